@@ -295,6 +295,94 @@ void TF_EnqueueNamedTensor(TF_Session* session, int tensor_id,
   VLOG(1) << "Enqueuing is done.";
 }
 
+int64_t TF_SessionPrepareCallable(TF_Session* session, const TF_Output* inputs,
+                                  int ninputs, const TF_Output* outputs,
+                                  int noutputs,
+                                  const TF_Operation* const* target_opers,
+                                  int ntargets, TF_Status* status) {
+  if (session->extend_before_run &&
+      !tensorflow::ExtendSessionGraphHelper(session, status)) {
+    return -1;
+  }
+
+  tensorflow::CallableOptions callable_options;
+  for (int i = 0; i < ninputs; ++i) {
+    callable_options.add_feed(tensorflow::strings::StrCat(
+        inputs[i].oper->node.name(), ":", inputs[i].index));
+  }
+  for (int i = 0; i < noutputs; ++i) {
+    callable_options.add_fetch(tensorflow::strings::StrCat(
+        outputs[i].oper->node.name(), ":", outputs[i].index));
+  }
+  for (int i = 0; i < ntargets; ++i) {
+    callable_options.add_target(target_opers[i]->node.name());
+  }
+
+  tensorflow::Session::CallableHandle handle;
+  status->status = session->session->MakeCallable(callable_options, &handle);
+  if (!status->status.ok()) return -1;
+  return handle;
+}
+
+void TF_SessionRunCallable(TF_Session* session, int64_t handle,
+                           TF_Tensor* const* input_values, int ninputs,
+                           TF_Tensor** output_values, int noutputs,
+                           TF_Status* status) {
+  status->status = Status::OK();
+  std::vector<tensorflow::Tensor> feed_tensors(ninputs);
+  for (int i = 0; i < ninputs && status->status.ok(); ++i) {
+    status->status =
+        tensorflow::TF_TensorToTensor(input_values[i], &feed_tensors[i]);
+  }
+  std::vector<tensorflow::Tensor> fetch_tensors;
+  if (status->status.ok()) {
+    status->status = session->session->RunCallable(handle, feed_tensors,
+                                                   &fetch_tensors, nullptr);
+  }
+  if (status->status.ok() &&
+      fetch_tensors.size() != static_cast<size_t>(noutputs)) {
+    status->status = InvalidArgument("Expected ", fetch_tensors.size(),
+                                     " output values, got ", noutputs);
+  }
+
+  for (int i = 0; i < noutputs; ++i) {
+    TF_Tensor* reused = output_values[i];
+    output_values[i] = nullptr;
+    if (status->status.ok()) {
+      const tensorflow::Tensor& src = fetch_tensors[i];
+      // Only tensors whose buffer TF_Tensor shares can be rewrapped; strings,
+      // resources and empty tensors need a new TF_Tensor.
+      if (reused != nullptr && src.IsInitialized() &&
+          src.NumElements() > 0 && src.dtype() != tensorflow::DT_STRING &&
+          src.dtype() != tensorflow::DT_RESOURCE) {
+        tensorflow::TensorBuffer* buf = tensorflow::TensorCApi::Buffer(src);
+        buf->Ref();
+        reused->buffer->Unref();
+        reused->buffer = buf;
+        reused->dtype = static_cast<TF_DataType>(src.dtype());
+        reused->shape = src.shape();
+        output_values[i] = reused;
+        continue;
+      }
+      output_values[i] = tensorflow::TF_TensorFromTensor(src, status);
+    }
+    if (reused != nullptr) TF_DeleteTensor(reused);
+  }
+  if (!status->status.ok()) {
+    for (int i = 0; i < noutputs; ++i) {
+      if (output_values[i] != nullptr) {
+        TF_DeleteTensor(output_values[i]);
+        output_values[i] = nullptr;
+      }
+    }
+  }
+}
+
+void TF_SessionReleaseCallable(TF_Session* session, int64_t handle,
+                               TF_Status* status) {
+  status->status = session->session->ReleaseCallable(handle);
+}
+
 TF_Buffer* TFE_GetServerDef(const char* text_proto, TF_Status* status) {
   tensorflow::ServerDef server_def;
   if (!tensorflow::protobuf::TextFormat::ParseFromString(text_proto,
@@ -142,6 +142,36 @@ TF_CAPI_EXPORT extern void TF_EnqueueNamedTensor(TF_Session* session,
                                                  int tensor_id,
                                                  TF_Tensor* tensor,
                                                  TF_Status* status);
+
+// Prepares the subgraph that feeds `inputs`, fetches `outputs` and runs
+// `target_opers`, so that it can be run repeatedly with
+// TF_SessionRunCallable(). Unlike TF_SessionRun(), which looks up the
+// subgraph from the feed and fetch names on every call, this does the lookup
+// once. Returns a handle that must be released with
+// TF_SessionReleaseCallable().
+TF_CAPI_EXPORT extern int64_t TF_SessionPrepareCallable(
+    TF_Session* session, const TF_Output* inputs, int ninputs,
+    const TF_Output* outputs, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets, TF_Status* status);
+
+// Runs a subgraph prepared with TF_SessionPrepareCallable(). `input_values`
+// and `output_values` are in the order of the inputs and outputs it was
+// prepared with. Input tensors are still owned by the caller; other than
+// strings and resources they are fed without a copy.
+//
+// Each `output_values[i]` may be nullptr, or a tensor returned by an earlier
+// call that the caller has no more use for. Such a tensor is reused to hold
+// the new output instead of allocating a new TF_Tensor. On return the caller
+// owns all of `output_values`, which are nullptr if the run failed.
+TF_CAPI_EXPORT extern void TF_SessionRunCallable(
+    TF_Session* session, int64_t handle, TF_Tensor* const* input_values,
+    int ninputs, TF_Tensor** output_values, int noutputs, TF_Status* status);
+
+// Releases the resources of a subgraph prepared with
+// TF_SessionPrepareCallable().
+TF_CAPI_EXPORT extern void TF_SessionReleaseCallable(TF_Session* session,
+                                                     int64_t handle,
+                                                     TF_Status* status);
 // Create a serialized tensorflow.ServerDef proto.
 TF_Buffer* TFE_GetServerDef(const char* text_proto, TF_Status* status);
 
@@ -225,6 +225,69 @@ TEST(CAPI_EXPERIMENTAL, SymbolicTensor) {
   TF_DeleteStatus(status);
 }
 
+TEST(CAPI_EXPERIMENTAL, SessionRunCallable) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_Output input{feed, 0};
+  TF_Output output{add, 0};
+  const int64_t handle = TF_SessionPrepareCallable(
+      session, &input, 1, &output, 1, nullptr, 0, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_Tensor* output_value = nullptr;
+  for (int32_t i = 0; i < 3; ++i) {
+    TF_Tensor* input_value = Int32Tensor(i);
+    TF_Tensor* previous_output = output_value;
+    TF_SessionRunCallable(session, handle, &input_value, 1, &output_value, 1,
+                          s);
+    TF_DeleteTensor(input_value);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    ASSERT_NE(nullptr, output_value);
+    // The output tensor of the previous run is reused.
+    if (previous_output != nullptr) EXPECT_EQ(previous_output, output_value);
+    EXPECT_EQ(TF_INT32, TF_TensorType(output_value));
+    EXPECT_EQ(0, TF_NumDims(output_value));
+    EXPECT_EQ(i + 2, *static_cast<int32_t*>(TF_TensorData(output_value)));
+  }
+
+  // A failed run deletes the output tensors it was given.
+  TF_Tensor* wrong_type = DoubleTensor(1.0);
+  TF_SessionRunCallable(session, handle, &wrong_type, 1, &output_value, 1, s);
+  TF_DeleteTensor(wrong_type);
+  EXPECT_NE(TF_OK, TF_GetCode(s));
+  EXPECT_EQ(nullptr, output_value);
+
+  // The error of the failed run does not carry over to the next one.
+  TF_Tensor* input_value = Int32Tensor(5);
+  TF_SessionRunCallable(session, handle, &input_value, 1, &output_value, 1, s);
+  TF_DeleteTensor(input_value);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  ASSERT_NE(nullptr, output_value);
+  EXPECT_EQ(7, *static_cast<int32_t*>(TF_TensorData(output_value)));
+  TF_DeleteTensor(output_value);
+
+  TF_SessionReleaseCallable(session, handle, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_CloseSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 class AddEagerOpToGraphTest : public ::testing::Test {
  protected:
   AddEagerOpToGraphTest()
@@ -33,6 +33,9 @@ constexpr char kSavedModelFilenamePb[] = "saved_model.pb";
 /// SavedModel text format proto filename.
 constexpr char kSavedModelFilenamePbTxt[] = "saved_model.pbtxt";
 
+/// SavedModel memmapped package holding the tensors of ImmutableConst ops.
+constexpr char kSavedModelMemmappedConstantsFilename[] = "constants.mmap";
+
 /// SavedModel legacy init op collection key. Used in v1 SavedModels.
 constexpr char kSavedModelLegacyInitOpKey[] = "legacy_init_op";
 
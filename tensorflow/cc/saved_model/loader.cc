@@ -19,17 +19,22 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/platform.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#if !defined(PLATFORM_WINDOWS)
+#include "tensorflow/core/util/memmapped_file_system.h"
+#endif  // !PLATFORM_WINDOWS
 
 namespace tensorflow {
 namespace {
@@ -64,6 +69,27 @@ uint64 GetLatencyMicroseconds(const uint64 start_microseconds) {
   return end_microseconds - start_microseconds;
 }
 
+// Sets `*env` to an Env that wraps `base_env` and maps the memmapped
+// constants of the SavedModel, if it has any. Leaves `*env` empty otherwise.
+Status MaybeCreateMemmappedEnv(const string& export_dir, Env* base_env,
+                               std::unique_ptr<Env>* env) {
+  const string constants_path =
+      io::JoinPath(export_dir, kSavedModelMemmappedConstantsFilename);
+  if (!base_env->FileExists(constants_path).ok()) {
+    return Status::OK();
+  }
+#if defined(PLATFORM_WINDOWS)
+  return errors::Unimplemented(
+      "Memmapped SavedModel constants are not supported on Windows: ",
+      constants_path);
+#else
+  std::unique_ptr<MemmappedEnv> memmapped_env(new MemmappedEnv(base_env));
+  TF_RETURN_IF_ERROR(memmapped_env->InitializeFromFile(constants_path));
+  *env = std::move(memmapped_env);
+  return Status::OK();
+#endif  // PLATFORM_WINDOWS
+}
+
 Status LoadMetaGraphIntoSession(const MetaGraphDef& meta_graph_def,
                                 const SessionOptions& session_options,
                                 std::unique_ptr<Session>* session) {
@@ -265,10 +291,23 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   const uint64 read_start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
                                                     &bundle->meta_graph_def));
+  const uint64 read_meta_graph_walltime =
+      GetLatencyMicroseconds(read_start_microseconds);
 
-  TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
-      bundle->meta_graph_def, session_options, &bundle->session));
+  const uint64 create_session_start_microseconds = Env::Default()->NowMicros();
+  SessionOptions options = session_options;
+  TF_RETURN_IF_ERROR(
+      MaybeCreateMemmappedEnv(export_dir, options.env, &bundle->env));
+  if (bundle->env != nullptr) {
+    options.env = bundle->env.get();
+  }
+  TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(bundle->meta_graph_def, options,
+                                              &bundle->session));
+  const uint64 create_session_walltime =
+      GetLatencyMicroseconds(create_session_start_microseconds);
 
+  const uint64 restore_variables_start_microseconds =
+      Env::Default()->NowMicros();
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
       GetAssetFileDefs(bundle->meta_graph_def, &asset_file_defs));
@@ -277,6 +316,8 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                  bundle->meta_graph_def.saver_def().restore_op_name(),
                  bundle->meta_graph_def.saver_def().filename_tensor_name(),
                  asset_file_defs, bundle->session.get()));
+  const uint64 restore_variables_walltime =
+      GetLatencyMicroseconds(restore_variables_start_microseconds);
   // Record walltime spent in restoring graph from disk, but postpone metric
   // increments until graph init finishes.
   const uint64 restore_graph_walltime =
@@ -289,11 +330,27 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, bundle->meta_graph_def,
                                asset_file_defs, bundle->session.get(),
                                init_op_name));
+  const uint64 init_graph_walltime =
+      GetLatencyMicroseconds(graph_init_start_microseconds);
+
+  // "restore_graph" covers the first three stages, which are also recorded
+  // separately.
+  load_latency_by_stage->GetCell(export_dir, "read_meta_graph")
+      ->Add(read_meta_graph_walltime);
+  load_latency_by_stage->GetCell(export_dir, "create_session")
+      ->Add(create_session_walltime);
+  load_latency_by_stage->GetCell(export_dir, "restore_variables")
+      ->Add(restore_variables_walltime);
   load_latency_by_stage->GetCell(export_dir, "restore_graph")
       ->Add(restore_graph_walltime);
   // Record wall time spent in init op.
   load_latency_by_stage->GetCell(export_dir, "init_graph")
-      ->Add(GetLatencyMicroseconds(graph_init_start_microseconds));
+      ->Add(init_graph_walltime);
+  LOG(INFO) << "SavedModel load stages (microseconds): read_meta_graph: "
+            << read_meta_graph_walltime
+            << ", create_session: " << create_session_walltime
+            << ", restore_variables: " << restore_variables_walltime
+            << ", init_graph: " << init_graph_walltime << ".";
   return Status::OK();
 }
 
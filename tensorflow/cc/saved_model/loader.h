@@ -22,6 +22,7 @@ limitations under the License.
 #include <unordered_set>
 
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/public/session.h"
 
@@ -29,6 +30,10 @@ namespace tensorflow {
 
 /// SavedModel representation once the SavedModel is loaded from storage.
 struct SavedModelBundle {
+  /// The Env of `session`, if it is not the Env of the SessionOptions. It
+  /// serves the memory-mapped constants of the SavedModel, if it has any, and
+  /// must outlive `session`.
+  std::unique_ptr<Env> env;
   std::unique_ptr<Session> session;
   MetaGraphDef meta_graph_def;
 
@@ -47,6 +52,11 @@ struct SavedModelBundle {
 /// to be loaded is identified by the supplied tags, corresponding exactly to
 /// the set of tags used at SavedModel build time. Returns a SavedModel bundle
 /// with a session and the requested meta graph def, if found.
+///
+/// If the export directory contains a memmapped package of constants (see
+/// kSavedModelMemmappedConstantsFilename), the session runs in an Env that
+/// maps it, so that the ImmutableConst ops of the graph share its read-only
+/// pages instead of copying the tensors.
 Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
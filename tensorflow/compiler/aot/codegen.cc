@@ -205,6 +205,28 @@ Status GenArgMethods(const tf2xla::Config& config,
   return Status::OK();
 }
 
+// Generate the method that sets the args holding the weights.
+string GenWeightsMethods(const CodegenOpts& opts) {
+  if (opts.weights_args.empty()) return "";
+  string set_args;
+  for (const WeightsArg& arg : opts.weights_args) {
+    absl::StrAppend(&set_args, "    set_arg_data(", arg.arg_index,
+                    ", weights + ", arg.offset, ");\n");
+  }
+  const string code = R"(
+  // Sets the args holding the model weights to point into `data`, the
+  // contents of the weights file written by tfcompile. `data` must be aligned
+  // to 64 bytes and outlive every call to Run; mmap'ing the file does both.
+  static constexpr size_t WeightsSize() { return {{WEIGHTS_SIZE}}; }
+  void set_weights_data(const void* data) {
+    const char* weights = static_cast<const char*>(data);
+{{SET_ARGS}}  }
+)";
+  return absl::StrReplaceAll(
+      code, {{"{{WEIGHTS_SIZE}}", absl::StrCat(opts.weights_size)},
+             {"{{SET_ARGS}}", set_args}});
+}
+
 // Generate methods for results (outputs).
 Status GenResultMethods(const tf2xla::Config& config,
                         const xla::ProgramShapeProto& ps, string* methods) {
@@ -391,6 +413,7 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
   const xla::ProgramShapeProto& ps = compile_result.program_shape;
   string methods_arg, methods_result, methods_variable;
   TF_RETURN_IF_ERROR(GenArgMethods(config, ps, compile_result, &methods_arg));
+  methods_arg += GenWeightsMethods(opts);
   TF_RETURN_IF_ERROR(GenResultMethods(config, ps, &methods_result));
   TF_RETURN_IF_ERROR(GenVariableMethods(config, ps, &methods_variable));
   const size_t arg_bytes_aligned =
@@ -48,6 +48,12 @@ struct CodegenOpts {
   // If true, emit a serialized HloProfilePrinterData protobuf that can be used
   // to pretty print HLO profile counters.
   bool gen_hlo_profile_printer_data = false;
+
+  // The arguments whose values are in the weights file written by tfcompile,
+  // which has weights_size bytes. If not empty, generate a set_weights_data
+  // method that sets all of them.
+  std::vector<WeightsArg> weights_args;
+  int64 weights_size = 0;
 };
 
 // Describes a generated metadata object file.
@@ -20,17 +20,23 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/aot/flags.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.h"
 #include "tensorflow/compiler/tf2xla/tf2xla_util.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/compile_only_client.h"
 #include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/compiler/xla/cpu_function_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_compiler.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
@@ -90,6 +96,44 @@ Status CompileXla(xla::CompileOnlyClient* client,
 
 }  // namespace
 
+Status ExternalizeWeights(int64 min_bytes, GraphDef* graph_def,
+                          tf2xla::Config* config, string* weights,
+                          std::vector<WeightsArg>* weights_args) {
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    const auto value_attr = node.attr().find("value");
+    if (node.op() != "Const" || value_attr == node.attr().end()) continue;
+    Tensor value;
+    if (!value.FromProto(value_attr->second.tensor())) {
+      return errors::InvalidArgument("Cannot parse the value of Const node ",
+                                     node.name());
+    }
+    if (!DataTypeCanUseMemcpy(value.dtype()) ||
+        static_cast<int64>(value.TotalBytes()) < min_bytes) {
+      continue;
+    }
+
+    // XLA expects its arguments to be aligned like its own buffers.
+    const size_t align = xla::cpu_function_runtime::kAlign;
+    weights->resize((weights->size() + align - 1) / align * align);
+    weights_args->push_back({config->feed_size(),
+                             static_cast<int64>(weights->size())});
+    const StringPiece data = value.tensor_data();
+    weights->append(data.data(), data.size());
+
+    tf2xla::Feed* feed = config->add_feed();
+    feed->mutable_id()->set_node_name(node.name());
+    value.shape().AsProto(feed->mutable_shape());
+    feed->set_type(value.dtype());
+    feed->set_name(absl::StrCat("weights_", weights_args->size() - 1));
+
+    node.set_op("Placeholder");
+    node.clear_attr();
+    AddNodeAttr("dtype", value.dtype(), &node);
+    AddNodeAttr("shape", value.shape(), &node);
+  }
+  return Status::OK();
+}
+
 Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
                     const MainFlags& flags, CompileResult* compile_result) {
   // Converts the graph into an XLA computation, and compiles the
@@ -120,6 +164,7 @@ Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
       flags.target_triple, flags.target_cpu, flags.target_features,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
+  aot_opts.set_max_parallelism(flags.max_parallelism);
 
   return CompileXla(client, computation, aot_opts, compile_result);
 }
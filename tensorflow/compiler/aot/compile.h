@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/compiler/aot/flags.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
@@ -38,6 +39,21 @@ struct CompileResult {
   int pointer_size = 0;                  // Size of a pointer in bytes.
 };
 
+// An argument of the generated function that holds one of the graph's
+// constants, whose value is in the weights file instead of the object file.
+struct WeightsArg {
+  int arg_index;
+  int64 offset;  // Of the value in the weights file.
+};
+
+// Replaces the Const nodes of graph_def whose values have at least min_bytes
+// bytes with feeds, which are appended to config. Their values are appended
+// to weights, each at an offset aligned for XLA arguments, and described by
+// weights_args.
+Status ExternalizeWeights(int64 min_bytes, GraphDef* graph_def,
+                          tf2xla::Config* config, string* weights,
+                          std::vector<WeightsArg>* weights_args);
+
 // CompileGraph compiles the graph_def into an object file containing a function
 // that performs the graph operations.
 //
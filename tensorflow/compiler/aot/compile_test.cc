@@ -0,0 +1,85 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/aot/compile.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/xla/cpu_function_runtime.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace tfcompile {
+namespace {
+
+void AddConst(const string& name, const Tensor& value, GraphDef* graph_def) {
+  NodeDef* node = graph_def->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  AddNodeAttr("dtype", value.dtype(), node);
+  AddNodeAttr("value", value, node);
+}
+
+TEST(ExternalizeWeightsTest, ReplacesLargeConstsWithFeeds) {
+  GraphDef graph_def;
+  AddConst("small", test::AsTensor<float>({1, 2}), &graph_def);
+  AddConst("large", test::AsTensor<float>({1, 2, 3, 4}, {2, 2}), &graph_def);
+  AddConst("large_int", test::AsTensor<int32>({5, 6, 7, 8}), &graph_def);
+  AddConst("string", test::AsTensor<string>({"abcdefghijklmnop"}), &graph_def);
+  tf2xla::Config config;
+  config.add_feed()->mutable_id()->set_node_name("input");
+
+  string weights;
+  std::vector<WeightsArg> weights_args;
+  TF_ASSERT_OK(ExternalizeWeights(/*min_bytes=*/16, &graph_def, &config,
+                                  &weights, &weights_args));
+
+  EXPECT_EQ("Const", graph_def.node(0).op());
+  EXPECT_EQ("Placeholder", graph_def.node(1).op());
+  EXPECT_EQ("Placeholder", graph_def.node(2).op());
+  EXPECT_EQ("Const", graph_def.node(3).op());
+
+  ASSERT_EQ(3, config.feed_size());
+  EXPECT_EQ("large", config.feed(1).id().node_name());
+  EXPECT_EQ("weights_0", config.feed(1).name());
+  EXPECT_EQ(DT_FLOAT, config.feed(1).type());
+  EXPECT_EQ(2, config.feed(1).shape().dim_size());
+  EXPECT_EQ("large_int", config.feed(2).id().node_name());
+  EXPECT_EQ("weights_1", config.feed(2).name());
+
+  ASSERT_EQ(2, weights_args.size());
+  EXPECT_EQ(1, weights_args[0].arg_index);
+  EXPECT_EQ(0, weights_args[0].offset);
+  EXPECT_EQ(2, weights_args[1].arg_index);
+  EXPECT_EQ(xla::cpu_function_runtime::kAlign, weights_args[1].offset);
+  EXPECT_EQ(weights_args[1].offset + 16, weights.size());
+
+  const float* large =
+      reinterpret_cast<const float*>(weights.data() + weights_args[0].offset);
+  EXPECT_EQ(3, large[2]);
+  const int32* large_int =
+      reinterpret_cast<const int32*>(weights.data() + weights_args[1].offset);
+  EXPECT_EQ(8, large_int[3]);
+}
+
+}  // namespace
+}  // namespace tfcompile
+}  // namespace tensorflow
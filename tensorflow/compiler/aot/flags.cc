@@ -68,6 +68,16 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "function."},
       {"out_session_module", &flags->out_session_module,
        "Output session module proto."},
+      {"out_weights", &flags->out_weights,
+       "If set, the graph's constants of at least "
+       "--externalize_weights_min_bytes bytes are written to this file "
+       "instead of being compiled into the object file.  The generated class "
+       "reads them with set_weights_data(), e.g. from the mmap'ed file."},
+      {"externalize_weights_min_bytes", &flags->externalize_weights_min_bytes,
+       "The size of the smallest constant written to --out_weights."},
+      {"max_parallelism", &flags->max_parallelism,
+       "If greater than 1, large ops are split into up to this many tasks, "
+       "which run on the thread pool passed to set_thread_pool()."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
@@ -38,6 +38,9 @@ struct MainFlags {
   string out_metadata_object;
   string out_header;
   string out_session_module;
+  string out_weights;
+  int64 externalize_weights_min_bytes = 1024;
+  int32 max_parallelism = 0;
 
   // C++ codegen options
   bool gen_name_to_index = false;
@@ -38,6 +38,7 @@ def tf_library(
         tfcompile_tool = "//tensorflow/compiler/aot:tfcompile",
         include_standard_runtime_deps = True,
         enable_xla_hlo_profiling = False,
+        externalize_weights = False,
         deps = None,
         tags = None):
     """Runs tfcompile to compile a TensorFlow graph into executable code.
@@ -88,6 +89,9 @@ def tf_library(
       enable_xla_hlo_profiling: Enable XLA HLO profiling in the generated
         program, and emit metadata that lets us pretty-print the gathered
         profile counters.
+      externalize_weights: If True, the graph's large constants are written to
+        <name>_weights.bin instead of the object file, and must be passed to
+        set_weights_data() of the generated class before Run.
       deps: a list of deps to include on the build rules for the generated
         library, added to the standard deps if standard_runtime_deps is True.
       tags: tags to apply to subsidiary build rules.
@@ -192,6 +196,13 @@ def tf_library(
         profiling_flag = "--xla_hlo_profile"
     else:
         profiling_flag = ""
+    weights_file = name + "_weights.bin"
+    if externalize_weights:
+        weights_outs = [weights_file]
+        weights_flag = " --out_weights=$(@D)/" + weights_file
+    else:
+        weights_outs = []
+        weights_flag = ""
     native.genrule(
         name = ("gen_" + name),
         srcs = [
@@ -202,7 +213,7 @@ def tf_library(
             header_file,
             metadata_object_file,
             function_object_file,
-        ],
+        ] + weights_outs,
         cmd = (
             "CUDA_VISIBLE_DEVICES='' " +
             "$(location " + tfcompile_tool + ")" +
@@ -214,7 +225,7 @@ def tf_library(
             " --out_header=$(@D)/" + header_file +
             " --out_metadata_object=$(@D)/" + metadata_object_file +
             " --out_function_object=$(@D)/" + function_object_file +
-            " " + flags + " " + profiling_flag
+            weights_flag + " " + flags + " " + profiling_flag
         ),
         tools = [tfcompile_tool],
         visibility = visibility,
@@ -287,6 +298,7 @@ def tf_library(
             # TODO(cwhipkey): only depend on kernel code that the model actually
             # needed.
             "//tensorflow/compiler/xla/service/cpu:runtime_conv2d",
+            "//tensorflow/compiler/xla/service/cpu:runtime_fork_join",
             "//tensorflow/compiler/xla/service/cpu:runtime_key_value_sort",
             "//tensorflow/compiler/xla/service/cpu:runtime_matmul",
             "//tensorflow/compiler/xla/service/cpu:runtime_single_threaded_conv2d",
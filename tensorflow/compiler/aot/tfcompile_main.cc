@@ -86,6 +86,14 @@ Status Main(const MainFlags& flags) {
   }
   GraphDef graph_def;
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.graph, &graph_def));
+  string weights;
+  std::vector<WeightsArg> weights_args;
+  if (!flags.out_weights.empty()) {
+    TF_RETURN_IF_ERROR(
+        ExternalizeWeights(flags.externalize_weights_min_bytes, &graph_def,
+                           &config, &weights, &weights_args));
+    TF_RETURN_IF_ERROR(ValidateConfig(config));
+  }
   CompileResult compile_result;
   TF_RETURN_IF_ERROR(CompileGraph(graph_def, config, flags, &compile_result));
 
@@ -95,10 +103,15 @@ Status Main(const MainFlags& flags) {
   TF_RETURN_IF_ERROR(
       WriteStringToFile(env, flags.out_function_object,
                         absl::string_view(obj.data(), obj.size())));
+  if (!flags.out_weights.empty()) {
+    TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_weights, weights));
+  }
   CodegenOpts codegen_opts;
   codegen_opts.gen_name_to_index = flags.gen_name_to_index;
   codegen_opts.gen_program_shape = flags.gen_program_shape;
   codegen_opts.target_triple = flags.target_triple;
+  codegen_opts.weights_args = weights_args;
+  codegen_opts.weights_size = weights.size();
   if (flags.cpp_class.empty()) {
     return errors::InvalidArgument("Must specify --cpp_class");
   }
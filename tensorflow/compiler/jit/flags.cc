@@ -128,6 +128,8 @@ void AllocateAndParseFlags() {
 
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
+  ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_max_signatures_per_cluster = 0;
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -151,6 +153,15 @@ void AllocateAndParseFlags() {
 
        Flag("tf_xla_always_defer_compilation",
             &ops_flags->tf_xla_always_defer_compilation, ""),
+       Flag("tf_xla_async_compilation", &ops_flags->tf_xla_async_compilation,
+            "If true, compile new signatures of clusters that may run without "
+            "XLA in the background, and run them without XLA until their "
+            "compilation is done."),
+       Flag("tf_xla_max_signatures_per_cluster",
+            &ops_flags->tf_xla_max_signatures_per_cluster,
+            "If positive, the maximum number of signatures (input shapes and "
+            "constant values) compiled for each cluster that may run without "
+            "XLA. Other signatures run without XLA."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
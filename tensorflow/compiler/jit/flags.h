@@ -91,6 +91,17 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, _XlaCompile compiles new signatures of clusters that may run
+  // without XLA on background threads, and runs them without XLA until their
+  // compilation is done.  Defaults to false.
+  bool tf_xla_async_compilation;
+
+  // If positive, _XlaCompile compiles at most this many signatures (i.e. sets
+  // of input shapes and constant values) of each cluster that may run without
+  // XLA, and runs the cluster without XLA for other signatures.  Defaults to 0,
+  // i.e. no limit.
+  int64 tf_xla_max_signatures_per_cluster;
 };
 
 // Flags for the build_xla_ops pass.
@@ -202,7 +202,8 @@ static Status BuildCompilationCache(OpKernelContext* ctx,
   if (platform_info.xla_device_metadata()) {
     *cache = new XlaCompilationCache(
         platform_info.xla_device_metadata()->client(),
-        platform_info.xla_device_metadata()->jit_device_type());
+        platform_info.xla_device_metadata()->jit_device_type(),
+        GetXlaOpsCommonFlags().tf_xla_max_signatures_per_cluster);
     return Status::OK();
   }
 
@@ -248,14 +249,16 @@ static Status BuildCompilationCache(OpKernelContext* ctx,
                                    platform_info.device_type().type());
   }
   *cache = new XlaCompilationCache(
-      client.ValueOrDie(), DeviceType(registration->compilation_device_name));
+      client.ValueOrDie(), DeviceType(registration->compilation_device_name),
+      GetXlaOpsCommonFlags().tf_xla_max_signatures_per_cluster);
   return Status::OK();
 }
 
 static Status CompileToLocalExecutable(
     OpKernelContext* ctx, const NameAttrList& function,
     const XlaPlatformInfo& platform_info, absl::Span<const int> resources,
-    absl::Span<const int> constants, bool lazy, xla::LocalClient** client,
+    absl::Span<const int> constants,
+    XlaCompilationCache::CompileMode compile_mode, xla::LocalClient** client,
     std::map<int, OptionalTensor>* variables,
     const XlaCompiler::CompilationResult** kernel,
     xla::LocalExecutable** executable) {
@@ -315,10 +318,8 @@ static Status CompileToLocalExecutable(
   std::vector<XlaCompiler::Argument> args;
   TF_RETURN_IF_ERROR(XlaComputationLaunchContext::BuildXlaCompilerArguments(
       constant_args, *variables, ctx, &args));
-  return cache->Compile(options, function, args, compile_options,
-                        lazy ? XlaCompilationCache::CompileMode::kLazy
-                             : XlaCompilationCache::CompileMode::kStrict,
-                        kernel, executable);
+  return cache->Compile(options, function, args, compile_options, compile_mode,
+                        platform_info.shared_allocator(), kernel, executable);
 }
 
 void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
@@ -332,8 +333,9 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
 
   {
     Status s = CompileToLocalExecutable(
-        ctx, function_, platform_info_, resources_, constants_, /*lazy=*/false,
-        &client, &variables, &kernel, &executable);
+        ctx, function_, platform_info_, resources_, constants_,
+        XlaCompilationCache::CompileMode::kStrict, &client, &variables, &kernel,
+        &executable);
     if (!s.ok() && (platform_info_.device_type().type_string() == DEVICE_CPU ||
                     platform_info_.device_type().type_string() == DEVICE_GPU)) {
       // Suggest auto jit if the failure was with GPU or CPU.
@@ -457,9 +459,16 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
       cannot_compile_cluster) {
     executable = nullptr;
   } else {
+    XlaCompilationCache::CompileMode compile_mode =
+        XlaCompilationCache::CompileMode::kStrict;
+    if (!must_compile_) {
+      compile_mode = GetXlaOpsCommonFlags().tf_xla_async_compilation
+                         ? XlaCompilationCache::CompileMode::kAsync
+                         : XlaCompilationCache::CompileMode::kLazy;
+    }
     Status status = CompileToLocalExecutable(
-        ctx, function_, platform_info_, resources_, constants_,
-        /*lazy=*/!must_compile_, &client, &variables, &kernel, &executable);
+        ctx, function_, platform_info_, resources_, constants_, compile_mode,
+        &client, &variables, &kernel, &executable);
     if (must_compile_ || status.code() != error::UNIMPLEMENTED) {
       OP_REQUIRES_OK(ctx, status);
     }
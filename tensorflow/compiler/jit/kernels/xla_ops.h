@@ -59,6 +59,17 @@ class XlaPlatformInfo {
   se::DeviceMemoryAllocator* allocator() const {
     return device_allocator_ ? device_allocator_ : xla_allocator_.get();
   }
+
+  // Returns allocator() with a reference that keeps it alive beyond this
+  // XlaPlatformInfo, e.g. for background compilations.  The xla::Backend's
+  // allocator is not owned, as it lives as long as the process-wide client.
+  std::shared_ptr<se::DeviceMemoryAllocator> shared_allocator() const {
+    if (device_allocator_) {
+      return std::shared_ptr<se::DeviceMemoryAllocator>(
+          std::shared_ptr<se::DeviceMemoryAllocator>(), device_allocator_);
+    }
+    return xla_allocator_;
+  }
   DeviceType device_type() const { return device_type_; }
 
   // This is equal to xla_device_metadata()->platform()->id() if
@@ -85,8 +96,9 @@ class XlaPlatformInfo {
   // then device_allocator_ is the xla::Backend's memory allocator and
   // xla_allocator_ is null.  If the op is placed on a regular CPU or GPU device
   // then device_allocator_ is null and xla_allocator_ points to an appropriate
-  // se::TfAllocatorAdapter instance.
-  std::unique_ptr<se::TfAllocatorAdapter> xla_allocator_;
+  // se::TfAllocatorAdapter instance, which is shared with background
+  // compilations.
+  std::shared_ptr<se::TfAllocatorAdapter> xla_allocator_;
   se::DeviceMemoryAllocator* device_allocator_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaPlatformInfo);
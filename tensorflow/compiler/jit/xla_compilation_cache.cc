@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/type_util.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -41,9 +43,27 @@ namespace tensorflow {
 
 constexpr int64 XlaCompilationCache::kDefaultCompilationThreshold;
 
+namespace {
+
+// The number of threads running background compilations.
+constexpr int kNumAsyncCompilationThreads = 4;
+
+// Returns the threads running background compilations. They are shared by all
+// caches, and never destroyed since compilations may outlive any cache.
+thread::ThreadPool* AsyncCompilationThreadPool() {
+  static thread::ThreadPool* thread_pool = new thread::ThreadPool(
+      Env::Default(), "xla_async_compilation", kNumAsyncCompilationThreads);
+  return thread_pool;
+}
+
+}  // namespace
+
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
-                                         DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+                                         DeviceType device_type,
+                                         int64 max_signatures_per_cluster)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      max_signatures_per_cluster_(max_signatures_per_cluster) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
   // Ensure any use of our programs have completed by waiting for all stream
@@ -170,19 +190,37 @@ Status XlaCompilationCache::Compile(
     absl::Span<const XlaCompiler::Argument> args,
     const XlaCompiler::CompileOptions& compile_options,
     CompileMode compile_mode,
+    std::shared_ptr<se::DeviceMemoryAllocator> device_allocator_ref,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   absl::optional<int64> compile_threshold;
-  if (compile_mode == CompileMode::kLazy) {
+  if (compile_mode == CompileMode::kLazy ||
+      compile_mode == CompileMode::kAsync) {
     compile_threshold = kDefaultCompilationThreshold;
   }
+  if (compile_mode == CompileMode::kAsync) {
+    // The compilation may outlive this call, so it owns copies of its inputs.
+    std::vector<XlaCompiler::Argument> owned_args(args.begin(), args.end());
+    auto compile_fn = [compile_options, function, owned_args](
+                          XlaCompiler* compiler,
+                          XlaCompiler::CompilationResult* result) {
+      return compiler->CompileFunction(compile_options, function, owned_args,
+                                       result);
+    };
+    return CompileImpl(options, function, args, compile_fn,
+                       /*compile_threshold=*/compile_threshold,
+                       /*compile_async=*/true, std::move(device_allocator_ref),
+                       out_compilation_result, out_executable);
+  }
   auto compile_fn = [&](XlaCompiler* compiler,
                         XlaCompiler::CompilationResult* result) {
     return compiler->CompileFunction(compile_options, function, args, result);
   };
   return CompileImpl(options, function, args, compile_fn,
                      /*compile_threshold=*/compile_threshold,
-                     out_compilation_result, out_executable);
+                     /*compile_async=*/false,
+                     /*device_allocator_ref=*/nullptr, out_compilation_result,
+                     out_executable);
 }
 
 static bool IsMegamorphic(int64 compile_count, int64 execution_count) {
@@ -221,7 +259,92 @@ Status XlaCompilationCache::CompileSingleOp(
   };
   return CompileImpl(options, name, args, compile_op,
                      /*compile_threshold=*/absl::nullopt,
-                     out_compilation_result, out_executable);
+                     /*compile_async=*/false,
+                     /*device_allocator_ref=*/nullptr, out_compilation_result,
+                     out_executable);
+}
+
+Status XlaCompilationCache::RecordCompilation(const string& function_name,
+                                              uint64 compile_time_us) {
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(function_name);
+  it->second.compile_count++;
+  it->second.cumulative_compile_time_us += compile_time_us;
+  VLOG(1) << "compiled " << function_name << " " << it->second.compile_count
+          << " times, compile time: " << compile_time_us
+          << " us, cumulative: " << it->second.cumulative_compile_time_us
+          << " us ("
+          << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                           1.0e6)
+          << " / "
+          << tensorflow::strings::HumanReadableElapsedTime(
+                 it->second.cumulative_compile_time_us / 1.0e6)
+          << ")";
+
+  XlaJitCompilationActivity jit_compilation_activity;
+  jit_compilation_activity.set_cluster_name(function_name);
+  jit_compilation_activity.set_compile_count(it->second.compile_count);
+  jit_compilation_activity.set_compile_time_us(compile_time_us);
+  jit_compilation_activity.set_cumulative_compile_time_us(
+      it->second.cumulative_compile_time_us);
+
+  return BroadcastXlaActivity(std::move(jit_compilation_activity));
+}
+
+void XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const string& function_name,
+    const std::function<Status(XlaCompiler* compiler,
+                               XlaCompiler::CompilationResult*)>& compile_fn,
+    std::shared_ptr<se::DeviceMemoryAllocator> device_allocator_ref,
+    Entry* entry) {
+  // The function library and the device allocator of the caller may be
+  // modified or destroyed before the compilation runs.
+  std::shared_ptr<FunctionLibraryDefinition> flib_def;
+  XlaCompiler::Options async_options = options;
+  async_options.device_allocator = device_allocator_ref.get();
+  if (options.flib_def != nullptr) {
+    flib_def = std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+    async_options.flib_def = flib_def.get();
+  }
+
+  // Entries are never evicted, so `entry` lives as long as this cache, which
+  // the compilation keeps alive.
+  Ref();
+  AsyncCompilationThreadPool()->Schedule([this, async_options, flib_def,
+                                          device_allocator_ref, function_name,
+                                          compile_fn, entry]() {
+    core::ScopedUnref cache_ref(this);
+    tensorflow::Env* env = tensorflow::Env::Default();
+    const uint64 compile_start_us = env->NowMicros();
+
+    XlaCompiler compiler(async_options);
+    XlaCompiler::CompilationResult compilation_result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    Status status;
+    {
+      ScopedCompilationPhase phase(kCompilationPhaseXla, function_name);
+      status = compile_fn(&compiler, &compilation_result);
+      if (status.ok()) {
+        status =
+            BuildExecutable(async_options, compilation_result, &executable);
+      }
+    }
+
+    const uint64 compile_time_us = env->NowMicros() - compile_start_us;
+    Status record_status = RecordCompilation(function_name, compile_time_us);
+    if (!record_status.ok()) {
+      LOG(WARNING) << "Failed to record the compilation of "
+                   << function_name << ": " << record_status;
+    }
+
+    mutex_lock entry_lock(entry->mu);
+    entry->compilation_status = status;
+    entry->compilation_result = std::move(compilation_result);
+    entry->executable = std::move(executable);
+    entry->compiled = true;
+    entry->compiling = false;
+    entry->compilation_done.notify_all();
+  });
 }
 
 Status XlaCompilationCache::CompileImpl(
@@ -229,7 +352,8 @@ Status XlaCompilationCache::CompileImpl(
     absl::Span<const XlaCompiler::Argument> args,
     const std::function<Status(XlaCompiler* compiler,
                                XlaCompiler::CompilationResult*)>& compile_fn,
-    absl::optional<int64> compile_threshold,
+    absl::optional<int64> compile_threshold, bool compile_async,
+    std::shared_ptr<se::DeviceMemoryAllocator> device_allocator_ref,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   DCHECK_NE(out_executable, nullptr);
@@ -293,8 +417,22 @@ Status XlaCompilationCache::CompileImpl(
           << " signature: " << signature.HumanString() << " with request count "
           << current_request_count << " and compile threshold "
           << compile_threshold.value_or(0);
+  if (!entry->compiled && entry->compiling) {
+    if (compile_threshold.has_value()) {
+      // Callers that may defer compilation run the cluster without XLA until
+      // the background compilation is done.
+      VLOG(2) << "Compilation in progress for signature: "
+              << signature.HumanString();
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      return Status::OK();
+    }
+    while (entry->compiling) {
+      entry->compilation_done.wait(entry_lock);
+    }
+  }
   if (!entry->compiled) {
-    const bool should_compile = [&] {
+    bool should_compile = [&] {
       if (!compile_threshold.has_value()) {
         // Lazy compilation is disabled.
         return true;
@@ -322,6 +460,20 @@ Status XlaCompilationCache::CompileImpl(
       return reached_compile_threshold;
     }();
 
+    if (should_compile) {
+      mutex_lock lock(cluster_compile_stats_mu_);
+      ClusterCompileStats& stats = cluster_compile_stats_[function.name()];
+      if (compile_threshold.has_value() && max_signatures_per_cluster_ > 0 &&
+          stats.signature_count >= max_signatures_per_cluster_) {
+        VLOG(3) << "Not compiling cluster " << function.name()
+                << " because it already has " << stats.signature_count
+                << " compiled signatures.";
+        should_compile = false;
+      } else {
+        ++stats.signature_count;
+      }
+    }
+
     if (!should_compile) {
       VLOG(2) << "Not compiling for signature: " << signature.HumanString();
       *out_compilation_result = nullptr;
@@ -329,6 +481,17 @@ Status XlaCompilationCache::CompileImpl(
       return Status::OK();
     }
 
+    if (compile_async) {
+      VLOG(2) << "Compiling in the background for signature: "
+              << signature.HumanString();
+      entry->compiling = true;
+      CompileAsync(options, function.name(), compile_fn,
+                   std::move(device_allocator_ref), entry);
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      return Status::OK();
+    }
+
     tensorflow::Env* env = tensorflow::Env::Default();
     const uint64 compile_start_us = env->NowMicros();
     // Do the actual JIT compilation without holding the lock (it can take
@@ -337,42 +500,19 @@ Status XlaCompilationCache::CompileImpl(
     XlaCompiler compiler(options);
     entry->compiled = true;
 
-    entry->compilation_status =
-        compile_fn(&compiler, &entry->compilation_result);
-    TF_RETURN_IF_ERROR(entry->compilation_status);
-    CHECK_EQ(entry->executable.get(), nullptr);
-    entry->compilation_status =
-        BuildExecutable(options, entry->compilation_result, &entry->executable);
+    {
+      ScopedCompilationPhase phase(kCompilationPhaseXla, function.name());
+      entry->compilation_status =
+          compile_fn(&compiler, &entry->compilation_result);
+      TF_RETURN_IF_ERROR(entry->compilation_status);
+      CHECK_EQ(entry->executable.get(), nullptr);
+      entry->compilation_status = BuildExecutable(
+          options, entry->compilation_result, &entry->executable);
+    }
 
     const uint64 compile_end_us = env->NowMicros();
     const uint64 compile_time_us = compile_end_us - compile_start_us;
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
-    }
+    TF_RETURN_IF_ERROR(RecordCompilation(function.name(), compile_time_us));
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
   *out_compilation_result = &entry->compilation_result;
@@ -40,15 +40,19 @@ namespace tensorflow {
 // XLA computation for each new set of input shapes.
 //
 // Currently no cache eviction policy is implemented and the cache grows without
-// bound.
+// bound, unless `max_signatures_per_cluster` is positive. In that case lazy and
+// async compilations stop compiling new signatures of a cluster once this many
+// have been compiled, and the cluster runs without XLA for the new signatures.
 class XlaCompilationCache : public ResourceBase {
  public:
-  XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
+  XlaCompilationCache(xla::LocalClient* client, DeviceType device_type,
+                      int64 max_signatures_per_cluster = 0);
   ~XlaCompilationCache() override;
 
   enum class CompileMode {
     kLazy,
     kStrict,
+    kAsync,
   };
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -61,20 +65,31 @@ class XlaCompilationCache : public ResourceBase {
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  If `compile_mode`
+  // is `kAsync` then the cache uses the same heuristics as `kLazy`, but runs
+  // the compilations it decides on in the background and returns null until
+  // they are done, so that the caller can run the cluster without XLA in the
+  // meantime.  `options.flib_def` is copied for background compilations.
+  // `options.device_allocator` is usually owned by the calling kernel, which
+  // may be destroyed before a background compilation finishes, so background
+  // compilations use `device_allocator_ref` instead, and hold a reference to
+  // it.  If it is null they use the allocator of the XLA backend.  The other
+  // pointers in `options` must remain valid until background compilations
+  // finish.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
   // xla::LocalExecutable and sets `out_executable` to point to it. The
   // resulting executable pointer may be null if the computation has no
   // non-constant outputs.
-  Status Compile(const XlaCompiler::Options& options,
-                 const NameAttrList& function,
-                 absl::Span<const XlaCompiler::Argument> args,
-                 const XlaCompiler::CompileOptions& compile_options,
-                 CompileMode compile_mode,
-                 const XlaCompiler::CompilationResult** out_compilation_result,
-                 xla::LocalExecutable** out_executable);
+  Status Compile(
+      const XlaCompiler::Options& options, const NameAttrList& function,
+      absl::Span<const XlaCompiler::Argument> args,
+      const XlaCompiler::CompileOptions& compile_options,
+      CompileMode compile_mode,
+      std::shared_ptr<se::DeviceMemoryAllocator> device_allocator_ref,
+      const XlaCompiler::CompilationResult** out_compilation_result,
+      xla::LocalExecutable** out_executable);
 
   // As above, but calls XlaCompiler::CompileSingleOp instead of
   // XlaCompiler::CompileFunction.
@@ -119,24 +134,42 @@ class XlaCompilationCache : public ResourceBase {
       absl::Span<const XlaCompiler::Argument> args);
 
  private:
+  struct Entry;
+
   // Common implementation of Compile and CompileSingleOp.
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
       absl::Span<const XlaCompiler::Argument> args,
       const std::function<Status(XlaCompiler* compiler,
                                  XlaCompiler::CompilationResult*)>& compile_fn,
-      absl::optional<int64> compile_threshold,
+      absl::optional<int64> compile_threshold, bool compile_async,
+      std::shared_ptr<se::DeviceMemoryAllocator> device_allocator_ref,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
+  // Compiles `entry` on a background thread, with `device_allocator_ref` as
+  // the device allocator. `compile_fn` must not refer to the arguments of the
+  // call that schedules it.
+  void CompileAsync(
+      const XlaCompiler::Options& options, const string& function_name,
+      const std::function<Status(XlaCompiler* compiler,
+                                 XlaCompiler::CompilationResult*)>& compile_fn,
+      std::shared_ptr<se::DeviceMemoryAllocator> device_allocator_ref,
+      Entry* entry);
+
   // Takes `result` which has been compiled from a Tensorflow subgraph to a
   // XLA computation already, and generates an XLA LocalExecutable `executable`.
   Status BuildExecutable(const XlaCompiler::Options& options,
                          const XlaCompiler::CompilationResult& result,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Updates the statistics of the cluster `function_name` after it has been
+  // compiled in `compile_time_us`, and broadcasts them to activity listeners.
+  Status RecordCompilation(const string& function_name, uint64 compile_time_us);
+
   xla::LocalClient* const client_;
   const DeviceType device_type_;
+  const int64 max_signatures_per_cluster_;
 
   // The value associated with a cache entry.
   struct Entry {
@@ -145,6 +178,11 @@ class XlaCompilationCache : public ResourceBase {
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is this entry being compiled in the background? Signaled on
+    // `compilation_done` when the compilation finishes.
+    bool compiling GUARDED_BY(mu) = false;
+    condition_variable compilation_done;
+
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
 
@@ -167,6 +205,10 @@ class XlaCompilationCache : public ResourceBase {
     // Number of times the cluster has been (re-)compiled.
     int64 compile_count = 0;
 
+    // Number of signatures of the cluster whose compilation has started,
+    // including those still compiling in the background.
+    int64 signature_count = 0;
+
     // The number of times this cluster has been executed.
     int64 execution_count = 0;
 
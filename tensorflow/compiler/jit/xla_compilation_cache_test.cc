@@ -14,8 +14,18 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
+
 #include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/stream_executor/host/host_platform_id.h"
+#include "tensorflow/stream_executor/multi_platform_manager.h"
+#include "tensorflow/stream_executor/tf_allocator_adapter.h"
 
 namespace tensorflow {
 namespace {
@@ -50,5 +60,64 @@ TEST(XlaCompilationCacheTest, SignatureEquality) {
   }
 }
 
+TEST(XlaCompilationCacheTest, AsyncCompilationOutlivesCaller) {
+  XlaOpRegistry::RegisterCompilationKernels();
+  FunctionDefLibrary flib;
+  *flib.add_function() = FunctionDefHelper::Create(
+      "AddFloats", {"a: float", "b: float"}, {"sum: float"}, {},
+      {{{"add"}, "Add", {"a", "b"}, {{"T", DT_FLOAT}}}}, {{"sum", "add:z:0"}});
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), flib);
+
+  xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+  se::Platform* platform =
+      se::MultiPlatformManager::PlatformWithId(se::host::kHostPlatformId)
+          .ValueOrDie();
+  // Stands in for the allocator owned by the XlaPlatformInfo of a kernel,
+  // which may be destroyed while the compilation is still running.
+  auto allocator =
+      std::make_shared<se::TfAllocatorAdapter>(platform, cpu_allocator());
+
+  XlaCompiler::Options options;
+  options.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  options.client = client;
+  options.flib_def = &flib_def;
+  options.graph_def_version = TF_GRAPH_DEF_VERSION;
+  options.device_allocator = allocator.get();
+
+  NameAttrList function;
+  function.set_name("AddFloats");
+  std::vector<XlaCompiler::Argument> args(2);
+  for (XlaCompiler::Argument& arg : args) {
+    arg.kind = XlaCompiler::Argument::kParameter;
+    arg.type = DT_FLOAT;
+    arg.shape = TensorShape({2});
+  }
+  XlaCompiler::CompileOptions compile_options;
+  compile_options.is_entry_computation = true;
+
+  XlaCompilationCache* cache =
+      new XlaCompilationCache(client, DeviceType(DEVICE_CPU_XLA_JIT));
+  core::ScopedUnref cache_ref(cache);
+  const XlaCompiler::CompilationResult* result = nullptr;
+  xla::LocalExecutable* executable = nullptr;
+  // The first execution is compiled, in the background.
+  TF_ASSERT_OK(cache->Compile(options, function, args, compile_options,
+                              XlaCompilationCache::CompileMode::kAsync,
+                              allocator, &result, &executable));
+  EXPECT_EQ(nullptr, result);
+  EXPECT_EQ(nullptr, executable);
+  // The background compilation keeps its own reference to the allocator.
+  options.device_allocator = nullptr;
+  allocator.reset();
+
+  // A strict compilation of the same signature waits for the background one.
+  TF_ASSERT_OK(cache->Compile(options, function, args, compile_options,
+                              XlaCompilationCache::CompileMode::kStrict,
+                              /*device_allocator_ref=*/nullptr, &result,
+                              &executable));
+  ASSERT_NE(nullptr, result);
+  EXPECT_NE(nullptr, executable);
+}
+
 }  // namespace
 }  // namespace tensorflow
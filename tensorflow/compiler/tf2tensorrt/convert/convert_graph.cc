@@ -40,6 +40,9 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
@@ -77,6 +80,42 @@ Status BuildNodeMap(const Graph& graph,
   return Status::OK();
 }
 
+// Launch overheads of a TensorFlow op and of a TensorRT engine, in
+// microseconds.
+constexpr double kOpLaunchOverheadUs = 5.0;
+constexpr double kEngineLaunchOverheadUs = 20.0;
+
+// Memory bandwidth to assume if the device doesn't report one, in KB/s.
+constexpr double kDefaultBandwidthKBps = 100.0 * 1000 * 1000;
+
+// Returns how many times faster TensorRT runs `op` than TensorFlow. Only the
+// ops that do most of the compute of models are sped up; the others only
+// save their launch overhead.
+double GetTrtOpSpeedup(const string& op, TrtPrecisionMode precision_mode) {
+  static const auto* compute_heavy_ops = new std::set<string>{
+      "BatchMatMul", "Conv2D", "Conv2DBackpropInput", "DepthwiseConv2dNative",
+      "MatMul"};
+  if (!compute_heavy_ops->count(op)) return 1.0;
+  switch (precision_mode) {
+    case TrtPrecisionMode::FP32:
+      return 1.2;
+    case TrtPrecisionMode::FP16:
+      return 2.0;
+    case TrtPrecisionMode::INT8:
+      return 3.0;
+  }
+  return 1.0;
+}
+
+// Returns the size of a tensor, counting unknown dimensions as 1.
+int64 GetMinimumTensorBytes(const PartialTensorShape& shape, DataType dtype) {
+  int64 num_elements = 1;
+  for (int i = 0; i < shape.dims(); ++i) {
+    num_elements *= std::max<int64>(shape.dim_size(i), 1);
+  }
+  return num_elements * DataTypeSize(dtype);
+}
+
 }  // namespace
 
 struct EdgePtrCompare {
@@ -688,6 +727,57 @@ std::pair<int, Allocator*> GetDeviceAndAllocator(const ConversionParams& params,
   return std::make_pair(cuda_device_id, dev_allocator);
 }
 
+float EstimateSegmentSpeedup(const std::set<const Node*>& segment,
+                             const EngineInfo& engine,
+                             const grappler::GraphProperties& graph_properties,
+                             TrtPrecisionMode precision_mode, string* report) {
+  const DeviceProperties device = grappler::GetDeviceInfo(
+      engine.device.empty() ? "/device:GPU:0" : engine.device);
+  grappler::OpLevelCostEstimator estimator;
+  double tf_time_us = 0;
+  double trt_time_us = kEngineLaunchOverheadUs;
+  for (const Node* node : segment) {
+    grappler::OpContext op_context;
+    op_context.name = node->name();
+    op_context.op_info.set_op(node->type_string());
+    *op_context.op_info.mutable_attr() = node->def().attr();
+    for (const auto& input :
+         graph_properties.GetInputProperties(node->name())) {
+      *op_context.op_info.add_inputs() = input;
+    }
+    for (const auto& output :
+         graph_properties.GetOutputProperties(node->name())) {
+      *op_context.op_info.add_outputs() = output;
+    }
+    *op_context.op_info.mutable_device() = device;
+    const double op_time_us =
+        estimator.PredictCosts(op_context).execution_time.count() / 1000.0;
+    tf_time_us += op_time_us + kOpLaunchOverheadUs;
+    trt_time_us +=
+        op_time_us / GetTrtOpSpeedup(node->type_string(), precision_mode);
+  }
+
+  // Every tensor at the boundary is copied once, e.g. to change its layout.
+  int64 boundary_bytes = 0;
+  for (const EngineConnection& connection : engine.connections) {
+    if (connection.is_control_edge()) continue;
+    boundary_bytes += GetMinimumTensorBytes(connection.is_input_edge
+                                                ? connection.outside_shape
+                                                : connection.inside_shape,
+                                            connection.connection_type);
+  }
+  const double bandwidth_kbps =
+      device.bandwidth() > 0 ? device.bandwidth() : kDefaultBandwidthKBps;
+  // Reading and writing the bytes, at KB/s, in microseconds.
+  trt_time_us += 2 * boundary_bytes * 1000.0 / bandwidth_kbps;
+
+  const float speedup = tf_time_us / trt_time_us;
+  StrAppend(report, engine.engine_name, " with ", segment.size(),
+            " nodes: TensorFlow ", tf_time_us, " us, TensorRT ", trt_time_us,
+            " us with ", boundary_bytes, " boundary bytes, speedup ", speedup);
+  return speedup;
+}
+
 // Entry function from optimization pass.
 Status ConvertAfterShapes(const ConversionParams& params) {
   // Sanity checks.
@@ -755,6 +845,19 @@ Status ConvertAfterShapes(const ConversionParams& params) {
                    << status;
       continue;
     }
+    if (params.minimum_segment_speedup > 0) {
+      string report;
+      const float speedup =
+          EstimateSegmentSpeedup(curr_segment, curr_engine,
+                                 *params.graph_properties,
+                                 params.precision_mode, &report);
+      if (speedup < params.minimum_segment_speedup) {
+        LOG(INFO) << "Not converting segment " << t << ", which is not "
+                  << "estimated to be fast enough in TensorRT: " << report;
+        continue;
+      }
+      LOG(INFO) << "Converting segment " << t << ": " << report;
+    }
     curr_engine.precision_mode = params.precision_mode;
     curr_engine.engine_type = ((params.is_dyn_op || params.use_calibration)
                                    ? EngineInfo::EngineType::TRTDynamic
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_TF2TENSORRT_CONVERT_CONVERT_GRAPH_H_
 #define TENSORFLOW_COMPILER_TF2TENSORRT_CONVERT_CONVERT_GRAPH_H_
 
+#include <set>
 #include <vector>
 
 #include "tensorflow/compiler/tf2tensorrt/convert/convert_nodes.h"
@@ -48,6 +49,10 @@ struct ConversionParams {
   bool use_calibration = true;
   // Whether to use function fallback for TRTEngineOp
   bool use_function_backup = true;
+  // If positive, segments that aren't estimated to run at least this many
+  // times faster in TensorRT than in TensorFlow are not converted. See
+  // EstimateSegmentSpeedup().
+  float minimum_segment_speedup = 0;
 };
 
 // Method to call from optimization pass
@@ -57,6 +62,17 @@ Status ConvertAfterShapes(const ConversionParams& params);
 std::pair<int, Allocator*> GetDeviceAndAllocator(const ConversionParams& params,
                                                  const EngineInfo& engine);
 
+// Estimates how many times faster the nodes of `segment` run as the TensorRT
+// engine described by `engine` than as TensorFlow ops. TensorFlow pays a
+// launch overhead per op, while TensorRT pays one per engine, speeds up the
+// compute-heavy ops, and copies the tensors at the boundary of the engine. The
+// costs of the ops come from grappler's OpLevelCostEstimator. Appends a
+// description of the estimate to `report`. Expose for testing.
+float EstimateSegmentSpeedup(const std::set<const Node*>& segment,
+                             const EngineInfo& engine,
+                             const grappler::GraphProperties& graph_properties,
+                             TrtPrecisionMode precision_mode, string* report);
+
 }  // namespace convert
 }  // namespace tensorrt
 }  // namespace tensorflow
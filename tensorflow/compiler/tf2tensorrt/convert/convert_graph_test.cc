@@ -150,7 +150,8 @@ TEST(ConvertGraphTest, GetDeviceAndAllocator) {
 
 class ConvertAfterShapesTest : public ::testing::Test {
  public:
-  Status RunConvertAfterShape(Scope s, GraphDef* output_graph_def) {
+  Status RunConvertAfterShape(Scope s, GraphDef* output_graph_def,
+                              float minimum_segment_speedup = 0) {
     // Create GraphProperties.
     grappler::GrapplerItem item;
     TF_EXPECT_OK(s.ToGraphDef(&item.graph));
@@ -167,6 +168,7 @@ class ConvertAfterShapesTest : public ::testing::Test {
     params.minimum_segment_size = 1;
     params.graph_properties = &graph_properties;
     params.use_calibration = false;
+    params.minimum_segment_speedup = minimum_segment_speedup;
 
     return ConvertAfterShapes(params);
   }
@@ -218,6 +220,34 @@ TEST_F(ConvertAfterShapesTest, DirectlyConnectedEngines) {
   EXPECT_EQ(2, num_trt_ops);
 }
 
+TEST_F(ConvertAfterShapesTest, SkipsSegmentsNotEstimatedToBeFaster) {
+  // A segment of cheap elementwise ops only pays the launch of the engine and
+  // the copies of its inputs and outputs.
+  Scope s = Scope::NewRootScope();
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({1024, 1024}));
+  auto identity = ops::Identity(s.WithOpName("identity"), input);
+  auto add = ops::Add(s.WithOpName("add"), identity, identity);
+  ops::Identity(s.WithOpName("output"), add);
+
+  auto count_trt_ops = [](const GraphDef& graph_def) {
+    int num_trt_ops = 0;
+    for (const NodeDef& node : graph_def.node()) {
+      if (node.op() == "TRTEngineOp") ++num_trt_ops;
+    }
+    return num_trt_ops;
+  };
+
+  GraphDef output_graph_def;
+  TF_EXPECT_OK(RunConvertAfterShape(s, &output_graph_def));
+  EXPECT_EQ(1, count_trt_ops(output_graph_def));
+
+  output_graph_def.Clear();
+  TF_EXPECT_OK(RunConvertAfterShape(s, &output_graph_def,
+                                    /*minimum_segment_speedup=*/1));
+  EXPECT_EQ(0, count_trt_ops(output_graph_def));
+}
+
 }  // namespace convert
 }  // namespace tensorrt
 }  // namespace tensorflow
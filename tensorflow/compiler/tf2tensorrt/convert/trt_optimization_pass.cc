@@ -70,6 +70,9 @@ Status TRTOptimizationPass::Init(
   if (params.count("use_function_backup")) {
     use_function_backup_ = params.at("use_function_backup").b();
   }
+  if (params.count("minimum_segment_speedup")) {
+    minimum_segment_speedup_ = params.at("minimum_segment_speedup").f();
+  }
   return Status::OK();
 }
 
@@ -260,6 +263,7 @@ Status TRTOptimizationPass::Optimize(grappler::Cluster* cluster,
   cp.max_cached_engines = max_cached_batches_;
   cp.use_calibration = use_calibration_;
   cp.use_function_backup = use_function_backup_;
+  cp.minimum_segment_speedup = minimum_segment_speedup_;
   auto status = ConvertAfterShapes(cp);
   VLOG(1) << "Returning from " << name_;
   return status;
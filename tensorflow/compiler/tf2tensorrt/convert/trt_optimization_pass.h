@@ -41,7 +41,8 @@ class TRTOptimizationPass : public grappler::CustomGraphOptimizer {
         max_cached_batches_(1),
         max_workspace_size_bytes_(256LL << 20),
         use_calibration_(true),
-        use_function_backup_(true) {
+        use_function_backup_(true),
+        minimum_segment_speedup_(0) {
     VLOG(1) << "Constructing " << name_;
   }
 
@@ -73,6 +74,10 @@ class TRTOptimizationPass : public grappler::CustomGraphOptimizer {
 
   // Whether to allow TF function fallback path in TRTEngineOp.
   bool use_function_backup_;
+
+  // Segments estimated to run less than this many times faster in TensorRT
+  // are left in TensorFlow. Zero converts every segment.
+  float minimum_segment_speedup_;
 };
 
 }  // namespace convert
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/compiler/tf2tensorrt/convert/utils.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/calibration_resource.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_allocator.h"
+#include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_instance.pb.h"  // NOLINT
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_logger.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_lru_cache.h"
 #include "tensorflow/core/framework/function.h"
@@ -30,13 +31,17 @@ limitations under the License.
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/stream_executor/lib/statusor.h"
 
 #if GOOGLE_CUDA
@@ -117,6 +122,23 @@ class TRTEngineOp : public AsyncOpKernel {
       const std::vector<TensorShape>& actual_input_shapes,
       std::vector<TensorShape>* engine_input_shapes);
 
+  // Returns the file in engine_cache_dir_ for the engine of the given input
+  // shapes, or an empty string if built engines are not saved.
+  string GetEngineCacheFilename(const std::vector<TensorShape>& input_shapes,
+                                OpKernelContext* ctx) const;
+
+  // Loads the engine for the given input shapes saved by an earlier run, if
+  // there is one.
+  Status LoadEngineFromCacheDir(
+      const string& filename, const std::vector<TensorShape>& input_shapes,
+      TRTBaseAllocator* allocator,
+      TrtUniquePtrType<nvinfer1::ICudaEngine>* engine);
+
+  // Saves a built engine so that later runs can load it.
+  Status SaveEngineToCacheDir(const string& filename,
+                              const std::vector<TensorShape>& input_shapes,
+                              nvinfer1::ICudaEngine* engine);
+
   std::vector<string> input_nodes_;
   std::vector<string> output_nodes_;
 
@@ -154,6 +176,16 @@ class TRTEngineOp : public AsyncOpKernel {
   // If true, create calibration graph for INT8 mode. Otherwise, we are using
   // user-provided quantization ranges.
   bool use_calibration_;
+
+  // Directory where built engines are saved and loaded from, set with the
+  // TF_TRT_ENGINE_CACHE_DIR environment variable. Empty if engines are only
+  // kept in memory.
+  string engine_cache_dir_;
+
+  // Everything other than the input shapes and the device that the engines
+  // built by this op depend on: the segment, the precision, the calibration
+  // data, the workspace size and the TensorRT version.
+  string engine_cache_key_;
 };
 
 #define TYPECASE(dt, X, Y)                                    \
@@ -202,6 +234,9 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
   OP_REQUIRES_OK(context,
                  context->GetAttr("workspace_size_bytes", &workspace_size_));
   OP_REQUIRES_OK(context, context->GetAttr("static_engine", &static_engine_));
+  OP_REQUIRES_OK(context, ReadStringFromEnvVar("TF_TRT_ENGINE_CACHE_DIR", "",
+                                               &engine_cache_dir_));
+  const uint64 segment_fingerprint = Fingerprint64(serialized_segment_);
   if (!static_engine_) {
     OP_REQUIRES(context, segment_graph_.ParseFromString(serialized_segment_),
                 errors::InvalidArgument("Failed to parse segment graphdef!"));
@@ -227,6 +262,12 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
   calibration_mode_ =
       (use_calibration_ && precision_mode_ == TrtPrecisionMode::INT8 &&
        calibration_data.empty());
+  engine_cache_key_ =
+      StrCat("segment:", segment_fingerprint, ";precision:", precision_string,
+             ";use_calibration:", use_calibration_ ? 1 : 0,
+             ";calibration:", Fingerprint64(calibration_data),
+             ";workspace:", workspace_size_,
+             ";tensorrt:", getInferLibVersion());
   if (!calibration_data.empty()) {
     calibrator_.reset(new TRTInt8Calibrator(calibration_data));
     calibration_data.resize(0);
@@ -661,12 +702,39 @@ StatusOr<EngineContext*> TRTEngineOp::GetEngine(
     std::vector<PartialTensorShape> partial_shapes(engine_input_shapes.begin(),
                                                    engine_input_shapes.end());
 
+    // Engines saved by an earlier run are loaded instead of being built again,
+    // which can take minutes.
+    const string cache_filename =
+        GetEngineCacheFilename(engine_input_shapes, ctx);
+    Status status = errors::NotFound("No saved engine");
+    if (!cache_filename.empty()) {
+      status = LoadEngineFromCacheDir(cache_filename, engine_input_shapes,
+                                      allocator, &engine);
+      if (status.ok()) {
+        LOG(INFO) << "Loaded the TensorRT engine for " << name()
+                  << " from " << cache_filename;
+      } else if (!errors::IsNotFound(status)) {
+        LOG(WARNING) << "Failed to load the TensorRT engine for " << name()
+                     << " from " << cache_filename << ": " << status;
+      }
+    }
+
     // Up to this point, calibrator_ can never be empty, since otherwise it
     // means calibration_mode_ is true and this path won't get executed.
-    auto status = convert::ConvertGraphDefToEngine(
-        segment_graph_, precision_mode_, batch_size, workspace_size_,
-        partial_shapes, &logger, allocator, calibrator_.get(), &engine,
-        use_calibration_, &convert_successfully);
+    if (!status.ok()) {
+      status = convert::ConvertGraphDefToEngine(
+          segment_graph_, precision_mode_, batch_size, workspace_size_,
+          partial_shapes, &logger, allocator, calibrator_.get(), &engine,
+          use_calibration_, &convert_successfully);
+      if (status.ok() && !cache_filename.empty()) {
+        const Status save_status = SaveEngineToCacheDir(
+            cache_filename, engine_input_shapes, engine.get());
+        if (!save_status.ok()) {
+          LOG(WARNING) << "Failed to save the TensorRT engine for " << name()
+                       << " to " << cache_filename << ": " << save_status;
+        }
+      }
+    }
     if (!status.ok()) {
       LOG(WARNING) << "Engine creation for " << name() << " failed. "
                    << "The native segment will be used instead. "
@@ -687,6 +755,79 @@ StatusOr<EngineContext*> TRTEngineOp::GetEngine(
   return cache.at(engine_input_shapes).get();
 }
 
+string TRTEngineOp::GetEngineCacheFilename(
+    const std::vector<TensorShape>& input_shapes, OpKernelContext* ctx) const {
+  if (engine_cache_dir_.empty()) return "";
+  // Engines are specific to the GPU model they were built for.
+  const string key =
+      StrCat(engine_cache_key_,
+             ";shapes:", TensorShapeUtils::ShapeListString(input_shapes),
+             ";device:", ctx->device()->attributes().physical_device_desc());
+  return io::JoinPath(
+      engine_cache_dir_,
+      StrCat(absl::Hex(Fingerprint64(key), absl::kZeroPad16), ".trtengine"));
+}
+
+Status TRTEngineOp::LoadEngineFromCacheDir(
+    const string& filename, const std::vector<TensorShape>& input_shapes,
+    TRTBaseAllocator* allocator,
+    TrtUniquePtrType<nvinfer1::ICudaEngine>* engine) {
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(env->FileExists(filename));
+  string serialized;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &serialized));
+  TRTEngineInstance engine_instance;
+  if (!engine_instance.ParseFromString(serialized)) {
+    return errors::DataLoss("Can't parse ", filename);
+  }
+  // Guard against fingerprint collisions.
+  std::vector<TensorShape> saved_input_shapes;
+  for (const TensorShapeProto& shape : engine_instance.input_shapes()) {
+    saved_input_shapes.emplace_back(shape);
+  }
+  if (saved_input_shapes != input_shapes) {
+    return errors::InvalidArgument(
+        "Saved engine is for input shapes ",
+        TensorShapeUtils::ShapeListString(saved_input_shapes));
+  }
+
+  TrtUniquePtrType<IRuntime> infer(nvinfer1::createInferRuntime(logger));
+  infer->setGpuAllocator(allocator);
+  engine->reset(infer->deserializeCudaEngine(
+      engine_instance.serialized_engine().c_str(),
+      engine_instance.serialized_engine().size(), nullptr));
+  if (*engine == nullptr) {
+    return errors::Internal("TensorRT can't deserialize the saved engine");
+  }
+  return Status::OK();
+}
+
+Status TRTEngineOp::SaveEngineToCacheDir(
+    const string& filename, const std::vector<TensorShape>& input_shapes,
+    nvinfer1::ICudaEngine* engine) {
+  TRTEngineInstance engine_instance;
+  for (const TensorShape& shape : input_shapes) {
+    shape.AsProto(engine_instance.add_input_shapes());
+  }
+  TrtUniquePtrType<nvinfer1::IHostMemory> engine_data(engine->serialize());
+  engine_instance.set_serialized_engine(engine_data->data(),
+                                        engine_data->size());
+
+  // Write to a temporary file first, so that other processes sharing the
+  // directory never load a partially written engine.
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(engine_cache_dir_));
+  const string tmp_filename = StrCat(filename, ".tmp", env->NowMicros(), "-",
+                                    env->GetCurrentThreadId());
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_filename,
+                                       engine_instance.SerializeAsString()));
+  const Status status = env->RenameFile(tmp_filename, filename);
+  if (!status.ok()) {
+    env->DeleteFile(tmp_filename).IgnoreError();
+  }
+  return status;
+}
+
 Status TRTEngineOp::AllocateCalibrationResources(OpKernelContext* ctx,
                                                  TRTCalibrationResource** cr) {
   auto cres = new TRTCalibrationResource();
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <dirent.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <fstream>
@@ -31,6 +32,8 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 #if GOOGLE_CUDA
@@ -142,6 +145,36 @@ TEST_F(TRTEngineOpTestBase, dynamic_shapes) {
   EXPECT_THAT((++iter)->first, ElementsAre(TensorShape({2, 2})));
 }
 
+TEST_F(TRTEngineOpTestBase, SavesAndLoadsEnginesFromCacheDir) {
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "SavesAndLoadsEnginesFromCacheDir");
+  setenv("TF_TRT_ENGINE_CACHE_DIR", cache_dir.c_str(), /*overwrite=*/1);
+  TRTEngineOpTestBase::AddSimpleTrtOp(DT_FLOAT);
+  unsetenv("TF_TRT_ENGINE_CACHE_DIR");
+
+  // The built engine is saved.
+  TRTEngineOpTestBase::AddSimpleInput<float>(TensorShape({1, 2}));
+  TF_ASSERT_OK(OpsTestBase::RunOpKernel());
+  std::vector<string> saved_engines;
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+      io::JoinPath(cache_dir, "*.trtengine"), &saved_engines));
+  EXPECT_EQ(1, saved_engines.size());
+
+  // Without the in-memory cache, the saved engine is loaded instead of built.
+  TF_ASSERT_OK(device_->resource_manager()->Delete<TRTEngineCacheResource>(
+      "TF-TRT-Engine-Cache", "myop"));
+  ResetInputs();
+  TRTEngineOpTestBase::AddSimpleInput<float>(TensorShape({1, 2}));
+  TF_ASSERT_OK(OpsTestBase::RunOpKernel());
+  Tensor* output = OpsTestBase::GetOutput(0);
+  EXPECT_THAT(absl::Span<const float>(output->flat<float>().data(),
+                                      output->NumElements()),
+              ElementsAre(0.0f, 2.0f));
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+      io::JoinPath(cache_dir, "*.trtengine"), &saved_engines));
+  EXPECT_EQ(1, saved_engines.size());
+}
+
 template <typename T>
 class TRTEngineOpTest : public TRTEngineOpTestBase {};
 
@@ -58,6 +58,7 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_gpu_enable_fast_min_max(true);
 
   opts.set_xla_allow_excess_precision(true);
+  opts.set_xla_constant_folding_on_host_min_elements(1 << 20);
   opts.set_xla_force_host_platform_device_count(1);
   return opts;
 }
@@ -122,6 +123,15 @@ static void AllocateFlags() {
     };
   };
 
+  // Returns a lambda that calls "member_setter" on "flag_values" with the
+  // argument passed in to the lambda.
+  auto int64_setter_for = [](void (DebugOptions::*member_setter)(int64)) {
+    return [member_setter](int64 value) {
+      (flag_values->*member_setter)(value);
+      return true;
+    };
+  };
+
   auto string_setter_for =
       [](void (DebugOptions::*member_setter)(const string& value)) {
         return [member_setter](const string& value) {
@@ -508,6 +518,47 @@ static void AllocateFlags() {
           bool_setter_for(&DebugOptions::set_xla_gpu_force_conv_nchw),
           flag_values->xla_gpu_force_conv_nchw(),
           "For cuDNN convolutions, always NCHW layouts."),
+      tensorflow::Flag(
+          "xla_gpu_persistent_cubin_cache_dir",
+          flag_values->mutable_xla_gpu_persistent_cubin_cache_dir(),
+          "If non-empty, directory in which to store the cubins compiled from "
+          "PTX, to reuse them across processes instead of running ptxas "
+          "again."),
+      tensorflow::Flag(
+          "xla_gpu_enable_cuda_graphs",
+          bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+          flag_values->xla_gpu_enable_cuda_graphs(),
+          "If true, replay the thunks of GPU executables that only launch "
+          "kernels on one stream as CUDA graphs, captured on their first run "
+          "with each set of buffer addresses."),
+      tensorflow::Flag(
+          "xla_gpu_autotune_cache_dir",
+          flag_values->mutable_xla_gpu_autotune_cache_dir(),
+          "If non-empty, directory in which to store the results of "
+          "autotuning convolutions and gemms, to reuse them across processes "
+          "instead of autotuning again."),
+      tensorflow::Flag(
+          "xla_gpu_rematerialization_memory_limit_bytes",
+          int64_setter_for(
+              &DebugOptions::set_xla_gpu_rematerialization_memory_limit_bytes),
+          flag_values->xla_gpu_rematerialization_memory_limit_bytes(),
+          "If positive, rematerialize the instructions which are the cheapest "
+          "to recompute until the peak memory use of each module on GPU is "
+          "below this many bytes."),
+      tensorflow::Flag(
+          "xla_gpu_enable_async_all_reduce",
+          bool_setter_for(&DebugOptions::set_xla_gpu_enable_async_all_reduce),
+          flag_values->xla_gpu_enable_async_all_reduce(),
+          "If true, run all-reduces on GPU on a separate stream, as early as "
+          "possible, to overlap them with computation."),
+      tensorflow::Flag(
+          "xla_constant_folding_on_host_min_elements",
+          int64_setter_for(
+              &DebugOptions::set_xla_constant_folding_on_host_min_elements),
+          flag_values->xla_constant_folding_on_host_min_elements(),
+          "Constant fold the instructions which read and write at least this "
+          "many elements by compiling them for the host, rather than with the "
+          "HLO evaluator. Zero or less disables this."),
   });
   ParseFlagsFromEnvAndDieIfUnknown("XLA_FLAGS", *flag_objects);
 }
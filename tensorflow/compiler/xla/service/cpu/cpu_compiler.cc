@@ -92,6 +92,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
+#include "tensorflow/compiler/xla/service/host_constant_evaluator.h"
 #include "tensorflow/compiler/xla/service/indexed_array_analysis.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/map_inliner.h"
@@ -327,7 +328,11 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
 
     pass.AddPass<HloDCE>();
     pass.AddPass<ReshapeMover>();
-    pass.AddPass<HloConstantFolding>();
+    pass.AddPass<HloConstantFolding>(
+        module->config()
+            .debug_options()
+            .xla_constant_folding_on_host_min_elements(),
+        EvaluateConstantOnHost);
     pass.AddPass<ConditionalSimplifier>();
   }
   pipeline.AddPass<IndexedArrayAnalysisPrinterPass>();
@@ -356,7 +361,8 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
 
 Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     HloModule* module, bool is_aot_compile,
-    LLVMTargetMachineFeatures* target_machine_features) {
+    LLVMTargetMachineFeatures* target_machine_features,
+    int aot_max_parallelism) {
   HloPassPipeline pipeline("HLO passes after layout assignment");
   // After layout assignment, use a layout-sensitive verifier.
   auto& after_layout_assn =
@@ -391,12 +397,15 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
           : tensorflow::port::NumSchedulableCPUs();
   if (!is_aot_compile) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
-    // Note this is not run for AOT because it would bring in thread pool
-    // and thread synchronization dependencies which would likely increase
-    // binary size (and most AOT applications are single-threaded).
-    // TODO(b/29630486) Support multi-threaded AOT.
     pipeline.AddPass<ParallelTaskAssigner>(
         max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
+  } else if (aot_max_parallelism > 1) {
+    // AOT compilations only do this when asked to, because it brings in
+    // thread pool and thread synchronization dependencies which increase
+    // binary size, and most AOT applications are single-threaded.
+    pipeline.AddPass<ParallelTaskAssigner>(aot_max_parallelism,
+                                           ShapeSizeBytesFunction(),
+                                           target_machine_features);
   }
   // Copy insertion should be performed immediately before IR emission to
   // avoid inserting unnecessary copies (later pass adds an instruction which
@@ -412,12 +421,14 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
 }
 
 Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile,
-                                 llvm::TargetMachine* target_machine) {
+                                 llvm::TargetMachine* target_machine,
+                                 int aot_max_parallelism) {
   LLVMTargetMachineFeatures target_machine_features(target_machine);
   TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(module, is_aot_compile,
                                                    &target_machine_features));
   return RunHloPassesAfterLayoutAssn(module, is_aot_compile,
-                                     &target_machine_features);
+                                     &target_machine_features,
+                                     aot_max_parallelism);
 }
 
 namespace {
@@ -843,8 +854,9 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
     HloModule* module = modules[i].get();
     VLOG(1) << "Compiling ahead-of-time: " << module->name();
 
-    TF_RETURN_IF_ERROR(
-        RunHloPasses(module, /*is_aot_compile=*/true, target_machine.get()));
+    TF_RETURN_IF_ERROR(RunHloPasses(module, /*is_aot_compile=*/true,
+                                    target_machine.get(),
+                                    options.max_parallelism()));
 
     TF_ASSIGN_OR_RETURN(HloSchedule schedule,
                         ScheduleModule(module, BufferSizeBytesFunction()));
@@ -69,12 +69,22 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   // The relocation model used for compilation.
   RelocationModel relocation_model() const { return relocation_model_; }
 
+  // If greater than 1, large ops are split into up to this many parallel
+  // tasks, which run on the intra-op thread pool of the ExecutableRunOptions
+  // (or on the calling thread if it has none). Otherwise the generated code
+  // is single-threaded, apart from the Eigen matmul and conv runtime calls.
+  int max_parallelism() const { return max_parallelism_; }
+  void set_max_parallelism(int max_parallelism) {
+    max_parallelism_ = max_parallelism;
+  }
+
  private:
   const string triple_;
   const string cpu_name_;
   const string features_;
   const string entry_point_name_;
   const RelocationModel relocation_model_;
+  int max_parallelism_ = 0;
 };
 
 class CpuAotCompilationResult : public AotCompilationResult {
@@ -152,9 +162,11 @@ class CpuCompiler : public LLVMCompiler {
   static void InitializeLLVMTarget();
 
   // Runs the HLO passes which are necessary for both optimizations and
-  // correctness.
+  // correctness. AOT compilations only assign parallel tasks if
+  // aot_max_parallelism is greater than 1.
   Status RunHloPasses(HloModule* module, bool is_aot_compile,
-                      llvm::TargetMachine* target_machine);
+                      llvm::TargetMachine* target_machine,
+                      int aot_max_parallelism = 0);
 
   // Runs HLO passes up to and including layout assignment.
   Status RunHloPassesThroughLayoutAssn(
@@ -164,7 +176,8 @@ class CpuCompiler : public LLVMCompiler {
   // Runs HLO passes after layout assignment.
   Status RunHloPassesAfterLayoutAssn(
       HloModule* module, bool is_aot_compile,
-      LLVMTargetMachineFeatures* target_machine_features);
+      LLVMTargetMachineFeatures* target_machine_features,
+      int aot_max_parallelism);
 
   TF_DISALLOW_COPY_AND_ASSIGN(CpuCompiler);
 };
@@ -26,6 +26,10 @@ const char* const kLlvmIrDotTilingFactor = "xla_llvm_dot_tiling_factor";
 const char* const kXlaForceEnableExperimentalLlvmIrGemm =
     "xla_force_enable_experimental_llvm_ir_gemm";
 const char* const kLlvmIrGemmTileSize = "xla_llvm_ir_gemm_tile_size";
+const char* const kXlaDisableVectorTiledLoopsCpuOption =
+    "xla_cpu_disable_vector_tiled_loops";
+const char* const kXlaParallelCostProfileCpuOption =
+    "xla_cpu_parallel_cost_profile";
 
 }  // namespace
 
@@ -45,6 +49,13 @@ bool VectorizedReduceDisabled(const HloModuleConfig& config) {
   return extra_options_map.count(kXlaOptimizeForSizeCpuOption) > 0;
 }
 
+bool VectorTiledLoopsDisabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaOptimizeForSizeCpuOption) > 0 ||
+         extra_options_map.count(kXlaDisableVectorTiledLoopsCpuOption) > 0;
+}
+
 absl::optional<int64> LlvmIrGemvTilingFactor(const HloModuleConfig& config) {
   const auto& extra_options_map =
       config.debug_options().xla_backend_extra_options();
@@ -57,6 +68,16 @@ absl::optional<int64> LlvmIrGemvTilingFactor(const HloModuleConfig& config) {
   return absl::nullopt;
 }
 
+absl::optional<string> ParallelCostProfile(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  auto it = extra_options_map.find(kXlaParallelCostProfileCpuOption);
+  if (it == extra_options_map.end()) {
+    return absl::nullopt;
+  }
+  return string(it->second);
+}
+
 bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config) {
   const auto& extra_options_map =
       config.debug_options().xla_backend_extra_options();
@@ -40,6 +40,7 @@ limitations under the License.
 #include "llvm/IR/LLVMContext.h"
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/map_util.h"
+#include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
@@ -3157,13 +3158,26 @@ Status IrEmitter::EmitTargetElementLoop(
     llvm_ir::EmitTuple(target_array, tuple_operand_ptrs, &b_);
 
   } else {
+    const int64 vector_tile_size = GetVectorTileSize(*target_op);
     if (ShouldEmitParallelLoopFor(*target_op)) {
       // Emit code to read dynamic loop bounds from compute function argument.
       std::vector<std::pair<llvm::Value*, llvm::Value*>> dynamic_loop_bounds =
           compute_function_->GetDynamicLoopBounds();
       // Emit parallel loop with dynamic loop bounds for most-major dimensions.
+      // Shapes partitioned down to their most-minor dimension are not tiled.
+      TF_RETURN_IF_ERROR(
+          ParallelLoopEmitter(
+              element_generator, target_array, &dynamic_loop_bounds, &b_,
+              target_shape.rank() > dynamic_loop_bounds.size()
+                  ? vector_tile_size
+                  : 1)
+              .EmitLoop(IrName(target_op)));
+    } else if (vector_tile_size > 1) {
+      // Emit a sequential loop nest tiled like the parallel one.
+      DynamicLoopBounds no_dynamic_loop_bounds;
       TF_RETURN_IF_ERROR(ParallelLoopEmitter(element_generator, target_array,
-                                             &dynamic_loop_bounds, &b_)
+                                             &no_dynamic_loop_bounds, &b_,
+                                             vector_tile_size)
                              .EmitLoop(IrName(target_op)));
     } else {
       TF_RETURN_IF_ERROR(
@@ -3174,6 +3188,30 @@ Status IrEmitter::EmitTargetElementLoop(
   return Status::OK();
 }
 
+int64 IrEmitter::GetVectorTileSize(const HloInstruction& op) {
+  // Only loop fusions are tiled: they are where elementwise chains with
+  // broadcasts end up, and their element generators have no side effects.
+  if (op.opcode() != HloOpcode::kFusion || !op.IsLoopFusion() ||
+      options::VectorTiledLoopsDisabled(hlo_module_config_)) {
+    return 1;
+  }
+  const Shape& shape = op.shape();
+  if (!shape.IsArray() || ShapeUtil::IsScalar(shape) ||
+      (!primitive_util::IsFloatingPointType(shape.element_type()) &&
+       !primitive_util::IsIntegralType(shape.element_type()))) {
+    return 1;
+  }
+  const int64 minor_dimension_size =
+      shape.dimensions(LayoutUtil::Minor(shape.layout(), 0));
+  int64 vector_tile_size =
+      target_machine_features_.vector_register_num_elements(
+          *compute_function_->function(), shape.element_type());
+  while (vector_tile_size > 1 && minor_dimension_size % vector_tile_size != 0) {
+    vector_tile_size /= 2;
+  }
+  return std::max<int64>(vector_tile_size, 1);
+}
+
 Status IrEmitter::EmitMemcpy(const HloInstruction& source,
                              const HloInstruction& destination) {
   llvm::Value* source_value = GetEmittedValueFor(&source);
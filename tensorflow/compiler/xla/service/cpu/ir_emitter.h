@@ -485,6 +485,13 @@ class IrEmitter : public DfsHloVisitorWithDefault,
            op.parent()->root_instruction() == &op;
   }
 
+  // Returns the number of consecutive elements of the most-minor dimension of
+  // `op` computed by each iteration of its element loop, so that LLVM
+  // vectorizes them as a whole: the number of elements of a vector register,
+  // or the largest power of two below it dividing the most-minor dimension.
+  // Returns 1 if the element loop of `op` should not be vector-tiled.
+  int64 GetVectorTileSize(const HloInstruction& op);
+
   // This struct contains all the state needed to emit instructions for
   // profiling a computation.
   class ProfilingState {
@@ -25,9 +25,11 @@ namespace cpu {
 ParallelLoopEmitter::ParallelLoopEmitter(
     const llvm_ir::ElementGenerator& target_element_generator,
     const llvm_ir::IrArray& target_array,
-    const DynamicLoopBounds* dynamic_loop_bounds, llvm::IRBuilder<>* b)
+    const DynamicLoopBounds* dynamic_loop_bounds, llvm::IRBuilder<>* b,
+    int64 vector_tile_size)
     : LoopEmitter(target_element_generator, target_array, b),
-      dynamic_loop_bounds_(dynamic_loop_bounds) {}
+      dynamic_loop_bounds_(dynamic_loop_bounds),
+      vector_tile_size_(vector_tile_size) {}
 
 std::vector<llvm_ir::IrArray::Index>
 ParallelLoopEmitter::EmitIndexAndSetExitBasicBlock(absl::string_view loop_name,
@@ -56,14 +58,20 @@ ParallelLoopEmitter::EmitIndexAndSetExitBasicBlock(absl::string_view loop_name,
           end_index);
       array_multi_index[dimension] = loop->GetIndVarValue();
     } else {
-      // Emit static loop bounds for this dimension.
+      // Emit static loop bounds for this dimension. The most-minor dimension
+      // steps by whole vector tiles.
+      const int64 stride = i == 0 ? vector_tile_size_ : 1;
+      CHECK_EQ(shape_.dimensions(dimension) % stride, 0);
       std::unique_ptr<llvm_ir::ForLoop> loop = loop_nest.AddLoop(
           /*start_index=*/0,
           /*end_index=*/shape_.dimensions(dimension),
+          /*stride=*/stride,
           /*suffix=*/absl::StrFormat("dim.%d", dimension));
       array_multi_index[dimension] = loop->GetIndVarValue();
     }
   }
+  CHECK(vector_tile_size_ == 1 || num_dims > dynamic_loop_bounds_->size())
+      << "The most-minor dimension of a vector-tiled loop must be static";
   // Point IR builder at inner loop BB.
   llvm_ir::SetToFirstInsertPoint(loop_nest.GetInnerLoopBodyBasicBlock(), b_);
 
@@ -71,8 +79,20 @@ ParallelLoopEmitter::EmitIndexAndSetExitBasicBlock(absl::string_view loop_name,
   exit_bb_ = loop_nest.GetOuterLoopExitBasicBlock();
   CHECK(exit_bb_ != nullptr);
 
-  llvm_ir::IrArray::Index array_index(array_multi_index, shape_, index_type);
-  return {array_index};
+  // Return the indices of the consecutive elements of the vector tile.
+  const int64 minor_dimension = LayoutUtil::Minor(shape_.layout(), 0);
+  llvm::Value* tile_start = array_multi_index[minor_dimension];
+  std::vector<llvm_ir::IrArray::Index> array_indices;
+  array_indices.reserve(vector_tile_size_);
+  for (int64 i = 0; i < vector_tile_size_; ++i) {
+    if (i > 0) {
+      array_multi_index[minor_dimension] = b_->CreateAdd(
+          tile_start, llvm::ConstantInt::get(tile_start->getType(), i), "",
+          /*HasNUW=*/true, /*HasNSW=*/true);
+    }
+    array_indices.emplace_back(array_multi_index, shape_, index_type);
+  }
+  return array_indices;
 }
 
 }  // namespace cpu
@@ -45,6 +45,13 @@ namespace cpu {
 // Outer dimension partitions can be generated using the ShapePartitionAssigner
 // and ShapePartitionIterator utility classes from shape_partition.cc.
 //
+// If 'vector_tile_size' is greater than one, the loop over the most-minor
+// dimension steps by 'vector_tile_size' elements and its body computes that
+// many consecutive elements, which LLVM then vectorizes as a whole. The
+// most-minor dimension must have static bounds and be a multiple of
+// 'vector_tile_size'. With no dynamic loop bounds, this emits a sequential
+// vector-tiled loop nest.
+//
 class ParallelLoopEmitter : public llvm_ir::LoopEmitter {
  public:
   // Constructs a ParallelLoopEmitter which uses 'target_element_generator' to
@@ -54,7 +61,7 @@ class ParallelLoopEmitter : public llvm_ir::LoopEmitter {
   ParallelLoopEmitter(const llvm_ir::ElementGenerator& target_element_generator,
                       const llvm_ir::IrArray& target_array,
                       const DynamicLoopBounds* dynamic_loop_bounds,
-                      llvm::IRBuilder<>* b);
+                      llvm::IRBuilder<>* b, int64 vector_tile_size = 1);
 
   ParallelLoopEmitter(const ParallelLoopEmitter&) = delete;
   ParallelLoopEmitter& operator=(const ParallelLoopEmitter&) = delete;
@@ -65,6 +72,7 @@ class ParallelLoopEmitter : public llvm_ir::LoopEmitter {
 
  private:
   const DynamicLoopBounds* dynamic_loop_bounds_;
+  const int64 vector_tile_size_;
 };
 
 }  // namespace cpu
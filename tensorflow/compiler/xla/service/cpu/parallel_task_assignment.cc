@@ -15,8 +15,15 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 
+#include <cmath>
+#include <map>
+#include <vector>
+
 #include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
@@ -24,6 +31,11 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace xla {
 namespace cpu {
@@ -106,6 +118,187 @@ class DefaultCostModel : public ParallelCostModel {
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
+namespace {
+
+// Costs of the building blocks of HloCostAnalysis, and of running a parallel
+// task, measured on the host.
+struct MeasuredCosts {
+  double ns_per_flop = 0;
+  double ns_per_transcendental = 0;
+  double ns_per_byte = 0;
+  double ns_per_task = 0;
+};
+
+// Returns the nanoseconds per iteration of `body`, run `iterations` times.
+template <typename Body>
+double MeasureNanosPerIteration(int64 iterations, const Body& body) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const uint64 start_nanos = env->NowNanos();
+  for (int64 i = 0; i < iterations; ++i) {
+    body();
+  }
+  return static_cast<double>(env->NowNanos() - start_nanos) / iterations;
+}
+
+// Runs micro-benchmarks of arithmetic on data in L1 cache, of streaming
+// through memory and of fork/join over `max_parallelism` threads.
+MeasuredCosts CalibrateCosts(int64 max_parallelism) {
+  MeasuredCosts costs;
+  volatile float sink = 0;
+
+  constexpr int64 kCacheResidentElements = 1 << 10;
+  std::vector<float> values(kCacheResidentElements, 1.0f);
+  auto multiply_add = [&values] {
+    for (float& value : values) {
+      value = value * 0.999f + 0.001f;
+    }
+  };
+  costs.ns_per_flop = MeasureNanosPerIteration(1 << 12, multiply_add) /
+                      (2 * kCacheResidentElements);
+  auto exponential = [&values] {
+    for (float& value : values) {
+      value = std::exp(-value);
+    }
+  };
+  costs.ns_per_transcendental =
+      MeasureNanosPerIteration(1 << 6, exponential) / kCacheResidentElements;
+  sink = values[0];
+
+  // Stream through a buffer much larger than the last level cache.
+  constexpr int64 kStreamedElements = 1 << 24;
+  std::vector<float> buffer(kStreamedElements, 1.0f);
+  auto sum = [&buffer, &sink] {
+    float sum = 0;
+    for (float value : buffer) {
+      sum += value;
+    }
+    sink = sum;
+  };
+  costs.ns_per_byte = MeasureNanosPerIteration(4, sum) /
+                      (kStreamedElements * sizeof(float));
+
+  if (max_parallelism > 1) {
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_cpu_calibration", max_parallelism);
+    auto fork_join = [&pool, max_parallelism] {
+      tensorflow::BlockingCounter counter(max_parallelism - 1);
+      for (int64 i = 1; i < max_parallelism; ++i) {
+        pool.Schedule([&counter] { counter.DecrementCount(); });
+      }
+      counter.Wait();
+    };
+    costs.ns_per_task =
+        MeasureNanosPerIteration(1 << 8, fork_join) / max_parallelism;
+  }
+  return costs;
+}
+
+Status ReadCostProfile(const string& path, MeasuredCosts* costs) {
+  string contents;
+  TF_RETURN_IF_ERROR(tensorflow::ReadFileToString(tensorflow::Env::Default(),
+                                                  path, &contents));
+  for (absl::string_view line :
+       absl::StrSplit(contents, '\n', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> fields =
+        absl::StrSplit(line, ' ', absl::SkipEmpty());
+    double value;
+    if (fields.size() != 2 || !absl::SimpleAtod(fields[1], &value)) {
+      return InvalidArgument("Malformed line in cost profile %s: %s", path,
+                             line);
+    }
+    if (fields[0] == "ns_per_flop") {
+      costs->ns_per_flop = value;
+    } else if (fields[0] == "ns_per_transcendental") {
+      costs->ns_per_transcendental = value;
+    } else if (fields[0] == "ns_per_byte") {
+      costs->ns_per_byte = value;
+    } else if (fields[0] == "ns_per_task") {
+      costs->ns_per_task = value;
+    }
+  }
+  return Status::OK();
+}
+
+Status WriteCostProfile(const string& path, const MeasuredCosts& costs) {
+  return tensorflow::WriteStringToFile(
+      tensorflow::Env::Default(), path,
+      absl::StrCat("ns_per_flop ", costs.ns_per_flop,
+                   "\nns_per_transcendental ", costs.ns_per_transcendental,
+                   "\nns_per_byte ", costs.ns_per_byte, "\nns_per_task ",
+                   costs.ns_per_task, "\n"));
+}
+
+// Returns the costs in the profile at `path`, calibrating them and writing the
+// profile first if it does not exist yet. An empty `path` calibrates the costs
+// without writing them. The costs are computed once per process and path.
+MeasuredCosts GetMeasuredCosts(const string& path, int64 max_parallelism) {
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static auto* costs_by_path = new std::map<string, MeasuredCosts>();
+  tensorflow::mutex_lock lock(mu);
+  auto it = costs_by_path->find(path);
+  if (it != costs_by_path->end()) {
+    return it->second;
+  }
+  MeasuredCosts costs;
+  if (path.empty() || !tensorflow::Env::Default()->FileExists(path).ok()) {
+    costs = CalibrateCosts(max_parallelism);
+    VLOG(1) << "Calibrated parallel costs: ns_per_flop " << costs.ns_per_flop
+            << " ns_per_transcendental " << costs.ns_per_transcendental
+            << " ns_per_byte " << costs.ns_per_byte << " ns_per_task "
+            << costs.ns_per_task;
+    if (!path.empty()) {
+      Status status = WriteCostProfile(path, costs);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to write parallel cost profile: " << status;
+      }
+    }
+  } else {
+    Status status = ReadCostProfile(path, &costs);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to read parallel cost profile, calibrating "
+                   << "instead: " << status;
+      costs = CalibrateCosts(max_parallelism);
+    }
+  }
+  costs_by_path->emplace(path, costs);
+  return costs;
+}
+
+}  // namespace
+
+// Cost model fitted to the host: estimates the run time of an instruction from
+// its HloCostAnalysis counts and the measured cost of each, and picks the task
+// count minimizing run_time / task_count + task_count * ns_per_task.
+class MeasuredCostModel : public ParallelCostModel {
+ public:
+  MeasuredCostModel(const int64 max_parallelism, const MeasuredCosts& costs,
+                    std::unique_ptr<HloCostAnalysis> cost_analysis)
+      : max_parallelism_(max_parallelism),
+        costs_(costs),
+        cost_analysis_(std::move(cost_analysis)) {}
+  ~MeasuredCostModel() override {}
+
+  int64 GetParallelTaskCount(HloInstruction* instruction) override {
+    const double run_time_ns =
+        costs_.ns_per_flop * cost_analysis_->flop_count(*instruction) +
+        costs_.ns_per_transcendental *
+            cost_analysis_->transcendental_count(*instruction) +
+        costs_.ns_per_byte * cost_analysis_->bytes_accessed(*instruction);
+    if (costs_.ns_per_task <= 0) {
+      return max_parallelism_;
+    }
+    const double task_count = std::sqrt(run_time_ns / costs_.ns_per_task);
+    // Return target parallel task count in [1, max_parallelism_].
+    return std::min(max_parallelism_,
+                    std::max(int64{1}, static_cast<int64>(task_count)));
+  }
+
+ private:
+  const int64 max_parallelism_;
+  const MeasuredCosts costs_;
+  const std::unique_ptr<HloCostAnalysis> cost_analysis_;
+};
+
 ParallelTaskAssignment::ParallelTaskAssignment(
     const int64 max_parallelism,
     const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module,
@@ -116,7 +309,14 @@ ParallelTaskAssignment::ParallelTaskAssignment(
   auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size);
   HloComputation* computation = module->entry_computation();
   Status status = computation->root_instruction()->Accept(cost_analysis.get());
-  if (status.ok()) {
+  absl::optional<string> cost_profile =
+      options::ParallelCostProfile(module->config());
+  if (status.ok() && cost_profile.has_value()) {
+    // Use the costs measured on the host, or read from a profile of them.
+    cost_model_.reset(new MeasuredCostModel(
+        max_parallelism, GetMeasuredCosts(*cost_profile, max_parallelism),
+        std::move(cost_analysis)));
+  } else if (status.ok()) {
     // Set default cost model based on 'cost_analysis'.
     cost_model_.reset(new DefaultCostModel(max_parallelism, shape_size,
                                            std::move(cost_analysis)));
@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/test.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace xla {
 namespace {
@@ -44,6 +46,22 @@ class ParallelTaskAssignmentTest : public HloTestBase {
                                      &target_machine_features_)
         .Run(module);
   }
+
+  // Returns a module config reading the measured parallel costs from a profile
+  // with the given contents.
+  HloModuleConfig GetConfigWithCostProfile(const string& name,
+                                           const string& profile) {
+    const string path =
+        tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+    TF_CHECK_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(), path,
+                                              profile));
+    HloModuleConfig config = GetModuleConfigForTest();
+    DebugOptions debug_options = config.debug_options();
+    (*debug_options.mutable_xla_backend_extra_options())
+        ["xla_cpu_parallel_cost_profile"] = path;
+    config.set_debug_options(debug_options);
+    return config;
+  }
 };
 
 TEST_F(ParallelTaskAssignmentTest, DotOperationNotParallelized) {
@@ -170,5 +188,50 @@ TEST_F(ParallelTaskAssignmentTest, InPlaceDynamicUpdateSliceNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, MeasuredCostsParallelizeExpensiveLoops) {
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_measured_costs
+    ENTRY Exp {
+      p = f32[1024,1024] parameter(0)
+      ROOT exp = f32[1024,1024] exponential(p)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<HloModule> m,
+      ParseAndReturnVerifiedModule(
+          hlo_string,
+          GetConfigWithCostProfile("cheap_tasks",
+                                   "ns_per_flop 1\n"
+                                   "ns_per_transcendental 10\n"
+                                   "ns_per_byte 1\n"
+                                   "ns_per_task 1000\n")));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+}
+
+TEST_F(ParallelTaskAssignmentTest, MeasuredCostsDoNotParallelizeCheapLoops) {
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_measured_costs
+    ENTRY Exp {
+      p = f32[1024,1024] parameter(0)
+      ROOT exp = f32[1024,1024] exponential(p)
+    }
+  )";
+
+  // A task costs more than computing the whole result.
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<HloModule> m,
+      ParseAndReturnVerifiedModule(
+          hlo_string,
+          GetConfigWithCostProfile("expensive_tasks",
+                                   "ns_per_flop 1\n"
+                                   "ns_per_transcendental 10\n"
+                                   "ns_per_byte 1\n"
+                                   "ns_per_task 1e9\n")));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+}
+
 }  // namespace
 }  // namespace xla
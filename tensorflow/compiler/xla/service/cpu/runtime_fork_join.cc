@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
 
+#include <algorithm>
+
 #define EIGEN_USE_THREADS
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -31,8 +33,8 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
+// Calls 'function_ptr' once per partition, in parallel over the intra-op
+// thread pool and the calling thread, which runs the first partitions inline.
 // Uses blocking counter to synchonize threads after parallel calls complete.
 //
 // The 'partitions' array has a total number of elements equal to
@@ -74,31 +76,45 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   const xla::ExecutableRunOptions* run_options =
       static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
   CHECK_NE(run_options, nullptr);
-  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
+  const Eigen::ThreadPoolDevice* thread_pool =
+      run_options->intra_op_thread_pool();
 
   ComputeFunctionType function =
       reinterpret_cast<ComputeFunctionType>(function_ptr);
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
+  // Run at most one task per thread of the pool plus the calling thread, each
+  // task calling 'function' on a contiguous range of partitions, so that
+  // partition counts chosen for a larger pool do not oversubscribe this one.
+  // Without a pool, which AOT callers may not set, run them all inline.
+  const int32 num_tasks =
+      thread_pool == nullptr
+          ? 1
+          : std::min<int32>(num_partitions, thread_pool->numThreads() + 1);
+  auto run_partitions = [=](int32 task) {
+    const int32 begin = static_cast<int64>(task) * num_partitions / num_tasks;
+    const int32 end =
+        static_cast<int64>(task + 1) * num_partitions / num_tasks;
+    for (int32 i = begin; i < end; ++i) {
+      function(result_ptr, run_options_ptr, nullptr, buffer_table,
+               &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+    }
+  };
+
+  // Dispatch 'num_tasks - 1' tasks to run in parallel.
+  tensorflow::BlockingCounter bc(num_tasks - 1);
+  for (int32 task = 1; task < num_tasks; ++task) {
+    thread_pool->enqueueNoNotification(
+        [task, &run_partitions, &bc]() {
+          run_partitions(task);
           bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
         });
   }
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  // Run the first task inline.
+  run_partitions(0);
   bc.Wait();
   VLOG(2) << "ParallelForkJoin EXIT";
 }
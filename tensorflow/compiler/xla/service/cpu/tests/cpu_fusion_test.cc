@@ -333,6 +333,30 @@ TEST_F(CpuFusionTest, DoNotDuplicateExpensiveOps) {
   EXPECT_EQ(0, fusion_inst->operand_count());
 }
 
+TEST_F(CpuFusionTest, VectorTiledLoopFusion) {
+  // The most-minor dimensions are multiples of the vector register width, of
+  // a smaller power of two, and of no power of two, so the fused loops are
+  // tiled by a whole vector register, by part of one, and not at all.
+  const char* const kModuleStr = R"(
+  HloModule VectorTiledLoopFusion
+
+  ENTRY main {
+    p0 = f32[5,64] parameter(0)
+    p1 = f32[64] parameter(1)
+    b1 = f32[5,64] broadcast(p1), dimensions={1}
+    add = f32[5,64] add(p0, b1)
+    mul = f32[5,64] multiply(add, add)
+    p2 = f32[3,12] parameter(2)
+    exp = f32[3,12] exponential(p2)
+    sub = f32[3,12] subtract(exp, p2)
+    p3 = s32[7,7] parameter(3)
+    neg = s32[7,7] negate(p3)
+    abs = s32[7,7] abs(neg)
+    ROOT tuple = (f32[5,64], f32[3,12], s32[7,7]) tuple(mul, sub, abs)
+  })";
+  EXPECT_TRUE(RunAndCompare(kModuleStr, error_spec_));
+}
+
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
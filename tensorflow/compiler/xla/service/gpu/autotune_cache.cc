@@ -0,0 +1,108 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_cache.h"
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+// Returns the path of the file storing the result cached under `key`. Files
+// are named after a fingerprint of the key.
+string PersistentAutotuneCachePath(const string& cache_dir,
+                                   const string& key) {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      cache_dir, absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                              absl::Hex(fingerprint.low64, absl::kZeroPad16),
+                              ".autotune"));
+}
+
+}  // namespace
+
+string PersistentAutotuneCacheKey(se::StreamExecutor* stream_exec,
+                                  absl::string_view instruction_key) {
+  const se::DeviceDescription& desc = stream_exec->GetDeviceDescription();
+  int cc_major = 0, cc_minor = 0;
+  desc.cuda_compute_capability(&cc_major, &cc_minor);
+  string dnn_version;
+  if (auto* dnn = stream_exec->AsDnn()) {
+    auto version_or = dnn->GetVersion();
+    if (version_or.ok()) {
+      const se::dnn::VersionInfo& version = version_or.ValueOrDie();
+      dnn_version = absl::StrCat(version.major_version(), ".",
+                                 version.minor_version(), ".",
+                                 version.patch());
+    }
+  }
+  return absl::StrCat(desc.name(), "\nsm_", cc_major, cc_minor, "\n",
+                      desc.driver_version(), "\n", desc.runtime_version(), "\n",
+                      dnn_version, "\n", instruction_key);
+}
+
+bool LoadPersistentAutotuneResult(const string& cache_dir, const string& key,
+                                  tensorflow::AutotuneResult* result) {
+  const string path = PersistentAutotuneCachePath(cache_dir, key);
+  AutotuneCacheEntry entry;
+  if (!tensorflow::ReadBinaryProto(tensorflow::Env::Default(), path, &entry)
+           .ok()) {
+    return false;
+  }
+  // Guard against fingerprint collisions.
+  if (entry.key() != key) {
+    VLOG(1) << "Ignoring autotuning result in " << path
+            << " cached under another key";
+    return false;
+  }
+  *result = entry.result();
+  return true;
+}
+
+void StorePersistentAutotuneResult(const string& cache_dir, const string& key,
+                                   const tensorflow::AutotuneResult& result) {
+  const string path = PersistentAutotuneCachePath(cache_dir, key);
+  AutotuneCacheEntry entry;
+  entry.set_key(key);
+  *entry.mutable_result() = result;
+
+  // The file is written under a unique name and then renamed, so that
+  // processes sharing the directory never read a partial file.
+  tensorflow::Env* env = tensorflow::Env::Default();
+  Status status = env->RecursivelyCreateDir(cache_dir);
+  const string temp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(tensorflow::random::New64()));
+  if (status.ok()) {
+    status = tensorflow::WriteBinaryProto(env, temp_path, entry);
+  }
+  if (status.ok()) {
+    status = env->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write autotuning result to " << path << ": "
+                 << status;
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+}
+
+}  // namespace gpu
+}  // namespace xla
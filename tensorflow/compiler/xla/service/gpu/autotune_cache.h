@@ -0,0 +1,50 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_CACHE_H_
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/protobuf/autotuning.pb.h"
+
+// Persistent cache of autotuning results, shared across processes through the
+// files of a directory (see DebugOptions::xla_gpu_autotune_cache_dir). Each
+// result is stored in its own file, as an AutotuneCacheEntry.
+
+namespace xla {
+namespace gpu {
+
+// Returns the key under which to cache the result of autotuning the
+// instruction described by `instruction_key` on `stream_exec`. The key also
+// identifies the device model and the driver, CUDA and cuDNN versions.
+string PersistentAutotuneCacheKey(se::StreamExecutor* stream_exec,
+                                  absl::string_view instruction_key);
+
+// Looks up the result stored under `key` in `cache_dir`. Returns false if
+// there is none.
+bool LoadPersistentAutotuneResult(const string& cache_dir, const string& key,
+                                  tensorflow::AutotuneResult* result);
+
+// Stores `result` under `key` in `cache_dir`. Failures only cost autotuning
+// again later, so they are logged and ignored.
+void StorePersistentAutotuneResult(const string& cache_dir, const string& key,
+                                   const tensorflow::AutotuneResult& result);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_CACHE_H_
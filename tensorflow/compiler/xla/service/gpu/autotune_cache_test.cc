@@ -0,0 +1,72 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_cache.h"
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+string TestCacheDir(const string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+TEST(AutotuneCacheTest, MissingResult) {
+  tensorflow::AutotuneResult result;
+  EXPECT_FALSE(LoadPersistentAutotuneResult(TestCacheDir("missing"),
+                                            "some key", &result));
+}
+
+TEST(AutotuneCacheTest, StoreAndLoadResults) {
+  const string cache_dir = TestCacheDir("store_and_load");
+  tensorflow::AutotuneResult conv_result;
+  conv_result.mutable_conv()->set_algorithm(3);
+  conv_result.mutable_conv()->set_tensor_ops_enabled(true);
+  conv_result.set_scratch_bytes(1024);
+  StorePersistentAutotuneResult(cache_dir, "conv key", conv_result);
+  tensorflow::AutotuneResult gemm_result;
+  gemm_result.mutable_gemm()->set_algorithm(7);
+  StorePersistentAutotuneResult(cache_dir, "gemm key", gemm_result);
+
+  tensorflow::AutotuneResult result;
+  ASSERT_TRUE(LoadPersistentAutotuneResult(cache_dir, "conv key", &result));
+  EXPECT_EQ(result.conv().algorithm(), 3);
+  EXPECT_TRUE(result.conv().tensor_ops_enabled());
+  EXPECT_EQ(result.scratch_bytes(), 1024);
+  ASSERT_TRUE(LoadPersistentAutotuneResult(cache_dir, "gemm key", &result));
+  EXPECT_EQ(result.gemm().algorithm(), 7);
+  EXPECT_FALSE(LoadPersistentAutotuneResult(cache_dir, "other key", &result));
+}
+
+TEST(AutotuneCacheTest, LaterResultReplacesEarlierOne) {
+  const string cache_dir = TestCacheDir("replace");
+  tensorflow::AutotuneResult gemm_result;
+  gemm_result.mutable_gemm()->set_algorithm(1);
+  StorePersistentAutotuneResult(cache_dir, "gemm key", gemm_result);
+  gemm_result.mutable_gemm()->set_algorithm(2);
+  StorePersistentAutotuneResult(cache_dir, "gemm key", gemm_result);
+
+  tensorflow::AutotuneResult result;
+  ASSERT_TRUE(LoadPersistentAutotuneResult(cache_dir, "gemm key", &result));
+  EXPECT_EQ(result.gemm().algorithm(), 2);
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,89 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/cubin_cache.h"
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+// Returns the path of the file storing the cubin cached under `key`. Files are
+// named after a fingerprint of the key, which holds the whole PTX.
+string PersistentCubinCachePath(const string& cache_dir, const string& key) {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      cache_dir, absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                              absl::Hex(fingerprint.low64, absl::kZeroPad16),
+                              ".cubin"));
+}
+
+}  // namespace
+
+string PersistentCubinCacheKey(absl::string_view ptx, int cc_major,
+                               int cc_minor, bool disable_ptxas_optimizations,
+                               absl::string_view ptxas_version) {
+  return absl::StrCat("ptxas ", ptxas_version, "\nsm_", cc_major, cc_minor,
+                      "\n", disable_ptxas_optimizations ? "-O0" : "-O3", "\n",
+                      ptx);
+}
+
+bool LoadPersistentCubin(const string& cache_dir, const string& key,
+                         std::vector<uint8>* cubin) {
+  string data;
+  if (!tensorflow::ReadFileToString(tensorflow::Env::Default(),
+                                    PersistentCubinCachePath(cache_dir, key),
+                                    &data)
+           .ok() ||
+      data.empty()) {
+    return false;
+  }
+  cubin->assign(data.begin(), data.end());
+  return true;
+}
+
+void StorePersistentCubin(const string& cache_dir, const string& key,
+                          const std::vector<uint8>& cubin) {
+  const string path = PersistentCubinCachePath(cache_dir, key);
+
+  // The file is written under a unique name and then renamed, so that
+  // processes sharing the directory never read a partial file.
+  tensorflow::Env* env = tensorflow::Env::Default();
+  Status status = env->RecursivelyCreateDir(cache_dir);
+  const string temp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(tensorflow::random::New64()));
+  if (status.ok()) {
+    status = tensorflow::WriteStringToFile(
+        env, temp_path,
+        absl::string_view(reinterpret_cast<const char*>(cubin.data()),
+                          cubin.size()));
+  }
+  if (status.ok()) {
+    status = env->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write cubin to " << path << ": " << status;
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,52 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CUBIN_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CUBIN_CACHE_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/types.h"
+
+// Persistent cache of the cubins that ptxas compiles from PTX, shared across
+// processes through the files of a directory (see
+// DebugOptions::xla_gpu_persistent_cubin_cache_dir). Each cubin is stored in
+// its own file.
+
+namespace xla {
+namespace gpu {
+
+// Returns the key under which to cache the cubin compiled from `ptx` for
+// compute capability `cc_major`.`cc_minor` by version `ptxas_version` of
+// ptxas, so that upgrading CUDA never serves cubins built by the old ptxas.
+string PersistentCubinCacheKey(absl::string_view ptx, int cc_major,
+                               int cc_minor, bool disable_ptxas_optimizations,
+                               absl::string_view ptxas_version);
+
+// Looks up the cubin stored under `key` in `cache_dir`. Returns false if there
+// is none.
+bool LoadPersistentCubin(const string& cache_dir, const string& key,
+                         std::vector<uint8>* cubin);
+
+// Stores `cubin` under `key` in `cache_dir`. Failures only cost a
+// recompilation later, so they are logged and ignored.
+void StorePersistentCubin(const string& cache_dir, const string& key,
+                          const std::vector<uint8>& cubin);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CUBIN_CACHE_H_
@@ -0,0 +1,71 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/cubin_cache.h"
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+string TestCacheDir(const string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+TEST(CubinCacheTest, MissingCubin) {
+  std::vector<uint8> cubin;
+  EXPECT_FALSE(
+      LoadPersistentCubin(TestCacheDir("missing"), "some key", &cubin));
+}
+
+TEST(CubinCacheTest, StoreAndLoadCubins) {
+  const string cache_dir = TestCacheDir("store_and_load");
+  const string key = PersistentCubinCacheKey(
+      "ptx", 7, 0, /*disable_ptxas_optimizations=*/false, "10.1.243");
+  StorePersistentCubin(cache_dir, key, {1, 2, 3});
+
+  std::vector<uint8> cubin;
+  ASSERT_TRUE(LoadPersistentCubin(cache_dir, key, &cubin));
+  EXPECT_EQ(cubin, std::vector<uint8>({1, 2, 3}));
+}
+
+TEST(CubinCacheTest, KeyIdentifiesEverythingTheCubinDependsOn) {
+  const string key = PersistentCubinCacheKey(
+      "ptx", 7, 0, /*disable_ptxas_optimizations=*/false, "10.1.243");
+  EXPECT_EQ(key, PersistentCubinCacheKey("ptx", 7, 0, false, "10.1.243"));
+  EXPECT_NE(key, PersistentCubinCacheKey("other ptx", 7, 0, false, "10.1.243"));
+  EXPECT_NE(key, PersistentCubinCacheKey("ptx", 7, 5, false, "10.1.243"));
+  EXPECT_NE(key, PersistentCubinCacheKey("ptx", 7, 0, true, "10.1.243"));
+  EXPECT_NE(key, PersistentCubinCacheKey("ptx", 7, 0, false, "10.2.89"));
+}
+
+TEST(CubinCacheTest, CubinOfAnotherPtxasVersionIsNotLoaded) {
+  const string cache_dir = TestCacheDir("ptxas_upgrade");
+  StorePersistentCubin(cache_dir,
+                       PersistentCubinCacheKey("ptx", 7, 0, false, "10.0.130"),
+                       {1, 2, 3});
+
+  std::vector<uint8> cubin;
+  EXPECT_FALSE(LoadPersistentCubin(
+      cache_dir, PersistentCubinCacheKey("ptx", 7, 0, false, "10.1.243"),
+      &cubin));
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_cache.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_comparator.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
@@ -201,6 +202,21 @@ StatusOr<ConvCacheKey> AutotuneCacheKeyfromInstruction(
       conv->feature_group_count());
 }
 
+// Returns the part of the key of the persistent autotuning cache that
+// describes the convolution, i.e. `key` without the StreamExecutor.
+string PersistentCacheInstructionKey(const ConvCacheKey& key) {
+  string instruction_key = absl::StrCat(
+      "conv\n", std::get<1>(key), "\n", std::get<2>(key), "\n",
+      ShapeUtil::HumanStringWithLayout(std::get<3>(key)));
+  for (const Shape& operand_shape : std::get<4>(key)) {
+    absl::StrAppend(&instruction_key, "\n",
+                    ShapeUtil::HumanStringWithLayout(operand_shape));
+  }
+  absl::StrAppend(&instruction_key, "\n", std::get<5>(key), "\n",
+                  std::get<6>(key), "\n", std::get<7>(key));
+  return instruction_key;
+}
+
 tensorflow::mutex autotune_cache_lock(tensorflow::LINKER_INITIALIZED);
 auto& autotune_cache GUARDED_BY(autotune_cache_lock) =
     *new absl::flat_hash_map<ConvCacheKey, AutotuneResult>();
@@ -237,11 +253,33 @@ StatusOr<AutotuneResult> CudnnConvAlgorithmPicker::PickBestAlgorithm(
     autotune_cache_stats.cache_misses++;
   }
 
+  // Then look for a result autotuned by an earlier process.
+  const string& persistent_cache_dir =
+      instr->GetModule()->config().debug_options().xla_gpu_autotune_cache_dir();
+  string persistent_key;
+  if (!persistent_cache_dir.empty()) {
+    persistent_key = PersistentAutotuneCacheKey(
+        stream_exec_, PersistentCacheInstructionKey(key));
+    AutotuneResult result;
+    if (LoadPersistentAutotuneResult(persistent_cache_dir, persistent_key,
+                                     &result)) {
+      VLOG(2) << "Using persistently cached autotuning result for "
+              << instr->ToString();
+      tensorflow::mutex_lock lock(autotune_cache_lock);
+      CHECK(autotune_cache.insert({key, result}).second);
+      return result;
+    }
+  }
+
   StatusOr<AutotuneResult> result_or = PickBestAlgorithmNoCache(instr);
   if (result_or.ok()) {
     tensorflow::mutex_lock lock(autotune_cache_lock);
     CHECK(autotune_cache.insert({key, result_or.ValueOrDie()}).second);
   }
+  if (result_or.ok() && !persistent_cache_dir.empty()) {
+    StorePersistentAutotuneResult(persistent_cache_dir, persistent_key,
+                                  result_or.ValueOrDie());
+  }
   return result_or;
 }
 
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gemm_algorithm_picker.h"
 
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_cache.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_comparator.h"
 #include "tensorflow/compiler/xla/service/gpu/gemm_thunk.h"
@@ -212,6 +214,31 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoGemmAutotune(
   cache_misses++;
   VLOG(4) << "Autotuning cache miss";
 
+  // Then look for a result autotuned by an earlier process. A result without
+  // a gemm algorithm stands for the generic algorithm.
+  const string& persistent_cache_dir =
+      instr->GetModule()->config().debug_options().xla_gpu_autotune_cache_dir();
+  string persistent_key;
+  if (!persistent_cache_dir.empty()) {
+    persistent_key = PersistentAutotuneCacheKey(
+        stream->parent(),
+        absl::StrCat("gemm\n", ShapeUtil::HumanStringWithLayout(lhs->shape()),
+                     "\n", ShapeUtil::HumanStringWithLayout(rhs->shape()),
+                     "\n", ShapeUtil::HumanStringWithLayout(instr->shape()),
+                     "\n", std::get<4>(key)));
+    AutotuneResult persistent_result;
+    if (LoadPersistentAutotuneResult(persistent_cache_dir, persistent_key,
+                                     &persistent_result)) {
+      VLOG(4) << "Using persistently cached autotuning result";
+      absl::optional<se::blas::AlgorithmType> result;
+      if (persistent_result.has_gemm()) {
+        result = persistent_result.gemm().algorithm();
+      }
+      CHECK(autotune_cache.emplace(key, result).second);
+      return result;
+    }
+  }
+
   int64 batch_size = gemm_config.batch_size();
   absl::optional<se::blas::AlgorithmType> result;
   if (batch_size != 1) {
@@ -227,6 +254,14 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoGemmAutotune(
   }
 
   CHECK(autotune_cache.emplace(key, result).second);
+  if (!persistent_cache_dir.empty()) {
+    AutotuneResult persistent_result;
+    if (result.has_value()) {
+      persistent_result.mutable_gemm()->set_algorithm(*result);
+    }
+    StorePersistentAutotuneResult(persistent_cache_dir, persistent_key,
+                                  persistent_result);
+  }
   return result;
 }
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/copy_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_debug_info_manager.h"
 #include "tensorflow/compiler/xla/service/gpu/hlo_execution_profiler.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
@@ -38,6 +39,9 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/stream_executor/cuda/cuda_activation.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#include "third_party/gpus/cuda/include/cuda_runtime_api.h"
 
 namespace xla {
 namespace gpu {
@@ -45,6 +49,11 @@ namespace {
 
 using tensorflow::tracing::ScopedAnnotation;
 
+// Maximum number of CUDA graphs kept per executable, i.e. of distinct sets of
+// buffer addresses it is replayed with. Later sets of addresses launch the
+// thunks one by one.
+constexpr size_t kMaxCudaGraphsPerExecutable = 16;
+
 }  // namespace
 
 // Implementation note: HLO profiling is always enabled for GPU executables,
@@ -63,7 +72,10 @@ GpuExecutable::GpuExecutable(
       cubin_(cubin),
       compute_capability_(compute_capability),
       thunk_schedule_(std::move(thunk_schedule)),
-      assignment_(std::move(assignment)) {
+      assignment_(std::move(assignment)),
+      use_cuda_graphs_(
+          module().config().debug_options().xla_gpu_enable_cuda_graphs() &&
+          CanUseCudaGraphs()) {
   CHECK(has_module() && assignment_);
   GpuDebugInfoManager::Get()->RegisterModule(module().name(), shared_module(),
                                              assignment_);
@@ -74,6 +86,14 @@ GpuExecutable::~GpuExecutable() {
   CHECK(has_module() && assignment_);
   GpuDebugInfoManager::Get()->UnregisterModule(module().name(), shared_module(),
                                                assignment_);
+#if CUDART_VERSION >= 10010
+  tensorflow::mutex_lock lock(cuda_graph_mutex_);
+  for (auto& key_and_graph : cuda_graphs_) {
+    se::cuda::ScopedActivateExecutorContext activation(
+        key_and_graph.first.first);
+    cudaGraphExecDestroy(key_and_graph.second);
+  }
+#endif
 }
 
 void GpuExecutable::ComputeThunkAnnotations() {
@@ -89,6 +109,113 @@ void GpuExecutable::ComputeThunkAnnotations() {
   }
 }
 
+bool GpuExecutable::CanUseCudaGraphs() const {
+  if (thunk_schedule_->StreamCount() != 1) {
+    return false;
+  }
+  for (const Thunk* thunk : thunk_schedule_->TotalOrder()) {
+    switch (thunk->kind()) {
+      case Thunk::kKernel:
+      case Thunk::kMemset32BitValue:
+      case Thunk::kMemzero:
+        break;
+      case Thunk::kCopy:
+        // Copies from host memory can not be captured.
+        if (dynamic_cast<const DeviceToDeviceCopyThunk*>(thunk) == nullptr) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+StatusOr<bool> GpuExecutable::LaunchCudaGraph(
+    const ServiceExecutableRunOptions* run_options,
+    const BufferAllocations& buffer_allocations,
+    HloExecutionProfiler* profiler) {
+#if CUDART_VERSION >= 10010
+  se::Stream* main_stream = run_options->stream();
+  se::StreamExecutor* executor = main_stream->parent();
+  cudaStream_t cuda_stream = se::gpu::AsGpuStreamValue(main_stream);
+
+  CudaGraphKey key;
+  key.first = executor;
+  key.second.reserve(assignment_->Allocations().size());
+  for (const BufferAllocation& allocation : assignment_->Allocations()) {
+    key.second.push_back(
+        buffer_allocations.GetDeviceAddress(allocation.index()).opaque());
+  }
+
+  tensorflow::mutex_lock lock(cuda_graph_mutex_);
+  if (cuda_graphs_failed_) {
+    return false;
+  }
+  se::cuda::ScopedActivateExecutorContext activation(executor);
+  auto it = cuda_graphs_.find(key);
+  if (it == cuda_graphs_.end()) {
+    if (cuda_graphs_.size() >= kMaxCudaGraphsPerExecutable) {
+      return false;
+    }
+
+    // Capturing only records the launches of the thunks into the graph, it
+    // does not run them.
+    VLOG(2) << "Capturing a CUDA graph of " << module().name();
+    cudaError_t error =
+        cudaStreamBeginCapture(cuda_stream, cudaStreamCaptureModeThreadLocal);
+    if (error != cudaSuccess) {
+      LOG(WARNING) << "Failed to start capturing a CUDA graph of "
+                   << module().name() << ": " << cudaGetErrorString(error)
+                   << "; launching its thunks one by one instead.";
+      cuda_graphs_failed_ = true;
+      return false;
+    }
+    Status execute_status;
+    for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+      Thunk::ExecuteParams thunk_params{
+          &buffer_allocations, main_stream,
+          run_options->run_options().run_id(), profiler,
+          run_options->run_options().device_assignment()};
+      execute_status = thunk->ExecuteOnStream(thunk_params);
+      if (!execute_status.ok()) {
+        break;
+      }
+    }
+    cudaGraph_t graph = nullptr;
+    error = cudaStreamEndCapture(cuda_stream, &graph);
+    TF_RETURN_IF_ERROR(execute_status);
+
+    cudaGraphExec_t graph_exec = nullptr;
+    if (error == cudaSuccess) {
+      error = cudaGraphInstantiate(&graph_exec, graph, /*pErrorNode=*/nullptr,
+                                   /*pLogBuffer=*/nullptr, /*bufferSize=*/0);
+    }
+    if (graph != nullptr) {
+      cudaGraphDestroy(graph);
+    }
+    if (error != cudaSuccess) {
+      LOG(WARNING) << "Failed to capture a CUDA graph of " << module().name()
+                   << ": " << cudaGetErrorString(error)
+                   << "; launching its thunks one by one instead.";
+      cuda_graphs_failed_ = true;
+      return false;
+    }
+    it = cuda_graphs_.emplace(std::move(key), graph_exec).first;
+  }
+
+  cudaError_t error = cudaGraphLaunch(it->second, cuda_stream);
+  if (error != cudaSuccess) {
+    return InternalError("Failed to launch the CUDA graph of %s: %s",
+                         module().name(), cudaGetErrorString(error));
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 Status GpuExecutable::ExecuteThunks(
     const ServiceExecutableRunOptions* run_options,
     const BufferAllocations& buffer_allocations, bool block_host_until_done,
@@ -132,40 +259,54 @@ Status GpuExecutable::ExecuteThunks(
       [&] { return absl::StrCat(hlo_module_->name(), ":XLA GPU module"); },
       tensorflow::profiler::TraceMeLevel::kInfo);
 
-  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
-  bool scoped_annotation_enabled = ScopedAnnotation::IsEnabled();
-  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
-    // Annotate execution of this op if tracing was enabled when we started
-    // running this module.  If tracing is enabled *while* we're running the
-    // module, we won't get any data, but that's probably an OK trade-off.
-    absl::optional<ScopedAnnotation> op_annotation;
-    CHECK(thunk->hlo_instruction());
-    if (scoped_annotation_enabled) {
-      op_annotation.emplace(FindOrDie(thunk_annotations_, thunk));
+  // Replaying a CUDA graph launches all the thunks at once, so they are
+  // neither annotated nor profiled one by one.
+  bool launched_cuda_graph = false;
+  if (use_cuda_graphs_ && !do_profile) {
+    for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+      TF_RETURN_IF_ERROR(thunk->Initialize(*this, executor));
     }
+    TF_ASSIGN_OR_RETURN(
+        launched_cuda_graph,
+        LaunchCudaGraph(run_options, buffer_allocations, &profiler));
+  }
+
+  if (!launched_cuda_graph) {
+    std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
+    bool scoped_annotation_enabled = ScopedAnnotation::IsEnabled();
+    for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+      // Annotate execution of this op if tracing was enabled when we started
+      // running this module.  If tracing is enabled *while* we're running the
+      // module, we won't get any data, but that's probably an OK trade-off.
+      absl::optional<ScopedAnnotation> op_annotation;
+      CHECK(thunk->hlo_instruction());
+      if (scoped_annotation_enabled) {
+        op_annotation.emplace(FindOrDie(thunk_annotations_, thunk));
+      }
 
-    TF_RETURN_IF_ERROR(thunk->Initialize(*this, executor));
-    int32 stream_no =
-        thunk_schedule_->StreamNumberForHlo(*thunk->hlo_instruction());
-    se::Stream* stream =
-        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
+      TF_RETURN_IF_ERROR(thunk->Initialize(*this, executor));
+      int32 stream_no =
+          thunk_schedule_->StreamNumberForHlo(*thunk->hlo_instruction());
+      se::Stream* stream =
+          (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
 
-    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
-      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
-    }
+      for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
+        stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
+      }
 
-    VLOG(2) << "Executing the thunk for "
-            << thunk->hlo_instruction()->ToString() << " on stream "
-            << stream_no;
-    Thunk::ExecuteParams thunk_params{
-        &buffer_allocations, stream, run_options->run_options().run_id(),
-        &profiler, run_options->run_options().device_assignment()};
-    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
-    if (thunk_schedule_->Depended(thunk)) {
-      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
-      finish_event->Init();
-      stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk] = std::move(finish_event);
+      VLOG(2) << "Executing the thunk for "
+              << thunk->hlo_instruction()->ToString() << " on stream "
+              << stream_no;
+      Thunk::ExecuteParams thunk_params{
+          &buffer_allocations, stream, run_options->run_options().run_id(),
+          &profiler, run_options->run_options().device_assignment()};
+      TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
+      if (thunk_schedule_->Depended(thunk)) {
+        auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
+        finish_event->Init();
+        stream->ThenRecordEvent(finish_event.get());
+        thunk_to_finish_event[thunk] = std::move(finish_event);
+      }
     }
   }
 
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
@@ -39,9 +42,13 @@ limitations under the License.
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/stream_executor/device_memory_allocator.h"
 
+struct CUgraphExec_st;
+
 namespace xla {
 namespace gpu {
 
+class HloExecutionProfiler;
+
 // GPU-targeting implementation of the XLA Executable interface.
 //
 // Launches the given CUDA kernel via the StreamExecutor.
@@ -109,6 +116,19 @@ class GpuExecutable : public Executable {
                        bool block_host_until_done,
                        HloExecutionProfile* hlo_execution_profile);
 
+  // Returns whether every thunk of this executable runs on the main stream and
+  // can be captured into a CUDA graph, i.e. does not synchronize with the host
+  // or choose what to launch next based on device data.
+  bool CanUseCudaGraphs() const;
+
+  // Launches the thunks on the main stream of `run_options` as a single CUDA
+  // graph, capturing the graph if this is the first run with the addresses of
+  // `buffer_allocations`. Returns false, having launched nothing, if the thunks
+  // have to be launched one by one instead. The thunks must be initialized.
+  StatusOr<bool> LaunchCudaGraph(const ServiceExecutableRunOptions* run_options,
+                                 const BufferAllocations& buffer_allocations,
+                                 HloExecutionProfiler* profiler);
+
   // Returns the points-to set of the root instruction of the entry
   // computation. Uses points-to analysis from buffer assignment.
   const PointsToSet& GetRootPointsToSet() const;
@@ -165,6 +185,22 @@ class GpuExecutable : public Executable {
   std::map<stream_executor::StreamExecutor*, BufferAllocToDeviceMemoryMap>
       module_globals_ GUARDED_BY(module_handle_mutex_);
 
+  // Whether the thunks are replayed as CUDA graphs, see
+  // DebugOptions::xla_gpu_enable_cuda_graphs.
+  const bool use_cuda_graphs_;
+
+  // Instantiated CUDA graphs of the thunks, keyed by the executor they were
+  // captured on and the addresses of the buffer allocations they were captured
+  // with, which are baked into the kernel parameters of the graph.
+  using CudaGraphKey =
+      std::pair<stream_executor::StreamExecutor*, std::vector<const void*>>;
+  tensorflow::mutex cuda_graph_mutex_;
+  std::map<CudaGraphKey, CUgraphExec_st*> cuda_graphs_
+      GUARDED_BY(cuda_graph_mutex_);
+  // Set when capturing a graph failed, after which the thunks are always
+  // launched one by one.
+  bool cuda_graphs_failed_ GUARDED_BY(cuda_graph_mutex_) = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuExecutable);
 };
 
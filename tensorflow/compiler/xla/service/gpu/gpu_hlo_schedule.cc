@@ -14,11 +14,15 @@ limitations under the License.
 ==============================================================================*/
 
 #include <deque>
+#include <functional>
 #include <memory>
+#include <queue>
 #include <unordered_map>
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
@@ -184,6 +188,102 @@ void BFSLaunchOrder(const HloComputation* computation,
   }
 }
 
+// Reorders `launch_order` so that the instructions on the collective stream are
+// launched as soon as their operands are, and the instructions which depend on
+// their results as late as possible, i.e. only once nothing else can be
+// launched. Computation which does not depend on a collective thus overlaps
+// with it. Otherwise the relative order of `launch_order` is preserved.
+std::vector<HloInstruction*> HideCollectiveLatency(
+    const std::vector<HloInstruction*>& launch_order,
+    const StreamAssignment& stream_assignment) {
+  auto is_collective = [&stream_assignment](const HloInstruction* hlo) {
+    return stream_assignment.HasStreamAssigned(*hlo) &&
+           stream_assignment.StreamNumberForHlo(*hlo) ==
+               stream_assignment.CollectiveStreamNumber();
+  };
+  auto predecessors_of = [](const HloInstruction* hlo) {
+    absl::flat_hash_set<const HloInstruction*> predecessors(
+        hlo->operands().begin(), hlo->operands().end());
+    predecessors.insert(hlo->control_predecessors().begin(),
+                        hlo->control_predecessors().end());
+    return predecessors;
+  };
+
+  // `launch_order` is topological, so one pass finds all the instructions
+  // which transitively depend on a collective, and the number of distinct
+  // predecessors of each instruction.
+  absl::flat_hash_map<const HloInstruction*, int64> position;
+  absl::flat_hash_map<const HloInstruction*, int64> pending_predecessors;
+  absl::flat_hash_set<const HloInstruction*> waits_for_collective;
+  for (int64 i = 0; i < launch_order.size(); ++i) {
+    const HloInstruction* hlo = launch_order[i];
+    position[hlo] = i;
+    const auto predecessors = predecessors_of(hlo);
+    pending_predecessors[hlo] = predecessors.size();
+    if (is_collective(hlo)) {
+      continue;
+    }
+    for (const HloInstruction* predecessor : predecessors) {
+      if (is_collective(predecessor) ||
+          waits_for_collective.contains(predecessor)) {
+        waits_for_collective.insert(hlo);
+        break;
+      }
+    }
+  }
+
+  // Ready instructions, by position in `launch_order`, in decreasing priority.
+  // Collectives are launched eagerly, along with the parameters and constants,
+  // which launch nothing but may be all a collective waits for.
+  using ReadyQueue =
+      std::priority_queue<int64, std::vector<int64>, std::greater<int64>>;
+  ReadyQueue ready_eager;
+  ReadyQueue ready_independent;
+  ReadyQueue ready_dependent;
+  auto make_ready = [&](const HloInstruction* hlo) {
+    const int64 i = position.at(hlo);
+    if (is_collective(hlo) || !stream_assignment.HasStreamAssigned(*hlo)) {
+      ready_eager.push(i);
+    } else if (waits_for_collective.contains(hlo)) {
+      ready_dependent.push(i);
+    } else {
+      ready_independent.push(i);
+    }
+  };
+  for (const HloInstruction* hlo : launch_order) {
+    if (pending_predecessors.at(hlo) == 0) {
+      make_ready(hlo);
+    }
+  }
+
+  std::vector<HloInstruction*> reordered;
+  reordered.reserve(launch_order.size());
+  while (reordered.size() < launch_order.size()) {
+    ReadyQueue* queue = &ready_dependent;
+    if (!ready_eager.empty()) {
+      queue = &ready_eager;
+    } else if (!ready_independent.empty()) {
+      queue = &ready_independent;
+    }
+    CHECK(!queue->empty());
+    HloInstruction* hlo = launch_order[queue->top()];
+    queue->pop();
+    reordered.push_back(hlo);
+
+    absl::flat_hash_set<const HloInstruction*> successors(
+        hlo->users().begin(), hlo->users().end());
+    successors.insert(hlo->control_successors().begin(),
+                      hlo->control_successors().end());
+    for (const HloInstruction* successor : successors) {
+      auto it = pending_predecessors.find(successor);
+      if (it != pending_predecessors.end() && --it->second == 0) {
+        make_ready(successor);
+      }
+    }
+  }
+  return reordered;
+}
+
 }  // end namespace
 
 GpuHloSchedule::GpuHloSchedule() {}
@@ -196,7 +296,17 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
 
   // Initialize thunk_launch_order_, the total order of thunk launches.
   HloComputation* entry_computation = module.entry_computation();
-  if (stream_assignment.StreamCount() == 1) {
+  // Collectives may run on a stream of their own, apart from the computation.
+  const bool has_collective_stream =
+      stream_assignment.CollectiveStreamNumber() >= 0;
+  const int compute_stream_count =
+      stream_assignment.StreamCount() - (has_collective_stream ? 1 : 0);
+  if (compute_stream_count == 1 && module.has_schedule()) {
+    // Follow the schedule already computed for the module, e.g. by
+    // rematerialization, which relies on it to bound memory usage.
+    schedule->thunk_launch_order_ =
+        module.schedule().sequence(entry_computation).instructions();
+  } else if (compute_stream_count == 1) {
     // All kernels are launched on a single stream, so there's no loss of
     // concurrency by optimizing for minimal memory usage.
     TF_ASSIGN_OR_RETURN(
@@ -210,6 +320,10 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
     // BFS tends to increase concurrency, but also increases memory usage.
     BFSLaunchOrder(entry_computation, &schedule->thunk_launch_order_);
   }
+  if (has_collective_stream) {
+    schedule->thunk_launch_order_ =
+        HideCollectiveLatency(schedule->thunk_launch_order_, stream_assignment);
+  }
 
   schedule->hlo_ordering_ = absl::make_unique<GpuHloOrdering>(
       &module, stream_assignment, schedule->thunk_launch_order_);
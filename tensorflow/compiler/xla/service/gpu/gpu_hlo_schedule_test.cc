@@ -401,5 +401,64 @@ TEST_F(GpuHloScheduleTest, LatticeMatMul) {
   }
 }
 
+// Test that an all-reduce on the collective stream is launched before the
+// computation which does not depend on it, and its users after.
+TEST_F(GpuHloScheduleTest, AsyncAllReduce) {
+  const Shape f32_scalar = ShapeUtil::MakeShape(F32, {});
+  HloComputation::Builder sum_builder("sum");
+  HloInstruction* lhs = sum_builder.AddInstruction(
+      HloInstruction::CreateParameter(0, f32_scalar, "lhs"));
+  HloInstruction* rhs = sum_builder.AddInstruction(
+      HloInstruction::CreateParameter(1, f32_scalar, "rhs"));
+  sum_builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_scalar, HloOpcode::kAdd, lhs, rhs));
+
+  HloModuleConfig config;
+  auto debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_gpu_disable_multi_streaming(true);
+  debug_options.set_xla_gpu_enable_async_all_reduce(true);
+  config.set_debug_options(debug_options);
+  auto module = absl::make_unique<HloModule>("test_module", config);
+  HloComputation* sum = module->AddEmbeddedComputation(sum_builder.Build());
+
+  HloComputation::Builder builder("entry_computation");
+  HloInstruction* x = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/0, f32_2x2_, /*name=*/"x"));
+  HloInstruction* y = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/1, f32_2x2_, /*name=*/"y"));
+  HloInstruction* add1 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kAdd, y, y));
+  HloInstruction* add2 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kAdd, add1, y));
+  HloInstruction* all_reduce =
+      builder.AddInstruction(HloInstruction::CreateAllReduce(
+          f32_2x2_, {x}, sum, /*replica_groups=*/{},
+          /*channel_id=*/absl::nullopt));
+  HloInstruction* add3 = builder.AddInstruction(HloInstruction::CreateBinary(
+      f32_2x2_, HloOpcode::kAdd, all_reduce, add2));
+  module->AddEntryComputation(builder.Build(add3));
+
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  EXPECT_EQ(streams->StreamCount(), 2);
+  EXPECT_EQ(streams->StreamNumberForHlo(*all_reduce),
+            streams->CollectiveStreamNumber());
+  EXPECT_NE(streams->StreamNumberForHlo(*add1),
+            streams->CollectiveStreamNumber());
+  EXPECT_EQ(streams->StreamNumberForHlo(*add1),
+            streams->StreamNumberForHlo(*add3));
+
+  auto schedule = BuildGpuHloSchedule(*module, *streams);
+  // Remove parameters, which are unordered.
+  EXPECT_EQ(RemoveHlo(schedule->ThunkLaunchOrder(), {x, y}),
+            HloVec({all_reduce, add1, add2, add3}));
+
+  // The all-reduce runs concurrently with the computation it does not feed.
+  auto order = schedule->ConsumeHloOrdering();
+  EXPECT_TRUE(order->ExecutesBefore(all_reduce, add3));
+  EXPECT_TRUE(order->ExecutesBefore(add2, add3));
+  EXPECT_FALSE(order->ExecutesBefore(all_reduce, add1));
+  EXPECT_FALSE(order->ExecutesBefore(add1, all_reduce));
+}
+
 }  // namespace gpu
 }  // namespace xla
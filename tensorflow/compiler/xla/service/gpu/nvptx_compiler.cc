@@ -42,6 +42,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/dump.h"
 #include "tensorflow/compiler/xla/service/dynamic_index_splitter.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
+#include "tensorflow/compiler/xla/service/gpu/cubin_cache.h"
 #include "tensorflow/compiler/xla/service/gpu/cudnn_batchnorm_rewriter.h"
 #include "tensorflow/compiler/xla/service/gpu/cudnn_conv_algorithm_picker.h"
 #include "tensorflow/compiler/xla/service/gpu/cudnn_conv_pad_for_tensor_cores.h"
@@ -81,11 +82,14 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_element_type_converter.h"
 #include "tensorflow/compiler/xla/service/hlo_get_dimension_size_rewriter.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
+#include "tensorflow/compiler/xla/service/hlo_rematerialization.h"
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
+#include "tensorflow/compiler/xla/service/host_constant_evaluator.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/mem_wasted_on_passthrough_params.h"
 #include "tensorflow/compiler/xla/service/reduce_precision_insertion.h"
@@ -241,7 +245,11 @@ Status OptimizeHloModule(HloModule* hlo_module, se::StreamExecutor* stream_exec,
 
       pass.AddPass<HloDCE>();
       pass.AddPass<ReshapeMover>();
-      pass.AddPass<HloConstantFolding>();
+      pass.AddPass<HloConstantFolding>(
+          hlo_module->config()
+              .debug_options()
+              .xla_constant_folding_on_host_min_elements(),
+          EvaluateConstantOnHost);
       pass.AddPass<ConditionalSimplifier>();
     }
 
@@ -453,6 +461,33 @@ Status PrepareHloModuleForIrEmitting(HloModule* hlo_module) {
   return pipeline.Run(hlo_module).status();
 }
 
+// Rematerializes instructions to keep the peak memory use of the module below
+// --xla_gpu_rematerialization_memory_limit_bytes, if it is set. The module is
+// left with the schedule used to account for memory, which GpuHloSchedule
+// then follows. Runs after copy insertion, immediately before IR emission.
+Status RematerializeHloModule(HloModule* hlo_module, int64 pointer_size) {
+  const int64 memory_limit_bytes =
+      hlo_module->config()
+          .debug_options()
+          .xla_gpu_rematerialization_memory_limit_bytes();
+  if (memory_limit_bytes <= 0) {
+    return Status::OK();
+  }
+  auto size_function = [pointer_size](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, pointer_size);
+  };
+  HloPassPipeline pipeline("rematerialization");
+  pipeline.AddPass<HloMemoryScheduler>(
+      [size_function](const BufferValue& buffer) {
+        return size_function(buffer.shape());
+      },
+      DefaultMemoryScheduler);
+  pipeline.AddPass<HloRematerialization>(
+      size_function, memory_limit_bytes, /*sizes=*/nullptr,
+      HloRematerialization::CostMode::kCompute);
+  return pipeline.Run(hlo_module).status();
+}
+
 // Prints a warning if the ptx->sass JIT in the driver has known bugs.
 //
 // Using such a driver only a problem if we fail to use ptxas to compile our ptx
@@ -513,6 +548,8 @@ StatusOr<std::unique_ptr<HloModule>> NVPTXCompiler::RunHloPasses(
 
   TF_RETURN_IF_ERROR(PrepareHloModuleForIrEmitting(module.get()));
 
+  TF_RETURN_IF_ERROR(RematerializeHloModule(module.get(), pointer_size_));
+
   return std::move(module);
 }
 
@@ -713,14 +750,40 @@ std::vector<uint8> NVPTXCompiler::CompilePtxOrGetCachedResult(
     tensorflow::mutex_lock lock(cache_value->mutex_);
     if (inserted) {
       CHECK(!cache_value->compilation_done);
-      if (!ptx.empty()) {
+      const se::cuda::PtxCompilationOptions ptx_options =
+          PtxOptsFromConfig(hlo_module_config);
+      const DebugOptions& debug_options = hlo_module_config.debug_options();
+      const string& persistent_cache_dir =
+          debug_options.xla_gpu_persistent_cubin_cache_dir();
+      // Cubins are only shared with processes using the same ptxas.
+      string persistent_cache_key;
+      if (!ptx.empty() && !persistent_cache_dir.empty()) {
+        auto ptxas_version = se::cuda::GetPtxasVersion(ptx_options);
+        if (ptxas_version.ok()) {
+          persistent_cache_key = PersistentCubinCacheKey(
+              ptx, cc_major, cc_minor, ptx_options.disable_ptxas_optimizations,
+              ptxas_version.ValueOrDie());
+        } else {
+          VLOG(1) << "Not using the persistent cubin cache: "
+                  << ptxas_version.status();
+        }
+      }
+      if (!persistent_cache_key.empty() &&
+          LoadPersistentCubin(persistent_cache_dir, persistent_cache_key,
+                              &cache_value->cubin_data)) {
+        VLOG(2) << "Loaded CUBIN size: " << cache_value->cubin_data.size()
+                << " from " << persistent_cache_dir;
+      } else if (!ptx.empty()) {
         StatusOr<std::vector<uint8>> maybe_cubin = se::cuda::CompilePtx(
-            stream_exec->device_ordinal(), cache_ptx->c_str(),
-            PtxOptsFromConfig(hlo_module_config));
+            stream_exec->device_ordinal(), cache_ptx->c_str(), ptx_options);
         if (maybe_cubin.ok()) {
           cache_value->cubin_data = std::move(maybe_cubin).ValueOrDie();
           VLOG(2) << "Compiled PTX size:" << ptx.size()
                   << " CUBIN size: " << cache_value->cubin_data.size();
+          if (!persistent_cache_key.empty()) {
+            StorePersistentCubin(persistent_cache_dir, persistent_cache_key,
+                                 cache_value->cubin_data);
+          }
         } else {
           bool log_warning = true;
           if (maybe_cubin.status().code() ==
@@ -107,6 +107,10 @@ class NVPTXCompiler : public LLVMCompiler {
   //
   // If compiling the ptx fails, we return an empty cubin, cross our fingers,
   // and leave compilation up to the driver.
+  //
+  // If xla_gpu_persistent_cubin_cache_dir is set, entries missing from this
+  // map are first looked up in that directory, and compiled cubins are written
+  // to it.
   struct CompilationCacheKey {
     CompilationCacheKey(std::string ptx, int cc_major, int cc_minor)
         : ptx(std::move(ptx)), cc_major(cc_major), cc_minor(cc_minor) {}
@@ -61,7 +61,8 @@ inline bool IsStreamNumValid(int stream_num) {
 // Returns which existing stream to assign to `hlo`, or -1 if a stream is not
 // needed. `stream_assignment` is the existing stream assignment for all
 // instructions topologically before `hlo`. `seen_gemms` contains all GEMMs that
-// are topologically before `hlo`.
+// are topologically before `hlo`. The collective stream, if any, is never
+// assigned to computation.
 int ComputeStreamToAssign(
     const HloInstruction& hlo, const StreamAssignment& stream_assignment,
     const HloReachabilityMap& reachability,
@@ -79,12 +80,15 @@ int ComputeStreamToAssign(
     return 0;
   }
 
+  const int collective_stream_num = stream_assignment.CollectiveStreamNumber();
   if (!(IsCublasGemm(hlo) || IsMatrixMultiplication(hlo))) {
     // If `hlo` is not implemented as a GEMM, keep it close to its operands to
     // avoid excessive synchronization.
     int stream_num = -1;
     for (const auto* operand : hlo.operands()) {
-      if (stream_assignment.HasStreamAssigned(*operand)) {
+      if (stream_assignment.HasStreamAssigned(*operand) &&
+          stream_assignment.StreamNumberForHlo(*operand) !=
+              collective_stream_num) {
         stream_num = std::max(stream_num,
                               stream_assignment.StreamNumberForHlo(*operand));
       }
@@ -100,6 +104,9 @@ int ComputeStreamToAssign(
   // streams assigned to GEMMs that are concurrent with `hlo`. Then, we assign
   // `hlo` a different stream.
   absl::flat_hash_set<int> forbidden_stream_numbers;
+  if (IsStreamNumValid(collective_stream_num)) {
+    forbidden_stream_numbers.insert(collective_stream_num);
+  }
   for (const auto* seen_gemm : seen_gemms) {
     int stream_num = stream_assignment.StreamNumberForHlo(*seen_gemm);
     if (!forbidden_stream_numbers.contains(stream_num) &&
@@ -132,7 +139,20 @@ std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
   // TODO(b/111791052): If we remove such a common variable, we will need to
   // clean up the code here.
   int stream_num_for_rng = kInvalidStreamNum;
+  // All-reduces optionally run in order on a stream of their own, reserved when
+  // the first one is assigned, so that they overlap with computation.
+  const bool use_collective_stream =
+      module.config().debug_options().xla_gpu_enable_async_all_reduce();
   for (const auto* hlo : computation.MakeInstructionPostOrder()) {
+    if (use_collective_stream && hlo->opcode() == HloOpcode::kAllReduce) {
+      if (!IsStreamNumValid(stream_assignment->CollectiveStreamNumber())) {
+        stream_assignment->SetCollectiveStreamNumber(
+            stream_assignment->StreamCount());
+      }
+      stream_assignment->AssignStreamToHlo(
+          hlo, stream_assignment->CollectiveStreamNumber());
+      continue;
+    }
     // If we ever enable fusion of RNG instructions, we will need to extend this
     // code to look inside a fused instruction.
     int stream_num = (hlo->opcode() == HloOpcode::kRng &&
@@ -32,8 +32,16 @@ class StreamAssignment {
   // `hlo` needs to outlive this StreamAssignment object.
   void AssignStreamToHlo(const HloInstruction* hlo, int stream_no);
 
+  // Returns the stream reserved for collectives, so that they overlap with
+  // computation, or -1 if collectives run on the same streams as computation.
+  int CollectiveStreamNumber() const { return collective_stream_number_; }
+  void SetCollectiveStreamNumber(int stream_no) {
+    collective_stream_number_ = stream_no;
+  }
+
  private:
   int stream_count_ = 1;  // At least the main stream.
+  int collective_stream_number_ = -1;
   absl::flat_hash_map<const HloInstruction*, int> hlo_to_stream_number_;
 };
 
@@ -63,6 +63,24 @@ static bool IsOrContainsIllegalInstr(const HloInstruction* instr) {
   return false;
 }
 
+// Returns the number of elements of the arrays read and written by instr.
+static int64 ElementsInResultAndOperands(const HloInstruction& instr) {
+  int64 elements = 0;
+  auto add_elements = [&elements](const Shape& shape) {
+    ShapeUtil::ForEachSubshape(
+        shape, [&elements](const Shape& subshape, const ShapeIndex& index) {
+          if (subshape.IsArray()) {
+            elements += ShapeUtil::ElementsIn(subshape);
+          }
+        });
+  };
+  add_elements(instr.shape());
+  for (const HloInstruction* operand : instr.operands()) {
+    add_elements(operand->shape());
+  }
+  return elements;
+}
+
 StatusOr<bool> HloConstantFolding::Run(HloModule* module) {
   // Limit the constant folding to 0 iterations to skip folding loops. This
   // retains the behavior from before while loop support in HloEvaluator and may
@@ -138,9 +156,17 @@ StatusOr<bool> HloConstantFolding::Run(HloModule* module) {
       }
 
       Literal result;
+      bool evaluated = false;
+      if (large_constant_evaluator_ && large_constant_min_elements_ > 0 &&
+          ElementsInResultAndOperands(*instruction) >=
+              large_constant_min_elements_) {
+        evaluated = large_constant_evaluator_(*instruction, &result);
+        VLOG(3) << "Evaluated large constant " << instruction->name() << ": "
+                << evaluated;
+      }
       // Currently we skip unimplemented operations.
       // TODO(b/35975797): Fold constant computations for more operations.
-      if (!evaluator->TryEvaluate(instruction, &result)) {
+      if (!evaluated && !evaluator->TryEvaluate(instruction, &result)) {
         VLOG(2) << "Constant folding failed for instruction: "
                 << instruction->ToString();
         continue;
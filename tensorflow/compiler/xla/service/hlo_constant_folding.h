@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_HLO_CONSTANT_FOLDING_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_HLO_CONSTANT_FOLDING_H_
 
+#include <functional>
+
+#include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 
@@ -25,11 +28,33 @@ namespace xla {
 // computation on constants.
 class HloConstantFolding : public HloModulePass {
  public:
+  // Evaluates an instruction whose operands are all constants into the given
+  // literal. Returns false if the instruction could not be evaluated.
+  using ConstantEvaluator =
+      std::function<bool(const HloInstruction&, Literal*)>;
+
+  HloConstantFolding() = default;
+
+  // Instructions whose result and operands have at least
+  // `large_constant_min_elements` elements in total are evaluated by
+  // `large_constant_evaluator`, e.g. by compiling them, rather than by the
+  // HloEvaluator, which interprets every element and is slow on large
+  // constants. HloEvaluator is still used if `large_constant_evaluator` fails.
+  // A non-positive `large_constant_min_elements` disables this.
+  HloConstantFolding(int64 large_constant_min_elements,
+                     ConstantEvaluator large_constant_evaluator)
+      : large_constant_min_elements_(large_constant_min_elements),
+        large_constant_evaluator_(std::move(large_constant_evaluator)) {}
+
   absl::string_view name() const override { return "constant_folding"; }
 
   // Run constant folding operations on the given module. Returns whether the
   // module was changed (constant expressions folded).
   StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  int64 large_constant_min_elements_ = 0;
+  ConstantEvaluator large_constant_evaluator_;
 };
 
 }  // namespace xla
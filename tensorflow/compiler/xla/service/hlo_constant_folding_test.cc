@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
 
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal.h"
@@ -268,6 +270,44 @@ TEST_F(HloConstantFoldingTest, DoesNotFoldLargePad) {
               GmockMatch(m::Pad(m::Constant(), m::Constant())));
 }
 
+TEST_F(HloConstantFoldingTest, LargeConstantsUseLargeConstantEvaluator) {
+  const char* const kModuleStr = R"(
+  HloModule test
+
+  ENTRY entry {
+    small = f32[4] constant({1, 2, 3, 4})
+    small_negate = f32[4] negate(small)
+    large = f32[8,8] broadcast(small_negate), dimensions={1}
+    large_constant = f32[2,4] constant({{1, 2, 3, 4}, {5, 6, 7, 8}})
+    large_add = f32[2,4] add(large_constant, large_constant)
+    ROOT tuple = (f32[8,8], f32[2,4]) tuple(large, large_add)
+  })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kModuleStr));
+
+  std::vector<string> evaluated;
+  HloConstantFolding const_folder(
+      /*large_constant_min_elements=*/24,
+      [&evaluated](const HloInstruction& instruction, Literal* result) {
+        evaluated.push_back(instruction.name());
+        *result = Literal(instruction.shape());
+        result->PopulateWithValue<float>(5);
+        return true;
+      });
+  TF_ASSERT_OK_AND_ASSIGN(bool result, const_folder.Run(module.get()));
+  EXPECT_TRUE(result);
+
+  // Only the addition is large enough for the large constant evaluator. The
+  // negation is folded by HloEvaluator, and the broadcast is not folded.
+  EXPECT_THAT(evaluated, ::testing::ElementsAre("large_add"));
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, GmockMatch(m::Tuple(m::Broadcast(m::Constant()),
+                                        m::Constant())));
+  EXPECT_EQ(root->operand(0)->operand(0)->literal(),
+            LiteralUtil::CreateR1<float>({-1, -2, -3, -4}));
+  EXPECT_EQ(root->operand(1)->literal().GetFirstElement<float>(), 5);
+}
+
 TEST_F(HloConstantFoldingTest, DontFoldSubcomputationContainingAfterAll) {
   const char* const kModuleStr = R"(
   HloModule test
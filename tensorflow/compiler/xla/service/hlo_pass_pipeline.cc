@@ -21,12 +21,14 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/service/dump.h"
 #include "tensorflow/compiler/xla/service/hlo_graph_dumper.h"
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -63,10 +65,13 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
     MaybeDumpHlo(*hlo,
                  /*after_pass_name=*/last_pass_name,
                  /*before_pass_name=*/pass_name);
+    absl::optional<tensorflow::ScopedCompilationPhase> phase;
     if (!pass->IsPassPipeline()) {
       compilation_stats_->StartPass(pass_name);
+      phase.emplace(tensorflow::kCompilationPhaseHloPass, pass_name);
     }
     TF_ASSIGN_OR_RETURN(bool pass_changed, RunHelper(pass, hlo));
+    phase.reset();
     changed |= pass_changed;
     TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, pass_name));
     last_pass_name = string(pass_name);
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/buffer_value.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_dce.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
@@ -894,9 +895,16 @@ bool MemoryUsageTracker::Check() const {
 // The idea is to choose the operation that will save the most memory for
 // rematerialization and do not worry about how much the compute costs since
 // running out of memory is more harmful than taking longer to get the answer.
-int64 RematerializationCost(const HloInstruction* instruction,
-                            const MemoryUsageTracker& memory_tracker,
-                            int64 memory_reduced, int64 memory_limit_bytes) {
+//
+// If 'compute_costs' is non-null, the cost is instead the number of flops
+// needed to recompute the instruction per byte of memory reduced, plus one so
+// that candidates which are free to recompute are still ranked by the memory
+// they reduce.
+double RematerializationCost(
+    const HloInstruction* instruction,
+    const MemoryUsageTracker& memory_tracker, int64 memory_reduced,
+    int64 memory_limit_bytes,
+    const absl::flat_hash_map<const HloInstruction*, int64>* compute_costs) {
   // If none of the users of 'instruction' have been placed in the sequence (as
   // tracked by memory_tracker), then rematerialization of 'instruction' is a
   // zero-cost move of 'instruction' in the sequence.
@@ -908,6 +916,10 @@ int64 RematerializationCost(const HloInstruction* instruction,
   }
 
   CHECK_GT(memory_reduced, 0);
+  if (compute_costs != nullptr) {
+    const int64 flops = FindOrDefault(*compute_costs, instruction, 0);
+    return static_cast<double>(1 + flops) / memory_reduced;
+  }
   // Return the inverse of the benefit of rematerialization.
   return memory_limit_bytes / memory_reduced;
 }
@@ -920,9 +932,10 @@ int64 RematerializationCost(const HloInstruction* instruction,
 Item* PickRematerializationCandidate(
     const MemoryUsageTracker& memory_tracker,
     const InstructionList& instruction_list, int64 memory_limit_bytes,
-    absl::flat_hash_map<const HloInstruction*, bool>* remat_able) {
+    absl::flat_hash_map<const HloInstruction*, bool>* remat_able,
+    const absl::flat_hash_map<const HloInstruction*, int64>* compute_costs) {
   Item* best_item = nullptr;
-  int64 best_cost = 0;
+  double best_cost = 0;
 
   // TODO(b/35244891): This is currently quadratic in the number of HLO
   // instructions.
@@ -972,8 +985,9 @@ Item* PickRematerializationCandidate(
       continue;
     }
 
-    const int cost = RematerializationCost(candidate, memory_tracker,
-                                           memory_reduced, memory_limit_bytes);
+    const double cost =
+        RematerializationCost(candidate, memory_tracker, memory_reduced,
+                              memory_limit_bytes, compute_costs);
 
     VLOG(5) << "candidate " << candidate->name() << ", memory reduced "
             << memory_reduced << ", cost per byte " << cost;
@@ -1087,7 +1101,8 @@ StatusOr<bool> HloRematerialization::RematerializeComputation(
               << ", limit is " << HumanReadableNumBytes(memory_limit_bytes);
 
       Item* best_item = PickRematerializationCandidate(
-          memory_tracker, instruction_list, memory_limit_bytes, &remat_able);
+          memory_tracker, instruction_list, memory_limit_bytes, &remat_able,
+          cost_mode_ == CostMode::kCompute ? &compute_costs_ : nullptr);
 
       if (best_item == nullptr) {
         VLOG(3) << "Unable to find rematerialization candidate at program "
@@ -1108,6 +1123,10 @@ StatusOr<bool> HloRematerialization::RematerializeComputation(
 
       HloInstruction* remat =
           computation->AddInstruction(best->Clone(/*suffix=*/"remat"));
+      if (cost_mode_ == CostMode::kCompute) {
+        const int64 best_compute_cost = FindOrDefault(compute_costs_, best, 0);
+        compute_costs_[remat] = best_compute_cost;
+      }
 
       // Add control dependencies to the new operation.
       for (auto successor : best->control_successors()) {
@@ -1268,10 +1287,23 @@ StatusOr<bool> HloRematerialization::Run(HloModule* module) {
   rematerialized_computations_.clear();
   instructions_rematerialized_ = 0;
   net_instructions_added_ = 0;
+  compute_costs_.clear();
 
   TF_RET_CHECK(module->has_schedule());
   TF_ASSIGN_OR_RETURN(points_to_analysis_, TuplePointsToAnalysis::Run(module));
 
+  if (cost_mode_ == CostMode::kCompute) {
+    for (HloComputation* computation : module->MakeNonfusionComputations()) {
+      HloCostAnalysis cost_analysis(size_function_);
+      TF_RETURN_IF_ERROR(computation->Accept(&cost_analysis));
+      for (const HloInstruction* instruction : computation->instructions()) {
+        compute_costs_[instruction] =
+            cost_analysis.flop_count(*instruction) +
+            cost_analysis.transcendental_count(*instruction);
+      }
+    }
+  }
+
   // Adjust memory limit to account for the output of the entry
   // computation. This is necessary because the per-computation accounting in
   // MemoryUsageTracker do not include output as these are typically allocated
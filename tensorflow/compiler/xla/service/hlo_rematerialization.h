@@ -46,6 +46,18 @@ class HloRematerialization : public HloModulePass {
     int64 after_bytes;
   };
 
+  // How candidates for rematerialization are ranked against each other.
+  enum class CostMode {
+    // Prefer the candidates which reduce memory use the most, regardless of
+    // how expensive they are to recompute.
+    kMemory,
+    // Prefer the candidates which recompute the fewest flops, as estimated by
+    // HloCostAnalysis, per byte of memory use reduced. Fusions are
+    // rematerialized as a whole, so this favors cheap elementwise fusions over
+    // convolutions and dots when training large models.
+    kCompute,
+  };
+
   // Constructor parameters:
   //
   //   size_function: Function which returns the size in bytes of the top-level
@@ -57,11 +69,15 @@ class HloRematerialization : public HloModulePass {
   //   sizes: Pointer to data structure which records the peak memory usage of
   //     the HLO module before/after rematerialization. Value are set during
   //     Run(). Can be nullptr.
+  //
+  //   cost_mode: How candidates for rematerialization are selected.
   HloRematerialization(const ShapeSizeFunction& size_function,
-                       int64 memory_limit_bytes, RematerializationSizes* sizes)
+                       int64 memory_limit_bytes, RematerializationSizes* sizes,
+                       CostMode cost_mode = CostMode::kMemory)
       : size_function_(size_function),
         memory_limit_bytes_(memory_limit_bytes),
-        sizes_(sizes) {}
+        sizes_(sizes),
+        cost_mode_(cost_mode) {}
   ~HloRematerialization() {}
 
   absl::string_view name() const override { return "rematerialization"; }
@@ -109,6 +125,13 @@ class HloRematerialization : public HloModulePass {
   // module before/after rematerialization
   RematerializationSizes* sizes_;
 
+  const CostMode cost_mode_;
+
+  // The number of flops needed to recompute each instruction, including the
+  // rematerializations added by this pass. Only populated in
+  // CostMode::kCompute.
+  absl::flat_hash_map<const HloInstruction*, int64> compute_costs_;
+
   // Call graph of the hlo_module.
   std::unique_ptr<CallGraph> call_graph_;
 
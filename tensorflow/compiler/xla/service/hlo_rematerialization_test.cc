@@ -41,15 +41,17 @@ using ::testing::_;
 // RematerializationTestBase for more.
 class HloRematerializationTest : public RematerializationTestBase {
  protected:
-  StatusOr<bool> RunHloRematerialization(int64 memory_limit_bytes,
-                                         HloModule* module) {
+  StatusOr<bool> RunHloRematerialization(
+      int64 memory_limit_bytes, HloModule* module,
+      HloRematerialization::CostMode cost_mode =
+          HloRematerialization::CostMode::kMemory) {
     TF_EXPECT_OK(verifier().Run(module).status());
     HloMemoryScheduler scheduler(
         [](const BufferValue& buffer) { return ByteSizeOf(buffer.shape()); },
         DefaultMemoryScheduler);
     TF_EXPECT_OK(scheduler.Run(module).status());
     HloRematerialization remat(ByteSizeOf, memory_limit_bytes,
-                               /*sizes=*/nullptr);
+                               /*sizes=*/nullptr, cost_mode);
     return remat.Run(module);
   }
 };
@@ -534,6 +536,89 @@ TEST_P(IndirectUseTest, IndirectUseNotRematerialized) {
 INSTANTIATE_TEST_SUITE_P(IndirectUseTestInstantiation, IndirectUseTest,
                          ::testing::Values(true, false));
 
+class CostModeTest : public HloRematerializationTest,
+                     public ::testing::WithParamInterface<bool> {};
+
+TEST_P(CostModeTest, CheapestCandidateRematerialized) {
+  // Test that the compute cost mode rematerializes the candidate which is the
+  // cheapest to recompute rather than the one which saves the most memory.
+  // Test is parameterized on whether the compute cost mode is used. Module:
+  //
+  // Entry computation:
+  //   F32[] %param = {...}
+  //   F32[2048] %vec = {...}
+  //   F32[1024] %bcast = broadcast(%param)
+  //   F32[2048] %exp = exp(%vec)
+  //   F32[1024] %slice_1 = slice(%exp)
+  //   F32[1024] %add_1 = add(%bcast, %slice_1)
+  //   F32[4096] %concat_1 = concat({%add_1, %add_1, %add_1, %add_1})
+  //   F32[1024] %slice_2 = slice(%concat_1)
+  //   F32[1024] %add_2 = add(%bcast, %slice_2)
+  //   F32[3072] %concat_2 = concat({%exp, %add_2})
+  //   F32[1024] %slice_3 = slice(%concat_2)
+  //
+  // Both %bcast and %exp are live across %concat_1, where memory use peaks,
+  // and rematerializing either is enough to get below the limit. %exp saves
+  // more memory but %bcast is free to recompute.
+  const bool use_compute_cost = GetParam();
+  auto module = CreateNewVerifiedModule();
+
+  const Shape vec2048_shape = ShapeUtil::MakeShape(xla::F32, {2048});
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, scalar_shape_, "param"));
+  auto vec = builder.AddInstruction(
+      HloInstruction::CreateParameter(1, vec2048_shape, "vec"));
+  auto bcast = builder.AddInstruction(
+      HloInstruction::CreateBroadcast(vec1024_shape_, param, {}));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(vec2048_shape, HloOpcode::kExp, vec));
+  auto slice_1 = builder.AddInstruction(HloInstruction::CreateSlice(
+      vec1024_shape_, exp, /*start_indices=*/{0},
+      /*limit_indices=*/{1024}, /*strides=*/{1}));
+  auto add_1 = builder.AddInstruction(HloInstruction::CreateBinary(
+      vec1024_shape_, HloOpcode::kAdd, bcast, slice_1));
+  auto concat_1 = builder.AddInstruction(HloInstruction::CreateConcatenate(
+      ShapeUtil::MakeShape(xla::F32, {4096}), {add_1, add_1, add_1, add_1},
+      /*dimension=*/0));
+  auto slice_2 = builder.AddInstruction(HloInstruction::CreateSlice(
+      vec1024_shape_, concat_1, /*start_indices=*/{0},
+      /*limit_indices=*/{1024}, /*strides=*/{1}));
+  auto add_2 = builder.AddInstruction(HloInstruction::CreateBinary(
+      vec1024_shape_, HloOpcode::kAdd, bcast, slice_2));
+  auto concat_2 = builder.AddInstruction(HloInstruction::CreateConcatenate(
+      ShapeUtil::MakeShape(xla::F32, {3072}), {exp, add_2},
+      /*dimension=*/0));
+  builder.AddInstruction(HloInstruction::CreateSlice(
+      vec1024_shape_, concat_2, /*start_indices=*/{0},
+      /*limit_indices=*/{1024}, /*strides=*/{1}));
+  module->AddEntryComputation(builder.Build());
+
+  // Peak memory is 44KB at %concat_1 including parameters and output.
+  // Rematerializing %bcast reduces it to 40KB and rematerializing %exp to
+  // 36KB, so pick a limit between 42KB and 44KB.
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunHloRematerialization(
+          /*memory_limit_bytes=*/43 * 1024, module.get(),
+          use_compute_cost ? HloRematerialization::CostMode::kCompute
+                           : HloRematerialization::CostMode::kMemory));
+  EXPECT_TRUE(changed);
+
+  if (use_compute_cost) {
+    EXPECT_THAT(add_2, op::Add(op::Broadcast(param), slice_2));
+    EXPECT_NE(add_2->operand(0), bcast);
+    EXPECT_EQ(concat_2->operand(0), exp);
+  } else {
+    EXPECT_THAT(concat_2, op::Concatenate(op::Exp(vec), add_2));
+    EXPECT_NE(concat_2->operand(0), exp);
+    EXPECT_EQ(add_2->operand(0), bcast);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(CostModeTestInstantiation, CostModeTest,
+                         ::testing::Values(true, false));
+
 }  // namespace
 
 }  // namespace xla
@@ -0,0 +1,196 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/host_constant_evaluator.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/service/compiler.h"
+#include "tensorflow/compiler/xla/service/computation_layout.h"
+#include "tensorflow/compiler/xla/service/hlo_clone_context.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/service/transfer_manager.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace xla {
+
+namespace {
+
+// Stop caching results once they take this many bytes.
+constexpr int64 kMaxCachedBytes = int64{256} << 20;
+
+using CacheKey = std::pair<uint64, uint64>;
+
+struct EvaluationCache {
+  tensorflow::mutex mu;
+  absl::flat_hash_map<CacheKey, Literal> results GUARDED_BY(mu);
+  int64 cached_bytes GUARDED_BY(mu) = 0;
+};
+
+EvaluationCache* GetEvaluationCache() {
+  static auto* cache = new EvaluationCache;
+  return cache;
+}
+
+// Returns the runner for the host platform, or nullptr if there is no backend
+// for it. The runner is not thread-safe, so it must be used under the returned
+// mutex.
+HloRunner* GetHostRunner(tensorflow::mutex** mu) {
+  static auto* runner_mu = new tensorflow::mutex;
+  static HloRunner* runner = []() -> HloRunner* {
+    StatusOr<se::Platform*> platform = PlatformUtil::GetPlatform("Host");
+    if (!platform.ok() ||
+        !Compiler::GetForPlatform(platform.ValueOrDie()).ok() ||
+        !TransferManager::GetForPlatform(platform.ValueOrDie()).ok()) {
+      VLOG(1) << "No host backend to evaluate constants with";
+      return nullptr;
+    }
+    return new HloRunner(platform.ValueOrDie());
+  }();
+  *mu = runner_mu;
+  return runner;
+}
+
+// Fingerprints the instruction, including its called computations, and the
+// values of its operands.
+CacheKey FingerprintEvaluation(const HloInstruction& instruction) {
+  string key = instruction.ToString(HloPrintOptions::Canonical());
+  for (const HloInstruction* operand : instruction.operands()) {
+    const Literal& literal = operand->literal();
+    const tensorflow::Fprint128 fingerprint =
+        tensorflow::Fingerprint128(tensorflow::StringPiece(
+            static_cast<const char*>(literal.untyped_data()),
+            literal.size_bytes()));
+    absl::StrAppend(&key, ";",
+                    ShapeUtil::HumanStringWithLayout(literal.shape()), ":",
+                    fingerprint.low64, ":", fingerprint.high64);
+  }
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return {fingerprint.low64, fingerprint.high64};
+}
+
+// Builds a module computing `instruction` from parameters, so that the
+// constant folding of its own compilation leaves it alone.
+std::unique_ptr<HloModule> MakeEvaluationModule(
+    const HloInstruction& instruction) {
+  DebugOptions debug_options =
+      instruction.GetModule()->config().debug_options();
+  debug_options.clear_xla_dump_to();
+  HloModuleConfig config;
+  config.set_debug_options(debug_options);
+  auto module = absl::make_unique<HloModule>(
+      absl::StrCat("constant_", instruction.name()), config);
+
+  HloCloneContext context(module.get());
+  HloComputation::Builder builder(module->name());
+  std::vector<HloInstruction*> parameters;
+  for (int64 i = 0; i < instruction.operand_count(); ++i) {
+    parameters.push_back(builder.AddInstruction(HloInstruction::CreateParameter(
+        i, instruction.operand(i)->shape(), absl::StrCat("operand.", i))));
+  }
+  builder.AddInstruction(instruction.CloneWithNewOperands(
+      instruction.shape(), parameters, &context));
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  // Keep the layouts of the operands and of the result.
+  *module->mutable_entry_computation_layout() = ComputationLayout(
+      computation->ComputeProgramShape(), /*ignore_layouts=*/false);
+  return module;
+}
+
+}  // namespace
+
+bool EvaluateConstantOnHost(const HloInstruction& instruction,
+                            Literal* result) {
+  // Custom calls would be resolved against the targets of the host backend.
+  if (instruction.opcode() == HloOpcode::kCustomCall ||
+      !instruction.shape().IsArray() ||
+      !LayoutUtil::HasLayout(instruction.shape())) {
+    return false;
+  }
+  for (const HloInstruction* operand : instruction.operands()) {
+    if (operand->opcode() != HloOpcode::kConstant ||
+        !operand->shape().IsArray()) {
+      return false;
+    }
+  }
+
+  const CacheKey key = FingerprintEvaluation(instruction);
+  EvaluationCache* cache = GetEvaluationCache();
+  {
+    tensorflow::mutex_lock lock(cache->mu);
+    auto it = cache->results.find(key);
+    if (it != cache->results.end()) {
+      VLOG(2) << "Reusing the evaluation of " << instruction.name();
+      *result = it->second.Clone();
+      return true;
+    }
+  }
+
+  // Compiling the evaluation module runs constant folding again, which must
+  // not come back here while the runner is in use.
+  static thread_local bool evaluating = false;
+  tensorflow::mutex* runner_mu;
+  HloRunner* runner = GetHostRunner(&runner_mu);
+  if (runner == nullptr || evaluating) {
+    return false;
+  }
+  std::vector<const Literal*> arguments;
+  for (const HloInstruction* operand : instruction.operands()) {
+    arguments.push_back(&operand->literal());
+  }
+  StatusOr<Literal> evaluated = [&] {
+    tensorflow::mutex_lock lock(*runner_mu);
+    evaluating = true;
+    StatusOr<Literal> literal =
+        runner->Execute(MakeEvaluationModule(instruction), arguments);
+    evaluating = false;
+    return literal;
+  }();
+  if (!evaluated.ok()) {
+    VLOG(1) << "Failed to evaluate " << instruction.name()
+            << " on the host: " << evaluated.status();
+    return false;
+  }
+  Literal literal = evaluated.ConsumeValueOrDie();
+  if (!ShapeUtil::Equal(literal.shape(), instruction.shape())) {
+    literal = literal.Relayout(instruction.shape());
+  }
+
+  {
+    tensorflow::mutex_lock lock(cache->mu);
+    if (cache->cached_bytes + literal.size_bytes() <= kMaxCachedBytes &&
+        !cache->results.contains(key)) {
+      cache->cached_bytes += literal.size_bytes();
+      cache->results.emplace(key, literal.Clone());
+    }
+  }
+  *result = std::move(literal);
+  return true;
+}
+
+}  // namespace xla
@@ -0,0 +1,37 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_HOST_CONSTANT_EVALUATOR_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_HOST_CONSTANT_EVALUATOR_H_
+
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+
+namespace xla {
+
+// Evaluates `instruction`, whose operands must all be array constants, by
+// compiling it with the backend of the host platform, i.e. the CPU backend's
+// JIT, and running it. This is much faster than HloEvaluator on large
+// constants. Results are cached for the lifetime of the process by a
+// fingerprint of the instruction and the values of its operands, so that
+// compiling the same module again does not recompile the instruction.
+//
+// Returns false if the host backend is not linked in, or fails to compile or
+// run the instruction. Meant to be passed to HloConstantFolding.
+bool EvaluateConstantOnHost(const HloInstruction& instruction, Literal* result);
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_HOST_CONSTANT_EVALUATOR_H_
@@ -619,4 +619,20 @@ RemoteMemoryManager* CreateRemoteMemoryManager(const string& host,
 
 }  // namespace tensorflow
 
+#else  // TENSORFLOW_USE_GDR
+
+#include "tensorflow/contrib/gdr/gdr_memory_manager.h"
+
+namespace tensorflow {
+
+// Lets GdrServer link in builds that only enable other RemoteMemoryManager
+// implementations, such as UCX. GdrServer::Init() rejects the missing
+// manager.
+RemoteMemoryManager* CreateRemoteMemoryManager(const string& host,
+                                               const string& port) {
+  return nullptr;
+}
+
+}  // namespace tensorflow
+
 #endif  // TENSORFLOW_USE_GDR
@@ -52,6 +52,7 @@ class RemoteMemoryManager {
       StatusCallback done) = 0;
 };
 
+// Returns nullptr if TensorFlow was built without GDR support.
 RemoteMemoryManager* CreateRemoteMemoryManager(const string& host,
                                                const string& port);
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
+#include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
 
@@ -47,9 +48,20 @@ GdrServer::GdrServer(const ServerDef& server_def, Env* env)
       CreateRemoteMemoryManager(host, port));
 }
 
+GdrServer::GdrServer(
+    const ServerDef& server_def, Env* env,
+    std::unique_ptr<RemoteMemoryManager> remote_memory_manager)
+    : GrpcServer(server_def, env),
+      remote_memory_manager_(std::move(remote_memory_manager)) {}
+
 GdrServer::~GdrServer() {}
 
 Status GdrServer::Init() {
+  if (remote_memory_manager_ == nullptr) {
+    return errors::Unimplemented(
+        "TensorFlow was built without GDR support; rebuild with --config=gdr "
+        "to use grpc+gdr");
+  }
   RendezvousMgrCreationFunction rendezvous_mgr_func =
       [this](const WorkerEnv* env) {
         return new GdrRendezvousMgr(env, remote_memory_manager_.get());
@@ -122,6 +134,19 @@ Status GdrServer::Create(const ServerDef& server_def, Env* env,
   return Status::OK();
 }
 
+/* static */
+Status GdrServer::Create(
+    const ServerDef& server_def, Env* env,
+    std::unique_ptr<RemoteMemoryManager> remote_memory_manager,
+    std::unique_ptr<ServerInterface>* out_server) {
+  std::unique_ptr<GdrServer> ret(
+      new GdrServer(server_def, env == nullptr ? Env::Default() : env,
+                    std::move(remote_memory_manager)));
+  TF_RETURN_IF_ERROR(ret->Init());
+  *out_server = std::move(ret);
+  return Status::OK();
+}
+
 namespace {
 
 class GdrServerFactory : public ServerFactory {
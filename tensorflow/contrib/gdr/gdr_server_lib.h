@@ -24,11 +24,19 @@ namespace tensorflow {
 class GdrServer : public GrpcServer {
  protected:
   GdrServer(const ServerDef& server_def, Env* env);
+  GdrServer(const ServerDef& server_def, Env* env,
+            std::unique_ptr<RemoteMemoryManager> remote_memory_manager);
 
  public:
   static Status Create(const ServerDef& server_def, Env* env,
                        std::unique_ptr<ServerInterface>* out_server);
 
+  // Creates a server whose tensors are moved by "remote_memory_manager".
+  static Status Create(
+      const ServerDef& server_def, Env* env,
+      std::unique_ptr<RemoteMemoryManager> remote_memory_manager,
+      std::unique_ptr<ServerInterface>* out_server);
+
   virtual ~GdrServer() override;
 
   virtual Status Start() override;
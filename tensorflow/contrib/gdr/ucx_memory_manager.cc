@@ -0,0 +1,608 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_UCX
+
+#include "tensorflow/contrib/gdr/ucx_memory_manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <ucp/api/ucp.h>
+
+#include "tensorflow/contrib/gdr/gdr.pb.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Active message sent by the receiver of a tensor once it has read it, so
+// that the sender can release the tensor buffer.
+const uint16_t kReleaseAmId = 0;
+
+Status UcxError(ucs_status_t status, const string& what) {
+  return errors::Unavailable(what, ": ", ucs_status_string(status));
+}
+
+class UcxMemoryManager : public RemoteMemoryManager {
+ public:
+  UcxMemoryManager();
+
+  ~UcxMemoryManager() override;
+
+  Status Init() override;
+
+  void Run() override;
+
+  void Stop() override;
+
+  void TransportOptionsFromTensor(
+      ::google::protobuf::Any* mutable_transport_options, const Tensor& tensor,
+      Device* device, DeviceContext* device_context, bool on_host,
+      StatusCallback done) override;
+
+  void TensorFromTransportOptions(
+      Tensor* tensor, const ::google::protobuf::Any& transport_options,
+      Device* device, DeviceContext* device_context, bool on_host,
+      StatusCallback done) override;
+
+ private:
+  using TensorKey = uint32_t;
+
+  // A region registered with ucp_mem_map().
+  struct MemoryRegion {
+    char* addr;
+    size_t length;
+    ucp_mem_h memh;
+    string rkey;  // Packed remote key.
+  };
+
+  // An operation issued to the worker that has not completed yet.
+  struct PendingRequest {
+    // For reads: the callback to run, the unpacked remote key, and the
+    // endpoint and key used to release the remote tensor buffer.
+    StatusCallback done;
+    ucp_rkey_h rkey = nullptr;
+    ucp_ep_h ep = nullptr;
+    TensorKey tensor_key = 0;
+    // For release messages: the payload, which must outlive the send.
+    std::unique_ptr<TensorKey> message;
+  };
+
+  static void OnRequestDone(void* request, ucs_status_t status);
+  static ucs_status_t OnRelease(void* arg, void* data, size_t length,
+                                ucp_ep_h reply_ep, unsigned flags);
+
+  // Records "request", returned by a non-blocking UCP call, as pending.
+  // Returns false if the call has already completed.
+  bool AddPendingRequest(ucs_status_ptr_t request, PendingRequest* pending)
+      EXCLUSIVE_LOCKS_REQUIRED(worker_mu_);
+
+  // Finishes the read described by "pending". The callback is appended to
+  // "callbacks", to be run once worker_mu_ is released.
+  void FinishRead(PendingRequest* pending, ucs_status_t status,
+                  std::vector<std::function<void()>>* callbacks)
+      EXCLUSIVE_LOCKS_REQUIRED(worker_mu_);
+
+  void SendRelease(ucp_ep_h ep, TensorKey tensor_key)
+      EXCLUSIVE_LOCKS_REQUIRED(worker_mu_);
+
+  Status GetEndpoint(const string& worker_address, ucp_ep_h* ep)
+      EXCLUSIVE_LOCKS_REQUIRED(worker_mu_);
+
+  void ReleaseTensorBuffer(TensorKey tensor_key);
+
+  // Returns true if the buffer of "tensor" lies in a registered region, and
+  // then sets "*rkey" (if not null) to the packed remote key of the region.
+  bool FindMemoryRegion(const Tensor* tensor, string* rkey);
+
+  void InsertMemoryRegion(void* addr, size_t length,
+                          const string& allocator_name);
+
+  void EvictMemoryRegion(void* addr, size_t length);
+
+  ucp_context_h context_ = nullptr;
+  std::atomic<bool> stopped_;
+  std::atomic<TensorKey> next_key_;
+
+  // The UCP worker is created in serialized mode; every call on it, or on
+  // its endpoints, holds worker_mu_.
+  mutex worker_mu_;
+  ucp_worker_h worker_ = nullptr;
+  string worker_address_;
+  std::map<string, ucp_ep_h> endpoints_ GUARDED_BY(worker_mu_);
+  std::unordered_map<void*, PendingRequest> pending_ GUARDED_BY(worker_mu_);
+  std::vector<std::pair<void*, ucs_status_t>> completed_
+      GUARDED_BY(worker_mu_);
+
+  // Sender side buffers of the tensors being read by a peer.
+  mutex buf_mu_;
+  std::map<TensorKey, const TensorBuffer*> tensor_buffers_ GUARDED_BY(buf_mu_);
+
+  // Registered regions, sorted by address.
+  mutex alloc_mu_;
+  std::vector<MemoryRegion> mrs_ GUARDED_BY(alloc_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(UcxMemoryManager);
+};
+
+UcxMemoryManager::UcxMemoryManager()
+    : stopped_(true), next_key_(static_cast<uint32_t>(random::New64())) {}
+
+UcxMemoryManager::~UcxMemoryManager() {
+  if (worker_ != nullptr) {
+    mutex_lock l(worker_mu_);
+    for (const auto& endpoint : endpoints_) {
+      ucp_ep_destroy(endpoint.second);
+    }
+    ucp_worker_destroy(worker_);
+  }
+  if (context_ != nullptr) {
+    {
+      mutex_lock l(alloc_mu_);
+      for (const MemoryRegion& mr : mrs_) {
+        ucp_mem_unmap(context_, mr.memh);
+      }
+      mrs_.clear();
+    }
+    ucp_cleanup(context_);
+  }
+}
+
+Status UcxMemoryManager::Init() {
+  ucp_config_t* config;
+  ucs_status_t status = ucp_config_read(nullptr, nullptr, &config);
+  if (status != UCS_OK) {
+    return UcxError(status, "cannot read UCX configuration");
+  }
+  ucp_params_t params = {};
+  params.field_mask = UCP_PARAM_FIELD_FEATURES | UCP_PARAM_FIELD_REQUEST_SIZE;
+  params.features = UCP_FEATURE_RMA | UCP_FEATURE_AM;
+  // Each request starts with a pointer back to this manager.
+  params.request_size = sizeof(UcxMemoryManager*);
+  status = ucp_init(&params, config, &context_);
+  ucp_config_release(config);
+  if (status != UCS_OK) {
+    return UcxError(status, "cannot initialize UCX");
+  }
+
+  ucp_worker_params_t worker_params = {};
+  worker_params.field_mask = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
+  worker_params.thread_mode = UCS_THREAD_MODE_SERIALIZED;
+  status = ucp_worker_create(context_, &worker_params, &worker_);
+  if (status != UCS_OK) {
+    return UcxError(status, "cannot create UCX worker");
+  }
+  ucp_address_t* address;
+  size_t address_length;
+  status = ucp_worker_get_address(worker_, &address, &address_length);
+  if (status != UCS_OK) {
+    return UcxError(status, "cannot get UCX worker address");
+  }
+  worker_address_.assign(reinterpret_cast<const char*>(address),
+                         address_length);
+  ucp_worker_release_address(worker_, address);
+  status = ucp_worker_set_am_handler(worker_, kReleaseAmId, &OnRelease, this,
+                                     UCP_AM_FLAG_WHOLE_MSG);
+  if (status != UCS_OK) {
+    return UcxError(status, "cannot set UCX active message handler");
+  }
+  LOG(INFO) << "UCX worker created with a " << address_length
+            << " byte address";
+
+  SubAllocator::Visitor alloc_visitor = [this](void* ptr, int numa_node,
+                                               size_t num_bytes) {
+    VLOG(2) << "Registering UCX memory region on numa_node " << numa_node;
+    InsertMemoryRegion(ptr, num_bytes, strings::StrCat("CPU:", numa_node));
+  };
+  SubAllocator::Visitor free_visitor = [this](void* ptr, int numa_node,
+                                              size_t num_bytes) {
+    VLOG(2) << "De-registering UCX memory region on numa_node " << numa_node;
+    EvictMemoryRegion(ptr, num_bytes);
+  };
+  ProcessState::singleton()->AddCPUAllocVisitor(alloc_visitor);
+  ProcessState::singleton()->AddCPUFreeVisitor(free_visitor);
+  LOG(INFO) << "Instrumenting CPU allocator(s)";
+
+  for (int numa_idx = 0; numa_idx < port::NUMANumNodes(); ++numa_idx) {
+    GPUProcessState::singleton()->AddGpuHostAllocVisitor(numa_idx,
+                                                         alloc_visitor);
+    GPUProcessState::singleton()->AddGpuHostFreeVisitor(numa_idx, free_visitor);
+  }
+
+  // UCX registers device memory when it is built with CUDA support; when it
+  // is not, ucp_mem_map() fails and tensors on the GPU are staged through
+  // host memory.
+  SubAllocator::Visitor cuda_alloc_visitor = [this](void* ptr, int gpu_id,
+                                                    size_t num_bytes) {
+    VLOG(2) << "Registering UCX memory region on GPU " << gpu_id;
+    InsertMemoryRegion(ptr, num_bytes, strings::StrCat("GPU:", gpu_id));
+  };
+  for (int numa_idx = 0; numa_idx < port::NUMANumNodes(); ++numa_idx) {
+    GPUProcessState::singleton()->AddGPUAllocVisitor(numa_idx,
+                                                     cuda_alloc_visitor);
+  }
+  LOG(INFO) << "Instrumenting GPU allocator(s)";
+
+  return Status::OK();
+}
+
+void UcxMemoryManager::Run() {
+  stopped_ = false;
+  while (!stopped_) {
+    std::vector<std::function<void()>> callbacks;
+    {
+      mutex_lock l(worker_mu_);
+      while (ucp_worker_progress(worker_) != 0) {
+      }
+      for (const auto& completed : completed_) {
+        auto iter = pending_.find(completed.first);
+        if (iter != pending_.end()) {
+          if (iter->second.done) {
+            FinishRead(&iter->second, completed.second, &callbacks);
+          } else if (completed.second != UCS_OK) {
+            LOG(WARNING) << "Cannot release remote tensor buffer: "
+                         << ucs_status_string(completed.second);
+          }
+          pending_.erase(iter);
+        }
+        ucp_request_free(completed.first);
+      }
+      completed_.clear();
+    }
+    for (const auto& callback : callbacks) {
+      callback();
+    }
+  }
+}
+
+void UcxMemoryManager::Stop() { stopped_ = true; }
+
+/* static */
+void UcxMemoryManager::OnRequestDone(void* request, ucs_status_t status) {
+  // Called from ucp_worker_progress(), with worker_mu_ held.
+  UcxMemoryManager* manager = *static_cast<UcxMemoryManager**>(request);
+  manager->completed_.emplace_back(request, status);
+}
+
+/* static */
+ucs_status_t UcxMemoryManager::OnRelease(void* arg, void* data, size_t length,
+                                         ucp_ep_h reply_ep, unsigned flags) {
+  UcxMemoryManager* manager = static_cast<UcxMemoryManager*>(arg);
+  if (length != sizeof(TensorKey)) {
+    LOG(ERROR) << "Received release message of " << length << " bytes";
+    return UCS_OK;
+  }
+  TensorKey tensor_key;
+  memcpy(&tensor_key, data, sizeof(tensor_key));
+  manager->ReleaseTensorBuffer(tensor_key);
+  return UCS_OK;
+}
+
+bool UcxMemoryManager::AddPendingRequest(ucs_status_ptr_t request,
+                                         PendingRequest* pending) {
+  if (request == nullptr) {
+    return false;
+  }
+  // The completion callback only runs from ucp_worker_progress(), which
+  // cannot be called concurrently since worker_mu_ is held.
+  *static_cast<UcxMemoryManager**>(request) = this;
+  pending_.emplace(request, std::move(*pending));
+  return true;
+}
+
+void UcxMemoryManager::FinishRead(
+    PendingRequest* pending, ucs_status_t status,
+    std::vector<std::function<void()>>* callbacks) {
+  ucp_rkey_destroy(pending->rkey);
+  // The sender holds the buffer until it is told to release it, whether the
+  // read succeeded or not.
+  SendRelease(pending->ep, pending->tensor_key);
+  Status s = status == UCS_OK ? Status::OK() : UcxError(status, "read failed");
+  StatusCallback done = std::move(pending->done);
+  callbacks->push_back([done, s]() { done(s); });
+}
+
+void UcxMemoryManager::SendRelease(ucp_ep_h ep, TensorKey tensor_key) {
+  PendingRequest pending;
+  pending.message.reset(new TensorKey(tensor_key));
+  ucs_status_ptr_t request =
+      ucp_am_send_nb(ep, kReleaseAmId, pending.message.get(),
+                     sizeof(TensorKey), ucp_dt_make_contig(1), &OnRequestDone,
+                     0 /* flags */);
+  if (UCS_PTR_IS_ERR(request)) {
+    LOG(WARNING) << "Cannot release remote tensor buffer " << tensor_key
+                 << ": " << ucs_status_string(UCS_PTR_STATUS(request));
+    return;
+  }
+  AddPendingRequest(request, &pending);
+}
+
+Status UcxMemoryManager::GetEndpoint(const string& worker_address,
+                                     ucp_ep_h* ep) {
+  auto iter = endpoints_.find(worker_address);
+  if (iter != endpoints_.end()) {
+    *ep = iter->second;
+    return Status::OK();
+  }
+  ucp_ep_params_t ep_params = {};
+  ep_params.field_mask = UCP_EP_PARAM_FIELD_REMOTE_ADDRESS;
+  ep_params.address =
+      reinterpret_cast<const ucp_address_t*>(worker_address.data());
+  ucs_status_t status = ucp_ep_create(worker_, &ep_params, ep);
+  if (status != UCS_OK) {
+    return UcxError(status, "cannot create UCX endpoint");
+  }
+  endpoints_.emplace(worker_address, *ep);
+  return Status::OK();
+}
+
+void UcxMemoryManager::ReleaseTensorBuffer(TensorKey tensor_key) {
+  const TensorBuffer* buffer = nullptr;
+  {
+    mutex_lock l(buf_mu_);
+    auto iter = tensor_buffers_.find(tensor_key);
+    if (iter == tensor_buffers_.end()) {
+      LOG(ERROR) << "Cannot find tensor buffer for tensor key " << tensor_key;
+      return;
+    }
+    buffer = iter->second;
+    tensor_buffers_.erase(iter);
+  }
+  buffer->Unref();
+}
+
+void UcxMemoryManager::TransportOptionsFromTensor(
+    ::google::protobuf::Any* mutable_transport_options, const Tensor& tensor,
+    Device* device, DeviceContext* device_context, bool on_host,
+    StatusCallback done) {
+  UcxRemoteMemoryRegion remote_mr;
+  remote_mr.set_worker_address(worker_address_);
+  if (tensor.TotalBytes() == 0) {
+    mutable_transport_options->PackFrom(remote_mr);
+    done(Status::OK());
+    return;
+  }
+
+  string rkey;
+  const TensorBuffer* buffer = DMAHelper::buffer(&tensor);
+
+  Tensor* copy = nullptr;
+
+  if (!FindMemoryRegion(&tensor, &rkey)) {
+    AllocatorAttributes alloc_attrs;
+    alloc_attrs.set_gpu_compatible(true);
+    alloc_attrs.set_nic_compatible(true);
+    alloc_attrs.set_on_host(true);
+    Allocator* alloc = device->GetAllocator(alloc_attrs);
+    copy = new Tensor(alloc, tensor.dtype(), tensor.shape());
+
+    buffer = DMAHelper::buffer(copy);
+    if (!FindMemoryRegion(copy, &rkey)) {
+      done(errors::Unavailable("Cannot find UCX registered memory region"));
+      delete copy;
+      return;
+    }
+  }
+
+  TensorKey tensor_key = next_key_++;
+  buffer->Ref();
+  {
+    mutex_lock l(buf_mu_);
+    tensor_buffers_.insert(std::make_pair(tensor_key, buffer));
+  }
+
+  remote_mr.set_addr(reinterpret_cast<uint64_t>(buffer->data()));
+  remote_mr.set_rkey(rkey);
+  remote_mr.set_tensor_key(tensor_key);
+  mutable_transport_options->PackFrom(remote_mr);
+
+  if (copy && device->tensorflow_gpu_device_info() && !on_host) {
+    device_context->CopyDeviceTensorToCPU(&tensor, "" /* tensor_name */, device,
+                                          copy, [done, copy](const Status& s) {
+                                            done(s);
+                                            delete copy;
+                                          });
+  } else if (copy) {
+    std::memcpy(buffer->data(), DMAHelper::buffer(&tensor)->data(),
+                buffer->size());
+    done(Status::OK());
+    delete copy;  // OK to delete; we have reffed the underlying TensorBuffer
+  } else {
+    done(Status::OK());
+  }
+}
+
+void UcxMemoryManager::TensorFromTransportOptions(
+    Tensor* tensor, const ::google::protobuf::Any& transport_options,
+    Device* device, DeviceContext* device_context, bool on_host,
+    StatusCallback done) {
+  UcxRemoteMemoryRegion remote_mr;
+  if (!transport_options.UnpackTo(&remote_mr)) {
+    done(errors::NotFound("No UCX transport options found"));
+    return;
+  }
+  if (tensor->TotalBytes() == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  // UCX reads into unregistered host memory, but device memory is only
+  // usable if UCX could register it.
+  const TensorBuffer* buffer = DMAHelper::buffer(tensor);
+  const Tensor* copy = nullptr;
+  if (device->tensorflow_gpu_device_info() && !on_host &&
+      !FindMemoryRegion(tensor, nullptr)) {
+    AllocatorAttributes alloc_attrs;
+    alloc_attrs.set_gpu_compatible(true);
+    alloc_attrs.set_nic_compatible(true);
+    alloc_attrs.set_on_host(true);
+    Allocator* alloc = device->GetAllocator(alloc_attrs);
+    copy = new Tensor(alloc, tensor->dtype(), tensor->shape());
+    buffer = DMAHelper::buffer(copy);
+  }
+
+  uint64_t start = Env::Default()->NowMicros();
+  const TensorKey tensor_key = remote_mr.tensor_key();
+
+  PendingRequest pending;
+  pending.tensor_key = tensor_key;
+  pending.done = [done, copy, device, device_context, tensor, start,
+                  tensor_key](const Status& s) {
+    if (!s.ok()) {
+      done(s);
+      delete copy;
+      return;
+    }
+
+    VLOG(2) << "UCX read of tensor " << tensor_key << " of size "
+            << DMAHelper::buffer(tensor)->size() << " took "
+            << (Env::Default()->NowMicros() - start) << " micros";
+
+    if (copy) {
+      device_context->CopyCPUTensorToDevice(copy, device, tensor,
+                                            [done, copy](const Status& s) {
+                                              done(s);
+                                              delete copy;
+                                            });
+    } else {
+      done(s);
+    }
+  };
+
+  std::vector<std::function<void()>> callbacks;
+  {
+    mutex_lock l(worker_mu_);
+    Status s = GetEndpoint(remote_mr.worker_address(), &pending.ep);
+    ucs_status_t status = UCS_OK;
+    if (s.ok()) {
+      status = ucp_ep_rkey_unpack(pending.ep, remote_mr.rkey().data(),
+                                  &pending.rkey);
+      if (status != UCS_OK) {
+        s = UcxError(status, "cannot unpack UCX remote key");
+        SendRelease(pending.ep, tensor_key);
+      }
+    }
+    if (!s.ok()) {
+      StatusCallback failed = std::move(pending.done);
+      callbacks.push_back([failed, s]() { failed(s); });
+    } else {
+      ucs_status_ptr_t request =
+          ucp_get_nb(pending.ep, buffer->data(), buffer->size(),
+                     remote_mr.addr(), pending.rkey, &OnRequestDone);
+      if (UCS_PTR_IS_ERR(request)) {
+        FinishRead(&pending, UCS_PTR_STATUS(request), &callbacks);
+      } else if (!AddPendingRequest(request, &pending)) {
+        FinishRead(&pending, UCS_OK, &callbacks);
+      }
+    }
+  }
+  for (const auto& callback : callbacks) {
+    callback();
+  }
+}
+
+bool UcxMemoryManager::FindMemoryRegion(const Tensor* tensor, string* rkey) {
+  const char* addr =
+      static_cast<const char*>(DMAHelper::buffer(tensor)->data());
+  mutex_lock l(alloc_mu_);
+  auto iter = std::upper_bound(
+      mrs_.begin(), mrs_.end(), addr,
+      [](const char* addr, const MemoryRegion& mr) {
+        return addr < mr.addr + mr.length;
+      });
+  if (iter == mrs_.end() || iter->addr > addr) {
+    return false;
+  }
+  if (rkey != nullptr) {
+    *rkey = iter->rkey;
+  }
+  return true;
+}
+
+void UcxMemoryManager::InsertMemoryRegion(void* addr, size_t length,
+                                          const string& allocator_name) {
+  if (length == 0) return;
+  ucp_mem_map_params_t params = {};
+  params.field_mask =
+      UCP_MEM_MAP_PARAM_FIELD_ADDRESS | UCP_MEM_MAP_PARAM_FIELD_LENGTH;
+  params.address = addr;
+  params.length = length;
+  MemoryRegion mr;
+  mr.addr = static_cast<char*>(addr);
+  mr.length = length;
+  ucs_status_t status = ucp_mem_map(context_, &params, &mr.memh);
+  if (status != UCS_OK) {
+    LOG(WARNING) << "Cannot register memory region allocated by "
+                 << allocator_name << ": " << ucs_status_string(status);
+    return;
+  }
+  void* rkey_buffer;
+  size_t rkey_size;
+  status = ucp_rkey_pack(context_, mr.memh, &rkey_buffer, &rkey_size);
+  if (status != UCS_OK) {
+    LOG(WARNING) << "Cannot pack remote key of memory region allocated by "
+                 << allocator_name << ": " << ucs_status_string(status);
+    ucp_mem_unmap(context_, mr.memh);
+    return;
+  }
+  mr.rkey.assign(static_cast<const char*>(rkey_buffer), rkey_size);
+  ucp_rkey_buffer_release(rkey_buffer);
+
+  mutex_lock l(alloc_mu_);
+  auto iter = std::upper_bound(
+      mrs_.begin(), mrs_.end(), mr.addr,
+      [](const char* addr, const MemoryRegion& mr) { return addr < mr.addr; });
+  mrs_.insert(iter, std::move(mr));
+}
+
+void UcxMemoryManager::EvictMemoryRegion(void* addr, size_t length) {
+  if (length == 0) return;
+  mutex_lock l(alloc_mu_);
+  auto iter = std::lower_bound(
+      mrs_.begin(), mrs_.end(), static_cast<char*>(addr),
+      [](const MemoryRegion& mr, const char* addr) { return mr.addr < addr; });
+  if (iter != mrs_.end() && iter->addr == addr) {
+    ucp_mem_unmap(context_, iter->memh);
+    mrs_.erase(iter);
+  } else {
+    LOG(WARNING) << "Failed to de-register memory region";
+  }
+}
+
+}  // namespace
+
+RemoteMemoryManager* CreateUcxMemoryManager() { return new UcxMemoryManager; }
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_UCX
@@ -0,0 +1,34 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_GDR_UCX_MEMORY_MANAGER_H_
+#define TENSORFLOW_CONTRIB_GDR_UCX_MEMORY_MANAGER_H_
+
+#include "tensorflow/contrib/gdr/gdr_memory_manager.h"
+
+namespace tensorflow {
+
+// Returns a RemoteMemoryManager that moves tensors with UCX one-sided reads.
+//
+// Like the GDR manager, it registers the buffers of the CPU, GPU host and GPU
+// allocators as they are allocated, so that tensors are read in place by the
+// receiver. Unlike it, it needs no listening address: the UCP worker address
+// is sent along with each tensor, and UCX picks the transport (InfiniBand,
+// RoCE, TCP, shared memory or CUDA IPC) for each peer.
+RemoteMemoryManager* CreateUcxMemoryManager();
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CONTRIB_GDR_UCX_MEMORY_MANAGER_H_
@@ -0,0 +1,49 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/gdr/gdr_server_lib.h"
+#include "tensorflow/contrib/gdr/ucx_memory_manager.h"
+
+namespace tensorflow {
+namespace {
+
+// Serves "grpc+ucx" with the GDR server: gRPC carries the control messages
+// and the tensors of RecvTensor and RecvBuf are read with UCX.
+class UcxServerFactory : public ServerFactory {
+ public:
+  bool AcceptsOptions(const ServerDef& server_def) override {
+    return server_def.protocol() == "grpc+ucx";
+  }
+
+  Status NewServer(const ServerDef& server_def,
+                   std::unique_ptr<ServerInterface>* out_server) override {
+    return GdrServer::Create(
+        server_def, Env::Default(),
+        std::unique_ptr<RemoteMemoryManager>(CreateUcxMemoryManager()),
+        out_server);
+  }
+};
+
+// Registers a `ServerFactory` for UCX backed `GdrServer` instances.
+class UcxServerRegistrar {
+ public:
+  UcxServerRegistrar() {
+    ServerFactory::Register("UCX_SERVER", new UcxServerFactory());
+  }
+};
+static UcxServerRegistrar registrar;
+
+}  // namespace
+}  // namespace tensorflow
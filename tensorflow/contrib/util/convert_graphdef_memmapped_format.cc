@@ -21,10 +21,16 @@ limitations under the License.
 //  tensorflow/contrib/util/convert_graphdef_memmapped_format
 //        --in_graph=frozen.model --out_graph=memmapped.mmodel
 //
+// or, to convert the constants of a SavedModel in place,
+//
+//  tensorflow/contrib/util/convert_graphdef_memmapped_format
+//        --saved_model_dir=/path/to/saved_model
+//
 // Parameters:
 // in_graph - name of a file with a frozen GraphDef proto in binary format
 // out_graph - name of the output file, where the graph in memmapped format will
 // be saved.
+// saved_model_dir - directory of a SavedModel to convert instead of in_graph.
 // min_conversion_size_bytes - tensors with fewer than this many bytes of data
 // will not be converted to ImmutableConst format, and kept in the graph.
 
@@ -41,10 +47,13 @@ namespace {
 int ParseFlagsAndConvertGraph(int argc, char* argv[]) {
   string in_graph = "";
   string out_graph = "";
+  string saved_model_dir = "";
   int min_conversion_tensor_size = 10000;
   std::vector<Flag> flag_list = {
       Flag("in_graph", &in_graph, "input graph"),
       Flag("out_graph", &out_graph, "output graph"),
+      Flag("saved_model_dir", &saved_model_dir,
+           "SavedModel directory to convert in place"),
       Flag("min_conversion_tensor_size", &min_conversion_tensor_size,
            "constants with tensors that have less than this number elements "
            "won't be converted into ImmutableConst (be memmapped)"),
@@ -61,19 +70,25 @@ int ParseFlagsAndConvertGraph(int argc, char* argv[]) {
     LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
     return -1;
   }
-  if (in_graph.empty()) {
-    LOG(ERROR) << "in_graph graph can't be empty";
-    return -1;
-  }
-  if (out_graph.empty()) {
-    LOG(ERROR) << "out_graph graph can't be empty";
-    return -1;
+  if (saved_model_dir.empty()) {
+    if (in_graph.empty()) {
+      LOG(ERROR) << "in_graph graph can't be empty";
+      return -1;
+    }
+    if (out_graph.empty()) {
+      LOG(ERROR) << "out_graph graph can't be empty";
+      return -1;
+    }
   }
   if (min_conversion_tensor_size <= 0) {
     LOG(ERROR) << "min_conversion_tensor_size must be > 0";
     return -1;
   }
-  const auto result = ConvertConstantsToImmutable(in_graph, out_graph,
+  const auto result =
+      saved_model_dir.empty()
+          ? ConvertConstantsToImmutable(in_graph, out_graph,
+                                        min_conversion_tensor_size)
+          : ConvertSavedModelConstantsToImmutable(saved_model_dir,
                                                   min_conversion_tensor_size);
   if (!result.ok()) {
     LOG(ERROR) << "Conversion failed " << result.error_message();
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
 
 #include <unordered_set>
+#include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -24,8 +25,10 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/immutable_constant_op.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
 #include "tensorflow/core/util/memmapped_file_system_writer.h"
 
 namespace tensorflow {
@@ -131,6 +134,25 @@ class NodeConverter {
   std::unordered_set<string> used_names_;
 };
 
+// Iterates over graph nodes, looking for Const and replacing it with
+// ImmutableConst.
+Status ConvertGraphConstantsToImmutable(GraphDef* graph_def,
+                                        NodeConverter* node_converter,
+                                        MemmappedFileSystemWriter* writer,
+                                        int* convert_counter,
+                                        int min_conversion_size_bytes) {
+  for (int i = 0; i < graph_def->node_size(); ++i) {
+    const NodeDef& node = graph_def->node(i);
+    if (node.op() == "Const") {
+      // Try to convert to ImmutableConst
+      TF_RETURN_IF_ERROR(node_converter->ConvertConstantsToImmutable(
+          graph_def->mutable_node(i), writer, convert_counter,
+          min_conversion_size_bytes));
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 // Loads the graph, replaces operators, and writes it out.
@@ -153,18 +175,10 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
   MemmappedFileSystemWriter writer;
   TF_RETURN_IF_ERROR(writer.InitializeToFile(default_env, out_graph_filename));
 
-  // Iterate over graph nodes, looking for Const and replacing it with
-  // ImmutableConst.
   int convert_counter = 0;
-  for (int i = 0; i < graph_def.node_size(); ++i) {
-    const NodeDef& node = graph_def.node(i);
-    if (node.op() == "Const") {
-      // Try to convert to ImmutableConst
-      TF_RETURN_IF_ERROR(node_converter.ConvertConstantsToImmutable(
-          graph_def.mutable_node(i), &writer, &convert_counter,
-          min_conversion_size_bytes));
-    }
-  }
+  TF_RETURN_IF_ERROR(ConvertGraphConstantsToImmutable(
+      &graph_def, &node_converter, &writer, &convert_counter,
+      min_conversion_size_bytes));
   TF_RETURN_IF_ERROR(writer.SaveProtobuf(
       graph_def, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef));
   TF_RETURN_IF_ERROR(writer.FlushAndClose());
@@ -172,4 +186,40 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
   return Status::OK();
 }
 
+Status ConvertSavedModelConstantsToImmutable(const string& export_dir,
+                                             int min_conversion_size_bytes) {
+  Env* default_env = Env::Default();
+  const string saved_model_filename =
+      io::JoinPath(export_dir, kSavedModelFilenamePb);
+  SavedModel saved_model;
+  const auto load_status =
+      ReadBinaryProto(default_env, saved_model_filename, &saved_model);
+  if (!load_status.ok()) {
+    return errors::NotFound("Failed to load SavedModel at '",
+                            saved_model_filename,
+                            "' : ", load_status.error_message());
+  }
+
+  // A single converter keeps region names unique across all meta graphs.
+  NodeConverter node_converter;
+  const string constants_filename =
+      io::JoinPath(export_dir, kSavedModelMemmappedConstantsFilename);
+  MemmappedFileSystemWriter writer;
+  TF_RETURN_IF_ERROR(writer.InitializeToFile(default_env, constants_filename));
+
+  int convert_counter = 0;
+  for (MetaGraphDef& meta_graph_def : *saved_model.mutable_meta_graphs()) {
+    TF_RETURN_IF_ERROR(ConvertGraphConstantsToImmutable(
+        meta_graph_def.mutable_graph_def(), &node_converter, &writer,
+        &convert_counter, min_conversion_size_bytes));
+  }
+  TF_RETURN_IF_ERROR(writer.FlushAndClose());
+  LOG(INFO) << "Converted " << convert_counter << " nodes";
+  if (convert_counter == 0) {
+    // An empty package can't be mapped, and the SavedModel is unchanged.
+    return default_env->DeleteFile(constants_filename);
+  }
+  return WriteBinaryProto(default_env, saved_model_filename, saved_model);
+}
+
 }  // namespace tensorflow
@@ -29,6 +29,14 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                    const string& out_graph_filename,
                                    int min_conversion_size_bytes);
 
+// Converts the large Const ops of every meta graph of the SavedModel in
+// `export_dir` in place. Their tensors are written to the memmapped package
+// kSavedModelMemmappedConstantsFilename in `export_dir`, which LoadSavedModel()
+// maps instead of parsing the tensors out of saved_model.pb. Only binary
+// SavedModels are supported.
+Status ConvertSavedModelConstantsToImmutable(const string& export_dir,
+                                             int min_conversion_size_bytes);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CONTRIB_UTIL_CONVERT_GRAPHDEF_MEMMAPPED_FORMAT_LIB_H_
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
@@ -20,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/memmapped_file_system.h"
 
@@ -89,6 +92,46 @@ TEST(ConvertGraphdefMemmappedFormatTest, ConvertModel) {
   EXPECT_EQ(outputs.front().flat<float>()(2), 2.0f * 3.0f * kTensorHeight);
 }
 
+TEST(ConvertGraphdefMemmappedFormatTest, ConvertSavedModel) {
+  const string export_dir =
+      io::JoinPath(testing::TmpDir(), "memmapped_saved_model");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(export_dir));
+
+  constexpr int kTensorWidth = 4000;
+  constexpr int kTensorHeight = 100;
+  Tensor test_tensor1(DT_FLOAT, TensorShape({kTensorWidth, kTensorHeight}));
+  test::FillFn<float>(&test_tensor1, [](int) -> float { return 2.0; });
+  Tensor test_tensor2(DT_FLOAT, TensorShape({kTensorHeight, kTensorWidth}));
+  test::FillFn<float>(&test_tensor2, [](int) -> float { return 3.0; });
+
+  auto root = Scope::NewRootScope().ExitOnError();
+  Output m = ops::MatMul(root, test_tensor1, test_tensor2);
+  const string result_name = m.node()->name();
+
+  SavedModel saved_model;
+  MetaGraphDef* meta_graph_def = saved_model.add_meta_graphs();
+  meta_graph_def->mutable_meta_info_def()->add_tags("serve");
+  TF_ASSERT_OK(root.ToGraphDef(meta_graph_def->mutable_graph_def()));
+  TF_ASSERT_OK(WriteBinaryProto(
+      Env::Default(), io::JoinPath(export_dir, kSavedModelFilenamePb),
+      saved_model));
+
+  TF_ASSERT_OK(ConvertSavedModelConstantsToImmutable(export_dir, 10000));
+  TF_ASSERT_OK(Env::Default()->FileExists(
+      io::JoinPath(export_dir, kSavedModelMemmappedConstantsFilename)));
+
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir,
+                              {"serve"}, &bundle));
+  ASSERT_TRUE(bundle.env != nullptr);
+  ASSERT_TRUE(GraphHasImmutableConstNodes(bundle.meta_graph_def.graph_def()));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {result_name + ":0"}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs.front().flat<float>()(0), 2.0f * 3.0f * kTensorHeight);
+}
+
 TEST(ConvertGraphdefMemmappedFormatTest, NotSupportedTypesConvert) {
   // Create a graph with strings.
   const string dir = testing::TmpDir();
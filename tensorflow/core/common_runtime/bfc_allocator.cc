@@ -16,19 +16,36 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
 #include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+void AtomicMax(std::atomic<int64>* value, int64 candidate) {
+  int64 current = value->load(std::memory_order_relaxed);
+  while (candidate > current &&
+         !value->compare_exchange_weak(current, candidate,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name)
     : sub_allocator_(sub_allocator),
@@ -65,6 +82,39 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  Status status = ReadInt64FromEnvVar("TF_BFC_ALLOCATOR_SLAB_CACHE_BYTES", 0,
+                                      &slab_cache_limit_);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetSlabCacheLimit: " << status.error_message();
+    slab_cache_limit_ = 0;
+  }
+  if (slab_cache_limit_ > 0) {
+    VLOG(1) << "Using a slab cache of up to "
+            << strings::HumanReadableNumBytes(slab_cache_limit_)
+            << " for allocations of up to " << kMaxSlabObjectSize << " bytes.";
+    slab_cache_shards_.reset(new SlabCacheShard[kNumSlabCacheShards]);
+  }
+
+  status = ReadBoolFromEnvVar("TF_BFC_ALLOCATOR_RELEASE_FREE_REGIONS", false,
+                              &release_free_regions_);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetReleaseFreeRegions: " << status.error_message();
+    release_free_regions_ = false;
+  }
+
+  int64 memory_profile_events;
+  status = ReadInt64FromEnvVar("TF_BFC_ALLOCATOR_MEMORY_PROFILE_EVENTS", 0,
+                               &memory_profile_events);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetMemoryProfileEvents: " << status.error_message();
+    memory_profile_events = 0;
+  }
+  if (memory_profile_events > 0) {
+    VLOG(1) << "Recording a memory profile of the last "
+            << memory_profile_events << " events.";
+    memory_profiler_.reset(new MemoryProfiler(memory_profile_events));
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -216,9 +266,28 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
   }
 }
 
-void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
+void* BFCAllocator::AllocateRaw(size_t alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
+  void* ptr = AllocateRawUnprofiled(alignment, num_bytes, allocation_attr);
+  if (memory_profiler_ != nullptr && ptr != nullptr) {
+    memory_profiler_->RecordAllocation(ptr, num_bytes);
+  }
+  return ptr;
+}
+
+void* BFCAllocator::AllocateRawUnprofiled(
+    size_t unused_alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
   VLOG(1) << "AllocateRaw " << Name() << "  " << num_bytes;
+  if (slab_cache_limit_ > 0 && num_bytes > 0 &&
+      num_bytes <= kMaxSlabObjectSize &&
+      allocation_attr.freed_by_func == nullptr) {
+    void* ptr = AllocateFromSlabCache(num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    // Otherwise fall back to the bins, which may release free slabs.
+  }
   if (allocation_attr.no_retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
@@ -294,6 +363,26 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Free objects held in the slab cache cannot be used for this allocation,
+  // but slabs whose objects are all free can.
+  if (ReleaseFreeSlabs()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
+  // The free memory may be split across regions, none of which is large
+  // enough.  Reserve the memory of the regions that are entirely free again
+  // as one region.
+  if (release_free_regions_ && ReleaseFreeRegions() &&
+      Extend(unused_alignment, rounded_bytes)) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   if ((freed_before == 0) && (!timestamped_chunks_.empty())) {
     // We're unable to satisfy an allocation request without a specific
     // timestamp requirement.  Rather than fail, try merging any held-out
@@ -310,6 +399,10 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // We searched all bins for an existing free chunk to use and
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
+  if (memory_profiler_ != nullptr) {
+    memory_profiler_->RecordAllocationFailure(num_bytes,
+                                              GetFragmentationLocked());
+  }
   if (dump_log_on_failure) {
     LOG(WARNING) << "Allocator (" << Name() << ") ran out of memory trying "
                  << "to allocate " << strings::HumanReadableNumBytes(num_bytes)
@@ -317,12 +410,31 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
                  << ").  Current allocation summary follows.";
     DumpMemoryLog(rounded_bytes);
     LOG(WARNING) << RenderOccupancy();
+    if (memory_profiler_ != nullptr) {
+      static const int kMaxLoggedEvents = 100;
+      LOG(WARNING) << "Memory profile:\n"
+                   << GetMemoryProfileLocked().DebugString(kMaxLoggedEvents);
+    }
   }
   return nullptr;
 }
 
+void* BFCAllocator::AllocateSlabChunk() {
+  const BinNum bin_num = BinNumForSize(kSlabSize);
+  mutex_lock l(lock_);
+  if (!timestamped_chunks_.empty()) {
+    MergeTimestampedChunks(0);
+  }
+  void* ptr = FindChunkPtr(bin_num, kSlabSize, kSlabSize, 0, false);
+  if (ptr == nullptr && Extend(Allocator::kAllocatorAlignment, kSlabSize)) {
+    ptr = FindChunkPtr(bin_num, kSlabSize, kSlabSize, 0, false);
+  }
+  return ptr;
+}
+
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
-                                 size_t num_bytes, uint64 freed_before) {
+                                 size_t num_bytes, uint64 freed_before,
+                                 bool track_stats) {
   // First identify the first bin that could satisfy rounded_bytes.
   for (; bin_num < kNumBins; bin_num++) {
     // Start searching from the first bin for the smallest chunk that fits
@@ -357,15 +469,22 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         chunk->requested_size = num_bytes;
         // Assign a unique id and increment the id counter, marking the
         // chunk as being in use.
-        chunk->allocation_id = next_allocation_id_++;
+        chunk->allocation_id =
+            next_allocation_id_.fetch_add(1, std::memory_order_relaxed);
 
         // Update stats.
-        ++stats_.num_allocs;
-        stats_.bytes_in_use += chunk->size;
-        stats_.peak_bytes_in_use =
-            std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
-        stats_.largest_alloc_size =
-            std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        if (track_stats) {
+          ++stats_.num_allocs;
+          stats_.bytes_in_use += chunk->size;
+          bfc_bytes_in_use_.store(stats_.bytes_in_use,
+                                  std::memory_order_relaxed);
+          stats_.peak_bytes_in_use = std::max(
+              stats_.peak_bytes_in_use,
+              stats_.bytes_in_use +
+                  slab_bytes_in_use_.load(std::memory_order_relaxed));
+          stats_.largest_alloc_size =
+              std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        }
 
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
@@ -420,6 +539,10 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  if (memory_profiler_ != nullptr && ptr != nullptr) {
+    // Before the memory can be handed out again.
+    memory_profiler_->RecordDeallocation(ptr);
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -429,13 +552,20 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     VLOG(2) << "tried to deallocate nullptr";
     return;
   }
+  if (slab_cache_limit_ > 0 && DeallocateToSlabCache(ptr)) {
+    return;
+  }
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
 
-  MarkFree(h);
+  ReturnChunk(h, true);
+}
+
+void BFCAllocator::ReturnChunk(ChunkHandle h, bool track_stats) {
+  MarkFree(h, track_stats);
 
   // Consider coalescing it.
   if (timing_counter_) {
@@ -519,7 +649,7 @@ void BFCAllocator::RemoveFreeChunkFromBin(BFCAllocator::ChunkHandle h) {
   c->bin_num = kInvalidBinNum;
 }
 
-void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
+void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h, bool track_stats) {
   Chunk* c = ChunkFromHandle(h);
   CHECK(c->in_use() && (c->bin_num == kInvalidBinNum));
 
@@ -532,7 +662,10 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
   }
 
   // Updates the stats.
-  stats_.bytes_in_use -= c->size;
+  if (track_stats) {
+    stats_.bytes_in_use -= c->size;
+    bfc_bytes_in_use_.store(stats_.bytes_in_use, std::memory_order_relaxed);
+  }
 }
 
 BFCAllocator::ChunkHandle BFCAllocator::TryToCoalesce(ChunkHandle h,
@@ -652,10 +785,288 @@ bool BFCAllocator::MergeTimestampedChunks(size_t required_bytes) {
   return satisfied;
 }
 
+// static
+int BFCAllocator::SizeClassForBytes(size_t num_bytes) {
+  return std::max(0, Log2Ceiling64(num_bytes) -
+                         static_cast<int>(kMinAllocationBits));
+}
+
+BFCAllocator::SlabCacheShard* BFCAllocator::CurrentSlabCacheShard() {
+  // Threads are assigned to shards round-robin when they first use any slab
+  // cache, which spreads a fixed set of inter-op threads evenly.
+  static std::atomic<int> next_shard{0};
+  static thread_local int shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kNumSlabCacheShards;
+  return &slab_cache_shards_[shard];
+}
+
+void* BFCAllocator::AllocateFromSlabCache(size_t num_bytes) {
+  const int size_class = SizeClassForBytes(num_bytes);
+  DCHECK_LT(size_class, kNumSizeClasses);
+  SlabCacheShard* shard = CurrentSlabCacheShard();
+  SlabObject object;
+  bool found = false;
+  {
+    mutex_lock l(shard->mu);
+    std::vector<SlabObject>& free_objects = shard->free_objects[size_class];
+    if (!free_objects.empty()) {
+      object = free_objects.back();
+      free_objects.pop_back();
+      found = true;
+    }
+  }
+  if (!found && !RefillSlabCache(shard, size_class, &object)) {
+    return nullptr;
+  }
+
+  Slab* slab = object.slab;
+  const int index = slab->IndexFor(object.ptr);
+  slab->requested_sizes[index] = num_bytes;
+  slab->allocation_ids[index] =
+      next_allocation_id_.fetch_add(1, std::memory_order_relaxed);
+
+  const int64 object_size = slab->object_size;
+  slab_num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  const int64 bytes_in_use =
+      slab_bytes_in_use_.fetch_add(object_size, std::memory_order_relaxed) +
+      object_size;
+  AtomicMax(&slab_peak_bytes_in_use_,
+            bytes_in_use + bfc_bytes_in_use_.load(std::memory_order_relaxed));
+  AtomicMax(&slab_largest_alloc_size_, object_size);
+  return object.ptr;
+}
+
+bool BFCAllocator::DeallocateToSlabCache(void* ptr) {
+  Slab* slab = FindSlab(ptr);
+  if (slab == nullptr) {
+    return false;
+  }
+  const int index = slab->IndexFor(ptr);
+  CHECK_NE(slab->allocation_ids[index], -1)
+      << "Deallocating slab object that is not in use: " << ptr;
+  slab->allocation_ids[index] = -1;
+  slab_bytes_in_use_.fetch_sub(slab->object_size, std::memory_order_relaxed);
+
+  // Keep the most recently freed objects in the shard, and move the oldest
+  // batch to the depot once the shard holds two batches.
+  const int size_class = SizeClassForBytes(slab->object_size);
+  SlabCacheShard* shard = CurrentSlabCacheShard();
+  std::vector<SlabObject> overflow;
+  {
+    mutex_lock l(shard->mu);
+    std::vector<SlabObject>& free_objects = shard->free_objects[size_class];
+    free_objects.push_back({ptr, slab});
+    if (free_objects.size() >= 2 * kSlabCacheBatchSize) {
+      overflow.assign(free_objects.begin(),
+                      free_objects.begin() + kSlabCacheBatchSize);
+      free_objects.erase(free_objects.begin(),
+                         free_objects.begin() + kSlabCacheBatchSize);
+    }
+  }
+  if (!overflow.empty()) {
+    mutex_lock l(slab_depot_mu_);
+    std::vector<SlabObject>& depot = slab_depot_[size_class];
+    depot.insert(depot.end(), overflow.begin(), overflow.end());
+  }
+  return true;
+}
+
+bool BFCAllocator::RefillSlabCache(SlabCacheShard* shard, int size_class,
+                                   SlabObject* result) {
+  std::vector<SlabObject> batch;
+  {
+    mutex_lock l(slab_depot_mu_);
+    std::vector<SlabObject>& depot = slab_depot_[size_class];
+    const size_t n = std::min<size_t>(depot.size(), kSlabCacheBatchSize);
+    batch.assign(depot.end() - n, depot.end());
+    depot.resize(depot.size() - n);
+  }
+  if (batch.empty()) {
+    Slab* slab = NewSlab(size_class);
+    if (slab == nullptr) {
+      return false;
+    }
+    // Push in reverse so that objects are handed out in address order.
+    batch.reserve(slab->num_objects);
+    for (int i = slab->num_objects - 1; i >= 0; --i) {
+      batch.push_back(
+          {static_cast<char*>(slab->ptr) + i * slab->object_size, slab});
+    }
+  }
+  *result = batch.back();
+  batch.pop_back();
+
+  // Keep at most one batch in the shard; a new slab of small objects has
+  // many more.
+  const size_t num_to_depot =
+      batch.size() > kSlabCacheBatchSize ? batch.size() - kSlabCacheBatchSize
+                                         : 0;
+  if (num_to_depot > 0) {
+    mutex_lock l(slab_depot_mu_);
+    std::vector<SlabObject>& depot = slab_depot_[size_class];
+    depot.insert(depot.end(), batch.begin(), batch.begin() + num_to_depot);
+  }
+  if (batch.size() > num_to_depot) {
+    mutex_lock l(shard->mu);
+    std::vector<SlabObject>& free_objects = shard->free_objects[size_class];
+    free_objects.insert(free_objects.end(), batch.begin() + num_to_depot,
+                        batch.end());
+  }
+  return true;
+}
+
+BFCAllocator::Slab* BFCAllocator::NewSlab(int size_class) {
+  {
+    mutex_lock l(slab_mu_);
+    if (slab_bytes_ + static_cast<int64>(kSlabSize) > slab_cache_limit_) {
+      return nullptr;
+    }
+    slab_bytes_ += kSlabSize;
+  }
+  void* ptr = AllocateSlabChunk();
+  if (ptr == nullptr) {
+    mutex_lock l(slab_mu_);
+    slab_bytes_ -= kSlabSize;
+    return nullptr;
+  }
+
+  auto slab = absl::make_unique<Slab>();
+  slab->ptr = ptr;
+  slab->object_size = kMinAllocationSize << size_class;
+  slab->num_objects = kSlabSize / slab->object_size;
+  slab->requested_sizes.reset(new size_t[slab->num_objects]());
+  slab->allocation_ids.reset(new int64[slab->num_objects]);
+  std::fill_n(slab->allocation_ids.get(), slab->num_objects, -1);
+  VLOG(2) << "New slab at " << ptr << " for objects of "
+          << slab->object_size << " bytes";
+
+  Slab* result = slab.get();
+  mutex_lock l(slab_mu_);
+  auto it = std::upper_bound(
+      slabs_.begin(), slabs_.end(), ptr,
+      [](const void* p, const std::unique_ptr<Slab>& s) { return p < s->ptr; });
+  slabs_.insert(it, std::move(slab));
+  return result;
+}
+
+BFCAllocator::Slab* BFCAllocator::FindSlab(const void* ptr) const {
+  tf_shared_lock l(slab_mu_);
+  auto it = std::upper_bound(
+      slabs_.begin(), slabs_.end(), ptr,
+      [](const void* p, const std::unique_ptr<Slab>& s) { return p < s->ptr; });
+  if (it == slabs_.begin()) {
+    return nullptr;
+  }
+  --it;
+  if (ptr >= static_cast<const char*>((*it)->ptr) + kSlabSize) {
+    return nullptr;
+  }
+  return it->get();
+}
+
+bool BFCAllocator::ReleaseFreeRegions() {
+  std::vector<void*> free_regions;
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    const Chunk* c = ChunkFromHandle(region_manager_.get_handle(region.ptr()));
+    // Chunks held out by the timestamping are not in a bin, and may still
+    // be in use by the GPU.
+    if (!c->in_use() && c->bin_num != kInvalidBinNum &&
+        c->size == region.memory_size()) {
+      free_regions.push_back(region.ptr());
+    }
+  }
+  for (void* ptr : free_regions) {
+    ChunkHandle h = region_manager_.get_handle(ptr);
+    const size_t bytes = ChunkFromHandle(h)->size;
+    RemoveFreeChunkFromBin(h);
+    DeleteChunk(h);
+    region_manager_.RemoveAllocationRegion(ptr);
+    sub_allocator_->Free(ptr, bytes);
+    total_region_allocated_bytes_ -= bytes;
+    VLOG(1) << "Released free region of "
+            << strings::HumanReadableNumBytes(bytes) << " at " << ptr;
+  }
+  return !free_regions.empty();
+}
+
+bool BFCAllocator::ReleaseFreeSlabs() NO_THREAD_SAFETY_ANALYSIS {
+  if (slab_cache_limit_ == 0) {
+    return false;
+  }
+  mutex_lock slab_lock(slab_mu_);
+  if (slabs_.empty()) {
+    return false;
+  }
+  mutex_lock depot_lock(slab_depot_mu_);
+  for (int i = 0; i < kNumSlabCacheShards; ++i) {
+    slab_cache_shards_[i].mu.lock();
+  }
+
+  // A slab is entirely free iff all of its objects are on some free list.
+  std::unordered_map<const Slab*, int> num_free;
+  auto count_free = [&num_free](const std::vector<SlabObject>& objects) {
+    for (const SlabObject& object : objects) {
+      ++num_free[object.slab];
+    }
+  };
+  for (int c = 0; c < kNumSizeClasses; ++c) {
+    count_free(slab_depot_[c]);
+    for (int i = 0; i < kNumSlabCacheShards; ++i) {
+      count_free(slab_cache_shards_[i].free_objects[c]);
+    }
+  }
+  std::unordered_set<const Slab*> to_release;
+  for (const auto& slab : slabs_) {
+    if (num_free[slab.get()] == slab->num_objects) {
+      to_release.insert(slab.get());
+    }
+  }
+
+  if (!to_release.empty()) {
+    auto remove_released = [&to_release](std::vector<SlabObject>* objects) {
+      objects->erase(std::remove_if(objects->begin(), objects->end(),
+                                    [&to_release](const SlabObject& object) {
+                                      return to_release.count(object.slab) > 0;
+                                    }),
+                     objects->end());
+    };
+    for (int c = 0; c < kNumSizeClasses; ++c) {
+      remove_released(&slab_depot_[c]);
+      for (int i = 0; i < kNumSlabCacheShards; ++i) {
+        remove_released(&slab_cache_shards_[i].free_objects[c]);
+      }
+    }
+    auto it = slabs_.begin();
+    while (it != slabs_.end()) {
+      if (to_release.count(it->get()) > 0) {
+        BFCAllocator::ChunkHandle h = region_manager_.get_handle((*it)->ptr);
+        CHECK(h != kInvalidChunkHandle);
+        ReturnChunk(h, false);
+        slab_bytes_ -= kSlabSize;
+        it = slabs_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    VLOG(1) << "Released " << to_release.size() << " free slabs";
+  }
+
+  for (int i = 0; i < kNumSlabCacheShards; ++i) {
+    slab_cache_shards_[i].mu.unlock();
+  }
+  return !to_release.empty();
+}
+
 bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  if (slab_cache_limit_ > 0) {
+    const Slab* slab = FindSlab(ptr);
+    if (slab != nullptr) {
+      return slab->requested_sizes[slab->IndexFor(ptr)];
+    }
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -665,6 +1076,12 @@ size_t BFCAllocator::RequestedSize(const void* ptr) const {
 }
 
 size_t BFCAllocator::AllocatedSize(const void* ptr) const {
+  if (slab_cache_limit_ > 0) {
+    const Slab* slab = FindSlab(ptr);
+    if (slab != nullptr) {
+      return slab->object_size;
+    }
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -674,6 +1091,12 @@ size_t BFCAllocator::AllocatedSize(const void* ptr) const {
 }
 
 int64 BFCAllocator::AllocationId(const void* ptr) const {
+  if (slab_cache_limit_ > 0) {
+    const Slab* slab = FindSlab(ptr);
+    if (slab != nullptr) {
+      return slab->allocation_ids[slab->IndexFor(ptr)];
+    }
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -821,19 +1244,97 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
             << (memory_limit_ - total_region_allocated_bytes_)
             << " curr_region_allocation_bytes_: "
             << curr_region_allocation_bytes_;
-  LOG(INFO) << "Stats: \n" << stats_.DebugString();
+  if (slab_cache_limit_ > 0) {
+    mutex_lock l(slab_mu_);
+    LOG(INFO) << "Slab cache: " << slabs_.size() << " slabs holding "
+              << strings::HumanReadableNumBytes(slab_bytes_) << " of "
+              << strings::HumanReadableNumBytes(slab_cache_limit_) << ", "
+              << strings::HumanReadableNumBytes(
+                     slab_bytes_in_use_.load(std::memory_order_relaxed))
+              << " in use.";
+  }
+  LOG(INFO) << "Stats: \n" << GetStatsLocked().DebugString();
 }
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  return GetStatsLocked();
+}
+
+AllocatorStats BFCAllocator::GetStatsLocked() {
+  AllocatorStats stats = stats_;
+  // Free memory in the regions, and the largest part of it that a single
+  // allocation can use.  The bins hold free chunks by increasing size.
+  stats.bytes_free = total_region_allocated_bytes_ - stats_.bytes_in_use;
+  for (BinNum b = kNumBins - 1; b >= 0; --b) {
+    const Bin* bin = BinFromIndex(b);
+    if (!bin->free_chunks.empty()) {
+      stats.largest_free_block_size =
+          ChunkFromHandle(*bin->free_chunks.rbegin())->size;
+      break;
+    }
+  }
+  if (slab_cache_limit_ > 0) {
+    stats.num_allocs += slab_num_allocs_.load(std::memory_order_relaxed);
+    stats.bytes_in_use += slab_bytes_in_use_.load(std::memory_order_relaxed);
+    stats.peak_bytes_in_use = std::max(
+        {stats.peak_bytes_in_use, stats.bytes_in_use,
+         slab_peak_bytes_in_use_.load(std::memory_order_relaxed)});
+    stats.largest_alloc_size =
+        std::max(stats.largest_alloc_size,
+                 slab_largest_alloc_size_.load(std::memory_order_relaxed));
+  }
+  return stats;
+}
+
+MemoryFragmentation BFCAllocator::GetFragmentationLocked() {
+  const AllocatorStats stats = GetStatsLocked();
+  MemoryFragmentation fragmentation;
+  fragmentation.micros = Env::Default()->NowMicros();
+  fragmentation.bytes_reserved = total_region_allocated_bytes_;
+  fragmentation.bytes_in_use = stats.bytes_in_use;
+  fragmentation.bytes_free = stats.bytes_free;
+  fragmentation.largest_free_chunk = stats.largest_free_block_size;
+  const std::array<BinDebugInfo, kNumBins> bin_infos = get_bin_debug_info();
+  for (BinNum b = 0; b < kNumBins; ++b) {
+    const BinDebugInfo& bin_info = bin_infos[b];
+    if (bin_info.total_chunks_in_bin == 0) continue;
+    MemoryFragmentation::Bin bin;
+    bin.bin_size = BinNumToSize(b);
+    bin.num_chunks = bin_info.total_chunks_in_bin;
+    bin.num_chunks_in_use = bin_info.total_chunks_in_use;
+    bin.bytes = bin_info.total_bytes_in_bin;
+    bin.bytes_in_use = bin_info.total_bytes_in_use;
+    bin.requested_bytes_in_use = bin_info.total_requested_bytes_in_use;
+    fragmentation.bins.push_back(bin);
+  }
+  return fragmentation;
+}
+
+absl::optional<MemoryProfile> BFCAllocator::GetMemoryProfile() {
+  if (memory_profiler_ == nullptr) {
+    return absl::nullopt;
+  }
+  mutex_lock l(lock_);
+  return GetMemoryProfileLocked();
+}
+
+MemoryProfile BFCAllocator::GetMemoryProfileLocked() {
+  MemoryProfile profile = memory_profiler_->GetProfile();
+  profile.fragmentation = GetFragmentationLocked();
+  return profile;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
   stats_.num_allocs = 0;
-  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.peak_bytes_in_use =
+      stats_.bytes_in_use + slab_bytes_in_use_.load(std::memory_order_relaxed);
   stats_.largest_alloc_size = 0;
+  slab_num_allocs_.store(0, std::memory_order_relaxed);
+  slab_peak_bytes_in_use_.store(stats_.peak_bytes_in_use,
+                                std::memory_order_relaxed);
+  slab_largest_alloc_size_.store(0, std::memory_order_relaxed);
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
@@ -24,6 +26,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
+#include "tensorflow/core/common_runtime/memory_profiler.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
@@ -43,6 +46,22 @@ namespace tensorflow {
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If the environment variable TF_BFC_ALLOCATOR_SLAB_CACHE_BYTES is set to a
+// positive value, small allocations are served by a slab cache in front of
+// the bins that holds at most that many bytes; see "Slab cache" below.
+//
+// If the environment variable TF_BFC_ALLOCATOR_RELEASE_FREE_REGIONS is true,
+// an allocation that fails for lack of a large enough free chunk returns the
+// regions whose memory is all free to the sub-allocator and reserves the
+// memory again as one region.  This undoes the fragmentation of allow_growth
+// allocators, whose free memory may otherwise be split across many regions.
+//
+// If the environment variable TF_BFC_ALLOCATOR_MEMORY_PROFILE_EVENTS is set to
+// a positive value, the allocator records a memory profile (see
+// MemoryProfiler) with a timeline of that many of the most recent allocations
+// and deallocations. The profile is logged when an allocation fails and is
+// returned by GetMemoryProfile().
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
@@ -77,13 +96,25 @@ class BFCAllocator : public Allocator {
 
   void SetSafeFrontier(uint64 count) override;
 
+  // Returns the memory profile recorded so far, or nothing if the allocator
+  // does not record one.
+  absl::optional<MemoryProfile> GetMemoryProfile();
+
  private:
   struct Bin;
 
+  void* AllocateRawUnprofiled(size_t alignment, size_t num_bytes,
+                              const AllocationAttributes& allocation_attr);
+
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure,
                             uint64 freed_before_count);
 
+  // Allocates a kSlabSize chunk for the slab cache. The chunk is not
+  // accounted for in stats_; its objects are accounted for when they are
+  // handed out.
+  void* AllocateSlabChunk();
+
   void* AllocateRawInternalWithRetry(
       size_t alignment, size_t num_bytes,
       const AllocationAttributes& allocation_attr);
@@ -318,6 +349,15 @@ class BFCAllocator : public Allocator {
     }
     void erase(const void* p) { return MutableRegionFor(p)->erase(p); }
 
+    void RemoveAllocationRegion(const void* ptr) {
+      auto entry = std::find_if(regions_.begin(), regions_.end(),
+                                [ptr](const AllocationRegion& region) {
+                                  return region.ptr() == ptr;
+                                });
+      CHECK(entry != regions_.end()) << "Could not find Region for " << ptr;
+      regions_.erase(entry);
+    }
+
     const std::vector<AllocationRegion>& regions() const { return regions_; }
 
    private:
@@ -355,9 +395,10 @@ class BFCAllocator : public Allocator {
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Returns a pointer to an underlying allocated chunk of size
-  // 'rounded_bytes'.
+  // 'rounded_bytes'. Updates stats_ iff 'track_stats' is true.
   void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes,
-                     uint64 freed_before) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+                     uint64 freed_before, bool track_stats = true)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Splits the chunk specified by 'h' into two chunks, one at least
   // of size 'num_bytes'.
@@ -398,7 +439,13 @@ class BFCAllocator : public Allocator {
   const Chunk* ChunkFromHandle(ChunkHandle h) const
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
-  void MarkFree(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Marks the chunk 'h' as free. Updates stats_ iff 'track_stats' is true.
+  void MarkFree(ChunkHandle h, bool track_stats = true)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Marks the in-use chunk 'h' as free and returns it to the bins.
+  void ReturnChunk(ChunkHandle h, bool track_stats)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   ChunkHandle TryToCoalesce(ChunkHandle h, bool ignore_freed_at)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
@@ -416,6 +463,88 @@ class BFCAllocator : public Allocator {
   std::array<BinDebugInfo, kNumBins> get_bin_debug_info()
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Slab cache.
+  //
+  // Allocations of at most kMaxSlabObjectSize bytes that carry no
+  // freed_by_func requirement are rounded up to one of kNumSizeClasses
+  // power-of-two size classes and served from slabs: kSlabSize chunks taken
+  // from the bins and carved into equal objects. Free objects are cached in
+  // kNumSlabCacheShards shards, each shared by a group of threads, and moved
+  // between the shards and a shared depot kSlabCacheBatchSize at a time. An
+  // allocation or deallocation thus usually takes only an uncontended shard
+  // lock; lock_ is only taken to get a new slab.
+  //
+  // The slabs hold at most slab_cache_limit_ bytes. Slabs are given back to
+  // the bins when all of their objects are free and an allocation could not
+  // be satisfied otherwise, and when the allocator is destroyed.
+  //
+  // Lock order: lock_, slab_mu_, slab_depot_mu_, SlabCacheShard::mu.
+  static const size_t kMaxSlabObjectSize = 4096;
+  static const int kNumSizeClasses = 5;
+  static const size_t kSlabSize = 64 << 10;
+  static const int kNumSlabCacheShards = 16;
+  static const int kSlabCacheBatchSize = 32;
+
+  struct Slab {
+    void* ptr = nullptr;
+    size_t object_size = 0;
+    int num_objects = 0;
+    // Indexed by object. Written and read by whoever owns the object.
+    std::unique_ptr<size_t[]> requested_sizes;
+    std::unique_ptr<int64[]> allocation_ids;
+
+    int IndexFor(const void* p) const {
+      return (static_cast<const char*>(p) - static_cast<const char*>(ptr)) /
+             object_size;
+    }
+  };
+
+  struct SlabObject {
+    void* ptr;
+    Slab* slab;
+  };
+
+  struct SlabCacheShard {
+    mutex mu;
+    std::vector<SlabObject> free_objects[kNumSizeClasses] GUARDED_BY(mu);
+  };
+
+  static int SizeClassForBytes(size_t num_bytes);
+
+  // Returns nullptr if no slab has room and no new slab can be made.
+  void* AllocateFromSlabCache(size_t num_bytes);
+
+  // Returns false if 'ptr' was not allocated from the slab cache.
+  bool DeallocateToSlabCache(void* ptr);
+
+  // Gets free objects of 'size_class' from the depot, or from a new slab,
+  // into 'shard', and pops one of them into '*result'.
+  bool RefillSlabCache(SlabCacheShard* shard, int size_class,
+                       SlabObject* result);
+
+  Slab* NewSlab(int size_class);
+
+  // Returns the slab that contains 'ptr', or nullptr if there is none.
+  Slab* FindSlab(const void* ptr) const;
+
+  // Returns all slabs whose objects are all free to the bins. Returns true if
+  // any slab was returned.
+  bool ReleaseFreeSlabs() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the regions whose memory is all in one free chunk to the
+  // sub-allocator. Returns true if any region was returned.
+  bool ReleaseFreeRegions() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  SlabCacheShard* CurrentSlabCacheShard();
+
+  // Returns stats_ with the slab cache stats merged in.
+  AllocatorStats GetStatsLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Describes the chunks in the bins.
+  MemoryFragmentation GetFragmentationLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  MemoryProfile GetMemoryProfileLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   AllocatorRetry retry_helper_;
 
   // Structures immutable after construction
@@ -486,11 +615,36 @@ class BFCAllocator : public Allocator {
   ChunkHandle free_chunks_list_ GUARDED_BY(lock_);
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ GUARDED_BY(lock_);
+  // newly-created chunk or slab object.
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
+  // Mirrors stats_.bytes_in_use so the slab cache can track the peak.
+  std::atomic<int64> bfc_bytes_in_use_{0};
+
+  // Slab cache state. A limit of 0 disables the slab cache.
+  int64 slab_cache_limit_ = 0;
+
+  // Whether ReleaseFreeRegions() is tried when an allocation fails.
+  bool release_free_regions_ = false;
+  mutable mutex slab_mu_;
+  // Sorted by ptr.
+  std::vector<std::unique_ptr<Slab>> slabs_ GUARDED_BY(slab_mu_);
+  int64 slab_bytes_ GUARDED_BY(slab_mu_) = 0;
+  mutex slab_depot_mu_;
+  std::vector<SlabObject> slab_depot_[kNumSizeClasses] GUARDED_BY(
+      slab_depot_mu_);
+  std::unique_ptr<SlabCacheShard[]> slab_cache_shards_;
+
+  // Slab cache stats, merged into stats_ by GetStats().
+  std::atomic<int64> slab_num_allocs_{0};
+  std::atomic<int64> slab_bytes_in_use_{0};
+  std::atomic<int64> slab_peak_bytes_in_use_{0};
+  std::atomic<int64> slab_largest_alloc_size_{0};
+
+  // Null unless a memory profile is recorded.
+  std::unique_ptr<MemoryProfiler> memory_profiler_;
 
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
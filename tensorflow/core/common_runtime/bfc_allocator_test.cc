@@ -0,0 +1,311 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+const char kSlabCacheBytes[] = "TF_BFC_ALLOCATOR_SLAB_CACHE_BYTES";
+
+std::unique_ptr<BFCAllocator> NewCPUBFCAllocator(size_t total_memory) {
+  return absl::make_unique<BFCAllocator>(
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}), total_memory,
+      /*allow_growth=*/false, "cpu_bfc");
+}
+
+class BFCAllocatorSlabCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override { CHECK_EQ(setenv(kSlabCacheBytes, "1048576", 1), 0); }
+  void TearDown() override { CHECK_EQ(unsetenv(kSlabCacheBytes), 0); }
+};
+
+TEST_F(BFCAllocatorSlabCacheTest, SmallAllocationsUseSizeClasses) {
+  auto a = NewCPUBFCAllocator(1 << 20);
+  void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 300);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ(300, a->RequestedSize(p));
+  EXPECT_EQ(512, a->AllocatedSize(p));
+  EXPECT_GT(a->AllocationId(p), 0);
+
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(1, stats->num_allocs);
+  EXPECT_EQ(512, stats->bytes_in_use);
+  EXPECT_EQ(512, stats->peak_bytes_in_use);
+  EXPECT_EQ(512, stats->largest_alloc_size);
+
+  a->DeallocateRaw(p);
+  stats = a->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(512, stats->peak_bytes_in_use);
+
+  // The object just freed is reused first.
+  void* q = a->AllocateRaw(Allocator::kAllocatorAlignment, 400);
+  EXPECT_EQ(p, q);
+  a->DeallocateRaw(q);
+
+  a->ClearStats();
+  stats = a->GetStats();
+  EXPECT_EQ(0, stats->num_allocs);
+  EXPECT_EQ(0, stats->peak_bytes_in_use);
+  EXPECT_EQ(0, stats->largest_alloc_size);
+}
+
+TEST_F(BFCAllocatorSlabCacheTest, DistinctObjects) {
+  auto a = NewCPUBFCAllocator(1 << 20);
+  std::vector<void*> ptrs;
+  for (int s = 1; s <= 4096; s += 37) {
+    void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, s);
+    ASSERT_NE(nullptr, p);
+    ptrs.push_back(p);
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (size_t i = 1; i < ptrs.size(); ++i) {
+    ASSERT_NE(ptrs[i], ptrs[i - 1]);
+    ASSERT_GE(static_cast<size_t>(static_cast<char*>(ptrs[i]) -
+                                  static_cast<char*>(ptrs[i - 1])),
+              a->AllocatedSize(ptrs[i - 1]));
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+}
+
+TEST_F(BFCAllocatorSlabCacheTest, LargeAllocationsBypassSlabCache) {
+  auto a = NewCPUBFCAllocator(1 << 20);
+  void* small = a->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  void* large = a->AllocateRaw(Allocator::kAllocatorAlignment, 8192);
+  ASSERT_NE(nullptr, small);
+  ASSERT_NE(nullptr, large);
+  EXPECT_EQ(8192, a->AllocatedSize(large));
+
+  // The slab backing 'small' is not reported as in use.
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(256 + 8192, stats->bytes_in_use);
+  EXPECT_EQ(8192, stats->largest_alloc_size);
+  a->DeallocateRaw(small);
+  a->DeallocateRaw(large);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+}
+
+TEST_F(BFCAllocatorSlabCacheTest, ReleasesFreeSlabsWhenOutOfMemory) {
+  // Fill the whole allocator with 4KiB objects, free them, and check that
+  // the memory can then be used for one large allocation.
+  auto a = NewCPUBFCAllocator(1 << 20);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 256; ++i) {
+    void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+    ASSERT_NE(nullptr, p);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  AllocationAttributes attrs;
+  attrs.no_retry_on_failure = true;
+  void* large = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 19, attrs);
+  ASSERT_NE(nullptr, large);
+  a->DeallocateRaw(large);
+}
+
+TEST_F(BFCAllocatorSlabCacheTest, ConcurrentAllocations) {
+  auto a = NewCPUBFCAllocator(1 << 26);
+  const int kNumThreads = 8;
+  const int kNumIterations = 2000;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&a, t]() {
+        random::PhiloxRandom philox(123, t);
+        random::SimplePhilox rand(&philox);
+        std::vector<void*> ptrs;
+        for (int i = 0; i < kNumIterations; ++i) {
+          if (ptrs.empty() || rand.OneIn(2)) {
+            const size_t size = 1 + rand.Uniform(8192);
+            void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, size);
+            CHECK(p != nullptr);
+            CHECK_EQ(size, a->RequestedSize(p));
+            memset(p, t, size);
+            ptrs.push_back(p);
+          } else {
+            const int index = rand.Uniform(ptrs.size());
+            a->DeallocateRaw(ptrs[index]);
+            ptrs[index] = ptrs.back();
+            ptrs.pop_back();
+          }
+        }
+        for (void* p : ptrs) {
+          a->DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_GT(stats->peak_bytes_in_use, 0);
+}
+
+const char kReleaseFreeRegions[] = "TF_BFC_ALLOCATOR_RELEASE_FREE_REGIONS";
+
+// Leaves a 4MiB allocator with free regions of 1MiB and 2MiB.
+std::unique_ptr<BFCAllocator> NewFragmentedAllocator() {
+  auto a = absl::make_unique<BFCAllocator>(
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}), 4 << 20,
+      /*allow_growth=*/true, "cpu_bfc");
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 2 << 20);
+  CHECK(p1 != nullptr);
+  CHECK(p2 != nullptr);
+  a->DeallocateRaw(p1);
+  a->DeallocateRaw(p2);
+  return a;
+}
+
+TEST(BFCAllocatorTest, ReportsFragmentation) {
+  auto a = NewFragmentedAllocator();
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(3 << 20, stats->bytes_free);
+  EXPECT_EQ(2 << 20, stats->largest_free_block_size);
+}
+
+TEST(BFCAllocatorTest, FragmentedAllocationFailsByDefault) {
+  auto a = NewFragmentedAllocator();
+  AllocationAttributes attrs;
+  attrs.no_retry_on_failure = true;
+  EXPECT_EQ(nullptr,
+            a->AllocateRaw(Allocator::kAllocatorAlignment, 3 << 20, attrs));
+}
+
+TEST(BFCAllocatorTest, ReleasesFreeRegionsWhenOutOfMemory) {
+  CHECK_EQ(setenv(kReleaseFreeRegions, "true", 1), 0);
+  auto a = NewFragmentedAllocator();
+  CHECK_EQ(unsetenv(kReleaseFreeRegions), 0);
+  AllocationAttributes attrs;
+  attrs.no_retry_on_failure = true;
+  void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 3 << 20, attrs);
+  ASSERT_NE(nullptr, p);
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(3 << 20, stats->bytes_in_use);
+  EXPECT_EQ(1 << 20, stats->bytes_free);
+  a->DeallocateRaw(p);
+}
+
+const char kMemoryProfileEvents[] = "TF_BFC_ALLOCATOR_MEMORY_PROFILE_EVENTS";
+
+TEST(BFCAllocatorTest, NoMemoryProfileByDefault) {
+  EXPECT_FALSE(NewCPUBFCAllocator(1 << 20)->GetMemoryProfile());
+}
+
+TEST(BFCAllocatorTest, RecordsMemoryProfile) {
+  CHECK_EQ(setenv(kMemoryProfileEvents, "3", 1), 0);
+  auto a = NewCPUBFCAllocator(1 << 20);
+  CHECK_EQ(unsetenv(kMemoryProfileEvents), 0);
+  void* p1;
+  void* p2;
+  {
+    ScopedMemoryDebugAnnotation annotation("op1", 7);
+    p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+    p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  }
+  a->DeallocateRaw(p1);
+  void* p3 = a->AllocateRaw(Allocator::kAllocatorAlignment, 512);
+  a->DeallocateRaw(p2);
+  a->DeallocateRaw(p3);
+  AllocationAttributes attrs;
+  attrs.no_retry_on_failure = true;
+  EXPECT_EQ(nullptr,
+            a->AllocateRaw(Allocator::kAllocatorAlignment, 2 << 20, attrs));
+
+  absl::optional<MemoryProfile> profile = a->GetMemoryProfile();
+  ASSERT_TRUE(profile);
+  EXPECT_EQ(6, profile->num_events);
+  // Only the last three events fit in the timeline.
+  ASSERT_EQ(3, profile->timeline.size());
+  EXPECT_TRUE(profile->timeline[0].is_allocation);
+  EXPECT_EQ(512, profile->timeline[0].bytes);
+  EXPECT_EQ(2560, profile->timeline[0].bytes_in_use);
+  EXPECT_EQ("(unknown)", profile->timeline[0].op_name);
+  EXPECT_FALSE(profile->timeline[1].is_allocation);
+  EXPECT_EQ(2048, profile->timeline[1].bytes);
+  EXPECT_EQ("op1", profile->timeline[1].op_name);
+  EXPECT_EQ(7, profile->timeline[1].step_id);
+  EXPECT_EQ(0, profile->timeline[2].bytes_in_use);
+
+  EXPECT_EQ(3072, profile->peak_bytes_in_use);
+  EXPECT_EQ(7, profile->peak_step_id);
+  ASSERT_EQ(1, profile->live_at_peak.size());
+  EXPECT_EQ("op1", profile->live_at_peak[0].op_name);
+  EXPECT_EQ(3072, profile->live_at_peak[0].bytes);
+  EXPECT_EQ(2, profile->live_at_peak[0].num_allocations);
+
+  EXPECT_EQ(1 << 20, profile->fragmentation.bytes_reserved);
+  EXPECT_EQ(0, profile->fragmentation.bytes_in_use);
+  EXPECT_EQ(1 << 20, profile->fragmentation.largest_free_chunk);
+  EXPECT_EQ(0.0, profile->fragmentation.fragmentation());
+  EXPECT_EQ(1, profile->num_failed_allocations);
+  EXPECT_EQ(2 << 20, profile->last_failed_allocation_bytes);
+}
+
+void BM_SmallAllocations(int iters, int num_threads, int use_slab_cache) {
+  testing::StopTiming();
+  CHECK_EQ(setenv(kSlabCacheBytes, use_slab_cache ? "16777216" : "0", 1), 0);
+  auto a = NewCPUBFCAllocator(1 << 28);
+  CHECK_EQ(unsetenv(kSlabCacheBytes), 0);
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+  testing::StartTiming();
+  BlockingCounter counter(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    pool.Schedule([&a, &counter, iters]() {
+      void* ptrs[16];
+      for (int i = 0; i < iters; ++i) {
+        for (int j = 0; j < 16; ++j) {
+          ptrs[j] =
+              a->AllocateRaw(Allocator::kAllocatorAlignment, 64 << (j % 6));
+        }
+        for (int j = 0; j < 16; ++j) {
+          a->DeallocateRaw(ptrs[j]);
+        }
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+}
+BENCHMARK(BM_SmallAllocations)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1);
+
+}  // namespace
+}  // namespace tensorflow
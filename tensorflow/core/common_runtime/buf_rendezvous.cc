@@ -21,28 +21,38 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/hash/hash.h"
 
 namespace tensorflow {
 
 BufRendezvous::~BufRendezvous() {
-  mutex_lock l(mu_);
-  if (!hook_table_.empty()) {
-    PurgeTable(errors::Internal("Delete called on non-empty BufRendezvous"),
-               &hook_table_);
+  for (Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    if (!shard.hook_table.empty()) {
+      PurgeTable(errors::Internal("Delete called on non-empty BufRendezvous"),
+                 &shard.hook_table);
+    }
   }
 }
 
+BufRendezvous::Shard* BufRendezvous::GetShard(const string& key) {
+  return &shards_[Hash64(key) % kNumShards];
+}
+
 void BufRendezvous::StartAbort(const Status& s) {
   CHECK(!s.ok());
   HookTable dummy_table;
-  {
-    mutex_lock l(mu_);
+  for (Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
     // Use a "derived" status as the status for the rendezvous. Derived
     // status messages are ignored when aggregating errors across devices: this
     // allows us to prefer our original status message over any cancellation
     // related errors.
-    status_.Update(StatusGroup::MakeDerived(s));
-    hook_table_.swap(dummy_table);
+    shard.status.Update(StatusGroup::MakeDerived(s));
+    for (auto& it : shard.hook_table) {
+      dummy_table.insert(it);
+    }
+    shard.hook_table.clear();
   }
   PurgeTable(s, &dummy_table);
 }
@@ -75,16 +85,17 @@ void BufRendezvous::ProvideBuf(const string& key, Device* dev,
                                const ProducerCallback& done) {
   Hook* h = nullptr;
   Status providebuf_status;
+  Shard* shard = GetShard(key);
   do {
-    mutex_lock l(mu_);
-    if (!status_.ok()) {
-      providebuf_status = status_;
+    mutex_lock l(shard->mu);
+    if (!shard->status.ok()) {
+      providebuf_status = shard->status;
       break;
     } else {
-      auto it = hook_table_.find(key);
-      if (it == hook_table_.end()) {
+      auto it = shard->hook_table.find(key);
+      if (it == shard->hook_table.end()) {
         h = new Hook;
-        it = hook_table_.insert(std::make_pair(key, h)).first;
+        it = shard->hook_table.insert(std::make_pair(key, h)).first;
       } else {
         if (it->second->prod_cb != nullptr) {
           providebuf_status = errors::Internal(
@@ -101,7 +112,7 @@ void BufRendezvous::ProvideBuf(const string& key, Device* dev,
       h->prod_cb = done;
       // If consumer is waiting, kick off right away, removing Hook from table.
       if (h->cons_cb != nullptr) {
-        hook_table_.erase(it);
+        shard->hook_table.erase(it);
       } else {
         h = nullptr;
       }
@@ -137,14 +148,15 @@ void BufRendezvous::ConsumeBuf(const string& key, const string& device_name,
   }
 
   Hook* existing_hook = nullptr;
+  Shard* shard = GetShard(key);
   do {
-    mutex_lock l(mu_);
-    if (!status_.ok()) {
-      consumebuf_status = status_;
+    mutex_lock l(shard->mu);
+    if (!shard->status.ok()) {
+      consumebuf_status = shard->status;
       break;
     }
-    auto it = hook_table_.find(key);
-    if (it != hook_table_.end()) {
+    auto it = shard->hook_table.find(key);
+    if (it != shard->hook_table.end()) {
       // Prepare to consume immediately.
       if (it->second->cons_cb) {
         consumebuf_status =
@@ -152,12 +164,12 @@ void BufRendezvous::ConsumeBuf(const string& key, const string& device_name,
         break;
       }
       existing_hook = it->second;
-      hook_table_.erase(it);
+      shard->hook_table.erase(it);
       existing_hook->cons_cb = done;
     } else {
       // Hang consumer callback on the Hook.
       Hook* h = new Hook;
-      hook_table_[key] = h;
+      shard->hook_table[key] = h;
       h->cons_cb = done;
       return;
     }
@@ -179,12 +191,14 @@ void BufRendezvous::DoneWithHook(Hook* h) {
 }
 
 void BufRendezvous::LogContents() {
-  mutex_lock l(mu_);
   LOG(INFO) << strings::StrCat("BufRendezvous ",
                                strings::Hex(reinterpret_cast<uint64>(this)),
                                " step_id=", step_id_, " current contents:");
-  for (auto it : hook_table_) {
-    LOG(INFO) << it.first << ":" << it.second->DebugString();
+  for (Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    for (auto it : shard.hook_table) {
+      LOG(INFO) << it.first << ":" << it.second->DebugString();
+    }
   }
 }
 
@@ -100,12 +100,25 @@ class BufRendezvous {
   void LogContents();
 
  protected:
+  typedef absl::flat_hash_map<string, Hook*> HookTable;
+
+  // The hook table is split into independently locked shards, selected by
+  // a hash of the key, so that concurrent transfers between different
+  // device pairs (e.g. the chunks of a ring collective) do not all contend
+  // on one mutex.  Each shard carries its own copy of the abort status so
+  // that a Hook can never be added to a shard after StartAbort purged it.
+  static constexpr int kNumShards = 16;
+  struct Shard {
+    mutex mu;
+    Status status GUARDED_BY(mu);
+    HookTable hook_table GUARDED_BY(mu);
+  };
+
+  Shard* GetShard(const string& key);
+
   const uint64 step_id_;
   const DeviceMgr* const dev_mgr_;  // Not owned.
-  mutex mu_;
-  Status status_ GUARDED_BY(mu_);
-  typedef absl::flat_hash_map<string, Hook*> HookTable;
-  HookTable hook_table_ GUARDED_BY(mu_);
+  Shard shards_[kNumShards];
 
   void PurgeTable(const Status& s, HookTable* table);
 };
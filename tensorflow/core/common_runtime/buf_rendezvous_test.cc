@@ -14,11 +14,15 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
 
+#include <atomic>
+
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -205,6 +209,59 @@ TEST_F(BufRendezvousTest, AbortEmpty) {
   br_->StartAbort(errors::Internal("Falling sky detected"));
 }
 
+TEST_F(BufRendezvousTest, ConcurrentTransfers) {
+  const int kNumPairs = 8;
+  const int kKeysPerPair = 100;
+  std::atomic<int> num_consumed(0);
+  std::atomic<int> num_released(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 2 * kNumPairs);
+    for (int p = 0; p < kNumPairs; ++p) {
+      pool.Schedule([this, p, &num_released]() {
+        for (int k = 0; k < kKeysPerPair; ++k) {
+          br_->ProvideBuf(strings::StrCat("pair", p, ":", k), default_device_,
+                          fake_device_context_, &a_, aa_,
+                          [&num_released](const Status& s) {
+                            TF_EXPECT_OK(s);
+                            ++num_released;
+                          });
+        }
+      });
+      pool.Schedule([this, p, &num_consumed]() {
+        for (int k = 0; k < kKeysPerPair; ++k) {
+          br_->ConsumeBuf(strings::StrCat("pair", p, ":", k),
+                          *kDefaultDeviceName, kDefaultIncarnation,
+                          [this, &num_consumed](const Status& s,
+                                                BufRendezvous::Hook* h) {
+                            TF_EXPECT_OK(s);
+                            ASSERT_TRUE(h != nullptr);
+                            EXPECT_EQ(h->prod_value, &a_);
+                            ++num_consumed;
+                            br_->DoneWithHook(h);
+                          });
+        }
+      });
+    }
+  }
+  EXPECT_EQ(kNumPairs * kKeysPerPair, num_consumed);
+  EXPECT_EQ(kNumPairs * kKeysPerPair, num_released);
+}
+
+TEST_F(BufRendezvousTest, AbortPurgesAllKeys) {
+  const int kNumKeys = 64;
+  int num_aborted = 0;
+  for (int k = 0; k < kNumKeys; ++k) {
+    br_->ProvideBuf(strings::StrCat("key", k), default_device_,
+                    fake_device_context_, &a_, aa_,
+                    [&num_aborted](const Status& s) {
+                      EXPECT_FALSE(s.ok());
+                      ++num_aborted;
+                    });
+  }
+  br_->StartAbort(errors::Internal("Falling sky detected"));
+  EXPECT_EQ(kNumKeys, num_aborted);
+}
+
 TEST_F(BufRendezvousTest, UseAfterAbort) {
   br_->StartAbort(errors::Internal("Falling sky detected"));
   Status cons_status;
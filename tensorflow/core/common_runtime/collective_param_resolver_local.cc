@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/device_name_utils.h"
 
@@ -62,8 +63,19 @@ string GetCollectiveName(const CollectiveParams* cp, bool nccl) {
       return "HierarchicalTreeBroadcast";
 
     case REDUCTION_COLLECTIVE: {
-      if (nccl) {
+      if (cp->instance.wire_data_type != DT_INVALID) {
+        // Only the ring implementation supports a wire codec.
+        return "RingReduce";
+      } else if (nccl) {
         return "NcclReduce";
+      } else if (cp->group.device_type == DEVICE_GPU &&
+                 cp->group.num_tasks > 1 &&
+                 cp->instance.same_num_devices_per_task &&
+                 cp->group.group_size > cp->group.num_tasks) {
+        // Several GPUs on each of several tasks: reduce over the local links
+        // first, so that only 1/devices_per_task of the tensor crosses the
+        // network from each device.
+        return "HierarchicalRingReduce";
       } else {
         return "RingReduce";
       }
@@ -428,6 +440,20 @@ void SortDevicesAndTasks(CollectiveParams* cp) {
   VLOG(1) << "Modified device_names on " << cp;
   SetDevPerTask(cp);
 }
+
+// Returns a fingerprint of the inputs to CompleteDefaultRanking other than
+// the device localities, which don't change.
+uint64 RankingFingerprint(const CollectiveParams& shared) {
+  uint64 fp = Fingerprint64(shared.instance.gpu_ring_order);
+  fp = FingerprintCat64(fp, shared.group.group_key);
+  for (const string& device_name : shared.instance.device_names) {
+    fp = FingerprintCat64(fp, Fingerprint64(device_name));
+  }
+  for (const string& task_name : shared.instance.task_names) {
+    fp = FingerprintCat64(fp, Fingerprint64(task_name));
+  }
+  return fp;
+}
 }  // namespace
 
 void CollectiveParamResolverLocal::CompleteTaskIsLocal(const string& task_name,
@@ -477,6 +503,21 @@ void CollectiveParamResolverLocal::InitInstanceSharedParams(
   // GetDeviceAttributesAsync will use those fields to launch RPCs.
   CompleteTaskIsLocal(task_name_, &ir->shared);
 
+  // Reuse the ranking of an earlier instance of the same group, if any.
+  const uint64 ranking_fp = RankingFingerprint(ir->shared);
+  {
+    mutex_lock l(ranking_mu_);
+    auto it = ranking_cache_.find(ranking_fp);
+    if (it != ranking_cache_.end()) {
+      ir->shared.instance.device_names = it->second.device_names;
+      ir->shared.instance.task_names = it->second.task_names;
+      VLOG(2) << "Reusing device order for instance "
+              << ir->shared.instance.instance_key;
+      done(Status::OK());
+      return;
+    }
+  }
+
   // Because the callback may execute in a different thread, we release
   // ir->out_mu here.  Before releasing, we mark it as unavailable for other
   // threads.
@@ -491,7 +532,7 @@ void CollectiveParamResolverLocal::InitInstanceSharedParams(
       ir->shared.instance.device_names,  // NOLINT
       ir->shared.instance.task_names,    // NOLINT
       attributes,
-      [this, gr, cp, ir, attributes, done](const Status& s)
+      [this, gr, cp, ir, attributes, ranking_fp, done](const Status& s)
           EXCLUSIVE_LOCK_FUNCTION(ir->out_mu) {
             // Then we recover the lock in the callback thread that will hold it
             // through the rest of the call chain.  Signal the cv now, any
@@ -502,6 +543,12 @@ void CollectiveParamResolverLocal::InitInstanceSharedParams(
             ir->out_cv.notify_all();
             if (s.ok()) {
               CompleteDefaultRanking(gr, cp, ir, *attributes);
+              {
+                mutex_lock l(ranking_mu_);
+                InstanceRanking& ranking = ranking_cache_[ranking_fp];
+                ranking.device_names = ir->shared.instance.device_names;
+                ranking.task_names = ir->shared.instance.task_names;
+              }
               done(Status::OK());
             } else {
               done(s);
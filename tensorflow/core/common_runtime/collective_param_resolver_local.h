@@ -227,6 +227,12 @@ class CollectiveParamResolverLocal : public ParamResolverInterface {
   void CallbackWithStatus(const InstanceRecCallback& done, InstanceRec* irec)
       LOCKS_EXCLUDED(irec->out_mu);
 
+  // Device order established by CompleteDefaultRanking.
+  struct InstanceRanking {
+    std::vector<string> device_names;
+    std::vector<string> task_names;
+  };
+
   const bool nccl_;
   const DeviceMgr* dev_mgr_;
   DeviceResolverInterface* dev_resolver_;  // Not owned.
@@ -237,6 +243,11 @@ class CollectiveParamResolverLocal : public ParamResolverInterface {
   mutex instance_mu_;
   gtl::FlatMap<int32, std::unique_ptr<InstanceRec>> instance_table_
       GUARDED_BY(instance_mu_);
+  // Rankings keyed by a fingerprint of the group membership and ring order
+  // they were established for, so that later instances of the same group
+  // don't resolve the device localities again.
+  mutex ranking_mu_;
+  gtl::FlatMap<uint64, InstanceRanking> ranking_cache_ GUARDED_BY(ranking_mu_);
 };
 
 }  // namespace tensorflow
@@ -74,6 +74,11 @@ class CollectiveParamResolverLocalTest : public ::testing::Test {
     }
   }
 
+  size_t RankingCacheSize() {
+    mutex_lock l(prl_->ranking_mu_);
+    return prl_->ranking_cache_.size();
+  }
+
   std::unique_ptr<DeviceMgr> device_mgr_;
   std::unique_ptr<DeviceResolverLocal> drl_;
   std::unique_ptr<CollectiveParamResolverLocal> prl_;
@@ -201,6 +206,48 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
   }
 }
 
+TEST_F(CollectiveParamResolverLocalTest, ReusesRankingAcrossInstances) {
+  for (int instance_key : {7, 8}) {
+    CollectiveParams cps[NUM_DEVS];
+    Status statuses[NUM_DEVS];
+    Notification note[NUM_DEVS];
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      CollectiveParams* cp = &cps[i];
+      cp->group.group_key = 1;
+      cp->group.group_size = 3;
+      cp->group.device_type = DeviceType("CPU");
+      cp->group.num_tasks = 1;
+      cp->instance.instance_key = instance_key;
+      cp->instance.type = REDUCTION_COLLECTIVE;
+      cp->instance.data_type = DataType(DT_FLOAT);
+      cp->instance.shape = TensorShape({instance_key});
+      cp->instance.device_names.push_back(
+          strings::StrCat("/job:localhost/replica:0/task:0/device:CPU:", i));
+      cp->instance.impl_details.subdiv_offsets.push_back(0);
+      prl_->CompleteParamsAsync(cp->instance.device_names[0], cp,
+                                nullptr /*CancellationManager*/,
+                                [&statuses, &note, i](const Status& s) {
+                                  statuses[i] = s;
+                                  note[i].Notify();
+                                });
+    }
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      note[i].WaitForNotification();
+      TF_ASSERT_OK(statuses[i]);
+      ASSERT_EQ(cps[i].instance.device_names.size(), 3);
+      for (int j = 0; j < NUM_DEVS; ++j) {
+        EXPECT_EQ(
+            strings::StrCat("/job:localhost/replica:0/task:0/device:CPU:", j),
+            cps[i].instance.device_names[j]);
+      }
+      EXPECT_EQ(cps[i].instance.instance_key, instance_key);
+      EXPECT_EQ(cps[i].instance.shape, TensorShape({instance_key}));
+      EXPECT_EQ(cps[i].default_rank, i);
+    }
+    EXPECT_EQ(1, RankingCacheSize());
+  }
+}
+
 void InitializeCollectiveParamsForBroadcast(int instance_key, int device_idx,
                                             bool is_source,
                                             CollectiveParams* cp) {
@@ -110,5 +110,16 @@ Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
   return sub_ctx->sub_ctx_->status();
 }
 
+Status ComputeUnaryOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
+                      Device* device, OpKernel* op, Tensor* input,
+                      Tensor* output) {
+  std::unique_ptr<SubContext> sub_ctx(
+      new SubContext(op_ctx, params, op, input, input));
+  device->Compute(op, sub_ctx->sub_ctx_.get());
+  TF_RETURN_IF_ERROR(sub_ctx->sub_ctx_->status());
+  *output = *sub_ctx->sub_ctx_->mutable_output(0);
+  return Status::OK();
+}
+
 }  // namespace collective_util
 }  // namespace tensorflow
@@ -53,6 +53,12 @@ Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
                     Device* device, OpKernel* op, Tensor* output,
                     Tensor* input);
 
+// Applies a unary op that allocates its own output, e.g. a Cast, to input
+// and sets *output to the result.
+Status ComputeUnaryOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
+                      Device* device, OpKernel* op, Tensor* input,
+                      Tensor* output);
+
 }  // namespace collective_util
 }  // namespace tensorflow
 
@@ -0,0 +1,157 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+const char kCompilationPhaseSession[] = "session";
+const char kCompilationPhaseGrappler[] = "grappler";
+const char kCompilationPhaseFunction[] = "function";
+const char kCompilationPhaseXla[] = "xla";
+const char kCompilationPhaseHloPass[] = "hlo_pass";
+
+namespace {
+
+// This metric lives here rather than in metrics.cc so that Grappler, which
+// core_cpu depends on, and XLA can record to it.
+auto* compilation_phase_usecs = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/compilation_phase_usecs",
+     "The wall time of graph compilation phases in microseconds.", "kind",
+     "name"},
+    // Power of 2 with bucket count 30 (> 8 minutes).
+    {monitoring::Buckets::Exponential(1, 2, 30)});
+
+// Function and XLA phases are named after the function or cluster, so they
+// are aggregated by kind only to bound the number of metric cells.
+bool HasBoundedNames(const string& kind) {
+  return kind != kCompilationPhaseFunction && kind != kCompilationPhaseXla;
+}
+
+}  // namespace
+
+string CompilationReport::DebugString() const {
+  struct Summary {
+    int64 num_runs = 0;
+    int64 duration_micros = 0;
+    int64 node_delta = 0;
+    bool has_node_delta = false;
+  };
+  std::map<std::pair<string, string>, Summary> summaries;
+  for (const CompilationPhase& phase : phases) {
+    Summary& summary = summaries[{phase.kind, phase.name}];
+    ++summary.num_runs;
+    summary.duration_micros += phase.duration_micros;
+    if (phase.nodes_before >= 0 && phase.nodes_after >= 0) {
+      summary.node_delta += phase.nodes_after - phase.nodes_before;
+      summary.has_node_delta = true;
+    }
+  }
+  std::vector<std::pair<std::pair<string, string>, Summary>> sorted(
+      summaries.begin(), summaries.end());
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const std::pair<std::pair<string, string>, Summary>& a,
+                      const std::pair<std::pair<string, string>, Summary>& b) {
+                     return a.second.duration_micros >
+                            b.second.duration_micros;
+                   });
+
+  string result = strings::StrCat("Compilation phases (last ", phases.size(),
+                                  " of ", num_phases, "):\n");
+  for (const auto& entry : sorted) {
+    strings::StrAppend(&result, "  ", entry.first.first, " ",
+                       entry.first.second, ": ",
+                       strings::Printf("%.3f", entry.second.duration_micros /
+                                                   1000.0),
+                       "ms in ", entry.second.num_runs, " runs");
+    if (entry.second.has_node_delta) {
+      strings::StrAppend(&result, ", ", entry.second.node_delta > 0 ? "+" : "",
+                         entry.second.node_delta, " nodes");
+    }
+    strings::StrAppend(&result, "\n");
+  }
+  return result;
+}
+
+CompilationProfiler::CompilationProfiler(int64 max_phases)
+    : max_phases_(std::max<int64>(max_phases, 1)) {}
+
+/* static */
+CompilationProfiler* CompilationProfiler::Global() {
+  static CompilationProfiler* profiler = new CompilationProfiler(10000);
+  return profiler;
+}
+
+void CompilationProfiler::Record(CompilationPhase phase) {
+  compilation_phase_usecs
+      ->GetCell(phase.kind, HasBoundedNames(phase.kind) ? phase.name : "")
+      ->Add(phase.duration_micros);
+  mutex_lock l(mu_);
+  if (static_cast<int64>(phases_.size()) < max_phases_) {
+    phases_.push_back(std::move(phase));
+  } else {
+    phases_[num_phases_ % max_phases_] = std::move(phase);
+  }
+  ++num_phases_;
+}
+
+CompilationReport CompilationProfiler::GetReport() {
+  CompilationReport report;
+  mutex_lock l(mu_);
+  // The oldest phase is the one the next phase would overwrite.
+  const size_t oldest = static_cast<int64>(phases_.size()) < max_phases_
+                            ? 0
+                            : num_phases_ % max_phases_;
+  report.phases.reserve(phases_.size());
+  for (size_t i = 0; i < phases_.size(); ++i) {
+    report.phases.push_back(phases_[(oldest + i) % phases_.size()]);
+  }
+  report.num_phases = num_phases_;
+  return report;
+}
+
+void CompilationProfiler::Clear() {
+  mutex_lock l(mu_);
+  phases_.clear();
+  num_phases_ = 0;
+}
+
+ScopedCompilationPhase::ScopedCompilationPhase(StringPiece kind,
+                                               StringPiece name,
+                                               int64 nodes_before)
+    : trace_me_(
+          [kind, name] { return strings::StrCat(kind, "#name=", name, "#"); },
+          profiler::TraceMeLevel::kInfo) {
+  phase_.kind = string(kind);
+  phase_.name = string(name);
+  phase_.nodes_before = nodes_before;
+  phase_.start_micros = Env::Default()->NowMicros();
+}
+
+ScopedCompilationPhase::~ScopedCompilationPhase() {
+  phase_.duration_micros = Env::Default()->NowMicros() - phase_.start_micros;
+  CompilationProfiler::Global()->Record(std::move(phase_));
+}
+
+}  // namespace tensorflow
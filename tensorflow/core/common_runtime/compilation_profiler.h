@@ -0,0 +1,128 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COMPILATION_PROFILER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COMPILATION_PROFILER_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+
+// The kinds of compilation phases recorded by the runtime.
+//
+// The phases of DirectSession graph and executor creation.
+extern const char kCompilationPhaseSession[];
+// A Grappler pass run by the MetaOptimizer.
+extern const char kCompilationPhaseGrappler[];
+// The instantiation of a function by a FunctionLibraryRuntime.
+extern const char kCompilationPhaseFunction[];
+// The compilation of a cluster or function by the XLA compilation cache.
+extern const char kCompilationPhaseXla[];
+// An HLO pass run by an HloPassPipeline.
+extern const char kCompilationPhaseHloPass[];
+
+// One timed phase of turning a graph into something that can be executed.
+struct CompilationPhase {
+  string kind;
+  // The phase, pass or function.
+  string name;
+  int64 start_micros = 0;
+  int64 duration_micros = 0;
+  // The size of the graph before and after the phase, or -1 when the phase
+  // does not work on a graph or does not know its size.
+  int64 nodes_before = -1;
+  int64 nodes_after = -1;
+};
+
+// The compilation phases recorded by a CompilationProfiler.
+struct CompilationReport {
+  // The most recent phases, oldest first. Nested phases end, and so appear,
+  // before the phases that contain them.
+  std::vector<CompilationPhase> phases;
+  // The number of phases recorded, including the ones that no longer are in
+  // `phases`.
+  int64 num_phases = 0;
+
+  // Renders the total time, number of runs and node count change of each
+  // kind and name of phase, slowest first.
+  string DebugString() const;
+};
+
+// Keeps the most recent `max_phases` compilation phases in a ring buffer.
+//
+// Compilation phases run once per graph or function rather than once per
+// step, so the global profiler is always on. Every recorded phase is also
+// exported as the "/tensorflow/core/compilation_phase_usecs" metric.
+//
+// Thread-safe.
+class CompilationProfiler {
+ public:
+  explicit CompilationProfiler(int64 max_phases);
+
+  // The profiler that ScopedCompilationPhase records to.
+  static CompilationProfiler* Global();
+
+  void Record(CompilationPhase phase);
+
+  CompilationReport GetReport();
+
+  // Forgets all recorded phases.
+  void Clear();
+
+ private:
+  const int64 max_phases_;
+
+  mutex mu_;
+  std::vector<CompilationPhase> phases_ GUARDED_BY(mu_);
+  int64 num_phases_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompilationProfiler);
+};
+
+// Times a compilation phase from construction to destruction, emits it as a
+// TraceMe span "<kind>#name=<name>#", and records it to the global
+// CompilationProfiler.
+//
+// Example:
+//
+//   ScopedCompilationPhase phase(kCompilationPhaseSession, "partition",
+//                                graph->num_op_nodes());
+//   TF_RETURN_IF_ERROR(Partition(...));
+//   phase.set_nodes_after(num_partitioned_nodes);
+class ScopedCompilationPhase {
+ public:
+  ScopedCompilationPhase(StringPiece kind, StringPiece name,
+                         int64 nodes_before = -1);
+  ~ScopedCompilationPhase();
+
+  void set_nodes_after(int64 nodes_after) { phase_.nodes_after = nodes_after; }
+
+ private:
+  CompilationPhase phase_;
+  profiler::TraceMe trace_me_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedCompilationPhase);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COMPILATION_PROFILER_H_
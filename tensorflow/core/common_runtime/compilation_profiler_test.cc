@@ -0,0 +1,95 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+CompilationPhase MakePhase(const string& kind, const string& name,
+                           int64 duration_micros) {
+  CompilationPhase phase;
+  phase.kind = kind;
+  phase.name = name;
+  phase.duration_micros = duration_micros;
+  return phase;
+}
+
+TEST(CompilationProfilerTest, ScopedPhaseRecordsToGlobalProfiler) {
+  CompilationProfiler::Global()->Clear();
+  {
+    ScopedCompilationPhase outer(kCompilationPhaseSession, "partition", 10);
+    {
+      ScopedCompilationPhase inner(kCompilationPhaseGrappler,
+                                   "constant_folding");
+    }
+    outer.set_nodes_after(7);
+  }
+
+  CompilationReport report = CompilationProfiler::Global()->GetReport();
+  ASSERT_EQ(2, report.phases.size());
+  EXPECT_EQ(2, report.num_phases);
+  // The nested phase ends first.
+  EXPECT_EQ(kCompilationPhaseGrappler, report.phases[0].kind);
+  EXPECT_EQ("constant_folding", report.phases[0].name);
+  EXPECT_EQ(-1, report.phases[0].nodes_before);
+  EXPECT_EQ(-1, report.phases[0].nodes_after);
+  EXPECT_EQ(kCompilationPhaseSession, report.phases[1].kind);
+  EXPECT_EQ("partition", report.phases[1].name);
+  EXPECT_EQ(10, report.phases[1].nodes_before);
+  EXPECT_EQ(7, report.phases[1].nodes_after);
+  EXPECT_LE(report.phases[1].start_micros, report.phases[0].start_micros);
+  EXPECT_GE(report.phases[1].duration_micros,
+            report.phases[0].duration_micros);
+  CompilationProfiler::Global()->Clear();
+}
+
+TEST(CompilationProfilerTest, KeepsMostRecentPhases) {
+  CompilationProfiler profiler(2);
+  profiler.Record(MakePhase(kCompilationPhaseSession, "a", 1));
+  profiler.Record(MakePhase(kCompilationPhaseSession, "b", 2));
+  profiler.Record(MakePhase(kCompilationPhaseSession, "c", 3));
+
+  CompilationReport report = profiler.GetReport();
+  ASSERT_EQ(2, report.phases.size());
+  EXPECT_EQ(3, report.num_phases);
+  EXPECT_EQ("b", report.phases[0].name);
+  EXPECT_EQ("c", report.phases[1].name);
+}
+
+TEST(CompilationProfilerTest, DebugStringAggregatesPhases) {
+  CompilationProfiler profiler(10);
+  CompilationPhase pruning =
+      MakePhase(kCompilationPhaseGrappler, "pruning", 1000);
+  pruning.nodes_before = 10;
+  pruning.nodes_after = 6;
+  profiler.Record(pruning);
+  pruning.nodes_before = 6;
+  pruning.nodes_after = 5;
+  profiler.Record(pruning);
+  profiler.Record(MakePhase(kCompilationPhaseXla, "cluster_0", 5000));
+
+  const string debug_string = profiler.GetReport().DebugString();
+  EXPECT_EQ(
+      "Compilation phases (last 3 of 3):\n"
+      "  xla cluster_0: 5.000ms in 1 runs\n"
+      "  grappler pruning: 2.000ms in 2 runs, -5 nodes\n",
+      debug_string);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -471,7 +471,8 @@ bool ReplaceTensorWithConstant(
     const ConstantFoldNameGenerator& generate_new_name) {
   // Be conservative when replacing a tensor with a constant, when not
   // running on CPU.
-  // 1) Do not replace another constant.
+  // 1) Do not replace another constant, or an ImmutableConst whose output
+  // aliases memory-mapped data that a Const would copy into the graph.
   // 2) If the destination tensor or any other tensor from the same node is not
   // an int32 tensor, and has HOST_MEMORY constraint, do not replace it.
   // 3) If the destination tensor or any other tensor from the same node is an
@@ -484,7 +485,8 @@ bool ReplaceTensorWithConstant(
   // TODO(keveman): Consider adding a new constant op that has a kernel
   // implementation for all types, but with HostMemory constraint on it's
   // output.
-  if (tensor.first->IsConstant()) {
+  if (tensor.first->IsConstant() ||
+      tensor.first->type_string() == "ImmutableConst") {
     return false;
   }
   DeviceType device_type = partition_device
@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
 #include "tensorflow/core/common_runtime/constant_folding.h"
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -35,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
+#include "tensorflow/core/common_runtime/sampled_traces.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
@@ -93,13 +95,19 @@ Status NewThreadPoolFromThreadPoolOptions(
   if (num_threads == 0) {
     num_threads = NumInterOpThreadsFromSessionOptions(options);
   }
+  ThreadOptions thread_options = InterOpThreadOptions(options);
+  if (thread_pool_options.cpu_affinity_size() > 0) {
+    thread_options.cpu_affinity.assign(
+        thread_pool_options.cpu_affinity().begin(),
+        thread_pool_options.cpu_affinity().end());
+  }
   const string& name = thread_pool_options.global_name();
   if (name.empty()) {
     // Session-local threadpool.
     VLOG(1) << "Direct session inter op parallelism threads for pool "
             << pool_number << ": " << num_threads;
     *pool = new thread::ThreadPool(
-        options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
+        options.env, thread_options, strings::StrCat("Compute", pool_number),
         num_threads, !options.config.experimental().disable_thread_spinning(),
         /*allocator=*/nullptr);
     *owned = true;
@@ -116,7 +124,7 @@ Status NewThreadPoolFromThreadPoolOptions(
   if (mvalue->second == nullptr) {
     mvalue->first = thread_pool_options.num_threads();
     mvalue->second = new thread::ThreadPool(
-        options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
+        options.env, thread_options, strings::StrCat("Compute", pool_number),
         num_threads, !options.config.experimental().disable_thread_spinning(),
         /*allocator=*/nullptr);
   } else {
@@ -581,10 +589,23 @@ Status DirectSession::RunInternal(
           ((measure_step_count + 1) % build_cost_model_every == 0);
     }
   }
-  if (do_trace || update_cost_model ||
+  // Sampled steps record the same per-op timings as a trace, but hand them
+  // to SampledTraces instead of returning them to the caller.
+  const int32 trace_sample_period =
+      options_.config.experimental().trace_sample_period();
+  const bool sample_trace = !do_trace && trace_sample_period > 0 &&
+                            executor_step_count % trace_sample_period == 0;
+
+  // RunCallable() may be called without a RunMetadata, in which case the
+  // collected stats only feed the cost model and SampledTraces.
+  StepStats local_step_stats;
+  StepStats* step_stats = &local_step_stats;
+  if (do_trace || update_cost_model || sample_trace ||
       run_options.report_tensor_allocations_upon_oom()) {
-    run_state.collector.reset(
-        new StepStatsCollector(run_metadata->mutable_step_stats()));
+    if (run_metadata != nullptr) {
+      step_stats = run_metadata->mutable_step_stats();
+    }
+    run_state.collector.reset(new StepStatsCollector(step_stats));
     args.stats_collector = run_state.collector.get();
   }
 
@@ -623,7 +644,8 @@ Status DirectSession::RunInternal(
   std::unique_ptr<thread::ThreadPool> threadpool_wrapper;
   thread::ThreadPool* pool = nullptr;
 
-  if (run_in_caller_thread_) {
+  if (run_in_caller_thread_ ||
+      run_options.experimental().run_in_caller_thread()) {
     pool = nullptr;
   } else if (threadpool_options.inter_op_threadpool != nullptr) {
     threadpool_wrapper = absl::make_unique<thread::ThreadPool>(
@@ -647,7 +669,15 @@ Status DirectSession::RunInternal(
   if (ShouldUseRunHandlerPool(run_options) &&
       run_options.experimental().use_run_handler_pool()) {
     VLOG(1) << "Using RunHandler to scheduler inter-op closures.";
-    handler = GetOrCreateRunHandlerPool(options_)->Get(step_id);
+    const int64 priority = run_options.experimental().run_handler_priority();
+    const uint64 get_start_us = options_.env->NowMicros();
+    handler = GetOrCreateRunHandlerPool(options_)->Get(
+        step_id,
+        run_options.timeout_in_ms() > 0 ? run_options.timeout_in_ms()
+                                        : operation_timeout_in_ms_,
+        priority);
+    metrics::RecordRunHandlerQueueingDelay(
+        priority, options_.env->NowMicros() - get_start_us);
   }
   auto* handler_ptr = handler.get();
 
@@ -735,10 +765,19 @@ Status DirectSession::RunInternal(
     run_state.collector->BuildCostModel(&cost_model_manager_, device_to_graph);
 
     // annotate stats onto cost graph.
-    CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
-    for (const auto& item : executors_and_keys->items) {
-      TF_RETURN_IF_ERROR(
-          cost_model_manager_.AddToCostGraphDef(item.graph, cost_graph));
+    if (run_metadata != nullptr) {
+      CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
+      for (const auto& item : executors_and_keys->items) {
+        TF_RETURN_IF_ERROR(
+            cost_model_manager_.AddToCostGraphDef(item.graph, cost_graph));
+      }
+    }
+  }
+
+  if (sample_trace) {
+    SampledTraces::Global()->Add(std::move(*step_stats));
+    if (run_metadata != nullptr) {
+      run_metadata->clear_step_stats();
     }
   }
 
@@ -1243,6 +1282,8 @@ Status DirectSession::CreateExecutors(
 
   ek->callable_options = callable_options;
 
+  ScopedCompilationPhase executors_phase(kCompilationPhaseSession,
+                                        "create_executors");
   std::unordered_map<string, std::unique_ptr<Graph>> graphs;
   TF_RETURN_IF_ERROR(CreateGraphs(
       options, &graphs, &func_info->flib_def, run_state_args, &ek->input_types,
@@ -1327,8 +1368,14 @@ Status DirectSession::CreateExecutors(
       return Status::OK();
     };
 
-    optimizer.Optimize(lib, options_.env, device, &partition_graph,
-                       /*shape_map=*/nullptr);
+    {
+      ScopedCompilationPhase phase(kCompilationPhaseSession,
+                                   "graph_optimizer",
+                                   partition_graph->num_op_nodes());
+      optimizer.Optimize(lib, options_.env, device, &partition_graph,
+                         /*shape_map=*/nullptr);
+      phase.set_nodes_after(partition_graph->num_op_nodes());
+    }
 
     // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
     const DebugOptions& debug_options =
@@ -1346,6 +1393,10 @@ Status DirectSession::CreateExecutors(
     item->executor = nullptr;
     item->device = device;
     auto executor_type = options_.config.experimental().executor_type();
+    // Constructs the kernels of the partition.
+    ScopedCompilationPhase executor_phase(kCompilationPhaseSession,
+                                          "create_executor",
+                                          partition_graph->num_op_nodes());
     TF_RETURN_IF_ERROR(NewExecutor(
         executor_type, params, std::move(partition_graph), &item->executor));
   }
@@ -1509,6 +1560,8 @@ Status DirectSession::CreateGraphs(
 
   std::unique_ptr<GraphExecutionState> temp_exec_state_holder;
   GraphExecutionState* execution_state = nullptr;
+  ScopedCompilationPhase graphs_phase(kCompilationPhaseSession,
+                                     "create_graphs");
   if (options_.config.graph_options().place_pruned_graph()) {
     // Because we are placing pruned graphs, we need to create a
     // new GraphExecutionState for every new unseen graph,
@@ -1588,6 +1641,9 @@ Status DirectSession::CreateGraphs(
   popts.flib_def = &client_graph->graph.flib_def();
   popts.control_flow_added = false;
 
+  std::unique_ptr<ScopedCompilationPhase> partition_phase(
+      new ScopedCompilationPhase(kCompilationPhaseSession, "partition",
+                                 client_graph->graph.num_op_nodes()));
   std::unordered_map<string, GraphDef> partitions;
   TF_RETURN_IF_ERROR(Partition(popts, &client_graph->graph, &partitions));
 
@@ -1611,25 +1667,41 @@ Status DirectSession::CreateGraphs(
     }
   }
 
-  for (const auto& partition : partitions) {
+  int64 num_partition_nodes = 0;
+  for (auto& partition : partitions) {
     std::unique_ptr<Graph> device_graph(
         new Graph(client_graph->flib_def.get()));
     GraphConstructorOptions device_opts;
     // There are internal operations (e.g., send/recv) that we now allow.
     device_opts.allow_internal_ops = true;
     device_opts.expect_device_spec = true;
-    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(device_opts, partition.second,
-                                              device_graph.get()));
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
+        device_opts, std::move(partition.second), device_graph.get()));
+    num_partition_nodes += device_graph->num_op_nodes();
     outputs->emplace(partition.first, std::move(device_graph));
   }
+  partition_phase->set_nodes_after(num_partition_nodes);
+  partition_phase.reset();
 
   GraphOptimizationPassOptions optimization_options;
   optimization_options.session_options = &options_;
   optimization_options.flib_def = client_graph->flib_def.get();
   optimization_options.partition_graphs = outputs;
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
+  {
+    ScopedCompilationPhase phase(kCompilationPhaseSession,
+                                 "post_partitioning_passes",
+                                 num_partition_nodes);
+    TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
+    num_partition_nodes = 0;
+    for (const auto& partition : *outputs) {
+      num_partition_nodes += partition.second->num_op_nodes();
+    }
+    phase.set_nodes_after(num_partition_nodes);
+  }
 
+  ScopedCompilationPhase rewrite_phase(kCompilationPhaseSession,
+                                       "device_rewrite_graph");
   Status s;
   for (auto& partition : *outputs) {
     const string& partition_name = partition.first;
@@ -1798,7 +1870,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   }
 
   Status GetArg(int index, Tensor* val) const override {
-    if (index > feed_tensors_->size()) {
+    if (index >= feed_tensors_->size()) {
       return errors::Internal("Args index out of bounds: ", index);
     } else if (executors_and_keys_->input_types[index] == DT_RESOURCE) {
       TF_RETURN_IF_ERROR(
@@ -1810,7 +1882,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   }
 
   Status SetRetval(int index, const Tensor& val) override {
-    if (index > fetch_tensors_->size()) {
+    if (index >= fetch_tensors_->size()) {
       return errors::Internal("RetVal index out of bounds: ", index);
     }
     (*fetch_tensors_)[index] = val;
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
+#include "tensorflow/core/common_runtime/sampled_traces.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -688,6 +689,88 @@ TEST_F(DirectSessionMinusAXTest, UseRunHandlerPool) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunInCallerThread_Callable) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  CallableOptions callable_options =
+      MakeCallableOptions({}, {y_ + ":0"}, {y_neg_});
+  callable_options.mutable_run_options()
+      ->mutable_experimental()
+      ->set_run_in_caller_thread(true);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+  ASSERT_EQ(1, outputs.size());
+  auto mat = outputs[0].matrix<float>();
+  ASSERT_TRUE(outputs[0].IsInitialized());
+  EXPECT_FLOAT_EQ(5.0, mat(0, 0));
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+TEST_F(DirectSessionMinusAXTest, SampledTraces) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_trace_sample_period(2);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  SampledTraces::Global()->Clear();
+
+  // The first and third steps are sampled.
+  for (int i = 0; i < 4; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session->Run(RunOptions(), {}, {y_ + ":0"}, {}, &outputs,
+                              &run_metadata));
+    EXPECT_EQ(0, run_metadata.step_stats().dev_stats_size());
+  }
+
+  const std::vector<StepStats> steps = SampledTraces::Global()->Get();
+  ASSERT_EQ(2, steps.size());
+  bool found_y = false;
+  for (const DeviceStepStats& dev_stats : steps[0].dev_stats()) {
+    for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+      if (node_stats.node_name() == y_) found_y = true;
+    }
+  }
+  EXPECT_TRUE(found_y);
+  const string json = SampledTraces::Global()->ToChromeTraceJson();
+  EXPECT_TRUE(absl::StrContains(json, "\"traceEvents\""));
+  EXPECT_TRUE(
+      absl::StrContains(json, strings::StrCat("\"name\":\"", y_, "\"")));
+  SampledTraces::Global()->Clear();
+}
+
+TEST_F(DirectSessionMinusAXTest, SampledTraces_CallableWithoutRunMetadata) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_trace_sample_period(1);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  SampledTraces::Global()->Clear();
+
+  Session::CallableHandle handle;
+  CallableOptions callable_options;
+  callable_options.add_fetch(y_ + ":0");
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+  for (int i = 0; i < 2; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+
+  // Every step is sampled, although no RunMetadata was passed.
+  EXPECT_EQ(2, SampledTraces::Global()->Get().size());
+  SampledTraces::Global()->Clear();
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
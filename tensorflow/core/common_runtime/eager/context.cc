@@ -58,6 +58,8 @@ auto* eager_context_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/core/eager_context_created",
                                     "True if an eager context was created.");
 
+std::atomic<int64> next_kernel_cache_generation(0);
+
 }  // namespace
 
 EagerContext::EagerContext(
@@ -91,6 +93,7 @@ EagerContext::EagerContext(
   // currently a no-op.
   eager_context_created->GetCell()->Set(true);
   monitoring::StartExporter();
+  NewKernelCacheGeneration();
   if (device_mgr_owned) {
     local_device_manager_.reset(device_mgr);
     local_unowned_device_manager_ = nullptr;
@@ -165,6 +168,7 @@ void EagerContext::ClearCaches() {
   // well.
   mutex_lock ml(cache_mu_);
   executor_.WaitForAllPendingNodes().IgnoreError();
+  NewKernelCacheGeneration();
   kernel_cache_.clear();
   for (auto& entry : registered_functions_) {
     entry.second->cached_kernel_keys->clear();
@@ -416,6 +420,7 @@ Status EagerContext::AddFunctionDef(const FunctionDef& fdef) {
   if (is_first_ref) {
     mutex_lock l(functions_mu_);
     TF_RETURN_IF_ERROR(func_lib_def_.AddFunctionDef(fdef));
+    NewKernelCacheGeneration();
     // TODO(fishx): Avoid holding lock when sending RPCs.
     return MaybeRegisterFunctionRemotely(fdef);
   }
@@ -433,6 +438,7 @@ Status EagerContext::RemoveFunction(const string& func) {
     }
     is_last_ref = registered_function->RefCountIsOne();
     if (is_last_ref) {
+      NewKernelCacheGeneration();
       for (auto& key : *registered_function->cached_kernel_keys) {
         kernel_cache_.erase(key);
       }
@@ -460,6 +466,11 @@ core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
   return new_ref;
 }
 
+void EagerContext::NewKernelCacheGeneration() {
+  kernel_cache_generation_.store(next_kernel_cache_generation.fetch_add(1),
+                                 std::memory_order_release);
+}
+
 void EagerContext::AddKernelToCache(Fprint128 cache_key,
                                     KernelAndDevice* kernel) {
   mutex_lock ml(cache_mu_);
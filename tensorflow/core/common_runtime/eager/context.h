@@ -185,6 +185,14 @@ class EagerContext : public core::RefCounted {
 
   void AddKernelToCache(Fprint128 cache_key, KernelAndDevice* kernel);
 
+  // Identifies the state of the kernel cache: changes whenever a kernel may
+  // have left the cache or a function was added. Values are never reused,
+  // also across contexts, so a kernel that was cached under the same
+  // generation is still cached.
+  int64 KernelCacheGeneration() const {
+    return kernel_cache_generation_.load(std::memory_order_acquire);
+  }
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   bool AllowSoftPlacement() const { return allow_soft_placement_; }
   bool LogMemory() const { return log_memory_; }
@@ -376,6 +384,10 @@ class EagerContext : public core::RefCounted {
       kernel_cache_ GUARDED_BY(cache_mu_);
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       GUARDED_BY(cache_mu_);
+  std::atomic<int64> kernel_cache_generation_;
+
+  // Moves KernelCacheGeneration() to a new value.
+  void NewKernelCacheGeneration();
 
   // Whether we should compute RunMetadata.
   std::atomic<bool> should_store_step_stats_{false};
@@ -40,7 +40,7 @@ void EagerExecutor::Add(std::unique_ptr<EagerNode> node) {
     return;
   }
 
-  node_queue_.push(std::move(node));
+  node_queue_.push_back(std::move(node));
 
   // If there were no previous nodes pending, wake the run thread to start
   // processing requests again.
@@ -82,6 +82,7 @@ tensorflow::Status EagerExecutor::status() const {
 void EagerExecutor::Run() {
   while (true) {
     EagerNode* curr_node;
+    int num_nodes = 1;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
       while (node_queue_.empty() || !status_.ok()) {
@@ -91,11 +92,20 @@ void EagerExecutor::Run() {
       // Obtain raw pointer since we don't want to remove from the queue until
       // the node has been run.
       curr_node = node_queue_.front().get();
+      while (num_nodes < node_queue_.size() &&
+             curr_node->Absorb(node_queue_[num_nodes].get())) {
+        ++num_nodes;
+      }
     }
     tensorflow::Status status = curr_node->Run();
     const bool ok = status.ok();
     tensorflow::mutex_lock l(node_queue_mutex_);
-    node_queue_.pop();
+    // The nodes are only used as keys of node_done_notifications_ once popped.
+    gtl::InlinedVector<EagerNode*, 4> done_nodes;
+    for (int i = 0; i < num_nodes; ++i) {
+      done_nodes.push_back(node_queue_.front().get());
+      node_queue_.pop_front();
+    }
     if (!ok) {
       status_ = status;
       // We remove any pending ops so that we don't try to execute them if
@@ -104,23 +114,25 @@ void EagerExecutor::Run() {
                               ". Encountered when executing an operation using "
                               "EagerExecutor. This error cancels all future "
                               "operations and poisons their output tensors.");
-      for (int i = 0; i < node_queue_.size(); ++i) {
+      while (!node_queue_.empty()) {
         node_queue_.front()->Abort(status);
         // Dequeue and delete nodes
-        node_queue_.pop();
+        node_queue_.pop_front();
       }
     }
     if (!node_done_notifications_.empty()) {
       // Note that we notify all waiting threads in case an error has occurred.
       // These calling threads are responsible for checking status_ before
       // proceeding.
-      const auto range = ok ? node_done_notifications_.equal_range(curr_node)
-                            : make_pair(node_done_notifications_.begin(),
-                                        node_done_notifications_.end());
-      for (auto it = range.first; it != range.second; ++it) {
-        it->second->notify_all();
+      for (EagerNode* node : done_nodes) {
+        const auto range = ok ? node_done_notifications_.equal_range(node)
+                              : make_pair(node_done_notifications_.begin(),
+                                          node_done_notifications_.end());
+        for (auto it = range.first; it != range.second; ++it) {
+          it->second->notify_all();
+        }
+        node_done_notifications_.erase(range.first, range.second);
       }
-      node_done_notifications_.erase(range.first, range.second);
     }
   }
 }
@@ -17,9 +17,9 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 
@@ -53,6 +53,13 @@ class EagerNode {
   // For example, if the node would have computed some tensors in the Run(),
   // it should poison the corresponding tensor handles in this method.
   virtual void Abort(Status status) = 0;
+
+  // Called by the executor with the node queued right after this one, before
+  // this node is run. Returning true means that this node's Run() also runs
+  // `next`, and that its Abort() also aborts it, so the executor won't call
+  // either on `next` itself. This lets a node batch the work of the nodes
+  // that follow it, such as sending consecutive remote ops in one RPC.
+  virtual bool Absorb(EagerNode* next) { return false; }
 };
 
 // A class for handling async execution (see TFE_ContextSetAsync).
@@ -101,7 +108,7 @@ class EagerExecutor {
   condition_variable nodes_pending_ GUARDED_BY(node_queue_mutex_);
 
   // Queue of pending EagerNodes.
-  std::queue<std::unique_ptr<EagerNode>> node_queue_
+  std::deque<std::unique_ptr<EagerNode>> node_queue_
       GUARDED_BY(node_queue_mutex_);
 
   // `status_` is set based on any errors raised during execution of a
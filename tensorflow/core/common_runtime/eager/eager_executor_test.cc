@@ -0,0 +1,123 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Records which nodes ran together and which were aborted.
+struct Log {
+  mutex mu;
+  std::vector<std::vector<int>> batches GUARDED_BY(mu);
+  std::vector<int> aborted GUARDED_BY(mu);
+};
+
+// A node that absorbs up to `max_batch_size - 1` following TestNodes, and
+// fails when run if `status` is not OK.
+class TestNode : public EagerNode {
+ public:
+  TestNode(int id, Log* log, int max_batch_size = 1,
+           Status status = Status::OK(), Notification* run_after = nullptr)
+      : id_(id),
+        log_(log),
+        max_batch_size_(max_batch_size),
+        status_(status),
+        run_after_(run_after) {}
+
+  bool Absorb(EagerNode* next) override {
+    auto* node = dynamic_cast<TestNode*>(next);
+    if (node == nullptr || absorbed_.size() + 1 >= max_batch_size_) {
+      return false;
+    }
+    absorbed_.push_back(node);
+    return true;
+  }
+
+  Status Run() override {
+    if (run_after_ != nullptr) run_after_->WaitForNotification();
+    std::vector<int> batch = {id_};
+    for (TestNode* node : absorbed_) batch.push_back(node->id_);
+    mutex_lock l(log_->mu);
+    log_->batches.push_back(batch);
+    return status_;
+  }
+
+  void Abort(Status status) override {
+    mutex_lock l(log_->mu);
+    log_->aborted.push_back(id_);
+  }
+
+ private:
+  const int id_;
+  Log* const log_;
+  const int max_batch_size_;
+  const Status status_;
+  Notification* const run_after_;
+  std::vector<TestNode*> absorbed_;
+};
+
+TEST(EagerExecutorTest, RunsQueuedNodesInBatches) {
+  Log log;
+  Notification start;
+  EagerExecutor executor;
+  executor.EnableAsync();
+  // The first node blocks the executor until the others are queued.
+  executor.Add(absl::make_unique<TestNode>(0, &log, /*max_batch_size=*/1,
+                                           Status::OK(), &start));
+  for (int i = 1; i <= 5; ++i) {
+    executor.Add(absl::make_unique<TestNode>(i, &log, /*max_batch_size=*/3));
+  }
+  start.Notify();
+  TF_ASSERT_OK(executor.WaitForAllPendingNodes());
+
+  mutex_lock l(log.mu);
+  EXPECT_EQ(std::vector<std::vector<int>>({{0}, {1, 2, 3}, {4, 5}}),
+            log.batches);
+  EXPECT_TRUE(log.aborted.empty());
+}
+
+TEST(EagerExecutorTest, FailedBatchAbortsTheNodesAfterIt) {
+  Log log;
+  Notification start;
+  EagerExecutor executor;
+  executor.EnableAsync();
+  executor.Add(absl::make_unique<TestNode>(0, &log, /*max_batch_size=*/1,
+                                           Status::OK(), &start));
+  executor.Add(absl::make_unique<TestNode>(1, &log, /*max_batch_size=*/2,
+                                           errors::Unavailable("failed")));
+  for (int i = 2; i <= 6; ++i) {
+    executor.Add(absl::make_unique<TestNode>(i, &log));
+  }
+  start.Notify();
+  EXPECT_TRUE(errors::IsUnavailable(executor.WaitForAllPendingNodes()));
+  EXPECT_TRUE(errors::IsUnavailable(executor.status()));
+
+  mutex_lock l(log.mu);
+  EXPECT_EQ(std::vector<std::vector<int>>({{0}, {1, 2}}), log.batches);
+  // Node 2 was absorbed by the failed node, so the executor does not abort it.
+  EXPECT_EQ(std::vector<int>({3, 4, 5, 6}), log.aborted);
+}
+
+}  // namespace
+}  // namespace tensorflow
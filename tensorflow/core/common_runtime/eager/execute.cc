@@ -236,6 +236,43 @@ Status ValidateInputTypeAndPlacement(
   return Status::OK();
 }
 
+// The kernel of the last single-device op that this thread executed, so that
+// running the same op again can skip the function library lookup and the
+// input validation. The kernel is only compared against, never dereferenced:
+// it may have left the kernel cache since, in which case the generation of
+// the cache has changed.
+struct LastKernel {
+  const EagerContext* ctx = nullptr;
+  int64 generation = -1;
+  Fprint128 cache_key = {0, 0};
+  const KernelAndDevice* kernel = nullptr;
+  // The dtypes and devices of inputs that passed ValidateInputTypeAndPlacement
+  // for the kernel without copies.
+  gtl::InlinedVector<std::pair<DataType, const Device*>, 4> valid_inputs;
+};
+
+LastKernel* ThreadLastKernel() {
+  static thread_local LastKernel last_kernel;
+  return &last_kernel;
+}
+
+// Returns true if the inputs of `op` have the dtypes and devices of
+// `valid_inputs`.
+bool InputsMatch(
+    EagerContext* ctx, EagerOperation* op,
+    const gtl::InlinedVector<std::pair<DataType, const Device*>, 4>&
+        valid_inputs) {
+  if (op->Inputs().size() != valid_inputs.size()) return false;
+  for (int i = 0; i < op->Inputs().size(); ++i) {
+    TensorHandle* handle = op->Inputs()[i];
+    if (handle->dtype != valid_inputs[i].first ||
+        handle->DeviceOrHostCPU(ctx) != valid_inputs[i].second) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status SelectDevice(EagerOperation* op, const NodeDef& ndef, EagerContext* ctx,
                     Device** device) {
   std::vector<Device*> final_devices;
@@ -476,8 +513,17 @@ Status EagerLocalExecute(EagerOperation* op,
   Fprint128 cache_key = op->MutableAttrs()->CacheKey(
       DeviceNameOrUnspecified(op->GetDeviceName()));
 
+  // Read before the kernel cache lookup, so that a kernel recorded in
+  // LastKernel under this generation was cached under it.
+  const int64 generation = ctx->KernelCacheGeneration();
+  LastKernel* last_kernel = ThreadLastKernel();
+  const bool same_op_as_last = last_kernel->ctx == ctx &&
+                               last_kernel->generation == generation &&
+                               last_kernel->cache_key == cache_key;
+
+  // Only single-device ops are recorded in LastKernel.
   bool is_multi_device_function =
-      IsMultiDevice(ctx->FindFunctionDef(op->Name()));
+      !same_op_as_last && IsMultiDevice(ctx->FindFunctionDef(op->Name()));
 
   std::vector<Device*> input_dev_ptrs;
   // `input_tensor_shapes` contains (potentially a subset of) non DT_RESOURCE
@@ -635,9 +681,28 @@ Status EagerLocalExecute(EagerOperation* op,
                                    *num_retvals);
   }
   *num_retvals = output_dtypes_size;
-  TF_RETURN_IF_ERROR(ValidateInputTypeAndPlacement(
-      ctx, op, kernel,
-      ctx->ShouldStoreStepStats() ? ctx->RunMetadataProto() : nullptr));
+  // Validation only depends on the kernel and the input dtypes and devices,
+  // and leaves the inputs on the devices the kernel expects, so it does not
+  // need to be repeated for inputs that passed it before. The generation is
+  // checked again since the kernel may have been replaced during the lookup.
+  if (!same_op_as_last || kernel.get() != last_kernel->kernel ||
+      ctx->KernelCacheGeneration() != generation ||
+      !InputsMatch(ctx, op, last_kernel->valid_inputs)) {
+    TF_RETURN_IF_ERROR(ValidateInputTypeAndPlacement(
+        ctx, op, kernel,
+        ctx->ShouldStoreStepStats() ? ctx->RunMetadataProto() : nullptr));
+    if (!is_multi_device_function) {
+      last_kernel->ctx = ctx;
+      last_kernel->generation = generation;
+      last_kernel->cache_key = cache_key;
+      last_kernel->kernel = kernel.get();
+      last_kernel->valid_inputs.clear();
+      for (TensorHandle* handle : op->Inputs()) {
+        last_kernel->valid_inputs.emplace_back(handle->dtype,
+                                               handle->DeviceOrHostCPU(ctx));
+      }
+    }
+  }
 
   std::unique_ptr<NodeExecStats> maybe_stats;
   StepStats* maybe_step_stats = nullptr;
@@ -26,9 +26,12 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -46,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/edgeset.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -60,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -69,7 +74,9 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/internal/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/op_context.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -212,6 +219,11 @@ struct NodeItem {
   // 0... for forward from that input.
   const int* forward_from() const { return forward_from_base(); }
 
+  // Return array of per-input flags, false for an input whose buffer is
+  // always shared with its producer and so can never be forwarded to an
+  // output.
+  const bool* input_forwardable() const { return input_forwardable_base(); }
+
  private:
   friend class GraphView;
 
@@ -222,6 +234,7 @@ struct NodeItem {
   //   int                 forward_from[num_outputs];
   //   uint8               input_type[num_inputs];
   //   uint8               output_type[num_outputs];
+  //   bool                input_forwardable[num_inputs];
 
   // Return pointer to variable length section.
   char* var() const {
@@ -251,6 +264,12 @@ struct NodeItem {
         sizeof(AllocatorAttributes) * num_outputs + sizeof(int) * num_outputs +
         sizeof(uint8) * num_inputs);
   }
+  bool* input_forwardable_base() const {
+    return reinterpret_cast<bool*>(
+        var() + sizeof(EdgeInfo) * num_output_edges +
+        sizeof(AllocatorAttributes) * num_outputs + sizeof(int) * num_outputs +
+        sizeof(uint8) * num_inputs + sizeof(uint8) * num_outputs);
+  }
 
   TF_DISALLOW_COPY_AND_ASSIGN(NodeItem);
 };
@@ -291,10 +310,22 @@ class GraphView {
   TF_DISALLOW_COPY_AND_ASSIGN(GraphView);
 };
 
+// Bounds for the initial block size of a step's arena.
+constexpr size_t kMinStepArenaBlockSize = 64 << 10;
+constexpr size_t kMaxStepArenaBlockSize = 64 << 20;
+
 class ExecutorImpl : public Executor {
  public:
-  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g)
-      : params_(p), graph_(std::move(g)), gview_() {
+  // If `work_stealing_workers` is positive, every invocation of the
+  // executor dispatches the nodes that are not run inline to at most that
+  // many work-stealing workers instead of scheduling one closure per node on
+  // the runner.
+  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g,
+               int work_stealing_workers = 0)
+      : params_(p),
+        graph_(std::move(g)),
+        gview_(),
+        work_stealing_workers_(work_stealing_workers) {
     CHECK(p.create_kernel != nullptr);
     CHECK(p.delete_kernel != nullptr);
   }
@@ -378,6 +409,19 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // Maximum number of work-stealing workers per step, or 0 to schedule every
+  // dispatched node directly on the runner.
+  const int work_stealing_workers_;
+
+  // If true, each step serves the temporary allocations of its kernels from
+  // a StepArenaAllocator. Set from TF_EXECUTOR_USE_STEP_ARENA for CPU
+  // devices.
+  bool use_step_arena_ = false;
+
+  // Initial block size of the next step's arena: the bytes used by the
+  // previous step, so that a steady-state step needs a single block.
+  mutable std::atomic<size_t> step_arena_block_size_{kMinStepArenaBlockSize};
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
@@ -428,7 +472,8 @@ size_t GraphView::NodeItemBytes(const Node* n) {
       + num_outputs * sizeof(AllocatorAttributes)  // output_attr[...]
       + num_outputs * sizeof(int)                  // forward_from[num_outputs]
       + num_inputs * sizeof(uint8)                 // input_type[num_inputs]
-      + num_outputs * sizeof(uint8);               // output_type[num_outputs]
+      + num_outputs * sizeof(uint8)                // output_type[num_outputs]
+      + num_inputs * sizeof(bool);                 // input_forwardable[...]
   static constexpr size_t kItemAlignment = sizeof(NodeItem*);
   static_assert(kItemAlignment % alignof(NodeItem) == 0,
                 "NodeItem must be aligned with kItemAlignment");
@@ -512,6 +557,24 @@ char* GraphView::InitializeNode(char* ptr, const Node* n) {
     DCHECK_EQ(item->input_type(i), n->input_type(i));
   }
 
+  // Mark the inputs whose producer keeps a reference to every tensor it
+  // outputs, so that the kernel can skip the forwarding checks for them.
+  bool* input_forwardable = item->input_forwardable_base();
+  for (int i = 0; i < num_inputs; i++) {
+    input_forwardable[i] = !IsRefType(n->input_type(i));
+  }
+  for (const Edge* e : n->in_edges()) {
+    if (e->IsControlEdge()) continue;
+    const Node* src = e->src();
+    bool is_constant_enter = false;
+    if (IsConstant(src) ||
+        (IsEnter(src) &&
+         GetNodeAttr(src->attrs(), "is_constant", &is_constant_enter).ok() &&
+         is_constant_enter)) {
+      input_forwardable[e->dst_input()] = false;
+    }
+  }
+
   // Check ScopedAllocatorAttrs and forward_from.  Also assign output_types.
   {
     std::vector<int> forward_input;
@@ -601,6 +664,55 @@ void GetMaxPendingCounts(const Node* n, size_t* max_pending,
   *max_dead_count = num_in_edges;
 }
 
+// Graphs with fewer nodes create their kernels on the calling thread.
+constexpr int kMinNodesForParallelKernelCreation = 32;
+
+// Returns true if TF_EXECUTOR_PARALLEL_KERNEL_CREATION enables parallel kernel
+// creation for all executors. Read once per process.
+bool ParallelKernelCreationEnabledByEnv() {
+  static const bool enabled = [] {
+    bool enabled = false;
+    Status s = ReadBoolFromEnvVar("TF_EXECUTOR_PARALLEL_KERNEL_CREATION",
+                                  false, &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return false;
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
+// Calls `fn(i)` for every i in [0, n) on a thread pool shared by all
+// executors, and returns when all calls are done. The calling thread takes
+// part, so this makes progress even when called from a pool thread. The pool
+// is only created once an executor opts into parallel kernel creation.
+void ParallelFor(int n, const std::function<void(int)>& fn) {
+  static thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "executor_kernel_creation",
+                             port::MaxParallelism());
+  struct State {
+    explicit State(int n) : done(n) {}
+    std::atomic<int> next{0};
+    BlockingCounter done;
+  };
+  // Pool threads that start after all calls are claimed return at once, but
+  // may do so after this function has returned.
+  auto state = std::make_shared<State>(n);
+  auto work = [state, n, &fn]() {
+    for (int i = state->next++; i < n; i = state->next++) {
+      fn(i);
+      state->done.DecrementCount();
+    }
+  };
+  const int num_helpers = std::min(n, pool->NumThreads()) - 1;
+  for (int i = 0; i < num_helpers; ++i) {
+    pool->Schedule(work);
+  }
+  work();
+  state->done.Wait();
+}
+
 Status ExecutorImpl::Initialize() {
   gview_.Initialize(graph_.get());
 
@@ -613,6 +725,33 @@ Status ExecutorImpl::Initialize() {
   device_record_tensor_accesses_ =
       params_.device->RequiresRecordingAccessedTensors();
 
+  bool use_step_arena = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_USE_STEP_ARENA", false,
+                                        &use_step_arena));
+  use_step_arena_ =
+      use_step_arena && params_.device->device_type() == DEVICE_CPU;
+
+  // Kernel constructors can be expensive, e.g. when they build lookup tables
+  // or compile regular expressions, so large graphs can create all their
+  // kernels in parallel up front. This is opt-in, since not every
+  // `create_kernel` is safe to call concurrently.
+  std::vector<Status> kernel_statuses;
+  if ((params_.parallel_kernel_creation ||
+       ParallelKernelCreationEnabledByEnv()) &&
+      graph_->num_nodes() >= kMinNodesForParallelKernelCreation) {
+    std::vector<const Node*> nodes;
+    nodes.reserve(graph_->num_nodes());
+    for (const Node* n : graph_->nodes()) {
+      nodes.push_back(n);
+    }
+    kernel_statuses.resize(graph_->num_node_ids());
+    ParallelFor(nodes.size(), [this, &nodes, &kernel_statuses](int i) {
+      const Node* n = nodes[i];
+      kernel_statuses[n->id()] =
+          params_.create_kernel(n->def(), &gview_.node(n->id())->kernel);
+    });
+  }
+
   for (auto& it : cf_info.unique_frame_names) {
     EnsureFrameInfo(it)->nodes = new std::vector<const Node*>;
   }
@@ -635,7 +774,9 @@ Status ExecutorImpl::Initialize() {
     item->input_start = frame_info->total_inputs;
     frame_info->total_inputs += n->num_inputs();
 
-    Status s = params_.create_kernel(n->def(), &item->kernel);
+    Status s = kernel_statuses.empty()
+                   ? params_.create_kernel(n->def(), &item->kernel)
+                   : kernel_statuses[id];
     if (!s.ok()) {
       item->kernel = nullptr;
       s = AttachDef(s, *n);
@@ -1000,6 +1141,17 @@ class ExecutorState {
                                     dead_result);
     }
 
+    // Returns the state to that of a new IterationState, so that it can be
+    // reused for another iteration of a frame with the same frame info.
+    void Reset(const PendingCounts* pending_counts, int total_input_tensors) {
+      for (int i = 0; i < total_input_tensors; ++i) {
+        input_tensors[i] = Entry();
+      }
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts_.CopyFrom(*pending_counts);
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
@@ -1075,6 +1227,11 @@ class ExecutorState {
     // The active iteration states of this frame.
     gtl::InlinedVector<IterationState*, 12> iterations;
 
+    // The states of completed iterations, which are reset and reused for
+    // new iterations instead of being reallocated. At most
+    // max_parallel_iterations + 1 are kept.
+    std::vector<IterationState*> free_iterations GUARDED_BY(mu);
+
     // The NextIteration nodes to enter a new iteration. If the number of
     // outstanding iterations reaches the limit, we will defer the start of
     // the next iteration until the number of outstanding iterations falls
@@ -1117,6 +1274,26 @@ class ExecutorState {
       return iterations[index];
     }
 
+    // Returns the state for a new iteration, reusing a free one if any.
+    IterationState* NewIteration() EXCLUSIVE_LOCKS_REQUIRED(mu) {
+      if (free_iterations.empty()) {
+        return new IterationState(pending_counts, total_input_tensors);
+      }
+      IterationState* state = free_iterations.back();
+      free_iterations.pop_back();
+      state->Reset(pending_counts, total_input_tensors);
+      return state;
+    }
+
+    // Keeps the state of a completed iteration for reuse.
+    void RecycleIteration(IterationState* state) EXCLUSIVE_LOCKS_REQUIRED(mu) {
+      if (free_iterations.size() < iterations.size()) {
+        free_iterations.push_back(state);
+      } else {
+        delete state;
+      }
+    }
+
     inline void SetIteration(int64 iter, IterationState* state)
         EXCLUSIVE_LOCKS_REQUIRED(mu) {
       size_t index = iter % iterations.size();
@@ -1186,6 +1363,9 @@ class ExecutorState {
         delete iterations[i];
         iterations[i] = nullptr;
       }
+      for (IterationState* state : free_iterations) {
+        delete state;
+      }
     }
   };
 
@@ -1240,6 +1420,18 @@ class ExecutorState {
     int front_index_;
   };
 
+  // A node handed to the work-stealing scheduler, together with the time it
+  // became ready.
+  struct ScheduledNode {
+    ScheduledNode() : tagged_node(nullptr, nullptr, -1, false) {}
+    ScheduledNode(const TaggedNode& node, int64 nsec)
+        : tagged_node(node), scheduled_nsec(nsec) {}
+
+    TaggedNode tagged_node;
+    int64 scheduled_nsec = 0;
+  };
+  typedef WorkStealingScheduler<ScheduledNode> NodeScheduler;
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1272,8 +1464,17 @@ class ExecutorState {
   std::unique_ptr<DeviceBase> user_device_;
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
+  const bool run_all_kernels_inline_;
   const bool trace_using_annotations_;
 
+  // If not null, dispatched nodes are run by these work-stealing workers
+  // instead of one runner_ closure per node. Owns a reference.
+  NodeScheduler* node_scheduler_ = nullptr;
+
+  // If not null, serves allocate_temp() for the kernels of this step.
+  // Released when the step finishes.
+  StepArenaAllocator* step_arena_ = nullptr;
+
   // Owned.
 
   // A flag that is set on error after the frame state has been
@@ -1288,6 +1489,13 @@ class ExecutorState {
 
   std::atomic_int_fast32_t num_outstanding_ops_;
 
+  // True if this step records scheduling metrics. The counts below are only
+  // updated when it is.
+  const bool sample_metrics_;
+  std::atomic<int64> num_queued_nodes_{0};
+  std::atomic<int64> num_inline_nodes_{0};
+  std::atomic<int64> num_dispatched_nodes_{0};
+
   // Available via OpKernelContext to every OpKernel invocation.
   mutex num_deferred_ops_mu_;
   int64 num_deferred_ops_ GUARDED_BY(num_deferred_ops_mu_) = 0;
@@ -1303,6 +1511,12 @@ class ExecutorState {
   // name of the new frame from nodedef.
   gtl::FlatMap<string, FrameState*> outstanding_frames_ GUARDED_BY(mu_);
 
+  // The free iteration states of deleted frames, keyed by the pending counts
+  // of their frame info, for reuse by later frames of the same loop, e.g.
+  // the inner loop of a nested loop.
+  gtl::FlatMap<const PendingCounts*, std::vector<IterationState*>>
+      free_iterations_ GUARDED_BY(mu_);
+
   // The unique name of a frame.
   inline string MakeFrameName(FrameState* frame, int64 iter_id,
                               const string& name) {
@@ -1353,6 +1567,10 @@ class ExecutorState {
   void ScheduleReady(const TaggedNodeSeq& ready,
                      TaggedNodeReadyQueue* inline_ready);
 
+  // Runs 'tagged_node' on another thread, either through runner_ or the
+  // work-stealing scheduler.
+  void Dispatch(const TaggedNode& tagged_node, int64 scheduled_nsec);
+
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
 
@@ -1405,13 +1623,27 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
+      run_all_kernels_inline_(args.run_all_kernels_inline),
       trace_using_annotations_(impl->params_.device->TraceUsingAnnotations()),
-      num_outstanding_ops_(0) {
+      num_outstanding_ops_(0),
+      sample_metrics_(metrics::ShouldSampleExecutorStep()) {
   if (args.user_intra_op_threadpool != nullptr) {
     Device* device = impl_->params_.device;
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (impl_->work_stealing_workers_ > 0) {
+    node_scheduler_ = new NodeScheduler(
+        impl_->work_stealing_workers_, runner_,
+        [this](ScheduledNode node) {
+          Process(node.tagged_node, node.scheduled_nsec);
+        });
+  }
+  if (impl_->use_step_arena_) {
+    step_arena_ = new StepArenaAllocator(
+        impl_->params_.device->GetAllocator(AllocatorAttributes()),
+        impl_->step_arena_block_size_.load(std::memory_order_relaxed));
+  }
 
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
@@ -1432,6 +1664,27 @@ ExecutorState::~ExecutorState() {
   for (auto name_frame : outstanding_frames_) {
     delete name_frame.second;
   }
+  for (auto& free_iterations : free_iterations_) {
+    for (IterationState* state : free_iterations.second) {
+      delete state;
+    }
+  }
+  if (sample_metrics_) {
+    metrics::RecordExecutorReadyNodes(num_inline_nodes_.load(),
+                                      num_dispatched_nodes_.load());
+  }
+  if (node_scheduler_ != nullptr) {
+    metrics::RecordExecutorWorkStealing(node_scheduler_->num_local_hits(),
+                                        node_scheduler_->num_steals());
+    node_scheduler_->Unref();
+  }
+  if (step_arena_ != nullptr) {
+    const size_t block_size =
+        std::min(std::max(step_arena_->bytes_used(), kMinStepArenaBlockSize),
+                 kMaxStepArenaBlockSize);
+    impl_->step_arena_block_size_.store(block_size, std::memory_order_relaxed);
+    step_arena_->Release();
+  }
   for (auto it : device_context_map_) {
     it->Unref();
   }
@@ -1623,6 +1876,16 @@ bool MightTrace(const NodeItem& item,
 }
 
 void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
+  if (sample_metrics_) {
+    const int64 num_queued =
+        num_queued_nodes_.fetch_sub(1, std::memory_order_relaxed);
+    DCHECK_GT(num_queued, 0) << "Processing a node that was not queued";
+    const int64 now_nsec = nodestats::NowInNsec();
+    if (now_nsec > scheduled_nsec) {
+      metrics::RecordExecutorSchedulingDelay((now_nsec - scheduled_nsec) /
+                                             EnvTime::kMicrosToNanos);
+    }
+  }
   WithContext wc(context_);
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
@@ -1656,6 +1919,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
   params.function_library = impl_->params_.function_library;
   params.resource_manager = device->resource_manager();
   params.step_container = step_container_;
+  params.step_temp_allocator = step_arena_;
   params.slice_reader_cache = slice_reader_cache_;
   params.inputs = &inputs;
   params.input_device_contexts = &input_device_contexts;
@@ -1761,6 +2025,12 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
       params.forward_from_array = item.forward_from();
+      params.input_forwardable_array = item.input_forwardable();
+      // Attributes the allocations of the kernel to it in memory profiles.
+      ScopedMemoryDebugAnnotation memory_annotation(op_kernel->name().c_str(),
+                                                    step_id_);
+      // Tags CPU profile samples taken while the kernel runs with it.
+      profiler::ScopedOpContext op_context(op_kernel->name().c_str());
 
       if (item.kernel_is_async) {
         // Asynchronous computes.
@@ -2298,18 +2568,48 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   if (ready.empty()) return;
 
   int64 scheduled_nsec = 0;
-  if (stats_collector_) {
+  if (stats_collector_ || sample_metrics_) {
     scheduled_nsec = nodestats::NowInNsec();
   }
 
+  if (run_all_kernels_inline_) {
+    if (inline_ready == nullptr) {
+      // The nodes wait in `runner_` like dispatched nodes do, and each of
+      // them goes through Process().
+      if (sample_metrics_) {
+        num_dispatched_nodes_.fetch_add(ready.size(),
+                                        std::memory_order_relaxed);
+        metrics::RecordExecutorQueueDepth(num_queued_nodes_.fetch_add(
+            ready.size(), std::memory_order_relaxed));
+      }
+      // Run all the ready ops from a single closure, so that they run one
+      // after another on the same thread whatever `runner_` does.
+      runner_([this, ready, scheduled_nsec]() {
+        for (auto& tagged_node : ready) {
+          Process(tagged_node, scheduled_nsec);
+        }
+      });
+    } else {
+      for (auto& tagged_node : ready) {
+        inline_ready->push_back(tagged_node);
+      }
+      if (sample_metrics_) {
+        num_inline_nodes_.fetch_add(ready.size(), std::memory_order_relaxed);
+      }
+    }
+    return;
+  }
+
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_nsec); });
+      Dispatch(tagged_node, scheduled_nsec);
     }
     return;
   }
 
+  const size_t num_inline_before = inline_ready->size();
+
   const GraphView& gview = impl_->gview_;
   const TaggedNode* curr_expensive_node = nullptr;
   for (auto& tagged_node : ready) {
@@ -2321,8 +2621,7 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
       if (curr_expensive_node) {
         // Dispatch to another thread since there is plenty of work to
         // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_nsec));
+        Dispatch(*curr_expensive_node, scheduled_nsec);
       }
       curr_expensive_node = &tagged_node;
     }
@@ -2334,10 +2633,31 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     } else {
       // There are inline nodes to run already. We dispatch this expensive
       // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_nsec));
+      Dispatch(*curr_expensive_node, scheduled_nsec);
     }
   }
+  if (sample_metrics_) {
+    num_inline_nodes_.fetch_add(inline_ready->size() - num_inline_before,
+                                std::memory_order_relaxed);
+  }
+}
+
+void ExecutorState::Dispatch(const TaggedNode& tagged_node,
+                             int64 scheduled_nsec) {
+  if (sample_metrics_) {
+    num_dispatched_nodes_.fetch_add(1, std::memory_order_relaxed);
+    metrics::RecordExecutorQueueDepth(
+        num_queued_nodes_.fetch_add(1, std::memory_order_relaxed));
+  }
+  if (node_scheduler_ != nullptr) {
+    // Nodes dispatched from a worker stay on that worker's queue, where it
+    // picks them up as soon as it finishes the current node, unless an idle
+    // worker steals them first.
+    node_scheduler_->Schedule(ScheduledNode(tagged_node, scheduled_nsec));
+  } else {
+    runner_(std::bind(&ExecutorState::Process, this, tagged_node,
+                      scheduled_nsec));
+  }
 }
 
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
@@ -2596,9 +2916,21 @@ void ExecutorState::FindOrCreateChildFrame(FrameState* frame, int64 iter,
 
   // 'iterations' is a fixed-length circular buffer.
   temp->iterations.resize(temp->max_parallel_iterations + 1);
-  // Initialize iteration 0.
-  temp->iterations[0] =
-      new IterationState(temp->pending_counts, temp->total_input_tensors);
+  {
+    mutex_lock executor_lock(mu_);
+    mutex_lock frame_lock(temp->mu);
+    auto it = free_iterations_.find(temp->pending_counts);
+    if (it != free_iterations_.end()) {
+      std::vector<IterationState*>& free_iterations = it->second;
+      while (!free_iterations.empty() &&
+             temp->free_iterations.size() < temp->iterations.size()) {
+        temp->free_iterations.push_back(free_iterations.back());
+        free_iterations.pop_back();
+      }
+    }
+    // Initialize iteration 0.
+    temp->iterations[0] = temp->NewIteration();
+  }
 
   {
     mutex_lock executor_lock(mu_);
@@ -2673,6 +3005,14 @@ void ExecutorState::DeleteFrame(FrameState* frame, TaggedNodeSeq* ready) {
   {
     mutex_lock executor_lock(mu_);
     outstanding_frames_.erase(frame_name);
+    mutex_lock frame_lock(frame->mu);
+    std::vector<IterationState*>& free_iterations =
+        free_iterations_[frame->pending_counts];
+    while (!frame->free_iterations.empty() &&
+           free_iterations.size() < frame->iterations.size()) {
+      free_iterations.push_back(frame->free_iterations.back());
+      frame->free_iterations.pop_back();
+    }
   }
   delete frame;
 }
@@ -2854,9 +3194,7 @@ void ExecutorState::FrameState::IncrementIteration(const GraphView* gview,
   const int64 next_iter = iteration_count;
 
   // Initialize the next iteration.
-  IterationState* iter_state =
-      new IterationState(pending_counts, total_input_tensors);
-  SetIteration(next_iter, iter_state);
+  SetIteration(next_iter, NewIteration());
   num_outstanding_iterations++;
   dead_exits.clear();
 
@@ -2873,7 +3211,7 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
     // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    RecycleIteration(GetIteration(curr_iter));
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -2941,6 +3279,41 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the "WORK_STEALING" executor, which runs the default executor's
+// algorithm but dispatches ready nodes to a bounded set of per-step workers
+// with work stealing. The number of workers defaults to the number of
+// schedulable CPUs and can be overridden with the
+// TF_WORK_STEALING_EXECUTOR_MAX_WORKERS environment variable.
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      int64 max_workers;
+      TF_RETURN_IF_ERROR(
+          ReadInt64FromEnvVar("TF_WORK_STEALING_EXECUTOR_MAX_WORKERS",
+                              port::MaxParallelism(), &max_workers));
+      if (max_workers <= 0) {
+        return errors::InvalidArgument(
+            "TF_WORK_STEALING_EXECUTOR_MAX_WORKERS must be positive, got ",
+            max_workers);
+      }
+      auto impl = absl::make_unique<ExecutorImpl>(params, std::move(graph),
+                                                  max_workers);
+      TF_RETURN_IF_ERROR(impl->Initialize());
+      *out_executor = std::move(impl);
+      return Status::OK();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -103,6 +103,12 @@ class Executor {
     // If true, calls Sync() on the device.
     bool sync_on_finish = false;
 
+    // If true, all kernels of the step run sequentially: nodes that become
+    // ready are run by the thread that made them ready, and nodes that become
+    // ready outside of the executor (e.g. when an async kernel completes) are
+    // run from a single `runner` closure.
+    bool run_all_kernels_inline = false;
+
     typedef std::function<void()> Closure;
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
@@ -144,6 +150,11 @@ struct LocalExecutorParams {
   std::function<Status(const NodeDef&, OpKernel**)> create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
 
+  // If true, the kernels of large graphs are created concurrently on a shared
+  // thread pool, which requires `create_kernel` to be thread-safe. Setting
+  // TF_EXECUTOR_PARALLEL_KERNEL_CREATION=true enables it for all executors.
+  bool parallel_kernel_creation = false;
+
   Executor::RendezvousFactory rendezvous_factory;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
@@ -16,10 +16,13 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/op.h"
@@ -28,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
@@ -57,15 +61,19 @@ class ExecutorTest : public ::testing::Test {
   }
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "",
+              bool parallel_kernel_creation = false) {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
     params.create_kernel = [this, version](const NodeDef& ndef,
                                            OpKernel** kernel) {
+      num_kernels_created_.fetch_add(1);
       return CreateNonCachedKernel(device_.get(), nullptr, ndef, version,
                                    kernel);
     };
+    params.parallel_kernel_creation = parallel_kernel_creation;
     params.delete_kernel = [](OpKernel* kernel) {
       DeleteNonCachedKernel(kernel);
     };
@@ -77,15 +85,18 @@ class ExecutorTest : public ::testing::Test {
       return Status::OK();
     };
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, std::move(graph), &exec_));
+    std::unique_ptr<Executor> exec;
+    TF_CHECK_OK(NewExecutor(executor_type, params, std::move(graph), &exec));
+    exec_ = exec.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
-  Status Run(Rendezvous* rendez) {
+  Status Run(Rendezvous* rendez, bool run_all_kernels_inline = false) {
     Executor::Args args;
     args.rendezvous = rendez;
     args.stats_collector = &step_stats_collector_;
     args.runner = runner_;
+    args.run_all_kernels_inline = run_all_kernels_inline;
     return exec_->Run(args);
   }
 
@@ -96,6 +107,7 @@ class ExecutorTest : public ::testing::Test {
   StepStats step_stats_;
   Executor::Args::Runner runner_;
   Rendezvous* rendez_ = nullptr;
+  std::atomic<int> num_kernels_created_{0};
 };
 
 // A float val -> Tensor<float>
@@ -200,6 +212,54 @@ TEST_F(ExecutorTest, SelfAdd) {
   EXPECT_EQ(1024.0, V(out));  // b=v10=2*v9=4*v8=...=1024*a=1024.0
 }
 
+int64 ReadyNodesCount(const string& dispatch) {
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  options.collect_metric_descriptors = false;
+  const auto metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(options);
+  const auto it =
+      metrics->point_set_map.find("/tensorflow/core/executor_ready_nodes");
+  if (it == metrics->point_set_map.end()) return 0;
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == dispatch) {
+      return point->int64_value;
+    }
+  }
+  return 0;
+}
+
+TEST_F(ExecutorTest, SampledMetricsWithRunAllKernelsInline) {
+  // v1 = a + a, ..., v10 = v9 + v9, b <- v10
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto v = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  const int N = 10;
+  for (int i = 1; i <= N; ++i) {
+    v = test::graph::Add(g.get(), v, v);
+  }
+  test::graph::Send(g.get(), v, "b", BOB, 1, ALICE);
+  Create(std::move(g));
+
+  metrics::SetExecutorMetricsSampleRateForTesting(1);
+  const int64 inline_before = ReadyNodesCount("inline");
+  const int64 dispatched_before = ReadyNodesCount("dispatched");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  // Every node that runs is accounted for as queued before it is processed,
+  // which Process() checks in debug builds.
+  TF_ASSERT_OK(Run(rendez_, /*run_all_kernels_inline=*/true));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(1024.0, V(out));
+  metrics::SetExecutorMetricsSampleRateForTesting(100);
+
+  // The root nodes are dispatched; the adds and the send run inline.
+  EXPECT_GE(ReadyNodesCount("dispatched") - dispatched_before, 1);
+  EXPECT_GE(ReadyNodesCount("inline") - inline_before, N + 1);
+}
+
 // Builds a graph which adds N copies of one variable "in". I.e.,
 //     a + a + a + ... + a
 // The returned graph is parenthesized ramdonly. I.e.,
@@ -250,6 +310,40 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, ParallelKernelCreation) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  const int num_nodes = g->num_nodes();
+  Create(std::move(g), "", /*parallel_kernel_creation=*/true);
+  // Every kernel is created exactly once, before the graph runs.
+  EXPECT_EQ(num_nodes, num_kernels_created_.load());
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+  EXPECT_EQ(num_nodes, num_kernels_created_.load());
+}
+
+TEST_F(ExecutorTest, WorkStealingRandomTree) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  Create(std::move(g), "WORK_STEALING");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -285,6 +379,23 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, WorkStealingConcurrentAddAssign) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildConcurrentAddAssign(g.get());
+  Create(std::move(g), "WORK_STEALING");
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
@@ -751,6 +752,7 @@ Status FunctionLibraryRuntimeImpl::Instantiate(
 
   const FunctionLibraryDefinition* lib_def =
       options.lib_def ? options.lib_def : base_lib_def_;
+  ScopedCompilationPhase phase(kCompilationPhaseFunction, function_name);
   std::unique_ptr<FunctionBody> fbody;
   if (function_name == kGradientOp) {
     const AttrValue* f = attrs.Find(kFuncAttr);
@@ -773,6 +775,7 @@ Status FunctionLibraryRuntimeImpl::Instantiate(
     }
     TF_RETURN_IF_ERROR(FunctionDefToBody(*fdef, attrs, lib_def, &fbody));
   }
+  phase.set_nodes_after(fbody->graph->num_op_nodes());
 
   LocalHandle local_handle;
   {
@@ -926,6 +929,11 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Item** item) {
   }
   const FunctionLibraryDefinition* lib_def =
       flr->GetFunctionLibraryDefinition();
+  // Optimizes the function body and constructs its kernels.
+  ScopedCompilationPhase phase(
+      kCompilationPhaseFunction,
+      strings::StrCat(fbody->fdef.signature().name(), ":executor"),
+      fbody->graph->num_op_nodes());
   std::unique_ptr<Graph> g(new Graph(lib_def));
   CopyGraph(*fbody->graph, g.get());
 
@@ -951,6 +959,7 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Item** item) {
   };
   params.rendezvous_factory = (*item)->rendezvous_factory;
   Graph* graph = g.get();
+  phase.set_nodes_after(graph->num_op_nodes());
   std::unique_ptr<Executor> exec;
   TF_RETURN_IF_ERROR(NewExecutor(executor_type, params, std::move(g), &exec));
   {
@@ -999,6 +1008,7 @@ void FunctionLibraryRuntimeImpl::ExecutorArgsFromOptions(
   }
   exec_args->collective_executor = run_opts.collective_executor;
   exec_args->call_frame = frame;
+  exec_args->run_all_kernels_inline = run_opts.run_all_kernels_inline;
 }
 
 void FunctionLibraryRuntimeImpl::RunRemote(const Options& opts, Handle handle,
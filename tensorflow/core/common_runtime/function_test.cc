@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/equal_graph_def.h"
@@ -392,6 +393,20 @@ TEST_F(FunctionLibraryRuntimeTest, XTimesTwo) {
   test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4, 6, 8}));
 }
 
+TEST_F(FunctionLibraryRuntimeTest, XTimesTwoRunAllKernelsInline) {
+  Init({test::function::XTimesTwo()});
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(Instantiate(flr0_, "XTimesTwo", {{"T", DT_FLOAT}}, &handle));
+  FunctionLibraryRuntime::Options opts;
+  opts.run_all_kernels_inline = true;
+  auto x = test::AsTensor<float>({1, 2, 3, 4});
+  Tensor y;
+  TF_CHECK_OK(Run(flr0_, handle, opts, {x}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4, 6, 8}));
+  TF_CHECK_OK(Run(flr0_, handle, opts, {x}, {&y}, /*add_runner=*/false));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4, 6, 8}));
+}
+
 TEST_F(FunctionLibraryRuntimeTest, XTimesN) {
   Init({test::function::XTimesTwo(), test::function::XTimesFour(),
         test::function::XTimes16()});
@@ -2071,5 +2086,46 @@ TEST(OptimizationTest, RemoveListArrayConverter_WithContolDeps) {
   TF_EXPECT_GRAPH_EQ(expected, Optimize(remove_listarray_and_identity, func));
 }
 
+// Measures the per-call overhead of running an already instantiated function
+// through the FunctionLibraryRuntime, with closures run inline.
+static void BM_FunctionCall(int iters) {
+  testing::StopTiming();
+  SessionOptions options;
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_CHECK_OK(DeviceFactory::AddDevices(
+      options, "/job:localhost/replica:0/task:0", &devices));
+  FunctionDefLibrary proto;
+  *proto.add_function() = test::function::XTimesTwo();
+  FunctionLibraryDefinition lib_def(OpRegistry::Global(), proto);
+  DeviceMgr device_mgr(std::move(devices));
+  ProcessFunctionLibraryRuntime pflr(&device_mgr, Env::Default(),
+                                     TF_GRAPH_DEF_VERSION, &lib_def,
+                                     OptimizerOptions());
+  FunctionLibraryRuntime* flr =
+      pflr.GetFLR("/job:localhost/replica:0/task:0/cpu:0");
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(flr->Instantiate(
+      "XTimesTwo", test::function::Attrs({{"T", DT_FLOAT}}), &handle));
+
+  std::function<void(std::function<void()>)> runner =
+      [](std::function<void()> fn) { fn(); };
+  FunctionLibraryRuntime::Options opts;
+  opts.runner = &runner;
+  const std::vector<Tensor> args = {test::AsTensor<float>({1, 2, 3, 4})};
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    std::vector<Tensor> rets;
+    Notification done;
+    flr->Run(opts, handle, args, &rets, [&done](const Status& s) {
+      TF_CHECK_OK(s);
+      done.Notify();
+    });
+    done.WaitForNotification();
+  }
+  testing::StopTiming();
+  TF_CHECK_OK(flr->ReleaseHandle(handle));
+}
+BENCHMARK(BM_FunctionCall);
+
 }  // namespace
 }  // namespace tensorflow
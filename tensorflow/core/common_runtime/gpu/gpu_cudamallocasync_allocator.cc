@@ -0,0 +1,230 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/stream_executor/cuda/cuda_activation.h"
+#endif  // GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+// The stream-ordered allocator and memory pools were added in CUDA 11.2.
+#if defined(GOOGLE_CUDA) && GOOGLE_CUDA && CUDA_VERSION >= 11020
+#define TF_CUDA_MALLOC_ASYNC_SUPPORTED 1
+#endif
+
+namespace tensorflow {
+
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+namespace {
+
+string CudaErrorString(CUresult result) {
+  const char* error_string = nullptr;
+  if (cuGetErrorString(result, &error_string) != CUDA_SUCCESS ||
+      error_string == nullptr) {
+    return strings::StrCat("CUDA error ", static_cast<int>(result));
+  }
+  return error_string;
+}
+
+}  // namespace
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+
+GPUcudaMallocAsyncAllocator::GPUcudaMallocAsyncAllocator(
+    PlatformGpuId platform_gpu_id, size_t pool_size, size_t release_threshold,
+    const string& name)
+    : pool_size_(pool_size), name_(name) {
+  stream_exec_ =
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie();
+  stats_.bytes_limit = static_cast<int64>(pool_size);
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUmemPoolProps props = {};
+  props.allocType = CU_MEM_ALLOCATION_TYPE_PINNED;
+  props.handleTypes = CU_MEM_HANDLE_TYPE_NONE;
+  props.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+  props.location.id = platform_gpu_id.value();
+  CUmemoryPool pool;
+  CUresult result = cuMemPoolCreate(&pool, &props);
+  if (result != CUDA_SUCCESS) {
+    LOG(FATAL) << "cuMemPoolCreate failed for GPU " << platform_gpu_id.value()
+               << ": " << CudaErrorString(result);
+  }
+  pool_ = pool;
+
+  cuuint64_t threshold = release_threshold > 0 ? release_threshold : pool_size;
+  result = cuMemPoolSetAttribute(pool, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD,
+                                 &threshold);
+  if (result != CUDA_SUCCESS) {
+    LOG(ERROR) << "Failed to set the release threshold of the memory pool of "
+               << name_ << ": " << CudaErrorString(result);
+  }
+  VLOG(1) << "Created " << name_ << " with a memory pool of at most "
+          << pool_size << " bytes, keeping " << threshold
+          << " bytes reserved.";
+#else
+  LOG(FATAL) << "GPUcudaMallocAsyncAllocator requires CUDA 11.2 or later.";
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+GPUcudaMallocAsyncAllocator::~GPUcudaMallocAsyncAllocator() {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  if (pool_ != nullptr) {
+    // Frees still pending on the stream must complete before the pool goes.
+    stream_exec_->SynchronizeAllActivity();
+    se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+    cuMemPoolDestroy(static_cast<CUmemoryPool>(pool_));
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+/*static*/ bool GPUcudaMallocAsyncAllocator::IsSupported(
+    PlatformGpuId platform_gpu_id) {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  int driver_version = 0;
+  if (cuDriverGetVersion(&driver_version) != CUDA_SUCCESS ||
+      driver_version < 11020) {
+    return false;
+  }
+  CUdevice device;
+  if (cuDeviceGet(&device, platform_gpu_id.value()) != CUDA_SUCCESS) {
+    return false;
+  }
+  int pools_supported = 0;
+  if (cuDeviceGetAttribute(&pools_supported,
+                           CU_DEVICE_ATTRIBUTE_MEMORY_POOLS_SUPPORTED,
+                           device) != CUDA_SUCCESS) {
+    return false;
+  }
+  return pools_supported != 0;
+#else
+  return false;
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void GPUcudaMallocAsyncAllocator::SetStream(se::Stream* stream) {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  mutex_lock l(mu_);
+  stream_ = *reinterpret_cast<CUstream*>(
+      stream->implementation()->GpuStreamMemberHack());
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void* GPUcudaMallocAsyncAllocator::AllocateRaw(size_t alignment,
+                                               size_t num_bytes) {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  // Pool allocations are aligned to at least 256 bytes, which is more than
+  // Allocator::kAllocatorAlignment.
+  mutex_lock l(mu_);
+  if (stats_.bytes_in_use + static_cast<int64>(num_bytes) >
+      static_cast<int64>(pool_size_)) {
+    LOG(WARNING) << name_ << " ran out of memory trying to allocate "
+                 << num_bytes << " bytes with " << stats_.bytes_in_use
+                 << " of " << pool_size_ << " bytes in use.";
+    return nullptr;
+  }
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUdeviceptr ptr = 0;
+  CUresult result =
+      cuMemAllocFromPoolAsync(&ptr, num_bytes, static_cast<CUmemoryPool>(pool_),
+                              static_cast<CUstream>(stream_));
+  if (result != CUDA_SUCCESS) {
+    LOG(ERROR) << "cuMemAllocFromPoolAsync failed to allocate " << num_bytes
+               << " bytes: " << CudaErrorString(result);
+    return nullptr;
+  }
+  void* rv = reinterpret_cast<void*>(ptr);
+  sizes_[rv] = num_bytes;
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += num_bytes;
+  stats_.peak_bytes_in_use =
+      std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  stats_.largest_alloc_size =
+      std::max<int64>(stats_.largest_alloc_size, num_bytes);
+  return rv;
+#else
+  return nullptr;
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void GPUcudaMallocAsyncAllocator::DeallocateRaw(void* ptr) {
+#ifdef TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  if (ptr == nullptr) return;
+  mutex_lock l(mu_);
+  auto it = sizes_.find(ptr);
+  CHECK(it != sizes_.end()) << "Freeing a pointer unknown to " << name_;
+  stats_.bytes_in_use -= it->second;
+  sizes_.erase(it);
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUresult result = cuMemFreeAsync(reinterpret_cast<CUdeviceptr>(ptr),
+                                   static_cast<CUstream>(stream_));
+  if (result != CUDA_SUCCESS) {
+    LOG(ERROR) << "cuMemFreeAsync failed to free " << ptr << ": "
+               << CudaErrorString(result);
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+size_t GPUcudaMallocAsyncAllocator::RequestedSize(const void* ptr) const {
+  mutex_lock l(mu_);
+  auto it = sizes_.find(ptr);
+  CHECK(it != sizes_.end()) << "Asked for the size of a pointer unknown to "
+                            << name_;
+  return it->second;
+}
+
+size_t GPUcudaMallocAsyncAllocator::AllocatedSize(const void* ptr) const {
+  return RequestedSize(ptr);
+}
+
+absl::optional<AllocatorStats> GPUcudaMallocAsyncAllocator::GetStats() {
+  mutex_lock l(mu_);
+#if defined(TF_CUDA_MALLOC_ASYNC_SUPPORTED) && CUDA_VERSION >= 11030
+  // The pool reports how much memory it holds from the driver, which
+  // includes the freed blocks kept below the release threshold.
+  cuuint64_t reserved = 0;
+  cuuint64_t peak_reserved = 0;
+  CUmemoryPool pool = static_cast<CUmemoryPool>(pool_);
+  if (cuMemPoolGetAttribute(pool, CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT,
+                            &reserved) == CUDA_SUCCESS &&
+      cuMemPoolGetAttribute(pool, CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH,
+                            &peak_reserved) == CUDA_SUCCESS) {
+    stats_.bytes_reserved = static_cast<int64>(reserved);
+    stats_.peak_bytes_reserved = static_cast<int64>(peak_reserved);
+  }
+#endif
+  return stats_;
+}
+
+void GPUcudaMallocAsyncAllocator::ClearStats() {
+  mutex_lock l(mu_);
+  stats_.num_allocs = 0;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.largest_alloc_size = 0;
+#if defined(TF_CUDA_MALLOC_ASYNC_SUPPORTED) && CUDA_VERSION >= 11030
+  // Setting the high watermark resets it to the current reserved size.
+  cuuint64_t zero = 0;
+  cuMemPoolSetAttribute(static_cast<CUmemoryPool>(pool_),
+                        CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH, &zero);
+#endif
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,86 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
+
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_id.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator built on CUDA's stream-ordered allocator
+// (cuMemAllocFromPoolAsync and cuMemFreeAsync, CUDA 11.2 and later).
+//
+// Each allocator owns a memory pool on its GPU. Allocations and frees are
+// ordered on the stream set with SetStream(), normally the compute stream of
+// the GPUDevice, so a freed block may be handed out again as soon as the work
+// queued before the free has run, without waiting for the host to observe it.
+// Memory freed to the pool stays reserved up to `release_threshold` bytes and
+// any excess is returned to the driver when the stream synchronizes.
+//
+// Requests that would bring the bytes in use above `pool_size` fail, like
+// they do for the BFC allocator.
+class GPUcudaMallocAsyncAllocator : public Allocator {
+ public:
+  // A `release_threshold` of 0 keeps up to `pool_size` bytes reserved.
+  GPUcudaMallocAsyncAllocator(PlatformGpuId platform_gpu_id, size_t pool_size,
+                              size_t release_threshold, const string& name);
+  ~GPUcudaMallocAsyncAllocator() override;
+
+  // Returns true if the CUDA driver and the GPU support memory pools.
+  static bool IsSupported(PlatformGpuId platform_gpu_id);
+
+  // Sets the stream that subsequent allocations and frees are ordered on.
+  // Until it is called, the legacy default stream is used, which orders them
+  // with respect to all the other blocking streams of the GPU.
+  void SetStream(se::Stream* stream);
+
+  string Name() override { return name_; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override { return true; }
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override;
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+ private:
+  se::StreamExecutor* stream_exec_;  // Not owned.
+  const size_t pool_size_;
+  const string name_;
+
+  // CUmemoryPool and CUstream, kept opaque so that this header does not
+  // depend on the CUDA headers.
+  void* pool_ = nullptr;
+  void* stream_ = nullptr;
+
+  mutable mutex mu_;
+  std::unordered_map<const void*, size_t> sizes_ GUARDED_BY(mu_);
+  AllocatorStats stats_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUcudaMallocAsyncAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
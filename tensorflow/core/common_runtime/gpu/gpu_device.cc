@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
@@ -374,6 +375,12 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
         i, streams_.back()->compute, streams_.back()->host_to_device,
         streams_.back()->device_to_host, streams_.back()->device_to_device));
   }
+  // Order the allocations of a stream-ordered allocator on the compute
+  // stream, which is where most tensors are produced and consumed.
+  if (auto* async_allocator =
+          dynamic_cast<GPUcudaMallocAsyncAllocator*>(gpu_allocator_)) {
+    async_allocator->SetStream(streams_[0]->compute);
+  }
 
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
@@ -26,6 +26,35 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Returns the number of compute streams requested for each GPUDevice.
+int32 NumComputeStreams(const SessionOptions& options) {
+  const GPUOptions::Experimental& experimental =
+      options.config.gpu_options().experimental();
+  int32 num_streams = experimental.num_compute_streams();
+  if (num_streams == 0) num_streams = 1;
+  if (num_streams < 1 || num_streams > 8) {
+    LOG(ERROR) << "Illegal GPUOptions.experimental.num_compute_streams="
+               << num_streams << " set to 1 instead.";
+    num_streams = 1;
+  }
+  if (num_streams > 1 &&
+      (experimental.timestamped_allocator() ||
+       experimental.kernel_tracker_max_interval() > 0 ||
+       experimental.kernel_tracker_max_bytes() > 0 ||
+       experimental.kernel_tracker_max_pending() > 0)) {
+    LOG(WARNING) << "GPUOptions.experimental.num_compute_streams="
+                 << num_streams << " is not supported together with "
+                 << "timestamped_allocator or kernel tracking; using a single "
+                 << "compute stream.";
+    num_streams = 1;
+  }
+  return num_streams;
+}
+
+}  // namespace
+
 class GPUDevice : public BaseGPUDevice {
  public:
   GPUDevice(const SessionOptions& options, const string& name,
@@ -34,7 +63,8 @@ class GPUDevice : public BaseGPUDevice {
             Allocator* gpu_allocator, Allocator* cpu_allocator)
       : BaseGPUDevice(options, name, memory_limit, locality, tf_gpu_id,
                       physical_device_desc, gpu_allocator, cpu_allocator,
-                      false /* sync every op */, 1 /* max_streams */) {
+                      false /* sync every op */,
+                      NumComputeStreams(options) /* max_streams */) {
     if (options.config.has_gpu_options()) {
       force_gpu_compatible_ =
           options.config.gpu_options().force_gpu_compatible();
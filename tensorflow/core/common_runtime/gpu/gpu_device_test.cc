@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -346,6 +348,61 @@ TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   }
 }
 
+TEST_F(GPUDeviceTest, IsGpuHostMemory) {
+  SessionOptions opts = MakeSessionOptions("0");
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  GPUProcessState* process_state = GPUProcessState::singleton();
+
+  constexpr int kNumElements = 1024;
+  Tensor pinned(process_state->GetGpuHostAllocator(0), DT_FLOAT,
+                TensorShape({kNumElements}));
+  Tensor pageable(cpu_allocator(), DT_FLOAT, TensorShape({kNumElements}));
+  const float* pinned_data = pinned.flat<float>().data();
+  EXPECT_TRUE(process_state->IsGpuHostMemory(pinned_data));
+  EXPECT_TRUE(process_state->IsGpuHostMemory(pinned_data + kNumElements - 1));
+  EXPECT_FALSE(process_state->IsGpuHostMemory(DMAHelper::base(&pageable)));
+}
+
+// Copies of pageable tensors of at least 1MB go through the pinned staging
+// buffers of the GPU, which concurrent copies take turns using.  Staged
+// copies are only made in this test, since the buffers come from the pinned
+// host allocator that TearDown destroys.
+TEST_F(GPUDeviceTest, StagedCopyOfPageableTensors) {
+  SessionOptions opts = MakeSessionOptions("0");
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  Device* device = devices[0].get();
+  auto* device_info = device->tensorflow_gpu_device_info();
+  CHECK(device_info);
+  DeviceContext* device_context = device_info->default_context;
+  Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+
+  // Just over 9MB, so that the last of the 4MB chunks is partial.
+  constexpr int kNumElements = (9 << 18) + 3;
+  constexpr int kNumCopies = 4;
+  thread::ThreadPool pool(Env::Default(), "staged_copies", kNumCopies);
+  for (int c = 0; c < kNumCopies; ++c) {
+    pool.Schedule([this, c, device, device_context, allocator]() {
+      Tensor cpu_tensor(cpu_allocator(), DT_FLOAT, TensorShape({kNumElements}));
+      auto input = cpu_tensor.flat<float>();
+      for (int i = 0; i < kNumElements; ++i) input(i) = c * 1000 + i % 1000;
+      Tensor gpu_tensor(allocator, DT_FLOAT, TensorShape({kNumElements}));
+      CopyCPUToGPU(&cpu_tensor, &gpu_tensor, device, device_context);
+
+      Tensor output_cpu_tensor(cpu_allocator(), DT_FLOAT,
+                               TensorShape({kNumElements}));
+      CopyGPUToCPU(&gpu_tensor, &output_cpu_tensor, device, device_context);
+      auto output = output_cpu_tensor.flat<float>();
+      for (int i = 0; i < kNumElements; ++i) {
+        ASSERT_EQ(input(i), output(i)) << " for copy " << c << " index " << i;
+      }
+    });
+  }
+}
+
 class GPUKernelTrackerTest : public ::testing::Test {
  protected:
   void Init(const GPUKernelTracker::Params& params) {
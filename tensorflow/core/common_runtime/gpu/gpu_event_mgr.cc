@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 
+#include <chrono>  // NOLINT
+
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -27,6 +29,10 @@ namespace {
 //  - Is this the right number of threads?
 //  - Should EventMgrs be shared between GPUDevices on a multi-GPU machine?
 static const int kNumThreads = 2;
+
+// How long the destructor waits for the host callbacks that are still
+// pending once the device is idle.
+static const uint64 kMaxHostCallbackWaitUsecs = 1000000;
 }  // namespace
 
 namespace gpu_event_mgr {
@@ -97,6 +103,8 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      use_host_callbacks_(
+          gpu_options.experimental().use_host_callbacks_in_event_mgr()),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
@@ -106,7 +114,31 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
 }
 
 EventMgr::~EventMgr() {
+  if (use_host_callbacks_) {
+    // Host callbacks refer to this object, so wait for them to run.  Once the
+    // device is idle, any callback that is still pending was dropped by a
+    // failed stream and will never run, so the wait is bounded.
+    if (!exec_->SynchronizeAllActivity()) {
+      LOG(ERROR) << "Failed to synchronize the device before destroying its "
+                    "EventMgr";
+    }
+    mutex_lock l(mu_);
+    const uint64 deadline_micros =
+        Env::Default()->NowMicros() + kMaxHostCallbackWaitUsecs;
+    while (pending_callbacks_ > 0) {
+      const uint64 now_micros = Env::Default()->NowMicros();
+      if (now_micros >= deadline_micros) {
+        LOG(ERROR) << "Destroying EventMgr with " << pending_callbacks_
+                   << " host callbacks that did not run";
+        break;
+      }
+      events_pending_.wait_for(
+          l, std::chrono::microseconds(deadline_micros - now_micros));
+    }
+  }
   StopPollingLoop();
+  FreeMemory(completed_);
+  completed_.clear();
 
   // Events are owned by this object.
   for (auto& e : free_events_) {
@@ -202,7 +234,7 @@ void EventMgr::PollLoop() {
       if (stop_polling_) {
         break;
       }
-      if (used_events_.empty()) {
+      if (used_events_.empty() && completed_.empty()) {
         events_pending_.wait(l);
       }
       PollEvents(true, &to_free);
@@ -221,6 +253,30 @@ void EventMgr::PollLoop() {
 void EventMgr::QueueInUse(se::Stream* stream, InUse iu) {
   VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
+  if (use_host_callbacks_) {
+    // The callback runs on a driver thread, which must not call into CUDA,
+    // so it only hands the record over to the polling thread.  A stream in
+    // an error state does not run its callbacks, so the record is handed
+    // over right away instead, as the polling of an event would fail on it.
+    if (stream->ok()) {
+      ++pending_callbacks_;
+      stream->ThenDoHostCallback([this, iu]() {
+        mutex_lock l(mu_);
+        completed_.push_back(iu);
+        --pending_callbacks_;
+        events_pending_.notify_all();
+      });
+      if (stream->ok()) {
+        return;
+      }
+      // The callback could not be enqueued.
+      --pending_callbacks_;
+    }
+    LOG(WARNING) << "Releasing the resources of a stream in an error state";
+    completed_.push_back(iu);
+    events_pending_.notify_all();
+    return;
+  }
   // Events are created on demand, and repeatedly reused.  There is no
   // limit placed here on the number of allocated Events.
   if (free_events_.empty()) {
@@ -259,6 +315,11 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
                           gtl::InlinedVector<InUse, 4>* to_free) {
   VLOG(2) << "PollEvents  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
+  // Records completed by host callbacks are ready to be freed.
+  for (auto& iu : completed_) {
+    to_free->push_back(std::move(iu));
+  }
+  completed_.clear();
   // Sweep the remaining events in order.  If this is the dedicated
   // polling thread, check the entire set.  Otherwise, just sweep up to
   // the first non-complete record that is still pending.
@@ -61,6 +61,13 @@ void WarnIfInCallback(std::function<void()> f);
 // An object to keep track of pending Events in the StreamExecutor streams
 // and associated Tensors that cannot safely be deleted until the associated
 // Events are recorded.
+//
+// By default completion is detected by polling the Events.  If
+// GPUOptions.experimental.use_host_callbacks_in_event_mgr is set, a host
+// callback is enqueued on the stream instead, which hands the completed work
+// to the EventMgr thread as soon as the stream reaches it.  Work queued on a
+// stream in an error state, which would never run the callback, is handed
+// over right away.
 class EventMgr {
  public:
   virtual ~EventMgr();
@@ -111,6 +118,7 @@ class EventMgr {
   se::StreamExecutor* const exec_;
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
+  const bool use_host_callbacks_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -197,6 +205,11 @@ class EventMgr {
   // A FIFO queue of InUse events and associated tensors.
   std::deque<InUse> used_events_ GUARDED_BY(mu_);
 
+  // With host callbacks, the InUse records whose callback has run but which
+  // have not been freed yet, and the number of callbacks still to run.
+  ToFreeVector completed_ GUARDED_BY(mu_);
+  int64 pending_callbacks_ GUARDED_BY(mu_) = 0;
+
   bool stop_polling_ GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
 
@@ -284,6 +284,57 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// With host callbacks, tensors are released and functions run without any
+// polling of events.
+TEST(EventMgr, HostCallbacks) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.mutable_experimental()->set_use_host_callbacks_in_event_mgr(true);
+  TEST_EventMgr em(stream_exec, gpu_options);
+  TEST_EventMgrHelper th(&em);
+  th.StartPollingLoop();
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  const int64 live_bytes_before = live_tensor_bytes;
+  TensorReferenceVector v;
+  AddTensorReference(&v, 100 * 1048576);
+  em.ThenDeleteTensors(stream.get(), v);
+  EXPECT_EQ(0, th.queue_size());
+  Notification note;
+  em.ThenExecute(stream.get(), [&note]() { note.Notify(); });
+  note.WaitForNotification();
+  EXPECT_EQ(0, th.queue_size());
+  EXPECT_EQ(0, th.free_size());
+  // The tensors were queued before the function, so they are released no
+  // later than it runs.
+  EXPECT_EQ(live_bytes_before, live_tensor_bytes);
+}
+
+// A stream in an error state does not run host callbacks, so its tensors and
+// functions are released without one, and the EventMgr can be destroyed.
+TEST(EventMgr, HostCallbacksOnStreamInErrorState) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.mutable_experimental()->set_use_host_callbacks_in_event_mgr(true);
+  std::unique_ptr<TEST_EventMgr> em(
+      new TEST_EventMgr(stream_exec, gpu_options));
+  TEST_EventMgrHelper th(em.get());
+  th.StartPollingLoop();
+  // A stream is in an error state until it is initialized.
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  ASSERT_FALSE(stream->ok());
+  const int64 live_bytes_before = live_tensor_bytes;
+  TensorReferenceVector v;
+  AddTensorReference(&v, 100 * 1048576);
+  em->ThenDeleteTensors(stream.get(), v);
+  Notification note;
+  em->ThenExecute(stream.get(), [&note]() { note.Notify(); });
+  note.WaitForNotification();
+  EXPECT_EQ(live_bytes_before, live_tensor_bytes);
+  em.reset();
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
@@ -581,7 +632,8 @@ class EMBenchmarkHelper {
   }
 };
 
-static void BM_no_ops(int iters, int threads) {
+static void BM_no_ops_with_options(int iters, int threads,
+                                   const GPUOptions& gpu_options) {
   testing::StopTiming();
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -592,7 +644,7 @@ static void BM_no_ops(int iters, int threads) {
   std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
   CHECK(stream);
   stream->Init();
-  TEST_EventMgr em(stream_exec, GPUOptions());
+  TEST_EventMgr em(stream_exec, gpu_options);
   testing::StartTiming();
   std::atomic<int> counter;
   counter.store(0, std::memory_order_seq_cst);
@@ -611,10 +663,25 @@ static void BM_no_ops(int iters, int threads) {
     Env::Default()->SleepForMicroseconds(1);
   }
 }
+
+static void BM_no_ops(int iters, int threads) {
+  BM_no_ops_with_options(iters, threads, GPUOptions());
+}
 BENCHMARK(BM_no_ops)->Arg(4);
 BENCHMARK(BM_no_ops)->Arg(8);
 BENCHMARK(BM_no_ops)->Arg(32);
 
+// As BM_no_ops, with completion detected by host callbacks instead of
+// polling.
+static void BM_no_ops_host_callbacks(int iters, int threads) {
+  GPUOptions gpu_options;
+  gpu_options.mutable_experimental()->set_use_host_callbacks_in_event_mgr(true);
+  BM_no_ops_with_options(iters, threads, gpu_options);
+}
+BENCHMARK(BM_no_ops_host_callbacks)->Arg(4);
+BENCHMARK(BM_no_ops_host_callbacks)->Arg(8);
+BENCHMARK(BM_no_ops_host_callbacks)->Arg(32);
+
 // Benchmark functions are defined at top level.  In order to provide a real,
 // persistent GPUDevice to the following function it also needs to be at top
 // level.  But then we can't clean it up without a cuda runtime error, so we
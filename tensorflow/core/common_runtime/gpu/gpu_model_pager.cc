@@ -0,0 +1,340 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_model_pager.h"
+
+#include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+GPUModelPager::GPUModelPager(const DeviceMgr* device_mgr)
+    : device_mgr_(device_mgr) {}
+
+GPUModelPager::~GPUModelPager() {
+  // Variables that are still paged out would be left uninitialized for good.
+  Status s = PageIn();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to page in model variables: " << s;
+  }
+}
+
+Status GPUModelPager::PageOut() {
+  mutex_lock l(mu_);
+  while (num_runs_ > 0 || paging_in_) {
+    cond_var_.wait(l);
+  }
+  if (paged_out_) return Status::OK();
+  paged_out_ = true;
+  for (Device* device : device_mgr_->ListDevices()) {
+    const DeviceBase::GpuDeviceInfo* gpu_info =
+        device->tensorflow_gpu_device_info();
+    if (gpu_info == nullptr || gpu_info->default_context == nullptr) continue;
+    // Pinned memory on the NUMA node of the GPU keeps the copies off the
+    // inter-socket link.
+    Allocator* host_allocator =
+        GPUProcessState::singleton()->GetGpuHostAllocator(
+            device->attributes().locality().numa_node());
+
+    std::vector<std::unique_ptr<Var, core::RefCountDeleter>> variables;
+    device->resource_manager()->GetAll(&variables);
+    for (auto& var : variables) {
+      mutex_lock var_lock(*var->mu());
+      const Tensor& device_tensor = *var->tensor();
+      if (!var->is_initialized ||
+          !DataTypeCanUseMemcpy(device_tensor.dtype()) ||
+          device_tensor.NumElements() == 0) {
+        continue;
+      }
+      Tensor host_tensor(host_allocator, device_tensor.dtype(),
+                         device_tensor.shape());
+      Notification note;
+      Status copy_status;
+      gpu_info->default_context->CopyDeviceTensorToCPU(
+          &device_tensor, "", device, &host_tensor,
+          [&note, &copy_status](const Status& s) {
+            copy_status = s;
+            note.Notify();
+          });
+      note.WaitForNotification();
+      TF_RETURN_IF_ERROR(copy_status);
+
+      // Dropping the reference releases the GPU memory, unless a tensor
+      // produced by the last run still aliases it.
+      const DataType dtype = device_tensor.dtype();
+      *var->tensor() = Tensor(dtype);
+      var->is_initialized = false;
+      paged_variables_.push_back({device, std::move(var), host_tensor});
+    }
+  }
+  return Status::OK();
+}
+
+void GPUModelPager::PageInAsync(StatusCallback done) {
+  std::vector<PagedVariable> paged_variables;
+  {
+    mutex_lock l(mu_);
+    if (paged_out_) {
+      page_in_callbacks_.push_back(std::move(done));
+      // Only the first caller copies the variables; the others wait for it.
+      if (paging_in_) return;
+      paging_in_ = true;
+      paged_variables.swap(paged_variables_);
+      done = nullptr;
+    }
+  }
+  if (done != nullptr) {
+    done(Status::OK());
+    return;
+  }
+  if (paged_variables.empty()) {
+    FinishPageIn(Status::OK());
+    return;
+  }
+
+  struct PageInState {
+    mutex mu;
+    int pending;
+    Status status;
+    StatusCallback done;
+  };
+  auto state = std::make_shared<PageInState>();
+  state->pending = paged_variables.size();
+  state->done = [this](const Status& s) { FinishPageIn(s); };
+  auto finish_one = [state](const Status& s) {
+    bool finished;
+    {
+      mutex_lock l(state->mu);
+      state->status.Update(s);
+      finished = --state->pending == 0;
+    }
+    if (finished) state->done(state->status);
+  };
+
+  for (PagedVariable& paged : paged_variables) {
+    Device* device = paged.device;
+    const Tensor& host_tensor = paged.host_tensor;
+    auto device_tensor = std::make_shared<Tensor>(
+        device->GetAllocator(AllocatorAttributes()), host_tensor.dtype(),
+        host_tensor.shape());
+    if (!device_tensor->IsInitialized()) {
+      finish_one(errors::ResourceExhausted(
+          "Failed to allocate ", host_tensor.TotalBytes(),
+          " bytes to page in a variable on ", device->name()));
+      continue;
+    }
+    // The host tensor and the variable are kept alive by the callback.
+    auto var = std::make_shared<PagedVariable>(std::move(paged));
+    DeviceContext* device_context =
+        device->tensorflow_gpu_device_info()->default_context;
+    device_context->CopyCPUTensorToDevice(
+        &var->host_tensor, device, device_tensor.get(),
+        [var, device_tensor, finish_one](const Status& s) {
+          if (s.ok()) {
+            mutex_lock l(*var->var->mu());
+            *var->var->tensor() = *device_tensor;
+            var->var->is_initialized = true;
+          }
+          finish_one(s);
+        });
+  }
+}
+
+void GPUModelPager::FinishPageIn(const Status& status) {
+  std::vector<StatusCallback> callbacks;
+  {
+    mutex_lock l(mu_);
+    // A variable that failed to page in stays uninitialized, and the runs
+    // that read it report the error.
+    paged_out_ = false;
+    paging_in_ = false;
+    callbacks.swap(page_in_callbacks_);
+    cond_var_.notify_all();
+  }
+  for (const StatusCallback& done : callbacks) {
+    done(status);
+  }
+}
+
+Status GPUModelPager::PageIn() {
+  Notification note;
+  Status status;
+  PageInAsync([&note, &status](const Status& s) {
+    status = s;
+    note.Notify();
+  });
+  note.WaitForNotification();
+  return status;
+}
+
+Status GPUModelPager::BeginRun() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      if (!paged_out_) {
+        ++num_runs_;
+        return Status::OK();
+      }
+    }
+    // The model may be paged out again before this run gets the lock back.
+    TF_RETURN_IF_ERROR(PageIn());
+  }
+}
+
+void GPUModelPager::EndRun() {
+  mutex_lock l(mu_);
+  DCHECK_GT(num_runs_, 0);
+  if (--num_runs_ == 0) cond_var_.notify_all();
+}
+
+bool GPUModelPager::paged_out() const {
+  mutex_lock l(mu_);
+  return paged_out_;
+}
+
+int64 GPUModelPager::paged_out_bytes() const {
+  mutex_lock l(mu_);
+  int64 bytes = 0;
+  for (const PagedVariable& paged : paged_variables_) {
+    bytes += paged.host_tensor.TotalBytes();
+  }
+  return bytes;
+}
+
+GPUModelPagingSession::GPUModelPagingSession(std::unique_ptr<Session> session,
+                                             const DeviceMgr* device_mgr)
+    : session_(std::move(session)), pager_(device_mgr) {}
+
+Status GPUModelPagingSession::Wrap(
+    std::unique_ptr<Session> session,
+    std::unique_ptr<GPUModelPagingSession>* out_session) {
+  const DeviceMgr* device_mgr;
+  TF_RETURN_IF_ERROR(session->LocalDeviceManager(&device_mgr));
+  out_session->reset(
+      new GPUModelPagingSession(std::move(session), device_mgr));
+  return Status::OK();
+}
+
+Status GPUModelPagingSession::RunPagedIn(const std::function<Status()>& fn) {
+  TF_RETURN_IF_ERROR(pager_.BeginRun());
+  Status s = fn();
+  pager_.EndRun();
+  return s;
+}
+
+Status GPUModelPagingSession::Create(const GraphDef& graph) {
+  return session_->Create(graph);
+}
+
+Status GPUModelPagingSession::Create(const RunOptions& run_options,
+                                     const GraphDef& graph) {
+  return session_->Create(run_options, graph);
+}
+
+Status GPUModelPagingSession::Extend(const GraphDef& graph) {
+  return session_->Extend(graph);
+}
+
+Status GPUModelPagingSession::Extend(const RunOptions& run_options,
+                                     const GraphDef& graph) {
+  return session_->Extend(run_options, graph);
+}
+
+Status GPUModelPagingSession::Run(
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names,
+    std::vector<Tensor>* outputs) {
+  return RunPagedIn([&]() {
+    return session_->Run(inputs, output_tensor_names, target_node_names,
+                         outputs);
+  });
+}
+
+Status GPUModelPagingSession::Run(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names,
+    std::vector<Tensor>* outputs, RunMetadata* run_metadata) {
+  return RunPagedIn([&]() {
+    return session_->Run(run_options, inputs, output_tensor_names,
+                         target_node_names, outputs, run_metadata);
+  });
+}
+
+Status GPUModelPagingSession::PRunSetup(
+    const std::vector<string>& input_names,
+    const std::vector<string>& output_names,
+    const std::vector<string>& target_nodes, string* handle) {
+  return session_->PRunSetup(input_names, output_names, target_nodes, handle);
+}
+
+Status GPUModelPagingSession::PRun(
+    const string& handle, const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_names, std::vector<Tensor>* outputs) {
+  return RunPagedIn([&]() {
+    return session_->PRun(handle, inputs, output_names, outputs);
+  });
+}
+
+Status GPUModelPagingSession::ListDevices(
+    std::vector<DeviceAttributes>* response) {
+  return session_->ListDevices(response);
+}
+
+Status GPUModelPagingSession::Close() { return session_->Close(); }
+
+Status GPUModelPagingSession::Close(const RunOptions& run_options) {
+  return session_->Close(run_options);
+}
+
+Status GPUModelPagingSession::LocalDeviceManager(const DeviceMgr** output) {
+  return session_->LocalDeviceManager(output);
+}
+
+Status GPUModelPagingSession::MakeCallable(
+    const CallableOptions& callable_options, CallableHandle* out_handle) {
+  return session_->MakeCallable(callable_options, out_handle);
+}
+
+Status GPUModelPagingSession::RunCallable(
+    CallableHandle handle, const std::vector<Tensor>& feed_tensors,
+    std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata) {
+  return RunPagedIn([&]() {
+    return session_->RunCallable(handle, feed_tensors, fetch_tensors,
+                                 run_metadata);
+  });
+}
+
+Status GPUModelPagingSession::RunCallable(
+    CallableHandle handle, const std::vector<Tensor>& feed_tensors,
+    std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
+    const thread::ThreadPoolOptions& threadpool_options) {
+  return RunPagedIn([&]() {
+    return session_->RunCallable(handle, feed_tensors, fetch_tensors,
+                                 run_metadata, threadpool_options);
+  });
+}
+
+Status GPUModelPagingSession::ReleaseCallable(CallableHandle handle) {
+  return session_->ReleaseCallable(handle);
+}
+
+}  // namespace tensorflow
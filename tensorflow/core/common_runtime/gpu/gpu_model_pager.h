@@ -0,0 +1,161 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MODEL_PAGER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MODEL_PAGER_H_
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+
+// Moves the resource variables of a model out of GPU memory and back, so that
+// a server can keep more models loaded than fit in GPU memory at once, paging
+// the weights of cold models out to pinned host memory.
+//
+// A pager covers all the GPU devices of `device_mgr`, which is usually the
+// device manager of the session serving one model. While the model is paged
+// out its variables are uninitialized, so every run must be bracketed by
+// BeginRun() and EndRun(), which page the model in on demand.
+// GPUModelPagingSession does this for all the runs of a session.
+class GPUModelPager {
+ public:
+  explicit GPUModelPager(const DeviceMgr* device_mgr);
+  ~GPUModelPager();
+
+  // Copies the variables on the GPUs to the pinned host memory of their NUMA
+  // nodes and releases their GPU memory. Waits for the runs in progress to
+  // end first. Does nothing if the model is already paged out.
+  Status PageOut();
+
+  // Copies the paged out variables back to their GPUs, and calls `done` once
+  // all of them are in place. Does nothing if the model is not paged out.
+  void PageInAsync(StatusCallback done);
+
+  // Synchronous version of PageInAsync().
+  Status PageIn();
+
+  // Pages the model in if needed, and keeps PageOut() from paging it out
+  // again until the matching EndRun().
+  Status BeginRun();
+  void EndRun();
+
+  // Returns whether the variables of the model are in host memory.
+  bool paged_out() const;
+
+  // Returns the number of bytes of GPU memory released by PageOut().
+  int64 paged_out_bytes() const;
+
+ private:
+  struct PagedVariable {
+    Device* device;
+    std::unique_ptr<Var, core::RefCountDeleter> var;
+    Tensor host_tensor;
+  };
+
+  void FinishPageIn(const Status& status);
+
+  const DeviceMgr* const device_mgr_;
+  mutable mutex mu_;
+  condition_variable cond_var_;
+  // Stays true until a page-in has copied all the variables back.
+  bool paged_out_ GUARDED_BY(mu_) = false;
+  bool paging_in_ GUARDED_BY(mu_) = false;
+  // The callbacks of the PageInAsync() calls waiting for the page-in in
+  // progress.
+  std::vector<StatusCallback> page_in_callbacks_ GUARDED_BY(mu_);
+  int64 num_runs_ GUARDED_BY(mu_) = 0;
+  std::vector<PagedVariable> paged_variables_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUModelPager);
+};
+
+// A session that pages its model in before each run, and exposes the pager of
+// its model so that the caller can page it out while it is idle.
+class GPUModelPagingSession : public Session {
+ public:
+  // Wraps `session`, which must expose its local device manager.
+  static Status Wrap(std::unique_ptr<Session> session,
+                     std::unique_ptr<GPUModelPagingSession>* out_session);
+
+  GPUModelPager* pager() { return &pager_; }
+
+  Status Create(const GraphDef& graph) override;
+  Status Create(const RunOptions& run_options, const GraphDef& graph) override;
+  Status Extend(const GraphDef& graph) override;
+  Status Extend(const RunOptions& run_options, const GraphDef& graph) override;
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override;
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override;
+  Status PRunSetup(const std::vector<string>& input_names,
+                   const std::vector<string>& output_names,
+                   const std::vector<string>& target_nodes,
+                   string* handle) override;
+  Status PRun(const string& handle,
+              const std::vector<std::pair<string, Tensor>>& inputs,
+              const std::vector<string>& output_names,
+              std::vector<Tensor>* outputs) override;
+  Status ListDevices(std::vector<DeviceAttributes>* response) override;
+  Status Close() override;
+  Status Close(const RunOptions& run_options) override;
+  Status LocalDeviceManager(const DeviceMgr** output) override;
+  Status MakeCallable(const CallableOptions& callable_options,
+                      CallableHandle* out_handle) override;
+  Status RunCallable(CallableHandle handle,
+                     const std::vector<Tensor>& feed_tensors,
+                     std::vector<Tensor>* fetch_tensors,
+                     RunMetadata* run_metadata) override;
+  Status RunCallable(
+      CallableHandle handle, const std::vector<Tensor>& feed_tensors,
+      std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
+      const thread::ThreadPoolOptions& threadpool_options) override;
+  Status ReleaseCallable(CallableHandle handle) override;
+
+ private:
+  GPUModelPagingSession(std::unique_ptr<Session> session,
+                        const DeviceMgr* device_mgr);
+
+  // Runs `fn` between pager_.BeginRun() and pager_.EndRun().
+  Status RunPagedIn(const std::function<Status()>& fn);
+
+  const std::unique_ptr<Session> session_;
+  // Declared after `session_`, so that it pages the model back in before the
+  // session is destroyed.
+  GPUModelPager pager_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUModelPagingSession);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MODEL_PAGER_H_
@@ -0,0 +1,133 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_model_pager.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/cc/ops/resource_variable_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace {
+
+// Serves a model with one 2x2 float variable on the first GPU.
+class GPUModelPagerTest : public ::testing::Test {
+ protected:
+  GPUModelPagerTest() {
+    Scope root = Scope::NewRootScope().WithDevice("/device:GPU:0");
+    auto var = ops::VarHandleOp(root.WithOpName("var"), DT_FLOAT,
+                                TensorShape({2, 2}));
+    ops::AssignVariableOp(root.WithOpName("init"), var,
+                          ops::Const(root, {{1.f, 2.f}, {3.f, 4.f}}));
+    ops::ReadVariableOp(root.WithOpName("read"), var, DT_FLOAT);
+    ops::VarIsInitializedOp(root.WithOpName("is_initialized"), var);
+    GraphDef graph_def;
+    TF_CHECK_OK(root.ToGraphDef(&graph_def));
+
+    session_.reset(NewSession(SessionOptions()));
+    TF_CHECK_OK(session_->Create(graph_def));
+    TF_CHECK_OK(session_->Run({}, {}, {"init"}, nullptr));
+  }
+
+  Status Read(Session* session, Tensor* value) {
+    std::vector<Tensor> outputs;
+    TF_RETURN_IF_ERROR(session->Run({}, {"read:0"}, {}, &outputs));
+    *value = outputs[0];
+    return Status::OK();
+  }
+
+  bool IsInitialized() {
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session_->Run({}, {"is_initialized:0"}, {}, &outputs));
+    return outputs[0].scalar<bool>()();
+  }
+
+  const Tensor expected_ =
+      test::AsTensor<float>({1.f, 2.f, 3.f, 4.f}, TensorShape({2, 2}));
+  std::unique_ptr<Session> session_;
+};
+
+TEST_F(GPUModelPagerTest, PageOutReleasesTheVariablesAndPageInRestoresThem) {
+  const DeviceMgr* device_mgr;
+  TF_ASSERT_OK(session_->LocalDeviceManager(&device_mgr));
+  GPUModelPager pager(device_mgr);
+
+  TF_ASSERT_OK(pager.PageOut());
+  EXPECT_TRUE(pager.paged_out());
+  EXPECT_EQ(expected_.TotalBytes(), pager.paged_out_bytes());
+  EXPECT_FALSE(IsInitialized());
+
+  TF_ASSERT_OK(pager.PageIn());
+  EXPECT_FALSE(pager.paged_out());
+  EXPECT_EQ(0, pager.paged_out_bytes());
+  EXPECT_TRUE(IsInitialized());
+  Tensor value;
+  TF_ASSERT_OK(Read(session_.get(), &value));
+  test::ExpectTensorEqual<float>(expected_, value);
+}
+
+TEST_F(GPUModelPagerTest, ConcurrentPageInsWaitForTheSameCopy) {
+  const DeviceMgr* device_mgr;
+  TF_ASSERT_OK(session_->LocalDeviceManager(&device_mgr));
+  GPUModelPager pager(device_mgr);
+  TF_ASSERT_OK(pager.PageOut());
+
+  Notification first_done;
+  Notification second_done;
+  pager.PageInAsync([&first_done](const Status& s) {
+    TF_EXPECT_OK(s);
+    first_done.Notify();
+  });
+  pager.PageInAsync([&second_done](const Status& s) {
+    TF_EXPECT_OK(s);
+    second_done.Notify();
+  });
+  first_done.WaitForNotification();
+  second_done.WaitForNotification();
+  EXPECT_FALSE(pager.paged_out());
+  Tensor value;
+  TF_ASSERT_OK(Read(session_.get(), &value));
+  test::ExpectTensorEqual<float>(expected_, value);
+}
+
+TEST_F(GPUModelPagerTest, PagingSessionPagesInBeforeEachRun) {
+  std::unique_ptr<GPUModelPagingSession> session;
+  TF_ASSERT_OK(GPUModelPagingSession::Wrap(std::move(session_), &session));
+
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK(session->pager()->PageOut());
+    EXPECT_TRUE(session->pager()->paged_out());
+    Tensor value;
+    TF_ASSERT_OK(Read(session.get(), &value));
+    test::ExpectTensorEqual<float>(expected_, value);
+    EXPECT_FALSE(session->pager()->paged_out());
+  }
+  TF_ASSERT_OK(session->Close());
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_cudamalloc_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_debug_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_host_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
@@ -94,13 +95,30 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
   AllocatorParts& allocator_parts = gpu_allocators_[tf_gpu_id.value()];
   if (allocator_parts.allocator == nullptr) {
     // Validate allocator types.
-    if (!allocator_type.empty() && allocator_type != "BFC") {
+    if (!allocator_type.empty() && allocator_type != "BFC" &&
+        allocator_type != "cuda_malloc_async") {
       LOG(ERROR) << "Invalid allocator type: " << allocator_type;
       return nullptr;
     }
 
     PlatformGpuId platform_gpu_id;
     TF_CHECK_OK(GpuIdManager::TfToPlatformGpuId(tf_gpu_id, &platform_gpu_id));
+    if (allocator_type == "cuda_malloc_async") {
+      if (GPUcudaMallocAsyncAllocator::IsSupported(platform_gpu_id)) {
+        // The pool replaces the BFC allocator, so there is no BFC allocator
+        // or sub-allocator, and timing counters are not supported.
+        Allocator* gpu_allocator = new GPUcudaMallocAsyncAllocator(
+            platform_gpu_id, total_bytes,
+            options.experimental().mempool_release_threshold_bytes(),
+            strings::StrCat("GPU_", tf_gpu_id.value(), "_cuda_malloc_async"));
+        allocator_parts = {std::unique_ptr<Allocator>(gpu_allocator),
+                           nullptr, nullptr, nullptr, nullptr};
+        return allocator_parts.allocator.get();
+      }
+      LOG(WARNING) << "Allocator type cuda_malloc_async is not supported by "
+                   << "the CUDA driver or GPU " << platform_gpu_id.value()
+                   << "; using BFC instead.";
+    }
     int bus_id = BusIdForGPU(tf_gpu_id);
     DCHECK_GE(bus_id, 0);
     while (bus_id >= gpu_visitors_.size()) {
@@ -150,7 +168,8 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
                        gpu_bfc_allocator, sub_allocator,
                        std::unique_ptr<Allocator>(recording_allocator)};
   }
-  if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
+  if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
+      allocator_parts.recording_allocator != nullptr) {
     return allocator_parts.recording_allocator.get();
   } else {
     return allocator_parts.allocator.get();
@@ -177,7 +196,9 @@ SharedCounter* GPUProcessState::GPUAllocatorCounter(TfGpuId tf_gpu_id) {
   AllocatorParts& allocator_parts = gpu_allocators_[tf_gpu_id.value()];
   if (allocator_parts.counter.get() == nullptr) {
     SharedCounter* timing_counter = new SharedCounter;
-    allocator_parts.bfc_allocator->SetTimingCounter(timing_counter);
+    if (allocator_parts.bfc_allocator != nullptr) {
+      allocator_parts.bfc_allocator->SetTimingCounter(timing_counter);
+    }
     allocator_parts.counter.reset(timing_counter);
   }
   return allocator_parts.counter.get();
@@ -237,9 +258,22 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     while (gpu_host_free_visitors_.size() <= numa_node) {
       gpu_host_free_visitors_.push_back({});
     }
-    SubAllocator* sub_allocator =
-        new GpuHostAllocator(se, numa_node, gpu_host_alloc_visitors_[numa_node],
-                             gpu_host_free_visitors_[numa_node]);
+    // Track the pinned chunks, so that IsGpuHostMemory does not depend on
+    // which allocator wraps the SubAllocator.
+    std::vector<SubAllocator::Visitor> alloc_visitors =
+        gpu_host_alloc_visitors_[numa_node];
+    alloc_visitors.push_back([this](void* ptr, int, size_t num_bytes) {
+      mutex_lock l(gpu_host_chunks_mu_);
+      gpu_host_chunks_[static_cast<const char*>(ptr)] = num_bytes;
+    });
+    std::vector<SubAllocator::Visitor> free_visitors =
+        gpu_host_free_visitors_[numa_node];
+    free_visitors.push_back([this](void* ptr, int, size_t) {
+      mutex_lock l(gpu_host_chunks_mu_);
+      gpu_host_chunks_.erase(static_cast<const char*>(ptr));
+    });
+    SubAllocator* sub_allocator = new GpuHostAllocator(
+        se, numa_node, alloc_visitors, free_visitors);
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64 gpu_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_LIMIT_IN_MB",
@@ -283,6 +317,16 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
   }
 }
 
+bool GPUProcessState::IsGpuHostMemory(const void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  mutex_lock l(gpu_host_chunks_mu_);
+  // Find the last chunk that starts at or before "p".
+  auto it = gpu_host_chunks_.upper_bound(p);
+  if (it == gpu_host_chunks_.begin()) return false;
+  --it;
+  return p < it->first + it->second;
+}
+
 void GPUProcessState::AddGPUAllocVisitor(int bus_id,
                                          const SubAllocator::Visitor& visitor) {
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
@@ -86,6 +86,10 @@ class GPUProcessState {
 
   virtual Allocator* GetGpuHostAllocator(int numa_node);
 
+  // Returns true if "ptr" points into memory allocated by the SubAllocator of
+  // a GpuHostAllocator, i.e. host memory pinned for DMA to and from the GPUs.
+  bool IsGpuHostMemory(const void* ptr);
+
   // Registers a Visitor to be invoked on new chunks of memory allocated by the
   // SubAllocator of every GPU proximate to the specified bus.  The AllocVisitor
   // is provided with a memory pointer, a GPU id, and the size of the area it
@@ -150,6 +154,13 @@ class GPUProcessState {
       GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_host_free_visitors_
       GUARDED_BY(mu_);
+
+  // Maps the start of each chunk of pinned host memory held by a
+  // GpuHostAllocator to its size.  Has its own lock, since the chunks are
+  // allocated and freed while "mu_" may be held.
+  mutex gpu_host_chunks_mu_;
+  std::map<const char*, size_t> gpu_host_chunks_
+      GUARDED_BY(gpu_host_chunks_mu_);
 };
 
 }  // namespace tensorflow
@@ -69,11 +69,12 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
   // fresh stream.
   // 2. Try to execute a node on the same stream as one of its
   // inputs to avoid inter-stream dependencies.
-  // 3. If any input comes from a node with a large fanout then
-  // perhaps an indication that it is shared between parallel
-  // streams of work. We choose a new stream here so that all consumers
-  // of the tensor are likely to run in parallel.
+  // 3. Only the first consumer of a node continues its stream. Further
+  // consumers are the heads of independent branches of work and get a new
+  // stream each, so that the branches can run in parallel and only
+  // synchronize with each other where they join again.
   int highest_stream_id = -1;
+  std::vector<bool> stream_continued(graph->num_node_ids(), false);
   for (Node* n : order) {
     VLOG(3) << "Inspecting node " << n->DebugString();
     const int node_id = n->id();
@@ -82,9 +83,10 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
     // Determine a suitable stream to use.
     int stream_id = highest_stream_id + 1;
     for (const Edge* e : n->in_edges()) {
-      const size_t fanout = e->src()->out_edges().size();
-      if (fanout == 1) {
-        stream_id = (*node_to_stream_id)[e->src()->id()];
+      const int src_id = e->src()->id();
+      if (!stream_continued[src_id]) {
+        stream_continued[src_id] = true;
+        stream_id = (*node_to_stream_id)[src_id];
         break;
       }
     }
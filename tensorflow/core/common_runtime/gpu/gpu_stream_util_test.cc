@@ -103,6 +103,36 @@ TEST_F(GpuStreamUtilTest, SimpleGraphManyStreams) {
   }
 }
 
+TEST_F(GpuStreamUtilTest, IndependentBranchesGetTheirOwnStreams) {
+  auto root = Scope::DisabledShapeInferenceScope().ExitOnError();
+  Output input = ops::Const(root.WithOpName("input"), 1.0f, {2, 2});
+  Output left = ops::MatMul(root.WithOpName("left"), input, input);
+  Output left_relu = ops::Relu(root.WithOpName("left_relu"), left);
+  Output right = ops::MatMul(root.WithOpName("right"), input, input);
+  Output right_relu = ops::Relu(root.WithOpName("right_relu"), right);
+  ops::Add(root.WithOpName("join"), left_relu, right_relu);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&g));
+
+  std::unordered_map<int, int> node_to_stream_id;
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.max_streams = 100;
+  TF_ASSERT_OK(gpu_stream_util::AssignStreams(&g, opts, &node_to_stream_id));
+
+  std::unordered_map<string, int> stream_by_name;
+  for (Node* n : g.nodes()) {
+    stream_by_name[n->name()] = node_to_stream_id[n->id()];
+  }
+  // Each branch stays on one stream, and the two branches run on different
+  // streams.
+  EXPECT_EQ(stream_by_name["left"], stream_by_name["left_relu"]);
+  EXPECT_EQ(stream_by_name["right"], stream_by_name["right_relu"]);
+  EXPECT_NE(stream_by_name["left"], stream_by_name["right"]);
+  // The join continues one of the branches.
+  EXPECT_TRUE(stream_by_name["join"] == stream_by_name["left"] ||
+              stream_by_name["join"] == stream_by_name["right"]);
+}
+
 TEST_F(GpuStreamUtilTest, StreamOverrides) {
   auto root = Scope::DisabledShapeInferenceScope().ExitOnError();
   ops::_Recv(root.WithOpName("input"), DT_FLOAT, "input", "/cpu:0", 0,
@@ -15,6 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -33,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -60,6 +67,115 @@ namespace tensorflow {
 using se::DeviceMemoryBase;
 using se::Stream;
 
+namespace {
+
+// Host to device copies of at least this many bytes out of pageable memory
+// are staged through pinned buffers, because the driver copies pageable
+// memory at a fraction of the bandwidth of pinned memory.
+const int64 kStagingMinBytes = 1 << 20;
+// Size of each staging buffer.  Filling one buffer on the host overlaps with
+// the DMA out of the other one.
+const int64 kStagingBufferBytes = 4 << 20;
+const int kNumStagingBuffers = 2;
+
+// A fixed set of pinned host buffers through which pageable host memory is
+// copied to one GPU.  One copy at a time owns the whole pool, until all its
+// chunks are enqueued.
+class StagingBufferPool {
+ public:
+  // Returns the pool of the GPU of "executor".
+  static StagingBufferPool* Get(se::StreamExecutor* executor) {
+    static mutex* mu = new mutex;
+    static auto* pools = new std::map<se::StreamExecutor*, StagingBufferPool*>;
+    mutex_lock l(*mu);
+    StagingBufferPool*& pool = (*pools)[executor];
+    if (pool == nullptr) pool = new StagingBufferPool;
+    return pool;
+  }
+
+  // Enqueues on "stream" a copy of "num_bytes" bytes from "src" to "dst",
+  // in chunks alternating between the staging buffers.  Blocks until all
+  // but the last kNumStagingBuffers chunks have been copied to the GPU, much
+  // like a direct copy out of pageable memory blocks for all of it.  Returns
+  // false without enqueuing anything if the buffers cannot be allocated.
+  bool Copy(Stream* stream, EventMgr* event_mgr, const void* src,
+            DeviceMemoryBase* dst, int64 num_bytes) {
+    {
+      mutex_lock l(mu_);
+      while (in_use_) cv_.wait(l);
+      if (buffers_.empty() && !AllocateBuffers()) return false;
+      in_use_ = true;
+    }
+    int64 offset = 0;
+    for (int i = 0; offset < num_bytes; ++i) {
+      Buffer* buffer;
+      {
+        mutex_lock l(mu_);
+        buffer = &buffers_[i % kNumStagingBuffers];
+        // Wait until the DMA out of this buffer in a previous round is done.
+        while (buffer->pending) cv_.wait(l);
+        buffer->pending = true;
+      }
+      const int64 chunk_bytes =
+          std::min(kStagingBufferBytes, num_bytes - offset);
+      memcpy(buffer->data, static_cast<const char*>(src) + offset,
+             chunk_bytes);
+      DeviceMemoryBase chunk_dst(static_cast<char*>(dst->opaque()) + offset,
+                                 chunk_bytes);
+      stream->ThenMemcpy(&chunk_dst, buffer->data, chunk_bytes);
+      event_mgr->ThenExecute(stream, [this, buffer]() {
+        mutex_lock l(mu_);
+        buffer->pending = false;
+        cv_.notify_all();
+      });
+      offset += chunk_bytes;
+    }
+    mutex_lock l(mu_);
+    in_use_ = false;
+    cv_.notify_all();
+    return true;
+  }
+
+ private:
+  struct Buffer {
+    void* data;
+    // True while a DMA out of "data" is enqueued and not yet done.
+    bool pending;
+  };
+
+  StagingBufferPool() {}
+
+  bool AllocateBuffers() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    GPUProcessState* process_state = GPUProcessState::singleton();
+    Allocator* allocator = process_state->GetGpuHostAllocator(0);
+    for (int i = 0; i < kNumStagingBuffers; ++i) {
+      void* data = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                          kStagingBufferBytes);
+      // Without pinned host memory, e.g. when GPU DMA registration is off,
+      // staging would only add a host copy.
+      if (data == nullptr || !process_state->IsGpuHostMemory(data)) {
+        LOG(WARNING) << "Failed to allocate pinned staging buffers, copying "
+                     << "out of pageable memory instead.";
+        if (data != nullptr) allocator->DeallocateRaw(data);
+        for (Buffer& buffer : buffers_) allocator->DeallocateRaw(buffer.data);
+        buffers_.clear();
+        return false;
+      }
+      buffers_.push_back({data, false});
+    }
+    return true;
+  }
+
+  mutex mu_;
+  condition_variable cv_;
+  // True while a copy owns the buffers.
+  bool in_use_ GUARDED_BY(mu_) = false;
+  // Not resized once allocated, so a copy can hold pointers to its elements.
+  std::vector<Buffer> buffers_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
 Status PrepareCopy(Device* device, const DeviceContext* ctx, const Tensor& src,
                    const Tensor* dst,
                    const DeviceBase::GpuDeviceInfo** dev_info,
@@ -199,9 +315,10 @@ void GPUUtil::DeviceToDeviceCopy(
     done(s);
     return;
   }
+  const GPUDeviceContext* send_gpu_context =
+      static_cast<const GPUDeviceContext*>(send_dev_context);
   auto send_device_to_device_stream =
-      static_cast<const GPUDeviceContext*>(send_dev_context)
-          ->device_to_device_stream(dev_to_dev_stream_index);
+      send_gpu_context->device_to_device_stream(dev_to_dev_stream_index);
   if (send_device_to_device_stream == nullptr) {
     done(errors::Internal("No send gpu copy-out-stream is available."));
     return;
@@ -212,26 +329,48 @@ void GPUUtil::DeviceToDeviceCopy(
 
   const int64 total_bytes = input->TotalBytes();
   if (total_bytes > 0) {
-    void* src_ptr = GetBase(input);
-    DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
-    void* dst_ptr = GetBase(output);
-    DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
+    char* src_ptr = static_cast<char*>(GetBase(input));
+    char* dst_ptr = static_cast<char*>(GetBase(output));
     auto recv_stream =
         static_cast<const GPUDeviceContext*>(recv_dev_context)->stream();
     if (recv_stream == nullptr) {
       done(errors::Internal("No recv gpu stream is available."));
       return;
     }
-    // Since we want to use the memory from recv_stream in the
-    // send_device_to_device_stream, add a dependency to make sure the memory is
-    // truly free.
-    // TODO(zhengxq): remove this dependency when we switch to a better way
-    // to make sure the memory is free.
-    send_device_to_device_stream->ThenWaitFor(recv_stream);
-
-    VLOG(2) << "src_ptr " << src_ptr << " dst_ptr " << dst_ptr;
-    send_device_to_device_stream->ThenMemcpy(&gpu_dst_ptr, gpu_src_ptr,
-                                             total_bytes);
+
+    // Large copies over a direct link are split into one chunk per
+    // device-to-device stream, starting with send_device_to_device_stream.
+    const InterconnectLink* link = FindLink(src, dst);
+    int num_chunks = 1;
+    if (link != nullptr && total_bytes >= kSplitCopyMinBytes) {
+      num_chunks = send_gpu_context->num_device_to_device_streams();
+    }
+    VLOG(2) << "src_ptr " << static_cast<void*>(src_ptr) << " dst_ptr "
+            << static_cast<void*>(dst_ptr) << " link "
+            << (link != nullptr ? link->type() : "none") << " chunks "
+            << num_chunks;
+    // Keep chunk boundaries aligned.
+    const int64 chunk_bytes =
+        (total_bytes / num_chunks + Allocator::kAllocatorAlignment - 1) /
+        Allocator::kAllocatorAlignment * Allocator::kAllocatorAlignment;
+    for (int i = 0; i < num_chunks; ++i) {
+      const int64 offset = i * chunk_bytes;
+      if (offset >= total_bytes) break;
+      const int64 bytes = std::min(chunk_bytes, total_bytes - offset);
+      se::Stream* copy_stream = send_gpu_context->device_to_device_stream(
+          dev_to_dev_stream_index + i);
+      if (i > 0) copy_stream->ThenWaitFor(send_stream);
+      // Since we want to use the memory from recv_stream in the
+      // copy_stream, add a dependency to make sure the memory is
+      // truly free.
+      // TODO(zhengxq): remove this dependency when we switch to a better way
+      // to make sure the memory is free.
+      copy_stream->ThenWaitFor(recv_stream);
+      DeviceMemoryBase gpu_src_ptr(src_ptr + offset, bytes);
+      DeviceMemoryBase gpu_dst_ptr(dst_ptr + offset, bytes);
+      copy_stream->ThenMemcpy(&gpu_dst_ptr, gpu_src_ptr, bytes);
+      if (i > 0) send_device_to_device_stream->ThenWaitFor(copy_stream);
+    }
   }
 
   // Use of input may outlive stack scope, so keep a ref.
@@ -330,7 +469,17 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
     void* src_ptr = GetBase(cpu_tensor);
     void* dst_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
-    recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
+    bool staged = false;
+    if (total_bytes >= kStagingMinBytes &&
+        !GPUProcessState::singleton()->IsGpuHostMemory(src_ptr)) {
+      staged = StagingBufferPool::Get(recv_host_to_device_stream->parent())
+                   ->Copy(recv_host_to_device_stream, dev_info->event_mgr,
+                          src_ptr, &gpu_dst_ptr, total_bytes);
+    }
+    if (!staged) {
+      recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr,
+                                             total_bytes);
+    }
   }
   // Use of cpu_tensor may outlive stack scope, so keep a ref.
   TensorReference input_ref(*cpu_tensor);
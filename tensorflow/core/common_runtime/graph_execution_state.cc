@@ -24,6 +24,7 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_join.h"
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
@@ -606,9 +607,17 @@ Status GraphExecutionState::InitBaseGraph(std::unique_ptr<Graph>&& new_graph) {
   optimization_options.flib_def = flib_def_.get();
   optimization_options.device_set = device_set_;
 
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::PRE_PLACEMENT, optimization_options));
+  {
+    ScopedCompilationPhase phase(kCompilationPhaseSession,
+                                 "pre_placement_passes",
+                                 new_graph->num_op_nodes());
+    TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::PRE_PLACEMENT, optimization_options));
+    phase.set_nodes_after(new_graph->num_op_nodes());
+  }
 
+  ScopedCompilationPhase placement_phase(kCompilationPhaseSession, "placement",
+                                         new_graph->num_op_nodes());
   Placer placer(new_graph.get(), "", flib_def_.get(), device_set_,
                 /* default_device= */ nullptr,
                 session_options_ == nullptr ||
@@ -617,9 +626,16 @@ Status GraphExecutionState::InitBaseGraph(std::unique_ptr<Graph>&& new_graph) {
                     session_options_->config.log_device_placement());
   // TODO(mrry): Consider making the Placer cancelable.
   TF_RETURN_IF_ERROR(placer.Run());
+  placement_phase.set_nodes_after(new_graph->num_op_nodes());
 
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::POST_PLACEMENT, optimization_options));
+  {
+    ScopedCompilationPhase phase(kCompilationPhaseSession,
+                                 "post_placement_passes",
+                                 new_graph->num_op_nodes());
+    TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::POST_PLACEMENT, optimization_options));
+    phase.set_nodes_after(new_graph->num_op_nodes());
+  }
 
   for (const Node* n : new_graph->nodes()) {
     VLOG(2) << "Mapping " << n->name() << " to " << n->cost_id();
@@ -643,6 +659,8 @@ Status GraphExecutionState::OptimizeGraph(
     grappler::GrapplerItem item;
     item.id = "tf_graph";
     graph_->ToGraphDef(&item.graph);
+    // The graph is optimized for the feeds of these callable options only.
+    item.optimization_options().feeds_are_complete = true;
 
     // It's ok to skip invalid device annotations in Grappler.
     for (const Device* d : device_set_->devices()) {
@@ -757,8 +775,8 @@ Status GraphExecutionState::OptimizeGraph(
 
     GraphConstructorOptions opts;
     opts.allow_internal_ops = true;
-    TF_RETURN_IF_ERROR(
-        ConvertGraphDefToGraph(opts, new_graph, optimized_graph->get()));
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, std::move(new_graph),
+                                              optimized_graph->get()));
     // The graph conversion sets the requested device names but not the
     // assigned device names. However, since at this point the graph is placed
     // TF expects an assigned device name for every node. Therefore we copy
@@ -791,21 +809,29 @@ Status GraphExecutionState::BuildGraph(const BuildGraphOptions& options,
   std::unique_ptr<Graph> optimized_graph;
   std::unique_ptr<FunctionLibraryDefinition> optimized_flib;
 
-  Status s = OptimizeGraph(options, &optimized_graph, &optimized_flib);
-  if (!s.ok()) {
-    VLOG(2) << "Grappler optimization failed. Error: " << s.error_message();
-    // Simply copy the original graph and the function library if we couldn't
-    // optimize it.
-    optimized_graph.reset(new Graph(flib_def_.get()));
-    CopyGraph(*graph_, optimized_graph.get());
-    optimized_flib.reset(new FunctionLibraryDefinition(*flib_def_));
+  {
+    ScopedCompilationPhase phase(kCompilationPhaseSession, "grappler",
+                                 graph_->num_op_nodes());
+    Status s = OptimizeGraph(options, &optimized_graph, &optimized_flib);
+    if (!s.ok()) {
+      VLOG(2) << "Grappler optimization failed. Error: " << s.error_message();
+      // Simply copy the original graph and the function library if we
+      // couldn't optimize it.
+      optimized_graph.reset(new Graph(flib_def_.get()));
+      CopyGraph(*graph_, optimized_graph.get());
+      optimized_flib.reset(new FunctionLibraryDefinition(*flib_def_));
+    }
+    phase.set_nodes_after(optimized_graph->num_op_nodes());
   }
 
   subgraph::RewriteGraphMetadata rewrite_metadata;
   if (session_options_ == nullptr ||
       !session_options_->config.graph_options().place_pruned_graph()) {
+    ScopedCompilationPhase phase(kCompilationPhaseSession, "prune",
+                                 optimized_graph->num_op_nodes());
     TF_RETURN_IF_ERROR(
         PruneGraph(options, optimized_graph.get(), &rewrite_metadata));
+    phase.set_nodes_after(optimized_graph->num_op_nodes());
   } else {
     // This GraphExecutionState represents a graph that was
     // pruned when this was constructed, so we copy the metadata from
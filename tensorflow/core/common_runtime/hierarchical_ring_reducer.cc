@@ -0,0 +1,306 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+// Phases of the algorithm, used to tell apart the buffers exchanged.
+enum Phase {
+  kLocalReduceScatter = 0,
+  kRemoteReduceScatter = 1,
+  kRemoteAllGather = 2,
+  kLocalAllGather = 3,
+};
+
+int Mod(int a, int m) { return ((a % m) + m) % m; }
+
+}  // namespace
+
+Status HierarchicalRingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
+  CHECK_EQ(col_params->instance.impl_details.collective_name,
+           "HierarchicalRingReduce");
+  if (!col_params->instance.same_num_devices_per_task) {
+    return errors::InvalidArgument(
+        "HierarchicalRingReduce requires the same number of devices in every "
+        "task of group ",
+        col_params->group.group_key);
+  }
+  return Status::OK();
+}
+
+void HierarchicalRingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  done_ = std::move(done);
+  group_size_ = col_params_->group.group_size;
+  num_subdivs_ = 1;
+
+  // Devices are sorted so that those of the same task are adjacent.
+  const std::vector<string>& task_names = col_params_->instance.task_names;
+  num_tasks_ = 1;
+  for (int r = 1; r < group_size_; ++r) {
+    if (task_names[r] != task_names[r - 1]) ++num_tasks_;
+  }
+  devices_per_task_ = group_size_ / num_tasks_;
+  for (int r = 0; r < group_size_; ++r) {
+    if (group_size_ % num_tasks_ != 0 ||
+        task_names[r] != task_names[(r / devices_per_task_) *
+                                    devices_per_task_]) {
+      StartAbort(errors::InvalidArgument(
+          "HierarchicalRingReduce requires the same number of devices in "
+          "every task, with the devices of each task adjacent"));
+      Finish(false);
+      return;
+    }
+  }
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    Status status;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->input_device_context(0),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done_(status);
+      return;
+    }
+  }
+
+  // Chunk (b * num_tasks_ + t) is the t-th chunk of block b.
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, group_size_,
+                                  col_ctx_->device->GetAllocator(attr)));
+  Status s;
+  if (col_params_->final_op) {
+    s = InitGroupSizeTensor();
+  }
+  temp_chunks_.clear();
+  temp_chunks_.resize(group_size_);
+  for (int k = 0; k < group_size_; ++k) {
+    if (ca_->ChunkBytes(k) > 0) {
+      temp_chunks_[k] = ca_->TempChunk(k);
+    }
+  }
+  const DeviceBase::GpuDeviceInfo* gpu_info =
+      col_ctx_->device->tensorflow_gpu_device_info();
+  if (s.ok() && gpu_info) {
+    // As in RingReducer, wait for the compute stream so that the temporary
+    // buffers allocated above are valid for RDMA.
+    Notification note;
+    s = gpu_info->default_context->ThenExecute(
+        col_ctx_->device, gpu_info->stream, [&note]() { note.Notify(); });
+    if (s.ok()) {
+      note.WaitForNotification();
+    }
+  }
+  if (!s.ok()) {
+    StartAbort(s);
+    temp_chunks_.clear();
+    Finish(false);
+    return;
+  }
+
+  const int num_tasks = num_tasks_;
+  const int num_devices = devices_per_task_;
+  const int task = col_params_->default_rank / num_devices;
+  const int local = col_params_->default_rank % num_devices;
+  auto rank = [num_devices](int task, int local) {
+    return task * num_devices + local;
+  };
+  const int local_prev = rank(task, Mod(local - 1, num_devices));
+  const int local_next = rank(task, Mod(local + 1, num_devices));
+  const int remote_prev = rank(Mod(task - 1, num_tasks), local);
+  const int remote_next = rank(Mod(task + 1, num_tasks), local);
+  VLOG(1) << "HierarchicalRingReducer::Run for device "
+          << col_ctx_->device_name << " rank " << col_params_->default_rank
+          << " task " << task << "/" << num_tasks << " local " << local << "/"
+          << num_devices;
+
+  // Reduce-scatter the blocks over the ring of this task.  Afterwards this
+  // device holds block (local + 1) reduced over the task.
+  for (int step = 0; s.ok() && step < num_devices - 1; ++step) {
+    s = RunStep(kLocalReduceScatter, local_next,
+                Mod(local - step, num_devices) * num_tasks, local_prev,
+                Mod(local - step - 1, num_devices) * num_tasks, num_tasks,
+                /*reduce=*/true);
+  }
+
+  // All-reduce that block over the ring of devices with the same local
+  // index.  Chunk t of the block is fully reduced on task (t - 1) after the
+  // reduce-scatter, and that task applies the final op to it.
+  const int block = Mod(local + 1, num_devices) * num_tasks;
+  for (int step = 0; s.ok() && step < num_tasks - 1; ++step) {
+    s = RunStep(kRemoteReduceScatter, remote_next,
+                block + Mod(task - step, num_tasks), remote_prev,
+                block + Mod(task - step - 1, num_tasks), 1, /*reduce=*/true);
+  }
+  const int owned_chunk = block + Mod(task + 1, num_tasks);
+  if (s.ok() && col_params_->final_op && ca_->ChunkBytes(owned_chunk) > 0) {
+    Tensor chunk = ca_->ChunkAlias(owned_chunk);
+    s = collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->final_op.get(), &chunk, &group_size_tensor_);
+    if (!s.ok()) StartAbort(s);
+  }
+  for (int step = 0; s.ok() && step < num_tasks - 1; ++step) {
+    s = RunStep(kRemoteAllGather, remote_next,
+                block + Mod(task + 1 - step, num_tasks), remote_prev,
+                block + Mod(task - step, num_tasks), 1, /*reduce=*/false);
+  }
+
+  // All-gather the blocks over the ring of this task.
+  for (int step = 0; s.ok() && step < num_devices - 1; ++step) {
+    s = RunStep(kLocalAllGather, local_next,
+                Mod(local + 1 - step, num_devices) * num_tasks, local_prev,
+                Mod(local - step, num_devices) * num_tasks, num_tasks,
+                /*reduce=*/false);
+  }
+
+  temp_chunks_.clear();
+  Finish(s.ok());
+}
+
+Status HierarchicalRingReducer::RunStep(int phase, int send_to, int send_chunk,
+                                        int recv_from, int recv_chunk,
+                                        int num_chunks, bool reduce) {
+  std::vector<Tensor> send_chunks;
+  std::vector<Tensor> recv_chunks;
+  std::vector<int> send_indices;
+  std::vector<int> recv_indices;
+  send_chunks.reserve(num_chunks);
+  recv_chunks.reserve(num_chunks);
+  for (int i = 0; i < num_chunks; ++i) {
+    if (ca_->ChunkBytes(send_chunk + i) > 0) {
+      send_chunks.push_back(ca_->ChunkAlias(send_chunk + i));
+      send_indices.push_back(send_chunk + i);
+    }
+    if (ca_->ChunkBytes(recv_chunk + i) > 0) {
+      recv_chunks.push_back(ca_->ChunkAlias(recv_chunk + i));
+      recv_indices.push_back(recv_chunk + i);
+    }
+  }
+
+  auto buf_key = [this, phase](int chunk, int src_rank) {
+    return strings::StrCat(name_, "(", col_ctx_->exec_key, "):phase(", phase,
+                           "):chunk(", chunk, "):srcrank(", src_rank, ")");
+  };
+  mutex mu;
+  Status status;
+  BlockingCounter counter(send_chunks.size() + recv_chunks.size());
+  auto done = [&mu, &status, &counter](const Status& s) {
+    {
+      mutex_lock l(mu);
+      status.Update(s);
+    }
+    counter.DecrementCount();
+  };
+  const CollInstanceParams& instance = col_params_->instance;
+  for (int i = 0; i < send_chunks.size(); ++i) {
+    col_ctx_->col_exec->PostToPeer(
+        instance.device_names[send_to], instance.task_names[send_to],
+        buf_key(send_indices[i], col_params_->default_rank), col_ctx_->device,
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), &send_chunks[i],
+        col_ctx_->device_locality, done);
+  }
+  for (int i = 0; i < recv_chunks.size(); ++i) {
+    const int k = recv_indices[i];
+    Tensor* dst_tensor = reduce ? &temp_chunks_[k] : &recv_chunks[i];
+    col_ctx_->col_exec->RecvFromPeer(
+        instance.device_names[recv_from], instance.task_names[recv_from],
+        col_params_->task.is_local[recv_from], buf_key(k, recv_from),
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), dst_tensor,
+        col_ctx_->device_locality, 0 /*dev_to_dev_stream_index*/, done);
+  }
+  counter.Wait();
+  if (!status.ok()) {
+    StartAbort(status);
+    return status;
+  }
+
+  if (reduce) {
+    for (int i = 0; i < recv_chunks.size(); ++i) {
+      Status s = collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->merge_op.get(), &recv_chunks[i],
+          &temp_chunks_[recv_indices[i]]);
+      if (!s.ok()) {
+        StartAbort(s);
+        return s;
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalRingReducer::InitGroupSizeTensor() {
+  Tensor group_size_val = ca_->Scalar(group_size_);
+  if (col_params_->group.device_type == "CPU") {
+    group_size_tensor_ = group_size_val;
+    return Status::OK();
+  }
+  group_size_tensor_ = ca_->Scalar(
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+      AllocationAttributes());
+  Notification note;
+  Status status;
+  col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+      &group_size_val, col_ctx_->device, &group_size_tensor_,
+      [&note, &status](const Status& s) {
+        status = s;
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
+}
+
+REGISTER_COLLECTIVE(HierarchicalRingReduce, HierarchicalRingReducer);
+
+}  // namespace tensorflow
@@ -0,0 +1,65 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/ring_alg.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+
+// Two level all-reduce for groups spanning several tasks with the same number
+// of devices each.
+//
+// With T tasks of D devices, the tensor is split into D blocks of T chunks.
+// The devices of each task first reduce-scatter the blocks over a ring local
+// to the task, so that each device holds one block reduced over its task.
+// Devices with the same local index then all-reduce that block over a ring
+// across the tasks, and finally the devices of each task all-gather the
+// blocks.  Only 2 * (T - 1) / (T * D) of the tensor crosses task boundaries
+// per device, instead of 2 * (T * D - 1) / (T * D) for a flat ring.
+class HierarchicalRingReducer : public RingAlg {
+ public:
+  HierarchicalRingReducer()
+      : RingAlg(REDUCTION_COLLECTIVE, "HierarchicalRingReduce") {}
+  ~HierarchicalRingReducer() override {}
+
+  // Begins async execution of the reduction.  Must be called in a blockable
+  // thread.
+  void Run(StatusCallback done) override;
+
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+ private:
+  // Sends chunks [send_chunk, send_chunk + num_chunks) to the device of rank
+  // 'send_to' and receives chunks [recv_chunk, recv_chunk + num_chunks) from
+  // the device of rank 'recv_from', then waits for all of them.  Received
+  // chunks are merged into the current value if 'reduce' is true, and
+  // overwrite it otherwise.
+  Status RunStep(int phase, int send_to, int send_chunk, int recv_from,
+                 int recv_chunk, int num_chunks, bool reduce);
+
+  // Makes group_size_tensor_ for the final op.
+  Status InitGroupSizeTensor();
+
+  int num_tasks_;
+  int devices_per_task_;
+  std::vector<Tensor> temp_chunks_;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
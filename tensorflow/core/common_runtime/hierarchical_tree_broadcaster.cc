@@ -14,10 +14,12 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/hierarchical_tree_broadcaster.h"
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/collective_util.h"
@@ -43,15 +45,42 @@ namespace tensorflow {
 namespace {
 // Key to be used for BufRendezvous by Broadcaster.
 string BroadcastBufKey(const string& exec_key, int subdiv, int src_rank,
-                       int dst_rank) {
+                       int dst_rank, int chunk) {
   if (READABLE_KEYS) {
     return strings::StrCat("broadcast(", exec_key, "):subdiv(", subdiv,
-                           "):src(", src_rank, "):dst(", dst_rank, ")");
+                           "):src(", src_rank, "):dst(", dst_rank,
+                           "):chunk(", chunk, ")");
   } else {
     // TODO(b/78352018): Try a denser format, e.g. a 64 or 128 bit hash.
-    return strings::StrCat(exec_key, ":", subdiv, ":", src_rank, ":", dst_rank);
+    return strings::StrCat(exec_key, ":", subdiv, ":", src_rank, ":", dst_rank,
+                           ":", chunk);
   }
 }
+
+// The value is broadcast in chunks of at most kMaxChunkSizeBytes, so that a
+// device can forward a chunk to its descendents while it receives the next
+// one.  Same as the maximum chunk size of ring algorithms.
+constexpr size_t kMaxChunkSizeBytes = (4 * 1024 * 1024);
+
+// Splits `value` into chunks that alias its buffer.  Values of types that
+// can't be split, e.g. strings, are a single chunk.
+std::vector<Tensor> SplitIntoChunks(const Tensor& value) {
+  std::vector<Tensor> chunks;
+  const int64 num_elements = value.NumElements();
+  if (!DataTypeCanUseMemcpy(value.dtype()) || num_elements == 0) {
+    chunks.push_back(value);
+    return chunks;
+  }
+  Tensor flat;
+  CHECK(flat.CopyFrom(value, TensorShape({num_elements})));
+  const int64 chunk_elements = std::max<int64>(
+      1, kMaxChunkSizeBytes / DataTypeSize(value.dtype()));
+  for (int64 start = 0; start < num_elements; start += chunk_elements) {
+    chunks.push_back(
+        flat.Slice(start, std::min(start + chunk_elements, num_elements)));
+  }
+  return chunks;
+}
 }  // namespace
 
 HierarchicalTreeBroadcaster::HierarchicalTreeBroadcaster()
@@ -315,38 +344,42 @@ void HierarchicalTreeBroadcaster::RunTree() {
     int pending_count = 0;  // GUARDED_BY(mu)
     condition_variable all_done;
 
-    if (my_rank >= 0 && my_rank != source_rank) {
-      // Begin by receiving the value.
-      profiler::TraceMe activity(
-          [&] { return strings::StrCat("ReceiveValue:", si); },
-          profiler::TraceMeLevel::kInfo);
-      int recv_from_rank = TreeRecvFrom(*col_params_, si);
-      Notification note;
-      DispatchRecv(si, recv_from_rank, my_rank, col_ctx_->output,
-                   [this, &mu, &note](const Status& s) {
-                     mutex_lock l(mu);
-                     status_.Update(s);
-                     note.Notify();
-                   });
-      note.WaitForNotification();
+    const bool do_recv = my_rank >= 0 && my_rank != source_rank;
+    std::vector<int> send_to_ranks;
+    if (my_rank >= 0) {
+      TreeSendTo(*col_params_, si, &send_to_ranks);
     }
-
-    // Then forward value to all descendent devices.
+    // The chunks are received into, and forwarded from, the output.  Only the
+    // original source device forwards its input.
+    std::vector<Tensor> chunks =
+        SplitIntoChunks(is_source_ ? *col_ctx_->input : *col_ctx_->output);
     {
       profiler::TraceMe activity(
-          [&] { return strings::StrCat("ForwardValue:", si); },
+          [&] { return strings::StrCat("ReceiveAndForwardValue:", si); },
           profiler::TraceMeLevel::kInfo);
-      if (my_rank >= 0 && status_.ok()) {
-        std::vector<int> send_to_ranks;
-        TreeSendTo(*col_params_, si, &send_to_ranks);
-        for (int i = 0; i < send_to_ranks.size(); ++i) {
-          int target_rank = send_to_ranks[i];
-          {
-            mutex_lock l(mu);
-            ++pending_count;
-          }
-          DispatchSend(si, target_rank, my_rank,
-                       (is_source_ ? col_ctx_->input : col_ctx_->output),
+      for (int ci = 0; ci < chunks.size(); ++ci) {
+        if (do_recv) {
+          // Begin by receiving the chunk.  The sends of the previous chunks
+          // continue meanwhile.
+          int recv_from_rank = TreeRecvFrom(*col_params_, si);
+          Notification note;
+          DispatchRecv(si, recv_from_rank, my_rank, ci, &chunks[ci],
+                       [this, &mu, &note](const Status& s) {
+                         mutex_lock l(mu);
+                         status_.Update(s);
+                         note.Notify();
+                       });
+          note.WaitForNotification();
+        }
+        {
+          mutex_lock l(mu);
+          if (!status_.ok()) break;
+          pending_count += send_to_ranks.size();
+        }
+
+        // Then forward the chunk to all descendent devices.
+        for (int target_rank : send_to_ranks) {
+          DispatchSend(si, target_rank, my_rank, ci, &chunks[ci],
                        [this, &mu, &pending_count, &all_done](const Status& s) {
                          mutex_lock l(mu);
                          status_.Update(s);
@@ -357,47 +390,47 @@ void HierarchicalTreeBroadcaster::RunTree() {
                        });
         }
       }
+    }
 
-      // For the original source device, we copy input to output if they are
-      // different.
-      // If there is only 1 subdiv, we do this in that subdiv.  If there is more
-      // than 1 subdiv, then the original source device will participate in 2
-      // subdivs - the global inter-task broadcast and one local intra-task
-      // broadcast.  In this case, we perform the copy in the second subdiv for
-      // this device.
-      if (status_.ok() && is_source_ && (1 == num_subdivs || 0 != si)) {
-        VLOG(2) << "copying input to output for device="
-                << col_ctx_->device_name << " subdiv=" << si;
-        if (col_ctx_->input != col_ctx_->output &&
-            (DMAHelper::base(col_ctx_->input) !=
-             DMAHelper::base(col_ctx_->output))) {
-          {
-            mutex_lock l(mu);
-            ++pending_count;
-          }
-          DeviceContext* op_dev_ctx = col_ctx_->op_ctx->op_device_context();
-          CollectiveRemoteAccessLocal::MemCpyAsync(
-              op_dev_ctx, op_dev_ctx, col_ctx_->device, col_ctx_->device,
-              col_ctx_->op_ctx->input_alloc_attr(0),
-              col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
-              col_ctx_->output, 0, /*stream_index*/
-              [this, &mu, &pending_count, &all_done](const Status& s) {
-                mutex_lock l(mu);
-                status_.Update(s);
-                --pending_count;
-                if (0 == pending_count) {
-                  all_done.notify_all();
-                }
-              });
+    // For the original source device, we copy input to output if they are
+    // different.
+    // If there is only 1 subdiv, we do this in that subdiv.  If there is more
+    // than 1 subdiv, then the original source device will participate in 2
+    // subdivs - the global inter-task broadcast and one local intra-task
+    // broadcast.  In this case, we perform the copy in the second subdiv for
+    // this device.
+    if (status_.ok() && is_source_ && (1 == num_subdivs || 0 != si)) {
+      VLOG(2) << "copying input to output for device="
+              << col_ctx_->device_name << " subdiv=" << si;
+      if (col_ctx_->input != col_ctx_->output &&
+          (DMAHelper::base(col_ctx_->input) !=
+           DMAHelper::base(col_ctx_->output))) {
+        {
+          mutex_lock l(mu);
+          ++pending_count;
         }
+        DeviceContext* op_dev_ctx = col_ctx_->op_ctx->op_device_context();
+        CollectiveRemoteAccessLocal::MemCpyAsync(
+            op_dev_ctx, op_dev_ctx, col_ctx_->device, col_ctx_->device,
+            col_ctx_->op_ctx->input_alloc_attr(0),
+            col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+            col_ctx_->output, 0, /*stream_index*/
+            [this, &mu, &pending_count, &all_done](const Status& s) {
+              mutex_lock l(mu);
+              status_.Update(s);
+              --pending_count;
+              if (0 == pending_count) {
+                all_done.notify_all();
+              }
+            });
       }
+    }
 
-      // Then wait for all pending actions to complete.
-      {
-        mutex_lock l(mu);
-        if (pending_count > 0) {
-          all_done.wait(l);
-        }
+    // Then wait for all pending actions to complete.
+    {
+      mutex_lock l(mu);
+      while (pending_count > 0) {
+        all_done.wait(l);
       }
     }
   }
@@ -406,11 +439,11 @@ void HierarchicalTreeBroadcaster::RunTree() {
 }
 
 void HierarchicalTreeBroadcaster::DispatchSend(int subdiv, int dst_rank,
-                                               int src_rank,
+                                               int src_rank, int chunk,
                                                const Tensor* src_tensor,
                                                const StatusCallback& done) {
   string send_buf_key =
-      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank);
+      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank, chunk);
   int dst_idx =
       col_params_->instance.impl_details.subdiv_permutations[subdiv][dst_rank];
   VLOG(3) << "DispatchSend " << send_buf_key << " from_device "
@@ -426,10 +459,11 @@ void HierarchicalTreeBroadcaster::DispatchSend(int subdiv, int dst_rank,
 }
 
 void HierarchicalTreeBroadcaster::DispatchRecv(int subdiv, int src_rank,
-                                               int dst_rank, Tensor* dst_tensor,
+                                               int dst_rank, int chunk,
+                                               Tensor* dst_tensor,
                                                const StatusCallback& done) {
   string recv_buf_key =
-      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank);
+      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank, chunk);
   int src_idx =
       col_params_->instance.impl_details.subdiv_permutations[subdiv][src_rank];
   VLOG(3) << "DispatchRecv " << recv_buf_key << " from_device "
@@ -66,18 +66,21 @@ class HierarchicalTreeBroadcaster : public CollectiveImplementationInterface {
   // Get the task to which the device at `device_rank` belongs.
   int GetDeviceTask(int device_rank, const std::vector<int>& dev_per_task);
 
-  // Sends `src_tensor` asynchronously from this device to device at `dst_rank`
-  // in `subdiv`.  Calls `done` upon completion.
-  void DispatchSend(int subdiv, int dst_rank, int src_rank,
+  // Sends `src_tensor`, the chunk with index `chunk` of the value,
+  // asynchronously from this device to device at `dst_rank` in `subdiv`.
+  // Calls `done` upon completion.
+  void DispatchSend(int subdiv, int dst_rank, int src_rank, int chunk,
                     const Tensor* src_tensor, const StatusCallback& done);
 
-  // Receives a tensor into the memory buffer owned by `dst_tensor` at this
-  // device from device at `src_rank` in `subdiv`.  Calls `done` upon
-  // completion.
-  void DispatchRecv(int subdiv, int src_rank, int dst_rank, Tensor* dst_tensor,
-                    const StatusCallback& done);
+  // Receives the chunk with index `chunk` of the value into the memory buffer
+  // owned by `dst_tensor` at this device from device at `src_rank` in
+  // `subdiv`.  Calls `done` upon completion.
+  void DispatchRecv(int subdiv, int src_rank, int dst_rank, int chunk,
+                    Tensor* dst_tensor, const StatusCallback& done);
 
-  // Executes the hierarchical broadcast defined by this op.
+  // Executes the hierarchical broadcast defined by this op.  Large values are
+  // split into chunks, and each device forwards a chunk to its descendents
+  // while it receives the next one.
   void RunTree();
 
   CollectiveContext* col_ctx_;          // Not owned
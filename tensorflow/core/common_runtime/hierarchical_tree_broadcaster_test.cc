@@ -875,6 +875,9 @@ DEF_TEST(FLOAT, CPU, 2, 1, 128, 0, false)
 DEF_TEST(FLOAT, CPU, 2, 4, 128, 0, true)
 DEF_TEST(FLOAT, CPU, 2, 8, 4095, 0, false)
 DEF_TEST(FLOAT, CPU, 4, 4, 1045991, 0, true)
+// Values split into several chunks.
+DEF_TEST(FLOAT, CPU, 2, 2, 3145728, 0, false)
+DEF_TEST(DOUBLE, CPU, 1, 4, 1100001, 0, true)
 
 DEF_TEST(DOUBLE, CPU, 2, 4, 128, 0, false)
 DEF_TEST(INT32, CPU, 2, 4, 128, 0, true)
@@ -0,0 +1,189 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_profiler.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+namespace {
+
+const char kUnknownOpName[] = "(unknown)";
+
+}  // namespace
+
+string MemoryFragmentation::DebugString() const {
+  string result = strings::StrCat(
+      "Reserved: ", strings::HumanReadableNumBytes(bytes_reserved),
+      ", in use: ", strings::HumanReadableNumBytes(bytes_in_use),
+      ", free: ", strings::HumanReadableNumBytes(bytes_free),
+      ", largest free chunk: ",
+      strings::HumanReadableNumBytes(largest_free_chunk),
+      ", fragmentation: ", strings::Printf("%.3f", fragmentation()), "\n");
+  for (const Bin& bin : bins) {
+    strings::StrAppend(
+        &result, "  Bin (", strings::HumanReadableNumBytes(bin.bin_size),
+        "): ", bin.num_chunks, " chunks, ", bin.num_chunks_in_use,
+        " in use, ", strings::HumanReadableNumBytes(bin.bytes), " in chunks, ",
+        strings::HumanReadableNumBytes(bin.bytes_in_use), " in use, ",
+        strings::HumanReadableNumBytes(bin.requested_bytes_in_use),
+        " requested\n");
+  }
+  return result;
+}
+
+string MemoryProfile::DebugString(int max_events) const {
+  string result = strings::StrCat(
+      "Peak bytes in use: ", strings::HumanReadableNumBytes(peak_bytes_in_use),
+      " at ", peak_micros, "us in step ", peak_step_id, "\n",
+      "Live at peak by op:\n");
+  for (const OpMemory& op : live_at_peak) {
+    strings::StrAppend(&result, "  ", strings::HumanReadableNumBytes(op.bytes),
+                       " in ", op.num_allocations, " allocations by ",
+                       op.op_name, "\n");
+  }
+  strings::StrAppend(&result, "Fragmentation: ", fragmentation.DebugString());
+  if (num_failed_allocations > 0) {
+    strings::StrAppend(
+        &result, num_failed_allocations, " failed allocations, the last of ",
+        strings::HumanReadableNumBytes(last_failed_allocation_bytes),
+        ". Fragmentation at the last failure: ",
+        fragmentation_at_last_failure.DebugString());
+  }
+  const int num_shown =
+      std::min<int64>(std::max(max_events, 0), timeline.size());
+  strings::StrAppend(&result, "Timeline (last ", num_shown, " of ",
+                     num_events, " events):\n");
+  for (size_t i = timeline.size() - num_shown; i < timeline.size(); ++i) {
+    const Event& event = timeline[i];
+    strings::StrAppend(&result, "  ", event.micros, "us step ", event.step_id,
+                       event.is_allocation ? " alloc " : " free  ",
+                       event.bytes, " in use ", event.bytes_in_use, " ",
+                       event.op_name, "\n");
+  }
+  return result;
+}
+
+MemoryProfiler::MemoryProfiler(int64 max_events)
+    : max_events_(std::max<int64>(max_events, 1)) {}
+
+void MemoryProfiler::RecordAllocation(const void* ptr, int64 bytes) {
+  const char* op_name = ScopedMemoryDebugAnnotation::CurrentOpName();
+  const int64 step_id = ScopedMemoryDebugAnnotation::CurrentStepId();
+  mutex_lock l(mu_);
+  auto it = live_bytes_by_op_
+                .emplace(op_name != nullptr ? op_name : kUnknownOpName,
+                         LiveBytes())
+                .first;
+  it->second.bytes += bytes;
+  ++it->second.num_allocations;
+  const Allocation allocation = {bytes, &it->first, step_id};
+  live_[ptr] = allocation;
+  bytes_in_use_ += bytes;
+  const int64 micros = Env::Default()->NowMicros();
+  AddEvent(micros, true, allocation);
+
+  if (bytes_in_use_ > peak_bytes_in_use_) {
+    peak_bytes_in_use_ = bytes_in_use_;
+    peak_micros_ = micros;
+    peak_step_id_ = step_id;
+    live_bytes_by_op_at_peak_ = live_bytes_by_op_;
+  }
+}
+
+void MemoryProfiler::RecordDeallocation(const void* ptr) {
+  mutex_lock l(mu_);
+  auto it = live_.find(ptr);
+  if (it == live_.end()) {
+    // Allocated before the profiler was enabled.
+    return;
+  }
+  const Allocation allocation = it->second;
+  live_.erase(it);
+  LiveBytes& live_bytes = live_bytes_by_op_[*allocation.op_name];
+  live_bytes.bytes -= allocation.bytes;
+  --live_bytes.num_allocations;
+  bytes_in_use_ -= allocation.bytes;
+  AddEvent(Env::Default()->NowMicros(), false, allocation);
+}
+
+void MemoryProfiler::RecordAllocationFailure(
+    int64 bytes, const MemoryFragmentation& fragmentation) {
+  mutex_lock l(mu_);
+  ++num_failed_allocations_;
+  last_failed_allocation_bytes_ = bytes;
+  fragmentation_at_last_failure_ = fragmentation;
+}
+
+void MemoryProfiler::AddEvent(int64 micros, bool is_allocation,
+                              const Allocation& allocation) {
+  MemoryProfile::Event event;
+  event.micros = micros;
+  event.is_allocation = is_allocation;
+  event.bytes = allocation.bytes;
+  event.bytes_in_use = bytes_in_use_;
+  event.op_name = *allocation.op_name;
+  event.step_id = allocation.step_id;
+  if (static_cast<int64>(events_.size()) < max_events_) {
+    events_.push_back(std::move(event));
+  } else {
+    events_[num_events_ % max_events_] = std::move(event);
+  }
+  ++num_events_;
+}
+
+MemoryProfile MemoryProfiler::GetProfile() {
+  MemoryProfile profile;
+  mutex_lock l(mu_);
+  // The oldest event is the one the next event would overwrite.
+  const size_t oldest = static_cast<int64>(events_.size()) < max_events_
+                            ? 0
+                            : num_events_ % max_events_;
+  profile.timeline.reserve(events_.size());
+  for (size_t i = 0; i < events_.size(); ++i) {
+    profile.timeline.push_back(events_[(oldest + i) % events_.size()]);
+  }
+  profile.num_events = num_events_;
+
+  profile.peak_bytes_in_use = peak_bytes_in_use_;
+  profile.peak_micros = peak_micros_;
+  profile.peak_step_id = peak_step_id_;
+  for (const auto& op : live_bytes_by_op_at_peak_) {
+    if (op.second.num_allocations > 0) {
+      profile.live_at_peak.push_back(
+          {op.first, op.second.bytes, op.second.num_allocations});
+    }
+  }
+  std::sort(profile.live_at_peak.begin(), profile.live_at_peak.end(),
+            [](const MemoryProfile::OpMemory& a,
+               const MemoryProfile::OpMemory& b) {
+              return a.bytes != b.bytes ? a.bytes > b.bytes
+                                        : a.op_name < b.op_name;
+            });
+
+  profile.num_failed_allocations = num_failed_allocations_;
+  profile.last_failed_allocation_bytes = last_failed_allocation_bytes_;
+  profile.fragmentation_at_last_failure = fragmentation_at_last_failure_;
+  return profile;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,176 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PROFILER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PROFILER_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The state of an allocator's free memory at one point in time.
+struct MemoryFragmentation {
+  // Chunks whose size falls in [bin_size, 2 * bin_size).
+  struct Bin {
+    int64 bin_size = 0;
+    int64 num_chunks = 0;
+    int64 num_chunks_in_use = 0;
+    int64 bytes = 0;
+    int64 bytes_in_use = 0;
+    int64 requested_bytes_in_use = 0;
+  };
+
+  int64 micros = 0;
+  int64 bytes_reserved = 0;
+  int64 bytes_in_use = 0;
+  int64 bytes_free = 0;
+  int64 largest_free_chunk = 0;
+  // Only the bins that hold chunks.
+  std::vector<Bin> bins;
+
+  // The part of the free memory that an allocation of the size of all free
+  // memory could not use: 0 when all free memory is contiguous.
+  double fragmentation() const {
+    return bytes_free > 0
+               ? 1.0 - static_cast<double>(largest_free_chunk) / bytes_free
+               : 0.0;
+  }
+
+  string DebugString() const;
+};
+
+// A memory profile recorded by a MemoryProfiler.
+struct MemoryProfile {
+  struct Event {
+    int64 micros = 0;
+    bool is_allocation = true;
+    int64 bytes = 0;
+    // The bytes in use right after the event.
+    int64 bytes_in_use = 0;
+    // The op and step that made the allocation, also for deallocations.
+    string op_name;
+    int64 step_id = 0;
+  };
+
+  // The bytes live at one point in time that were allocated by one op.
+  struct OpMemory {
+    string op_name;
+    int64 bytes = 0;
+    int64 num_allocations = 0;
+  };
+
+  // The most recent events, oldest first.
+  std::vector<Event> timeline;
+  // The number of events recorded, including the ones that no longer are in
+  // the timeline.
+  int64 num_events = 0;
+
+  int64 peak_bytes_in_use = 0;
+  int64 peak_micros = 0;
+  int64 peak_step_id = 0;
+  // The memory live at the peak by op, largest first.
+  std::vector<OpMemory> live_at_peak;
+
+  // The state of the free memory when the profile was taken.
+  MemoryFragmentation fragmentation;
+
+  // The last allocation that failed for lack of memory, if any.
+  int64 num_failed_allocations = 0;
+  int64 last_failed_allocation_bytes = 0;
+  MemoryFragmentation fragmentation_at_last_failure;
+
+  // Renders the profile, with at most the last `max_events` events of the
+  // timeline.
+  string DebugString(int max_events) const;
+};
+
+// Records the allocations and deallocations of an allocator, attributed to
+// the op and step that made them (see ScopedMemoryDebugAnnotation).
+//
+// The most recent `max_events` events are kept in a ring buffer, which forms
+// the memory timeline. Independently of the ring buffer, the profiler keeps
+// the bytes live per op, and copies them whenever the bytes in use reach a
+// new peak, so that the memory live at the peak can be reported even after
+// its events have left the ring buffer.
+//
+// Thread-safe.
+class MemoryProfiler {
+ public:
+  explicit MemoryProfiler(int64 max_events);
+
+  // Records an allocation of `bytes` at `ptr` by the op of the current
+  // thread's ScopedMemoryDebugAnnotation.
+  void RecordAllocation(const void* ptr, int64 bytes);
+
+  // Records the deallocation of `ptr`, which must be recorded as allocated.
+  // Must be called before the memory can be allocated again.
+  void RecordDeallocation(const void* ptr);
+
+  // Records an allocation of `bytes` that failed for lack of memory.
+  void RecordAllocationFailure(int64 bytes,
+                               const MemoryFragmentation& fragmentation);
+
+  // Returns the profile recorded so far. The caller fills in
+  // `fragmentation`.
+  MemoryProfile GetProfile();
+
+ private:
+  struct Allocation {
+    int64 bytes;
+    // Points to a key of live_bytes_by_op_.
+    const string* op_name;
+    int64 step_id;
+  };
+
+  struct LiveBytes {
+    int64 bytes = 0;
+    int64 num_allocations = 0;
+  };
+
+  void AddEvent(int64 micros, bool is_allocation, const Allocation& allocation)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64 max_events_;
+
+  mutex mu_;
+  std::vector<MemoryProfile::Event> events_ GUARDED_BY(mu_);
+  int64 num_events_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<const void*, Allocation> live_ GUARDED_BY(mu_);
+  // Entries are never erased, so that Allocation::op_name stays valid.
+  std::unordered_map<string, LiveBytes> live_bytes_by_op_ GUARDED_BY(mu_);
+  int64 bytes_in_use_ GUARDED_BY(mu_) = 0;
+
+  int64 peak_bytes_in_use_ GUARDED_BY(mu_) = 0;
+  int64 peak_micros_ GUARDED_BY(mu_) = 0;
+  int64 peak_step_id_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<string, LiveBytes> live_bytes_by_op_at_peak_
+      GUARDED_BY(mu_);
+
+  int64 num_failed_allocations_ GUARDED_BY(mu_) = 0;
+  int64 last_failed_allocation_bytes_ GUARDED_BY(mu_) = 0;
+  MemoryFragmentation fragmentation_at_last_failure_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryProfiler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PROFILER_H_
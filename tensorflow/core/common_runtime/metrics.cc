@@ -14,8 +14,14 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/metrics.h"
+
+#include <atomic>
+
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace metrics {
@@ -61,6 +67,12 @@ auto* tf_data_elements_counter = monitoring::Counter<1>::New(
 auto* tf_data_optimization_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/optimization", "tf.data optimization", "name");
 
+auto* tf_data_vectorization_blocked_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/vectorization_blocked",
+    "The number of times an op prevented a tf.data map function from being "
+    "vectorized.",
+    "op_type");
+
 auto* build_graph_calls = monitoring::Counter<0>::New(
     "/tensorflow/core/graph_build_calls",
     "The number of times TensorFlow has created a new client graph. "
@@ -78,6 +90,50 @@ auto* build_graph_time_usecs = monitoring::Counter<0>::New(
     "spent optimizing the graph with Grappler, and time spent pruning the "
     "sub-graph.");
 
+auto* executor_work_stealing_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor_work_stealing",
+    "The number of nodes run by the work-stealing executor, by whether the "
+    "node was run by the worker that made it ready or stolen by another.",
+    "source");
+
+auto* executor_scheduling_delay_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/executor_scheduling_delay_usecs",
+     "The time between a node becoming ready and an inter-op thread starting "
+     "to run it in microseconds, in sampled executor steps."},
+    // Power of 2 with bucket count 20 (> 1 second)
+    {monitoring::Buckets::Exponential(1, 2, 20)});
+
+auto* executor_queue_depth = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/executor_queue_depth",
+     "The number of nodes of a step dispatched to the inter-op thread pool "
+     "but not yet started, when a node is dispatched, in sampled executor "
+     "steps."},
+    // Power of 2 with bucket count 16 (> 32K nodes)
+    {monitoring::Buckets::Exponential(1, 2, 16)});
+
+auto* executor_ready_nodes_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor_ready_nodes",
+    "The number of ready nodes in sampled executor steps, by whether they "
+    "were run inline by the thread that made them ready or dispatched to the "
+    "inter-op thread pool.",
+    "dispatch");
+
+auto* run_handler_queueing_delay_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler_queueing_delay_usecs",
+     "The time Session::Run() calls waited for a handler from the "
+     "RunHandlerPool in microseconds, by priority class.",
+     "priority"},
+    // Power of 2 with bucket count 20 (> 1 second)
+    {monitoring::Buckets::Exponential(1, 2, 20)});
+
+auto* rpc_phase_usecs = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/rpc_phase_usecs",
+     "The time RPCs spent in each phase of their processing in microseconds, "
+     "by method and phase.",
+     "method", "phase"},
+    // Power of 2 with bucket count 24 (> 8 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
 }  // namespace
 
 void RecordTFDataAutotune(const string& name) {
@@ -96,6 +152,10 @@ void RecordTFDataOptimization(const string& name, int64 num_changes) {
   tf_data_optimization_counter->GetCell(name)->IncrementBy(num_changes);
 }
 
+void RecordTFDataVectorizationBlocked(const string& op_type) {
+  tf_data_vectorization_blocked_counter->GetCell(op_type)->IncrementBy(1);
+}
+
 void RecordGraphInputTensors(const size_t size) {
   graph_run_input_tensor_bytes->GetCell()->Add(size);
 }
@@ -112,6 +172,67 @@ void UpdateGraphExecTime(const uint64 running_time_usecs) {
   }
 }
 
+void RecordExecutorWorkStealing(int64 local_hits, int64 steals) {
+  static auto* local_hits_cell =
+      executor_work_stealing_counter->GetCell("local");
+  static auto* steals_cell = executor_work_stealing_counter->GetCell("stolen");
+  if (local_hits > 0) local_hits_cell->IncrementBy(local_hits);
+  if (steals > 0) steals_cell->IncrementBy(steals);
+}
+
+std::atomic<int64>* ExecutorMetricsSampleRate() {
+  static std::atomic<int64>* sample_rate = new std::atomic<int64>([] {
+    int64 rate;
+    Status s = ReadInt64FromEnvVar("TF_EXECUTOR_METRICS_SAMPLE_RATE", 100,
+                                   &rate);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return int64{0};
+    }
+    return rate;
+  }());
+  return sample_rate;
+}
+
+bool ShouldSampleExecutorStep() {
+  const int64 sample_rate =
+      ExecutorMetricsSampleRate()->load(std::memory_order_relaxed);
+  if (sample_rate <= 0) return false;
+  static std::atomic<uint64> num_steps{0};
+  return num_steps.fetch_add(1, std::memory_order_relaxed) % sample_rate == 0;
+}
+
+void SetExecutorMetricsSampleRateForTesting(int64 sample_rate) {
+  ExecutorMetricsSampleRate()->store(sample_rate, std::memory_order_relaxed);
+}
+
+void RecordExecutorSchedulingDelay(uint64 delay_usecs) {
+  static auto* cell = executor_scheduling_delay_usecs->GetCell();
+  cell->Add(delay_usecs);
+}
+
+void RecordExecutorQueueDepth(int64 depth) {
+  static auto* cell = executor_queue_depth->GetCell();
+  cell->Add(depth);
+}
+
+void RecordExecutorReadyNodes(int64 inline_nodes, int64 dispatched_nodes) {
+  static auto* inline_cell = executor_ready_nodes_counter->GetCell("inline");
+  static auto* dispatched_cell =
+      executor_ready_nodes_counter->GetCell("dispatched");
+  if (inline_nodes > 0) inline_cell->IncrementBy(inline_nodes);
+  if (dispatched_nodes > 0) dispatched_cell->IncrementBy(dispatched_nodes);
+}
+
+void RecordRunHandlerQueueingDelay(int64 priority, uint64 delay_usecs) {
+  run_handler_queueing_delay_usecs->GetCell(strings::StrCat(priority))
+      ->Add(delay_usecs);
+}
+
+void RecordRpcPhase(const string& method, const string& phase, uint64 usecs) {
+  rpc_phase_usecs->GetCell(method, phase)->Add(usecs);
+}
+
 void UpdateGraphBuildTime(const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
     build_graph_calls->GetCell()->IncrementBy(1);
@@ -43,12 +43,66 @@ void RecordTFDataElements(const string& name, int64 num_elements);
 // The `name` argument identifies the optimization (e.g. "noop_eliminiation").
 void RecordTFDataOptimization(const string& name, int64 num_changes);
 
+// Records that a tf.data map function could not be fully vectorized because of
+// an op of type `op_type`, which has no vectorizer or whose vectorizer failed.
+void RecordTFDataVectorizationBlocked(const string& op_type);
+
 // Records the size of input/output tensors in bytes.
 void RecordGraphInputTensors(const size_t size);
 void RecordGraphOutputTensors(const size_t size);
 
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 
+// Records how the nodes dispatched by a step of the work-stealing executor
+// were picked up: `local_hits` were run by the worker that produced them and
+// `steals` were taken from another worker's queue.
+void RecordExecutorWorkStealing(int64 local_hits, int64 steals);
+
+// Returns true if the scheduling of the executor step about to start should
+// be recorded by the functions below. One step in
+// TF_EXECUTOR_METRICS_SAMPLE_RATE (default 100) is sampled, and none if it is
+// 0, so steps that are not sampled pay for a single relaxed atomic increment.
+bool ShouldSampleExecutorStep();
+
+// Overrides TF_EXECUTOR_METRICS_SAMPLE_RATE for the steps started afterwards.
+void SetExecutorMetricsSampleRateForTesting(int64 sample_rate);
+
+// Records, for a sampled step, the time between a node becoming ready and an
+// inter-op thread starting to run it.
+void RecordExecutorSchedulingDelay(uint64 delay_usecs);
+
+// Records, for a sampled step, the number of nodes dispatched to the inter-op
+// thread pool but not yet started, when a node is dispatched.
+void RecordExecutorQueueDepth(int64 depth);
+
+// Records how the ready nodes of a sampled step were run: `inline_nodes` by
+// the thread that made them ready and `dispatched_nodes` by the inter-op
+// thread pool.
+void RecordExecutorReadyNodes(int64 inline_nodes, int64 dispatched_nodes);
+
+// Records the time a Session::Run() call of the given priority class waited
+// for a handler from the RunHandlerPool.
+void RecordRunHandlerQueueingDelay(int64 priority, uint64 delay_usecs);
+
+// Records the time in microseconds an RPC spent in one `phase`. `method` is
+// the full gRPC method name (e.g. "/tensorflow.WorkerService/RecvTensor") and
+// `phase` one of:
+//   "client_serialization": encoding the request on the client.
+//   "client_latency": from sending the request to receiving the response.
+//   "client_callback_queueing": from receiving the response to a callback
+//     thread starting to decode it.
+//   "client_decode": decoding the response on the client.
+//   "server_queueing": from the request arriving at the server to a thread
+//     starting to handle it.
+//   "server_handling": from starting to handle the request to the response
+//     being ready to send, e.g. including the wait for the tensor of a
+//     RecvTensor and its encoding.
+//   "server_tensor_encode": encoding a tensor into the response.
+//   "response_transfer": from the server starting to encode the response to
+//     the client receiving it. Measured with the clocks of both machines, and
+//     clamped to the client latency.
+void RecordRpcPhase(const string& method, const string& phase, uint64 usecs);
+
 // Updates the metrics stored about time spent building graphs.
 //
 // By "GraphBuild", we refer to building a client graph, which is a sub-graph of
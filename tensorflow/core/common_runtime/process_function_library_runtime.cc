@@ -28,8 +28,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/rendezvous_util.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph.h"
@@ -505,6 +508,18 @@ Status ValidateMultiDeviceOptions(
         options.output_devices.size(),
         " number of arguments = ", signature.output_arg_size());
   }
+  if (options.num_micro_batches < 1) {
+    return errors::InvalidArgument(
+        "InstantiateOptions.num_micro_batches must be at least 1, got ",
+        options.num_micro_batches);
+  }
+  for (const int index : options.summed_micro_batch_outputs) {
+    if (index < 0 || index >= signature.output_arg_size()) {
+      return errors::InvalidArgument(
+          "InstantiateOptions.summed_micro_batch_outputs contains ", index,
+          " but the function has ", signature.output_arg_size(), " outputs");
+    }
+  }
   return Status::OK();
 }
 
@@ -544,6 +559,47 @@ Status GetGraphAndArgRets(
   return Status::OK();
 }
 
+// Adds to `channels` the rendezvous key of every tensor that a Send node of
+// `subgraph` sends, outside of any loop, to another device of `device_mgr`.
+Status AddIntraProcessChannels(const DeviceMgr* device_mgr,
+                               const Graph& subgraph,
+                               IntraProcessChannelIndex* channels) {
+  for (const Node* node : subgraph.op_nodes()) {
+    if (!node->IsSend()) continue;
+    bool client_terminated;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node->attrs(), "client_terminated", &client_terminated));
+    bool hostmem_sendrecv;
+    if (client_terminated ||
+        (GetNodeAttr(node->attrs(), "_hostmem_sendrecv", &hostmem_sendrecv)
+             .ok() &&
+         hostmem_sendrecv)) {
+      // Keyed by the client, or by the call frame of the function.
+      continue;
+    }
+    string send_device, recv_device, tensor_name;
+    int64 send_device_incarnation;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node->attrs(), "send_device", &send_device));
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node->attrs(), "recv_device", &recv_device));
+    TF_RETURN_IF_ERROR(GetNodeAttr(node->attrs(), "send_device_incarnation",
+                                   &send_device_incarnation));
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node->attrs(), "tensor_name", &tensor_name));
+    Device* device;
+    if (!device_mgr->LookupDevice(send_device, &device).ok() ||
+        !device_mgr->LookupDevice(recv_device, &device).ok()) {
+      continue;
+    }
+    const string key = Rendezvous::CreateKey(
+        send_device, static_cast<uint64>(send_device_incarnation),
+        recv_device, tensor_name, FrameAndIter(0, 0));
+    channels->emplace(key, channels->size());
+  }
+  return Status::OK();
+}
+
 }  // anonymous namespace
 
 Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
@@ -615,6 +671,11 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
       absl::make_unique<MultiDeviceFunctionData>(
           function_name, function_key, ret_node_names.size(),
           lib_def->ReachableDefinitions(*fdef), std::move(ret_types));
+  data->num_micro_batches_ = options.num_micro_batches;
+  data->sum_micro_batch_outputs_.resize(data->num_outputs_);
+  for (const int index : options.summed_micro_batch_outputs) {
+    data->sum_micro_batch_outputs_[index] = true;
+  }
 
   GraphOptimizationPassOptions optimization_options;
   // TODO(iga): Thread other relevant options from SessionOptions.
@@ -758,6 +819,26 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
         subgraph, device_type, &comp_data->arg_indices_,
         &comp_data->ret_indices_, &comp_data->arg_alloc_attrs_,
         &comp_data->ret_alloc_attrs_));
+    if (data->num_micro_batches_ > 1) {
+      // The return values of the micro-batches are combined on the host.
+      if (GetFLR(target) == nullptr) {
+        return errors::Unimplemented(
+            "Micro-batches of multi-device functions can only run on local "
+            "devices, but function ",
+            function_name, " places ops on ", target);
+      }
+      for (int j = 0; j < comp_data->ret_indices_.size(); ++j) {
+        const int ret_index = comp_data->ret_indices_[j];
+        if (data->ret_types_[ret_index] == DT_RESOURCE ||
+            (device_type != DEVICE_CPU &&
+             !comp_data->ret_alloc_attrs_[j].on_host())) {
+          return errors::InvalidArgument(
+              "The ", ret_index, "-th return value of function ",
+              function_name, " must be a tensor in host memory to be ",
+              "combined across micro-batches, but it is on ", target);
+        }
+      }
+    }
     FunctionDef shard;
     string unique_name = name_generator.GetName();
     TF_RETURN_IF_ERROR(
@@ -778,6 +859,9 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
             << component_handle;
     VLOG(2) << DebugString(shard);
     comp_data->handle_ = component_handle;
+
+    TF_RETURN_IF_ERROR(
+        AddIntraProcessChannels(device_mgr_, *subgraph, &data->channels_));
   }
 
   *handle = AddMultiDeviceHandle(std::move(data), function_key);
@@ -868,6 +952,31 @@ void ProcessFunctionLibraryRuntime::RunMultiDevice(
     return;
   }
 
+  if (data->num_micro_batches_ > 1) {
+    RunMicroBatches(opts, data, args, rets, cleanup_items, std::move(done));
+  } else {
+    RunComponentFunctions(opts, data, args, rets, cleanup_items,
+                          std::move(done));
+  }
+}
+
+void ProcessFunctionLibraryRuntime::RunComponentFunctions(
+    const FunctionLibraryRuntime::Options& opts,
+    const MultiDeviceFunctionData* data, gtl::ArraySlice<Tensor> args,
+    std::vector<Tensor>* rets,
+    std::vector<std::unique_ptr<CleanUpItem>>* cleanup_items,
+    FunctionLibraryRuntime::DoneCallback done) const {
+  // Tensors exchanged between the local component functions go through
+  // channels bound at instantiation rather than through `opts.rendezvous`.
+  Rendezvous* local_rendezvous = opts.rendezvous;
+  if (opts.rendezvous != nullptr && !data->channels_.empty()) {
+    local_rendezvous = new IntraProcessChannelRendezvous(
+        device_mgr_, &data->channels_, opts.rendezvous);
+    done = [local_rendezvous, done](const Status& status) {
+      local_rendezvous->Unref();
+      done(status);
+    };
+  }
   auto* refcounted_done = new ReffedStatusCallback(std::move(done));
   for (int i = 0; i < data->glue_.size(); ++i) {
     refcounted_done->Ref();
@@ -895,13 +1004,16 @@ void ProcessFunctionLibraryRuntime::RunMultiDevice(
       thread::ThreadPool* pool = flr->device()->tensorflow_device_thread_pool();
       opts_copy.runner = (pool == nullptr) ? opts_copy.runner : flr->runner();
 
+      opts_copy.rendezvous = local_rendezvous;
+
       VLOG(1) << "Running component function on device " << target
               << " with handle " << handle;
       VLOG(4) << "    with " << opts_copy.DebugString();
 
+      Rendezvous* rendezvous = opts_copy.rendezvous;
       flr->Run(opts_copy, handle, comp_args, comp_rets,
-               [comp_rets, rets, comp_data, refcounted_done,
-                data](const Status& status) {
+               [comp_rets, rets, comp_data, refcounted_done, data,
+                rendezvous](const Status& status) {
                  if (!status.ok()) {
                    VLOG(2) << "Component function execution failed: " << status;
                    const string function_and_msg = strings::StrCat(
@@ -909,6 +1021,11 @@ void ProcessFunctionLibraryRuntime::RunMultiDevice(
                        " ", status.error_message());
                    refcounted_done->UpdateStatus(
                        Status(status.code(), function_and_msg));
+                   // A micro-batch owns its rendezvous, so unblock the
+                   // component functions waiting on this one here.
+                   if (data->num_micro_batches_ > 1) {
+                     rendezvous->StartAbort(status);
+                   }
                  } else {
                    for (int i = 0; i < comp_rets->size(); ++i) {
                      (*rets)[comp_data.ret_indices_[i]] = (*comp_rets)[i];
@@ -920,6 +1037,7 @@ void ProcessFunctionLibraryRuntime::RunMultiDevice(
                });
     } else {
       opts_copy.remote_execution = true;
+      opts_copy.rendezvous = opts.rendezvous;
 
       VLOG(1) << "Running component function on device " << target
               << " with handle " << handle;
@@ -944,6 +1062,112 @@ void ProcessFunctionLibraryRuntime::RunMultiDevice(
   refcounted_done->Unref();
 }
 
+namespace {
+
+// Returns the elementwise sum of `tensors`, which have the same shape.
+Status SumTensors(const std::vector<Tensor>& tensors, Tensor* sum) {
+  *sum = tensor::DeepCopy(tensors[0]);
+  for (size_t i = 1; i < tensors.size(); ++i) {
+    if (tensors[i].shape() != sum->shape()) {
+      return errors::InvalidArgument(
+          "Cannot sum micro-batch return values of shapes ",
+          sum->shape().DebugString(), " and ",
+          tensors[i].shape().DebugString());
+    }
+    switch (sum->dtype()) {
+#define CASE(T)                                   \
+  case DataTypeToEnum<T>::value:                  \
+    sum->flat<T>() += tensors[i].flat<T>();       \
+    break;
+      TF_CALL_NUMBER_TYPES(CASE);
+#undef CASE
+      default:
+        return errors::InvalidArgument(
+            "Cannot sum micro-batch return values of type ",
+            DataTypeString(sum->dtype()));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+void ProcessFunctionLibraryRuntime::RunMicroBatches(
+    const FunctionLibraryRuntime::Options& opts,
+    const MultiDeviceFunctionData* data, gtl::ArraySlice<Tensor> args,
+    std::vector<Tensor>* rets,
+    std::vector<std::unique_ptr<CleanUpItem>>* cleanup_items,
+    FunctionLibraryRuntime::DoneCallback done) const {
+  const int num_micro_batches = data->num_micro_batches_;
+  std::vector<std::vector<Tensor>> micro_batch_args(num_micro_batches);
+  for (const Tensor& arg : args) {
+    if (arg.dtype() == DT_RESOURCE || arg.dims() == 0) {
+      for (std::vector<Tensor>& micro_batch : micro_batch_args) {
+        micro_batch.push_back(arg);
+      }
+      continue;
+    }
+    const int64 batch_size = arg.dim_size(0);
+    if (batch_size % num_micro_batches != 0) {
+      done(errors::InvalidArgument(
+          "Cannot split an argument of function ", data->function_name_,
+          " with batch size ", batch_size, " into ", num_micro_batches,
+          " micro-batches"));
+      return;
+    }
+    const int64 micro_batch_size = batch_size / num_micro_batches;
+    for (int i = 0; i < num_micro_batches; ++i) {
+      micro_batch_args[i].push_back(
+          arg.Slice(i * micro_batch_size, (i + 1) * micro_batch_size));
+    }
+  }
+
+  auto micro_batch_rets =
+      std::make_shared<std::vector<std::vector<Tensor>>>(num_micro_batches);
+  auto* refcounted_done = new ReffedStatusCallback(
+      [data, rets, micro_batch_rets, done](const Status& status) {
+        if (!status.ok()) {
+          done(status);
+          return;
+        }
+        rets->resize(data->num_outputs_);
+        for (int j = 0; j < data->num_outputs_; ++j) {
+          std::vector<Tensor> parts;
+          parts.reserve(micro_batch_rets->size());
+          for (const std::vector<Tensor>& micro_batch : *micro_batch_rets) {
+            parts.push_back(micro_batch[j]);
+          }
+          Status s = data->sum_micro_batch_outputs_[j]
+                         ? SumTensors(parts, &(*rets)[j])
+                         : tensor::Concat(parts, &(*rets)[j]);
+          if (!s.ok()) {
+            done(s);
+            return;
+          }
+        }
+        done(Status::OK());
+      });
+  for (int i = 0; i < num_micro_batches; ++i) {
+    refcounted_done->Ref();
+  }
+
+  // The _Send/_Recv nodes of the component functions use the same keys for
+  // all the micro-batches, so every micro-batch gets its own rendezvous.
+  FunctionLibraryRuntime::Options opts_copy = opts;
+  for (int i = 0; i < num_micro_batches; ++i) {
+    Rendezvous* rendezvous = new IntraProcessRendezvous(device_mgr_);
+    opts_copy.rendezvous = rendezvous;
+    RunComponentFunctions(
+        opts_copy, data, micro_batch_args[i], &(*micro_batch_rets)[i],
+        cleanup_items, [rendezvous, refcounted_done](const Status& status) {
+          rendezvous->Unref();
+          refcounted_done->UpdateStatus(status);
+          refcounted_done->Unref();
+        });
+  }
+  refcounted_done->Unref();
+}
+
 Status ProcessFunctionLibraryRuntime::Instantiate(
     const string& function_name, AttrSlice attrs,
     const FunctionLibraryRuntime::InstantiateOptions& options,
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -214,9 +215,19 @@ class ProcessFunctionLibraryRuntime {
     const int num_outputs_;
     DataTypeVector ret_types_;
 
+    // See InstantiateOptions.num_micro_batches.
+    int num_micro_batches_ = 1;
+    // sum_micro_batch_outputs_[i] is true if the i-th return value of the
+    // micro-batches is summed rather than concatenated.
+    std::vector<bool> sum_micro_batch_outputs_;
+
     // Maps the device name to the information about the component function
     // be run on this device.
     std::unordered_map<string, ComponentFunctionData> glue_;
+
+    // The channels of the tensors that the component functions exchange
+    // between devices of this process. See IntraProcessChannelRendezvous.
+    IntraProcessChannelIndex channels_;
   };
 
   // For a given device_name, returns a DeviceContext for copying
@@ -293,6 +304,24 @@ class ProcessFunctionLibraryRuntime {
                       gtl::ArraySlice<Tensor> args, std::vector<Tensor>* rets,
                       std::vector<std::unique_ptr<CleanUpItem>>* cleanup_items,
                       FunctionLibraryRuntime::DoneCallback done) const;
+  // Runs the component functions of `data` once on `args`.
+  void RunComponentFunctions(
+      const FunctionLibraryRuntime::Options& opts,
+      const MultiDeviceFunctionData* data, gtl::ArraySlice<Tensor> args,
+      std::vector<Tensor>* rets,
+      std::vector<std::unique_ptr<CleanUpItem>>* cleanup_items,
+      FunctionLibraryRuntime::DoneCallback done) const;
+
+  // Splits `args` into data->num_micro_batches_ micro-batches, runs them
+  // concurrently through the component functions, and combines their return
+  // values into `rets`.
+  void RunMicroBatches(
+      const FunctionLibraryRuntime::Options& opts,
+      const MultiDeviceFunctionData* data, gtl::ArraySlice<Tensor> args,
+      std::vector<Tensor>* rets,
+      std::vector<std::unique_ptr<CleanUpItem>>* cleanup_items,
+      FunctionLibraryRuntime::DoneCallback done) const;
+
   void CleanUp(std::vector<std::unique_ptr<CleanUpItem>>* items,
                FunctionLibraryRuntime::DoneCallback done) const;
 
@@ -733,6 +733,46 @@ TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_ResourceOutput_GPU) {
                                  test::AsTensor<float>({10, 20}));
 }
 
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_MicroBatches) {
+  // Two stages, on CPU:0 and CPU:1. `y` is concatenated over the
+  // micro-batches, and `y_sum` is summed.
+  FunctionDef two_stages = FunctionDefHelper::Create(
+      "TwoStages", {"x: float"}, {"y: float", "y_sum: float"}, {},
+      {{{"two"}, "Const", {}, {{"value", 2.0f}, {"dtype", DT_FLOAT}}},
+       {{"stage_0"},
+        "Mul",
+        {"x", "two:output:0"},
+        {{"T", DT_FLOAT}},
+        {},
+        "/device:CPU:0"},
+       {{"stage_1"},
+        "Mul",
+        {"stage_0:z:0", "two:output:0"},
+        {{"T", DT_FLOAT}},
+        {},
+        "/device:CPU:1"}},
+      {{"y", "stage_1:z:0"}, {"y_sum", "stage_1:z:0"}});
+  Init({two_stages});
+
+  FunctionLibraryRuntime::InstantiateOptions inst_opts =
+      MakeOptions("CPU:0", {"CPU:0"}, {"CPU:0", "CPU:0"});
+  inst_opts.num_micro_batches = 2;
+  inst_opts.summed_micro_batch_outputs = {1};
+  FunctionLibraryRuntime::Options opts;
+  opts.rendezvous = rendezvous_;
+  Tensor y;
+  Tensor y_sum;
+  TF_CHECK_OK(Run("TwoStages", opts, {}, inst_opts,
+                  {test::AsTensor<float>({1, 2, 3, 4})}, {&y, &y_sum}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({4, 8, 12, 16}));
+  test::ExpectTensorEqual<float>(y_sum, test::AsTensor<float>({16, 24}));
+
+  // The batch must split evenly.
+  Status status = Run("TwoStages", opts, {}, inst_opts,
+                      {test::AsTensor<float>({1, 2, 3})}, {&y, &y_sum});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
 TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_PlacerError) {
   if (gpu_device_ == nullptr) {
     GTEST_SKIP() << "No GPUs available";
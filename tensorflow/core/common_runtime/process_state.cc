@@ -60,8 +60,8 @@ ProcessState::MemDesc ProcessState::PtrType(const void* ptr) {
 }
 
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
-  if (!numa_enabled_ || numa_node == port::kNUMANoAffinity) numa_node = 0;
   mutex_lock lock(mu_);
+  if (!numa_enabled_ || numa_node == port::kNUMANoAffinity) numa_node = 0;
   while (cpu_allocators_.size() <= static_cast<size_t>(numa_node)) {
     // If visitors have been defined we need an Allocator built from
     // a SubAllocator.  Prefer BFCAllocator, but fall back to PoolAllocator
@@ -56,8 +56,12 @@ class ProcessState : public ProcessStateInterface {
   };
 
   // If NUMA Allocators are desired, call this before calling any
-  // Allocator accessor.
-  void EnableNUMA() { numa_enabled_ = true; }
+  // Allocator accessor.  Allocators created before the call are not
+  // bound to a node.
+  void EnableNUMA() {
+    mutex_lock l(mu_);
+    numa_enabled_ = true;
+  }
 
   // Returns what we know about the memory at ptr.
   // If we know nothing, it's called CPU 0 with no other attributes.
@@ -92,10 +96,10 @@ class ProcessState : public ProcessStateInterface {
   void TestOnlyReset();
 
   static ProcessState* instance_;
-  bool numa_enabled_;
-
   mutex mu_;
 
+  bool numa_enabled_ GUARDED_BY(mu_);
+
   // Indexed by numa_node.  If we want numa-specific allocators AND a
   // non-specific allocator, maybe should index by numa_node+1.
   std::vector<Allocator*> cpu_allocators_ GUARDED_BY(mu_);
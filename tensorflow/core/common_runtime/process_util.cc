@@ -73,7 +73,8 @@ static thread::ThreadPool* InitComputePool(const SessionOptions& options) {
     inter_op_parallelism_threads = DefaultNumInterOpThreads();
   }
   return new thread::ThreadPool(
-      Env::Default(), ThreadOptions(), "Compute", inter_op_parallelism_threads,
+      Env::Default(), InterOpThreadOptions(options), "Compute",
+      inter_op_parallelism_threads,
       !options.config.experimental().disable_thread_spinning(),
       /*allocator=*/nullptr);
 }
@@ -122,12 +123,19 @@ int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options) {
   return DefaultNumInterOpThreads();
 }
 
+ThreadOptions InterOpThreadOptions(const SessionOptions& options) {
+  ThreadOptions thread_options;
+  const auto& cpus = options.config.experimental().inter_op_cpu_affinity();
+  thread_options.cpu_affinity.assign(cpus.begin(), cpus.end());
+  return thread_options;
+}
+
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options) {
   const int32 num_threads = NumInterOpThreadsFromSessionOptions(options);
   VLOG(1) << "Direct session inter op parallelism threads: " << num_threads;
   return new thread::ThreadPool(
-      options.env, ThreadOptions(), "Compute", num_threads,
+      options.env, InterOpThreadOptions(options), "Compute", num_threads,
       !options.config.experimental().disable_thread_spinning(),
       /*allocator=*/nullptr);
 }
@@ -44,6 +44,10 @@ int32 NumIntraOpThreadsFromEnvironment();
 // on the number of schedulable CPUs, and any MKL and OpenMP configurations.
 int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options);
 
+// Returns the options for the threads of inter op thread pools created for
+// `options`.
+ThreadOptions InterOpThreadOptions(const SessionOptions& options);
+
 // Creates a thread pool with number of inter op threads.
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options);
@@ -31,38 +31,18 @@ limitations under the License.
 
 namespace tensorflow {
 
-IntraProcessRendezvous::IntraProcessRendezvous(const DeviceMgr* device_mgr)
-    : device_mgr_(device_mgr), local_(NewLocalRendezvous()) {}
-
-IntraProcessRendezvous::~IntraProcessRendezvous() { local_->Unref(); }
-
-Status IntraProcessRendezvous::Send(const ParsedKey& parsed,
-                                    const Rendezvous::Args& args,
-                                    const Tensor& val, const bool is_dead) {
-  VLOG(1) << "IntraProcessRendezvous Send " << this << " " << parsed.FullKey();
-  {
-    mutex_lock l(mu_);
-    if (!status_.ok()) return status_;
-  }
+namespace {
 
-  // Buffers "val" and "device_context" in local_.
-  return local_->Send(parsed, args, val, is_dead);
-}
-
-Status IntraProcessRendezvous::ParseKey(const string& key, bool is_src,
-                                        Rendezvous::ParsedKey* parsed) {
-  {
-    mutex_lock l(mu_);
-    if (!status_.ok()) return status_;
-  }
-  TF_RETURN_IF_ERROR(Rendezvous::ParseKey(key, parsed));
-  return Status::OK();
-}
+typedef std::function<void(const Status&)> StatusCallback;
 
-void IntraProcessRendezvous::SameWorkerRecvDone(
-    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& send_args,
-    const Rendezvous::Args& recv_args, const Tensor& in, Tensor* out,
-    StatusCallback done) {
+// Callback handling the case when a rendezvous has been accomplished and the
+// consumer is local to this process. Tensor "in" will be copied into "out".
+// The key "parsed" encodes the src and dst devices.
+void SameWorkerRecvDone(const DeviceMgr* device_mgr,
+                        const Rendezvous::ParsedKey& parsed,
+                        const Rendezvous::Args& send_args,
+                        const Rendezvous::Args& recv_args, const Tensor& in,
+                        Tensor* out, StatusCallback done) {
   // Do a quick copy (sharing the underlying buffer) if both tensors
   // are on host memory.
   const bool src_host =
@@ -87,13 +67,13 @@ void IntraProcessRendezvous::SameWorkerRecvDone(
   }
 
   Device* src_device;
-  Status s = device_mgr_->LookupDevice(parsed.src_device, &src_device);
+  Status s = device_mgr->LookupDevice(parsed.src_device, &src_device);
   if (!s.ok()) {
     done(s);
     return;
   }
   Device* dst_device;
-  s = device_mgr_->LookupDevice(parsed.dst_device, &dst_device);
+  s = device_mgr->LookupDevice(parsed.dst_device, &dst_device);
   if (!s.ok()) {
     done(s);
     return;
@@ -129,6 +109,66 @@ void IntraProcessRendezvous::SameWorkerRecvDone(
       out, 0 /*dev_to_dev_stream_index*/, std::move(done), sync_dst_compute);
 }
 
+// Hands the tensor "in" that was sent on "parsed" to the receiver's "done",
+// copying it to the receiving device first if needed.
+void IntraProcessRecvDone(const DeviceMgr* device_mgr,
+                          const Rendezvous::ParsedKey& parsed,
+                          const Status& status,
+                          const Rendezvous::Args& send_args,
+                          const Rendezvous::Args& recv_args, const Tensor& in,
+                          bool is_dead, Rendezvous::DoneCallback done) {
+  // If "in" is an uninitialized tensor, do copy-construction to
+  // preserve the uninitialized state, along with data type and shape
+  // info, which is useful for debugger purposes.
+  Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
+
+  auto final_callback = std::bind(
+      [send_args, recv_args, out, is_dead](Rendezvous::DoneCallback done,
+                                           // Begin unbound arguments.
+                                           const Status& s) {
+        done(s, send_args, recv_args, *out, is_dead);
+        delete out;
+      },
+      std::move(done), std::placeholders::_1);
+
+  if (status.ok() && in.IsInitialized()) {
+    SameWorkerRecvDone(device_mgr, parsed, send_args, recv_args, in, out,
+                       std::move(final_callback));
+  } else {
+    final_callback(status);
+  }
+}
+
+}  // namespace
+
+IntraProcessRendezvous::IntraProcessRendezvous(const DeviceMgr* device_mgr)
+    : device_mgr_(device_mgr), local_(NewLocalRendezvous()) {}
+
+IntraProcessRendezvous::~IntraProcessRendezvous() { local_->Unref(); }
+
+Status IntraProcessRendezvous::Send(const ParsedKey& parsed,
+                                    const Rendezvous::Args& args,
+                                    const Tensor& val, const bool is_dead) {
+  VLOG(1) << "IntraProcessRendezvous Send " << this << " " << parsed.FullKey();
+  {
+    mutex_lock l(mu_);
+    if (!status_.ok()) return status_;
+  }
+
+  // Buffers "val" and "device_context" in local_.
+  return local_->Send(parsed, args, val, is_dead);
+}
+
+Status IntraProcessRendezvous::ParseKey(const string& key, bool is_src,
+                                        Rendezvous::ParsedKey* parsed) {
+  {
+    mutex_lock l(mu_);
+    if (!status_.ok()) return status_;
+  }
+  TF_RETURN_IF_ERROR(Rendezvous::ParseKey(key, parsed));
+  return Status::OK();
+}
+
 void IntraProcessRendezvous::RecvAsync(const ParsedKey& parsed,
                                        const Rendezvous::Args& recv_args,
                                        DoneCallback done) {
@@ -144,26 +184,8 @@ void IntraProcessRendezvous::RecvAsync(const ParsedKey& parsed,
                          const Rendezvous::Args& send_args,
                          const Rendezvous::Args& recv_args, const Tensor& in,
                          bool is_dead) {
-            // If "in" is an uninitialized tensor, do copy-construction to
-            // preserve the uninitialized state, along with data type and shape
-            // info, which is useful for debugger purposes.
-            Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
-
-            auto final_callback = std::bind(
-                [send_args, recv_args, out, is_dead](DoneCallback done,
-                                                     // Begin unbound arguments.
-                                                     const Status& s) {
-                  done(s, send_args, recv_args, *out, is_dead);
-                  delete out;
-                },
-                std::move(done), std::placeholders::_1);
-
-            if (status.ok() && in.IsInitialized()) {
-              SameWorkerRecvDone(parsed, send_args, recv_args, in, out,
-                                 std::move(final_callback));
-            } else {
-              final_callback(status);
-            }
+            IntraProcessRecvDone(device_mgr_, parsed, status, send_args,
+                                 recv_args, in, is_dead, std::move(done));
           },
           std::move(done), std::placeholders::_1, std::placeholders::_2,
           std::placeholders::_3, std::placeholders::_4, std::placeholders::_5));
@@ -174,4 +196,164 @@ void IntraProcessRendezvous::StartAbort(const Status& s) {
   local_->StartAbort(s);
 }
 
+
+// The state of one channel. A channel holds at most one of a sent tensor that
+// no receiver has asked for yet and a receiver that waits for a tensor.
+struct IntraProcessChannelRendezvous::Channel {
+  mutex mu;
+  // Status given by StartAbort() if any.
+  Status status GUARDED_BY(mu);
+
+  bool has_value GUARDED_BY(mu) = false;
+  Tensor value GUARDED_BY(mu);
+  bool is_dead GUARDED_BY(mu) = false;
+  Rendezvous::Args send_args GUARDED_BY(mu);
+
+  DoneCallback waiter GUARDED_BY(mu);
+  Rendezvous::Args recv_args GUARDED_BY(mu);
+};
+
+IntraProcessChannelRendezvous::IntraProcessChannelRendezvous(
+    const DeviceMgr* device_mgr, const IntraProcessChannelIndex* channels,
+    Rendezvous* base)
+    : device_mgr_(device_mgr),
+      channels_(channels),
+      channel_state_(new Channel[channels->size()]),
+      base_(base) {
+  base_->Ref();
+}
+
+IntraProcessChannelRendezvous::~IntraProcessChannelRendezvous() {
+  for (size_t i = 0; i < channels_->size(); ++i) {
+    Channel* channel = &channel_state_[i];
+    mutex_lock l(channel->mu);
+    if (channel->has_value && channel->send_args.device_context) {
+      channel->send_args.device_context->Unref();
+    }
+    if (channel->waiter && channel->recv_args.device_context) {
+      channel->recv_args.device_context->Unref();
+    }
+  }
+  base_->Unref();
+}
+
+IntraProcessChannelRendezvous::Channel*
+IntraProcessChannelRendezvous::FindChannel(const ParsedKey& key) const {
+  auto it = channels_->find(key.FullKey());
+  return it == channels_->end() ? nullptr : &channel_state_[it->second];
+}
+
+Status IntraProcessChannelRendezvous::Send(const ParsedKey& key,
+                                           const Rendezvous::Args& args,
+                                           const Tensor& val,
+                                           const bool is_dead) {
+  Channel* channel = FindChannel(key);
+  if (channel == nullptr) {
+    return base_->Send(key, args, val, is_dead);
+  }
+  VLOG(2) << "IntraProcessChannelRendezvous Send " << this << " "
+          << key.FullKey();
+
+  DoneCallback waiter;
+  Rendezvous::Args recv_args;
+  {
+    mutex_lock l(channel->mu);
+    if (!channel->status.ok()) return channel->status;
+    if (channel->has_value) {
+      return errors::Internal("Sent a second tensor on ", key.FullKey(),
+                              " before the first was received.");
+    }
+    if (!channel->waiter) {
+      // The receiver picks the tensor up when it arrives.
+      channel->has_value = true;
+      channel->value = val;
+      channel->is_dead = is_dead;
+      channel->send_args = args;
+      if (args.device_context) args.device_context->Ref();
+      return Status::OK();
+    }
+    waiter = std::move(channel->waiter);
+    channel->waiter = nullptr;
+    recv_args = channel->recv_args;
+  }
+
+  IntraProcessRecvDone(device_mgr_, key, Status::OK(), args, recv_args, val,
+                       is_dead, std::move(waiter));
+  if (recv_args.device_context) recv_args.device_context->Unref();
+  return Status::OK();
+}
+
+void IntraProcessChannelRendezvous::RecvAsync(const ParsedKey& key,
+                                              const Rendezvous::Args& args,
+                                              DoneCallback done) {
+  Channel* channel = FindChannel(key);
+  if (channel == nullptr) {
+    base_->RecvAsync(key, args, std::move(done));
+    return;
+  }
+  VLOG(2) << "IntraProcessChannelRendezvous Recv " << this << " "
+          << key.FullKey();
+
+  channel->mu.lock();
+  if (!channel->status.ok()) {
+    Status s = channel->status;
+    channel->mu.unlock();
+    done(s, Args(), args, Tensor(), false);
+    return;
+  }
+  if (!channel->has_value) {
+    if (channel->waiter) {
+      channel->mu.unlock();
+      done(errors::Internal("Received a second tensor on ", key.FullKey(),
+                            " before the first was sent."),
+           Args(), args, Tensor(), false);
+      return;
+    }
+    // The sender hands the tensor over when it arrives.
+    channel->waiter = std::move(done);
+    channel->recv_args = args;
+    if (args.device_context) args.device_context->Ref();
+    channel->mu.unlock();
+    return;
+  }
+  Tensor value = std::move(channel->value);
+  channel->value = Tensor();
+  const bool is_dead = channel->is_dead;
+  const Rendezvous::Args send_args = channel->send_args;
+  channel->has_value = false;
+  channel->mu.unlock();
+
+  IntraProcessRecvDone(device_mgr_, key, Status::OK(), send_args, args, value,
+                       is_dead, std::move(done));
+  if (send_args.device_context) send_args.device_context->Unref();
+}
+
+void IntraProcessChannelRendezvous::StartAbort(const Status& status) {
+  CHECK(!status.ok());
+  for (size_t i = 0; i < channels_->size(); ++i) {
+    Channel* channel = &channel_state_[i];
+    DoneCallback waiter;
+    Rendezvous::Args recv_args;
+    {
+      mutex_lock l(channel->mu);
+      channel->status.Update(status);
+      if (channel->has_value) {
+        channel->has_value = false;
+        channel->value = Tensor();
+        if (channel->send_args.device_context) {
+          channel->send_args.device_context->Unref();
+        }
+      }
+      waiter = std::move(channel->waiter);
+      channel->waiter = nullptr;
+      recv_args = channel->recv_args;
+    }
+    if (waiter) {
+      waiter(status, Args(), recv_args, Tensor(), false);
+      if (recv_args.device_context) recv_args.device_context->Unref();
+    }
+  }
+  base_->StartAbort(status);
+}
+
 }  // end namespace tensorflow
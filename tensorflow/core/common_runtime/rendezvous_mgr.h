@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_RENDEZVOUS_MGR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_RENDEZVOUS_MGR_H_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -72,19 +74,55 @@ class IntraProcessRendezvous : public Rendezvous {
   Status ParseKey(const string& key, bool is_src,
                   Rendezvous::ParsedKey* parsed);
 
-  // Callback handling the case when a rendezvous has been
-  // accomplished in local_ and the consumer is local to this process.
-  // Tensor "in" will be copied into "out". The key "parsed" encodes
-  // the src and dst devices.
-  typedef std::function<void(const Status&)> StatusCallback;
-  void SameWorkerRecvDone(const Rendezvous::ParsedKey& parsed,
-                          const Rendezvous::Args& send_args,
-                          const Rendezvous::Args& recv_args, const Tensor& in,
-                          Tensor* out, StatusCallback done);
-
   TF_DISALLOW_COPY_AND_ASSIGN(IntraProcessRendezvous);
 };
 
+// Maps the rendezvous key of each tensor that is sent between two devices of
+// this process to the index of the channel that carries it.
+typedef absl::flat_hash_map<string, int> IntraProcessChannelIndex;
+
+// IntraProcessChannelRendezvous is a Rendezvous for a single run of a
+// multi-device function, whose Send/Recv pairs are all known when the
+// function is instantiated.
+//
+// Each key in "channels" gets a preallocated channel that holds either the
+// sent tensor or the waiting receiver, so these tensors are exchanged without
+// the shared, string-keyed table and per-tensor allocations of a local
+// rendezvous. The tensors are copied between devices as
+// IntraProcessRendezvous does. Every other key is forwarded to "base", which
+// serves the tensors exchanged with remote devices.
+class IntraProcessChannelRendezvous : public Rendezvous {
+ public:
+  // "channels" must outlive this object.
+  IntraProcessChannelRendezvous(const DeviceMgr* device_mgr,
+                                const IntraProcessChannelIndex* channels,
+                                Rendezvous* base);
+
+  Status Send(const ParsedKey& key, const Rendezvous::Args& args,
+              const Tensor& val, const bool is_dead) override;
+
+  void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
+                 DoneCallback done) override;
+
+  // Fails the receivers waiting on the channels and aborts "base".
+  void StartAbort(const Status& status) override;
+
+ private:
+  struct Channel;
+
+  ~IntraProcessChannelRendezvous() override;
+
+  // Returns the channel of "key", or nullptr if "key" goes through "base".
+  Channel* FindChannel(const ParsedKey& key) const;
+
+  const DeviceMgr* device_mgr_;
+  const IntraProcessChannelIndex* const channels_;
+  std::unique_ptr<Channel[]> channel_state_;
+  Rendezvous* const base_;  // Owns a Ref on this object.
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IntraProcessChannelRendezvous);
+};
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_RENDEZVOUS_MGR_H_
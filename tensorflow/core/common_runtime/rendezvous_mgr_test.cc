@@ -0,0 +1,165 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/rendezvous_mgr.h"
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+Rendezvous::ParsedKey MakeKey(const string& name) {
+  const string s = Rendezvous::CreateKey(
+      "/job:localhost/replica:0/task:0/device:CPU:0", 1,
+      "/job:localhost/replica:0/task:0/device:CPU:1", name,
+      FrameAndIter(0, 0));
+  Rendezvous::ParsedKey key;
+  TF_CHECK_OK(Rendezvous::ParseKey(s, &key));
+  return key;
+}
+
+class IntraProcessChannelRendezvousTest : public ::testing::Test {
+ protected:
+  IntraProcessChannelRendezvousTest()
+      : key_foo_(MakeKey("foo")), key_bar_(MakeKey("bar")) {
+    SessionOptions options;
+    (*options.config.mutable_device_count())["CPU"] = 2;
+    std::vector<std::unique_ptr<Device>> devices;
+    TF_CHECK_OK(DeviceFactory::AddDevices(
+        options, "/job:localhost/replica:0/task:0", &devices));
+    device_mgr_.reset(new DeviceMgr(std::move(devices)));
+
+    // Only "foo" has a channel; "bar" goes through the base rendezvous.
+    channels_[string(key_foo_.FullKey())] = 0;
+    base_ = NewLocalRendezvous();
+    rendez_ = new IntraProcessChannelRendezvous(device_mgr_.get(),
+                                                &channels_, base_);
+  }
+
+  ~IntraProcessChannelRendezvousTest() override {
+    rendez_->Unref();
+    base_->Unref();
+  }
+
+  const Rendezvous::ParsedKey key_foo_;
+  const Rendezvous::ParsedKey key_bar_;
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  IntraProcessChannelIndex channels_;
+  Rendezvous* base_;
+  Rendezvous* rendez_;
+};
+
+TEST_F(IntraProcessChannelRendezvousTest, SendThenRecv) {
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(key_foo_, args, test::AsScalar<float>(1.0f), false));
+  Tensor val;
+  bool is_dead = true;
+  TF_ASSERT_OK(rendez_->Recv(key_foo_, args, &val, &is_dead));
+  EXPECT_FALSE(is_dead);
+  test::ExpectTensorEqual<float>(test::AsScalar<float>(1.0f), val);
+
+  // The channel can carry the next tensor once the first was received.
+  TF_ASSERT_OK(
+      rendez_->Send(key_foo_, args, test::AsScalar<float>(2.0f), false));
+  TF_ASSERT_OK(rendez_->Recv(key_foo_, args, &val, &is_dead));
+  test::ExpectTensorEqual<float>(test::AsScalar<float>(2.0f), val);
+}
+
+TEST_F(IntraProcessChannelRendezvousTest, RecvThenSend) {
+  Rendezvous::Args args;
+  Notification done;
+  Status status;
+  Tensor val;
+  rendez_->RecvAsync(key_foo_, args,
+                     [&](const Status& s, const Rendezvous::Args& send_args,
+                         const Rendezvous::Args& recv_args, const Tensor& v,
+                         const bool is_dead) {
+                       status = s;
+                       val = v;
+                       EXPECT_FALSE(is_dead);
+                       done.Notify();
+                     });
+  EXPECT_FALSE(done.HasBeenNotified());
+  TF_ASSERT_OK(
+      rendez_->Send(key_foo_, args, test::AsScalar<float>(3.0f), false));
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  test::ExpectTensorEqual<float>(test::AsScalar<float>(3.0f), val);
+}
+
+TEST_F(IntraProcessChannelRendezvousTest, DeadTensor) {
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(key_foo_, args, Tensor(), true));
+  Tensor val;
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(key_foo_, args, &val, &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
+TEST_F(IntraProcessChannelRendezvousTest, DuplicateSend) {
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(key_foo_, args, test::AsScalar<float>(1.0f), false));
+  EXPECT_TRUE(errors::IsInternal(
+      rendez_->Send(key_foo_, args, test::AsScalar<float>(2.0f), false)));
+  // The first tensor is still delivered.
+  Tensor val;
+  bool is_dead = true;
+  TF_ASSERT_OK(rendez_->Recv(key_foo_, args, &val, &is_dead));
+  test::ExpectTensorEqual<float>(test::AsScalar<float>(1.0f), val);
+}
+
+TEST_F(IntraProcessChannelRendezvousTest, StartAbortFailsPendingRecv) {
+  Rendezvous::Args args;
+  Notification done;
+  Status status;
+  rendez_->RecvAsync(key_foo_, args,
+                     [&](const Status& s, const Rendezvous::Args& send_args,
+                         const Rendezvous::Args& recv_args, const Tensor& v,
+                         const bool is_dead) {
+                       status = s;
+                       done.Notify();
+                     });
+  rendez_->StartAbort(errors::Aborted("abort"));
+  done.WaitForNotification();
+  EXPECT_TRUE(errors::IsAborted(status));
+
+  // Later sends fail, on the channels and on the base rendezvous alike.
+  EXPECT_TRUE(errors::IsAborted(
+      rendez_->Send(key_foo_, args, test::AsScalar<float>(1.0f), false)));
+  EXPECT_TRUE(errors::IsAborted(
+      rendez_->Send(key_bar_, args, test::AsScalar<float>(1.0f), false)));
+}
+
+TEST_F(IntraProcessChannelRendezvousTest, ForwardsUnknownKeysToBase) {
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(key_bar_, args, test::AsScalar<float>(4.0f), false));
+  Tensor val;
+  bool is_dead = true;
+  TF_ASSERT_OK(base_->Recv(key_bar_, args, &val, &is_dead));
+  test::ExpectTensorEqual<float>(test::AsScalar<float>(4.0f), val);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -80,6 +80,7 @@ class RingAlg : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    Tensor wire_chunk;  // if initialized, sent and recv'd in place of chunk
     Status status;
     string DebugString() const;
   };
@@ -164,6 +164,43 @@ void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
   if (rf->do_recv) {
     rf->tmp_chunk = ca_->TempChunk(rf->sc_idx);
   }
+  if (col_params_->instance.wire_data_type != DT_INVALID &&
+      ca_->ChunkBytes(rf->sc_idx) > 0) {
+    rf->wire_chunk = Tensor(col_ctx_->device->GetAllocator(
+                                col_ctx_->op_ctx->output_alloc_attr(0)),
+                            col_params_->instance.wire_data_type,
+                            TensorShape({rf->chunk.NumElements()}));
+  }
+}
+
+Status RingReducer::EncodeField(RingField* rf) {
+  return collective_util::ComputeUnaryOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->encode_op.get(), &rf->chunk, &rf->wire_chunk);
+}
+
+Status RingReducer::DecodeField(RingField* rf) {
+  Tensor decoded;
+  TF_RETURN_IF_ERROR(collective_util::ComputeUnaryOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->decode_op.get(), &rf->wire_chunk, &decoded));
+  if (!rf->second_pass) {
+    rf->tmp_chunk = decoded;
+    return Status::OK();
+  }
+  Notification note;
+  Status status;
+  CollectiveRemoteAccessLocal::MemCpyAsync(
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+      col_ctx_->device, col_ctx_->op_ctx->output_alloc_attr(0),
+      col_ctx_->op_ctx->output_alloc_attr(0), &decoded, &rf->chunk,
+      0 /*dev_to_dev_stream_index*/, [&note, &status](const Status& s) {
+        status.Update(s);
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
 }
 
 // At the beginning of the algorithm initialize a RingField struct for
@@ -251,15 +288,28 @@ bool RingReducer::RunAsyncParts() {
             --recv_pending_count;
             if (!rf->second_pass) {
               rf->action = RF_REDUCE;
-              Status s = collective_util::ComputeBinOp(
-                  col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
-                  col_params_->merge_op.get(), &rf->chunk, &rf->tmp_chunk);
+              Status s;
+              if (rf->wire_chunk.IsInitialized()) {
+                s = DecodeField(rf);
+              }
+              if (s.ok()) {
+                s = collective_util::ComputeBinOp(
+                    col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+                    col_params_->merge_op.get(), &rf->chunk, &rf->tmp_chunk);
+              }
               if (!s.ok()) {
                 aborted = true;
                 StartAbort(s);
               }
             } else {
               rf->action = RF_SEND_READY;
+              if (rf->wire_chunk.IsInitialized()) {
+                Status s = DecodeField(rf);
+                if (!s.ok()) {
+                  aborted = true;
+                  StartAbort(s);
+                }
+              }
             }
             break;
           case RF_REDUCE:
@@ -282,6 +332,21 @@ bool RingReducer::RunAsyncParts() {
             rf->action = RF_DONE;
             break;
           case RF_SEND_READY:
+            // A value received in the second pass is forwarded as received.
+            if (rf->wire_chunk.IsInitialized() &&
+                (rf->second_pass ? !rf->do_recv : rf->do_send)) {
+              Status s = EncodeField(rf);
+              if (s.ok() && rf->second_pass) {
+                // Round the final value as the other devices will receive
+                // it, so that all of them end up with the same result.
+                s = DecodeField(rf);
+              }
+              if (!s.ok()) {
+                aborted = true;
+                StartAbort(s);
+                break;
+              }
+            }
             if (rf->do_send) {
               rf->action = RF_SEND;
               auto send_complete = [this, rf, &ready_queue,
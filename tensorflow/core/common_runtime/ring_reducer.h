@@ -49,6 +49,12 @@ class RingReducer : public RingAlg {
   void ContinueAfterInputCopy();
   bool RunAsyncParts();
 
+  // With a wire codec, converts rf->chunk to the wire type before it is sent,
+  // and rf->wire_chunk back to the data type after it is received: into
+  // rf->tmp_chunk in the first pass and into rf->chunk in the second.
+  Status EncodeField(RingField* rf);
+  Status DecodeField(RingField* rf);
+
   Tensor group_size_tensor_;
   Notification group_size_tensor_ready_;
 
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
@@ -118,6 +120,19 @@ std::unique_ptr<OpKernel> GetAdd(DataType dtype, const DeviceType& device_type,
   return GetKernel(node_def, device_type, device);
 }
 
+std::unique_ptr<OpKernel> GetCast(DataType src, DataType dst,
+                                  const DeviceType& device_type,
+                                  DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder("cast_node", "Cast");
+  TF_CHECK_OK(builder.Attr("SrcT", src)
+                  .Attr("DstT", dst)
+                  .Attr("Truncate", false)
+                  .Input(FakeInput(src))
+                  .Finalize(&node_def));
+  return GetKernel(node_def, device_type, device);
+}
+
 std::unique_ptr<OpKernel> GetDiv(DataType dtype, const DeviceType& device_type,
                                  DeviceBase* device) {
   NodeDef node_def;
@@ -153,7 +168,8 @@ class RingReducerTest : public ::testing::Test {
   }
 
   void Init(int num_workers, int num_devices, DataType dtype,
-            const DeviceType& device_type, int num_subdivs, int fail_after) {
+            const DeviceType& device_type, int num_subdivs, int fail_after,
+            const string& collective_name = "RingReduce") {
 #ifdef GOOGLE_CUDA
     InitGPUDevices();
 #endif
@@ -203,8 +219,9 @@ class RingReducerTest : public ::testing::Test {
     col_params_.instance.instance_key = kInstanceKey;
     col_params_.instance.impl_details.subdiv_offsets.clear();
     col_params_.instance.type = REDUCTION_COLLECTIVE;
-    col_params_.instance.impl_details.collective_name = "RingReduce";
+    col_params_.instance.impl_details.collective_name = collective_name;
     col_params_.instance.data_type = dtype;
+    col_params_.instance.wire_data_type = wire_data_type_;
     col_params_.instance.impl_details.subdiv_permutations.resize(num_subdivs);
     col_params_.subdiv_rank.resize(num_subdivs);
     int subdiv_stride = num_devices / num_subdivs;
@@ -283,8 +300,10 @@ class RingReducerTest : public ::testing::Test {
   template <typename T>
   void RunTest(DataType dtype, const DeviceType& device_type, int num_workers,
                int num_devices, int num_subdivs, int tensor_len,
-               int fail_after) {
-    Init(num_workers, num_devices, dtype, device_type, num_subdivs, fail_after);
+               int fail_after,
+               const string& collective_name = "RingReduce") {
+    Init(num_workers, num_devices, dtype, device_type, num_subdivs, fail_after,
+         collective_name);
     std::vector<T> expected(tensor_len, 0.0);
     for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
       DeviceInstance* instance = instances_[di];
@@ -315,6 +334,7 @@ class RingReducerTest : public ::testing::Test {
       for (int i = 0; i < tensor_len; ++i) {
         expected[i] /= (num_workers * num_devices);
       }
+      Tensor first_actual;
       for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
         TF_EXPECT_OK(instances_[di]->status_);
         Tensor* inst = &instances_[di]->tensor_;
@@ -337,6 +357,22 @@ class RingReducerTest : public ::testing::Test {
         }
 
         auto alias = actual.template unaligned_flat<T>();
+        if (wire_data_type_ != DT_INVALID) {
+          // Values are rounded on every hop, but all devices must still
+          // end up with identical results.
+          if (di == 0) {
+            first_actual = actual;
+          } else {
+            test::ExpectTensorEqual<T>(first_actual, actual);
+          }
+          const double group_size = num_workers * num_devices;
+          for (int i = 0; i < tensor_len; ++i) {
+            EXPECT_NEAR(expected[i], alias(i),
+                        std::abs(expected[i]) * group_size / 128 + 1e-6)
+                << "Mismatch at device " << di << " index " << i;
+          }
+          continue;
+        }
         for (int i = 0; i < tensor_len; ++i) {
           switch (dtype) {
             case DT_FLOAT:
@@ -468,6 +504,14 @@ class RingReducerTest : public ::testing::Test {
           GetAdd(col_params_.instance.data_type, device_type_, device_);
       col_params_.final_op =
           GetDiv(col_params_.instance.data_type, device_type_, device_);
+      if (col_params_.instance.wire_data_type != DT_INVALID) {
+        col_params_.encode_op =
+            GetCast(col_params_.instance.data_type,
+                    col_params_.instance.wire_data_type, device_type_, device_);
+        col_params_.decode_op =
+            GetCast(col_params_.instance.wire_data_type,
+                    col_params_.instance.data_type, device_type_, device_);
+      }
 
       // Prepare an OpKernelContext.
       OpKernelContext::Params op_params;
@@ -507,17 +551,23 @@ class RingReducerTest : public ::testing::Test {
                                                        &output_tensor_ptr));
       CHECK_EQ(output_tensor_ptr, ctx.mutable_output(0));
 
-      // Prepare a RingReducer instance.
+      // Prepare a RingReducer or HierarchicalRingReducer instance.
       string exec_key =
           strings::StrCat(col_params_.instance.instance_key, ":0:0");
-      RingReducer reducer;
+      std::unique_ptr<RingAlg> reducer;
+      if (col_params_.instance.impl_details.collective_name ==
+          "HierarchicalRingReduce") {
+        reducer.reset(new HierarchicalRingReducer);
+      } else {
+        reducer.reset(new RingReducer);
+      }
       CollectiveContext col_ctx(parent_->col_exec_, parent_->dev_mgr_.get(),
                                 &ctx, &op_params, col_params_, exec_key,
                                 kStepId, &tensor_, &tensor_);
-      TF_CHECK_OK(reducer.InitializeCollectiveContext(&col_ctx));
+      TF_CHECK_OK(reducer->InitializeCollectiveContext(&col_ctx));
 
       // Run the all-reduce.
-      reducer.Run([this](Status s) { status_ = s; });
+      reducer->Run([this](Status s) { status_ = s; });
       if (status_.ok()) {
         CHECK(tensor_.CopyFrom(*ctx.mutable_output(0), tensor_.shape()));
       }
@@ -541,6 +591,7 @@ class RingReducerTest : public ::testing::Test {
 
   bool stop_ = false;
   DeviceType device_type_;
+  DataType wire_data_type_ = DT_INVALID;
   TestCollectiveExecutorMgr col_exec_mgr_;
   CollectiveExecutor* col_exec_;
   CollectiveRemoteAccessLocal* rma_;
@@ -705,6 +756,43 @@ DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 7)
 DEF_TEST(FLOAT, CPU, 2, 8, 2, 9408, 11)
 #endif
 
+#define DEF_HIERARCHICAL_TEST(B, C, T, W, D, L, A)                            \
+  TEST_F(RingReducerTest,                                                     \
+         HierDaTy##B##_DevTy##T##_Wkr##W##_Dev##D##_Len##L##_Abrt##A) {       \
+    RunTest<C>(DT_##B, DEVICE_##T, W, D, 1, L, A, "HierarchicalRingReduce");  \
+  }
+
+#ifndef GOOGLE_CUDA
+// Success tests
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 1, 4, 1001, 0)
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 4, 1, 1001, 0)
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 2, 4, 1, 0)
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 2, 4, 7, 0)
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 2, 4, 1001, 0)
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 4, 2, 4095, 0)
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 3, 8, 1045991, 0)
+DEF_HIERARCHICAL_TEST(DOUBLE, double, CPU, 2, 4, 4095, 0)
+DEF_HIERARCHICAL_TEST(INT64, int64, CPU, 4, 2, 4095, 0)
+
+// Failure tests
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 2, 8, 9408, 1)
+DEF_HIERARCHICAL_TEST(FLOAT, float, CPU, 2, 8, 9408, 7)
+#endif
+
+#define DEF_WIRE_TEST(T, W, D, S, L, A)                                     \
+  TEST_F(RingReducerTest,                                                   \
+         WireBf16_DevTy##T##_Wkr##W##_Dev##D##_Sdiv##S##_Len##L##_Abrt##A) { \
+    wire_data_type_ = DT_BFLOAT16;                                          \
+    RunTest<float>(DT_FLOAT, DEVICE_##T, W, D, S, L, A);                    \
+  }
+
+#ifndef GOOGLE_CUDA
+DEF_WIRE_TEST(CPU, 1, 2, 1, 1, 0)
+DEF_WIRE_TEST(CPU, 1, 2, 1, 1001, 0)
+DEF_WIRE_TEST(CPU, 2, 4, 2, 4095, 0)
+DEF_WIRE_TEST(CPU, 2, 8, 1, 9408, 7)
+#endif
+
 #ifdef GOOGLE_CUDA
 // GPU tests.  So long as the device names are all in a single tasks we
 // bypass inter-worker routing code and can fake multiple GPUs with a single
@@ -0,0 +1,121 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/sampled_traces.h"
+
+#include <algorithm>
+#include <map>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Appends `s` as a quoted JSON string.
+void AppendQuoted(StringPiece s, string* json) {
+  json->push_back('"');
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      json->push_back('\\');
+      json->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      strings::Appendf(json, "\\u%04x", c);
+    } else {
+      json->push_back(c);
+    }
+  }
+  json->push_back('"');
+}
+
+}  // namespace
+
+SampledTraces* SampledTraces::Global() {
+  static SampledTraces* global = new SampledTraces(kDefaultCapacity);
+  return global;
+}
+
+void SampledTraces::Add(StepStats step_stats) {
+  mutex_lock l(mu_);
+  if (static_cast<int>(steps_.size()) >= capacity_) {
+    steps_.pop_front();
+  }
+  steps_.push_back(std::move(step_stats));
+}
+
+std::vector<StepStats> SampledTraces::Get() const {
+  mutex_lock l(mu_);
+  return std::vector<StepStats>(steps_.begin(), steps_.end());
+}
+
+void SampledTraces::Clear() {
+  mutex_lock l(mu_);
+  steps_.clear();
+}
+
+string SampledTraces::ToChromeTraceJson() const {
+  return StepStatsToChromeTraceJson(Get());
+}
+
+string StepStatsToChromeTraceJson(const std::vector<StepStats>& steps) {
+  // Devices get the same pid in all the steps.
+  std::map<string, int> device_pids;
+  for (const StepStats& step : steps) {
+    for (const DeviceStepStats& dev_stats : step.dev_stats()) {
+      device_pids.emplace(dev_stats.device(), device_pids.size());
+    }
+  }
+
+  string json = "{\"traceEvents\":[";
+  bool first = true;
+  auto start_event = [&json, &first]() {
+    if (!first) json.push_back(',');
+    first = false;
+  };
+  for (const auto& device_pid : device_pids) {
+    start_event();
+    strings::Appendf(&json,
+                     "{\"ph\":\"M\",\"pid\":%d,\"name\":\"process_name\","
+                     "\"args\":{\"name\":",
+                     device_pid.second);
+    AppendQuoted(device_pid.first, &json);
+    strings::StrAppend(&json, "}}");
+  }
+  for (const StepStats& step : steps) {
+    for (const DeviceStepStats& dev_stats : step.dev_stats()) {
+      const int pid = device_pids[dev_stats.device()];
+      for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+        start_event();
+        strings::StrAppend(&json, "{\"ph\":\"X\",\"cat\":\"Op\",\"name\":");
+        AppendQuoted(node_stats.node_name(), &json);
+        strings::Appendf(&json,
+                         ",\"pid\":%d,\"tid\":%u,\"ts\":%lld,\"dur\":%lld,"
+                         "\"args\":{\"label\":",
+                         pid, node_stats.thread_id(),
+                         static_cast<long long>(node_stats.all_start_micros()),
+                         static_cast<long long>(
+                             std::max<int64>(node_stats.all_end_rel_micros(),
+                                             1)));
+        AppendQuoted(node_stats.timeline_label(), &json);
+        strings::StrAppend(&json, "}}");
+      }
+    }
+  }
+  strings::StrAppend(&json, "]}");
+  return json;
+}
+
+}  // namespace tensorflow
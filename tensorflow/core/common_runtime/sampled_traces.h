@@ -0,0 +1,68 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_TRACES_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_TRACES_H_
+
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Keeps the per-op timings of the most recent sampled steps, so that a server
+// can export them without tracing every request. Sessions add a step here for
+// one in `ConfigProto.Experimental.trace_sample_period` Run calls.
+class SampledTraces {
+ public:
+  // Number of steps kept by the process-wide instance.
+  static constexpr int kDefaultCapacity = 64;
+
+  // Returns the process-wide instance, which the sessions add steps to.
+  static SampledTraces* Global();
+
+  explicit SampledTraces(int capacity) : capacity_(capacity) {}
+
+  // Adds a sampled step, dropping the oldest step if the buffer is full.
+  void Add(StepStats step_stats);
+
+  // Returns the sampled steps, oldest first.
+  std::vector<StepStats> Get() const;
+
+  // Drops all the sampled steps.
+  void Clear();
+
+  // Returns the sampled steps in the Chrome trace event format, which can be
+  // loaded in chrome://tracing. Each device is a process and each thread that
+  // ran ops is a thread.
+  string ToChromeTraceJson() const;
+
+ private:
+  const int capacity_;
+  mutable mutex mu_;
+  std::deque<StepStats> steps_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SampledTraces);
+};
+
+// Converts step stats to the Chrome trace event format.
+string StepStatsToChromeTraceJson(const std::vector<StepStats>& steps);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_TRACES_H_
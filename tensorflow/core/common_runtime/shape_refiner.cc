@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/shape_inference_cache.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
@@ -682,7 +683,8 @@ Status ShapeRefiner::RunShapeFn(const Node* node,
     }
 
     if (op_reg_data->shape_inference_fn) {
-      TF_RETURN_IF_ERROR(c->Run(op_reg_data->shape_inference_fn));
+      TF_RETURN_IF_ERROR(
+          shape_inference::ShapeInferenceCache::Global()->Run(*op_reg_data, c));
     } else {
       TF_RETURN_IF_ERROR(c->Run(shape_inference::UnknownShape));
     }
@@ -0,0 +1,582 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/tensor_slice_reader_cache.h"
+
+namespace tensorflow {
+namespace {
+
+typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
+typedef gtl::InlinedVector<DeviceContext*, 4> DeviceContextVec;
+typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
+
+// Relative cost of a kernel that reports itself as expensive, used to balance
+// chains across workers.
+constexpr int64 kExpensiveKernelCost = 16;
+
+// Returns an Unimplemented error if `graph` uses a feature that the static
+// schedule executor does not support. This is checked before any kernel is
+// created, so that callers can fall back to another executor cheaply.
+Status CheckGraphIsSupported(const Device* device, const Graph& graph) {
+  if (device->tensorflow_gpu_device_info() != nullptr) {
+    return errors::Unimplemented(
+        "Static schedule executor does not support devices that need a "
+        "device context, but got device ",
+        device->name());
+  }
+  for (const Node* n : graph.op_nodes()) {
+    for (DataType dt : n->output_types()) {
+      if (IsRefType(dt)) {
+        return errors::Unimplemented(
+            "Static schedule executor does not support reference-typed "
+            "edges. But saw type ",
+            DataTypeString(dt), " in outputs of node ", n->name());
+      }
+    }
+    if (n->IsControlFlow()) {
+      return errors::Unimplemented(
+          "Static schedule executor does not support control flow. But saw "
+          "control flow node ",
+          n->name());
+    }
+    if (n->IsSend() || n->IsHostSend() || n->IsRecv() || n->IsHostRecv()) {
+      return errors::Unimplemented(
+          "Static schedule executor does not support partitioned graphs. "
+          "But saw send/recv node ",
+          n->name());
+    }
+    if (n->IsCollective()) {
+      return errors::Unimplemented(
+          "Static schedule executor does not support collective ops. But saw "
+          "collective node ",
+          n->name());
+    }
+  }
+  return Status::OK();
+}
+
+class StaticScheduleExecutorImpl : public Executor {
+ public:
+  StaticScheduleExecutorImpl(const LocalExecutorParams& params,
+                             int num_threads)
+      : params_(params), num_threads_(std::max(num_threads, 1)) {}
+
+  ~StaticScheduleExecutorImpl() override {
+    for (const KernelState& kernel_state : kernels_) {
+      if (kernel_state.kernel != nullptr) {
+        params_.delete_kernel(kernel_state.kernel);
+      }
+    }
+  }
+
+  Status Initialize(const Graph& graph);
+
+  void RunAsync(const Args& args, DoneCallback done) override;
+
+ private:
+  class RunState;
+
+  // Represents cached graph structure state for each kernel.
+  struct KernelState {
+    // The kernel object. Not owned.
+    //
+    // This pointer is managed by `params_.create_kernel()` and
+    // `params_.delete_kernel()`.
+    OpKernel* kernel = nullptr;
+
+    // These fields determine the range of elements in the flat input vector
+    // that corresponds to the inputs of `kernel`.
+    size_t input_start_index = 0;
+    size_t num_inputs = 0;
+
+    size_t num_outputs = 0;
+
+    // For the `j`th output of `kernel`, `output_locations[j]` contains the
+    // locations in the flat input vector to which that output must be
+    // copied.
+    std::vector<std::vector<size_t>> output_locations;
+
+    // Memory space information for each output of `kernel`.
+    std::vector<AllocatorAttributes> output_alloc_attrs;
+
+    // The worker that runs this kernel, and the kernel's position in that
+    // worker's schedule.
+    int worker = 0;
+    size_t schedule_position = 0;
+
+    // The number of distinct predecessors (through data or control edges)
+    // that run on a different worker.
+    int num_remote_predecessors = 0;
+
+    // The kernels on other workers that have this kernel as a predecessor.
+    std::vector<size_t> remote_successors;
+  };
+
+  // Splits the kernels, which are in topological order, into chains and
+  // assigns the chains to workers. Fills in `worker_schedules_` and the
+  // scheduling fields of `kernels_`.
+  void AssignWorkers(const std::vector<std::vector<size_t>>& predecessors);
+
+  const LocalExecutorParams params_;
+  const int num_threads_;
+
+  // All following members are read-only after Initialize().
+
+  // The kernels of the graph, in topological order.
+  std::vector<KernelState> kernels_;
+
+  // For each worker, the indices into `kernels_` that it runs, in
+  // topological order.
+  std::vector<std::vector<size_t>> worker_schedules_;
+
+  // The sum of the number of inputs for each node in the graph.
+  size_t total_num_inputs_ = 0;
+
+  // Memory space information for each input, in the order of the flat input
+  // vector.
+  std::vector<AllocatorAttributes> input_alloc_attrs_;
+};
+
+Status StaticScheduleExecutorImpl::Initialize(const Graph& graph) {
+  TF_RETURN_IF_ERROR(CheckGraphIsSupported(params_.device, graph));
+
+  std::vector<Node*> ordered_nodes;
+  ordered_nodes.reserve(graph.num_nodes());
+  GetReversePostOrder(graph, &ordered_nodes);
+  if (ordered_nodes.size() != graph.num_nodes()) {
+    return errors::InvalidArgument("Graph had ", graph.num_nodes(),
+                                   " but reverse post-order had ",
+                                   ordered_nodes.size());
+  }
+  // The source and sink nodes carry no work, and would otherwise make every
+  // node depend on the same two kernels.
+  ordered_nodes.erase(
+      std::remove_if(ordered_nodes.begin(), ordered_nodes.end(),
+                     [](const Node* n) { return !n->IsOp(); }),
+      ordered_nodes.end());
+
+  std::vector<int> node_to_index(graph.num_node_ids(), -1);
+  kernels_.resize(ordered_nodes.size());
+  size_t input_start_index = 0;
+  for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+    const Node* n = ordered_nodes[i];
+    node_to_index[n->id()] = i;
+    KernelState& kernel_state = kernels_[i];
+    TF_RETURN_IF_ERROR(params_.create_kernel(n->def(), &kernel_state.kernel));
+    kernel_state.num_inputs = n->num_inputs();
+    kernel_state.num_outputs = n->num_outputs();
+    kernel_state.input_start_index = input_start_index;
+    input_start_index += kernel_state.num_inputs;
+  }
+  total_num_inputs_ = input_start_index;
+
+  // Build the mapping from each node output to the input slot of the
+  // corresponding destination node, and the predecessor lists used to build
+  // the schedule.
+  std::vector<std::vector<size_t>> predecessors(kernels_.size());
+  for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+    const Node* n = ordered_nodes[i];
+    KernelState& kernel_state = kernels_[i];
+    kernel_state.output_locations.resize(kernel_state.num_outputs);
+    for (const Edge* e : n->out_edges()) {
+      const int dst = node_to_index[e->dst()->id()];
+      if (dst < 0) continue;
+      predecessors[dst].push_back(i);
+      if (!e->IsControlEdge()) {
+        kernel_state.output_locations[e->src_output()].push_back(
+            kernels_[dst].input_start_index + e->dst_input());
+      }
+    }
+
+    // Compute allocator attributes for each node output.
+    kernel_state.output_alloc_attrs.resize(kernel_state.num_outputs);
+    const OpKernel* op_kernel = kernel_state.kernel;
+    for (int out = 0; out < n->num_outputs(); out++) {
+      DCHECK_LT(out, op_kernel->output_memory_types().size());
+      if (op_kernel->output_memory_types()[out] == HOST_MEMORY) {
+        AllocatorAttributes h;
+        h.set_on_host(true);
+        kernel_state.output_alloc_attrs[out].Merge(h);
+      }
+    }
+  }
+  for (auto& preds : predecessors) {
+    std::sort(preds.begin(), preds.end());
+    preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+  }
+
+  input_alloc_attrs_.resize(total_num_inputs_);
+  for (const KernelState& kernel_state : kernels_) {
+    for (size_t j = 0; j < kernel_state.output_locations.size(); ++j) {
+      for (size_t output_location : kernel_state.output_locations[j]) {
+        input_alloc_attrs_[output_location] =
+            kernel_state.output_alloc_attrs[j];
+      }
+    }
+  }
+
+  AssignWorkers(predecessors);
+  return Status::OK();
+}
+
+void StaticScheduleExecutorImpl::AssignWorkers(
+    const std::vector<std::vector<size_t>>& predecessors) {
+  // Greedily cover the graph with chains: a kernel extends the chain of one
+  // of its predecessors if that predecessor is still the chain's tail, and
+  // starts a new chain otherwise. Kernels are visited in topological order,
+  // so every chain is itself in topological order.
+  std::vector<int> chain_of(kernels_.size(), -1);
+  std::vector<size_t> chain_tail;
+  std::vector<int64> chain_cost;
+  for (size_t i = 0; i < kernels_.size(); ++i) {
+    int chain = -1;
+    for (size_t pred : predecessors[i]) {
+      if (chain_tail[chain_of[pred]] == pred) {
+        chain = chain_of[pred];
+        break;
+      }
+    }
+    if (chain < 0) {
+      chain = chain_tail.size();
+      chain_tail.push_back(i);
+      chain_cost.push_back(0);
+    }
+    chain_of[i] = chain;
+    chain_tail[chain] = i;
+    chain_cost[chain] +=
+        kernels_[i].kernel->IsExpensive() ? kExpensiveKernelCost : 1;
+  }
+
+  // Assign the chains to workers, longest chain first, each to the least
+  // loaded worker.
+  const int num_chains = chain_tail.size();
+  const int num_workers = std::max(std::min(num_threads_, num_chains), 1);
+  std::vector<int> chains_by_cost(num_chains);
+  for (int c = 0; c < num_chains; ++c) chains_by_cost[c] = c;
+  std::stable_sort(chains_by_cost.begin(), chains_by_cost.end(),
+                   [&chain_cost](int a, int b) {
+                     return chain_cost[a] > chain_cost[b];
+                   });
+  std::vector<int> worker_of_chain(num_chains, 0);
+  std::vector<int64> worker_cost(num_workers, 0);
+  for (int c : chains_by_cost) {
+    const int worker =
+        std::min_element(worker_cost.begin(), worker_cost.end()) -
+        worker_cost.begin();
+    worker_of_chain[c] = worker;
+    worker_cost[worker] += chain_cost[c];
+  }
+
+  worker_schedules_.assign(num_workers, {});
+  for (size_t i = 0; i < kernels_.size(); ++i) {
+    KernelState& kernel_state = kernels_[i];
+    kernel_state.worker = worker_of_chain[chain_of[i]];
+    std::vector<size_t>& schedule = worker_schedules_[kernel_state.worker];
+    kernel_state.schedule_position = schedule.size();
+    schedule.push_back(i);
+  }
+  for (size_t i = 0; i < kernels_.size(); ++i) {
+    for (size_t pred : predecessors[i]) {
+      if (kernels_[pred].worker != kernels_[i].worker) {
+        ++kernels_[i].num_remote_predecessors;
+        kernels_[pred].remote_successors.push_back(i);
+      }
+    }
+  }
+  VLOG(1) << "Static schedule executor assigned " << kernels_.size()
+          << " kernels in " << num_chains << " chains to " << num_workers
+          << " workers";
+}
+
+// The state associated with one invocation of the executor.
+class StaticScheduleExecutorImpl::RunState {
+ public:
+  RunState(const StaticScheduleExecutorImpl* impl, const Args& args,
+           DoneCallback done)
+      : impl_(impl),
+        args_(args),
+        done_(std::move(done)),
+        inputs_(new Tensor[impl->total_num_inputs_]),
+        pending_(new std::atomic<int>[impl->kernels_.size()]),
+        num_running_workers_(impl->worker_schedules_.size()) {
+    for (size_t i = 0; i < impl_->kernels_.size(); ++i) {
+      // A kernel with remote predecessors waits for each of them, and for
+      // its own worker to reach it.
+      const int n = impl_->kernels_[i].num_remote_predecessors;
+      pending_[i].store(n > 0 ? n + 1 : 0, std::memory_order_relaxed);
+    }
+  }
+
+  void Start() {
+    const int num_workers = impl_->worker_schedules_.size();
+    for (int w = 1; w < num_workers; ++w) {
+      args_.runner([this, w]() { RunWorker(w, 0); });
+    }
+    RunWorker(0, 0);
+  }
+
+ private:
+  // Runs the schedule of `worker` starting at `position`, until the end of
+  // the schedule or until it reaches a kernel whose remote predecessors have
+  // not all completed. `resumed` is true if the kernel at `position` was
+  // already released by its last remote predecessor.
+  void RunWorker(int worker, size_t position, bool resumed = false);
+
+  // Releases the remote successors of `kernel_state`, resuming the worker of
+  // any successor whose last predecessor this was.
+  void ReleaseRemoteSuccessors(const KernelState& kernel_state);
+
+  void Finish();
+
+  const StaticScheduleExecutorImpl* const impl_;
+  const Args args_;
+  DoneCallback done_;
+
+  // The inputs of every kernel, laid out contiguously as described by
+  // `KernelState::input_start_index`.
+  std::unique_ptr<Tensor[]> inputs_;
+
+  // For kernels with remote predecessors, the number of events that must
+  // still happen before the kernel can run.
+  std::unique_ptr<std::atomic<int>[]> pending_;
+
+  std::atomic<int> num_running_workers_;
+
+  // Set once any kernel fails. The remaining kernels are then skipped, but the
+  // workers still walk their schedules so that every worker finishes.
+  std::atomic<bool> aborted_{false};
+
+  checkpoint::TensorSliceReaderCacheWrapper slice_reader_cache_;
+
+  mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+};
+
+void StaticScheduleExecutorImpl::RunState::RunWorker(int worker,
+                                                     size_t position,
+                                                     bool resumed) {
+  const std::vector<size_t>& schedule = impl_->worker_schedules_[worker];
+
+  TensorValueVec node_inputs;
+  DeviceContextVec input_device_contexts;
+  AllocatorAttributeVec input_alloc_attrs;
+
+  // Prepare the parameters that will be the same for all kernels.
+  OpKernelContext::Params params;
+  params.step_id = args_.step_id;
+  Device* device = impl_->params_.device;
+  params.device = device;
+  params.log_memory = false;
+  params.record_tensor_accesses = false;
+  params.rendezvous = args_.rendezvous;
+  params.create_rendezvous = &impl_->params_.rendezvous_factory;
+  params.session_state = args_.session_state;
+  params.session_handle = args_.session_handle;
+  params.session_metadata = impl_->params_.session_metadata;
+  params.tensor_store = args_.tensor_store;
+  params.cancellation_manager = args_.cancellation_manager;
+  params.call_frame = args_.call_frame;
+  params.function_library = impl_->params_.function_library;
+  params.resource_manager = device->resource_manager();
+  params.step_container = args_.step_container;
+  params.slice_reader_cache = &slice_reader_cache_;
+  params.inputs = &node_inputs;
+  params.input_device_contexts = &input_device_contexts;
+  params.input_alloc_attrs = &input_alloc_attrs;
+  Args::Runner runner_copy = args_.runner;
+  params.runner = &runner_copy;
+  // The graph has no control flow, so every kernel runs in the root frame.
+  params.frame_iter = FrameAndIter(0, 0);
+  params.is_input_dead = false;
+  params.op_device_context = nullptr;
+  params.forward_from_array = nullptr;
+
+  for (; position < schedule.size(); ++position) {
+    const size_t index = schedule[position];
+    const KernelState& kernel_state = impl_->kernels_[index];
+    if (resumed) {
+      resumed = false;
+    } else if (kernel_state.num_remote_predecessors > 0 &&
+               pending_[index].fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      // The worker that completes the last remote predecessor resumes this
+      // schedule at `position`.
+      return;
+    }
+
+    const size_t input_start_index = kernel_state.input_start_index;
+    const size_t num_inputs = kernel_state.num_inputs;
+    const size_t num_outputs = kernel_state.num_outputs;
+
+    if (!aborted_.load(std::memory_order_relaxed)) {
+      node_inputs.clear();
+      node_inputs.resize(num_inputs);
+      input_alloc_attrs.clear();
+      input_alloc_attrs.resize(num_inputs);
+      for (size_t j = 0; j < num_inputs; ++j) {
+        node_inputs[j].tensor = &inputs_[input_start_index + j];
+        input_alloc_attrs[j] = impl_->input_alloc_attrs_[input_start_index + j];
+      }
+      input_device_contexts.clear();
+      input_device_contexts.resize(num_inputs);
+      params.op_kernel = kernel_state.kernel;
+      params.output_attr_array = kernel_state.output_alloc_attrs.data();
+      OpKernelContext ctx(&params, num_outputs);
+
+      device->Compute(kernel_state.kernel, &ctx);
+
+      Status s = ctx.status();
+      if (s.ok()) {
+        // Forward the outputs of the kernel to the inputs of subsequent
+        // kernels.
+        for (size_t j = 0; j < num_outputs; ++j) {
+          TensorValue val = ctx.release_output(j);
+          const std::vector<size_t>& locations =
+              kernel_state.output_locations[j];
+          if (val.tensor == nullptr) {
+            if (!locations.empty()) {
+              s = errors::Internal("Missing output ", j, " of node ",
+                                   kernel_state.kernel->name());
+            }
+            continue;
+          }
+          for (size_t output_location : locations) {
+            inputs_[output_location] = *val.tensor;
+          }
+          delete val.tensor;
+        }
+      }
+      if (!s.ok()) {
+        mutex_lock l(mu_);
+        if (status_.ok()) status_ = s;
+        aborted_.store(true, std::memory_order_relaxed);
+      }
+    }
+
+    // Free the inputs to the current kernel.
+    for (size_t j = 0; j < num_inputs; ++j) {
+      inputs_[input_start_index + j] = Tensor();
+    }
+
+    ReleaseRemoteSuccessors(kernel_state);
+  }
+
+  if (num_running_workers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    Finish();
+  }
+}
+
+void StaticScheduleExecutorImpl::RunState::ReleaseRemoteSuccessors(
+    const KernelState& kernel_state) {
+  for (size_t successor : kernel_state.remote_successors) {
+    if (pending_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // The successor's own worker has already reached it and returned, so
+      // resume that worker's schedule at the successor.
+      const KernelState& successor_state = impl_->kernels_[successor];
+      const int worker = successor_state.worker;
+      const size_t position = successor_state.schedule_position;
+      args_.runner([this, worker, position]() {
+        RunWorker(worker, position, /*resumed=*/true);
+      });
+    }
+  }
+}
+
+void StaticScheduleExecutorImpl::RunState::Finish() {
+  Status status;
+  {
+    mutex_lock l(mu_);
+    status = status_;
+  }
+  DoneCallback done = std::move(done_);
+  delete this;
+  done(status);
+}
+
+void StaticScheduleExecutorImpl::RunAsync(const Args& args,
+                                          DoneCallback done) {
+  if (kernels_.empty()) {
+    done(Status::OK());
+    return;
+  }
+  (new RunState(this, args, std::move(done)))->Start();
+}
+
+class StaticScheduleExecutorRegistrar {
+ public:
+  StaticScheduleExecutorRegistrar() {
+    ExecutorFactory::Register("STATIC_SCHEDULE", new Factory());
+  }
+
+ private:
+  // Graphs that the static schedule executor does not support are run by
+  // the default executor, so that a session can select "STATIC_SCHEDULE"
+  // for all of its graphs. The number of workers per step is read from the
+  // TF_STATIC_SCHEDULE_EXECUTOR_NUM_THREADS environment variable and
+  // defaults to 1, which runs each step as a flat loop on the caller thread.
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      int64 num_threads;
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar(
+          "TF_STATIC_SCHEDULE_EXECUTOR_NUM_THREADS", 1, &num_threads));
+      Status s = CheckGraphIsSupported(params.device, *graph);
+      if (errors::IsUnimplemented(s)) {
+        VLOG(1) << "Falling back to the default executor: " << s;
+        return tensorflow::NewExecutor("", params, std::move(graph),
+                                       out_executor);
+      }
+      TF_RETURN_IF_ERROR(s);
+      Executor* ret;
+      TF_RETURN_IF_ERROR(NewStaticScheduleExecutor(params, num_threads,
+                                                   std::move(graph), &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
+};
+static StaticScheduleExecutorRegistrar registrar;
+
+}  // namespace
+
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 int num_threads,
+                                 std::unique_ptr<const Graph> graph,
+                                 Executor** executor) {
+  std::unique_ptr<StaticScheduleExecutorImpl> impl =
+      absl::make_unique<StaticScheduleExecutorImpl>(params, num_threads);
+  TF_RETURN_IF_ERROR(impl->Initialize(*graph));
+  *executor = impl.release();
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,59 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+
+#include "tensorflow/core/common_runtime/executor.h"
+
+namespace tensorflow {
+
+// Creates a new `Executor` that runs `graph` according to a schedule that is
+// computed once, when the executor is created.
+//
+// At creation time the graph is topologically sorted, the input slot of every
+// edge is resolved into a flat table, and the nodes are split into chains
+// that are assigned to at most `num_threads` workers. Each `Run` then walks
+// each worker's fixed list of kernels in order; the only per-step bookkeeping
+// is an atomic count for the nodes that wait on a node of another worker. A
+// worker that reaches such a node before its inputs are ready returns, and is
+// resumed on the runner by the worker that produces the last input. With
+// `num_threads == 1` the whole graph runs as one flat loop on the caller
+// thread.
+//
+// The executor is intended for small, fixed inference graphs, where the
+// dynamic bookkeeping of the default executor (pending counts, frames and
+// iterations) dominates the cost of the kernels. It has the same limitations
+// as the single-threaded executor in `kernels/data`:
+//
+// 1. Reference-typed tensors are not supported.
+// 2. Graphs with control flow (containing "Switch" and "Merge" nodes) are not
+//    supported.
+// 3. Partitioned graphs (containing "_Send" and "_Recv" nodes) and collective
+//    ops are not supported.
+// 4. Only devices that do not need a device context (e.g. CPU) are
+//    supported.
+// 5. Step statistics, memory logging and allocation forwarding are not
+//    supported.
+//
+// If `graph` uses any of these features, returns an `Unimplemented` error.
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 int num_threads,
+                                 std::unique_ptr<const Graph> graph,
+                                 Executor** executor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
@@ -0,0 +1,227 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// The parameter is the number of worker threads of the executor.
+class StaticScheduleExecutorTest : public ::testing::TestWithParam<int> {
+ protected:
+  StaticScheduleExecutorTest()
+      : device_(DeviceFactory::NewDevice("CPU", {},
+                                         "/job:localhost/replica:0/task:0")) {
+    SessionOptions options;
+    thread_pool_ = ComputePool(options);
+  }
+
+  ~StaticScheduleExecutorTest() override { delete exec_; }
+
+  // Resets executor_ with a new executor based on a graph 'gdef'.
+  Status Create(std::unique_ptr<const Graph> graph) {
+    const int version = graph->versions().producer();
+    LocalExecutorParams params;
+    params.device = device_.get();
+    params.create_kernel = [this, version](const NodeDef& ndef,
+                                           OpKernel** kernel) {
+      return CreateNonCachedKernel(device_.get(), nullptr, ndef, version,
+                                   kernel);
+    };
+    params.delete_kernel = [](OpKernel* kernel) {
+      DeleteNonCachedKernel(kernel);
+    };
+    delete exec_;
+    exec_ = nullptr;
+    runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
+    return NewStaticScheduleExecutor(params, GetParam(), std::move(graph),
+                                     &exec_);
+  }
+
+  Status Run(CallFrameInterface* call_frame) {
+    Executor::Args args;
+    args.call_frame = call_frame;
+    args.runner = runner_;
+    return exec_->Run(args);
+  }
+
+  thread::ThreadPool* thread_pool_ = nullptr;
+  std::unique_ptr<Device> device_;
+  Executor* exec_ = nullptr;
+  Executor::Args::Runner runner_;
+};
+
+// A float val -> Tensor<float>
+Tensor V(const float val) {
+  Tensor tensor(DT_FLOAT, TensorShape({}));
+  tensor.scalar<float>()() = val;
+  return tensor;
+}
+
+// Tensor<float> -> a float val.
+float V(const Tensor& tensor) {
+  CHECK_EQ(tensor.dtype(), DT_FLOAT);
+  CHECK(TensorShapeUtils::IsScalar(tensor.shape()));
+  return tensor.scalar<float>()();
+}
+
+TEST_P(StaticScheduleExecutorTest, SimpleAdd) {
+  // c = a + b
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto in1 = test::graph::Arg(g.get(), 1, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Retval(g.get(), 0, tmp);
+  FixupSourceAndSinkEdges(g.get());
+  TF_ASSERT_OK(Create(std::move(g)));
+  FunctionCallFrame call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0), V(2.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(3.0, V(retvals[0]));
+}
+
+// Builds a graph which adds N copies of one variable "in", parenthesized
+// randomly, so that it has many independent chains.
+void BuildTree(int N, Graph* g) {
+  CHECK_GT(N, 1);
+  auto in = test::graph::Arg(g, 0, DT_FLOAT);
+  std::vector<Node*> nodes;
+  for (int i = 0; i < N; ++i) {
+    nodes.push_back(test::graph::Identity(g, in, 0));
+  }
+  random::PhiloxRandom philox(0, 17);
+  random::SimplePhilox rnd(&philox);
+  while (nodes.size() > 1) {
+    int x = rnd.Uniform(nodes.size());
+    auto in0 = nodes[x];
+    nodes[x] = nodes.back();
+    nodes.resize(nodes.size() - 1);
+    x = rnd.Uniform(nodes.size());
+    auto in1 = nodes[x];
+    nodes[x] = test::graph::Add(g, in0, in1);
+  }
+  test::graph::Retval(g, 0, nodes.back());
+  FixupSourceAndSinkEdges(g);
+}
+
+TEST_P(StaticScheduleExecutorTest, RandomTree) {
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  TF_ASSERT_OK(Create(std::move(g)));
+  // Run several steps to make sure no per-step state leaks into the next.
+  for (int i = 0; i < 4; ++i) {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(4096.0, V(retvals[0]));
+  }
+}
+
+TEST_P(StaticScheduleExecutorTest, OpError) {
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto zero = test::graph::Constant(g.get(), V(0.0));
+  auto inf = test::graph::Unary(g.get(), "Reciprocal", zero);
+  auto check = test::graph::CheckNumerics(g.get(), inf, "message");
+  auto two = test::graph::Constant(g.get(), V(2.0));
+  test::graph::Binary(g.get(), "Mul", check, two);
+  FixupSourceAndSinkEdges(g.get());
+  TF_ASSERT_OK(Create(std::move(g)));
+  FunctionCallFrame call_frame({}, {});
+  EXPECT_TRUE(errors::IsInvalidArgument(Run(&call_frame)));
+}
+
+TEST_P(StaticScheduleExecutorTest, ControlFlowIsUnimplemented) {
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Constant(g.get(), test::AsScalar<bool>(true));
+  test::graph::Switch(g.get(), in, pred);
+  FixupSourceAndSinkEdges(g.get());
+  EXPECT_TRUE(errors::IsUnimplemented(Create(std::move(g))));
+}
+
+INSTANTIATE_TEST_CASE_P(NumThreads, StaticScheduleExecutorTest,
+                        ::testing::Values(1, 2, 8));
+
+static void BM_executor(int iters, int width, int depth) {
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  random::PhiloxRandom philox(1729, 17);
+  random::SimplePhilox rand(&philox);
+  uint64 cur = 0;
+  uint32 r = 1 + rand.Rand32() % width;
+  std::vector<Node*> ready_nodes;
+  for (int i = 0; i < r; ++i) {
+    ready_nodes.push_back(test::graph::NoOp(g, {}));
+    ++cur;
+  }
+  for (int i = 0; i < depth; ++i) {
+    std::random_shuffle(ready_nodes.begin(), ready_nodes.end());
+    r = 1 + rand.Rand32() % (ready_nodes.size());
+    std::vector<Node*> control_inputs;
+    for (int j = 0; j < r; ++j) {
+      control_inputs.push_back(ready_nodes.back());
+      ready_nodes.pop_back();
+    }
+    Node* n = test::graph::NoOp(g, control_inputs);
+    ++cur;
+    r = 1 + rand.Rand32() % width;
+    for (int j = 0; j < r; ++j) {
+      ready_nodes.push_back(test::graph::NoOp(g, {n}));
+      ++cur;
+    }
+  }
+  FixupSourceAndSinkEdges(g);
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkLabel(strings::StrCat("Nodes = ", cur));
+  SetBenchmarkItemsProcessed(cur * static_cast<int64>(iters));
+#endif  // PLATFORM_GOOGLE
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, "STATIC_SCHEDULE")
+      .Run(iters);
+}
+
+// Tall skinny graphs
+BENCHMARK(BM_executor)->ArgPair(16, 1024);
+BENCHMARK(BM_executor)->ArgPair(32, 8192);
+
+// Short fat graphs
+BENCHMARK(BM_executor)->ArgPair(1024, 16);
+BENCHMARK(BM_executor)->ArgPair(8192, 32);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,154 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base,
+                                       size_t initial_block_size)
+    : base_(base),
+      max_arena_allocation_(initial_block_size / 4),
+      next_block_size_(initial_block_size) {
+  CHECK_GT(initial_block_size, 0);
+}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  DCHECK(forwarded_.empty());
+  for (const auto& block : blocks_) {
+    base_->DeallocateRaw(block.second.start);
+  }
+}
+
+bool StepArenaAllocator::AddBlock(size_t min_bytes) {
+  Block* block = nullptr;
+  for (auto it = free_blocks_.begin(); it != free_blocks_.end(); ++it) {
+    if ((*it)->size >= min_bytes) {
+      block = *it;
+      free_blocks_.erase(it);
+      break;
+    }
+  }
+  if (block == nullptr) {
+    const size_t block_size = std::max(next_block_size_, min_bytes);
+    void* start =
+        base_->AllocateRaw(Allocator::kAllocatorAlignment, block_size);
+    if (start == nullptr) {
+      return false;
+    }
+    block = &blocks_[static_cast<const char*>(start)];
+    block->start = static_cast<char*>(start);
+    block->size = block_size;
+    // Grow geometrically so that a step that outgrows its estimate needs
+    // only a few more blocks.
+    next_block_size_ = block_size * 2;
+  }
+  if (cur_block_ != nullptr && cur_block_->num_live == 0) {
+    free_blocks_.push_back(cur_block_);
+  }
+  cur_block_ = block;
+  cur_ = block->start;
+  end_ = block->start + block->size;
+  return true;
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  alignment = std::max<size_t>(alignment, Allocator::kAllocatorAlignment);
+  if (num_bytes > max_arena_allocation_) {
+    void* ptr = base_->AllocateRaw(alignment, num_bytes);
+    if (ptr != nullptr) {
+      mutex_lock l(mu_);
+      forwarded_.insert(ptr);
+      num_live_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ptr;
+  }
+
+  mutex_lock l(mu_);
+  uintptr_t cur = reinterpret_cast<uintptr_t>(cur_);
+  uintptr_t aligned = (cur + alignment - 1) & ~(alignment - 1);
+  if (cur_ == nullptr ||
+      aligned + num_bytes > reinterpret_cast<uintptr_t>(end_)) {
+    // Blocks are aligned to kAllocatorAlignment; over-allocate for stricter
+    // alignment requests.
+    if (!AddBlock(num_bytes + alignment)) {
+      return nullptr;
+    }
+    cur = reinterpret_cast<uintptr_t>(cur_);
+    aligned = (cur + alignment - 1) & ~(alignment - 1);
+  }
+  char* ptr = reinterpret_cast<char*>(aligned);
+  const size_t bytes = (ptr + num_bytes) - cur_;
+  cur_ = ptr + num_bytes;
+  cur_block_->used += bytes;
+  ++cur_block_->num_live;
+  bytes_in_use_ += bytes;
+  peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+  num_live_.fetch_add(1, std::memory_order_relaxed);
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  bool forwarded = false;
+  {
+    mutex_lock l(mu_);
+    forwarded = !forwarded_.empty() && forwarded_.erase(ptr) > 0;
+    if (!forwarded) {
+      // The block of `ptr` is the last one that starts at or before it.
+      auto it = blocks_.upper_bound(static_cast<const char*>(ptr));
+      DCHECK(it != blocks_.begin());
+      --it;
+      Block* block = &it->second;
+      if (--block->num_live == 0) {
+        bytes_in_use_ -= block->used;
+        block->used = 0;
+        if (block == cur_block_) {
+          cur_ = block->start;
+        } else {
+          free_blocks_.push_back(block);
+        }
+      }
+    }
+  }
+  if (forwarded) {
+    base_->DeallocateRaw(ptr);
+  }
+  DecrementLive();
+}
+
+size_t StepArenaAllocator::bytes_used() const {
+  mutex_lock l(mu_);
+  return peak_bytes_in_use_;
+}
+
+int StepArenaAllocator::num_blocks() const {
+  mutex_lock l(mu_);
+  return blocks_.size();
+}
+
+void StepArenaAllocator::Release() { DecrementLive(); }
+
+void StepArenaAllocator::DecrementLive() {
+  if (num_live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,108 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for the temporary buffers of a single step.
+//
+// Allocations are carved out of large blocks obtained from `base` by bumping
+// a pointer. Each block counts its live buffers: once they are all
+// deallocated, the block is reused from its start, so that a step that
+// repeatedly allocates and frees temporaries (e.g. in a while loop) does not
+// grow without bound, and a buffer that is kept alive only pins its own
+// block. The blocks are given back to `base` all at once. Allocations larger
+// than a quarter of the initial block size are forwarded to `base`.
+//
+// The owner of the arena calls Release() at the end of the step and must not
+// allocate from it afterwards. Since a temporary buffer may still be
+// referenced after the step (e.g. when a kernel returns it as an output), the
+// arena deletes itself, and returns its blocks, only once it has been
+// released and all of its buffers have been deallocated.
+class StepArenaAllocator : public Allocator {
+ public:
+  StepArenaAllocator(Allocator* base, size_t initial_block_size);
+
+  string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Peak number of bytes in use in the blocks of this arena, including
+  // alignment padding. Useful to size the arena of the next step.
+  size_t bytes_used() const;
+
+  // Number of blocks obtained from the base allocator.
+  int num_blocks() const;
+
+  // Ends the step. May delete this object.
+  void Release();
+
+ private:
+  ~StepArenaAllocator() override;
+
+  struct Block {
+    char* start;
+    size_t size;
+    // Bytes handed out since the block was last (re)started.
+    size_t used = 0;
+    // Buffers of the block that have not been deallocated.
+    int64 num_live = 0;
+  };
+
+  // Makes a block of at least `min_bytes` current, reusing a free block if
+  // one is large enough.
+  bool AddBlock(size_t min_bytes) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void DecrementLive();
+
+  Allocator* const base_;
+  const size_t max_arena_allocation_;
+
+  mutable mutex mu_;
+  // All blocks, keyed by their start address.
+  std::map<const char*, Block> blocks_ GUARDED_BY(mu_);
+  // Blocks without live buffers, other than the current one.
+  std::vector<Block*> free_blocks_ GUARDED_BY(mu_);
+  Block* cur_block_ GUARDED_BY(mu_) = nullptr;
+  char* cur_ GUARDED_BY(mu_) = nullptr;
+  char* end_ GUARDED_BY(mu_) = nullptr;
+  size_t next_block_size_ GUARDED_BY(mu_);
+  size_t bytes_in_use_ GUARDED_BY(mu_) = 0;
+  size_t peak_bytes_in_use_ GUARDED_BY(mu_) = 0;
+  std::unordered_set<void*> forwarded_ GUARDED_BY(mu_);
+
+  // Live buffers, including forwarded ones, plus one until Release() is
+  // called.
+  std::atomic<int64> num_live_{1};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
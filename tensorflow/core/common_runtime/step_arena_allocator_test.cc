@@ -0,0 +1,122 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(StepArenaAllocatorTest, BumpsWithinBlock) {
+  StepArenaAllocator* arena = new StepArenaAllocator(cpu_allocator(), 4096);
+  char* p0 = static_cast<char*>(arena->AllocateRaw(64, 100));
+  char* p1 = static_cast<char*>(arena->AllocateRaw(64, 100));
+  ASSERT_NE(nullptr, p0);
+  ASSERT_NE(nullptr, p1);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p0) % 64);
+  EXPECT_EQ(128, p1 - p0);
+  EXPECT_EQ(228, arena->bytes_used());
+  arena->DeallocateRaw(p0);
+  arena->DeallocateRaw(p1);
+  arena->Release();
+}
+
+TEST(StepArenaAllocatorTest, GrowsBeyondFirstBlock) {
+  StepArenaAllocator* arena = new StepArenaAllocator(cpu_allocator(), 4096);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 100; ++i) {
+    void* p = arena->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+    ASSERT_NE(nullptr, p);
+    memset(p, i, 1000);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) {
+    arena->DeallocateRaw(p);
+  }
+  arena->Release();
+}
+
+TEST(StepArenaAllocatorTest, ReusesBlockOnceAllBuffersAreFreed) {
+  StepArenaAllocator* arena = new StepArenaAllocator(cpu_allocator(), 4096);
+  void* first = arena->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  arena->DeallocateRaw(first);
+  // Like the temporaries of a while loop body, each buffer is freed before
+  // the next one is allocated.
+  for (int i = 0; i < 1000; ++i) {
+    void* p = arena->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+    ASSERT_EQ(first, p);
+    arena->DeallocateRaw(p);
+  }
+  EXPECT_EQ(1, arena->num_blocks());
+  EXPECT_EQ(1000, arena->bytes_used());
+  arena->Release();
+}
+
+TEST(StepArenaAllocatorTest, LiveBufferPinsOnlyItsBlock) {
+  StepArenaAllocator* arena = new StepArenaAllocator(cpu_allocator(), 4096);
+  void* retained = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  for (int i = 0; i < 100; ++i) {
+    std::vector<void*> ptrs;
+    for (int j = 0; j < 8; ++j) {
+      void* p = arena->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+      ASSERT_NE(nullptr, p);
+      memset(p, j, 1000);
+      ptrs.push_back(p);
+    }
+    for (void* p : ptrs) {
+      arena->DeallocateRaw(p);
+    }
+  }
+  // The block holding `retained` cannot be reused, but the blocks of the
+  // freed buffers are.
+  EXPECT_LE(arena->num_blocks(), 3);
+  arena->DeallocateRaw(retained);
+  arena->Release();
+}
+
+TEST(StepArenaAllocatorTest, ForwardsLargeAllocations) {
+  StepArenaAllocator* arena = new StepArenaAllocator(cpu_allocator(), 4096);
+  void* small = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  void* large = arena->AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  ASSERT_NE(nullptr, large);
+  // Only the small allocation came from the arena's blocks.
+  EXPECT_EQ(100, arena->bytes_used());
+  arena->DeallocateRaw(large);
+  arena->DeallocateRaw(small);
+  arena->Release();
+}
+
+TEST(StepArenaAllocatorTest, BuffersOutliveRelease) {
+  StepArenaAllocator* arena = new StepArenaAllocator(cpu_allocator(), 4096);
+  Tensor small(arena, DT_FLOAT, TensorShape({4}));
+  Tensor large(arena, DT_FLOAT, TensorShape({1024}));
+  small.flat<float>().setConstant(1.0);
+  large.flat<float>().setConstant(2.0);
+  arena->Release();
+  // The arena is deleted when the last tensor goes away.
+  test::ExpectTensorEqual<float>(small,
+                                 test::AsTensor<float>({1.0, 1.0, 1.0, 1.0}));
+  EXPECT_EQ(2.0, large.flat<float>()(1023));
+}
+
+}  // namespace
+}  // namespace tensorflow
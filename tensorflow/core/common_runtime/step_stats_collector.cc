@@ -179,6 +179,8 @@ void NodeExecStatsWrapper::AddAllocation(
   absl::optional<AllocatorStats> stats = allocator->GetStats();
   if (stats) {
     memory->set_allocator_bytes_in_use(stats->bytes_in_use);
+    memory->set_allocator_bytes_free(stats->bytes_free);
+    memory->set_allocator_largest_free_block(stats->largest_free_block_size);
   }
   allocations_.push_back(std::make_pair(memory, tracking_allocator));
 }
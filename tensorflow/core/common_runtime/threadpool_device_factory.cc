@@ -37,16 +37,25 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
 
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
+    const bool use_numa_affinity =
+        options.config.experimental().use_numa_affinity();
     int num_numa_nodes = port::NUMANumNodes();
-    int n = 1;
+    // With NUMA affinity and no explicit CPU device count, create one device
+    // per NUMA node so that each node's cores and memory are used locally.
+    int n = use_numa_affinity ? num_numa_nodes : 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
     }
+    if (use_numa_affinity) {
+      // Without this, ProcessState hands out the node-0 allocator for every
+      // numa_node.
+      ProcessState::singleton()->EnableNUMA();
+    }
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
       std::unique_ptr<ThreadPoolDevice> tpd;
-      if (options.config.experimental().use_numa_affinity()) {
+      if (use_numa_affinity) {
         int numa_node = i % num_numa_nodes;
         if (numa_node != i) {
           LOG(INFO) << "Only " << num_numa_nodes
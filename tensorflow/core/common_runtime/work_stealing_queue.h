@@ -0,0 +1,239 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A fixed set of double-ended queues, one per worker. A worker pushes and
+// pops at the back of its own queue (LIFO, which keeps a node's successors
+// hot in the worker's cache), while an idle worker steals from the front of
+// the other queues (FIFO, which takes the oldest and typically largest
+// pieces of outstanding work).
+//
+// Every queue is guarded by its own mutex, so in the common case a worker
+// only ever touches an uncontended lock.
+template <typename T>
+class WorkStealingQueueSet {
+ public:
+  explicit WorkStealingQueueSet(int num_queues) : queues_(num_queues) {
+    CHECK_GT(num_queues, 0);
+  }
+
+  int num_queues() const { return queues_.size(); }
+
+  // Approximate number of items over all queues.
+  int64 size() const { return size_.load(std::memory_order_acquire); }
+
+  // Appends `item` to the back of queue `queue`.
+  void Push(int queue, T item) {
+    DCHECK_GE(queue, 0);
+    DCHECK_LT(queue, queues_.size());
+    Queue& q = queues_[queue];
+    {
+      mutex_lock l(q.mu);
+      q.items.push_back(std::move(item));
+    }
+    size_.fetch_add(1, std::memory_order_release);
+  }
+
+  // Pops the most recently pushed item of queue `queue` into `*item`. If
+  // that queue is empty, steals the oldest item of another queue and sets
+  // `*stolen` to true. Returns false if all queues are empty.
+  bool Pop(int queue, T* item, bool* stolen) {
+    DCHECK_GE(queue, 0);
+    DCHECK_LT(queue, queues_.size());
+    *stolen = false;
+    if (size() == 0) return false;
+    {
+      Queue& q = queues_[queue];
+      mutex_lock l(q.mu);
+      if (!q.items.empty()) {
+        *item = std::move(q.items.back());
+        q.items.pop_back();
+        size_.fetch_sub(1, std::memory_order_release);
+        return true;
+      }
+    }
+    const int n = queues_.size();
+    for (int i = 1; i < n; ++i) {
+      Queue& victim = queues_[(queue + i) % n];
+      mutex_lock l(victim.mu);
+      if (!victim.items.empty()) {
+        *item = std::move(victim.items.front());
+        victim.items.pop_front();
+        size_.fetch_sub(1, std::memory_order_release);
+        *stolen = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  struct Queue {
+    mutex mu;
+    std::deque<T> items GUARDED_BY(mu);
+  };
+
+  std::vector<Queue> queues_;
+  std::atomic<int64> size_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingQueueSet);
+};
+
+// Schedules items of type T onto at most `max_workers` closures running on
+// `runner`, each of which drains its own queue of a WorkStealingQueueSet and
+// steals from the others when idle. Workers are started on demand and exit
+// when there is no work left anywhere, so an idle scheduler holds no
+// threads.
+//
+// Items scheduled from within one of this scheduler's workers stay on that
+// worker's queue; items scheduled from any other thread are spread across
+// the queues round-robin.
+//
+// The scheduler is reference counted: every running worker holds a
+// reference, so `handler` may destroy the object that owns the scheduler as
+// long as it does not schedule more work afterwards.
+template <typename T>
+class WorkStealingScheduler : public core::RefCounted {
+ public:
+  typedef std::function<void(std::function<void()>)> Runner;
+  typedef std::function<void(T)> Handler;
+
+  WorkStealingScheduler(int max_workers, Runner runner, Handler handler)
+      : queues_(max_workers),
+        runner_(std::move(runner)),
+        handler_(std::move(handler)) {
+    idle_workers_.reserve(max_workers);
+    for (int i = max_workers - 1; i >= 0; --i) {
+      idle_workers_.push_back(i);
+    }
+  }
+
+  int max_workers() const { return queues_.num_queues(); }
+
+  // Number of items popped from the queue of the worker that produced them.
+  int64 num_local_hits() const {
+    return num_local_hits_.load(std::memory_order_relaxed);
+  }
+
+  // Number of items a worker took from another worker's queue.
+  int64 num_steals() const {
+    return num_steals_.load(std::memory_order_relaxed);
+  }
+
+  void Schedule(T item) {
+    const WorkerId& self = CurrentWorker();
+    int queue;
+    if (self.scheduler == this) {
+      queue = self.index;
+    } else {
+      queue = static_cast<int>(
+          next_queue_.fetch_add(1, std::memory_order_relaxed) %
+          queues_.num_queues());
+    }
+    queues_.Push(queue, std::move(item));
+    MaybeStartWorker();
+  }
+
+ private:
+  struct WorkerId {
+    const void* scheduler = nullptr;
+    int index = -1;
+  };
+
+  static WorkerId& CurrentWorker() {
+    static thread_local WorkerId current;
+    return current;
+  }
+
+  // Starts one more worker if any worker slot is idle.
+  void MaybeStartWorker() {
+    int worker;
+    {
+      mutex_lock l(mu_);
+      if (idle_workers_.empty()) return;
+      worker = idle_workers_.back();
+      idle_workers_.pop_back();
+    }
+    Ref();
+    runner_([this, worker]() { WorkerLoop(worker); });
+  }
+
+  void WorkerLoop(int worker) {
+    // Runners may execute closures inline, so a worker can start on a
+    // thread that is already running another worker.
+    WorkerId saved = CurrentWorker();
+    CurrentWorker() = {this, worker};
+    T item;
+    bool stolen;
+    while (true) {
+      while (queues_.Pop(worker, &item, &stolen)) {
+        if (stolen) {
+          num_steals_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          num_local_hits_.fetch_add(1, std::memory_order_relaxed);
+        }
+        handler_(std::move(item));
+      }
+      {
+        mutex_lock l(mu_);
+        idle_workers_.push_back(worker);
+      }
+      // Work pushed between the last failed Pop and going idle may not
+      // have started a worker if all slots were busy, so check again
+      // before exiting.
+      if (queues_.size() == 0) break;
+      mutex_lock l(mu_);
+      if (idle_workers_.empty()) break;
+      worker = idle_workers_.back();
+      idle_workers_.pop_back();
+      CurrentWorker().index = worker;
+    }
+    CurrentWorker() = saved;
+    Unref();
+  }
+
+  WorkStealingQueueSet<T> queues_;
+  const Runner runner_;
+  const Handler handler_;
+
+  mutex mu_;
+  std::vector<int> idle_workers_ GUARDED_BY(mu_);
+
+  std::atomic<int64> next_queue_{0};
+  std::atomic<int64> num_local_hits_{0};
+  std::atomic<int64> num_steals_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingScheduler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
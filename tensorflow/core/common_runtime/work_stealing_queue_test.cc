@@ -0,0 +1,106 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
+
+#include <atomic>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingQueueSetTest, PopsOwnQueueLifo) {
+  WorkStealingQueueSet<int> queues(2);
+  queues.Push(0, 1);
+  queues.Push(0, 2);
+  queues.Push(0, 3);
+  EXPECT_EQ(3, queues.size());
+
+  int item;
+  bool stolen;
+  ASSERT_TRUE(queues.Pop(0, &item, &stolen));
+  EXPECT_EQ(3, item);
+  EXPECT_FALSE(stolen);
+  ASSERT_TRUE(queues.Pop(0, &item, &stolen));
+  EXPECT_EQ(2, item);
+  EXPECT_FALSE(stolen);
+  EXPECT_EQ(1, queues.size());
+}
+
+TEST(WorkStealingQueueSetTest, StealsOldestFromOtherQueue) {
+  WorkStealingQueueSet<int> queues(3);
+  queues.Push(1, 10);
+  queues.Push(1, 11);
+
+  int item;
+  bool stolen;
+  ASSERT_TRUE(queues.Pop(0, &item, &stolen));
+  EXPECT_EQ(10, item);
+  EXPECT_TRUE(stolen);
+  ASSERT_TRUE(queues.Pop(2, &item, &stolen));
+  EXPECT_EQ(11, item);
+  EXPECT_TRUE(stolen);
+  EXPECT_FALSE(queues.Pop(0, &item, &stolen));
+  EXPECT_EQ(0, queues.size());
+}
+
+TEST(WorkStealingSchedulerTest, RunsEveryItemOnce) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  const int kNumItems = 1000;
+  std::vector<std::atomic<int>> runs(kNumItems);
+  for (auto& r : runs) r = 0;
+  BlockingCounter counter(kNumItems);
+
+  auto* scheduler = new WorkStealingScheduler<int>(
+      4, [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); },
+      [&runs, &counter](int i) {
+        ++runs[i];
+        counter.DecrementCount();
+      });
+  for (int i = 0; i < kNumItems; ++i) {
+    scheduler->Schedule(i);
+  }
+  counter.Wait();
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_EQ(1, runs[i]) << i;
+  }
+  EXPECT_EQ(kNumItems, scheduler->num_local_hits() + scheduler->num_steals());
+  scheduler->Unref();
+}
+
+TEST(WorkStealingSchedulerTest, KeepsSuccessorsLocal) {
+  // With a single worker nothing can be stolen, so every item the worker
+  // produces must be a local hit.
+  const int kDepth = 100;
+  std::atomic<int> num_run(0);
+  WorkStealingScheduler<int>* scheduler = nullptr;
+  scheduler = new WorkStealingScheduler<int>(
+      1, [](std::function<void()> fn) { fn(); },
+      [&scheduler, &num_run](int depth) {
+        ++num_run;
+        if (depth > 0) scheduler->Schedule(depth - 1);
+      });
+  scheduler->Schedule(kDepth);
+  EXPECT_EQ(kDepth + 1, num_run);
+  EXPECT_EQ(kDepth + 1, scheduler->num_local_hits());
+  EXPECT_EQ(0, scheduler->num_steals());
+  scheduler->Unref();
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/cancellable_call.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
@@ -79,6 +80,24 @@ class CompleteInstanceCall : public CancellableCall {
   CompleteInstanceResponse resp_;
 };
 
+// Returns a fingerprint of the fields of *cp sent to the group leader by
+// CompleteInstanceCall, other than the instance key and node name.
+uint64 InstanceStructureFingerprint(const CollectiveParams& cp) {
+  uint64 fp = Fingerprint64(cp.group.device_type.type_string());
+  fp = FingerprintCat64(fp, cp.group.group_key);
+  fp = FingerprintCat64(fp, cp.group.group_size);
+  fp = FingerprintCat64(fp, cp.instance.type);
+  fp = FingerprintCat64(fp, cp.instance.data_type);
+  for (int64 dim_size : cp.instance.shape.dim_sizes()) {
+    fp = FingerprintCat64(fp, dim_size);
+  }
+  fp = FingerprintCat64(fp, cp.instance.shape.dims());
+  for (int32 offset : cp.instance.impl_details.subdiv_offsets) {
+    fp = FingerprintCat64(fp, offset);
+  }
+  return fp;
+}
+
 }  // namespace
 
 CollectiveParamResolverDistributed::CollectiveParamResolverDistributed(
@@ -308,6 +327,24 @@ bool CollectiveParamResolverDistributed::InstanceIsCached(int32 instance_key) {
   return it != instance_table_.end();
 }
 
+bool CollectiveParamResolverDistributed::InstanceStructureIsCached(
+    const CollectiveParams& cp) {
+  // The leader only coordinates the source of broadcasts, which can differ
+  // between instances.
+  if (cp.instance.type == BROADCAST_COLLECTIVE) return false;
+  const uint64 fp = InstanceStructureFingerprint(cp);
+  mutex_lock l(instance_mu_);
+  return instance_structures_.find(fp) != instance_structures_.end();
+}
+
+void CollectiveParamResolverDistributed::CacheInstanceStructure(
+    const CollectiveParams& cp) {
+  if (cp.instance.type == BROADCAST_COLLECTIVE) return;
+  const uint64 fp = InstanceStructureFingerprint(cp);
+  mutex_lock l(instance_mu_);
+  instance_structures_.insert(fp);
+}
+
 void CollectiveParamResolverDistributed::UpdateInstanceCache(
     const GroupRec* gr, CollectiveParams* cp,
     const CompleteInstanceResponse& resp, const StatusCallback& done) {
@@ -371,7 +408,8 @@ void CollectiveParamResolverDistributed::CompleteInstanceDistributed(
   if (group_leader_.empty()) {
     // This is the group leader so resolution is local.
     return CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
-  } else if (InstanceIsCached(cp->instance.instance_key)) {
+  } else if (InstanceIsCached(cp->instance.instance_key) ||
+             InstanceStructureIsCached(*cp)) {
     return CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
   } else {
     CompleteInstanceCall* call = new CompleteInstanceCall(
@@ -384,6 +422,7 @@ void CollectiveParamResolverDistributed::CompleteInstanceDistributed(
               if (!s.ok()) {
                 done(s);
               } else {
+                CacheInstanceStructure(*cp);
                 CompleteInstanceLocal(device, gr, cp, cp->is_source, done);
               }
             });
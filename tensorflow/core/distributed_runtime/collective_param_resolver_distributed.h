@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
 
 namespace tensorflow {
 class ConfigProto;
@@ -82,8 +83,21 @@ class CollectiveParamResolverDistributed : public CollectiveParamResolverLocal {
                                    const StatusCallback& done)
       LOCKS_EXCLUDED(instance_mu_, gr->mu, group_mu_);
 
+  // Returns true iff the group leader already completed a non-broadcast
+  // instance with the same structure as *cp, in which case completing *cp
+  // needs nothing from the leader.
+  bool InstanceStructureIsCached(const CollectiveParams& cp)
+      LOCKS_EXCLUDED(instance_mu_);
+
+  // Records that the group leader completed an instance like *cp.
+  void CacheInstanceStructure(const CollectiveParams& cp)
+      LOCKS_EXCLUDED(instance_mu_);
+
   WorkerCacheInterface* worker_cache_;  // Not owned
   const string group_leader_;
+  // Fingerprints of the group membership, type and tensor shape of
+  // non-broadcast instances the group leader completed.
+  gtl::FlatSet<uint64> instance_structures_ GUARDED_BY(instance_mu_);
 };
 
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
 
+#include <atomic>
+
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/test_utils.h"
@@ -72,11 +74,17 @@ class FakeWorker : public TestWorkerInterface {
                              const CompleteInstanceRequest* request,
                              CompleteInstanceResponse* response,
                              StatusCallback done) override {
+    ++num_complete_instance_calls_;
     param_resolver_->CompleteInstanceAsync(request, response, &cm_, done);
   }
 
+  int num_complete_instance_calls() const {
+    return num_complete_instance_calls_;
+  }
+
  private:
   string name_;
+  std::atomic<int> num_complete_instance_calls_{0};
   DeviceMgr* device_mgr_;
   CancellationManager cm_;
   CollectiveParamResolverDistributed* param_resolver_;
@@ -183,9 +191,10 @@ class DeviceResDistTest : public ::testing::Test {
     wc_.AddWorker(worker_name, fw);
   }
 
-  void DefineCollectiveParams(int num_workers, int num_devices) {
+  void DefineCollectiveParams(int num_workers, int num_devices,
+                              int instance_key = 3) {
     const int kGroupKey = 5;
-    const int kInstanceKey = 3;
+    cp_.clear();
     for (int wi = 0; wi < num_workers; ++wi) {
       string task_name = strings::StrCat("/job:worker/replica:0/task:", wi);
       for (int di = 0; di < num_devices; ++di) {
@@ -196,7 +205,7 @@ class DeviceResDistTest : public ::testing::Test {
         cp.group.group_size = num_workers * num_devices;
         cp.group.device_type = DEVICE_CPU;
         cp.group.num_tasks = num_workers;
-        cp.instance.instance_key = kInstanceKey;
+        cp.instance.instance_key = instance_key;
         cp.instance.type = REDUCTION_COLLECTIVE;
         cp.instance.data_type = DT_FLOAT;
         cp.instance.shape = TensorShape({64});
@@ -315,6 +324,25 @@ TEST_F(DeviceResDistTest, Workers2Devices2) {
   ValidateCollectiveParams(num_workers, num_devices);
 }
 
+TEST_F(DeviceResDistTest, RepeatedInstancesSkipLeader) {
+  const int num_workers = 2;
+  const int num_devices = 2;
+  DefineWorkers(num_workers, num_devices, "CPU", false);
+  DefineCollectiveParams(num_workers, num_devices);
+  IssueRequests(num_workers, num_devices);
+  ValidateCollectiveParams(num_workers, num_devices);
+  // The devices of the second worker asked the leader.
+  const int num_calls = workers_[0]->num_complete_instance_calls();
+  EXPECT_GT(num_calls, 0);
+
+  // A new instance with the same structure is completed locally.
+  DefineCollectiveParams(num_workers, num_devices, /*instance_key=*/4);
+  IssueRequests(num_workers, num_devices);
+  ValidateCollectiveParams(num_workers, num_devices);
+  EXPECT_EQ(num_calls, workers_[0]->num_complete_instance_calls());
+  EXPECT_EQ(4, cp_[num_devices].instance.instance_key);
+}
+
 #ifndef GOOGLE_CUDA
 namespace {
 // A mock NcclReducer for testing group runtime details initialization with CPU
@@ -0,0 +1,68 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_DATA_SERVICE_CLIENT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_DATA_SERVICE_CLIENT_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// The calls that workers and consumers make to the tf.data service
+// dispatcher. All methods block until the response arrives, and may be called
+// concurrently.
+class DispatcherClient {
+ public:
+  virtual ~DispatcherClient() {}
+
+  virtual Status RegisterWorker(const RegisterWorkerRequest* request,
+                                RegisterWorkerResponse* response) = 0;
+  virtual Status WorkerHeartbeat(const WorkerHeartbeatRequest* request,
+                                 WorkerHeartbeatResponse* response) = 0;
+  virtual Status GetOrRegisterDataset(
+      const GetOrRegisterDatasetRequest* request,
+      GetOrRegisterDatasetResponse* response) = 0;
+  virtual Status GetOrCreateJob(const GetOrCreateJobRequest* request,
+                                GetOrCreateJobResponse* response) = 0;
+  virtual Status GetTasks(const GetTasksRequest* request,
+                          GetTasksResponse* response) = 0;
+  virtual Status GetSplit(const GetSplitRequest* request,
+                          GetSplitResponse* response) = 0;
+};
+
+// The calls that consumers make to a tf.data service worker.
+class WorkerClient {
+ public:
+  virtual ~WorkerClient() {}
+
+  // Fetches the next element of task `task_id`. Blocks until the worker has
+  // produced the element, or `TryCancel()` is called. May be called
+  // concurrently.
+  virtual Status GetElement(int64 task_id, std::vector<Tensor>* components,
+                            bool* end_of_sequence) = 0;
+
+  // Makes the pending and future `GetElement()` calls return CANCELLED.
+  virtual void TryCancel() = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_DATA_SERVICE_CLIENT_H_
@@ -0,0 +1,304 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/data_service/dispatcher_impl.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// The default number of splits of a SHARD_DYNAMIC job for each worker
+// registered when the job is created. More splits rebalance at a finer grain
+// as workers join and leave, but restart the input pipeline more often.
+constexpr int64 kDefaultSplitsPerWorker = 8;
+
+}  // namespace
+
+constexpr int64 DataServiceDispatcherImpl::kWorkerTimeoutMicros;
+
+Status DataServiceDispatcherImpl::RegisterWorker(
+    const RegisterWorkerRequest* request, RegisterWorkerResponse* response) {
+  if (request->worker_address().empty()) {
+    return errors::InvalidArgument("The worker address must not be empty.");
+  }
+  mutex_lock l(mu_);
+  RemoveFailedWorkers();
+  const int64 worker_id = next_worker_id_++;
+  Worker& worker = workers_[worker_id];
+  worker.address = request->worker_address();
+  worker.last_heartbeat_micros = env_->NowMicros();
+  // Give the new worker a share of the dynamic jobs that still have splits.
+  for (auto& job : jobs_) {
+    if (job.second.sharding_policy == SHARD_DYNAMIC &&
+        job.second.HasSplitsToLease()) {
+      AddTask(job.first, 0, job.second.num_splits, worker_id);
+    }
+  }
+  response->set_worker_id(worker_id);
+  VLOG(1) << "Registered tf.data service worker " << worker_id << " at "
+          << request->worker_address();
+  return Status::OK();
+}
+
+Status DataServiceDispatcherImpl::WorkerHeartbeat(
+    const WorkerHeartbeatRequest* request, WorkerHeartbeatResponse* response) {
+  mutex_lock l(mu_);
+  Worker* worker = gtl::FindOrNull(workers_, request->worker_id());
+  if (worker == nullptr) {
+    return errors::NotFound("Unknown tf.data service worker ",
+                            request->worker_id());
+  }
+  // Updated first, so that the heartbeat itself does not time out.
+  worker->last_heartbeat_micros = env_->NowMicros();
+  RemoveFailedWorkers();
+  for (int64 task_id : request->finished_task_ids()) {
+    const int64* job_id = gtl::FindOrNull(job_by_task_, task_id);
+    if (job_id == nullptr || !finished_tasks_.insert(task_id).second) {
+      continue;
+    }
+    Job& job = jobs_[*job_id];
+    --job.num_unfinished_tasks;
+    // A finished task has produced its last split.
+    job.leased_splits.erase(task_id);
+    job.leasing_tasks.erase(task_id);
+  }
+  for (TaskDef& task : worker->new_tasks) {
+    response->add_new_tasks()->Swap(&task);
+  }
+  worker->new_tasks.clear();
+  return Status::OK();
+}
+
+Status DataServiceDispatcherImpl::GetOrRegisterDataset(
+    const GetOrRegisterDatasetRequest* request,
+    GetOrRegisterDatasetResponse* response) {
+  const uint64 hash = DeterministicProtoHash64(request->dataset().graph());
+  mutex_lock l(mu_);
+  auto range = datasets_by_hash_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (AreSerializedProtosEqual(datasets_[it->second].graph(),
+                                 request->dataset().graph())) {
+      response->set_dataset_id(it->second);
+      return Status::OK();
+    }
+  }
+  const int64 dataset_id = next_dataset_id_++;
+  datasets_[dataset_id] = request->dataset();
+  datasets_by_hash_.emplace(hash, dataset_id);
+  response->set_dataset_id(dataset_id);
+  return Status::OK();
+}
+
+Status DataServiceDispatcherImpl::GetOrCreateJob(
+    const GetOrCreateJobRequest* request, GetOrCreateJobResponse* response) {
+  mutex_lock l(mu_);
+  RemoveFailedWorkers();
+  if (datasets_.count(request->dataset_id()) == 0) {
+    return errors::NotFound("Unknown dataset ", request->dataset_id());
+  }
+  int64 job_id;
+  if (request->job_name().empty()) {
+    TF_RETURN_IF_ERROR(CreateJob(request->dataset_id(),
+                                 request->sharding_policy(),
+                                 request->num_splits(), &job_id));
+  } else {
+    const int64* existing_job_id =
+        gtl::FindOrNull(jobs_by_name_, request->job_name());
+    if (existing_job_id != nullptr) {
+      job_id = *existing_job_id;
+    } else {
+      TF_RETURN_IF_ERROR(CreateJob(request->dataset_id(),
+                                   request->sharding_policy(),
+                                   request->num_splits(), &job_id));
+      jobs_by_name_[request->job_name()] = job_id;
+    }
+  }
+  response->set_job_id(job_id);
+  return Status::OK();
+}
+
+Status DataServiceDispatcherImpl::CreateJob(int64 dataset_id,
+                                            ShardingPolicy sharding_policy,
+                                            int64 num_splits, int64* job_id) {
+  if (workers_.empty()) {
+    return errors::Unavailable(
+        "No tf.data service workers are registered with the dispatcher.");
+  }
+  *job_id = next_job_id_++;
+  Job& job = jobs_[*job_id];
+  job.dataset_id = dataset_id;
+  job.sharding_policy = sharding_policy;
+  if (sharding_policy == SHARD_DYNAMIC) {
+    job.num_splits = num_splits > 0
+                         ? num_splits
+                         : kDefaultSplitsPerWorker * workers_.size();
+  }
+  int64 shard_index = 0;
+  for (const auto& worker : workers_) {
+    AddTask(*job_id, shard_index++, workers_.size(), worker.first);
+  }
+  return Status::OK();
+}
+
+void DataServiceDispatcherImpl::AddTask(int64 job_id, int64 shard_index,
+                                        int64 num_shards, int64 worker_id) {
+  Job& job = jobs_[job_id];
+  Worker* worker = &workers_[worker_id];
+  TaskDef task;
+  task.set_job_id(job_id);
+  task.set_task_id(next_task_id_++);
+  *task.mutable_dataset() = datasets_[job.dataset_id];
+  task.set_sharding_policy(job.sharding_policy);
+  task.set_shard_index(shard_index);
+  task.set_num_shards(num_shards);
+  job.tasks.emplace_back();
+  job.tasks.back().set_task_id(task.task_id());
+  job.tasks.back().set_worker_address(worker->address);
+  ++job.num_unfinished_tasks;
+  if (job.sharding_policy == SHARD_DYNAMIC) {
+    job.leasing_tasks.insert(task.task_id());
+  }
+  job_by_task_[task.task_id()] = job_id;
+  worker_by_task_[task.task_id()] = worker_id;
+  worker->task_ids.push_back(task.task_id());
+  worker->new_tasks.push_back(std::move(task));
+}
+
+void DataServiceDispatcherImpl::RemoveFailedWorkers() {
+  const uint64 now_micros = env_->NowMicros();
+  std::vector<int64> failed_jobs;
+  for (auto it = workers_.begin(); it != workers_.end();) {
+    Worker& worker = it->second;
+    if (now_micros <= worker.last_heartbeat_micros + kWorkerTimeoutMicros) {
+      ++it;
+      continue;
+    }
+    LOG(WARNING) << "tf.data service worker " << it->first << " at "
+                 << worker.address << " has not sent a heartbeat for "
+                 << (now_micros - worker.last_heartbeat_micros) / 1000
+                 << " ms, removing it.";
+    for (int64 task_id : worker.task_ids) {
+      FailTask(task_id);
+      failed_jobs.push_back(job_by_task_[task_id]);
+      worker_by_task_.erase(task_id);
+    }
+    it = workers_.erase(it);
+  }
+  for (int64 job_id : failed_jobs) {
+    AddTasksForReturnedSplits(job_id);
+  }
+}
+
+void DataServiceDispatcherImpl::FailTask(int64 task_id) {
+  Job& job = jobs_[job_by_task_[task_id]];
+  // Tasks of static jobs keep their shard: their consumers fail instead.
+  if (job.sharding_policy != SHARD_DYNAMIC ||
+      !finished_tasks_.insert(task_id).second) {
+    return;
+  }
+  --job.num_unfinished_tasks;
+  for (TaskInfo& task : job.tasks) {
+    if (task.task_id() == task_id) {
+      task.set_failed(true);
+    }
+  }
+  auto it = job.leased_splits.find(task_id);
+  if (it != job.leased_splits.end()) {
+    VLOG(1) << "Returning split " << it->second << " of failed task "
+            << task_id;
+    job.returned_splits.push_back(it->second);
+    job.leased_splits.erase(it);
+  }
+  job.leasing_tasks.erase(task_id);
+}
+
+void DataServiceDispatcherImpl::AddTasksForReturnedSplits(int64 job_id) {
+  Job& job = jobs_[job_id];
+  if (job.returned_splits.empty()) {
+    return;
+  }
+  std::unordered_set<int64> leasing_workers;
+  for (int64 task_id : job.leasing_tasks) {
+    leasing_workers.insert(worker_by_task_[task_id]);
+  }
+  for (const auto& worker : workers_) {
+    if (leasing_workers.count(worker.first) == 0) {
+      AddTask(job_id, 0, job.num_splits, worker.first);
+    }
+  }
+}
+
+Status DataServiceDispatcherImpl::GetTasks(const GetTasksRequest* request,
+                                           GetTasksResponse* response) {
+  mutex_lock l(mu_);
+  RemoveFailedWorkers();
+  const Job* job = gtl::FindOrNull(jobs_, request->job_id());
+  if (job == nullptr) {
+    return errors::NotFound("Unknown job ", request->job_id());
+  }
+  for (const TaskInfo& task : job->tasks) {
+    *response->add_task_info() = task;
+  }
+  response->set_job_finished(job->num_unfinished_tasks == 0);
+  // A task that is producing a split may still fail, and its split be given
+  // to a new task.
+  response->set_tasks_final(
+      job->sharding_policy != SHARD_DYNAMIC ||
+      (!job->HasSplitsToLease() && job->leased_splits.empty()));
+  return Status::OK();
+}
+
+Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
+                                           GetSplitResponse* response) {
+  mutex_lock l(mu_);
+  RemoveFailedWorkers();
+  const int64 task_id = request->task_id();
+  const int64* job_id = gtl::FindOrNull(job_by_task_, task_id);
+  if (job_id == nullptr) {
+    return errors::NotFound("Unknown task ", task_id);
+  }
+  Job& job = jobs_[*job_id];
+  if (job.sharding_policy != SHARD_DYNAMIC) {
+    return errors::FailedPrecondition("Task ", task_id,
+                                      " does not belong to a SHARD_DYNAMIC "
+                                      "job.");
+  }
+  response->set_num_splits(job.num_splits);
+  // Asking for a split means that the previous one has been produced. A task
+  // that failed, or already finished, gets no more splits.
+  job.leased_splits.erase(task_id);
+  if (job.leasing_tasks.count(task_id) == 0 || !job.HasSplitsToLease()) {
+    job.leasing_tasks.erase(task_id);
+    response->set_end_of_splits(true);
+    return Status::OK();
+  }
+  int64 split_index;
+  if (!job.returned_splits.empty()) {
+    split_index = job.returned_splits.front();
+    job.returned_splits.pop_front();
+  } else {
+    split_index = job.next_split++;
+  }
+  job.leased_splits[task_id] = split_index;
+  response->set_split_index(split_index);
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,147 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_DISPATCHER_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_DISPATCHER_IMPL_H_
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// The RPC-agnostic implementation of the tf.data service dispatcher. All state
+// is kept in memory.
+//
+// A job is split into one task per worker registered at the time the job is
+// created; task `i` produces shard `i` of the dataset. Workers learn about
+// their new tasks from the responses to their heartbeats, and report the tasks
+// that have produced all their elements in later heartbeats.
+//
+// SHARD_DYNAMIC jobs instead lease their splits to the tasks one at a time,
+// through `GetSplit()`, and a worker that registers while such a job still has
+// splits to lease gets a task of the job too. A worker that has not sent a
+// heartbeat for `kWorkerTimeoutMicros` is removed: its SHARD_DYNAMIC tasks are
+// marked as failed, and the splits they were producing are leased again, to a
+// new task on each remaining worker if needed. Failures are detected when the
+// dispatcher handles a request, which the heartbeats of the other workers
+// guarantee happens regularly.
+class DataServiceDispatcherImpl {
+ public:
+  // `env` is used to read the time of the heartbeats.
+  explicit DataServiceDispatcherImpl(Env* env = Env::Default()) : env_(env) {}
+
+  static constexpr int64 kWorkerTimeoutMicros = 10 * 1000 * 1000;
+
+  Status RegisterWorker(const RegisterWorkerRequest* request,
+                        RegisterWorkerResponse* response);
+  Status WorkerHeartbeat(const WorkerHeartbeatRequest* request,
+                         WorkerHeartbeatResponse* response);
+  Status GetOrRegisterDataset(const GetOrRegisterDatasetRequest* request,
+                              GetOrRegisterDatasetResponse* response);
+  Status GetOrCreateJob(const GetOrCreateJobRequest* request,
+                        GetOrCreateJobResponse* response);
+  Status GetTasks(const GetTasksRequest* request, GetTasksResponse* response);
+  Status GetSplit(const GetSplitRequest* request, GetSplitResponse* response);
+
+ private:
+  struct Worker {
+    string address;
+    uint64 last_heartbeat_micros = 0;
+    // The ids of all the tasks assigned to the worker.
+    std::vector<int64> task_ids;
+    // The tasks assigned to the worker since its last heartbeat.
+    std::vector<TaskDef> new_tasks;
+  };
+
+  struct Job {
+    int64 dataset_id;
+    ShardingPolicy sharding_policy;
+    std::vector<TaskInfo> tasks;
+    int64 num_unfinished_tasks = 0;
+    // The number of splits of a SHARD_DYNAMIC job, and the next one to lease.
+    int64 num_splits = 0;
+    int64 next_split = 0;
+    // The splits of failed tasks, to lease again before `next_split`.
+    std::deque<int64> returned_splits;
+    // Maps the tasks that are producing a split to that split.
+    std::unordered_map<int64, int64> leased_splits;
+    // The tasks that may still ask for a split.
+    std::unordered_set<int64> leasing_tasks;
+
+    // Whether the job has splits that no task has been given yet.
+    bool HasSplitsToLease() const {
+      return next_split < num_splits || !returned_splits.empty();
+    }
+  };
+
+  // Creates a job over `dataset_id`, with one task per registered worker.
+  Status CreateJob(int64 dataset_id, ShardingPolicy sharding_policy,
+                   int64 num_splits, int64* job_id)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Adds a task of job `job_id` that runs on worker `worker_id` and produces
+  // shard `shard_index` of `num_shards`.
+  void AddTask(int64 job_id, int64 shard_index, int64 num_shards,
+               int64 worker_id) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Removes the workers whose last heartbeat is older than
+  // `kWorkerTimeoutMicros`, and gives the splits of their tasks back to their
+  // jobs.
+  void RemoveFailedWorkers() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Marks `task_id`, which ran on a failed worker, as failed if it belongs to
+  // a SHARD_DYNAMIC job, and returns its split to the job.
+  void FailTask(int64 task_id) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Adds a task of job `job_id` to each worker that has no task of the job
+  // that may still lease a split.
+  void AddTasksForReturnedSplits(int64 job_id) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  mutex mu_;
+  int64 next_worker_id_ GUARDED_BY(mu_) = 0;
+  int64 next_dataset_id_ GUARDED_BY(mu_) = 0;
+  int64 next_job_id_ GUARDED_BY(mu_) = 0;
+  int64 next_task_id_ GUARDED_BY(mu_) = 0;
+  // Ordered by id, so that shard indices follow the registration order.
+  std::map<int64, Worker> workers_ GUARDED_BY(mu_);
+  std::unordered_map<int64, DatasetDef> datasets_ GUARDED_BY(mu_);
+  // Maps the deterministic hash of a dataset's graph to the ids of the
+  // datasets with that hash.
+  std::unordered_multimap<uint64, int64> datasets_by_hash_ GUARDED_BY(mu_);
+  std::unordered_map<int64, Job> jobs_ GUARDED_BY(mu_);
+  std::unordered_map<string, int64> jobs_by_name_ GUARDED_BY(mu_);
+  std::unordered_map<int64, int64> job_by_task_ GUARDED_BY(mu_);
+  std::unordered_map<int64, int64> worker_by_task_ GUARDED_BY(mu_);
+  std::unordered_set<int64> finished_tasks_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DataServiceDispatcherImpl);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_DISPATCHER_IMPL_H_
@@ -0,0 +1,352 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/data_service/dispatcher_impl.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+class FakeClockEnv : public EnvWrapper {
+ public:
+  FakeClockEnv() : EnvWrapper(Env::Default()) {}
+  void AdvanceByMicros(uint64 micros) { now_micros_ += micros; }
+  uint64 NowMicros() const override { return now_micros_; }
+
+ private:
+  uint64 now_micros_ = 0;
+};
+
+class DispatcherImplTest : public ::testing::Test {
+ protected:
+  DispatcherImplTest() : dispatcher_(&env_) {}
+
+  // Lets every worker time out, except the ones that send a heartbeat later.
+  void TimeOutWorkers() {
+    env_.AdvanceByMicros(DataServiceDispatcherImpl::kWorkerTimeoutMicros + 1);
+  }
+
+  int64 RegisterWorker(const string& address) {
+    RegisterWorkerRequest request;
+    request.set_worker_address(address);
+    RegisterWorkerResponse response;
+    TF_CHECK_OK(dispatcher_.RegisterWorker(&request, &response));
+    return response.worker_id();
+  }
+
+  int64 RegisterDataset(const string& node_name) {
+    GetOrRegisterDatasetRequest request;
+    request.mutable_dataset()->mutable_graph()->add_node()->set_name(
+        node_name);
+    GetOrRegisterDatasetResponse response;
+    TF_CHECK_OK(dispatcher_.GetOrRegisterDataset(&request, &response));
+    return response.dataset_id();
+  }
+
+  Status CreateJob(int64 dataset_id, const string& job_name, int64* job_id,
+                   ShardingPolicy sharding_policy = SHARD_AUTO,
+                   int64 num_splits = 0) {
+    GetOrCreateJobRequest request;
+    request.set_dataset_id(dataset_id);
+    request.set_sharding_policy(sharding_policy);
+    request.set_job_name(job_name);
+    request.set_num_splits(num_splits);
+    GetOrCreateJobResponse response;
+    TF_RETURN_IF_ERROR(dispatcher_.GetOrCreateJob(&request, &response));
+    *job_id = response.job_id();
+    return Status::OK();
+  }
+
+  WorkerHeartbeatResponse Heartbeat(int64 worker_id,
+                                    const std::vector<int64>& finished_tasks) {
+    WorkerHeartbeatRequest request;
+    request.set_worker_id(worker_id);
+    for (int64 task_id : finished_tasks) {
+      request.add_finished_task_ids(task_id);
+    }
+    WorkerHeartbeatResponse response;
+    TF_CHECK_OK(dispatcher_.WorkerHeartbeat(&request, &response));
+    return response;
+  }
+
+  GetTasksResponse GetTasks(int64 job_id) {
+    GetTasksRequest request;
+    request.set_job_id(job_id);
+    GetTasksResponse response;
+    TF_CHECK_OK(dispatcher_.GetTasks(&request, &response));
+    return response;
+  }
+
+  GetSplitResponse GetSplit(int64 task_id) {
+    GetSplitRequest request;
+    request.set_task_id(task_id);
+    GetSplitResponse response;
+    TF_CHECK_OK(dispatcher_.GetSplit(&request, &response));
+    return response;
+  }
+
+  FakeClockEnv env_;
+  DataServiceDispatcherImpl dispatcher_;
+};
+
+TEST_F(DispatcherImplTest, RegisterWorkerRequiresAddress) {
+  RegisterWorkerRequest request;
+  RegisterWorkerResponse response;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      dispatcher_.RegisterWorker(&request, &response)));
+}
+
+TEST_F(DispatcherImplTest, DatasetsAreRegisteredOnce) {
+  const int64 a = RegisterDataset("a");
+  const int64 b = RegisterDataset("b");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, RegisterDataset("a"));
+  EXPECT_EQ(b, RegisterDataset("b"));
+}
+
+TEST_F(DispatcherImplTest, CreateJobRequiresWorkers) {
+  const int64 dataset_id = RegisterDataset("a");
+  int64 job_id;
+  EXPECT_TRUE(errors::IsUnavailable(CreateJob(dataset_id, "", &job_id)));
+}
+
+TEST_F(DispatcherImplTest, CreateJobRequiresDataset) {
+  RegisterWorker("localhost:1");
+  int64 job_id;
+  EXPECT_TRUE(errors::IsNotFound(CreateJob(42, "", &job_id)));
+}
+
+TEST_F(DispatcherImplTest, OneShardPerWorker) {
+  const int64 worker_0 = RegisterWorker("localhost:1");
+  const int64 worker_1 = RegisterWorker("localhost:2");
+  const int64 dataset_id = RegisterDataset("a");
+  int64 job_id;
+  TF_ASSERT_OK(CreateJob(dataset_id, "", &job_id));
+
+  GetTasksResponse tasks = GetTasks(job_id);
+  ASSERT_EQ(2, tasks.task_info_size());
+  EXPECT_EQ("localhost:1", tasks.task_info(0).worker_address());
+  EXPECT_EQ("localhost:2", tasks.task_info(1).worker_address());
+  EXPECT_FALSE(tasks.job_finished());
+
+  WorkerHeartbeatResponse heartbeat_0 = Heartbeat(worker_0, {});
+  ASSERT_EQ(1, heartbeat_0.new_tasks_size());
+  const TaskDef& task_0 = heartbeat_0.new_tasks(0);
+  EXPECT_EQ(tasks.task_info(0).task_id(), task_0.task_id());
+  EXPECT_EQ(job_id, task_0.job_id());
+  EXPECT_EQ(SHARD_AUTO, task_0.sharding_policy());
+  EXPECT_EQ(0, task_0.shard_index());
+  EXPECT_EQ(2, task_0.num_shards());
+  EXPECT_EQ("a", task_0.dataset().graph().node(0).name());
+
+  WorkerHeartbeatResponse heartbeat_1 = Heartbeat(worker_1, {});
+  ASSERT_EQ(1, heartbeat_1.new_tasks_size());
+  EXPECT_EQ(1, heartbeat_1.new_tasks(0).shard_index());
+
+  // Tasks are only sent once.
+  EXPECT_EQ(0, Heartbeat(worker_0, {}).new_tasks_size());
+}
+
+TEST_F(DispatcherImplTest, NamedJobsAreShared) {
+  RegisterWorker("localhost:1");
+  const int64 dataset_id = RegisterDataset("a");
+  int64 shared_0, shared_1, unnamed_0, unnamed_1;
+  TF_ASSERT_OK(CreateJob(dataset_id, "shared", &shared_0));
+  TF_ASSERT_OK(CreateJob(dataset_id, "shared", &shared_1));
+  TF_ASSERT_OK(CreateJob(dataset_id, "", &unnamed_0));
+  TF_ASSERT_OK(CreateJob(dataset_id, "", &unnamed_1));
+  EXPECT_EQ(shared_0, shared_1);
+  EXPECT_NE(shared_0, unnamed_0);
+  EXPECT_NE(unnamed_0, unnamed_1);
+}
+
+TEST_F(DispatcherImplTest, JobFinishesWhenAllTasksFinish) {
+  const int64 worker_0 = RegisterWorker("localhost:1");
+  const int64 worker_1 = RegisterWorker("localhost:2");
+  int64 job_id;
+  TF_ASSERT_OK(CreateJob(RegisterDataset("a"), "", &job_id));
+  const int64 task_0 = Heartbeat(worker_0, {}).new_tasks(0).task_id();
+  const int64 task_1 = Heartbeat(worker_1, {}).new_tasks(0).task_id();
+
+  Heartbeat(worker_0, {task_0});
+  // Repeated reports are ignored.
+  Heartbeat(worker_0, {task_0});
+  EXPECT_FALSE(GetTasks(job_id).job_finished());
+  Heartbeat(worker_1, {task_1});
+  EXPECT_TRUE(GetTasks(job_id).job_finished());
+}
+
+TEST_F(DispatcherImplTest, DynamicJobLeasesSplits) {
+  const int64 worker_0 = RegisterWorker("localhost:1");
+  const int64 worker_1 = RegisterWorker("localhost:2");
+  int64 job_id;
+  TF_ASSERT_OK(CreateJob(RegisterDataset("a"), "", &job_id, SHARD_DYNAMIC,
+                         /*num_splits=*/3));
+  const int64 task_0 = Heartbeat(worker_0, {}).new_tasks(0).task_id();
+  const int64 task_1 = Heartbeat(worker_1, {}).new_tasks(0).task_id();
+  EXPECT_FALSE(GetTasks(job_id).tasks_final());
+
+  // Splits are leased in order to whichever task asks first.
+  GetSplitResponse split = GetSplit(task_0);
+  EXPECT_EQ(0, split.split_index());
+  EXPECT_EQ(3, split.num_splits());
+  EXPECT_EQ(1, GetSplit(task_0).split_index());
+  EXPECT_EQ(2, GetSplit(task_1).split_index());
+  // The splits being produced could still be returned by a failed task.
+  EXPECT_FALSE(GetTasks(job_id).tasks_final());
+  EXPECT_TRUE(GetSplit(task_0).end_of_splits());
+  EXPECT_TRUE(GetSplit(task_1).end_of_splits());
+  EXPECT_TRUE(GetTasks(job_id).tasks_final());
+}
+
+TEST_F(DispatcherImplTest, WorkersJoinDynamicJobs) {
+  RegisterWorker("localhost:1");
+  const int64 dataset_id = RegisterDataset("a");
+  int64 dynamic_job, static_job;
+  TF_ASSERT_OK(CreateJob(dataset_id, "", &dynamic_job, SHARD_DYNAMIC,
+                         /*num_splits=*/2));
+  TF_ASSERT_OK(CreateJob(dataset_id, "", &static_job));
+
+  const int64 worker_1 = RegisterWorker("localhost:2");
+  WorkerHeartbeatResponse heartbeat = Heartbeat(worker_1, {});
+  ASSERT_EQ(1, heartbeat.new_tasks_size());
+  EXPECT_EQ(dynamic_job, heartbeat.new_tasks(0).job_id());
+  EXPECT_EQ(SHARD_DYNAMIC, heartbeat.new_tasks(0).sharding_policy());
+  EXPECT_EQ(2, GetTasks(dynamic_job).task_info_size());
+  EXPECT_EQ(1, GetTasks(static_job).task_info_size());
+  EXPECT_TRUE(GetTasks(static_job).tasks_final());
+
+  // Once all its splits are leased, a job gets no more tasks.
+  const int64 new_task = heartbeat.new_tasks(0).task_id();
+  GetSplit(new_task);
+  GetSplit(new_task);
+  const int64 worker_2 = RegisterWorker("localhost:3");
+  EXPECT_EQ(0, Heartbeat(worker_2, {}).new_tasks_size());
+  EXPECT_EQ(2, GetTasks(dynamic_job).task_info_size());
+}
+
+TEST_F(DispatcherImplTest, SplitsOfFailedWorkersAreLeasedAgain) {
+  const int64 worker_0 = RegisterWorker("localhost:1");
+  const int64 worker_1 = RegisterWorker("localhost:2");
+  const int64 dataset_id = RegisterDataset("a");
+  int64 dynamic_job, static_job;
+  TF_ASSERT_OK(CreateJob(dataset_id, "", &dynamic_job, SHARD_DYNAMIC,
+                         /*num_splits=*/3));
+  TF_ASSERT_OK(CreateJob(dataset_id, "", &static_job));
+  WorkerHeartbeatResponse heartbeat_0 = Heartbeat(worker_0, {});
+  WorkerHeartbeatResponse heartbeat_1 = Heartbeat(worker_1, {});
+  const int64 task_0 = heartbeat_0.new_tasks(0).task_id();
+  const int64 task_1 = heartbeat_1.new_tasks(0).task_id();
+  EXPECT_EQ(0, GetSplit(task_0).split_index());
+  EXPECT_EQ(1, GetSplit(task_1).split_index());
+
+  // Worker 0 stops sending heartbeats.
+  TimeOutWorkers();
+  EXPECT_EQ(0, Heartbeat(worker_1, {}).new_tasks_size());
+  GetTasksResponse tasks = GetTasks(dynamic_job);
+  ASSERT_EQ(2, tasks.task_info_size());
+  EXPECT_TRUE(tasks.task_info(0).failed());
+  EXPECT_FALSE(tasks.task_info(1).failed());
+  EXPECT_FALSE(tasks.tasks_final());
+  // The tasks of static jobs keep their shard.
+  EXPECT_FALSE(GetTasks(static_job).task_info(0).failed());
+
+  // The split of the failed task is leased before the remaining one.
+  EXPECT_EQ(0, GetSplit(task_1).split_index());
+  EXPECT_EQ(2, GetSplit(task_1).split_index());
+  EXPECT_TRUE(GetSplit(task_1).end_of_splits());
+  EXPECT_TRUE(GetSplit(task_0).end_of_splits());
+  Heartbeat(worker_1, {task_1});
+  tasks = GetTasks(dynamic_job);
+  EXPECT_TRUE(tasks.tasks_final());
+  EXPECT_TRUE(tasks.job_finished());
+
+  // A removed worker has to register again.
+  WorkerHeartbeatRequest request;
+  request.set_worker_id(worker_0);
+  WorkerHeartbeatResponse response;
+  EXPECT_TRUE(
+      errors::IsNotFound(dispatcher_.WorkerHeartbeat(&request, &response)));
+}
+
+TEST_F(DispatcherImplTest, SplitsOfFailedWorkersGetNewTasks) {
+  const int64 worker_0 = RegisterWorker("localhost:1");
+  const int64 worker_1 = RegisterWorker("localhost:2");
+  int64 job_id;
+  TF_ASSERT_OK(CreateJob(RegisterDataset("a"), "", &job_id, SHARD_DYNAMIC,
+                         /*num_splits=*/1));
+  const int64 task_0 = Heartbeat(worker_0, {}).new_tasks(0).task_id();
+  const int64 task_1 = Heartbeat(worker_1, {}).new_tasks(0).task_id();
+  EXPECT_EQ(0, GetSplit(task_0).split_index());
+  EXPECT_TRUE(GetSplit(task_1).end_of_splits());
+  Heartbeat(worker_1, {task_1});
+
+  // Worker 1 has no task left to lease the split of the failed worker 0, so
+  // it gets a new one.
+  TimeOutWorkers();
+  WorkerHeartbeatResponse heartbeat = Heartbeat(worker_1, {});
+  ASSERT_EQ(1, heartbeat.new_tasks_size());
+  const int64 new_task = heartbeat.new_tasks(0).task_id();
+  EXPECT_EQ(job_id, heartbeat.new_tasks(0).job_id());
+  EXPECT_EQ(3, GetTasks(job_id).task_info_size());
+  EXPECT_EQ(0, GetSplit(new_task).split_index());
+  EXPECT_TRUE(GetSplit(new_task).end_of_splits());
+  EXPECT_TRUE(GetTasks(job_id).tasks_final());
+}
+
+TEST_F(DispatcherImplTest, DefaultNumSplitsScalesWithWorkers) {
+  RegisterWorker("localhost:1");
+  RegisterWorker("localhost:2");
+  int64 job_id;
+  TF_ASSERT_OK(CreateJob(RegisterDataset("a"), "", &job_id, SHARD_DYNAMIC));
+  const int64 task_id = GetTasks(job_id).task_info(0).task_id();
+  EXPECT_EQ(16, GetSplit(task_id).num_splits());
+}
+
+TEST_F(DispatcherImplTest, GetSplitRequiresDynamicJob) {
+  const int64 worker_id = RegisterWorker("localhost:1");
+  int64 job_id;
+  TF_ASSERT_OK(CreateJob(RegisterDataset("a"), "", &job_id));
+  GetSplitRequest request;
+  request.set_task_id(Heartbeat(worker_id, {}).new_tasks(0).task_id());
+  GetSplitResponse response;
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      dispatcher_.GetSplit(&request, &response)));
+  request.set_task_id(42);
+  EXPECT_TRUE(errors::IsNotFound(dispatcher_.GetSplit(&request, &response)));
+}
+
+TEST_F(DispatcherImplTest, UnknownWorkerAndJob) {
+  WorkerHeartbeatRequest heartbeat_request;
+  heartbeat_request.set_worker_id(42);
+  WorkerHeartbeatResponse heartbeat_response;
+  EXPECT_TRUE(errors::IsNotFound(
+      dispatcher_.WorkerHeartbeat(&heartbeat_request, &heartbeat_response)));
+
+  GetTasksRequest tasks_request;
+  tasks_request.set_job_id(42);
+  GetTasksResponse tasks_response;
+  EXPECT_TRUE(errors::IsNotFound(
+      dispatcher_.GetTasks(&tasks_request, &tasks_response)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,475 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/data_service/worker_impl.h"
+
+#include <deque>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/function_handle_cache.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/kernels/data/unbounded_thread_pool.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kShardNodePrefix[] = "tf_data_service_shard";
+
+// Makes the dataset returned by `graph_def` produce only shard `index` of
+// `num_shards`, by inserting a sharding dataset between the dataset and the
+// `_Retval` node.
+Status AddShardNode(ShardingPolicy sharding_policy, int64 num_shards,
+                    int64 index, const DataTypeVector& output_dtypes,
+                    const std::vector<PartialTensorShape>& output_shapes,
+                    GraphDef* graph_def) {
+  int retval_index = -1;
+  for (int i = 0; i < graph_def->node_size(); ++i) {
+    if (graph_def->node(i).op() == FunctionLibraryDefinition::kRetOp) {
+      retval_index = i;
+    }
+  }
+  if (retval_index < 0) {
+    return errors::InvalidArgument("The dataset graph has no output.");
+  }
+  const string num_shards_name =
+      strings::StrCat(kShardNodePrefix, "/num_shards");
+  const string index_name = strings::StrCat(kShardNodePrefix, "/index");
+  auto add_scalar = [graph_def](const string& name, int64 value) {
+    NodeDef* node = graph_def->add_node();
+    node->set_name(name);
+    node->set_op("Const");
+    Tensor tensor(DT_INT64, TensorShape({}));
+    tensor.scalar<int64>()() = value;
+    AddNodeAttr("dtype", DT_INT64, node);
+    AddNodeAttr("value", tensor, node);
+  };
+  add_scalar(num_shards_name, num_shards);
+  add_scalar(index_name, index);
+
+  NodeDef* shard = graph_def->add_node();
+  shard->set_name(kShardNodePrefix);
+  switch (sharding_policy) {
+    case SHARD_AUTO:
+    case SHARD_DYNAMIC:
+      shard->set_op("AutoShardDataset");
+      break;
+    case SHARD_DATA:
+      shard->set_op("ShardDataset");
+      break;
+    default:
+      return errors::InvalidArgument("Unsupported sharding policy ",
+                                     sharding_policy);
+  }
+  NodeDef* retval = graph_def->mutable_node(retval_index);
+  shard->add_input(retval->input(0));
+  shard->add_input(num_shards_name);
+  shard->add_input(index_name);
+  AddNodeAttr("output_types", output_dtypes, shard);
+  AddNodeAttr("output_shapes", output_shapes, shard);
+  retval->set_input(0, shard->name());
+  return Status::OK();
+}
+
+}  // namespace
+
+// Runs the dataset of one task and buffers its elements.
+class DataServiceWorkerImpl::Task {
+ public:
+  // `dispatcher` must outlive the task; SHARD_DYNAMIC tasks lease their
+  // splits from it.
+  Task(const TaskDef& def, int64 buffer_size, DispatcherClient* dispatcher)
+      : def_(def), buffer_size_(buffer_size), dispatcher_(dispatcher) {}
+
+  ~Task() {
+    Cancel();
+    // Wait for the prefetch thread to return from its current `GetNext()`
+    // before destroying the iterator.
+    prefetch_thread_.reset();
+  }
+
+  // Starts running the dataset. If this fails, `GetNext()` returns the error.
+  Status Initialize() {
+    Status s = InitializeInternal();
+    if (!s.ok()) {
+      mutex_lock l(mu_);
+      status_ = s;
+    }
+    return s;
+  }
+
+  // Makes the pending and future `GetNext()` calls return CANCELLED, and
+  // stops prefetching.
+  void Cancel() {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+  }
+
+  Status GetNext(std::vector<Tensor>* components, bool* end_of_sequence) {
+    mutex_lock l(mu_);
+    while (buffer_.empty() && status_.ok() && !end_of_sequence_ &&
+           !cancelled_) {
+      cond_var_.wait(l);
+    }
+    if (cancelled_) {
+      return errors::Cancelled("Task ", def_.task_id(), " was cancelled.");
+    }
+    if (!buffer_.empty()) {
+      *components = std::move(buffer_.front());
+      buffer_.pop_front();
+      *end_of_sequence = false;
+      cond_var_.notify_all();
+      return Status::OK();
+    }
+    *end_of_sequence = end_of_sequence_;
+    return status_;
+  }
+
+ private:
+  Status InitializeInternal() {
+    std::unique_ptr<Device> device = DeviceFactory::NewDevice(
+        "CPU", SessionOptions(), "/job:localhost/replica:0/task:0");
+    if (device == nullptr) {
+      return errors::Internal("Could not create a CPU device.");
+    }
+    Device* device_ptr = device.get();
+    device_mgr_ = absl::make_unique<DeviceMgr>(std::move(device));
+    pool_ = absl::make_unique<thread::ThreadPool>(
+        Env::Default(), "tf_data_service_task", port::NumSchedulableCPUs());
+    flib_def_ = absl::make_unique<FunctionLibraryDefinition>(
+        OpRegistry::Global(), def_.dataset().graph().library());
+    pflr_ = absl::make_unique<ProcessFunctionLibraryRuntime>(
+        device_mgr_.get(), Env::Default(), TF_GRAPH_DEF_VERSION,
+        flib_def_.get(), OptimizerOptions(), pool_.get());
+    flr_ = pflr_->GetFLR(device_ptr->name());
+    function_handle_cache_ = absl::make_unique<FunctionHandleCache>(flr_);
+    unbounded_thread_pool_ = absl::make_unique<UnboundedThreadPool>(
+        Env::Default(), "tf_data_service_task_iterator");
+
+    DatasetBase* dataset;
+    TF_RETURN_IF_ERROR(MakeDataset(def_.dataset().graph(), &dataset));
+    output_dtypes_ = dataset->output_dtypes();
+    output_shapes_ = dataset->output_shapes();
+    // SHARD_DYNAMIC tasks create the iterator of each split as they lease it.
+    if (def_.sharding_policy() != SHARD_DYNAMIC) {
+      TF_RETURN_IF_ERROR(MakeIterator(
+          def_.sharding_policy() == SHARD_OFF ? 1 : def_.num_shards(),
+          def_.shard_index()));
+    }
+    prefetch_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+        ThreadOptions(), "tf_data_service_task_prefetch",
+        [this]() { PrefetchThread(); }));
+    return Status::OK();
+  }
+
+  // Makes `iterator_` iterate over shard `index` of `num_shards` of the
+  // dataset.
+  Status MakeIterator(int64 num_shards, int64 index) {
+    iterator_.reset();
+    DatasetBase* dataset;
+    if (num_shards > 1) {
+      GraphDef graph_def = def_.dataset().graph();
+      TF_RETURN_IF_ERROR(AddShardNode(def_.sharding_policy(), num_shards,
+                                      index, output_dtypes_, output_shapes_,
+                                      &graph_def));
+      TF_RETURN_IF_ERROR(MakeDataset(graph_def, &dataset));
+    } else {
+      TF_RETURN_IF_ERROR(MakeDataset(def_.dataset().graph(), &dataset));
+    }
+    std::unique_ptr<IteratorContext> ctx = MakeIteratorContext();
+    return dataset->MakeIterator(
+        ctx.get(), strings::StrCat("Task", def_.task_id()), &iterator_);
+  }
+
+  // Produces the next element of the task. SHARD_DYNAMIC tasks move on to the
+  // next split leased from the dispatcher whenever the current one is done.
+  // Each split gets a fresh iterator over the sharded graph, so when the input
+  // has no files to shard and AutoShard falls back to data sharding, every
+  // split reads the whole input to keep one element in `num_splits`.
+  Status GetNextElement(IteratorContext* ctx, std::vector<Tensor>* components,
+                        bool* end_of_sequence) {
+    while (true) {
+      if (iterator_ != nullptr) {
+        TF_RETURN_IF_ERROR(
+            iterator_->GetNext(ctx, components, end_of_sequence));
+        if (!*end_of_sequence || def_.sharding_policy() != SHARD_DYNAMIC) {
+          return Status::OK();
+        }
+        iterator_.reset();
+      }
+      GetSplitRequest request;
+      request.set_task_id(def_.task_id());
+      GetSplitResponse response;
+      TF_RETURN_IF_ERROR(dispatcher_->GetSplit(&request, &response));
+      if (response.end_of_splits()) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      VLOG(1) << "Task " << def_.task_id() << " leased split "
+              << response.split_index() << " of " << response.num_splits();
+      TF_RETURN_IF_ERROR(
+          MakeIterator(response.num_splits(), response.split_index()));
+    }
+  }
+
+  // Runs `graph_def` and returns the dataset it outputs. The dataset is owned
+  // by `dataset_variant_`.
+  Status MakeDataset(const GraphDef& graph_def, DatasetBase** dataset) {
+    string output_node;
+    for (const auto& node : graph_def.node()) {
+      if (node.op() == FunctionLibraryDefinition::kRetOp) {
+        output_node = node.input(0);
+      }
+    }
+    if (output_node.empty()) {
+      return errors::InvalidArgument("The dataset graph has no output.");
+    }
+    Graph graph(OpRegistry::Global());
+    TF_RETURN_IF_ERROR(ImportGraphDef({}, graph_def, &graph, nullptr));
+    std::vector<Tensor> outputs;
+    GraphRunner graph_runner(flr_->device());
+    TF_RETURN_IF_ERROR(
+        graph_runner.Run(&graph, flr_, {}, {output_node}, &outputs));
+    TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(outputs[0], dataset));
+    dataset_variant_ = outputs[0];
+    return Status::OK();
+  }
+
+  std::unique_ptr<IteratorContext> MakeIteratorContext() {
+    IteratorContext::Params params;
+    params.env = Env::Default();
+    params.flr = flr_;
+    params.function_handle_cache = function_handle_cache_.get();
+    params.resource_mgr = &resource_mgr_;
+    DeviceBase* device = flr_->device();
+    params.allocator_getter = [device](AllocatorAttributes attrs) {
+      return device->GetAllocator(attrs);
+    };
+    thread::ThreadPool* pool = pool_.get();
+    params.runner = [pool](std::function<void()> fn) {
+      pool->Schedule(std::move(fn));
+    };
+    params.runner_threadpool_size = pool->NumThreads();
+    params.thread_factory = unbounded_thread_pool_->get_thread_factory();
+    return absl::make_unique<IteratorContext>(std::move(params));
+  }
+
+  void PrefetchThread() {
+    std::unique_ptr<IteratorContext> ctx = MakeIteratorContext();
+    while (true) {
+      {
+        mutex_lock l(mu_);
+        while (!cancelled_ &&
+               buffer_.size() >= static_cast<size_t>(buffer_size_)) {
+          cond_var_.wait(l);
+        }
+        if (cancelled_) {
+          return;
+        }
+      }
+      std::vector<Tensor> components;
+      bool end_of_sequence = false;
+      Status s = GetNextElement(ctx.get(), &components, &end_of_sequence);
+      mutex_lock l(mu_);
+      if (!s.ok() || end_of_sequence) {
+        status_ = s;
+        end_of_sequence_ = end_of_sequence;
+        cond_var_.notify_all();
+        return;
+      }
+      buffer_.push_back(std::move(components));
+      cond_var_.notify_all();
+    }
+  }
+
+  const TaskDef def_;
+  const int64 buffer_size_;
+  DispatcherClient* const dispatcher_;  // Not owned.
+
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<thread::ThreadPool> pool_;
+  std::unique_ptr<FunctionLibraryDefinition> flib_def_;
+  std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
+  FunctionLibraryRuntime* flr_ = nullptr;  // Owned by `pflr_`.
+  std::unique_ptr<FunctionHandleCache> function_handle_cache_;
+  ResourceMgr resource_mgr_;
+  std::unique_ptr<UnboundedThreadPool> unbounded_thread_pool_;
+  Tensor dataset_variant_;
+  DataTypeVector output_dtypes_;
+  std::vector<PartialTensorShape> output_shapes_;
+  // Only used by the prefetch thread once it has started.
+  std::unique_ptr<IteratorBase> iterator_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  std::deque<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+  Status status_ GUARDED_BY(mu_);
+  bool end_of_sequence_ GUARDED_BY(mu_) = false;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> prefetch_thread_;
+};
+
+DataServiceWorkerImpl::DataServiceWorkerImpl(
+    std::unique_ptr<DispatcherClient> dispatcher, int64 heartbeat_interval_ms,
+    int64 buffer_size)
+    : dispatcher_(std::move(dispatcher)),
+      heartbeat_interval_ms_(heartbeat_interval_ms),
+      buffer_size_(buffer_size) {}
+
+DataServiceWorkerImpl::~DataServiceWorkerImpl() { Stop(); }
+
+void DataServiceWorkerImpl::Stop() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+    for (auto& task : tasks_) {
+      task.second->Cancel();
+    }
+  }
+  heartbeat_thread_.reset();
+}
+
+Status DataServiceWorkerImpl::Start(const string& worker_address) {
+  RegisterWorkerRequest request;
+  request.set_worker_address(worker_address);
+  RegisterWorkerResponse response;
+  TF_RETURN_IF_ERROR(dispatcher_->RegisterWorker(&request, &response));
+  {
+    mutex_lock l(mu_);
+    worker_id_ = response.worker_id();
+  }
+  LOG(INFO) << "Registered tf.data service worker " << response.worker_id()
+            << " at " << worker_address;
+  heartbeat_thread_ = absl::WrapUnique(
+      Env::Default()->StartThread(ThreadOptions(), "tf_data_service_heartbeat",
+                                  [this]() { HeartbeatThread(); }));
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::ProcessTask(const TaskDef& task) {
+  {
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      return errors::Cancelled("The tf.data service worker was stopped.");
+    }
+    if (tasks_.count(task.task_id()) > 0) {
+      return errors::AlreadyExists("Task ", task.task_id(),
+                                   " is already being processed.");
+    }
+  }
+  auto new_task = std::make_shared<Task>(task, buffer_size_, dispatcher_.get());
+  // A task that fails to start is still registered, so that its consumers
+  // receive the error instead of waiting for the task forever.
+  Status s = new_task->Initialize();
+  {
+    mutex_lock l(mu_);
+    tasks_[task.task_id()] = std::move(new_task);
+  }
+  TF_RETURN_IF_ERROR(s);
+  VLOG(1) << "Started task " << task.task_id() << " of job " << task.job_id()
+          << " (shard " << task.shard_index() << " of " << task.num_shards()
+          << ")";
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
+                                         std::vector<Tensor>* components,
+                                         bool* end_of_sequence) {
+  std::shared_ptr<Task> task;
+  {
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      return errors::Cancelled("The tf.data service worker was stopped.");
+    }
+    auto it = tasks_.find(request->task_id());
+    if (it == tasks_.end()) {
+      return errors::Unavailable("Task ", request->task_id(),
+                                 " has not been assigned to this worker yet.");
+    }
+    task = it->second;
+  }
+  TF_RETURN_IF_ERROR(task->GetNext(components, end_of_sequence));
+  if (*end_of_sequence) {
+    mutex_lock l(mu_);
+    finished_tasks_.push_back(request->task_id());
+  }
+  return Status::OK();
+}
+
+void DataServiceWorkerImpl::HeartbeatThread() {
+  while (true) {
+    Status s = SendHeartbeat();
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to send a heartbeat to the tf.data service "
+                   << "dispatcher: " << s;
+    }
+    mutex_lock l(mu_);
+    if (!cancelled_) {
+      cond_var_.wait_for(l,
+                         std::chrono::milliseconds(heartbeat_interval_ms_));
+    }
+    if (cancelled_) {
+      return;
+    }
+  }
+}
+
+Status DataServiceWorkerImpl::SendHeartbeat() {
+  WorkerHeartbeatRequest request;
+  std::vector<int64> finished_tasks;
+  {
+    mutex_lock l(mu_);
+    request.set_worker_id(worker_id_);
+    finished_tasks.swap(finished_tasks_);
+  }
+  for (int64 task_id : finished_tasks) {
+    request.add_finished_task_ids(task_id);
+  }
+  WorkerHeartbeatResponse response;
+  Status s = dispatcher_->WorkerHeartbeat(&request, &response);
+  if (!s.ok()) {
+    // Report the finished tasks again with the next heartbeat.
+    mutex_lock l(mu_);
+    finished_tasks_.insert(finished_tasks_.end(), finished_tasks.begin(),
+                           finished_tasks.end());
+    return s;
+  }
+  for (const TaskDef& task : response.new_tasks()) {
+    Status task_status = ProcessTask(task);
+    if (!task_status.ok()) {
+      LOG(ERROR) << "Failed to start task " << task.task_id() << ": "
+                 << task_status;
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
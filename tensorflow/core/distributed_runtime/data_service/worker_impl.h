@@ -0,0 +1,88 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_WORKER_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_WORKER_IMPL_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/data_service/data_service_client.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// The RPC-agnostic implementation of a tf.data service worker.
+//
+// Each task assigned to the worker runs its dataset in a standalone runtime
+// with its own CPU device and function library, and prefetches up to
+// `buffer_size` elements ahead of the consumers.
+class DataServiceWorkerImpl {
+ public:
+  // `dispatcher` is used to register the worker and to send its heartbeats
+  // every `heartbeat_interval_ms` milliseconds.
+  DataServiceWorkerImpl(std::unique_ptr<DispatcherClient> dispatcher,
+                        int64 heartbeat_interval_ms, int64 buffer_size);
+  ~DataServiceWorkerImpl();
+
+  // Cancels the tasks and stops sending heartbeats. The pending and future
+  // `GetElement()` calls return CANCELLED.
+  void Stop();
+
+  // Registers the worker with the dispatcher under `worker_address`, and
+  // starts sending heartbeats.
+  Status Start(const string& worker_address);
+
+  // Starts producing the elements of `task`.
+  Status ProcessTask(const TaskDef& task);
+
+  // Returns the next element of a task. Blocks until the element has been
+  // produced.
+  Status GetElement(const GetElementRequest* request,
+                    std::vector<Tensor>* components, bool* end_of_sequence);
+
+ private:
+  class Task;
+
+  void HeartbeatThread();
+  Status SendHeartbeat();
+
+  const std::unique_ptr<DispatcherClient> dispatcher_;
+  const int64 heartbeat_interval_ms_;
+  const int64 buffer_size_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  int64 worker_id_ GUARDED_BY(mu_) = -1;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  std::unordered_map<int64, std::shared_ptr<Task>> tasks_ GUARDED_BY(mu_);
+  // The finished tasks that have not been reported to the dispatcher yet.
+  std::vector<int64> finished_tasks_ GUARDED_BY(mu_);
+  std::unique_ptr<Thread> heartbeat_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DataServiceWorkerImpl);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_SERVICE_WORKER_IMPL_H_
@@ -0,0 +1,276 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/data_service/worker_impl.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using test::function::NDef;
+
+// Returns the graph of `range(0, n)`, in the form that DataServiceDataset
+// sends it to the dispatcher.
+DatasetDef RangeDatasetDef(int64 n) {
+  auto scalar = [](const string& name, int64 value) {
+    return NDef(name, "Const", {},
+                {{"dtype", DT_INT64}, {"value", test::AsScalar<int64>(value)}});
+  };
+  DatasetDef dataset;
+  *dataset.mutable_graph() = test::function::GDef(
+      {scalar("start", 0), scalar("stop", n), scalar("step", 1),
+       NDef("range", "RangeDataset", {"start", "stop", "step"},
+            {{"output_types", DataTypeVector({DT_INT64})},
+             {"output_shapes", std::vector<PartialTensorShape>({{}})}}),
+       NDef("dataset", "_Retval", {"range"},
+            {{"T", DT_VARIANT}, {"index", 0}})},
+      {});
+  return dataset;
+}
+
+TaskDef MakeTask(int64 task_id, const DatasetDef& dataset,
+                 ShardingPolicy sharding_policy = SHARD_OFF,
+                 int64 num_shards = 1, int64 shard_index = 0) {
+  TaskDef task;
+  task.set_job_id(1);
+  task.set_task_id(task_id);
+  *task.mutable_dataset() = dataset;
+  task.set_sharding_policy(sharding_policy);
+  task.set_num_shards(num_shards);
+  task.set_shard_index(shard_index);
+  return task;
+}
+
+// Hands out the tasks added with `AddTask()` in the next heartbeat response,
+// records the finished tasks reported by the heartbeats, and leases the splits
+// set with `SetNumSplits()` in order.
+class FakeDispatcherClient : public DispatcherClient {
+ public:
+  Status RegisterWorker(const RegisterWorkerRequest* request,
+                        RegisterWorkerResponse* response) override {
+    response->set_worker_id(kWorkerId);
+    return Status::OK();
+  }
+
+  Status WorkerHeartbeat(const WorkerHeartbeatRequest* request,
+                         WorkerHeartbeatResponse* response) override {
+    EXPECT_EQ(kWorkerId, request->worker_id());
+    mutex_lock l(mu_);
+    finished_tasks_.insert(finished_tasks_.end(),
+                           request->finished_task_ids().begin(),
+                           request->finished_task_ids().end());
+    for (const TaskDef& task : new_tasks_) {
+      *response->add_new_tasks() = task;
+    }
+    new_tasks_.clear();
+    cond_var_.notify_all();
+    return Status::OK();
+  }
+
+  Status GetOrRegisterDataset(const GetOrRegisterDatasetRequest* request,
+                              GetOrRegisterDatasetResponse* response) override {
+    return errors::Unimplemented("GetOrRegisterDataset");
+  }
+
+  Status GetOrCreateJob(const GetOrCreateJobRequest* request,
+                        GetOrCreateJobResponse* response) override {
+    return errors::Unimplemented("GetOrCreateJob");
+  }
+
+  Status GetTasks(const GetTasksRequest* request,
+                  GetTasksResponse* response) override {
+    return errors::Unimplemented("GetTasks");
+  }
+
+  Status GetSplit(const GetSplitRequest* request,
+                  GetSplitResponse* response) override {
+    mutex_lock l(mu_);
+    if (next_split_ >= num_splits_) {
+      response->set_end_of_splits(true);
+      return Status::OK();
+    }
+    response->set_split_index(next_split_++);
+    response->set_num_splits(num_splits_);
+    return Status::OK();
+  }
+
+  void SetNumSplits(int64 num_splits) {
+    mutex_lock l(mu_);
+    num_splits_ = num_splits;
+    next_split_ = 0;
+  }
+
+  void AddTask(const TaskDef& task) {
+    mutex_lock l(mu_);
+    new_tasks_.push_back(task);
+  }
+
+  // Blocks until a heartbeat has reported that `task_id` is finished.
+  void WaitForFinishedTask(int64 task_id) {
+    mutex_lock l(mu_);
+    while (std::find(finished_tasks_.begin(), finished_tasks_.end(),
+                     task_id) == finished_tasks_.end()) {
+      cond_var_.wait(l);
+    }
+  }
+
+  static constexpr int64 kWorkerId = 7;
+
+ private:
+  mutex mu_;
+  condition_variable cond_var_;
+  std::vector<TaskDef> new_tasks_ GUARDED_BY(mu_);
+  std::vector<int64> finished_tasks_ GUARDED_BY(mu_);
+  int64 num_splits_ GUARDED_BY(mu_) = 0;
+  int64 next_split_ GUARDED_BY(mu_) = 0;
+};
+
+constexpr int64 FakeDispatcherClient::kWorkerId;
+
+class DataServiceWorkerImplTest : public ::testing::Test {
+ protected:
+  DataServiceWorkerImplTest() {
+    auto dispatcher = absl::make_unique<FakeDispatcherClient>();
+    dispatcher_ = dispatcher.get();
+    worker_ = absl::make_unique<DataServiceWorkerImpl>(
+        std::move(dispatcher), /*heartbeat_interval_ms=*/10,
+        /*buffer_size=*/2);
+  }
+
+  Status GetElement(int64 task_id, std::vector<Tensor>* components,
+                    bool* end_of_sequence) {
+    GetElementRequest request;
+    request.set_task_id(task_id);
+    return worker_->GetElement(&request, components, end_of_sequence);
+  }
+
+  // Returns the remaining elements of `task_id`, which must be scalars.
+  std::vector<int64> GetRemainingElements(int64 task_id) {
+    std::vector<int64> elements;
+    while (true) {
+      std::vector<Tensor> components;
+      bool end_of_sequence = false;
+      TF_CHECK_OK(GetElement(task_id, &components, &end_of_sequence));
+      if (end_of_sequence) {
+        return elements;
+      }
+      EXPECT_EQ(1, components.size());
+      elements.push_back(components[0].scalar<int64>()());
+    }
+  }
+
+  FakeDispatcherClient* dispatcher_;  // Owned by `worker_`.
+  std::unique_ptr<DataServiceWorkerImpl> worker_;
+};
+
+TEST_F(DataServiceWorkerImplTest, ProducesTheElementsOfATask) {
+  TF_ASSERT_OK(worker_->ProcessTask(MakeTask(1, RangeDatasetDef(5))));
+  EXPECT_EQ(std::vector<int64>({0, 1, 2, 3, 4}), GetRemainingElements(1));
+  // A finished task keeps reporting the end of its sequence.
+  EXPECT_TRUE(GetRemainingElements(1).empty());
+}
+
+TEST_F(DataServiceWorkerImplTest, DataShardedTaskProducesItsShard) {
+  TF_ASSERT_OK(worker_->ProcessTask(MakeTask(1, RangeDatasetDef(8), SHARD_DATA,
+                                             /*num_shards=*/3,
+                                             /*shard_index=*/1)));
+  EXPECT_EQ(std::vector<int64>({1, 4, 7}), GetRemainingElements(1));
+}
+
+TEST_F(DataServiceWorkerImplTest, DynamicTaskProducesTheLeasedSplits) {
+  dispatcher_->SetNumSplits(3);
+  TF_ASSERT_OK(
+      worker_->ProcessTask(MakeTask(1, RangeDatasetDef(8), SHARD_DYNAMIC)));
+  // A range has no files, so each split reads the whole range and keeps every
+  // third element.
+  EXPECT_EQ(std::vector<int64>({0, 3, 6, 1, 4, 7, 2, 5}),
+            GetRemainingElements(1));
+}
+
+TEST_F(DataServiceWorkerImplTest, TasksRunIndependently) {
+  TF_ASSERT_OK(worker_->ProcessTask(MakeTask(1, RangeDatasetDef(3))));
+  TF_ASSERT_OK(worker_->ProcessTask(MakeTask(2, RangeDatasetDef(2))));
+  EXPECT_EQ(std::vector<int64>({0, 1}), GetRemainingElements(2));
+  EXPECT_EQ(std::vector<int64>({0, 1, 2}), GetRemainingElements(1));
+}
+
+TEST_F(DataServiceWorkerImplTest, DuplicateTaskIsRejected) {
+  TF_ASSERT_OK(worker_->ProcessTask(MakeTask(1, RangeDatasetDef(5))));
+  EXPECT_TRUE(errors::IsAlreadyExists(
+      worker_->ProcessTask(MakeTask(1, RangeDatasetDef(5)))));
+}
+
+TEST_F(DataServiceWorkerImplTest, UnknownTaskIsUnavailable) {
+  std::vector<Tensor> components;
+  bool end_of_sequence = false;
+  EXPECT_TRUE(
+      errors::IsUnavailable(GetElement(1, &components, &end_of_sequence)));
+}
+
+TEST_F(DataServiceWorkerImplTest, TaskThatFailsToStartReturnsItsError) {
+  DatasetDef dataset = RangeDatasetDef(5);
+  // Without its `_Retval` node, the graph has no output.
+  dataset.mutable_graph()->mutable_node()->RemoveLast();
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(worker_->ProcessTask(MakeTask(1, dataset))));
+  std::vector<Tensor> components;
+  bool end_of_sequence = false;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(GetElement(1, &components, &end_of_sequence)));
+}
+
+TEST_F(DataServiceWorkerImplTest, StopCancelsTheTasks) {
+  TF_ASSERT_OK(worker_->ProcessTask(MakeTask(1, RangeDatasetDef(5))));
+  worker_->Stop();
+  std::vector<Tensor> components;
+  bool end_of_sequence = false;
+  EXPECT_TRUE(
+      errors::IsCancelled(GetElement(1, &components, &end_of_sequence)));
+  EXPECT_TRUE(errors::IsCancelled(
+      worker_->ProcessTask(MakeTask(2, RangeDatasetDef(5)))));
+}
+
+TEST_F(DataServiceWorkerImplTest, HeartbeatsStartAndFinishTasks) {
+  dispatcher_->AddTask(MakeTask(3, RangeDatasetDef(2)));
+  TF_ASSERT_OK(worker_->Start("localhost:0"));
+  // The task is started by one of the next heartbeats.
+  std::vector<Tensor> components;
+  bool end_of_sequence = false;
+  Status s;
+  while (errors::IsUnavailable(
+      s = GetElement(3, &components, &end_of_sequence))) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  TF_ASSERT_OK(s);
+  ASSERT_FALSE(end_of_sequence);
+  EXPECT_EQ(0, components[0].scalar<int64>()());
+  EXPECT_EQ(std::vector<int64>({1}), GetRemainingElements(3));
+  dispatcher_->WaitForFinishedTask(3);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
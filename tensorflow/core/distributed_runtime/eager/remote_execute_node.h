@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_REMOTE_EXECUTE_NODE_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_REMOTE_EXECUTE_NODE_H_
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/distributed_runtime/eager/eager_client.h"
@@ -26,8 +28,15 @@ namespace eager {
 
 // RemoteExecuteNode is an implementation of EagerNode which enqueues
 // an operation via RPC in a remote EagerService.
+//
+// Consecutive nodes for the same remote context are sent in a single
+// EnqueueRequest. The remote service runs the operations of a request in
+// order, so an operation can use the outputs of the ones before it.
 class RemoteExecuteNode : public tensorflow::EagerNode {
  public:
+  // The most nodes sent in one EnqueueRequest.
+  static constexpr int kMaxBatchSize = 64;
+
   RemoteExecuteNode(std::unique_ptr<EnqueueRequest> request,
                     EagerClient* eager_client,
                     const gtl::InlinedVector<TensorHandle*, 4>& inputs,
@@ -50,7 +59,25 @@ class RemoteExecuteNode : public tensorflow::EagerNode {
     }
   }
 
+  bool Absorb(EagerNode* next) override {
+    auto* node = dynamic_cast<RemoteExecuteNode*>(next);
+    if (node == nullptr || node->eager_client_ != eager_client_ ||
+        node->request_->context_id() != request_->context_id() ||
+        node->request_->queue_size() != 1 || request_->queue_size() != 1 ||
+        absorbed_.size() + 1 >= kMaxBatchSize) {
+      return false;
+    }
+    absorbed_.push_back(node);
+    return true;
+  }
+
   Status Run() override {
+    for (RemoteExecuteNode* node : absorbed_) {
+      for (auto& item : *node->request_->mutable_queue()) {
+        request_->add_queue()->Swap(&item);
+      }
+    }
+
     EnqueueResponse response;
     Status status;
     Notification n;
@@ -66,9 +93,26 @@ class RemoteExecuteNode : public tensorflow::EagerNode {
       return status;
     }
 
+    // Each node sent one operation, so the responses are in node order.
+    SetRemoteShapes(response.queue_response(0));
+    for (int i = 0; i < absorbed_.size(); i++) {
+      absorbed_[i]->SetRemoteShapes(response.queue_response(i + 1));
+    }
+
+    return status;
+  }
+
+  void Abort(Status status) override {
+    PoisonRetvals(status);
+    for (RemoteExecuteNode* node : absorbed_) {
+      node->PoisonRetvals(status);
+    }
+  }
+
+ private:
+  void SetRemoteShapes(const QueueResponse& queue_response) {
     for (int i = 0; i < retvals_.size(); i++) {
-      Status s =
-          retvals_[i]->SetRemoteShape(response.queue_response(0).shape(i));
+      Status s = retvals_[i]->SetRemoteShape(queue_response.shape(i));
       if (!s.ok()) {
         retvals_[i]->Poison(s);
       }
@@ -78,11 +122,9 @@ class RemoteExecuteNode : public tensorflow::EagerNode {
     for (auto* handle : inputs_) {
       handle->Unref();
     }
-
-    return status;
   }
 
-  void Abort(Status status) override {
+  void PoisonRetvals(Status status) {
     for (int i = 0; i < retvals_.size(); i++) {
       retvals_[i]->Poison(status);
       retvals_[i]->Unref();
@@ -93,11 +135,13 @@ class RemoteExecuteNode : public tensorflow::EagerNode {
     }
   }
 
- private:
   std::unique_ptr<EnqueueRequest> request_;
   EagerClient* eager_client_;  // Not owned, and must outlive this node.
   gtl::InlinedVector<TensorHandle*, 4> inputs_;
   gtl::InlinedVector<TensorHandle*, 2> retvals_;
+  // The nodes that are sent in the same request as this one, in order. They
+  // stay owned by the executor until this node is done.
+  std::vector<RemoteExecuteNode*> absorbed_;
 };
 
 }  // namespace eager
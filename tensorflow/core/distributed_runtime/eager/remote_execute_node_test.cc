@@ -0,0 +1,209 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/eager/remote_execute_node.h"
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+// Records the operations of every Enqueue call, and answers each operation
+// with one output of shape [operation id].
+class FakeEagerClient : public EagerClient {
+ public:
+  explicit FakeEagerClient(Status status = Status::OK()) : status_(status) {}
+
+#define CLIENT_METHOD(method)                                    \
+  void method##Async(const method##Request* request,             \
+                     method##Response* response,                 \
+                     StatusCallback done) override {             \
+    done(errors::Unimplemented(#method));                        \
+  }
+
+  CLIENT_METHOD(CreateContext);
+  CLIENT_METHOD(WaitQueueDone);
+  CLIENT_METHOD(KeepAlive);
+  CLIENT_METHOD(CloseContext);
+  CLIENT_METHOD(RegisterFunction);
+  CLIENT_METHOD(SendTensor);
+
+#undef CLIENT_METHOD
+
+  void EnqueueAsync(const EnqueueRequest* request, EnqueueResponse* response,
+                    StatusCallback done) override {
+    std::vector<int64> op_ids;
+    for (const QueueItem& item : request->queue()) {
+      if (!item.has_operation()) continue;
+      op_ids.push_back(item.operation().id());
+      response->add_queue_response()->add_shape()->add_dim()->set_size(
+          item.operation().id());
+    }
+    // Releasing remote handles also enqueues requests, without operations.
+    if (!op_ids.empty()) {
+      mutex_lock l(mu_);
+      batches_.push_back(op_ids);
+    }
+    done(status_);
+  }
+
+  void StreamingEnqueueAsync(const EnqueueRequest* request,
+                             EnqueueResponse* response,
+                             StatusCallback done) override {
+    done(errors::Unimplemented("StreamingEnqueue"));
+  }
+
+  std::vector<std::vector<int64>> batches() {
+    mutex_lock l(mu_);
+    return batches_;
+  }
+
+ private:
+  const Status status_;
+  mutex mu_;
+  std::vector<std::vector<int64>> batches_ GUARDED_BY(mu_);
+};
+
+class RemoteExecuteNodeTest : public ::testing::Test {
+ protected:
+  RemoteExecuteNodeTest() {
+    std::vector<std::unique_ptr<Device>> devices;
+    TF_CHECK_OK(DeviceFactory::AddDevices(
+        SessionOptions(), "/job:localhost/replica:0/task:0", &devices));
+    device_ = devices[0].get();
+    device_mgr_ = absl::make_unique<DeviceMgr>(std::move(devices));
+    ctx_ = new EagerContext(
+        SessionOptions(),
+        ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+        ContextMirroringPolicy::MIRRORING_NONE, /*async=*/false,
+        device_mgr_.get(), /*device_mgr_owned=*/false,
+        new IntraProcessRendezvous(device_mgr_.get()), nullptr);
+  }
+
+  ~RemoteExecuteNodeTest() override {
+    for (TensorHandle* handle : handles_) handle->Unref();
+    ctx_->Unref();
+  }
+
+  // Returns a client that outlives the handles, which may release their
+  // remote tensors through it when they are deleted.
+  FakeEagerClient* CreateClient(Status status = Status::OK()) {
+    clients_.push_back(absl::make_unique<FakeEagerClient>(status));
+    return clients_.back().get();
+  }
+
+  // Returns a node that runs operation `op_id` with one output, which is
+  // appended to `handles_`.
+  std::unique_ptr<RemoteExecuteNode> CreateNode(int64 op_id,
+                                                EagerClient* eager_client,
+                                                uint64 context_id = 1) {
+    auto request = absl::make_unique<EnqueueRequest>();
+    request->set_context_id(context_id);
+    request->add_queue()->mutable_operation()->set_id(op_id);
+    TensorHandle* retval;
+    TF_CHECK_OK(TensorHandle::CreateUnshapedRemoteHandle(
+        op_id, 0, eager_client, context_id, DT_FLOAT, device_, nullptr, ctx_,
+        &retval));
+    handles_.push_back(retval);
+    return absl::make_unique<RemoteExecuteNode>(
+        std::move(request), eager_client,
+        gtl::InlinedVector<TensorHandle*, 4>(), &retval, 1);
+  }
+
+  std::vector<std::unique_ptr<FakeEagerClient>> clients_;
+  Device* device_;
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  EagerContext* ctx_;
+  std::vector<TensorHandle*> handles_;
+};
+
+TEST_F(RemoteExecuteNodeTest, AbsorbsUpToMaxBatchSize) {
+  FakeEagerClient* client = CreateClient();
+  std::vector<std::unique_ptr<RemoteExecuteNode>> nodes;
+  for (int i = 0; i <= RemoteExecuteNode::kMaxBatchSize; ++i) {
+    nodes.push_back(CreateNode(i, client));
+  }
+  for (int i = 1; i < RemoteExecuteNode::kMaxBatchSize; ++i) {
+    EXPECT_TRUE(nodes[0]->Absorb(nodes[i].get())) << i;
+  }
+  EXPECT_FALSE(
+      nodes[0]->Absorb(nodes[RemoteExecuteNode::kMaxBatchSize].get()));
+
+  TF_ASSERT_OK(nodes[0]->Run());
+  std::vector<int64> expected_ids;
+  for (int i = 0; i < RemoteExecuteNode::kMaxBatchSize; ++i) {
+    expected_ids.push_back(i);
+  }
+  EXPECT_EQ(std::vector<std::vector<int64>>({expected_ids}), client->batches());
+
+  // Each handle gets the shape answered for its own operation.
+  for (int i = 0; i < RemoteExecuteNode::kMaxBatchSize; ++i) {
+    TensorShape shape;
+    TF_ASSERT_OK(handles_[i]->Shape(&shape));
+    EXPECT_EQ(TensorShape({i}), shape);
+  }
+
+  TF_ASSERT_OK(nodes[RemoteExecuteNode::kMaxBatchSize]->Run());
+  EXPECT_EQ(2, client->batches().size());
+}
+
+TEST_F(RemoteExecuteNodeTest, DoesNotAbsorbOtherClientsOrContexts) {
+  FakeEagerClient* client = CreateClient();
+  FakeEagerClient* other_client = CreateClient();
+  std::unique_ptr<RemoteExecuteNode> node = CreateNode(0, client);
+  std::unique_ptr<RemoteExecuteNode> other_client_node =
+      CreateNode(1, other_client);
+  std::unique_ptr<RemoteExecuteNode> other_context_node =
+      CreateNode(2, client, /*context_id=*/2);
+  EXPECT_FALSE(node->Absorb(other_client_node.get()));
+  EXPECT_FALSE(node->Absorb(other_context_node.get()));
+
+  TF_ASSERT_OK(node->Run());
+  TF_ASSERT_OK(other_client_node->Run());
+  TF_ASSERT_OK(other_context_node->Run());
+  EXPECT_EQ(std::vector<std::vector<int64>>({{0}, {2}}), client->batches());
+  EXPECT_EQ(std::vector<std::vector<int64>>({{1}}), other_client->batches());
+}
+
+TEST_F(RemoteExecuteNodeTest, FailedRpcPoisonsAbsorbedNodes) {
+  FakeEagerClient* client = CreateClient(errors::Unavailable("worker is gone"));
+  std::vector<std::unique_ptr<RemoteExecuteNode>> nodes;
+  for (int i = 0; i < 3; ++i) {
+    nodes.push_back(CreateNode(i, client));
+  }
+  EXPECT_TRUE(nodes[0]->Absorb(nodes[1].get()));
+  EXPECT_TRUE(nodes[0]->Absorb(nodes[2].get()));
+
+  EXPECT_TRUE(errors::IsUnavailable(nodes[0]->Run()));
+  for (TensorHandle* handle : handles_) {
+    TensorShape shape;
+    EXPECT_TRUE(errors::IsUnavailable(handle->Shape(&shape)));
+  }
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
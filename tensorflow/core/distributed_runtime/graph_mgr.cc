@@ -315,6 +315,34 @@ Status GraphMgr::Register(const string& handle, const GraphDef& gdef,
   return Status::OK();
 }
 
+Status GraphMgr::SetRegisteredKeys(const string& handle, RegisteredKeys keys) {
+  auto shared_keys = std::make_shared<const RegisteredKeys>(std::move(keys));
+  mutex_lock l(mu_);
+  auto iter = table_.find(handle);
+  if (iter == table_.end()) {
+    return errors::Aborted("Graph handle is not found: ", handle,
+                           ". Possibly, this worker just restarted.");
+  }
+  iter->second->registered_keys = std::move(shared_keys);
+  return Status::OK();
+}
+
+Status GraphMgr::GetRegisteredKeys(
+    const string& handle, std::shared_ptr<const RegisteredKeys>* keys) {
+  mutex_lock l(mu_);
+  auto iter = table_.find(handle);
+  if (iter == table_.end()) {
+    return errors::Aborted("Graph handle is not found: ", handle,
+                           ". Possibly, this worker just restarted.");
+  }
+  if (iter->second->registered_keys == nullptr) {
+    return errors::InvalidArgument("No keys were registered with graph ",
+                                   handle);
+  }
+  *keys = iter->second->registered_keys;
+  return Status::OK();
+}
+
 Status GraphMgr::Deregister(const string& handle) {
   Item* item = nullptr;
   // Removes one item from table_.
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -98,6 +99,16 @@ class GraphMgr {
   void RecvOutputsAsync(const int64 step_id, NamedTensors* out,
                         StatusCallback done);
 
+  // Rendezvous keys of the client-terminated inputs and outputs of a
+  // registered graph, which RunGraph requests may refer to by position.
+  struct RegisteredKeys {
+    std::vector<string> feed;
+    std::vector<string> fetch;
+  };
+  Status SetRegisteredKeys(const string& handle, RegisteredKeys keys);
+  Status GetRegisteredKeys(const string& handle,
+                           std::shared_ptr<const RegisteredKeys>* keys);
+
   // Deregisters a graph.
   Status Deregister(const string& handle);
 
@@ -141,6 +152,9 @@ class GraphMgr {
     GraphMgr* graph_mgr;
 
     int64 collective_graph_key;
+
+    // Set by SetRegisteredKeys(). Guarded by the GraphMgr's mutex.
+    std::shared_ptr<const RegisteredKeys> registered_keys;
   };
 
   const WorkerEnv* worker_env_;  // Not owned.
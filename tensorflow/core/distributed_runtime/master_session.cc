@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/master_session.h"
 
+#include <chrono>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -58,6 +59,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class RunManyGraphs;
+
 // MasterSession wraps ClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -80,7 +83,11 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
         worker_cache_(worker_cache),
         should_deregister_(should_deregister),
         collective_graph_key_(
-            client_graph_before_register_->collective_graph_key) {
+            client_graph_before_register_->collective_graph_key),
+        max_overlapping_steps_(
+            is_partial ? 0
+                       : session_opts.config.experimental()
+                             .max_overlapping_steps()) {
     VLOG(1) << "Created ReffedClientGraph for node with "
             << client_graph_before_register_->graph.num_node_ids();
 
@@ -122,6 +129,11 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     return execution_count_.fetch_add(1);
   }
 
+  // When StartStep() last returned this graph, in units of
+  // MasterSession::run_graph_uses_. Guarded by MasterSession::mu_.
+  int64 last_use() const { return last_use_; }
+  void set_last_use(int64 last_use) { last_use_ = last_use; }
+
   // Turn RPC logging on or off, both at the WorkerCache used by this
   // master process, and at each remote worker in use for the current
   // partitions.
@@ -245,6 +257,38 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   const bool should_deregister_;
   const int64 collective_graph_key_;
   std::atomic<int64> execution_count_ = {0};
+  int64 last_use_ = 0;
+
+  // If positive, at most this many steps of this graph run at a time, and
+  // waiting steps start in the order in which they arrived.  Partial runs span
+  // several RunPartitions() calls and are never held back.
+  const int max_overlapping_steps_;
+  mutex admission_mu_;
+  condition_variable admission_cv_;
+  int64 next_ticket_ GUARDED_BY(admission_mu_) = 0;
+  int64 next_admitted_ GUARDED_BY(admission_mu_) = 0;
+  // Tickets of steps that gave up waiting before their turn came.
+  std::unordered_set<int64> abandoned_tickets_ GUARDED_BY(admission_mu_);
+  int num_running_steps_ GUARDED_BY(admission_mu_) = 0;
+
+  // Blocks until a step may issue its RunGraph calls. Fails if `calls` is
+  // cancelled or if `timeout_in_ms` is positive and expires first.
+  Status AdmitStep(RunManyGraphs* calls, int64 timeout_in_ms);
+
+  // Wakes up the steps waiting in AdmitStep(), e.g. to notice cancellation.
+  void WakeWaitingSteps() {
+    if (max_overlapping_steps_ <= 0) return;
+    mutex_lock l(admission_mu_);
+    admission_cv_.notify_all();
+  }
+
+  // Called once the RunGraph calls of an admitted step have finished.
+  void FinishStep() {
+    if (max_overlapping_steps_ <= 0) return;
+    mutex_lock l(admission_mu_);
+    --num_running_steps_;
+    admission_cv_.notify_all();
+  }
 
   // Graph partitioned into per-location subgraphs.
   struct Part {
@@ -264,6 +308,11 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     // this partition on the worker.
     string graph_handle;
 
+    // True if the worker stored the keys of `feed_key` and `key_fetch`, in
+    // iteration order, at registration.  Non-partial RunGraph requests then
+    // refer to feeds and fetches by their position in that order.
+    bool use_key_indices = false;
+
     Part() : feed_key(3), key_fetch(3) {}
   };
 
@@ -475,6 +524,12 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     *c->req.mutable_debug_options() =
         callable_opts_.run_options().debug_options();
     c->req.set_collective_graph_key(collective_graph_key_);
+    for (const auto& feed_key : part.feed_key) {
+      c->req.add_feed_key(feed_key.second);
+    }
+    for (const auto& key_fetch : part.key_fetch) {
+      c->req.add_fetch_key(key_fetch.first);
+    }
     VLOG(2) << "Register " << c->req.graph_def().DebugString();
     auto cb = [c, &done](const Status& s) {
       c->status = s;
@@ -487,6 +542,7 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     Call* c = &calls[i];
     s.Update(c->status);
     partitions_[i].graph_handle = c->resp.graph_handle();
+    partitions_[i].use_key_indices = c->resp.accepts_key_indices();
   }
   return s;
 }
@@ -530,6 +586,11 @@ class RunManyGraphs {
     ReportBadStatus(errors::Cancelled("RunManyGraphs"));
   }
 
+  bool cancel_issued() const {
+    mutex_lock l(mu_);
+    return cancel_issued_;
+  }
+
   void Wait() { pending_.Wait(); }
 
   Status status() const {
@@ -566,6 +627,51 @@ class RunManyGraphs {
   TF_DISALLOW_COPY_AND_ASSIGN(RunManyGraphs);
 };
 
+Status MasterSession::ReffedClientGraph::AdmitStep(RunManyGraphs* calls,
+                                                   int64 timeout_in_ms) {
+  if (max_overlapping_steps_ <= 0) return Status::OK();
+  const uint64 deadline_micros =
+      timeout_in_ms > 0 ? Env::Default()->NowMicros() + timeout_in_ms * 1000
+                        : 0;
+  mutex_lock l(admission_mu_);
+  const int64 ticket = next_ticket_++;
+  Status s;
+  while (ticket != next_admitted_ ||
+         num_running_steps_ >= max_overlapping_steps_) {
+    if (calls->cancel_issued()) {
+      s = errors::Cancelled("Step was cancelled");
+      break;
+    }
+    if (deadline_micros == 0) {
+      admission_cv_.wait(l);
+      continue;
+    }
+    const uint64 now_micros = Env::Default()->NowMicros();
+    if (now_micros >= deadline_micros) {
+      s = errors::DeadlineExceeded(
+          "Timed out waiting for one of the ", max_overlapping_steps_,
+          " overlapping steps of this graph to finish");
+      break;
+    }
+    admission_cv_.wait_for(
+        l, std::chrono::microseconds(deadline_micros - now_micros));
+  }
+  if (s.ok()) {
+    ++num_running_steps_;
+  }
+  if (ticket == next_admitted_) {
+    ++next_admitted_;
+    while (abandoned_tickets_.erase(next_admitted_) > 0) {
+      ++next_admitted_;
+    }
+  } else {
+    abandoned_tickets_.insert(ticket);
+  }
+  // The next step in line may be admissible as well.
+  admission_cv_.notify_all();
+  return s;
+}
+
 namespace {
 Status AddSendFromClientRequest(const RunStepRequestWrapper& client_req,
                                 MutableRunGraphRequestWrapper* worker_req,
@@ -673,6 +779,23 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
           }
         }
       }
+    } else if (part.use_key_indices) {
+      // Same as below, but without sending the rendezvous keys.
+      int32 key_index = 0;
+      for (const auto& feed_key : part.feed_key) {
+        const string& feed = feed_key.first;
+        auto iter = feeds.find(feed);
+        if (iter == feeds.end()) {
+          return errors::Internal("No feed index found for feed: ", feed);
+        }
+        const int64 feed_index = iter->second;
+        TF_RETURN_IF_ERROR(AddSendFromClientRequest(req, c->req.get(),
+                                                    feed_index, string()));
+        c->req->add_send_index(key_index++);
+      }
+      for (int32 i = 0; i < part.key_fetch.size(); ++i) {
+        c->req->add_recv_index(i);
+      }
     } else {
       for (const auto& feed_key : part.feed_key) {
         const string& feed = feed_key.first;
@@ -692,6 +815,31 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
     }
   }
 
+  // Registers for cancellation before waiting for admission, so that a step
+  // that is held back by max_overlapping_steps can be cancelled too.
+  call_opts->SetCancelCallback([this, &calls]() {
+    LOG(INFO) << "Client requested cancellation for RunStep, cancelling "
+                  "worker operations.";
+    calls.StartCancel();
+    WakeWaitingSteps();
+  });
+  auto token = cm->get_cancellation_token();
+  const bool success = cm->RegisterCallback(token, [this, &calls]() {
+    calls.StartCancel();
+    WakeWaitingSteps();
+  });
+  if (!success) {
+    calls.StartCancel();
+  }
+  const Status admitted = AdmitStep(&calls, call_opts->GetTimeout());
+  if (!admitted.ok()) {
+    call_opts->ClearCancelCallback();
+    if (success) {
+      cm->DeregisterCallback(token);
+    }
+    return admitted;
+  }
+
   // Issues RunGraph calls.
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
@@ -703,18 +851,8 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
   }
 
   // Waits for the RunGraph calls.
-  call_opts->SetCancelCallback([&calls]() {
-    LOG(INFO) << "Client requested cancellation for RunStep, cancelling "
-                  "worker operations.";
-    calls.StartCancel();
-  });
-  auto token = cm->get_cancellation_token();
-  const bool success =
-      cm->RegisterCallback(token, [&calls]() { calls.StartCancel(); });
-  if (!success) {
-    calls.StartCancel();
-  }
   calls.Wait();
+  FinishStep();
   call_opts->ClearCancelCallback();
   if (success) {
     cm->DeregisterCallback(token);
@@ -1463,6 +1601,7 @@ WorkerCacheInterface* MasterSession::get_worker_cache() const {
 Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
                                 ReffedClientGraph** out_rcg, int64* out_count) {
   const uint64 hash = HashBuildGraphOptions(opts);
+  std::vector<ReffedClientGraph*> to_unref;
   {
     mutex_lock l(mu_);
     // TODO(suharshs): We cache partial run graphs and run graphs separately
@@ -1484,15 +1623,41 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
           stats_publisher_factory_, is_partial, worker_cache,
           !should_delete_worker_sessions_);
       iter = m->insert({hash, entry}).first;
+      EvictRunGraphs(hash, &to_unref, m);
       VLOG(1) << "Preparing to execute new graph";
     }
     *out_rcg = iter->second;
     (*out_rcg)->Ref();
+    (*out_rcg)->set_last_use(++run_graph_uses_);
     *out_count = (*out_rcg)->get_and_increment_execution_count();
   }
+  for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
   return Status::OK();
 }
 
+void MasterSession::EvictRunGraphs(uint64 keep_hash,
+                                   std::vector<ReffedClientGraph*>* to_unref,
+                                   RCGMap* rcg_map) {
+  const int max_cached =
+      session_opts_.config.experimental().max_cached_run_graphs();
+  if (max_cached <= 0) return;
+  while (rcg_map->size() > static_cast<size_t>(max_cached)) {
+    auto lru = rcg_map->end();
+    for (auto iter = rcg_map->begin(); iter != rcg_map->end(); ++iter) {
+      if (iter->first != keep_hash &&
+          (lru == rcg_map->end() ||
+           iter->second->last_use() < lru->second->last_use())) {
+        lru = iter;
+      }
+    }
+    if (lru == rcg_map->end()) return;
+    VLOG(1) << "Evicting graph for hash " << lru->first;
+    // Steps that are still running hold their own reference.
+    to_unref->push_back(lru->second);
+    rcg_map->erase(lru);
+  }
+}
+
 void MasterSession::ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                                    RCGMap* rcg_map) {
   VLOG(1) << "Discarding all reffed graphs";
@@ -154,6 +154,10 @@ class MasterSession : public core::RefCounted {
   typedef std::unordered_map<uint64, ReffedClientGraph*> RCGMap;
   RCGMap run_graphs_ GUARDED_BY(mu_);
   RCGMap partial_run_graphs_ GUARDED_BY(mu_);
+  // Number of times StartStep() returned a graph; orders the entries of the
+  // maps above for eviction when
+  // `ConfigProto.Experimental.max_cached_run_graphs` is set.
+  int64 run_graph_uses_ GUARDED_BY(mu_) = 0;
   int64 next_callable_handle_ GUARDED_BY(mu_) = 0;
   RCGMap callables_ GUARDED_BY(mu_);
 
@@ -225,6 +229,11 @@ class MasterSession : public core::RefCounted {
                    ReffedClientGraph** out_rcg, int64* out_count);
   void ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                       RCGMap* rcg_map) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Removes the least recently used graphs other than the one for
+  // `keep_hash` from `rcg_map` until it is within the configured bound.
+  void EvictRunGraphs(uint64 keep_hash,
+                      std::vector<ReffedClientGraph*>* to_unref,
+                      RCGMap* rcg_map) EXCLUSIVE_LOCKS_REQUIRED(mu_);
   void FillPerStepState(MasterSession::ReffedClientGraph* rcg,
                         const RunOptions& run_options, uint64 step_id,
                         int64 count, PerStepState* out_pss,
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_testlib.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/graph/testlib.h"
@@ -61,10 +62,12 @@ class MasterTest : public ::testing::Test {
   // rpc calls.
 
   Status CreateSession(const GraphDef& def, string* handle,
-                       int64* initial_version) {
+                       int64* initial_version,
+                       const ConfigProto& config = ConfigProto()) {
     ::grpc::ClientContext ctx;
     CreateSessionRequest req;
     *(req.mutable_graph_def()) = def;
+    *(req.mutable_config()) = config;
     // Invokes placement frequently.
     req.mutable_config()->set_placement_period(1);
     CreateSessionResponse resp;
@@ -93,10 +96,16 @@ class MasterTest : public ::testing::Test {
 
   Status RunStep(const string& handle,
                  const std::vector<std::pair<string, const Tensor*> >& feed,
-                 const std::map<string, Tensor*>& fetch) {
+                 const std::map<string, Tensor*>& fetch,
+                 const std::vector<string>& targets = {},
+                 int64 timeout_in_ms = 0) {
     ::grpc::ClientContext ctx;
     RunStepRequest req;
     req.set_session_handle(handle);
+    for (const string& target : targets) {
+      req.add_target(target);
+    }
+    req.mutable_options()->set_timeout_in_ms(timeout_in_ms);
     for (const auto& p : feed) {
       const string& feed_name = p.first;
       const Tensor* feed_tensor = p.second;
@@ -359,6 +368,109 @@ TEST_F(MasterTest, ConcurrentExtendAndRun) {
   TF_ASSERT_OK(CloseSession(handle));
 }
 
+TEST_F(MasterTest, EvictsRunGraphs) {
+  Graph graph(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&a_tensor, {1, 2, 3, 4});
+  Node* a_node = test::graph::Constant(&graph, a_tensor);
+  Tensor x_tensor(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&x_tensor, {0, 0, 0, 0});
+  Node* x_node = test::graph::Constant(&graph, x_tensor);
+  // y = A * x and z = x * A.
+  Node* y_node = test::graph::Matmul(&graph, a_node, x_node, false, false);
+  Node* z_node = test::graph::Matmul(&graph, x_node, a_node, false, false);
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+
+  string handle;
+  int64 initial_version;
+  ConfigProto config;
+  config.mutable_experimental()->set_max_cached_run_graphs(1);
+  TF_ASSERT_OK(CreateSession(def, &handle, &initial_version, config));
+
+  // Alternating between the two signatures rebuilds and re-registers the
+  // graphs for each of them in turn.
+  Tensor x(DT_FLOAT, TensorShape({2, 2}));
+  Tensor out(DT_FLOAT, TensorShape({2, 2}));
+  for (int i = 0; i < 3; ++i) {
+    test::FillValues<float>(&x, {1, 0, 0, static_cast<float>(i)});
+    TF_ASSERT_OK(RunStep(handle, {{x_node->name(), &x}},
+                         {{y_node->name() + ":0", &out}}));
+    test::ExpectTensorEqual<float>(
+        out, test::AsTensor<float>({1, 2.0f * i, 3, 4.0f * i}, {2, 2}));
+    TF_ASSERT_OK(RunStep(handle, {{x_node->name(), &x}},
+                         {{z_node->name() + ":0", &out}}));
+    test::ExpectTensorEqual<float>(
+        out, test::AsTensor<float>({1, 2, 3.0f * i, 4.0f * i}, {2, 2}));
+  }
+  TF_EXPECT_OK(CloseSession(handle));
+}
+
+TEST_F(MasterTest, BoundedOverlappingSteps) {
+  // Steps that dequeue from an empty queue stay in flight until another
+  // graph of the session enqueues into it.
+  GraphDef def;
+  TF_ASSERT_OK(NodeDefBuilder("queue", "FIFOQueueV2")
+                   .Attr("component_types", {DT_FLOAT})
+                   .Finalize(def.add_node()));
+  TF_ASSERT_OK(NodeDefBuilder("dequeue", "QueueDequeueV2")
+                   .Input("queue", 0, DT_RESOURCE)
+                   .Attr("component_types", {DT_FLOAT})
+                   .Finalize(def.add_node()));
+  TF_ASSERT_OK(NodeDefBuilder("value", "Const")
+                   .Attr("dtype", DT_FLOAT)
+                   .Attr("value", test::AsScalar<float>(1.0f))
+                   .Finalize(def.add_node()));
+  TF_ASSERT_OK(NodeDefBuilder("enqueue", "QueueEnqueueV2")
+                   .Input("queue", 0, DT_RESOURCE)
+                   .Input({{"value", 0, DT_FLOAT}})
+                   .Finalize(def.add_node()));
+
+  string handle;
+  int64 initial_version;
+  ConfigProto config;
+  config.mutable_experimental()->set_max_overlapping_steps(2);
+  TF_ASSERT_OK(CreateSession(def, &handle, &initial_version, config));
+
+  // Only two of the three dequeue steps are admitted. They block on the
+  // workers, so the third one times out waiting for its turn.
+  mutex mu;
+  std::vector<Status> statuses;
+  Notification timed_out;
+  {
+    thread::ThreadPool thread_pool(Env::Default(), "run_pool", 3);
+    for (int i = 0; i < 3; ++i) {
+      thread_pool.Schedule([this, handle, &mu, &statuses, &timed_out]() {
+        Tensor y(DT_FLOAT, TensorShape({}));
+        const Status s = RunStep(handle, {}, {{"dequeue:0", &y}}, {},
+                                 /*timeout_in_ms=*/1000);
+        mutex_lock l(mu);
+        statuses.push_back(s);
+        if (errors::IsDeadlineExceeded(s) && !timed_out.HasBeenNotified()) {
+          timed_out.Notify();
+        }
+      });
+    }
+    timed_out.WaitForNotification();
+    TF_ASSERT_OK(RunStep(handle, {}, {}, {"enqueue"}));
+    TF_ASSERT_OK(RunStep(handle, {}, {}, {"enqueue"}));
+  }
+
+  ASSERT_EQ(3, statuses.size());
+  int num_ok = 0;
+  for (const Status& s : statuses) {
+    if (s.ok()) {
+      ++num_ok;
+    } else {
+      EXPECT_TRUE(errors::IsDeadlineExceeded(s)) << s;
+      EXPECT_NE(s.error_message().find("overlapping steps"), string::npos)
+          << s;
+    }
+  }
+  EXPECT_EQ(2, num_ok);
+  TF_EXPECT_OK(CloseSession(handle));
+}
+
 TEST_F(MasterTest, EigenProblem) {
   // A = [3 2; -1 0]; x = rand(2, 1);
   // for i=1:100; x = A * x; end
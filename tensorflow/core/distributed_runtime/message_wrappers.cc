@@ -368,6 +368,30 @@ void InMemoryRunGraphRequest::add_recv_key(const string& recv_key) {
   recvs_.push_back(recv_key);
 }
 
+size_t InMemoryRunGraphRequest::num_send_indices() const {
+  return send_indices_.size();
+}
+
+int32 InMemoryRunGraphRequest::send_index(size_t i) const {
+  return send_indices_[i];
+}
+
+void InMemoryRunGraphRequest::add_send_index(int32 index) {
+  send_indices_.push_back(index);
+}
+
+size_t InMemoryRunGraphRequest::num_recv_indices() const {
+  return recv_indices_.size();
+}
+
+int32 InMemoryRunGraphRequest::recv_index(size_t i) const {
+  return recv_indices_[i];
+}
+
+void InMemoryRunGraphRequest::add_recv_index(int32 index) {
+  recv_indices_.push_back(index);
+}
+
 bool InMemoryRunGraphRequest::is_partial() const { return is_partial_; }
 
 void InMemoryRunGraphRequest::set_is_partial(bool is_partial) {
@@ -415,6 +439,12 @@ const RunGraphRequest& InMemoryRunGraphRequest::ToProto() const {
     for (size_t i = 0; i < num_recvs(); ++i) {
       proto_version_->add_recv_key(recv_key(i));
     }
+    for (int32 index : send_indices_) {
+      proto_version_->add_send_index(index);
+    }
+    for (int32 index : recv_indices_) {
+      proto_version_->add_recv_index(index);
+    }
     proto_version_->set_is_partial(is_partial());
     proto_version_->set_is_last_partial_run(is_last_partial_run());
   }
@@ -515,6 +545,30 @@ void MutableProtoRunGraphRequest::add_recv_key(const string& recv_key) {
   request_.add_recv_key(recv_key);
 }
 
+size_t MutableProtoRunGraphRequest::num_send_indices() const {
+  return request_.send_index_size();
+}
+
+int32 MutableProtoRunGraphRequest::send_index(size_t i) const {
+  return request_.send_index(i);
+}
+
+void MutableProtoRunGraphRequest::add_send_index(int32 index) {
+  request_.add_send_index(index);
+}
+
+size_t MutableProtoRunGraphRequest::num_recv_indices() const {
+  return request_.recv_index_size();
+}
+
+int32 MutableProtoRunGraphRequest::recv_index(size_t i) const {
+  return request_.recv_index(i);
+}
+
+void MutableProtoRunGraphRequest::add_recv_index(int32 index) {
+  request_.add_recv_index(index);
+}
+
 bool MutableProtoRunGraphRequest::is_partial() const {
   return request_.is_partial();
 }
@@ -596,6 +650,22 @@ const string& ProtoRunGraphRequest::recv_key(size_t i) const {
   return request_->recv_key(i);
 }
 
+size_t ProtoRunGraphRequest::num_send_indices() const {
+  return request_->send_index_size();
+}
+
+int32 ProtoRunGraphRequest::send_index(size_t i) const {
+  return request_->send_index(i);
+}
+
+size_t ProtoRunGraphRequest::num_recv_indices() const {
+  return request_->recv_index_size();
+}
+
+int32 ProtoRunGraphRequest::recv_index(size_t i) const {
+  return request_->recv_index(i);
+}
+
 bool ProtoRunGraphRequest::is_partial() const { return request_->is_partial(); }
 
 bool ProtoRunGraphRequest::is_last_partial_run() const {
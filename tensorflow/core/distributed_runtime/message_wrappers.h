@@ -282,6 +282,14 @@ class RunGraphRequestWrapper {
   virtual size_t num_recvs() const = 0;
   virtual const string& recv_key(size_t i) const = 0;
 
+  // Positions of the send keys, and of additional keys to fetch, in the keys
+  // registered with the graph. If num_send_indices() is non-zero, it is equal
+  // to num_sends() and the send keys are empty.
+  virtual size_t num_send_indices() const = 0;
+  virtual int32 send_index(size_t i) const = 0;
+  virtual size_t num_recv_indices() const = 0;
+  virtual int32 recv_index(size_t i) const = 0;
+
   // True if the RunGraphRequest is a partial run request.
   virtual bool is_partial() const = 0;
 
@@ -322,6 +330,8 @@ class MutableRunGraphRequestWrapper : public RunGraphRequestWrapper {
       const string& send_key) = 0;
 
   virtual void add_recv_key(const string& recv_key) = 0;
+  virtual void add_send_index(int32 index) = 0;
+  virtual void add_recv_index(int32 index) = 0;
   virtual void set_is_partial(bool is_partial) = 0;
   virtual void set_is_last_partial_run(bool is_last_partial_run) = 0;
   virtual void set_store_errors_in_response_body(bool store_errors) = 0;
@@ -341,6 +351,10 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   Status SendValue(size_t i, Tensor* out_tensor) const override;
   size_t num_recvs() const override;
   const string& recv_key(size_t i) const override;
+  size_t num_send_indices() const override;
+  int32 send_index(size_t i) const override;
+  size_t num_recv_indices() const override;
+  int32 recv_index(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
   const RunGraphRequest& ToProto() const override;
@@ -360,6 +374,8 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
       const RunCallableRequest& run_callable_request, size_t i,
       const string& send_key) override;
   void add_recv_key(const string& recv_key) override;
+  void add_send_index(int32 index) override;
+  void add_recv_index(int32 index) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
   void set_store_errors_in_response_body(bool store_errors) override;
@@ -373,6 +389,8 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   ExecutorOpts exec_opts_;
   gtl::InlinedVector<std::pair<string, Tensor>, 4> sends_;
   gtl::InlinedVector<string, 4> recvs_;
+  gtl::InlinedVector<int32, 4> send_indices_;
+  gtl::InlinedVector<int32, 4> recv_indices_;
   bool is_partial_ = false;
   bool is_last_partial_run_ = false;
   bool store_errors_in_response_body_ = false;
@@ -401,6 +419,10 @@ class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
   Status SendValue(size_t i, Tensor* out_tensor) const override;
   size_t num_recvs() const override;
   const string& recv_key(size_t i) const override;
+  size_t num_send_indices() const override;
+  int32 send_index(size_t i) const override;
+  size_t num_recv_indices() const override;
+  int32 recv_index(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
   bool store_errors_in_response_body() const override;
@@ -420,6 +442,8 @@ class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
       const RunCallableRequest& run_callable_request, size_t i,
       const string& send_key) override;
   void add_recv_key(const string& recv_key) override;
+  void add_send_index(int32 index) override;
+  void add_recv_index(int32 index) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
   void set_store_errors_in_response_body(bool store_errors) override;
@@ -444,6 +468,10 @@ class ProtoRunGraphRequest : public RunGraphRequestWrapper {
   Status SendValue(size_t i, Tensor* out_tensor) const override;
   size_t num_recvs() const override;
   const string& recv_key(size_t i) const override;
+  size_t num_send_indices() const override;
+  int32 send_index(size_t i) const override;
+  size_t num_recv_indices() const override;
+  int32 recv_index(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
   bool store_errors_in_response_body() const override;
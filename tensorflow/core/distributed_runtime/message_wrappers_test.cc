@@ -80,6 +80,9 @@ void BuildRunGraphRequest(const RunStepRequestWrapper& run_step_request,
                                                             "send_1"));
   run_graph_request->add_recv_key("recv_2");
   run_graph_request->add_recv_key("recv_3");
+  run_graph_request->add_send_index(4);
+  run_graph_request->add_send_index(5);
+  run_graph_request->add_recv_index(6);
   run_graph_request->set_is_partial(true);
 }
 
@@ -95,6 +98,11 @@ void CheckRunGraphRequest(const RunGraphRequestWrapper& request) {
   test::ExpectTensorEqual<int32>(TensorA(), val);
   TF_EXPECT_OK(request.SendValue(1, &val));
   test::ExpectTensorEqual<int32>(TensorB(), val);
+  ASSERT_EQ(2, request.num_send_indices());
+  EXPECT_EQ(4, request.send_index(0));
+  EXPECT_EQ(5, request.send_index(1));
+  ASSERT_EQ(1, request.num_recv_indices());
+  EXPECT_EQ(6, request.recv_index(0));
   EXPECT_TRUE(request.is_partial());
   EXPECT_FALSE(request.is_last_partial_run());
 }
@@ -0,0 +1,129 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_client.h"
+
+#include <unordered_set>
+
+#include "grpcpp/grpcpp.h"
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+class GrpcDispatcherClient : public DispatcherClient {
+ public:
+  explicit GrpcDispatcherClient(SharedGrpcChannelPtr channel)
+      : stub_(std::move(channel)) {}
+
+#define CLIENT_METHOD(method)                                              \
+  Status method(const method##Request* request, method##Response* response) \
+      override {                                                           \
+    ::grpc::ClientContext ctx;                                             \
+    return FromGrpcStatus(stub_.method(&ctx, *request, response));         \
+  }
+
+  CLIENT_METHOD(RegisterWorker);
+  CLIENT_METHOD(WorkerHeartbeat);
+  CLIENT_METHOD(GetOrRegisterDataset);
+  CLIENT_METHOD(GetOrCreateJob);
+  CLIENT_METHOD(GetTasks);
+  CLIENT_METHOD(GetSplit);
+
+#undef CLIENT_METHOD
+
+ private:
+  grpc::DispatcherService::Stub stub_;
+};
+
+class GrpcWorkerClient : public WorkerClient {
+ public:
+  explicit GrpcWorkerClient(SharedGrpcChannelPtr channel)
+      : stub_(std::move(channel)) {}
+
+  Status GetElement(int64 task_id, std::vector<Tensor>* components,
+                    bool* end_of_sequence) override {
+    ::grpc::ClientContext ctx;
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("The tf.data service client was cancelled.");
+      }
+      active_contexts_.insert(&ctx);
+    }
+    GetElementRequest request;
+    request.set_task_id(task_id);
+    GetElementResponse response;
+    ::grpc::Status s = stub_.GetElement(&ctx, request, &response);
+    {
+      mutex_lock l(mu_);
+      active_contexts_.erase(&ctx);
+    }
+    TF_RETURN_IF_ERROR(FromGrpcStatus(s));
+    *end_of_sequence = response.end_of_sequence();
+    components->clear();
+    components->reserve(response.components_size());
+    for (const RecvTensorResponse& component : response.components()) {
+      Tensor tensor;
+      if (!tensor.FromProto(component.tensor())) {
+        return errors::Internal("Could not parse a component of task ",
+                                task_id, "'s element.");
+      }
+      components->push_back(std::move(tensor));
+    }
+    return Status::OK();
+  }
+
+  void TryCancel() override {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (::grpc::ClientContext* ctx : active_contexts_) {
+      ctx->TryCancel();
+    }
+  }
+
+ private:
+  grpc::DataWorkerService::Stub stub_;
+
+  mutex mu_;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  std::unordered_set<::grpc::ClientContext*> active_contexts_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+Status NewGrpcDispatcherClient(const string& address,
+                               std::unique_ptr<DispatcherClient>* client) {
+  SharedGrpcChannelPtr channel;
+  TF_RETURN_IF_ERROR(NewHostPortGrpcChannel(address, nullptr, &channel));
+  client->reset(new GrpcDispatcherClient(std::move(channel)));
+  return Status::OK();
+}
+
+Status NewGrpcWorkerClient(const string& address,
+                           std::unique_ptr<WorkerClient>* client) {
+  SharedGrpcChannelPtr channel;
+  TF_RETURN_IF_ERROR(NewHostPortGrpcChannel(address, nullptr, &channel));
+  client->reset(new GrpcWorkerClient(std::move(channel)));
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,40 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_CLIENT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_CLIENT_H_
+
+#include <memory>
+
+#include "tensorflow/core/distributed_runtime/data_service/data_service_client.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace data {
+
+// Creates a client for the tf.data service dispatcher at `address`, a
+// "host:port" pair.
+Status NewGrpcDispatcherClient(const string& address,
+                               std::unique_ptr<DispatcherClient>* client);
+
+// Creates a client for the tf.data service worker at `address`, a "host:port"
+// pair.
+Status NewGrpcWorkerClient(const string& address,
+                           std::unique_ptr<WorkerClient>* client);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_CLIENT_H_
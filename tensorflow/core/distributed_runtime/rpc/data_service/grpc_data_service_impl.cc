@@ -0,0 +1,167 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_impl.h"
+
+#include "grpcpp/impl/codegen/async_stream.h"
+#include "grpcpp/impl/codegen/async_unary_call.h"
+#include "grpcpp/impl/codegen/channel_interface.h"
+#include "grpcpp/impl/codegen/client_unary_call.h"
+#include "grpcpp/impl/codegen/method_handler_impl.h"
+#include "grpcpp/impl/codegen/rpc_service_method.h"
+#include "grpcpp/impl/codegen/service_type.h"
+#include "grpcpp/impl/codegen/sync_stream.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace data {
+
+const char* GrpcDispatcherMethodName(GrpcDispatcherMethod id) {
+  switch (id) {
+    case GrpcDispatcherMethod::kRegisterWorker:
+      return "/tensorflow.data.DispatcherService/RegisterWorker";
+    case GrpcDispatcherMethod::kWorkerHeartbeat:
+      return "/tensorflow.data.DispatcherService/WorkerHeartbeat";
+    case GrpcDispatcherMethod::kGetOrRegisterDataset:
+      return "/tensorflow.data.DispatcherService/GetOrRegisterDataset";
+    case GrpcDispatcherMethod::kGetOrCreateJob:
+      return "/tensorflow.data.DispatcherService/GetOrCreateJob";
+    case GrpcDispatcherMethod::kGetTasks:
+      return "/tensorflow.data.DispatcherService/GetTasks";
+    case GrpcDispatcherMethod::kGetSplit:
+      return "/tensorflow.data.DispatcherService/GetSplit";
+  }
+  // Shouldn't be reached.
+  LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
+  return "invalid id";
+}
+
+const char* GrpcDataWorkerMethodName(GrpcDataWorkerMethod id) {
+  switch (id) {
+    case GrpcDataWorkerMethod::kGetElement:
+      return "/tensorflow.data.WorkerService/GetElement";
+  }
+  // Shouldn't be reached.
+  LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
+  return "invalid id";
+}
+
+namespace grpc {
+
+DispatcherService::Stub::Stub(
+    const std::shared_ptr< ::grpc::ChannelInterface>& channel)
+    : channel_(channel),
+      rpcmethod_RegisterWorker_(
+          GrpcDispatcherMethodName(GrpcDispatcherMethod::kRegisterWorker),
+          ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_WorkerHeartbeat_(
+          GrpcDispatcherMethodName(GrpcDispatcherMethod::kWorkerHeartbeat),
+          ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_GetOrRegisterDataset_(
+          GrpcDispatcherMethodName(
+              GrpcDispatcherMethod::kGetOrRegisterDataset),
+          ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_GetOrCreateJob_(
+          GrpcDispatcherMethodName(GrpcDispatcherMethod::kGetOrCreateJob),
+          ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_GetTasks_(
+          GrpcDispatcherMethodName(GrpcDispatcherMethod::kGetTasks),
+          ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_GetSplit_(
+          GrpcDispatcherMethodName(GrpcDispatcherMethod::kGetSplit),
+          ::grpc::internal::RpcMethod::NORMAL_RPC, channel) {}
+
+::grpc::Status DispatcherService::Stub::RegisterWorker(
+    ::grpc::ClientContext* context, const RegisterWorkerRequest& request,
+    RegisterWorkerResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_RegisterWorker_, context, request, response);
+}
+
+::grpc::Status DispatcherService::Stub::WorkerHeartbeat(
+    ::grpc::ClientContext* context, const WorkerHeartbeatRequest& request,
+    WorkerHeartbeatResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_WorkerHeartbeat_, context, request, response);
+}
+
+::grpc::Status DispatcherService::Stub::GetOrRegisterDataset(
+    ::grpc::ClientContext* context, const GetOrRegisterDatasetRequest& request,
+    GetOrRegisterDatasetResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetOrRegisterDataset_, context, request,
+      response);
+}
+
+::grpc::Status DispatcherService::Stub::GetOrCreateJob(
+    ::grpc::ClientContext* context, const GetOrCreateJobRequest& request,
+    GetOrCreateJobResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetOrCreateJob_, context, request, response);
+}
+
+::grpc::Status DispatcherService::Stub::GetTasks(
+    ::grpc::ClientContext* context, const GetTasksRequest& request,
+    GetTasksResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetTasks_, context, request, response);
+}
+
+::grpc::Status DispatcherService::Stub::GetSplit(
+    ::grpc::ClientContext* context, const GetSplitRequest& request,
+    GetSplitResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetSplit_, context, request, response);
+}
+
+DispatcherService::AsyncService::AsyncService() {
+  for (int i = 0; i < kGrpcNumDispatcherMethods; ++i) {
+    AddMethod(new ::grpc::internal::RpcServiceMethod(
+        GrpcDispatcherMethodName(static_cast<GrpcDispatcherMethod>(i)),
+        ::grpc::internal::RpcMethod::NORMAL_RPC, nullptr));
+    ::grpc::Service::MarkMethodAsync(i);
+  }
+}
+
+DispatcherService::AsyncService::~AsyncService() {}
+
+DataWorkerService::Stub::Stub(
+    const std::shared_ptr< ::grpc::ChannelInterface>& channel)
+    : channel_(channel),
+      rpcmethod_GetElement_(
+          GrpcDataWorkerMethodName(GrpcDataWorkerMethod::kGetElement),
+          ::grpc::internal::RpcMethod::NORMAL_RPC, channel) {}
+
+::grpc::Status DataWorkerService::Stub::GetElement(
+    ::grpc::ClientContext* context, const GetElementRequest& request,
+    GetElementResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetElement_, context, request, response);
+}
+
+DataWorkerService::AsyncService::AsyncService() {
+  for (int i = 0; i < kGrpcNumDataWorkerMethods; ++i) {
+    AddMethod(new ::grpc::internal::RpcServiceMethod(
+        GrpcDataWorkerMethodName(static_cast<GrpcDataWorkerMethod>(i)),
+        ::grpc::internal::RpcMethod::NORMAL_RPC, nullptr));
+    ::grpc::Service::MarkMethodAsync(i);
+  }
+}
+
+DataWorkerService::AsyncService::~AsyncService() {}
+
+}  // namespace grpc
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,141 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_IMPL_H_
+
+#include "grpcpp/impl/codegen/async_stream.h"
+#include "grpcpp/impl/codegen/async_unary_call.h"
+#include "grpcpp/impl/codegen/client_context.h"
+#include "grpcpp/impl/codegen/proto_utils.h"
+#include "grpcpp/impl/codegen/rpc_method.h"
+#include "grpcpp/impl/codegen/service_type.h"
+#include "grpcpp/impl/codegen/status.h"
+#include "grpcpp/impl/codegen/stub_options.h"
+#include "grpcpp/impl/codegen/sync_stream.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// Names of dispatcher methods.
+enum class GrpcDispatcherMethod {
+  kRegisterWorker,
+  kWorkerHeartbeat,
+  kGetOrRegisterDataset,
+  kGetOrCreateJob,
+  kGetTasks,
+  kGetSplit,
+};
+
+static const int kGrpcNumDispatcherMethods =
+    static_cast<int>(GrpcDispatcherMethod::kGetSplit) + 1;
+
+const char* GrpcDispatcherMethodName(GrpcDispatcherMethod id);
+
+// Names of worker methods.
+enum class GrpcDataWorkerMethod {
+  kGetElement,
+};
+
+static const int kGrpcNumDataWorkerMethods =
+    static_cast<int>(GrpcDataWorkerMethod::kGetElement) + 1;
+
+const char* GrpcDataWorkerMethodName(GrpcDataWorkerMethod id);
+
+namespace grpc {
+
+// Implementation of `tensorflow.data.DispatcherService`, based on the
+// definition in "//tensorflow/core/protobuf/data_service.proto".
+class DispatcherService final {
+ public:
+  class Stub final {
+   public:
+    explicit Stub(const std::shared_ptr< ::grpc::ChannelInterface>& channel);
+
+    ::grpc::Status RegisterWorker(::grpc::ClientContext* context,
+                                  const RegisterWorkerRequest& request,
+                                  RegisterWorkerResponse* response);
+    ::grpc::Status WorkerHeartbeat(::grpc::ClientContext* context,
+                                   const WorkerHeartbeatRequest& request,
+                                   WorkerHeartbeatResponse* response);
+    ::grpc::Status GetOrRegisterDataset(
+        ::grpc::ClientContext* context,
+        const GetOrRegisterDatasetRequest& request,
+        GetOrRegisterDatasetResponse* response);
+    ::grpc::Status GetOrCreateJob(::grpc::ClientContext* context,
+                                  const GetOrCreateJobRequest& request,
+                                  GetOrCreateJobResponse* response);
+    ::grpc::Status GetTasks(::grpc::ClientContext* context,
+                            const GetTasksRequest& request,
+                            GetTasksResponse* response);
+    ::grpc::Status GetSplit(::grpc::ClientContext* context,
+                            const GetSplitRequest& request,
+                            GetSplitResponse* response);
+
+   private:
+    std::shared_ptr< ::grpc::ChannelInterface> channel_;
+    const ::grpc::internal::RpcMethod rpcmethod_RegisterWorker_;
+    const ::grpc::internal::RpcMethod rpcmethod_WorkerHeartbeat_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetOrRegisterDataset_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetOrCreateJob_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetTasks_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetSplit_;
+  };
+
+  class AsyncService : public ::grpc::Service {
+   public:
+    AsyncService();
+    virtual ~AsyncService();
+
+    // Make RequestAsyncUnary public for grpc_call.h
+    using ::grpc::Service::RequestAsyncUnary;
+  };
+};
+
+// Implementation of `tensorflow.data.WorkerService`, based on the definition
+// in "//tensorflow/core/protobuf/data_service.proto". The server writes the
+// `GetElementResponse` directly into a ::grpc::ByteBuffer.
+class DataWorkerService final {
+ public:
+  class Stub final {
+   public:
+    explicit Stub(const std::shared_ptr< ::grpc::ChannelInterface>& channel);
+
+    ::grpc::Status GetElement(::grpc::ClientContext* context,
+                              const GetElementRequest& request,
+                              GetElementResponse* response);
+
+   private:
+    std::shared_ptr< ::grpc::ChannelInterface> channel_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetElement_;
+  };
+
+  class AsyncService : public ::grpc::Service {
+   public:
+    AsyncService();
+    virtual ~AsyncService();
+
+    // Make RequestAsyncUnary public for grpc_call.h
+    using ::grpc::Service::RequestAsyncUnary;
+  };
+};
+
+}  // namespace grpc
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_IMPL_H_
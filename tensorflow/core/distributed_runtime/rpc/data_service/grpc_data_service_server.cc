@@ -0,0 +1,353 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_server.h"
+
+#include <limits>
+
+#include "absl/memory/memory.h"
+#include "grpcpp/grpcpp.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/server_builder.h"
+#include "tensorflow/core/distributed_runtime/data_service/dispatcher_impl.h"
+#include "tensorflow/core/distributed_runtime/data_service/worker_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_client.h"
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Writes a `GetElementResponse` into `result`. The components are encoded
+// with `EncodeTensorToByteBuffer()`, which does not copy the contents of large
+// tensors, and their slices are concatenated after the tag and length of each
+// `GetElementResponse.components` field.
+Status EncodeElementToByteBuffer(const std::vector<Tensor>& components,
+                                 bool end_of_sequence,
+                                 ::grpc::ByteBuffer* result) {
+  std::vector<::grpc::Slice> slices;
+  for (const Tensor& component : components) {
+    ::grpc::ByteBuffer buffer;
+    ::tensorflow::grpc::EncodeTensorToByteBuffer(
+        /*is_dead=*/false, component, /*require_ack=*/false, &buffer);
+    std::vector<::grpc::Slice> buffer_slices;
+    if (!buffer.Dump(&buffer_slices).ok()) {
+      return errors::Internal("Could not encode an element component.");
+    }
+    string header;
+    core::PutVarint32(&header,
+                      (GetElementResponse::kComponentsFieldNumber << 3) |
+                          2 /* WIRETYPE_LENGTH_DELIMITED */);
+    core::PutVarint64(&header, buffer.Length());
+    slices.emplace_back(header.data(), header.size());
+    slices.insert(slices.end(), buffer_slices.begin(), buffer_slices.end());
+  }
+  if (end_of_sequence) {
+    string field;
+    core::PutVarint32(&field,
+                      (GetElementResponse::kEndOfSequenceFieldNumber << 3) |
+                          0 /* WIRETYPE_VARINT */);
+    core::PutVarint32(&field, 1);
+    slices.emplace_back(field.data(), field.size());
+  }
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+  return Status::OK();
+}
+
+// Owns the gRPC server and the thread that polls its completion queue.
+// `Derived` provides `EnqueueRequests()`, which is called once the server has
+// started, and the request handlers.
+template <class Derived, class AsyncService>
+class GrpcDataServer : public DataServiceServer {
+ public:
+  ~GrpcDataServer() override { Stop(); }
+
+  int bound_port() const override { return bound_port_; }
+
+  void Stop() override {
+    {
+      mutex_lock l(mu_);
+      if (is_shutdown_) {
+        return;
+      }
+      is_shutdown_ = true;
+      if (server_ == nullptr) {
+        stopped_ = true;
+        stopped_cond_var_.notify_all();
+        return;
+      }
+    }
+    server_->Shutdown();
+    cq_->Shutdown();
+    // Blocks until the polling thread has drained the completion queue.
+    thread_.reset();
+    mutex_lock l(mu_);
+    stopped_ = true;
+    stopped_cond_var_.notify_all();
+  }
+
+  void Join() override {
+    mutex_lock l(mu_);
+    while (!stopped_) {
+      stopped_cond_var_.wait(l);
+    }
+  }
+
+ protected:
+  Status StartServer(int port, const string& name) {
+    ::grpc::ServerBuilder builder;
+    builder.AddListeningPort(strings::StrCat("0.0.0.0:", port),
+                             ::grpc::InsecureServerCredentials(),
+                             &bound_port_);
+    builder.SetMaxMessageSize(std::numeric_limits<int32>::max());
+    builder.RegisterService(&service_);
+    cq_ = builder.AddCompletionQueue();
+    server_ = builder.BuildAndStart();
+    if (server_ == nullptr) {
+      return errors::Unavailable("Could not start the ", name,
+                                 " gRPC server on port ", port);
+    }
+    static_cast<Derived*>(this)->EnqueueRequests();
+    thread_.reset(Env::Default()->StartThread(ThreadOptions(), name,
+                                              [this]() { HandleRPCsLoop(); }));
+    return Status::OK();
+  }
+
+  // Requests the next call to `method`, unless the server is shutting down.
+  template <class RequestMessage, class ResponseMessage>
+  void EnqueueRequest(
+      int method,
+      void (Derived::*handler)(
+          Call<Derived, AsyncService, RequestMessage, ResponseMessage>*)) {
+    mutex_lock l(mu_);
+    if (!is_shutdown_) {
+      Call<Derived, AsyncService, RequestMessage, ResponseMessage>::
+          EnqueueRequestForMethod(&service_, cq_.get(), method, handler,
+                                  /*supports_cancel=*/false);
+    }
+  }
+
+ private:
+  void HandleRPCsLoop() {
+    void* tag;
+    bool ok;
+    while (cq_->Next(&tag, &ok)) {
+      typename UntypedCall<Derived>::Tag* callback_tag =
+          static_cast<typename UntypedCall<Derived>::Tag*>(tag);
+      CHECK(callback_tag);
+      callback_tag->OnCompleted(static_cast<Derived*>(this), ok);
+    }
+  }
+
+  AsyncService service_;
+  int bound_port_ = 0;
+  std::unique_ptr<::grpc::Server> server_;
+  std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
+  std::unique_ptr<Thread> thread_;
+
+  mutex mu_;
+  condition_variable stopped_cond_var_;
+  bool is_shutdown_ GUARDED_BY(mu_) = false;
+  bool stopped_ GUARDED_BY(mu_) = false;
+};
+
+// Requests the next call to the dispatcher method `method`.
+#define ENQUEUE_REQUEST(method)                                           \
+  EnqueueRequest<method##Request, method##Response>(                      \
+      static_cast<int>(GrpcDispatcherMethod::k##method),                  \
+      &GrpcDispatcherServer::method##Handler)
+
+class GrpcDispatcherServer
+    : public GrpcDataServer<GrpcDispatcherServer,
+                            grpc::DispatcherService::AsyncService> {
+ public:
+  GrpcDispatcherServer()
+      : pool_(Env::Default(), "tf_data_dispatcher",
+              port::NumSchedulableCPUs()) {}
+
+  ~GrpcDispatcherServer() override { Stop(); }
+
+  Status Start(int port) { return StartServer(port, "tf_data_dispatcher"); }
+
+  void EnqueueRequests() {
+    for (int i = 0; i < kQueueDepth; ++i) {
+      ENQUEUE_REQUEST(RegisterWorker);
+      ENQUEUE_REQUEST(WorkerHeartbeat);
+      ENQUEUE_REQUEST(GetOrRegisterDataset);
+      ENQUEUE_REQUEST(GetOrCreateJob);
+      ENQUEUE_REQUEST(GetTasks);
+      ENQUEUE_REQUEST(GetSplit);
+    }
+  }
+
+ private:
+  static constexpr int kQueueDepth = 10;
+
+  template <class RequestMessage, class ResponseMessage>
+  using DispatcherCall = Call<GrpcDispatcherServer,
+                              grpc::DispatcherService::AsyncService,
+                              RequestMessage, ResponseMessage>;
+
+#define HANDLE_CALL(method)                                                 \
+  void method##Handler(DispatcherCall<method##Request, method##Response>*   \
+                           call) {                                          \
+    pool_.Schedule([this, call]() {                                         \
+      call->SendResponse(                                                   \
+          ToGrpcStatus(impl_.method(&call->request, &call->response)));     \
+    });                                                                     \
+    ENQUEUE_REQUEST(method);                                                \
+  }
+
+  HANDLE_CALL(RegisterWorker);
+  HANDLE_CALL(WorkerHeartbeat);
+  HANDLE_CALL(GetOrRegisterDataset);
+  HANDLE_CALL(GetOrCreateJob);
+  HANDLE_CALL(GetTasks);
+  HANDLE_CALL(GetSplit);
+
+#undef HANDLE_CALL
+
+  DataServiceDispatcherImpl impl_;
+  // Destroyed before `impl_`, after waiting for the scheduled handlers.
+  thread::ThreadPool pool_;
+};
+
+#undef ENQUEUE_REQUEST
+
+class GrpcDataWorkerServer
+    : public GrpcDataServer<GrpcDataWorkerServer,
+                            grpc::DataWorkerService::AsyncService> {
+ public:
+  explicit GrpcDataWorkerServer(std::unique_ptr<DataServiceWorkerImpl> impl)
+      : impl_(std::move(impl)) {}
+
+  ~GrpcDataWorkerServer() override {
+    Stop();
+    // The handlers use `impl_`, so wait for them before destroying it.
+    mutex_lock l(handlers_mu_);
+    while (num_active_handlers_ > 0) {
+      handlers_cond_var_.wait(l);
+    }
+  }
+
+  Status Start(int port) { return StartServer(port, "tf_data_worker"); }
+
+  void Stop() override {
+    // Wakes up the handlers blocked in `GetElement()`, so that the gRPC
+    // server can shut down.
+    impl_->Stop();
+    GrpcDataServer::Stop();
+  }
+
+  // Registers the worker with the dispatcher.
+  Status Register(const string& worker_address) {
+    return impl_->Start(worker_address);
+  }
+
+  void EnqueueRequests() {
+    for (int i = 0; i < kQueueDepth; ++i) {
+      EnqueueGetElementRequest();
+    }
+  }
+
+ private:
+  static constexpr int kQueueDepth = 100;
+
+  void EnqueueGetElementRequest() {
+    EnqueueRequest<GetElementRequest, ::grpc::ByteBuffer>(
+        static_cast<int>(GrpcDataWorkerMethod::kGetElement),
+        &GrpcDataWorkerServer::GetElementHandler);
+  }
+
+  // Blocks until the element has been produced, so the handler runs on its
+  // own thread instead of a fixed-size pool.
+  void GetElementHandler(
+      Call<GrpcDataWorkerServer, grpc::DataWorkerService::AsyncService,
+           GetElementRequest, ::grpc::ByteBuffer>* call) {
+    {
+      mutex_lock l(handlers_mu_);
+      ++num_active_handlers_;
+    }
+    Env::Default()->SchedClosure([this, call]() {
+      std::vector<Tensor> components;
+      bool end_of_sequence = false;
+      Status s =
+          impl_->GetElement(&call->request, &components, &end_of_sequence);
+      if (s.ok()) {
+        s = EncodeElementToByteBuffer(components, end_of_sequence,
+                                      &call->response);
+      }
+      call->SendResponse(ToGrpcStatus(s));
+      mutex_lock l(handlers_mu_);
+      if (--num_active_handlers_ == 0) {
+        handlers_cond_var_.notify_all();
+      }
+    });
+    EnqueueGetElementRequest();
+  }
+
+  const std::unique_ptr<DataServiceWorkerImpl> impl_;
+
+  mutex handlers_mu_;
+  condition_variable handlers_cond_var_;
+  int64 num_active_handlers_ GUARDED_BY(handlers_mu_) = 0;
+};
+
+}  // namespace
+
+Status NewGrpcDispatcherServer(int port,
+                               std::unique_ptr<DataServiceServer>* server) {
+  auto dispatcher = absl::make_unique<GrpcDispatcherServer>();
+  TF_RETURN_IF_ERROR(dispatcher->Start(port));
+  LOG(INFO) << "Started tf.data service dispatcher on port "
+            << dispatcher->bound_port();
+  *server = std::move(dispatcher);
+  return Status::OK();
+}
+
+Status NewGrpcDataWorkerServer(const GrpcDataWorkerServerOptions& options,
+                               std::unique_ptr<DataServiceServer>* server) {
+  std::unique_ptr<DispatcherClient> dispatcher;
+  TF_RETURN_IF_ERROR(
+      NewGrpcDispatcherClient(options.dispatcher_address, &dispatcher));
+  auto worker = absl::make_unique<GrpcDataWorkerServer>(
+      absl::make_unique<DataServiceWorkerImpl>(std::move(dispatcher),
+                                               options.heartbeat_interval_ms,
+                                               options.buffer_size));
+  TF_RETURN_IF_ERROR(worker->Start(options.port));
+  string worker_address = options.worker_address;
+  if (worker_address.empty()) {
+    worker_address = strings::StrCat(port::Hostname(), ":",
+                                     worker->bound_port());
+  }
+  TF_RETURN_IF_ERROR(worker->Register(worker_address));
+  *server = std::move(worker);
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
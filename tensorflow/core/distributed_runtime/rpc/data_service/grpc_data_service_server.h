@@ -0,0 +1,69 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_SERVER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_SERVER_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// A running tf.data service dispatcher or worker server. The server is
+// stopped when it is destroyed.
+class DataServiceServer {
+ public:
+  virtual ~DataServiceServer() {}
+
+  // The port that the server listens on.
+  virtual int bound_port() const = 0;
+
+  // Stops serving requests. Blocks until the in-flight requests have been
+  // answered.
+  virtual void Stop() = 0;
+
+  // Blocks until `Stop()` has been called.
+  virtual void Join() = 0;
+};
+
+// Starts a dispatcher server on `port`. If `port` is 0, an unused port is
+// picked.
+Status NewGrpcDispatcherServer(int port,
+                               std::unique_ptr<DataServiceServer>* server);
+
+struct GrpcDataWorkerServerOptions {
+  // The port to listen on. If 0, an unused port is picked.
+  int port = 0;
+  // The address of the dispatcher, as "host:port".
+  string dispatcher_address;
+  // The address at which consumers reach this worker. Defaults to the
+  // hostname of the machine and the bound port.
+  string worker_address;
+  // The number of elements each task prefetches ahead of its consumers.
+  int64 buffer_size = 16;
+  int64 heartbeat_interval_ms = 100;
+};
+
+// Starts a worker server, and registers it with the dispatcher.
+Status NewGrpcDataWorkerServer(const GrpcDataWorkerServerOptions& options,
+                               std::unique_ptr<DataServiceServer>* server);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_SERVICE_GRPC_DATA_SERVICE_SERVER_H_
@@ -0,0 +1,59 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <iostream>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_server.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+// This binary starts a tf.data service dispatcher, or a tf.data service worker
+// if --dispatcher_address is set.
+int main(int argc, char* argv[]) {
+  int port = 0;
+  tensorflow::string dispatcher_address;
+  tensorflow::string worker_address;
+  tensorflow::int64 buffer_size = 16;
+  std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("port", &port, "port to listen on"),
+      tensorflow::Flag("dispatcher_address", &dispatcher_address,
+                       "host:port of the dispatcher; if set, starts a worker"),
+      tensorflow::Flag("worker_address", &worker_address,
+                       "host:port at which consumers reach this worker"),
+      tensorflow::Flag("buffer_size", &buffer_size,
+                       "number of elements each task prefetches"),
+  };
+  tensorflow::string usage = tensorflow::Flags::Usage(argv[0], flag_list);
+  const bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (!parse_result || argc != 1) {
+    std::cerr << usage << std::endl;
+    return -1;
+  }
+  std::unique_ptr<tensorflow::data::DataServiceServer> server;
+  if (dispatcher_address.empty()) {
+    TF_QCHECK_OK(tensorflow::data::NewGrpcDispatcherServer(port, &server));
+  } else {
+    tensorflow::data::GrpcDataWorkerServerOptions options;
+    options.port = port;
+    options.dispatcher_address = dispatcher_address;
+    options.worker_address = worker_address;
+    options.buffer_size = buffer_size;
+    TF_QCHECK_OK(tensorflow::data::NewGrpcDataWorkerServer(options, &server));
+  }
+  server->Join();
+}
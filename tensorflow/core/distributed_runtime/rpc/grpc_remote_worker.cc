@@ -67,6 +67,7 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        recvtensors_(Method(GrpcWorkerMethod::kRecvTensors)),
         logger_(logger) {}
 
   ~GrpcRemoteWorker() override {}
@@ -253,6 +254,40 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, recvtensor_, callback, call_opts);
   }
 
+  void RecvTensorsAsync(CallOptions* call_opts,
+                        const RecvTensorsRequest* request,
+                        std::vector<TensorResponse*>* responses,
+                        StatusCallback done) override {
+    VLOG(1) << "RecvTensorsAsync req: " << request->DebugString();
+    // The tensors are expected to be small, so unlike RecvTensorAsync() the
+    // response is parsed as a regular protocol buffer and then copied.
+    RecvTensorsResponse* proto = new RecvTensorsResponse;
+    auto callback = [this, request, responses, proto, done](Status s) {
+      if (s.ok() &&
+          static_cast<size_t>(proto->response_size()) != responses->size()) {
+        s = errors::Internal("Expected ", responses->size(),
+                             " responses from RecvTensors, got ",
+                             proto->response_size());
+      }
+      if (s.ok()) {
+        for (int i = 0; i < proto->response_size(); ++i) {
+          RecvTensorResponse* response = proto->mutable_response(i);
+          const bool require_ack = response->require_ack();
+          s.Update((*responses)[i]->InitFrom(response));
+          if (require_ack) {
+            IssueMarkRecvFinishedRequest(request->request(i).request_id());
+          }
+        }
+      }
+      delete proto;
+      // Note done() can delete this worker object, so we need to call done()
+      // last.
+      done(s);
+    };
+
+    IssueRequest(request, proto, recvtensors_, callback, call_opts);
+  }
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override {
     IssueRequest(request, response, logging_, done);
@@ -317,6 +352,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string recvtensors_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
@@ -203,8 +203,12 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
   master_service_ = NewGrpcMasterService(master_impl_.get(), config, &builder);
   worker_impl_ = opts.worker_func ? opts.worker_func(&worker_env_, config)
                                   : NewGrpcWorker(&worker_env_, config);
+  GrpcWorkerServiceOptions worker_service_options =
+      opts.worker_service_options;
+  TF_RETURN_IF_ERROR(UpdateGrpcWorkerServiceOptions(config.rpc_options(),
+                                                    &worker_service_options));
   worker_service_ = NewGrpcWorkerService(worker_impl_.get(), &builder,
-                                         opts.worker_service_options)
+                                         worker_service_options)
                         .release();
   eager_service_ = new eager::GrpcEagerServiceImpl(&worker_env_, &builder);
 
@@ -16,11 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_STATE_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_STATE_H_
 
+#include <algorithm>
 #include <queue>
 #include <utility>
 
 #include "grpcpp/generic/generic_stub.h"
 #include "grpcpp/grpcpp.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
@@ -31,9 +33,16 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace tensorflow {
 
+// Returns the time the server started to send `response`, or 0 if unknown.
+inline int64 SendStartMicros(const protobuf::Message& response) { return 0; }
+inline int64 SendStartMicros(const TensorResponse& response) {
+  return response.metadata().send_start_micros();
+}
+
 // Object allocated per active RPC.
 // Manage the state of a single asynchronous RPC request.  If `max_retries`
 // is greater than 0, the request will be retried for any transient failures
@@ -66,7 +75,19 @@ class RPCState : public GrpcClientCQTag {
         method_(method),
         fail_fast_(fail_fast) {
     response_ = response;
-    ::grpc::Status s = GrpcMaybeUnparseProto(request, &request_buf_);
+    const uint64 serialization_start_micros = Env::Default()->NowMicros();
+    ::grpc::Status s;
+    {
+      profiler::TraceMe activity(
+          [this] {
+            return strings::StrCat("RpcSerialize#method=", method_, "#");
+          },
+          profiler::TraceMeLevel::kInfo);
+      s = GrpcMaybeUnparseProto(request, &request_buf_);
+    }
+    metrics::RecordRpcPhase(
+        method_, "client_serialization",
+        Env::Default()->NowMicros() - serialization_start_micros);
     if (!s.ok()) {
       LOG(ERROR) << "GrpcMaybeUnparseProto returned with non-ok status: "
                  << s.error_message();
@@ -91,6 +112,7 @@ class RPCState : public GrpcClientCQTag {
     }
 
     VLOG(2) << "Starting call: " << method_;
+    start_micros_ = Env::Default()->NowMicros();
 
     call_ = std::move(
         stub_->PrepareUnaryCall(context_.get(), method_, request_buf_, cq_));
@@ -104,6 +126,9 @@ class RPCState : public GrpcClientCQTag {
     }
 
     VLOG(2) << "Completed call: " << method_;
+    completed_micros_ = Env::Default()->NowMicros();
+    metrics::RecordRpcPhase(method_, "client_latency",
+                            completed_micros_ - start_micros_);
 
     Status s = FromGrpcStatus(status_);
     if (s.ok() && !ok) {
@@ -152,9 +177,29 @@ class RPCState : public GrpcClientCQTag {
   }
 
   void ParseAndCallDone() {
+    const uint64 decode_start_micros = Env::Default()->NowMicros();
+    metrics::RecordRpcPhase(method_, "client_callback_queueing",
+                            decode_start_micros - completed_micros_);
     Status s;
-    if (!GrpcMaybeParseProto(&response_buf_, response_)) {
-      s.Update(errors::Internal("could not parse rpc response"));
+    {
+      profiler::TraceMe activity(
+          [this] { return strings::StrCat("RpcDecode#method=", method_, "#"); },
+          profiler::TraceMeLevel::kInfo);
+      if (!GrpcMaybeParseProto(&response_buf_, response_)) {
+        s.Update(errors::Internal("could not parse rpc response"));
+      }
+    }
+    metrics::RecordRpcPhase(method_, "client_decode",
+                            Env::Default()->NowMicros() - decode_start_micros);
+    const int64 send_start_micros = SendStartMicros(*response_);
+    if (s.ok() && send_start_micros > 0) {
+      // Respect causality despite clock skew: the response was sent after the
+      // request, and before it was received.
+      const int64 transfer_start_micros =
+          std::min(std::max(send_start_micros, start_micros_),
+                   completed_micros_);
+      metrics::RecordRpcPhase(method_, "response_transfer",
+                              completed_micros_ - transfer_start_micros);
     }
     done_(s);
     delete this;
@@ -175,6 +220,10 @@ class RPCState : public GrpcClientCQTag {
   size_t num_retries_ = 0;
   size_t max_retries_;
 
+  // The start of the current attempt and its completion.
+  int64 start_micros_ = 0;
+  int64 completed_micros_ = 0;
+
   ::grpc::CompletionQueue* cq_;
   ::grpc::GenericStub* stub_;
   ::grpc::string method_;
@@ -21,9 +21,11 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/io/proto_encode_helper.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 // (Omitted internal-only flag)
@@ -144,14 +146,37 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
   response.set_require_ack(require_ack);
   response.set_send_start_micros(Env::Default()->NowMicros());
-  if (!DataTypeCanUseMemcpy(val.dtype())) {
-    // Straightforward but slow path for complicated kinds of tensor data
-    // TODO(jeff,sanjay): If this becomes an issue, we could
-    // go directly from val -> ByteBuffer, with some effort.
+  if (!tensor::CanSerializeTensorProtoContent(val.dtype())) {
+    // Straightforward but slow path for complicated kinds of tensor data,
+    // e.g. variants and resources, which are encoded through a TensorProto.
     val.AsProtoTensorContent(response.mutable_tensor());
 
     // Encode full protocol buffer to a ByteBuffer
     EncodeRecvTensorResponseToByteBuffer(response, result);
+  } else if (!DataTypeCanUseMemcpy(val.dtype())) {
+    // Encode the response into a single grpc::Slice, with the strings of
+    // "val" written straight into it.
+    string header;  // All of RecvTensorResponse except the tensor() field
+    response.AppendToString(&header);
+    const size_t tensor_bytes = tensor::TensorProtoContentByteSize(val);
+    ::grpc::Slice slice(header.size() +
+                        VarLengthEncodingSize(
+                            RecvTensorResponse::kTensorFieldNumber,
+                            tensor_bytes));
+    {
+      protobuf::io::ArrayOutputStream stream(
+          const_cast<uint8_t*>(slice.begin()), slice.size());
+      protobuf::io::CodedOutputStream out(&stream);
+      out.WriteRaw(header.data(), header.size());
+      out.WriteTag((RecvTensorResponse::kTensorFieldNumber << 3) |
+                   2 /* length delimited */);
+      out.WriteVarint64(tensor_bytes);
+      tensor::SerializeTensorProtoContent(val, &out);
+      CHECK(!out.HadError());
+      CHECK_EQ(static_cast<size_t>(out.ByteCount()), slice.size());
+    }
+    ::grpc::ByteBuffer tmp(&slice, 1);
+    result->Swap(&tmp);
   } else {
     // skeleton is the encoded TensorProto contents (dtype and shape), but
     // not the actual data
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/lib/random/random.h"
 
 namespace tensorflow {
@@ -31,8 +32,45 @@ double GenerateUniformRandomNumberBetween(double a, double b) {
   return a + GenerateUniformRandomNumber() * (b - a);
 }
 
+// A TensorBuffer over a range of a received gRPC slice, which it keeps alive.
+class GrpcSliceBuffer : public TensorBuffer {
+ public:
+  GrpcSliceBuffer(const ::grpc::Slice& slice, size_t offset, size_t size)
+      : TensorBuffer(const_cast<uint8*>(slice.begin() + offset)),
+        slice_(slice),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("grpc_slice");
+  }
+  // The slice may be shared with other readers of the received message.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const ::grpc::Slice slice_;
+  const size_t size_;
+};
+
 }  // namespace
 
+TensorBuffer* GrpcByteSource::AliasContents(int64 offset, size_t num_bytes) {
+  std::vector<::grpc::Slice> slices;
+  if (!buffer_->Dump(&slices).ok()) {
+    return nullptr;
+  }
+  for (const ::grpc::Slice& slice : slices) {
+    if (static_cast<uint64>(offset) < slice.size()) {
+      if (offset + num_bytes > slice.size()) return nullptr;
+      return new GrpcSliceBuffer(slice, offset, num_bytes);
+    }
+    offset -= slice.size();
+  }
+  return nullptr;
+}
+
 int64 ComputeBackoffMicroseconds(int current_retry_attempt, int64 min_delay,
                                  int64 max_delay) {
   DCHECK_GE(current_retry_attempt, 0);
@@ -53,6 +53,9 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Aliases the bytes if they lie within a single slice of the buffer.
+  TensorBuffer* AliasContents(int64 offset, size_t num_bytes) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
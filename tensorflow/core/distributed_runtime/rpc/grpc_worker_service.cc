@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <unordered_map>
@@ -23,12 +24,14 @@ limitations under the License.
 #include "grpcpp/alarm.h"
 #include "grpcpp/server_builder.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
@@ -45,14 +48,18 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
@@ -94,15 +101,19 @@ namespace {
   }
 
 // GrpcWorkerService spawns one or more GrpcWorkerServiceThreads to service
-// requests.  Each thread operates on an independent completion queue.
+// requests.  Each one operates on an independent completion queue, which is
+// polled by one or more threads.
 class GrpcWorkerServiceThread {
  public:
   explicit GrpcWorkerServiceThread(
       GrpcWorker* worker, ::grpc::ServerBuilder* builder,
-      std::unordered_map<int, int> queue_depth, GrpcResponseCache* cache,
+      std::unordered_map<int, int> queue_depth, int num_threads,
+      thread::ThreadPool* recv_tensor_pool, GrpcResponseCache* cache,
       grpc::WorkerService::AsyncService* worker_service)
       : worker_(worker),
         queue_depth_(queue_depth),
+        num_threads_(num_threads),
+        recv_tensor_pool_(recv_tensor_pool),
         cache_(cache),
         worker_service_(worker_service),
         is_shutdown_(false) {
@@ -110,12 +121,15 @@ class GrpcWorkerServiceThread {
   }
 
   void Start() {
-    thread_.reset(
-        worker_->env()->env->StartThread(ThreadOptions(), "grpc_worker_service",
-                                         [this]() { HandleRPCsLoop(); }));
+    EnqueueInitialRequests();
+    for (int i = 0; i < num_threads_; ++i) {
+      threads_.emplace_back(worker_->env()->env->StartThread(
+          ThreadOptions(), "grpc_worker_service",
+          [this]() { HandleRPCsLoop(); }));
+    }
   }
 
-  void Join() { thread_.reset(); }  // Blocks until thread exits
+  void Join() { threads_.clear(); }  // Blocks until the threads exit
 
   void Shutdown() {
     {
@@ -126,12 +140,8 @@ class GrpcWorkerServiceThread {
   }
 
  private:
-  // Add one or more completion queue entries for each worker method, then
-  // begin servicing requests from the completion queue.
-  void HandleRPCsLoop() {
-    // TODO(ncteisen): This may require performance engineering. We can
-    // change the number of threads, the number of handlers per thread,
-    // or even decide to specialize certain threads to certain methods.
+  // Add one or more completion queue entries for each worker method.
+  void EnqueueInitialRequests() {
     SETUP_FOR_REQUEST(GetStatus, 1, false);
     SETUP_FOR_REQUEST(CreateWorkerSession, 1, false);
     SETUP_FOR_REQUEST(DeleteWorkerSession, 1, false);
@@ -157,7 +167,17 @@ class GrpcWorkerServiceThread {
          ++i) {
       EnqueueRecvTensorRequestRaw();
     }
+    for (int i = 0;
+         i < gtl::FindWithDefault(
+                 queue_depth_,
+                 static_cast<int>(GrpcWorkerMethod::kRecvTensors), 100);
+         ++i) {
+      EnqueueRecvTensorsRequestRaw();
+    }
+  }
 
+  // Services requests from the completion queue until it is shut down.
+  void HandleRPCsLoop() {
     void* tag;
     bool ok;
 
@@ -174,6 +194,15 @@ class GrpcWorkerServiceThread {
     worker_->env()->compute_pool->Schedule(std::move(f));
   }
 
+  // Schedules the handling of a request that mostly encodes tensors.
+  void ScheduleRecv(std::function<void()> f) {
+    if (recv_tensor_pool_ != nullptr) {
+      recv_tensor_pool_->Schedule(std::move(f));
+    } else {
+      Schedule(std::move(f));
+    }
+  }
+
   // The following section contains one request handler method per
   // RPC. The `FooHandler` method is called (indirectly) by
   // `HandleRPCsLoop()` when the next Foo RPC is received. Each
@@ -265,13 +294,22 @@ class GrpcWorkerServiceThread {
 
   void RecvTensorHandlerRaw(
       WorkerCall<RecvTensorRequest, ::grpc::ByteBuffer>* call) {
-    Schedule([this, call]() {
+    const uint64 arrival_micros = Env::Default()->NowMicros();
+    ScheduleRecv([this, call, arrival_micros]() {
+      static const string* method =
+          new string(GrpcWorkerMethodName(GrpcWorkerMethod::kRecvTensor));
+      const uint64 start_micros = Env::Default()->NowMicros();
+      metrics::RecordRpcPhase(*method, "server_queueing",
+                              start_micros - arrival_micros);
       CallOptions* call_opts = new CallOptions;
       call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
 
       worker_->GrpcRecvTensorAsync(
           call_opts, &call->request, &call->response,
-          [call, call_opts](const Status& s) {
+          [call, call_opts, start_micros](const Status& s) {
+            metrics::RecordRpcPhase(
+                *method, "server_handling",
+                Env::Default()->NowMicros() - start_micros);
             call->ClearCancelCallback();
             delete call_opts;
             if (!s.ok()) {
@@ -283,8 +321,28 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorsHandlerRaw(
+      WorkerCall<RecvTensorsRequest, ::grpc::ByteBuffer>* call) {
+    ScheduleRecv([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+
+      worker_->GrpcRecvTensorsAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(1) << "Bad response from RecvTensors:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    EnqueueRecvTensorsRequestRaw();
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
-    Schedule([this, call]() {
+    ScheduleRecv([this, call]() {
       CallOptions* call_opts = new CallOptions;
       call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
       worker_->RecvBufAsync(call_opts, &call->request, &call->response,
@@ -352,10 +410,25 @@ class GrpcWorkerServiceThread {
     }
   }
 
+  void EnqueueRecvTensorsRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
+           RecvTensorsRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kRecvTensors),
+              &GrpcWorkerServiceThread::RecvTensorsHandlerRaw,
+              true /* supports cancel*/);
+    }
+  }
+
   GrpcWorker* const worker_ = nullptr;  // Not owned.
   std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
-  std::unique_ptr<Thread> thread_;
+  std::vector<std::unique_ptr<Thread>> threads_;
   std::unordered_map<int, int> queue_depth_;
+  const int num_threads_;
+  thread::ThreadPool* const recv_tensor_pool_;  // Not owned, may be null.
   GrpcResponseCache* cache_;
   grpc::WorkerService::AsyncService* const worker_service_;
 
@@ -371,10 +444,16 @@ class GrpcWorkerService : public AsyncServiceInterface {
       : is_shutdown_(false) {
     builder->RegisterService(&worker_service_);
 
+    if (options.num_recv_tensor_threads > 0) {
+      recv_tensor_pool_.reset(new thread::ThreadPool(
+          worker->env()->env, "grpc_worker_recv_tensor",
+          options.num_recv_tensor_threads));
+    }
     for (int i = 0; i < options.num_serving_threads; i++) {
-      threads_.emplace_back(
-          new GrpcWorkerServiceThread(worker, builder, options.queue_depth,
-                                      cache_.get(), &worker_service_));
+      threads_.emplace_back(new GrpcWorkerServiceThread(
+          worker, builder, options.queue_depth,
+          std::max(options.num_threads_per_cq, 1), recv_tensor_pool_.get(),
+          cache_.get(), &worker_service_));
     }
   }
 
@@ -408,6 +487,8 @@ class GrpcWorkerService : public AsyncServiceInterface {
  private:
   grpc::WorkerService::AsyncService worker_service_;
   std::vector<std::unique_ptr<GrpcWorkerServiceThread>> threads_;
+  // Destroyed before `threads_`, so that its pending handlers can finish.
+  std::unique_ptr<thread::ThreadPool> recv_tensor_pool_;
 
   std::unique_ptr<GrpcResponseCache> cache_;
   mutex service_shutdown_mu_;
@@ -451,7 +532,21 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                                                      bool is_dead,
                                                      const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      const uint64 start_micros = Env::Default()->NowMicros();
+      {
+        profiler::TraceMe activity(
+            [&tensor] {
+              return strings::StrCat("RecvTensorEncode#bytes=",
+                                     tensor.TotalBytes(), "#");
+            },
+            profiler::TraceMeLevel::kInfo);
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+      }
+      static const string* method =
+          new string(GrpcWorkerMethodName(GrpcWorkerMethod::kRecvTensor));
+      metrics::RecordRpcPhase(*method, "server_tensor_encode",
+                              Env::Default()->NowMicros() - start_micros);
     }
     done(status);
   };
@@ -555,6 +650,79 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
       });
 }
 
+void GrpcWorker::GrpcRecvTensorsAsync(CallOptions* opts,
+                                      const RecvTensorsRequest* request,
+                                      ::grpc::ByteBuffer* response,
+                                      StatusCallback done) {
+  VLOG(1) << "GrpcRecvTensorsAsync req: " << request->DebugString();
+  const int num_requests = request->request_size();
+  if (num_requests == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  // Each request is served by GrpcRecvTensorAsync() into its own buffer; the
+  // buffers are then concatenated into one RecvTensorsResponse.
+  struct State {
+    explicit State(int n) : opts(n), buffers(n), pending(n) {}
+    std::vector<CallOptions> opts;
+    std::vector<::grpc::ByteBuffer> buffers;
+    mutex mu;
+    Status status GUARDED_BY(mu);
+    int pending GUARDED_BY(mu);
+  };
+  State* state = new State(num_requests);
+  opts->SetCancelCallback([state]() {
+    for (CallOptions& opts : state->opts) opts.StartCancel();
+  });
+
+  auto finish = [opts, state, response, done]() {
+    opts->ClearCancelCallback();
+    Status s;
+    {
+      mutex_lock l(state->mu);
+      s = state->status;
+    }
+    std::vector<::grpc::Slice> slices;
+    for (int i = 0; s.ok() && i < state->buffers.size(); ++i) {
+      const ::grpc::ByteBuffer& buffer = state->buffers[i];
+      std::vector<::grpc::Slice> buffer_slices;
+      if (!buffer.Dump(&buffer_slices).ok()) {
+        s = errors::Internal("Could not read the response to ",
+                             "RecvTensor request ", i);
+        break;
+      }
+      // The tag and length of the i-th RecvTensorsResponse.response field.
+      string header;
+      core::PutVarint32(&header,
+                        (RecvTensorsResponse::kResponseFieldNumber << 3) |
+                            2 /* WIRETYPE_LENGTH_DELIMITED */);
+      core::PutVarint64(&header, buffer.Length());
+      slices.emplace_back(header.data(), header.size());
+      slices.insert(slices.end(), buffer_slices.begin(), buffer_slices.end());
+    }
+    if (s.ok()) {
+      ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+      response->Swap(&tmp);
+    }
+    delete state;
+    done(s);
+  };
+
+  for (int i = 0; i < num_requests; ++i) {
+    GrpcRecvTensorAsync(&state->opts[i], &request->request(i),
+                        &state->buffers[i], [state, finish](const Status& s) {
+                          bool last;
+                          {
+                            mutex_lock l(state->mu);
+                            state->status.Update(s);
+                            last = --state->pending == 0;
+                          }
+                          if (last) finish();
+                        });
+  }
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
@@ -747,6 +915,38 @@ std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env,
   return std::unique_ptr<GrpcWorker>(new GrpcWorker(env, config));
 }
 
+Status UpdateGrpcWorkerServiceOptions(const RPCOptions& rpc_options,
+                                      GrpcWorkerServiceOptions* options) {
+  if (rpc_options.num_completion_queues() > 0) {
+    options->num_serving_threads = rpc_options.num_completion_queues();
+  }
+  if (rpc_options.num_threads_per_completion_queue() > 0) {
+    options->num_threads_per_cq =
+        rpc_options.num_threads_per_completion_queue();
+  }
+  if (rpc_options.num_recv_tensor_threads() > 0) {
+    options->num_recv_tensor_threads = rpc_options.num_recv_tensor_threads();
+  }
+  for (const auto& entry : rpc_options.worker_method_queue_depth()) {
+    int method = 0;
+    for (; method < kGrpcNumWorkerMethods; ++method) {
+      StringPiece name =
+          GrpcWorkerMethodName(static_cast<GrpcWorkerMethod>(method));
+      if (absl::EndsWith(name, strings::StrCat("/", entry.first))) break;
+    }
+    if (method == kGrpcNumWorkerMethods) {
+      return errors::InvalidArgument("Unknown worker service method \"",
+                                     entry.first, "\" in RPCOptions");
+    }
+    if (entry.second <= 0) {
+      return errors::InvalidArgument("The queue depth of ", entry.first,
+                                     " must be positive, got ", entry.second);
+    }
+    options->queue_depth[method] = entry.second;
+  }
+  return Status::OK();
+}
+
 std::unique_ptr<AsyncServiceInterface> NewGrpcWorkerService(
     GrpcWorker* worker, ::grpc::ServerBuilder* builder,
     GrpcWorkerServiceOptions options) {
@@ -32,6 +32,7 @@ namespace tensorflow {
 
 class AsyncServiceInterface;
 class ConfigProto;
+class RPCOptions;
 struct WorkerEnv;
 struct WorkerSession;
 class GrpcResponseCache;
@@ -46,6 +47,13 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  // Handles a batch of RecvTensor requests, writing a serialized
+  // RecvTensorsResponse into "*response" without re-encoding the tensors.
+  virtual void GrpcRecvTensorsAsync(CallOptions* opts,
+                                    const RecvTensorsRequest* request,
+                                    ::grpc::ByteBuffer* response,
+                                    StatusCallback done);
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -74,9 +82,19 @@ struct GrpcWorkerServiceOptions {
   // Map from GrpcWorkerMethod id to queue depth.  If set this overrides the
   // default queue depth for a method.
   std::unordered_map<int, int> queue_depth;
+  // The number of completion queues.
   int num_serving_threads = 8;
+  // The number of threads polling each completion queue.
+  int num_threads_per_cq = 1;
+  // If positive, the size of a separate pool for the RecvTensor, RecvTensors
+  // and RecvBuf handlers. Otherwise they run on the worker's compute pool.
+  int num_recv_tensor_threads = 0;
 };
 
+// Overrides the fields of `options` that are set in `rpc_options`.
+Status UpdateGrpcWorkerServiceOptions(const RPCOptions& rpc_options,
+                                      GrpcWorkerServiceOptions* options);
+
 // Returns an implementation of WorkerService rpc service.
 std::unique_ptr<AsyncServiceInterface> NewGrpcWorkerService(
     GrpcWorker* worker, ::grpc::ServerBuilder* builder,
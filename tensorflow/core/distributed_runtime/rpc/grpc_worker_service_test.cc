@@ -0,0 +1,144 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/tensorflow_server.pb.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(UpdateGrpcWorkerServiceOptionsTest, OverridesTheSetFields) {
+  GrpcWorkerServiceOptions options;
+  options.queue_depth[static_cast<int>(GrpcWorkerMethod::kRunGraph)] = 3;
+  RPCOptions rpc_options;
+  rpc_options.set_num_threads_per_completion_queue(4);
+  (*rpc_options.mutable_worker_method_queue_depth())["RecvTensor"] = 100;
+  TF_ASSERT_OK(UpdateGrpcWorkerServiceOptions(rpc_options, &options));
+
+  EXPECT_EQ(8, options.num_serving_threads);
+  EXPECT_EQ(4, options.num_threads_per_cq);
+  EXPECT_EQ(0, options.num_recv_tensor_threads);
+  EXPECT_EQ(2, options.queue_depth.size());
+  EXPECT_EQ(3,
+            options.queue_depth[static_cast<int>(GrpcWorkerMethod::kRunGraph)]);
+  EXPECT_EQ(
+      100,
+      options.queue_depth[static_cast<int>(GrpcWorkerMethod::kRecvTensor)]);
+}
+
+TEST(UpdateGrpcWorkerServiceOptionsTest, UnknownMethod) {
+  GrpcWorkerServiceOptions options;
+  RPCOptions rpc_options;
+  (*rpc_options.mutable_worker_method_queue_depth())["RecvTensorz"] = 100;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      UpdateGrpcWorkerServiceOptions(rpc_options, &options)));
+}
+
+TEST(UpdateGrpcWorkerServiceOptionsTest, NonPositiveDepth) {
+  for (const int depth : {0, -1}) {
+    GrpcWorkerServiceOptions options;
+    RPCOptions rpc_options;
+    (*rpc_options.mutable_worker_method_queue_depth())["RunGraph"] = depth;
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        UpdateGrpcWorkerServiceOptions(rpc_options, &options)))
+        << depth;
+  }
+}
+
+// Runs steps that send tensors between two workers, from several client
+// threads at once, with several threads polling each completion queue and a
+// separate pool for the RecvTensor handlers.
+TEST(GrpcWorkerServiceTest, MultiThreadedCompletionQueues) {
+  constexpr int kNumTasks = 2;
+  std::vector<int> ports;
+  for (int i = 0; i < kNumTasks; ++i) {
+    ports.push_back(testing::PickUnusedPortOrDie());
+  }
+  for (int i = 0; i < kNumTasks; ++i) {
+    ServerDef server_def;
+    server_def.set_protocol("grpc");
+    server_def.set_job_name("worker");
+    server_def.set_task_index(i);
+    auto* job_def = server_def.mutable_cluster()->add_job();
+    job_def->set_name("worker");
+    for (int j = 0; j < kNumTasks; ++j) {
+      (*job_def->mutable_tasks())[j] = strings::StrCat("localhost:", ports[j]);
+    }
+    RPCOptions* rpc_options =
+        server_def.mutable_default_session_config()->mutable_rpc_options();
+    rpc_options->set_num_completion_queues(2);
+    rpc_options->set_num_threads_per_completion_queue(4);
+    rpc_options->set_num_recv_tensor_threads(2);
+    (*rpc_options->mutable_worker_method_queue_depth())["RecvTensor"] = 4;
+
+    std::unique_ptr<ServerInterface> server;
+    TF_ASSERT_OK(NewServer(server_def, &server));
+    TF_ASSERT_OK(server->Start());
+    // A started server cannot be shut down cleanly, so it is never deleted.
+    server.release();
+  }
+
+  // The square is computed on task 1 and sent to task 0.
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Placeholder(
+      root.WithOpName("x").WithDevice("/job:worker/task:1/cpu:0"), DT_FLOAT);
+  auto square = ops::Square(root.WithDevice("/job:worker/task:1/cpu:0"), x);
+  ops::Add(root.WithOpName("sum").WithDevice("/job:worker/task:0/cpu:0"),
+           square, x);
+  GraphDef graph_def;
+  TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+
+  SessionOptions session_options;
+  session_options.target = strings::StrCat("grpc://localhost:", ports[0]);
+  std::unique_ptr<Session> session(NewSession(session_options));
+  ASSERT_NE(nullptr, session);
+  TF_ASSERT_OK(session->Create(graph_def));
+
+  {
+    thread::ThreadPool clients(Env::Default(), "clients", 8);
+    for (int i = 0; i < 8; ++i) {
+      clients.Schedule([&session, i]() {
+        for (int step = 0; step < 20; ++step) {
+          const float value = i * 100 + step;
+          Tensor x(value);
+          std::vector<Tensor> outputs;
+          TF_ASSERT_OK(session->Run({{"x", x}}, {"sum:0"}, {}, &outputs));
+          ASSERT_EQ(1, outputs.size());
+          EXPECT_EQ(value * value + value, outputs[0].scalar<float>()());
+        }
+      });
+    }
+  }
+  TF_ASSERT_OK(session->Close());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -32,11 +34,14 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+class RpcRecvTensorCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
   RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
@@ -50,6 +55,19 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Finishes "call" after its RecvTensor RPC has completed.
+  void OnCallDone(RpcRecvTensorCall* call);
+
+  // Fetches the tensors of "calls", which all come from the same worker, with
+  // a single RecvTensors RPC.
+  void StartBatch(std::vector<RpcRecvTensorCall*> calls);
+  void FlushBatch(const string& src_worker);
+
+  mutex batch_mu_;
+  // Calls waiting for the batching window to close, by source worker.
+  std::unordered_map<string, std::vector<RpcRecvTensorCall*>> pending_batches_
+      GUARDED_BY(batch_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -213,6 +231,50 @@ static RpcRecvTensorFreeList* get_call_freelist() {
   return call_freelist;
 }
 
+// The largest number of tensors fetched by one RecvTensors RPC.
+const size_t kMaxRecvTensorsBatchSize = 128;
+
+// Returns how long a RecvTensor call waits for other calls to the same worker
+// before they are all sent as one RecvTensors RPC. Batching is disabled when
+// the window is zero, which is the default.
+static int64 RecvTensorBatchWindowMicros() {
+  static const int64 window_micros = []() {
+    int64 micros;
+    Status s = ReadInt64FromEnvVar("TF_RECV_TENSOR_BATCH_WINDOW_MICROS", 0,
+                                   &micros);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return int64{0};
+    }
+    return micros;
+  }();
+  return window_micros;
+}
+
+// Tracks the workers that do not implement RecvTensors, so that they are sent
+// one RecvTensor RPC per tensor without first trying a batch.
+class UnbatchedWorkers {
+ public:
+  bool Contains(const string& worker) {
+    mutex_lock l(mu_);
+    return workers_.count(worker) > 0;
+  }
+
+  void Insert(const string& worker) {
+    mutex_lock l(mu_);
+    workers_.insert(worker);
+  }
+
+ private:
+  mutex mu_;
+  std::unordered_set<string> workers_ GUARDED_BY(mu_);
+};
+
+static UnbatchedWorkers* get_unbatched_workers() {
+  static UnbatchedWorkers* workers = new UnbatchedWorkers();
+  return workers;
+}
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
@@ -270,20 +332,125 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   // Start "call".
   Ref();
-  call->Start([this, call]() {
-    // Removes "call" from active_. Prevent StartAbort().
-    DeregisterCall(call);
-    // If StartAbort was called prior to DeregisterCall, then the
-    // current status should be bad.
-    Status s = call->status();
-    // NOTE: `*session()` can potentially be deleted before we return from
-    // `call->done()(...)`, so we must release the worker before calling the
-    // callback.
-    call->ReleaseWorker(session()->worker_cache.get());
-    call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
-    get_call_freelist()->Release(call);
-    Unref();
-  });
+  const int64 window_micros = RecvTensorBatchWindowMicros();
+  if (window_micros <= 0 ||
+      get_unbatched_workers()->Contains(call->src_worker_)) {
+    call->Start([this, call]() { OnCallDone(call); });
+    return;
+  }
+
+  // Queue "call" until the batching window of its worker closes, or until
+  // the batch is full.
+  const string src_worker = call->src_worker_;
+  std::vector<RpcRecvTensorCall*> full_batch;
+  bool schedule_flush = false;
+  {
+    mutex_lock l(batch_mu_);
+    std::vector<RpcRecvTensorCall*>& batch = pending_batches_[src_worker];
+    schedule_flush = batch.empty();
+    batch.push_back(call);
+    if (batch.size() >= kMaxRecvTensorsBatchSize) {
+      full_batch.swap(batch);
+    }
+  }
+  if (schedule_flush) {
+    Ref();
+    env_->env->SchedClosureAfter(window_micros, [this, src_worker]() {
+      FlushBatch(src_worker);
+      Unref();
+    });
+  }
+  if (!full_batch.empty()) {
+    StartBatch(std::move(full_batch));
+  }
+}
+
+void RpcRemoteRendezvous::OnCallDone(RpcRecvTensorCall* call) {
+  // Removes "call" from active_. Prevent StartAbort().
+  DeregisterCall(call);
+  // If StartAbort was called prior to DeregisterCall, then the
+  // current status should be bad.
+  Status s = call->status();
+  // NOTE: `*session()` can potentially be deleted before we return from
+  // `call->done()(...)`, so we must release the worker before calling the
+  // callback.
+  call->ReleaseWorker(session()->worker_cache.get());
+  call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
+  get_call_freelist()->Release(call);
+  Unref();
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker) {
+  std::vector<RpcRecvTensorCall*> calls;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = pending_batches_.find(src_worker);
+    if (it == pending_batches_.end()) return;
+    calls.swap(it->second);
+    pending_batches_.erase(it);
+  }
+  if (!calls.empty()) {
+    StartBatch(std::move(calls));
+  }
+}
+
+void RpcRemoteRendezvous::StartBatch(std::vector<RpcRecvTensorCall*> calls) {
+  // Calls aborted while they were queued are finished right away.
+  std::vector<RpcRecvTensorCall*> live_calls;
+  for (RpcRecvTensorCall* call : calls) {
+    if (call->status().ok()) {
+      live_calls.push_back(call);
+    } else {
+      OnCallDone(call);
+    }
+  }
+  if (live_calls.empty()) return;
+  if (live_calls.size() == 1) {
+    RpcRecvTensorCall* call = live_calls[0];
+    call->Start([this, call]() { OnCallDone(call); });
+    return;
+  }
+
+  struct Batch {
+    CallOptions opts;
+    RecvTensorsRequest req;
+    std::vector<TensorResponse*> responses;
+    std::vector<RpcRecvTensorCall*> calls;
+  };
+  Batch* batch = new Batch;
+  batch->calls = std::move(live_calls);
+  for (RpcRecvTensorCall* call : batch->calls) {
+    *batch->req.add_request() = call->req_;
+    call->resp_.InitAlloc(call->dst_device_, call->alloc_attrs_);
+    batch->responses.push_back(&call->resp_);
+    // Aborting any call of the batch cancels the whole RPC.
+    call->opts_.SetCancelCallback([batch]() { batch->opts.StartCancel(); });
+  }
+
+  WorkerInterface* wi = batch->calls[0]->wi_;
+  wi->RecvTensorsAsync(
+      &batch->opts, &batch->req, &batch->responses,
+      [this, batch](const Status& s) {
+        for (RpcRecvTensorCall* call : batch->calls) {
+          call->opts_.ClearCancelCallback();
+        }
+        if (errors::IsUnimplemented(s)) {
+          // The source worker predates RecvTensors.
+          get_unbatched_workers()->Insert(batch->calls[0]->src_worker_);
+          for (RpcRecvTensorCall* call : batch->calls) {
+            call->Start([this, call]() { OnCallDone(call); });
+          }
+        } else {
+          for (RpcRecvTensorCall* call : batch->calls) {
+            if (!s.ok()) {
+              mutex_lock l(call->mu_);
+              call->status_.Update(s);
+            }
+            OnCallDone(call);
+          }
+        }
+        delete batch;
+      });
 }
 
 }  // namespace
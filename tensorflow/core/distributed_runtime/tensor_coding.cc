@@ -23,8 +23,17 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Tensor contents smaller than this are copied even if the Source could alias
+// them, since aliasing keeps the whole transport buffer alive.
+static const int kMinAliasedBytes = 4096;
+
 TensorResponse::Source::~Source() {}
 
+TensorBuffer* TensorResponse::Source::AliasContents(int64 offset,
+                                                    size_t num_bytes) {
+  return nullptr;
+}
+
 void TensorResponse::Clear() {
   on_host_ = false;
   device_ = nullptr;
@@ -145,7 +154,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    Source* source, protobuf::io::CodedInputStream* input,
+    TensorProto* tensor_meta) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -196,12 +206,27 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        if (num_bytes >= kMinAliasedBytes &&
+            static_cast<size_t>(num_bytes) ==
+                shape.num_elements() * DataTypeSize(tensor_meta->dtype()) &&
+            !alloc_attrs_.gpu_compatible() && !alloc_attrs_.nic_compatible()) {
+          // Wrap the received bytes if they are suitably aligned; the
+          // destination allocator does not matter for plain host memory.
+          TensorBuffer* alias =
+              source->AliasContents(input->CurrentPosition(), num_bytes);
+          if (alias != nullptr) {
+            Tensor t(tensor_meta->dtype(), shape, alias);
+            alias->Unref();
+            if (t.IsAligned()) {
+              if (!input->Skip(num_bytes)) return false;
+              tensor_ = std::move(t);
+              break;
+            }
+          }
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -235,7 +260,7 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(source, &input, meta_.mutable_tensor())) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -64,6 +64,15 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Returns a buffer that aliases the "num_bytes" bytes at "offset" in the
+    // serialized RecvTensorResponse, or nullptr if the Source cannot provide
+    // them without a copy, e.g. because they are not contiguous in memory.
+    // The caller owns a reference on the returned buffer, which keeps the
+    // bytes alive.
+    //
+    // The default implementation returns nullptr.
+    virtual TensorBuffer* AliasContents(int64 offset, size_t num_bytes);
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -92,7 +101,8 @@ class TensorResponse {
   DeviceBase* device() const { return device_; }
 
  private:
-  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
+  bool ParseTensorSubmessage(Source* source,
+                             protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
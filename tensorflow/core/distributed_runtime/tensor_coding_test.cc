@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -72,6 +74,53 @@ class StringSource : public TensorResponse::Source {
   int block_size_;
 };
 
+// A Source over an array, which aliases the requested contents.
+class AliasingSource : public TensorResponse::Source {
+ public:
+  AliasingSource(const char* data, size_t size)
+      : data_(data), size_(size), stream_(nullptr) {}
+  ~AliasingSource() override { DeleteStream(); }
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    DeleteStream();
+    stream_ = new (&space_) protobuf::io::ArrayInputStream(data_, size_);
+    return stream_;
+  }
+
+  TensorBuffer* AliasContents(int64 offset, size_t num_bytes) override {
+    ++num_aliased_;
+    return new Buffer(const_cast<char*>(data_) + offset, num_bytes);
+  }
+
+  int num_aliased() const { return num_aliased_; }
+
+ private:
+  class Buffer : public TensorBuffer {
+   public:
+    Buffer(char* data, size_t size) : TensorBuffer(data), size_(size) {}
+    size_t size() const override { return size_; }
+    TensorBuffer* root_buffer() override { return this; }
+    void FillAllocationDescription(
+        AllocationDescription* proto) const override {}
+    bool OwnsMemory() const override { return false; }
+
+   private:
+    const size_t size_;
+  };
+
+  void DeleteStream() {
+    if (stream_) {
+      stream_->~ArrayInputStream();
+    }
+  }
+
+  const char* data_;
+  const size_t size_;
+  protobuf::io::ArrayInputStream* stream_;
+  char space_[sizeof(protobuf::io::ArrayInputStream)];
+  int num_aliased_ = 0;
+};
+
 class TensorResponseTest : public ::testing::Test {
  public:
   void Validate(const Tensor& src, bool is_dead, bool use_tensor_content) {
@@ -156,6 +205,36 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, AliasesAlignedContents) {
+  Tensor src(DT_FLOAT, TensorShape({4096}));
+  test::FillIota<float>(&src, 0);
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  const string encoded = proto.SerializeAsString();
+  // The tensor contents end the encoding.
+  const size_t content_offset = encoded.size() - src.TotalBytes();
+
+  const size_t kAlign = EIGEN_MAX_ALIGN_BYTES;
+  char* memory = static_cast<char*>(
+      port::AlignedMalloc(encoded.size() + 2 * kAlign, kAlign));
+  for (int misalignment : {0, 4}) {
+    char* data =
+        memory + (kAlign - content_offset % kAlign) % kAlign + misalignment;
+    memcpy(data, encoded.data(), encoded.size());
+    AliasingSource source(data, encoded.size());
+    TensorResponse response;
+    DummyDevice cpu_device(Env::Default());
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_ASSERT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(1, source.num_aliased());
+    test::ExpectTensorEqual<float>(src, response.tensor());
+    // Unaligned contents are copied.
+    EXPECT_EQ(misalignment == 0,
+              response.tensor().tensor_data().data() == data + content_offset);
+  }
+  port::AlignedFree(memory);
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -82,6 +82,15 @@ void Worker::RegisterGraphAsync(const RegisterGraphRequest* request,
         request->collective_graph_key(), session->cluster_flr.get(),
         response->mutable_graph_handle());
   }
+  if (s.ok()) {
+    GraphMgr::RegisteredKeys keys;
+    keys.feed.assign(request->feed_key().begin(), request->feed_key().end());
+    keys.fetch.assign(request->fetch_key().begin(),
+                      request->fetch_key().end());
+    s = session->graph_mgr->SetRegisteredKeys(response->graph_handle(),
+                                              std::move(keys));
+    response->set_accepts_key_indices(s.ok());
+  }
   done(s);
 }
 
@@ -116,19 +125,45 @@ void Worker::AbortStep(int64 step_id) {
 }
 
 Status Worker::PrepareRunGraph(RunGraphRequestWrapper* req,
+                               GraphMgr* graph_mgr,
                                GraphMgr::NamedTensors* in,
                                GraphMgr::NamedTensors* out) {
   static Tensor empty_tensor(DT_FLOAT);
+  std::shared_ptr<const GraphMgr::RegisteredKeys> keys;
+  if (req->num_send_indices() > 0 || req->num_recv_indices() > 0) {
+    TF_RETURN_IF_ERROR(
+        graph_mgr->GetRegisteredKeys(req->graph_handle(), &keys));
+    if (req->num_send_indices() != req->num_sends()) {
+      return errors::InvalidArgument("Got ", req->num_send_indices(),
+                                     " send indices for ", req->num_sends(),
+                                     " sends");
+    }
+  }
   if (req->num_sends() > 0) {
     Tensor val;
     for (size_t i = 0; i < req->num_sends(); ++i) {
       TF_RETURN_IF_ERROR(req->SendValue(i, &val));
-      in->insert({req->send_key(i), val});
+      if (keys == nullptr) {
+        in->insert({req->send_key(i), val});
+        continue;
+      }
+      const int32 index = req->send_index(i);
+      if (index < 0 || index >= keys->feed.size()) {
+        return errors::InvalidArgument("Invalid send index ", index);
+      }
+      in->insert({keys->feed[index], val});
     }
   }
   for (size_t i = 0; i < req->num_recvs(); ++i) {
     out->insert({req->recv_key(i), empty_tensor});
   }
+  for (size_t i = 0; i < req->num_recv_indices(); ++i) {
+    const int32 index = req->recv_index(i);
+    if (index < 0 || index >= keys->fetch.size()) {
+      return errors::InvalidArgument("Invalid recv index ", index);
+    }
+    out->insert({keys->fetch[index], empty_tensor});
+  }
   return Status::OK();
 }
 
@@ -181,7 +216,7 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
   }
   GraphMgr::NamedTensors in;
   GraphMgr::NamedTensors* out = new GraphMgr::NamedTensors;
-  s = PrepareRunGraph(request, &in, out);
+  s = PrepareRunGraph(request, session->graph_mgr.get(), &in, out);
   if (!s.ok()) {
     delete out;
     done(s);
@@ -283,7 +318,7 @@ void Worker::DoPartialRunGraph(CallOptions* opts,
 
   GraphMgr::NamedTensors in;
   GraphMgr::NamedTensors* out = new GraphMgr::NamedTensors;
-  s = PrepareRunGraph(request, &in, out);
+  s = PrepareRunGraph(request, session->graph_mgr.get(), &in, out);
   auto finish = [done, out, opts](const Status& s) {
     opts->ClearCancelCallback();
     delete out;
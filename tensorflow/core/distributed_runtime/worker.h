@@ -122,7 +122,7 @@ class Worker : public WorkerInterface {
 
   CancellationManager cancellation_manager_;
 
-  Status PrepareRunGraph(RunGraphRequestWrapper* req,
+  Status PrepareRunGraph(RunGraphRequestWrapper* req, GraphMgr* graph_mgr,
                          GraphMgr::NamedTensors* in,
                          GraphMgr::NamedTensors* out);
 
@@ -17,9 +17,11 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_WORKER_INTERFACE_H_
 
 #include <functional>
+#include <vector>
 
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/message_wrappers.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
@@ -106,6 +108,20 @@ class WorkerInterface {
                                TensorResponse* response,
                                StatusCallback done) = 0;
 
+  // Receives the tensors of "request->request()" in one call, into the
+  // corresponding elements of "*responses", which must have been initialized
+  // with TensorResponse::InitAlloc().  Fails as a whole if any of the
+  // tensors cannot be received.
+  //
+  // The default implementation returns an Unimplemented error, in which case
+  // the caller should fall back to RecvTensorAsync().
+  virtual void RecvTensorsAsync(CallOptions* opts,
+                                const RecvTensorsRequest* request,
+                                std::vector<TensorResponse*>* responses,
+                                StatusCallback done) {
+    done(errors::Unimplemented("RecvTensors is not supported"));
+  }
+
   virtual void LoggingAsync(const LoggingRequest* request,
                             LoggingResponse* response, StatusCallback done) = 0;
 
@@ -33,9 +33,49 @@ string AllocatorStats::DebugString() const {
       "InUse:        %20lld\n"
       "MaxInUse:     %20lld\n"
       "NumAllocs:    %20lld\n"
-      "MaxAllocSize: %20lld\n",
+      "MaxAllocSize: %20lld\n"
+      "Free:         %20lld\n"
+      "MaxFreeBlock: %20lld\n",
       this->bytes_limit ? *this->bytes_limit : 0, this->bytes_in_use,
-      this->peak_bytes_in_use, this->num_allocs, this->largest_alloc_size);
+      this->peak_bytes_in_use, this->num_allocs, this->largest_alloc_size,
+      this->bytes_free, this->largest_free_block_size);
+}
+
+namespace {
+
+struct MemoryDebugAnnotation {
+  const char* op_name = nullptr;
+  int64 step_id = 0;
+};
+
+MemoryDebugAnnotation* ThreadMemoryDebugAnnotation() {
+  static thread_local MemoryDebugAnnotation annotation;
+  return &annotation;
+}
+
+}  // namespace
+
+ScopedMemoryDebugAnnotation::ScopedMemoryDebugAnnotation(const char* op_name,
+                                                         int64 step_id) {
+  MemoryDebugAnnotation* annotation = ThreadMemoryDebugAnnotation();
+  last_op_name_ = annotation->op_name;
+  last_step_id_ = annotation->step_id;
+  annotation->op_name = op_name;
+  annotation->step_id = step_id;
+}
+
+ScopedMemoryDebugAnnotation::~ScopedMemoryDebugAnnotation() {
+  MemoryDebugAnnotation* annotation = ThreadMemoryDebugAnnotation();
+  annotation->op_name = last_op_name_;
+  annotation->step_id = last_step_id_;
+}
+
+/*static*/ const char* ScopedMemoryDebugAnnotation::CurrentOpName() {
+  return ThreadMemoryDebugAnnotation()->op_name;
+}
+
+/*static*/ int64 ScopedMemoryDebugAnnotation::CurrentStepId() {
+  return ThreadMemoryDebugAnnotation()->step_id;
 }
 
 constexpr size_t Allocator::kAllocatorAlignment;
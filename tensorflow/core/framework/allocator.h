@@ -62,6 +62,27 @@ struct AllocationAttributes {
   TF_DISALLOW_COPY_AND_ASSIGN(AllocationAttributes);
 };
 
+// Annotates the allocations made by the current thread while it is in scope
+// with the name of the op and the id of the step that made them. Allocators
+// that record memory profiles attribute allocations to ops with it. Scopes
+// nest; `op_name` must outlive the annotation.
+class ScopedMemoryDebugAnnotation {
+ public:
+  ScopedMemoryDebugAnnotation(const char* op_name, int64 step_id);
+  ~ScopedMemoryDebugAnnotation();
+
+  // The op name and step id of the innermost annotation on this thread, or
+  // nullptr and 0 if there is none.
+  static const char* CurrentOpName();
+  static int64 CurrentStepId();
+
+ private:
+  const char* last_op_name_;
+  int64 last_step_id_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedMemoryDebugAnnotation);
+};
+
 // Runtime statistics collected by an allocator. Exactly the same as
 // stream_executor::AllocatorStats, but independently defined to preserve the
 // mutual independence of StreamExecutor and TensorFlow.
@@ -82,13 +103,22 @@ struct AllocatorStats {
   // if such a limit is known.
   absl::optional<int64> bytes_reservable_limit;
 
+  // Stats for fragmentation, for allocators that reserve memory up front and
+  // carve allocations out of it.  An allocation larger than
+  // largest_free_block_size needs more memory to be reserved, even if
+  // bytes_free is larger.
+  int64 bytes_free;               // Number of reserved bytes not in use.
+  int64 largest_free_block_size;  // The largest contiguous free block.
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
         peak_bytes_in_use(0),
         largest_alloc_size(0),
         bytes_reserved(0),
-        peak_bytes_reserved(0) {}
+        peak_bytes_reserved(0),
+        bytes_free(0),
+        largest_free_block_size(0) {}
 
   string DebugString() const;
 };
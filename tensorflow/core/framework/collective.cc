@@ -66,6 +66,7 @@ CollInstanceParams& CollInstanceParams::operator=(
     instance_key = other.instance_key;
     type = other.type;
     data_type = other.data_type;
+    wire_data_type = other.wire_data_type;
     shape = other.shape;
     device_names.clear();
     device_names.assign(other.device_names.begin(), other.device_names.end());
@@ -92,6 +93,7 @@ CollInstanceParams& CollInstanceParams::operator=(
 string CollInstanceParams::ToString() const {
   string v = strings::StrCat("CollInstanceParams { instance_key=", instance_key,
                              " type=", type, " data_type=", data_type,
+                             " wire_data_type=", wire_data_type,
                              " shape=", shape.DebugString(), " devices {");
   for (const auto& d : device_names) {
     strings::StrAppend(&v, d, ",");
@@ -90,6 +90,9 @@ struct CollInstanceParams {
   int32 instance_key = -1;
   CollectiveType type = UNDEFINED_COLLECTIVE;
   DataType data_type = DT_FLOAT;
+  // Type in which reduction values are sent between devices, if different
+  // from data_type.  Partial reductions are still computed in data_type.
+  DataType wire_data_type = DT_INVALID;
   TensorShape shape = {0};
   // Fully qualified name of device for each member, in default rank order.
   std::vector<string> device_names;
@@ -128,6 +131,9 @@ struct CollectiveParams {
   std::vector<int> subdiv_rank;
   std::unique_ptr<OpKernel> merge_op;  // reduction only
   std::unique_ptr<OpKernel> final_op;  // reduction only
+  // Convert values to and from instance.wire_data_type.  Reduction only.
+  std::unique_ptr<OpKernel> encode_op;
+  std::unique_ptr<OpKernel> decode_op;
   string ToString() const;
 };
 
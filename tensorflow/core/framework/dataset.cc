@@ -23,7 +23,9 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/profiler/lib/op_context.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/batch_util.h"
 
 namespace tensorflow {
 namespace data {
@@ -415,9 +417,14 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
                                     bool* end_of_sequence) {
   profiler::TraceMe activity([&] { return BuildTraceMeName(); },
                              profiler::TraceMeLevel::kInfo);
+  profiler::ScopedDatasetIteratorContext iterator_context(
+      params_.prefix.c_str());
   RecordStart(ctx, /*stop_output=*/true);
   Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
-  if (s.ok() && !*end_of_sequence) RecordElement(ctx);
+  if (s.ok() && !*end_of_sequence) {
+    RecordElement(ctx);
+    RecordElementBytes(ctx, *out_tensors);
+  }
   RecordStop(ctx, /*start_output=*/true);
   if (TF_PREDICT_FALSE(errors::IsOutOfRange(s))) {
     s = errors::Internal("Iterator \"", params_.prefix,
@@ -430,6 +437,36 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
   return s;
 }
 
+Status DatasetBaseIterator::MaybeFillBatchSlot(
+    IteratorContext* ctx, const std::vector<Tensor>& element) {
+  BatchSlot* slot = ctx->batch_slot().get();
+  if (slot == nullptr || slot->batch == nullptr ||
+      slot->producer != params_.prefix) {
+    return Status::OK();
+  }
+  std::vector<Tensor>& batch = *slot->batch;
+  if (element.size() != batch.size()) {
+    return Status::OK();
+  }
+  for (size_t i = 0; i < element.size(); ++i) {
+    if (element[i].dtype() != batch[i].dtype() ||
+        element[i].dims() + 1 != batch[i].dims()) {
+      return Status::OK();
+    }
+    for (int d = 0; d < element[i].dims(); ++d) {
+      if (element[i].dim_size(d) != batch[i].dim_size(d + 1)) {
+        return Status::OK();
+      }
+    }
+  }
+  for (size_t i = 0; i < element.size(); ++i) {
+    TF_RETURN_IF_ERROR(
+        batch_util::CopyElementToSlice(element[i], &batch[i], slot->index));
+  }
+  slot->filled = true;
+  return Status::OK();
+}
+
 void DatasetOpKernel::Compute(OpKernelContext* ctx) {
   DatasetBase* dataset = nullptr;
   MakeDataset(ctx, &dataset);
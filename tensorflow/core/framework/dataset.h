@@ -282,6 +282,27 @@ class Runner {
   static Runner* get();
 };
 
+// A slot in a batch that a consuming iterator (e.g. `BatchDataset`) has
+// preallocated for the next element of its input. Only the iterator whose
+// prefix equals `producer` may use the slot: it copies the components of the
+// element it produces into row `index` of `batch` as soon as the element is
+// computed and sets `filled`, so that the consumer does not need to hold on to
+// the element and copy it later. Iterators further upstream must ignore it.
+struct BatchSlot {
+  // The prefix of the iterator that may fill the slot.
+  string producer;
+
+  // One preallocated tensor per tuple component, with the batch dimension
+  // first. Not owned; reset to `nullptr` once the batch is complete.
+  std::vector<Tensor>* batch = nullptr;
+
+  // The row of `batch` to fill.
+  int64 index = 0;
+
+  // Set by the producer once the row has been filled.
+  bool filled = false;
+};
+
 // A cut-down version of `OpKernelContext` for running computations in
 // iterators. Note that we cannot simply use `OpKernelContext` here because we
 // might run computation in an iterator whose lifetime is not nested within the
@@ -296,6 +317,10 @@ class Runner {
 class IteratorContext {
  public:
   struct Params {
+    // Creates parameters that the caller fills in, for running iterators
+    // outside of an op kernel.
+    Params() = default;
+
     explicit Params(IteratorContext* ctx)
         : allocator_getter(ctx->allocator_getter()),
           env(ctx->env()),
@@ -371,6 +396,11 @@ class IteratorContext {
     // A `ThreadFactory` for creating threads used by iterators to perform
     // blocking work.
     std::shared_ptr<ThreadFactory> thread_factory = nullptr;
+
+    // If non-null, a batch slot offered to the immediate input of the
+    // consumer that created this context. It is deliberately not propagated
+    // by `Params(IteratorContext*)`.
+    std::shared_ptr<BatchSlot> batch_slot = nullptr;
   };
 
   explicit IteratorContext(IteratorContext* ctx) : params_(Params{ctx}) {}
@@ -423,6 +453,8 @@ class IteratorContext {
     return params_.stats_aggregator;
   }
 
+  const std::shared_ptr<BatchSlot>& batch_slot() { return params_.batch_slot; }
+
   Params params() { return params_; }
 
  private:
@@ -795,6 +827,13 @@ class DatasetBaseIterator : public IteratorBase {
     }
   }
 
+  // If the consumer of this iterator has offered a batch slot for the element
+  // being produced, copies `element` into the slot and marks it as filled.
+  // Elements whose types or shapes do not match the slot are left to the
+  // consumer, which reports any mismatch.
+  Status MaybeFillBatchSlot(IteratorContext* ctx,
+                            const std::vector<Tensor>& element);
+
   // When modeling is enabled, this method records the fact that this iterator
   // has dequeued an element from an internal buffer.
   void RecordBufferDequeue(IteratorContext* ctx,
@@ -821,15 +860,25 @@ class DatasetBaseIterator : public IteratorBase {
     }
   }
 
+  // When modeling is enabled, this method records the size of an element
+  // produced by this iterator.
+  void RecordElementBytes(IteratorContext* ctx,
+                          const std::vector<Tensor>& element) {
+    if (collect_resource_usage(ctx)) {
+      node_->add_bytes_produced(GetAllocatedBytes(element));
+    }
+  }
+
   // When modeling is enabled, this method records the fact that a thread of
   // this iterator has started work.
   void RecordStart(IteratorContext* ctx, bool stop_output = false) {
     if (collect_resource_usage(ctx)) {
       int64 now_nanos = Env::Default()->NowNanos();
+      int64 cpu_nanos = Env::Default()->ThreadCpuNanos();
       if (stop_output && node_->output()) {
-        node_->output()->record_stop(now_nanos);
+        node_->output()->record_stop(now_nanos, cpu_nanos);
       }
-      node_->record_start(now_nanos);
+      node_->record_start(now_nanos, cpu_nanos);
     }
   }
 
@@ -838,9 +887,10 @@ class DatasetBaseIterator : public IteratorBase {
   void RecordStop(IteratorContext* ctx, bool start_output = false) {
     if (collect_resource_usage(ctx)) {
       int64 now_nanos = Env::Default()->NowNanos();
-      node_->record_stop(now_nanos);
+      int64 cpu_nanos = Env::Default()->ThreadCpuNanos();
+      node_->record_stop(now_nanos, cpu_nanos);
       if (start_output && node_->output()) {
-        node_->output()->record_start(now_nanos);
+        node_->output()->record_start(now_nanos, cpu_nanos);
       }
     }
   }
@@ -941,6 +941,13 @@ string Canonicalize(const string& funcname, AttrSlice attrs,
     entries.push_back(
         strings::StrCat("_state_handle", "=", options.state_handle));
   }
+  if (options.num_micro_batches > 1) {
+    entries.push_back(strings::StrCat("_num_micro_batches", "=",
+                                      options.num_micro_batches));
+    entries.push_back(
+        strings::StrCat("_summed_micro_batch_outputs", "=",
+                        absl::StrJoin(options.summed_micro_batch_outputs, ":")));
+  }
   string executor_type = FunctionLibraryRuntime::ExecutorType(options, attrs);
   if (!executor_type.empty()) {
     entries.push_back(strings::StrCat(kExecutorAttr, "=", executor_type));
@@ -1050,6 +1057,12 @@ FunctionLibraryDefinition::FunctionDefAndOpRegistration::
       op_registration_data(fdef.signature(), shape_inference::UnknownShape,
                            true /* is_function */) {}
 
+FunctionLibraryDefinition::FunctionDefAndOpRegistration::
+    FunctionDefAndOpRegistration(FunctionDef&& fdef_in)
+    : fdef(std::move(fdef_in)),
+      op_registration_data(fdef.signature(), shape_inference::UnknownShape,
+                           true /* is_function */) {}
+
 FunctionLibraryDefinition::FunctionLibraryDefinition(
     const FunctionLibraryDefinition& other)
     : default_registry_(other.default_registry_) {
@@ -1103,19 +1116,19 @@ Status FunctionLibraryDefinition::AddFunctionDef(const FunctionDef& fdef) {
   return AddFunctionDefHelper(fdef, &added);
 }
 
-Status FunctionLibraryDefinition::AddFunctionDefHelper(const FunctionDef& fdef,
-                                                       bool* added) {
-  *added = false;
-  std::unique_ptr<FunctionDefAndOpRegistration>* entry =
-      &function_defs_[fdef.signature().name()];
-  if (*entry != nullptr) {
-    if (!FunctionDefsEqual((*entry)->fdef, fdef)) {
+Status FunctionLibraryDefinition::FindEntryToAdd(
+    const FunctionDef& fdef,
+    std::unique_ptr<FunctionDefAndOpRegistration>** entry) {
+  *entry = &function_defs_[fdef.signature().name()];
+  if (**entry != nullptr) {
+    if (!FunctionDefsEqual((**entry)->fdef, fdef)) {
       return errors::InvalidArgument(
           "Cannot add function '", fdef.signature().name(),
           "' because a different function with the same name already "
           "exists.");
     }
     // Ignore duplicate FunctionDefs.
+    *entry = nullptr;
     return Status::OK();
   }
   const OpDef* op_def;
@@ -1124,11 +1137,31 @@ Status FunctionLibraryDefinition::AddFunctionDefHelper(const FunctionDef& fdef,
         "Cannot add function '", fdef.signature().name(),
         "' because an op with the same name already exists.");
   }
+  return Status::OK();
+}
+
+Status FunctionLibraryDefinition::AddFunctionDefHelper(const FunctionDef& fdef,
+                                                       bool* added) {
+  *added = false;
+  std::unique_ptr<FunctionDefAndOpRegistration>* entry;
+  TF_RETURN_IF_ERROR(FindEntryToAdd(fdef, &entry));
+  if (entry == nullptr) return Status::OK();
   entry->reset(new FunctionDefAndOpRegistration(fdef));
   *added = true;
   return Status::OK();
 }
 
+Status FunctionLibraryDefinition::AddFunctionDefHelper(FunctionDef&& fdef,
+                                                       bool* added) {
+  *added = false;
+  std::unique_ptr<FunctionDefAndOpRegistration>* entry;
+  TF_RETURN_IF_ERROR(FindEntryToAdd(fdef, &entry));
+  if (entry == nullptr) return Status::OK();
+  entry->reset(new FunctionDefAndOpRegistration(std::move(fdef)));
+  *added = true;
+  return Status::OK();
+}
+
 Status FunctionLibraryDefinition::AddGradientDef(const GradientDef& grad) {
   mutex_lock l(mu_);
   bool added;
@@ -1224,6 +1257,38 @@ Status FunctionLibraryDefinition::AddLibrary(
   return Status::OK();
 }
 
+Status FunctionLibraryDefinition::AddLibrary(FunctionDefLibrary&& lib_def) {
+  // Remember the funcs and grads that we added successfully so that
+  // we can roll them back on error.
+  mutex_lock l(mu_);
+  std::vector<string> funcs;
+  std::vector<string> funcs_with_grads;
+  Status s;
+  bool added;
+  for (FunctionDef& fdef : *lib_def.mutable_function()) {
+    string name = fdef.signature().name();
+    s = AddFunctionDefHelper(std::move(fdef), &added);
+    if (!s.ok()) {
+      Remove(funcs, funcs_with_grads);
+      return s;
+    }
+    if (added) {
+      funcs.push_back(std::move(name));
+    }
+  }
+  for (const GradientDef& grad : lib_def.gradient()) {
+    s = AddGradientDefHelper(grad, &added);
+    if (!s.ok()) {
+      Remove(funcs, funcs_with_grads);
+      return s;
+    }
+    if (added) {
+      funcs_with_grads.push_back(grad.function_name());
+    }
+  }
+  return Status::OK();
+}
+
 Status FunctionLibraryDefinition::ReplaceFunction(const string& func,
                                                   const FunctionDef& fdef) {
   mutex_lock l(mu_);
@@ -1553,6 +1618,7 @@ string FunctionLibraryRuntime::Options::DebugString() const {
       " remote_execution=", remote_execution, " source_device=", source_device,
       " create_rendezvous=", create_rendezvous,
       " allow_dead_tensors=", allow_dead_tensors,
+      " run_all_kernels_inline=", run_all_kernels_inline,
       " args_alloc_attrs=", AllocatorAttributesToString(args_alloc_attrs),
       " rets_alloc_attrs=", AllocatorAttributesToString(rets_alloc_attrs), ")");
 }
@@ -387,6 +387,8 @@ class FunctionLibraryDefinition : public OpRegistryInterface {
   // Duplicate functions and gradients are ignored.
   // This operation is atomic.
   Status AddLibrary(const FunctionDefLibrary& lib_def) LOCKS_EXCLUDED(mu_);
+  // Same as above, but moves the function definitions out of `lib_def`.
+  Status AddLibrary(FunctionDefLibrary&& lib_def) LOCKS_EXCLUDED(mu_);
 
   // If the gradient function for 'func' is specified explicitly in
   // the library, returns the gradient function name.  Otherwise,
@@ -447,6 +449,7 @@ class FunctionLibraryDefinition : public OpRegistryInterface {
 
   struct FunctionDefAndOpRegistration {
     explicit FunctionDefAndOpRegistration(const FunctionDef& fdef_in);
+    explicit FunctionDefAndOpRegistration(FunctionDef&& fdef_in);
 
     FunctionDef fdef;
     OpRegistrationData op_registration_data;
@@ -461,6 +464,13 @@ class FunctionLibraryDefinition : public OpRegistryInterface {
   // `added` to true if the `fdef`/`grad` were actually added to this.
   Status AddFunctionDefHelper(const FunctionDef& fdef, bool* added)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status AddFunctionDefHelper(FunctionDef&& fdef, bool* added)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Sets `*entry` to the slot for `fdef`, or to nullptr if an identical
+  // function is already present.
+  Status FindEntryToAdd(const FunctionDef& fdef,
+                        std::unique_ptr<FunctionDefAndOpRegistration>** entry)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
   Status AddGradientDefHelper(const GradientDef& grad, bool* added)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -597,6 +607,22 @@ class FunctionLibraryRuntime {
     // If set, partitioned functions will be added to `graph_collector`.
     // `graph_collector` must be alive during the call to Instantiate.
     GraphCollector* graph_collector = nullptr;
+
+    // This interface is EXPERIMENTAL and subject to change.
+    //
+    // For multi-device functions, if greater than 1, every call splits the
+    // arguments along their first dimension into this many micro-batches, and
+    // runs the micro-batches through the component functions as a pipeline:
+    // each device moves on to the next micro-batch as soon as it is done with
+    // the previous one, while the following devices work on the previous one.
+    // Scalar and DT_RESOURCE arguments are passed whole to every micro-batch.
+    // Return values are concatenated along their first dimension, or summed
+    // if their index is in `summed_micro_batch_outputs` (e.g. gradients).
+    //
+    // REQUIRES: all the component functions run on local devices and return
+    // their values in host memory.
+    int num_micro_batches = 1;
+    std::vector<int> summed_micro_batch_outputs;
   };
   typedef uint64 Handle;
   virtual Status Instantiate(const string& function_name, AttrSlice attrs,
@@ -663,6 +689,12 @@ class FunctionLibraryRuntime {
     // If True, allow returning dead tensors.
     bool allow_dead_tensors = false;
 
+    // If true, the function body runs on a single thread: the ready kernels
+    // are run one after another by the thread that made them ready, rather
+    // than each being handed to `runner`. This avoids the scheduling overhead
+    // of small functions that are called very often.
+    bool run_all_kernels_inline = false;
+
     // Returns a human readable representation of this.
     string DebugString() const;
   };
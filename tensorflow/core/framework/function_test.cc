@@ -1120,6 +1120,27 @@ GradientDef MakeGradDef(const string& f, const string& g) {
   return grad;
 }
 
+TEST(FunctionLibraryDefinitionTest, AddLibraryByMove) {
+  const string x2_name = test::function::XTimesTwo().signature().name();
+  const string x4_name = test::function::XTimesFour().signature().name();
+  FunctionLibraryDefinition lib_def(OpRegistry::Global(), FunctionDefLibrary());
+  FunctionDefLibrary proto;
+  *proto.add_function() = test::function::XTimesTwo();
+  *proto.add_gradient() = MakeGradDef(x2_name, x4_name);
+  TF_EXPECT_OK(lib_def.AddLibrary(std::move(proto)));
+
+  const FunctionDef* fdef = lib_def.Find(x2_name);
+  ASSERT_NE(fdef, nullptr);
+  EXPECT_TRUE(FunctionDefsEqual(*fdef, test::function::XTimesTwo()));
+  EXPECT_EQ(x4_name, lib_def.FindGradient(x2_name));
+
+  // Adding a duplicate by move is still a no-op.
+  proto.Clear();
+  *proto.add_function() = test::function::XTimesTwo();
+  TF_EXPECT_OK(lib_def.AddLibrary(std::move(proto)));
+  EXPECT_EQ(1, lib_def.ToProto().function_size());
+}
+
 TEST(FunctionLibraryDefinitionTest, AddLibrary_Atomic) {
   // Create lib def containing two functions with equal names
   FunctionDefLibrary proto;
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/model.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 
 #include "absl/time/clock.h"
@@ -562,6 +564,92 @@ class Unknown : public Node {
   }
 };
 
+// Models the memory used by the buffers of an input pipeline as a linear
+// function of its tunable parameters.
+struct MemoryModel {
+  // Bytes buffered by nodes without tunable parameters (e.g. prefetch, shuffle
+  // or cache buffers). These do not change during the optimization.
+  double fixed_bytes = 0.0L;
+
+  // Bytes buffered per unit of each tunable parameter, keyed by the name of the
+  // node that owns the parameter.
+  std::map<string, double> bytes_per_unit;
+
+  // Returns the projected number of buffered bytes for the model values of
+  // `parameters`.
+  double Bytes(
+      const std::map<string, std::shared_ptr<Parameter>>& parameters) const {
+    double bytes = fixed_bytes;
+    for (auto& pair : parameters) {
+      bytes += gtl::FindWithDefault(bytes_per_unit, pair.first, 0.0L) *
+               pair.second->value;
+    }
+    return bytes;
+  }
+};
+
+// Builds the memory model of the subtree rooted in `node`, assuming that the
+// buffer of a node with a tunable parameter holds a number of elements
+// proportional to the value the parameter currently has in the pipeline.
+MemoryModel BuildMemoryModel(
+    const std::shared_ptr<Node>& node,
+    const std::map<string, std::shared_ptr<Parameter>>& parameters) {
+  std::map<string, int64> buffered_bytes;
+  node->CollectBufferedBytes(&buffered_bytes);
+  MemoryModel result;
+  for (auto& pair : buffered_bytes) {
+    auto* parameter = gtl::FindOrNull(parameters, pair.first);
+    if (!parameter) {
+      result.fixed_bytes += pair.second;
+      continue;
+    }
+    double value;
+    {
+      mutex_lock l(*(*parameter)->state->mu);
+      value = (*parameter)->state->value;
+    }
+    result.bytes_per_unit[pair.first] = pair.second / std::max(value, 1.0);
+  }
+  return result;
+}
+
+// Scales down the model values of the parameters that own buffers, without
+// going below their minimum values, so that the projected number of buffered
+// bytes does not exceed `ram_budget`. A non-positive budget is unlimited.
+void FitRamBudget(const MemoryModel& memory, int64 ram_budget,
+                  std::map<string, std::shared_ptr<Parameter>>* parameters) {
+  if (ram_budget <= 0) {
+    return;
+  }
+  const double bytes = memory.Bytes(*parameters);
+  if (bytes <= ram_budget) {
+    return;
+  }
+  const double tunable_bytes = bytes - memory.fixed_bytes;
+  const double scale =
+      std::max(ram_budget - memory.fixed_bytes, 0.0) / tunable_bytes;
+  for (auto& pair : *parameters) {
+    if (gtl::FindWithDefault(memory.bytes_per_unit, pair.first, 0.0L) > 0) {
+      pair.second->value =
+          std::max(pair.second->value * scale, pair.second->min);
+    }
+  }
+}
+
+// Publishes the model values of `parameters` to the input pipeline.
+void UpdateStateValues(
+    const std::map<string, std::shared_ptr<Parameter>>& parameters) {
+  VLOG(2) << "Number of tunable parameters: " << parameters.size();
+  for (auto& pair : parameters) {
+    auto& parameter = pair.second;
+    VLOG(2) << "Setting tunable parameter " << pair.first << " to "
+            << parameter->value;
+    mutex_lock l(*parameter->state->mu);
+    parameter->state->value = parameter->value;
+    parameter->state->cond_var->notify_all();
+  }
+}
+
 }  // namespace
 
 std::shared_ptr<Parameter> MakeParameter(const string& name,
@@ -603,6 +691,31 @@ std::shared_ptr<Node> MakeUnknownNode(Node::Args args) {
   return std::make_shared<Unknown>(std::move(args));
 }
 
+void Node::CollectStepStats(int64 start_micros,
+                            DeviceStepStats* device_stats) const {
+  tf_shared_lock l(mu_);
+  NodeExecStats* node_stats = device_stats->add_node_stats();
+  node_stats->set_node_name(long_name());
+  node_stats->set_all_start_micros(start_micros);
+  node_stats->set_all_start_nanos(start_micros * EnvTime::kMicrosToNanos);
+  node_stats->set_op_end_rel_micros(cpu_time_ / EnvTime::kMicrosToNanos);
+  node_stats->set_op_end_rel_nanos(cpu_time_);
+  node_stats->set_all_end_rel_micros(processing_time_ /
+                                     EnvTime::kMicrosToNanos);
+  node_stats->set_all_end_rel_nanos(processing_time_);
+  node_stats->set_timeline_label(strings::StrCat(
+      long_name(), " elements=", num_elements_, " bytes=", bytes_produced_,
+      " cpu_ns=", cpu_time_, " wall_ns=", processing_time_));
+  AllocatorMemoryUsed* memory = node_stats->add_memory();
+  memory->set_allocator_name("tf_data_buffer");
+  memory->set_total_bytes(bytes_produced_);
+  memory->set_peak_bytes(peak_buffered_bytes_);
+  memory->set_live_bytes(buffered_bytes_);
+  for (auto& input : inputs_) {
+    input->CollectStepStats(start_micros, device_stats);
+  }
+}
+
 std::shared_ptr<Node> Model::AddNode(Node::Factory factory, const string& name,
                                      const string& output_name) {
   // The name captures the sequence of iterators joined by `::`. We use the full
@@ -647,10 +760,15 @@ void Model::AddProcessingTime(const string& name, int64 delta) {
   }
 }
 
-void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget) {
+void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
+                     int64 ram_budget) {
   switch (algorithm) {
     case AutotuneAlgorithm::HILL_CLIMB:
-      OptimizeHillClimb(cpu_budget);
+      OptimizeHillClimb(cpu_budget, ram_budget);
+      break;
+    case AutotuneAlgorithm::GRADIENT_DESCENT:
+      OptimizeGradientDescent(cpu_budget, ram_budget);
+      break;
   }
 }
 
@@ -676,10 +794,11 @@ void Model::RecordStart(const string& name, bool stop_output) {
   auto node = gtl::FindOrNull(lookup_table_, name);
   if (collect_resource_usage_ && node) {
     int64 now_nanos = absl::GetCurrentTimeNanos();
+    int64 cpu_nanos = Env::Default()->ThreadCpuNanos();
     if (stop_output && (*node)->output()) {
-      (*node)->output()->record_stop(now_nanos);
+      (*node)->output()->record_stop(now_nanos, cpu_nanos);
     }
-    (*node)->record_start(now_nanos);
+    (*node)->record_start(now_nanos, cpu_nanos);
   }
 }
 
@@ -688,9 +807,10 @@ void Model::RecordStop(const string& name, bool start_output) {
   auto node = gtl::FindOrNull(lookup_table_, name);
   if (collect_resource_usage_ && node) {
     int64 now_nanos = absl::GetCurrentTimeNanos();
-    (*node)->record_stop(now_nanos);
+    int64 cpu_nanos = Env::Default()->ThreadCpuNanos();
+    (*node)->record_stop(now_nanos, cpu_nanos);
     if (start_output && (*node)->output()) {
-      (*node)->output()->record_start(now_nanos);
+      (*node)->output()->record_start(now_nanos, cpu_nanos);
     }
   }
 }
@@ -708,6 +828,15 @@ void Model::RemoveNode(const string& name) {
   lookup_table_.erase(name);
 }
 
+void Model::ExportStepStats(StepStats* step_stats) {
+  tf_shared_lock l(mu_);
+  DeviceStepStats* device_stats = step_stats->add_dev_stats();
+  device_stats->set_device("/tf_data");
+  if (output_) {
+    output_->CollectStepStats(start_micros_, device_stats);
+  }
+}
+
 std::map<string, std::shared_ptr<Parameter>> Model::CollectTunableParameters(
     std::shared_ptr<Node> node) {
   std::map<string, std::shared_ptr<Parameter>> parameters;
@@ -715,7 +844,7 @@ std::map<string, std::shared_ptr<Parameter>> Model::CollectTunableParameters(
   return parameters;
 }
 
-void Model::OptimizeHillClimb(int64 cpu_budget) {
+void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget) {
   std::shared_ptr<Node> snapshot;
   {
     tf_shared_lock lock(mu_);
@@ -724,6 +853,7 @@ void Model::OptimizeHillClimb(int64 cpu_budget) {
   VLOG(2) << "Starting optimization of tunable parameters";
   const double processing_time = TotalProcessingTime(snapshot);
   auto parameters = CollectTunableParameters(snapshot);
+  const MemoryModel memory = BuildMemoryModel(snapshot, parameters);
   for (auto& pair : parameters) {
     pair.second->value = 1;
   }
@@ -741,11 +871,17 @@ void Model::OptimizeHillClimb(int64 cpu_budget) {
     }
     double best_delta = -1.0L;
     Parameter* best_parameter = nullptr;
+    bool ram_limited = false;
     for (auto& pair : parameters) {
       if (pair.second->value == pair.second->max) {
         continue;
       }
       pair.second->value++;
+      if (ram_budget > 0 && memory.Bytes(parameters) > ram_budget) {
+        ram_limited = true;
+        pair.second->value--;
+        continue;
+      }
       double new_output_time = OutputTime(snapshot, /*gradient=*/nullptr);
       double delta = output_time - new_output_time;
       if (delta > best_delta) {
@@ -755,6 +891,10 @@ void Model::OptimizeHillClimb(int64 cpu_budget) {
       pair.second->value--;
     }
     if (!best_parameter) {
+      if (ram_limited) {
+        VLOG(2) << "Reached the RAM budget of " << ram_budget << " bytes";
+        break;
+      }
       LOG(WARNING) << "Failed to find a tunable parameter that would "
                       "decrease the output time. This means that the "
                       "autotuning optimization got stuck in a local maximum. "
@@ -763,15 +903,78 @@ void Model::OptimizeHillClimb(int64 cpu_budget) {
     }
     best_parameter->value++;
   }
-  VLOG(2) << "Number of tunable parameters: " << parameters.size();
+  UpdateStateValues(parameters);
+}
+
+void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget) {
+  // The step size, in units of the parameter with the largest derivative, that
+  // the descent starts with and below which it stops.
+  constexpr double kInitialStep = 1.0L;
+  constexpr double kMinStep = 1.0L / 16;
+  // Bounds the number of output time evaluations per optimization.
+  constexpr int kMaxIterations = 1000;
+
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock lock(mu_);
+    snapshot = output_->Snapshot(nullptr);
+  }
+  VLOG(2) << "Starting optimization of tunable parameters";
+  const double processing_time = TotalProcessingTime(snapshot);
+  auto parameters = CollectTunableParameters(snapshot);
+  const MemoryModel memory = BuildMemoryModel(snapshot, parameters);
   for (auto& pair : parameters) {
-    auto& parameter = pair.second;
-    VLOG(2) << "Setting tunable parameter " << pair.first << " to "
-            << parameter->value;
-    mutex_lock l(*parameter->state->mu);
-    parameter->state->value = parameter->value;
-    parameter->state->cond_var->notify_all();
+    pair.second->value = pair.second->min;
+  }
+  std::map<string, double> gradient;
+  double output_time = OutputTime(snapshot, &gradient);
+  double step = kInitialStep;
+  std::map<string, double> old_values;
+  for (int i = 0; i < kMaxIterations && step >= kMinStep &&
+                  output_time > processing_time / cpu_budget;
+       ++i) {
+    // Only derivatives that can be followed without leaving the parameter
+    // bounds contribute to the normalization.
+    double max_derivative = 0.0L;
+    for (auto& pair : parameters) {
+      const double derivative =
+          gtl::FindWithDefault(gradient, pair.first, 0.0L);
+      if ((derivative < 0 && pair.second->value < pair.second->max) ||
+          (derivative > 0 && pair.second->value > pair.second->min)) {
+        max_derivative = std::max(max_derivative, std::abs(derivative));
+      }
+    }
+    if (max_derivative == 0) {
+      break;
+    }
+    for (auto& pair : parameters) {
+      auto& parameter = pair.second;
+      old_values[pair.first] = parameter->value;
+      const double derivative =
+          gtl::FindWithDefault(gradient, pair.first, 0.0L);
+      const double new_value =
+          parameter->value - step * derivative / max_derivative;
+      parameter->value =
+          std::min(std::max(new_value, parameter->min), parameter->max);
+    }
+    FitRamBudget(memory, ram_budget, &parameters);
+    std::map<string, double> new_gradient;
+    const double new_output_time = OutputTime(snapshot, &new_gradient);
+    if (new_output_time < output_time) {
+      output_time = new_output_time;
+      gradient.swap(new_gradient);
+    } else {
+      for (auto& pair : parameters) {
+        pair.second->value = old_values[pair.first];
+      }
+      step /= 2;
+    }
+  }
+  // Tunable parameters are integral in the input pipeline.
+  for (auto& pair : parameters) {
+    pair.second->value = std::round(pair.second->value);
   }
+  UpdateStateValues(parameters);
 }
 
 double Model::OutputTime(std::shared_ptr<Node> node,
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 #define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 
+#include <algorithm>
 #include <list>
 #include <memory>
 #include <string>
@@ -23,6 +24,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -40,6 +42,7 @@ constexpr int64 kAutotune = -1;
 
 enum class AutotuneAlgorithm {
   HILL_CLIMB = 0,
+  GRADIENT_DESCENT = 1,
 };
 
 // Represents thread-safe state that can be shared between an input pipeline and
@@ -129,6 +132,13 @@ class Node {
   void add_buffered_bytes(int64 delta) LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
     buffered_bytes_ += delta;
+    peak_buffered_bytes_ = std::max(peak_buffered_bytes_, buffered_bytes_);
+  }
+
+  // Increments the bytes produced by the given delta.
+  void add_bytes_produced(int64 delta) LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    bytes_produced_ += delta;
   }
 
   // Adds an input.
@@ -155,6 +165,18 @@ class Node {
     return buffered_bytes_;
   }
 
+  // Returns the total number of bytes of the elements produced by the node.
+  int64 bytes_produced() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return bytes_produced_;
+  }
+
+  // Returns the aggregate thread CPU time spent executing the node logic.
+  int64 cpu_time() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return cpu_time_;
+  }
+
   // Indicates whether the node has tunable parameters.
   bool has_tunable_parameters() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -188,6 +210,12 @@ class Node {
   // Returns the node output.
   Node* output() const { return output_; }
 
+  // Returns the largest number of bytes stored in this node's buffer so far.
+  int64 peak_buffered_bytes() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return peak_buffered_bytes_;
+  }
+
   // Returns the aggregate processing time.
   int64 processing_time() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -200,19 +228,26 @@ class Node {
     num_elements_++;
   }
 
-  // Records that a node thread has started executing.
-  void record_start(int64 time_nanos) LOCKS_EXCLUDED(mu_) {
+  // Records that a node thread has started executing. The `cpu_nanos` argument
+  // is the CPU time consumed by the calling thread so far, or 0 if unknown.
+  void record_start(int64 time_nanos, int64 cpu_nanos = 0)
+      LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
-    work_start_[std::this_thread::get_id()] = time_nanos;
+    work_start_[std::this_thread::get_id()] = {time_nanos, cpu_nanos};
   }
 
-  // Records that a node thread has stopped executing.
-  void record_stop(int64 time_nanos) LOCKS_EXCLUDED(mu_) {
+  // Records that a node thread has stopped executing. The `cpu_nanos` argument
+  // is the CPU time consumed by the calling thread so far, or 0 if unknown.
+  void record_stop(int64 time_nanos, int64 cpu_nanos = 0)
+      LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
     std::thread::id tid = std::this_thread::get_id();
     auto iter = work_start_.find(tid);
     if (iter != work_start_.end()) {
-      processing_time_ += time_nanos - iter->second;
+      processing_time_ += time_nanos - iter->second.first;
+      if (cpu_nanos > iter->second.second) {
+        cpu_time_ += cpu_nanos - iter->second.second;
+      }
       work_start_.erase(iter);
     } else {
       VLOG(1)
@@ -232,6 +267,28 @@ class Node {
     autotune_ = autotune;
   }
 
+  // Collects the number of bytes buffered by the nodes in the subtree rooted in
+  // this node, keyed by the (unique) node name.
+  void CollectBufferedBytes(std::map<string, int64>* buffered_bytes) const
+      LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    if (!autotune_) {
+      return;
+    }
+    buffered_bytes->insert(std::make_pair(long_name(), buffered_bytes_));
+    for (auto& input : inputs_) {
+      input->CollectBufferedBytes(buffered_bytes);
+    }
+  }
+
+  // Appends a profile of the subtree rooted in this node to `device_stats`,
+  // one `NodeExecStats` per node in pre-order. The all-end time is the
+  // aggregate wall time spent in the node and the op-end time is the
+  // aggregate thread CPU time, both relative to the model creation time given
+  // by `start_micros`. Buffered bytes are reported as allocator memory.
+  void CollectStepStats(int64 start_micros, DeviceStepStats* device_stats) const
+      LOCKS_EXCLUDED(mu_);
+
   // Collects tunable parameters in the subtree rooted in this node.
   void CollectTunableParameters(
       std::map<string, std::shared_ptr<Parameter>>* parameters) const
@@ -257,7 +314,11 @@ class Node {
     strings::StrAppend(&result, long_name(), ":\n");
     strings::StrAppend(&result, "  autotune=", autotune_, "\n");
     strings::StrAppend(&result, "  buffered_bytes=", buffered_bytes_, "\n");
+    strings::StrAppend(&result, "  peak_buffered_bytes=", peak_buffered_bytes_,
+                       "\n");
+    strings::StrAppend(&result, "  bytes_produced=", bytes_produced_, "\n");
     strings::StrAppend(&result, "  processing_time=", processing_time_, "\n");
+    strings::StrAppend(&result, "  cpu_time=", cpu_time_, "\n");
     strings::StrAppend(&result, "  num_elements=", num_elements_, "\n");
     string inputs;
     for (auto& input : inputs_) {
@@ -293,7 +354,10 @@ class Node {
       mutex_lock l2(result->mu_);
       result->autotune_ = autotune_;
       result->buffered_bytes_ = buffered_bytes_;
+      result->peak_buffered_bytes_ = peak_buffered_bytes_;
+      result->bytes_produced_ = bytes_produced_;
       result->processing_time_ = processing_time_;
+      result->cpu_time_ = cpu_time_;
       result->num_elements_ = num_elements_;
       result->parameters_ = parameters_;
     }
@@ -421,9 +485,14 @@ class Node {
   // from computation of output time and processing time.
   bool autotune_ GUARDED_BY(mu_) = true;
   int64 buffered_bytes_ GUARDED_BY(mu_) = 0;
+  int64 peak_buffered_bytes_ GUARDED_BY(mu_) = 0;
+  int64 bytes_produced_ GUARDED_BY(mu_) = 0;
   int64 processing_time_ GUARDED_BY(mu_) = 0;
+  int64 cpu_time_ GUARDED_BY(mu_) = 0;
   int64 num_elements_ GUARDED_BY(mu_) = 0;
-  std::map<std::thread::id, int64> work_start_ GUARDED_BY(mu_);
+  // Maps a thread to the wall time and thread CPU time of its last start event.
+  std::map<std::thread::id, std::pair<int64, int64>> work_start_
+      GUARDED_BY(mu_);
   std::map<string, std::shared_ptr<Parameter>> parameters_ GUARDED_BY(mu_);
 
   // Statistic of inputs processing time history.
@@ -494,6 +563,7 @@ class Model {
   // from modules that it could not depend on statically.
   Model(NodeHook remove_node_hook)
       : collect_resource_usage_(false),
+        start_micros_(Env::Default()->NowMicros()),
         remove_node_hook_(std::move(remove_node_hook)) {
     DCHECK(remove_node_hook_ != nullptr);
   }
@@ -501,6 +571,10 @@ class Model {
   // Indicates whether to collect resource usage.
   bool collect_resource_usage() const { return collect_resource_usage_; }
 
+  // Starts collecting resource usage even if the input pipeline has no
+  // tunable parameters (e.g. because the usage is being profiled).
+  void EnableResourceUsageCollection() { collect_resource_usage_ = true; }
+
   // Adds a node with the given name and given output.
   std::shared_ptr<Node> AddNode(Node::Factory factory, const string& name,
                                 const string& output_name) LOCKS_EXCLUDED(mu_);
@@ -509,8 +583,13 @@ class Model {
   void AddProcessingTime(const string& name, int64 delta) LOCKS_EXCLUDED(mu_);
 
   // Uses the given algorithm to perform the autotuning optimization.
-  void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget)
-      LOCKS_EXCLUDED(mu_);
+  //
+  // If `ram_budget` is positive, the tunable parameters are chosen so that the
+  // projected size of all buffers of the input pipeline, including buffers of
+  // transformations without tunable parameters (e.g. prefetch, shuffle or
+  // cache), does not exceed `ram_budget` bytes.
+  void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
+                int64 ram_budget) LOCKS_EXCLUDED(mu_);
 
   // Records that a node has produced an element.
   void RecordElement(const string& name) LOCKS_EXCLUDED(mu_);
@@ -529,6 +608,18 @@ class Model {
   // Removes the given node.
   void RemoveNode(const string& name) LOCKS_EXCLUDED(mu_);
 
+  // Exports the per-node processing time, CPU time, produced bytes and buffer
+  // occupancy of the input pipeline as a `DeviceStepStats` entry of
+  // `step_stats`, so that it can be rendered by the existing timeline tools.
+  void ExportStepStats(StepStats* step_stats) LOCKS_EXCLUDED(mu_);
+
+  // Returns the node of the output iterator of the input pipeline, or nullptr
+  // if no iterator has been created yet.
+  std::shared_ptr<Node> output() LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return output_;
+  }
+
  private:
   // Collects tunable parameters in the tree rooted in the given node, returning
   // a mapping from a (unique) node name to a tunable parameter.
@@ -540,8 +631,20 @@ class Model {
   // in parallelism decreases the output time the most. This process is repeated
   // until all parameters reach their maximum values or the projected output
   // time is less than or equal to the processing time needed to produce an
-  // element divided by CPU budget.
-  void OptimizeHillClimb(int64 cpu_budget);
+  // element divided by CPU budget. Increments that would exceed the RAM budget
+  // are not considered.
+  void OptimizeHillClimb(int64 cpu_budget, int64 ram_budget);
+
+  // This optimization algorithm starts by setting all tunable parameters to
+  // their minimum values. It then repeatedly moves all parameters jointly in
+  // the direction of the negative output time gradient, normalized so that the
+  // parameter with the largest derivative changes by one step, and projects the
+  // result back onto the parameter bounds and the RAM budget. The step is
+  // halved whenever it fails to decrease the output time. This process is
+  // repeated until the projected output time is less than or equal to the
+  // processing time needed to produce an element divided by CPU budget, or
+  // the step becomes negligible.
+  void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget);
 
   // Collects the output time and if `gradient` is not `nullptr`, the output
   // time gradient w.r.t. tunable parameters of the subtree rooted in the given
@@ -568,6 +671,9 @@ class Model {
   // of the parameter) and never stops.
   std::atomic<bool> collect_resource_usage_;
 
+  // The time at which the model was created; profile times are relative to it.
+  const int64 start_micros_;
+
   // A hook invoked immediately before a node is removed from the model.
   const NodeHook remove_node_hook_;
 };
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace data {
@@ -401,6 +402,40 @@ TEST(SetterGetterTest, Node) {
   EXPECT_EQ(node->num_elements(), 1);
 }
 
+TEST(ResourceUsageTest, Node) {
+  std::shared_ptr<Node> node =
+      model::MakeUnknownNode({1, "TestNode", nullptr});
+  std::shared_ptr<Node> input = model::MakeSourceNode({2, "TestInput", node});
+  node->add_input(input);
+
+  node->record_start(/*time_nanos=*/1, /*cpu_nanos=*/10);
+  node->record_stop(/*time_nanos=*/41, /*cpu_nanos=*/30);
+  EXPECT_EQ(node->processing_time(), 40);
+  EXPECT_EQ(node->cpu_time(), 20);
+
+  input->add_buffered_bytes(100);
+  input->add_buffered_bytes(-60);
+  input->add_bytes_produced(60);
+  EXPECT_EQ(input->buffered_bytes(), 40);
+  EXPECT_EQ(input->peak_buffered_bytes(), 100);
+  EXPECT_EQ(input->bytes_produced(), 60);
+
+  DeviceStepStats device_stats;
+  node->CollectStepStats(/*start_micros=*/5, &device_stats);
+  ASSERT_EQ(device_stats.node_stats_size(), 2);
+  const NodeExecStats& node_stats = device_stats.node_stats(0);
+  EXPECT_EQ(node_stats.node_name(), "TestNode(id:1)");
+  EXPECT_EQ(node_stats.all_start_micros(), 5);
+  EXPECT_EQ(node_stats.all_end_rel_nanos(), 40);
+  EXPECT_EQ(node_stats.op_end_rel_nanos(), 20);
+  const NodeExecStats& input_stats = device_stats.node_stats(1);
+  EXPECT_EQ(input_stats.node_name(), "TestInput(id:2)");
+  ASSERT_EQ(input_stats.memory_size(), 1);
+  EXPECT_EQ(input_stats.memory(0).total_bytes(), 60);
+  EXPECT_EQ(input_stats.memory(0).peak_bytes(), 100);
+  EXPECT_EQ(input_stats.memory(0).live_bytes(), 40);
+}
+
 // Returns a weighted sum of a prior and the actual processing time.
 double weighted_processing_time(int64 num_elements, double processing_time,
                                 double prior) {
@@ -671,6 +706,127 @@ TEST(UnknownGradientTest, Model) {
               (new_output_time - output_time) / kParameterStep,
               kComparisonPrecision);
 }
+
+// Adds a chain of `num_stages` nodes with autotuned parallelism to `model`,
+// each of which spends `stage_time` nanoseconds per element, and returns their
+// shared states. The root of the model buffers `fixed_bytes` bytes, and each
+// stage buffers `element_bytes` bytes per element in flight.
+std::vector<std::shared_ptr<SharedState>> AddParallelStages(
+    Model* model, int64 num_stages, int64 stage_time, int64 element_bytes,
+    int64 fixed_bytes) {
+  constexpr int64 kNumElements = 100;
+  constexpr int64 kMaxParallelism = 16;
+  constexpr int64 kInitialParallelism = 4;
+  std::shared_ptr<Node> root = model->AddNode(
+      [](Node::Args args) { return MakeKnownRatioNode(std::move(args), 1); },
+      "Model", "");
+  root->add_buffered_bytes(fixed_bytes);
+  std::vector<std::shared_ptr<Node>> nodes = {root};
+  std::vector<std::shared_ptr<SharedState>> states;
+  string name = "Model";
+  for (int64 i = 0; i < num_stages; ++i) {
+    auto state = std::make_shared<SharedState>(
+        kAutotune, std::make_shared<mutex>(),
+        std::make_shared<condition_variable>());
+    state->value = kInitialParallelism;
+    const string output_name = name;
+    name = strings::StrCat(name, "::ParallelMap", i);
+    std::shared_ptr<Node> node = model->AddNode(
+        [state](Node::Args args) {
+          return MakeAsyncKnownRatioNode(
+              std::move(args), 1,
+              {MakeParameter("parallelism", state, 1, kMaxParallelism)});
+        },
+        name, output_name);
+    node->add_buffered_bytes(kInitialParallelism * element_bytes);
+    node->add_processing_time(kNumElements * stage_time);
+    nodes.push_back(node);
+    states.push_back(state);
+  }
+  nodes.push_back(model->AddNode(MakeSourceNode,
+                                 strings::StrCat(name, "::Range"), name));
+  for (auto& node : nodes) {
+    for (int64 i = 0; i < kNumElements; ++i) {
+      node->record_element();
+    }
+  }
+  root->add_processing_time(kNumElements * 100);
+  nodes.back()->add_processing_time(kNumElements * 100);
+  return states;
+}
+
+class OptimizeTest : public ::testing::TestWithParam<AutotuneAlgorithm> {};
+
+TEST_P(OptimizeTest, IncreasesParallelism) {
+  Model model([](std::shared_ptr<Node>) {});
+  auto states = AddParallelStages(&model, /*num_stages=*/1,
+                                  /*stage_time=*/10000, /*element_bytes=*/1000,
+                                  /*fixed_bytes=*/0);
+  model.Optimize(GetParam(), /*cpu_budget=*/4, /*ram_budget=*/0);
+  EXPECT_GT(states[0]->value, 1);
+  EXPECT_LE(states[0]->value, 16);
+}
+
+TEST_P(OptimizeTest, RespectsRamBudget) {
+  Model model([](std::shared_ptr<Node>) {});
+  // The fixed 500 bytes (e.g. of a prefetch buffer) leave room for two
+  // elements of the parallel stage.
+  auto states = AddParallelStages(&model, /*num_stages=*/1,
+                                  /*stage_time=*/10000, /*element_bytes=*/1000,
+                                  /*fixed_bytes=*/500);
+  model.Optimize(GetParam(), /*cpu_budget=*/4, /*ram_budget=*/2500);
+  EXPECT_GE(states[0]->value, 1);
+  EXPECT_LE(states[0]->value, 2);
+}
+
+TEST_P(OptimizeTest, TunesStagesJointly) {
+  Model model([](std::shared_ptr<Node>) {});
+  auto states = AddParallelStages(&model, /*num_stages=*/3,
+                                  /*stage_time=*/10000, /*element_bytes=*/1000,
+                                  /*fixed_bytes=*/0);
+  model.Optimize(GetParam(), /*cpu_budget=*/8, /*ram_budget=*/0);
+  for (auto& state : states) {
+    EXPECT_GT(state->value, 1);
+    EXPECT_LE(state->value, 16);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Test, OptimizeTest,
+    ::testing::Values(AutotuneAlgorithm::HILL_CLIMB,
+                      AutotuneAlgorithm::GRADIENT_DESCENT));
+
+// Compares the cost of the autotuning algorithms on a pipeline with `stages`
+// parallel stages, reporting the tuned parallelism of each stage as the label.
+static void BM_Optimize(int iters, int algorithm, int stages) {
+  testing::StopTiming();
+  string label;
+  for (int i = 0; i < iters; ++i) {
+    Model model([](std::shared_ptr<Node>) {});
+    auto states =
+        AddParallelStages(&model, stages, /*stage_time=*/10000,
+                          /*element_bytes=*/1000, /*fixed_bytes=*/0);
+    testing::StartTiming();
+    model.Optimize(static_cast<AutotuneAlgorithm>(algorithm),
+                   /*cpu_budget=*/8, /*ram_budget=*/0);
+    testing::StopTiming();
+    if (i == 0) {
+      for (auto& state : states) {
+        strings::StrAppend(&label, state->value, ",");
+      }
+    }
+  }
+  testing::SetLabel(label);
+}
+
+BENCHMARK(BM_Optimize)
+    ->ArgPair(static_cast<int>(AutotuneAlgorithm::HILL_CLIMB), 1)
+    ->ArgPair(static_cast<int>(AutotuneAlgorithm::HILL_CLIMB), 4)
+    ->ArgPair(static_cast<int>(AutotuneAlgorithm::HILL_CLIMB), 16)
+    ->ArgPair(static_cast<int>(AutotuneAlgorithm::GRADIENT_DESCENT), 1)
+    ->ArgPair(static_cast<int>(AutotuneAlgorithm::GRADIENT_DESCENT), 4)
+    ->ArgPair(static_cast<int>(AutotuneAlgorithm::GRADIENT_DESCENT), 16);
+
 }  // namespace
 }  // namespace model
 }  // namespace data
@@ -108,6 +108,12 @@ EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE tensorflow::bfloat16 abs(
   return static_cast<tensorflow::bfloat16>(::fabsf(static_cast<float>(x)));
 }
 
+template <>
+EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE tensorflow::bfloat16 tanh(
+    const tensorflow::bfloat16& x) {
+  return static_cast<tensorflow::bfloat16>(::tanhf(static_cast<float>(x)));
+}
+
 }  // namespace numext
 }  // namespace Eigen
 
@@ -508,6 +508,10 @@ std::unique_ptr<Tensor> OpKernelContext::forward_input(
   bool forward_expected =
       (params_->forward_from_array != nullptr && output_index >= 0 &&
        params_->forward_from_array[output_index] == input_index);
+  if (!forward_expected && params_->input_forwardable_array != nullptr &&
+      !params_->input_forwardable_array[input_index]) {
+    return nullptr;
+  }
   if (!forward_expected && params_->forward_from_array != nullptr) {
     // Check for possibly conflicting forward.
     for (int i = 0; i < num_outputs(); ++i) {
@@ -711,7 +715,13 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   Tensor new_tensor(a, type, shape,
                     AllocationAttributes(allocation_attr.no_retry_on_failure,
                                          /* allocation_will_be_logged= */ true,
@@ -795,6 +805,16 @@ Status OpKernelContext::allocate_temp(
             << ".  Switch to allocate_output to avoid performance penalty.";
     allocator_attr.scope_id = -1;
   }
+  if (params_->step_temp_allocator != nullptr && allocator_attr.value == 0 &&
+      allocation_attr.freed_by_func == nullptr && !track_allocations()) {
+    Status s = allocate_tensor(params_->step_temp_allocator, type, shape,
+                               out_temp, allocation_attr);
+    if (record_memory_consumption_) {
+      mutex_lock l(stats_mu_);
+      temp_memory_allocated_ += out_temp->TotalBytes();
+    }
+    return s;
+  }
   Status s =
       allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
@@ -667,6 +667,11 @@ class OpKernelContext {
     // stored in this container..
     ScopedStepContainer* step_container = nullptr;
 
+    // If not null, allocate_temp() calls with default allocator attributes
+    // are served by this allocator, which is expected to be cheaper than the
+    // device allocator for buffers that die within the step.
+    Allocator* step_temp_allocator = nullptr;
+
     // Mechanism used by this op kernel invocation to communicate with
     // computations running on other devices.
     Rendezvous* rendezvous = nullptr;
@@ -724,6 +729,11 @@ class OpKernelContext {
     // Values in [0,...) represent reservations for the indexed output.
     const int* forward_from_array = nullptr;
 
+    // If set, input_forwardable_array[i] is false when the buffer of input i
+    // is known at graph construction time to be shared with its producer,
+    // e.g. a Const, so forward_input() need not check it.
+    const bool* input_forwardable_array = nullptr;
+
     // For tracking actively running deferred ops.
     std::function<void()> inc_num_deferred_ops_function = []() {};
     std::function<void()> dec_num_deferred_ops_function = []() {};
@@ -889,6 +899,9 @@ class OpKernelContext {
   //     never assigned a forwarded input:
   //        forward_from_array[output_index] == kNeverForward
   //
+  //   * input_forwardable_array is nullptr or input_forwardable_array[
+  //     input_index] is true, unless input_index is reserved for output_index.
+  //
   // Otherwise returns nullptr.
   // NOTE: For Cuda kernels that read inputs using the __ldg() intrinsic,
   // forwarding is only safe if there are no reads via __ldg() after writes
@@ -1305,6 +1318,10 @@ class OpKernelContext {
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
 
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
+
   // Initialize the allocated_scope_ids_ set the first time this method is
   // called.
   void maybe_initialize_scope_id_set();
@@ -401,6 +401,35 @@ TEST_F(OpKernelTest, InputDtype) {
   EXPECT_EQ(dtype, DT_INT32);
 }
 
+TEST_F(OpKernelTest, ForwardInputHonorsForwardableHint) {
+  Env* env = Env::Default();
+  OpKernelContext::Params params;
+  params.record_tensor_accesses = false;
+  auto device =
+      absl::make_unique<DummyDevice>(env, params.record_tensor_accesses);
+  params.device = device.get();
+  Status status;
+  std::unique_ptr<OpKernel> op(
+      CreateOpKernel(DEVICE_CPU, params.device, cpu_allocator(),
+                     CreateNodeDef("Test4", {DT_FLOAT}), TF_GRAPH_DEF_VERSION,
+                     &status));
+  EXPECT_TRUE(status.ok());
+  params.op_kernel = op.get();
+  Tensor a(DT_FLOAT, TensorShape({2}));
+  gtl::InlinedVector<TensorValue, 4> inputs{TensorValue(&a)};
+  params.inputs = &inputs;
+
+  auto ctx = absl::make_unique<OpKernelContext>(&params);
+  EXPECT_NE(nullptr, ctx->forward_input(0, 0, DT_FLOAT, TensorShape({2}),
+                                        DEVICE_MEMORY, AllocatorAttributes()));
+
+  const bool input_forwardable[] = {false};
+  params.input_forwardable_array = input_forwardable;
+  ctx = absl::make_unique<OpKernelContext>(&params);
+  EXPECT_EQ(nullptr, ctx->forward_input(0, 0, DT_FLOAT, TensorShape({2}),
+                                        DEVICE_MEMORY, AllocatorAttributes()));
+}
+
 // A mock device that mimics the behavior of scoped allocator upon calling
 // GetAllocator with a positive scope_id.
 class ScopedAllocatorDevice : public DeviceBase {
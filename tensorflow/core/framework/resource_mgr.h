@@ -150,6 +150,14 @@ class ResourceMgr {
                     std::vector<std::unique_ptr<T, core::RefCountDeleter>>*
                         resources) const TF_MUST_USE_RESULT;
 
+  // Returns all the resources of type T, in all containers. The caller takes
+  // the ownership of one ref on each of them.
+  //
+  // REQUIRES: std::is_base_of<ResourceBase, T>
+  template <typename T>
+  void GetAll(
+      std::vector<std::unique_ptr<T, core::RefCountDeleter>>* resources) const;
+
   // If "container" has a resource "name", returns it in
   // "*resource". Otherwise, invokes creator() to create the resource.
   // The caller takes the ownership of one ref on "*resource".
@@ -489,6 +497,24 @@ Status ResourceMgr::LookupMany(
   return Status::OK();
 }
 
+template <typename T>
+void ResourceMgr::GetAll(
+    std::vector<std::unique_ptr<T, core::RefCountDeleter>>* resources) const {
+  CheckDeriveFromResourceBase<T>();
+  const uint64 hash_code = MakeTypeIndex<T>().hash_code();
+  tf_shared_lock l(mu_);
+  for (const auto& p : containers_) {
+    for (const auto& q : *p.second) {
+      if (q.first.first == hash_code) {
+        q.second->Ref();
+        // It's safe to down cast since typeid(T).hash_code() is part of the
+        // map key.
+        resources->emplace_back(static_cast<T*>(q.second));
+      }
+    }
+  }
+}
+
 // Simple wrapper to allow conditional dynamic / static casts.
 template <typename T, bool use_dynamic_cast>
 struct TypeCastFunctor {
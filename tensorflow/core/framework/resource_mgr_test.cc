@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_mgr.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -126,6 +128,27 @@ TEST(ResourceMgrTest, Basic) {
   TF_CHECK_OK(rm.Cleanup("bar"));
 }
 
+TEST(ResourceMgrTest, GetAll) {
+  ResourceMgr rm;
+  TF_CHECK_OK(rm.Create("foo", "bar", new Resource("cat")));
+  TF_CHECK_OK(rm.Create("baz", "bar", new Resource("dog")));
+  TF_CHECK_OK(rm.Create("foo", "bar", new Other("tiger")));
+
+  std::vector<std::unique_ptr<Resource, core::RefCountDeleter>> resources;
+  rm.GetAll(&resources);
+  std::vector<string> labels;
+  for (const auto& r : resources) {
+    labels.push_back(r->DebugString());
+  }
+  std::sort(labels.begin(), labels.end());
+  EXPECT_EQ(labels, std::vector<string>({"R/cat", "R/dog"}));
+
+  std::vector<std::unique_ptr<Other, core::RefCountDeleter>> others;
+  rm.GetAll(&others);
+  ASSERT_EQ(others.size(), 1);
+  EXPECT_EQ(others[0]->DebugString(), "O/tiger");
+}
+
 TEST(ResourceMgrTest, CreateOrLookup) {
   ResourceMgr rm;
   EXPECT_EQ("R/cat", LookupOrCreate<Resource>(&rm, "foo", "bar", "cat"));
@@ -17,6 +17,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/run_handler.h"
 
+#include <algorithm>
+#include <limits>
+#include <set>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
@@ -136,7 +140,10 @@ class RunHandlerThreadPool {
 
   struct ThreadWorkSource {
     ThreadWorkSource()
-        : blocking_inflight(0), non_blocking_inflight(0), traceme_id(0) {}
+        : blocking_inflight(0),
+          non_blocking_inflight(0),
+          traceme_id(0),
+          priority(0) {}
     Queue blocking_work_queue;
     std::atomic<int64> blocking_inflight;
     mutex blocking_mu;
@@ -144,6 +151,8 @@ class RunHandlerThreadPool {
     std::atomic<int64> non_blocking_inflight;
     mutex non_blocking_mu;
     std::atomic<int64> traceme_id;
+    // Priority of the handler owning the queues.
+    std::atomic<int64> priority;
   };
 
   void AddWorkToQueue(Queue* q, mutex* mu, bool inter_work,
@@ -236,8 +245,16 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
       // by some other thread when a session run starts/finishes.
       mutex_lock l(thread_data_[thread_id].mu);
 
+      // Sources are sorted by decreasing priority. Once inter-op work of
+      // some priority had to be left waiting, work of lower priority is not
+      // stolen, so that it does not delay the waiting work further.
+      int64 waiting_priority = std::numeric_limits<int64>::min();
       for (int i = 0; i < thread_work_sources->size(); ++i) {
         ThreadWorkSource* tws = (*thread_work_sources)[i];
+        if (tws->priority.load(std::memory_order_relaxed) <
+            waiting_priority) {
+          break;
+        }
         // We want a smallish numbers of inter threads since
         // otherwise there will be contention in PropagateOutputs.
         // This is best effort policy.
@@ -251,6 +268,10 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
             traceme_id = tws->traceme_id.load(std::memory_order_relaxed);
             break;
           }
+        } else if (may_steal_blocking_work &&
+                   waiting_priority == std::numeric_limits<int64>::min() &&
+                   !tws->blocking_work_queue.Empty()) {
+          waiting_priority = tws->priority.load(std::memory_order_relaxed);
         }
         t = tws->non_blocking_work_queue.PopBack();
         if (t.f) {
@@ -315,11 +336,14 @@ class RunHandler::Impl {
   // Stores now time (in microseconds) since unix epoch when the handler is
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
+  // Deadline in microseconds since unix epoch, or kuint64max if none.
+  uint64 deadline_us() const { return deadline_us_; }
+  int64 priority() const { return priority_; }
   int64 step_id() const { return step_id_; }
   void ScheduleInterOpClosure(std::function<void()> fn);
   void ScheduleIntraOpClosure(std::function<void()> fn);
 
-  void Reset(int64 step_id);
+  void Reset(int64 step_id, int64 timeout_in_ms, int64 priority);
 
   RunHandlerPool::Impl* pool_impl() { return pool_impl_; }
 
@@ -341,6 +365,8 @@ class RunHandler::Impl {
 
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  uint64 deadline_us_;
+  int64 priority_;
   int64 step_id_;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   RunHandlerThreadPool::ThreadWorkSource tws_;
@@ -380,22 +406,31 @@ class RunHandlerPool::Impl {
     return run_handler_thread_pool_.get();
   }
 
-  std::unique_ptr<RunHandler> Get(int64 step_id) LOCKS_EXCLUDED(mu_) {
+  std::unique_ptr<RunHandler> Get(int64 step_id, int64 timeout_in_ms,
+                                  int64 priority) LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
-    while (free_handlers_.empty()) {
+    auto waiting = waiting_priorities_.insert(priority);
+    while (free_handlers_.empty() || *waiting_priorities_.rbegin() > priority) {
       one_handler_free_.wait(l);
     }
-    // Remove the last entry from free_handlers_ and add to the end of
-    // sorted_active_handlers_.
+    waiting_priorities_.erase(waiting);
+    // Remove the last entry from free_handlers_ and insert it into
+    // sorted_active_handlers_ after all handlers that take precedence.
     auto* handler_impl = free_handlers_.back();
-    handler_impl->Reset(step_id);
-    // Sortedness isn't violated if we simply add at the end of the list, since
-    // handlers are expected to be obtained in increasing order of time.
-    sorted_active_handlers_.push_back(handler_impl);
+    handler_impl->Reset(step_id, timeout_in_ms, priority);
+    sorted_active_handlers_.insert(
+        std::upper_bound(sorted_active_handlers_.begin(),
+                         sorted_active_handlers_.end(), handler_impl,
+                         TakesPrecedence),
+        handler_impl);
     DCHECK_LE(sorted_active_handlers_.size(), max_handlers_);
     free_handlers_.pop_back();
 
     RecomputePoolStatsLocked();
+    if (!free_handlers_.empty() && !waiting_priorities_.empty()) {
+      // A caller of lower priority may be able to proceed now.
+      one_handler_free_.notify_all();
+    }
     return WrapUnique<RunHandler>(new RunHandler(handler_impl));
   }
 
@@ -427,12 +462,23 @@ class RunHandlerPool::Impl {
 
       RecomputePoolStatsLocked();
     }
-    one_handler_free_.notify_one();
+    // Waiting callers proceed by priority, so let them all re-check.
+    one_handler_free_.notify_all();
   }
 
  private:
   void RecomputePoolStatsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns true if the work of `a` is to be run before that of `b`.
+  static bool TakesPrecedence(const RunHandler::Impl* a,
+                              const RunHandler::Impl* b) {
+    if (a->priority() != b->priority()) return a->priority() > b->priority();
+    if (a->deadline_us() != b->deadline_us()) {
+      return a->deadline_us() < b->deadline_us();
+    }
+    return a->start_time_us() < b->start_time_us();
+  }
+
   // Maximum number of handlers pre-created during pool construction time. The
   // number has been chosen expecting each handler might at least want 1
   // inter-op thread for execution (during compute intensive workloads like
@@ -441,9 +487,10 @@ class RunHandlerPool::Impl {
 
   std::unique_ptr<RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
-  // TODO(azaks): sort by the remaining latency budget.
+  // Handlers are sorted by TakesPrecedence().
   std::vector<RunHandler::Impl*> sorted_active_handlers_ GUARDED_BY(mu_);
+  // Priorities of the callers blocked in Get().
+  std::multiset<int64> waiting_priorities_ GUARDED_BY(mu_);
   std::vector<RunHandler::Impl*> free_handlers_ GUARDED_BY(mu_);
   std::vector<std::unique_ptr<RunHandler::Impl>> handlers_ GUARDED_BY(mu_);
   // Histogram of elapsed runtime of every handler (in ms).
@@ -512,7 +559,7 @@ void RunHandler::Impl::ThreadPoolInterfaceWrapper::Schedule(
 RunHandler::Impl::Impl(RunHandlerPool::Impl* pool_impl)
     : pool_impl_(pool_impl) {
   thread_pool_interface_.reset(new ThreadPoolInterfaceWrapper(this));
-  Reset(0);
+  Reset(0, 0, 0);
 }
 
 void RunHandler::Impl::ScheduleInterOpClosure(std::function<void()> fn) {
@@ -531,10 +578,15 @@ void RunHandler::Impl::ScheduleIntraOpClosure(std::function<void()> fn) {
       &tws()->traceme_id, std::move(fn));
 }
 
-void RunHandler::Impl::Reset(int64 step_id) {
+void RunHandler::Impl::Reset(int64 step_id, int64 timeout_in_ms,
+                             int64 priority) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  deadline_us_ = timeout_in_ms > 0 ? start_time_us_ + timeout_in_ms * 1000
+                                   : kuint64max;
+  priority_ = priority;
   step_id_ = step_id;
   tws_.traceme_id = step_id;
+  tws_.priority = priority;
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -546,8 +598,10 @@ RunHandlerPool::RunHandlerPool(int num_inter_op_threads,
 
 RunHandlerPool::~RunHandlerPool() {}
 
-std::unique_ptr<RunHandler> RunHandlerPool::Get(int64 step_id) {
-  return impl_->Get(step_id);
+std::unique_ptr<RunHandler> RunHandlerPool::Get(int64 step_id,
+                                                int64 timeout_in_ms,
+                                                int64 priority) {
+  return impl_->Get(step_id, timeout_in_ms, priority);
 }
 
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
@@ -61,8 +61,15 @@ class RunHandlerPool {
   // and is being used by a client.  It becomes 'inactive' once more when the
   // unique_ptr is destroyed.
   //
-  // Will block unless there is an inactive handler.
-  std::unique_ptr<RunHandler> Get(int64 step_id = 0);
+  // Will block unless there is an inactive handler that no caller with a
+  // higher `priority` is waiting for.
+  //
+  // Work of active handlers with a higher `priority` is run first, and among
+  // handlers of the same priority, that of the handler with the earliest
+  // deadline (`timeout_in_ms` after the call, if positive) or else of the
+  // oldest handler.
+  std::unique_ptr<RunHandler> Get(int64 step_id = 0, int64 timeout_in_ms = 0,
+                                  int64 priority = 0);
 
  private:
   class Impl;
@@ -74,7 +81,7 @@ class RunHandlerPool {
 // RunHandler can be used to schedule inter/intra-op closures to run on a global
 // pool shared across all Session::Run(s). The closures are enqueued to a
 // handler specific queue, from which the work is stolen in a priority order
-// (time of the Get() call).
+// (priority, deadline and time of the Get() call).
 //
 // It can only be created via RunHandlerPool::Get().
 //
@@ -25,6 +25,7 @@ limitations under the License.
 #include "absl/synchronization/barrier.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -78,5 +79,62 @@ TEST(RunHandlerUtilTest, TestBasicScheduling) {
   counter.Wait();
 }
 
+// Runs one closure from each of two handlers obtained with the given
+// timeouts and priorities on a single inter-op thread, and returns the order
+// in which they ran.
+std::vector<string> RunInOrder(int64 first_timeout_in_ms, int64 first_priority,
+                               int64 second_timeout_in_ms,
+                               int64 second_priority) {
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(1, 0));
+  auto first = pool->Get(1, first_timeout_in_ms, first_priority);
+  // Keep the only thread busy until both closures are queued.
+  Notification blocker;
+  BlockingCounter started(1);
+  first->ScheduleInterOpClosure([&blocker, &started]() {
+    started.DecrementCount();
+    blocker.WaitForNotification();
+  });
+  started.Wait();
+
+  auto second = pool->Get(2, second_timeout_in_ms, second_priority);
+  mutex mu;
+  std::vector<string> order;
+  BlockingCounter done(2);
+  first->ScheduleInterOpClosure([&mu, &order, &done]() {
+    {
+      mutex_lock l(mu);
+      order.push_back("first");
+    }
+    done.DecrementCount();
+  });
+  second->ScheduleInterOpClosure([&mu, &order, &done]() {
+    {
+      mutex_lock l(mu);
+      order.push_back("second");
+    }
+    done.DecrementCount();
+  });
+  blocker.Notify();
+  done.Wait();
+  return order;
+}
+
+TEST(RunHandlerUtilTest, TestArrivalOrder) {
+  EXPECT_EQ(std::vector<string>({"first", "second"}), RunInOrder(0, 0, 0, 0));
+}
+
+TEST(RunHandlerUtilTest, TestPriorityOrder) {
+  EXPECT_EQ(std::vector<string>({"second", "first"}), RunInOrder(0, 0, 0, 1));
+  EXPECT_EQ(std::vector<string>({"first", "second"}),
+            RunInOrder(0, 1, 1000, 0));
+}
+
+TEST(RunHandlerUtilTest, TestDeadlineOrder) {
+  EXPECT_EQ(std::vector<string>({"second", "first"}),
+            RunInOrder(0, 0, 60000, 0));
+  EXPECT_EQ(std::vector<string>({"first", "second"}),
+            RunInOrder(1000, 0, 60000, 0));
+}
+
 }  // namespace
 }  // namespace tensorflow
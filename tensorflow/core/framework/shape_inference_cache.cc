@@ -0,0 +1,215 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/shape_inference_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace shape_inference {
+
+namespace {
+
+auto* shape_inference_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/shape_inference_cache",
+    "The number of shape inference cache lookups.", "result");
+
+// Nodes with large attrs, such as the value of a Const, are not worth the
+// memory: their keys are longer than their shape functions are slow.
+constexpr size_t kMaxKeyBytes = 4096;
+
+}  // namespace
+
+ShapeInferenceCache::ShapeInferenceCache(int64 max_entries)
+    : max_entries_(std::max<int64>(max_entries, 1)) {}
+
+/* static */
+ShapeInferenceCache* ShapeInferenceCache::Global() {
+  static ShapeInferenceCache* cache = new ShapeInferenceCache(16384);
+  return cache;
+}
+
+bool ShapeInferenceCache::MakeKey(const OpRegistrationData& op_reg_data,
+                                  InferenceContext* c, string* key) const {
+  if (op_reg_data.is_function_op || !op_reg_data.shape_inference_fn) {
+    return false;
+  }
+  // Ops of a function library can share names with other ops.
+  const OpRegistrationData* registered;
+  if (!OpRegistry::Global()->LookUp(op_reg_data.op_def.name(), &registered)
+           .ok() ||
+      registered != &op_reg_data) {
+    return false;
+  }
+
+  *key = strings::StrCat(op_reg_data.op_def.name(), ";",
+                         c->graph_def_version(), ";");
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    // A shape function that saw input values in an earlier run may not
+    // depend on the input shapes alone.
+    if (c->requested_input_tensor(i) ||
+        c->requested_input_tensor_as_partial_shape(i) ||
+        c->input_handle_shapes_and_types(i) != nullptr) {
+      return false;
+    }
+    const ShapeHandle input = c->input(i);
+    if (!c->FullyDefined(input)) {
+      return false;
+    }
+    strings::StrAppend(key, "[");
+    for (int j = 0; j < c->Rank(input); ++j) {
+      strings::StrAppend(key, c->Value(c->Dim(input, j)), ",");
+    }
+    strings::StrAppend(key, "]");
+  }
+
+  // The attrs of a NodeDef are a map, so sort them by name.
+  std::vector<std::pair<string, const AttrValue*>> attrs;
+  attrs.reserve(c->attrs().size());
+  for (const auto& attr : c->attrs()) {
+    attrs.emplace_back(attr.first, &attr.second);
+  }
+  std::sort(attrs.begin(), attrs.end());
+  string serialized;
+  for (const auto& attr : attrs) {
+    if (!SerializeToStringDeterministic(*attr.second, &serialized)) {
+      return false;
+    }
+    strings::StrAppend(key, ";", attr.first, "=", serialized.size(), ":",
+                       serialized);
+    if (key->size() > kMaxKeyBytes) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status ShapeInferenceCache::Run(const OpRegistrationData& op_reg_data,
+                                InferenceContext* c) {
+  string key;
+  if (!MakeKey(op_reg_data, c, &key)) {
+    return c->Run(op_reg_data.shape_inference_fn);
+  }
+
+  std::vector<CachedShape> outputs;
+  bool hit = false;
+  {
+    mutex_lock l(mu_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      outputs = it->second;
+      hit = true;
+      ++stats_.hits;
+    } else {
+      ++stats_.misses;
+    }
+  }
+  shape_inference_cache_lookups->GetCell(hit ? "hit" : "miss")->IncrementBy(1);
+
+  if (hit) {
+    return c->Run([&outputs](InferenceContext* c) {
+      std::vector<DimensionHandle> unknown_dims;
+      for (int i = 0; i < c->num_outputs(); ++i) {
+        const CachedShape& output = outputs[i];
+        if (!output.rank_known) {
+          c->set_output(i, c->UnknownShape());
+          continue;
+        }
+        std::vector<DimensionHandle> dims;
+        dims.reserve(output.dims.size());
+        for (const int64 dim : output.dims) {
+          if (dim >= 0) {
+            dims.push_back(c->MakeDim(dim));
+            continue;
+          }
+          const size_t index = -1 - dim;
+          while (unknown_dims.size() <= index) {
+            unknown_dims.push_back(c->UnknownDim());
+          }
+          dims.push_back(unknown_dims[index]);
+        }
+        c->set_output(i, c->MakeShape(dims));
+      }
+      return Status::OK();
+    });
+  }
+
+  TF_RETURN_IF_ERROR(c->Run(op_reg_data.shape_inference_fn));
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    if (c->requested_input_tensor(i) ||
+        c->requested_input_tensor_as_partial_shape(i)) {
+      return Status::OK();
+    }
+  }
+  outputs.resize(c->num_outputs());
+  // Unknown dimensions are numbered in the order they first appear.
+  std::vector<DimensionHandle> unknown_dims;
+  for (int i = 0; i < c->num_outputs(); ++i) {
+    if (c->output_handle_shapes_and_types(i) != nullptr) {
+      return Status::OK();
+    }
+    const ShapeHandle output = c->output(i);
+    CachedShape& cached = outputs[i];
+    cached.rank_known = c->RankKnown(output);
+    if (!cached.rank_known) continue;
+    cached.dims.reserve(c->Rank(output));
+    for (int j = 0; j < c->Rank(output); ++j) {
+      const DimensionHandle dim = c->Dim(output, j);
+      if (c->ValueKnown(dim)) {
+        cached.dims.push_back(c->Value(dim));
+        continue;
+      }
+      size_t index = 0;
+      while (index < unknown_dims.size() &&
+             !unknown_dims[index].SameHandle(dim)) {
+        ++index;
+      }
+      if (index == unknown_dims.size()) {
+        unknown_dims.push_back(dim);
+      }
+      cached.dims.push_back(-1 - static_cast<int64>(index));
+    }
+  }
+
+  mutex_lock l(mu_);
+  if (static_cast<int64>(entries_.size()) >= max_entries_) {
+    entries_.clear();
+  }
+  entries_.emplace(std::move(key), std::move(outputs));
+  return Status::OK();
+}
+
+ShapeInferenceCache::Stats ShapeInferenceCache::GetStats() {
+  mutex_lock l(mu_);
+  Stats stats = stats_;
+  stats.num_entries = entries_.size();
+  return stats;
+}
+
+void ShapeInferenceCache::Clear() {
+  mutex_lock l(mu_);
+  entries_.clear();
+  stats_ = Stats();
+}
+
+}  // namespace shape_inference
+}  // namespace tensorflow
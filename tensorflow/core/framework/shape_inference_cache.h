@@ -0,0 +1,96 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_FRAMEWORK_SHAPE_INFERENCE_CACHE_H_
+#define TENSORFLOW_CORE_FRAMEWORK_SHAPE_INFERENCE_CACHE_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/op_def_builder.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace shape_inference {
+
+// Memoizes the output shapes that the shape functions of registered ops infer,
+// so that graphs with many identical nodes, or graphs that are built and
+// optimized several times, run each shape function once per distinct input.
+//
+// A result is keyed by the op, the graph def version, the node attrs and the
+// input shapes. It is only cached when it cannot depend on anything else:
+// the op must come from the global op registry, all input shapes must be fully
+// defined, the inputs must carry no resource or variant handle data, and the
+// shape function must neither ask for the value of an input tensor nor set
+// handle data on its outputs. Failed shape functions are not cached.
+//
+// The number of cached results is bounded; the cache starts over when it is
+// full. Lookups are exported as the "/tensorflow/core/shape_inference_cache"
+// metric.
+//
+// Thread-safe.
+class ShapeInferenceCache {
+ public:
+  struct Stats {
+    int64 hits = 0;
+    int64 misses = 0;
+    int64 num_entries = 0;
+  };
+
+  explicit ShapeInferenceCache(int64 max_entries);
+
+  // The process-wide cache used by ShapeRefiner and Grappler.
+  static ShapeInferenceCache* Global();
+
+  // Runs the shape function of `op_reg_data` in `c`, or sets the outputs of
+  // `c` to the shapes that the function inferred for an identical node.
+  Status Run(const OpRegistrationData& op_reg_data, InferenceContext* c);
+
+  Stats GetStats();
+
+  // Forgets all cached results and resets the stats.
+  void Clear();
+
+ private:
+  // The shape of an output. A known dimension is stored as its size and an
+  // unknown dimension as -1 - k, where the unknown dimensions with the same k
+  // are the same dimension.
+  struct CachedShape {
+    bool rank_known = false;
+    std::vector<int64> dims;
+  };
+
+  // Returns false if the results of `c` cannot be cached.
+  bool MakeKey(const OpRegistrationData& op_reg_data, InferenceContext* c,
+               string* key) const;
+
+  const int64 max_entries_;
+
+  mutex mu_;
+  std::unordered_map<string, std::vector<CachedShape>> entries_ GUARDED_BY(mu_);
+  Stats stats_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShapeInferenceCache);
+};
+
+}  // namespace shape_inference
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_SHAPE_INFERENCE_CACHE_H_
@@ -0,0 +1,139 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/shape_inference_cache.h"
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace shape_inference {
+namespace {
+
+int num_shape_fn_calls = 0;
+
+// Outputs the input shape, and a matrix whose two dimensions are the same
+// unknown dimension. Reads the value of the input if `read_input` is set.
+REGISTER_OP("ShapeInferenceCacheTestOp")
+    .Input("x: T")
+    .Output("y: T")
+    .Output("z: T")
+    .Attr("T: {float, int32}")
+    .Attr("read_input: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ++num_shape_fn_calls;
+      bool read_input;
+      TF_RETURN_IF_ERROR(c->GetAttr("read_input", &read_input));
+      if (read_input) {
+        c->input_tensor(0);
+      }
+      c->set_output(0, c->input(0));
+      DimensionHandle dim = c->UnknownDim();
+      c->set_output(1, c->Matrix(dim, dim));
+      return Status::OK();
+    });
+
+class ShapeInferenceCacheTest : public ::testing::Test {
+ protected:
+  ShapeInferenceCacheTest() : cache_(10) {
+    TF_CHECK_OK(
+        OpRegistry::Global()->LookUp("ShapeInferenceCacheTestOp", &op_data_));
+    num_shape_fn_calls = 0;
+  }
+
+  NodeDef MakeNode(DataType dtype, bool read_input) {
+    NodeDef def;
+    TF_CHECK_OK(NodeDefBuilder("node", "ShapeInferenceCacheTestOp")
+                    .Input(FakeInput(dtype))
+                    .Attr("read_input", read_input)
+                    .Finalize(&def));
+    return def;
+  }
+
+  // Runs the test op on `input_shape` through the cache and returns the
+  // inferred output shapes.
+  string Run(const NodeDef& def, const PartialTensorShape& input_shape) {
+    InferenceContext c(TF_GRAPH_DEF_VERSION, &def, op_data_->op_def,
+                       {input_shape}, {}, {}, {});
+    TF_CHECK_OK(c.construction_status());
+    TF_CHECK_OK(cache_.Run(*op_data_, &c));
+    EXPECT_TRUE(c.Dim(c.output(1), 0).SameHandle(c.Dim(c.output(1), 1)));
+    return strings::StrCat(c.DebugString(c.output(0)), " ",
+                           c.DebugString(c.output(1)));
+  }
+
+  ShapeInferenceCache cache_;
+  const OpRegistrationData* op_data_ = nullptr;
+};
+
+TEST_F(ShapeInferenceCacheTest, ReusesResultForSameInputsAndAttrs) {
+  const NodeDef def = MakeNode(DT_FLOAT, false);
+  EXPECT_EQ("[2,3] [?,?]", Run(def, PartialTensorShape({2, 3})));
+  EXPECT_EQ("[2,3] [?,?]", Run(def, PartialTensorShape({2, 3})));
+  EXPECT_EQ(1, num_shape_fn_calls);
+
+  ShapeInferenceCache::Stats stats = cache_.GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(1, stats.num_entries);
+}
+
+TEST_F(ShapeInferenceCacheTest, KeysOnInputShapesAndAttrs) {
+  EXPECT_EQ("[2,3] [?,?]",
+            Run(MakeNode(DT_FLOAT, false), PartialTensorShape({2, 3})));
+  EXPECT_EQ("[3,2] [?,?]",
+            Run(MakeNode(DT_FLOAT, false), PartialTensorShape({3, 2})));
+  EXPECT_EQ("[2,3] [?,?]",
+            Run(MakeNode(DT_INT32, false), PartialTensorShape({2, 3})));
+  EXPECT_EQ(3, num_shape_fn_calls);
+  EXPECT_EQ(0, cache_.GetStats().hits);
+  EXPECT_EQ(3, cache_.GetStats().num_entries);
+}
+
+TEST_F(ShapeInferenceCacheTest, DoesNotCachePartiallyDefinedInputs) {
+  const NodeDef def = MakeNode(DT_FLOAT, false);
+  EXPECT_EQ("[?,3] [?,?]", Run(def, PartialTensorShape({-1, 3})));
+  EXPECT_EQ("[?,3] [?,?]", Run(def, PartialTensorShape({-1, 3})));
+  EXPECT_EQ(2, num_shape_fn_calls);
+  EXPECT_EQ(0, cache_.GetStats().misses);
+}
+
+TEST_F(ShapeInferenceCacheTest, DoesNotCacheShapeFnsThatReadInputValues) {
+  const NodeDef def = MakeNode(DT_FLOAT, true);
+  Run(def, PartialTensorShape({2, 3}));
+  Run(def, PartialTensorShape({2, 3}));
+  EXPECT_EQ(2, num_shape_fn_calls);
+  EXPECT_EQ(0, cache_.GetStats().num_entries);
+}
+
+TEST_F(ShapeInferenceCacheTest, StartsOverWhenFull) {
+  const NodeDef def = MakeNode(DT_FLOAT, false);
+  for (int i = 0; i < 11; ++i) {
+    Run(def, PartialTensorShape({i}));
+  }
+  EXPECT_EQ(1, cache_.GetStats().num_entries);
+  cache_.Clear();
+  EXPECT_EQ(0, cache_.GetStats().misses);
+}
+
+}  // namespace
+}  // namespace shape_inference
+}  // namespace tensorflow
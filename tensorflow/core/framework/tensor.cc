@@ -51,6 +51,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
@@ -464,6 +465,105 @@ Buffer<T>::~Buffer() {
   }
 }
 
+// Ref-counted buffer that stores a small payload of a simple type next to
+// its reference count, so that a small tensor costs a single allocation.
+// The allocations are recycled through a per-thread free list.
+class InlineBuffer : public BufferBase {
+ public:
+  // Tensors of at most this many bytes may use an InlineBuffer.
+  static constexpr size_t kMaxBytes = 64;
+
+  InlineBuffer(Allocator* a, size_t size)
+      : BufferBase(a, storage_), size_(size) {
+    DCHECK_LE(size, kMaxBytes);
+  }
+
+  size_t size() const override { return size_; }
+
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
+
+  // Returns true if a tensor of `num_elements` elements of `type` allocated
+  // by `a` may use an InlineBuffer instead of a Buffer<T>. Only the plain CPU
+  // allocator qualifies, and only when it is not being tracked, since the
+  // payload does not come from `a`. Allocations with non-default `attr` go
+  // to `a`, which is the one to interpret them.
+  static bool CanUse(Allocator* a, DataType type, int64 num_elements,
+                     const AllocationAttributes* attr = nullptr) {
+    return num_elements > 0 && DataTypeCanUseMemcpy(type) &&
+           num_elements * DataTypeSize(type) <= static_cast<int64>(kMaxBytes) &&
+           a == cpu_allocator_base() && !CPUAllocatorStatsEnabled() &&
+           !LogMemory::IsEnabled() &&
+           (attr == nullptr ||
+            (!attr->no_retry_on_failure && attr->freed_by_func == nullptr));
+  }
+
+ private:
+  // Keeps up to kMaxFreeBuffers released allocations of the current thread.
+  struct FreeList {
+    static constexpr size_t kMaxFreeBuffers = 256;
+
+    ~FreeList();
+
+    std::vector<void*> buffers;
+  };
+
+  // Returns the free list of the current thread, or nullptr once it has been
+  // destroyed at thread exit, e.g. when the destructor of another
+  // thread_local releases a tensor.
+  static FreeList* GetFreeList();
+
+  // Set when the current thread's free list has been destroyed. Trivially
+  // destructible, so it stays valid for the rest of the thread exit.
+  static thread_local bool free_list_destroyed_;
+
+  ~InlineBuffer() override {}
+
+  const size_t size_;
+  alignas(Allocator::kAllocatorAlignment) char storage_[kMaxBytes];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+constexpr size_t InlineBuffer::kMaxBytes;
+
+thread_local bool InlineBuffer::free_list_destroyed_ = false;
+
+InlineBuffer::FreeList::~FreeList() {
+  free_list_destroyed_ = true;
+  for (void* ptr : buffers) {
+    port::AlignedFree(ptr);
+  }
+}
+
+InlineBuffer::FreeList* InlineBuffer::GetFreeList() {
+  if (free_list_destroyed_) return nullptr;
+  static thread_local FreeList free_list;
+  return &free_list;
+}
+
+void* InlineBuffer::operator new(size_t size) {
+  DCHECK_EQ(size, sizeof(InlineBuffer));
+  FreeList* free_list = GetFreeList();
+  if (free_list != nullptr && !free_list->buffers.empty()) {
+    void* ptr = free_list->buffers.back();
+    free_list->buffers.pop_back();
+    return ptr;
+  }
+  return port::AlignedMalloc(sizeof(InlineBuffer),
+                             Allocator::kAllocatorAlignment);
+}
+
+void InlineBuffer::operator delete(void* ptr) {
+  FreeList* free_list = GetFreeList();
+  if (free_list != nullptr &&
+      free_list->buffers.size() < FreeList::kMaxFreeBuffers) {
+    free_list->buffers.push_back(ptr);
+  } else {
+    port::AlignedFree(ptr);
+  }
+}
+
 // Allocates a T[n] buffer. Fills in the buffer with repeated values
 // in "in".  If "in" has less values than "n", fills the rest of T[n]
 // with the last value. If "in" has no values, fills T[n] with the
@@ -738,7 +838,9 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape)
     : shape_(shape), buf_(nullptr) {
   set_dtype(type);
   CHECK_NOTNULL(a);
-  if (shape_.num_elements() > 0 || a->AllocatesOpaqueHandle()) {
+  if (InlineBuffer::CanUse(a, type, shape_.num_elements())) {
+    buf_ = new InlineBuffer(a, shape_.num_elements() * DataTypeSize(type));
+  } else if (shape_.num_elements() > 0 || a->AllocatesOpaqueHandle()) {
     CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
   }
   if (buf_ != nullptr && buf_->data() != nullptr && LogMemory::IsEnabled()) {
@@ -752,7 +854,9 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape,
     : shape_(shape), buf_(nullptr) {
   set_dtype(type);
   CHECK_NOTNULL(a);
-  if (shape_.num_elements() > 0 || a->AllocatesOpaqueHandle()) {
+  if (InlineBuffer::CanUse(a, type, shape_.num_elements(), &allocation_attr)) {
+    buf_ = new InlineBuffer(a, shape_.num_elements() * DataTypeSize(type));
+  } else if (shape_.num_elements() > 0 || a->AllocatesOpaqueHandle()) {
     CASES(type, buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
   }
   if (!allocation_attr.allocation_will_be_logged && buf_ != nullptr &&
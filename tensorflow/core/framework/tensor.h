@@ -619,6 +619,10 @@ class Tensor {
   friend class XlaTensor;             // For access to RefCountIsOne().
   friend class XlaTensorBuffer;  // For access to the private constructor taking
                                  // the buffer
+  friend class BundleReader;     // For access to the private constructor taking
+                                 // the buffer
+  friend class TensorResponse;   // For access to the private constructor taking
+                                 // the buffer
   friend class Var;
   template <typename Device, typename T>
   friend class AssignVariableOp;  // For access to RefCountIsOne().
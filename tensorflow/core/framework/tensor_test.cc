@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -84,6 +85,49 @@ TEST(TensorTest, Default) {
   EXPECT_EQ(t.NumElements(), 0);
 }
 
+TEST(TensorTest, SmallTensorsOnCpuAllocator) {
+  // Small tensors of simple types keep their payload inside the buffer
+  // object. They must behave like any other tensor.
+  std::vector<Tensor> tensors;
+  for (int i = 0; i < 1000; ++i) {
+    Tensor t(cpu_allocator_base(), DT_INT64, TensorShape({8}));
+    EXPECT_TRUE(t.IsAligned());
+    EXPECT_EQ(64, t.TotalBytes());
+    t.flat<int64>().setConstant(i);
+    tensors.push_back(t);
+    if (i % 3 == 0) tensors.erase(tensors.begin());
+  }
+  for (const Tensor& t : tensors) {
+    const int64 value = t.flat<int64>()(0);
+    test::ExpectTensorEqual<int64>(
+        t, test::AsTensor<int64>(std::vector<int64>(8, value), {8}));
+  }
+
+  Tensor scalar(cpu_allocator_base(), DT_FLOAT, TensorShape({}));
+  scalar.scalar<float>()() = 1.5f;
+  Tensor copy;
+  EXPECT_TRUE(copy.CopyFrom(scalar, TensorShape({1})));
+  EXPECT_TRUE(copy.SharesBufferWith(scalar));
+  EXPECT_EQ(1.5f, copy.flat<float>()(0));
+}
+
+struct ThreadExitTensorHolder {
+  Tensor tensor;
+};
+
+TEST(TensorTest, SmallTensorReleasedAtThreadExit) {
+  // The holder is constructed before the thread's free list of small tensor
+  // buffers, so it is destroyed after it and releases its tensor then.
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "release_at_exit", [] {
+        static thread_local ThreadExitTensorHolder holder;
+        ThreadExitTensorHolder* h = &holder;
+        Tensor t(cpu_allocator_base(), DT_FLOAT, TensorShape({}));
+        t.scalar<float>()() = 1.0f;
+        h->tensor = t;
+      }));
+}
+
 TEST(TensorTest, DataType_Traits) {
   EXPECT_TRUE(std::is_trivial<float>::value);
   EXPECT_TRUE(std::is_trivial<double>::value);
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/type_traits.h"
 #include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
@@ -366,5 +367,90 @@ bool CompressTensorProtoInPlace(int64 min_num_elements,
 
 #undef HANDLE_COMPRESS_CASE
 
+namespace {
+
+enum WireType {
+  WIRETYPE_VARINT = 0,
+  WIRETYPE_LENGTH_DELIMITED = 2,
+};
+
+inline uint32 MakeTag(int field_number, WireType wire_type) {
+  return (static_cast<uint32>(field_number) << 3) | wire_type;
+}
+
+inline size_t VarLengthEncodingSize(size_t bytes) {
+  return 1 + core::VarintLength(bytes) + bytes;  // tag, length and data
+}
+
+// Returns the size of the `tensor_content` AsProtoTensorContent() produces.
+// REQUIRES: CanSerializeTensorProtoContent(tensor.dtype())
+size_t ContentByteSize(const Tensor& tensor) {
+  if (tensor.NumElements() == 0) return 0;
+  if (tensor.dtype() != DT_STRING) return tensor.tensor_data().size();
+  // Same encoding as port::EncodeStringList(): all the lengths as varints,
+  // followed by all the bytes.
+  size_t bytes = 0;
+  for (const string& s : tensor.flat<string>()) {
+    bytes += core::VarintLength(s.size()) + s.size();
+  }
+  return bytes;
+}
+
+}  // namespace
+
+bool CanSerializeTensorProtoContent(DataType dtype) {
+  return DataTypeCanUseMemcpy(dtype) || dtype == DT_STRING;
+}
+
+size_t TensorProtoContentByteSize(const Tensor& tensor) {
+  DCHECK(CanSerializeTensorProtoContent(tensor.dtype()));
+  size_t bytes = 0;
+  if (tensor.dtype() != DT_INVALID) {
+    bytes += 1 + core::VarintLength(tensor.dtype());
+  }
+  TensorShapeProto shape;
+  tensor.shape().AsProto(&shape);
+  bytes += VarLengthEncodingSize(shape.ByteSizeLong());
+  const size_t content_bytes = ContentByteSize(tensor);
+  if (content_bytes > 0) {
+    bytes += VarLengthEncodingSize(content_bytes);
+  }
+  return bytes;
+}
+
+void SerializeTensorProtoContent(const Tensor& tensor,
+                                 protobuf::io::CodedOutputStream* out) {
+  DCHECK(CanSerializeTensorProtoContent(tensor.dtype()));
+  // Fields are written in field number order, like the generated code does.
+  if (tensor.dtype() != DT_INVALID) {
+    out->WriteTag(MakeTag(TensorProto::kDtypeFieldNumber, WIRETYPE_VARINT));
+    out->WriteVarint64(tensor.dtype());
+  }
+  TensorShapeProto shape;
+  tensor.shape().AsProto(&shape);
+  out->WriteTag(
+      MakeTag(TensorProto::kTensorShapeFieldNumber, WIRETYPE_LENGTH_DELIMITED));
+  out->WriteVarint64(shape.ByteSizeLong());
+  shape.SerializeWithCachedSizes(out);
+
+  const size_t content_bytes = ContentByteSize(tensor);
+  if (content_bytes == 0) return;
+  out->WriteTag(MakeTag(TensorProto::kTensorContentFieldNumber,
+                        WIRETYPE_LENGTH_DELIMITED));
+  out->WriteVarint64(content_bytes);
+  if (tensor.dtype() != DT_STRING) {
+    const StringPiece data = tensor.tensor_data();
+    out->WriteRaw(data.data(), data.size());
+    return;
+  }
+  const auto strings = tensor.flat<string>();
+  for (const string& s : strings) {
+    out->WriteVarint64(s.size());
+  }
+  for (const string& s : strings) {
+    out->WriteRaw(s.data(), s.size());
+  }
+}
+
 }  // namespace tensor
 }  // namespace tensorflow
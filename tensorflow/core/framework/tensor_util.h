@@ -325,6 +325,28 @@ inline bool CompressTensorProtoInPlace(TensorProto* tensor) {
                                     kDefaultMinCompressionRatio, tensor);
 }
 
+// Returns true if TensorProtoContentByteSize() and
+// SerializeTensorProtoContent() support tensors of type "dtype": types that
+// can be memcpy-ed, and DT_STRING. Tensors of other types have to go through
+// a TensorProto.
+bool CanSerializeTensorProtoContent(DataType dtype);
+
+// Returns the size in bytes of the serialized TensorProto that
+// `tensor.AsProtoTensorContent()` produces.
+//
+// REQUIRES: CanSerializeTensorProtoContent(tensor.dtype())
+size_t TensorProtoContentByteSize(const Tensor& tensor);
+
+// Writes the same bytes as serializing the TensorProto produced by
+// `tensor.AsProtoTensorContent()`, but the tensor data goes straight from the
+// tensor buffer to `out`, without first being copied into an intermediate
+// TensorProto. This matters for large tensors, e.g. when sending them.
+//
+// REQUIRES: CanSerializeTensorProtoContent(tensor.dtype())
+// REQUIRES: 'tensor' must point to data stored in CPU memory.
+void SerializeTensorProtoContent(const Tensor& tensor,
+                                 protobuf::io::CodedOutputStream* out);
+
 }  // namespace tensor
 }  // namespace tensorflow
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_encode_decode.h"
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -590,5 +591,40 @@ TEST(TensorProtoUtil, CompressTensorProtoConstantTail) {
   }
 }
 
+void ExpectSerializesLikeTensorProto(const Tensor& t) {
+  ASSERT_TRUE(tensor::CanSerializeTensorProtoContent(t.dtype()));
+  TensorProto proto;
+  t.AsProtoTensorContent(&proto);
+  const string expected = proto.SerializeAsString();
+  const size_t bytes = tensor::TensorProtoContentByteSize(t);
+  EXPECT_EQ(expected.size(), bytes);
+  string serialized(bytes, '\0');
+  {
+    protobuf::io::ArrayOutputStream stream(&serialized[0], bytes);
+    protobuf::io::CodedOutputStream out(&stream);
+    tensor::SerializeTensorProtoContent(t, &out);
+    EXPECT_FALSE(out.HadError());
+    EXPECT_EQ(bytes, static_cast<size_t>(out.ByteCount()));
+  }
+  EXPECT_EQ(expected, serialized);
+}
+
+TEST(TensorProtoContentTest, SerializesLikeTensorProto) {
+  ExpectSerializesLikeTensorProto(test::AsScalar<float>(1.5f));
+  ExpectSerializesLikeTensorProto(
+      test::AsTensor<int64>({1, -2, 3, 4, 5, 6}, TensorShape({2, 3})));
+  ExpectSerializesLikeTensorProto(Tensor(DT_INT32, TensorShape({0, 3})));
+  ExpectSerializesLikeTensorProto(test::AsTensor<string>(
+      {"", "a", string(300, 'b'), "ccc"}, TensorShape({2, 2})));
+  ExpectSerializesLikeTensorProto(Tensor(DT_STRING, TensorShape({3})));
+  // Sliced tensors only serialize their own elements.
+  ExpectSerializesLikeTensorProto(
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6}, TensorShape({3, 2}))
+          .Slice(1, 2));
+
+  EXPECT_FALSE(tensor::CanSerializeTensorProtoContent(DT_VARIANT));
+  EXPECT_FALSE(tensor::CanSerializeTensorProtoContent(DT_RESOURCE));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -191,6 +191,74 @@ void ReverseDFSFrom(const Graph& g, gtl::ArraySlice<Node*> start,
   ReverseDFSFromHelper(g, start, enter, leave, stable_comparator);
 }
 
+namespace {
+
+// Traverses the out edges of `view`, or its in edges if `reverse` is set.
+void CompactDFSFromHelper(const CompactGraphView& view,
+                          gtl::ArraySlice<int> start, bool reverse,
+                          const std::function<void(int)>& enter,
+                          const std::function<void(int)>& leave) {
+  // Stack of work to do.
+  struct Work {
+    int node_id;
+    bool leave;  // Are we entering or leaving the node?
+  };
+  std::vector<Work> stack(start.size());
+  for (int i = 0; i < start.size(); ++i) {
+    stack[i] = Work{start[i], false};
+  }
+
+  std::vector<bool> visited(view.num_node_ids(), false);
+  while (!stack.empty()) {
+    Work w = stack.back();
+    stack.pop_back();
+
+    const int id = w.node_id;
+    if (w.leave) {
+      leave(id);
+      continue;
+    }
+
+    if (visited[id]) continue;
+    visited[id] = true;
+    if (enter) enter(id);
+
+    // Arrange to call leave(id) when all done with descendants.
+    if (leave) stack.push_back(Work{id, true});
+
+    for (const CompactGraphView::CompactEdge& e :
+         reverse ? view.in_edges(id) : view.out_edges(id)) {
+      const int next = reverse ? e.src : e.dst;
+      if (!visited[next]) {
+        // Note; we must not mark as visited until we actually process it.
+        stack.push_back(Work{next, false});
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void DFSFrom(const CompactGraphView& view, gtl::ArraySlice<int> start,
+             const std::function<void(int)>& enter,
+             const std::function<void(int)>& leave) {
+  CompactDFSFromHelper(view, start, /*reverse=*/false, enter, leave);
+}
+
+void ReverseDFSFrom(const CompactGraphView& view, gtl::ArraySlice<int> start,
+                    const std::function<void(int)>& enter,
+                    const std::function<void(int)>& leave) {
+  CompactDFSFromHelper(view, start, /*reverse=*/true, enter, leave);
+}
+
+void GetReversePostOrder(const CompactGraphView& view,
+                         std::vector<int>* order) {
+  order->clear();
+  DFSFrom(view, {static_cast<int>(Graph::kSourceId)}, nullptr,
+          [order](int id) { order->push_back(id); });
+  std::reverse(order->begin(), order->end());
+}
+
 void GetPostOrder(const Graph& g, std::vector<Node*>* order,
                   const NodeComparator& stable_comparator,
                   const EdgeFilter& edge_filter) {
@@ -20,6 +20,7 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "tensorflow/core/graph/compact_graph_view.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 
@@ -120,6 +121,21 @@ void GetReversePostOrder(const Graph& g, std::vector<Node*>* order,
                          const NodeComparator& stable_comparator = {},
                          const EdgeFilter& edge_filter = {});
 
+// Same as DFSFrom and ReverseDFSFrom, but traverse a CompactGraphView and
+// identify nodes by id. Use these for passes that traverse a large graph
+// many times, so that building the view once pays off.
+extern void DFSFrom(const CompactGraphView& view, gtl::ArraySlice<int> start,
+                    const std::function<void(int)>& enter,
+                    const std::function<void(int)>& leave);
+extern void ReverseDFSFrom(const CompactGraphView& view,
+                           gtl::ArraySlice<int> start,
+                           const std::function<void(int)>& enter,
+                           const std::function<void(int)>& leave);
+
+// Same as GetReversePostOrder without a comparator or filter, but returns the
+// ids of the nodes of `view`.
+void GetReversePostOrder(const CompactGraphView& view, std::vector<int>* order);
+
 // Prune nodes in "g" that are not in some path from the source node
 // to any node in 'nodes'. Returns true if changes were made to the graph.
 // Does not fix up source and sink edges.
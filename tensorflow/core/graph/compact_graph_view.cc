@@ -0,0 +1,44 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/compact_graph_view.h"
+
+namespace tensorflow {
+
+CompactGraphView::CompactGraphView(const Graph& graph)
+    : graph_(graph), num_node_ids_(graph.num_node_ids()) {
+  in_offsets_.reserve(num_node_ids_ + 1);
+  out_offsets_.reserve(num_node_ids_ + 1);
+  in_edges_.reserve(graph.num_edges());
+  out_edges_.reserve(graph.num_edges());
+  for (int id = 0; id < num_node_ids_; ++id) {
+    in_offsets_.push_back(in_edges_.size());
+    out_offsets_.push_back(out_edges_.size());
+    const Node* node = graph.FindNodeId(id);
+    if (node == nullptr) continue;
+    for (const Edge* e : node->in_edges()) {
+      in_edges_.push_back(CompactEdge{e->src()->id(), id, e->src_output(),
+                                      e->dst_input()});
+    }
+    for (const Edge* e : node->out_edges()) {
+      out_edges_.push_back(CompactEdge{id, e->dst()->id(), e->src_output(),
+                                       e->dst_input()});
+    }
+  }
+  in_offsets_.push_back(in_edges_.size());
+  out_offsets_.push_back(out_edges_.size());
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPH_COMPACT_GRAPH_VIEW_H_
+#define TENSORFLOW_CORE_GRAPH_COMPACT_GRAPH_VIEW_H_
+
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+
+// A read-only snapshot of the edges of a Graph, stored as flat arrays indexed
+// by node id (compressed sparse rows) instead of as per-node sets of
+// heap-allocated Edges. Algorithms that traverse a large graph many times,
+// e.g. DFS from many start nodes, touch far less memory through it.
+//
+// The view holds no attributes and refers to nodes by id only; use
+// graph().FindNodeId() to get at a Node. It must not outlive the graph and is
+// not updated when the graph changes.
+class CompactGraphView {
+ public:
+  // An edge between the nodes with ids `src` and `dst`. `src_output` and
+  // `dst_input` are Graph::kControlSlot for control edges.
+  struct CompactEdge {
+    int src;
+    int dst;
+    int src_output;
+    int dst_input;
+
+    bool IsControlEdge() const { return src_output == Graph::kControlSlot; }
+  };
+
+  explicit CompactGraphView(const Graph& graph);
+
+  const Graph& graph() const { return graph_; }
+  int num_node_ids() const { return num_node_ids_; }
+
+  // The edges into and out of the node with id `id`, in the order of
+  // Node::in_edges() and Node::out_edges() respectively. Empty for the ids of
+  // removed nodes.
+  gtl::ArraySlice<CompactEdge> in_edges(int id) const {
+    return Slice(in_edges_, in_offsets_, id);
+  }
+  gtl::ArraySlice<CompactEdge> out_edges(int id) const {
+    return Slice(out_edges_, out_offsets_, id);
+  }
+
+ private:
+  static gtl::ArraySlice<CompactEdge> Slice(
+      const std::vector<CompactEdge>& edges, const std::vector<int>& offsets,
+      int id) {
+    DCHECK_GE(id, 0);
+    DCHECK_LT(static_cast<size_t>(id) + 1, offsets.size());
+    return gtl::ArraySlice<CompactEdge>(edges.data() + offsets[id],
+                                        offsets[id + 1] - offsets[id]);
+  }
+
+  const Graph& graph_;
+  const int num_node_ids_;
+
+  // The edges of node i are edges[offsets[i]] to edges[offsets[i + 1] - 1].
+  std::vector<int> in_offsets_;
+  std::vector<CompactEdge> in_edges_;
+  std::vector<int> out_offsets_;
+  std::vector<CompactEdge> out_edges_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompactGraphView);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPH_COMPACT_GRAPH_VIEW_H_
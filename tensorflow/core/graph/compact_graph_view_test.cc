@@ -0,0 +1,115 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/compact_graph_view.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+REGISTER_OP("CompactGraphViewTestInput").Output("o: float");
+REGISTER_OP("CompactGraphViewTestBinary")
+    .Input("a: float")
+    .Input("b: float")
+    .Output("o: float");
+
+class CompactGraphViewTest : public ::testing::Test {
+ protected:
+  CompactGraphViewTest() : graph_(OpRegistry::Global()) {
+    TF_CHECK_OK(NodeBuilder("a", "CompactGraphViewTestInput")
+                    .Finalize(&graph_, &a_));
+    TF_CHECK_OK(NodeBuilder("b", "CompactGraphViewTestInput")
+                    .Finalize(&graph_, &b_));
+    TF_CHECK_OK(NodeBuilder("c", "CompactGraphViewTestBinary")
+                    .Input(a_)
+                    .Input(b_)
+                    .Finalize(&graph_, &c_));
+    graph_.AddControlEdge(a_, b_);
+    FixupSourceAndSinkEdges(&graph_);
+  }
+
+  Graph graph_;
+  Node* a_;
+  Node* b_;
+  Node* c_;
+};
+
+TEST_F(CompactGraphViewTest, MatchesGraphEdges) {
+  CompactGraphView view(graph_);
+  ASSERT_EQ(graph_.num_node_ids(), view.num_node_ids());
+  for (const Node* n : graph_.nodes()) {
+    std::vector<const Edge*> in_edges(n->in_edges().begin(),
+                                      n->in_edges().end());
+    ASSERT_EQ(in_edges.size(), view.in_edges(n->id()).size());
+    for (size_t i = 0; i < in_edges.size(); ++i) {
+      const CompactGraphView::CompactEdge& e = view.in_edges(n->id())[i];
+      EXPECT_EQ(in_edges[i]->src()->id(), e.src);
+      EXPECT_EQ(n->id(), e.dst);
+      EXPECT_EQ(in_edges[i]->src_output(), e.src_output);
+      EXPECT_EQ(in_edges[i]->dst_input(), e.dst_input);
+      EXPECT_EQ(in_edges[i]->IsControlEdge(), e.IsControlEdge());
+    }
+    EXPECT_EQ(n->out_edges().size(), view.out_edges(n->id()).size());
+  }
+}
+
+TEST_F(CompactGraphViewTest, SkipsRemovedNodes) {
+  Node* d;
+  TF_ASSERT_OK(
+      NodeBuilder("d", "CompactGraphViewTestInput").Finalize(&graph_, &d));
+  const int d_id = d->id();
+  graph_.RemoveNode(d);
+  CompactGraphView view(graph_);
+  EXPECT_TRUE(view.in_edges(d_id).empty());
+  EXPECT_TRUE(view.out_edges(d_id).empty());
+}
+
+TEST_F(CompactGraphViewTest, ReversePostOrder) {
+  CompactGraphView view(graph_);
+  std::vector<int> order;
+  GetReversePostOrder(view, &order);
+  std::vector<Node*> expected;
+  GetReversePostOrder(graph_, &expected);
+  ASSERT_EQ(expected.size(), order.size());
+  auto position = [&order](const Node* n) {
+    return std::find(order.begin(), order.end(), n->id()) - order.begin();
+  };
+  EXPECT_EQ(0, position(graph_.source_node()));
+  EXPECT_LT(position(a_), position(b_));
+  EXPECT_LT(position(b_), position(c_));
+  EXPECT_LT(position(c_), position(graph_.sink_node()));
+}
+
+TEST_F(CompactGraphViewTest, ReverseDFSFrom) {
+  CompactGraphView view(graph_);
+  std::vector<int> visited;
+  ReverseDFSFrom(view, {b_->id()},
+                 [&visited](int id) { visited.push_back(id); }, nullptr);
+  std::sort(visited.begin(), visited.end());
+  std::vector<int> expected = {Graph::kSourceId, a_->id(), b_->id()};
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(expected, visited);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -536,6 +536,8 @@ class Graph {
   // imported function differs from an existing function or op with the same
   // name.
   Status AddFunctionLibrary(const FunctionDefLibrary& fdef_lib);
+  // Same as above, but moves the function definitions out of `fdef_lib`.
+  Status AddFunctionLibrary(FunctionDefLibrary&& fdef_lib);
 
   // The number of live nodes in the graph.
   //
@@ -264,6 +264,12 @@ class GraphConstructor {
   // Returns the function information for the graph, or nullptr if none is
   // available.
   virtual const FunctionDefLibrary* library() const = 0;
+  // Adds the function information for the graph to g_, avoiding a copy if
+  // possible. After calling this method, the result of library() is
+  // undefined.
+  virtual Status ConsumeLibrary() {
+    return library() ? g_->AddFunctionLibrary(*library()) : Status::OK();
+  }
 
   // From constructor
   const Options opts_;
@@ -429,6 +435,9 @@ class NodeDefMovingGraphConstructor : public GraphConstructor {
   const FunctionDefLibrary* library() const override {
     return &graph_def_.library();
   }
+  Status ConsumeLibrary() override {
+    return g_->AddFunctionLibrary(std::move(*graph_def_.mutable_library()));
+  }
 
   GraphDef graph_def_;
   std::vector<bool> is_consumed_;
@@ -1097,11 +1106,7 @@ void GraphConstructor::PrintCycles() {
 Status GraphConstructor::Convert() {
   // Import functions before adding nodes, since imported nodes may refer to
   // functions
-  if (library()) {
-    // TODO(b/135705010): Add rvalue overloads into the function library, to
-    // avoid unnecessarily copying `*library()` here.
-    TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library()));
-  }
+  TF_RETURN_IF_ERROR(ConsumeLibrary());
 
   std::vector<InputInfo> inputs;
   int processed = 0;
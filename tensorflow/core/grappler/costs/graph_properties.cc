@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/shape_inference_cache.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
@@ -1658,7 +1659,9 @@ class SymbolicShapeRefiner {
   Status InferShapes(const NodeDef& node, NodeContext* c) {
     // Infer the shapes of output tensors.
     if (!c->op_data || c->op_data->shape_inference_fn == nullptr ||
-        !c->inference_context->Run(c->op_data->shape_inference_fn).ok()) {
+        !shape_inference::ShapeInferenceCache::Global()
+             ->Run(*c->op_data, c->inference_context.get())
+             .ok()) {
       // Annotate outputs with unknown shapes. Update output shapes with
       // annotated information later on if available.
       // Note that shape inference function may return an error, but we ignore
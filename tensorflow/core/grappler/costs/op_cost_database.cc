@@ -0,0 +1,172 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_database.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Builds the database key of `op_info`. Returns false if the shape of one of
+// its inputs is not fully known.
+bool GetKey(const OpInfo& op_info, string* key) {
+  *key = strings::StrCat(op_info.op(), ";", op_info.device().type());
+  for (const auto& input : op_info.inputs()) {
+    if (input.shape().unknown_rank()) {
+      return false;
+    }
+    strings::StrAppend(key, ";", DataTypeString(input.dtype()), "[");
+    for (const auto& dim : input.shape().dim()) {
+      if (dim.size() < 0) {
+        return false;
+      }
+      strings::StrAppend(key, dim.size(), ",");
+    }
+    strings::StrAppend(key, "]");
+  }
+  return true;
+}
+
+}  // namespace
+
+void OpCostDatabase::Add(const OpPerformanceList& op_performance_list) {
+  for (const auto& op_performance : op_performance_list.op_performance()) {
+    string key;
+    if (!GetKey(op_performance.op(), &key)) {
+      continue;
+    }
+    Entry& entry = entries_[key];
+    if (entry.num_measurements == 0) {
+      entry.op_performance = op_performance;
+      // The node name is meaningless once measurements are merged.
+      entry.op_performance.clear_node();
+    } else {
+      entry.op_performance.set_temporary_memory_size(
+          std::max(entry.op_performance.temporary_memory_size(),
+                   op_performance.temporary_memory_size()));
+    }
+    entry.num_measurements++;
+    entry.total_compute_cost += op_performance.compute_cost();
+    entry.total_compute_time += op_performance.compute_time();
+    entry.total_memory_time += op_performance.memory_time();
+  }
+}
+
+Status OpCostDatabase::AddRunMetadata(const RunMetadata& run_metadata) {
+  if (run_metadata.cost_graph().node_size() == 0) {
+    return errors::InvalidArgument(
+        "RunMetadata has no cost graph; run with "
+        "GraphOptions::build_cost_model set.");
+  }
+  if (run_metadata.partition_graphs_size() == 0) {
+    return errors::InvalidArgument(
+        "RunMetadata has no partition graphs; run with "
+        "RunOptions::output_partition_graphs set.");
+  }
+  GraphDef graph;
+  for (const auto& partition_graph : run_metadata.partition_graphs()) {
+    for (const auto& node : partition_graph.node()) {
+      *graph.add_node() = node;
+    }
+  }
+  Add(CostGraphToOpPerformanceData(run_metadata.cost_graph(), graph));
+  return Status::OK();
+}
+
+bool OpCostDatabase::Lookup(const OpInfo& op_info, Costs* costs) const {
+  string key;
+  if (!GetKey(op_info, &key)) {
+    return false;
+  }
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  const Entry& entry = it->second;
+  const double num_measurements = entry.num_measurements;
+  *costs = Costs();
+  costs->execution_time =
+      Costs::NanoSeconds(entry.total_compute_cost / num_measurements);
+  costs->compute_time =
+      Costs::NanoSeconds(entry.total_compute_time / num_measurements);
+  costs->memory_time =
+      Costs::NanoSeconds(entry.total_memory_time / num_measurements);
+  // Measured runs usually don't split the time between compute and memory.
+  if (costs->compute_time == Costs::Duration::zero() &&
+      costs->memory_time == Costs::Duration::zero()) {
+    costs->compute_time = costs->execution_time;
+  }
+  costs->temporary_memory = entry.op_performance.temporary_memory_size();
+  costs->persistent_memory =
+      entry.op_performance.op_memory().persistent_memory();
+  costs->inaccurate = false;
+  return true;
+}
+
+OpPerformanceList OpCostDatabase::ToOpPerformanceList() const {
+  OpPerformanceList op_performance_list;
+  for (const auto& key_and_entry : entries_) {
+    const Entry& entry = key_and_entry.second;
+    OpPerformance* op_performance = op_performance_list.add_op_performance();
+    *op_performance = entry.op_performance;
+    op_performance->set_compute_cost(
+        static_cast<int64>(entry.total_compute_cost / entry.num_measurements));
+    op_performance->set_compute_time(
+        static_cast<int64>(entry.total_compute_time / entry.num_measurements));
+    op_performance->set_memory_time(
+        static_cast<int64>(entry.total_memory_time / entry.num_measurements));
+  }
+  return op_performance_list;
+}
+
+Status OpCostDatabase::Load(const string& path) {
+  OpPerformanceList op_performance_list;
+  Status status = ReadBinaryProto(Env::Default(), path, &op_performance_list);
+  if (!status.ok()) {
+    op_performance_list.Clear();
+    if (!ReadTextProto(Env::Default(), path, &op_performance_list).ok()) {
+      return errors::InvalidArgument("Can't read an OpPerformanceList from ",
+                                     path, ": ", status.error_message());
+    }
+  }
+  Add(op_performance_list);
+  return Status::OK();
+}
+
+Status OpCostDatabase::Save(const string& path) const {
+  return WriteBinaryProto(Env::Default(), path, ToOpPerformanceList());
+}
+
+Costs MeasuredOpLevelCostEstimator::PredictCosts(
+    const OpContext& op_context) const {
+  Costs costs;
+  if (database_ != nullptr && database_->Lookup(op_context.op_info, &costs)) {
+    return costs;
+  }
+  return OpLevelCostEstimator::PredictCosts(op_context);
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,93 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_DATABASE_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_DATABASE_H_
+
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Op costs measured on real runs. Measurements are keyed by op type, device
+// type and the dtypes and shapes of the op inputs; each key holds the average
+// of all the measurements added for it. Measurements of ops with inputs of
+// unknown shape are dropped since they can't be matched reliably.
+class OpCostDatabase {
+ public:
+  OpCostDatabase() {}
+
+  // Adds the measurements in `op_performance_list`, e.g. as produced by
+  // CostGraphToOpPerformanceData() or ToOpPerformanceList().
+  void Add(const OpPerformanceList& op_performance_list);
+
+  // Adds the measurements of the cost graph in `run_metadata`, matched
+  // against its partition graphs. The run must have been made with
+  // GraphOptions::build_cost_model and RunOptions::output_partition_graphs.
+  Status AddRunMetadata(const RunMetadata& run_metadata);
+
+  // Sets `costs` to the measured cost of the op described by `op_info` and
+  // returns true, or returns false if nothing was measured for it.
+  bool Lookup(const OpInfo& op_info, Costs* costs) const;
+
+  // Returns one entry per key, holding the averaged measurements.
+  OpPerformanceList ToOpPerformanceList() const;
+
+  // Reads or writes the database as an OpPerformanceList. Load() accepts both
+  // the binary and the text format.
+  Status Load(const string& path);
+  Status Save(const string& path) const;
+
+  int size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    OpPerformance op_performance;
+    int64 num_measurements = 0;
+    double total_compute_cost = 0;
+    double total_compute_time = 0;
+    double total_memory_time = 0;
+  };
+
+  std::unordered_map<string, Entry> entries_;
+};
+
+// Predicts op costs from an OpCostDatabase, falling back to the analytical
+// model of OpLevelCostEstimator for ops that were never measured.
+class MeasuredOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  explicit MeasuredOpLevelCostEstimator(
+      std::shared_ptr<const OpCostDatabase> database)
+      : database_(std::move(database)) {}
+  ~MeasuredOpLevelCostEstimator() override {}
+
+  Costs PredictCosts(const OpContext& op_context) const override;
+
+ private:
+  std::shared_ptr<const OpCostDatabase> database_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_DATABASE_H_
@@ -0,0 +1,120 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_database.h"
+
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+OpInfo DescribeOp(const string& op, const string& device_type,
+                  std::initializer_list<int64> input_dims) {
+  OpInfo op_info;
+  op_info.set_op(op);
+  op_info.mutable_device()->set_type(device_type);
+  auto* input = op_info.add_inputs();
+  input->set_dtype(DT_FLOAT);
+  for (int64 dim : input_dims) {
+    input->mutable_shape()->add_dim()->set_size(dim);
+  }
+  return op_info;
+}
+
+void AddMeasurement(const OpInfo& op_info, int64 compute_cost_ns,
+                    OpPerformanceList* op_performance_list) {
+  OpPerformance* op_performance = op_performance_list->add_op_performance();
+  *op_performance->mutable_op() = op_info;
+  op_performance->set_compute_cost(compute_cost_ns);
+}
+
+TEST(OpCostDatabaseTest, AveragesMeasurementsPerKey) {
+  OpPerformanceList op_performance_list;
+  AddMeasurement(DescribeOp("Unique", "CPU", {1000}), 3000,
+                 &op_performance_list);
+  AddMeasurement(DescribeOp("Unique", "CPU", {1000}), 5000,
+                 &op_performance_list);
+  AddMeasurement(DescribeOp("Unique", "GPU", {1000}), 100,
+                 &op_performance_list);
+  // Unknown shapes are not recorded.
+  AddMeasurement(DescribeOp("Unique", "CPU", {-1}), 100, &op_performance_list);
+
+  OpCostDatabase database;
+  database.Add(op_performance_list);
+  EXPECT_EQ(database.size(), 2);
+
+  Costs costs;
+  ASSERT_TRUE(database.Lookup(DescribeOp("Unique", "CPU", {1000}), &costs));
+  EXPECT_EQ(costs.execution_time, Costs::NanoSeconds(4000));
+  EXPECT_EQ(costs.compute_time, Costs::NanoSeconds(4000));
+  EXPECT_FALSE(costs.inaccurate);
+  ASSERT_TRUE(database.Lookup(DescribeOp("Unique", "GPU", {1000}), &costs));
+  EXPECT_EQ(costs.execution_time, Costs::NanoSeconds(100));
+
+  EXPECT_FALSE(database.Lookup(DescribeOp("Unique", "CPU", {2000}), &costs));
+  EXPECT_FALSE(database.Lookup(DescribeOp("Unique", "CPU", {-1}), &costs));
+  EXPECT_FALSE(database.Lookup(DescribeOp("Sort", "CPU", {1000}), &costs));
+}
+
+TEST(OpCostDatabaseTest, SaveAndLoad) {
+  OpPerformanceList op_performance_list;
+  AddMeasurement(DescribeOp("StringSplit", "CPU", {64}), 2000,
+                 &op_performance_list);
+  OpCostDatabase database;
+  database.Add(op_performance_list);
+
+  const string path =
+      io::JoinPath(testing::TmpDir(), "op_cost_database_test.pb");
+  TF_ASSERT_OK(database.Save(path));
+  OpCostDatabase loaded;
+  TF_ASSERT_OK(loaded.Load(path));
+  EXPECT_EQ(loaded.size(), 1);
+  Costs costs;
+  ASSERT_TRUE(loaded.Lookup(DescribeOp("StringSplit", "CPU", {64}), &costs));
+  EXPECT_EQ(costs.execution_time, Costs::NanoSeconds(2000));
+}
+
+TEST(OpCostDatabaseTest, AddRunMetadataRequiresCostGraph) {
+  OpCostDatabase database;
+  EXPECT_FALSE(database.AddRunMetadata(RunMetadata()).ok());
+}
+
+TEST(MeasuredOpLevelCostEstimatorTest, PrefersMeasuredCosts) {
+  OpPerformanceList op_performance_list;
+  AddMeasurement(DescribeOp("Relu", "CPU", {1000}), 123456,
+                 &op_performance_list);
+  auto database = std::make_shared<OpCostDatabase>();
+  database->Add(op_performance_list);
+  MeasuredOpLevelCostEstimator estimator(database);
+
+  OpContext op_context;
+  op_context.op_info = DescribeOp("Relu", "CPU", {1000});
+  EXPECT_EQ(estimator.PredictCosts(op_context).execution_time,
+            Costs::NanoSeconds(123456));
+
+  // Falls back to the analytical model for ops that were not measured.
+  op_context.op_info = DescribeOp("Relu", "CPU", {2000});
+  OpLevelCostEstimator analytical_estimator;
+  EXPECT_EQ(estimator.PredictCosts(op_context).execution_time,
+            analytical_estimator.PredictCosts(op_context).execution_time);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -101,6 +101,11 @@ struct GrapplerItem {
 
     // Mark the grapper optimization run in eager mode or not.
     bool is_eager_mode = false;
+
+    // If true, `feed` lists every tensor that will be fed when running the
+    // graph, so PlaceholderWithDefault nodes that are not fed always produce
+    // their default value.
+    bool feeds_are_complete = false;
   };
 
   const std::unordered_set<string>& devices() const;
@@ -2871,10 +2871,14 @@ class UnaryOpsComposition : public ArithmeticOptimizerStage {
                       {"Ceil",       {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Cos",        {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Cosh",       {DT_FLOAT,          DT_DOUBLE}},
+                      {"Digamma",    {DT_FLOAT,          DT_DOUBLE}},
+                      {"Erf",        {DT_FLOAT,          DT_DOUBLE}},
+                      {"Erfc",       {DT_FLOAT,          DT_DOUBLE}},
                       {"Expm1",      {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Exp",        {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Floor",      {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Inv",        {DT_FLOAT, DT_HALF, DT_DOUBLE}},
+                      {"Lgamma",     {DT_FLOAT,          DT_DOUBLE}},
                       {"Log",        {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Log1p",      {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Neg",        {DT_FLOAT, DT_HALF, DT_DOUBLE}},
@@ -2883,6 +2887,7 @@ class UnaryOpsComposition : public ArithmeticOptimizerStage {
                       {"Round",      {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Rsqrt",      {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Sigmoid",    {DT_FLOAT, DT_HALF, DT_DOUBLE}},
+                      {"Sign",       {DT_FLOAT,          DT_DOUBLE}},
                       {"Sin",        {DT_FLOAT, DT_HALF, DT_DOUBLE}},
                       {"Sinh",       {DT_FLOAT,          DT_DOUBLE}},
                       {"Sqrt",       {DT_FLOAT, DT_HALF, DT_DOUBLE}},
@@ -48,6 +48,7 @@ const std::pair<int, int> kMinGPUArch = {7, 0};
 
 const char kSuffix[] = "AutoMixedPrecision";
 const char kCastToFp16[] = "CastToFp16";
+const char kCastToBf16[] = "CastToBf16";
 const char kCastToFp32[] = "CastToFp32";
 
 // Instances of this class represent unique type attribute identifiers within a
@@ -833,9 +834,13 @@ DataTypeSet AllowedDataTypes(const OpDef& op_def, const TypeAttrId& t_attr_id) {
   return AllowedDataTypes(*attr_def);
 }
 
+// Builds a Cast between DT_FLOAT and `target_dtype` (DT_HALF or DT_BFLOAT16).
 NodeDef BuildCastNode(const MutableGraphView::OutputPort& src, bool to_fp16,
-                      const string& device) {
-  const char* cast_string = to_fp16 ? kCastToFp16 : kCastToFp32;
+                      DataType target_dtype, const string& device) {
+  const char* cast_string = kCastToFp32;
+  if (to_fp16) {
+    cast_string = target_dtype == DT_BFLOAT16 ? kCastToBf16 : kCastToFp16;
+  }
   string name = strings::StrCat(src.node->name(), "-", src.port_id, "-",
                                 cast_string, "-", kSuffix);
   NodeDef node;
@@ -843,8 +848,8 @@ NodeDef BuildCastNode(const MutableGraphView::OutputPort& src, bool to_fp16,
   node.set_op("Cast");
   node.set_device(device);
   node.add_input(strings::StrCat(src.node->name(), ":", src.port_id));
-  (*node.mutable_attr())["SrcT"].set_type(to_fp16 ? DT_FLOAT : DT_HALF);
-  (*node.mutable_attr())["DstT"].set_type(to_fp16 ? DT_HALF : DT_FLOAT);
+  (*node.mutable_attr())["SrcT"].set_type(to_fp16 ? DT_FLOAT : target_dtype);
+  (*node.mutable_attr())["DstT"].set_type(to_fp16 ? target_dtype : DT_FLOAT);
   (*node.mutable_attr())["Truncate"].set_b(false);
   return node;
 }
@@ -902,12 +907,16 @@ class AutoMixedPrecisionImpl {
  public:
   AutoMixedPrecisionImpl(Cluster* cluster,
                          const std::unordered_set<string>& nodes_to_preserve,
-                         GraphDef* graph, string id)
+                         GraphDef* graph, string id,
+                         AutoMixedPrecisionMode mode)
       : virtual_placer_(cluster->GetDevices()),
         nodes_to_preserve_(nodes_to_preserve),
         graph_(graph),
         id_(id),
-        graph_view_(graph) {}
+        graph_view_(graph),
+        mode_(mode),
+        target_dtype_(mode == AutoMixedPrecisionMode::CPU ? DT_BFLOAT16
+                                                           : DT_HALF) {}
 
   Status Optimize();
 
@@ -922,7 +931,7 @@ class AutoMixedPrecisionImpl {
   Status PrintDebugLogs(bool preop, size_t timestamp);
   void LogSkippedNode(const NodeDef& node) const;
   bool MustPreserve(const NodeDef& node) const;
-  bool IsOnGPU(const NodeDef& node) const;
+  bool IsOnDevice(const NodeDef& node, const string& device_type) const;
   bool IsOnSuitableGPUArch(const NodeDef& node) const;
   bool ShouldProcess(const NodeDef& node) const;
   bool NodeHasFP16KernelForTypeAttr(const NodeDef& node, TypeAttrId taid) const;
@@ -958,6 +967,9 @@ class AutoMixedPrecisionImpl {
   GraphDef* graph_;
   string id_;
   MutableGraphView graph_view_;
+  AutoMixedPrecisionMode mode_;
+  // The reduced precision type: DT_HALF on GPUs and DT_BFLOAT16 on CPUs.
+  DataType target_dtype_;
   NodeTypeAttrMap node_type_map_;
   GraphTypeTopologyView graph_type_view_;
   bool force_all_fp16_;
@@ -975,7 +987,7 @@ bool AutoMixedPrecisionImpl::NodeHasFP16KernelForTypeAttr(
     string device_name = virtual_placer_.get_canonical_device_name(node);
     node_copy.set_device(device_name);
   }
-  if (!SetDataType(&node_copy, taid, DataType::DT_HALF)) {
+  if (!SetDataType(&node_copy, taid, target_dtype_)) {
     return false;
   }
   return IsKernelRegisteredForNode(node_copy).ok();
@@ -1012,19 +1024,19 @@ Status AutoMixedPrecisionImpl::PrintDebugLogs(bool preop, size_t timestamp) {
                          strings::StrCat("paintbuckets", suffix, ".txt"));
     f.open(fname.c_str(), std::fstream::out);
     f << "WhiteList:\n";
-    for (auto x : AutoMixedPrecisionLists::WhiteList()) {
+    for (auto x : fp16_whitelist_) {
       f << x << "\n";
     }
     f << "\nBlackList:\n";
-    for (auto x : AutoMixedPrecisionLists::BlackList()) {
+    for (auto x : fp16_blacklist_) {
       f << x << "\n";
     }
     f << "\nGrayList:\n";
-    for (auto x : AutoMixedPrecisionLists::GrayList()) {
+    for (auto x : fp16_graylist_) {
       f << x << "\n";
     }
     f << "\nClearList:\n";
-    for (auto x : AutoMixedPrecisionLists::ClearList()) {
+    for (auto x : fp16_clearlist_) {
       f << x << "\n";
     }
     f.close();
@@ -1034,18 +1046,21 @@ Status AutoMixedPrecisionImpl::PrintDebugLogs(bool preop, size_t timestamp) {
 }
 
 void AutoMixedPrecisionImpl::LogSkippedNode(const NodeDef& node) const {
+  const char* reason =
+      mode_ == AutoMixedPrecisionMode::CPU
+          ? "is not on the CPU"
+          : "is not on the GPU, or the GPU arch is not suitable";
   VLOG(2) << "Skipping " << node.op() << " node " << node.name()
           << " because it "
-          << (MustPreserve(node)
-                  ? "must be preserved"
-                  : "is not on the GPU, or the GPU arch is not suitable");
+          << (MustPreserve(node) ? "must be preserved" : reason);
 }
 
 bool AutoMixedPrecisionImpl::MustPreserve(const NodeDef& node) const {
   return nodes_to_preserve_.count(node.name());
 }
 
-bool AutoMixedPrecisionImpl::IsOnGPU(const NodeDef& node) const {
+bool AutoMixedPrecisionImpl::IsOnDevice(const NodeDef& node,
+                                        const string& device_type) const {
   string device_name;
   if (node.device().empty()) {
     device_name = virtual_placer_.get_canonical_device_name(node);
@@ -1056,7 +1071,7 @@ bool AutoMixedPrecisionImpl::IsOnGPU(const NodeDef& node) const {
   string not_used;
   if (DeviceNameUtils::SplitDeviceName(device_name, &not_used, &device) &&
       absl::StrContains(absl::AsciiStrToLower(device),
-                        absl::AsciiStrToLower(DEVICE_GPU))) {
+                        absl::AsciiStrToLower(device_type))) {
     return true;
   }
   return false;
@@ -1099,7 +1114,7 @@ bool AutoMixedPrecisionImpl::SupportsFloat16(
       OpRegistry::Global()->LookUpOpDef(node_type.node->op(), &op_def);
   if (!status.ok()) return false;
   return AllowedDataTypes(*op_def, node_type.type_attr)
-             .Contains(DataType::DT_HALF) &&
+             .Contains(target_dtype_) &&
          NodeHasFP16KernelForTypeAttr(*node_type.node, node_type.type_attr);
 }
 
@@ -1148,10 +1163,17 @@ Status AutoMixedPrecisionImpl::Optimize() {
   optimization_level = absl::AsciiStrToUpper(optimization_level);
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
 
-  fp16_whitelist_ = AutoMixedPrecisionLists::WhiteList();
-  fp16_blacklist_ = AutoMixedPrecisionLists::BlackList();
-  fp16_graylist_ = AutoMixedPrecisionLists::GrayList();
-  fp16_clearlist_ = AutoMixedPrecisionLists::ClearList();
+  if (mode_ == AutoMixedPrecisionMode::CPU) {
+    fp16_whitelist_ = AutoMixedPrecisionListsCpu::WhiteList();
+    fp16_blacklist_ = AutoMixedPrecisionListsCpu::BlackList();
+    fp16_graylist_ = AutoMixedPrecisionListsCpu::GrayList();
+    fp16_clearlist_ = AutoMixedPrecisionListsCpu::ClearList();
+  } else {
+    fp16_whitelist_ = AutoMixedPrecisionLists::WhiteList();
+    fp16_blacklist_ = AutoMixedPrecisionLists::BlackList();
+    fp16_graylist_ = AutoMixedPrecisionLists::GrayList();
+    fp16_clearlist_ = AutoMixedPrecisionLists::ClearList();
+  }
   TF_RETURN_IF_ERROR(ValidateLists(fp16_whitelist_, fp16_blacklist_,
                                    fp16_graylist_, fp16_clearlist_));
 
@@ -1160,8 +1182,12 @@ Status AutoMixedPrecisionImpl::Optimize() {
 
   VLOG(2) << "Identifying nodes that should be processed";
   for (const NodeDef& node : graph_->node()) {
-    if (!MustPreserve(node) && IsOnGPU(node) &&
-        (ShouldIgnorePerformance() || IsOnSuitableGPUArch(node))) {
+    bool on_target_device =
+        mode_ == AutoMixedPrecisionMode::CPU
+            ? IsOnDevice(node, DEVICE_CPU)
+            : IsOnDevice(node, DEVICE_GPU) &&
+                  (ShouldIgnorePerformance() || IsOnSuitableGPUArch(node));
+    if (!MustPreserve(node) && on_target_device) {
       should_process_nodes_.insert(&node);
     } else {
       LogSkippedNode(node);
@@ -1669,7 +1695,8 @@ void AutoMixedPrecisionImpl::MakeCastsWhiteIfAllOutputsWhite(
   }
 }
 
-// Changes all white-painted type attributes to DT_HALF, and inserts Cast nodes
+// Changes all white-painted type attributes to the target type (DT_HALF or
+// DT_BFLOAT16), and inserts Cast nodes
 // at node outputs for all edges that connect white-painted <->
 // non-white-painted type attributes.
 Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
@@ -1692,8 +1719,9 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
       bool src_is_white = white_set.count(node_type_idx);
       if (src_is_white) {
         VLOG(1) << "Changing type " << type_attr.DebugString() << " of "
-                << node->op() << " node " << node->name() << " to DT_HALF";
-        if (!SetDataType(node, type_attr, DT_HALF)) {
+                << node->op() << " node " << node->name() << " to "
+                << DataTypeString(target_dtype_);
+        if (!SetDataType(node, type_attr, target_dtype_)) {
           return errors::Internal("Failed to set type attribute");
         }
         ++num_nodes_changed;
@@ -1720,11 +1748,13 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
             if (!added_cast_node) {
               bool to_fp16 = dst_is_white;
               VLOG(1) << "Inserting cast to "
-                      << (to_fp16 ? "DT_HALF" : "DT_FLOAT") << " at "
+                      << DataTypeString(to_fp16 ? target_dtype_ : DT_FLOAT)
+                      << " at "
                       << src.node->op() << " " << src.node->name() << ":"
                       << src.port_id;
               added_cast_node = graph_view_.AddNode(
-                  BuildCastNode(src, to_fp16, src.node->device()));
+                  BuildCastNode(src, to_fp16, target_dtype_,
+                                src.node->device()));
               if (to_fp16 && !IsConstant(*node) && !IsVariable(*node) &&
                   !IsIdentityAfterVariable(*node)) {
                 ++num_nonvar_casts_to_fp16;
@@ -1738,8 +1768,10 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
     }
   }
   LOG(INFO) << "Converted " << num_nodes_changed << "/" << num_nodes_preop
-            << " nodes to float16 precision using " << num_nonvar_casts_to_fp16
-            << " cast(s) to float16 (excluding Const and Variable casts)";
+            << " nodes to " << DataTypeString(target_dtype_)
+            << " precision using " << num_nonvar_casts_to_fp16 << " cast(s) to "
+            << DataTypeString(target_dtype_)
+            << " (excluding Const and Variable casts)";
   return Status::OK();
 }
 
@@ -1770,7 +1802,7 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
 
   int num_gpus = ShouldIgnorePerformance() ? GetNumGPUs(*cluster)
                                            : GetNumGPUs(*cluster, kMinGPUArch);
-  if (num_gpus < 1) {
+  if (mode_ == AutoMixedPrecisionMode::CUDA && num_gpus < 1) {
     // AutoMixedPrecision is currently only tuned for GPU.
     LOG(WARNING) << "No (suitable) GPUs detected, skipping " << name()
                  << " graph optimizer";
@@ -1779,7 +1811,7 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
 
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
-                                   item.id);
+                                   item.id, mode_);
   if (item.id == "tf_graph") {
     LOG(INFO) << "Running " << name() << " graph optimizer";
   } else {
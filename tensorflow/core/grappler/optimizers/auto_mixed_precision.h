@@ -22,22 +22,35 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
-// Convert data types to float16 where appropriate to improve performance on
-// GPUs.
+enum class AutoMixedPrecisionMode {
+  CUDA,  // Use float16 on GPUs with Tensor Cores.
+  CPU,   // Use bfloat16 on CPUs.
+};
+
+// Convert data types to float16 (on GPUs) or bfloat16 (on CPUs) where
+// appropriate to improve performance.
 class AutoMixedPrecision : public GraphOptimizer {
  public:
   explicit AutoMixedPrecision(
-      RewriterConfig::Toggle opt_level = RewriterConfig::ON) {}
+      RewriterConfig::Toggle opt_level = RewriterConfig::ON,
+      AutoMixedPrecisionMode mode = AutoMixedPrecisionMode::CUDA)
+      : mode_(mode) {}
 
   ~AutoMixedPrecision() override {}
 
-  string name() const override { return "auto_mixed_precision"; };
+  string name() const override {
+    return mode_ == AutoMixedPrecisionMode::CPU ? "auto_mixed_precision_cpu"
+                                                : "auto_mixed_precision";
+  };
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* output) override;
 
   void Feedback(Cluster* cluster, const GrapplerItem& item,
                 const GraphDef& optimize_output, double result) override;
+
+ private:
+  const AutoMixedPrecisionMode mode_;
 };
 
 }  // end namespace grappler
@@ -29,7 +29,7 @@ namespace tensorflow {
 namespace grappler {
 
 class AutoMixedPrecisionLists {
- private:
+ protected:
   static void UpdateList(gtl::FlatSet<string>* list, const string& to_add,
                          const string& to_remove) {
     for (auto x : str_util::Split(to_add, ",")) {
@@ -297,6 +297,105 @@ class AutoMixedPrecisionLists {
   }
 };
 
+// The lists used to convert to bfloat16 on CPUs. bfloat16 has the range of
+// float32, so only ops that accumulate many values or that are sensitive to the
+// reduced mantissa are kept in float32. The clearlist is shared with the GPU
+// lists.
+class AutoMixedPrecisionListsCpu : public AutoMixedPrecisionLists {
+ public:
+  // Returns the set of ops that benefit the most from bfloat16. These ops are
+  // always converted to bfloat16. The stock CPU kernels of these ops convert
+  // bfloat16 to float and back, so the benefit comes from kernels that compute
+  // in bfloat16 natively and from the smaller tensors around them.
+  static gtl::FlatSet<string> WhiteList() {
+    string to_add, to_remove;
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_CPU_GRAPH_REWRITE_WHITELIST_ADD", "",
+        &to_add));
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_CPU_GRAPH_REWRITE_WHITELIST_REMOVE", "",
+        &to_remove));
+
+    auto list = gtl::FlatSet<string>{
+        "BatchMatMul",
+        "BatchMatMulV2",
+        "Conv2D",
+        "MatMul",
+    };
+    UpdateList(&list, to_add, to_remove);
+    return list;
+  }
+
+  // Returns the set of ops that are safe in bfloat16, but which may be made
+  // unsafe by an upstream blacklist op.
+  static gtl::FlatSet<string> GrayList() {
+    if (IsPseudoFastMath()) {
+      return gtl::FlatSet<string>{};
+    }
+    string to_add, to_remove;
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_CPU_GRAPH_REWRITE_GRAYLIST_ADD", "",
+        &to_add));
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_CPU_GRAPH_REWRITE_GRAYLIST_REMOVE", "",
+        &to_remove));
+
+    auto list = gtl::FlatSet<string>{
+        "Add",
+        "AddN",
+        "AddV2",
+        "BiasAdd",
+        "BiasAddV1",
+        "Elu",
+        "LeakyRelu",
+        "Mul",
+        "RealDiv",
+        "Rsqrt",
+        "Sigmoid",
+        "Sqrt",
+        "Square",
+        "SquaredDifference",
+        "Sub",
+        "Tanh",
+    };
+    UpdateList(&list, to_add, to_remove);
+    return list;
+  }
+
+  // Returns the set of ops that must stay in float32, and whose effects may
+  // also be observed in downstream nodes.
+  static gtl::FlatSet<string> BlackList() {
+    if (IsPseudoFastMath()) {
+      return gtl::FlatSet<string>{};
+    }
+    string to_add, to_remove;
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_CPU_GRAPH_REWRITE_BLACKLIST_ADD", "",
+        &to_add));
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_CPU_GRAPH_REWRITE_BLACKLIST_REMOVE", "",
+        &to_remove));
+
+    auto list = gtl::FlatSet<string>{
+        "Exp",
+        "Expm1",
+        "L2Loss",
+        "Log",
+        "Log1p",
+        "LogSoftmax",
+        "Mean",
+        "Pow",
+        "SaveV2",
+        "Softmax",
+        "SoftmaxCrossEntropyWithLogits",
+        "SparseSoftmaxCrossEntropyWithLogits",
+        "Sum",
+    };
+    UpdateList(&list, to_add, to_remove);
+    return list;
+  }
+};
+
 }  // end namespace grappler
 }  // end namespace tensorflow
 
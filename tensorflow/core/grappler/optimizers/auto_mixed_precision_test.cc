@@ -13,12 +13,6 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-// Currently, this test only passes when TensorFlow passes with CUDA, because
-// otherwise the optimizer will not turn clearlist nodes to float16. When
-// looking at clearlist nodes, this optimizer checks if the nodes have a float16
-// GPU OpKernel, but without CUDA there are no GPU OpKernels at all.
-#if GOOGLE_CUDA
-
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 
 #include <utility>
@@ -44,6 +38,12 @@ namespace tensorflow {
 namespace grappler {
 namespace {
 
+// Currently, the GPU tests only pass when TensorFlow passes with CUDA, because
+// otherwise the optimizer will not turn clearlist nodes to float16. When
+// looking at clearlist nodes, this optimizer checks if the nodes have a float16
+// GPU OpKernel, but without CUDA there are no GPU OpKernels at all.
+#if GOOGLE_CUDA
+
 const std::pair<int, int> kMinGPUArch = {7, 0};
 
 class AutoMixedPrecisionTest : public GrapplerTest {
@@ -727,8 +727,57 @@ TEST_F(AutoMixedPrecisionTest, StackV2) {
             DT_FLOAT);
 }
 
+#endif  // GOOGLE_CUDA
+
+class AutoMixedPrecisionCpuTest : public GrapplerTest {};
+
+TEST_F(AutoMixedPrecisionCpuTest, Simple) {
+  DeviceProperties device_properties;
+  device_properties.set_type("CPU");
+  VirtualCluster cluster({{"/CPU:0", device_properties}});
+  TF_ASSERT_OK(cluster.Provision());
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Const(s.WithOpName("input"), 0.5f, {32, 32});
+  Output wht1 = ops::MatMul(s.WithOpName("wht1"), input, input);
+  Output clr1 = ops::Relu(s.WithOpName("clr1"), wht1);
+  Output gry1 = ops::Sqrt(s.WithOpName("gry1"), clr1);
+  Output wht2 = ops::MatMul(s.WithOpName("wht2"), gry1, gry1);
+  Output blk1 = ops::Log(s.WithOpName("blk1"), wht2);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), blk1);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+
+  AutoMixedPrecision optimizer(RewriterConfig::ON,
+                               AutoMixedPrecisionMode::CPU);
+  EXPECT_EQ(optimizer.name(), "auto_mixed_precision_cpu");
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(&cluster, item, &output));
+
+  VLOG(1) << output.DebugString();
+
+  GraphView output_view(&output);
+  // One cast to bfloat16 after the input and one back to float before blk1.
+  EXPECT_EQ(output.node_size(), item.graph.node_size() + 2);
+  EXPECT_EQ(output_view.GetNode("input")->attr().at("dtype").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("wht1")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("clr1")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("gry1")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("wht2")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("blk1")->attr().at("T").type(), DT_FLOAT);
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(tensors.size(), tensors_expected.size());
+  EXPECT_EQ(tensors.size(), item.fetch.size());
+  for (int i = 0; i < item.fetch.size(); ++i) {
+    test::ExpectTensorNear<float>(tensors_expected[i], tensors[i], 1e-2);
+  }
+  TF_ASSERT_OK(cluster.Shutdown());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
-
-#endif  // GOOGLE_CUDA
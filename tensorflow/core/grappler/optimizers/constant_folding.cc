@@ -18,11 +18,14 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 
 #include <cmath>
+#include <set>
+#include <unordered_map>
 
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -44,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
@@ -61,6 +65,11 @@ using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 
 // We only fold/materialize constants smaller than 10 MiB.
 static const int64 kMaxConstantSize = 10 * 1024 * 1024;
+// Constants at least this large are deduplicated by content.
+static const int64 kMinDeduplicatedConstantSize = 16 * 1024;
+// The distinct constants folded in a graph may add at most 1 GiB to it, which
+// keeps the GraphDef under the 2 GiB protobuf limit.
+static const int64 kMaxFoldedConstantsSize = 1024 * 1024 * 1024;
 
 namespace {
 template <typename T>
@@ -1305,6 +1314,12 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
         *result_too_large = true;
         return s;
       }
+      if (!ChargeFoldedConstant(outputs->at(i))) {
+        *result_too_large = true;
+        return errors::InvalidArgument(
+            "Can't fold ", node_name, ", the folded constants would exceed ",
+            kMaxFoldedConstantsSize, " bytes");
+      }
     } else {
       // Create an empty NodeDef to identify dead outputs (e.g. the output of a
       // switch that's not selected by the switch predicate).
@@ -3442,6 +3457,99 @@ Status ConstantFolding::AddQuantizedMatMulMinMaxOutConstNodes(
   return Status::OK();
 }
 
+bool ConstantFolding::ChargeFoldedConstant(const NodeDef& const_node) {
+  const AttrValue& value = const_node.attr().at("value");
+  const int64 size = value.tensor().ByteSizeLong();
+  const bool deduplicated = size >= kMinDeduplicatedConstantSize;
+  uint64 fingerprint = 0;
+  if (deduplicated) {
+    fingerprint = FastAttrValueHash(value);
+    if (folded_constant_fingerprints_.contains(fingerprint)) {
+      return true;
+    }
+  }
+  if (folded_constants_size_ + size > kMaxFoldedConstantsSize) {
+    return false;
+  }
+  folded_constants_size_ += size;
+  if (deduplicated) {
+    folded_constant_fingerprints_.insert(fingerprint);
+  }
+  return true;
+}
+
+void ConstantFolding::DeduplicateConstants(GraphDef* optimized_graph) const {
+  // Candidates are bucketed by a hash of their value, device and control
+  // dependencies, then compared exactly within a bucket.
+  std::unordered_map<uint64, std::vector<int>> buckets;
+  std::unordered_map<string, string> replacements;
+  std::vector<int> nodes_to_delete;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    const NodeDef& node = optimized_graph->node(i);
+    if (!IsConstant(node) || !HasNodeAttr(node, "value") ||
+        nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end() ||
+        feed_nodes_.find(node.name()) != feed_nodes_.end()) {
+      continue;
+    }
+    const AttrValue& value = node.attr().at("value");
+    if (value.tensor().ByteSizeLong() < kMinDeduplicatedConstantSize) {
+      continue;
+    }
+    std::set<string> control_inputs(node.input().begin(), node.input().end());
+    uint64 hash =
+        Hash64Combine(FastAttrValueHash(value), Hash64(node.device()));
+    for (const string& input : control_inputs) {
+      hash = Hash64Combine(hash, Hash64(input));
+    }
+    std::vector<int>& bucket = buckets[hash];
+    const NodeDef* kept_node = nullptr;
+    for (int kept : bucket) {
+      const NodeDef& candidate = optimized_graph->node(kept);
+      if (candidate.device() == node.device() &&
+          std::set<string>(candidate.input().begin(),
+                           candidate.input().end()) == control_inputs &&
+          FastAreAttrValuesEqual(candidate.attr().at("value"), value)) {
+        kept_node = &candidate;
+        break;
+      }
+    }
+    if (kept_node == nullptr) {
+      bucket.push_back(i);
+    } else {
+      VLOG(1) << "Deduplicating constant " << node.name() << " into "
+              << kept_node->name();
+      replacements[node.name()] = kept_node->name();
+      nodes_to_delete.push_back(i);
+    }
+  }
+  if (replacements.empty()) {
+    return;
+  }
+
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    std::unordered_set<string> control_inputs;
+    int num_inputs = 0;
+    for (int i = 0; i < node.input_size(); ++i) {
+      int port;
+      const string input_name = ParseNodeName(node.input(i), &port);
+      auto it = replacements.find(input_name);
+      string input = node.input(i);
+      if (it != replacements.end()) {
+        input = port < 0 ? AsControlDependency(it->second) : it->second;
+      }
+      // Drop control dependencies made redundant by the merge.
+      if (port < 0 && !control_inputs.insert(input).second) {
+        continue;
+      }
+      node.set_input(num_inputs++, input);
+    }
+    while (node.input_size() > num_inputs) {
+      node.mutable_input()->RemoveLast();
+    }
+  }
+  EraseNodesFromGraph(std::move(nodes_to_delete), optimized_graph);
+}
+
 Status ConstantFolding::RunOptimizationPass(Cluster* cluster,
                                             const GrapplerItem& item,
                                             GraphDef* optimized_graph) {
@@ -3525,6 +3633,8 @@ Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
   has_fetch_ = !item.fetch.empty();
+  folded_constants_size_ = 0;
+  folded_constant_fingerprints_.clear();
   GrapplerItem item_to_optimize = item;
   *optimized_graph = item.graph;
   int64 node_count;
@@ -3538,6 +3648,7 @@ Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
     TF_RETURN_IF_ERROR(
         RunOptimizationPass(cluster, item_to_optimize, optimized_graph));
   } while (graph_modified_ || optimized_graph->node_size() != node_count);
+  DeduplicateConstants(optimized_graph);
   *optimized_graph->mutable_library() = item.graph.library();
   *optimized_graph->mutable_versions() = item.graph.versions();
 
@@ -257,6 +257,15 @@ class ConstantFolding : public GraphOptimizer {
   Status AddQuantizedMatMulMinMaxOutConstNodes(NodeDef* node,
                                                GraphDef* optimized_graph);
 
+  // Charges the folded constant `const_node` against the folding budget.
+  // Returns false if it doesn't fit. Large constants whose content was already
+  // folded are free since DeduplicateConstants() keeps a single copy.
+  bool ChargeFoldedConstant(const NodeDef& const_node);
+
+  // Merges large Const nodes holding the same value on the same device and
+  // with the same control dependencies into one of them.
+  void DeduplicateConstants(GraphDef* optimized_graph) const;
+
   // Points to an externally provided device or to owned_device_;
   RewriterConfig::Toggle opt_level_;
   DeviceBase* cpu_device_;
@@ -271,6 +280,10 @@ class ConstantFolding : public GraphOptimizer {
   bool has_fetch_;
   bool graph_modified_;
   bool graph_contains_assign_or_inplace_op_;
+  // Total size of the distinct constants folded so far, and the fingerprints
+  // of the large ones.
+  int64 folded_constants_size_;
+  absl::flat_hash_set<uint64> folded_constant_fingerprints_;
 };
 
 }  // end namespace grappler
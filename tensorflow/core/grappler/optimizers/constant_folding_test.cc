@@ -3154,6 +3154,51 @@ TEST_F(ConstantFoldingTest, LargeConstant) {
   test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
 }
 
+TEST_F(ConstantFoldingTest, DeduplicateLargeConstants) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Tensor c_t(DT_FLOAT, TensorShape({8 * 1024}));
+  test::FillIota<float>(&c_t, 1.0f);
+  Output c = ops::Const(scope.WithOpName("c"), c_t);
+  // Both negations fold into the same 32KB constant.
+  Output neg1 = ops::Neg(scope.WithOpName("neg1"), c);
+  Output neg2 = ops::Neg(scope.WithOpName("neg2"), c);
+  Output x = ops::Placeholder(scope.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape(TensorShape({8 * 1024})));
+  Output out1 = ops::Add(scope.WithOpName("out1"), x, neg1);
+  Output out2 = ops::Add(scope.WithOpName("out2"), x, neg2);
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+  item.fetch = {"out1", "out2"};
+
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  GraphDef output;
+  Status status = optimizer.Optimize(/*cluster=*/nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  int num_large_constants = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.op() == "Const" &&
+        node.attr().at("value").tensor().ByteSizeLong() >= 16 * 1024) {
+      ++num_large_constants;
+      EXPECT_EQ(node.name(), "neg1");
+    } else if (node.name() == "out1" || node.name() == "out2") {
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(1), "neg1");
+    }
+  }
+  EXPECT_EQ(num_large_constants, 1);
+
+  Tensor x_t(DT_FLOAT, TensorShape({8 * 1024}));
+  test::FillIota<float>(&x_t, 2.0f);
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, {{"x", x_t}});
+  ASSERT_EQ(tensors_expected.size(), 2);
+  auto tensors = EvaluateNodes(output, item.fetch, {{"x", x_t}});
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+  test::ExpectTensorEqual<float>(tensors_expected[1], tensors[1]);
+}
+
 TEST_F(ConstantFoldingTest, SwitchIdenticalInputs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output x = ops::Placeholder(s.WithOpName("x"), DT_BOOL,
@@ -93,6 +93,12 @@ Status ShuffleAndRepeatFusion::OptimizeAndCollectStats(
       continue;
     }
 
+    // The fused kernel keeps its buffer in memory.
+    if (HasNodeAttr(shuffle_node, "spill_dir") &&
+        !shuffle_node.attr().at("spill_dir").s().empty()) {
+      continue;
+    }
+
     NodeDef* shuffle_and_repeat_node =
         graph.AddNode(make_shuffle_and_repeat_node(shuffle_node, repeat_node));
     TF_RETURN_IF_ERROR(graph.UpdateFanouts(repeat_node.name(),
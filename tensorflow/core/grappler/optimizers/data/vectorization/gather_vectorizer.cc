@@ -0,0 +1,119 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char* const kGatherPrefix = "vectorized/gather";
+
+// Reads the value of `tensor` if it is produced by a scalar integer Const.
+Status GetScalarConstant(const WrappedTensor& tensor, int64* value) {
+  if (!tensor.node->IsConstant() || tensor.stacked) {
+    return errors::Unimplemented(
+        "Only a constant axis is supported when vectorizing Gather.");
+  }
+  TensorProto proto;
+  TF_RETURN_IF_ERROR(GetNodeAttr(tensor.node->attrs(), "value", &proto));
+  Tensor t;
+  if (!t.FromProto(proto) || t.dims() != 0 ||
+      (t.dtype() != DT_INT32 && t.dtype() != DT_INT64)) {
+    return errors::InvalidArgument("Expected the axis to be an integer scalar");
+  }
+  *value = t.dtype() == DT_INT32 ? t.scalar<int32>()() : t.scalar<int64>()();
+  return Status::OK();
+}
+
+// Vectorizes Gather and GatherV2 into GatherV2 when the indices are stacked.
+// If the params are stacked too, the stacked dimension becomes one more batch
+// dimension of the gather. Otherwise, the params are shared by all elements,
+// and only gathering along their first dimension keeps the stacked dimension
+// first in the output.
+class GatherVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    NodeBuilder::NodeOut params, indices;
+    TF_RETURN_IF_ERROR(inputs.stacked(1, &indices));
+
+    int64 axis = 0;
+    int64 batch_dims = 0;
+    if (node.type_string() == "GatherV2") {
+      TF_RETURN_IF_ERROR(GetScalarConstant(inputs.at(2), &axis));
+      if (HasNodeAttr(node.def(), "batch_dims")) {
+        TF_RETURN_IF_ERROR(
+            GetNodeAttr(node.attrs(), "batch_dims", &batch_dims));
+      }
+    }
+
+    if (inputs.at(0).stacked) {
+      TF_RETURN_IF_ERROR(inputs.stacked(0, &params));
+      // Negative values count from the end, so they don't change.
+      if (axis >= 0) ++axis;
+      if (batch_dims >= 0) ++batch_dims;
+    } else {
+      TF_RETURN_IF_ERROR(inputs.unstacked(0, &params));
+      if (axis != 0 || batch_dims != 0) {
+        return errors::Unimplemented(
+            "Vectorizing Gather with unstacked params is only supported along "
+            "their first dimension.");
+      }
+    }
+
+    DataType params_type, indices_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(node.attrs(), "Tparams", &params_type));
+    TF_RETURN_IF_ERROR(GetNodeAttr(node.attrs(), "Tindices", &indices_type));
+
+    Status status;
+    Scope parent = NewInternalScope(outer_scope, &status, nullptr);
+    Scope s = parent.NewSubScope(kGatherPrefix);
+    Output new_axis = ops::Const(s, axis);
+    TF_RETURN_IF_ERROR(status);
+
+    Node* new_node;
+    TF_RETURN_IF_ERROR(NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                   "GatherV2")
+                           .Input(params)
+                           .Input(indices)
+                           .Input(new_axis.node())
+                           .Attr("Tparams", params_type)
+                           .Attr("Tindices", indices_type)
+                           .Attr("Taxis", DT_INT64)
+                           .Attr("batch_dims", batch_dims)
+                           .Finalize(outer_scope, &new_node));
+
+    // Add output mappings
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("Gather", GatherVectorizer);
+REGISTER_VECTORIZER("GatherV2", GatherVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
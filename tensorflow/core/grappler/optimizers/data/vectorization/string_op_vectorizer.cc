@@ -0,0 +1,67 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Vectorizes ops that act on each element of their first input, and whose
+// other inputs are scalars that configure them, such as regex patterns. Such
+// an op is the vectorized version of itself, with the first input stacked and
+// the others unstacked.
+class ElementwiseOpVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    NodeBuilder::NodeOut input;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &input));
+
+    std::vector<NodeBuilder::NodeOut> scalars(inputs.size() - 1);
+    for (size_t i = 1; i < inputs.size(); ++i) {
+      TF_RETURN_IF_ERROR(inputs.unstacked(i, &scalars[i - 1]));
+    }
+
+    Node* new_node;
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(input);
+    for (const auto& scalar : scalars) {
+      node_builder = node_builder.Input(scalar);
+    }
+    for (const auto& attr : node.attrs()) {
+      node_builder = node_builder.Attr(attr.first, attr.second);
+    }
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+// DecodeRaw appends a dimension to the shape of its input, so decoding the
+// stacked records keeps the stacked dimension first.
+REGISTER_VECTORIZER("DecodeRaw", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("RegexFullMatch", ElementwiseOpVectorizer);
+REGISTER_VECTORIZER("RegexReplace", ElementwiseOpVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/strings/str_join.h"
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/function.h"
@@ -239,6 +240,7 @@ Status Vectorization::AddConversionMapping(Node* op_node) {
 
   auto vectorizer = VectorizerRegistry::Global()->Get(op_node->type_string());
   if (vectorizer == nullptr) {
+    metrics::RecordTFDataVectorizationBlocked(op_node->type_string());
     return errors::Unimplemented("No vectorizer registered for op: ",
                                  op_node->type_string());
   }
@@ -277,6 +279,7 @@ Status Vectorization::AddConversionMapping(Node* op_node) {
   if (!s.ok()) {
     VLOG(2) << "Vectorizer for op \"" << op_node->type_string()
             << "\" failed with error: " << s;
+    metrics::RecordTFDataVectorizationBlocked(op_node->type_string());
     return s;
   }
 
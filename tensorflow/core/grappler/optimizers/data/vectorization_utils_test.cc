@@ -1001,6 +1001,94 @@ INSTANTIATE_TEST_CASE_P(
                       "SquaredDifference", "Sub", "TruncateDiv", "TruncateMod",
                       "Zeta"));
 
+class StringUnaryTest : public ::testing::TestWithParam<const char*> {};
+
+TEST_P(StringUnaryTest, VectorizeCwiseStringUnary) {
+  TF_EXPECT_OK(CwiseTestHelper(DT_STRING, GetParam(), 1));
+}
+
+INSTANTIATE_TEST_CASE_P(Test, StringUnaryTest,
+                        ::testing::Values("DecodeBase64", "EncodeBase64",
+                                          "StringLength", "StringLower",
+                                          "StringStrip", "StringToNumber",
+                                          "StringUpper"));
+
+TEST(VectorizerTest, VectorizeRegexReplace) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: string"},
+      /*out_def=*/{"ret0: string"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const<string>("Pattern", "a+"),
+       FunctionDefHelper::Const<string>("Rewrite", "a"),
+       {{"Replace"},
+        "RegexReplace",
+        {"arg0", "Pattern:output:0", "Rewrite:output:0"},
+        {}}},
+      /*ret_def=*/{{"ret0", "Replace:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  const NodeDef& replace_node = vectorized->node_def(
+      function_utils::FindFunctionNodeWithOp("RegexReplace", *vectorized));
+  EXPECT_EQ(replace_node.input(0),
+            vectorized->signature().input_arg(0).name());
+}
+
+TEST(VectorizerTest, VectorizeGatherWithUnstackedParams) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: int32"},
+      /*out_def=*/{"ret0: float"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const<float>("Params", {1.0f, 2.0f, 3.0f}),
+       FunctionDefHelper::Const("Axis", 0),
+       {{"Gather"},
+        "GatherV2",
+        {"Params:output:0", "arg0", "Axis:output:0"},
+        {{"Tparams", DT_FLOAT}, {"Tindices", DT_INT32}, {"Taxis", DT_INT32}}}},
+      /*ret_def=*/{{"ret0", "Gather:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  const NodeDef& gather_node = vectorized->node_def(
+      function_utils::FindFunctionNodeWithOp("GatherV2", *vectorized));
+  EXPECT_EQ(gather_node.input(1), vectorized->signature().input_arg(0).name());
+  EXPECT_EQ(gather_node.attr().at("batch_dims").i(), 0);
+}
+
+TEST(VectorizerTest, VectorizeGatherWithStackedParams) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: float", "arg1: int32"},
+      /*out_def=*/{"ret0: float"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {{{"Gather"},
+        "Gather",
+        {"arg0", "arg1"},
+        {{"Tparams", DT_FLOAT}, {"Tindices", DT_INT32}}}},
+      /*ret_def=*/{{"ret0", "Gather:output:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  // The stacked dimension is gathered over as a batch dimension.
+  const NodeDef& gather_node = vectorized->node_def(
+      function_utils::FindFunctionNodeWithOp("GatherV2", *vectorized));
+  EXPECT_EQ(gather_node.attr().at("batch_dims").i(), 1);
+}
+
 // Before:
 //
 //
@@ -15,15 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer_factory.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/port.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -41,6 +45,67 @@ inline int GetNumGPUs(const Cluster& cluster) {
   return num_gpus;
 }
 
+// Picks the device and formats to convert to from the devices in the cluster.
+// GPUs prefer NCHW. On CPU only MKL kernels run NCHW efficiently; they reorder
+// into their blocked layouts (e.g. nChw16c) internally, so handing them NCHW
+// avoids a reorder back to NHWC between consecutive ops.
+Status GetLayoutTarget(const Cluster& cluster, string* target_device,
+                       string* src_format, string* dst_format) {
+  if (GetNumGPUs(cluster) > 0) {
+    *target_device = "GPU";
+  } else if (IsMklEnabled()) {
+    *target_device = "CPU";
+  } else {
+    return errors::Aborted(
+        "No GPUs found and MKL is not enabled: GenericLayoutOptimizer has no "
+        "preferred layout for this cluster.");
+  }
+  *src_format = "NHWC";
+  *dst_format = "NCHW";
+  return Status::OK();
+}
+
+// Returns the number of bytes written by `transpose`, computed from its
+// annotated output shape, or -1 if the shape is not fully known.
+int64 GetTransposeBytes(const utils::MutableNodeView& transpose) {
+  const auto* output_shape_attr = transpose.GetAttr(kAttrOutputShape);
+  const auto* data_type_attr = transpose.GetAttr("T");
+  if (output_shape_attr == nullptr || data_type_attr == nullptr ||
+      output_shape_attr->list().shape_size() < 1) {
+    return -1;
+  }
+  const TensorShapeProto& shape = output_shape_attr->list().shape(0);
+  if (shape.unknown_rank()) {
+    return -1;
+  }
+  int64 num_elements = 1;
+  for (const auto& dim : shape.dim()) {
+    if (dim.size() < 0) {
+      return -1;
+    }
+    num_elements *= dim.size();
+  }
+  return num_elements * DataTypeSize(data_type_attr->type());
+}
+
+// Sums the bytes written by the Transpose nodes with node index in
+// [begin, end). Returns -1 if the size of any of them is unknown.
+int64 GetTotalTransposeBytes(TransposeContext* context, int begin, int end) {
+  int64 total_bytes = 0;
+  for (int i = begin; i < end; ++i) {
+    auto* node_view = context->graph_view->GetNode(i);
+    if (!IsTranspose(*node_view->node())) {
+      continue;
+    }
+    const int64 bytes = GetTransposeBytes(*node_view);
+    if (bytes < 0) {
+      return -1;
+    }
+    total_bytes += bytes;
+  }
+  return total_bytes;
+}
+
 Status ExpandLayoutSensitiveOp(TransposeContext* context,
                                TransposerFactory* transposer_factory) {
   const int num_nodes = context->num_nodes;
@@ -146,28 +211,68 @@ inline bool IsCancellableNodePair(
          IsCancellableDataFormatNodePair(fanout_transpose, fanin_transpose);
 }
 
+// Returns true if `node`, a node of the original graph, can be removed after
+// its regular fanouts are forwarded. Nodes added by the optimizer always can.
+inline bool IsRemovableOriginalNode(const TransposeContext& context,
+                                    const utils::MutableNodeView& node) {
+  return !context.nodes_to_preserve.contains(node.GetName()) &&
+         node.NumControllingFanins() == 0 && node.NumControlledFanouts() == 0;
+}
+
 Status EraseCancellableNodes(TransposeContext* context) {
   const int original_num_nodes = context->num_nodes;
   utils::MutableGraphView* graph_view = context->graph_view.get();
   utils::Mutation* mutation = graph_view->GetMutationBuilder();
   const int num_nodes = graph_view->NumNodes();
+  // Nodes removed so far. A pair is skipped if it touches one of them, as the
+  // fanins seen through the graph view are stale until the mutation applies.
+  absl::flat_hash_set<int> removed_nodes;
+
+  auto remove_node = [&](utils::MutableNodeView* node, bool is_added) {
+    mutation->RemoveNode(node);
+    removed_nodes.insert(node->node_index());
+    if (node->NumRegularFanins() < 2) {
+      return;
+    }
+    auto* perm_node = node->GetRegularFanin(1).node_view();
+    // Perm constants of original transposes may be shared.
+    if (is_added || (perm_node->NumRegularFanouts() == 1 &&
+                     IsRemovableOriginalNode(*context, *perm_node))) {
+      mutation->RemoveNode(perm_node);
+    }
+  };
 
-  for (int i = original_num_nodes; i < num_nodes; ++i) {
+  // Adjacent pairs are cancelled across the whole graph, so transposes already
+  // present in the graph are folded together with the ones added around
+  // converted ops.
+  for (int i = 0; i < num_nodes; ++i) {
     auto* node = graph_view->GetNode(i);
-    if (node->NumRegularFanins() < 1) {
+    if (node->NumRegularFanins() < 1 || removed_nodes.contains(i)) {
       continue;
     }
     const auto& regular_fanin_0 = node->GetRegularFanin(0);
     auto* fanin_node = regular_fanin_0.node_view();
-    // TODO(lyandy): Lift restriction once original nodes in the graph can be
-    // pruned away.
-    if (fanin_node->node_index() < original_num_nodes) {
+    if (fanin_node->NumRegularFanins() < 1 ||
+        removed_nodes.contains(fanin_node->node_index())) {
+      continue;
+    }
+    const bool node_is_added = i >= original_num_nodes;
+    const bool fanin_is_added = fanin_node->node_index() >= original_num_nodes;
+    if (!node_is_added && !IsRemovableOriginalNode(*context, *node)) {
+      continue;
+    }
+    if (!fanin_is_added &&
+        (fanin_node->NumRegularFanouts() != 1 ||
+         !IsRemovableOriginalNode(*context, *fanin_node))) {
       continue;
     }
     if (!IsCancellableNodePair(*node, *fanin_node)) {
       continue;
     }
     const auto& fanin_to_forward = fanin_node->GetRegularFanin(0);
+    if (removed_nodes.contains(fanin_to_forward.node_view()->node_index())) {
+      continue;
+    }
     TensorId fanin_id_to_forward(fanin_to_forward.node_view()->GetName(),
                                  fanin_to_forward.index());
     for (const auto& regular_fanout : node->GetRegularFanout(0)) {
@@ -175,14 +280,8 @@ Status EraseCancellableNodes(TransposeContext* context) {
                                         regular_fanout.index(),
                                         fanin_id_to_forward);
     }
-    mutation->RemoveNode(node);
-    if (node->NumRegularFanins() > 1) {
-      mutation->RemoveNode(node->GetRegularFanin(1).node_view());
-    }
-    mutation->RemoveNode(fanin_node);
-    if (fanin_node->NumRegularFanins() > 1) {
-      mutation->RemoveNode(fanin_node->GetRegularFanin(1).node_view());
-    }
+    remove_node(node, node_is_added);
+    remove_node(fanin_node, fanin_is_added);
   }
   return mutation->Apply();
 }
@@ -208,20 +307,33 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
         << "generic layout optimizer was called with cluster == nullptr";
     return errors::Aborted("cluster == nullptr.");
   }
-  if (GetNumGPUs(*cluster) < 1) {
-    return errors::Aborted(
-        "No GPUs found: GenericLayoutOptimizer is currently only tuned for "
-        "GPU.");
+  string target_device = target_device_;
+  string src_format = src_format_;
+  string dst_format = dst_format_;
+  if (target_device.empty()) {
+    TF_RETURN_IF_ERROR(
+        GetLayoutTarget(*cluster, &target_device, &src_format, &dst_format));
   }
 
   TransposeContext context;
   TF_RETURN_IF_ERROR(TransposeContext::InitializeTransposeContext(
-      item, cluster, src_format_, dst_format_, target_device_, &context));
+      item, cluster, src_format, dst_format, target_device, &context));
   TransposerFactory transposer_factory;
   TF_RETURN_IF_ERROR(ExpandLayoutSensitiveOp(&context, &transposer_factory));
   if (context.graph.node_size() > context.num_nodes) {
+    // The transposes added around layout sensitive ops stand for the layout
+    // conversions these ops would otherwise perform internally.
+    const int64 bytes_before = GetTotalTransposeBytes(
+        &context, /*begin=*/0, /*end=*/context.graph.node_size());
     TF_RETURN_IF_ERROR(ExpandLayoutAgnosticOp(&context, &transposer_factory));
     TF_RETURN_IF_ERROR(EraseCancellableNodes(&context));
+    const int64 bytes_after = GetTotalTransposeBytes(
+        &context, /*begin=*/0, /*end=*/context.graph_view->NumNodes());
+    if (bytes_before >= 0 && bytes_after > bytes_before) {
+      return errors::Aborted(
+          "Layout conversion is not profitable: the remaining transposes move ",
+          bytes_after, " bytes, versus ", bytes_before, " bytes without it.");
+    }
     // TODO(lyandy): Remove sorting once other optimizers are migrated to using
     // `utils::GraphView`.
     TF_RETURN_IF_ERROR(
@@ -22,9 +22,22 @@ namespace tensorflow {
 namespace grappler {
 
 // Optimize the data layout for convolutional models.
+//
+// By default the target is picked from the cluster: GPUs convert NHWC ops to
+// NCHW, and CPUs do the same when MKL is enabled. The conversion is only kept
+// if the transposes left in the graph move no more bytes than the layout
+// conversions the converted ops would otherwise perform internally.
 class GenericLayoutOptimizer : public GraphOptimizer {
  public:
   GenericLayoutOptimizer() : GraphOptimizer() {}
+  // Converts layout sensitive ops placed on `target_device` from `src_format`
+  // to `dst_format`, regardless of the devices in the cluster.
+  GenericLayoutOptimizer(const string& target_device, const string& src_format,
+                         const string& dst_format)
+      : GraphOptimizer(),
+        target_device_(target_device),
+        src_format_(src_format),
+        dst_format_(dst_format) {}
   ~GenericLayoutOptimizer() override {}
 
   string name() const override { return "layout"; };
@@ -36,9 +49,10 @@ class GenericLayoutOptimizer : public GraphOptimizer {
                 const GraphDef& optimize_output, double result) override;
 
  private:
-  string target_device_ = "GPU";
-  string src_format_ = "NHWC";
-  string dst_format_ = "NCHW";
+  // Empty when the target should be picked from the cluster.
+  string target_device_;
+  string src_format_;
+  string dst_format_;
 };
 
 }  // namespace grappler
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/graph_view.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/port.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -431,7 +432,7 @@ TEST_F(GenericLayoutOptimizerTest, Conv2DDataFormatVecPermuteCollapse) {
                           "fill-0-0-TransposeNCHWToNHWC-LayoutOptimizer", 0);
 }
 
-TEST_F(GenericLayoutOptimizerTest, DoNotPruneNonAddedCancellableTransposes) {
+TEST_F(GenericLayoutOptimizerTest, PruneNonAddedCancellableTransposes) {
 #if !GOOGLE_CUDA
   GTEST_SKIP() << "CUDA is not enabled";
 #endif  // !GOOGLE_CUDA
@@ -472,52 +473,33 @@ TEST_F(GenericLayoutOptimizerTest, DoNotPruneNonAddedCancellableTransposes) {
   utils::GraphView graph_view(&output, &status);
   TF_ASSERT_OK(status);
 
-  LOG(INFO) << graph_view.graph()->DebugString();
-  auto* input_node = graph_view.GetNode("input");
-  ASSERT_NE(input_node, nullptr);
-
-  auto* input_in_transpose_node = graph_view.GetNode("input_in_transpose");
-  ASSERT_NE(input_in_transpose_node, nullptr);
-  ASSERT_EQ(input_in_transpose_node->NumRegularFanins(), 2);
-  VerifyRegularFaninMatch(input_in_transpose_node, 0, input_node->GetName(), 0);
-
-  auto* input_out_transpose_node = graph_view.GetNode("input_out_transpose");
-  ASSERT_NE(input_out_transpose_node, nullptr);
-  ASSERT_EQ(input_out_transpose_node->NumRegularFanins(), 2);
-  VerifyRegularFaninMatch(input_out_transpose_node, 0,
-                          input_in_transpose_node->GetName(), 0);
+  // The original transpose pairs cancel out among themselves and with the
+  // transposes added around the converted BiasAdd.
+  EXPECT_EQ(graph_view.GetNode("input_in_transpose"), nullptr);
+  EXPECT_EQ(graph_view.GetNode("input_out_transpose"), nullptr);
+  EXPECT_EQ(graph_view.GetNode("output_in_transpose"), nullptr);
+  EXPECT_EQ(
+      graph_view.GetNode("bias_add-0-0-TransposeNCHWToNHWC-LayoutOptimizer"),
+      nullptr);
 
   auto* bias_add_in_transpose_node =
       graph_view.GetNode("bias_add-0-TransposeNHWCToNCHW-LayoutOptimizer");
   ASSERT_NE(bias_add_in_transpose_node, nullptr);
   ASSERT_EQ(bias_add_in_transpose_node->NumRegularFanins(), 2);
-  VerifyRegularFaninMatch(bias_add_in_transpose_node, 0,
-                          input_out_transpose_node->GetName(), 0);
+  VerifyRegularFaninMatch(bias_add_in_transpose_node, 0, "input", 0);
 
   auto* bias_add_node = graph_view.GetNode("bias_add");
   ASSERT_NE(bias_add_node, nullptr);
   ASSERT_EQ(bias_add_node->NumRegularFanins(), 2);
   VerifyRegularFaninMatch(bias_add_node, 0,
                           bias_add_in_transpose_node->GetName(), 0);
-
-  auto* bias_add_out_transpose_node =
-      graph_view.GetNode("bias_add-0-0-TransposeNCHWToNHWC-LayoutOptimizer");
-  ASSERT_NE(bias_add_out_transpose_node, nullptr);
-  ASSERT_EQ(bias_add_out_transpose_node->NumRegularFanins(), 2);
-  VerifyRegularFaninMatch(bias_add_out_transpose_node, 0,
-                          bias_add_node->GetName(), 0);
-
-  auto* output_in_transpose_node = graph_view.GetNode("output_in_transpose");
-  ASSERT_NE(output_in_transpose_node, nullptr);
-  ASSERT_EQ(output_in_transpose_node->NumRegularFanins(), 2);
-  VerifyRegularFaninMatch(output_in_transpose_node, 0,
-                          bias_add_out_transpose_node->GetName(), 0);
+  VerifyDataFormatAttributeMatch(bias_add_node, "NCHW");
 
   auto* output_out_transpose_node = graph_view.GetNode("output_out_transpose");
   ASSERT_NE(output_out_transpose_node, nullptr);
   ASSERT_EQ(output_out_transpose_node->NumRegularFanins(), 2);
   VerifyRegularFaninMatch(output_out_transpose_node, 0,
-                          output_in_transpose_node->GetName(), 0);
+                          bias_add_node->GetName(), 0);
 
   auto* output_node = graph_view.GetNode("output");
   ASSERT_NE(output_node, nullptr);
@@ -526,6 +508,64 @@ TEST_F(GenericLayoutOptimizerTest, DoNotPruneNonAddedCancellableTransposes) {
                           0);
 }
 
+TEST(GenericLayoutOptimizerCPUTest, CPUTarget) {
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  VirtualCluster cluster({{"/CPU:0", cpu_device}});
+  TF_ASSERT_OK(cluster.Provision());
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto conv = SimpleConv2D(&s, 4, 2, "VALID", "/CPU:0");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GenericLayoutOptimizer optimizer("CPU", "NHWC", "NCHW");
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(&cluster, item, &output));
+
+  Status status;
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  auto* conv_node = graph_view.GetNode("Conv2D");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NCHW");
+  auto* input_transpose_node =
+      graph_view.GetNode("Conv2D-0-TransposeNHWCToNCHW-LayoutOptimizer");
+  ASSERT_NE(input_transpose_node, nullptr);
+  VerifyRegularFaninMatch(conv_node, 0, input_transpose_node->GetName(), 0);
+  TF_ASSERT_OK(cluster.Shutdown());
+}
+
+TEST(GenericLayoutOptimizerCPUTest, CPUOnlyClusterTarget) {
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  VirtualCluster cluster({{"/CPU:0", cpu_device}});
+  TF_ASSERT_OK(cluster.Provision());
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto conv = SimpleConv2D(&s, 4, 2, "VALID", "/CPU:0");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Without GPUs the layout is only converted for MKL kernels.
+  GenericLayoutOptimizer optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(&cluster, item, &output);
+  if (!IsMklEnabled()) {
+    EXPECT_TRUE(errors::IsAborted(status));
+  } else {
+    TF_ASSERT_OK(status);
+    utils::GraphView graph_view(&output, &status);
+    TF_ASSERT_OK(status);
+    auto* conv_node = graph_view.GetNode("Conv2D");
+    ASSERT_NE(conv_node, nullptr);
+    VerifyDataFormatAttributeMatch(conv_node, "NCHW");
+  }
+  TF_ASSERT_OK(cluster.Shutdown());
+}
+
 // TODO(yanzha): Add more complex Graph for test.
 
 }  // namespace grappler
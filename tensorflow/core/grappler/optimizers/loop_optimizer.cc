@@ -22,12 +22,15 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
@@ -38,10 +41,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
 #include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/utils/traversal.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
@@ -453,6 +459,402 @@ Status LoopInvariantNodeMotionOptimizer::Optimize() {
   return Status::OK();
 }
 
+// Returns the node or function argument producing `input`, an input of a node
+// of a FunctionDef ("arg" or "node:output:index").
+string FunctionDefInputNode(const string& input) {
+  return input.substr(0, input.find(':'));
+}
+
+// Hoists loop invariant nodes out of the body function of functional While
+// loops. A loop variable is invariant if the body returns it unchanged.
+// Stateless nodes of the body that only depend on invariant loop variables and
+// constants are copied in front of the While node, and the values they compute
+// are passed to the body as new invariant loop variables.
+class FunctionalLoopInvariantNodeMotionOptimizer {
+ public:
+  FunctionalLoopInvariantNodeMotionOptimizer(
+      const std::unordered_set<string>& nodes_to_preserve,
+      GraphDef* optimized_graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        optimized_graph_(optimized_graph),
+        flib_(OpRegistry::Global(), optimized_graph->library()) {}
+  Status Optimize();
+
+ private:
+  // A body output to pass to the loop as a new invariant loop variable.
+  struct HoistedOutput {
+    string body_output;  // In FunctionDef format, i.e. "node:output:index".
+    string graph_output;  // The same output of the node copied to the graph.
+    DataType dtype;
+  };
+
+  Status OptimizeWhile(NodeDef* while_node,
+                       absl::flat_hash_set<string>* node_names);
+  bool IsHoistable(const NodeDef& node) const;
+  // Converts a body output in FunctionDef format of one of `nodes` to the
+  // corresponding output of its copy `prefix`/node in the graph.
+  Status GetGraphOutput(
+      const string& body_output,
+      const absl::flat_hash_map<string, const NodeDef*>& nodes,
+      const string& prefix, string* graph_output, DataType* dtype) const;
+  // Returns `base`, or a variation of it if `fdef` already uses the name.
+  string UniqueArgName(const FunctionDef& fdef, const string& base) const;
+
+  const std::unordered_set<string>& nodes_to_preserve_;
+  GraphDef* optimized_graph_;  // Not owned.
+  FunctionLibraryDefinition flib_;
+};
+
+Status FunctionalLoopInvariantNodeMotionOptimizer::Optimize() {
+  absl::flat_hash_set<string> node_names;
+  for (const NodeDef& node : optimized_graph_->node()) {
+    node_names.insert(node.name());
+  }
+  const int num_nodes = optimized_graph_->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = optimized_graph_->mutable_node(i);
+    if (IsWhile(*node) && nodes_to_preserve_.count(node->name()) == 0) {
+      TF_RETURN_IF_ERROR(OptimizeWhile(node, &node_names));
+    }
+  }
+  return Status::OK();
+}
+
+bool FunctionalLoopInvariantNodeMotionOptimizer::IsHoistable(
+    const NodeDef& node) const {
+  if (IsControlFlow(node) || flib_.Find(node.op()) != nullptr) {
+    return false;
+  }
+  for (const auto& attr : node.attr()) {
+    // Functional ops such as StatelessIf call other functions.
+    if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+      return false;
+    }
+  }
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return false;
+  }
+  return !op_def->is_stateful();
+}
+
+Status FunctionalLoopInvariantNodeMotionOptimizer::GetGraphOutput(
+    const string& body_output,
+    const absl::flat_hash_map<string, const NodeDef*>& nodes,
+    const string& prefix, string* graph_output, DataType* dtype) const {
+  const std::vector<string> pieces = str_util::Split(body_output, ':');
+  int index;
+  if (pieces.size() != 3 || !strings::safe_strto32(pieces[2], &index)) {
+    return errors::InvalidArgument("Unexpected function body input ",
+                                   body_output);
+  }
+  const NodeDef& node = *nodes.at(pieces[0]);
+  const OpDef* op_def;
+  TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node.op(), &op_def));
+  NameRangeMap output_ranges;
+  TF_RETURN_IF_ERROR(
+      NameRangesForNode(node, *op_def, nullptr, &output_ranges));
+  const auto range = output_ranges.find(pieces[1]);
+  if (range == output_ranges.end()) {
+    return errors::InvalidArgument("Unknown output ", body_output);
+  }
+  DataTypeVector output_types;
+  TF_RETURN_IF_ERROR(OutputTypesForNode(node, *op_def, &output_types));
+  const int graph_index = range->second.first + index;
+  *dtype = output_types[graph_index];
+  *graph_output = AddPrefixToNodeName(node.name(), prefix);
+  if (graph_index > 0) {
+    strings::StrAppend(graph_output, ":", graph_index);
+  }
+  return Status::OK();
+}
+
+string FunctionalLoopInvariantNodeMotionOptimizer::UniqueArgName(
+    const FunctionDef& fdef, const string& base) const {
+  absl::flat_hash_set<string> names;
+  for (const auto& arg : fdef.signature().input_arg()) {
+    names.insert(arg.name());
+  }
+  for (const auto& arg : fdef.signature().output_arg()) {
+    names.insert(arg.name());
+  }
+  for (const NodeDef& node : fdef.node_def()) {
+    names.insert(node.name());
+  }
+  string name = base;
+  while (names.contains(name)) {
+    name = strings::StrCat(name, "_");
+  }
+  return name;
+}
+
+Status FunctionalLoopInvariantNodeMotionOptimizer::OptimizeWhile(
+    NodeDef* while_node, absl::flat_hash_set<string>* node_names) {
+  const NameAttrList& body_attr = while_node->attr().at("body").func();
+  const NameAttrList& cond_attr = while_node->attr().at("cond").func();
+  const FunctionDef* body = flib_.Find(body_attr.name());
+  const FunctionDef* cond = flib_.Find(cond_attr.name());
+  if (body == nullptr || cond == nullptr || IsParametrized(*body) ||
+      IsParametrized(*cond) || body_attr.attr_size() > 0 ||
+      cond_attr.attr_size() > 0) {
+    return Status::OK();
+  }
+  const int num_loop_vars = body->signature().input_arg_size();
+  if (body->signature().output_arg_size() != num_loop_vars ||
+      cond->signature().input_arg_size() != num_loop_vars ||
+      NumNonControlInputs(*while_node) != num_loop_vars) {
+    return Status::OK();
+  }
+
+  absl::flat_hash_map<string, const NodeDef*> body_nodes;
+  for (const NodeDef& node : body->node_def()) {
+    body_nodes[node.name()] = &node;
+  }
+
+  // Find the invariant loop variables, returned as is or through an Identity.
+  absl::flat_hash_map<string, int> invariant_args;
+  for (int i = 0; i < num_loop_vars; ++i) {
+    const string& arg = body->signature().input_arg(i).name();
+    const auto ret = body->ret().find(body->signature().output_arg(i).name());
+    if (ret == body->ret().end()) continue;
+    if (ret->second == arg) {
+      invariant_args[arg] = i;
+      continue;
+    }
+    const auto it = body_nodes.find(FunctionDefInputNode(ret->second));
+    if (it != body_nodes.end() && IsIdentity(*it->second) &&
+        it->second->input_size() == 1 && it->second->input(0) == arg) {
+      invariant_args[arg] = i;
+    }
+  }
+  if (invariant_args.empty()) {
+    return Status::OK();
+  }
+
+  // Find the nodes that only depend on invariant loop variables, constants, or
+  // other such nodes, in topological order.
+  std::vector<const NodeDef*> hoisted_nodes;
+  absl::flat_hash_set<string> hoisted;
+  absl::flat_hash_set<string> constants;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef& node : body->node_def()) {
+      if (hoisted.contains(node.name()) || constants.contains(node.name()) ||
+          invariant_args.contains(node.name())) {
+        continue;
+      }
+      if (IsConstant(node)) {
+        if (node.input_size() == 0) constants.insert(node.name());
+        continue;
+      }
+      // Identities of invariant loop variables are aliases of the variables.
+      if (IsIdentity(node) && node.input_size() == 1 &&
+          invariant_args.contains(FunctionDefInputNode(node.input(0)))) {
+        invariant_args[node.name()] =
+            invariant_args[FunctionDefInputNode(node.input(0))];
+        changed = true;
+        continue;
+      }
+      if (node.input_size() == 0 || !IsHoistable(node)) continue;
+      bool invariant = true;
+      for (const string& input : node.input()) {
+        const string input_node = FunctionDefInputNode(input);
+        if (IsControlInput(input) ||
+            !(invariant_args.contains(input_node) ||
+              hoisted.contains(input_node) || constants.contains(input_node))) {
+          invariant = false;
+          break;
+        }
+      }
+      if (invariant) {
+        hoisted.insert(node.name());
+        hoisted_nodes.push_back(&node);
+        changed = true;
+      }
+    }
+  }
+  if (hoisted_nodes.empty()) {
+    return Status::OK();
+  }
+
+  // The outputs of hoisted nodes that are still used in the body become new
+  // loop variables.
+  const string prefix =
+      AddPrefixToNodeName("loop_invariant", while_node->name());
+  std::vector<HoistedOutput> hoisted_outputs;
+  absl::flat_hash_map<string, int> hoisted_output_index;
+  auto add_hoisted_output = [&](const string& body_output) -> Status {
+    if (hoisted_output_index.contains(body_output)) return Status::OK();
+    HoistedOutput output;
+    output.body_output = body_output;
+    TF_RETURN_IF_ERROR(GetGraphOutput(body_output, body_nodes, prefix,
+                                      &output.graph_output, &output.dtype));
+    hoisted_output_index[body_output] = hoisted_outputs.size();
+    hoisted_outputs.push_back(std::move(output));
+    return Status::OK();
+  };
+  absl::flat_hash_set<string> control_dependencies;
+  for (const NodeDef& node : body->node_def()) {
+    if (hoisted.contains(node.name())) continue;
+    for (const string& input : node.input()) {
+      const string input_node = FunctionDefInputNode(input);
+      if (IsControlInput(input)) {
+        control_dependencies.insert(input.substr(1));
+      } else if (hoisted.contains(input_node)) {
+        TF_RETURN_IF_ERROR(add_hoisted_output(input));
+      }
+    }
+  }
+  for (const auto& ret : body->ret()) {
+    if (hoisted.contains(FunctionDefInputNode(ret.second))) {
+      TF_RETURN_IF_ERROR(add_hoisted_output(ret.second));
+    }
+  }
+  for (const auto& control_ret : body->control_ret()) {
+    control_dependencies.insert(control_ret.second);
+  }
+  if (hoisted_outputs.empty()) {
+    return Status::OK();
+  }
+  // Hoisted nodes that are control dependencies of the body stay in the body,
+  // along with the hoisted nodes they read.
+  absl::flat_hash_set<string> kept_in_body;
+  std::vector<string> to_keep(control_dependencies.begin(),
+                              control_dependencies.end());
+  while (!to_keep.empty()) {
+    const string name = to_keep.back();
+    to_keep.pop_back();
+    if (!hoisted.contains(name) || !kept_in_body.insert(name).second) continue;
+    for (const string& input : body_nodes.at(name)->input()) {
+      to_keep.push_back(FunctionDefInputNode(input));
+    }
+  }
+
+  // Copy the hoisted nodes and the constants they read in front of the loop.
+  std::vector<NodeDef> graph_nodes;
+  absl::flat_hash_set<string> copied_constants;
+  auto to_graph_input = [&](const string& input, string* graph_input) {
+    const string input_node = FunctionDefInputNode(input);
+    const auto arg = invariant_args.find(input_node);
+    if (arg != invariant_args.end()) {
+      *graph_input = while_node->input(arg->second);
+      return Status::OK();
+    }
+    if (constants.contains(input_node) &&
+        copied_constants.insert(input_node).second) {
+      graph_nodes.push_back(*body_nodes.at(input_node));
+    }
+    DataType unused;
+    return GetGraphOutput(input, body_nodes, prefix, graph_input, &unused);
+  };
+  for (const NodeDef* node : hoisted_nodes) {
+    NodeDef graph_node = *node;
+    for (int i = 0; i < graph_node.input_size(); ++i) {
+      string graph_input;
+      TF_RETURN_IF_ERROR(to_graph_input(graph_node.input(i), &graph_input));
+      graph_node.set_input(i, graph_input);
+    }
+    graph_nodes.push_back(std::move(graph_node));
+  }
+  for (NodeDef& graph_node : graph_nodes) {
+    graph_node.set_name(AddPrefixToNodeName(graph_node.name(), prefix));
+    if (node_names->contains(graph_node.name())) {
+      return Status::OK();
+    }
+    graph_node.set_device(while_node->device());
+    // Keep the control dependencies of the loop, e.g. in case they are dead.
+    for (const string& input : while_node->input()) {
+      if (IsControlInput(input)) *graph_node.add_input() = input;
+    }
+  }
+
+  // Pass the hoisted outputs to new loop variables of the body and the
+  // condition.
+  FunctionDef new_body = *body;
+  FunctionDef new_cond = *cond;
+  new_body.mutable_signature()->set_name(
+      flib_.UniqueFunctionName(strings::StrCat(body_attr.name(), "_licm_")));
+  new_cond.mutable_signature()->set_name(
+      flib_.UniqueFunctionName(strings::StrCat(cond_attr.name(), "_licm_")));
+  absl::flat_hash_map<string, string> replacements;
+  for (int i = 0; i < hoisted_outputs.size(); ++i) {
+    const HoistedOutput& output = hoisted_outputs[i];
+    const string base_name = strings::StrCat("loop_invariant_", i);
+    const string arg_name = UniqueArgName(new_body, base_name);
+    OpDef::ArgDef* body_arg = new_body.mutable_signature()->add_input_arg();
+    body_arg->set_name(arg_name);
+    body_arg->set_type(output.dtype);
+    const string output_name =
+        UniqueArgName(new_body, strings::StrCat(arg_name, "_output"));
+    OpDef::ArgDef* body_output = new_body.mutable_signature()->add_output_arg();
+    body_output->set_name(output_name);
+    body_output->set_type(output.dtype);
+    (*new_body.mutable_ret())[output_name] = arg_name;
+    const string cond_arg_name = UniqueArgName(new_cond, base_name);
+    OpDef::ArgDef* cond_arg = new_cond.mutable_signature()->add_input_arg();
+    cond_arg->set_name(cond_arg_name);
+    cond_arg->set_type(output.dtype);
+    replacements[output.body_output] = arg_name;
+  }
+  for (auto& ret : *new_body.mutable_ret()) {
+    const auto it = replacements.find(ret.second);
+    if (it != replacements.end()) ret.second = it->second;
+  }
+  // Drop the hoisted nodes from the body, and read the new loop variables
+  // instead.
+  auto* body_node_defs = new_body.mutable_node_def();
+  for (int i = body_node_defs->size() - 1; i >= 0; --i) {
+    NodeDef* node = body_node_defs->Mutable(i);
+    if (hoisted.contains(node->name())) {
+      if (!kept_in_body.contains(node->name())) {
+        body_node_defs->DeleteSubrange(i, 1);
+      }
+      continue;
+    }
+    for (int j = 0; j < node->input_size(); ++j) {
+      const auto it = replacements.find(node->input(j));
+      if (it != replacements.end()) node->set_input(j, it->second);
+    }
+  }
+  TF_RETURN_IF_ERROR(flib_.AddFunctionDef(new_body));
+  TF_RETURN_IF_ERROR(flib_.AddFunctionDef(new_cond));
+  *optimized_graph_->mutable_library()->add_function() = new_body;
+  *optimized_graph_->mutable_library()->add_function() = new_cond;
+
+  // Rewire the loop.
+  VLOG(1) << "Hoisting " << hoisted_nodes.size()
+          << " loop invariant node(s) out of " << while_node->name();
+  std::vector<string> control_inputs;
+  for (const string& input : while_node->input()) {
+    if (IsControlInput(input)) control_inputs.push_back(input);
+  }
+  while_node->mutable_input()->DeleteSubrange(
+      num_loop_vars, while_node->input_size() - num_loop_vars);
+  auto& attrs = *while_node->mutable_attr();
+  for (const HoistedOutput& output : hoisted_outputs) {
+    *while_node->add_input() = output.graph_output;
+    attrs["T"].mutable_list()->add_type(output.dtype);
+    // Shape lists are either empty or list the shapes of all loop variables.
+    for (const char* shapes_attr : {"output_shapes", "_output_shapes"}) {
+      auto it = attrs.find(shapes_attr);
+      if (it != attrs.end() && it->second.list().shape_size() > 0) {
+        it->second.mutable_list()->add_shape()->set_unknown_rank(true);
+      }
+    }
+  }
+  for (const string& input : control_inputs) {
+    *while_node->add_input() = input;
+  }
+  attrs["body"].mutable_func()->set_name(new_body.signature().name());
+  attrs["cond"].mutable_func()->set_name(new_cond.signature().name());
+  for (NodeDef& graph_node : graph_nodes) {
+    node_names->insert(graph_node.name());
+    *optimized_graph_->add_node() = std::move(graph_node);
+  }
+  return Status::OK();
+}
+
 std::vector<int> GetStackPushNodesToConvert(
     const GraphTopologyView& graph_view,
     const std::unordered_set<string>& nodes_to_preserve, int stack_node_idx) {
@@ -592,22 +994,62 @@ bool IsReallyConstant(const NodeDef& node,
   return feed_nodes.find(node.name()) == feed_nodes.end();
 }
 
+// Returns true and sets `value` if the boolean `predicate` always has the same
+// value, i.e. if it is a constant forwarded through Identity, Snapshot and
+// LogicalNot nodes. PlaceholderWithDefault nodes that are not fed forward their
+// default value, but this is only known when `feeds_are_complete` is set.
+bool GetConstantPredicate(const NodeDef& predicate, const NodeMap& node_map,
+                          const absl::flat_hash_set<string>& feed_nodes,
+                          bool feeds_are_complete, bool* value) {
+  const NodeDef* node = &predicate;
+  bool negate = false;
+  // The bound protects against malformed graphs with cycles.
+  for (int depth = 0; depth < 32 && node != nullptr; ++depth) {
+    if (IsReallyConstant(*node, feed_nodes)) {
+      Tensor selector;
+      if (!selector.FromProto(node->attr().at("value").tensor()) ||
+          selector.dtype() != DT_BOOL || selector.NumElements() != 1) {
+        return false;
+      }
+      *value = selector.flat<bool>()(0) != negate;
+      return true;
+    }
+    if (feed_nodes.contains(node->name())) {
+      return false;
+    }
+    const bool forwards_input =
+        IsIdentity(*node) || IsSnapshot(*node) || IsLogicalNot(*node) ||
+        (feeds_are_complete && node->op() == "PlaceholderWithDefault");
+    if (!forwards_input || node->input_size() == 0 ||
+        IsControlInput(node->input(0))) {
+      return false;
+    }
+    if (IsLogicalNot(*node)) {
+      negate = !negate;
+    }
+    node = node_map.GetNode(node->input(0));
+  }
+  return false;
+}
+
 Status CheckForDeadFanout(const MutableGraphView& view,
                           const NodeDef& switch_node, const NodeMap& node_map,
                           const absl::flat_hash_set<string>& feed_nodes,
-                          DeviceBase* cpu_device, ResourceMgr* resource_mgr,
-                          bool* has_dead_fanout, int* dead_fanout) {
+                          bool feeds_are_complete, DeviceBase* cpu_device,
+                          ResourceMgr* resource_mgr, bool* has_dead_fanout,
+                          int* dead_fanout) {
   *has_dead_fanout = false;
   GraphView::InputPort switch_loopcond_port(&switch_node, 1);
   const NodeDef* switch_predicate =
       view.GetRegularFanin(switch_loopcond_port).node;
 
-  // CASE 1: Control is a constant.
-  if (IsReallyConstant(*switch_predicate, feed_nodes)) {
-    Tensor selector;
-    CHECK(selector.FromProto(switch_predicate->attr().at("value").tensor()));
+  // CASE 1: Control is a constant, possibly forwarded by other nodes.
+  bool predicate_value;
+  if (GetConstantPredicate(*switch_predicate, node_map, feed_nodes,
+                           feeds_are_complete, &predicate_value)) {
     *has_dead_fanout = true;
-    *dead_fanout = selector.scalar<bool>()() ? 0 : 1;
+    *dead_fanout = predicate_value ? 0 : 1;
+    return Status::OK();
   }
 
   GraphView::InputPort switch_input_port(&switch_node, 0);
@@ -703,13 +1145,14 @@ LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
                              DeviceBase* cpu_device)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
-      options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+      options_(LoopOptimizerOptions::Default(opt_level)) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
 Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   if (!options_.enable_loop_invariant_node_motion &&
+      !options_.enable_functional_loop_invariant_node_motion &&
       !options_.enable_stack_push_removal &&
       !options_.enable_dead_branch_removal) {
     return errors::Aborted("Nothing to do.");
@@ -720,6 +1163,11 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     LoopInvariantNodeMotionOptimizer linm_optimizer(optimized_graph);
     TF_RETURN_IF_ERROR(linm_optimizer.Optimize());
   }
+  if (options_.enable_functional_loop_invariant_node_motion) {
+    FunctionalLoopInvariantNodeMotionOptimizer flinm_optimizer(
+        item.NodesToPreserve(), optimized_graph);
+    TF_RETURN_IF_ERROR(flinm_optimizer.Optimize());
+  }
   if (options_.enable_stack_push_removal) {
     TF_RETURN_IF_ERROR(RemoveStackOps(item.NodesToPreserve(), optimized_graph));
   }
@@ -731,8 +1179,9 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     for (const auto& feed : item.feed) {
       feed_nodes.insert(NodeName(feed.first));
     }
-    TF_RETURN_IF_ERROR(RemoveDeadBranches(item.NodesToPreserve(), node_map,
-                                          feed_nodes, optimized_graph));
+    TF_RETURN_IF_ERROR(RemoveDeadBranches(
+        item.NodesToPreserve(), node_map, feed_nodes,
+        item.optimization_options().feeds_are_complete, optimized_graph));
   }
 
   return Status::OK();
@@ -741,12 +1190,12 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
 Status LoopOptimizer::RemoveDeadBranches(
     const std::unordered_set<string>& nodes_to_preserve,
     const NodeMap& node_map, const absl::flat_hash_set<string>& feed_nodes,
-    GraphDef* optimized_graph) {
+    bool feeds_are_complete, GraphDef* optimized_graph) {
   std::unordered_set<const NodeDef*> dead_nodes;
   std::unordered_map<NodeDef*, std::set<int>> dead_merge_inputs;
-  // TODO(bsteiner): also rewrite switches as identity. For now we just record
-  // them
-  absl::flat_hash_set<GraphView::OutputPort> identity_switches;
+  // Switches whose dead output is removed entirely, mapped to their live
+  // output. They are rewritten as Identity nodes once the graph is pruned.
+  absl::flat_hash_map<string, int> identity_switches;
 
   MutableGraphView view(optimized_graph);
   for (const NodeDef& node : optimized_graph->node()) {
@@ -762,14 +1211,13 @@ Status LoopOptimizer::RemoveDeadBranches(
 
     int dead_fanout;
     bool has_dead_fanout;
-    TF_RETURN_IF_ERROR(CheckForDeadFanout(view, node, node_map, feed_nodes,
-                                          cpu_device_, resource_mgr_.get(),
-                                          &has_dead_fanout, &dead_fanout));
+    TF_RETURN_IF_ERROR(CheckForDeadFanout(
+        view, node, node_map, feed_nodes, feeds_are_complete, cpu_device_,
+        resource_mgr_.get(), &has_dead_fanout, &dead_fanout));
     if (!has_dead_fanout) {
       continue;
     }
     GraphView::OutputPort dead(&node, dead_fanout);
-    identity_switches.insert(dead);
 
     SetVector<MutableGraphView::InputPort, absl::Hash<MutableGraphView::Port>>
         zombie_inputs;
@@ -855,6 +1303,9 @@ Status LoopOptimizer::RemoveDeadBranches(
     if (!found_node_to_preserve) {
       std::swap(dead_nodes, local_dead_nodes);
       std::swap(dead_merge_inputs, local_dead_merge_inputs);
+      if (node.op() == "Switch") {
+        identity_switches[node.name()] = 1 - dead_fanout;
+      }
     }
   }
 
@@ -909,6 +1360,38 @@ Status LoopOptimizer::RemoveDeadBranches(
 
   EraseNodesFromGraph(std::move(nodes_idx_to_delete), optimized_graph);
 
+  // Rewrite the switches that only forward their input to their live output as
+  // Identity nodes. The predicate becomes a control input, so that the Identity
+  // is still dead whenever the predicate is.
+  if (!identity_switches.empty()) {
+    for (const NodeDef& node : optimized_graph->node()) {
+      for (const string& input : node.input()) {
+        const TensorId tensor = ParseTensorName(input);
+        auto it = identity_switches.find(tensor.node());
+        if (it != identity_switches.end() &&
+            tensor.index() != Graph::kControlSlot &&
+            tensor.index() != it->second) {
+          // The dead output is still consumed: keep the switch.
+          identity_switches.erase(it);
+        }
+      }
+    }
+  }
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    if (identity_switches.contains(node.name())) {
+      node.set_op("Identity");
+      node.set_input(1, AsControlDependency(NodeName(node.input(1))));
+      continue;
+    }
+    for (int i = 0; i < node.input_size(); ++i) {
+      const TensorId tensor = ParseTensorName(node.input(i));
+      auto it = identity_switches.find(tensor.node());
+      if (it != identity_switches.end() && tensor.index() > 0) {
+        node.set_input(i, string(tensor.node()));
+      }
+    }
+  }
+
   return Status::OK();
 }
 
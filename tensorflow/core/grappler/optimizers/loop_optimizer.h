@@ -52,11 +52,15 @@ class LoopOptimizer : public GraphOptimizer {
   // Granular control for loop optimizer stages.
   struct LoopOptimizerOptions {
     bool enable_loop_invariant_node_motion = false;
+    // Hoists invariant nodes out of the body of functional While loops.
+    bool enable_functional_loop_invariant_node_motion = false;
     bool enable_stack_push_removal = true;
     bool enable_dead_branch_removal = true;
 
     static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
       LoopOptimizerOptions options;
+      options.enable_functional_loop_invariant_node_motion =
+          opt_level == RewriterConfig::AGGRESSIVE;
       return options;
     }
   };
@@ -64,7 +68,7 @@ class LoopOptimizer : public GraphOptimizer {
   Status RemoveDeadBranches(const std::unordered_set<string>& nodes_to_preserve,
                             const NodeMap& node_map,
                             const absl::flat_hash_set<string>& feed_nodes,
-                            GraphDef* optimized_graph);
+                            bool feeds_are_complete, GraphDef* optimized_graph);
 
   RewriterConfig::Toggle opt_level_;
   DeviceBase* cpu_device_;
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -869,6 +870,62 @@ TEST_F(LoopOptimizerTest, RemoveDeadBranchesConstantCondition) {
   test::ExpectTensorNear<float>(tensors_expected[1], tensors[1], 1e-6);
 }
 
+TEST_F(LoopOptimizerTest, RemoveDeadBranchesPlaceholderWithDefault) {
+  Scope scope = Scope::NewRootScope();
+  Output v_in = ops::Const<float>(scope.WithOpName("v_in"), {123.0}, {});
+  Output is_training_default = ops::Const(
+      scope.WithOpName("is_training_default"), false, TensorShape({}));
+  Output is_training = ops::PlaceholderWithDefault(
+      scope.WithOpName("is_training"), is_training_default, TensorShape({}));
+  Output is_inference =
+      ops::LogicalNot(scope.WithOpName("is_inference"), is_training);
+  ops::Switch s(scope.WithOpName("switch"), v_in, is_inference);
+  Output square = ops::Square(scope.WithOpName("square"), s.output_false);
+  Output sqrt = ops::Sqrt(scope.WithOpName("sqrt"), s.output_true);
+  ops::Merge m(scope.WithOpName("m"), {square, sqrt});
+  Output out = ops::Identity(scope.WithOpName("out"), m.output);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  // The default value of is_training is only known if it is never fed.
+  LoopOptimizer optimizer(RewriterConfig::AGGRESSIVE, nullptr);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "switch") {
+      EXPECT_EQ(node.op(), "Switch");
+    }
+  }
+
+  item.optimization_options().feeds_are_complete = true;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(output.node_size(), item.graph.node_size() - 1);
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "square");
+    if (node.name() == "switch") {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "v_in");
+      EXPECT_EQ(node.input(1), "^is_inference");
+    } else if (node.name() == "sqrt") {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "switch");
+    } else if (node.name() == "m") {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "sqrt");
+    }
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-6);
+}
+
 TEST_F(LoopOptimizerTest, RemoveDeadBranchesFullyRemoveDeadBranches) {
   const string gdef_ascii = R"EOF(
 node {
@@ -1706,5 +1763,93 @@ versions {
   EXPECT_TRUE(found);
 }
 
+TEST_F(LoopOptimizerTest, HoistFunctionalWhileInvariants) {
+  using test::function::NDef;
+
+  FunctionDef body = FunctionDefHelper::Create(
+      // Name
+      "Body",
+      // Args
+      {"i: int32", "x: float", "y: float"},
+      // Return values
+      {"i_out: int32", "x_out: float", "y_out: float"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"one"},
+        "Const",
+        {},
+        {{"value", test::AsScalar<int32>(1)}, {"dtype", DT_INT32}}},
+       {{"next_i"}, "Add", {"i", "one:output:0"}, {{"T", DT_INT32}}},
+       {{"y_squared"}, "Square", {"y"}, {{"T", DT_FLOAT}}},
+       {{"next_x"}, "Add", {"x", "y_squared:y:0"}, {{"T", DT_FLOAT}}}},
+      // Mapping
+      {{"i_out", "next_i:z:0"}, {"x_out", "next_x:z:0"}, {"y_out", "y"}});
+  FunctionDef cond = FunctionDefHelper::Create(
+      // Name
+      "Cond",
+      // Args
+      {"i: int32", "x: float", "y: float"},
+      // Return values
+      {"z: bool"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"n"},
+        "Const",
+        {},
+        {{"value", test::AsScalar<int32>(10)}, {"dtype", DT_INT32}}},
+       {{"less"}, "Less", {"i", "n:output:0"}, {{"T", DT_INT32}}}},
+      // Mapping
+      {{"z", "less:z:0"}});
+
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("i0", "Const", {},
+            {{"value", test::AsScalar<int32>(0)}, {"dtype", DT_INT32}}),
+       NDef("x0", "Const", {},
+            {{"value", test::AsScalar<float>(0.0f)}, {"dtype", DT_FLOAT}}),
+       NDef("y0", "Const", {},
+            {{"value", test::AsScalar<float>(2.0f)}, {"dtype", DT_FLOAT}}),
+       NDef("while", "While", {"i0", "x0", "y0"},
+            {{"T", DataTypeSlice{DT_INT32, DT_FLOAT, DT_FLOAT}},
+             {"cond", FunctionDefHelper::FunctionRef("Cond")},
+             {"body", FunctionDefHelper::FunctionRef("Body")}}),
+       NDef("out", "Identity", {"while:1"}, {{"T", DT_FLOAT}})},
+      {body, cond});
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer(RewriterConfig::AGGRESSIVE, nullptr);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* hoisted = node_map.GetNode("while/loop_invariant/y_squared");
+  ASSERT_NE(hoisted, nullptr);
+  EXPECT_EQ(hoisted->op(), "Square");
+  ASSERT_EQ(hoisted->input_size(), 1);
+  EXPECT_EQ(hoisted->input(0), "y0");
+
+  const NodeDef* while_node = node_map.GetNode("while");
+  ASSERT_EQ(while_node->input_size(), 4);
+  EXPECT_EQ(while_node->input(3), "while/loop_invariant/y_squared");
+  EXPECT_EQ(while_node->attr().at("T").list().type_size(), 4);
+  const string& body_name = while_node->attr().at("body").func().name();
+  EXPECT_NE(body_name, "Body");
+  for (const FunctionDef& function : output.library().function()) {
+    if (function.signature().name() != body_name) continue;
+    EXPECT_EQ(function.signature().input_arg_size(), 4);
+    for (const NodeDef& node : function.node_def()) {
+      EXPECT_NE(node.op(), "Square");
+    }
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
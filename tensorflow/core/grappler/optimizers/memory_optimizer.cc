@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_cost_database.h"
 #include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -1259,6 +1262,236 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   return updated_graph;
 }
 
+// A tensor that is live at the memory peak, together with the cheapest way of
+// evicting it found by MemoryBudgetPass.
+struct EvictionCandidate {
+  NodeDef* node;
+  int output_id;
+  int64 memory_used;
+  // Estimated cost of the eviction, in nanoseconds.
+  double cost;
+  bool recompute;
+  // Nodes in the recomputation target scope which consume the tensor.
+  std::unordered_set<NodeDef*> target_nodes;
+
+  // Cheapest bytes first.
+  bool operator<(const EvictionCandidate& other) const {
+    return cost / memory_used < other.cost / other.memory_used;
+  }
+};
+
+// Brings the estimated peak memory usage of every device under
+// `memory_budget_bytes` (or under the device memory size if the budget is not
+// set). Tensors that are live at the peak are ranked by the estimated cost of
+// either recomputing their producer (measured in `op_cost_database` when
+// available, predicted by the OpLevelCostEstimator otherwise) or swapping them
+// out to the host, and the cheapest ones are evicted until the budget is met. Only tensors consumed by nodes in the recomputation target
+// scope are considered, since the other uses are on the forward path. Swaps
+// are recorded as "_swap_to_host" annotations which are materialized by
+// SwappingPass.
+bool MemoryBudgetPass(Cluster* cluster, int64 memory_budget_bytes,
+                      const string& recomputation_targets_name_scope,
+                      std::shared_ptr<const OpCostDatabase> op_cost_database,
+                      GrapplerItem* item,
+                      std::unordered_set<string>* skip_list) {
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  GraphMemory memory(*item);
+  Status s = memory.InferStatically(devices);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return false;
+  }
+  GraphProperties properties(*item);
+  if (!properties
+           .InferStatically(/*assume_valid_feeds=*/true,
+                            /*aggressive_shape_inference=*/false,
+                            /*include_tensor_values=*/false)
+           .ok()) {
+    return false;
+  }
+
+  // This invalidates all NodeDef pointers, so it needs to happen before we
+  // start collecting candidates.
+  if (!TopologicalSort(&item->graph).ok()) {
+    return false;
+  }
+  NodeMap node_map(&item->graph);
+  MutableGraphView view(&item->graph);
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item->graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+  auto is_target = [&recomputation_targets_name_scope](const NodeDef& node) {
+    return node.name().find(recomputation_targets_name_scope) == 0 ||
+           node.name().find("/" + recomputation_targets_name_scope) != -1;
+  };
+  auto is_recomputable = [&](const NodeDef& node) {
+    if (is_target(node) || feeds.count(node.name()) > 0 ||
+        IsConstant(node) || IsVariable(node) || !IsFreeOfSideEffect(node) ||
+        node.op().empty() || IsControlFlow(node)) {
+      return false;
+    }
+    for (const string& input_name : node.input()) {
+      const NodeDef* input_node = node_map.GetNode(input_name);
+      if (input_node == nullptr || is_target(*input_node)) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  MeasuredOpLevelCostEstimator cost_estimator(std::move(op_cost_database));
+  std::vector<EvictionCandidate> evictions;
+  std::unordered_set<string> evicted_tensors;
+  for (const auto& device : devices) {
+    const string& device_name = device.first;
+    const DeviceProperties& prop = device.second;
+    const int64 budget =
+        memory_budget_bytes > 0 ? memory_budget_bytes : prop.memory_size();
+    if (budget <= 0) {
+      VLOG(1) << "No memory budget for device " << device_name;
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage =
+        memory.GetPeakMemoryUsage(device_name);
+    if (mem_usage.used_memory <= budget) {
+      continue;
+    }
+    int64 required_savings = mem_usage.used_memory - budget;
+    VLOG(1) << "Peak memory usage of " << mem_usage.used_memory
+            << " bytes on device " << device_name << " exceeds budget by "
+            << required_savings << " bytes";
+
+    std::vector<EvictionCandidate> candidates;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (live_tensor.memory_used <= 1024) {
+        // Don't bother with small tensors.
+        continue;
+      }
+      const string tensor_name =
+          strings::StrCat(live_tensor.node, ":", live_tensor.output_id);
+      if (skip_list->count(live_tensor.node) > 0 ||
+          evicted_tensors.count(tensor_name) > 0) {
+        continue;
+      }
+      NodeDef* node = node_map.GetNode(live_tensor.node);
+      if (node == nullptr) {
+        continue;
+      }
+      EvictionCandidate candidate;
+      candidate.node = node;
+      candidate.output_id = live_tensor.output_id;
+      candidate.memory_used = live_tensor.memory_used;
+      MutableGraphView::OutputPort port =
+          view.GetOutputPort(live_tensor.node, live_tensor.output_id);
+      bool swappable = prop.type() == "GPU" && IsSwappable(view, port);
+      for (const MutableGraphView::InputPort& fanout : view.GetFanout(port)) {
+        if (fanout.port_id < 0 || !is_target(*fanout.node)) {
+          continue;
+        }
+        candidate.target_nodes.insert(fanout.node);
+        swappable &= IsSwappable(fanout);
+      }
+      if (candidate.target_nodes.empty()) {
+        continue;
+      }
+
+      double recompute_cost = std::numeric_limits<double>::infinity();
+      if (is_recomputable(*node)) {
+        OpContext op_context;
+        op_context.name = node->name();
+        op_context.device_name = device_name;
+        op_context.op_info = BuildOpInfoWithoutDevice(
+            *node, name_to_node,
+            properties.GetInputProperties(node->name()));
+        *op_context.op_info.mutable_device() = prop;
+        const Costs costs = cost_estimator.PredictCosts(op_context);
+        if (!costs.inaccurate) {
+          recompute_cost = costs.execution_time.count();
+        }
+      }
+      // Swapping moves the tensor out and back in, over PCIe running at
+      // 16 GBps (as in SwappingPass).
+      const double swap_cost =
+          swappable ? 2.0 * live_tensor.memory_used / 16
+                    : std::numeric_limits<double>::infinity();
+      if (std::isinf(recompute_cost) && std::isinf(swap_cost)) {
+        continue;
+      }
+      candidate.recompute = recompute_cost <= swap_cost;
+      candidate.cost = std::min(recompute_cost, swap_cost);
+      candidates.push_back(std::move(candidate));
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    for (EvictionCandidate& candidate : candidates) {
+      if (required_savings <= 0) {
+        break;
+      }
+      VLOG(1) << "Will " << (candidate.recompute ? "recompute" : "swap")
+              << " tensor " << candidate.node->name() << ":"
+              << candidate.output_id << " of size " << candidate.memory_used
+              << " at an estimated cost of " << candidate.cost << "ns";
+      required_savings -= candidate.memory_used;
+      evicted_tensors.insert(
+          strings::StrCat(candidate.node->name(), ":", candidate.output_id));
+      evictions.push_back(std::move(candidate));
+    }
+  }
+  if (evictions.empty()) {
+    return false;
+  }
+
+  std::unordered_map<const NodeDef*, int> topological_numbering;
+  for (int node_number = 0; node_number < item->graph.node_size();
+       ++node_number) {
+    topological_numbering[item->graph.mutable_node(node_number)] =
+        item->graph.node_size() - node_number - 1;
+  }
+  // All the outputs of a node are recomputed together.
+  std::vector<NodeDef*> recomputed_nodes;
+  std::unordered_map<NodeDef*, std::unordered_set<NodeDef*>> recomputations;
+  for (const EvictionCandidate& eviction : evictions) {
+    if (eviction.recompute) {
+      if (recomputations.count(eviction.node) == 0) {
+        recomputed_nodes.push_back(eviction.node);
+      }
+      recomputations[eviction.node].insert(eviction.target_nodes.begin(),
+                                           eviction.target_nodes.end());
+      continue;
+    }
+    const string tensor_name =
+        strings::StrCat(eviction.node->name(), ":", eviction.output_id);
+    for (NodeDef* target : eviction.target_nodes) {
+      for (int i = 0; i < target->input_size(); ++i) {
+        if (target->input(i) != tensor_name &&
+            (eviction.output_id != 0 ||
+             target->input(i) != eviction.node->name())) {
+          continue;
+        }
+        AttrValue& swap_to_host = (*target->mutable_attr())["_swap_to_host"];
+        if (swap_to_host.value_case() == AttrValue::kI) {
+          const int64 input_id = swap_to_host.i();
+          swap_to_host.mutable_list()->add_i(input_id);
+        }
+        swap_to_host.mutable_list()->add_i(i);
+      }
+    }
+  }
+  for (NodeDef* node : recomputed_nodes) {
+    RecomputeSubgraph({node}, recomputations[node], node_map,
+                      topological_numbering, &item->graph);
+    skip_list->insert(node->name());
+    skip_list->insert(AddPrefixToNodeName(node->name(), kRecomputedNodePrefix));
+  }
+  return true;
+}
+
 bool CrossesTaskOrCpuGpuBoundary(const NodeDef& node1, const NodeDef& node2) {
   string task1;
   string device1;
@@ -1387,11 +1620,20 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       updated_graph |= SchedulingPass(cluster, &optimized_item);
     }
 
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    if (optimization_level_ == RewriterConfig::MEMORY_BUDGET_HEURISTICS &&
+        cluster != nullptr) {
+      updated_graph |= MemoryBudgetPass(
+          cluster, memory_budget_bytes_, recomputation_targets_name_scope_,
+          op_cost_database_, &optimized_item, &skip_list);
+    }
+
     GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
     if ((optimization_level_ == RewriterConfig::DEFAULT_MEM_OPT ||
          optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS ||
          optimization_level_ == RewriterConfig::HEURISTICS ||
-         optimization_level_ == RewriterConfig::MANUAL) &&
+         optimization_level_ == RewriterConfig::MANUAL ||
+         optimization_level_ == RewriterConfig::MEMORY_BUDGET_HEURISTICS) &&
         cluster != nullptr) {
       updated_graph |= SwappingPass(optimization_level_, cluster,
                                     &optimized_item, &skip_list);
@@ -16,8 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MEMORY_OPTIMIZER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MEMORY_OPTIMIZER_H_
 
+#include <memory>
 #include <string>
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/op_cost_database.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
@@ -33,11 +35,20 @@ class MemoryOptimizer : public GraphOptimizer {
   // recomputation_targets_name_scope: Name scope for potential outputs of
   //   recomputations. See
   //   RewriterConfig::memory_optimizer_target_node_name_scope.
+  // memory_budget_bytes: Per-device memory budget used by
+  //   MEMORY_BUDGET_HEURISTICS. See RewriterConfig::memory_optimizer_budget.
+  // op_cost_database: Measured op costs used to price recomputations, or null
+  //   to rely on the analytical cost model only. See
+  //   RewriterConfig::op_cost_database.
   explicit MemoryOptimizer(
       RewriterConfig::MemOptType optimization_level,
-      const string& recomputation_targets_name_scope = "gradients/")
+      const string& recomputation_targets_name_scope = "gradients/",
+      int64 memory_budget_bytes = 0,
+      std::shared_ptr<const OpCostDatabase> op_cost_database = nullptr)
       : optimization_level_(optimization_level),
-        recomputation_targets_name_scope_(recomputation_targets_name_scope) {}
+        recomputation_targets_name_scope_(recomputation_targets_name_scope),
+        memory_budget_bytes_(memory_budget_bytes),
+        op_cost_database_(std::move(op_cost_database)) {}
   ~MemoryOptimizer() override {}
 
   string name() const override { return "memory_optimizer"; };
@@ -51,6 +62,8 @@ class MemoryOptimizer : public GraphOptimizer {
  private:
   RewriterConfig::MemOptType optimization_level_;
   string recomputation_targets_name_scope_;
+  int64 memory_budget_bytes_;
+  std::shared_ptr<const OpCostDatabase> op_cost_database_;
 };
 
 }  // end namespace grappler
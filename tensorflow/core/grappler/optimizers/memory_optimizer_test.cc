@@ -345,6 +345,43 @@ TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
 #endif
 }
 
+TEST_F(MemoryOptimizerTest, MemoryBudgetRecomputation) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/cpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/cpu:0"), v);
+  Output c = ops::Square(s.WithOpName("c").WithDevice("/cpu:0"), b);
+  Output d = ops::Exp(s.WithOpName("gradients/d").WithDevice("/cpu:0"), c);
+  Output e =
+      ops::AddN(s.WithOpName("gradients/e").WithDevice("/cpu:0"), {d, b});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/e"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // The activations don't fit in a 1KB budget. "b" is only consumed on the CPU,
+  // so it can't be swapped and has to be recomputed instead.
+  MemoryOptimizer optimizer(RewriterConfig::MEMORY_BUDGET_HEURISTICS,
+                            "gradients/", /*memory_budget_bytes=*/1024);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  NodeMap node_map(&output);
+  const NodeDef* recomputed_b = node_map.GetNode("Recomputed/b");
+  ASSERT_NE(nullptr, recomputed_b);
+  EXPECT_EQ("Sqrt", recomputed_b->op());
+  EXPECT_EQ("v", recomputed_b->input(0));
+  const NodeDef* new_e = node_map.GetNode("gradients/e");
+  ASSERT_NE(nullptr, new_e);
+  EXPECT_EQ("gradients/d", new_e->input(0));
+  EXPECT_EQ("Recomputed/b", new_e->input(1));
+  // The forward path still uses the original activation.
+  EXPECT_EQ("b", node_map.GetNode("c")->input(0));
+}
+
 TEST_F(MemoryOptimizerTest, UnswappableInputs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
+#include "tensorflow/core/common_runtime/compilation_profiler.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -47,8 +50,15 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/ptr_util.h"
 
@@ -84,7 +94,8 @@ int NumIterations(const RewriterConfig& cfg) {
 // Check if optimizer is allowed to run only once.
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
-         name == "loop_optimizer" || name == "auto_mixed_precision";
+         name == "loop_optimizer" || name == "auto_mixed_precision" ||
+         name == "auto_mixed_precision_cpu";
 }
 
 uint64 DeadlineMicroSeconds(const RewriterConfig& cfg) {
@@ -99,6 +110,68 @@ uint64 DeadlineMicroSeconds(const RewriterConfig& cfg) {
   }
 }
 
+// Returns a fingerprint of `graph`, used to detect passes that did not change
+// it.
+uint64 GraphFingerprint(const GraphDef& graph) {
+  string serialized;
+  SerializeToStringDeterministic(graph, &serialized);
+  return Fingerprint64(serialized);
+}
+
+// Returns the name of the cache entry for the result of optimizing `item`. It
+// is a fingerprint of everything the result depends on: the graph, the nodes
+// that must be preserved, the optimization options, the rewriter config, the
+// available devices and the TensorFlow version.
+string OptimizationCacheKey(const GrapplerItem& item, const RewriterConfig& cfg,
+                            const Cluster* cluster) {
+  string key;
+  const auto append = [&key](StringPiece value) {
+    strings::StrAppend(&key, value.size(), ":", value, ";");
+  };
+  const auto append_proto = [&append](const protobuf::MessageLite& proto) {
+    string serialized;
+    SerializeToStringDeterministic(proto, &serialized);
+    append(serialized);
+  };
+
+  append(TF_VERSION_STRING);
+  append(strings::StrCat(TF_GRAPH_DEF_VERSION));
+  append_proto(item.graph);
+  append_proto(cfg);
+  for (const auto& feed : item.feed) {
+    append(strings::StrCat(feed.first, DataTypeString(feed.second.dtype()),
+                           feed.second.shape().DebugString()));
+  }
+  for (const auto* nodes : {&item.fetch, &item.init_ops, &item.keep_ops}) {
+    append(absl::StrJoin(*nodes, ","));
+  }
+  append(strings::StrCat(item.save_op, ",", item.restore_op, ",",
+                         item.save_restore_loc_tensor));
+  const auto& options = item.optimization_options();
+  for (bool option : {options.allow_non_differentiable_rewrites,
+                      options.allow_pruning_stateful_and_dataset_ops,
+                      options.optimize_function_library,
+                      options.is_eager_mode}) {
+    append(option ? "1" : "0");
+  }
+
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  std::sort(devices.begin(), devices.end());
+  append(absl::StrJoin(devices, ","));
+  if (cluster != nullptr) {
+    std::map<string, DeviceProperties> cluster_devices(
+        cluster->GetDevices().begin(), cluster->GetDevices().end());
+    for (const auto& device : cluster_devices) {
+      append(device.first);
+      append_proto(device.second);
+    }
+  }
+
+  const Fprint128 fingerprint = Fingerprint128(key);
+  return strings::StrCat(strings::Hex(fingerprint.high64, strings::kZeroPad16),
+                         strings::Hex(fingerprint.low64, strings::kZeroPad16));
+}
+
 // A helper function to decide whether to enable the automatic mixed precision
 // optimizer.
 bool AutoMixedPrecisionEnabled(RewriterConfig::Toggle opt_level) {
@@ -124,6 +197,9 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
   MK_OPT("layout", new GenericLayoutOptimizer());
   MK_OPT("auto_mixed_precision",
          new AutoMixedPrecision(cfg_.auto_mixed_precision()));
+  MK_OPT("auto_mixed_precision_cpu",
+         new AutoMixedPrecision(cfg_.auto_mixed_precision_cpu(),
+                                AutoMixedPrecisionMode::CPU));
   MK_OPT("memory", new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("arithmetic", new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   MK_OPT("autoparallel", new AutoParallel(cfg_.auto_parallel().num_replicas()));
@@ -147,6 +223,15 @@ MetaOptimizer::MetaOptimizer(DeviceBase* cpu_device, const ConfigProto& cfg)
       cfg_(*config_proto_.mutable_graph_options()->mutable_rewrite_options()) {
   DCHECK(cpu_device_ == nullptr ||
          cpu_device_->attributes().device_type() == "CPU");
+  if (!cfg_.op_cost_database().empty()) {
+    auto op_cost_database = std::make_shared<OpCostDatabase>();
+    Status status = op_cost_database->Load(cfg_.op_cost_database());
+    if (status.ok()) {
+      op_cost_database_ = std::move(op_cost_database);
+    } else {
+      LOG(WARNING) << "Ignoring the op cost database: " << status;
+    }
+  }
 }
 
 Status MetaOptimizer::InitializeOptimizers(
@@ -199,15 +284,22 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<AutoMixedPrecision>(cfg_.auto_mixed_precision()));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu())) {
+    optimizers->push_back(MakeUnique<AutoMixedPrecision>(
+        cfg_.auto_mixed_precision_cpu(), AutoMixedPrecisionMode::CPU));
+  }
   if (cfg_.memory_optimization() != RewriterConfig::NO_MEM_OPT) {
     if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
       optimizers->push_back(
           // Use the default target node name prefix "gradients/"
-          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization()));
+          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization(), "gradients/",
+                                      cfg_.memory_optimizer_budget(),
+                                      op_cost_database_));
     } else {
       optimizers->push_back(MakeUnique<MemoryOptimizer>(
           cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
+          cfg_.memory_optimizer_target_node_name_scope(),
+          cfg_.memory_optimizer_budget(), op_cost_database_));
     }
   }
   if (cfg_.auto_parallel().enable()) {
@@ -368,6 +460,14 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
     CompressConstants(optimized_graph);
   }
 
+  // When the optimizers run more than once, a pass that left the graph
+  // unchanged is skipped until another pass changes the graph. This maps such
+  // a pass to the fingerprint of the graph it left unchanged.
+  const bool skip_unchanged_passes = NumIterations(cfg_) > 1;
+  uint64 graph_fingerprint =
+      skip_unchanged_passes ? GraphFingerprint(*optimized_graph) : 0;
+  absl::flat_hash_map<const GraphOptimizer*, uint64> unchanged_by_pass;
+
   for (int iteration = 0; iteration < NumIterations(cfg_); ++iteration) {
     // Don't bother optimizing further if the graph is already tiny.
     if (optimized_graph->node_size() < min_graph_nodes) {
@@ -398,6 +498,14 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
         if (fusion_optimizer == nullptr) fusion_optimizer = optimizer.get();
         continue;
       }
+      if (skip_unchanged_passes) {
+        auto it = unchanged_by_pass.find(optimizer.get());
+        if (it != unchanged_by_pass.end() && it->second == graph_fingerprint) {
+          VLOG(3) << "Skipping " << optimizer->name()
+                  << ", the graph has not changed since its last no-op run";
+          continue;
+        }
+      }
 
       TF_RETURN_IF_ERROR(RunOptimizer(optimizer.get(), cluster, &optimized_item,
                                       optimized_graph, &optimization_result));
@@ -406,6 +514,16 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
         CompressConstants(optimized_graph);
       }
 
+      if (skip_unchanged_passes) {
+        const uint64 new_fingerprint = GraphFingerprint(*optimized_graph);
+        if (new_fingerprint == graph_fingerprint) {
+          unchanged_by_pass[optimizer.get()] = new_fingerprint;
+        } else {
+          unchanged_by_pass.erase(optimizer.get());
+        }
+        graph_fingerprint = new_fingerprint;
+      }
+
       if (VLOG_IS_ON(4)) {
         DumpGraphDefToFile(
             strings::StrCat("after_MetaOptimizer_iteration_", iteration, "_",
@@ -456,7 +574,10 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -478,8 +599,14 @@ Status MetaOptimizer::RunOptimizer(
   optimized_graph->Swap(&optimized_item->graph);
   *optimized_graph = GraphDef();
   optimizer->set_deadline_usec(this->deadline_usec());
-  Status status =
-      optimizer->Optimize(cluster, *optimized_item, optimized_graph);
+  Status status;
+  {
+    ScopedCompilationPhase phase(kCompilationPhaseGrappler, optimizer->name(),
+                                 optimized_item->graph.node_size());
+    status = optimizer->Optimize(cluster, *optimized_item, optimized_graph);
+    phase.set_nodes_after(status.ok() ? optimized_graph->node_size()
+                                      : optimized_item->graph.node_size());
+  }
   uint64 end_us = Env::Default()->NowMicros();
   float duration_ms = (end_us - start_us) / 1000.0f;
 
@@ -518,8 +645,51 @@ Status MetaOptimizer::RunOptimizer(
 
 Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
+  const string& cache_dir = cfg_.meta_optimizer_cache_dir();
+  if (cache_dir.empty()) {
+    return OptimizeUncached(cluster, item, optimized_graph);
+  }
+
+  Env* env = Env::Default();
+  const string cache_path = io::JoinPath(
+      cache_dir,
+      strings::StrCat(OptimizationCacheKey(item, cfg_, cluster), ".pb"));
+  if (env->FileExists(cache_path).ok()) {
+    Status s = ReadBinaryProto(env, cache_path, optimized_graph);
+    if (s.ok()) {
+      VLOG(1) << "Loaded optimized graph for grappler item " << item.id
+              << " from " << cache_path;
+      return Status::OK();
+    }
+    LOG(WARNING) << "Ignoring unreadable grappler cache entry " << cache_path
+                 << ": " << s;
+    optimized_graph->Clear();
+  }
+
+  TF_RETURN_IF_ERROR(OptimizeUncached(cluster, item, optimized_graph));
+
+  // Write to a unique temporary file and rename it, so that concurrent
+  // writers and readers of the same entry never observe a partial graph.
+  const string tmp_path = strings::StrCat(cache_path, ".tmp", random::New64());
+  Status s = env->RecursivelyCreateDir(cache_dir);
+  if (s.ok()) s = WriteBinaryProto(env, tmp_path, *optimized_graph);
+  if (s.ok()) s = env->RenameFile(tmp_path, cache_path);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to write grappler cache entry " << cache_path
+                 << ": " << s;
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return Status::OK();
+}
+
+Status MetaOptimizer::OptimizeUncached(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph) {
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.clear();
+  }
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -581,13 +751,23 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   absl::flat_hash_set<string> optimized_funcs;
   bool optimize_function_library =
       item.optimization_options().optimize_function_library;
+  const int graph_def_version = trimmed_item.graph.versions().producer();
+
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+  if (cfg_.function_optimization_parallelism() > 1) {
+    thread_pool = absl::make_unique<thread::ThreadPool>(
+        Env::Default(), "meta_optimizer_functions",
+        cfg_.function_optimization_parallelism());
+  }
 
   while (optimize_function_library) {
     optimize_function_library = false;
+    const bool is_tpu_graph = IsTPUGraphDef(*optimized_graph);
 
+    // Functions to optimize in this pass over the library, in library order.
+    std::vector<const FunctionDef*> funcs;
+    std::vector<bool> is_differentiable;
     for (const FunctionDef& func : optimized_graph->library().function()) {
-      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
-
       const string& func_name = func.signature().name();
 
       // Skip functions that are not reachable from the optimized graph.
@@ -602,95 +782,30 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       // the function optimizer, before we can optimize function body.
       if (IsParametrized(func)) continue;
 
-      VLOG(3) << "Optimize function: function=" << func_name;
-
       // Function optimization might specialize nested function calls, so we
       // have to reset the flag and do at least one more pass over the library.
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+      is_differentiable.push_back(differentiable_functions.contains(func_name));
+    }
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(MakeGrapplerFunctionItem(
-          func, flib, trimmed_item.graph.versions().producer(), &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
-      }
-
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // TODO(b/129545186): Shape inference in GraphProperties doesn't work well
-      // with _Arg nodes. Replace them with Placeholders with unknown shape.
-      absl::flat_hash_set<absl::string_view> input_nodes;
-      for (auto& input_arg : func_item.inputs()) {
-        input_nodes.insert(input_arg.node_name);
-      }
-      for (NodeDef& func_node : *func_item.graph.mutable_node()) {
-        if (input_nodes.contains(func_node.name())) {
-          func_node.set_op("Placeholder");
-          auto& attrs = *func_node.mutable_attr();
-          attrs["dtype"] = attrs["T"];
-          attrs.erase("index");
-          attrs.erase("T");
-          TensorShapeProto unknown_shape;
-          unknown_shape.set_unknown_rank(true);
-          *(attrs["shape"].mutable_shape()) = unknown_shape;
-        }
-      }
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only execption is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        TF_RETURN_IF_ERROR(
-            OptimizeGraph(cluster, func_item, &optimized_func_graph));
-      }
-
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
-        }
+    if (thread_pool != nullptr) {
+      TF_RETURN_IF_ERROR(OptimizeFunctionsInParallel(
+          cluster, funcs, is_differentiable, graph_def_version, is_tpu_graph,
+          thread_pool.get(), &flib));
+    } else {
+      for (int i = 0; i < funcs.size(); ++i) {
+        GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+        GrapplerFunctionItem func_item;
+        GraphDef optimized_func_graph;
+        TF_RETURN_IF_ERROR(OptimizeFunction(
+            cluster, *funcs[i], flib, graph_def_version, is_differentiable[i],
+            is_tpu_graph, &func_item, &optimized_func_graph));
+        TF_RETURN_IF_ERROR(ReplaceOptimizedFunction(
+            funcs[i]->signature().name(), std::move(optimized_func_graph),
+            &func_item, &flib));
       }
-
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
-
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
     }
 
     // If optimized at least one function, update the graph library.
@@ -711,7 +826,180 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   return Status::OK();
 }
 
+Status MetaOptimizer::OptimizeFunction(
+    Cluster* cluster, const FunctionDef& func,
+    const FunctionLibraryDefinition& flib, int graph_def_version,
+    bool is_differentiable, bool is_tpu_graph, GrapplerFunctionItem* func_item,
+    GraphDef* optimized_func_graph) {
+  const string& func_name = func.signature().name();
+  VLOG(3) << "Optimize function: function=" << func_name;
+
+  // Make a GrapplerItem from a FunctionDef.
+  TF_RETURN_IF_ERROR(
+      MakeGrapplerFunctionItem(func, flib, graph_def_version, func_item));
+
+  // If we need to compute the gradient of optimized function at runtime, we
+  // can't perform non-differentiable rewrites.
+  func_item->optimization_options().allow_non_differentiable_rewrites =
+      !is_differentiable;
+
+  // Device set available to the function is defined only by the runtime,
+  // when we instantiate and execute the function. We can't use all devices
+  // available to the main graph, because after partitioning the function
+  // call node might execute on a remote worker.
+  if (!func_item->devices().empty()) {
+    return errors::Internal("GrapplerFunctionItem devices must be empty.");
+  }
+
+  // We are not allowed to prune certain types of ops from the graph
+  // instantiated by the function definition, because we must guarantee
+  // function execution semantics wrt side effects (see
+  // function_optimizer.cc).
+  func_item->optimization_options().allow_pruning_stateful_and_dataset_ops =
+      false;
+
+  // TODO(b/129545186): Shape inference in GraphProperties doesn't work well
+  // with _Arg nodes. Replace them with Placeholders with unknown shape.
+  absl::flat_hash_set<absl::string_view> input_nodes;
+  for (auto& input_arg : func_item->inputs()) {
+    input_nodes.insert(input_arg.node_name);
+  }
+  for (NodeDef& func_node : *func_item->graph.mutable_node()) {
+    if (input_nodes.contains(func_node.name())) {
+      func_node.set_op("Placeholder");
+      auto& attrs = *func_node.mutable_attr();
+      attrs["dtype"] = attrs["T"];
+      attrs.erase("index");
+      attrs.erase("T");
+      TensorShapeProto unknown_shape;
+      unknown_shape.set_unknown_rank(true);
+      *(attrs["shape"].mutable_shape()) = unknown_shape;
+    }
+  }
+
+  // Optimize function body graph.
+  if (is_tpu_graph) {
+    // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+    // passes do not handle TPU functions correctly in a variety of ways
+    // (Note that due to the pre-placement TPU graph rewriting passes, the
+    // TPU-related ops are encapsulated away into functions). For example,
+    // TPU graphs contain TPUReplicateMetadata node that carries relevant
+    // TPU metadata and Grappler passes could prune that away. Grappler
+    // passes could also cause issues around shape inference. Since the
+    // desired and existing behavior is to not optimize TPU functions with
+    // Grappler, this check preserves that. The only execption is
+    // implementation selector what is required to swap in some TPU specific
+    // lowering code and is verified the work correctly on TPUs.
+    ImplementationSelector implementation_selector;
+    return implementation_selector.Optimize(cluster, *func_item,
+                                            optimized_func_graph);
+  }
+  return OptimizeGraph(cluster, *func_item, optimized_func_graph);
+}
+
+Status MetaOptimizer::ReplaceOptimizedFunction(
+    const string& func_name, GraphDef optimized_func_graph,
+    GrapplerFunctionItem* func_item, FunctionLibraryDefinition* flib) {
+  // Function body optimization might have created new specialized
+  // functions for each instantiation context. Add them to the library.
+  for (const FunctionDef& func_def :
+       optimized_func_graph.library().function()) {
+    if (flib->Find(func_def.signature().name()) == nullptr) {
+      TF_RETURN_IF_ERROR(flib->AddFunctionDef(func_def));
+    }
+  }
+
+  // Convert optimized graph back to FunctionDef.
+  FunctionDef optimized_func;
+  func_item->SwapFunctionBody(std::move(optimized_func_graph));
+  TF_RETURN_IF_ERROR(MakeFunctionDef(*func_item, *flib, &optimized_func));
+
+  // Replace optimized function with a new FunctionDef.
+  return flib->ReplaceFunction(func_name, optimized_func);
+}
+
+Status MetaOptimizer::OptimizeFunctionsInParallel(
+    Cluster* cluster, const std::vector<const FunctionDef*>& funcs,
+    const std::vector<bool>& is_differentiable, int graph_def_version,
+    bool is_tpu_graph, thread::ThreadPool* thread_pool,
+    FunctionLibraryDefinition* flib) {
+  const int num_funcs = funcs.size();
+
+  // A function must see the optimized version of every function it calls that
+  // precedes it in the library, exactly as in sequential optimization.
+  // Functions without such a dependency may be optimized concurrently.
+  std::vector<std::vector<int>> dependencies(num_funcs);
+  for (int i = 0; i < num_funcs; ++i) {
+    const FunctionLibraryDefinition reachable =
+        flib->ReachableDefinitions(*funcs[i]);
+    for (int j = 0; j < i; ++j) {
+      if (reachable.Contains(funcs[j]->signature().name())) {
+        dependencies[i].push_back(j);
+      }
+    }
+  }
+
+  // Optimizes at most one function per thread at a time, so that only that
+  // many function bodies are held in memory. The first unoptimized function
+  // has all its dependencies optimized, so every round makes progress.
+  const int max_in_flight = thread_pool->NumThreads();
+  std::vector<bool> optimized(num_funcs, false);
+  int num_optimized = 0;
+  while (num_optimized < num_funcs) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    std::vector<int> ready;
+    for (int i = 0; i < num_funcs && ready.size() < max_in_flight; ++i) {
+      if (optimized[i]) continue;
+      if (std::all_of(dependencies[i].begin(), dependencies[i].end(),
+                      [&optimized](int j) { return optimized[j]; })) {
+        ready.push_back(i);
+      }
+    }
+
+    std::vector<GrapplerFunctionItem> func_items(ready.size());
+    std::vector<GraphDef> optimized_func_graphs(ready.size());
+    std::vector<Status> statuses(ready.size());
+    BlockingCounter counter(ready.size());
+    for (int k = 0; k < ready.size(); ++k) {
+      thread_pool->Schedule([&, k]() {
+        // Cost estimators of a cluster are not thread-safe, so every function
+        // is optimized against its own virtual copy of the cluster.
+        std::unique_ptr<Cluster> func_cluster;
+        if (cluster != nullptr) {
+          if (cluster->GetDeviceSet() != nullptr) {
+            func_cluster =
+                absl::make_unique<VirtualCluster>(cluster->GetDeviceSet());
+          } else {
+            func_cluster =
+                absl::make_unique<VirtualCluster>(cluster->GetDevices());
+          }
+        }
+        const int i = ready[k];
+        statuses[k] = OptimizeFunction(
+            func_cluster.get(), *funcs[i], *flib, graph_def_version,
+            is_differentiable[i], is_tpu_graph, &func_items[k],
+            &optimized_func_graphs[k]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+
+    // Update the library in library order, as sequential optimization would.
+    for (int k = 0; k < ready.size(); ++k) {
+      TF_RETURN_IF_ERROR(statuses[k]);
+      const int i = ready[k];
+      TF_RETURN_IF_ERROR(ReplaceOptimizedFunction(
+          funcs[i]->signature().name(), std::move(optimized_func_graphs[k]),
+          &func_items[k], flib));
+      optimized[i] = true;
+      ++num_optimized;
+    }
+  }
+  return Status::OK();
+}
+
 void MetaOptimizer::PrintResult() {
+  mutex_lock l(optimization_results_mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     LOG(INFO) << "Optimization results for grappler item: " << graph_result.id;
     for (const OptimizerResult& result : graph_result.results) {
@@ -745,6 +1033,7 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
+         AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_cpu()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
 }
@@ -20,10 +20,15 @@ limitations under the License.
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/grappler/costs/op_cost_database.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/verifier_config.pb.h"
@@ -71,14 +76,47 @@ class MetaOptimizer : public GraphOptimizer {
       std::vector<std::unique_ptr<GraphVerifier>>* post_optimization_verifiers)
       const;
 
+  // Optimizes the main graph and the function library of `item`, bypassing
+  // the cache configured by `meta_optimizer_cache_dir`.
+  Status OptimizeUncached(Cluster* cluster, const GrapplerItem& item,
+                          GraphDef* optimized_graph);
+
   // Run optimization pass over a single GrapplerItem. Meta optimizer might run
   // multiple such passes: 1) for the main graph 2) for the function library
   Status OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
                        GraphDef* optimized_graph);
 
+  // Optimizes the body of `func`, looking up the functions it calls in `flib`.
+  // Stores the function item in `func_item` and its optimized body in
+  // `optimized_func_graph`. Does not modify `flib`, so that several functions
+  // can be optimized concurrently.
+  Status OptimizeFunction(Cluster* cluster, const FunctionDef& func,
+                          const FunctionLibraryDefinition& flib,
+                          int graph_def_version, bool is_differentiable,
+                          bool is_tpu_graph, GrapplerFunctionItem* func_item,
+                          GraphDef* optimized_func_graph);
+
+  // Replaces `func_name` in `flib` with the optimized body of `func_item`, and
+  // adds the functions specialized while optimizing it.
+  Status ReplaceOptimizedFunction(const string& func_name,
+                                  GraphDef optimized_func_graph,
+                                  GrapplerFunctionItem* func_item,
+                                  FunctionLibraryDefinition* flib);
+
+  // Optimizes `funcs` on `thread_pool` and replaces them in `flib`. Functions
+  // are optimized concurrently unless one calls another that precedes it in
+  // `funcs`, and at most one function per thread is in flight at a time.
+  Status OptimizeFunctionsInParallel(
+      Cluster* cluster, const std::vector<const FunctionDef*>& funcs,
+      const std::vector<bool>& is_differentiable, int graph_def_version,
+      bool is_tpu_graph, thread::ThreadPool* thread_pool,
+      FunctionLibraryDefinition* flib);
+
   DeviceBase* const cpu_device_;  // may be NULL
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
+  // Loaded from RewriterConfig::op_cost_database, null if not configured.
+  std::shared_ptr<const OpCostDatabase> op_cost_database_;
 
   struct OptimizerResult {
     string optimizer_name;
@@ -96,7 +134,9 @@ class MetaOptimizer : public GraphOptimizer {
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
-  std::vector<GraphOptimizationResult> optimization_results_;
+  mutex optimization_results_mu_;
+  std::vector<GraphOptimizationResult> optimization_results_
+      GUARDED_BY(optimization_results_mu_);
 };
 
 bool MetaOptimizerEnabled(const ConfigProto& cfg);
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -77,6 +78,29 @@ class TestGraphOptimizer : public TestOptimizer {
 
 REGISTER_GRAPH_OPTIMIZER(TestGraphOptimizer);
 
+// Counts its invocations and leaves the graph unchanged.
+class CountingOptimizer : public TestOptimizer {
+ public:
+  static void ResetCount() { count_ = 0; }
+  static int Count() { return count_; }
+
+  string name() const override { return "counting_optimizer"; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override {
+    ++count_;
+    *optimized_graph = item.graph;
+    return Status::OK();
+  }
+
+ private:
+  static int count_;
+};
+
+int CountingOptimizer::count_;
+
+REGISTER_GRAPH_OPTIMIZER(CountingOptimizer);
+
 class TestOptimizerWithParams : public TestOptimizer {
  public:
   Status Init(
@@ -151,6 +175,45 @@ TEST_F(MetaOptimizerTest, RunsCustomOptimizer) {
   EXPECT_TRUE(TestOptimizer::IsOptimized());
 }
 
+TEST_F(MetaOptimizerTest, ReusesCachedOptimizedGraph) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "meta_optimizer_cache");
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  rewriter_config.set_meta_optimizer_cache_dir(cache_dir);
+
+  TestOptimizer::SetOptimized(false);
+  GraphDef output;
+  TF_EXPECT_OK(MetaOptimizer(nullptr, config_proto)
+                   .Optimize(nullptr, item, &output));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  // The same graph and config hit the cache and skip the optimizers.
+  TestOptimizer::SetOptimized(false);
+  GraphDef cached_output;
+  TF_EXPECT_OK(MetaOptimizer(nullptr, config_proto)
+                   .Optimize(nullptr, item, &cached_output));
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  CompareGraphs(output, cached_output);
+
+  // A different config misses the cache.
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::ONE);
+  TF_EXPECT_OK(MetaOptimizer(nullptr, config_proto)
+                   .Optimize(nullptr, item, &cached_output));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+}
+
 TEST_F(MetaOptimizerTest, RunsCustomOptimizerWithParams) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
   GrapplerItem item;
@@ -212,6 +275,25 @@ TEST_F(MetaOptimizerTest, RunOptimizersTwice) {
   TF_EXPECT_OK(status);
 }
 
+TEST_F(MetaOptimizerTest, SkipsPassesThatLeftTheGraphUnchanged) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("CountingOptimizer");
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.set_min_graph_nodes(-1);
+
+  CountingOptimizer::ResetCount();
+  MetaOptimizer optimizer(nullptr, config_proto);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(CountingOptimizer::Count(), 1);
+}
+
 TEST_F(MetaOptimizerTest, RunToggleOptimizersAndCustomGraphOptimizerTwice) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
   GrapplerItem item;
@@ -397,6 +479,72 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibrary) {
   test::ExpectTensorEqual<int>(tensors_expected[1], tensors[1]);
 }
 
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryInParallel) {
+  using test::function::NDef;
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.set_function_optimization(RewriterConfig::ON);
+  rewriter_config.add_optimizers("function");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  // MyQuadratic calls MySquare, which precedes it in the library; XTimesTwo
+  // and MySquare are independent.
+  FunctionDef square_func = FunctionDefHelper::Create(
+      "MySquare", {"x:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"mul"}, "Mul", {"x", "x"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "mul:z:0"}});
+  (*square_func.mutable_attr())["_noinline"].set_b(true);
+
+  FunctionDef quadratic_func = FunctionDefHelper::Create(
+      "MyQuadratic", {"x:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"square"}, "MySquare", {"x"}, {{"T", "$T"}}},
+       {{"quadratic"}, "MySquare", {"square:z"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "quadratic:z:0"}});
+  (*quadratic_func.mutable_attr())["_noinline"].set_b(true);
+
+  FunctionDef x_times_two = test::function::XTimesTwo();
+  (*x_times_two.mutable_attr())["_noinline"].set_b(true);
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("square", "MySquare", {"a"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("quadratic", "MyQuadratic", {"a"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("x2", "XTimesTwo", {"a"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("out_s", "Identity", {"square:0"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("out_q", "Identity", {"quadratic:0"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("out_x", "Identity", {"x2:0"}, {{"T", DT_FLOAT}}, kDevice)},
+      /*funcs=*/
+      {square_func, quadratic_func, x_times_two});
+
+  GraphDef sequential_output;
+  TF_EXPECT_OK(MetaOptimizer(nullptr, config_proto)
+                   .Optimize(nullptr, item, &sequential_output));
+
+  rewriter_config.set_function_optimization_parallelism(4);
+  GraphDef parallel_output;
+  TF_EXPECT_OK(MetaOptimizer(nullptr, config_proto)
+                   .Optimize(nullptr, item, &parallel_output));
+
+  CompareGraphs(sequential_output, parallel_output);
+  FunctionLibraryDefinition parallel_flib(OpRegistry::Global(),
+                                          parallel_output.library());
+  ASSERT_EQ(sequential_output.library().function_size(),
+            parallel_flib.num_functions());
+  for (const FunctionDef& func : sequential_output.library().function()) {
+    const FunctionDef* parallel_func =
+        parallel_flib.Find(func.signature().name());
+    ASSERT_NE(parallel_func, nullptr);
+    CompareFunctions(func, *parallel_func);
+  }
+}
+
 TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryPruneUnusedOutputs) {
   using test::function::NDef;
 
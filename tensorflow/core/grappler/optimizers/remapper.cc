@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include <algorithm>
+
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
@@ -27,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -51,6 +56,19 @@ namespace grappler {
 //   (1) FusedBatchNorm + <Activation>
 //   (2) FusedBatchNorm + SideInput + <Activation>
 //
+// Mean + Sub + Square + Mean + Add + Rsqrt + Mul + Mul + Add -> _FusedLayerNorm
+//   (1) Layer normalization over the innermost dimension
+//
+// BatchMatMul + Mul + Softmax + BatchMatMul -> _FusedScaledDotProductAttention
+//   (1) softmax(Q * K^T * scale) * V
+//
+// Unique + GatherV2 + SparseSegment{Sum,Mean,SqrtN} -> SparseSegment{...}
+//   (1) Sparse embedding lookup reading the rows of the embedding directly
+//
+// {Sum,Mean,Max,Min} + ... + {Sum,Mean,Max,Min} -> _FusedReduce
+//   (1) Several reductions of the same input over the same axes, e.g. the
+//       Mean(x) and Mean(Square(x)) of a normalization
+//
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
 // patterns are "ContractionWith...".
 namespace {
@@ -58,6 +76,10 @@ namespace {
 constexpr char kFusedConv2D[] = "_FusedConv2D";
 constexpr char kFusedMatMul[] = "_FusedMatMul";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
+constexpr char kFusedLayerNorm[] = "_FusedLayerNorm";
+constexpr char kFusedScaledDotProductAttention[] =
+    "_FusedScaledDotProductAttention";
+constexpr char kFusedReduce[] = "_FusedReduce";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -106,6 +128,78 @@ struct FusedBatchNormEx {
   int invalidated = kMissingIndex;
 };
 
+// Layer normalization over the innermost dimension of `x`, spelled out with
+// primitive ops:
+//   mean = Mean(x, axis=-1, keep_dims=True)
+//   centered = Sub(x, mean)
+//   variance = Mean(Square(centered), axis=-1, keep_dims=True)
+//   normalized = Mul(centered, Rsqrt(Add(variance, epsilon)))
+//   y = Add(Mul(normalized, scale), offset)
+struct LayerNorm {
+  LayerNorm() = default;
+
+  string x;
+  string scale;
+  string offset;
+  float epsilon = 0.0;
+  // The final Add, which is replaced by the fused node.
+  int add_offset = kMissingIndex;
+  // All the other nodes of the pattern.
+  std::vector<int> fused_nodes;
+};
+
+// Scaled dot-product attention:
+//   scores = BatchMatMul(query, key, adj_y=True)
+//   weights = Softmax(Mul(scores, scale))  // or RealDiv(scores, 1 / scale)
+//   output = BatchMatMul(weights, value)
+struct ScaledDotProductAttention {
+  ScaledDotProductAttention() = default;
+
+  string query;
+  string key;
+  string value;
+  float scale = 1.0;
+  // The final BatchMatMul, which is replaced by the fused node.
+  int output = kMissingIndex;
+  // All the other nodes of the pattern.
+  std::vector<int> fused_nodes;
+};
+
+// Sparse segment reduction of the rows gathered at the unique ids:
+//   unique_ids, idx = Unique(ids)
+//   rows = GatherV2(params, unique_ids, axis=0)  // optionally with an Identity
+//   output = SparseSegment{Sum,Mean,SqrtN}(rows, idx, segment_ids)
+// This is what embedding_lookup_sparse() builds for unweighted lookups. The
+// reduction can read the rows of `params` at `ids` directly, without
+// materializing the gathered rows.
+struct SparseSegmentReductionOfGather {
+  SparseSegmentReductionOfGather() = default;
+
+  string params;
+  string ids;
+  DataType ids_dtype = DT_INVALID;
+  // The sparse segment reduction, which is rewritten in place.
+  int reduction = kMissingIndex;
+  // Nodes of the pattern that are left without consumers.
+  std::vector<int> fused_nodes;
+};
+
+// Reductions of the same input over the same axes:
+//   y_i = {Sum,Mean,Max,Min}(x, axes)  // or {Sum,Mean}(Square(x), axes)
+// A single _FusedReduce computes them all in one pass over `x`.
+struct MultipleReductions {
+  MultipleReductions() = default;
+
+  string input;
+  string fused_name;
+  // The reductions, which are replaced by Identities of the fused outputs,
+  // with what each of them computes of `input`.
+  std::vector<int> reductions;
+  std::vector<string> kinds;
+  // The Square nodes read by the reductions.
+  std::vector<int> fused_nodes;
+};
+
 // Contraction node followed by a BiasAdd.
 struct ContractionWithBiasAdd {
   ContractionWithBiasAdd() = default;
@@ -341,11 +435,20 @@ bool IsSupportedActivation(const NodeDef& node) {
   return IsRelu(node) || IsRelu6(node) || IsElu(node);
 }
 
+// Patterns that do not forward control dependencies to the fused node reject
+// nodes that have any.
 inline bool HasControlFaninOrFanout(const utils::MutableNodeView& node_view) {
   return node_view.NumControllingFanins() > 0 ||
          node_view.NumControlledFanouts() > 0;
 }
 
+// Nodes that are removed by a fusion must not have control fanouts, because
+// they would be left without the node they depend on. Their control fanins are
+// forwarded to the fused node instead.
+inline bool HasControlFanout(const utils::MutableNodeView& node_view) {
+  return node_view.NumControlledFanouts() > 0;
+}
+
 inline bool HasAtMostOneFanoutAtPort0(const utils::MutableNodeView& node_view) {
   return node_view.GetRegularFanout(0).size() <= 1;
 }
@@ -357,7 +460,6 @@ bool FindContractionWithBias(const RemapperContext& ctx, int node_index,
 
   const auto* node_view = ctx.graph_view.GetNode(node_index);
   // Root of the pattern must be a BiasAdd.
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (HasControlFaninOrFanout(*node_view)) return false;
 
   const auto* node_def = node_view->node();
@@ -398,7 +500,6 @@ bool FindContractionWithBiasAndActivation(
 
   const auto* node_view = ctx.graph_view.GetNode(node_index);
   // Root of the pattern must be an activation node.
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (HasControlFaninOrFanout(*node_view)) return false;
 
   const auto* node_def = node_view->node();
@@ -433,9 +534,9 @@ bool FindConv2DWithSqueezeAndBias(const RemapperContext& ctx, int node_index,
                                   ContractionWithSqueezeAndBiasAdd* matched) {
   if (!EigenSupportsContractionOutputKernel()) return false;
 
+  // The control inputs of the root are forwarded to the fused node, and its
+  // control fanouts are kept by the Squeeze that takes over its name.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
-  if (HasControlFaninOrFanout(*node_view)) return false;
 
   // Root of the pattern must be a BiasAdd.
   const auto* node_def = node_view->node();
@@ -449,7 +550,7 @@ bool FindConv2DWithSqueezeAndBias(const RemapperContext& ctx, int node_index,
 
   if (!IsSqueeze(*squeeze_node_def) ||
       !HaveSameDataType(node_def, squeeze_node_def, "T") ||
-      HasControlFaninOrFanout(*squeeze_node_view) ||
+      HasControlFanout(*squeeze_node_view) ||
       !HasAtMostOneFanoutAtPort0(*squeeze_node_view) ||
       IsInPreserveSet(ctx, squeeze_node_def))
     return false;
@@ -469,7 +570,7 @@ bool FindConv2DWithSqueezeAndBias(const RemapperContext& ctx, int node_index,
 
   if (!IsConv2D(*conv2d_node_def) ||
       !HaveSameDataType(node_def, conv2d_node_def, "T") ||
-      HasControlFaninOrFanout(*conv2d_node_view) ||
+      HasControlFanout(*conv2d_node_view) ||
       !HasAtMostOneFanoutAtPort0(*conv2d_node_view) ||
       IsInPreserveSet(ctx, conv2d_node_def))
     return false;
@@ -504,10 +605,9 @@ bool FindConv2DWithBatchNorm(const RemapperContext& ctx, int node_index,
   const auto* training_attr = node_view->GetAttr(kIsTraining);
   if (training_attr != nullptr && training_attr->b()) return false;
 
-  // Check that only 0th output is consumed by other nodes.
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
-  if (HasControlFaninOrFanout(*node_view) ||
-      !node_view->GetRegularFanout(1).empty() ||  // batch_mean
+  // Check that only 0th output is consumed by other nodes. The fused node
+  // takes over the name and the controls of the root.
+  if (!node_view->GetRegularFanout(1).empty() ||  // batch_mean
       !node_view->GetRegularFanout(2).empty() ||  // batch_variance
       !node_view->GetRegularFanout(3).empty() ||  // reserve_space_1
       !node_view->GetRegularFanout(4).empty())    // reserve_space_2
@@ -523,7 +623,7 @@ bool FindConv2DWithBatchNorm(const RemapperContext& ctx, int node_index,
       !HaveSameDataType(node_def, conv2d_node_def) ||
       !IsCpuCompatibleDataType(conv2d_node_def) ||
       !IsCpuCompatibleDataFormat(conv2d_node_def) ||
-      HasControlFaninOrFanout(*conv2d_node_view) ||
+      HasControlFanout(*conv2d_node_view) ||
       !HasAtMostOneFanoutAtPort0(*conv2d_node_view) ||
       IsInPreserveSet(ctx, conv2d_node_def))
     return false;
@@ -542,7 +642,6 @@ bool FindConv2DWithBatchNormAndActivation(
   if (!EigenSupportsContractionOutputKernel()) return false;
 
   const auto* node_view = ctx.graph_view.GetNode(node_index);
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (HasControlFaninOrFanout(*node_view)) return false;
 
   // Root of the pattern must be an activation node.
@@ -562,6 +661,7 @@ bool FindConv2DWithBatchNormAndActivation(
       ctx.graph_view.GetNode(base.fused_batch_norm);
   const auto* fused_batch_norm_node_def = fused_batch_norm_node_view->node();
   if (!HasAtMostOneFanoutAtPort0(*fused_batch_norm_node_view) ||
+      HasControlFanout(*fused_batch_norm_node_view) ||
       !HaveSameDataType(node_def, fused_batch_norm_node_def) ||
       IsInPreserveSet(ctx, fused_batch_norm_node_def))
     return false;
@@ -602,7 +702,6 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
                                       const utils::MutableNodeView& node_view,
                                       ContractionWithBiasAddAndAdd* matched) {
   // Fusion with AddN is supported only when it has two inputs.
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (HasControlFaninOrFanout(node_view) || node_view.NumRegularFanins() != 2)
     return false;
 
@@ -645,7 +744,6 @@ bool FindContractionWithBiasAndAddActivation(
     const RemapperContext& ctx, int node_index,
     ContractionWithBiasAndAddActivation* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (HasControlFaninOrFanout(*node_view)) return false;
 
   // Root of the pattern must be an activation node.
@@ -740,7 +838,6 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
   // TODO(ezhulenev): Forward control dependencies.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
   const auto* node_def = node_view->node();
-  // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (!IsRelu(*node_def) || HasControlFaninOrFanout(*node_view)) return false;
 
   // Returns true iff the node is a compatible FusedBatchNorm node.
@@ -856,6 +953,435 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
   return false;
 }
 
+// _FusedLayerNorm and _FusedScaledDotProductAttention are implemented for
+// float on CPU, and for float and half on GPU.
+bool IsTransformerFusionCompatible(const NodeDef& node) {
+  const DataType dtype = GetDataTypeFromAttr(node, "T");
+  if (NodeIsOnCpu(&node)) return dtype == DT_FLOAT;
+  if (NodeIsOnGpu(&node)) return dtype == DT_FLOAT || dtype == DT_HALF;
+  return false;
+}
+
+// Returns true if `node` is a Const holding a single floating point value.
+bool GetScalarConstValue(const NodeDef& node, float* value) {
+  if (!IsConstant(node) || node.attr().count("value") == 0) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.NumElements() != 1)
+    return false;
+  switch (tensor.dtype()) {
+    case DT_FLOAT:
+      *value = tensor.flat<float>()(0);
+      return true;
+    case DT_HALF:
+      *value = static_cast<float>(tensor.flat<Eigen::half>()(0));
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if `node_view` is a Mean over the innermost dimension of its
+// input that keeps the reduced dimension.
+bool IsInnermostMean(const RemapperContext& ctx,
+                     const utils::MutableNodeView& node_view) {
+  const auto* node_def = node_view.node();
+  if (!IsMean(*node_def) || node_view.NumRegularFanins() != 2) return false;
+
+  bool keep_dims = false;
+  if (!GetNodeAttr(*node_def, "keep_dims", &keep_dims).ok() || !keep_dims)
+    return false;
+
+  const auto* axes = node_view.GetRegularFanin(1).node_view()->node();
+  if (!IsConstant(*axes) || axes->attr().count("value") == 0) return false;
+  Tensor axes_tensor;
+  if (!axes_tensor.FromProto(axes->attr().at("value").tensor()) ||
+      axes_tensor.NumElements() != 1)
+    return false;
+  int64 axis;
+  if (axes_tensor.dtype() == DT_INT32) {
+    axis = axes_tensor.flat<int32>()(0);
+  } else if (axes_tensor.dtype() == DT_INT64) {
+    axis = axes_tensor.flat<int64>()(0);
+  } else {
+    return false;
+  }
+  if (axis == -1) return true;
+
+  const auto& props = ctx.graph_properties.GetInputProperties(node_def->name());
+  return !props.empty() && !props[0].shape().unknown_rank() &&
+         axis == props[0].shape().dim_size() - 1;
+}
+
+// Returns true if the node can be fused away: it has no control dependencies,
+// it is not in the preserve set, and all its outputs are consumed within the
+// pattern (by `num_fanouts` consumers).
+bool IsFusableIntermediate(const RemapperContext& ctx,
+                           const utils::MutableNodeView& node_view,
+                           int num_fanouts = 1) {
+  return !HasControlFaninOrFanout(node_view) &&
+         node_view.NumRegularFanouts() == num_fanouts &&
+         !IsInPreserveSet(ctx, node_view.node());
+}
+
+// Matches the `Mul(centered, Rsqrt(Add(variance, epsilon)))` part of a layer
+// normalization, with `centered` at input `centered_port` of `normalized`.
+bool FindLayerNormNormalization(const RemapperContext& ctx,
+                                const utils::MutableNodeView& normalized,
+                                int centered_port, LayerNorm* matched) {
+  const auto& centered_fanin = normalized.GetRegularFanin(centered_port);
+  const auto* centered = centered_fanin.node_view();
+  const auto* rsqrt = normalized.GetRegularFanin(1 - centered_port).node_view();
+
+  // Centered input feeds both the variance computation and the normalization.
+  if (!IsSub(*centered->node()) || centered_fanin.index() != 0 ||
+      !IsFusableIntermediate(ctx, *centered, /*num_fanouts=*/2))
+    return false;
+  if (!IsRsqrt(*rsqrt->node()) || !IsFusableIntermediate(ctx, *rsqrt))
+    return false;
+
+  const auto* add_epsilon = rsqrt->GetRegularFanin(0).node_view();
+  if (!IsAdd(*add_epsilon->node()) ||
+      !IsFusableIntermediate(ctx, *add_epsilon) ||
+      add_epsilon->NumRegularFanins() != 2)
+    return false;
+
+  for (int i = 0; i < 2; ++i) {
+    const auto* variance = add_epsilon->GetRegularFanin(i).node_view();
+    const auto* epsilon = add_epsilon->GetRegularFanin(1 - i).node_view();
+    float epsilon_value;
+    if (!IsInnermostMean(ctx, *variance) ||
+        !IsFusableIntermediate(ctx, *variance) ||
+        !GetScalarConstValue(*epsilon->node(), &epsilon_value))
+      continue;
+
+    const auto& square_fanin = variance->GetRegularFanin(0);
+    const auto* square = square_fanin.node_view();
+    if (!IsSquare(*square->node()) || !IsFusableIntermediate(ctx, *square))
+      return false;
+    const auto& square_input = square->GetRegularFanin(0);
+    if (square_input.node_index() != centered->node_index() ||
+        square_input.index() != 0)
+      return false;
+
+    // centered = x - Mean(x)
+    const auto& x = centered->GetRegularFanin(0);
+    const auto* mean = centered->GetRegularFanin(1).node_view();
+    if (!IsInnermostMean(ctx, *mean) || !IsFusableIntermediate(ctx, *mean))
+      return false;
+    const auto& mean_input = mean->GetRegularFanin(0);
+    if (mean_input.node_index() != x.node_index() ||
+        mean_input.index() != x.index())
+      return false;
+
+    matched->x = centered->node()->input(0);
+    matched->epsilon = epsilon_value;
+    matched->fused_nodes = {mean->node_index(),        centered->node_index(),
+                            square->node_index(),      variance->node_index(),
+                            add_epsilon->node_index(), rsqrt->node_index(),
+                            normalized.node_index()};
+    return true;
+  }
+  return false;
+}
+
+bool FindLayerNorm(const RemapperContext& ctx, int node_index,
+                   LayerNorm* matched) {
+  // Root of the pattern must be an Add of the offset.
+  const auto* add_offset = ctx.graph_view.GetNode(node_index);
+  const auto* add_offset_def = add_offset->node();
+  if (!IsAdd(*add_offset_def) || HasControlFaninOrFanout(*add_offset) ||
+      add_offset->NumRegularFanins() != 2 ||
+      !IsTransformerFusionCompatible(*add_offset_def))
+    return false;
+
+  // Scale and offset must be vectors matching the normalized dimension.
+  const auto is_parameter_vector = [&](const NodeDef& node, int port,
+                                       const TensorShapeProto& x_shape) {
+    const auto& props = ctx.graph_properties.GetInputProperties(node.name());
+    if (props.size() <= static_cast<size_t>(port)) return false;
+    const TensorShapeProto& shape = props[port].shape();
+    if (x_shape.unknown_rank() || x_shape.dim_size() < 1) return false;
+    const auto& depth = x_shape.dim(x_shape.dim_size() - 1);
+    return Rank(shape) == 1 && IsKnown(depth) &&
+           shape.dim(0).size() == depth.size();
+  };
+
+  for (int i = 0; i < 2; ++i) {
+    const auto* mul_scale = add_offset->GetRegularFanin(i).node_view();
+    if (!IsMul(*mul_scale->node()) || !IsFusableIntermediate(ctx, *mul_scale) ||
+        mul_scale->NumRegularFanins() != 2)
+      continue;
+
+    for (int j = 0; j < 2; ++j) {
+      const auto* normalized = mul_scale->GetRegularFanin(j).node_view();
+      if (!IsMul(*normalized->node()) ||
+          !IsFusableIntermediate(ctx, *normalized) ||
+          normalized->NumRegularFanins() != 2)
+        continue;
+
+      LayerNorm layer_norm;
+      if (!FindLayerNormNormalization(ctx, *normalized, 0, &layer_norm) &&
+          !FindLayerNormNormalization(ctx, *normalized, 1, &layer_norm))
+        continue;
+
+      // Input of the first Mean in the pattern is `x`.
+      const auto& x_props = ctx.graph_properties.GetInputProperties(
+          ctx.graph_view.GetNode(layer_norm.fused_nodes[0])->GetName());
+      if (x_props.empty()) continue;
+      const TensorShapeProto& x_shape = x_props[0].shape();
+      if (!is_parameter_vector(*mul_scale->node(), 1 - j, x_shape) ||
+          !is_parameter_vector(*add_offset_def, 1 - i, x_shape))
+        continue;
+
+      layer_norm.scale = mul_scale->node()->input(1 - j);
+      layer_norm.offset = add_offset_def->input(1 - i);
+      layer_norm.add_offset = node_index;
+      layer_norm.fused_nodes.push_back(mul_scale->node_index());
+      *matched = std::move(layer_norm);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if the node is a BatchMatMul with the given adjoint flags.
+bool IsBatchMatMulWithAdjoints(const NodeDef& node, bool adj_x, bool adj_y) {
+  if (node.op() != "BatchMatMul" && node.op() != "BatchMatMulV2") return false;
+  bool node_adj_x = false;
+  bool node_adj_y = false;
+  return GetNodeAttr(node, "adj_x", &node_adj_x).ok() &&
+         GetNodeAttr(node, "adj_y", &node_adj_y).ok() &&
+         node_adj_x == adj_x && node_adj_y == adj_y;
+}
+
+bool FindScaledDotProductAttention(const RemapperContext& ctx, int node_index,
+                                   ScaledDotProductAttention* matched) {
+  // Root of the pattern must be a BatchMatMul of the weights and the values.
+  const auto* output = ctx.graph_view.GetNode(node_index);
+  const auto* output_def = output->node();
+  if (!IsBatchMatMulWithAdjoints(*output_def, false, false) ||
+      HasControlFaninOrFanout(*output) || output->NumRegularFanins() != 2 ||
+      !IsTransformerFusionCompatible(*output_def))
+    return false;
+
+  const auto* softmax = output->GetRegularFanin(0).node_view();
+  if (!IsSoftmax(*softmax->node()) || !IsFusableIntermediate(ctx, *softmax))
+    return false;
+
+  // Scaling can be either a multiplication or a division by a constant.
+  const auto* scaled = softmax->GetRegularFanin(0).node_view();
+  if (!IsFusableIntermediate(ctx, *scaled) || scaled->NumRegularFanins() != 2)
+    return false;
+  const utils::MutableNodeView* scores = nullptr;
+  float scale;
+  if (IsMul(*scaled->node())) {
+    for (int i = 0; i < 2 && scores == nullptr; ++i) {
+      const auto* factor = scaled->GetRegularFanin(1 - i).node_view();
+      if (GetScalarConstValue(*factor->node(), &scale)) {
+        scores = scaled->GetRegularFanin(i).node_view();
+      }
+    }
+  } else if (IsRealDiv(*scaled->node())) {
+    float divisor;
+    if (GetScalarConstValue(*scaled->GetRegularFanin(1).node_view()->node(),
+                            &divisor) &&
+        divisor != 0.0f) {
+      scale = 1.0f / divisor;
+      scores = scaled->GetRegularFanin(0).node_view();
+    }
+  }
+  if (scores == nullptr ||
+      !IsBatchMatMulWithAdjoints(*scores->node(), false, true) ||
+      !IsFusableIntermediate(ctx, *scores) || scores->NumRegularFanins() != 2)
+    return false;
+
+  // The fused kernel doesn't broadcast batch dimensions, so query, key and
+  // value must all have the same rank and batch dimensions.
+  const auto& scores_props =
+      ctx.graph_properties.GetInputProperties(scores->GetName());
+  const auto& output_props =
+      ctx.graph_properties.GetInputProperties(output_def->name());
+  if (scores_props.size() != 2 || output_props.size() != 2) return false;
+  const TensorShapeProto& query_shape = scores_props[0].shape();
+  const TensorShapeProto& key_shape = scores_props[1].shape();
+  const TensorShapeProto& value_shape = output_props[1].shape();
+  const int rank = Rank(query_shape);
+  if (rank < 3 || Rank(key_shape) != rank || Rank(value_shape) != rank)
+    return false;
+  for (int i = 0; i < rank - 2; ++i) {
+    const auto& dim = query_shape.dim(i);
+    if (!IsKnown(dim) || key_shape.dim(i).size() != dim.size() ||
+        value_shape.dim(i).size() != dim.size())
+      return false;
+  }
+
+  matched->query = scores->node()->input(0);
+  matched->key = scores->node()->input(1);
+  matched->value = output_def->input(1);
+  matched->scale = scale;
+  matched->output = node_index;
+  matched->fused_nodes = {scores->node_index(), scaled->node_index(),
+                          softmax->node_index()};
+  return true;
+}
+
+bool IsSparseSegmentReduction(const NodeDef& node) {
+  const string& op = node.op();
+  return op == "SparseSegmentSum" || op == "SparseSegmentMean" ||
+         op == "SparseSegmentSqrtN" ||
+         op == "SparseSegmentSumWithNumSegments" ||
+         op == "SparseSegmentMeanWithNumSegments" ||
+         op == "SparseSegmentSqrtNWithNumSegments";
+}
+
+// Returns true if `node` gathers whole rows of its params: a Gather, or a
+// GatherV2 along the axis 0 without batch dimensions.
+bool IsRowGather(const utils::MutableNodeView& node_view) {
+  const auto* node_def = node_view.node();
+  if (node_def->op() == "Gather") return node_view.NumRegularFanins() == 2;
+  if (node_def->op() != "GatherV2" || node_view.NumRegularFanins() != 3)
+    return false;
+
+  int batch_dims = 0;
+  if (GetNodeAttr(*node_def, "batch_dims", &batch_dims).ok() &&
+      batch_dims != 0)
+    return false;
+
+  const auto* axis = node_view.GetRegularFanin(2).node_view()->node();
+  if (!IsConstant(*axis) || axis->attr().count("value") == 0) return false;
+  Tensor axis_tensor;
+  if (!axis_tensor.FromProto(axis->attr().at("value").tensor()) ||
+      axis_tensor.NumElements() != 1)
+    return false;
+  if (axis_tensor.dtype() == DT_INT32) return axis_tensor.flat<int32>()(0) == 0;
+  if (axis_tensor.dtype() == DT_INT64) return axis_tensor.flat<int64>()(0) == 0;
+  return false;
+}
+
+bool FindSparseSegmentReductionOfGather(
+    const RemapperContext& ctx, int node_index,
+    SparseSegmentReductionOfGather* matched) {
+  // Root of the pattern must be a sparse segment reduction on CPU, the only
+  // device with sparse segment reduction kernels.
+  const auto* reduction = ctx.graph_view.GetNode(node_index);
+  const auto* reduction_def = reduction->node();
+  if (!IsSparseSegmentReduction(*reduction_def) ||
+      !NodeIsOnCpu(reduction_def) || reduction->NumRegularFanins() < 3)
+    return false;
+
+  const auto* rows = reduction->GetRegularFanin(0).node_view();
+  std::vector<int> fused_nodes;
+  if (IsIdentity(*rows->node())) {
+    if (!IsFusableIntermediate(ctx, *rows)) return false;
+    fused_nodes.push_back(rows->node_index());
+    rows = rows->GetRegularFanin(0).node_view();
+  }
+  if (!IsRowGather(*rows) || !IsFusableIntermediate(ctx, *rows)) return false;
+  fused_nodes.push_back(rows->node_index());
+
+  // The gathered rows and the reduction indices must both come from the same
+  // Unique: unique_ids[idx[i]] == ids[i].
+  const auto& unique_ids = rows->GetRegularFanin(1);
+  const auto& idx = reduction->GetRegularFanin(1);
+  const auto* unique = unique_ids.node_view();
+  if (unique->node()->op() != "Unique" || unique_ids.index() != 0 ||
+      idx.node_view() != unique || idx.index() != 1)
+    return false;
+  const DataType ids_dtype = GetDataTypeFromAttr(*unique->node(), "T");
+  if (ids_dtype != DT_INT32 && ids_dtype != DT_INT64) return false;
+  if (IsFusableIntermediate(ctx, *unique, /*num_fanouts=*/2)) {
+    fused_nodes.push_back(unique->node_index());
+  }
+
+  matched->params = rows->node()->input(0);
+  matched->ids = unique->node()->input(0);
+  matched->ids_dtype = ids_dtype;
+  matched->reduction = node_index;
+  matched->fused_nodes = std::move(fused_nodes);
+  return true;
+}
+
+bool IsFusableReduction(const utils::MutableNodeView& node_view) {
+  const auto* node_def = node_view.node();
+  if (!IsSum(*node_def) && !IsMean(*node_def) && !IsMax(*node_def) &&
+      !IsMin(*node_def))
+    return false;
+  const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+  return NodeIsOnCpu(node_def) && (dtype == DT_FLOAT || dtype == DT_DOUBLE) &&
+         node_view.NumRegularFanins() == 2 &&
+         node_view.NumControllingFanins() == 0;
+}
+
+bool GetKeepDims(const NodeDef& reduction) {
+  bool keep_dims = false;
+  return GetNodeAttr(reduction, "keep_dims", &keep_dims).ok() && keep_dims;
+}
+
+bool FindMultipleReductions(const RemapperContext& ctx, int node_index,
+                            const std::vector<bool>& invalidated_nodes,
+                            const std::vector<bool>& nodes_to_delete,
+                            MultipleReductions* matched) {
+  const auto* root = ctx.graph_view.GetNode(node_index);
+  const auto* root_def = root->node();
+  if (!IsFusableReduction(*root)) return false;
+
+  // The reduced tensor, read either directly or through a Square that only
+  // feeds a Sum or Mean.
+  const auto* root_input = root->GetRegularFanin(0).node_view();
+  const bool root_reduces_squares = (IsSum(*root_def) || IsMean(*root_def)) &&
+                                    IsSquare(*root_input->node()) &&
+                                    IsFusableIntermediate(ctx, *root_input);
+  const auto& input = root_reduces_squares ? root_input->GetRegularFanin(0)
+                                           : root->GetRegularFanin(0);
+  const string& input_name = root_reduces_squares ? root_input->node()->input(0)
+                                                  : root_def->input(0);
+
+  const bool keep_dims = GetKeepDims(*root_def);
+  const auto is_compatible = [&](const utils::MutableNodeView& reduction) {
+    const auto* reduction_def = reduction.node();
+    return !invalidated_nodes[reduction.node_index()] &&
+           !nodes_to_delete[reduction.node_index()] &&
+           IsFusableReduction(reduction) &&
+           reduction_def->input(1) == root_def->input(1) &&
+           reduction_def->device() == root_def->device() &&
+           HaveSameDataType(reduction_def, root_def) &&
+           GetDataTypeFromAttr(*reduction_def, "Tidx") ==
+               GetDataTypeFromAttr(*root_def, "Tidx") &&
+           GetKeepDims(*reduction_def) == keep_dims;
+  };
+
+  MultipleReductions reductions;
+  const auto* input_node = input.node_view();
+  for (const auto& fanout : input_node->GetRegularFanout(input.index())) {
+    const auto* consumer = fanout.node_view();
+    if (fanout.index() != 0) continue;
+    if (IsSquare(*consumer->node())) {
+      if (!IsFusableIntermediate(ctx, *consumer) ||
+          nodes_to_delete[consumer->node_index()])
+        continue;
+      const auto* reduction = consumer->GetRegularFanout(0)[0].node_view();
+      if ((IsSum(*reduction->node()) || IsMean(*reduction->node())) &&
+          is_compatible(*reduction)) {
+        reductions.reductions.push_back(reduction->node_index());
+        reductions.kinds.push_back(
+            strings::StrCat(reduction->node()->op(), "OfSquares"));
+        reductions.fused_nodes.push_back(consumer->node_index());
+      }
+    } else if (is_compatible(*consumer)) {
+      reductions.reductions.push_back(consumer->node_index());
+      reductions.kinds.push_back(consumer->node()->op());
+    }
+  }
+  if (reductions.reductions.size() < 2) return false;
+
+  reductions.input = input_name;
+  reductions.fused_name = strings::StrCat(root_def->name(), "/fused_reduce");
+  if (ctx.graph_view.GetNode(reductions.fused_name) != nullptr) return false;
+  *matched = std::move(reductions);
+  return true;
+}
+
 void CopyConv2DAttributes(const NodeDef& conv2d, NodeDef* fused_conv2d) {
   DCHECK(IsConv2D(conv2d)) << "Input node must be a Conv2D";
 
@@ -912,6 +1438,17 @@ void SetFusedOpAttributes(NodeDef* fused,
   SetAttrValue(epsilon, &(*attr)["epsilon"]);  // required only for BatchNorm
 }
 
+// Adds the control inputs of `node` to `fused`, which replaces it.
+void ForwardControlInputs(const NodeDef& node, NodeDef* fused) {
+  for (const string& input : node.input()) {
+    if (IsControlInput(input) &&
+        std::find(fused->input().begin(), fused->input().end(), input) ==
+            fused->input().end()) {
+      fused->add_input(input);
+    }
+  }
+}
+
 Status AddFusedContractionNode(RemapperContext* ctx,
                                const ContractionWithBiasAdd& matched,
                                std::vector<bool>* invalidated_nodes,
@@ -1025,10 +1562,14 @@ Status AddFusedConv2DNode(RemapperContext* ctx,
   fused_conv2d.add_input(contraction.input(1));  // 1: filter
   fused_conv2d.add_input(bias_add.input(1));     // 2: bias
 
+  ForwardControlInputs(contraction, &fused_conv2d);
+  ForwardControlInputs(bias_add, &fused_conv2d);
+
   CopyConv2DAttributes(contraction, &fused_conv2d);
   SetFusedOpAttributes(&fused_conv2d, {"BiasAdd"});
 
-  // Replace BiasAdd node with a Squeeze.
+  // Replace BiasAdd node with a Squeeze, which keeps the control inputs of
+  // the original Squeeze.
   NodeDef remapped_squeeze = squeeze;
   remapped_squeeze.set_name(bias_add.name());
   remapped_squeeze.set_input(0, contraction.name());
@@ -1069,6 +1610,8 @@ Status AddFusedConv2DNode(RemapperContext* ctx,
   fused_conv2d.add_input(fused_batch_norm.input(2));  // 3: offset
   fused_conv2d.add_input(fused_batch_norm.input(3));  // 4: mean
   fused_conv2d.add_input(fused_batch_norm.input(4));  // 5: variance
+  ForwardControlInputs(contraction, &fused_conv2d);
+  ForwardControlInputs(fused_batch_norm, &fused_conv2d);
 
   CopyConv2DAttributes(contraction, &fused_conv2d);
   SetFusedOpAttributes(&fused_conv2d, {"FusedBatchNorm"},
@@ -1112,6 +1655,8 @@ Status AddFusedConv2DNode(RemapperContext* ctx,
   fused_conv2d.add_input(fused_batch_norm.input(2));  // 3: offset
   fused_conv2d.add_input(fused_batch_norm.input(3));  // 4: mean
   fused_conv2d.add_input(fused_batch_norm.input(4));  // 5: variance
+  ForwardControlInputs(contraction, &fused_conv2d);
+  ForwardControlInputs(fused_batch_norm, &fused_conv2d);
 
   CopyConv2DAttributes(contraction, &fused_conv2d);
   SetFusedOpAttributes(&fused_conv2d, {"FusedBatchNorm", activation.op()},
@@ -1281,6 +1826,163 @@ Status AddFusedBatchNormExNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+Status AddFusedLayerNormNode(RemapperContext* ctx, const LayerNorm& matched,
+                             std::vector<bool>* invalidated_nodes,
+                             std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& add_offset = graph->node(matched.add_offset);
+  VLOG(2) << "Fuse layer normalization into " << kFusedLayerNorm << ":"
+          << " add_offset=" << add_offset.name() << " x=" << matched.x
+          << " scale=" << matched.scale << " offset=" << matched.offset;
+
+  NodeDef fused_op;
+  fused_op.set_op(kFusedLayerNorm);
+  fused_op.set_name(add_offset.name());
+  fused_op.set_device(add_offset.device());
+  fused_op.add_input(matched.x);       // 0: x
+  fused_op.add_input(matched.scale);   // 1: scale
+  fused_op.add_input(matched.offset);  // 2: offset
+
+  auto* attrs = fused_op.mutable_attr();
+  (*attrs)["T"] = add_offset.attr().at("T");
+  SetAttrValue(matched.epsilon, &(*attrs)["epsilon"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.add_offset] = true;
+  for (int node_index : matched.fused_nodes) {
+    (*nodes_to_delete)[node_index] = true;
+  }
+
+  return Status::OK();
+}
+
+Status AddFusedScaledDotProductAttentionNode(
+    RemapperContext* ctx, const ScaledDotProductAttention& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& output = graph->node(matched.output);
+  VLOG(2) << "Fuse scaled dot-product attention into "
+          << kFusedScaledDotProductAttention << ":"
+          << " output=" << output.name() << " query=" << matched.query
+          << " key=" << matched.key << " value=" << matched.value
+          << " scale=" << matched.scale;
+
+  NodeDef fused_op;
+  fused_op.set_op(kFusedScaledDotProductAttention);
+  fused_op.set_name(output.name());
+  fused_op.set_device(output.device());
+  fused_op.add_input(matched.query);  // 0: query
+  fused_op.add_input(matched.key);    // 1: key
+  fused_op.add_input(matched.value);  // 2: value
+
+  auto* attrs = fused_op.mutable_attr();
+  (*attrs)["T"] = output.attr().at("T");
+  SetAttrValue(matched.scale, &(*attrs)["scale"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.output] = true;
+  for (int node_index : matched.fused_nodes) {
+    (*nodes_to_delete)[node_index] = true;
+  }
+
+  return Status::OK();
+}
+
+Status AddSparseSegmentReductionOfParams(
+    RemapperContext* ctx, const SparseSegmentReductionOfGather& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& reduction = graph->node(matched.reduction);
+  VLOG(2) << "Fuse gather of unique ids into " << reduction.op() << ":"
+          << " reduction=" << reduction.name() << " params=" << matched.params
+          << " ids=" << matched.ids;
+
+  NodeDef fused_op = reduction;
+  fused_op.set_input(0, matched.params);  // 0: data
+  fused_op.set_input(1, matched.ids);     // 1: indices
+  SetAttrValue(matched.ids_dtype, &(*fused_op.mutable_attr())["Tidx"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.reduction] = true;
+  for (int node_index : matched.fused_nodes) {
+    (*nodes_to_delete)[node_index] = true;
+  }
+
+  return Status::OK();
+}
+
+Status AddFusedReduceNode(RemapperContext* ctx,
+                          const MultipleReductions& matched,
+                          std::vector<bool>* invalidated_nodes,
+                          std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& first = graph->node(matched.reductions[0]);
+  VLOG(2) << "Fuse " << matched.reductions.size() << " reductions into "
+          << kFusedReduce << ":"
+          << " name=" << matched.fused_name << " input=" << matched.input
+          << " reductions=" << absl::StrJoin(matched.kinds, ",");
+
+  NodeDef fused_op;
+  fused_op.set_op(kFusedReduce);
+  fused_op.set_name(matched.fused_name);
+  fused_op.set_device(first.device());
+  fused_op.add_input(matched.input);   // 0: input
+  fused_op.add_input(first.input(1));  // 1: reduction_indices
+
+  auto* attrs = fused_op.mutable_attr();
+  (*attrs)["T"] = first.attr().at("T");
+  if (first.attr().count("Tidx") > 0) {
+    (*attrs)["Tidx"] = first.attr().at("Tidx");
+  }
+  SetAttrValue(GetKeepDims(first), &(*attrs)["keep_dims"]);
+  SetAttrValue(static_cast<int64>(matched.kinds.size()),
+               &(*attrs)["num_reductions"]);
+  SetAttrValue(matched.kinds, &(*attrs)["reductions"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+
+  // Keep the names of the reductions for their consumers.
+  for (int i = 0; i < static_cast<int>(matched.reductions.size()); ++i) {
+    const NodeDef& reduction = graph->node(matched.reductions[i]);
+    NodeDef identity;
+    identity.set_op("Identity");
+    identity.set_name(reduction.name());
+    identity.set_device(reduction.device());
+    identity.add_input(strings::StrCat(matched.fused_name, ":", i));
+    (*identity.mutable_attr())["T"] = reduction.attr().at("T");
+    mutation->AddNode(std::move(identity), &status);
+    TF_RETURN_IF_ERROR(status);
+  }
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  for (int node_index : matched.reductions) {
+    (*invalidated_nodes)[node_index] = true;
+  }
+  for (int node_index : matched.fused_nodes) {
+    (*nodes_to_delete)[node_index] = true;
+  }
+
+  return Status::OK();
+}
+
 Status AddBatchNormNodes(RemapperContext* ctx, const FusedBatchNorm& matched) {
   const GraphDef* graph = ctx->graph_view.graph();
   const NodeDef& fused_node = graph->node(matched.fused_batch_norm);
@@ -1468,6 +2170,7 @@ Status AddBatchNormNodes(RemapperContext* ctx, const FusedBatchNorm& matched) {
 // shapes:
 //   (1) Splitting FusedBatchNorm into primitives.
 //   (2) Fusing side input and/or activation into FusedBatchNorm.
+//   (3) Fusing layer normalization or scaled dot-product attention.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1513,7 +2216,23 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
-  return is_batch_norm_candidate() || is_batch_norm_fusion_candidate();
+  // Candidate for a layer normalization or attention fusion.
+  const auto is_transformer_fusion_candidate = [&]() -> bool {
+    if (node_view->NumRegularFanins() < 1) return false;
+    const auto* fanin_0_node_def =
+        node_view->GetRegularFanin(0).node_view()->node();
+    if (IsAdd(*node_def)) {
+      // LayerNorm: the offset can be either input of the final Add.
+      if (IsMul(*fanin_0_node_def)) return true;
+      if (node_view->NumRegularFanins() < 2) return false;
+      return IsMul(*node_view->GetRegularFanin(1).node_view()->node());
+    }
+    return IsBatchMatMulWithAdjoints(*node_def, false, false) &&
+           IsSoftmax(*fanin_0_node_def);
+  };
+
+  return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
+         is_transformer_fusion_candidate();
 }
 
 }  // namespace
@@ -1631,6 +2350,20 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     }
 #endif  // !INTEL_MKL
 
+    // Remap the sparse segment reduction of rows gathered at unique ids into a
+    // sparse segment reduction of the params. The gradient of the result with
+    // respect to the params is dense, so only do it if the graph will not be
+    // differentiated.
+    SparseSegmentReductionOfGather sparse_segment_reduction_of_gather;
+    if (allow_non_differentiable_rewrites &&
+        FindSparseSegmentReductionOfGather(
+            ctx, i, &sparse_segment_reduction_of_gather)) {
+      TF_RETURN_IF_ERROR(AddSparseSegmentReductionOfParams(
+          &ctx, sparse_segment_reduction_of_gather, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
     // Infer properties lazily in case they are not needed.
     if (!ctx.inferred_graph_properties && RequiresInferredShapes(ctx, i)) {
       const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
@@ -1651,6 +2384,36 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap unfused layer normalization into the _FusedLayerNorm.
+    LayerNorm layer_norm;
+    if (allow_non_differentiable_rewrites &&
+        FindLayerNorm(ctx, i, &layer_norm)) {
+      TF_RETURN_IF_ERROR(AddFusedLayerNormNode(
+          &ctx, layer_norm, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap softmax(Q*K^T*scale)*V into the _FusedScaledDotProductAttention.
+    ScaledDotProductAttention attention;
+    if (allow_non_differentiable_rewrites &&
+        FindScaledDotProductAttention(ctx, i, &attention)) {
+      TF_RETURN_IF_ERROR(AddFusedScaledDotProductAttentionNode(
+          &ctx, attention, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap reductions of the same input over the same axes into a
+    // _FusedReduce.
+    MultipleReductions multiple_reductions;
+    if (allow_non_differentiable_rewrites &&
+        FindMultipleReductions(ctx, i, invalidated_nodes, nodes_to_delete,
+                               &multiple_reductions)) {
+      TF_RETURN_IF_ERROR(AddFusedReduceNode(&ctx, multiple_reductions,
+                                            &invalidated_nodes,
+                                            &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
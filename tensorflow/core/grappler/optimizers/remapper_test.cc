@@ -704,6 +704,80 @@ TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, FuseConv2DWithBatchNormForwardsControls) {
+  if (!EigenSupportsContractionOutputKernel()) return;
+
+  using ops::Placeholder;
+
+  for (bool conv_has_control_fanout : {false, true}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto input_shape = ops::Placeholder::Shape({8, 32, 32, 3});
+    auto filter_shape = ops::Placeholder::Shape({1, 1, 3, 128});
+    auto scale_shape = ops::Placeholder::Shape({128});
+
+    auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+    auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT, filter_shape);
+    auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT, scale_shape);
+    auto offset = Placeholder(s.WithOpName("offset"), DT_FLOAT, scale_shape);
+    auto mean = Placeholder(s.WithOpName("mean"), DT_FLOAT, scale_shape);
+    auto variance =
+        Placeholder(s.WithOpName("variance"), DT_FLOAT, scale_shape);
+    auto conv_control = ops::NoOp(s.WithOpName("conv_control"));
+    auto batch_norm_control = ops::NoOp(s.WithOpName("batch_norm_control"));
+
+    std::vector<int> strides = {1, 1, 1, 1};
+    auto conv_scope =
+        s.WithOpName("conv").WithControlDependencies({conv_control.operation});
+    auto conv = ops::Conv2D(conv_scope, input, filter, strides, "SAME");
+    ops::FusedBatchNorm::Attrs attrs;
+    attrs = attrs.IsTraining(false);
+    auto batch_norm_scope = s.WithOpName("batch_norm")
+                                .WithControlDependencies(
+                                    {batch_norm_control.operation});
+    auto batch_norm = ops::FusedBatchNorm(batch_norm_scope, conv, scale,
+                                          offset, mean, variance, attrs);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), batch_norm.y);
+    if (conv_has_control_fanout) {
+      // The Conv2D would be removed from under this dependency.
+      ops::NoOp(
+          s.WithOpName("after_conv").WithControlDependencies(conv.output));
+    }
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "batch_norm") {
+        if (conv_has_control_fanout) {
+          EXPECT_EQ(node.op(), "FusedBatchNorm");
+        } else {
+          EXPECT_EQ(node.op(), "_FusedConv2D");
+          ASSERT_EQ(node.input_size(), 8);
+          EXPECT_EQ(node.input(6), "^conv_control");
+          EXPECT_EQ(node.input(7), "^batch_norm_control");
+        }
+        found++;
+      } else if (node.name() == "conv") {
+        EXPECT_TRUE(conv_has_control_fanout);
+        found++;
+      }
+    }
+    EXPECT_EQ(found, conv_has_control_fanout ? 2 : 1);
+  }
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBatchNormAndActivation) {
   if (!EigenSupportsContractionOutputKernel()) return;
 
@@ -875,5 +949,357 @@ TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBias) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBiasForwardsControls) {
+  if (!EigenSupportsContractionOutputKernel()) return;
+
+  using ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input_shape = ops::Placeholder::Shape({8, 32, 1, 3});
+  auto filter_shape = ops::Placeholder::Shape({1, 1, 3, 128});
+  auto bias_shape = ops::Placeholder::Shape({128});
+
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+  auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT, filter_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+  auto conv_control = ops::NoOp(s.WithOpName("conv_control"));
+  auto squeeze_control = ops::NoOp(s.WithOpName("squeeze_control"));
+  auto bias_add_control = ops::NoOp(s.WithOpName("bias_add_control"));
+
+  std::vector<int> strides = {1, 1, 1, 1};
+  auto conv_scope =
+      s.WithOpName("conv").WithControlDependencies({conv_control.operation});
+  auto conv = ops::Conv2D(conv_scope, input, filter, strides, "SAME");
+
+  ops::Squeeze::Attrs attrs;
+  attrs = attrs.Axis({2});
+  auto squeeze_scope = s.WithOpName("squeeze").WithControlDependencies(
+      {squeeze_control.operation});
+  auto squeeze = ops::Squeeze(squeeze_scope, conv, attrs);
+
+  auto bias_add_scope = s.WithOpName("bias_add").WithControlDependencies(
+      {bias_add_control.operation});
+  auto bias_add = ops::BiasAdd(bias_add_scope, squeeze, bias);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), bias_add);
+  // The root keeps its name, so its control fanouts are preserved.
+  ops::NoOp(
+      s.WithOpName("after_bias_add").WithControlDependencies(bias_add.output));
+
+  auto input_t = GenerateRandomTensor<DT_FLOAT>({8, 32, 1, 3});
+  auto filter_t = GenerateRandomTensor<DT_FLOAT>({1, 1, 3, 128});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({128});
+
+  GrapplerItem item;
+  item.fetch = {"fetch", "after_bias_add"};
+  item.feed = {{"input", input_t}, {"filter", filter_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "conv") {
+      EXPECT_EQ(node.op(), "_FusedConv2D");
+      ASSERT_EQ(node.input_size(), 5);
+      EXPECT_EQ(node.input(3), "^conv_control");
+      EXPECT_EQ(node.input(4), "^bias_add_control");
+      found++;
+    } else if (node.name() == "bias_add") {
+      EXPECT_EQ(node.op(), "Squeeze");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "conv");
+      EXPECT_EQ(node.input(1), "^squeeze_control");
+      found++;
+    } else if (node.name() == "after_bias_add") {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "^bias_add");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 3);
+
+  auto tensors_expected = EvaluateNodes(item.graph, {"fetch"}, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, {"fetch"}, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseLayerNorm) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x_shape = ops::Placeholder::Shape({4, 16, 32});
+  auto vec_shape = ops::Placeholder::Shape({32});
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT, x_shape);
+  auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT, vec_shape);
+  auto offset = Placeholder(s.WithOpName("offset"), DT_FLOAT, vec_shape);
+
+  auto axis = ops::Const(s.WithOpName("axis"), {-1}, {1});
+  auto epsilon = ops::Const(s.WithOpName("epsilon"), 1e-5f, {});
+  auto mean = ops::Mean(s.WithOpName("mean"), x, axis,
+                        ops::Mean::KeepDims(true));
+  auto centered = ops::Sub(s.WithOpName("centered"), x, mean);
+  auto square = ops::Square(s.WithOpName("square"), centered);
+  auto variance = ops::Mean(s.WithOpName("variance"), square, axis,
+                            ops::Mean::KeepDims(true));
+  auto add_epsilon = ops::AddV2(s.WithOpName("add_epsilon"), variance, epsilon);
+  auto rsqrt = ops::Rsqrt(s.WithOpName("rsqrt"), add_epsilon);
+  auto normalized = ops::Mul(s.WithOpName("normalized"), centered, rsqrt);
+  auto mul_scale = ops::Mul(s.WithOpName("mul_scale"), normalized, scale);
+  auto add_offset = ops::AddV2(s.WithOpName("add_offset"), offset, mul_scale);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), add_offset);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({4, 16, 32});
+  auto scale_t = GenerateRandomTensor<DT_FLOAT>({32});
+  auto offset_t = GenerateRandomTensor<DT_FLOAT>({32});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", x_t}, {"scale", scale_t}, {"offset", offset_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "mean");
+    EXPECT_NE(node.name(), "rsqrt");
+    EXPECT_NE(node.name(), "mul_scale");
+    if (node.name() == "add_offset") {
+      EXPECT_EQ(node.op(), "_FusedLayerNorm");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "scale");
+      EXPECT_EQ(node.input(2), "offset");
+      EXPECT_FLOAT_EQ(node.attr().at("epsilon").f(), 1e-5f);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+}
+
+TEST_F(RemapperTest, FuseScaledDotProductAttention) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto query_shape = ops::Placeholder::Shape({2, 4, 8, 16});
+  auto key_shape = ops::Placeholder::Shape({2, 4, 10, 16});
+  auto value_shape = ops::Placeholder::Shape({2, 4, 10, 24});
+
+  auto query = Placeholder(s.WithOpName("query"), DT_FLOAT, query_shape);
+  auto key = Placeholder(s.WithOpName("key"), DT_FLOAT, key_shape);
+  auto value = Placeholder(s.WithOpName("value"), DT_FLOAT, value_shape);
+
+  auto scores = ops::BatchMatMulV2(s.WithOpName("scores"), query, key,
+                                   ops::BatchMatMulV2::AdjY(true));
+  auto scale = ops::Const(s.WithOpName("scale"), 0.25f, {});
+  auto scaled = ops::Mul(s.WithOpName("scaled"), scale, scores);
+  auto weights = ops::Softmax(s.WithOpName("weights"), scaled);
+  auto attention =
+      ops::BatchMatMulV2(s.WithOpName("attention"), weights, value);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), attention);
+
+  auto query_t = GenerateRandomTensor<DT_FLOAT>({2, 4, 8, 16});
+  auto key_t = GenerateRandomTensor<DT_FLOAT>({2, 4, 10, 16});
+  auto value_t = GenerateRandomTensor<DT_FLOAT>({2, 4, 10, 24});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"query", query_t}, {"key", key_t}, {"value", value_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "scores");
+    EXPECT_NE(node.name(), "weights");
+    if (node.name() == "attention") {
+      EXPECT_EQ(node.op(), "_FusedScaledDotProductAttention");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "query");
+      EXPECT_EQ(node.input(1), "key");
+      EXPECT_EQ(node.input(2), "value");
+      EXPECT_FLOAT_EQ(node.attr().at("scale").f(), 0.25f);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+}
+
+TEST_F(RemapperTest, FuseSparseSegmentReductionOfGather) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto params = Placeholder(s.WithOpName("params"), DT_FLOAT,
+                            ops::Placeholder::Shape({10, 4}));
+  auto ids = Placeholder(s.WithOpName("ids"), DT_INT64,
+                         ops::Placeholder::Shape({6}));
+  auto segment_ids =
+      ops::Const(s.WithOpName("segment_ids"), {0, 0, 1, 1, 1, 2}, {6});
+
+  auto unique = ops::Unique(s.WithOpName("unique"), ids);
+  auto axis = ops::Const(s.WithOpName("axis"), 0, {});
+  auto gather = ops::GatherV2(s.WithOpName("gather"), params, unique.y, axis);
+  auto rows = ops::Identity(s.WithOpName("rows"), gather);
+  auto combined = ops::SparseSegmentMean(s.WithOpName("combined"), rows,
+                                         unique.idx, segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), combined);
+
+  auto params_t = GenerateRandomTensor<DT_FLOAT>({10, 4});
+  auto ids_t = test::AsTensor<int64>({3, 7, 3, 0, 9, 7});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"params", params_t}, {"ids", ids_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "unique");
+    EXPECT_NE(node.name(), "gather");
+    EXPECT_NE(node.name(), "rows");
+    if (node.name() == "combined") {
+      EXPECT_EQ(node.op(), "SparseSegmentMean");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "params");
+      EXPECT_EQ(node.input(1), "ids");
+      EXPECT_EQ(node.input(2), "segment_ids");
+      EXPECT_EQ(node.attr().at("Tidx").type(), DT_INT64);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseMultipleReductions) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto axis = ops::Const(s.WithOpName("axis"), {1}, {1});
+  auto mean = ops::Mean(s.WithOpName("mean"), x, axis);
+  auto square = ops::Square(s.WithOpName("square"), x);
+  auto mean_of_squares =
+      ops::Mean(s.WithOpName("mean_of_squares"), square, axis);
+  auto max = ops::Max(s.WithOpName("max"), x, axis);
+  // Reduces other axes, so it is not fused.
+  auto sum = ops::Sum(s.WithOpName("sum"), x, {0});
+  auto fetch_mean = ops::Identity(s.WithOpName("fetch_mean"), mean);
+  auto fetch_mean_of_squares =
+      ops::Identity(s.WithOpName("fetch_mean_of_squares"), mean_of_squares);
+  auto fetch_max = ops::Identity(s.WithOpName("fetch_max"), max);
+  auto fetch_sum = ops::Identity(s.WithOpName("fetch_sum"), sum);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({8, 64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch_mean", "fetch_mean_of_squares", "fetch_max",
+                "fetch_sum"};
+  item.feed = {{"x", x_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  string fused_name;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "square");
+    if (node.op() == "_FusedReduce") {
+      fused_name = node.name();
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "axis");
+      EXPECT_EQ(node.attr().at("num_reductions").i(), 3);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "mean" || node.name() == "mean_of_squares" ||
+        node.name() == "max") {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0).substr(0, fused_name.size() + 1),
+                fused_name + ":");
+      found++;
+    } else if (node.name() == "sum") {
+      EXPECT_EQ(node.op(), "Sum");
+    }
+  }
+  EXPECT_EQ(4, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 4);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    test::ExpectTensorNear<float>(tensors[i], tensors_expected[i], 1e-5);
+  }
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -252,6 +254,44 @@ Status GetInputs(ScopedAllocatorOptimizer* sa_opti, int64 invocation_count,
   return Status::OK();
 }
 
+// Build the ScopedAllocator node that will be assigned to allocate
+// the output tensors of the input node set, one field per input.
+Status ConstructScopedAllocatorNode(
+    ScopedAllocatorOptimizer* sa_opti, GraphDef* graph, NodeMap* node_map,
+    const string& device_name, DataType dtype, int sa_id,
+    const string& sa_name, const std::vector<TensorShape>& input_shapes,
+    const std::vector<InputDesc>& inputs, const TensorShape& sa_shape) {
+  VLOG(2) << "ConstructScopedAllocatorNode " << sa_name;
+  NodeDefBuilder sa_builder(sa_name, "_ScopedAllocator");
+  sa_builder.Device(device_name);
+  sa_builder.Attr("sa_name", sa_name);
+  sa_builder.Attr("T", dtype);
+  sa_builder.Attr("id", sa_id);
+  sa_builder.Attr("shapes", input_shapes);
+  sa_builder.Attr("shape", sa_shape);
+  sa_builder.Attr("expected_call_count", static_cast<int64>(inputs.size()));
+  NodeDef* sa_node = graph->add_node();
+  LOG_WARNING_AND_RETURN_IF_ERROR(sa_builder.Finalize(sa_node));
+  node_map->AddNode(sa_name, sa_node);
+
+  // Add control edges from the ScopedAllocatorOp to all of the
+  // input nodes and mark them for allocation from backing tensor.
+  for (int i = 0; i < inputs.size(); ++i) {
+    auto& nd = inputs[i];
+    VLOG(2) << "To input " << i << ": " << nd.from_node_def->name()
+            << " add control input "
+            << "^" << sa_name;
+    nd.from_node_def->add_input(strings::StrCat("^", sa_name));
+    // This attribute says: allocate output_slot from
+    // ScopedAllocator instance sa_id + 1 + i.
+    ScopedAllocatorOptimizer::ExtendNodeAttr("_scoped_allocator",
+                                             {nd.output_slot, sa_id + 1 + i},
+                                             nd.from_node_def);
+    node_map->AddOutput(sa_name, nd.from_node_def->name());
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 void ScopedAllocatorOptimizer::ExtendNodeAttr(StringPiece name,
@@ -366,45 +406,6 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
     return Status::OK();
   }
 
-  // Build the ScopedAllocator node that will be assigned to allocate
-  // the output tensors of the input node set.
-  Status ConstructScopedAllocatorNode(
-      ScopedAllocatorOptimizer* sa_opti, GraphDef* graph, NodeMap* node_map,
-      const std::vector<NodeDef*>& ops, const string& device_name,
-      DataType dtype, int sa_id, const string& sa_name,
-      const std::vector<TensorShape>& input_shapes,
-      const std::vector<InputDesc>& inputs, const TensorShape& sa_shape) {
-    VLOG(2) << "ConstructScopedAllocatorNode " << sa_name;
-    NodeDefBuilder sa_builder(sa_name, "_ScopedAllocator");
-    sa_builder.Device(device_name);
-    sa_builder.Attr("sa_name", sa_name);
-    sa_builder.Attr("T", dtype);
-    sa_builder.Attr("id", sa_id);
-    sa_builder.Attr("shapes", input_shapes);
-    sa_builder.Attr("shape", sa_shape);
-    sa_builder.Attr("expected_call_count", static_cast<int64>(ops.size()));
-    NodeDef* sa_node = graph->add_node();
-    LOG_WARNING_AND_RETURN_IF_ERROR(sa_builder.Finalize(sa_node));
-    node_map->AddNode(sa_name, sa_node);
-
-    // Add control edges from the ScopedAllocatorOp to all of the
-    // input nodes and mark them for allocation from backing tensor.
-    for (int i = 0; i < inputs.size(); ++i) {
-      auto& nd = inputs[i];
-      VLOG(2) << "To input " << i << ": " << nd.from_node_def->name()
-              << " add control input "
-              << "^" << sa_name;
-      nd.from_node_def->add_input(strings::StrCat("^", sa_name));
-      // This attribute says: allocate output_slot from
-      // ScopedAllocator instance sa_id + 1 + i.
-      ScopedAllocatorOptimizer::ExtendNodeAttr("_scoped_allocator",
-                                               {nd.output_slot, sa_id + 1 + i},
-                                               nd.from_node_def);
-      node_map->AddOutput(sa_name, nd.from_node_def->name());
-    }
-    return Status::OK();
-  }
-
   Status BuildSAConcatNode(GraphDef* graph, NodeMap* node_map,
                            const std::vector<NodeDef*>& ops,
                            const std::set<string>& op_instance_names,
@@ -657,7 +658,7 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
     string sa_name =
         strings::StrCat("scoped_allocator_", sa_id, "_", invocation_count);
     TF_RETURN_IF_ERROR(ConstructScopedAllocatorNode(
-        sa_opti, graph, node_map, ops, device_name, dtype, sa_id, sa_name,
+        sa_opti, graph, node_map, device_name, dtype, sa_id, sa_name,
         input_shapes, inputs, sa_shape));
 
     // TODO(tucker): Maybe add control edges to delay execution of the
@@ -710,12 +711,229 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
   }
 };
 
+// Removes the copy done by a ConcatV2 whose inputs come from independent
+// producers.  A new ScopedAllocator lays out one field per input in concat
+// order, and each producer allocates its output in its field, so that the
+// backing tensor holds the concatenation once all producers have run.  The
+// ConcatV2 node becomes an Identity of a ScopedAllocatorConcat that outputs
+// a view of the backing tensor, which keeps its name and consumers unchanged.
+//
+// Only a ConcatV2 that is a flat copy of its inputs qualifies: all dimensions
+// before the concat axis must be 1, and every input but the last must fill
+// whole allocator alignment units so that there are no gaps between fields.
+// Each input must also be the only use of its producer, since any other
+// consumer could update the shared buffer in place.
+class ConcatRewriter : public ScopedAllocatorOptimizer::Rewriter {
+ public:
+  ~ConcatRewriter() override {}
+
+  bool RewritesSingleOps() const override { return true; }
+
+  Status Rewrite(ScopedAllocatorOptimizer* sa_opti, int64 invocation_count,
+                 GraphDef* graph, const string& op_name,
+                 const std::vector<NodeDef*>& ops, bool* applied) override {
+    NodeMap* node_map = sa_opti->node_map();
+    for (NodeDef* concat : ops) {
+      DataType dtype;
+      std::vector<TensorShape> input_shapes;
+      std::vector<InputDesc> inputs;
+      TensorShape output_shape;
+      Status s = AnalyzeConcat(node_map, concat, &dtype, &input_shapes,
+                               &inputs, &output_shape);
+      if (!s.ok()) {
+        VLOG(1) << "Not rewriting " << concat->name() << ": " << s;
+        continue;
+      }
+      TF_RETURN_IF_ERROR(RewriteConcat(sa_opti, invocation_count, graph,
+                                       node_map, concat, dtype, input_shapes,
+                                       inputs, output_shape));
+      *applied = true;
+    }
+    return Status::OK();
+  }
+
+ private:
+  // Reads the value of the constant axis input of `concat`.
+  Status GetAxis(NodeMap* node_map, const NodeDef& concat, int num_inputs,
+                 int64* axis) {
+    const NodeDef* axis_node = node_map->GetNode(concat.input(num_inputs));
+    if (axis_node == nullptr || !IsConstant(*axis_node)) {
+      return errors::Unimplemented("Axis of ", concat.name(),
+                                   " is not a constant");
+    }
+    TensorProto axis_proto;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*axis_node, "value", &axis_proto));
+    Tensor axis_tensor;
+    if (!axis_tensor.FromProto(axis_proto) ||
+        axis_tensor.NumElements() != 1) {
+      return errors::InvalidArgument("Invalid axis for ", concat.name());
+    }
+    if (axis_tensor.dtype() == DT_INT32) {
+      *axis = axis_tensor.flat<int32>()(0);
+    } else {
+      *axis = axis_tensor.flat<int64>()(0);
+    }
+    return Status::OK();
+  }
+
+  // Checks whether `concat` can be rewritten, and if so gathers its type,
+  // the shapes of its inputs and output, and the producers of its inputs.
+  Status AnalyzeConcat(NodeMap* node_map, NodeDef* concat, DataType* dtype,
+                       std::vector<TensorShape>* input_shapes,
+                       std::vector<InputDesc>* inputs,
+                       TensorShape* output_shape) {
+    CHECK(graph_properties_);
+    int num_inputs;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*concat, "N", &num_inputs));
+    TF_RETURN_IF_ERROR(GetNodeAttr(*concat, "T", dtype));
+    const int type_size = DataTypeSize(*dtype);
+    if (type_size == 0 || Allocator::kAllocatorAlignment % type_size != 0) {
+      return errors::Unimplemented("Unsupported type ",
+                                   DataTypeString(*dtype));
+    }
+    if (!graph_properties_->HasInputProperties(concat->name()) ||
+        !graph_properties_->HasOutputProperties(concat->name())) {
+      return errors::Internal("Node ", concat->name(), " lacks shapes.");
+    }
+    const std::vector<OpInfo::TensorProperties>& input_props =
+        graph_properties_->GetInputProperties(concat->name());
+    const std::vector<OpInfo::TensorProperties>& output_props =
+        graph_properties_->GetOutputProperties(concat->name());
+    if (input_props.size() != static_cast<size_t>(num_inputs) + 1 ||
+        output_props.size() != 1 ||
+        !TensorShape::IsValid(output_props[0].shape())) {
+      return errors::Internal("Complete shape not known for ",
+                              concat->name());
+    }
+    *output_shape = TensorShape(output_props[0].shape());
+
+    int64 axis;
+    TF_RETURN_IF_ERROR(GetAxis(node_map, *concat, num_inputs, &axis));
+    if (axis < 0) axis += output_shape->dims();
+    if (axis < 0 || axis >= output_shape->dims()) {
+      return errors::InvalidArgument("Invalid axis for ", concat->name());
+    }
+    for (int d = 0; d < axis; ++d) {
+      if (output_shape->dim_size(d) != 1) {
+        return errors::Unimplemented(concat->name(),
+                                     " is not a flat copy of its inputs");
+      }
+    }
+
+    std::set<string> producers;
+    for (int i = 0; i < num_inputs; ++i) {
+      if (!TensorShape::IsValid(input_props[i].shape())) {
+        return errors::Internal("Complete shape not known for input ", i,
+                                " of ", concat->name());
+      }
+      TensorShape shape(input_props[i].shape());
+      const int64 num_bytes = shape.num_elements() * type_size;
+      if (num_bytes == 0 ||
+          (i + 1 < num_inputs &&
+           num_bytes % Allocator::kAllocatorAlignment != 0)) {
+        return errors::Unimplemented("Input ", i, " of ", concat->name(),
+                                     " does not fill whole alignment units");
+      }
+      int position = 0;
+      ParseNodeName(concat->input(i), &position);
+      NodeDef* producer = node_map->GetNode(concat->input(i));
+      if (producer == nullptr) {
+        return errors::Internal("Did not find node ", concat->input(i));
+      }
+      if (IsConstant(*producer) || IsControlFlow(*producer) ||
+          producer->device() != concat->device()) {
+        return errors::Unimplemented("Input ", i, " of ", concat->name(),
+                                     " cannot be allocated in place");
+      }
+      if (HasNodeAttr(*producer, "_scoped_allocator")) {
+        return errors::Unimplemented("Input ", i, " of ", concat->name(),
+                                     " is already assigned to a "
+                                     "ScopedAllocator");
+      }
+      if (!producers.insert(producer->name()).second ||
+          node_map->GetOutputs(producer->name()).size() != 1) {
+        return errors::Unimplemented("Input ", i, " of ", concat->name(),
+                                     " has other uses");
+      }
+      input_shapes->push_back(shape);
+      inputs->emplace_back(producer, position, concat);
+    }
+    return Status::OK();
+  }
+
+  Status RewriteConcat(ScopedAllocatorOptimizer* sa_opti,
+                       int64 invocation_count, GraphDef* graph,
+                       NodeMap* node_map, NodeDef* concat, DataType dtype,
+                       const std::vector<TensorShape>& input_shapes,
+                       const std::vector<InputDesc>& inputs,
+                       const TensorShape& output_shape) {
+    VLOG(1) << "ConcatRewriter::Rewrite " << concat->name();
+    const string& device_name = concat->device();
+    // The fields have no gaps, so the backing tensor is exactly the size of
+    // the concatenation.
+    const TensorShape sa_shape({output_shape.num_elements()});
+    int sa_id = sa_opti->NewScopedAllocatorId(input_shapes.size());
+    string sa_name =
+        strings::StrCat("scoped_allocator_", sa_id, "_", invocation_count);
+    TF_RETURN_IF_ERROR(ConstructScopedAllocatorNode(
+        sa_opti, graph, node_map, device_name, dtype, sa_id, sa_name,
+        input_shapes, inputs, sa_shape));
+
+    string sac_name = strings::StrCat("scoped_allocator_concat_", sa_id, "_",
+                                      invocation_count);
+    std::vector<NodeDefBuilder::NodeOut> sac_inputs;
+    for (const InputDesc& nd : inputs) {
+      sac_inputs.emplace_back(nd.from_node_def->name(), nd.output_slot, dtype);
+    }
+    NodeDefBuilder sac_builder(sac_name, "_ScopedAllocatorConcat");
+    sac_builder.Device(device_name);
+    sac_builder.Attr("sa_name", sa_name);
+    sac_builder.Attr("id", sa_id);
+    sac_builder.Attr("T", dtype);
+    sac_builder.Attr("shape", output_shape);
+    sac_builder.Attr("reshape", true);
+    sac_builder.Attr("N", static_cast<int>(sac_inputs.size()));
+    sac_builder.Input(NodeDefBuilder::NodeOut(sa_name, 0, dtype));
+    sac_builder.Input(sac_inputs);
+    NodeDef* sac_node = graph->add_node();
+    LOG_WARNING_AND_RETURN_IF_ERROR(sac_builder.Finalize(sac_node));
+    node_map->AddNode(sac_name, sac_node);
+    node_map->AddOutput(sa_name, sac_name);
+    for (const InputDesc& nd : inputs) {
+      node_map->AddOutput(nd.from_node_def->name(), sac_name);
+    }
+
+    // Turn the ConcatV2 into an Identity of the concatenated view, keeping
+    // its control inputs.
+    std::vector<string> control_inputs;
+    for (const string& input_name : concat->input()) {
+      if (IsControlInput(input_name)) {
+        control_inputs.push_back(input_name);
+      }
+    }
+    node_map->RemoveInputs(concat->name());
+    concat->set_op("Identity");
+    concat->clear_input();
+    concat->add_input(sac_name);
+    node_map->AddOutput(sac_name, concat->name());
+    for (const string& input_name : control_inputs) {
+      concat->add_input(input_name);
+      node_map->AddOutput(NodeName(input_name), concat->name());
+    }
+    concat->mutable_attr()->erase("N");
+    concat->mutable_attr()->erase("Tidx");
+    return Status::OK();
+  }
+};
+
 ScopedAllocatorOptimizer::ScopedAllocatorOptimizer(
     RewriterConfig::Toggle opt_level, const ScopedAllocatorOptions& opts)
-    : opt_level_(opt_level) {
+    : opt_level_(opt_level), max_bucket_bytes_(opts.max_bucket_bytes()) {
   VLOG(1) << "ScopedAllocatorOptimizer::ScopedAllocatorOptimizer";
   Rewriter* r = new UnaryElementwiseRewriter();
   to_delete_.push_back(r);
+  Rewriter* concat_rewriter = new ConcatRewriter();
+  to_delete_.push_back(concat_rewriter);
   if (opts.enable_op_size() == 0) {
     // Opts handled by default:
     for (const auto& op_name : {"CollectiveReduce"}) {
@@ -725,7 +943,7 @@ ScopedAllocatorOptimizer::ScopedAllocatorOptimizer(
   } else {
     for (const auto& op_name : opts.enable_op()) {
       op_name_set_.insert(op_name);
-      rewriters_[op_name] = r;
+      rewriters_[op_name] = op_name == "ConcatV2" ? concat_rewriter : r;
     }
   }
 }
@@ -879,6 +1097,46 @@ void PartitionByLoopStructure(const FrameView& frame_view,
   }
 }
 
+// Splits nodes, already in execution order, into consecutive buckets whose
+// outputs total at most max_bucket_bytes.  A node whose output size is not
+// statically known is put in a bucket of its own.
+void PartitionIntoBuckets(const GraphProperties& graph_properties,
+                          int64 max_bucket_bytes,
+                          const std::vector<NodeDef*>& nodes,
+                          std::vector<std::vector<NodeDef*>>* buckets) {
+  int64 bucket_bytes = 0;
+  buckets->emplace_back();
+  for (NodeDef* nd : nodes) {
+    int64 num_bytes = -1;
+    if (graph_properties.HasOutputProperties(nd->name())) {
+      const std::vector<OpInfo::TensorProperties>& props =
+          graph_properties.GetOutputProperties(nd->name());
+      if (props.size() == 1 && TensorShape::IsValid(props[0].shape())) {
+        // Fields of the backing tensor are aligned as in PopulateFields.
+        const int64 a = Allocator::kAllocatorAlignment;
+        num_bytes = TensorShape(props[0].shape()).num_elements() *
+                    DataTypeSize(props[0].dtype());
+        num_bytes = (num_bytes + a - 1) / a * a;
+      }
+    }
+    if (num_bytes < 0) {
+      if (!buckets->back().empty()) buckets->emplace_back();
+      buckets->back().push_back(nd);
+      buckets->emplace_back();
+      bucket_bytes = 0;
+      continue;
+    }
+    if (!buckets->back().empty() &&
+        bucket_bytes + num_bytes > max_bucket_bytes) {
+      buckets->emplace_back();
+      bucket_bytes = 0;
+    }
+    buckets->back().push_back(nd);
+    bucket_bytes += num_bytes;
+  }
+  if (buckets->back().empty()) buckets->pop_back();
+}
+
 }  // namespace
 
 Status ScopedAllocatorOptimizer::ProcessGraphDef(
@@ -912,12 +1170,28 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
           continue;
         }
         rewriter->SetGraphProperties(graph_properties);
+        if (rewriter->RewritesSingleOps()) {
+          std::vector<NodeDef*> nodes;
+          for (NodeDef* n : it.second) {
+            if (frame_view.Frames(*n).empty()) {
+              nodes.push_back(n);
+            }
+          }
+          bool applied = false;
+          status = rewriter->Rewrite(this, invocation_count, graph, op_name,
+                                     nodes, &applied);
+          if (!status.ok()) {
+            break;
+          }
+          continue;
+        }
         std::unique_ptr<Tree> root(ComputeScopeTree(it.first, it.second));
         // Nodes with a common depth and root path are now grouped
         // in the same Tree struct.  Split those groups into subgroups that
         // share identical loop nesting.
         status = ApplyToAll(root.get(), [this, rewriter, graph, &frame_view,
-                                         &op_name, invocation_count](Tree* t) {
+                                         &graph_properties, &op_name,
+                                         invocation_count](Tree* t) {
           VLOG(2) << "applied to tree node " << t->edge_ << " at depth "
                   << t->depth_ << " of size " << t->nodes_.size();
           if (t->nodes_.size() > 1) {
@@ -925,13 +1199,26 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
             PartitionByLoopStructure(frame_view, t->nodes_, &loop_groups);
             for (auto& lg : loop_groups) {
               if (lg.size() > 1) {
-                bool applied = false;
                 Status s = OrderNodeSet(&lg);
                 TF_RETURN_IF_ERROR(s);
-                VLOG(1) << "Applying Rewriter for " << op_name;
-                s = rewriter->Rewrite(this, invocation_count, graph, op_name,
-                                      lg, &applied);
-                LOG_WARNING_AND_RETURN_IF_ERROR(s);
+                // Collectives are ordered by instance_key, so every member
+                // of a group splits its ops into the same buckets.
+                std::vector<std::vector<NodeDef*>> buckets;
+                if (max_bucket_bytes_ > 0) {
+                  PartitionIntoBuckets(graph_properties, max_bucket_bytes_, lg,
+                                       &buckets);
+                } else {
+                  buckets.push_back(std::move(lg));
+                }
+                for (auto& bucket : buckets) {
+                  if (bucket.size() <= 1) continue;
+                  bool applied = false;
+                  VLOG(1) << "Applying Rewriter for " << op_name << " to "
+                          << bucket.size() << " ops";
+                  s = rewriter->Rewrite(this, invocation_count, graph, op_name,
+                                        bucket, &applied);
+                  LOG_WARNING_AND_RETURN_IF_ERROR(s);
+                }
               }
             }
           }
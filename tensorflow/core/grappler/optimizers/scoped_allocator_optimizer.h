@@ -89,6 +89,11 @@ class ScopedAllocatorOptimizer : public GraphOptimizer {
                            const std::vector<NodeDef*>& nodes,
                            bool* applied) = 0;
 
+    // Returns true if Rewrite() handles each op on its own rather than
+    // coalescing parallel instances.  Such a Rewriter is called once with all
+    // of the occurrences of its op on a device that are outside of loops.
+    virtual bool RewritesSingleOps() const { return false; }
+
     void SetGraphProperties(const GraphProperties& graph_properties) {
       graph_properties_ = &graph_properties;
       CHECK(graph_properties_);
@@ -104,6 +109,7 @@ class ScopedAllocatorOptimizer : public GraphOptimizer {
   Status OrderNodeSet(std::vector<NodeDef*>* nodes) const;
 
   RewriterConfig::Toggle opt_level_;
+  int64 max_bucket_bytes_;
   std::unordered_set<string> nodes_to_preserve_;
   OpNameSet op_name_set_;
   std::unordered_map<string, Rewriter*> rewriters_;
@@ -273,6 +273,131 @@ TEST_F(ScopedAllocatorOptimizerTest, ForwardInputToOutput) {
   ValidateValues(outputs, expected_r1, expected_r2);
 }
 
+TEST_F(ScopedAllocatorOptimizerTest, MaxBucketBytes) {
+  // Four parallel Abs ops, each of whose 16 byte inputs occupies one
+  // aligned field, should be coalesced into two buckets of two.
+  GrapplerItem item;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  s = s.WithDevice("/job:localhost/replica:0/task:0/device:CPU:0");
+  Output a =
+      ops::Const<float>(s.WithOpName("a"), {1.0, 0.0, 0.0, -1.0}, {2, 2});
+  for (int i = 0; i < 4; ++i) {
+    Output sum = ops::Add(s.WithOpName(strings::StrCat("s", i)), a, a);
+    Output abs = ops::Abs(s.WithOpName(strings::StrCat("a", i)), sum);
+    ops::Reshape(s.WithOpName(strings::StrCat("r", i)), abs, {1, 4});
+  }
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ScopedAllocatorOptions opts;
+  opts.add_enable_op("Abs");
+  opts.set_max_bucket_bytes(2 * Allocator::kAllocatorAlignment);
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  int num_scoped_allocators = 0;
+  int num_abs = 0;
+  for (const NodeDef& n : optimized_graph.node()) {
+    if (n.op() == "_ScopedAllocator") {
+      ++num_scoped_allocators;
+      int64 expected_call_count = 0;
+      TF_ASSERT_OK(GetNodeAttr(n, "expected_call_count", &expected_call_count));
+      EXPECT_EQ(2, expected_call_count);
+    } else if (n.op() == "Abs") {
+      ++num_abs;
+    }
+  }
+  EXPECT_EQ(2, num_scoped_allocators);
+  EXPECT_EQ(2, num_abs);
+}
+
+TEST_F(ScopedAllocatorOptimizerTest, ConcatExecute) {
+  // The two 64 byte Add outputs should be written directly into the output of
+  // the concat, which becomes an Identity of a _ScopedAllocatorConcat.
+  GrapplerItem item;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  s = s.WithDevice("/job:localhost/replica:0/task:0/device:CPU:0");
+  std::vector<float> a_values(16), b_values(16);
+  for (int i = 0; i < 16; ++i) {
+    a_values[i] = i;
+    b_values[i] = -2 * i;
+  }
+  Output a = ops::Const<float>(s.WithOpName("a"), a_values, {4, 4});
+  Output b = ops::Const<float>(s.WithOpName("b"), b_values, {4, 4});
+  Output s1 = ops::Add(s.WithOpName("s1"), a, a);
+  Output s2 = ops::Add(s.WithOpName("s2"), a, b);
+  Output concat = ops::Concat(s.WithOpName("concat"), {s1, s2}, 0);
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ScopedAllocatorOptions opts;
+  opts.add_enable_op("ConcatV2");
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+  NodeMap node_map(&optimized_graph);
+  NodeDef* concat_node = node_map.GetNode("concat");
+  ASSERT_NE(nullptr, concat_node);
+  EXPECT_EQ("Identity", concat_node->op());
+  ASSERT_EQ(1, concat_node->input_size());
+  NodeDef* sac_node = node_map.GetNode(concat_node->input(0));
+  ASSERT_NE(nullptr, sac_node);
+  EXPECT_EQ("_ScopedAllocatorConcat", sac_node->op());
+  ASSERT_EQ(3, sac_node->input_size());
+  EXPECT_EQ("s1", sac_node->input(1));
+  EXPECT_EQ("s2", sac_node->input(2));
+  EXPECT_TRUE(HasNodeAttr(*node_map.GetNode("s1"), "_scoped_allocator"));
+  EXPECT_TRUE(HasNodeAttr(*node_map.GetNode("s2"), "_scoped_allocator"));
+
+  ConfigProto config;
+  GraphOptions* gopt = config.mutable_graph_options();
+  OptimizerOptions* optimizer_opts = gopt->mutable_optimizer_options();
+  optimizer_opts->set_do_common_subexpression_elimination(false);
+  optimizer_opts->set_do_constant_folding(false);
+  optimizer_opts->set_do_function_inlining(false);
+  optimizer_opts->set_opt_level(OptimizerOptions::L0);
+  RewriterConfig* rwcfg = gopt->mutable_rewrite_options();
+  rwcfg->clear_optimizers();
+  (*rwcfg->add_optimizers()) = "scoped_allocator";
+  rwcfg->mutable_scoped_allocator_opts()->add_enable_op("ConcatV2");
+  std::unique_ptr<Session> session(CreateSession(item.graph, config));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {"concat:0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  ASSERT_EQ(32, outputs[0].NumElements());
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(2 * i, outputs[0].flat<float>()(i));
+    EXPECT_EQ(-i, outputs[0].flat<float>()(16 + i));
+  }
+}
+
+TEST_F(ScopedAllocatorOptimizerTest, ConcatNotRewritten) {
+  // A concat along the inner dimension is not a flat copy of its inputs, and
+  // a concat of inputs that do not fill whole alignment units would leave
+  // gaps between them, so neither is rewritten.
+  GrapplerItem item;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  s = s.WithDevice("/job:localhost/replica:0/task:0/device:CPU:0");
+  Output a = ops::Const<float>(s.WithOpName("a"), 1.0f, {4, 4});
+  Output b = ops::Const<float>(s.WithOpName("b"), 1.0f, {2, 2});
+  Output s1 = ops::Add(s.WithOpName("s1"), a, a);
+  Output s2 = ops::Add(s.WithOpName("s2"), a, a);
+  ops::Concat(s.WithOpName("inner"), {s1, s2}, 1);
+  Output s3 = ops::Add(s.WithOpName("s3"), b, b);
+  Output s4 = ops::Add(s.WithOpName("s4"), b, b);
+  ops::Concat(s.WithOpName("unaligned"), {s3, s4}, 0);
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ScopedAllocatorOptions opts;
+  opts.add_enable_op("ConcatV2");
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+  for (const NodeDef& n : optimized_graph.node()) {
+    EXPECT_NE("_ScopedAllocator", n.op());
+    EXPECT_FALSE(HasNodeAttr(n, "_scoped_allocator"));
+  }
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/macros.h"
 
@@ -208,13 +209,43 @@ Status Split(OpKernelContext* context, const Tensor& input,
   return SplitCPU<T>(context, input, sizes, outputs);
 }
 
+// Pads 'input' with element type T along dimension 'dim' up to 'length', with
+// default-constructed (i.e. zero) values at the end of that dimension.
+template <typename T>
+Status PadDimension(OpKernelContext* context, const Tensor& input, int dim,
+                    int64 length, Tensor* output) {
+  TensorShape output_shape = input.shape();
+  output_shape.set_dim(dim, length);
+  TF_RETURN_IF_ERROR(
+      context->allocate_temp(input.dtype(), output_shape, output));
+
+  int64 outer_size = 1;
+  for (int i = 0; i < dim; ++i) {
+    outer_size *= input.dim_size(i);
+  }
+  int64 inner_size = 1;
+  for (int i = dim + 1; i < input.dims(); ++i) {
+    inner_size *= input.dim_size(i);
+  }
+  auto input_reshaped =
+      input.shaped<T, 3>({outer_size, input.dim_size(dim), inner_size});
+  auto output_reshaped = output->shaped<T, 3>({outer_size, length, inner_size});
+  output_reshaped.setConstant(T());
+  Eigen::DSizes<Eigen::DenseIndex, 3> slice_indices(0, 0, 0);
+  Eigen::DSizes<Eigen::DenseIndex, 3> slice_sizes(
+      outer_size, input.dim_size(dim), inner_size);
+  output_reshaped.slice(slice_indices, slice_sizes) = input_reshaped;
+  return Status::OK();
+}
+
 // A class encapsulating the state and logic for batching tensors.
 class BatchResource : public ResourceBase {
  public:
   static Status Create(int32 num_batch_threads, int32 max_batch_size,
                        int32 batch_timeout_micros, int32 max_enqueued_batches,
                        const std::vector<int32>& allowed_batch_sizes,
-                       FunctionLibraryRuntime::Handle fhandle,
+                       const std::vector<int32>& bucket_boundaries,
+                       int32 bucket_dim, FunctionLibraryRuntime::Handle fhandle,
                        std::unique_ptr<BatchResource>* resource) {
     std::unique_ptr<BatchResource> new_resource(new BatchResource);
 
@@ -231,6 +262,9 @@ class BatchResource : public ResourceBase {
 
     new_resource->allowed_batch_sizes_ = allowed_batch_sizes;
 
+    new_resource->bucket_boundaries_ = bucket_boundaries;
+    new_resource->bucket_dim_ = bucket_dim;
+
     new_resource->fhandle_ = fhandle;
 
     *resource = std::move(new_resource);
@@ -274,9 +308,16 @@ class BatchResource : public ResourceBase {
     batch_components->context = context;
     batch_components->done_callback = std::move(done_callback);
 
+    string bucket_queue_name = batcher_queue_name;
+    if (!bucket_boundaries_.empty()) {
+      TF_RETURN_IF_ERROR(AssignBucket(batch_components.get()));
+      strings::StrAppend(&bucket_queue_name, "/bucket_",
+                         batch_components->bucket_length);
+    }
+
     BatcherQueue* batcher_queue;
     TF_RETURN_IF_ERROR(
-        LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+        LookupOrCreateBatcherQueue(bucket_queue_name, &batcher_queue));
     return batcher_queue->Schedule(&batch_components);
   }
 
@@ -295,6 +336,11 @@ class BatchResource : public ResourceBase {
     OpKernelContext* context;
     AsyncOpKernel::DoneCallback done_callback;
 
+    // The length to which the inputs are padded along the bucket dimension,
+    // or -1 if the length exceeds all bucket boundaries, in which case the
+    // inputs are padded to the longest in their batch.
+    int64 bucket_length = -1;
+
     size_t size() const override { return inputs[0].shape().dim_size(0); }
   };
 
@@ -317,6 +363,37 @@ class BatchResource : public ResourceBase {
     return Status::OK();
   }
 
+  // Returns the length of 'tensor' along the bucket dimension, or -1 if it
+  // does not have that dimension (and is therefore never padded).
+  int64 BucketDimSize(const Tensor& tensor) const {
+    return tensor.dims() > bucket_dim_ ? tensor.dim_size(bucket_dim_) : -1;
+  }
+
+  // Sets the bucket of 'task' to the smallest entry in 'bucket_boundaries_'
+  // that is greater than or equal to the longest of its inputs along the
+  // bucket dimension. Tasks of different buckets are batched in different
+  // queues, so that they are not padded to each other's lengths.
+  Status AssignBucket(BatchTask* task) const {
+    int64 length = -1;
+    for (const Tensor& tensor : task->inputs) {
+      length = std::max(length, BucketDimSize(tensor));
+    }
+    if (length < 0) {
+      return errors::InvalidArgument(
+          "Bucketed batching requires at least one input tensor with more "
+          "than ",
+          bucket_dim_, " dimensions");
+    }
+    task->bucket_length = -1;
+    for (int32 boundary : bucket_boundaries_) {
+      if (boundary >= length) {
+        task->bucket_length = boundary;
+        break;
+      }
+    }
+    return Status::OK();
+  }
+
   // Returns the smallest entry in 'allowed_batch_sizes_' that is greater than
   // or equal to 'batch_size'. If 'allowed_batch_sizes_' is empty, simply
   // returns 'batch_size'.
@@ -347,48 +424,66 @@ class BatchResource : public ResourceBase {
     const int num_inputs = batch.task(0).inputs.size();
     concatenated_tensors->reserve(num_inputs);
 
+    // With bucketing, all the tasks of a batch share a bucket, and are padded
+    // to its length (or to the longest task if they exceed all boundaries).
+    int64 bucket_length = -1;
+    if (!bucket_boundaries_.empty()) {
+      for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
+        const BatchTask& task = batch.task(task_idx);
+        bucket_length = std::max(bucket_length, task.bucket_length);
+        for (const Tensor& tensor : task.inputs) {
+          bucket_length = std::max(bucket_length, BucketDimSize(tensor));
+        }
+      }
+    }
+
     // Process each input one at a time (the typical case has just one).
     for (int i = 0; i < num_inputs; ++i) {
       // Concatenate the tasks ith input tensors into a big output tensor.
       std::vector<Tensor> to_concatenate;
       to_concatenate.reserve(batch.num_tasks());
       for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
-        to_concatenate.push_back(batch.task(task_idx).inputs.at(i));
+        const Tensor& input = batch.task(task_idx).inputs.at(i);
+        const int64 length = BucketDimSize(input);
+        if (length < 0 || length == bucket_length) {
+          to_concatenate.push_back(input);
+          continue;
+        }
+        Status pad_status;
+        Tensor padded;
+        switch (input.dtype()) {
+#define CASE(type)                                                       \
+  case DataTypeToEnum<type>::value:                                      \
+    pad_status = PadDimension<type>(context, input, bucket_dim_,         \
+                                    bucket_length, &padded);             \
+    break;
+          TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+          default:
+            pad_status = errors::InvalidArgument("Unsupported data type: ",
+                                                 input.dtype());
+            break;
+        }
+        TF_RETURN_IF_ERROR(pad_status);
+        to_concatenate.push_back(padded);
       }
 
       // Add padding as needed. Use the first row of the first task's tensor as
-      // the data for padding.
+      // the data for padding. (The first row starts at the start of the
+      // tensor's buffer, so it is as aligned as the tensor.)
       if (padding_amount > 0) {
-        const Tensor& padding_source = batch.task(0).inputs.at(i);
-        Tensor padding;
-        if (padding_source.shape().dim_size(0) == 1) {
-          padding = padding_source;
-        } else {
-          const std::vector<int64> slice_sizes = {1};
-          const DataType type = padding_source.dtype();
-          Status slice_status;
-          std::vector<Tensor> slices;
-          switch (type) {
-#define CASE(type)                                                     \
-  case DataTypeToEnum<type>::value:                                    \
-    slice_status =                                                     \
-        SplitCPU<type>(context, padding_source, slice_sizes, &slices); \
-    break;
-            TF_CALL_ALL_TYPES(CASE);
-#undef CASE
-            default:
-              slice_status =
-                  errors::InvalidArgument("Unsupported data type: ", type);
-              break;
-          }
-          TF_RETURN_IF_ERROR(slice_status);
-          padding = slices.at(0);
-        }
+        const Tensor padding = to_concatenate[0].Slice(0, 1);
         for (int i = 0; i < padding_amount; ++i) {
           to_concatenate.push_back(padding);
         }
       }
 
+      // A single tensor is passed through without copying.
+      if (to_concatenate.size() == 1) {
+        concatenated_tensors->push_back(to_concatenate[0]);
+        continue;
+      }
+
       const DataType type = to_concatenate[0].dtype();
       Status concat_status;
       Tensor concatenated_tensor;
@@ -430,15 +525,12 @@ class BatchResource : public ResourceBase {
       task_sizes_plus_optional_padding.push_back(padding_size);
     }
 
-    // For each output tensor name, a divided-up tensor with one entry per task.
-    std::map<string, std::vector<Tensor>> split_tensors;
-
     DCHECK_EQ(batch->task(0).context->num_outputs(), combined_outputs.size());
     if (combined_outputs.size() != batch->task(0).context->num_outputs()) {
       return errors::Internal("Wrong number of batched output tensors");
     }
 
-    // Generate 'split_tensors' and populate the context outputs.
+    // Populate the context outputs.
     for (int i = 0; i < combined_outputs.size(); ++i) {
       const Tensor& output_tensor = combined_outputs[i];
       if (output_tensor.shape().dims() == 0) {
@@ -451,27 +543,21 @@ class BatchResource : public ResourceBase {
             "the 0th dimension sizes of the input tensors");
       }
 
-      std::vector<Tensor> split_tensor;
-      const Status split_status = tensor::Split(
-          output_tensor, task_sizes_plus_optional_padding, &split_tensor);
-      DCHECK(split_status.ok()) << split_status.ToString();
-      if (!split_status.ok()) {
-        return errors::Internal("Tensor split operation failed: ",
-                                split_status.ToString());
-      }
-      DCHECK_EQ(split_tensor.size(), task_sizes_plus_optional_padding.size());
-      if (split_tensor.size() != task_sizes_plus_optional_padding.size()) {
-        return errors::Internal(
-            "Tensor split operation did not work as expected; got ",
-            split_tensor.size(), " splits; expected ",
-            task_sizes_plus_optional_padding.size());
-      }
-
+      // Each task's output is a slice of the batched output, which shares
+      // (and keeps alive) its buffer. Slices which are not aligned enough to
+      // be used by other kernels are copied. (The padding, if any, is
+      // dropped.)
+      int64 offset = 0;
       for (int j = 0; j < batch->num_tasks(); ++j) {
         BatchTask& task = *(batch->mutable_task(j));
-        task.context->set_output(i, split_tensor.at(j));
-      }  // (Ignore a possible final split_tensors entry containing the
-         // padding.)
+        const int64 task_size = task_sizes_plus_optional_padding[j];
+        Tensor split_tensor = output_tensor.Slice(offset, offset + task_size);
+        if (!split_tensor.IsAligned()) {
+          split_tensor = tensor::DeepCopy(split_tensor);
+        }
+        task.context->set_output(i, split_tensor);
+        offset += task_size;
+      }
     }
 
     return Status::OK();
@@ -698,6 +784,13 @@ class BatchResource : public ResourceBase {
       GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+
+  // Boundaries of the buckets along dimension 'bucket_dim_' of the inputs.
+  // Each bucket has its own queue, with the same options, and all the queues
+  // share the threads of 'batcher_'. Empty if bucketing is disabled.
+  std::vector<int32> bucket_boundaries_;
+  int32 bucket_dim_ = 0;
+
   FunctionLibraryRuntime::Handle fhandle_;
 };
 
@@ -720,6 +813,9 @@ class BatchFunctionKernel : public AsyncOpKernel {
                    c->GetAttr("max_enqueued_batches", &max_enqueued_batches_));
     OP_REQUIRES_OK(c, c->GetAttr("allowed_batch_sizes", &allowed_batch_sizes_));
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(c, c->GetAttr("bucket_boundaries", &bucket_boundaries_));
+    OP_REQUIRES_OK(c, c->GetAttr("bucket_dim", &bucket_dim_));
+    OP_REQUIRES_OK(c, ValidateBucketBoundaries());
 
     auto lib = c->function_library();
     OP_REQUIRES(c, lib != nullptr, errors::Internal("No function library"));
@@ -735,10 +831,10 @@ class BatchFunctionKernel : public AsyncOpKernel {
     BatchResource* br;
     std::function<Status(BatchResource**)> creator = [this](BatchResource** r) {
       std::unique_ptr<BatchResource> new_resource;
-      TF_RETURN_IF_ERROR(
-          BatchResource::Create(num_batch_threads_, max_batch_size_,
-                                batch_timeout_micros_, max_enqueued_batches_,
-                                allowed_batch_sizes_, fhandle_, &new_resource));
+      TF_RETURN_IF_ERROR(BatchResource::Create(
+          num_batch_threads_, max_batch_size_, batch_timeout_micros_,
+          max_enqueued_batches_, allowed_batch_sizes_, bucket_boundaries_,
+          bucket_dim_, fhandle_, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -775,6 +871,29 @@ class BatchFunctionKernel : public AsyncOpKernel {
     return Status::OK();
   }
 
+  // Validates 'bucket_boundaries_' and 'bucket_dim_'. The boundaries must be
+  // positive and increase monotonically, and the inputs are batched along
+  // dimension 0 so they can't be bucketed along it.
+  Status ValidateBucketBoundaries() const {
+    if (bucket_boundaries_.empty()) {
+      return Status::OK();
+    }
+    if (bucket_dim_ < 1) {
+      return errors::InvalidArgument("bucket_dim must be positive, got ",
+                                     bucket_dim_);
+    }
+    int32 last_boundary = 0;
+    for (const int32 boundary : bucket_boundaries_) {
+      if (boundary <= last_boundary) {
+        return errors::InvalidArgument(
+            "bucket_boundaries entries must be positive and monotonically "
+            "increasing");
+      }
+      last_boundary = boundary;
+    }
+    return Status::OK();
+  }
+
  private:
   string container_;
   string shared_name_;
@@ -784,6 +903,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
   int32 batch_timeout_micros_;
   int32 max_enqueued_batches_;
   std::vector<int32> allowed_batch_sizes_;
+  std::vector<int32> bucket_boundaries_;
+  int32 bucket_dim_;
   FunctionLibraryRuntime::Handle fhandle_;
 };
 
@@ -817,7 +938,8 @@ class BatchKernel : public AsyncOpKernel {
       std::unique_ptr<BatchResource> new_resource;
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
-          max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle,
+          max_enqueued_batches_, allowed_batch_sizes_,
+          /*bucket_boundaries=*/{}, /*bucket_dim=*/0, kInvalidHandle,
           &new_resource));
       *r = new_resource.release();
       return Status::OK();
@@ -23,6 +23,7 @@ limitations under the License.
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -248,6 +249,35 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
   }
 };
 
+// Like MatMul, bfloat16 batch matmuls are computed in float on the CPU: the
+// inputs are converted to float temporaries and the float result is converted
+// back. This is slower and uses more memory than the float kernel, since there
+// is no native bfloat16 contraction to call; it only exists so that graphs
+// rewritten to bfloat16 can run on the CPU.
+template <>
+struct LaunchBatchMatMul<CPUDevice, bfloat16> {
+  static void Launch(OpKernelContext* context, const Tensor& in_x,
+                     const Tensor& in_y, bool adj_x, bool adj_y,
+                     const MatMulBCast& bcast, Tensor* out) {
+    Tensor in_x_float, in_y_float, out_float;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_FLOAT, in_x.shape(),
+                                                   &in_x_float));
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_FLOAT, in_y.shape(),
+                                                   &in_y_float));
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_FLOAT, out->shape(),
+                                                   &out_float));
+    BFloat16ToFloat(in_x.flat<bfloat16>().data(),
+                    in_x_float.flat<float>().data(), in_x.NumElements());
+    BFloat16ToFloat(in_y.flat<bfloat16>().data(),
+                    in_y_float.flat<float>().data(), in_y.NumElements());
+    LaunchBatchMatMul<CPUDevice, float>::Launch(
+        context, in_x_float, in_y_float, adj_x, adj_y, bcast, &out_float);
+    if (!context->status().ok()) return;
+    FloatToBFloat16(out_float.flat<float>().data(),
+                    out->flat<bfloat16>().data(), out->NumElements());
+  }
+};
+
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 namespace {
@@ -24,6 +24,7 @@ namespace tensorflow {
 TF_CALL_float(REGISTER_BATCH_MATMUL_CPU);
 TF_CALL_double(REGISTER_BATCH_MATMUL_CPU);
 TF_CALL_half(REGISTER_BATCH_MATMUL_CPU);
+TF_CALL_bfloat16(REGISTER_BATCH_MATMUL_CPU);
 TF_CALL_int32(REGISTER_BATCH_MATMUL_CPU);
 TF_CALL_int64(REGISTER_BATCH_MATMUL_CPU);
 
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_ADAPTIVE_SHARED_BATCH_SCHEDULER_H_
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <functional>
 #include <memory>
 #include <random>
@@ -28,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
@@ -42,6 +45,8 @@ class ASBSBatch;
 
 template <typename TaskType>
 class ASBSQueue;
+
+class ASBSLatencyModel;
 }  // namespace internal
 
 // Shared batch scheduler designed to minimize latency. The scheduler keeps
@@ -69,6 +74,12 @@ class ASBSQueue;
 // CPU utilization - If the batch processing is cpu dominated, you can reap
 //   latency gains when underutilized by increasing the processing rate, but
 //   back the rate off when the load increases to avoid overload.
+//
+// Optionally, ASBS can also pick the batch size and timeout of each queue to
+// meet a target tail latency (see Options::target_p99_latency_micros). Each
+// queue then learns how its batch processing latency grows with batch size,
+// and uses the largest batches that leave enough of the latency target for
+// the batches to be formed, since larger batches give higher throughput.
 
 template <typename TaskType>
 class AdaptiveSharedBatchScheduler
@@ -112,6 +123,13 @@ class AdaptiveSharedBatchScheduler
     // numbers will give less noisy latency measurements, but will be less
     // responsive to changes in workload.
     int64 batches_to_average_over = 1000;
+    // If positive, the target 99th percentile latency of the requests, from
+    // the creation of their batch to the end of its processing. Each queue
+    // then limits its batch size and batch timeout (to at most the values of
+    // its QueueOptions) so as to maximize throughput under this target. The
+    // limits are updated every batches_to_average_over batches, and exported
+    // with monitoring gauges labeled with the QueueOptions::model_name.
+    int64 target_p99_latency_micros = 0;
   };
 
   // Ownership is shared between the caller of Create() and any queues created
@@ -129,6 +147,9 @@ class AdaptiveSharedBatchScheduler
     // A non-zero value can improve performance by limiting the scheduling of
     // nearly empty batches.
     int64 batch_timeout_micros = 0;
+    // Name of the model processing the batches of this queue, used to label
+    // the monitoring gauges if Options::target_p99_latency_micros is set.
+    string model_name;
   };
 
   using BatchProcessor = std::function<void(std::unique_ptr<Batch<TaskType>>)>;
@@ -226,6 +247,142 @@ class AdaptiveSharedBatchScheduler
 // Implementation details follow. API users need not read.
 
 namespace internal {
+// Learns the batch processing latency of a queue as a function of batch size,
+// and picks the batch size and timeout limits which maximize its throughput
+// under a target tail latency.
+//
+// The processing latency is fit as fixed_cost + per_item_cost * batch_size,
+// by least squares over exponentially decayed observations. Throughput
+// batch_size / latency then increases with batch size, so the largest batch
+// whose processing takes at most kProcessingLatencyFraction of the target is
+// used, and batches may wait to fill up for the rest of the target. As the
+// observed latencies also include queueing for the batch threads, the target
+// is scaled down whenever the observed p99 latency exceeds it.
+class ASBSLatencyModel {
+ public:
+  ASBSLatencyModel(const string& model_name, int64 target_latency_micros,
+                   int max_batch_size, int64 max_batch_timeout_micros,
+                   int64 batches_to_average_over)
+      : model_name_(model_name),
+        target_latency_micros_(target_latency_micros),
+        max_batch_size_(max_batch_size),
+        max_batch_timeout_micros_(max_batch_timeout_micros),
+        batches_to_average_over_(batches_to_average_over),
+        decay_(1.0 - 1.0 / batches_to_average_over),
+        batch_size_limit_(max_batch_size),
+        batch_timeout_micros_limit_(max_batch_timeout_micros) {}
+
+  // Current limits of the batches of the queue.
+  int batch_size_limit() const { return batch_size_limit_; }
+  int64 batch_timeout_micros_limit() const {
+    return batch_timeout_micros_limit_;
+  }
+
+  // Records a batch of 'batch_size' which took 'processing_micros' to process,
+  // and 'latency_micros' since its creation.
+  void RecordBatch(int64 batch_size, int64 processing_micros,
+                   int64 latency_micros) {
+    mutex_lock l(mu_);
+    const double size = batch_size;
+    const double processing = processing_micros;
+    weight_sum_ = weight_sum_ * decay_ + 1;
+    size_sum_ = size_sum_ * decay_ + size;
+    size_squares_sum_ = size_squares_sum_ * decay_ + size * size;
+    processing_sum_ = processing_sum_ * decay_ + processing;
+    size_processing_sum_ = size_processing_sum_ * decay_ + size * processing;
+    latencies_.push_back(latency_micros);
+    if (latencies_.size() >= batches_to_average_over_) {
+      UpdateLimits();
+      latencies_.clear();
+    }
+  }
+
+ private:
+  // Fraction of the target latency that batch processing may take.
+  static constexpr double kProcessingLatencyFraction = 0.5;
+
+  void UpdateLimits() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const size_t p99_index = latencies_.size() * 99 / 100;
+    std::nth_element(latencies_.begin(), latencies_.begin() + p99_index,
+                     latencies_.end());
+    const int64 p99_latency_micros = latencies_[p99_index];
+    if (p99_latency_micros > target_latency_micros_) {
+      target_scale_ = std::max(0.1, target_scale_ * 0.8);
+    } else if (p99_latency_micros < 0.8 * target_latency_micros_) {
+      target_scale_ = std::min(1.0, target_scale_ * 1.05);
+    }
+
+    // Least squares fit of the processing latency. If a single batch size
+    // was observed, conservatively assume there is no fixed cost.
+    double fixed_cost = 0;
+    double per_item_cost = 0;
+    const double variance =
+        weight_sum_ * size_squares_sum_ - size_sum_ * size_sum_;
+    if (variance > 1e-6 * weight_sum_ * size_squares_sum_) {
+      per_item_cost =
+          (weight_sum_ * size_processing_sum_ - size_sum_ * processing_sum_) /
+          variance;
+      fixed_cost = (processing_sum_ - per_item_cost * size_sum_) / weight_sum_;
+    } else if (size_sum_ > 0) {
+      per_item_cost = processing_sum_ / size_sum_;
+    } else {
+      fixed_cost = processing_sum_ / weight_sum_;
+    }
+
+    const double target = target_latency_micros_ * target_scale_;
+    int batch_size = max_batch_size_;
+    if (per_item_cost > 0) {
+      const double size =
+          std::floor((target * kProcessingLatencyFraction - fixed_cost) /
+                     per_item_cost);
+      batch_size = static_cast<int>(
+          std::max(1.0, std::min<double>(max_batch_size_, size)));
+    }
+    const double processing = fixed_cost + per_item_cost * batch_size;
+    const int64 batch_timeout_micros = static_cast<int64>(std::max(
+        0.0, std::min<double>(max_batch_timeout_micros_, target - processing)));
+    batch_size_limit_ = batch_size;
+    batch_timeout_micros_limit_ = batch_timeout_micros;
+
+    static auto* batch_size_gauge = monitoring::Gauge<int64, 1>::New(
+        "/tensorflow/serving/batching/adaptive_batch_size",
+        "Batch size limit picked to meet the target latency.", "model_name");
+    static auto* batch_timeout_gauge = monitoring::Gauge<int64, 1>::New(
+        "/tensorflow/serving/batching/adaptive_batch_timeout_micros",
+        "Batch timeout picked to meet the target latency.", "model_name");
+    static auto* p99_latency_gauge = monitoring::Gauge<int64, 1>::New(
+        "/tensorflow/serving/batching/batch_p99_latency_micros",
+        "Observed p99 latency of the batches.", "model_name");
+    batch_size_gauge->GetCell(model_name_)->Set(batch_size);
+    batch_timeout_gauge->GetCell(model_name_)->Set(batch_timeout_micros);
+    p99_latency_gauge->GetCell(model_name_)->Set(p99_latency_micros);
+  }
+
+  const string model_name_;
+  const int64 target_latency_micros_;
+  const int max_batch_size_;
+  const int64 max_batch_timeout_micros_;
+  const size_t batches_to_average_over_;
+  const double decay_;
+
+  std::atomic<int> batch_size_limit_;
+  std::atomic<int64> batch_timeout_micros_limit_;
+
+  mutex mu_;
+  // Decayed sums of the observations of (batch size, processing latency).
+  double weight_sum_ GUARDED_BY(mu_) = 0;
+  double size_sum_ GUARDED_BY(mu_) = 0;
+  double size_squares_sum_ GUARDED_BY(mu_) = 0;
+  double processing_sum_ GUARDED_BY(mu_) = 0;
+  double size_processing_sum_ GUARDED_BY(mu_) = 0;
+  // Latencies of the batches since the last update of the limits.
+  std::vector<int64> latencies_ GUARDED_BY(mu_);
+  // Scale applied to the target latency, lowered while it is exceeded.
+  double target_scale_ GUARDED_BY(mu_) = 1.0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ASBSLatencyModel);
+};
+
 // Consolidates tasks into batches, passing them off to the
 // AdaptiveSharedBatchScheduler for processing.
 template <typename TaskType>
@@ -259,6 +416,8 @@ class ASBSQueue : public BatchScheduler<TaskType> {
  private:
   std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler_;
   const QueueOptions options_;
+  // Null unless the scheduler has a latency target.
+  std::shared_ptr<ASBSLatencyModel> latency_model_;
   // Owned by scheduler_.
   ASBSBatch<TaskType>* current_batch_ GUARDED_BY(mu_) = nullptr;
   int64 num_enqueued_batches_ GUARDED_BY(mu_) = 0;
@@ -272,10 +431,12 @@ template <typename TaskType>
 class ASBSBatch : public Batch<TaskType> {
  public:
   ASBSBatch(ASBSQueue<TaskType>* queue, int64 creation_time_micros,
-            int64 batch_timeout_micros)
+            int64 batch_timeout_micros,
+            std::shared_ptr<ASBSLatencyModel> latency_model)
       : queue_(queue),
         creation_time_micros_(creation_time_micros),
-        schedulable_time_micros_(creation_time_micros + batch_timeout_micros) {}
+        schedulable_time_micros_(creation_time_micros + batch_timeout_micros),
+        latency_model_(std::move(latency_model)) {}
 
   ~ASBSBatch() override {}
 
@@ -285,10 +446,17 @@ class ASBSBatch : public Batch<TaskType> {
 
   int64 schedulable_time_micros() const { return schedulable_time_micros_; }
 
+  // The latency model of the queue, which may outlive the queue itself. Null
+  // unless the scheduler has a latency target.
+  const std::shared_ptr<ASBSLatencyModel>& latency_model() const {
+    return latency_model_;
+  }
+
  private:
   ASBSQueue<TaskType>* queue_;
   const int64 creation_time_micros_;
   const int64 schedulable_time_micros_;
+  const std::shared_ptr<ASBSLatencyModel> latency_model_;
   TF_DISALLOW_COPY_AND_ASSIGN(ASBSBatch);
 };
 }  // namespace internal
@@ -344,6 +512,11 @@ Status AdaptiveSharedBatchScheduler<TaskType>::Create(
         "greater than or equal to 1; was ",
         options.batches_to_average_over);
   }
+  if (options.target_p99_latency_micros < 0) {
+    return errors::InvalidArgument(
+        "target_p99_latency_micros can't be negative; was ",
+        options.target_p99_latency_micros);
+  }
   scheduler->reset(new AdaptiveSharedBatchScheduler<TaskType>(options));
   return Status::OK();
 }
@@ -467,9 +640,17 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
     AdaptiveSharedBatchScheduler<TaskType>::BatchProcessor callback,
     bool is_express) {
   int64 start_time = batch->creation_time_micros();
+  const int64 processing_start_time = GetEnv()->NowMicros();
+  const int64 batch_size = batch->size();
+  const std::shared_ptr<internal::ASBSLatencyModel> latency_model =
+      batch->latency_model();
   callback(std::unique_ptr<Batch<TaskType>>(
       const_cast<internal::ASBSBatch<TaskType>*>(batch)));
   int64 end_time = GetEnv()->NowMicros();
+  if (latency_model != nullptr) {
+    latency_model->RecordBatch(batch_size, end_time - processing_start_time,
+                               end_time - start_time);
+  }
   mutex_lock l(mu_);
   if (is_express) {
     in_flight_express_batches_--;
@@ -525,7 +706,14 @@ template <typename TaskType>
 ASBSQueue<TaskType>::ASBSQueue(
     std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler,
     const QueueOptions& options)
-    : scheduler_(scheduler), options_(options) {}
+    : scheduler_(scheduler), options_(options) {
+  if (scheduler_->options_.target_p99_latency_micros > 0) {
+    latency_model_ = std::make_shared<ASBSLatencyModel>(
+        options_.model_name, scheduler_->options_.target_p99_latency_micros,
+        options_.max_batch_size, options_.batch_timeout_micros,
+        scheduler_->options_.batches_to_average_over);
+  }
+}
 
 template <typename TaskType>
 ASBSQueue<TaskType>::~ASBSQueue() {
@@ -552,12 +740,14 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
                                    " is larger than maximum batch size ",
                                    options_.max_batch_size);
   }
+  const int max_batch_size = latency_model_
+                                 ? latency_model_->batch_size_limit()
+                                 : options_.max_batch_size;
   bool is_old_batch_closed = false;
   {
     mutex_lock l(mu_);
     // Current batch is full, create another if allowed.
-    if (current_batch_ &&
-        current_batch_->size() + size > options_.max_batch_size) {
+    if (current_batch_ && current_batch_->size() + size > max_batch_size) {
       if (num_enqueued_batches_ >= options_.max_enqueued_batches) {
         return errors::Unavailable("The batch scheduling queue is full");
       }
@@ -567,9 +757,11 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
     }
     if (!current_batch_) {
       num_enqueued_batches_++;
-      current_batch_ = new_batch =
-          new ASBSBatch<TaskType>(this, scheduler_->GetEnv()->NowMicros(),
-                                  options_.batch_timeout_micros);
+      current_batch_ = new_batch = new ASBSBatch<TaskType>(
+          this, scheduler_->GetEnv()->NowMicros(),
+          latency_model_ ? latency_model_->batch_timeout_micros_limit()
+                         : options_.batch_timeout_micros,
+          latency_model_);
     }
     current_batch_->AddTask(std::move(*task));
     num_enqueued_tasks_++;
@@ -92,6 +92,9 @@ TEST(AdaptiveSharedBatchSchedulerTest, BadOptions) {
   options.min_in_flight_batches_limit = 2;
   options.num_batch_threads = 3;
   EXPECT_FALSE(Scheduler::Create(options, &scheduler).ok());
+  options = Scheduler::Options();
+  options.target_p99_latency_micros = -1;
+  EXPECT_FALSE(Scheduler::Create(options, &scheduler).ok());
 }
 
 TEST(AdaptiveSharedBatchSchedulerTest, InFlightBatchesLimit) {
@@ -381,6 +384,31 @@ TEST(AdaptiveSharedBatchSchedulerTest, QueueCapacityInfo) {
   EXPECT_EQ(queue->SchedulingCapacity(), 8 * 1000 + 300);
   finish_processing.Notify();
 }
+
+TEST(AdaptiveSharedBatchSchedulerTest, LatencyModel) {
+  internal::ASBSLatencyModel model("model", /*target_latency_micros=*/1000,
+                                   /*max_batch_size=*/256,
+                                   /*max_batch_timeout_micros=*/800,
+                                   /*batches_to_average_over=*/10);
+  EXPECT_EQ(model.batch_size_limit(), 256);
+  EXPECT_EQ(model.batch_timeout_micros_limit(), 800);
+
+  // Processing takes 100 + 10 * size micros, so batches of 40 take half of the
+  // target, and may wait for the other half.
+  for (int i = 0; i < 10; ++i) {
+    const int size = 1 + 3 * i;
+    model.RecordBatch(size, 100 + 10 * size, 300 + 10 * size);
+  }
+  EXPECT_EQ(model.batch_size_limit(), 40);
+  EXPECT_EQ(model.batch_timeout_micros_limit(), 500);
+
+  // Missing the target shrinks the batches and the timeout.
+  for (int i = 0; i < 10; ++i) {
+    model.RecordBatch(40, 500, 2000);
+  }
+  EXPECT_LT(model.batch_size_limit(), 40);
+  EXPECT_LT(model.batch_timeout_micros_limit(), 500);
+}
 }  // namespace anonymous
 }  // namespace serving
 }  // namespace tensorflow
@@ -219,42 +219,45 @@ class BoostedTreesPredictOp : public OpKernel {
                                 &output_logits_t));
     auto output_logits = output_logits_t->matrix<float>();
 
+    const std::shared_ptr<const BoostedTreesFlatEnsemble> ensemble =
+        resource->GetFlatEnsemble();
+    const int32 num_trees = ensemble->roots.size();
+
     // Return zero logits if it's an empty ensemble.
-    if (resource->num_trees() <= 0) {
+    if (num_trees <= 0) {
       output_logits.setZero();
       return;
     }
 
-    const int32 last_tree = resource->num_trees() - 1;
-    auto do_work = [&resource, &batch_bucketized_features, &output_logits,
-                    last_tree, this](int32 start, int32 end) {
-      for (int32 i = start; i < end; ++i) {
-        std::vector<float> tree_logits(logits_dimension_, 0.0);
-        int32 tree_id = 0;
-        int32 node_id = 0;
-        while (true) {
-          if (resource->is_leaf(tree_id, node_id)) {
-            const float tree_weight = resource->GetTreeWeight(tree_id);
-            const auto& leaf_logits = resource->node_value(tree_id, node_id);
-            DCHECK_EQ(leaf_logits.size(), logits_dimension_);
+    const int32 last_tree = num_trees - 1;
+    auto do_work = [&ensemble, &batch_bucketized_features, &output_logits,
+                    num_trees, this](int32 start, int32 end) {
+      // Examples are scored a block at a time, one tree after another, so
+      // that the nodes of a tree stay in cache while the block goes through
+      // it. Every example still adds up its trees in order.
+      const int32 kBlockSize = 64;
+      for (int32 block_start = start; block_start < end;
+           block_start += kBlockSize) {
+        const int32 block_end = std::min(block_start + kBlockSize, end);
+        for (int32 i = block_start; i < block_end; ++i) {
+          for (int32 j = 0; j < logits_dimension_; ++j) {
+            output_logits(i, j) = 0;
+          }
+        }
+        for (int32 tree_id = 0; tree_id < num_trees; ++tree_id) {
+          const float tree_weight = ensemble->tree_weights[tree_id];
+          for (int32 i = block_start; i < block_end; ++i) {
+            const int32 leaf_id =
+                ensemble->FindLeaf(tree_id, i, batch_bucketized_features);
+            const int32 value_start = ensemble->value_starts[leaf_id];
+            DCHECK_EQ(ensemble->value_starts[leaf_id + 1] - value_start,
+                      logits_dimension_);
+            const float* leaf_logits = &ensemble->leaf_values[value_start];
             for (int32 j = 0; j < logits_dimension_; ++j) {
-              tree_logits[j] += tree_weight * leaf_logits[j];
+              output_logits(i, j) += tree_weight * leaf_logits[j];
             }
-            // Stop if it was the last tree.
-            if (tree_id == last_tree) {
-              break;
-            }
-            // Move onto other trees.
-            ++tree_id;
-            node_id = 0;
-          } else {
-            node_id = resource->next_node(tree_id, node_id, i,
-                                          batch_bucketized_features);
           }
         }
-        for (int32 j = 0; j < logits_dimension_; ++j) {
-          output_logits(i, j) = tree_logits[j];
-        }
       }
     };
     // 10 is the magic number. The actual number might depend on (the number of
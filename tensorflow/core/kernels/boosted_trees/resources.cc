@@ -35,6 +35,7 @@ string BoostedTreesEnsembleResource::DebugString() const {
 bool BoostedTreesEnsembleResource::InitFromSerialized(const string& serialized,
                                                       const int64 stamp_token) {
   CHECK_EQ(stamp(), -1) << "Must Reset before Init.";
+  InvalidateFlatEnsemble();
   if (ParseProtoUnlimited(tree_ensemble_, serialized)) {
     set_stamp(stamp_token);
     return true;
@@ -50,6 +51,86 @@ int32 BoostedTreesEnsembleResource::num_trees() const {
   return tree_ensemble_->trees_size();
 }
 
+std::shared_ptr<const BoostedTreesFlatEnsemble>
+BoostedTreesEnsembleResource::GetFlatEnsemble() {
+  mutex_lock l(flat_mu_);
+  if (flat_ensemble_ != nullptr) {
+    return flat_ensemble_;
+  }
+  auto flat = std::make_shared<BoostedTreesFlatEnsemble>();
+  int64 num_nodes = 0;
+  for (const auto& tree : tree_ensemble_->trees()) {
+    num_nodes += tree.nodes_size();
+  }
+  flat->roots.reserve(tree_ensemble_->trees_size());
+  flat->tree_weights.reserve(tree_ensemble_->trees_size());
+  flat->feature_ids.reserve(num_nodes);
+  flat->thresholds.reserve(num_nodes);
+  flat->is_categorical.reserve(num_nodes);
+  flat->left_ids.reserve(num_nodes);
+  flat->right_ids.reserve(num_nodes);
+  flat->value_starts.reserve(num_nodes + 1);
+  flat->value_starts.push_back(0);
+
+  for (int32 tree_id = 0; tree_id < tree_ensemble_->trees_size(); ++tree_id) {
+    const int32 root = flat->feature_ids.size();
+    flat->roots.push_back(root);
+    flat->tree_weights.push_back(tree_ensemble_->tree_weights(tree_id));
+    for (const auto& node : tree_ensemble_->trees(tree_id).nodes()) {
+      int32 feature_id = -1;
+      int32 threshold = 0;
+      bool is_categorical = false;
+      int32 left_id = -1;
+      int32 right_id = -1;
+      switch (node.node_case()) {
+        case boosted_trees::Node::kBucketizedSplit: {
+          const auto& split = node.bucketized_split();
+          feature_id = split.feature_id();
+          threshold = split.threshold();
+          left_id = root + split.left_id();
+          right_id = root + split.right_id();
+          break;
+        }
+        case boosted_trees::Node::kCategoricalSplit: {
+          const auto& split = node.categorical_split();
+          feature_id = split.feature_id();
+          threshold = split.value();
+          is_categorical = true;
+          left_id = root + split.left_id();
+          right_id = root + split.right_id();
+          break;
+        }
+        case boosted_trees::Node::kLeaf: {
+          if (node.leaf().has_vector()) {
+            const auto& values = node.leaf().vector().value();
+            flat->leaf_values.insert(flat->leaf_values.end(), values.begin(),
+                                     values.end());
+          } else {
+            flat->leaf_values.push_back(node.leaf().scalar());
+          }
+          break;
+        }
+        default:
+          DCHECK(false) << "Node type " << node.node_case()
+                        << " not supported.";
+      }
+      flat->feature_ids.push_back(feature_id);
+      flat->thresholds.push_back(threshold);
+      flat->is_categorical.push_back(is_categorical);
+      flat->left_ids.push_back(left_id);
+      flat->right_ids.push_back(right_id);
+      flat->value_starts.push_back(flat->leaf_values.size());
+    }
+  }
+  flat_ensemble_ = std::move(flat);
+  return flat_ensemble_;
+}
+
+void BoostedTreesEnsembleResource::InvalidateFlatEnsemble() {
+  mutex_lock l(flat_mu_);
+  flat_ensemble_.reset();
+}
+
 int32 BoostedTreesEnsembleResource::next_node(
     const int32 tree_id, const int32 node_id, const int32 index_in_batch,
     const std::vector<TTypes<int32>::ConstVec>& bucketized_features) const {
@@ -122,6 +203,7 @@ void BoostedTreesEnsembleResource::set_node_value(const int32 tree_id,
   auto* node = tree_ensemble_->mutable_trees(tree_id)->mutable_nodes(node_id);
   DCHECK(node->node_case() == boosted_trees::Node::kLeaf);
   node->mutable_leaf()->set_scalar(logits);
+  InvalidateFlatEnsemble();
 }
 
 int32 BoostedTreesEnsembleResource::GetNumLayersGrown(
@@ -231,6 +313,7 @@ void BoostedTreesEnsembleResource::SetTreeWeight(const int32 tree_id,
   DCHECK_GE(tree_id, 0);
   DCHECK_LT(tree_id, num_trees());
   tree_ensemble_->set_tree_weights(tree_id, weight);
+  InvalidateFlatEnsemble();
 }
 
 void BoostedTreesEnsembleResource::UpdateGrowingMetadata() const {
@@ -260,6 +343,7 @@ int32 BoostedTreesEnsembleResource::AddNewTreeWithLogits(const float weight,
   node->mutable_leaf()->set_scalar(logits);
   tree_ensemble_->add_tree_weights(weight);
   tree_ensemble_->add_tree_metadata();
+  InvalidateFlatEnsemble();
 
   return new_tree_id;
 }
@@ -290,6 +374,7 @@ void BoostedTreesEnsembleResource::AddBucketizedSplitNode(
   // TODO(npononareva): this is LAYER-BY-LAYER boosting; add WHOLE-TREE.
   left_node->mutable_leaf()->set_scalar(prev_node_value + left_contrib);
   right_node->mutable_leaf()->set_scalar(prev_node_value + right_contrib);
+  InvalidateFlatEnsemble();
 }
 
 void BoostedTreesEnsembleResource::Reset() {
@@ -301,6 +386,7 @@ void BoostedTreesEnsembleResource::Reset() {
   CHECK_EQ(0, arena_.SpaceAllocated());
   tree_ensemble_ =
       protobuf::Arena::CreateMessage<boosted_trees::TreeEnsemble>(&arena_);
+  InvalidateFlatEnsemble();
 }
 
 void BoostedTreesEnsembleResource::PostPruneTree(const int32 current_tree,
@@ -399,6 +485,7 @@ void BoostedTreesEnsembleResource::PostPruneTree(const int32 current_tree,
   }
   // Replace all the nodes in a tree with the ones we keep.
   *tree->mutable_nodes() = std::move(new_nodes);
+  InvalidateFlatEnsemble();
 
   // Note that if the whole tree got pruned, we will end up with one node.
   // We can't remove that tree because it will cause problems with cache.
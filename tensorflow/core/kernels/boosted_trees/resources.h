@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 #define TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -43,6 +46,47 @@ class StampedResource : public ResourceBase {
   int64 stamp_;
 };
 
+// The trees of an ensemble flattened into arrays indexed by node, so that
+// inference reads a few contiguous arrays instead of chasing node protos.
+// The nodes of each tree are stored consecutively, and the child ids of splits
+// are indices into the arrays.
+struct BoostedTreesFlatEnsemble {
+  // The index of the root node of each tree.
+  std::vector<int32> roots;
+  std::vector<float> tree_weights;
+
+  // The split feature of each node, or -1 for leaves.
+  std::vector<int32> feature_ids;
+  // The bucket threshold of bucketized splits, or the value of categorical
+  // splits.
+  std::vector<int32> thresholds;
+  std::vector<uint8> is_categorical;
+  std::vector<int32> left_ids;
+  std::vector<int32> right_ids;
+
+  // The values of node n are leaf_values[value_starts[n], value_starts[n+1]).
+  // Only leaves have values.
+  std::vector<int32> value_starts;
+  std::vector<float> leaf_values;
+
+  // Returns the index of the leaf of tree `tree_id` that the example at
+  // `index_in_batch` of `bucketized_features` ends up in.
+  int32 FindLeaf(
+      const int32 tree_id, const int32 index_in_batch,
+      const std::vector<TTypes<int32>::ConstVec>& bucketized_features) const {
+    int32 node_id = roots[tree_id];
+    while (feature_ids[node_id] >= 0) {
+      const int32 value =
+          bucketized_features[feature_ids[node_id]](index_in_batch);
+      const bool go_left = is_categorical[node_id]
+                               ? value == thresholds[node_id]
+                               : value <= thresholds[node_id];
+      node_id = go_left ? left_ids[node_id] : right_ids[node_id];
+    }
+    return node_id;
+  }
+};
+
 // Keep a tree ensemble in memory for efficient evaluation and mutation.
 class BoostedTreesEnsembleResource : public StampedResource {
  public:
@@ -143,7 +187,15 @@ class BoostedTreesEnsembleResource : public StampedResource {
                               std::vector<float>* logit_updates) const;
   mutex* get_mutex() { return &mu_; }
 
+  // Returns the trees flattened for inference. They are flattened on first
+  // use after each change to the trees.
+  std::shared_ptr<const BoostedTreesFlatEnsemble> GetFlatEnsemble();
+
  private:
+  // Drops the flattened trees. Must be called by every method that changes
+  // the trees or their weights.
+  void InvalidateFlatEnsemble();
+
   // Helper method to check whether a node is a terminal node in that it
   // only has leaf nodes as children.
   bool IsTerminalSplitNode(const int32 tree_id, const int32 node_id) const;
@@ -166,6 +218,11 @@ class BoostedTreesEnsembleResource : public StampedResource {
   protobuf::Arena arena_;
   mutex mu_;
   boosted_trees::TreeEnsemble* tree_ensemble_;
+
+ private:
+  mutex flat_mu_;
+  std::shared_ptr<const BoostedTreesFlatEnsemble> flat_ensemble_
+      GUARDED_BY(flat_mu_);
 };
 
 }  // namespace tensorflow
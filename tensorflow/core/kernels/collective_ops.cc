@@ -166,6 +166,15 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
                     final_op_name));
     OP_REQUIRES_OK(c, c->GetAttr("T", &col_params_.instance.data_type));
     OP_REQUIRES_OK(c, c->GetAttr("wait_for", &dependencies_));
+    string wire_codec;
+    OP_REQUIRES_OK(c, c->GetAttr("wire_codec", &wire_codec));
+    if (wire_codec == "bf16") {
+      OP_REQUIRES(c, col_params_.instance.data_type == DT_FLOAT,
+                  errors::InvalidArgument(
+                      "wire_codec bf16 requires T=float but got ",
+                      DataTypeString(col_params_.instance.data_type)));
+      col_params_.instance.wire_data_type = DT_BFLOAT16;
+    }
 
     const NodeDef& real_node = c->def();
     col_params_.name = strings::StrCat(real_node.name(), ": Reduce(",
@@ -182,6 +191,24 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
                  &(*sub_node.mutable_attr())["T"]);
     col_params_.merge_op = BuildOpKernel(c, merge_op_name, &sub_node);
     col_params_.final_op = BuildOpKernel(c, final_op_name, &sub_node);
+
+    // The codec casts values to and from the wire type.
+    if (col_params_.instance.wire_data_type != DT_INVALID) {
+      NodeDef cast_node;
+      cast_node.add_input(real_node.input(0));
+      cast_node.set_device(real_node.device());
+      SetAttrValue(false, &(*cast_node.mutable_attr())["Truncate"]);
+      SetAttrValue(col_params_.instance.data_type,
+                   &(*cast_node.mutable_attr())["SrcT"]);
+      SetAttrValue(col_params_.instance.wire_data_type,
+                   &(*cast_node.mutable_attr())["DstT"]);
+      col_params_.encode_op = BuildOpKernel(c, "Cast", &cast_node);
+      SetAttrValue(col_params_.instance.wire_data_type,
+                   &(*cast_node.mutable_attr())["SrcT"]);
+      SetAttrValue(col_params_.instance.data_type,
+                   &(*cast_node.mutable_attr())["DstT"]);
+      col_params_.decode_op = BuildOpKernel(c, "Cast", &cast_node);
+    }
   }
 
   std::unique_ptr<OpKernel> BuildOpKernel(OpKernelConstruction* c,
@@ -32,6 +32,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/numeric_op.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -177,6 +178,39 @@ struct LaunchConv2DOp<CPUDevice, T> {
   }
 };
 
+// Like MatMul, bfloat16 convolutions are computed in float on the CPU: the
+// input and filter are converted to float temporaries and the float output is
+// converted back. This is slower and uses more memory than the float kernel;
+// it only exists so that graphs rewritten to bfloat16 can run on the CPU.
+template <>
+struct LaunchConv2DOp<CPUDevice, bfloat16> {
+  void operator()(OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+                  const Tensor& input, const Tensor& filter, int row_dilation,
+                  int col_dilation, int row_stride, int col_stride,
+                  const Padding& padding,
+                  const std::vector<int64>& explicit_paddings, Tensor* output,
+                  TensorFormat data_format) {
+    Tensor input_float, filter_float, output_float;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(DT_FLOAT, input.shape(), &input_float));
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(DT_FLOAT, filter.shape(), &filter_float));
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(DT_FLOAT, output->shape(), &output_float));
+    BFloat16ToFloat(input.flat<bfloat16>().data(),
+                    input_float.flat<float>().data(), input.NumElements());
+    BFloat16ToFloat(filter.flat<bfloat16>().data(),
+                    filter_float.flat<float>().data(), filter.NumElements());
+    LaunchConv2DOp<CPUDevice, float>()(
+        ctx, use_cudnn, cudnn_use_autotune, input_float, filter_float,
+        row_dilation, col_dilation, row_stride, col_stride, padding,
+        explicit_paddings, &output_float, data_format);
+    if (!ctx->status().ok()) return;
+    FloatToBFloat16(output_float.flat<float>().data(),
+                    output->flat<bfloat16>().data(), output->NumElements());
+  }
+};
+
 template <typename Device, typename T>
 class LaunchDeepConvOp {
  public:
@@ -570,6 +604,7 @@ class Conv2DOp : public BinaryOp<T> {
 TF_CALL_half(REGISTER_CPU);
 TF_CALL_float(REGISTER_CPU);
 TF_CALL_double(REGISTER_CPU);
+TF_CALL_bfloat16(REGISTER_CPU);
 #endif  // USE_GEMM_FOR_CONV
 
 // To be used inside depthwise_conv_op.cc.
@@ -682,8 +682,28 @@ Status ExtractForwardInput(OpKernelContext* context,
                            const Tensor** sequence_lengths, const int num_proj,
                            CudnnRnnModelShapes* model_shapes) {
   TF_RETURN_IF_ERROR(context->input("sequence_lengths", sequence_lengths));
-  return ExtractForwardInput(context, model_types, time_major, input, input_h,
-                             input_c, params, num_proj, model_shapes);
+  TF_RETURN_IF_ERROR(ExtractForwardInput(context, model_types, time_major,
+                                         input, input_h, input_c, params,
+                                         num_proj, model_shapes));
+  // The descriptors read batch_size lengths from the host, so check them
+  // before cuDNN sees a short vector or a length outside the input.
+  if (!TensorShapeUtils::IsVector((*sequence_lengths)->shape()) ||
+      (*sequence_lengths)->dim_size(0) != model_shapes->batch_size) {
+    return errors::InvalidArgument(
+        "sequence_lengths must be a vector of the batch size ",
+        model_shapes->batch_size, ", got shape: ",
+        (*sequence_lengths)->shape().DebugString());
+  }
+  const auto lengths = (*sequence_lengths)->vec<int>();
+  for (int64 i = 0; i < model_shapes->batch_size; ++i) {
+    if (lengths(i) <= 0 || lengths(i) > model_shapes->max_seq_length) {
+      return errors::InvalidArgument(
+          "sequence_lengths[", i, "] = ", lengths(i),
+          " is not in (0, max_seq_length = ", model_shapes->max_seq_length,
+          "]");
+    }
+  }
+  return Status::OK();
 }
 
 template <typename T>
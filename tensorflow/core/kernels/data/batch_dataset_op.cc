@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/batch_dataset_op.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -39,6 +41,9 @@ namespace data {
 
 constexpr char kInputImplEmpty[] = "input_impl_empty";
 constexpr char kBatchDataset[] = "BatchDataset";
+// The most bytes that are preallocated for a batch before any of its elements
+// have been produced. Larger batches grow geometrically as elements arrive.
+constexpr int64 kMaxInitialBatchBytes = 16 << 20;
 
 class BatchDatasetOp::Dataset : public DatasetBase {
  public:
@@ -66,6 +71,20 @@ class BatchDatasetOp::Dataset : public DatasetBase {
             PartialTensorShape({-1}).Concatenate(input_shape));
       }
     }
+
+    // If every component has a static shape and a type that can be copied
+    // with `memcpy`, the batch can be allocated before its elements are
+    // produced, and the input can write each element into its row directly.
+    preallocate_ = !parallel_copy_;
+    for (size_t i = 0; i < input_shapes.size(); ++i) {
+      if (!input_shapes[i].IsFullyDefined() ||
+          !DataTypeCanUseMemcpy(input_->output_dtypes()[i])) {
+        preallocate_ = false;
+        break;
+      }
+      element_bytes_ += input_shapes[i].num_elements() *
+                        DataTypeSize(input_->output_dtypes()[i]);
+    }
   }
 
   ~Dataset() override { input_->Unref(); }
@@ -132,6 +151,9 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (dataset()->preallocate_) {
+        return GetNextPreallocated(ctx, out_tensors, end_of_sequence);
+      }
       // Each row of `batch_elements` is a tuple of tensors from the
       // input iterator.
       std::vector<std::vector<Tensor>> batch_elements;
@@ -266,6 +288,145 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Produces a batch of fixed-shape elements. The output tensors are
+    // allocated up front and offered to the input iterator one row at a time
+    // through a `BatchSlot`, so that an input which supports it (e.g. map)
+    // writes each element into the batch as soon as it is computed, instead of
+    // this iterator holding `batch_size` elements and copying them afterwards.
+    Status GetNextPreallocated(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) {
+      mutex_lock l(mu_);
+      if (!input_impl_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      // Do not allocate more rows than the input can produce, and start
+      // with a bounded number of bytes: `batch_size` may be much larger than
+      // the number of elements that actually arrive.
+      int64 capacity = dataset()->batch_size_;
+      const int64 cardinality = dataset()->input_->Cardinality();
+      if (cardinality >= 0) {
+        capacity = std::min(capacity, std::max<int64>(cardinality, 1));
+      }
+      if (dataset()->element_bytes_ > 0) {
+        capacity = std::min(
+            capacity,
+            std::max<int64>(kMaxInitialBatchBytes / dataset()->element_bytes_,
+                            1));
+      }
+      std::vector<Tensor> batch;
+      TF_RETURN_IF_ERROR(AllocateBatch(ctx, capacity, 0, &batch));
+
+      auto slot = std::make_shared<BatchSlot>();
+      slot->producer = input_impl_->prefix();
+      slot->batch = &batch;
+      auto cleanup = gtl::MakeCleanup([&slot] { slot->batch = nullptr; });
+      IteratorContext::Params params(ctx);
+      params.batch_slot = slot;
+      IteratorContext input_ctx(std::move(params));
+
+      int64 num_batch_elements = 0;
+      *end_of_sequence = false;
+      while (num_batch_elements < dataset()->batch_size_) {
+        if (num_batch_elements == capacity) {
+          capacity = std::min(capacity * 2, dataset()->batch_size_);
+          TF_RETURN_IF_ERROR(
+              AllocateBatch(ctx, capacity, num_batch_elements, &batch));
+        }
+        slot->index = num_batch_elements;
+        slot->filled = false;
+        std::vector<Tensor> batch_element_tuple;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(
+            &input_ctx, &batch_element_tuple, end_of_sequence));
+        if (*end_of_sequence) {
+          input_impl_.reset();
+          break;
+        }
+        if (!slot->filled) {
+          TF_RETURN_IF_ERROR(CopyElementToBatch(
+              std::move(batch_element_tuple), num_batch_elements, &batch));
+        }
+        ++num_batch_elements;
+      }
+
+      if (num_batch_elements == 0 ||
+          (dataset()->drop_remainder_ &&
+           num_batch_elements < dataset()->batch_size_)) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      if (num_batch_elements < capacity) {
+        for (Tensor& batch_component : batch) {
+          batch_component = batch_component.Slice(0, num_batch_elements);
+        }
+      }
+      *out_tensors = std::move(batch);
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+    // (Re)allocates `batch` with room for `capacity` elements, keeping its
+    // first `num_elements` rows.
+    Status AllocateBatch(IteratorContext* ctx, int64 capacity,
+                         int64 num_elements, std::vector<Tensor>* batch) {
+      const DataTypeVector& dtypes = dataset()->input_->output_dtypes();
+      const auto& shapes = dataset()->input_->output_shapes();
+      batch->resize(dtypes.size());
+      for (size_t component_index = 0; component_index < dtypes.size();
+           ++component_index) {
+        TensorShape batch_component_shape({capacity});
+        TensorShape element_shape;
+        shapes[component_index].AsTensorShape(&element_shape);
+        batch_component_shape.AppendShape(element_shape);
+        Tensor batch_component(ctx->allocator({}), dtypes[component_index],
+                               batch_component_shape);
+        if (!batch_component.IsInitialized()) {
+          return errors::ResourceExhausted(
+              "Failed to allocate memory for the batch of component ",
+              component_index);
+        }
+        if (num_elements > 0) {
+          // Slices along the 0th dimension are contiguous.
+          const StringPiece rows =
+              (*batch)[component_index].Slice(0, num_elements).tensor_data();
+          memcpy(const_cast<char*>(batch_component.tensor_data().data()),
+                 rows.data(), rows.size());
+        }
+        (*batch)[component_index] = std::move(batch_component);
+      }
+      return Status::OK();
+    }
+
+    // Copies an element that the input did not write into its batch slot.
+    static Status CopyElementToBatch(std::vector<Tensor> element, int64 index,
+                                     std::vector<Tensor>* batch) {
+      if (element.size() != batch->size()) {
+        return errors::InvalidArgument(
+            "Cannot batch elements with different numbers of components. "
+            "Expected ",
+            batch->size(), " components but element ", index, " had ",
+            element.size(), ".");
+      }
+      for (size_t component_index = 0; component_index < element.size();
+           ++component_index) {
+        Tensor& batch_component = (*batch)[component_index];
+        TensorShape element_shape(batch_component.shape());
+        element_shape.RemoveDim(0);
+        if (element[component_index].shape() != element_shape) {
+          return errors::InvalidArgument(
+              "Cannot batch tensors with different shapes in component ",
+              component_index, ". Expected shape ",
+              element_shape.DebugString(), " but element ", index,
+              " had shape ", element[component_index].shape().DebugString(),
+              ".");
+        }
+        TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+            std::move(element[component_index]), &batch_component, index));
+      }
+      return Status::OK();
+    }
+
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
   };
@@ -276,6 +437,9 @@ class BatchDatasetOp::Dataset : public DatasetBase {
   const DatasetBase* const input_;
   const int op_version_;
   std::vector<PartialTensorShape> output_shapes_;
+  bool preallocate_;
+  // Bytes of one input element, if `preallocate_` is true.
+  int64 element_bytes_ = 0;
 };
 
 BatchDatasetOp::BatchDatasetOp(OpKernelConstruction* ctx)
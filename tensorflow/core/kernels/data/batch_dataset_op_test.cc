@@ -201,7 +201,25 @@ TestCase TestCase7() {
           /*breakpoints*/ {0, 1, 5}};
 }
 
-// Test Case 8: test BatchDatasetV2 with an invalid batch size
+// Test Case 8: test BatchDatasetV2 with a `batch_size` far too large to
+// allocate up front.
+TestCase HugeBatchSizeTestCase() {
+  return {/*range_data_param*/ {0, 10, 1},
+          /*batch_size*/
+          DatasetOpsTestBase::CreateTensor<int64>(TensorShape({}), {1LL << 40}),
+          /*drop_remainder*/
+          DatasetOpsTestBase::CreateTensor<bool>(TensorShape({}), {false}),
+          /*parallel_copy*/ false,
+          /*expected_outputs*/
+          {DatasetOpsTestBase::CreateTensor<int64>(
+              TensorShape({10}), {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})},
+          /*expected_output_dtypes*/ {DT_INT64},
+          /*expected_output_shapes*/ {PartialTensorShape({-1})},
+          /*expected_cardinality*/ 1,
+          /*breakpoints*/ {0, 1, 5}};
+}
+
+// Test Case 9: test BatchDatasetV2 with an invalid batch size
 TestCase InvalidBatchSizeTestCase() {
   return {/*range_data_param*/ {0, 10, 1},
           /*batch_size*/
@@ -703,7 +721,63 @@ INSTANTIATE_TEST_SUITE_P(BatchDatasetOpTest, ParameterizedBatchDatasetOpTest,
                          ::testing::ValuesIn(std::vector<TestCase>(
                              {TestCase1(), TestCase2(), TestCase3(),
                               TestCase4(), TestCase5(), TestCase6(),
-                              TestCase7()})));
+                              TestCase7(), HugeBatchSizeTestCase()})));
+
+// The batch is first allocated for 16MB worth of elements, and has to grow
+// to hold the rest.
+TEST_F(BatchDatasetOpTest, GrowsPreallocatedBatch) {
+  int thread_num = 2, cpu_num = 2;
+  TF_ASSERT_OK(InitThreadPool(thread_num));
+  TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
+  const int64 num_elements = 3 << 20;
+  std::unique_ptr<OpKernel> batch_dataset_kernel;
+  TF_ASSERT_OK(CreateBatchDatasetOpKernel(
+      /*parallel_copy=*/false, {DT_INT64}, {PartialTensorShape({-1})},
+      &batch_dataset_kernel));
+  DatasetBase* range_dataset;
+  TF_ASSERT_OK(CreateRangeDataset<int64>(0, num_elements, 1, "range",
+                                         &range_dataset));
+  Tensor range_dataset_tensor(DT_VARIANT, TensorShape({}));
+  TF_ASSERT_OK(
+      StoreDatasetInVariantTensor(range_dataset, &range_dataset_tensor));
+
+  Tensor batch_size =
+      CreateTensor<int64>(TensorShape({}), {2 * num_elements});
+  Tensor drop_remainder = CreateTensor<bool>(TensorShape({}), {false});
+  gtl::InlinedVector<TensorValue, 4> inputs{TensorValue(&range_dataset_tensor),
+                                            TensorValue(&batch_size),
+                                            TensorValue(&drop_remainder)};
+  std::unique_ptr<OpKernelContext> batch_dataset_context;
+  TF_ASSERT_OK(CreateBatchDatasetContext(batch_dataset_kernel.get(), &inputs,
+                                         &batch_dataset_context));
+  DatasetBase* batch_dataset;
+  TF_ASSERT_OK(CreateDataset(batch_dataset_kernel.get(),
+                             batch_dataset_context.get(), &batch_dataset));
+  core::ScopedUnref scoped_unref_batch_dataset(batch_dataset);
+
+  std::unique_ptr<IteratorContext> iterator_ctx;
+  TF_ASSERT_OK(
+      CreateIteratorContext(batch_dataset_context.get(), &iterator_ctx));
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(
+      batch_dataset->MakeIterator(iterator_ctx.get(), "Iterator", &iterator));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  TF_ASSERT_OK(
+      iterator->GetNext(iterator_ctx.get(), &out_tensors, &end_of_sequence));
+  ASSERT_FALSE(end_of_sequence);
+  ASSERT_EQ(1, out_tensors.size());
+  ASSERT_EQ(TensorShape({num_elements}), out_tensors[0].shape());
+  auto values = out_tensors[0].vec<int64>();
+  for (int64 i = 0; i < num_elements; ++i) {
+    ASSERT_EQ(i, values(i));
+  }
+  out_tensors.clear();
+  TF_ASSERT_OK(
+      iterator->GetNext(iterator_ctx.get(), &out_tensors, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
 
 TEST_F(BatchDatasetOpTest, InvalidBatchSize) {
   int thread_num = 2, cpu_num = 2;
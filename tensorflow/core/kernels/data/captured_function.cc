@@ -36,6 +36,10 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+// Functions with at most this many nodes are considered small enough that
+// scheduling each of their kernels on the runner costs more than it gains.
+constexpr int kMaxInlineFunctionNodes = 16;
+
 // Simplistic implementation of the `StepStatsCollectorInterface` that only
 // cares about collecting the CPU time needed to execute a captured function.
 class SimpleStepStatsCollector : public StepStatsCollectorInterface {
@@ -211,6 +215,24 @@ Status CreateFunctionLibraryDefinition(
   return Status::OK();
 }
 
+// Returns true if `fdef` is small and only uses stateless ops, so that running
+// all of its kernels on the calling thread cannot deadlock on a kernel that
+// waits for another kernel of the same function.
+bool ShouldRunAllKernelsInline(const FunctionLibraryDefinition& lib_def,
+                               const FunctionDef& fdef) {
+  if (fdef.node_def_size() > kMaxInlineFunctionNodes) {
+    return false;
+  }
+  for (const NodeDef& node : fdef.node_def()) {
+    const OpDef* op_def;
+    if (!lib_def.LookUpOpDef(node.op(), &op_def).ok() ||
+        op_def->is_stateful()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 Status MakeIteratorFromInputElement(
@@ -399,10 +421,23 @@ Status CapturedFunction::Instantiate(
   DataTypeVector ret_types;
   TF_RETURN_IF_ERROR(lib->GetRetTypes(f_handle, &ret_types));
 
+  // The single-threaded executor already runs everything inline, and the
+  // kernels of multi-device functions run on several devices.
+  bool run_all_kernels_inline = false;
+  if (metadata_->use_inter_op_parallelism() &&
+      !metadata_->is_multi_device_function()) {
+    const FunctionDef* fdef =
+        metadata_->lib_def()->Find(metadata_->func().name());
+    run_all_kernels_inline =
+        fdef != nullptr &&
+        ShouldRunAllKernelsInline(*metadata_->lib_def(), *fdef);
+  }
+
   *instantiated_captured_function =
       absl::WrapUnique<InstantiatedCapturedFunction>(
           new InstantiatedCapturedFunction(lib, f_handle, std::move(ret_types),
-                                           *ctx->runner(), this));
+                                           *ctx->runner(), this,
+                                           run_all_kernels_inline));
   return Status::OK();
 }
 
@@ -523,12 +558,15 @@ class BorrowedArgsCallFrame : public CallFrameBase {
 InstantiatedCapturedFunction::InstantiatedCapturedFunction(
     FunctionLibraryRuntime* lib, FunctionLibraryRuntime::Handle f_handle,
     DataTypeVector ret_types, std::function<void(std::function<void()>)> runner,
-    CapturedFunction* captured_func)
+    CapturedFunction* captured_func, bool run_all_kernels_inline)
     : lib_(lib),
       f_handle_(f_handle),
       ret_types_(std::move(ret_types)),
       captured_runner_(std::move(runner)),
-      captured_func_(captured_func) {}
+      captured_func_(captured_func),
+      create_rendezvous_(lib_->device()->device_type() != DEVICE_CPU ||
+                         captured_func_->is_multi_device_function()),
+      run_all_kernels_inline_(run_all_kernels_inline) {}
 
 // NOTE: We don't release f_handle_ here and instead delegate the function
 // handle releasing to the FunctionHandleCache. This is because in some cases
@@ -552,7 +590,8 @@ Status InstantiatedCapturedFunction::Run(IteratorContext* ctx,
       });
   f_opts.step_container = &step_container;
   f_opts.runner = ctx->runner();
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
+  f_opts.run_all_kernels_inline = run_all_kernels_inline_;
   // TODO(mrry): Add cancellation manager support to IteratorContext
   // so that we can cancel running map functions. The local
   // cancellation manager here is created so that we can run kernels
@@ -590,7 +629,8 @@ Status InstantiatedCapturedFunction::RunWithBorrowedArgs(
       });
   f_opts.step_container = &step_container;
   f_opts.runner = ctx->runner();
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
+  f_opts.run_all_kernels_inline = run_all_kernels_inline_;
   // TODO(mrry): Add cancellation manager support to IteratorContext
   // so that we can cancel running map functions. The local
   // cancellation manager here is created so that we can run kernels
@@ -628,7 +668,8 @@ Status InstantiatedCapturedFunction::RunInstantiated(
       });
   f_opts.step_container = &step_container;
   f_opts.runner = &captured_runner_;
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
+  f_opts.run_all_kernels_inline = run_all_kernels_inline_;
   // TODO(mrry): Add cancellation manager support to IteratorContext
   // so that we can cancel running map functions. The local
   // cancellation manager here is created so that we can run kernels
@@ -681,7 +722,8 @@ void InstantiatedCapturedFunction::RunAsync(
       });
   f_opts.step_container = step_container;
   f_opts.runner = ctx->runner();
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
+  f_opts.run_all_kernels_inline = run_all_kernels_inline_;
   // TODO(mrry): Add cancellation manager support to IteratorContext
   // so that we can cancel running map functions. The local
   // cancellation manager here is created so that we can run kernels
@@ -740,11 +782,6 @@ void InstantiatedCapturedFunction::RunAsync(
   lib_->Run(f_opts, f_handle_, frame, std::move(callback));
 }
 
-bool InstantiatedCapturedFunction::ShouldCreateRendezvous() const {
-  return lib_->device()->device_type() != DEVICE_CPU ||
-         captured_func_->is_multi_device_function();
-}
-
 CapturedFunction::CapturedFunction(
     const std::shared_ptr<const FunctionMetadata> metadata,
     std::vector<Tensor> captured_inputs)
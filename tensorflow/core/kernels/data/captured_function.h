@@ -93,11 +93,7 @@ class InstantiatedCapturedFunction {
       FunctionLibraryRuntime* lib, FunctionLibraryRuntime::Handle f_handle,
       DataTypeVector ret_types,
       std::function<void(std::function<void()>)> runner,
-      CapturedFunction* captured_func);
-
-  // Determines whether a rendezvous object should be created when running the
-  // instantiated function.
-  bool ShouldCreateRendezvous() const;
+      CapturedFunction* captured_func, bool run_all_kernels_inline);
 
   friend class CapturedFunction;
 
@@ -106,6 +102,12 @@ class InstantiatedCapturedFunction {
   const DataTypeVector ret_types_;
   std::function<void(std::function<void()>)> captured_runner_;
   CapturedFunction* const captured_func_;
+  // Whether a rendezvous object should be created when running the
+  // instantiated function.
+  const bool create_rendezvous_;
+  // Whether the kernels of the function run one after another on a single
+  // thread, which is cheaper for small functions than scheduling each kernel.
+  const bool run_all_kernels_inline_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(InstantiatedCapturedFunction);
 };
@@ -18,9 +18,12 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
@@ -34,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -540,5 +544,36 @@ std::function<void(std::function<void()>)> RunnerWithMaxParallelism(
       std::move(runner), std::placeholders::_1);
 }
 
+bool IsGpuDevice(const string& device) {
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(device, &parsed_name) &&
+         parsed_name.has_type && parsed_name.type == DEVICE_GPU;
+}
+
+void CopyToPinnedMemory(IteratorContext* ctx, std::vector<Tensor>* value) {
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  attr.set_gpu_compatible(true);
+  Allocator* allocator = ctx->allocator(attr);
+  for (Tensor& t : *value) {
+    if (!DataTypeCanUseMemcpy(t.dtype()) || t.NumElements() == 0) {
+      continue;
+    }
+    TensorDescription description;
+    t.FillDescription(&description);
+    if (description.allocation_description().allocator_name() ==
+        allocator->Name()) {
+      continue;
+    }
+    Tensor pinned(allocator, t.dtype(), t.shape());
+    // Keeps the pageable tensor if pinned memory is exhausted.
+    if (!pinned.IsInitialized()) continue;
+    StringPiece src = t.tensor_data();
+    memcpy(const_cast<char*>(pinned.tensor_data().data()), src.data(),
+           src.size());
+    t = std::move(pinned);
+  }
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -120,6 +120,15 @@ Status AddToFunctionLibrary(FunctionLibraryDefinition* base,
 std::function<void(std::function<void()>)> RunnerWithMaxParallelism(
     std::function<void(std::function<void()>)> runner, int max_parallelism);
 
+// Returns true if `device` is the full or legacy name of a GPU.
+bool IsGpuDevice(const string& device);
+
+// Replaces each tensor of `value` that can be copied with memcpy by a copy in
+// the GPU-compatible host memory of `ctx`, which is pinned when GPUs are
+// present. Empty tensors, tensors that are already in that memory, and tensors
+// whose copy cannot be allocated are kept as they are.
+void CopyToPinnedMemory(IteratorContext* ctx, std::vector<Tensor>* value);
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
@@ -637,6 +640,61 @@ TEST(DatasetUtilsTest, RunnerWithMaxParallelism) {
   auto fn = []() { ASSERT_EQ(GetPerThreadMaxParallelism(), 2); };
   runner(fn);
 }
+
+TEST(DatasetUtilsTest, IsGpuDevice) {
+  EXPECT_TRUE(IsGpuDevice("/job:localhost/replica:0/task:0/device:GPU:1"));
+  EXPECT_TRUE(IsGpuDevice("/gpu:0"));
+  EXPECT_FALSE(IsGpuDevice("/job:localhost/replica:0/task:0/device:CPU:0"));
+  EXPECT_FALSE(IsGpuDevice("not a device"));
+}
+
+// Stands in for the pinned host allocator of a GPU build.
+class FakePinnedAllocator : public Allocator {
+ public:
+  string Name() override { return "fake_pinned"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+};
+
+string AllocatorName(const Tensor& t) {
+  TensorDescription description;
+  t.FillDescription(&description);
+  return description.allocation_description().allocator_name();
+}
+
+TEST(DatasetUtilsTest, CopyToPinnedMemory) {
+  FakePinnedAllocator pinned_allocator;
+  IteratorContext::Params params;
+  params.allocator_getter = [&pinned_allocator](AllocatorAttributes attrs) {
+    EXPECT_TRUE(attrs.on_host());
+    EXPECT_TRUE(attrs.gpu_compatible());
+    return &pinned_allocator;
+  };
+  IteratorContext ctx(std::move(params));
+
+  const Tensor pageable = test::AsTensor<float>({1.f, 2.f, 3.f});
+  Tensor already_pinned(&pinned_allocator, DT_INT64, TensorShape({2}));
+  test::FillValues<int64>(&already_pinned, {4, 5});
+  const Tensor words = test::AsTensor<string>({"a", "b"});
+  const Tensor empty(DT_FLOAT, TensorShape({0}));
+  std::vector<Tensor> value = {pageable, already_pinned, words, empty};
+  CopyToPinnedMemory(&ctx, &value);
+
+  ASSERT_EQ(4, value.size());
+  EXPECT_EQ("fake_pinned", AllocatorName(value[0]));
+  EXPECT_FALSE(value[0].SharesBufferWith(pageable));
+  test::ExpectTensorEqual<float>(pageable, value[0]);
+  // Tensors already in pinned memory, and the ones that cannot be copied with
+  // memcpy, keep their buffers.
+  EXPECT_TRUE(value[1].SharesBufferWith(already_pinned));
+  EXPECT_TRUE(value[2].SharesBufferWith(words));
+  EXPECT_EQ(0, value[3].NumElements());
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
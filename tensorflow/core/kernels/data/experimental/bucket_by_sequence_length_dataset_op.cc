@@ -0,0 +1,535 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+constexpr char kDatasetName[] = "BucketBySequenceLength";
+constexpr char kExhausted[] = "exhausted";
+
+class BucketBySequenceLengthDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit BucketBySequenceLengthDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("length_component", &length_component_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("pad_to_bucket_boundary",
+                                     &pad_to_bucket_boundary_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    const size_t num_components = input->output_shapes().size();
+    OP_REQUIRES(
+        ctx, length_component_ < static_cast<int64>(num_components),
+        errors::InvalidArgument("`length_component` (", length_component_,
+                                ") must be less than the number of components "
+                                "in the input dataset's elements (",
+                                num_components, ")"));
+
+    const Tensor* boundaries_t;
+    OP_REQUIRES_OK(ctx, ctx->input("bucket_boundaries", &boundaries_t));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(boundaries_t->shape()),
+        errors::InvalidArgument("`bucket_boundaries` must be a vector"));
+    std::vector<int64> boundaries(boundaries_t->NumElements());
+    for (int64 i = 0; i < boundaries_t->NumElements(); ++i) {
+      boundaries[i] = boundaries_t->vec<int64>()(i);
+    }
+    OP_REQUIRES(ctx, std::is_sorted(boundaries.begin(), boundaries.end()),
+                errors::InvalidArgument(
+                    "`bucket_boundaries` must be sorted in increasing order"));
+
+    const Tensor* batch_sizes_t;
+    OP_REQUIRES_OK(ctx, ctx->input("bucket_batch_sizes", &batch_sizes_t));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(batch_sizes_t->shape()),
+        errors::InvalidArgument("`bucket_batch_sizes` must be a vector"));
+    OP_REQUIRES(ctx, batch_sizes_t->NumElements() == boundaries.size() + 1,
+                errors::InvalidArgument(
+                    "`bucket_batch_sizes` must have one more element than "
+                    "`bucket_boundaries`, but got ",
+                    batch_sizes_t->NumElements(), " and ", boundaries.size()));
+    std::vector<int64> batch_sizes(batch_sizes_t->NumElements());
+    for (int64 i = 0; i < batch_sizes_t->NumElements(); ++i) {
+      batch_sizes[i] = batch_sizes_t->vec<int64>()(i);
+      OP_REQUIRES(ctx, batch_sizes[i] > 0,
+                  errors::InvalidArgument(
+                      "Bucket batch sizes must be greater than zero."));
+    }
+
+    OpInputList padded_shape_tensors;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input_list("padded_shapes", &padded_shape_tensors));
+    OP_REQUIRES(ctx, padded_shape_tensors.size() == num_components,
+                errors::InvalidArgument("Number of padded shapes (",
+                                        padded_shape_tensors.size(),
+                                        ") must match the number of components "
+                                        "in the input dataset's elements (",
+                                        num_components, ")"));
+    std::vector<PartialTensorShape> padded_shapes;
+    padded_shapes.reserve(num_components);
+    for (const Tensor& padded_shape_t : padded_shape_tensors) {
+      OP_REQUIRES(ctx, TensorShapeUtils::IsVector(padded_shape_t.shape()),
+                  errors::InvalidArgument("All padded shapes must be vectors"));
+      PartialTensorShape padded_shape;
+      OP_REQUIRES_OK(ctx, PartialTensorShape::MakePartialShape(
+                              padded_shape_t.vec<int64>().data(),
+                              padded_shape_t.NumElements(), &padded_shape));
+      padded_shapes.push_back(std::move(padded_shape));
+    }
+
+    OpInputList padding_values_list;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input_list("padding_values", &padding_values_list));
+    OP_REQUIRES(ctx, padding_values_list.size() == num_components,
+                errors::InvalidArgument(
+                    "Number of padding values (", padding_values_list.size(),
+                    ") must match the number of components in the input "
+                    "dataset's elements (",
+                    num_components, ")"));
+    std::vector<Tensor> padding_values;
+    padding_values.reserve(num_components);
+    for (int i = 0; i < padding_values_list.size(); ++i) {
+      const Tensor& padding_value_t = padding_values_list[i];
+      OP_REQUIRES(
+          ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+          errors::InvalidArgument("All padding values must be scalars"));
+      OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                  errors::InvalidArgument(
+                      "Mismatched type between padding value ", i,
+                      " and input dataset's component ", i, ": ",
+                      DataTypeString(padding_value_t.dtype()), " vs. ",
+                      DataTypeString(input->output_dtypes()[i])));
+      padding_values.push_back(tensor::DeepCopy(padding_value_t));
+    }
+
+    bool drop_remainder;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<bool>(ctx, "drop_remainder",
+                                                  &drop_remainder));
+    int64 max_buffered_bytes;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "max_buffered_bytes",
+                                                   &max_buffered_bytes));
+    OP_REQUIRES(ctx, max_buffered_bytes >= 0,
+                errors::InvalidArgument("`max_buffered_bytes` must be >= 0."));
+    // Bounding the buffer emits partial batches early, which `drop_remainder`
+    // would silently discard.
+    OP_REQUIRES(ctx, max_buffered_bytes == 0 || !drop_remainder,
+                errors::InvalidArgument(
+                    "`max_buffered_bytes` cannot be set together with "
+                    "`drop_remainder`."));
+
+    *output = new Dataset(ctx, input, length_component_, std::move(boundaries),
+                          std::move(batch_sizes), std::move(padded_shapes),
+                          std::move(padding_values), pad_to_bucket_boundary_,
+                          drop_remainder, max_buffered_bytes);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input,
+            int64 length_component, std::vector<int64> boundaries,
+            std::vector<int64> batch_sizes,
+            std::vector<PartialTensorShape> padded_shapes,
+            std::vector<Tensor> padding_values, bool pad_to_bucket_boundary,
+            bool drop_remainder, int64 max_buffered_bytes)
+        : DatasetBase(DatasetContext(ctx)),
+          input_(input),
+          length_component_(length_component),
+          boundaries_(std::move(boundaries)),
+          batch_sizes_(std::move(batch_sizes)),
+          padded_shapes_(std::move(padded_shapes)),
+          padding_values_(std::move(padding_values)),
+          pad_to_bucket_boundary_(pad_to_bucket_boundary),
+          drop_remainder_(drop_remainder),
+          max_buffered_bytes_(max_buffered_bytes) {
+      input_->Ref();
+      // Batch sizes differ between buckets, and dimensions padded to the
+      // bucket boundary differ between batches.
+      output_shapes_.reserve(padded_shapes_.size());
+      for (const PartialTensorShape& padded_shape : padded_shapes_) {
+        output_shapes_.push_back(
+            PartialTensorShape({-1}).Concatenate(padded_shape));
+      }
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(
+          Iterator::Params{this, strings::StrCat(prefix, "::", kDatasetName)});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return strings::StrCat(kDatasetName, "DatasetOp::Dataset");
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+      Node* boundaries = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(boundaries_, &boundaries));
+      Node* batch_sizes = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(batch_sizes_, &batch_sizes));
+
+      std::vector<Node*> padded_shapes;
+      padded_shapes.reserve(padded_shapes_.size());
+      for (const PartialTensorShape& padded_shape : padded_shapes_) {
+        Node* node;
+        Tensor t(DT_INT64, TensorShape({padded_shape.dims()}));
+        for (int j = 0; j < padded_shape.dims(); ++j) {
+          t.vec<int64>()(j) = padded_shape.dim_size(j);
+        }
+        TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+        padded_shapes.push_back(node);
+      }
+
+      std::vector<Node*> padding_values;
+      padding_values.reserve(padding_values_.size());
+      for (const Tensor& t : padding_values_) {
+        Node* node;
+        TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+        padding_values.push_back(node);
+      }
+
+      Node* drop_remainder = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+      Node* max_buffered_bytes = nullptr;
+      TF_RETURN_IF_ERROR(
+          b->AddScalar(max_buffered_bytes_, &max_buffered_bytes));
+
+      AttrValue length_component;
+      b->BuildAttrValue(length_component_, &length_component);
+      AttrValue pad_to_bucket_boundary;
+      b->BuildAttrValue(pad_to_bucket_boundary_, &pad_to_bucket_boundary);
+      AttrValue output_types;
+      b->BuildAttrValue(output_dtypes(), &output_types);
+      AttrValue N;
+      b->BuildAttrValue<int64>(padded_shapes_.size(), &N);
+
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {{0, input_graph_node},
+           {1, boundaries},
+           {2, batch_sizes},
+           {5, drop_remainder},
+           {6, max_buffered_bytes}},
+          {{3, padded_shapes}, {4, padding_values}},
+          {{"length_component", length_component},
+           {"pad_to_bucket_boundary", pad_to_bucket_boundary},
+           {"Toutput_types", output_types},
+           {"N", N}},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            buckets_(params.dataset->batch_sizes_.size()),
+            bucket_bytes_(params.dataset->batch_sizes_.size(), 0) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        std::vector<std::vector<Tensor>> batch_elements;
+        int64 bucket = -1;
+        {
+          mutex_lock l(mu_);
+          while (input_impl_ && bucket < 0) {
+            std::vector<Tensor> element;
+            bool end_of_input;
+            TF_RETURN_IF_ERROR(
+                input_impl_->GetNext(ctx, &element, &end_of_input));
+            if (end_of_input) {
+              input_impl_.reset();
+              break;
+            }
+            int64 element_bucket;
+            TF_RETURN_IF_ERROR(BucketFor(element, &element_bucket));
+            AddToBucket(element_bucket, std::move(element));
+            if (buckets_[element_bucket].size() ==
+                dataset()->batch_sizes_[element_bucket]) {
+              bucket = element_bucket;
+            } else if (dataset()->max_buffered_bytes_ > 0 &&
+                       buffered_bytes_ > dataset()->max_buffered_bytes_) {
+              bucket = LargestBucket();
+            }
+          }
+          if (bucket < 0) {
+            // The input is exhausted, so flush the remaining partial batches
+            // in bucket order.
+            for (int64 i = 0; i < buckets_.size(); ++i) {
+              if (!buckets_[i].empty()) {
+                bucket = i;
+                break;
+              }
+            }
+            if (bucket < 0 || dataset()->drop_remainder_) {
+              for (int64 i = 0; i < buckets_.size(); ++i) {
+                buckets_[i].clear();
+                bucket_bytes_[i] = 0;
+              }
+              buffered_bytes_ = 0;
+              *end_of_sequence = true;
+              return Status::OK();
+            }
+          }
+          batch_elements.swap(buckets_[bucket]);
+          buffered_bytes_ -= bucket_bytes_[bucket];
+          bucket_bytes_[bucket] = 0;
+        }
+        *end_of_sequence = false;
+        return PadAndBatch(ctx, bucket, batch_elements, out_tensors);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        // The number of input elements per batch depends on the bucket.
+        return model::MakeUnknownRatioNode(std::move(args));
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (input_impl_) {
+          TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
+        } else {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kExhausted), ""));
+        }
+        for (int64 i = 0; i < buckets_.size(); ++i) {
+          const string name = full_name(strings::StrCat("buckets[", i, "]"));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat(name, "_size"), buckets_[i].size()));
+          for (int64 j = 0; j < buckets_[i].size(); ++j) {
+            for (int64 k = 0; k < buckets_[i][j].size(); ++k) {
+              TF_RETURN_IF_ERROR(writer->WriteTensor(
+                  strings::StrCat(name, "[", j, "][", k, "]"),
+                  buckets_[i][j][k]));
+            }
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (reader->Contains(full_name(kExhausted))) {
+          input_impl_.reset();
+        } else {
+          TF_RETURN_IF_ERROR(
+              dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+          TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+        }
+        const size_t num_components = dataset()->output_dtypes().size();
+        buffered_bytes_ = 0;
+        for (int64 i = 0; i < buckets_.size(); ++i) {
+          buckets_[i].clear();
+          bucket_bytes_[i] = 0;
+          const string name = full_name(strings::StrCat("buckets[", i, "]"));
+          int64 bucket_size;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(strings::StrCat(name, "_size"),
+                                                &bucket_size));
+          for (int64 j = 0; j < bucket_size; ++j) {
+            std::vector<Tensor> element(num_components);
+            for (int64 k = 0; k < num_components; ++k) {
+              TF_RETURN_IF_ERROR(reader->ReadTensor(
+                  strings::StrCat(name, "[", j, "][", k, "]"), &element[k]));
+            }
+            AddToBucket(i, std::move(element));
+          }
+        }
+        return Status::OK();
+      }
+
+     private:
+      // Finds the bucket of `element` from the size of the 0th dimension of
+      // its length component: bucket `i` holds the lengths in
+      // [boundaries[i - 1], boundaries[i]).
+      Status BucketFor(const std::vector<Tensor>& element, int64* bucket) {
+        const Tensor& component = element[dataset()->length_component_];
+        if (component.dims() < 1) {
+          return errors::InvalidArgument(
+              "The length component of an element must have rank >= 1, but "
+              "got a tensor of shape ",
+              component.shape().DebugString());
+        }
+        const int64 length = component.dim_size(0);
+        const std::vector<int64>& boundaries = dataset()->boundaries_;
+        *bucket = std::upper_bound(boundaries.begin(), boundaries.end(),
+                                   length) -
+                  boundaries.begin();
+        if (dataset()->pad_to_bucket_boundary_ &&
+            *bucket == boundaries.size()) {
+          return errors::InvalidArgument(
+              "When pad_to_bucket_boundary is set, elements must have length "
+              "< max(bucket_boundaries), but got an element of length ",
+              length);
+        }
+        return Status::OK();
+      }
+
+      void AddToBucket(int64 bucket, std::vector<Tensor> element)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        int64 bytes = 0;
+        for (const Tensor& t : element) {
+          bytes += t.TotalBytes();
+        }
+        buckets_[bucket].push_back(std::move(element));
+        bucket_bytes_[bucket] += bytes;
+        buffered_bytes_ += bytes;
+      }
+
+      int64 LargestBucket() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return std::max_element(bucket_bytes_.begin(), bucket_bytes_.end()) -
+               bucket_bytes_.begin();
+      }
+
+      // Pads the elements of `bucket` to a common shape and copies them into
+      // one output tensor per tuple component.
+      Status PadAndBatch(IteratorContext* ctx, int64 bucket,
+                         const std::vector<std::vector<Tensor>>& batch_elements,
+                         std::vector<Tensor>* out_tensors) {
+        const int64 num_batch_elements = batch_elements.size();
+        const size_t num_tuple_components = batch_elements[0].size();
+        for (size_t component_index = 0; component_index < num_tuple_components;
+             ++component_index) {
+          const PartialTensorShape& padded_shape =
+              dataset()->padded_shapes_[component_index];
+          TensorShape batch_component_shape({num_batch_elements});
+          for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+            if (padded_shape.dim_size(dim) != -1) {
+              batch_component_shape.AddDim(padded_shape.dim_size(dim));
+            } else if (dataset()->pad_to_bucket_boundary_) {
+              batch_component_shape.AddDim(dataset()->boundaries_[bucket] - 1);
+            } else {
+              batch_component_shape.AddDim(0);
+            }
+          }
+
+          for (int64 i = 0; i < num_batch_elements; ++i) {
+            const TensorShape& element_shape =
+                batch_elements[i][component_index].shape();
+            if (element_shape.dims() != padded_shape.dims()) {
+              return errors::InvalidArgument(
+                  "All elements in a batch must have the same rank as the "
+                  "padded shape for component",
+                  component_index, ": expected rank ", padded_shape.dims(),
+                  " but got element with rank ", element_shape.dims());
+            }
+            for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+              const int64 size = element_shape.dim_size(dim);
+              if (padded_shape.dim_size(dim) == -1 &&
+                  !dataset()->pad_to_bucket_boundary_) {
+                // Pad to the longest element in the batch.
+                if (size > batch_component_shape.dim_size(dim + 1)) {
+                  batch_component_shape.set_dim(dim + 1, size);
+                }
+              } else if (size > batch_component_shape.dim_size(dim + 1)) {
+                return errors::DataLoss(
+                    "Attempted to pad to a smaller size than the input "
+                    "element.");
+              }
+            }
+          }
+
+          out_tensors->emplace_back(ctx->allocator({}),
+                                    dataset()->output_dtypes()[component_index],
+                                    batch_component_shape);
+          Tensor& batch_component = out_tensors->back();
+          TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+              &batch_component, dataset()->padding_values_[component_index]));
+
+          TensorShape component_shape = batch_component_shape;
+          component_shape.RemoveDim(0);
+          for (int64 i = 0; i < num_batch_elements; ++i) {
+            const Tensor& element = batch_elements[i][component_index];
+            // Take the fast path if possible.
+            if (element.shape() == component_shape) {
+              TF_RETURN_IF_ERROR(
+                  batch_util::CopyElementToSlice(element, &batch_component, i));
+            } else {
+              TF_RETURN_IF_ERROR(batch_util::CopyElementToLargerSlice(
+                  element, &batch_component, i));
+            }
+          }
+        }
+        return Status::OK();
+      }
+
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      // The buffered elements of each bucket, and their sizes in bytes.
+      std::vector<std::vector<std::vector<Tensor>>> buckets_ GUARDED_BY(mu_);
+      std::vector<int64> bucket_bytes_ GUARDED_BY(mu_);
+      int64 buffered_bytes_ GUARDED_BY(mu_) = 0;
+    };
+
+    const DatasetBase* const input_;
+    const int64 length_component_;
+    const std::vector<int64> boundaries_;
+    const std::vector<int64> batch_sizes_;
+    const std::vector<PartialTensorShape> padded_shapes_;
+    const std::vector<Tensor> padding_values_;
+    const bool pad_to_bucket_boundary_;
+    const bool drop_remainder_;
+    const int64 max_buffered_bytes_;
+    std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  int64 length_component_;
+  bool pad_to_bucket_boundary_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("BucketBySequenceLengthDataset").Device(DEVICE_CPU),
+    BucketBySequenceLengthDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,482 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/data_service/data_service_client.h"
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_client.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+// How long UNAVAILABLE errors from the service are retried: they are returned
+// while the dispatcher has no workers, or a worker has not started a task yet.
+constexpr int64 kRetryTimeoutMicros = 60 * 1000 * 1000;
+constexpr int64 kMaxBackoffMicros = 1000 * 1000;
+// How often iterators of SHARD_DYNAMIC jobs look for tasks of workers that
+// registered after the job was created.
+constexpr int64 kTaskRefreshIntervalMs = 1000;
+
+Status ParseShardingPolicy(const string& name, ShardingPolicy* policy) {
+  if (name == "OFF") {
+    *policy = SHARD_OFF;
+  } else if (name == "AUTO") {
+    *policy = SHARD_AUTO;
+  } else if (name == "DATA") {
+    *policy = SHARD_DATA;
+  } else if (name == "DYNAMIC") {
+    *policy = SHARD_DYNAMIC;
+  } else {
+    return errors::InvalidArgument("Unknown sharding policy: ", name);
+  }
+  return Status::OK();
+}
+
+// Calls `f` until it returns something other than UNAVAILABLE, or
+// `kRetryTimeoutMicros` has passed.
+Status RetryUnavailable(const std::function<Status()>& f) {
+  Env* env = Env::Default();
+  const int64 deadline_micros = env->NowMicros() + kRetryTimeoutMicros;
+  int64 backoff_micros = 10 * 1000;
+  while (true) {
+    Status s = f();
+    if (!errors::IsUnavailable(s) || env->NowMicros() >= deadline_micros) {
+      return s;
+    }
+    env->SleepForMicroseconds(backoff_micros);
+    backoff_micros = std::min(2 * backoff_micros, kMaxBackoffMicros);
+  }
+}
+
+class DataServiceDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit DataServiceDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    string sharding_policy;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sharding_policy", &sharding_policy));
+    OP_REQUIRES_OK(ctx,
+                   ParseShardingPolicy(sharding_policy, &sharding_policy_));
+    sharding_policy_name_ = sharding_policy;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_splits", &num_splits_));
+    OP_REQUIRES(ctx, num_splits_ >= 0,
+                errors::InvalidArgument("`num_splits` must be >= 0, but got ",
+                                        num_splits_));
+  }
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    string address;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "address", &address));
+    OP_REQUIRES(ctx, !address.empty(),
+                errors::InvalidArgument("`address` must not be empty."));
+    string protocol;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "protocol", &protocol));
+    OP_REQUIRES(ctx, protocol == "grpc",
+                errors::InvalidArgument("Unsupported protocol: ", protocol));
+    string job_name;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "job_name", &job_name));
+    int64 max_outstanding_requests;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(
+                            ctx, "max_outstanding_requests",
+                            &max_outstanding_requests));
+    OP_REQUIRES(ctx, max_outstanding_requests > 0,
+                errors::InvalidArgument(
+                    "`max_outstanding_requests` must be > 0, but got ",
+                    max_outstanding_requests));
+
+    // The workers run the input pipeline, so it is shipped to the dispatcher
+    // as a graph. The pipeline must not depend on resources of this process.
+    GraphDef graph_def;
+    OP_REQUIRES_OK(
+        ctx, AsGraphDef(ctx, input, SerializationContext({}), &graph_def));
+    *output = new Dataset(ctx, input, std::move(graph_def), address, protocol,
+                          job_name, max_outstanding_requests,
+                          sharding_policy_, sharding_policy_name_,
+                          num_splits_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, GraphDef graph_def,
+            const string& address, const string& protocol,
+            const string& job_name, int64 max_outstanding_requests,
+            ShardingPolicy sharding_policy,
+            const string& sharding_policy_name, int64 num_splits)
+        : DatasetBase(DatasetContext(ctx)),
+          input_(input),
+          address_(address),
+          protocol_(protocol),
+          job_name_(job_name),
+          max_outstanding_requests_(max_outstanding_requests),
+          sharding_policy_(sharding_policy),
+          sharding_policy_name_(sharding_policy_name),
+          num_splits_(num_splits) {
+      input_->Ref();
+      *dataset_def_.mutable_graph() = std::move(graph_def);
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(
+          Iterator::Params{this, strings::StrCat(prefix, "::DataService")});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() const override {
+      return "DataServiceDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+      Node* address = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(address_, &address));
+      Node* protocol = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(protocol_, &protocol));
+      Node* job_name = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(job_name_, &job_name));
+      Node* max_outstanding_requests = nullptr;
+      TF_RETURN_IF_ERROR(
+          b->AddScalar(max_outstanding_requests_, &max_outstanding_requests));
+      AttrValue sharding_policy_attr;
+      b->BuildAttrValue(sharding_policy_name_, &sharding_policy_attr);
+      AttrValue num_splits_attr;
+      b->BuildAttrValue(num_splits_, &num_splits_attr);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          /*inputs=*/
+          {std::make_pair(0, input_graph_node), std::make_pair(1, address),
+           std::make_pair(2, protocol), std::make_pair(3, job_name),
+           std::make_pair(4, max_outstanding_requests)},
+          /*list_inputs=*/{},
+          /*attrs=*/
+          {{"sharding_policy", sharding_policy_attr},
+           {"num_splits", num_splits_attr}},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    // Reads the elements of one job. Each task of the job is read by its own
+    // thread, and the threads together keep at most
+    // `max_outstanding_requests` elements in flight or buffered. Tasks can be
+    // added to SHARD_DYNAMIC jobs while they run, so for those a separate
+    // thread polls the dispatcher for new tasks.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~Iterator() override {
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+        // Joined first, so that no new task threads are started.
+        task_refresh_thread_.reset();
+        for (const auto& task : tasks_) {
+          task->worker->TryCancel();
+        }
+        // Joins the threads.
+        task_threads_.clear();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsureThreadsStarted(ctx));
+        while (results_.empty() && status_.ok() &&
+               (num_finished_tasks_ < tasks_.size() || !tasks_final_)) {
+          RecordStop(ctx);
+          cond_var_.wait(l);
+          RecordStart(ctx);
+        }
+        if (!results_.empty()) {
+          *out_tensors = std::move(results_.front());
+          results_.pop_front();
+          *end_of_sequence = false;
+          cond_var_.notify_all();
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(status_);
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        return errors::Unimplemented(
+            "Checkpointing is not supported for DataServiceDataset.");
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        return errors::Unimplemented(
+            "Checkpointing is not supported for DataServiceDataset.");
+      }
+
+     private:
+      struct Task {
+        Task(int64 task_id, std::unique_ptr<WorkerClient> worker)
+            : task_id(task_id), worker(std::move(worker)) {}
+
+        const int64 task_id;
+        const std::unique_ptr<WorkerClient> worker;
+        // Set under the iterator's `mu_` once the dispatcher has given the
+        // splits of the task to other tasks.
+        bool failed = false;
+      };
+
+      // Registers the dataset, joins or creates the job, and starts one
+      // thread per task of the job.
+      Status EnsureThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (initialized_) {
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(
+            NewGrpcDispatcherClient(dataset()->address_, &dispatcher_));
+
+        GetOrRegisterDatasetRequest dataset_request;
+        *dataset_request.mutable_dataset() = dataset()->dataset_def_;
+        GetOrRegisterDatasetResponse dataset_response;
+        TF_RETURN_IF_ERROR(RetryUnavailable([&] {
+          return dispatcher_->GetOrRegisterDataset(&dataset_request,
+                                                   &dataset_response);
+        }));
+
+        GetOrCreateJobRequest job_request;
+        job_request.set_dataset_id(dataset_response.dataset_id());
+        job_request.set_sharding_policy(dataset()->sharding_policy_);
+        job_request.set_job_name(dataset()->job_name_);
+        job_request.set_num_splits(dataset()->num_splits_);
+        GetOrCreateJobResponse job_response;
+        TF_RETURN_IF_ERROR(RetryUnavailable([&] {
+          return dispatcher_->GetOrCreateJob(&job_request, &job_response);
+        }));
+
+        job_id_ = job_response.job_id();
+
+        GetTasksResponse tasks_response;
+        TF_RETURN_IF_ERROR(RetryUnavailable(
+            [&] { return GetTasks(&tasks_response); }));
+        if (tasks_response.task_info_size() == 0) {
+          return errors::Internal("The tf.data service job has no tasks.");
+        }
+        TF_RETURN_IF_ERROR(AddTasks(ctx, tasks_response));
+        initialized_ = true;
+        if (!tasks_final_) {
+          std::shared_ptr<IteratorContext> shared_ctx =
+              std::make_shared<IteratorContext>(ctx);
+          task_refresh_thread_ = ctx->StartThread(
+              "tf_data_service_task_refresh",
+              [this, shared_ctx]() { TaskRefreshThread(shared_ctx.get()); });
+        }
+        return Status::OK();
+      }
+
+      Status GetTasks(GetTasksResponse* response) {
+        GetTasksRequest request;
+        request.set_job_id(job_id_);
+        return dispatcher_->GetTasks(&request, response);
+      }
+
+      // Starts reading the tasks in `response` that are not read yet, and
+      // stops reading the ones that failed.
+      Status AddTasks(IteratorContext* ctx, const GetTasksResponse& response)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (const TaskInfo& task_info : response.task_info()) {
+          auto it = tasks_by_id_.find(task_info.task_id());
+          if (it != tasks_by_id_.end()) {
+            if (task_info.failed() && !it->second->failed) {
+              it->second->failed = true;
+              it->second->worker->TryCancel();
+            }
+            continue;
+          }
+          if (task_info.failed()) {
+            continue;
+          }
+          std::unique_ptr<WorkerClient> worker;
+          TF_RETURN_IF_ERROR(
+              NewGrpcWorkerClient(task_info.worker_address(), &worker));
+          auto task =
+              std::make_shared<Task>(task_info.task_id(), std::move(worker));
+          tasks_.push_back(task);
+          tasks_by_id_[task->task_id] = task;
+          task_threads_.push_back(ctx->StartThread(
+              "tf_data_service_client", [this, task]() { TaskThread(*task); }));
+        }
+        tasks_final_ = response.tasks_final();
+        cond_var_.notify_all();
+        return Status::OK();
+      }
+
+      void TaskRefreshThread(IteratorContext* ctx) {
+        while (true) {
+          {
+            mutex_lock l(mu_);
+            if (!cancelled_) {
+              cond_var_.wait_for(
+                  l, std::chrono::milliseconds(kTaskRefreshIntervalMs));
+            }
+            if (cancelled_ || !status_.ok()) {
+              return;
+            }
+          }
+          GetTasksResponse response;
+          Status s = GetTasks(&response);
+          mutex_lock l(mu_);
+          if (s.ok()) {
+            s = AddTasks(ctx, response);
+          }
+          if (errors::IsUnavailable(s)) {
+            // Try again at the next refresh.
+            continue;
+          }
+          if (!s.ok()) {
+            status_.Update(s);
+            cond_var_.notify_all();
+            return;
+          }
+          if (tasks_final_) {
+            return;
+          }
+        }
+      }
+
+      void TaskThread(const Task& task) {
+        while (true) {
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && status_.ok() &&
+                   num_outstanding_requests_ + results_.size() >=
+                       dataset()->max_outstanding_requests_) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_ || !status_.ok()) {
+              return;
+            }
+            ++num_outstanding_requests_;
+          }
+          std::vector<Tensor> element;
+          bool end_of_sequence = false;
+          Status s = RetryUnavailable([&] {
+            return task.worker->GetElement(task.task_id, &element,
+                                           &end_of_sequence);
+          });
+          mutex_lock l(mu_);
+          --num_outstanding_requests_;
+          cond_var_.notify_all();
+          if (cancelled_) {
+            return;
+          }
+          if (task.failed) {
+            // The elements of the task are produced by other tasks instead.
+            ++num_finished_tasks_;
+            return;
+          }
+          if (!s.ok()) {
+            status_.Update(s);
+            return;
+          }
+          if (end_of_sequence) {
+            ++num_finished_tasks_;
+            return;
+          }
+          results_.push_back(std::move(element));
+        }
+      }
+
+      mutex mu_;
+      condition_variable cond_var_;
+      bool initialized_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      Status status_ GUARDED_BY(mu_);
+      std::unique_ptr<DispatcherClient> dispatcher_;
+      int64 job_id_ = -1;
+      std::vector<std::shared_ptr<Task>> tasks_ GUARDED_BY(mu_);
+      std::unordered_map<int64, std::shared_ptr<Task>> tasks_by_id_
+          GUARDED_BY(mu_);
+      // False while tasks can still be added to the job.
+      bool tasks_final_ GUARDED_BY(mu_) = true;
+      size_t num_finished_tasks_ GUARDED_BY(mu_) = 0;
+      int64 num_outstanding_requests_ GUARDED_BY(mu_) = 0;
+      std::deque<std::vector<Tensor>> results_ GUARDED_BY(mu_);
+      // Only modified under `mu_` while `task_refresh_thread_` runs.
+      std::vector<std::unique_ptr<Thread>> task_threads_;
+      std::unique_ptr<Thread> task_refresh_thread_;
+    };
+
+    const DatasetBase* const input_;
+    DatasetDef dataset_def_;
+    const string address_;
+    const string protocol_;
+    const string job_name_;
+    const int64 max_outstanding_requests_;
+    const ShardingPolicy sharding_policy_;
+    const string sharding_policy_name_;
+    const int64 num_splits_;
+  };
+
+  ShardingPolicy sharding_policy_;
+  string sharding_policy_name_;
+  int64 num_splits_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DataServiceDataset").Device(DEVICE_CPU),
+                        DataServiceDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,242 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/rpc/data_service/grpc_data_service_server.h"
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kNodeName[] = "data_service_dataset";
+
+// Runs DataServiceDataset against a dispatcher and workers served from this
+// process.
+class DataServiceDatasetOpTest : public DatasetOpsTestBase {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(InitThreadPool(/*thread_num=*/2));
+    TF_ASSERT_OK(InitFunctionLibraryRuntime({}, /*cpu_num=*/2));
+  }
+
+  // Starts a dispatcher, and `num_workers` workers registered with it.
+  void StartService(int num_workers) {
+    TF_ASSERT_OK(NewGrpcDispatcherServer(/*port=*/0, &dispatcher_));
+    address_ = strings::StrCat("localhost:", dispatcher_->bound_port());
+    for (int i = 0; i < num_workers; ++i) {
+      AddWorker(/*heartbeat_interval_ms=*/10);
+    }
+  }
+
+  // Starts a worker that registers with the running dispatcher. The worker
+  // starts the tasks that it is given at its next heartbeat.
+  void AddWorker(int64 heartbeat_interval_ms) {
+    GrpcDataWorkerServerOptions options;
+    options.port = testing::PickUnusedPortOrDie();
+    options.dispatcher_address = address_;
+    options.worker_address = strings::StrCat("localhost:", options.port);
+    options.heartbeat_interval_ms = heartbeat_interval_ms;
+    std::unique_ptr<DataServiceServer> worker;
+    TF_ASSERT_OK(NewGrpcDataWorkerServer(options, &worker));
+    workers_.push_back(std::move(worker));
+  }
+
+  // Creates a DataServiceDataset that reads `range(0, n)` from the service.
+  Status MakeDataset(int64 n, const string& sharding_policy,
+                     const string& address, const string& protocol,
+                     const string& job_name, int64 max_outstanding_requests,
+                     DatasetBase** dataset) {
+    NodeDef node_def = test::function::NDef(
+        kNodeName, "DataServiceDataset",
+        {"input_dataset", "address", "protocol", "job_name",
+         "max_outstanding_requests"},
+        {{"sharding_policy", sharding_policy},
+         {"num_splits", 0},
+         {"output_types", DataTypeVector({DT_INT64})},
+         {"output_shapes", std::vector<PartialTensorShape>({{}})}});
+    TF_RETURN_IF_ERROR(CreateOpKernel(node_def, &kernel_));
+
+    DatasetBase* range_dataset;
+    TF_RETURN_IF_ERROR(
+        CreateRangeDataset<int64>(0, n, 1, "range", &range_dataset));
+    Tensor range_dataset_t(DT_VARIANT, TensorShape({}));
+    TF_RETURN_IF_ERROR(
+        StoreDatasetInVariantTensor(range_dataset, &range_dataset_t));
+    Tensor address_t = CreateTensor<string>(TensorShape({}), {address});
+    Tensor protocol_t = CreateTensor<string>(TensorShape({}), {protocol});
+    Tensor job_name_t = CreateTensor<string>(TensorShape({}), {job_name});
+    Tensor max_outstanding_requests_t =
+        CreateTensor<int64>(TensorShape({}), {max_outstanding_requests});
+    gtl::InlinedVector<TensorValue, 4> inputs(
+        {TensorValue(&range_dataset_t), TensorValue(&address_t),
+         TensorValue(&protocol_t), TensorValue(&job_name_t),
+         TensorValue(&max_outstanding_requests_t)});
+    TF_RETURN_IF_ERROR(
+        CreateOpKernelContext(kernel_.get(), &inputs, &context_));
+    return CreateDataset(kernel_.get(), context_.get(), dataset);
+  }
+
+  Status MakeIterator(DatasetBase* dataset,
+                      std::unique_ptr<IteratorBase>* iterator) {
+    TF_RETURN_IF_ERROR(
+        CreateIteratorContext(context_.get(), &iterator_context_));
+    return dataset->MakeIterator(iterator_context_.get(), "Iterator",
+                                 iterator);
+  }
+
+  // Returns the remaining elements of `iterator` in ascending order.
+  std::vector<int64> GetSortedElements(IteratorBase* iterator) {
+    std::vector<int64> elements;
+    while (true) {
+      std::vector<Tensor> out_tensors;
+      bool end_of_sequence = false;
+      TF_CHECK_OK(iterator->GetNext(iterator_context_.get(), &out_tensors,
+                                    &end_of_sequence));
+      if (end_of_sequence) {
+        break;
+      }
+      EXPECT_EQ(1, out_tensors.size());
+      elements.push_back(out_tensors[0].scalar<int64>()());
+    }
+    std::sort(elements.begin(), elements.end());
+    return elements;
+  }
+
+  // Declared before `workers_`, so that the workers are stopped first.
+  std::unique_ptr<DataServiceServer> dispatcher_;
+  std::vector<std::unique_ptr<DataServiceServer>> workers_;
+  string address_;
+  std::unique_ptr<OpKernel> kernel_;
+  std::unique_ptr<OpKernelContext> context_;
+  std::unique_ptr<IteratorContext> iterator_context_;
+};
+
+TEST_F(DataServiceDatasetOpTest, ShardingOffReadsTheDatasetFromEveryWorker) {
+  StartService(/*num_workers=*/2);
+  DatasetBase* dataset;
+  TF_ASSERT_OK(MakeDataset(4, "OFF", address_, "grpc", /*job_name=*/"",
+                           /*max_outstanding_requests=*/4, &dataset));
+  core::ScopedUnref scoped_unref(dataset);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(MakeIterator(dataset, &iterator));
+  EXPECT_EQ(std::vector<int64>({0, 0, 1, 1, 2, 2, 3, 3}),
+            GetSortedElements(iterator.get()));
+}
+
+TEST_F(DataServiceDatasetOpTest, DataShardingSplitsTheElements) {
+  StartService(/*num_workers=*/3);
+  DatasetBase* dataset;
+  TF_ASSERT_OK(MakeDataset(10, "DATA", address_, "grpc", /*job_name=*/"",
+                           /*max_outstanding_requests=*/1, &dataset));
+  core::ScopedUnref scoped_unref(dataset);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(MakeIterator(dataset, &iterator));
+  EXPECT_EQ(std::vector<int64>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}),
+            GetSortedElements(iterator.get()));
+}
+
+TEST_F(DataServiceDatasetOpTest, IteratorsOfANamedJobShareItsElements) {
+  StartService(/*num_workers=*/2);
+  DatasetBase* dataset;
+  TF_ASSERT_OK(MakeDataset(10, "DATA", address_, "grpc", "shared",
+                           /*max_outstanding_requests=*/2, &dataset));
+  core::ScopedUnref scoped_unref(dataset);
+  std::unique_ptr<IteratorBase> first;
+  TF_ASSERT_OK(MakeIterator(dataset, &first));
+  std::unique_ptr<IteratorBase> second;
+  TF_ASSERT_OK(MakeIterator(dataset, &second));
+  std::vector<int64> elements = GetSortedElements(first.get());
+  for (int64 element : GetSortedElements(second.get())) {
+    elements.push_back(element);
+  }
+  std::sort(elements.begin(), elements.end());
+  EXPECT_EQ(std::vector<int64>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), elements);
+}
+
+TEST_F(DataServiceDatasetOpTest, DynamicJobReadsTheTasksOfLaterWorkers) {
+  StartService(/*num_workers=*/0);
+  // Registers before the job is created, so its task only starts at its
+  // second heartbeat.
+  AddWorker(/*heartbeat_interval_ms=*/2000);
+  DatasetBase* dataset;
+  TF_ASSERT_OK(MakeDataset(10, "DYNAMIC", address_, "grpc", /*job_name=*/"",
+                           /*max_outstanding_requests=*/4, &dataset));
+  core::ScopedUnref scoped_unref(dataset);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(MakeIterator(dataset, &iterator));
+  std::vector<int64> elements;
+  {
+    // The first `GetNext()` creates the job, and waits for an element of
+    // either task.
+    std::unique_ptr<Thread> first_element(Env::Default()->StartThread(
+        ThreadOptions(), "first_element", [this, &iterator, &elements]() {
+          std::vector<Tensor> out_tensors;
+          bool end_of_sequence = false;
+          TF_CHECK_OK(iterator->GetNext(iterator_context_.get(), &out_tensors,
+                                        &end_of_sequence));
+          ASSERT_FALSE(end_of_sequence);
+          elements.push_back(out_tensors[0].scalar<int64>()());
+        }));
+    Env::Default()->SleepForMicroseconds(100 * 1000);
+    // The iterator only learns about the task of this worker by polling the
+    // dispatcher.
+    AddWorker(/*heartbeat_interval_ms=*/10);
+  }
+  for (int64 element : GetSortedElements(iterator.get())) {
+    elements.push_back(element);
+  }
+  std::sort(elements.begin(), elements.end());
+  EXPECT_EQ(std::vector<int64>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), elements);
+}
+
+TEST_F(DataServiceDatasetOpTest, InvalidArguments) {
+  DatasetBase* dataset;
+  EXPECT_TRUE(errors::IsInvalidArgument(MakeDataset(
+      10, "OFF", /*address=*/"", "grpc", "", 16, &dataset)));
+  EXPECT_TRUE(errors::IsInvalidArgument(MakeDataset(
+      10, "OFF", "localhost:1", /*protocol=*/"http", "", 16, &dataset)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      MakeDataset(10, "OFF", "localhost:1", "grpc", "",
+                  /*max_outstanding_requests=*/0, &dataset)));
+  EXPECT_TRUE(errors::IsInvalidArgument(MakeDataset(
+      10, /*sharding_policy=*/"FILES", "localhost:1", "grpc", "", 16,
+      &dataset)));
+}
+
+TEST_F(DataServiceDatasetOpTest, CheckpointingIsUnimplemented) {
+  DatasetBase* dataset;
+  // The iterator only connects to the service on its first `GetNext()`.
+  TF_ASSERT_OK(
+      MakeDataset(10, "OFF", "localhost:1", "grpc", "", 16, &dataset));
+  core::ScopedUnref scoped_unref(dataset);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(MakeIterator(dataset, &iterator));
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorData data;
+  VariantTensorDataWriter writer(&data);
+  EXPECT_TRUE(errors::IsUnimplemented(
+      iterator->Save(serialization_ctx.get(), &writer)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
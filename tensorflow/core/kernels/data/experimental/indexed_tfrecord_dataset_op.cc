@@ -0,0 +1,361 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <deque>
+#include <numeric>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_index.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+constexpr char kDatasetName[] = "IndexedTFRecord";
+constexpr char kNextPosition[] = "next_position";
+
+// Number of files whose readers an iterator keeps open.
+constexpr size_t kMaxOpenFiles = 16;
+
+class IndexedTFRecordDatasetOp : public DatasetOpKernel {
+ public:
+  explicit IndexedTFRecordDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shuffle", &shuffle_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<string>()(i));
+    }
+
+    string compression_type;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "compression_type",
+                                                    &compression_type));
+    // Compressed streams can only seek by decompressing up to the record,
+    // from the start of the file when seeking backwards, which would make a
+    // shuffled pass quadratic in the size of the files.
+    OP_REQUIRES(
+        ctx, !shuffle_ || compression_type.empty(),
+        errors::InvalidArgument("`shuffle` is only supported for uncompressed "
+                                "files, got compression type \"",
+                                compression_type, "\"."));
+
+    int64 num_shards;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "num_shards", &num_shards));
+    OP_REQUIRES(ctx, num_shards > 0,
+                errors::InvalidArgument("`num_shards` must be > 0."));
+    int64 shard_index;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "shard_index", &shard_index));
+    OP_REQUIRES(ctx, shard_index >= 0 && shard_index < num_shards,
+                errors::InvalidArgument(
+                    "`shard_index` must be in [0, num_shards)."));
+    int64 skip;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "skip", &skip));
+    OP_REQUIRES(ctx, skip >= 0,
+                errors::InvalidArgument("`skip` must be >= 0."));
+
+    int64 seed;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed", &seed));
+    int64 seed2;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed2", &seed2));
+    // Every worker must use the same permutation, so unseeded shuffles are
+    // only consistent within this dataset.
+    if (shuffle_ && seed == 0 && seed2 == 0) {
+      seed = random::New64();
+      seed2 = random::New64();
+    }
+
+    *output = new Dataset(ctx, std::move(filenames), compression_type,
+                          num_shards, shard_index, skip, seed, seed2,
+                          shuffle_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+            const string& compression_type, int64 num_shards,
+            int64 shard_index, int64 skip, int64 seed, int64 seed2,
+            bool shuffle)
+        : DatasetBase(DatasetContext(ctx)),
+          filenames_(std::move(filenames)),
+          compression_type_(compression_type),
+          options_(io::RecordReaderOptions::CreateRecordReaderOptions(
+              compression_type)),
+          num_shards_(num_shards),
+          shard_index_(shard_index),
+          skip_(skip),
+          seed_(seed),
+          seed2_(seed2),
+          shuffle_(shuffle) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(
+          Iterator::Params{this, strings::StrCat(prefix, "::", kDatasetName)});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      static DataTypeVector* dtypes = new DataTypeVector({DT_STRING});
+      return *dtypes;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      static std::vector<PartialTensorShape>* shapes =
+          new std::vector<PartialTensorShape>({{}});
+      return *shapes;
+    }
+
+    string DebugString() const override {
+      return "IndexedTFRecordDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* filenames = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+      Node* compression_type = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
+      Node* num_shards = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(num_shards_, &num_shards));
+      Node* shard_index = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(shard_index_, &shard_index));
+      Node* skip = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(skip_, &skip));
+      Node* seed = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
+      Node* seed2 = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
+      AttrValue shuffle;
+      b->BuildAttrValue(shuffle_, &shuffle);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {filenames, compression_type, num_shards, shard_index, skip, seed,
+           seed2},
+          {{"shuffle", shuffle}}, output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            next_position_(dataset()->shard_index_ +
+                           dataset()->skip_ * dataset()->num_shards_) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(LoadIndexLocked(ctx));
+        if (next_position_ >= static_cast<int64>(file_starts_.back())) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        uint64 record_id = next_position_;
+        if (dataset()->shuffle_) {
+          record_id = permutation_[next_position_];
+        }
+        next_position_ += dataset()->num_shards_;
+
+        // Files are numbered consecutively, so the record belongs to the
+        // last file starting at or before it.
+        const size_t file_index =
+            std::upper_bound(file_starts_.begin(), file_starts_.end(),
+                             record_id) -
+            file_starts_.begin() - 1;
+        uint64 offset =
+            offsets_[file_index][record_id - file_starts_[file_index]];
+        io::RecordReader* reader;
+        TF_RETURN_IF_ERROR(GetReaderLocked(ctx->env(), file_index, &reader));
+        out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
+                                  TensorShape({}));
+        Status s = reader->ReadRecord(
+            &offset, &out_tensors->back().scalar<string>()());
+        if (!s.ok()) {
+          out_tensors->pop_back();
+          if (errors::IsOutOfRange(s)) {
+            s = errors::DataLoss("record index of ",
+                                 dataset()->filenames_[file_index],
+                                 " points past the end of the file");
+          }
+          return s;
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar(full_name(kNextPosition), next_position_);
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return reader->ReadScalar(full_name(kNextPosition), &next_position_);
+      }
+
+     private:
+      struct OpenFile {
+        size_t file_index;
+        // `reader` borrows `file`, so it is declared last to be destroyed
+        // first.
+        std::unique_ptr<RandomAccessFile> file;
+        std::unique_ptr<io::RecordReader> reader;
+      };
+
+      // Reads the record index of every file, in parallel, and computes the
+      // permutation of the records if shuffling. Files without an index are
+      // scanned.
+      Status LoadIndexLocked(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!file_starts_.empty()) return Status::OK();
+        const std::vector<string>& filenames = dataset()->filenames_;
+        std::vector<std::vector<uint64>> offsets(filenames.size());
+        std::vector<Status> statuses(filenames.size());
+        BlockingCounter counter(filenames.size());
+        for (size_t i = 0; i < filenames.size(); ++i) {
+          (*ctx->runner())([this, ctx, &filenames, &offsets, &statuses,
+                            &counter, i]() {
+            Env* env = ctx->env();
+            Status s = io::ReadRecordIndex(
+                env, io::RecordIndexFilename(filenames[i]), &offsets[i]);
+            if (errors::IsNotFound(s)) {
+              LOG(WARNING) << "No record index for " << filenames[i]
+                           << "; scanning the file to build one.";
+              s = io::BuildRecordIndex(env, filenames[i], dataset()->options_,
+                                       &offsets[i]);
+            }
+            statuses[i] = s;
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
+        for (const Status& s : statuses) {
+          TF_RETURN_IF_ERROR(s);
+        }
+
+        std::vector<uint64> file_starts(1, 0);
+        for (const auto& file_offsets : offsets) {
+          file_starts.push_back(file_starts.back() + file_offsets.size());
+        }
+        if (dataset()->shuffle_) {
+          permutation_.resize(file_starts.back());
+          std::iota(permutation_.begin(), permutation_.end(), 0);
+          random::PhiloxRandom parent(dataset()->seed_, dataset()->seed2_);
+          random::SimplePhilox rng(&parent);
+          for (size_t i = permutation_.size(); i > 1; --i) {
+            std::swap(permutation_[i - 1], permutation_[rng.Uniform64(i)]);
+          }
+        }
+        offsets_ = std::move(offsets);
+        file_starts_ = std::move(file_starts);
+        return Status::OK();
+      }
+
+      // Returns a reader for the file at `file_index`, keeping the most
+      // recently used files open.
+      Status GetReaderLocked(Env* env, size_t file_index,
+                             io::RecordReader** reader)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (auto it = open_files_.begin(); it != open_files_.end(); ++it) {
+          if (it->file_index == file_index) {
+            std::rotate(open_files_.begin(), it, it + 1);
+            *reader = open_files_.front().reader.get();
+            return Status::OK();
+          }
+        }
+        OpenFile open_file;
+        open_file.file_index = file_index;
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+            dataset()->filenames_[file_index], &open_file.file));
+        // Records are read in index order, not sequentially, so there is no
+        // input buffering.
+        io::RecordReaderOptions options = dataset()->options_;
+        options.buffer_size = 0;
+        open_file.reader = absl::make_unique<io::RecordReader>(
+            open_file.file.get(), options);
+        open_files_.push_front(std::move(open_file));
+        if (open_files_.size() > kMaxOpenFiles) {
+          open_files_.pop_back();
+        }
+        *reader = open_files_.front().reader.get();
+        return Status::OK();
+      }
+
+      mutex mu_;
+      // Position in the (permuted) sequence of all records of the next
+      // record of this shard.
+      int64 next_position_ GUARDED_BY(mu_);
+      // Record offsets of each file, and the number of records in all files
+      // before each file, with the total at the end. Empty until loaded.
+      std::vector<std::vector<uint64>> offsets_ GUARDED_BY(mu_);
+      std::vector<uint64> file_starts_ GUARDED_BY(mu_);
+      std::vector<uint64> permutation_ GUARDED_BY(mu_);
+      std::deque<OpenFile> open_files_ GUARDED_BY(mu_);
+    };
+
+    const std::vector<string> filenames_;
+    const string compression_type_;
+    const io::RecordReaderOptions options_;
+    const int64 num_shards_;
+    const int64 shard_index_;
+    const int64 skip_;
+    const int64 seed_;
+    const int64 seed2_;
+    const bool shuffle_;
+  };
+
+  bool shuffle_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("IndexedTFRecordDataset").Device(DEVICE_CPU),
+                        IndexedTFRecordDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,166 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kNodeName[] = "indexed_tfrecord_dataset";
+
+class IndexedTFRecordDatasetOpTest : public DatasetOpsTestBase {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(InitThreadPool(/*thread_num=*/2));
+    TF_ASSERT_OK(InitFunctionLibraryRuntime({}, /*cpu_num=*/2));
+  }
+
+  // Writes records "<name>:<i>" for i in [0, num_records) to a new file, and
+  // returns its name.
+  string WriteFile(const string& name, int num_records, bool write_index,
+                   const string& compression_type = "") {
+    const string filename = io::JoinPath(testing::TmpDir(), name);
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(filename, &file));
+    io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions(compression_type);
+    options.write_index = write_index;
+    io::RecordWriter writer(file.get(), options);
+    for (int i = 0; i < num_records; ++i) {
+      TF_CHECK_OK(writer.WriteRecord(strings::StrCat(name, ":", i)));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+    return filename;
+  }
+
+  // Returns all records of a dataset over `filenames`.
+  Status ReadAll(const std::vector<string>& filenames,
+                 const string& compression_type, int64 num_shards,
+                 int64 shard_index, int64 skip, bool shuffle,
+                 std::vector<string>* records) {
+    NodeDef node_def = test::function::NDef(
+        kNodeName, "IndexedTFRecordDataset",
+        {"filenames", "compression_type", "num_shards", "shard_index", "skip",
+         "seed", "seed2"},
+        {{"shuffle", shuffle}});
+    std::unique_ptr<OpKernel> kernel;
+    TF_RETURN_IF_ERROR(CreateOpKernel(node_def, &kernel));
+
+    Tensor filenames_t = CreateTensor<string>(
+        TensorShape({static_cast<int64>(filenames.size())}), filenames);
+    Tensor compression_type_t =
+        CreateTensor<string>(TensorShape({}), {compression_type});
+    Tensor num_shards_t = CreateTensor<int64>(TensorShape({}), {num_shards});
+    Tensor shard_index_t = CreateTensor<int64>(TensorShape({}), {shard_index});
+    Tensor skip_t = CreateTensor<int64>(TensorShape({}), {skip});
+    Tensor seed_t = CreateTensor<int64>(TensorShape({}), {7});
+    Tensor seed2_t = CreateTensor<int64>(TensorShape({}), {11});
+    gtl::InlinedVector<TensorValue, 4> inputs(
+        {TensorValue(&filenames_t), TensorValue(&compression_type_t),
+         TensorValue(&num_shards_t), TensorValue(&shard_index_t),
+         TensorValue(&skip_t), TensorValue(&seed_t), TensorValue(&seed2_t)});
+    std::unique_ptr<OpKernelContext> context;
+    TF_RETURN_IF_ERROR(CreateOpKernelContext(kernel.get(), &inputs, &context));
+    DatasetBase* dataset;
+    TF_RETURN_IF_ERROR(CreateDataset(kernel.get(), context.get(), &dataset));
+    core::ScopedUnref scoped_unref(dataset);
+
+    std::unique_ptr<IteratorContext> iterator_context;
+    TF_RETURN_IF_ERROR(CreateIteratorContext(context.get(), &iterator_context));
+    std::unique_ptr<IteratorBase> iterator;
+    TF_RETURN_IF_ERROR(
+        dataset->MakeIterator(iterator_context.get(), "Iterator", &iterator));
+    while (true) {
+      std::vector<Tensor> out_tensors;
+      bool end_of_sequence = false;
+      TF_RETURN_IF_ERROR(iterator->GetNext(iterator_context.get(),
+                                           &out_tensors, &end_of_sequence));
+      if (end_of_sequence) return Status::OK();
+      records->push_back(out_tensors[0].scalar<string>()());
+    }
+  }
+};
+
+TEST_F(IndexedTFRecordDatasetOpTest, ReadsFilesWithAndWithoutIndex) {
+  const std::vector<string> filenames = {
+      WriteFile("indexed", 3, /*write_index=*/true),
+      WriteFile("not_indexed", 2, /*write_index=*/false)};
+  std::vector<string> records;
+  TF_ASSERT_OK(ReadAll(filenames, "", /*num_shards=*/1, /*shard_index=*/0,
+                       /*skip=*/0, /*shuffle=*/false, &records));
+  EXPECT_EQ(std::vector<string>({"indexed:0", "indexed:1", "indexed:2",
+                                 "not_indexed:0", "not_indexed:1"}),
+            records);
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, ShardAndSkip) {
+  const std::vector<string> filenames = {
+      WriteFile("shard_a", 4, /*write_index=*/true),
+      WriteFile("shard_b", 3, /*write_index=*/true)};
+  std::vector<string> records;
+  TF_ASSERT_OK(ReadAll(filenames, "", /*num_shards=*/2, /*shard_index=*/1,
+                       /*skip=*/1, /*shuffle=*/false, &records));
+  // Shard 1 holds records 1, 3 and 5 of all files; the first one is skipped.
+  EXPECT_EQ(std::vector<string>({"shard_a:3", "shard_b:1"}), records);
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, ShuffledShardsPartitionTheRecords) {
+  const std::vector<string> filenames = {
+      WriteFile("shuffle_a", 10, /*write_index=*/true),
+      WriteFile("shuffle_b", 7, /*write_index=*/false)};
+  std::vector<string> all_records;
+  TF_ASSERT_OK(ReadAll(filenames, "", /*num_shards=*/1, /*shard_index=*/0,
+                       /*skip=*/0, /*shuffle=*/false, &all_records));
+
+  // With the same seed, every shard sees the same permutation.
+  std::vector<string> shuffled_records;
+  for (int shard_index = 0; shard_index < 3; ++shard_index) {
+    TF_ASSERT_OK(ReadAll(filenames, "", /*num_shards=*/3, shard_index,
+                         /*skip=*/0, /*shuffle=*/true, &shuffled_records));
+  }
+  EXPECT_NE(all_records, shuffled_records);
+  std::sort(all_records.begin(), all_records.end());
+  std::sort(shuffled_records.begin(), shuffled_records.end());
+  EXPECT_EQ(all_records, shuffled_records);
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, CompressedFilesAreReadInOrder) {
+  const std::vector<string> filenames = {
+      WriteFile("compressed", 3, /*write_index=*/true, "GZIP")};
+  std::vector<string> records;
+  TF_ASSERT_OK(ReadAll(filenames, "GZIP", /*num_shards=*/2, /*shard_index=*/0,
+                       /*skip=*/0, /*shuffle=*/false, &records));
+  EXPECT_EQ(std::vector<string>({"compressed:0", "compressed:2"}), records);
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, ShuffleOfCompressedFilesIsRejected) {
+  const std::vector<string> filenames = {
+      WriteFile("compressed_shuffle", 3, /*write_index=*/true, "GZIP")};
+  std::vector<string> records;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      ReadAll(filenames, "GZIP", /*num_shards=*/1, /*shard_index=*/0,
+              /*skip=*/0, /*shuffle=*/true, &records)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,1165 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/parquet/parquet_file.h"
+
+#include <cstring>
+
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/experimental/parquet/thrift_compact.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "zlib.h"
+
+namespace tensorflow {
+namespace data {
+namespace parquet {
+namespace {
+
+using Type = ThriftCompactReader::Type;
+
+constexpr char kMagic[] = "PAR1";
+constexpr size_t kMagicSize = 4;
+constexpr size_t kFooterSize = kMagicSize + sizeof(uint32);
+
+// Bounds the nesting of the file schema to protect against corrupt input.
+constexpr int kMaxSchemaDepth = 64;
+
+// Field repetition types.
+constexpr int32 kRequired = 0;
+constexpr int32 kOptional = 1;
+constexpr int32 kRepeated = 2;
+
+// Converted types of unsigned integer columns.
+constexpr int32 kUint8 = 11;
+constexpr int32 kUint64 = 14;
+
+// Compression codecs.
+constexpr int32 kUncompressed = 0;
+constexpr int32 kSnappy = 1;
+constexpr int32 kGzip = 2;
+
+// Page types.
+constexpr int32 kDataPage = 0;
+constexpr int32 kDictionaryPage = 2;
+constexpr int32 kDataPageV2 = 3;
+
+// Encodings.
+constexpr int32 kPlain = 0;
+constexpr int32 kPlainDictionary = 2;
+constexpr int32 kRle = 3;
+constexpr int32 kRleDictionary = 8;
+
+// Reads the fields of a struct, invoking `read_field` for each of them.
+// `read_field` must consume the field value, or set `*handled` to false to
+// have it skipped.
+template <typename ReadField>
+Status ReadStruct(ThriftCompactReader* reader, ReadField read_field) {
+  TF_RETURN_IF_ERROR(reader->ReadStructBegin());
+  while (true) {
+    int16 id;
+    Type type;
+    TF_RETURN_IF_ERROR(reader->ReadFieldBegin(&id, &type));
+    if (type == ThriftCompactReader::kStop) break;
+    bool handled = true;
+    TF_RETURN_IF_ERROR(read_field(id, type, &handled));
+    if (!handled) {
+      TF_RETURN_IF_ERROR(reader->Skip(type));
+    }
+  }
+  return reader->ReadStructEnd();
+}
+
+// Reads the elements of a list of structs, invoking `read_element` for each.
+template <typename ReadElement>
+Status ReadStructList(ThriftCompactReader* reader, ReadElement read_element) {
+  Type element_type;
+  int64 size;
+  TF_RETURN_IF_ERROR(reader->ReadListBegin(&element_type, &size));
+  if (element_type != ThriftCompactReader::kStruct && size > 0) {
+    return errors::DataLoss("Expected a list of structs in Parquet metadata.");
+  }
+  for (int64 i = 0; i < size; ++i) {
+    TF_RETURN_IF_ERROR(read_element());
+  }
+  return Status::OK();
+}
+
+bool IsInteger(Type type) {
+  return type == ThriftCompactReader::kI16 ||
+         type == ThriftCompactReader::kI32 || type == ThriftCompactReader::kI64;
+}
+
+Status ReadStatistics(ThriftCompactReader* reader, ColumnStatistics* stats) {
+  string min, max, min_value, max_value;
+  bool has_min = false, has_max = false;
+  bool has_min_value = false, has_max_value = false;
+  TF_RETURN_IF_ERROR(
+      ReadStruct(reader, [&](int16 id, Type type, bool* handled) -> Status {
+        if (type != ThriftCompactReader::kBinary) {
+          *handled = false;
+          return Status::OK();
+        }
+        switch (id) {
+          case 1:
+            has_max = true;
+            return reader->ReadBinary(&max);
+          case 2:
+            has_min = true;
+            return reader->ReadBinary(&min);
+          case 5:
+            has_max_value = true;
+            return reader->ReadBinary(&max_value);
+          case 6:
+            has_min_value = true;
+            return reader->ReadBinary(&min_value);
+          default:
+            *handled = false;
+            return Status::OK();
+        }
+      }));
+  // `min_value` and `max_value` supersede the deprecated `min` and `max`.
+  if (has_min_value && has_max_value) {
+    stats->has_min_max = true;
+    stats->min = std::move(min_value);
+    stats->max = std::move(max_value);
+  } else if (has_min && has_max) {
+    stats->has_min_max = true;
+    stats->min = std::move(min);
+    stats->max = std::move(max);
+  }
+  return Status::OK();
+}
+
+Status ReadColumnMetaData(ThriftCompactReader* reader,
+                          ColumnChunkMetaData* chunk) {
+  return ReadStruct(reader, [&](int16 id, Type type, bool* handled) -> Status {
+    if (id == 12 && type == ThriftCompactReader::kStruct) {
+      return ReadStatistics(reader, &chunk->statistics);
+    }
+    if (!IsInteger(type)) {
+      *handled = false;
+      return Status::OK();
+    }
+    int64 value;
+    TF_RETURN_IF_ERROR(reader->ReadI64(&value));
+    switch (id) {
+      case 1:
+        chunk->type = static_cast<PhysicalType>(value);
+        break;
+      case 4:
+        chunk->codec = static_cast<int32>(value);
+        break;
+      case 5:
+        chunk->num_values = value;
+        break;
+      case 7:
+        chunk->total_compressed_size = value;
+        break;
+      case 9:
+        chunk->data_page_offset = value;
+        break;
+      case 11:
+        chunk->dictionary_page_offset = value;
+        break;
+    }
+    return Status::OK();
+  });
+}
+
+Status ReadColumnChunkMetaData(ThriftCompactReader* reader,
+                               ColumnChunkMetaData* chunk) {
+  bool has_meta_data = false;
+  TF_RETURN_IF_ERROR(
+      ReadStruct(reader, [&](int16 id, Type type, bool* handled) -> Status {
+        if (id == 1 && type == ThriftCompactReader::kBinary) {
+          return errors::Unimplemented(
+              "Parquet column chunks stored in separate files are not "
+              "supported.");
+        }
+        if (id == 3 && type == ThriftCompactReader::kStruct) {
+          has_meta_data = true;
+          return ReadColumnMetaData(reader, chunk);
+        }
+        *handled = false;
+        return Status::OK();
+      }));
+  if (!has_meta_data) {
+    return errors::DataLoss("Parquet column chunk without metadata.");
+  }
+  return Status::OK();
+}
+
+Status ReadRowGroup(ThriftCompactReader* reader, RowGroupMetaData* row_group) {
+  return ReadStruct(reader, [&](int16 id, Type type, bool* handled) -> Status {
+    if (id == 1 && type == ThriftCompactReader::kList) {
+      return ReadStructList(reader, [&]() {
+        row_group->columns.emplace_back();
+        return ReadColumnChunkMetaData(reader, &row_group->columns.back());
+      });
+    }
+    if (id == 3 && IsInteger(type)) {
+      return reader->ReadI64(&row_group->num_rows);
+    }
+    *handled = false;
+    return Status::OK();
+  });
+}
+
+struct SchemaElement {
+  bool has_type = false;
+  PhysicalType type = PhysicalType::INT32;
+  int32 type_length = 0;
+  int32 repetition_type = kRequired;
+  string name;
+  int32 num_children = 0;
+  int32 converted_type = -1;
+};
+
+Status ReadSchemaElement(ThriftCompactReader* reader, SchemaElement* element) {
+  return ReadStruct(reader, [&](int16 id, Type type, bool* handled) -> Status {
+    if (id == 4 && type == ThriftCompactReader::kBinary) {
+      return reader->ReadBinary(&element->name);
+    }
+    if (!IsInteger(type)) {
+      *handled = false;
+      return Status::OK();
+    }
+    int32 value;
+    TF_RETURN_IF_ERROR(reader->ReadI32(&value));
+    switch (id) {
+      case 1:
+        element->has_type = true;
+        element->type = static_cast<PhysicalType>(value);
+        break;
+      case 2:
+        element->type_length = value;
+        break;
+      case 3:
+        element->repetition_type = value;
+        break;
+      case 5:
+        element->num_children = value;
+        break;
+      case 6:
+        element->converted_type = value;
+        break;
+    }
+    return Status::OK();
+  });
+}
+
+// Appends the leaf columns of the schema subtree at `schema[*index]` to
+// `columns`, advancing `*index` past the subtree.
+Status AddColumns(const std::vector<SchemaElement>& schema,
+                  const string& prefix, int16 definition_level,
+                  int16 repetition_level, int16 repeated_definition_level,
+                  int depth, size_t* index,
+                  std::vector<ColumnDescriptor>* columns,
+                  std::vector<int32>* converted_types) {
+  if (depth > kMaxSchemaDepth) {
+    return errors::DataLoss("Parquet schema is nested too deep.");
+  }
+  if (*index >= schema.size()) {
+    return errors::DataLoss("Parquet schema has fewer elements than declared.");
+  }
+  const SchemaElement& element = schema[(*index)++];
+  const string path =
+      prefix.empty() ? element.name
+                     : strings::StrCat(prefix, ".", element.name);
+  if (element.repetition_type == kOptional) {
+    ++definition_level;
+  } else if (element.repetition_type == kRepeated) {
+    ++definition_level;
+    ++repetition_level;
+    repeated_definition_level = definition_level;
+  }
+  if (element.num_children > 0) {
+    for (int32 i = 0; i < element.num_children; ++i) {
+      TF_RETURN_IF_ERROR(AddColumns(schema, path, definition_level,
+                                    repetition_level, repeated_definition_level,
+                                    depth + 1, index, columns,
+                                    converted_types));
+    }
+    return Status::OK();
+  }
+  if (!element.has_type) {
+    return errors::DataLoss("Parquet schema leaf ", path, " has no type.");
+  }
+  columns->emplace_back();
+  ColumnDescriptor& column = columns->back();
+  column.path = path;
+  column.type = element.type;
+  column.type_length = element.type_length;
+  column.max_definition_level = definition_level;
+  column.max_repetition_level = repetition_level;
+  column.repeated_definition_level = repeated_definition_level;
+  converted_types->push_back(element.converted_type);
+  return Status::OK();
+}
+
+Status ReadMetaData(StringPiece data, FileMetaData* metadata,
+                    std::vector<int32>* converted_types) {
+  ThriftCompactReader reader(data);
+  std::vector<SchemaElement> schema;
+  TF_RETURN_IF_ERROR(
+      ReadStruct(&reader, [&](int16 id, Type type, bool* handled) -> Status {
+        if (id == 2 && type == ThriftCompactReader::kList) {
+          return ReadStructList(&reader, [&]() {
+            schema.emplace_back();
+            return ReadSchemaElement(&reader, &schema.back());
+          });
+        }
+        if (id == 3 && IsInteger(type)) {
+          return reader.ReadI64(&metadata->num_rows);
+        }
+        if (id == 4 && type == ThriftCompactReader::kList) {
+          return ReadStructList(&reader, [&]() {
+            metadata->row_groups.emplace_back();
+            return ReadRowGroup(&reader, &metadata->row_groups.back());
+          });
+        }
+        *handled = false;
+        return Status::OK();
+      }));
+  if (schema.empty()) {
+    return errors::DataLoss("Parquet file has no schema.");
+  }
+  // The first element is the root of the schema; its name is not part of the
+  // column paths.
+  size_t index = 1;
+  for (int32 i = 0; i < schema[0].num_children; ++i) {
+    TF_RETURN_IF_ERROR(AddColumns(schema, /*prefix=*/"", 0, 0, 0, 0, &index,
+                                  &metadata->columns, converted_types));
+  }
+  for (const RowGroupMetaData& row_group : metadata->row_groups) {
+    if (row_group.columns.size() != metadata->columns.size()) {
+      return errors::DataLoss("Parquet row group has ",
+                              row_group.columns.size(), " columns but the "
+                              "schema has ", metadata->columns.size(), ".");
+    }
+  }
+  return Status::OK();
+}
+
+Status ReadFully(RandomAccessFile* file, uint64 offset, size_t n,
+                 string* buffer) {
+  buffer->resize(n);
+  StringPiece result;
+  Status s = file->Read(offset, n, &result, &(*buffer)[0]);
+  if (!s.ok() && !errors::IsOutOfRange(s)) {
+    return s;
+  }
+  if (result.size() != n) {
+    return errors::DataLoss("Unexpected end of Parquet file at offset ",
+                            offset + result.size(), ".");
+  }
+  if (result.data() != buffer->data()) {
+    std::memcpy(&(*buffer)[0], result.data(), n);
+  }
+  return Status::OK();
+}
+
+// Decompresses a page of `uncompressed_size` bytes. `output` refers to either
+// `input` or `buffer`.
+Status Decompress(int32 codec, StringPiece input, int64 uncompressed_size,
+                  string* buffer, StringPiece* output) {
+  if (uncompressed_size < 0) {
+    return errors::DataLoss("Negative uncompressed Parquet page size.");
+  }
+  switch (codec) {
+    case kUncompressed:
+      if (input.size() != uncompressed_size) {
+        return errors::DataLoss("Uncompressed Parquet page has ", input.size(),
+                                " bytes instead of ", uncompressed_size, ".");
+      }
+      *output = input;
+      return Status::OK();
+    case kSnappy: {
+      size_t length;
+      if (!port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                              &length) ||
+          length != uncompressed_size) {
+        return errors::DataLoss("Corrupt Snappy compressed Parquet page.");
+      }
+      buffer->resize(length);
+      if (!port::Snappy_Uncompress(input.data(), input.size(), &(*buffer)[0])) {
+        return errors::DataLoss("Corrupt Snappy compressed Parquet page.");
+      }
+      *output = *buffer;
+      return Status::OK();
+    }
+    case kGzip: {
+      buffer->resize(uncompressed_size);
+      z_stream stream;
+      std::memset(&stream, 0, sizeof(stream));
+      // Adding 32 to the window bits accepts both gzip and zlib headers.
+      if (inflateInit2(&stream, MAX_WBITS + 32) != Z_OK) {
+        return errors::Internal("Failed to initialize zlib.");
+      }
+      stream.next_in =
+          reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+      stream.avail_in = input.size();
+      stream.next_out = reinterpret_cast<Bytef*>(&(*buffer)[0]);
+      stream.avail_out = uncompressed_size;
+      const int result = inflate(&stream, Z_FINISH);
+      const uLong total_out = stream.total_out;
+      inflateEnd(&stream);
+      if (result != Z_STREAM_END || total_out != uncompressed_size) {
+        return errors::DataLoss("Corrupt GZIP compressed Parquet page.");
+      }
+      *output = *buffer;
+      return Status::OK();
+    }
+    default:
+      return errors::Unimplemented("Unsupported Parquet compression codec ",
+                                   codec, ".");
+  }
+}
+
+// Returns the number of bits needed to represent values up to `max_value`.
+int BitWidth(int64 max_value) {
+  int width = 0;
+  while (max_value > 0) {
+    ++width;
+    max_value >>= 1;
+  }
+  return width;
+}
+
+// Decodes `n` values of the RLE / bit-packing hybrid encoding and appends them
+// to `out`.
+template <typename T>
+Status DecodeRle(StringPiece data, int bit_width, int64 n,
+                 std::vector<T>* out) {
+  if (bit_width > 32) {
+    return errors::DataLoss("Invalid RLE bit width ", bit_width, ".");
+  }
+  const uint64 mask = (uint64{1} << bit_width) - 1;
+  const int value_bytes = (bit_width + 7) / 8;
+  out->reserve(out->size() + n);
+  while (n > 0) {
+    uint64 header;
+    if (!core::GetVarint64(&data, &header)) {
+      return errors::DataLoss("Truncated RLE data in Parquet page.");
+    }
+    if (header & 1) {
+      // A bit-packed run of groups of 8 values, least significant bit first.
+      const uint64 num_groups = header >> 1;
+      if (num_groups > data.size()) {
+        return errors::DataLoss("Truncated RLE data in Parquet page.");
+      }
+      const int64 count = std::min<int64>(num_groups * 8, n);
+      if ((count * bit_width + 7) / 8 > data.size()) {
+        return errors::DataLoss("Truncated RLE data in Parquet page.");
+      }
+      const uint8* bytes = reinterpret_cast<const uint8*>(data.data());
+      for (int64 i = 0; i < count; ++i) {
+        const int64 bit = i * bit_width;
+        uint64 bits = 0;
+        for (int64 b = bit / 8, shift = 0; b * 8 < bit + bit_width;
+             ++b, shift += 8) {
+          bits |= static_cast<uint64>(bytes[b]) << shift;
+        }
+        out->push_back(static_cast<T>((bits >> (bit % 8)) & mask));
+      }
+      data.remove_prefix(std::min<uint64>(num_groups * bit_width, data.size()));
+      n -= count;
+    } else {
+      // A run of a repeated value.
+      const int64 count = std::min<int64>(header >> 1, n);
+      if (data.size() < value_bytes) {
+        return errors::DataLoss("Truncated RLE data in Parquet page.");
+      }
+      uint64 value = 0;
+      for (int i = 0; i < value_bytes; ++i) {
+        value |= static_cast<uint64>(static_cast<uint8>(data[i])) << (8 * i);
+      }
+      data.remove_prefix(value_bytes);
+      out->insert(out->end(), count, static_cast<T>(value & mask));
+      n -= count;
+    }
+  }
+  return Status::OK();
+}
+
+// Decodes `n` levels of at most `max_level` from `data`. Version 1 data pages
+// prefix the levels with their length in bytes; version 2 data pages store the
+// length in the page header.
+Status DecodeLevels(StringPiece* data, int32 encoding, int16 max_level,
+                    bool length_prefixed, int64 length, int64 n,
+                    std::vector<int16>* levels) {
+  if (max_level == 0) {
+    return Status::OK();
+  }
+  if (encoding != kRle) {
+    return errors::Unimplemented("Unsupported Parquet level encoding ",
+                                 encoding, ".");
+  }
+  if (length_prefixed) {
+    if (data->size() < sizeof(uint32)) {
+      return errors::DataLoss("Truncated levels in Parquet page.");
+    }
+    length = core::DecodeFixed32(data->data());
+    data->remove_prefix(sizeof(uint32));
+  }
+  if (length < 0 || length > data->size()) {
+    return errors::DataLoss("Truncated levels in Parquet page.");
+  }
+  TF_RETURN_IF_ERROR(DecodeRle(StringPiece(data->data(), length),
+                               BitWidth(max_level), n, levels));
+  data->remove_prefix(length);
+  for (auto it = levels->end() - n; it != levels->end(); ++it) {
+    if (*it > max_level) {
+      return errors::DataLoss("Invalid level in Parquet page.");
+    }
+  }
+  return Status::OK();
+}
+
+// Booleans are stored as bytes while decoding, to avoid `std::vector<bool>`.
+template <typename T>
+struct Storage {
+  using type = T;
+};
+
+template <>
+struct Storage<bool> {
+  using type = uint8;
+};
+
+Status DecodePlain(const ColumnDescriptor& column, StringPiece* data, int64 n,
+                   std::vector<uint8>* out) {
+  if (column.type != PhysicalType::BOOLEAN) {
+    return errors::Internal("Unexpected Parquet type for booleans.");
+  }
+  if ((n + 7) / 8 > data->size()) {
+    return errors::DataLoss("Truncated values in Parquet page.");
+  }
+  for (int64 i = 0; i < n; ++i) {
+    out->push_back(((*data)[i / 8] >> (i % 8)) & 1);
+  }
+  data->remove_prefix((n + 7) / 8);
+  return Status::OK();
+}
+
+template <typename T>
+Status DecodePlain(const ColumnDescriptor& column, StringPiece* data, int64 n,
+                   std::vector<T>* out) {
+  if (n * sizeof(T) > data->size()) {
+    return errors::DataLoss("Truncated values in Parquet page.");
+  }
+  // Parquet stores fixed-width values in little-endian byte order, which is
+  // also the byte order of the hosts TensorFlow runs on.
+  const size_t offset = out->size();
+  out->resize(offset + n);
+  std::memcpy(out->data() + offset, data->data(), n * sizeof(T));
+  data->remove_prefix(n * sizeof(T));
+  return Status::OK();
+}
+
+Status DecodePlain(const ColumnDescriptor& column, StringPiece* data, int64 n,
+                   std::vector<string>* out) {
+  out->reserve(out->size() + n);
+  for (int64 i = 0; i < n; ++i) {
+    size_t length = column.type_length;
+    if (column.type == PhysicalType::BYTE_ARRAY) {
+      if (data->size() < sizeof(uint32)) {
+        return errors::DataLoss("Truncated values in Parquet page.");
+      }
+      length = core::DecodeFixed32(data->data());
+      data->remove_prefix(sizeof(uint32));
+    }
+    if (length > data->size()) {
+      return errors::DataLoss("Truncated values in Parquet page.");
+    }
+    out->emplace_back(data->data(), length);
+    data->remove_prefix(length);
+  }
+  return Status::OK();
+}
+
+// Decodes the values of the pages of a column chunk into a tensor of type `T`.
+template <typename T>
+class ValueDecoder {
+ public:
+  explicit ValueDecoder(const ColumnDescriptor& column) : column_(column) {}
+
+  Status DecodeDictionary(StringPiece data, int32 encoding, int64 n) {
+    if (encoding != kPlain && encoding != kPlainDictionary) {
+      return errors::Unimplemented("Unsupported Parquet dictionary encoding ",
+                                   encoding, ".");
+    }
+    dictionary_.clear();
+    return DecodePlain(column_, &data, n, &dictionary_);
+  }
+
+  Status DecodeValues(StringPiece data, int32 encoding, int64 n) {
+    switch (encoding) {
+      case kPlain:
+        return DecodePlain(column_, &data, n, &values_);
+      case kPlainDictionary:
+      case kRleDictionary: {
+        if (n == 0) {
+          return Status::OK();
+        }
+        if (data.empty()) {
+          return errors::DataLoss("Truncated values in Parquet page.");
+        }
+        const int bit_width = static_cast<uint8>(data[0]);
+        data.remove_prefix(1);
+        indices_.clear();
+        TF_RETURN_IF_ERROR(DecodeRle(data, bit_width, n, &indices_));
+        values_.reserve(values_.size() + n);
+        for (uint32 index : indices_) {
+          if (index >= dictionary_.size()) {
+            return errors::DataLoss(
+                "Invalid dictionary index in Parquet page.");
+          }
+          values_.push_back(dictionary_[index]);
+        }
+        return Status::OK();
+      }
+      default:
+        return errors::Unimplemented("Unsupported Parquet encoding ", encoding,
+                                     ".");
+    }
+  }
+
+  void Finish(Tensor* values) {
+    *values = Tensor(DataTypeToEnum<T>::v(),
+                     TensorShape({static_cast<int64>(values_.size())}));
+    auto flat = values->flat<T>();
+    for (size_t i = 0; i < values_.size(); ++i) {
+      flat(i) = std::move(values_[i]);
+    }
+    values_.clear();
+  }
+
+ private:
+  const ColumnDescriptor& column_;
+  std::vector<typename Storage<T>::type> dictionary_;
+  std::vector<typename Storage<T>::type> values_;
+  std::vector<uint32> indices_;
+};
+
+struct PageHeader {
+  int32 type = -1;
+  int32 uncompressed_page_size = 0;
+  int32 compressed_page_size = 0;
+  int32 num_values = 0;
+  int32 encoding = kPlain;
+  int32 definition_level_encoding = kRle;
+  int32 repetition_level_encoding = kRle;
+  // Only set for version 2 data pages.
+  int32 definition_levels_byte_length = 0;
+  int32 repetition_levels_byte_length = 0;
+  bool is_compressed = true;
+};
+
+Status ReadPageHeader(ThriftCompactReader* reader, PageHeader* header) {
+  // The data page, dictionary page and version 2 data page headers share the
+  // fields of `PageHeader`.
+  auto read_int = [reader](Type type, int32* value, bool* handled) -> Status {
+    if (!IsInteger(type)) {
+      *handled = false;
+      return Status::OK();
+    }
+    return reader->ReadI32(value);
+  };
+  auto read_data_page_header = [&](int16 id, Type type,
+                                   bool* handled) -> Status {
+    switch (id) {
+      case 1:
+        return read_int(type, &header->num_values, handled);
+      case 2:
+        return read_int(type, &header->encoding, handled);
+      case 3:
+        return read_int(type, &header->definition_level_encoding, handled);
+      case 4:
+        return read_int(type, &header->repetition_level_encoding, handled);
+      default:
+        *handled = false;
+        return Status::OK();
+    }
+  };
+  auto read_dictionary_page_header = [&](int16 id, Type type,
+                                         bool* handled) -> Status {
+    switch (id) {
+      case 1:
+        return read_int(type, &header->num_values, handled);
+      case 2:
+        return read_int(type, &header->encoding, handled);
+      default:
+        *handled = false;
+        return Status::OK();
+    }
+  };
+  auto read_data_page_header_v2 = [&](int16 id, Type type,
+                                      bool* handled) -> Status {
+    switch (id) {
+      case 1:
+        return read_int(type, &header->num_values, handled);
+      case 4:
+        return read_int(type, &header->encoding, handled);
+      case 5:
+        return read_int(type, &header->definition_levels_byte_length, handled);
+      case 6:
+        return read_int(type, &header->repetition_levels_byte_length, handled);
+      case 7:
+        if (type == ThriftCompactReader::kBoolTrue ||
+            type == ThriftCompactReader::kBoolFalse) {
+          return reader->ReadBool(&header->is_compressed);
+        }
+        *handled = false;
+        return Status::OK();
+      default:
+        *handled = false;
+        return Status::OK();
+    }
+  };
+  return ReadStruct(reader, [&](int16 id, Type type, bool* handled) -> Status {
+    switch (id) {
+      case 1:
+        return read_int(type, &header->type, handled);
+      case 2:
+        return read_int(type, &header->uncompressed_page_size, handled);
+      case 3:
+        return read_int(type, &header->compressed_page_size, handled);
+    }
+    if (type != ThriftCompactReader::kStruct) {
+      *handled = false;
+      return Status::OK();
+    }
+    switch (id) {
+      case 5:
+        return ReadStruct(reader, read_data_page_header);
+      case 7:
+        return ReadStruct(reader, read_dictionary_page_header);
+      case 8:
+        return ReadStruct(reader, read_data_page_header_v2);
+      default:
+        *handled = false;
+        return Status::OK();
+    }
+  });
+}
+
+// Returns the number of non-null values among the last `n` entries.
+int64 CountValues(const ColumnDescriptor& column,
+                  const std::vector<int16>& definition_levels, int64 n) {
+  if (column.max_definition_level == 0) {
+    return n;
+  }
+  int64 count = 0;
+  for (auto it = definition_levels.end() - n; it != definition_levels.end();
+       ++it) {
+    if (*it == column.max_definition_level) ++count;
+  }
+  return count;
+}
+
+template <typename T>
+Status DecodeColumnChunk(const ColumnDescriptor& column,
+                         const ColumnChunkMetaData& chunk, StringPiece input,
+                         ColumnChunkData* data) {
+  ValueDecoder<T> decoder(column);
+  string buffer;
+  int64 num_entries = 0;
+  while (num_entries < chunk.num_values) {
+    if (input.empty()) {
+      return errors::DataLoss("Parquet column chunk ", column.path,
+                              " ended after ", num_entries, " of ",
+                              chunk.num_values, " values.");
+    }
+    ThriftCompactReader reader(input);
+    PageHeader header;
+    TF_RETURN_IF_ERROR(ReadPageHeader(&reader, &header));
+    input.remove_prefix(reader.position());
+    if (header.compressed_page_size < 0 ||
+        header.compressed_page_size > input.size() || header.num_values < 0) {
+      return errors::DataLoss("Corrupt page header in Parquet column chunk ",
+                              column.path, ".");
+    }
+    StringPiece page(input.data(), header.compressed_page_size);
+    input.remove_prefix(header.compressed_page_size);
+    StringPiece body;
+    switch (header.type) {
+      case kDictionaryPage:
+        TF_RETURN_IF_ERROR(Decompress(chunk.codec, page,
+                                      header.uncompressed_page_size, &buffer,
+                                      &body));
+        TF_RETURN_IF_ERROR(decoder.DecodeDictionary(body, header.encoding,
+                                                    header.num_values));
+        break;
+      case kDataPage: {
+        TF_RETURN_IF_ERROR(Decompress(chunk.codec, page,
+                                      header.uncompressed_page_size, &buffer,
+                                      &body));
+        const int64 n = header.num_values;
+        TF_RETURN_IF_ERROR(DecodeLevels(
+            &body, header.repetition_level_encoding,
+            column.max_repetition_level, /*length_prefixed=*/true, 0, n,
+            &data->repetition_levels));
+        TF_RETURN_IF_ERROR(DecodeLevels(
+            &body, header.definition_level_encoding,
+            column.max_definition_level, /*length_prefixed=*/true, 0, n,
+            &data->definition_levels));
+        TF_RETURN_IF_ERROR(decoder.DecodeValues(
+            body, header.encoding,
+            CountValues(column, data->definition_levels, n)));
+        num_entries += n;
+        break;
+      }
+      case kDataPageV2: {
+        // Levels are never compressed in version 2 data pages.
+        const int64 levels_length = static_cast<int64>(
+                                        header.repetition_levels_byte_length) +
+                                    header.definition_levels_byte_length;
+        if (header.repetition_levels_byte_length < 0 ||
+            header.definition_levels_byte_length < 0 ||
+            levels_length > page.size()) {
+          return errors::DataLoss("Corrupt page header in Parquet column ",
+                                  "chunk ", column.path, ".");
+        }
+        StringPiece levels(page.data(), levels_length);
+        page.remove_prefix(levels_length);
+        const int64 n = header.num_values;
+        TF_RETURN_IF_ERROR(DecodeLevels(
+            &levels, kRle, column.max_repetition_level,
+            /*length_prefixed=*/false, header.repetition_levels_byte_length, n,
+            &data->repetition_levels));
+        TF_RETURN_IF_ERROR(DecodeLevels(
+            &levels, kRle, column.max_definition_level,
+            /*length_prefixed=*/false, header.definition_levels_byte_length, n,
+            &data->definition_levels));
+        TF_RETURN_IF_ERROR(Decompress(
+            header.is_compressed ? chunk.codec : kUncompressed, page,
+            header.uncompressed_page_size - levels_length, &buffer, &body));
+        TF_RETURN_IF_ERROR(decoder.DecodeValues(
+            body, header.encoding,
+            CountValues(column, data->definition_levels, n)));
+        num_entries += n;
+        break;
+      }
+      default:
+        // Index pages carry no values.
+        break;
+    }
+  }
+  decoder.Finish(&data->values);
+  data->num_entries = num_entries;
+  return Status::OK();
+}
+
+// Decodes a PLAIN encoded statistic of a numeric column.
+bool DecodeStatistic(PhysicalType type, const string& bytes, double* value) {
+  switch (type) {
+    case PhysicalType::BOOLEAN:
+      if (bytes.size() != 1) return false;
+      *value = bytes[0] != 0;
+      return true;
+    case PhysicalType::INT32: {
+      int32 v;
+      if (bytes.size() != sizeof(v)) return false;
+      std::memcpy(&v, bytes.data(), sizeof(v));
+      *value = v;
+      return true;
+    }
+    case PhysicalType::INT64: {
+      int64 v;
+      if (bytes.size() != sizeof(v)) return false;
+      std::memcpy(&v, bytes.data(), sizeof(v));
+      *value = v;
+      return true;
+    }
+    case PhysicalType::FLOAT: {
+      float v;
+      if (bytes.size() != sizeof(v)) return false;
+      std::memcpy(&v, bytes.data(), sizeof(v));
+      *value = v;
+      return true;
+    }
+    case PhysicalType::DOUBLE: {
+      if (bytes.size() != sizeof(*value)) return false;
+      std::memcpy(value, bytes.data(), sizeof(*value));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Gathers `indices` of the 1-D tensor `values` into `output`, using a
+// default-constructed value for negative indices.
+template <typename T>
+void Gather(const Tensor& values, const std::vector<int64>& indices,
+            Tensor* output) {
+  *output = Tensor(values.dtype(),
+                   TensorShape({static_cast<int64>(indices.size())}));
+  auto input = values.flat<T>();
+  auto out = output->flat<T>();
+  for (size_t i = 0; i < indices.size(); ++i) {
+    out(i) = indices[i] < 0 ? T() : input(indices[i]);
+  }
+}
+
+}  // namespace
+
+int FileMetaData::FindColumn(StringPiece path) const {
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (columns[i].path == path) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+DataType DecodedType(PhysicalType type) {
+  switch (type) {
+    case PhysicalType::BOOLEAN:
+      return DT_BOOL;
+    case PhysicalType::INT32:
+      return DT_INT32;
+    case PhysicalType::INT64:
+      return DT_INT64;
+    case PhysicalType::FLOAT:
+      return DT_FLOAT;
+    case PhysicalType::DOUBLE:
+      return DT_DOUBLE;
+    case PhysicalType::BYTE_ARRAY:
+    case PhysicalType::FIXED_LEN_BYTE_ARRAY:
+      return DT_STRING;
+    default:
+      return DT_INVALID;
+  }
+}
+
+Status ReadFileMetaData(RandomAccessFile* file, uint64 file_size,
+                        FileMetaData* metadata) {
+  if (file_size < kMagicSize + kFooterSize) {
+    return errors::DataLoss("File of ", file_size,
+                            " bytes is too small to be a Parquet file.");
+  }
+  string footer;
+  TF_RETURN_IF_ERROR(
+      ReadFully(file, file_size - kFooterSize, kFooterSize, &footer));
+  if (footer.compare(sizeof(uint32), kMagicSize, kMagic) != 0) {
+    return errors::DataLoss("Not a Parquet file: missing footer magic.");
+  }
+  const uint64 metadata_size = core::DecodeFixed32(footer.data());
+  if (metadata_size > file_size - kMagicSize - kFooterSize) {
+    return errors::DataLoss("Invalid Parquet metadata size ", metadata_size,
+                            ".");
+  }
+  string buffer;
+  TF_RETURN_IF_ERROR(ReadFully(file, file_size - kFooterSize - metadata_size,
+                               metadata_size, &buffer));
+  *metadata = FileMetaData();
+  std::vector<int32> converted_types;
+  TF_RETURN_IF_ERROR(ReadMetaData(buffer, metadata, &converted_types));
+  // Statistics of unsigned columns are ordered differently from the signed
+  // values they are decoded to, so they cannot be used to skip row groups.
+  for (size_t i = 0; i < converted_types.size(); ++i) {
+    if (converted_types[i] >= kUint8 && converted_types[i] <= kUint64) {
+      for (RowGroupMetaData& row_group : metadata->row_groups) {
+        row_group.columns[i].statistics.has_min_max = false;
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status ReadColumnChunk(RandomAccessFile* file, const FileMetaData& metadata,
+                       int row_group, int column, ColumnChunkData* data) {
+  const ColumnDescriptor& descriptor = metadata.columns[column];
+  const ColumnChunkMetaData& chunk =
+      metadata.row_groups[row_group].columns[column];
+  if (descriptor.max_repetition_level > 1) {
+    return errors::Unimplemented("Parquet column ", descriptor.path,
+                                 " has nested repetition, which is not "
+                                 "supported.");
+  }
+  // Some writers set the dictionary page offset to 0 when there is none; the
+  // dictionary page always precedes the data pages.
+  int64 offset = chunk.data_page_offset;
+  if (chunk.dictionary_page_offset > 0 &&
+      chunk.dictionary_page_offset < offset) {
+    offset = chunk.dictionary_page_offset;
+  }
+  if (offset < 0 || chunk.total_compressed_size < 0) {
+    return errors::DataLoss("Invalid offset of Parquet column chunk ",
+                            descriptor.path, ".");
+  }
+  string buffer;
+  TF_RETURN_IF_ERROR(
+      ReadFully(file, offset, chunk.total_compressed_size, &buffer));
+  *data = ColumnChunkData();
+  switch (DecodedType(descriptor.type)) {
+    case DT_BOOL:
+      return DecodeColumnChunk<bool>(descriptor, chunk, buffer, data);
+    case DT_INT32:
+      return DecodeColumnChunk<int32>(descriptor, chunk, buffer, data);
+    case DT_INT64:
+      return DecodeColumnChunk<int64>(descriptor, chunk, buffer, data);
+    case DT_FLOAT:
+      return DecodeColumnChunk<float>(descriptor, chunk, buffer, data);
+    case DT_DOUBLE:
+      return DecodeColumnChunk<double>(descriptor, chunk, buffer, data);
+    case DT_STRING:
+      return DecodeColumnChunk<string>(descriptor, chunk, buffer, data);
+    default:
+      return errors::Unimplemented("Parquet column ", descriptor.path,
+                                   " has unsupported physical type ",
+                                   static_cast<int>(descriptor.type), ".");
+  }
+}
+
+ColumnReader::ColumnReader(const ColumnDescriptor& column,
+                           ColumnChunkData data)
+    : column_(column), data_(std::move(data)) {}
+
+Status ColumnReader::ReadRows(int64 num_rows, Tensor* values,
+                              std::vector<int64>* row_lengths) {
+  const bool has_definition_levels = column_.max_definition_level > 0;
+  const int64 first_value = value_;
+  // The positions of the values in `data_.values`, with -1 for nulls.
+  std::vector<int64> indices;
+  bool has_nulls = false;
+  auto read_entry = [&]() {
+    if (!has_definition_levels ||
+        data_.definition_levels[entry_] == column_.max_definition_level) {
+      if (values) indices.push_back(value_);
+      ++value_;
+    } else {
+      if (values) indices.push_back(-1);
+      has_nulls = true;
+    }
+  };
+  if (column_.max_repetition_level == 0) {
+    if (num_rows > data_.num_entries - entry_) {
+      return errors::OutOfRange("Read past the end of Parquet column chunk ",
+                                column_.path, ".");
+    }
+    for (int64 i = 0; i < num_rows; ++i, ++entry_) {
+      read_entry();
+    }
+  } else {
+    for (int64 i = 0; i < num_rows; ++i) {
+      if (entry_ >= data_.num_entries ||
+          data_.repetition_levels[entry_] != 0) {
+        return errors::OutOfRange("Read past the end of Parquet column chunk ",
+                                  column_.path, ".");
+      }
+      int64 length = 0;
+      do {
+        // Entries below the definition level of the repeated node are null
+        // or empty lists.
+        if (data_.definition_levels[entry_] >=
+            column_.repeated_definition_level) {
+          read_entry();
+          ++length;
+        }
+        ++entry_;
+      } while (entry_ < data_.num_entries &&
+               data_.repetition_levels[entry_] != 0);
+      if (row_lengths) row_lengths->push_back(length);
+    }
+  }
+  if (!values) {
+    return Status::OK();
+  }
+  if (!has_nulls) {
+    *values = tensor::DeepCopy(data_.values.Slice(first_value, value_));
+    return Status::OK();
+  }
+  switch (data_.values.dtype()) {
+    case DT_BOOL:
+      Gather<bool>(data_.values, indices, values);
+      break;
+    case DT_INT32:
+      Gather<int32>(data_.values, indices, values);
+      break;
+    case DT_INT64:
+      Gather<int64>(data_.values, indices, values);
+      break;
+    case DT_FLOAT:
+      Gather<float>(data_.values, indices, values);
+      break;
+    case DT_DOUBLE:
+      Gather<double>(data_.values, indices, values);
+      break;
+    case DT_STRING:
+      Gather<string>(data_.values, indices, values);
+      break;
+    default:
+      return errors::Internal("Unexpected decoded Parquet type.");
+  }
+  return Status::OK();
+}
+
+/* static */
+Status Predicate::ParseOp(StringPiece op, Op* result) {
+  if (op == "==") {
+    *result = kEqual;
+  } else if (op == "!=") {
+    *result = kNotEqual;
+  } else if (op == "<") {
+    *result = kLess;
+  } else if (op == "<=") {
+    *result = kLessEqual;
+  } else if (op == ">") {
+    *result = kGreater;
+  } else if (op == ">=") {
+    *result = kGreaterEqual;
+  } else {
+    return errors::InvalidArgument("Unsupported predicate operator: ", op);
+  }
+  return Status::OK();
+}
+
+bool RowGroupMayMatch(const FileMetaData& metadata, int row_group,
+                      const Predicate& predicate) {
+  const ColumnStatistics& stats =
+      metadata.row_groups[row_group].columns[predicate.column].statistics;
+  double min, max;
+  const PhysicalType type = metadata.columns[predicate.column].type;
+  if (!stats.has_min_max || !DecodeStatistic(type, stats.min, &min) ||
+      !DecodeStatistic(type, stats.max, &max)) {
+    return true;
+  }
+  // Comparisons with NaN are false, so NaN bounds never exclude a row group.
+  const double value = predicate.value;
+  switch (predicate.op) {
+    case Predicate::kEqual:
+      return !(value < min || value > max);
+    case Predicate::kNotEqual:
+      return !(min == value && max == value);
+    case Predicate::kLess:
+      return !(min >= value);
+    case Predicate::kLessEqual:
+      return !(min > value);
+    case Predicate::kGreater:
+      return !(max <= value);
+    case Predicate::kGreaterEqual:
+      return !(max < value);
+  }
+  return true;
+}
+
+}  // namespace parquet
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,168 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PARQUET_PARQUET_FILE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PARQUET_PARQUET_FILE_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+namespace parquet {
+
+// A minimal reader for the Apache Parquet file format
+// (https://github.com/apache/parquet-format).
+//
+// The reader supports flat columns and columns with a single level of
+// repetition (e.g. lists of primitive values), the PLAIN and dictionary
+// encodings, version 1 and 2 data pages, and the UNCOMPRESSED, SNAPPY and
+// GZIP codecs. Files are accessed through `RandomAccessFile`, so any file
+// system registered with TensorFlow can be read.
+
+// Physical types, as numbered by the Parquet format.
+enum class PhysicalType {
+  BOOLEAN = 0,
+  INT32 = 1,
+  INT64 = 2,
+  INT96 = 3,
+  FLOAT = 4,
+  DOUBLE = 5,
+  BYTE_ARRAY = 6,
+  FIXED_LEN_BYTE_ARRAY = 7,
+};
+
+// Describes a leaf column of the file schema.
+struct ColumnDescriptor {
+  // The names of the schema nodes leading to this column, joined by dots.
+  string path;
+  PhysicalType type = PhysicalType::INT32;
+  // The length of FIXED_LEN_BYTE_ARRAY values.
+  int32 type_length = 0;
+  int16 max_definition_level = 0;
+  int16 max_repetition_level = 0;
+  // For repeated columns, the definition level at which the innermost
+  // repeated node is defined, i.e. the smallest level of a list element.
+  int16 repeated_definition_level = 0;
+};
+
+// Minimum and maximum values of a column chunk, in PLAIN encoding.
+struct ColumnStatistics {
+  bool has_min_max = false;
+  string min;
+  string max;
+};
+
+struct ColumnChunkMetaData {
+  PhysicalType type = PhysicalType::INT32;
+  int32 codec = 0;
+  int64 num_values = 0;
+  int64 data_page_offset = 0;
+  // Negative if the column chunk has no dictionary page.
+  int64 dictionary_page_offset = -1;
+  int64 total_compressed_size = 0;
+  ColumnStatistics statistics;
+};
+
+struct RowGroupMetaData {
+  int64 num_rows = 0;
+  // Indexed like `FileMetaData::columns`.
+  std::vector<ColumnChunkMetaData> columns;
+};
+
+struct FileMetaData {
+  int64 num_rows = 0;
+  std::vector<ColumnDescriptor> columns;
+  std::vector<RowGroupMetaData> row_groups;
+
+  // Returns the index of the column with the given path, or -1.
+  int FindColumn(StringPiece path) const;
+};
+
+// Returns the TensorFlow type that values of `type` are decoded to, or
+// `DT_INVALID` if the type is not supported.
+DataType DecodedType(PhysicalType type);
+
+// Reads the metadata from the footer of a Parquet file of `file_size` bytes.
+Status ReadFileMetaData(RandomAccessFile* file, uint64 file_size,
+                        FileMetaData* metadata);
+
+// The decoded contents of a column chunk.
+struct ColumnChunkData {
+  // The non-null values of the column chunk, in order, as a 1-D tensor of
+  // type `DecodedType(column.type)`.
+  Tensor values;
+  // The definition and repetition level of each entry. Empty if the
+  // corresponding maximum level of the column is 0.
+  std::vector<int16> definition_levels;
+  std::vector<int16> repetition_levels;
+  // The number of entries (values and nulls) in the column chunk.
+  int64 num_entries = 0;
+};
+
+// Reads and decodes column `column` of row group `row_group`.
+Status ReadColumnChunk(RandomAccessFile* file, const FileMetaData& metadata,
+                       int row_group, int column, ColumnChunkData* data);
+
+// Reads the rows of a decoded column chunk in order.
+//
+// Null values are read as zero (or the empty string). Rows of repeated
+// columns are read as lists; null lists are read as empty lists.
+class ColumnReader {
+ public:
+  ColumnReader(const ColumnDescriptor& column, ColumnChunkData data);
+
+  // Reads the next `num_rows` rows. `values` is set to a 1-D tensor of the
+  // values of these rows. For repeated columns, the number of values of each
+  // row is appended to `row_lengths`. If `values` is `nullptr`, the rows are
+  // skipped.
+  Status ReadRows(int64 num_rows, Tensor* values,
+                  std::vector<int64>* row_lengths);
+
+ private:
+  const ColumnDescriptor column_;
+  const ColumnChunkData data_;
+  // The next entry (for levels) and non-null value to read.
+  int64 entry_ = 0;
+  int64 value_ = 0;
+};
+
+// A comparison between a column and a constant, used to skip row groups whose
+// statistics prove that no row satisfies it.
+struct Predicate {
+  enum Op { kEqual, kNotEqual, kLess, kLessEqual, kGreater, kGreaterEqual };
+
+  int column = 0;
+  Op op = kEqual;
+  double value = 0;
+
+  // Parses one of "==", "!=", "<", "<=", ">" and ">=".
+  static Status ParseOp(StringPiece op, Op* result);
+};
+
+// Returns `false` if the statistics of `row_group` prove that none of its
+// rows satisfies `predicate`. Columns of non-numeric types, and column chunks
+// without statistics, always may match.
+bool RowGroupMayMatch(const FileMetaData& metadata, int row_group,
+                      const Predicate& predicate);
+
+}  // namespace parquet
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PARQUET_PARQUET_FILE_H_
@@ -0,0 +1,545 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/parquet/parquet_file.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/data/experimental/parquet/thrift_compact.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "zlib.h"
+
+namespace tensorflow {
+namespace data {
+namespace parquet {
+namespace {
+
+using Type = ThriftCompactReader::Type;
+
+// Serializes values with the Thrift compact protocol.
+class ThriftWriter {
+ public:
+  void StructBegin() {
+    ids_.push_back(last_id_);
+    last_id_ = 0;
+  }
+
+  void StructEnd() {
+    out_.push_back(0);
+    last_id_ = ids_.back();
+    ids_.pop_back();
+  }
+
+  void StructField(int16 id) {
+    FieldBegin(id, ThriftCompactReader::kStruct);
+    StructBegin();
+  }
+
+  void I32Field(int16 id, int32 value) {
+    FieldBegin(id, ThriftCompactReader::kI32);
+    ZigZag(value);
+  }
+
+  void I64Field(int16 id, int64 value) {
+    FieldBegin(id, ThriftCompactReader::kI64);
+    ZigZag(value);
+  }
+
+  void BoolField(int16 id, bool value) {
+    FieldBegin(id, value ? ThriftCompactReader::kBoolTrue
+                         : ThriftCompactReader::kBoolFalse);
+  }
+
+  void BinaryField(int16 id, const string& value) {
+    FieldBegin(id, ThriftCompactReader::kBinary);
+    Binary(value);
+  }
+
+  void ListField(int16 id, Type element_type, int64 size) {
+    FieldBegin(id, ThriftCompactReader::kList);
+    if (size < 15) {
+      out_.push_back(static_cast<char>((size << 4) | element_type));
+    } else {
+      out_.push_back(static_cast<char>(0xf0 | element_type));
+      core::PutVarint64(&out_, size);
+    }
+  }
+
+  void I32(int32 value) { ZigZag(value); }
+
+  void Binary(const string& value) {
+    core::PutVarint64(&out_, value.size());
+    out_.append(value);
+  }
+
+  const string& out() const { return out_; }
+
+ private:
+  void FieldBegin(int16 id, Type type) {
+    const int delta = id - last_id_;
+    if (delta > 0 && delta <= 15) {
+      out_.push_back(static_cast<char>((delta << 4) | type));
+    } else {
+      out_.push_back(static_cast<char>(type));
+      ZigZag(id);
+    }
+    last_id_ = id;
+  }
+
+  void ZigZag(int64 value) {
+    core::PutVarint64(&out_, (static_cast<uint64>(value) << 1) ^
+                                 static_cast<uint64>(value >> 63));
+  }
+
+  string out_;
+  int16 last_id_ = 0;
+  std::vector<int16> ids_;
+};
+
+// Encodes a run of `count` copies of `value`.
+string RleRun(uint32 value, int count, int bit_width) {
+  string out;
+  core::PutVarint64(&out, count << 1);
+  for (int i = 0; i < (bit_width + 7) / 8; ++i) {
+    out.push_back(static_cast<char>(value >> (8 * i)));
+  }
+  return out;
+}
+
+// Encodes `values` as a bit-packed run.
+string BitPacked(const std::vector<uint32>& values, int bit_width) {
+  const int num_groups = (values.size() + 7) / 8;
+  string out;
+  core::PutVarint64(&out, (num_groups << 1) | 1);
+  string bits(num_groups * bit_width, '\0');
+  for (size_t i = 0; i < values.size(); ++i) {
+    for (int b = 0; b < bit_width; ++b) {
+      if (values[i] & (1u << b)) {
+        const size_t bit = i * bit_width + b;
+        bits[bit / 8] |= 1 << (bit % 8);
+      }
+    }
+  }
+  return out + bits;
+}
+
+// Prefixes version 1 data page levels with their length.
+string Levels(const string& rle) {
+  string out;
+  core::PutFixed32(&out, rle.size());
+  return out + rle;
+}
+
+string PlainInt32(const std::vector<int32>& values) {
+  string out;
+  for (int32 v : values) core::PutFixed32(&out, v);
+  return out;
+}
+
+string PlainInt64(const std::vector<int64>& values) {
+  string out;
+  for (int64 v : values) core::PutFixed64(&out, v);
+  return out;
+}
+
+string PlainDouble(const std::vector<double>& values) {
+  return string(reinterpret_cast<const char*>(values.data()),
+                values.size() * sizeof(double));
+}
+
+string PlainStrings(const std::vector<string>& values) {
+  string out;
+  for (const string& v : values) {
+    core::PutFixed32(&out, v.size());
+    out.append(v);
+  }
+  return out;
+}
+
+string Gzip(const string& data) {
+  uLongf length = compressBound(data.size());
+  string out(length, '\0');
+  CHECK_EQ(Z_OK, compress2(reinterpret_cast<Bytef*>(&out[0]), &length,
+                           reinterpret_cast<const Bytef*>(data.data()),
+                           data.size(), Z_DEFAULT_COMPRESSION));
+  out.resize(length);
+  return out;
+}
+
+string DictionaryPage(const string& body, int32 num_values) {
+  ThriftWriter w;
+  w.StructBegin();
+  w.I32Field(1, 2);
+  w.I32Field(2, body.size());
+  w.I32Field(3, body.size());
+  w.StructField(7);
+  w.I32Field(1, num_values);
+  w.I32Field(2, 0);
+  w.StructEnd();
+  w.StructEnd();
+  return w.out() + body;
+}
+
+string DataPage(const string& body, int32 num_values, int32 encoding) {
+  ThriftWriter w;
+  w.StructBegin();
+  w.I32Field(1, 0);
+  w.I32Field(2, body.size());
+  w.I32Field(3, body.size());
+  w.StructField(5);
+  w.I32Field(1, num_values);
+  w.I32Field(2, encoding);
+  w.I32Field(3, 3);
+  w.I32Field(4, 3);
+  w.StructEnd();
+  w.StructEnd();
+  return w.out() + body;
+}
+
+// A version 2 data page with GZIP compressed values.
+string DataPageV2(const string& repetition_levels,
+                  const string& definition_levels, const string& values,
+                  int32 num_values) {
+  const string compressed = Gzip(values);
+  const string levels = repetition_levels + definition_levels;
+  ThriftWriter w;
+  w.StructBegin();
+  w.I32Field(1, 3);
+  w.I32Field(2, levels.size() + values.size());
+  w.I32Field(3, levels.size() + compressed.size());
+  w.StructField(8);
+  w.I32Field(1, num_values);
+  w.I32Field(2, 0);
+  w.I32Field(3, num_values);
+  w.I32Field(4, 0);
+  w.I32Field(5, definition_levels.size());
+  w.I32Field(6, repetition_levels.size());
+  w.BoolField(7, true);
+  w.StructEnd();
+  w.StructEnd();
+  return w.out() + levels + compressed;
+}
+
+struct SchemaElement {
+  string name;
+  int32 type;  // Negative for groups.
+  int32 repetition_type;
+  int32 num_children;
+  int32 converted_type;
+};
+
+struct Chunk {
+  PhysicalType type;
+  int32 codec;
+  int64 num_values;
+  // The size of the dictionary page at the start of `pages`, if any.
+  size_t dictionary_size;
+  string pages;
+  // PLAIN encoded statistics; empty if there are none.
+  string min;
+  string max;
+};
+
+// Writes a Parquet file with the given schema and row groups.
+string MakeFile(const std::vector<SchemaElement>& schema,
+                const std::vector<std::pair<int64, std::vector<Chunk>>>&
+                    row_groups) {
+  string file = "PAR1";
+  std::vector<std::vector<int64>> offsets;
+  int64 num_rows = 0;
+  for (const auto& row_group : row_groups) {
+    num_rows += row_group.first;
+    offsets.emplace_back();
+    for (const Chunk& chunk : row_group.second) {
+      offsets.back().push_back(file.size());
+      file.append(chunk.pages);
+    }
+  }
+  ThriftWriter w;
+  w.StructBegin();
+  w.I32Field(1, 1);
+  w.ListField(2, ThriftCompactReader::kStruct, schema.size());
+  for (const SchemaElement& element : schema) {
+    w.StructBegin();
+    if (element.type >= 0) w.I32Field(1, element.type);
+    if (element.repetition_type >= 0) w.I32Field(3, element.repetition_type);
+    w.BinaryField(4, element.name);
+    if (element.num_children > 0) w.I32Field(5, element.num_children);
+    if (element.converted_type >= 0) w.I32Field(6, element.converted_type);
+    w.StructEnd();
+  }
+  w.I64Field(3, num_rows);
+  w.ListField(4, ThriftCompactReader::kStruct, row_groups.size());
+  for (size_t i = 0; i < row_groups.size(); ++i) {
+    w.StructBegin();
+    w.ListField(1, ThriftCompactReader::kStruct, row_groups[i].second.size());
+    for (size_t j = 0; j < row_groups[i].second.size(); ++j) {
+      const Chunk& chunk = row_groups[i].second[j];
+      const int64 offset = offsets[i][j];
+      w.StructBegin();
+      w.I64Field(2, offset);
+      w.StructField(3);
+      w.I32Field(1, static_cast<int32>(chunk.type));
+      // Encodings and path, which the reader skips.
+      w.ListField(2, ThriftCompactReader::kI32, 2);
+      w.I32(0);
+      w.I32(3);
+      w.ListField(3, ThriftCompactReader::kBinary, 1);
+      w.Binary("ignored");
+      w.I32Field(4, chunk.codec);
+      w.I64Field(5, chunk.num_values);
+      w.I64Field(6, chunk.pages.size());
+      w.I64Field(7, chunk.pages.size());
+      w.I64Field(9, offset + chunk.dictionary_size);
+      if (chunk.dictionary_size > 0) w.I64Field(11, offset);
+      if (!chunk.min.empty()) {
+        w.StructField(12);
+        w.BinaryField(5, chunk.max);
+        w.BinaryField(6, chunk.min);
+        w.StructEnd();
+      }
+      w.StructEnd();
+      w.StructEnd();
+    }
+    w.I64Field(2, 0);
+    w.I64Field(3, row_groups[i].first);
+    w.StructEnd();
+  }
+  w.StructEnd();
+  file.append(w.out());
+  core::PutFixed32(&file, w.out().size());
+  file.append("PAR1");
+  return file;
+}
+
+class ParquetFileTest : public ::testing::Test {
+ protected:
+  Status Open(const string& name, const string& contents) {
+    const string filename = io::JoinPath(testing::TmpDir(), name);
+    TF_RETURN_IF_ERROR(WriteStringToFile(Env::Default(), filename, contents));
+    TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(filename, &file_));
+    return ReadFileMetaData(file_.get(), contents.size(), &metadata_);
+  }
+
+  std::unique_ptr<RandomAccessFile> file_;
+  FileMetaData metadata_;
+};
+
+// A file with a required INT64 column `id`, an optional DOUBLE column `score`
+// and a dictionary encoded BYTE_ARRAY column `name`, in two row groups:
+//
+//   id  score  name
+//   1   0.5    "b"
+//   2   null   "a"
+//   3   2.5    "b"
+//   ---------------
+//   10  null   "c"
+//   11  4.0    "d"
+string FlatFile() {
+  std::vector<SchemaElement> schema = {
+      {"schema", -1, -1, 3, -1},
+      {"id", 2, 0, 0, -1},
+      {"score", 5, 1, 0, -1},
+      {"name", 6, 0, 0, 0},
+  };
+  std::vector<std::pair<int64, std::vector<Chunk>>> row_groups(2);
+  const string dictionary = DictionaryPage(PlainStrings({"a", "b"}), 2);
+  row_groups[0] = {
+      3,
+      {{PhysicalType::INT64, 0, 3, 0, DataPage(PlainInt64({1, 2, 3}), 3, 0),
+        PlainInt64({1}), PlainInt64({3})},
+       {PhysicalType::DOUBLE, 0, 3, 0,
+        DataPage(Levels(BitPacked({1, 0, 1}, 1)) + PlainDouble({0.5, 2.5}), 3,
+                 0),
+        "", ""},
+       {PhysicalType::BYTE_ARRAY, 0, 3, dictionary.size(),
+        dictionary +
+            DataPage(string(1, '\x01') + BitPacked({1, 0, 1}, 1), 3, 8),
+        "", ""}}};
+  row_groups[1] = {
+      2,
+      {{PhysicalType::INT64, 0, 2, 0, DataPage(PlainInt64({10, 11}), 2, 0),
+        PlainInt64({10}), PlainInt64({11})},
+       {PhysicalType::DOUBLE, 0, 2, 0,
+        DataPage(Levels(RleRun(0, 1, 1) + RleRun(1, 1, 1)) +
+                     PlainDouble({4.0}),
+                 2, 0),
+        PlainDouble({4.0}), PlainDouble({4.0})},
+       {PhysicalType::BYTE_ARRAY, 0, 2, 0,
+        DataPage(PlainStrings({"c", "d"}), 2, 0), "", ""}}};
+  return MakeFile(schema, row_groups);
+}
+
+// A file with a list of INT32 column `tags` holding [1, 2], [], null and [3],
+// and an unsigned INT32 column `u`.
+string ListFile() {
+  std::vector<SchemaElement> schema = {
+      {"schema", -1, -1, 2, -1},
+      {"tags", -1, 1, 1, 3},
+      {"list", -1, 2, 1, -1},
+      {"element", 1, 0, 0, -1},
+      {"u", 1, 0, 0, 13},
+  };
+  std::vector<std::pair<int64, std::vector<Chunk>>> row_groups(1);
+  row_groups[0] = {
+      4,
+      {{PhysicalType::INT32, 2, 5, 0,
+        DataPageV2(BitPacked({0, 1, 0, 0, 0}, 1), BitPacked({2, 2, 1, 0, 2}, 2),
+                   PlainInt32({1, 2, 3}), 5),
+        "", ""},
+       {PhysicalType::INT32, 0, 4, 0, DataPage(PlainInt32({1, 2, 3, 4}), 4, 0),
+        PlainInt32({1}), PlainInt32({4})}}};
+  return MakeFile(schema, row_groups);
+}
+
+TEST_F(ParquetFileTest, ReadFileMetaData) {
+  TF_ASSERT_OK(Open("flat.parquet", FlatFile()));
+  EXPECT_EQ(5, metadata_.num_rows);
+  ASSERT_EQ(3, metadata_.columns.size());
+  EXPECT_EQ("id", metadata_.columns[0].path);
+  EXPECT_EQ(PhysicalType::INT64, metadata_.columns[0].type);
+  EXPECT_EQ(0, metadata_.columns[0].max_definition_level);
+  EXPECT_EQ(1, metadata_.columns[1].max_definition_level);
+  EXPECT_EQ(0, metadata_.columns[1].max_repetition_level);
+  EXPECT_EQ(2, metadata_.FindColumn("name"));
+  EXPECT_EQ(-1, metadata_.FindColumn("missing"));
+  ASSERT_EQ(2, metadata_.row_groups.size());
+  EXPECT_EQ(3, metadata_.row_groups[0].num_rows);
+  EXPECT_EQ(2, metadata_.row_groups[1].num_rows);
+  EXPECT_TRUE(metadata_.row_groups[0].columns[0].statistics.has_min_max);
+  EXPECT_FALSE(metadata_.row_groups[0].columns[1].statistics.has_min_max);
+
+  TF_ASSERT_OK(Open("list.parquet", ListFile()));
+  ASSERT_EQ(2, metadata_.columns.size());
+  const ColumnDescriptor& tags = metadata_.columns[0];
+  EXPECT_EQ("tags.list.element", tags.path);
+  EXPECT_EQ(2, tags.max_definition_level);
+  EXPECT_EQ(1, tags.max_repetition_level);
+  EXPECT_EQ(2, tags.repeated_definition_level);
+  // Statistics of unsigned columns are not comparable as signed values.
+  EXPECT_FALSE(metadata_.row_groups[0].columns[1].statistics.has_min_max);
+}
+
+TEST_F(ParquetFileTest, InvalidFile) {
+  EXPECT_TRUE(errors::IsDataLoss(Open("short.parquet", "PAR1")));
+  string file = FlatFile();
+  file[file.size() - 1] = 'X';
+  EXPECT_TRUE(errors::IsDataLoss(Open("magic.parquet", file)));
+  file = FlatFile();
+  file[file.size() - 5] = '\x7f';
+  EXPECT_TRUE(errors::IsDataLoss(Open("length.parquet", file)));
+}
+
+TEST_F(ParquetFileTest, ReadColumnChunk) {
+  TF_ASSERT_OK(Open("flat.parquet", FlatFile()));
+  ColumnChunkData data;
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 0, 0, &data));
+  EXPECT_EQ(3, data.num_entries);
+  EXPECT_TRUE(data.definition_levels.empty());
+  test::ExpectTensorEqual<int64>(data.values,
+                                 test::AsTensor<int64>({1, 2, 3}));
+
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 0, 1, &data));
+  EXPECT_EQ(3, data.num_entries);
+  EXPECT_EQ(std::vector<int16>({1, 0, 1}), data.definition_levels);
+  test::ExpectTensorEqual<double>(data.values,
+                                  test::AsTensor<double>({0.5, 2.5}));
+
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 1, 1, &data));
+  EXPECT_EQ(std::vector<int16>({0, 1}), data.definition_levels);
+  test::ExpectTensorEqual<double>(data.values, test::AsTensor<double>({4.0}));
+
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 0, 2, &data));
+  test::ExpectTensorEqual<string>(data.values,
+                                  test::AsTensor<string>({"b", "a", "b"}));
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 1, 2, &data));
+  test::ExpectTensorEqual<string>(data.values,
+                                  test::AsTensor<string>({"c", "d"}));
+}
+
+TEST_F(ParquetFileTest, ReadCompressedRepeatedColumnChunk) {
+  TF_ASSERT_OK(Open("list.parquet", ListFile()));
+  ColumnChunkData data;
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 0, 0, &data));
+  EXPECT_EQ(5, data.num_entries);
+  EXPECT_EQ(std::vector<int16>({0, 1, 0, 0, 0}), data.repetition_levels);
+  EXPECT_EQ(std::vector<int16>({2, 2, 1, 0, 2}), data.definition_levels);
+  test::ExpectTensorEqual<int32>(data.values, test::AsTensor<int32>({1, 2, 3}));
+}
+
+TEST_F(ParquetFileTest, ColumnReaderFlat) {
+  TF_ASSERT_OK(Open("flat.parquet", FlatFile()));
+  ColumnChunkData data;
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 0, 1, &data));
+  ColumnReader reader(metadata_.columns[1], std::move(data));
+  Tensor values;
+  TF_ASSERT_OK(reader.ReadRows(2, &values, nullptr));
+  test::ExpectTensorEqual<double>(values, test::AsTensor<double>({0.5, 0.0}));
+  TF_ASSERT_OK(reader.ReadRows(1, &values, nullptr));
+  test::ExpectTensorEqual<double>(values, test::AsTensor<double>({2.5}));
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRows(1, &values, nullptr)));
+}
+
+TEST_F(ParquetFileTest, ColumnReaderRepeated) {
+  TF_ASSERT_OK(Open("list.parquet", ListFile()));
+  ColumnChunkData data;
+  TF_ASSERT_OK(ReadColumnChunk(file_.get(), metadata_, 0, 0, &data));
+  ColumnReader reader(metadata_.columns[0], std::move(data));
+  Tensor values;
+  std::vector<int64> row_lengths;
+  TF_ASSERT_OK(reader.ReadRows(1, nullptr, nullptr));
+  TF_ASSERT_OK(reader.ReadRows(3, &values, &row_lengths));
+  EXPECT_EQ(std::vector<int64>({0, 0, 1}), row_lengths);
+  test::ExpectTensorEqual<int32>(values, test::AsTensor<int32>({3}));
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRows(1, &values, nullptr)));
+}
+
+TEST_F(ParquetFileTest, RowGroupMayMatch) {
+  TF_ASSERT_OK(Open("flat.parquet", FlatFile()));
+  auto may_match = [this](int row_group, int column, Predicate::Op op,
+                          double value) {
+    Predicate predicate;
+    predicate.column = column;
+    predicate.op = op;
+    predicate.value = value;
+    return RowGroupMayMatch(metadata_, row_group, predicate);
+  };
+  // Row group 0 has ids in [1, 3] and row group 1 in [10, 11].
+  EXPECT_TRUE(may_match(0, 0, Predicate::kEqual, 2));
+  EXPECT_FALSE(may_match(1, 0, Predicate::kEqual, 2));
+  EXPECT_TRUE(may_match(0, 0, Predicate::kLess, 2));
+  EXPECT_FALSE(may_match(1, 0, Predicate::kLess, 10));
+  EXPECT_TRUE(may_match(1, 0, Predicate::kLessEqual, 10));
+  EXPECT_FALSE(may_match(0, 0, Predicate::kGreater, 3));
+  EXPECT_TRUE(may_match(0, 0, Predicate::kGreaterEqual, 3));
+  EXPECT_TRUE(may_match(0, 0, Predicate::kNotEqual, 2));
+  // Row group 1 has a single score of 4.0; row group 0 has no statistics.
+  EXPECT_FALSE(may_match(1, 1, Predicate::kNotEqual, 4.0));
+  EXPECT_TRUE(may_match(0, 1, Predicate::kEqual, 100));
+  // Strings have no numeric statistics.
+  EXPECT_TRUE(may_match(0, 2, Predicate::kEqual, 100));
+
+  Predicate::Op op;
+  TF_EXPECT_OK(Predicate::ParseOp(">=", &op));
+  EXPECT_EQ(Predicate::kGreaterEqual, op);
+  EXPECT_TRUE(errors::IsInvalidArgument(Predicate::ParseOp("=", &op)));
+}
+
+}  // namespace
+}  // namespace parquet
+}  // namespace data
+}  // namespace tensorflow
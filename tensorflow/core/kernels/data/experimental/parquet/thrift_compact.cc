@@ -0,0 +1,246 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/parquet/thrift_compact.h"
+
+#include <cstring>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data {
+namespace parquet {
+namespace {
+
+// Bounds the nesting of skipped values to protect against corrupt input.
+constexpr int kMaxSkipDepth = 64;
+
+Status Truncated() {
+  return errors::DataLoss("Truncated Thrift compact protocol data.");
+}
+
+}  // namespace
+
+Status ThriftCompactReader::ReadStructBegin() {
+  field_id_stack_.push_back(last_field_id_);
+  last_field_id_ = 0;
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadStructEnd() {
+  if (field_id_stack_.empty()) {
+    return errors::Internal("Unbalanced Thrift struct end.");
+  }
+  last_field_id_ = field_id_stack_.back();
+  field_id_stack_.pop_back();
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadFieldBegin(int16* id, Type* type) {
+  uint8 header;
+  TF_RETURN_IF_ERROR(ReadByte(&header));
+  *type = static_cast<Type>(header & 0x0f);
+  if (*type == kStop) {
+    *id = 0;
+    return Status::OK();
+  }
+  const int16 delta = header >> 4;
+  if (delta != 0) {
+    *id = last_field_id_ + delta;
+  } else {
+    int64 field_id;
+    TF_RETURN_IF_ERROR(ReadZigZag(&field_id));
+    *id = static_cast<int16>(field_id);
+  }
+  last_field_id_ = *id;
+  if (*type == kBoolTrue || *type == kBoolFalse) {
+    has_pending_bool_ = true;
+    pending_bool_ = *type == kBoolTrue;
+  }
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadListBegin(Type* element_type, int64* size) {
+  uint8 header;
+  TF_RETURN_IF_ERROR(ReadByte(&header));
+  *element_type = static_cast<Type>(header & 0x0f);
+  *size = header >> 4;
+  if (*size == 15) {
+    uint64 long_size;
+    TF_RETURN_IF_ERROR(ReadVarint(&long_size));
+    if (long_size > data_.size() - position_) {
+      // Every element takes at least one byte.
+      return Truncated();
+    }
+    *size = static_cast<int64>(long_size);
+  }
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadBool(bool* value) {
+  if (has_pending_bool_) {
+    has_pending_bool_ = false;
+    *value = pending_bool_;
+    return Status::OK();
+  }
+  uint8 byte;
+  TF_RETURN_IF_ERROR(ReadByte(&byte));
+  *value = byte == kBoolTrue;
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadI32(int32* value) {
+  int64 result;
+  TF_RETURN_IF_ERROR(ReadZigZag(&result));
+  *value = static_cast<int32>(result);
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadI64(int64* value) { return ReadZigZag(value); }
+
+Status ThriftCompactReader::ReadDouble(double* value) {
+  if (data_.size() - position_ < sizeof(double)) {
+    return Truncated();
+  }
+  // Doubles are stored in little-endian byte order.
+  uint64 bits = 0;
+  for (int i = 0; i < 8; ++i) {
+    bits |= static_cast<uint64>(static_cast<uint8>(data_[position_ + i]))
+            << (8 * i);
+  }
+  std::memcpy(value, &bits, sizeof(double));
+  position_ += sizeof(double);
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadBinary(string* value) {
+  uint64 length;
+  TF_RETURN_IF_ERROR(ReadVarint(&length));
+  if (length > data_.size() - position_) {
+    return Truncated();
+  }
+  value->assign(data_.data() + position_, length);
+  position_ += length;
+  return Status::OK();
+}
+
+Status ThriftCompactReader::Skip(Type type) { return SkipValue(type, 0); }
+
+Status ThriftCompactReader::ReadByte(uint8* value) {
+  if (position_ >= data_.size()) {
+    return Truncated();
+  }
+  *value = static_cast<uint8>(data_[position_++]);
+  return Status::OK();
+}
+
+Status ThriftCompactReader::ReadVarint(uint64* value) {
+  uint64 result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint8 byte;
+    TF_RETURN_IF_ERROR(ReadByte(&byte));
+    result |= static_cast<uint64>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return Status::OK();
+    }
+  }
+  return errors::DataLoss("Malformed varint in Thrift compact protocol data.");
+}
+
+Status ThriftCompactReader::ReadZigZag(int64* value) {
+  uint64 encoded;
+  TF_RETURN_IF_ERROR(ReadVarint(&encoded));
+  *value = static_cast<int64>(encoded >> 1) ^ -static_cast<int64>(encoded & 1);
+  return Status::OK();
+}
+
+Status ThriftCompactReader::SkipValue(Type type, int depth) {
+  if (depth > kMaxSkipDepth) {
+    return errors::DataLoss("Thrift compact protocol data is nested too deep.");
+  }
+  switch (type) {
+    case kBoolTrue:
+    case kBoolFalse: {
+      bool value;
+      return ReadBool(&value);
+    }
+    case kByte: {
+      uint8 value;
+      return ReadByte(&value);
+    }
+    case kI16:
+    case kI32:
+    case kI64: {
+      int64 value;
+      return ReadZigZag(&value);
+    }
+    case kDouble: {
+      double value;
+      return ReadDouble(&value);
+    }
+    case kBinary: {
+      uint64 length;
+      TF_RETURN_IF_ERROR(ReadVarint(&length));
+      if (length > data_.size() - position_) {
+        return Truncated();
+      }
+      position_ += length;
+      return Status::OK();
+    }
+    case kList:
+    case kSet: {
+      Type element_type;
+      int64 size;
+      TF_RETURN_IF_ERROR(ReadListBegin(&element_type, &size));
+      for (int64 i = 0; i < size; ++i) {
+        TF_RETURN_IF_ERROR(SkipValue(element_type, depth + 1));
+      }
+      return Status::OK();
+    }
+    case kMap: {
+      uint64 size;
+      TF_RETURN_IF_ERROR(ReadVarint(&size));
+      if (size == 0) {
+        return Status::OK();
+      }
+      uint8 types;
+      TF_RETURN_IF_ERROR(ReadByte(&types));
+      for (uint64 i = 0; i < size; ++i) {
+        TF_RETURN_IF_ERROR(SkipValue(static_cast<Type>(types >> 4), depth + 1));
+        TF_RETURN_IF_ERROR(
+            SkipValue(static_cast<Type>(types & 0x0f), depth + 1));
+      }
+      return Status::OK();
+    }
+    case kStruct: {
+      TF_RETURN_IF_ERROR(ReadStructBegin());
+      while (true) {
+        int16 id;
+        Type field_type;
+        TF_RETURN_IF_ERROR(ReadFieldBegin(&id, &field_type));
+        if (field_type == kStop) break;
+        TF_RETURN_IF_ERROR(SkipValue(field_type, depth + 1));
+      }
+      return ReadStructEnd();
+    }
+    default:
+      return errors::DataLoss("Unknown Thrift compact protocol type ",
+                              static_cast<int>(type), ".");
+  }
+}
+
+}  // namespace parquet
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PARQUET_THRIFT_COMPACT_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PARQUET_THRIFT_COMPACT_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+namespace parquet {
+
+// Decodes values serialized with the Thrift compact protocol, which Parquet
+// uses for its file and page metadata.
+//
+// Structs are read field by field: after `ReadStructBegin()`, callers
+// repeatedly call `ReadFieldBegin()` and then either read the field value with
+// the method matching its type or `Skip()` it, until the returned type is
+// `kStop`, and finally call `ReadStructEnd()`.
+class ThriftCompactReader {
+ public:
+  enum Type {
+    kStop = 0,
+    kBoolTrue = 1,
+    kBoolFalse = 2,
+    kByte = 3,
+    kI16 = 4,
+    kI32 = 5,
+    kI64 = 6,
+    kDouble = 7,
+    kBinary = 8,
+    kList = 9,
+    kSet = 10,
+    kMap = 11,
+    kStruct = 12,
+  };
+
+  explicit ThriftCompactReader(StringPiece data) : data_(data) {}
+
+  Status ReadStructBegin();
+  Status ReadStructEnd();
+
+  // Reads the header of the next field of the current struct. `*type` is
+  // `kStop` after the last field.
+  Status ReadFieldBegin(int16* id, Type* type);
+
+  // Reads the header of a list or set.
+  Status ReadListBegin(Type* element_type, int64* size);
+
+  // Reads a boolean field value or list element.
+  Status ReadBool(bool* value);
+
+  Status ReadI32(int32* value);
+  Status ReadI64(int64* value);
+  Status ReadDouble(double* value);
+  Status ReadBinary(string* value);
+
+  // Skips a value of the given type, including nested values.
+  Status Skip(Type type);
+
+  // Returns the number of bytes consumed so far.
+  size_t position() const { return position_; }
+
+ private:
+  Status ReadByte(uint8* value);
+  Status ReadVarint(uint64* value);
+  Status ReadZigZag(int64* value);
+  Status SkipValue(Type type, int depth);
+
+  const StringPiece data_;
+  size_t position_ = 0;
+  int16 last_field_id_ = 0;
+  std::vector<int16> field_id_stack_;
+  // The compact protocol encodes boolean field values in the field header.
+  bool has_pending_bool_ = false;
+  bool pending_bool_ = false;
+};
+
+}  // namespace parquet
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_PARQUET_THRIFT_COMPACT_H_
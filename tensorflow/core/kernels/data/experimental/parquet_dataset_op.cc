@@ -0,0 +1,461 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/kernels/data/experimental/parquet/parquet_file.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+class ParquetDatasetOp : public DatasetOpKernel {
+ public:
+  explicit ParquetDatasetOp(OpKernelConstruction* ctx) : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<string>()(i));
+    }
+
+    std::vector<string> columns;
+    OP_REQUIRES_OK(ctx, ParseVectorArgument<string>(ctx, "columns", &columns));
+    OP_REQUIRES(ctx, columns.size() == output_types_.size(),
+                errors::InvalidArgument(
+                    "`columns` has ", columns.size(),
+                    " elements but there are ", output_types_.size(),
+                    " output types."));
+
+    int64 batch_size;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(ctx, batch_size > 0,
+                errors::InvalidArgument("`batch_size` must be positive."));
+
+    std::vector<string> predicate_columns;
+    OP_REQUIRES_OK(ctx, ParseVectorArgument<string>(ctx, "predicate_columns",
+                                                    &predicate_columns));
+    std::vector<string> predicate_ops;
+    OP_REQUIRES_OK(ctx, ParseVectorArgument<string>(ctx, "predicate_ops",
+                                                    &predicate_ops));
+    std::vector<double> predicate_values;
+    OP_REQUIRES_OK(ctx, ParseVectorArgument<double>(ctx, "predicate_values",
+                                                    &predicate_values));
+    OP_REQUIRES(ctx,
+                predicate_ops.size() == predicate_columns.size() &&
+                    predicate_values.size() == predicate_columns.size(),
+                errors::InvalidArgument(
+                    "`predicate_columns`, `predicate_ops` and "
+                    "`predicate_values` must have the same length."));
+    for (const string& op : predicate_ops) {
+      parquet::Predicate::Op unused;
+      OP_REQUIRES_OK(ctx, parquet::Predicate::ParseOp(op, &unused));
+    }
+
+    *output = new Dataset(ctx, std::move(filenames), std::move(columns),
+                          batch_size, std::move(predicate_columns),
+                          std::move(predicate_ops), std::move(predicate_values),
+                          output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+            std::vector<string> columns, int64 batch_size,
+            std::vector<string> predicate_columns,
+            std::vector<string> predicate_ops,
+            std::vector<double> predicate_values,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : DatasetBase(DatasetContext(ctx)),
+          filenames_(std::move(filenames)),
+          columns_(std::move(columns)),
+          batch_size_(batch_size),
+          predicate_columns_(std::move(predicate_columns)),
+          predicate_ops_(std::move(predicate_ops)),
+          predicate_values_(std::move(predicate_values)),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(
+          Iterator::Params{this, strings::StrCat(prefix, "::Parquet")});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return "ParquetDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* filenames = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+      Node* columns = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(columns_, &columns));
+      Node* batch_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+      Node* predicate_columns = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(predicate_columns_, &predicate_columns));
+      Node* predicate_ops = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(predicate_ops_, &predicate_ops));
+      Node* predicate_values = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(predicate_values_, &predicate_values));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {filenames, columns, batch_size, predicate_columns, predicate_ops,
+           predicate_values},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        const size_t num_columns = dataset()->columns_.size();
+        // Batches may span row groups and files, so each column is read in
+        // pieces that are concatenated at the end.
+        std::vector<std::vector<Tensor>> pieces(num_columns);
+        std::vector<std::vector<int64>> row_lengths(num_columns);
+        int64 num_rows = 0;
+        while (num_rows < dataset()->batch_size_) {
+          if (rows_remaining_ == 0) {
+            bool end_of_files;
+            TF_RETURN_IF_ERROR(NextRowGroupLocked(ctx, &end_of_files));
+            if (end_of_files) break;
+          }
+          const int64 n =
+              std::min(dataset()->batch_size_ - num_rows, rows_remaining_);
+          for (size_t i = 0; i < num_columns; ++i) {
+            pieces[i].emplace_back();
+            TF_RETURN_IF_ERROR(readers_[i]->ReadRows(
+                n, &pieces[i].back(), IsRagged(i) ? &row_lengths[i] : nullptr));
+          }
+          num_rows += n;
+          rows_remaining_ -= n;
+          rows_consumed_ += n;
+        }
+        if (num_rows == 0) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        out_tensors->reserve(num_columns);
+        for (size_t i = 0; i < num_columns; ++i) {
+          Tensor values;
+          if (pieces[i].size() == 1) {
+            values = std::move(pieces[i][0]);
+          } else {
+            TF_RETURN_IF_ERROR(tensor::Concat(pieces[i], &values));
+          }
+          if (!IsRagged(i)) {
+            out_tensors->push_back(std::move(values));
+            continue;
+          }
+          // Ragged columns are encoded like the output of
+          // `RaggedTensorToVariant` with `batched_input=False`.
+          Tensor row_splits(DT_INT64, TensorShape({num_rows + 1}));
+          auto splits = row_splits.vec<int64>();
+          splits(0) = 0;
+          for (int64 j = 0; j < num_rows; ++j) {
+            splits(j + 1) = splits(j) + row_lengths[i][j];
+          }
+          Tensor encoded(DT_VARIANT, TensorShape({2}));
+          encoded.vec<Variant>()(0) = std::move(row_splits);
+          encoded.vec<Variant>()(1) = std::move(values);
+          out_tensors->emplace_back(DT_VARIANT, TensorShape({}));
+          out_tensors->back().scalar<Variant>()() = std::move(encoded);
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("current_file_index"),
+                                               current_file_index_));
+        if (file_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("next_row_group"),
+                                                 next_row_group_));
+          if (rows_remaining_ > 0) {
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                full_name("current_row_group"), next_row_group_ - 1));
+            TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("rows_consumed"),
+                                                   rows_consumed_));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        ResetFileLocked();
+        int64 current_file_index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("current_file_index"),
+                                              &current_file_index));
+        current_file_index_ = static_cast<size_t>(current_file_index);
+        if (!reader->Contains(full_name("next_row_group"))) {
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(OpenFileLocked(ctx->env()));
+        int64 next_row_group;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name("next_row_group"), &next_row_group));
+        next_row_group_ = next_row_group;
+        if (reader->Contains(full_name("current_row_group"))) {
+          int64 current_row_group, rows_consumed;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("current_row_group"),
+                                                &current_row_group));
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("rows_consumed"), &rows_consumed));
+          if (current_row_group < 0 ||
+              current_row_group >= metadata_.row_groups.size()) {
+            return errors::DataLoss("Invalid row group ", current_row_group,
+                                    " in checkpoint of ",
+                                    dataset()->filenames_[current_file_index_]);
+          }
+          TF_RETURN_IF_ERROR(ReadRowGroupLocked(ctx, current_row_group));
+          for (auto& column_reader : readers_) {
+            TF_RETURN_IF_ERROR(
+                column_reader->ReadRows(rows_consumed, nullptr, nullptr));
+          }
+          rows_consumed_ = rows_consumed;
+          rows_remaining_ -= rows_consumed;
+        }
+        return Status::OK();
+      }
+
+     private:
+      bool IsRagged(size_t i) const {
+        return dataset()->output_types_[i] == DT_VARIANT;
+      }
+
+      void ResetFileLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        file_.reset();
+        metadata_ = parquet::FileMetaData();
+        column_indices_.clear();
+        predicates_.clear();
+        readers_.clear();
+        next_row_group_ = 0;
+        rows_remaining_ = 0;
+        rows_consumed_ = 0;
+      }
+
+      // Opens the file at `current_file_index_` and resolves the projected
+      // and predicate columns against its schema.
+      Status OpenFileLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (current_file_index_ >= dataset()->filenames_.size()) {
+          return errors::InvalidArgument(
+              "current_file_index_:", current_file_index_,
+              " >= filenames_.size():", dataset()->filenames_.size());
+        }
+        const string& filename = dataset()->filenames_[current_file_index_];
+        uint64 file_size;
+        TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file_));
+        Status s =
+            parquet::ReadFileMetaData(file_.get(), file_size, &metadata_);
+        if (!s.ok()) {
+          errors::AppendToMessage(&s, "File: ", filename);
+          return s;
+        }
+        for (size_t i = 0; i < dataset()->columns_.size(); ++i) {
+          const string& path = dataset()->columns_[i];
+          const int index = metadata_.FindColumn(path);
+          if (index < 0) {
+            return errors::InvalidArgument("Column ", path, " not found in ",
+                                           filename);
+          }
+          const parquet::ColumnDescriptor& column = metadata_.columns[index];
+          if (IsRagged(i) != (column.max_repetition_level > 0)) {
+            return errors::InvalidArgument(
+                "Column ", path, " in ", filename, " is ",
+                column.max_repetition_level > 0 ? "" : "not ",
+                "repeated, so it must be read as a ",
+                column.max_repetition_level > 0 ? "ragged" : "dense",
+                " tensor.");
+          }
+          const DataType value_type = parquet::DecodedType(column.type);
+          if (!IsRagged(i) && value_type != dataset()->output_types_[i]) {
+            return errors::InvalidArgument(
+                "Column ", path, " in ", filename, " has type ",
+                DataTypeString(value_type), " but ",
+                DataTypeString(dataset()->output_types_[i]),
+                " was expected.");
+          }
+          column_indices_.push_back(index);
+        }
+        for (size_t i = 0; i < dataset()->predicate_columns_.size(); ++i) {
+          parquet::Predicate predicate;
+          predicate.column =
+              metadata_.FindColumn(dataset()->predicate_columns_[i]);
+          if (predicate.column < 0) {
+            return errors::InvalidArgument(
+                "Predicate column ", dataset()->predicate_columns_[i],
+                " not found in ", filename);
+          }
+          TF_RETURN_IF_ERROR(parquet::Predicate::ParseOp(
+              dataset()->predicate_ops_[i], &predicate.op));
+          predicate.value = dataset()->predicate_values_[i];
+          predicates_.push_back(predicate);
+        }
+        return Status::OK();
+      }
+
+      // Decodes the projected column chunks of `row_group` in parallel and
+      // prepares the column readers.
+      Status ReadRowGroupLocked(IteratorContext* ctx, int row_group)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const size_t num_columns = column_indices_.size();
+        std::vector<parquet::ColumnChunkData> chunks(num_columns);
+        BlockingCounter counter(num_columns);
+        Status status;
+        mutex status_mu;
+        for (size_t i = 0; i < num_columns; ++i) {
+          (*ctx->runner())([this, i, row_group, &chunks, &counter, &status,
+                            &status_mu]() {
+            Status s = parquet::ReadColumnChunk(file_.get(), metadata_,
+                                                row_group, column_indices_[i],
+                                                &chunks[i]);
+            if (!s.ok()) {
+              mutex_lock l(status_mu);
+              status.Update(s);
+            }
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
+        if (!status.ok()) {
+          errors::AppendToMessage(&status, "File: ",
+                                  dataset()->filenames_[current_file_index_]);
+          return status;
+        }
+        readers_.clear();
+        for (size_t i = 0; i < num_columns; ++i) {
+          readers_.emplace_back(new parquet::ColumnReader(
+              metadata_.columns[column_indices_[i]], std::move(chunks[i])));
+        }
+        rows_remaining_ = metadata_.row_groups[row_group].num_rows;
+        rows_consumed_ = 0;
+        return Status::OK();
+      }
+
+      // Advances to the next row group that may match the predicates, opening
+      // files as needed.
+      Status NextRowGroupLocked(IteratorContext* ctx, bool* end_of_files)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        while (current_file_index_ < dataset()->filenames_.size()) {
+          if (!file_) {
+            TF_RETURN_IF_ERROR(OpenFileLocked(ctx->env()));
+          }
+          while (next_row_group_ < metadata_.row_groups.size()) {
+            const int row_group = next_row_group_++;
+            if (metadata_.row_groups[row_group].num_rows == 0) continue;
+            bool may_match = true;
+            for (const parquet::Predicate& predicate : predicates_) {
+              if (!parquet::RowGroupMayMatch(metadata_, row_group, predicate)) {
+                may_match = false;
+                break;
+              }
+            }
+            if (!may_match) continue;
+            TF_RETURN_IF_ERROR(ReadRowGroupLocked(ctx, row_group));
+            *end_of_files = false;
+            return Status::OK();
+          }
+          ResetFileLocked();
+          ++current_file_index_;
+        }
+        *end_of_files = true;
+        return Status::OK();
+      }
+
+      mutex mu_;
+      size_t current_file_index_ GUARDED_BY(mu_) = 0;
+      std::unique_ptr<RandomAccessFile> file_ GUARDED_BY(mu_);
+      parquet::FileMetaData metadata_ GUARDED_BY(mu_);
+      // The indices in `metadata_.columns` of the projected columns.
+      std::vector<int> column_indices_ GUARDED_BY(mu_);
+      std::vector<parquet::Predicate> predicates_ GUARDED_BY(mu_);
+      int64 next_row_group_ GUARDED_BY(mu_) = 0;
+      // Readers of the projected columns of the current row group.
+      std::vector<std::unique_ptr<parquet::ColumnReader>> readers_
+          GUARDED_BY(mu_);
+      int64 rows_remaining_ GUARDED_BY(mu_) = 0;
+      int64 rows_consumed_ GUARDED_BY(mu_) = 0;
+    };
+
+    const std::vector<string> filenames_;
+    const std::vector<string> columns_;
+    const int64 batch_size_;
+    const std::vector<string> predicate_columns_;
+    const std::vector<string> predicate_ops_;
+    const std::vector<double> predicate_values_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ParquetDataset").Device(DEVICE_CPU),
+                        ParquetDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
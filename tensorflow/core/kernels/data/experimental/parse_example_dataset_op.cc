@@ -18,19 +18,29 @@ limitations under the License.
 #include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/kernels/data/parallel_map_dataset_op.h"
 #include "tensorflow/core/kernels/data/stats_utils.h"
+#include "tensorflow/core/util/batch_util.h"
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
 namespace tensorflow {
 namespace data {
 namespace {
 
+constexpr char kBatchAndParseExampleDataset[] = "BatchAndParseExampleDataset";
+constexpr char kInputImplEmpty[] = "input_impl_empty";
+
 // See documentation in ../../ops/dataset_ops.cc for a high-level
 // description of the following op.
+//
+// The same kernel implements "BatchAndParseExampleDataset", which batches
+// scalar serialized records itself and parses each batch with a single
+// FastParseExample call, instead of parsing batches built by an upstream
+// "BatchDataset".
 class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit ParseExampleDatasetOp(OpKernelConstruction* ctx)
       : UnaryDatasetOpKernel(ctx),
-        graph_def_version_(ctx->graph_def_version()) {
+        graph_def_version_(ctx->graph_def_version()),
+        batch_first_(ctx->def().op() == kBatchAndParseExampleDataset) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_keys", &sparse_keys_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_keys", &dense_keys_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_types", &sparse_types_));
@@ -38,7 +48,9 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_shapes", &dense_shapes_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
-    OP_REQUIRES_OK(ctx, ctx->GetAttr("sloppy", &sloppy_));
+    if (!batch_first_) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("sloppy", &sloppy_));
+    }
     for (int i = 0; i < dense_shapes_.size(); ++i) {
       bool shape_ok = true;
       if (dense_shapes_[i].dims() == -1) {
@@ -73,12 +85,31 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
     int64 num_parallel_calls = 0;
-    OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
-                                            &num_parallel_calls));
-    OP_REQUIRES(
-        ctx, num_parallel_calls > 0 || num_parallel_calls == model::kAutotune,
-        errors::InvalidArgument(
-            "num_parallel_calls must be greater than zero."));
+    int64 batch_size = 0;
+    bool drop_remainder = false;
+    if (batch_first_) {
+      OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "batch_size", &batch_size));
+      OP_REQUIRES(
+          ctx, batch_size > 0,
+          errors::InvalidArgument("Batch size must be greater than zero."));
+      OP_REQUIRES_OK(
+          ctx, ParseScalarArgument(ctx, "drop_remainder", &drop_remainder));
+      OP_REQUIRES(ctx,
+                  input->output_dtypes() == DataTypeVector({DT_STRING}) &&
+                      input->output_shapes()[0].IsCompatibleWith(
+                          PartialTensorShape({})),
+                  errors::InvalidArgument(
+                      "BatchAndParseExampleDataset expects an input dataset "
+                      "of scalar tf.string elements."));
+    } else {
+      OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
+                                              &num_parallel_calls));
+      OP_REQUIRES(
+          ctx,
+          num_parallel_calls > 0 || num_parallel_calls == model::kAutotune,
+          errors::InvalidArgument(
+              "num_parallel_calls must be greater than zero."));
+    }
 
     OpInputList dense_default_tensors;
     OP_REQUIRES_OK(ctx,
@@ -147,8 +178,9 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
     *output =
         new Dataset(ctx, input, dense_defaults, sparse_keys_, dense_keys_,
                     std::move(key_to_output_index), std::move(config),
-                    num_parallel_calls, sparse_types_, dense_types_,
-                    dense_shapes_, output_types_, output_shapes_, sloppy_);
+                    num_parallel_calls, batch_size, drop_remainder,
+                    sparse_types_, dense_types_, dense_shapes_, output_types_,
+                    output_shapes_, sloppy_);
   }
 
  private:
@@ -159,6 +191,7 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
             std::vector<string> dense_keys,
             std::map<string, int> key_to_output_index,
             example::FastParseExampleConfig config, int32 num_parallel_calls,
+            int64 batch_size, bool drop_remainder,
             const DataTypeVector& sparse_types,
             const DataTypeVector& dense_types,
             const std::vector<PartialTensorShape>& dense_shapes,
@@ -172,6 +205,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
           key_to_output_index_(std::move(key_to_output_index)),
           config_(std::move(config)),
           num_parallel_calls_(num_parallel_calls),
+          batch_size_(batch_size),
+          drop_remainder_(drop_remainder),
           sparse_types_(sparse_types),
           dense_types_(dense_types),
           dense_shapes_(dense_shapes),
@@ -185,6 +220,10 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
 
     std::unique_ptr<IteratorBase> MakeIteratorInternal(
         const string& prefix) const override {
+      if (batch_size_ > 0) {
+        return absl::make_unique<BatchIterator>(BatchIterator::Params{
+            this, strings::StrCat(prefix, "::BatchAndParseExample")});
+      }
       std::unique_ptr<ParallelMapFunctor> parse_example_functor =
           absl::make_unique<ParseExampleFunctor>(this);
       return NewParallelMapIterator(
@@ -205,7 +244,15 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       return "ParseExampleDatasetOp::Dataset";
     }
 
-    int64 Cardinality() const override { return input_->Cardinality(); }
+    int64 Cardinality() const override {
+      int64 n = input_->Cardinality();
+      if (batch_size_ == 0 || n == kInfiniteCardinality ||
+          n == kUnknownCardinality) {
+        return n;
+      }
+      return n / batch_size_ +
+             (n % batch_size_ == 0 || drop_remainder_ ? 0 : 1);
+    }
 
    protected:
     Status AsGraphDefInternal(SerializationContext* ctx,
@@ -214,13 +261,9 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       Node* input_graph_node = nullptr;
       TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
 
-      Node* num_parallle_calls_node;
       std::vector<Node*> dense_defaults_nodes;
       dense_defaults_nodes.reserve(dense_defaults_.size());
 
-      TF_RETURN_IF_ERROR(
-          b->AddScalar(num_parallel_calls_, &num_parallle_calls_node));
-
       for (const Tensor& dense_default : dense_defaults_) {
         Node* node;
         TF_RETURN_IF_ERROR(b->AddTensor(dense_default, &node));
@@ -241,6 +284,30 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       b->BuildAttrValue(dense_shapes_, &dense_shapes_attr);
       b->BuildAttrValue(sloppy_, &sloppy_attr);
 
+      if (batch_size_ > 0) {
+        Node* batch_size_node;
+        TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size_node));
+        Node* drop_remainder_node;
+        TF_RETURN_IF_ERROR(
+            b->AddScalar(drop_remainder_, &drop_remainder_node));
+        return b->AddDataset(this,
+                             {
+                                 {0, input_graph_node},
+                                 {1, batch_size_node},
+                                 {2, drop_remainder_node},
+                             },
+                             {{3, dense_defaults_nodes}},
+                             {{"sparse_keys", sparse_keys_attr},
+                              {"dense_keys", dense_keys_attr},
+                              {"sparse_types", sparse_types_attr},
+                              {"Tdense", dense_attr},
+                              {"dense_shapes", dense_shapes_attr}},
+                             output);
+      }
+
+      Node* num_parallle_calls_node;
+      TF_RETURN_IF_ERROR(
+          b->AddScalar(num_parallel_calls_, &num_parallle_calls_node));
       TF_RETURN_IF_ERROR(b->AddDataset(this,
                                        {
                                            {0, input_graph_node},
@@ -258,6 +325,93 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
     }
 
    private:
+    // Parses a batch of serialized `Example` protos with a single
+    // FastParseExample call, which writes dense features straight into
+    // batch-major output tensors, and converts the result into the
+    // components of one output element.
+    Status ParseSerialized(IteratorContext* ctx, const string& prefix,
+                           gtl::ArraySlice<string> serialized,
+                           std::vector<Tensor>* output) const {
+      thread::ThreadPool* device_threadpool =
+          ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
+      example::FastParseExampleConfig config = config_;
+      // local copy of config_ for modification.
+      auto stats_aggregator = ctx->stats_aggregator();
+      if (stats_aggregator) {
+        config.collect_feature_stats = true;
+      }
+      example::Result example_result;
+      Status s = FastParseExample(config, serialized, {}, device_threadpool,
+                                  &example_result);
+      if (s.ok()) {
+        output->resize(key_to_output_index_.size());
+        for (int d = 0; d < dense_keys_.size(); ++d) {
+          int output_index = key_to_output_index_.at(dense_keys_[d]);
+          DCHECK(example_result.dense_values[d].dtype() ==
+                 output_dtypes()[output_index])
+              << "Got wrong type for FastParseExample return value " << d
+              << " (expected " << DataTypeString(output_dtypes()[output_index])
+              << ", got "
+              << DataTypeString(example_result.dense_values[d].dtype())
+              << ").";
+          DCHECK(output_shapes()[output_index].IsCompatibleWith(
+              example_result.dense_values[d].shape()))
+              << "Got wrong shape for FastParseExample return value " << d
+              << " (expected " << output_shapes()[output_index].DebugString()
+              << ", got "
+              << example_result.dense_values[d].shape().DebugString()
+              << ").";
+          (*output)[output_index] = example_result.dense_values[d];
+        }
+        for (int d = 0; d < sparse_keys_.size(); ++d) {
+          int output_index = key_to_output_index_.at(sparse_keys_[d]);
+          (*output)[output_index] = Tensor(ctx->allocator({}), DT_VARIANT, {3});
+          Tensor& serialized_sparse = (*output)[output_index];
+          auto serialized_sparse_t = serialized_sparse.vec<Variant>();
+          serialized_sparse_t(0) = example_result.sparse_indices[d];
+          serialized_sparse_t(1) = example_result.sparse_values[d];
+          serialized_sparse_t(2) = example_result.sparse_shapes[d];
+          DCHECK(serialized_sparse.dtype() == output_dtypes()[output_index])
+              << "Got wrong type for FastParseExample return value " << d
+              << " (expected " << DataTypeString(output_dtypes()[output_index])
+              << ", got " << DataTypeString(serialized_sparse.dtype())
+              << ").";
+          DCHECK(output_shapes()[output_index].IsCompatibleWith(
+              serialized_sparse.shape()))
+              << "Got wrong shape for FastParseExample return value " << d
+              << " (expected " << output_shapes()[output_index].DebugString()
+              << ", got " << serialized_sparse.shape().DebugString()
+              << ").";
+        }
+        // TODO(b/123360128): Add component name to streamz metrics without
+        // breaking TFX metrics.
+        if (stats_aggregator) {
+          stats_aggregator->IncrementCounter(
+              stats_utils::kExamplesCount, "trainer",
+              example_result.feature_stats.size());
+          for (example::PerExampleFeatureStats feature_stats :
+               example_result.feature_stats) {
+            stats_aggregator->IncrementCounter(stats_utils::kFeaturesCount,
+                                               "trainer",
+                                               feature_stats.features_count);
+            stats_aggregator->IncrementCounter(
+                stats_utils::kFeatureValuesCount, "trainer",
+                feature_stats.feature_values_count);
+            int64 steps = ctx->model()->NumElements(prefix);
+            stats_aggregator->AddToHistogram(
+                stats_utils::FeatureHistogramName(node_name()),
+                {static_cast<double>(feature_stats.features_count)}, steps);
+
+            stats_aggregator->AddToHistogram(
+                stats_utils::FeatureValueHistogramName(node_name()),
+                {static_cast<double>(feature_stats.feature_values_count)},
+                steps);
+          }
+        }
+      }
+      return s;
+    }
+
     class ParseExampleFunctor : public ParallelMapFunctor {
      public:
       explicit ParseExampleFunctor(const Dataset* dataset)
@@ -267,99 +421,23 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
                    std::vector<Tensor> input, std::vector<Tensor>* output,
                    StatusCallback callback) override {
         (*ctx->runner())([this, ctx, prefix, input, output, callback]() {
-          thread::ThreadPool* device_threadpool =
-              ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
-          std::vector<string> slice_vec;
-          for (const Tensor& t : input) {
-            auto serialized_t = t.flat<string>();
-            gtl::ArraySlice<string> slice(serialized_t.data(),
-                                          serialized_t.size());
-            for (auto it = slice.begin(); it != slice.end(); it++)
-              slice_vec.push_back(*it);
-          }
-          example::FastParseExampleConfig config = dataset_->config_;
-          // local copy of config_ for modification.
-          auto stats_aggregator = ctx->stats_aggregator();
-          if (stats_aggregator) {
-            config.collect_feature_stats = true;
-          }
-          example::Result example_result;
-          Status s = FastParseExample(config, slice_vec, {}, device_threadpool,
-                                      &example_result);
-          if (s.ok()) {
-            (*output).resize(dataset_->key_to_output_index_.size());
-            for (int d = 0; d < dataset_->dense_keys_.size(); ++d) {
-              int output_index =
-                  dataset_->key_to_output_index_.at(dataset_->dense_keys_[d]);
-              DCHECK(example_result.dense_values[d].dtype() ==
-                     dataset_->output_dtypes()[output_index])
-                  << "Got wrong type for FastParseExample return value " << d
-                  << " (expected "
-                  << DataTypeString(dataset_->output_dtypes()[output_index])
-                  << ", got "
-                  << DataTypeString(example_result.dense_values[d].dtype())
-                  << ").";
-              DCHECK(dataset_->output_shapes()[output_index].IsCompatibleWith(
-                  example_result.dense_values[d].shape()))
-                  << "Got wrong shape for FastParseExample return value " << d
-                  << " (expected "
-                  << dataset_->output_shapes()[output_index].DebugString()
-                  << ", got "
-                  << example_result.dense_values[d].shape().DebugString()
-                  << ").";
-              (*output)[output_index] = example_result.dense_values[d];
-            }
-            for (int d = 0; d < dataset_->sparse_keys_.size(); ++d) {
-              int output_index =
-                  dataset_->key_to_output_index_.at(dataset_->sparse_keys_[d]);
-              (*output)[output_index] =
-                  Tensor(ctx->allocator({}), DT_VARIANT, {3});
-              Tensor& serialized_sparse = (*output)[output_index];
-              auto serialized_sparse_t = serialized_sparse.vec<Variant>();
-              serialized_sparse_t(0) = example_result.sparse_indices[d];
-              serialized_sparse_t(1) = example_result.sparse_values[d];
-              serialized_sparse_t(2) = example_result.sparse_shapes[d];
-              DCHECK(serialized_sparse.dtype() ==
-                     dataset_->output_dtypes()[output_index])
-                  << "Got wrong type for FastParseExample return value " << d
-                  << " (expected "
-                  << DataTypeString(dataset_->output_dtypes()[output_index])
-                  << ", got " << DataTypeString(serialized_sparse.dtype())
-                  << ").";
-              DCHECK(dataset_->output_shapes()[output_index].IsCompatibleWith(
-                  serialized_sparse.shape()))
-                  << "Got wrong shape for FastParseExample return value " << d
-                  << " (expected "
-                  << dataset_->output_shapes()[output_index].DebugString()
-                  << ", got " << serialized_sparse.shape().DebugString()
-                  << ").";
-            }
-            // TODO(b/123360128): Add component name to streamz metrics without
-            // breaking TFX metrics.
-            if (stats_aggregator) {
-              stats_aggregator->IncrementCounter(
-                  stats_utils::kExamplesCount, "trainer",
-                  example_result.feature_stats.size());
-              for (example::PerExampleFeatureStats feature_stats :
-                   example_result.feature_stats) {
-                stats_aggregator->IncrementCounter(
-                    stats_utils::kFeaturesCount, "trainer",
-                    feature_stats.features_count);
-                stats_aggregator->IncrementCounter(
-                    stats_utils::kFeatureValuesCount, "trainer",
-                    feature_stats.feature_values_count);
-                int64 steps = ctx->model()->NumElements(prefix);
-                stats_aggregator->AddToHistogram(
-                    stats_utils::FeatureHistogramName(dataset_->node_name()),
-                    {static_cast<double>(feature_stats.features_count)}, steps);
-
-                stats_aggregator->AddToHistogram(
-                    stats_utils::FeatureValueHistogramName(
-                        dataset_->node_name()),
-                    {static_cast<double>(feature_stats.feature_values_count)},
-                    steps);
-              }
+          Status s;
+          if (input.size() == 1) {
+            // Parse straight out of the batched input tensor.
+            auto serialized_t = input[0].flat<string>();
+            s = dataset_->ParseSerialized(
+                ctx, prefix,
+                gtl::ArraySlice<string>(serialized_t.data(),
+                                        serialized_t.size()),
+                output);
+          } else {
+            std::vector<string> slice_vec;
+            for (const Tensor& t : input) {
+              auto serialized_t = t.flat<string>();
+              slice_vec.insert(slice_vec.end(), serialized_t.data(),
+                               serialized_t.data() + serialized_t.size());
             }
+            s = dataset_->ParseSerialized(ctx, prefix, slice_vec, output);
           }
           callback(s);
         });
@@ -369,6 +447,111 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       const Dataset* dataset_;
     };
 
+    // Gathers `batch_size_` serialized records from the input and parses them
+    // together, so that no intermediate batch of serialized strings is built.
+    //
+    // FastParseExample splits each batch into minibatches that run on the
+    // device's CPU worker threads, so one batch is parsed in parallel. The
+    // records are gathered under `mu_` but parsed outside it, so concurrent
+    // callers parse different batches concurrently; a single consumer parses
+    // one batch at a time and should overlap it with `prefetch()`.
+    class BatchIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit BatchIterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        std::vector<Tensor> records;
+        {
+          mutex_lock l(mu_);
+          if (!input_impl_) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          records.reserve(dataset()->batch_size_);
+          *end_of_sequence = false;
+          for (int i = 0; i < dataset()->batch_size_ && !*end_of_sequence;
+               ++i) {
+            std::vector<Tensor> record;
+            TF_RETURN_IF_ERROR(
+                input_impl_->GetNext(ctx, &record, end_of_sequence));
+            if (!*end_of_sequence) {
+              if (record.size() != 1 ||
+                  !TensorShapeUtils::IsScalar(record[0].shape())) {
+                return errors::InvalidArgument(
+                    "Expected each input element to be a scalar string.");
+              }
+              records.emplace_back(std::move(record[0]));
+            } else {
+              input_impl_.reset();
+            }
+          }
+        }
+
+        if (records.empty() || (dataset()->drop_remainder_ &&
+                                records.size() < dataset()->batch_size_)) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+
+        // `CopyElementToSlice()` moves the strings of records whose buffer is
+        // not shared, e.g. records read from files, so their bytes are not
+        // copied. Records that share a buffer with another tensor, e.g.
+        // slices of a constant, are copied.
+        const int64 num_records = records.size();
+        Tensor serialized(ctx->allocator({}), DT_STRING, {num_records});
+        for (int64 i = 0; i < num_records; ++i) {
+          TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+              std::move(records[i]), &serialized, i));
+        }
+        auto serialized_t = serialized.vec<string>();
+        *end_of_sequence = false;
+        return dataset()->ParseSerialized(
+            ctx, prefix(),
+            gtl::ArraySlice<string>(serialized_t.data(), num_records),
+            out_tensors);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeKnownRatioNode(std::move(args),
+                                         dataset()->batch_size_);
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (!input_impl_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name(kInputImplEmpty), ""));
+        } else {
+          TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (!reader->Contains(full_name(kInputImplEmpty))) {
+          TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+        } else {
+          input_impl_.reset();
+        }
+        return Status::OK();
+      }
+
+     private:
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+    };
+
     const DatasetBase* const input_;
     const std::vector<Tensor> dense_defaults_;
     const std::vector<string> sparse_keys_;
@@ -376,6 +559,9 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
     const std::map<string, int> key_to_output_index_;
     const example::FastParseExampleConfig config_;
     const int64 num_parallel_calls_;
+    // Zero unless the input is batched by this dataset.
+    const int64 batch_size_;
+    const bool drop_remainder_;
     const DataTypeVector sparse_types_;
     const DataTypeVector dense_types_;
     const std::vector<PartialTensorShape> dense_shapes_;
@@ -385,9 +571,10 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
   };
 
   const int graph_def_version_;
+  const bool batch_first_;
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
-  bool sloppy_;
+  bool sloppy_ = false;
   std::vector<string> sparse_keys_;
   std::vector<string> dense_keys_;
   DataTypeVector sparse_types_;
@@ -402,6 +589,8 @@ REGISTER_KERNEL_BUILDER(Name("ParseExampleDataset").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(
     Name("ExperimentalParseExampleDataset").Device(DEVICE_CPU),
     ParseExampleDatasetOp);
+REGISTER_KERNEL_BUILDER(Name("BatchAndParseExampleDataset").Device(DEVICE_CPU),
+                        ParseExampleDatasetOp);
 
 }  // namespace
 }  // namespace data
@@ -0,0 +1,259 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/shared_cache.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+class SharedCacheDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit SharedCacheDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(
+        ctx, ctx->GetAttr("memory_budget_bytes", &memory_budget_bytes_));
+  }
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    string spill_dir;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "spill_dir", &spill_dir));
+
+    // Pipelines with the same definition and options share one cache,
+    // regardless of the iterator or session that created them. The input
+    // must serialize completely, so that its fingerprint covers every tensor
+    // it captures, and must be stateless, so that pipelines with the same
+    // definition produce the same elements.
+    SerializationContext::Params params;
+    std::vector<std::pair<string, Tensor>> input_list;
+    params.input_list = &input_list;
+    GraphDef graph_def;
+    Status s = AsGraphDef(ctx, input, SerializationContext(params), &graph_def);
+    OP_REQUIRES(ctx, s.ok(),
+                errors::FailedPrecondition(
+                    "Cannot share the cache of an input that does not fully "
+                    "serialize or that is stateful: ",
+                    s.error_message()));
+    OP_REQUIRES(ctx, input_list.empty(),
+                errors::FailedPrecondition(
+                    "Cannot share the cache of an input that captures ",
+                    input_list.size(), " tensors that cannot be serialized."));
+    const NodeDef* sink = nullptr;
+    for (const NodeDef& node : graph_def.node()) {
+      if (node.op() == "_Retval") {
+        sink = &node;
+        break;
+      }
+    }
+    OP_REQUIRES(ctx, sink != nullptr,
+                errors::Internal("Cannot find sink node for dataset graph."));
+    const string key = strings::StrCat(
+        strings::Hex(HashSubgraph(graph_def, sink), strings::kZeroPad16), "/",
+        memory_budget_bytes_, "/", spill_dir);
+
+    *output = new Dataset(ctx, input, key, memory_budget_bytes_, spill_dir);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, const string& key,
+            int64 memory_budget_bytes, const string& spill_dir)
+        : DatasetBase(DatasetContext(ctx)),
+          input_(input),
+          memory_budget_bytes_(memory_budget_bytes),
+          spill_dir_(spill_dir),
+          cache_(SharedCache::Acquire(key, memory_budget_bytes, spill_dir,
+                                      ctx->env())) {
+      input_->Ref();
+    }
+
+    ~Dataset() override {
+      SharedCache::Release(cache_);
+      input_->Unref();
+    }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(
+          Iterator::Params{this, strings::StrCat(prefix, "::SharedCache")});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() const override {
+      return "SharedCacheDatasetOp::Dataset";
+    }
+
+    int64 Cardinality() const override { return input_->Cardinality(); }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+      Node* spill_dir = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(spill_dir_, &spill_dir));
+      AttrValue memory_budget_bytes_attr;
+      b->BuildAttrValue<int64>(memory_budget_bytes_, &memory_budget_bytes_attr);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          /*inputs=*/
+          {std::make_pair(0, input_graph_node), std::make_pair(1, spill_dir)},
+          /*list_inputs=*/{},
+          /*attrs=*/{{"memory_budget_bytes", memory_budget_bytes_attr}},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~Iterator() override { dataset()->cache_->Abandon(this); }
+
+      Status Initialize(IteratorContext* ctx) override {
+        // The input iterator is only created once this iterator has to
+        // produce elements that are not cached yet.
+        return Status::OK();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        SharedCache* cache = dataset()->cache_;
+        while (true) {
+          bool produce;
+          TF_RETURN_IF_ERROR(cache->Lookup(index_, this, out_tensors,
+                                           end_of_sequence, &produce));
+          if (!produce) {
+            if (!*end_of_sequence) {
+              ++index_;
+            }
+            return Status::OK();
+          }
+          Status s = ProduceNext(ctx, cache);
+          if (!s.ok()) {
+            cache->Abandon(this);
+            return s;
+          }
+        }
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeKnownRatioNode(std::move(args),
+                                         /*ratio=*/1);
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("index"), index_));
+        if (input_impl_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("input_index"), input_index_));
+          TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        dataset()->cache_->Abandon(this);
+        input_impl_.reset();
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("index"), &index_));
+        if (reader->Contains(full_name("input_index"))) {
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("input_index"), &input_index_));
+          TF_RETURN_IF_ERROR(dataset()->input_->MakeIterator(
+              ctx, prefix(), &input_impl_));
+          TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+        }
+        return Status::OK();
+      }
+
+     private:
+      // Appends the element at `cache->size()` from the input to the cache,
+      // first skipping input elements that another producer already cached.
+      Status ProduceNext(IteratorContext* ctx, SharedCache* cache)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const int64 target = cache->size();
+        if (!input_impl_ || input_index_ > target) {
+          TF_RETURN_IF_ERROR(
+              dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+          input_index_ = 0;
+        }
+        std::vector<Tensor> element;
+        bool end_of_input = false;
+        while (input_index_ <= target) {
+          element.clear();
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, &end_of_input));
+          if (end_of_input) {
+            cache->Complete(this);
+            return Status::OK();
+          }
+          ++input_index_;
+        }
+        return cache->Append(this, std::move(element));
+      }
+
+      mutex mu_;
+      // Index of the next element this iterator returns.
+      int64 index_ GUARDED_BY(mu_) = 0;
+      // Only set while this iterator has produced elements for the cache.
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      // Number of elements read from `input_impl_`.
+      int64 input_index_ GUARDED_BY(mu_) = 0;
+    };
+
+    const DatasetBase* const input_;
+    const int64 memory_budget_bytes_;
+    const string spill_dir_;
+    SharedCache* const cache_;
+  };
+
+  int64 memory_budget_bytes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("SharedCacheDataset").Device(DEVICE_CPU),
+                        SharedCacheDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
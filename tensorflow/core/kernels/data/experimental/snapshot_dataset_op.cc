@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <deque>
+
 #include "absl/time/clock.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -28,6 +30,8 @@ limitations under the License.
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/lib/io/zstd/zstd_inputstream.h"
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #endif  // IS_SLIM_BUILD
@@ -74,6 +78,9 @@ class SnapshotWriter {
       dest_ = zlib_output_buffer;
       dest_is_owned_ = true;
 #endif  // IS_SLIM_BUILD
+    } else if (compression_type == io::compression::kZstd) {
+      dest_ = new io::ZstdOutputBuffer(dest, io::ZstdCompressionOptions());
+      dest_is_owned_ = true;
     }
   }
 
@@ -84,6 +91,22 @@ class SnapshotWriter {
     return dest_->Append(data);
   }
 
+  // Writes one record made of the concatenation of `chunks`, without first
+  // copying them into a single buffer.
+  Status WriteRecord(const std::vector<StringPiece>& chunks) {
+    uint64 size = 0;
+    for (const StringPiece& chunk : chunks) {
+      size += chunk.size();
+    }
+    char header[kHeaderSize];
+    core::EncodeFixed64(header, size);
+    TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
+    for (const StringPiece& chunk : chunks) {
+      TF_RETURN_IF_ERROR(dest_->Append(chunk));
+    }
+    return Status::OK();
+  }
+
 #if defined(PLATFORM_GOOGLE)
   Status WriteRecord(const absl::Cord& data) {
     char header[kHeaderSize];
@@ -144,6 +167,9 @@ class SnapshotReader {
           input_stream_.release(), zlib_options.input_buffer_size,
           zlib_options.output_buffer_size, zlib_options, true));
 #endif  // IS_SLIM_BUILD
+    } else if (compression_type_ == io::compression::kZstd) {
+      input_stream_.reset(new io::ZstdInputStream(
+          input_stream_.release(), io::ZstdCompressionOptions(), true));
     }
   }
 
@@ -184,6 +210,136 @@ string GetCurrentSnapshotDataFilename(uint64 bytes_written,
                       ".snapshot");
 }
 
+// Files of writer `writer_index` out of several are prefixed with the writer
+// index, so that each writer's files sort together and in order.
+string GetCurrentSnapshotDataFilename(int64 writer_index,
+                                      uint64 bytes_written,
+                                      uint64 shard_size_bytes,
+                                      const string& run_dir) {
+  uint64_t shard_id = bytes_written / shard_size_bytes;
+  return absl::StrCat(run_dir, "/", strings::Printf("%04lld", writer_index),
+                      "_", strings::Printf("%08lu", shard_id), ".snapshot");
+}
+
+// Writes `element` as one record. With `raw_buffers`, each tensor is written
+// as its rank and dimensions followed by its buffer, which avoids the
+// TensorProto encoding. Tensors whose buffers cannot be copied verbatim
+// (e.g. strings) are written as a length-prefixed TensorProto instead.
+Status WriteElement(SnapshotWriter* writer, const std::vector<Tensor>& element,
+                    bool raw_buffers) {
+  if (!raw_buffers) {
+    experimental::SnapshotRecord record;
+    for (const Tensor& t : element) {
+      t.AsProtoTensorContent(record.add_tensor());
+    }
+#if defined(PLATFORM_GOOGLE)
+    return writer->WriteRecord(record.SerializeAsCord());
+#else   // PLATFORM_GOOGLE
+    return writer->WriteRecord(record.SerializeAsString());
+#endif  // PLATFORM_GOOGLE
+  }
+  // `headers` must not reallocate while `chunks` points into it.
+  std::vector<string> headers(element.size());
+  std::vector<StringPiece> chunks;
+  chunks.reserve(2 * element.size());
+  for (size_t i = 0; i < element.size(); ++i) {
+    const Tensor& t = element[i];
+    string* header = &headers[i];
+    core::PutVarint64(header, t.dims());
+    for (int d = 0; d < t.dims(); ++d) {
+      core::PutVarint64(header, t.dim_size(d));
+    }
+    if (DataTypeCanUseMemcpy(t.dtype())) {
+      chunks.emplace_back(*header);
+      chunks.push_back(t.tensor_data());
+    } else {
+      TensorProto proto;
+      t.AsProtoTensorContent(&proto);
+      const string bytes = proto.SerializeAsString();
+      core::PutVarint64(header, bytes.size());
+      header->append(bytes);
+      chunks.emplace_back(*header);
+    }
+  }
+  return writer->WriteRecord(chunks);
+}
+
+// Reads the next element written by `WriteElement`. Returns OutOfRange at the
+// end of the file.
+Status ReadElement(SnapshotReader* reader, const DataTypeVector& dtypes,
+                   bool raw_buffers, std::vector<Tensor>* out_tensors,
+                   int64* num_bytes) {
+  *num_bytes = 0;
+  if (!raw_buffers) {
+#if !defined(PLATFORM_GOOGLE)
+    string record_bytes;
+    TF_RETURN_IF_ERROR(reader->ReadRecord(&record_bytes));
+    experimental::SnapshotRecord record;
+    record.ParseFromString(record_bytes);
+#else
+    absl::Cord record_cord;
+    TF_RETURN_IF_ERROR(reader->ReadRecord(&record_cord));
+    experimental::SnapshotRecord record;
+    record.ParseFromCord(record_cord);
+#endif
+    for (int i = 0; i < record.tensor_size(); ++i) {
+      Tensor t;
+      if (!t.FromProto(record.tensor(i))) {
+        return errors::DataLoss("Unable to parse Tensor from proto.");
+      }
+      out_tensors->push_back(t);
+      *num_bytes += t.TotalBytes();
+    }
+    return Status::OK();
+  }
+  string record_bytes;
+  TF_RETURN_IF_ERROR(reader->ReadRecord(&record_bytes));
+  StringPiece input(record_bytes);
+  for (DataType dtype : dtypes) {
+    uint64 rank;
+    if (!core::GetVarint64(&input, &rank)) {
+      return errors::DataLoss("Corrupt raw snapshot record.");
+    }
+    TensorShape shape;
+    for (uint64 d = 0; d < rank; ++d) {
+      uint64 dim;
+      if (!core::GetVarint64(&input, &dim)) {
+        return errors::DataLoss("Corrupt raw snapshot record.");
+      }
+      shape.AddDim(dim);
+    }
+    if (DataTypeCanUseMemcpy(dtype)) {
+      Tensor t(dtype, shape);
+      const size_t size = t.tensor_data().size();
+      if (input.size() < size) {
+        return errors::DataLoss("Truncated raw snapshot record.");
+      }
+      std::memcpy(const_cast<char*>(t.tensor_data().data()), input.data(),
+                  size);
+      input.remove_prefix(size);
+      *num_bytes += t.TotalBytes();
+      out_tensors->push_back(std::move(t));
+    } else {
+      uint64 length;
+      if (!core::GetVarint64(&input, &length) || input.size() < length) {
+        return errors::DataLoss("Corrupt raw snapshot record.");
+      }
+      TensorProto proto;
+      Tensor t;
+      if (!proto.ParseFromArray(input.data(), length) || !t.FromProto(proto)) {
+        return errors::DataLoss("Unable to parse Tensor from proto.");
+      }
+      input.remove_prefix(length);
+      *num_bytes += t.TotalBytes();
+      out_tensors->push_back(std::move(t));
+    }
+  }
+  if (!input.empty()) {
+    return errors::DataLoss("Raw snapshot record has trailing bytes.");
+  }
+  return Status::OK();
+}
+
 Status WriteMetadataFile(const string& hash_dir,
                          const experimental::SnapshotMetadataRecord& metadata) {
   string metadata_filename = absl::StrCat(hash_dir, "/", kSnapshotFilename);
@@ -277,6 +433,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("shard_size_bytes", &shard_size_bytes_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("pending_snapshot_expiry_seconds",
                                      &pending_snapshot_expiry_seconds_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("num_writer_threads", &num_writer_threads_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("raw_buffers", &raw_buffers_));
 
     if (shard_size_bytes_ == -1) shard_size_bytes_ = kDefaultShardSizeBytes;
 
@@ -288,8 +447,10 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES(
         ctx,
         compression_ == io::compression::kNone ||
-            compression_ == io::compression::kGzip,
-        errors::InvalidArgument("compression must be either '' or 'GZIP'."));
+            compression_ == io::compression::kGzip ||
+            compression_ == io::compression::kZstd,
+        errors::InvalidArgument(
+            "compression must be one of '', 'GZIP' or 'ZSTD'."));
 
     OP_REQUIRES(
         ctx, shard_size_bytes_ >= 1024 * 1024,
@@ -298,6 +459,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         ctx, pending_snapshot_expiry_seconds_ >= 1,
         errors::InvalidArgument(
             "pending_snapshot_expiry_seconds must be at least 1 second."));
+    OP_REQUIRES(
+        ctx, num_writer_threads_ >= 1,
+        errors::InvalidArgument("num_writer_threads must be at least 1."));
   }
 
  protected:
@@ -321,7 +485,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
     *output = new Dataset(ctx, input, path, graph_hash, reader_path_prefix_,
                           writer_path_prefix_, compression_, shard_size_bytes_,
-                          pending_snapshot_expiry_seconds_);
+                          pending_snapshot_expiry_seconds_,
+                          num_writer_threads_, raw_buffers_);
   }
 
  private:
@@ -331,7 +496,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             const string& graph_hash, const string& reader_path_prefix,
             const string& writer_path_prefix, const string& compression,
             const uint64 shard_size_bytes,
-            const uint64 pending_snapshot_expiry_seconds)
+            const uint64 pending_snapshot_expiry_seconds,
+            const int64 num_writer_threads, const bool raw_buffers)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           dir_(path),
@@ -340,7 +506,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           writer_path_prefix_(writer_path_prefix),
           compression_(compression),
           shard_size_bytes_(shard_size_bytes),
-          pending_snapshot_expiry_seconds_(pending_snapshot_expiry_seconds) {
+          pending_snapshot_expiry_seconds_(pending_snapshot_expiry_seconds),
+          num_writer_threads_(num_writer_threads),
+          raw_buffers_(raw_buffers) {
       input_->Ref();
     }
 
@@ -390,6 +558,12 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
       b->BuildAttrValue<int64>(pending_snapshot_expiry_seconds_,
                                &pending_snapshot_expiry_seconds_attr);
 
+      AttrValue num_writer_threads_attr;
+      b->BuildAttrValue<int64>(num_writer_threads_, &num_writer_threads_attr);
+
+      AttrValue raw_buffers_attr;
+      b->BuildAttrValue(raw_buffers_, &raw_buffers_attr);
+
       TF_RETURN_IF_ERROR(b->AddDataset(
           this,
           /*inputs=*/
@@ -402,7 +576,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
            {"writer_path_prefix", writer_path_prefix_attr},
            {"shard_size_bytes", shard_size_bytes_attr},
            {"pending_snapshot_expiry_seconds",
-            pending_snapshot_expiry_seconds_attr}},
+            pending_snapshot_expiry_seconds_attr},
+           {"num_writer_threads", num_writer_threads_attr},
+           {"raw_buffers", raw_buffers_attr}},
           output));
       return Status::OK();
     }
@@ -469,6 +645,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
      private:
       class SnapshotReaderIterator : public DatasetIterator<Dataset> {
        public:
+        // Number of elements each reader thread reads ahead of the consumer.
+        static constexpr size_t kReaderBufferSize = 16;
+
         explicit SnapshotReaderIterator(
             const Params& params, const string& hash_dir,
             const experimental::SnapshotMetadataRecord& metadata)
@@ -476,19 +655,49 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
               hash_dir_(hash_dir),
               metadata_(metadata) {}
 
+        ~SnapshotReaderIterator() override {
+          {
+            mutex_lock l(mu_);
+            cancelled_ = true;
+            cond_var_.notify_all();
+          }
+          // Joins the reader threads.
+          reader_threads_.clear();
+        }
+
         Status Initialize(IteratorContext* ctx) override {
           mutex_lock l(mu_);
 
           run_id_ = metadata_.run_id();
           run_dir_ = absl::StrCat(hash_dir_, "/", run_id_);
-          // Get all the files in the run_dir.
-          TF_RETURN_IF_ERROR(ctx->env()->GetMatchingPaths(
-              absl::StrCat(run_dir_, "/*"), &filenames_));
-          if (filenames_.empty()) {
-            return errors::InvalidArgument("Could not find any files in dir: ",
-                                           run_dir_);
+          num_writers_ = metadata_.num_writers();
+          if (num_writers_ == 0) {
+            // Get all the files in the run_dir.
+            TF_RETURN_IF_ERROR(ctx->env()->GetMatchingPaths(
+                absl::StrCat(run_dir_, "/*"), &filenames_));
+            if (filenames_.empty()) {
+              return errors::InvalidArgument(
+                  "Could not find any files in dir: ", run_dir_);
+            }
+            std::sort(filenames_.begin(), filenames_.end());
+            return Status::OK();
+          }
+
+          // Each writer's files are read back by their own thread. Elements
+          // were distributed round-robin, so reading the writers' buffers
+          // round-robin restores the original order.
+          buffers_.resize(num_writers_);
+          for (int64 i = 0; i < num_writers_; ++i) {
+            std::vector<string> filenames;
+            TF_RETURN_IF_ERROR(ctx->env()->GetMatchingPaths(
+                absl::StrCat(run_dir_, "/", strings::Printf("%04lld", i),
+                             "_*"),
+                &filenames));
+            std::sort(filenames.begin(), filenames.end());
+            reader_threads_.push_back(ctx->StartThread(
+                strings::StrCat("tf_data_snapshot_reader_", i),
+                [this, i, filenames]() { ReaderThread(i, filenames); }));
           }
-          std::sort(filenames_.begin(), filenames_.end());
           return Status::OK();
         }
 
@@ -497,33 +706,33 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                                bool* end_of_sequence) override {
           absl::Time start = absl::Now();
           mutex_lock l(mu_);
+          if (num_writers_ > 0) {
+            Buffer& buffer = buffers_[next_index_ % num_writers_];
+            while (buffer.elements.empty() && !buffer.done) {
+              cond_var_.wait(l);
+            }
+            if (buffer.elements.empty()) {
+              *end_of_sequence = true;
+              return Status::OK();
+            }
+            std::pair<Status, std::vector<Tensor>> element =
+                std::move(buffer.elements.front());
+            buffer.elements.pop_front();
+            cond_var_.notify_all();
+            TF_RETURN_IF_ERROR(element.first);
+            *out_tensors = std::move(element.second);
+            *end_of_sequence = false;
+            next_index_++;
+            return Status::OK();
+          }
           do {
             if (current_reader_) {
-#if !defined(PLATFORM_GOOGLE)
-              string record_bytes;
-              Status s = current_reader_->ReadRecord(&record_bytes);
-#else
-              absl::Cord record_cord;
-              Status s = current_reader_->ReadRecord(&record_cord);
-#endif
+              int64 num_bytes;
+              Status s = ReadElement(
+                  current_reader_.get(), dataset()->output_dtypes(),
+                  metadata_.raw_buffers(), out_tensors, &num_bytes);
               if (s.ok()) {
                 *end_of_sequence = false;
-                experimental::SnapshotRecord record;
-#if !defined(PLATFORM_GOOGLE)
-                record.ParseFromString(record_bytes);
-#else
-                record.ParseFromCord(record_cord);
-#endif
-                int64 num_bytes = 0;
-                for (int i = 0; i < record.tensor_size(); ++i) {
-                  Tensor t;
-                  if (!t.FromProto(record.tensor(i))) {
-                    return errors::DataLoss(
-                        "Unable to parse Tensor from proto.");
-                  }
-                  out_tensors->push_back(t);
-                  num_bytes += t.TotalBytes();
-                }
                 absl::Time end = absl::Now();
                 absl::Duration d = end - start;
                 time_spent_micros_ += absl::ToInt64Microseconds(d);
@@ -556,6 +765,48 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         }
 
        private:
+        // Elements read ahead from one writer's files.
+        struct Buffer {
+          std::deque<std::pair<Status, std::vector<Tensor>>> elements;
+          // Set once all of the writer's files have been read.
+          bool done = false;
+        };
+
+        void ReaderThread(int64 index, const std::vector<string>& filenames) {
+          Status s;
+          for (const string& filename : filenames) {
+            std::unique_ptr<RandomAccessFile> file;
+            s = Env::Default()->NewRandomAccessFile(
+                absl::StrCat(dataset()->reader_path_prefix_, filename), &file);
+            if (!s.ok()) break;
+            SnapshotReader reader(file.get(), dataset()->compression_);
+            while (true) {
+              std::vector<Tensor> element;
+              int64 num_bytes;
+              s = ReadElement(&reader, dataset()->output_dtypes(),
+                              metadata_.raw_buffers(), &element, &num_bytes);
+              if (!s.ok()) break;
+              mutex_lock l(mu_);
+              while (!cancelled_ &&
+                     buffers_[index].elements.size() >= kReaderBufferSize) {
+                cond_var_.wait(l);
+              }
+              if (cancelled_) return;
+              buffers_[index].elements.emplace_back(Status::OK(),
+                                                     std::move(element));
+              cond_var_.notify_all();
+            }
+            if (!errors::IsOutOfRange(s)) break;
+            s = Status::OK();
+          }
+          mutex_lock l(mu_);
+          if (!s.ok()) {
+            buffers_[index].elements.emplace_back(s, std::vector<Tensor>());
+          }
+          buffers_[index].done = true;
+          cond_var_.notify_all();
+        }
+
         Status SetupReaderLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
           if (current_file_index_ >= filenames_.size()) {
             return errors::InvalidArgument("current_files_index_...");
@@ -591,15 +842,27 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         double kbytes_written_ GUARDED_BY(mu_) = 0;
         size_t current_file_index_ GUARDED_BY(mu_) = 0;
 
+        // Only used when the snapshot was written by several writers.
+        int64 num_writers_ GUARDED_BY(mu_) = 0;
+        std::vector<Buffer> buffers_ GUARDED_BY(mu_);
+        bool cancelled_ GUARDED_BY(mu_) = false;
+        std::vector<std::unique_ptr<Thread>> reader_threads_;
+
         mutex mu_;
+        condition_variable cond_var_;
       };
 
       class SnapshotWriterIterator : public DatasetIterator<Dataset> {
        public:
+        // Number of elements buffered for each writer thread.
+        static constexpr size_t kWriterBufferSize = 16;
+
         explicit SnapshotWriterIterator(const Params& params,
                                         const string& hash_dir)
             : DatasetIterator<Dataset>(params), hash_dir_(hash_dir) {}
 
+        ~SnapshotWriterIterator() override { StopWriterThreads(); }
+
         Status Initialize(IteratorContext* ctx) override {
           mutex_lock l(mu_);
 
@@ -615,9 +878,27 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           metadata.set_graph_hash(dataset()->graph_hash_);
           metadata.set_run_id(run_id_);
           metadata.set_finalized(false);
+          const int64 num_writers = dataset()->num_writer_threads_;
+          if (num_writers > 1) {
+            metadata.set_num_writers(num_writers);
+          }
+          metadata.set_raw_buffers(dataset()->raw_buffers_);
 
           TF_RETURN_IF_ERROR(WriteMetadataFile(hash_dir_, metadata));
 
+          if (num_writers > 1) {
+            {
+              mutex_lock wl(writer_mu_);
+              buffers_.resize(num_writers);
+            }
+            for (int64 i = 0; i < num_writers; ++i) {
+              const string run_dir = run_dir_;
+              writer_threads_.push_back(ctx->StartThread(
+                  strings::StrCat("tf_data_snapshot_writer_", i),
+                  [this, i, run_dir]() { WriterThread(i, run_dir); }));
+            }
+          }
+
           return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
         }
 
@@ -631,6 +912,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
               input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
 
           if (*end_of_sequence) {
+            TF_RETURN_IF_ERROR(StopWriterThreads());
+
             experimental::SnapshotMetadataRecord metadata;
             TF_RETURN_IF_ERROR(ReadMetadataFile(hash_dir_, &metadata));
 
@@ -652,6 +935,22 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             return Status::OK();
           }
 
+          if (!writer_threads_.empty()) {
+            // Hand the element to its writer thread, round-robin, so that
+            // readers can restore the order.
+            mutex_lock wl(writer_mu_);
+            std::deque<std::vector<Tensor>>& buffer =
+                buffers_[next_index_ % buffers_.size()];
+            while (write_status_.ok() && buffer.size() >= kWriterBufferSize) {
+              writer_cond_var_.wait(wl);
+            }
+            TF_RETURN_IF_ERROR(write_status_);
+            buffer.push_back(*out_tensors);
+            writer_cond_var_.notify_all();
+            next_index_++;
+            return Status::OK();
+          }
+
           string snapshot_data_filename = GetCurrentSnapshotDataFilename(
               bytes_written_, dataset()->shard_size_bytes_, run_dir_);
 
@@ -670,22 +969,12 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             current_write_filename_ = snapshot_data_filename;
           }
 
-          experimental::SnapshotRecord record;
-
           int64 num_bytes = 0;
-          for (auto out_tensor : *out_tensors) {
+          for (const Tensor& out_tensor : *out_tensors) {
             num_bytes += out_tensor.TotalBytes();
-            TensorProto* t = record.add_tensor();
-            out_tensor.AsProtoTensorContent(t);
           }
-
-#if defined(PLATFORM_GOOGLE)
-          TF_RETURN_IF_ERROR(
-              current_writer_->WriteRecord(record.SerializeAsCord()));
-#else   // PLATFORM_GOOGLE
-          TF_RETURN_IF_ERROR(
-              current_writer_->WriteRecord(record.SerializeAsString()));
-#endif  // PLATFORM_GOOGLE
+          TF_RETURN_IF_ERROR(WriteElement(current_writer_.get(), *out_tensors,
+                                          dataset()->raw_buffers_));
 
           absl::Time end = absl::Now();
           absl::Duration d = end - start;
@@ -703,6 +992,68 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         }
 
        private:
+        // Writes the elements handed to writer `index` to its own sequence of
+        // files until `StopWriterThreads()` is called.
+        void WriterThread(int64 index, const string& run_dir) {
+          std::unique_ptr<WritableFile> file;
+          std::unique_ptr<SnapshotWriter> writer;
+          string filename;
+          uint64 bytes_written = 0;
+          Status s;
+          while (s.ok()) {
+            std::vector<Tensor> element;
+            {
+              mutex_lock wl(writer_mu_);
+              std::deque<std::vector<Tensor>>& buffer = buffers_[index];
+              while (buffer.empty() && !writers_finished_) {
+                writer_cond_var_.wait(wl);
+              }
+              if (buffer.empty()) break;
+              element = std::move(buffer.front());
+              buffer.pop_front();
+              writer_cond_var_.notify_all();
+            }
+            const string current_filename = GetCurrentSnapshotDataFilename(
+                index, bytes_written, dataset()->shard_size_bytes_, run_dir);
+            if (filename != current_filename) {
+              if (writer) s.Update(writer->Close());
+              if (file) s.Update(file->Close());
+              writer.reset();
+              file.reset();
+              if (!s.ok()) break;
+              s = Env::Default()->NewWritableFile(current_filename, &file);
+              if (!s.ok()) break;
+              writer = absl::make_unique<SnapshotWriter>(
+                  file.get(), dataset()->compression_);
+              filename = current_filename;
+            }
+            s = WriteElement(writer.get(), element, dataset()->raw_buffers_);
+            for (const Tensor& t : element) {
+              bytes_written += t.TotalBytes();
+            }
+          }
+          if (writer) s.Update(writer->Close());
+          if (file) s.Update(file->Close());
+          if (!s.ok()) {
+            mutex_lock wl(writer_mu_);
+            write_status_.Update(s);
+            writer_cond_var_.notify_all();
+          }
+        }
+
+        // Lets the writer threads drain their buffers and waits for them.
+        Status StopWriterThreads() {
+          {
+            mutex_lock wl(writer_mu_);
+            writers_finished_ = true;
+            writer_cond_var_.notify_all();
+          }
+          // Joins the writer threads.
+          writer_threads_.clear();
+          mutex_lock wl(writer_mu_);
+          return write_status_;
+        }
+
         std::unique_ptr<IteratorBase> input_impl_;
 
         const string hash_dir_;
@@ -718,6 +1069,15 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         int64 bytes_written_ GUARDED_BY(mu_) = 0;
 
         mutex mu_;
+
+        // Only used with more than one writer thread.
+        mutex writer_mu_;
+        condition_variable writer_cond_var_;
+        std::vector<std::deque<std::vector<Tensor>>> buffers_
+            GUARDED_BY(writer_mu_);
+        bool writers_finished_ GUARDED_BY(writer_mu_) = false;
+        Status write_status_ GUARDED_BY(writer_mu_);
+        std::vector<std::unique_ptr<Thread>> writer_threads_;
       };
 
       class SnapshotPassthroughIterator : public DatasetIterator<Dataset> {
@@ -756,6 +1116,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
     const uint64 shard_size_bytes_;
     const uint64 pending_snapshot_expiry_seconds_;
+
+    const int64 num_writer_threads_;
+    const bool raw_buffers_;
   };
 
   const int graph_def_version_;
@@ -768,6 +1131,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
   int64 shard_size_bytes_;
   int64 pending_snapshot_expiry_seconds_;
+  int64 num_writer_threads_;
+  bool raw_buffers_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("SnapshotDataset").Device(DEVICE_CPU),
@@ -144,6 +144,9 @@ class MapDatasetOp::Dataset : public DatasetBase {
 
       Status s =
           instantiated_captured_func_->Run(ctx, std::move(args), out_tensors);
+      if (s.ok()) {
+        return MaybeFillBatchSlot(ctx, *out_tensors);
+      }
       if (errors::IsOutOfRange(s)) {
         if (dataset()->preserve_cardinality_) {
           // To guarantee that the transformation preserves the cardinality of
@@ -18,7 +18,10 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/stats_utils.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/util/ptr_util.h"
@@ -47,22 +50,33 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES(ctx, cpu_budget_ > 0,
                 errors::InvalidArgument("CPU budget must be positive but is ",
                                         cpu_budget_, "."));
+    if (ctx->HasAttr("ram_budget")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("ram_budget", &ram_budget_));
+    } else {
+      ram_budget_ = 0;
+    }
+    OP_REQUIRES(ctx, ram_budget_ >= 0,
+                errors::InvalidArgument(
+                    "RAM budget must be non-negative but is ", ram_budget_,
+                    "."));
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
-    *output = new Dataset(ctx, input, algorithm_, cpu_budget_);
+    *output = new Dataset(ctx, input, algorithm_, cpu_budget_, ram_budget_);
   }
 
  private:
   class Dataset : public DatasetBase {
    public:
     Dataset(OpKernelContext* ctx, const DatasetBase* input,
-            model::AutotuneAlgorithm algorithm, int64 cpu_budget)
+            model::AutotuneAlgorithm algorithm, int64 cpu_budget,
+            int64 ram_budget)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           algorithm_(algorithm),
-          cpu_budget_(cpu_budget) {
+          cpu_budget_(cpu_budget),
+          ram_budget_(ram_budget) {
       input_->Ref();
     }
 
@@ -117,6 +131,11 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
       Status Initialize(IteratorContext* ctx) override {
         IteratorContext::Params params(ctx);
         params.model = model_;
+        if (ctx->stats_aggregator()) {
+          // Per-node usage is exported to the aggregator, so collect it even
+          // if the pipeline has nothing to tune.
+          model_->EnableResourceUsageCollection();
+        }
         return dataset()->input_->MakeIterator(
             IteratorContext(std::move(params)), prefix(), &input_impl_);
       }
@@ -169,6 +188,7 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
       void OptimizeThread(const std::shared_ptr<IteratorContext>& ctx) {
         int64 last_optimization_ms = 0;
         int64 optimization_period_ms = 10;
+        int64 num_optimizations = 0;
         int64 current_time_ms =
             ctx->env()->NowMicros() / EnvTime::kMillisToMicros;
         while (true) {
@@ -186,7 +206,11 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
             }
             if (cancelled_) return;
           }
-          model_->Optimize(dataset()->algorithm_, dataset()->cpu_budget_);
+          model_->Optimize(dataset()->algorithm_, dataset()->cpu_budget_,
+                           dataset()->ram_budget_);
+          if (auto stats_aggregator = ctx->stats_aggregator()) {
+            RecordNodeStats(stats_aggregator.get(), ++num_optimizations);
+          }
           // Exponentially increase the period of running the optimization
           // until a threshold is reached.
           if (optimization_period_ms != kOptimizationPeriodThresholdMs) {
@@ -198,6 +222,29 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
         }
       }
 
+      // Reports the per-node CPU time, produced bytes and peak buffer
+      // occupancy of the model to the given aggregator.
+      void RecordNodeStats(StatsAggregator* stats_aggregator, int64 step) {
+        StepStats step_stats;
+        model_->ExportStepStats(&step_stats);
+        for (const auto& device_stats : step_stats.dev_stats()) {
+          for (const auto& node_stats : device_stats.node_stats()) {
+            const string& name = node_stats.node_name();
+            stats_aggregator->AddScalar(
+                stats_utils::CpuTimeScalarName(name),
+                static_cast<float>(node_stats.op_end_rel_nanos()), step);
+            for (const auto& memory : node_stats.memory()) {
+              stats_aggregator->AddScalar(
+                  stats_utils::BytesProducedScalarName(name),
+                  static_cast<float>(memory.total_bytes()), step);
+              stats_aggregator->AddScalar(
+                  stats_utils::PeakBufferedBytesScalarName(name),
+                  static_cast<float>(memory.peak_bytes()), step);
+            }
+          }
+        }
+      }
+
       mutex mu_;
       condition_variable cond_var_;
       std::shared_ptr<model::Model> model_;
@@ -209,10 +256,12 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
     const DatasetBase* input_;
     const model::AutotuneAlgorithm algorithm_;
     const int64 cpu_budget_;
+    const int64 ram_budget_;
   };
 
   model::AutotuneAlgorithm algorithm_;
   int64 cpu_budget_;
+  int64 ram_budget_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ModelDataset").Device(DEVICE_CPU),
@@ -85,8 +85,7 @@ class MultiDeviceIterator : public ResourceBase {
     *incarnation_id = incarnation_id_;
 
     multi_device_buffer_ = absl::make_unique<MultiDeviceBuffer>(
-        devices_.size(), max_buffer_size, incarnation_id_, std::move(iterator),
-        this);
+        devices_, max_buffer_size, incarnation_id_, std::move(iterator), this);
     return Status::OK();
   }
 
@@ -125,17 +124,27 @@ class MultiDeviceIterator : public ResourceBase {
  private:
   // A private class that uses a background thread to keep a per device buffer
   // full.
+  //
+  // Elements for GPU shards are copied into GPU-compatible (pinned) host memory
+  // by the background thread, so that the later copies to the GPUs, which the
+  // per device prefetch issues ahead of consumption, are asynchronous DMAs
+  // instead of staged copies from pageable memory.
   class MultiDeviceBuffer {
    public:
-    MultiDeviceBuffer(size_t size, int64 max_buffer_size, int64 incarnation_id,
+    MultiDeviceBuffer(const std::vector<string>& devices, int64 max_buffer_size,
+                      int64 incarnation_id,
                       std::unique_ptr<IteratorBase> host_iterator,
                       MultiDeviceIterator* parent)
-        : buffer_(size),
-          size_(size),
+        : buffer_(devices.size()),
+          size_(devices.size()),
           max_buffer_size_(max_buffer_size),
           incarnation_id_(incarnation_id),
           host_iterator_(std::move(host_iterator)),
-          parent_(parent) {}
+          parent_(parent) {
+      for (const string& device : devices) {
+        pin_shard_.push_back(IsGpuDevice(device));
+      }
+    }
 
     ~MultiDeviceBuffer() {
       {
@@ -284,6 +293,10 @@ class MultiDeviceIterator : public ResourceBase {
 
         elem.status = host_iterator_->GetNext(ctx.get(), &elem.value,
                                               &elem.end_of_sequence);
+        if (elem.status.ok() && !elem.end_of_sequence &&
+            pin_shard_[shard_to_fetch]) {
+          CopyToPinnedMemory(ctx.get(), &elem.value);
+        }
 
         if (elem.status.ok() && elem.end_of_sequence) {
           end_of_iterator = true;
@@ -336,6 +349,8 @@ class MultiDeviceIterator : public ResourceBase {
     condition_variable shutdown_cond_var_ GUARDED_BY(mu_);
 
     std::vector<HostBuffer> buffer_;
+    // Whether the elements of each shard are copied into pinned memory.
+    std::vector<bool> pin_shard_;
 
     const size_t size_;
     const int64 max_buffer_size_;
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env_time.h"
 
 namespace tensorflow {
 namespace data {
@@ -62,6 +63,10 @@ namespace data {
 /* static */ constexpr const char* const
     ParallelInterleaveDatasetOp::kOutputShapes;
 /* static */ constexpr const char* const ParallelInterleaveDatasetOp::kSloppy;
+/* static */ constexpr const char* const
+    ParallelInterleaveDatasetOp::kBufferOutputElements;
+/* static */ constexpr const char* const
+    ParallelInterleaveDatasetOp::kReopenStragglers;
 
 constexpr char kDataParallelInterleaveWorkerPool[] =
     "data_parallel_interleave_worker_pool";
@@ -82,6 +87,7 @@ constexpr char kIdSuffix[] = ".id";
 constexpr char kSizeSuffix[] = ".size";
 constexpr char kInputsSuffix[] = ".inputs";
 constexpr char kIsReadySuffix[] = ".is_ready";
+constexpr char kNumFetchedSuffix[] = ".num_fetched";
 constexpr char kTFDataParallelInterleaveCurrent[] =
     "tf_data_parallel_interleave_current";
 constexpr char kTFDataParallelInterleaveFuture[] =
@@ -98,6 +104,13 @@ constexpr double kPrefetchFactor = 2.0L;
 // is to achieve efficient CPU utilization when some of the threads perform I/O.
 constexpr double kCPUFactor = 2.0L;
 
+// When straggler reopening is enabled, a cycle element is considered a
+// straggler once the consumer has waited on it for `kStragglerFactor` times the
+// average time it takes to fetch an element, but no less than
+// `kMinStragglerTimeoutUs`.
+constexpr double kStragglerFactor = 4.0L;
+constexpr int64 kMinStragglerTimeoutUs = 100 * 1000;
+
 // The motivation for creating an alternative implementation of parallel
 // interleave is to decouple the degree of parallelism from the cycle length.
 // This makes it possible to change the degree of parallelism (e.g. through
@@ -112,6 +125,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   Dataset(OpKernelContext* ctx, const DatasetBase* input,
           std::unique_ptr<CapturedFunction> captured_func, int64 cycle_length,
           int64 block_length, int64 num_parallel_calls, bool sloppy,
+          int64 buffer_output_elements, bool reopen_stragglers,
           const DataTypeVector& output_types,
           const std::vector<PartialTensorShape>& output_shapes)
       : DatasetBase(DatasetContext(ctx)),
@@ -121,6 +135,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         block_length_(block_length),
         num_parallel_calls_(num_parallel_calls),
         sloppy_(sloppy),
+        buffer_output_elements_(buffer_output_elements),
+        reopen_stragglers_(reopen_stragglers),
         output_types_(output_types),
         output_shapes_(output_shapes) {
     input_->Ref();
@@ -176,17 +192,24 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
     AttrValue sloppy_attr;
     b->BuildAttrValue(sloppy_, &sloppy_attr);
+    AttrValue buffer_output_elements_attr;
+    b->BuildAttrValue(buffer_output_elements_, &buffer_output_elements_attr);
+    AttrValue reopen_stragglers_attr;
+    b->BuildAttrValue(reopen_stragglers_, &reopen_stragglers_attr);
 
-    TF_RETURN_IF_ERROR(b->AddDataset(this,
-                                     {{0, input_node},
-                                      {2, cycle_length_node},
-                                      {3, block_length_node},
-                                      {4, num_parallel_calls_node}},
-                                     {{1, other_arguments}},
-                                     {{kFunc, f},
-                                      {kTarguments, other_arguments_types_attr},
-                                      {kSloppy, sloppy_attr}},
-                                     output));
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this,
+                      {{0, input_node},
+                       {2, cycle_length_node},
+                       {3, block_length_node},
+                       {4, num_parallel_calls_node}},
+                      {{1, other_arguments}},
+                      {{kFunc, f},
+                       {kTarguments, other_arguments_types_attr},
+                       {kSloppy, sloppy_attr},
+                       {kBufferOutputElements, buffer_output_elements_attr},
+                       {kReopenStragglers, reopen_stragglers_attr}},
+                      output));
     return Status::OK();
   }
 
@@ -200,6 +223,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           num_parallel_calls_(std::make_shared<model::SharedState>(
               params.dataset->num_parallel_calls_, mu_, cond_var_)),
           sloppy_(sloppy),
+          reopen_stragglers_(params.dataset->reopen_stragglers_ && !sloppy),
           current_elements_(params.dataset->cycle_length_) {
       // The size of the threadpool is the smaller of:
       //
@@ -254,9 +278,28 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       {
         mutex_lock l(*mu_);
         EnsureThreadsStarted(ctx);
+        // The cycle element the consumer is blocked on, and since when.
+        std::shared_ptr<Element> stalled_element;
+        int64 stall_start_us = 0;
         while (!Consume(&result)) {
           RecordStop(ctx);
-          cond_var_->wait(l);
+          if (reopen_stragglers_) {
+            const std::shared_ptr<Element>& element =
+                current_elements_[cycle_index_];
+            const int64 now_us = EnvTime::Default()->NowMicros();
+            if (element != stalled_element) {
+              stalled_element = element;
+              stall_start_us = now_us;
+            } else if (element &&
+                       now_us - stall_start_us >= StragglerTimeoutUs()) {
+              MaybeReopenStraggler(ctx, cycle_index_);
+              stall_start_us = now_us;
+            }
+            WaitForMilliseconds(&l, cond_var_.get(),
+                                StragglerTimeoutUs() / 1000);
+          } else {
+            cond_var_->wait(l);
+          }
           RecordStart(ctx);
         }
       }
@@ -348,6 +391,14 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       std::deque<std::shared_ptr<Result>> results GUARDED_BY(mu);
       // Indicates whether the element is used by a worker thread.
       bool in_use = false;
+      // The number of results produced by `iterator` so far, or -1 if unknown
+      // (e.g. restored from a checkpoint that predates this field).
+      int64 num_fetched GUARDED_BY(mu) = 0;
+      // Indicates whether a reopened copy of this element is being created.
+      bool reopening = false;
+      // Indicates whether this element has been replaced in the cycle by a
+      // reopened copy, in which case its worker discards what it fetches.
+      bool abandoned = false;
     };
 
     // Advances the position in the interleave cycle to the next cycle
@@ -445,7 +496,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       auto busy = [this]() EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
         const bool has_more_elements =
             !future_elements_.empty() || !end_of_input_;
-        const int block_length = dataset()->block_length_;
+        const int64 buffer_size = BufferSize();
         bool all_elements_busy = true;
         for (auto& element : current_elements_) {
           if (!element) {
@@ -456,7 +507,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           } else {
             mutex_lock l(element->mu);
             if (!element->in_use && element->iterator &&
-                element->results.size() < block_length) {
+                element->results.size() < buffer_size) {
               all_elements_busy = false;
               break;
             }
@@ -503,7 +554,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
             int64 num_results;
             {
               mutex_lock l(element->mu);
-              num_results = dataset()->block_length_ - element->results.size();
+              num_results = BufferSize() - element->results.size();
             }
             if (num_results > 0) {
               current_num_calls_++;
@@ -564,15 +615,23 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       bool end_of_input = false;
       for (int64 i = 0; i < num_results; ++i) {
         auto result = std::make_shared<Result>();
+        const int64 start_us = EnvTime::Default()->NowMicros();
         result->status = element->iterator->GetNext(
             ctx.get(), &result->return_values, &end_of_input);
         if (end_of_input) {
           break;
         }
-        RecordBufferEnqueue(ctx.get(), result->return_values);
         mutex_lock l(*mu_);
+        if (element->abandoned) {
+          break;
+        }
+        UpdateFetchLatency(EnvTime::Default()->NowMicros() - start_us);
+        RecordBufferEnqueue(ctx.get(), result->return_values);
         mutex_lock l2(element->mu);
         element->results.push_back(result);
+        if (element->num_fetched >= 0) {
+          ++element->num_fetched;
+        }
         result->is_ready = true;
         cond_var_->notify_all();
       }
@@ -580,6 +639,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       mutex_lock l(*mu_);
       // Release the ownership of the cycle element iterator.
       element->in_use = false;
+      if (element->abandoned) {
+        // The reopened copy of the element owns the open iterator count.
+        done();
+        cond_var_->notify_all();
+        return;
+      }
       if (end_of_input) {
         // Close the iterator if end of input was encountered.
         element->iterator.reset();
@@ -590,6 +655,109 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       cond_var_->notify_all();
     }
 
+    // Returns the number of results each current cycle element may buffer.
+    int64 BufferSize() const {
+      return std::max(dataset()->buffer_output_elements_,
+                      dataset()->block_length_);
+    }
+
+    // Returns how long the consumer waits on a cycle element before it is
+    // considered a straggler.
+    int64 StragglerTimeoutUs() const EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      return std::max(kMinStragglerTimeoutUs,
+                      static_cast<int64>(kStragglerFactor * fetch_latency_us_));
+    }
+
+    // Updates the moving average of the time it takes to fetch a result.
+    void UpdateFetchLatency(int64 latency_us) EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (fetch_latency_us_ == 0) {
+        fetch_latency_us_ = latency_us;
+      } else {
+        fetch_latency_us_ = 0.9 * fetch_latency_us_ + 0.1 * latency_us;
+      }
+    }
+
+    // Schedules the creation of a copy of the current cycle element at
+    // position `idx` if its worker is still busy fetching the element the
+    // consumer is waiting for.
+    void MaybeReopenStraggler(IteratorContext* ctx, int64 idx)
+        EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      std::shared_ptr<Element> element = current_elements_[idx];
+      if (cancelled_ || !element || !element->iterator || !element->in_use ||
+          element->reopening || element->abandoned) {
+        return;
+      }
+      int64 num_fetched;
+      {
+        mutex_lock l(element->mu);
+        if (!element->results.empty() || element->num_fetched < 0) {
+          return;
+        }
+        num_fetched = element->num_fetched;
+      }
+      VLOG(2) << "Reopening straggling cycle element " << element->id
+              << " after " << num_fetched << " elements.";
+      element->reopening = true;
+      ++current_num_calls_;
+      // The copy is not registered with the model, because it would share the
+      // name of the node of the iterator it replaces.
+      IteratorContext::Params params(ctx);
+      params.model = nullptr;
+      auto new_ctx = std::make_shared<IteratorContext>(std::move(params));
+      thread_pool_->Schedule(
+          std::bind(&ParallelInterleaveIterator::ReopenElement, this,
+                    std::move(new_ctx), std::move(element), idx, num_fetched));
+    }
+
+    // Re-creates the iterator of `element`, skips the `num_fetched` results
+    // that the original iterator already produced, and fetches the next one.
+    // If the original iterator has not produced that result in the meantime,
+    // the copy replaces `element` in the cycle.
+    void ReopenElement(const std::shared_ptr<IteratorContext>& ctx,
+                       const std::shared_ptr<Element>& element, int64 idx,
+                       int64 num_fetched) LOCKS_EXCLUDED(*mu_) {
+      auto replacement = std::make_shared<Element>();
+      replacement->id = element->id;
+      replacement->inputs = element->inputs;
+      auto result = std::make_shared<Result>();
+      bool end_of_input = false;
+      Status s = MakeIteratorFromInputElement(
+          ctx.get(), replacement->inputs, replacement->id,
+          *instantiated_captured_func_, prefix(), &replacement->iterator);
+      for (int64 i = 0; s.ok() && !end_of_input && i <= num_fetched; ++i) {
+        result->return_values.clear();
+        s = replacement->iterator->GetNext(ctx.get(), &result->return_values,
+                                           &end_of_input);
+        mutex_lock l(*mu_);
+        if (cancelled_) {
+          break;
+        }
+      }
+
+      mutex_lock l(*mu_);
+      --current_num_calls_;
+      element->reopening = false;
+      cond_var_->notify_all();
+      // Only replace the original when the copy produced the element that the
+      // consumer is waiting for and the original is still fetching it.
+      if (cancelled_ || !s.ok() || end_of_input ||
+          current_elements_[idx] != element || !element->in_use) {
+        return;
+      }
+      mutex_lock l2(element->mu);
+      if (!element->results.empty() || element->num_fetched != num_fetched) {
+        return;
+      }
+      result->is_ready = true;
+      {
+        mutex_lock l3(replacement->mu);
+        replacement->results.push_back(std::move(result));
+        replacement->num_fetched = num_fetched + 1;
+      }
+      element->abandoned = true;
+      current_elements_[idx] = std::move(replacement);
+    }
+
     // Manages futures cycle elements, creating new iterators as needed and
     // asynchronously fetching results from existing iterators.
     //
@@ -741,6 +909,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           full_name(strings::StrCat(key_prefix, "[", idx, "]", kResultsSuffix,
                                     kSizeSuffix)),
           element->results.size()));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(
+              strings::StrCat(key_prefix, "[", idx, "]", kNumFetchedSuffix)),
+          element->num_fetched));
       for (size_t i = 0; i < element->results.size(); i++) {
         std::shared_ptr<Result> result = element->results[i];
         TF_RETURN_IF_ERROR(WriteStatusLocked(
@@ -809,6 +981,14 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                                     kSizeSuffix)),
           &results_size));
       element->results.resize(results_size);
+      const string num_fetched_key = full_name(
+          strings::StrCat(key_prefix, "[", idx, "]", kNumFetchedSuffix));
+      if (reader->Contains(num_fetched_key)) {
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(num_fetched_key, &element->num_fetched));
+      } else {
+        element->num_fetched = -1;
+      }
       for (size_t i = 0; i < results_size; i++) {
         auto result = std::make_shared<Result>();
         TF_RETURN_IF_ERROR(
@@ -905,6 +1085,13 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Determines whether outputs can be produced in non-deterministic order.
     const bool sloppy_;
 
+    // Determines whether straggling cycle elements are speculatively
+    // reopened. Only used when outputs are produced in deterministic order.
+    const bool reopen_stragglers_;
+
+    // Moving average of the time it takes to fetch a result, in microseconds.
+    double fetch_latency_us_ GUARDED_BY(*mu_) = 0;
+
     // Iterator for input elements.
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(*mu_);
 
@@ -946,6 +1133,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   const int64 num_parallel_calls_;
   const int op_version_ = 2;
   const bool sloppy_;
+  const int64 buffer_output_elements_;
+  const bool reopen_stragglers_;
   const DataTypeVector output_types_;
   const std::vector<PartialTensorShape> output_shapes_;
 };
@@ -960,6 +1149,13 @@ ParallelInterleaveDatasetOp::ParallelInterleaveDatasetOp(
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kSloppy, &sloppy_));
+  OP_REQUIRES_OK(ctx,
+                 ctx->GetAttr(kBufferOutputElements, &buffer_output_elements_));
+  OP_REQUIRES(ctx, buffer_output_elements_ >= 0,
+              errors::InvalidArgument(
+                  "`buffer_output_elements` must be >= 0, but got ",
+                  buffer_output_elements_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReopenStragglers, &reopen_stragglers_));
 }
 
 void ParallelInterleaveDatasetOp::MakeDataset(OpKernelContext* ctx,
@@ -1000,6 +1196,7 @@ void ParallelInterleaveDatasetOp::MakeDataset(OpKernelContext* ctx,
 
   *output = new Dataset(ctx, input, std::move(captured_func), cycle_length,
                         block_length, num_parallel_calls, sloppy_,
+                        buffer_output_elements_, reopen_stragglers_,
                         output_types_, output_shapes_);
 }
 
@@ -34,6 +34,9 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kOutputTypes = "output_types";
   static constexpr const char* const kOutputShapes = "output_shapes";
   static constexpr const char* const kSloppy = "sloppy";
+  static constexpr const char* const kBufferOutputElements =
+      "buffer_output_elements";
+  static constexpr const char* const kReopenStragglers = "reopen_stragglers";
 
   explicit ParallelInterleaveDatasetOp(OpKernelConstruction* ctx);
 
@@ -47,6 +50,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
   bool sloppy_;
+  int64 buffer_output_elements_;
+  bool reopen_stragglers_;
 };
 
 }  // namespace data
@@ -39,6 +39,7 @@ class ParallelInterleaveDatasetOpTest : public DatasetOpsTestBase {
       const FunctionDefHelper::AttrValueWrapper &func,
       const DataTypeVector &output_types,
       const std::vector<PartialTensorShape> &output_shapes, bool sloppy,
+      int64 buffer_output_elements, bool reopen_stragglers,
       std::unique_ptr<OpKernel> *op_kernel) {
     name_utils::OpNameParams params;
     params.op_version = kOpVersion;
@@ -53,7 +54,10 @@ class ParallelInterleaveDatasetOpTest : public DatasetOpsTestBase {
          {ParallelInterleaveDatasetOp::kTarguments, {}},
          {ParallelInterleaveDatasetOp::kOutputTypes, output_types},
          {ParallelInterleaveDatasetOp::kOutputShapes, output_shapes},
-         {ParallelInterleaveDatasetOp::kSloppy, sloppy}});
+         {ParallelInterleaveDatasetOp::kSloppy, sloppy},
+         {ParallelInterleaveDatasetOp::kBufferOutputElements,
+          buffer_output_elements},
+         {ParallelInterleaveDatasetOp::kReopenStragglers, reopen_stragglers}});
     TF_RETURN_IF_ERROR(CreateOpKernel(node_def, op_kernel));
     return Status::OK();
   }
@@ -82,6 +86,8 @@ struct TestCase {
   std::vector<PartialTensorShape> expected_output_shapes;
   int64 expected_cardinality;
   std::vector<int> breakpoints;
+  int64 buffer_output_elements = 0;
+  bool reopen_stragglers = false;
 };
 
 template <typename T>
@@ -449,6 +455,23 @@ TestCase InvalidNumParallelCallsTestCase() {
           /*breakpoints*/ {}};
 }
 
+// test case 14: the same as test case 2, but each cycle element buffers up to
+// 3 elements ahead of the consumer.
+TestCase BufferOutputElementsTestCase() {
+  TestCase test_case = TestCase2();
+  test_case.buffer_output_elements = 3;
+  return test_case;
+}
+
+// test case 15: the same as test case 7, but with straggler reopening
+// enabled.
+TestCase ReopenStragglersTestCase() {
+  TestCase test_case = TestCase7();
+  test_case.buffer_output_elements = 2;
+  test_case.reopen_stragglers = true;
+  return test_case;
+}
+
 class ParameterizedParallelInterleaveDatasetOpTest
     : public ParallelInterleaveDatasetOpTest,
       public ::testing::WithParamInterface<TestCase> {};
@@ -463,6 +486,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, GetNext) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -517,6 +541,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, InvalidArguments) {
     TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
         test_case.func, test_case.expected_output_dtypes,
         test_case.expected_output_shapes, test_case.sloppy,
+        test_case.buffer_output_elements, test_case.reopen_stragglers,
         &parallel_interleave_dataset_kernel));
 
     Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -553,6 +578,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, DatasetNodeName) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -588,6 +614,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, DatasetTypeString) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -627,6 +654,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, DatasetOutputDtypes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -663,6 +691,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, DatasetOutputShapes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -700,6 +729,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, Cardinality) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -736,6 +766,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, DatasetSave) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -777,6 +808,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, IteratorOutputDtypes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -820,6 +852,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, IteratorOutputShapes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -863,6 +896,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, IteratorOutputPrefix) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -908,6 +942,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, Roundtrip) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
+      test_case.buffer_output_elements, test_case.reopen_stragglers,
       &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
@@ -971,7 +1006,8 @@ INSTANTIATE_TEST_SUITE_P(
     ParameterizedParallelInterleaveDatasetOpTest,
     ::testing::ValuesIn(std::vector<TestCase>(
         {TestCase1(), TestCase2(), TestCase3(), TestCase4(), TestCase5(),
-         TestCase6(), TestCase7(), TestCase8(), TestCase9(), TestCase10()})));
+         TestCase6(), TestCase7(), TestCase8(), TestCase9(), TestCase10(),
+         BufferOutputElementsTestCase(), ReopenStragglersTestCase()})));
 
 }  // namespace
 }  // namespace data
@@ -268,7 +268,7 @@ class ParallelMapIterator : public DatasetBaseIterator {
       *out_tensors = std::move(result->return_values);
       RecordBufferDequeue(ctx, *out_tensors);
       *end_of_sequence = false;
-      return Status::OK();
+      return MaybeFillBatchSlot(ctx, *out_tensors);
     }
     if (errors::IsOutOfRange(result->status)) {
       if (preserve_cardinality_) {
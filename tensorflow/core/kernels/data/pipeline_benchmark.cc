@@ -0,0 +1,365 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/pipeline_benchmark.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/function_handle_cache.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/kernels/data/unbounded_thread_pool.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kIteratorPrefix[] = "PipelineBenchmark";
+
+double PerSecond(int64 count, int64 nanos) {
+  return nanos > 0 ? count * 1e9 / nanos : 0.0;
+}
+
+// A dataset that repeats a fixed list of elements held in memory. It stands
+// in for the input of a stage run in isolation.
+class CachedElementsDataset : public DatasetBase {
+ public:
+  CachedElementsDataset(std::vector<std::vector<Tensor>> elements,
+                        const DataTypeVector& output_dtypes,
+                        const std::vector<PartialTensorShape>& output_shapes)
+      : DatasetBase(DatasetContext({"CachedElementsDataset", ""})),
+        elements_(std::move(elements)),
+        output_dtypes_(output_dtypes),
+        output_shapes_(output_shapes) {}
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(
+        Iterator::Params{this, strings::StrCat(prefix, "::CachedElements")});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return output_dtypes_;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  int64 Cardinality() const override { return kInfiniteCardinality; }
+
+  string DebugString() const override {
+    return "CachedElementsDatasetOp::Dataset";
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    return errors::Unimplemented(DebugString(),
+                                 " does not support serialization.");
+  }
+
+ private:
+  class Iterator : public DatasetIterator<CachedElementsDataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<CachedElementsDataset>(params) {}
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      const auto& elements = dataset()->elements_;
+      *out_tensors = elements[index_];
+      index_ = (index_ + 1) % elements.size();
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+   private:
+    size_t index_ = 0;
+  };
+
+  const std::vector<std::vector<Tensor>> elements_;
+  const DataTypeVector output_dtypes_;
+  const std::vector<PartialTensorShape> output_shapes_;
+};
+
+void CollectNodeStats(const model::Node& node, int64 wall_time_nanos,
+                      std::vector<PipelineNodeStats>* nodes) {
+  PipelineNodeStats stats;
+  stats.name = node.long_name();
+  stats.num_elements = node.num_elements();
+  stats.bytes_produced = node.bytes_produced();
+  stats.processing_time_nanos = node.processing_time();
+  stats.cpu_time_nanos = node.cpu_time();
+  stats.elements_per_second = PerSecond(stats.num_elements, wall_time_nanos);
+  stats.bytes_per_second = PerSecond(stats.bytes_produced, wall_time_nanos);
+  stats.max_elements_per_second =
+      PerSecond(stats.num_elements, stats.processing_time_nanos);
+  nodes->push_back(std::move(stats));
+  for (const auto& input : node.inputs()) {
+    CollectNodeStats(*input, wall_time_nanos, nodes);
+  }
+}
+
+}  // namespace
+
+string PipelineBenchmarkResult::DebugString() const {
+  string result = strings::StrCat(
+      stage.empty() ? "Pipeline" : strings::StrCat("Stage ", stage), ": ",
+      num_elements, " elements in ", wall_time_nanos / 1000, "us, ",
+      strings::Printf("%.1f", elements_per_second), " elements/s, ",
+      strings::HumanReadableNumBytes(static_cast<int64>(bytes_per_second)),
+      "/s\n");
+  for (const PipelineNodeStats& node : nodes) {
+    strings::StrAppend(
+        &result, "  ", node.name, ": ", node.num_elements, " elements, ",
+        strings::Printf("%.1f", node.elements_per_second), " elements/s, ",
+        strings::HumanReadableNumBytes(
+            static_cast<int64>(node.bytes_per_second)),
+        "/s, at most ",
+        strings::Printf("%.1f", node.max_elements_per_second),
+        " elements/s alone, cpu ", node.cpu_time_nanos / 1000, "us\n");
+  }
+  return result;
+}
+
+PipelineBenchmark::PipelineBenchmark(const GraphDef& graph_def)
+    : graph_def_(graph_def) {}
+
+PipelineBenchmark::~PipelineBenchmark() {}
+
+Status PipelineBenchmark::Create(
+    const GraphDef& graph_def, std::unique_ptr<PipelineBenchmark>* benchmark) {
+  std::unique_ptr<PipelineBenchmark> result(new PipelineBenchmark(graph_def));
+  TF_RETURN_IF_ERROR(result->Initialize());
+  *benchmark = std::move(result);
+  return Status::OK();
+}
+
+Status PipelineBenchmark::Initialize() {
+  for (const auto& node : graph_def_.node()) {
+    if (node.op() == FunctionLibraryDefinition::kRetOp) {
+      output_node_ = node.input(0);
+    }
+  }
+  if (output_node_.empty()) {
+    return errors::InvalidArgument("The dataset graph has no output.");
+  }
+
+  std::unique_ptr<Device> device = DeviceFactory::NewDevice(
+      "CPU", SessionOptions(), "/job:localhost/replica:0/task:0");
+  if (device == nullptr) {
+    return errors::Internal("Could not create a CPU device.");
+  }
+  Device* device_ptr = device.get();
+  device_mgr_ = absl::make_unique<DeviceMgr>(std::move(device));
+  pool_ = absl::make_unique<thread::ThreadPool>(
+      Env::Default(), "pipeline_benchmark", port::NumSchedulableCPUs());
+  flib_def_ = absl::make_unique<FunctionLibraryDefinition>(
+      OpRegistry::Global(), graph_def_.library());
+  pflr_ = absl::make_unique<ProcessFunctionLibraryRuntime>(
+      device_mgr_.get(), Env::Default(), TF_GRAPH_DEF_VERSION,
+      flib_def_.get(), OptimizerOptions(), pool_.get());
+  flr_ = pflr_->GetFLR(device_ptr->name());
+  function_handle_cache_ = absl::make_unique<FunctionHandleCache>(flr_);
+  resource_mgr_ = absl::make_unique<ResourceMgr>("pipeline_benchmark");
+  unbounded_thread_pool_ = absl::make_unique<UnboundedThreadPool>(
+      Env::Default(), "pipeline_benchmark_iterator");
+
+  // Walk from the output towards the source, along the first input of each
+  // dataset that transforms another dataset.
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const auto& node : graph_def_.node()) {
+    nodes[node.name()] = &node;
+  }
+  string name(ParseTensorName(output_node_).first);
+  while (nodes.count(name) > 0) {
+    const NodeDef& node = *nodes[name];
+    const OpDef* op_def;
+    TF_RETURN_IF_ERROR(flib_def_->LookUpOpDef(node.op(), &op_def));
+    if (node.input_size() == 0 || op_def->input_arg_size() == 0 ||
+        op_def->input_arg(0).type() != DT_VARIANT) {
+      break;
+    }
+    stages_.push_back(name);
+    name = string(ParseTensorName(node.input(0)).first);
+  }
+  return Status::OK();
+}
+
+Status PipelineBenchmark::Run(int64 num_elements,
+                              PipelineBenchmarkResult* result) {
+  Tensor dataset_variant;
+  TF_RETURN_IF_ERROR(MakeDataset(output_node_, {}, &dataset_variant));
+  return Measure(dataset_variant, num_elements, result);
+}
+
+Status PipelineBenchmark::RunStage(const string& stage, int64 num_elements,
+                                   int64 num_input_elements,
+                                   PipelineBenchmarkResult* result) {
+  if (std::find(stages_.begin(), stages_.end(), stage) == stages_.end()) {
+    return errors::InvalidArgument("\"", stage,
+                                   "\" is not a stage of the pipeline.");
+  }
+  const NodeDef* stage_node = nullptr;
+  for (const auto& node : graph_def_.node()) {
+    if (node.name() == stage) {
+      stage_node = &node;
+    }
+  }
+  const string& input_name = stage_node->input(0);
+
+  // Cache the elements of the input of the stage.
+  Tensor input_variant;
+  TF_RETURN_IF_ERROR(MakeDataset(input_name, {}, &input_variant));
+  DatasetBase* input;
+  TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(input_variant, &input));
+  std::vector<std::vector<Tensor>> elements;
+  {
+    std::unique_ptr<IteratorContext> ctx = MakeIteratorContext(nullptr);
+    std::unique_ptr<IteratorBase> iterator;
+    TF_RETURN_IF_ERROR(
+        input->MakeIterator(ctx.get(), kIteratorPrefix, &iterator));
+    bool end_of_sequence = false;
+    while (static_cast<int64>(elements.size()) < num_input_elements) {
+      std::vector<Tensor> components;
+      TF_RETURN_IF_ERROR(
+          iterator->GetNext(ctx.get(), &components, &end_of_sequence));
+      if (end_of_sequence) {
+        break;
+      }
+      elements.push_back(std::move(components));
+    }
+  }
+  if (elements.empty()) {
+    return errors::FailedPrecondition("The input of stage \"", stage,
+                                      "\" produced no elements.");
+  }
+
+  Tensor cached_variant(DT_VARIANT, TensorShape({}));
+  TF_RETURN_IF_ERROR(StoreDatasetInVariantTensor(
+      new CachedElementsDataset(std::move(elements), input->output_dtypes(),
+                                input->output_shapes()),
+      &cached_variant));
+  Tensor stage_variant;
+  TF_RETURN_IF_ERROR(
+      MakeDataset(stage, {{input_name, cached_variant}}, &stage_variant));
+  TF_RETURN_IF_ERROR(Measure(stage_variant, num_elements, result));
+  result->stage = stage;
+  return Status::OK();
+}
+
+Status PipelineBenchmark::MakeDataset(
+    const string& output_node,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    Tensor* dataset_variant) {
+  Graph graph(OpRegistry::Global());
+  TF_RETURN_IF_ERROR(ImportGraphDef({}, graph_def_, &graph, nullptr));
+  std::vector<Tensor> outputs;
+  GraphRunner graph_runner(flr_->device());
+  TF_RETURN_IF_ERROR(
+      graph_runner.Run(&graph, flr_, inputs, {output_node}, &outputs));
+  DatasetBase* dataset;
+  TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(outputs[0], &dataset));
+  *dataset_variant = outputs[0];
+  return Status::OK();
+}
+
+std::unique_ptr<IteratorContext> PipelineBenchmark::MakeIteratorContext(
+    std::shared_ptr<model::Model> model) {
+  IteratorContext::Params params;
+  params.env = Env::Default();
+  params.flr = flr_;
+  params.function_handle_cache = function_handle_cache_.get();
+  params.resource_mgr = resource_mgr_.get();
+  params.model = std::move(model);
+  DeviceBase* device = flr_->device();
+  params.allocator_getter = [device](AllocatorAttributes attrs) {
+    return device->GetAllocator(attrs);
+  };
+  thread::ThreadPool* pool = pool_.get();
+  params.runner = [pool](std::function<void()> fn) {
+    pool->Schedule(std::move(fn));
+  };
+  params.runner_threadpool_size = pool->NumThreads();
+  params.thread_factory = unbounded_thread_pool_->get_thread_factory();
+  return absl::make_unique<IteratorContext>(std::move(params));
+}
+
+Status PipelineBenchmark::Measure(const Tensor& dataset_variant,
+                                  int64 num_elements,
+                                  PipelineBenchmarkResult* result) {
+  DatasetBase* dataset;
+  TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(dataset_variant, &dataset));
+  auto model = std::make_shared<model::Model>(
+      [](std::shared_ptr<model::Node> node) {});
+  model->EnableResourceUsageCollection();
+  std::unique_ptr<IteratorContext> ctx = MakeIteratorContext(model);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_RETURN_IF_ERROR(
+      dataset->MakeIterator(ctx.get(), kIteratorPrefix, &iterator));
+
+  *result = PipelineBenchmarkResult();
+  const uint64 start_nanos = Env::Default()->NowNanos();
+  bool end_of_sequence = false;
+  while (result->num_elements < num_elements) {
+    std::vector<Tensor> components;
+    TF_RETURN_IF_ERROR(
+        iterator->GetNext(ctx.get(), &components, &end_of_sequence));
+    if (end_of_sequence) {
+      break;
+    }
+    ++result->num_elements;
+    result->bytes += GetAllocatedBytes(components);
+  }
+  result->wall_time_nanos = Env::Default()->NowNanos() - start_nanos;
+  result->elements_per_second =
+      PerSecond(result->num_elements, result->wall_time_nanos);
+  result->bytes_per_second = PerSecond(result->bytes, result->wall_time_nanos);
+
+  // Destroying the iterator removes its nodes from the model, so collect them
+  // first.
+  if (std::shared_ptr<model::Node> output = model->output()) {
+    CollectNodeStats(*output, result->wall_time_nanos, &result->nodes);
+  }
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,152 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_PIPELINE_BENCHMARK_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_PIPELINE_BENCHMARK_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class DeviceMgr;
+class FunctionHandleCache;
+class FunctionLibraryDefinition;
+class FunctionLibraryRuntime;
+class IteratorContext;
+class ProcessFunctionLibraryRuntime;
+class ResourceMgr;
+
+namespace thread {
+class ThreadPool;
+}  // namespace thread
+
+namespace data {
+
+class UnboundedThreadPool;
+
+// The measurements of one `model::Node` of the input pipeline.
+struct PipelineNodeStats {
+  // The long name of the node, e.g. "Map(id:2)".
+  string name;
+  int64 num_elements = 0;
+  int64 bytes_produced = 0;
+  // The time spent in the node itself, excluding the time spent in its inputs.
+  int64 processing_time_nanos = 0;
+  int64 cpu_time_nanos = 0;
+
+  // The rates at which the node produced elements over the run.
+  double elements_per_second = 0.0;
+  double bytes_per_second = 0.0;
+  // The rate the node could sustain if its inputs were free, estimated from
+  // its processing time.
+  double max_elements_per_second = 0.0;
+};
+
+// The result of a `PipelineBenchmark` run.
+struct PipelineBenchmarkResult {
+  // The stage run in isolation, or empty for the whole pipeline.
+  string stage;
+
+  int64 num_elements = 0;
+  int64 bytes = 0;
+  int64 wall_time_nanos = 0;
+  double elements_per_second = 0.0;
+  double bytes_per_second = 0.0;
+
+  // The nodes of the input pipeline, in depth-first order from the output.
+  std::vector<PipelineNodeStats> nodes;
+
+  string DebugString() const;
+};
+
+// Benchmarks a tf.data input pipeline, serialized as a `GraphDef` by
+// `DatasetToGraph`, outside of a session.
+//
+// `Run()` measures the throughput of the whole pipeline, and of each of its
+// `model::Node`s. `RunStage()` cuts the pipeline at one of its stages: the
+// input of the stage is run first and its elements are cached in memory, then
+// the stage alone is run on the cached elements. This measures the ceiling
+// of the stage, independently of the stages upstream of it.
+//
+// Only the time spent in `GetNext()` is measured; creating the datasets and
+// iterators is not. Input pipelines that contain a `ModelDataset` report
+// the nodes below it as a single node, since `ModelDataset` keeps its own
+// model.
+class PipelineBenchmark {
+ public:
+  static Status Create(const GraphDef& graph_def,
+                       std::unique_ptr<PipelineBenchmark>* benchmark);
+
+  ~PipelineBenchmark();
+
+  // The names of the `graph_def` nodes of the stages that can be run in
+  // isolation, from the output of the pipeline to its source: the datasets
+  // that transform an input dataset, following the first input of each.
+  const std::vector<string>& stages() const { return stages_; }
+
+  // Runs the pipeline for `num_elements` elements, or until it is exhausted.
+  Status Run(int64 num_elements, PipelineBenchmarkResult* result);
+
+  // Runs `stage` alone for `num_elements` elements, on the first
+  // `num_input_elements` elements of its input, repeated as often as needed.
+  Status RunStage(const string& stage, int64 num_elements,
+                  int64 num_input_elements, PipelineBenchmarkResult* result);
+
+ private:
+  explicit PipelineBenchmark(const GraphDef& graph_def);
+
+  Status Initialize();
+
+  // Runs the graph and returns the dataset output by `output_node`, with the
+  // tensors of `inputs` fed in place of the outputs they name.
+  Status MakeDataset(
+      const string& output_node,
+      const std::vector<std::pair<string, Tensor>>& inputs,
+      Tensor* dataset_variant);
+
+  std::unique_ptr<IteratorContext> MakeIteratorContext(
+      std::shared_ptr<model::Model> model);
+
+  Status Measure(const Tensor& dataset_variant, int64 num_elements,
+                 PipelineBenchmarkResult* result);
+
+  const GraphDef graph_def_;
+  string output_node_;
+  std::vector<string> stages_;
+
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<thread::ThreadPool> pool_;
+  std::unique_ptr<FunctionLibraryDefinition> flib_def_;
+  std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
+  FunctionLibraryRuntime* flr_ = nullptr;
+  std::unique_ptr<FunctionHandleCache> function_handle_cache_;
+  std::unique_ptr<ResourceMgr> resource_mgr_;
+  std::unique_ptr<UnboundedThreadPool> unbounded_thread_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PipelineBenchmark);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_PIPELINE_BENCHMARK_H_
@@ -0,0 +1,109 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks a tf.data input pipeline serialized by `DatasetToGraph`, e.g.
+// the value of `dataset._as_serialized_graph()` written to a file.
+//
+//   pipeline_benchmark --graph_def=/tmp/pipeline.pb --num_elements=1000 \
+//     --stage=all
+//
+// With --stage=all, the whole pipeline is run first, then each of its stages
+// alone on the cached elements of its input.
+
+#include <iostream>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/kernels/data/pipeline_benchmark.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+int Main(int argc, char** argv) {
+  string graph_def_path;
+  int64 num_elements = 1000;
+  string stage;
+  int64 num_input_elements = 1000;
+  std::vector<Flag> flag_list = {
+      Flag("graph_def", &graph_def_path,
+           "file with the binary or text GraphDef of the pipeline"),
+      Flag("num_elements", &num_elements,
+           "number of elements to produce in each run"),
+      Flag("stage", &stage,
+           "stage to run alone, \"all\" to run the pipeline and each stage, "
+           "or empty to run the pipeline only"),
+      Flag("num_input_elements", &num_input_elements,
+           "number of input elements to cache for a stage run alone"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  if (!Flags::Parse(&argc, argv, flag_list) || graph_def_path.empty()) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  port::InitMain(argv[0], &argc, &argv);
+
+  GraphDef graph_def;
+  Status s = ReadBinaryProto(Env::Default(), graph_def_path, &graph_def);
+  if (!s.ok()) {
+    s = ReadTextProto(Env::Default(), graph_def_path, &graph_def);
+  }
+  if (!s.ok()) {
+    LOG(ERROR) << "Could not read " << graph_def_path << ": " << s;
+    return -1;
+  }
+  std::unique_ptr<PipelineBenchmark> benchmark;
+  s = PipelineBenchmark::Create(graph_def, &benchmark);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return -1;
+  }
+
+  std::vector<string> stages;
+  if (stage == "all") {
+    stages = benchmark->stages();
+  } else if (!stage.empty()) {
+    stages.push_back(stage);
+  }
+  PipelineBenchmarkResult result;
+  if (stage.empty() || stage == "all") {
+    s = benchmark->Run(num_elements, &result);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return -1;
+    }
+    std::cout << result.DebugString();
+  }
+  for (const string& name : stages) {
+    s = benchmark->RunStage(name, num_elements, num_input_elements, &result);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return -1;
+    }
+    std::cout << result.DebugString();
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  return tensorflow::data::Main(argc, argv);
+}
@@ -0,0 +1,160 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/pipeline_benchmark.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// range(100).batch(4)
+constexpr char kGraphDef[] = R"proto(
+  node {
+    name: "start"
+    op: "Const"
+    attr { key: "dtype" value { type: DT_INT64 } }
+    attr {
+      key: "value"
+      value { tensor { dtype: DT_INT64 tensor_shape {} int64_val: 0 } }
+    }
+  }
+  node {
+    name: "stop"
+    op: "Const"
+    attr { key: "dtype" value { type: DT_INT64 } }
+    attr {
+      key: "value"
+      value { tensor { dtype: DT_INT64 tensor_shape {} int64_val: 100 } }
+    }
+  }
+  node {
+    name: "step"
+    op: "Const"
+    attr { key: "dtype" value { type: DT_INT64 } }
+    attr {
+      key: "value"
+      value { tensor { dtype: DT_INT64 tensor_shape {} int64_val: 1 } }
+    }
+  }
+  node {
+    name: "range"
+    op: "RangeDataset"
+    input: "start"
+    input: "stop"
+    input: "step"
+    attr { key: "output_types" value { list { type: DT_INT64 } } }
+    attr { key: "output_shapes" value { list { shape {} } } }
+  }
+  node {
+    name: "batch_size"
+    op: "Const"
+    attr { key: "dtype" value { type: DT_INT64 } }
+    attr {
+      key: "value"
+      value { tensor { dtype: DT_INT64 tensor_shape {} int64_val: 4 } }
+    }
+  }
+  node {
+    name: "drop_remainder"
+    op: "Const"
+    attr { key: "dtype" value { type: DT_BOOL } }
+    attr {
+      key: "value"
+      value { tensor { dtype: DT_BOOL tensor_shape {} bool_val: false } }
+    }
+  }
+  node {
+    name: "batch"
+    op: "BatchDatasetV2"
+    input: "range"
+    input: "batch_size"
+    input: "drop_remainder"
+    attr { key: "output_types" value { list { type: DT_INT64 } } }
+    attr {
+      key: "output_shapes"
+      value { list { shape { dim { size: -1 } } } }
+    }
+  }
+  node {
+    name: "output"
+    op: "_Retval"
+    input: "batch"
+    attr { key: "T" value { type: DT_VARIANT } }
+    attr { key: "index" value { i: 0 } }
+  }
+)proto";
+
+std::unique_ptr<PipelineBenchmark> MakeBenchmark() {
+  GraphDef graph_def;
+  CHECK(protobuf::TextFormat::ParseFromString(kGraphDef, &graph_def));
+  std::unique_ptr<PipelineBenchmark> benchmark;
+  TF_CHECK_OK(PipelineBenchmark::Create(graph_def, &benchmark));
+  return benchmark;
+}
+
+TEST(PipelineBenchmarkTest, Stages) {
+  std::unique_ptr<PipelineBenchmark> benchmark = MakeBenchmark();
+  EXPECT_EQ(std::vector<string>({"batch"}), benchmark->stages());
+}
+
+TEST(PipelineBenchmarkTest, RunsPipeline) {
+  std::unique_ptr<PipelineBenchmark> benchmark = MakeBenchmark();
+  PipelineBenchmarkResult result;
+  TF_ASSERT_OK(benchmark->Run(10, &result));
+  EXPECT_EQ("", result.stage);
+  EXPECT_EQ(10, result.num_elements);
+  EXPECT_EQ(10 * 4 * sizeof(int64), result.bytes);
+  EXPECT_GT(result.elements_per_second, 0);
+
+  ASSERT_EQ(2, result.nodes.size());
+  EXPECT_EQ(10, result.nodes[0].num_elements);
+  EXPECT_EQ(40, result.nodes[1].num_elements);
+  EXPECT_EQ(40 * sizeof(int64), result.nodes[1].bytes_produced);
+  EXPECT_GT(result.nodes[0].max_elements_per_second, 0);
+}
+
+TEST(PipelineBenchmarkTest, StopsAtEndOfSequence) {
+  std::unique_ptr<PipelineBenchmark> benchmark = MakeBenchmark();
+  PipelineBenchmarkResult result;
+  TF_ASSERT_OK(benchmark->Run(1000, &result));
+  EXPECT_EQ(25, result.num_elements);
+}
+
+TEST(PipelineBenchmarkTest, RunsStageOnCachedInput) {
+  std::unique_ptr<PipelineBenchmark> benchmark = MakeBenchmark();
+  PipelineBenchmarkResult result;
+  // The 8 cached elements are repeated to fill 100 batches.
+  TF_ASSERT_OK(benchmark->RunStage("batch", 100, 8, &result));
+  EXPECT_EQ("batch", result.stage);
+  EXPECT_EQ(100, result.num_elements);
+  ASSERT_EQ(2, result.nodes.size());
+  EXPECT_EQ(400, result.nodes[1].num_elements);
+  EXPECT_FALSE(result.DebugString().empty());
+}
+
+TEST(PipelineBenchmarkTest, UnknownStage) {
+  std::unique_ptr<PipelineBenchmark> benchmark = MakeBenchmark();
+  PipelineBenchmarkResult result;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      benchmark->RunStage("range", 10, 10, &result)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
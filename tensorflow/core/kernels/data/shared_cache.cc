@@ -0,0 +1,322 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/shared_cache.h"
+
+#include <unordered_map>
+
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+mutex* RegistryMutex() {
+  static mutex* mu = new mutex;
+  return mu;
+}
+
+std::unordered_map<string, SharedCache*>* Registry() {
+  static auto* registry = new std::unordered_map<string, SharedCache*>;
+  return registry;
+}
+
+// Spilled elements are stored as the number of components followed by the
+// length-prefixed TensorProto of each component.
+void EncodeElement(const std::vector<Tensor>& element, string* out) {
+  core::PutVarint64(out, element.size());
+  for (const Tensor& t : element) {
+    TensorProto proto;
+    t.AsProtoTensorContent(&proto);
+    const string bytes = proto.SerializeAsString();
+    core::PutVarint64(out, bytes.size());
+    out->append(bytes);
+  }
+}
+
+Status DecodeElement(StringPiece in, std::vector<Tensor>* element) {
+  uint64 num_components;
+  if (!core::GetVarint64(&in, &num_components)) {
+    return errors::DataLoss("Corrupt element in shared cache spill file.");
+  }
+  element->clear();
+  element->reserve(num_components);
+  for (uint64 i = 0; i < num_components; ++i) {
+    uint64 length;
+    if (!core::GetVarint64(&in, &length) || in.size() < length) {
+      return errors::DataLoss("Corrupt element in shared cache spill file.");
+    }
+    TensorProto proto;
+    element->emplace_back();
+    if (!proto.ParseFromArray(in.data(), length) ||
+        !element->back().FromProto(proto)) {
+      return errors::DataLoss("Corrupt tensor in shared cache spill file.");
+    }
+    in.remove_prefix(length);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+/* static */
+SharedCache* SharedCache::Acquire(const string& key, int64 memory_budget_bytes,
+                                  const string& spill_dir, Env* env) {
+  mutex_lock l(*RegistryMutex());
+  SharedCache*& cache = (*Registry())[key];
+  if (cache == nullptr) {
+    cache = new SharedCache(key, memory_budget_bytes, spill_dir, env);
+  } else {
+    cache->Ref();
+  }
+  return cache;
+}
+
+/* static */
+void SharedCache::Release(SharedCache* cache) {
+  // References are only taken and dropped under the registry mutex, so a
+  // cache with one reference left cannot be looked up concurrently.
+  mutex_lock l(*RegistryMutex());
+  if (cache->RefCountIsOne()) {
+    Registry()->erase(cache->key_);
+  }
+  cache->Unref();
+}
+
+SharedCache::SharedCache(const string& key, int64 memory_budget_bytes,
+                         const string& spill_dir, Env* env)
+    : key_(key),
+      memory_budget_bytes_(memory_budget_bytes),
+      spill_dir_(spill_dir),
+      env_(env) {}
+
+SharedCache::~SharedCache() {
+  spill_reader_.reset();
+  mutex_lock l(spill_mu_);
+  if (spill_writer_) {
+    spill_writer_->Close().IgnoreError();
+    spill_writer_.reset();
+    env_->DeleteFile(spill_filename_).IgnoreError();
+  }
+}
+
+string SharedCache::DebugString() const {
+  return strings::StrCat("SharedCache(", key_, ")");
+}
+
+Status SharedCache::Lookup(int64 index, const void* owner,
+                           std::vector<Tensor>* element, bool* end_of_sequence,
+                           bool* produce) {
+  *end_of_sequence = false;
+  *produce = false;
+  uint64 offset;
+  uint64 length;
+  {
+    mutex_lock l(mu_);
+    while (true) {
+      if (index < static_cast<int64>(entries_.size())) {
+        Entry& entry = entries_[index];
+        if (entry.in_memory) {
+          if (!entry.evicting) {
+            lru_.splice(lru_.begin(), lru_, entry.lru_pos);
+          }
+          *element = entry.element;
+          return Status::OK();
+        }
+        offset = entry.offset;
+        length = entry.length;
+        break;
+      }
+      if (completed_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      if (producer_ == nullptr || producer_ == owner) {
+        producer_ = owner;
+        *produce = true;
+        return Status::OK();
+      }
+      cond_var_.wait(l);
+    }
+  }
+  TF_RETURN_IF_ERROR(ReadSpilled(offset, length, element));
+  {
+    // Readmits the element, unless a concurrent reader already did.
+    mutex_lock l(mu_);
+    Entry& entry = entries_[index];
+    if (!entry.in_memory) {
+      entry.element = *element;
+      entry.in_memory = true;
+      entry.lru_pos = lru_.insert(lru_.begin(), index);
+      bytes_in_memory_ += entry.bytes;
+      --num_spilled_;
+    }
+  }
+  return MaybeSpill();
+}
+
+Status SharedCache::Append(const void* owner, std::vector<Tensor> element) {
+  {
+    mutex_lock l(mu_);
+    if (producer_ != owner) {
+      return errors::Internal("Only the producer may append to ",
+                              DebugString());
+    }
+    const int64 index = entries_.size();
+    entries_.emplace_back();
+    Entry& entry = entries_.back();
+    for (const Tensor& t : element) {
+      entry.bytes += t.TotalBytes();
+    }
+    entry.element = std::move(element);
+    entry.lru_pos = lru_.insert(lru_.begin(), index);
+    bytes_in_memory_ += entry.bytes;
+    cond_var_.notify_all();
+  }
+  return MaybeSpill();
+}
+
+void SharedCache::Complete(const void* owner) {
+  mutex_lock l(mu_);
+  if (producer_ == owner) {
+    completed_ = true;
+    producer_ = nullptr;
+    cond_var_.notify_all();
+  }
+}
+
+void SharedCache::Abandon(const void* owner) {
+  mutex_lock l(mu_);
+  if (producer_ == owner) {
+    producer_ = nullptr;
+    cond_var_.notify_all();
+  }
+}
+
+int64 SharedCache::size() {
+  mutex_lock l(mu_);
+  return entries_.size();
+}
+
+int64 SharedCache::bytes_in_memory() {
+  mutex_lock l(mu_);
+  return bytes_in_memory_;
+}
+
+int64 SharedCache::num_spilled() {
+  mutex_lock l(mu_);
+  return num_spilled_;
+}
+
+bool SharedCache::IsInMemory(int64 index) {
+  mutex_lock l(mu_);
+  return index < static_cast<int64>(entries_.size()) &&
+         entries_[index].in_memory;
+}
+
+Status SharedCache::MaybeSpill() {
+  if (memory_budget_bytes_ <= 0 || spill_dir_.empty()) {
+    return Status::OK();
+  }
+  mutex_lock spill_lock(spill_mu_);
+  std::vector<int64> victims;
+  std::vector<std::vector<Tensor>> elements;
+  {
+    mutex_lock l(mu_);
+    while (bytes_in_memory_ > memory_budget_bytes_ && !lru_.empty()) {
+      const int64 index = lru_.back();
+      Entry& entry = entries_[index];
+      lru_.pop_back();
+      entry.lru_pos = lru_.end();
+      bytes_in_memory_ -= entry.bytes;
+      if (entry.on_disk) {
+        entry.element.clear();
+        entry.in_memory = false;
+        ++num_spilled_;
+        continue;
+      }
+      entry.evicting = true;
+      victims.push_back(index);
+      elements.push_back(entry.element);
+    }
+  }
+  if (victims.empty()) {
+    return Status::OK();
+  }
+  std::vector<std::pair<uint64, uint64>> locations;
+  Status s = WriteSpilled(elements, &locations);
+  mutex_lock l(mu_);
+  for (size_t i = 0; i < victims.size(); ++i) {
+    Entry& entry = entries_[victims[i]];
+    entry.evicting = false;
+    if (!s.ok()) {
+      // Keeps the element in memory, as the least recently used one.
+      entry.lru_pos = lru_.insert(lru_.end(), victims[i]);
+      bytes_in_memory_ += entry.bytes;
+      continue;
+    }
+    entry.on_disk = true;
+    entry.offset = locations[i].first;
+    entry.length = locations[i].second;
+    entry.element.clear();
+    entry.in_memory = false;
+    ++num_spilled_;
+  }
+  return s;
+}
+
+Status SharedCache::WriteSpilled(
+    const std::vector<std::vector<Tensor>>& elements,
+    std::vector<std::pair<uint64, uint64>>* locations) {
+  if (!spill_writer_) {
+    TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(spill_dir_));
+    spill_filename_ = io::JoinPath(
+        spill_dir_, strings::StrCat("shared_cache_", random::New64(),
+                                    ".spill"));
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(spill_filename_, &spill_writer_));
+    TF_RETURN_IF_ERROR(
+        env_->NewRandomAccessFile(spill_filename_, &spill_reader_));
+  }
+  string record;
+  for (const std::vector<Tensor>& element : elements) {
+    record.clear();
+    EncodeElement(element, &record);
+    TF_RETURN_IF_ERROR(spill_writer_->Append(record));
+    locations->emplace_back(spill_size_, record.size());
+    spill_size_ += record.size();
+  }
+  // The entries are only marked as spilled once their bytes reach the file.
+  return spill_writer_->Flush();
+}
+
+Status SharedCache::ReadSpilled(uint64 offset, uint64 length,
+                                std::vector<Tensor>* element) {
+  string scratch(length, '\0');
+  StringPiece result;
+  TF_RETURN_IF_ERROR(
+      spill_reader_->Read(offset, length, &result, &scratch[0]));
+  if (result.size() != length) {
+    return errors::DataLoss("Short read from shared cache spill file of ",
+                            DebugString());
+  }
+  return DecodeElement(result, element);
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,162 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_SHARED_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_SHARED_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+
+// A process-wide cache of dataset elements, shared by every iterator that
+// reads the same (fingerprinted) input pipeline.
+//
+// Elements are produced in order by whichever iterator first asks for an
+// element that is not cached yet; that iterator becomes the producer and
+// other iterators that reach the end of the cached prefix wait for it. A
+// partially filled cache can therefore serve any number of concurrent
+// readers. If the producer goes away before the input is exhausted, the
+// next waiting reader takes over production.
+//
+// When `memory_budget_bytes` is positive and `spill_dir` is not empty, the
+// least recently used in-memory elements are written to a spill file in
+// `spill_dir` once the budget is exceeded. A spilled element that is read
+// again is readmitted to memory, evicting less recently used elements in
+// turn; elements that are already in the spill file are evicted without
+// being written again. Spill file I/O happens outside of the lock that
+// readers take. Without a spill directory the budget cannot be enforced and
+// all elements stay in memory.
+class SharedCache : public core::RefCounted {
+ public:
+  // Returns the cache registered under `key`, creating it with the given
+  // options if it does not exist. The caller owns a reference that must be
+  // given back with `Release()`.
+  static SharedCache* Acquire(const string& key, int64 memory_budget_bytes,
+                              const string& spill_dir, Env* env);
+
+  // Drops a reference obtained from `Acquire()`, removing the cache from the
+  // registry when it was the last one.
+  static void Release(SharedCache* cache);
+
+  // Looks up element `index`. If it is cached, copies it into `element`.
+  // If the input was exhausted before `index`, sets `end_of_sequence`.
+  // Otherwise, if no other producer is active, `owner` becomes the producer
+  // and `produce` is set: the caller must then call `Append()` with element
+  // `size()`, or `Complete()` or `Abandon()`. Blocks while element `index`
+  // is being produced by another owner.
+  Status Lookup(int64 index, const void* owner, std::vector<Tensor>* element,
+                bool* end_of_sequence, bool* produce);
+
+  // Adds the next element. Must only be called by the current producer.
+  Status Append(const void* owner, std::vector<Tensor> element);
+
+  // Marks the input as exhausted and releases the producer role.
+  void Complete(const void* owner);
+
+  // Releases the producer role, if `owner` holds it, without completing
+  // the cache.
+  void Abandon(const void* owner);
+
+  // Returns the number of cached elements.
+  int64 size();
+
+  // Returns the number of bytes of elements that are held in memory.
+  int64 bytes_in_memory();
+
+  // Returns the number of elements that are only held in the spill file.
+  int64 num_spilled();
+
+  // Returns whether element `index` is held in memory.
+  bool IsInMemory(int64 index);
+
+  string DebugString() const;
+
+ private:
+  struct Entry {
+    std::vector<Tensor> element;
+    int64 bytes = 0;
+    // Whether `element` is held in memory.
+    bool in_memory = true;
+    // Whether the entry has been taken off `lru_` to be written to the spill
+    // file. It is still in memory and served from there until then.
+    bool evicting = false;
+    // Whether the element has been written to the spill file at
+    // [offset, offset + length).
+    bool on_disk = false;
+    uint64 offset = 0;
+    uint64 length = 0;
+    // Position in `lru_` while the entry is in memory and not evicting.
+    std::list<int64>::iterator lru_pos;
+  };
+
+  SharedCache(const string& key, int64 memory_budget_bytes,
+              const string& spill_dir, Env* env);
+  ~SharedCache() override;
+
+  // Evicts least recently used elements until the budget is met, writing
+  // those that are not in the spill file yet. Spills are serialized by
+  // `spill_mu_`, and `mu_` is not held while the spill file is written.
+  Status MaybeSpill() LOCKS_EXCLUDED(mu_, spill_mu_);
+
+  // Appends `elements` to the spill file and returns the offset and length
+  // of each.
+  Status WriteSpilled(const std::vector<std::vector<Tensor>>& elements,
+                      std::vector<std::pair<uint64, uint64>>* locations)
+      EXCLUSIVE_LOCKS_REQUIRED(spill_mu_);
+
+  // Reads a spilled element back from the spill file.
+  Status ReadSpilled(uint64 offset, uint64 length,
+                     std::vector<Tensor>* element);
+
+  const string key_;
+  const int64 memory_budget_bytes_;
+  const string spill_dir_;
+  Env* const env_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  std::vector<Entry> entries_ GUARDED_BY(mu_);
+  // Indices of in-memory entries, most recently used first.
+  std::list<int64> lru_ GUARDED_BY(mu_);
+  int64 bytes_in_memory_ GUARDED_BY(mu_) = 0;
+  int64 num_spilled_ GUARDED_BY(mu_) = 0;
+  const void* producer_ GUARDED_BY(mu_) = nullptr;
+  bool completed_ GUARDED_BY(mu_) = false;
+
+  // Acquired before `mu_` when both are held.
+  mutex spill_mu_;
+  string spill_filename_ GUARDED_BY(spill_mu_);
+  std::unique_ptr<WritableFile> spill_writer_ GUARDED_BY(spill_mu_);
+  uint64 spill_size_ GUARDED_BY(spill_mu_) = 0;
+  // Created before any entry is marked `on_disk` and never reset before
+  // destruction, so it may be read without holding a lock.
+  std::unique_ptr<RandomAccessFile> spill_reader_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedCache);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_SHARED_CACHE_H_
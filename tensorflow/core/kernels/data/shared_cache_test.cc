@@ -0,0 +1,193 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/shared_cache.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::vector<Tensor> MakeElement(int64 value) {
+  return {test::AsTensor<int64>({value, value})};
+}
+
+// Appends `n` elements to `cache` on behalf of `owner`, then completes it.
+void Fill(SharedCache* cache, const void* owner, int64 n) {
+  for (int64 i = 0; i < n; ++i) {
+    std::vector<Tensor> element;
+    bool end_of_sequence;
+    bool produce;
+    TF_ASSERT_OK(cache->Lookup(i, owner, &element, &end_of_sequence, &produce));
+    ASSERT_TRUE(produce);
+    TF_ASSERT_OK(cache->Append(owner, MakeElement(i)));
+  }
+  cache->Complete(owner);
+}
+
+TEST(SharedCacheTest, SharedByKey) {
+  SharedCache* a = SharedCache::Acquire("SharedByKey", 0, "", Env::Default());
+  SharedCache* b = SharedCache::Acquire("SharedByKey", 0, "", Env::Default());
+  SharedCache* c = SharedCache::Acquire("Other", 0, "", Env::Default());
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  SharedCache::Release(a);
+  SharedCache::Release(b);
+  SharedCache::Release(c);
+}
+
+TEST(SharedCacheTest, ReadAfterComplete) {
+  SharedCache* cache =
+      SharedCache::Acquire("ReadAfterComplete", 0, "", Env::Default());
+  int writer;
+  int reader;
+  Fill(cache, &writer, 3);
+  for (int64 i = 0; i < 3; ++i) {
+    std::vector<Tensor> element;
+    bool end_of_sequence;
+    bool produce;
+    TF_ASSERT_OK(
+        cache->Lookup(i, &reader, &element, &end_of_sequence, &produce));
+    EXPECT_FALSE(end_of_sequence);
+    EXPECT_FALSE(produce);
+    test::ExpectTensorEqual<int64>(element[0], MakeElement(i)[0]);
+  }
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  bool produce;
+  TF_ASSERT_OK(cache->Lookup(3, &reader, &element, &end_of_sequence, &produce));
+  EXPECT_TRUE(end_of_sequence);
+  SharedCache::Release(cache);
+}
+
+TEST(SharedCacheTest, ReaderWaitsForProducer) {
+  SharedCache* cache =
+      SharedCache::Acquire("ReaderWaitsForProducer", 0, "", Env::Default());
+  int writer;
+  int reader;
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  bool produce;
+  TF_ASSERT_OK(cache->Lookup(0, &writer, &element, &end_of_sequence, &produce));
+  ASSERT_TRUE(produce);
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "reader", [cache, &reader]() {
+        std::vector<Tensor> element;
+        bool end_of_sequence;
+        bool produce;
+        TF_ASSERT_OK(
+            cache->Lookup(0, &reader, &element, &end_of_sequence, &produce));
+        EXPECT_FALSE(produce);
+        test::ExpectTensorEqual<int64>(element[0], MakeElement(0)[0]);
+      }));
+  Env::Default()->SleepForMicroseconds(10000);
+  TF_ASSERT_OK(cache->Append(&writer, MakeElement(0)));
+  thread.reset();
+  SharedCache::Release(cache);
+}
+
+TEST(SharedCacheTest, ReaderTakesOverAbandonedProduction) {
+  SharedCache* cache = SharedCache::Acquire(
+      "ReaderTakesOverAbandonedProduction", 0, "", Env::Default());
+  int writer;
+  int reader;
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  bool produce;
+  TF_ASSERT_OK(cache->Lookup(0, &writer, &element, &end_of_sequence, &produce));
+  ASSERT_TRUE(produce);
+  TF_ASSERT_OK(cache->Append(&writer, MakeElement(0)));
+  TF_ASSERT_OK(cache->Lookup(1, &writer, &element, &end_of_sequence, &produce));
+  ASSERT_TRUE(produce);
+  cache->Abandon(&writer);
+  TF_ASSERT_OK(cache->Lookup(1, &reader, &element, &end_of_sequence, &produce));
+  EXPECT_TRUE(produce);
+  EXPECT_FALSE(cache->Append(&writer, MakeElement(1)).ok());
+  TF_ASSERT_OK(cache->Append(&reader, MakeElement(1)));
+  EXPECT_EQ(2, cache->size());
+  SharedCache::Release(cache);
+}
+
+TEST(SharedCacheTest, SpillsOverBudget) {
+  const string spill_dir =
+      io::JoinPath(testing::TmpDir(), "shared_cache_spill");
+  const int64 element_bytes = MakeElement(0)[0].TotalBytes();
+  SharedCache* cache = SharedCache::Acquire(
+      "SpillsOverBudget", 4 * element_bytes, spill_dir, Env::Default());
+  int writer;
+  int reader;
+  Fill(cache, &writer, 10);
+  EXPECT_EQ(6, cache->num_spilled());
+  EXPECT_EQ(4 * element_bytes, cache->bytes_in_memory());
+  for (int64 i = 0; i < 10; ++i) {
+    std::vector<Tensor> element;
+    bool end_of_sequence;
+    bool produce;
+    TF_ASSERT_OK(
+        cache->Lookup(i, &reader, &element, &end_of_sequence, &produce));
+    ASSERT_FALSE(end_of_sequence);
+    test::ExpectTensorEqual<int64>(element[0], MakeElement(i)[0]);
+  }
+  SharedCache::Release(cache);
+}
+
+TEST(SharedCacheTest, ReadmitsSpilledElements) {
+  const string spill_dir =
+      io::JoinPath(testing::TmpDir(), "shared_cache_readmit");
+  const int64 element_bytes = MakeElement(0)[0].TotalBytes();
+  SharedCache* cache = SharedCache::Acquire(
+      "ReadmitsSpilledElements", 4 * element_bytes, spill_dir, Env::Default());
+  int writer;
+  int reader;
+  Fill(cache, &writer, 10);
+  EXPECT_FALSE(cache->IsInMemory(0));
+  EXPECT_TRUE(cache->IsInMemory(6));
+
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  bool produce;
+  TF_ASSERT_OK(cache->Lookup(0, &reader, &element, &end_of_sequence, &produce));
+  test::ExpectTensorEqual<int64>(element[0], MakeElement(0)[0]);
+  // Element 0 is now the most recently used one, and the least recently used
+  // element 6 makes room for it.
+  EXPECT_TRUE(cache->IsInMemory(0));
+  EXPECT_FALSE(cache->IsInMemory(6));
+  EXPECT_EQ(6, cache->num_spilled());
+  EXPECT_EQ(4 * element_bytes, cache->bytes_in_memory());
+
+  // Element 6 was not in the spill file yet, so it was written when evicted.
+  TF_ASSERT_OK(cache->Lookup(6, &reader, &element, &end_of_sequence, &produce));
+  test::ExpectTensorEqual<int64>(element[0], MakeElement(6)[0]);
+  SharedCache::Release(cache);
+}
+
+TEST(SharedCacheTest, UnboundedWithoutSpillDir) {
+  const int64 element_bytes = MakeElement(0)[0].TotalBytes();
+  SharedCache* cache = SharedCache::Acquire("UnboundedWithoutSpillDir",
+                                            element_bytes, "", Env::Default());
+  int writer;
+  Fill(cache, &writer, 10);
+  EXPECT_EQ(0, cache->num_spilled());
+  EXPECT_EQ(10 * element_bytes, cache->bytes_in_memory());
+  SharedCache::Release(cache);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
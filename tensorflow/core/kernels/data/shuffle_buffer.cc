@@ -0,0 +1,250 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/shuffle_buffer.h"
+
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Spilled elements are stored as the number of components followed by, for
+// each component, its dtype, rank and dimensions, and then either the raw
+// tensor bytes, or, for strings, the length-prefixed bytes of each string.
+// Unlike TensorProto this keeps the record as compact as the tensor itself
+// and lets decoding copy the bytes straight into the new tensor.
+Status EncodeElement(const std::vector<Tensor>& element, string* out) {
+  core::PutVarint64(out, element.size());
+  for (const Tensor& t : element) {
+    if (t.dtype() != DT_STRING && !DataTypeCanUseMemcpy(t.dtype())) {
+      return errors::Unimplemented("Cannot spill shuffle buffer element of ",
+                                   "type ", DataTypeString(t.dtype()));
+    }
+    core::PutVarint32(out, t.dtype());
+    core::PutVarint32(out, t.dims());
+    for (int i = 0; i < t.dims(); ++i) {
+      core::PutVarint64(out, t.dim_size(i));
+    }
+    if (t.dtype() == DT_STRING) {
+      const auto strings = t.flat<string>();
+      for (int64 i = 0; i < strings.size(); ++i) {
+        core::PutVarint64(out, strings(i).size());
+        out->append(strings(i));
+      }
+    } else {
+      const StringPiece data = t.tensor_data();
+      out->append(data.data(), data.size());
+    }
+  }
+  return Status::OK();
+}
+
+Status Corrupt() {
+  return errors::DataLoss("Corrupt element in shuffle buffer spill file.");
+}
+
+Status DecodeElement(StringPiece in, std::vector<Tensor>* element) {
+  uint64 num_components;
+  if (!core::GetVarint64(&in, &num_components)) {
+    return Corrupt();
+  }
+  element->clear();
+  element->reserve(num_components);
+  for (uint64 i = 0; i < num_components; ++i) {
+    uint32 dtype;
+    uint32 rank;
+    if (!core::GetVarint32(&in, &dtype) || !core::GetVarint32(&in, &rank)) {
+      return Corrupt();
+    }
+    TensorShape shape;
+    for (uint32 j = 0; j < rank; ++j) {
+      uint64 dim;
+      if (!core::GetVarint64(&in, &dim)) {
+        return Corrupt();
+      }
+      shape.AddDim(dim);
+    }
+    element->emplace_back(static_cast<DataType>(dtype), shape);
+    Tensor& t = element->back();
+    if (t.dtype() == DT_STRING) {
+      auto strings = t.flat<string>();
+      for (int64 j = 0; j < strings.size(); ++j) {
+        uint64 length;
+        if (!core::GetVarint64(&in, &length) || in.size() < length) {
+          return Corrupt();
+        }
+        strings(j).assign(in.data(), length);
+        in.remove_prefix(length);
+      }
+    } else {
+      const StringPiece data = t.tensor_data();
+      if (in.size() < data.size()) {
+        return Corrupt();
+      }
+      std::memcpy(const_cast<char*>(data.data()), in.data(), data.size());
+      in.remove_prefix(data.size());
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+/* static */ constexpr int64 ShuffleBuffer::kRecordsPerSegment;
+
+ShuffleBuffer::ShuffleBuffer(int64 capacity, const string& spill_dir, Env* env)
+    : capacity_(capacity),
+      spill_dir_(spill_dir),
+      env_(env),
+      slots_(absl::make_unique<Slot[]>(capacity)) {}
+
+ShuffleBuffer::~ShuffleBuffer() { Clear(); }
+
+Status ShuffleBuffer::Put(int64 index, std::vector<Tensor> element) {
+  Slot& slot = slots_[index];
+  if (spill_dir_.empty()) {
+    slot.element = std::move(element);
+    return Status::OK();
+  }
+  string record;
+  TF_RETURN_IF_ERROR(EncodeElement(element, &record));
+  return Append(record, &slot);
+}
+
+Status ShuffleBuffer::Take(int64 index, std::vector<Tensor>* element) {
+  Slot& slot = slots_[index];
+  if (slot.segment < 0) {
+    *element = std::move(slot.element);
+    slot.element.clear();
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(ReadSpilled(slot, element));
+  ReleaseSegment(&slot);
+  return Status::OK();
+}
+
+Status ShuffleBuffer::Get(int64 index, std::vector<Tensor>* element) {
+  const Slot& slot = slots_[index];
+  if (slot.segment < 0) {
+    *element = slot.element;
+    return Status::OK();
+  }
+  return ReadSpilled(slot, element);
+}
+
+void ShuffleBuffer::Swap(int64 i, int64 j) {
+  std::swap(slots_[i], slots_[j]);
+}
+
+void ShuffleBuffer::Clear() {
+  for (int64 i = 0; i < capacity_; ++i) {
+    slots_[i] = Slot();
+  }
+  while (!segments_.empty()) {
+    DeleteSegment(segments_.begin()->first);
+  }
+  active_segment_ = -1;
+}
+
+Status ShuffleBuffer::Append(const string& record, Slot* slot) {
+  if (active_segment_ >= 0 &&
+      segments_[active_segment_].num_records >= kRecordsPerSegment) {
+    Segment& sealed = segments_[active_segment_];
+    TF_RETURN_IF_ERROR(sealed.writer->Close());
+    sealed.writer.reset();
+    sealed.needs_flush = false;
+    if (sealed.num_live_records == 0) {
+      DeleteSegment(active_segment_);
+    }
+    active_segment_ = -1;
+  }
+  if (active_segment_ < 0) {
+    TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(spill_dir_));
+    Segment segment;
+    segment.filename = io::JoinPath(
+        spill_dir_, strings::StrCat("shuffle_buffer_", random::New64(), "_",
+                                    next_segment_id_, ".spill"));
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(segment.filename,
+                                             &segment.writer));
+    TF_RETURN_IF_ERROR(
+        env_->NewRandomAccessFile(segment.filename, &segment.reader));
+    active_segment_ = next_segment_id_++;
+    segments_[active_segment_] = std::move(segment);
+  }
+  Segment& segment = segments_[active_segment_];
+  TF_RETURN_IF_ERROR(segment.writer->Append(record));
+  slot->element.clear();
+  slot->segment = active_segment_;
+  slot->offset = segment.size;
+  slot->length = record.size();
+  segment.size += record.size();
+  ++segment.num_records;
+  ++segment.num_live_records;
+  segment.needs_flush = true;
+  return Status::OK();
+}
+
+Status ShuffleBuffer::ReadSpilled(const Slot& slot,
+                                  std::vector<Tensor>* element) {
+  Segment& segment = segments_[slot.segment];
+  if (segment.needs_flush) {
+    TF_RETURN_IF_ERROR(segment.writer->Flush());
+    segment.needs_flush = false;
+  }
+  string scratch(slot.length, '\0');
+  StringPiece result;
+  TF_RETURN_IF_ERROR(
+      segment.reader->Read(slot.offset, slot.length, &result, &scratch[0]));
+  if (result.size() != slot.length) {
+    return errors::DataLoss("Short read from shuffle buffer spill file ",
+                            segment.filename);
+  }
+  return DecodeElement(result, element);
+}
+
+void ShuffleBuffer::ReleaseSegment(Slot* slot) {
+  const int64 id = slot->segment;
+  *slot = Slot();
+  Segment& segment = segments_[id];
+  if (--segment.num_live_records == 0 && id != active_segment_) {
+    DeleteSegment(id);
+  }
+}
+
+void ShuffleBuffer::DeleteSegment(int64 id) {
+  auto it = segments_.find(id);
+  if (it == segments_.end()) {
+    return;
+  }
+  it->second.reader.reset();
+  if (it->second.writer) {
+    it->second.writer->Close().IgnoreError();
+    it->second.writer.reset();
+  }
+  env_->DeleteFile(it->second.filename).IgnoreError();
+  segments_.erase(it);
+}
+
+}  // namespace data
+}  // namespace tensorflow
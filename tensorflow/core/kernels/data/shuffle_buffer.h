@@ -0,0 +1,115 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_SHUFFLE_BUFFER_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_SHUFFLE_BUFFER_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace data {
+
+// The slots that hold the buffered elements of a shuffle iterator.
+//
+// By default the elements are kept in memory. When `spill_dir` is not empty,
+// every element is written to a spill file in `spill_dir` as soon as it is
+// put into a slot, and only its location in the file stays in memory; the
+// element is read back when it is taken out. The shuffling itself only moves
+// slot contents around, so it produces the same order in both modes.
+//
+// Spill files are append-only segments of `kRecordsPerSegment` elements,
+// deleted once all of their elements have been taken, so disk usage is a
+// small multiple of the buffered bytes. Only tensors whose type can be
+// copied with memcpy, and strings, can be spilled.
+//
+// Not thread-safe.
+class ShuffleBuffer {
+ public:
+  static constexpr int64 kRecordsPerSegment = 256;
+
+  ShuffleBuffer(int64 capacity, const string& spill_dir, Env* env);
+  ~ShuffleBuffer();
+
+  int64 capacity() const { return capacity_; }
+
+  // Stores `element` in the empty slot `index`.
+  Status Put(int64 index, std::vector<Tensor> element);
+
+  // Moves the element of slot `index` into `element`, leaving the slot
+  // empty.
+  Status Take(int64 index, std::vector<Tensor>* element);
+
+  // Copies the element of slot `index` into `element`.
+  Status Get(int64 index, std::vector<Tensor>* element);
+
+  // Exchanges the contents of slots `i` and `j`.
+  void Swap(int64 i, int64 j);
+
+  // Empties all slots and deletes the spill files.
+  void Clear();
+
+  // Returns the number of spill files currently on disk.
+  int64 num_segments() const { return segments_.size(); }
+
+ private:
+  struct Slot {
+    std::vector<Tensor> element;
+    // The spill segment holding the element, or -1 if the element is in
+    // memory or the slot is empty.
+    int64 segment = -1;
+    uint64 offset = 0;
+    uint64 length = 0;
+  };
+
+  struct Segment {
+    string filename;
+    // Only set for the segment that is being appended to.
+    std::unique_ptr<WritableFile> writer;
+    std::unique_ptr<RandomAccessFile> reader;
+    uint64 size = 0;
+    int64 num_records = 0;
+    int64 num_live_records = 0;
+    // Whether appended records may not have reached the file yet.
+    bool needs_flush = false;
+  };
+
+  Status Append(const string& record, Slot* slot);
+  Status ReadSpilled(const Slot& slot, std::vector<Tensor>* element);
+  // Drops the reference of `slot` to its segment, deleting the segment file
+  // when no slot refers to it and it is no longer appended to.
+  void ReleaseSegment(Slot* slot);
+  void DeleteSegment(int64 id);
+
+  const int64 capacity_;
+  const string spill_dir_;
+  Env* const env_;
+  std::unique_ptr<Slot[]> slots_;
+  std::map<int64, Segment> segments_;
+  int64 active_segment_ = -1;
+  int64 next_segment_id_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShuffleBuffer);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_SHUFFLE_BUFFER_H_
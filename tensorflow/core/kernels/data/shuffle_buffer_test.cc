@@ -0,0 +1,94 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/shuffle_buffer.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::vector<Tensor> MakeElement(int64 value) {
+  return {test::AsTensor<int64>({value, value + 1}, {2}),
+          test::AsTensor<string>({strings::StrCat("v", value), ""}, {1, 2})};
+}
+
+void ExpectElement(int64 value, const std::vector<Tensor>& element) {
+  std::vector<Tensor> expected = MakeElement(value);
+  ASSERT_EQ(expected.size(), element.size());
+  test::ExpectTensorEqual<int64>(expected[0], element[0]);
+  test::ExpectTensorEqual<string>(expected[1], element[1]);
+}
+
+string SpillDir() {
+  return io::JoinPath(testing::TmpDir(), "shuffle_buffer_test");
+}
+
+// Parameterized by whether the buffer spills its elements.
+class ShuffleBufferTest : public ::testing::TestWithParam<bool> {};
+
+TEST_P(ShuffleBufferTest, PutTakeSwap) {
+  ShuffleBuffer buffer(3, GetParam() ? SpillDir() : "", Env::Default());
+  for (int64 i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(buffer.Put(i, MakeElement(i)));
+  }
+  buffer.Swap(0, 2);
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(buffer.Take(0, &element));
+  ExpectElement(2, element);
+  TF_ASSERT_OK(buffer.Put(0, MakeElement(3)));
+  TF_ASSERT_OK(buffer.Get(0, &element));
+  ExpectElement(3, element);
+  // `Get()` leaves the element in place.
+  TF_ASSERT_OK(buffer.Take(0, &element));
+  ExpectElement(3, element);
+  TF_ASSERT_OK(buffer.Take(1, &element));
+  ExpectElement(1, element);
+  TF_ASSERT_OK(buffer.Take(2, &element));
+  ExpectElement(0, element);
+}
+
+TEST(ShuffleBufferSpillTest, SegmentsAreDeletedWhenDrained) {
+  const int64 n = 2 * ShuffleBuffer::kRecordsPerSegment + 1;
+  ShuffleBuffer buffer(n, SpillDir(), Env::Default());
+  for (int64 i = 0; i < n; ++i) {
+    TF_ASSERT_OK(buffer.Put(i, MakeElement(i)));
+  }
+  EXPECT_EQ(3, buffer.num_segments());
+  std::vector<Tensor> element;
+  for (int64 i = 0; i < ShuffleBuffer::kRecordsPerSegment; ++i) {
+    TF_ASSERT_OK(buffer.Take(i, &element));
+    ExpectElement(i, element);
+  }
+  EXPECT_EQ(2, buffer.num_segments());
+  buffer.Clear();
+  EXPECT_EQ(0, buffer.num_segments());
+}
+
+TEST(ShuffleBufferSpillTest, UnsupportedType) {
+  ShuffleBuffer buffer(1, SpillDir(), Env::Default());
+  Tensor variant(DT_VARIANT, TensorShape({}));
+  EXPECT_TRUE(errors::IsUnimplemented(buffer.Put(0, {variant})));
+}
+
+INSTANTIATE_TEST_SUITE_P(Spill, ShuffleBufferTest, ::testing::Bool());
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
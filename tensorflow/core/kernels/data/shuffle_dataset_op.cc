@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/kernels/data/shuffle_buffer.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -42,6 +43,7 @@ namespace data {
 /* static */ constexpr const char* const ShuffleDatasetOp::kDatasetType;
 /* static */ constexpr const char* const
     ShuffleDatasetOp::kReshuffleEachIteration;
+/* static */ constexpr const char* const ShuffleDatasetOp::kSpillDir;
 
 /* static */ constexpr const char* const
     ShuffleAndRepeatDatasetOp::kDatasetType;
@@ -72,11 +74,12 @@ ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
 class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
  public:
   ShuffleDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
-                     int64 buffer_size, int64 count)
+                     int64 buffer_size, int64 count, const string& spill_dir)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
-        count_(count) {
+        count_(count),
+        spill_dir_(spill_dir) {
     input_->Ref();
   }
 
@@ -114,8 +117,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           num_elements_(0),
           parent_generator_(seed, seed2),
           generator_(&parent_generator_) {
-      buffer_ = absl::make_unique<std::vector<Tensor>[]>(
-          params.dataset->buffer_size_);
+      buffer_ = absl::make_unique<ShuffleBuffer>(params.dataset->buffer_size_,
+                                                 params.dataset->spill_dir_,
+                                                 Env::Default());
       slices_.push_back(absl::make_unique<Slice>(0, 0));
     }
 
@@ -168,8 +172,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                     << this->dataset()->buffer_size_;
           }
           this->RecordBufferEnqueue(ctx, input_element);
-          buffer_[slices_.back()->end % this->dataset()->buffer_size_] =
-              std::move(input_element);
+          TF_RETURN_IF_ERROR(buffer_->Put(
+              slices_.back()->end % this->dataset()->buffer_size_,
+              std::move(input_element)));
           num_elements_++;
           slices_.back()->end++;
         } else {
@@ -202,11 +207,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             Random() % (slices_.front()->end - slices_.front()->start);
         int64 index =
             (slices_.front()->start + offset) % this->dataset()->buffer_size_;
-        *out_tensors = std::move(buffer_[index]);
+        TF_RETURN_IF_ERROR(buffer_->Take(index, out_tensors));
         this->RecordBufferDequeue(ctx, *out_tensors);
-        std::swap(
-            buffer_[index],
-            buffer_[slices_.front()->start % this->dataset()->buffer_size_]);
+        buffer_->Swap(
+            index, slices_.front()->start % this->dataset()->buffer_size_);
         slices_.front()->start++;
         num_elements_--;
       } else {
@@ -264,15 +268,17 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             slices_[i]->end));
         for (size_t j = slices_[i]->start; j < slices_[i]->end; ++j) {
           size_t index = j % this->dataset()->buffer_size_;
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(buffer_->Get(index, &element));
           TF_RETURN_IF_ERROR(writer->WriteScalar(
               this->full_name(
                   absl::StrJoin(std::make_tuple(kBuffer, index, kSize), "_")),
-              buffer_[index].size()));
-          for (size_t k = 0; k < buffer_[index].size(); ++k) {
+              element.size()));
+          for (size_t k = 0; k < element.size(); ++k) {
             TF_RETURN_IF_ERROR(writer->WriteTensor(
                 this->full_name(
                     absl::StrJoin(std::make_tuple(kBuffer, index, k), "_")),
-                buffer_[index][k]));
+                element[k]));
           }
         }
       }
@@ -310,8 +316,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             reader->ReadScalar(this->full_name(kSlicesSize), &temp));
         slices_size = static_cast<size_t>(temp);
       }
-      buffer_ = absl::make_unique<std::vector<Tensor>[]>(
-          this->dataset()->buffer_size_);
+      buffer_->Clear();
       for (size_t i = 0; i < slices_size; ++i) {
         int64 start;
         TF_RETURN_IF_ERROR(
@@ -330,13 +335,14 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
               this->full_name(
                   absl::StrJoin(std::make_tuple(kBuffer, index, kSize), "_")),
               &list_size));
-          buffer_[index] = std::vector<Tensor>(list_size);
+          std::vector<Tensor> element(list_size);
           for (int k = 0; k < list_size; ++k) {
             TF_RETURN_IF_ERROR(reader->ReadTensor(
                 this->full_name(
                     absl::StrJoin(std::make_tuple(kBuffer, index, k), "_")),
-                &buffer_[index][k]));
+                &element[k]));
           }
+          TF_RETURN_IF_ERROR(buffer_->Put(index, std::move(element)));
         }
       }
 
@@ -367,7 +373,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return out;
     }
 
-    std::unique_ptr<std::vector<Tensor>[]> buffer_ GUARDED_BY(mu_);
+    std::unique_ptr<ShuffleBuffer> buffer_ GUARDED_BY(mu_);
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
     int64 epoch_ GUARDED_BY(mu_);
     int64 num_elements_ GUARDED_BY(mu_);
@@ -381,12 +387,18 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   const DatasetBase* const input_;
   const int64 buffer_size_;
   const int64 count_;
+  // If not empty, buffered elements are spilled to files in this directory
+  // and only their locations are kept in memory.
+  const string spill_dir_;
 };
 
 ShuffleDatasetOp::ShuffleDatasetOp(OpKernelConstruction* ctx)
     : ShuffleDatasetOpBase(ctx) {
   OP_REQUIRES_OK(
       ctx, ctx->GetAttr(kReshuffleEachIteration, &reshuffle_each_iteration_));
+  if (ctx->HasAttr(kSpillDir)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kSpillDir, &spill_dir_));
+  }
 }
 
 // A dataset that uses a pseudorandom sequence of seeds for the iterators
@@ -394,8 +406,9 @@ ShuffleDatasetOp::ShuffleDatasetOp(OpKernelConstruction* ctx)
 class ShuffleDatasetOp::ReshufflingDataset : public ShuffleDatasetBase {
  public:
   ReshufflingDataset(OpKernelContext* ctx, const DatasetBase* input,
-                     int64 buffer_size, int64 seed, int64 seed2, int64 count)
-      : ShuffleDatasetBase(ctx, input, buffer_size, count),
+                     int64 buffer_size, int64 seed, int64 seed2, int64 count,
+                     const string& spill_dir)
+      : ShuffleDatasetBase(ctx, input, buffer_size, count, spill_dir),
         seed_(seed),
         seed2_(seed2) {}
 
@@ -555,15 +568,17 @@ class ShuffleDatasetOp::ReshufflingDataset : public ShuffleDatasetBase {
     Node* seed = nullptr;
     Node* seed2 = nullptr;
     AttrValue reshuffle_each_iteration;
+    AttrValue spill_dir;
 
     TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
     TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
     TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
     b->BuildAttrValue(true, &reshuffle_each_iteration);
+    b->BuildAttrValue(spill_dir_, &spill_dir);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {input_graph_node, buffer_size, seed, seed2},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        {std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration),
+         std::make_pair(kSpillDir, spill_dir)},  // Attrs
         output));
     return Status::OK();
   }
@@ -578,8 +593,9 @@ class ShuffleDatasetOp::ReshufflingDataset : public ShuffleDatasetBase {
 class ShuffleDatasetOp::FixedSeedDataset : public ShuffleDatasetBase {
  public:
   FixedSeedDataset(OpKernelContext* ctx, const DatasetBase* input,
-                   int64 buffer_size, int64 seed, int64 seed2, int64 count)
-      : ShuffleDatasetBase(ctx, input, buffer_size, count),
+                   int64 buffer_size, int64 seed, int64 seed2, int64 count,
+                   const string& spill_dir)
+      : ShuffleDatasetBase(ctx, input, buffer_size, count, spill_dir),
         seed_(seed),
         seed2_(seed2) {}
 
@@ -608,15 +624,17 @@ class ShuffleDatasetOp::FixedSeedDataset : public ShuffleDatasetBase {
     Node* seed = nullptr;
     Node* seed2 = nullptr;
     AttrValue reshuffle_each_iteration;
+    AttrValue spill_dir;
 
     TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
     TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
     TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
     b->BuildAttrValue(false, &reshuffle_each_iteration);
+    b->BuildAttrValue(spill_dir_, &spill_dir);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {input_graph_node, buffer_size, seed, seed2},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        {std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration),
+         std::make_pair(kSpillDir, spill_dir)},  // Attrs
         output));
     return Status::OK();
   }
@@ -650,10 +668,11 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
 
   int64 count = 1;
   if (reshuffle_each_iteration_) {
-    *output =
-        new ReshufflingDataset(ctx, input, buffer_size, seed, seed2, count);
+    *output = new ReshufflingDataset(ctx, input, buffer_size, seed, seed2,
+                                     count, spill_dir_);
   } else {
-    *output = new FixedSeedDataset(ctx, input, buffer_size, seed, seed2, count);
+    *output = new FixedSeedDataset(ctx, input, buffer_size, seed, seed2, count,
+                                   spill_dir_);
   }
 }
 
@@ -661,7 +680,7 @@ class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
           int64 seed, int64 seed2, int64 count)
-      : ShuffleDatasetBase(ctx, input, buffer_size, count),
+      : ShuffleDatasetBase(ctx, input, buffer_size, count, /*spill_dir=*/""),
         seed_(seed),
         seed2_(seed2) {}
 
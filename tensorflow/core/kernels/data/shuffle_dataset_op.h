@@ -40,6 +40,7 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
   static constexpr const char* const kDatasetType = "Shuffle";
   static constexpr const char* const kReshuffleEachIteration =
       "reshuffle_each_iteration";
+  static constexpr const char* const kSpillDir = "spill_dir";
 
   explicit ShuffleDatasetOp(OpKernelConstruction* ctx);
 
@@ -51,6 +52,7 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
   class ReshufflingDataset;
   class FixedSeedDataset;
   bool reshuffle_each_iteration_;
+  string spill_dir_;
 };
 
 class ShuffleAndRepeatDatasetOp : public ShuffleDatasetOpBase {
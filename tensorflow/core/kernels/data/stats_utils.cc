@@ -32,6 +32,9 @@ ABSL_CONST_INIT const char kDroppedElements[] = "dropped_elements";
 ABSL_CONST_INIT const char kFeaturesCount[] = "features_count";
 ABSL_CONST_INIT const char kFeatureValuesCount[] = "feature_values_count";
 ABSL_CONST_INIT const char kExamplesCount[] = "examples_count";
+ABSL_CONST_INIT const char kCpuTime[] = "cpu_time";
+ABSL_CONST_INIT const char kBytesProduced[] = "bytes_produced";
+ABSL_CONST_INIT const char kPeakBufferedBytes[] = "peak_buffered_bytes";
 
 string ExecutionTimeHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kExecutionTime);
@@ -69,6 +72,18 @@ string FeatureValueHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kFeatureValuesCount);
 }
 
+string CpuTimeScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kCpuTime);
+}
+
+string BytesProducedScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kBytesProduced);
+}
+
+string PeakBufferedBytesScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kPeakBufferedBytes);
+}
+
 }  // namespace stats_utils
 }  // namespace data
 }  // namespace tensorflow
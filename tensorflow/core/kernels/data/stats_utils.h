@@ -31,6 +31,9 @@ extern const char kDroppedElements[];
 extern const char kFeaturesCount[];
 extern const char kFeatureValuesCount[];
 extern const char kExamplesCount[];
+extern const char kCpuTime[];
+extern const char kBytesProduced[];
+extern const char kPeakBufferedBytes[];
 
 // Name for tf.data function execution time (in ns) histogram metrics.
 string ExecutionTimeHistogramName(const string& prefix);
@@ -61,6 +64,17 @@ string FeatureHistogramName(const string& prefix);
 // Name for feature-values count histogram metrics.
 string FeatureValueHistogramName(const string& prefix);
 
+// Name for the aggregate thread CPU time (in ns) scalar metrics of a node.
+string CpuTimeScalarName(const string& prefix);
+
+// Name for the scalar metrics of the total bytes of elements produced by a
+// node.
+string BytesProducedScalarName(const string& prefix);
+
+// Name for the scalar metrics of the largest number of bytes buffered by a
+// node.
+string PeakBufferedBytesScalarName(const string& prefix);
+
 }  // namespace stats_utils
 }  // namespace data
 }  // namespace tensorflow
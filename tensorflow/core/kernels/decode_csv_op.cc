@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <deque>
 #include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -21,6 +22,8 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -81,120 +84,33 @@ class DecodeCSVOp : public OpKernel {
       OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
     }
 
-    for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int32: ", fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int64: ", fields[f]));
-              output[f]->flat<int64>()(i) = value;
-            }
-            break;
+    mutex mu;
+    // The error of the first record that failed to parse, if any.
+    int64 error_record = records_size;
+    Status error;
+    auto parse_records = [&](int64 start, int64 limit) {
+      // Reused across records, so that parsing a record does not allocate.
+      std::vector<StringPiece> fields;
+      std::deque<string> unescaped_fields;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = ParseRecord(i, records_t(i), record_defaults, &output,
+                               &fields, &unescaped_fields);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < error_record) {
+            error_record = i;
+            error = s;
           }
-          case DT_FLOAT: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid float: ", fields[f]));
-              output[f]->flat<float>()(i) = value;
-            }
-            break;
-          }
-          case DT_DOUBLE: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<double>()(i) =
-                  record_defaults[f].flat<double>()(0);
-            } else {
-              double value;
-              OP_REQUIRES(ctx, strings::safe_strtod(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid double: ", fields[f]));
-              output[f]->flat<double>()(i) = value;
-            }
-            break;
-          }
-          case DT_STRING: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
-            }
-            break;
-          }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          return;
         }
       }
-    }
+    };
+    // Parsing a field takes a few hundred cycles.
+    const int64 cost_per_record = 200 * out_type_.size();
+    auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, records_size,
+          cost_per_record, parse_records);
+    OP_REQUIRES_OK(ctx, error);
   }
 
  private:
@@ -205,8 +121,95 @@ class DecodeCSVOp : public OpKernel {
   bool select_all_cols_;
   string na_value_;
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
+  // Parses record `i` into the outputs. `fields` and `unescaped_fields` are
+  // scratch space.
+  Status ParseRecord(int64 i, StringPiece record,
+                     const OpInputList& record_defaults, OpOutputList* output,
+                     std::vector<StringPiece>* fields,
+                     std::deque<string>* unescaped_fields) {
+    fields->clear();
+    unescaped_fields->clear();
+    TF_RETURN_IF_ERROR(ExtractFields(record, fields, unescaped_fields));
+    if (fields->size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
+
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const StringPiece field = (*fields)[f];
+      Tensor* out = (*output)[f];
+      // If this field is empty or NA value, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      if (field.empty() || field == na_value_) {
+        if (record_defaults[f].NumElements() != 1) {
+          return errors::InvalidArgument(
+              "Field ", f, " is required but missing in record ", i, "!");
+        }
+        switch (out_type_[f]) {
+          case DT_INT32:
+            out->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
+            break;
+          case DT_INT64:
+            out->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
+            break;
+          case DT_FLOAT:
+            out->flat<float>()(i) = record_defaults[f].flat<float>()(0);
+            break;
+          case DT_DOUBLE:
+            out->flat<double>()(i) = record_defaults[f].flat<double>()(0);
+            break;
+          case DT_STRING:
+            out->flat<string>()(i) = record_defaults[f].flat<string>()(0);
+            break;
+          default:
+            return errors::InvalidArgument("csv: data type ", out_type_[f],
+                                           " not supported in field ", f);
+        }
+        continue;
+      }
+      switch (out_type_[f]) {
+        case DT_INT32:
+          if (!strings::safe_strto32(field, &out->flat<int32>()(i))) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int32: ", field);
+          }
+          break;
+        case DT_INT64:
+          if (!strings::safe_strto64(field, &out->flat<int64>()(i))) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int64: ", field);
+          }
+          break;
+        case DT_FLOAT:
+          if (!strings::safe_strtof(field, &out->flat<float>()(i))) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid float: ", field);
+          }
+          break;
+        case DT_DOUBLE:
+          if (!strings::safe_strtod(field, &out->flat<double>()(i))) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid double: ", field);
+          }
+          break;
+        case DT_STRING:
+          out->flat<string>()(i).assign(field.data(), field.size());
+          break;
+        default:
+          return errors::InvalidArgument("csv: data type ", out_type_[f],
+                                         " not supported in field ", f);
+      }
+    }
+    return Status::OK();
+  }
+
+  // Appends the selected fields of `input` to `result`. Fields point into
+  // `input`, except for quoted fields with escaped quotes, which point into
+  // their unescaped copies in `unescaped_fields`.
+  Status ExtractFields(StringPiece input, std::vector<StringPiece>* result,
+                       std::deque<string>* unescaped_fields) {
     int64 current_idx = 0;
     int64 num_fields_parsed = 0;
     int64 selector_idx = 0;  // Keep track of index into select_cols
@@ -229,49 +232,63 @@ class DecodeCSVOp : public OpKernel {
         }
 
         // This is the body of the field;
-        string field;
+        StringPiece field;
+        const int64 field_start = current_idx;
         if (!quoted) {
           while (static_cast<size_t>(current_idx) < input.size() &&
                  input[current_idx] != delim_) {
-            OP_REQUIRES(ctx,
-                        (!use_quote_delim_ || input[current_idx] != '"') &&
-                            input[current_idx] != '\n' &&
-                            input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            if (include) field += input[current_idx];
+            if ((use_quote_delim_ && input[current_idx] == '"') ||
+                input[current_idx] == '\n' || input[current_idx] == '\r') {
+              return errors::InvalidArgument(
+                  "Unquoted fields cannot have quotes/CRLFs inside");
+            }
             current_idx++;
           }
+          field = input.substr(field_start, current_idx - field_start);
 
           // Go to next field or the end
           current_idx++;
         } else if (use_quote_delim_) {
+          // Set once the field has an escaped quote.
+          string* unescaped = nullptr;
           // Quoted field needs to be ended with '"' and delim or end
           while (
               (static_cast<size_t>(current_idx) < input.size() - 1) &&
               (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
             if (input[current_idx] != '"') {
-              if (include) field += input[current_idx];
+              if (unescaped != nullptr) {
+                unescaped->push_back(input[current_idx]);
+              }
               current_idx++;
             } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              if (include) field += '"';
+              if (input[current_idx + 1] != '"') {
+                return errors::InvalidArgument(
+                    "Quote inside a string has to be escaped by another "
+                    "quote");
+              }
+              if (include) {
+                if (unescaped == nullptr) {
+                  unescaped_fields->emplace_back(input.data() + field_start,
+                                                 current_idx - field_start);
+                  unescaped = &unescaped_fields->back();
+                }
+                unescaped->push_back('"');
+              }
               current_idx += 2;
             }
           }
 
-          OP_REQUIRES(
-              ctx,
-              (static_cast<size_t>(current_idx) < input.size() &&
-               input[current_idx] == '"' &&
-               (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
+          if (static_cast<size_t>(current_idx) >= input.size() ||
+              input[current_idx] != '"' ||
+              (static_cast<size_t>(current_idx) != input.size() - 1 &&
+               input[current_idx + 1] != delim_)) {
+            return errors::InvalidArgument(
+                "Quoted field has to end with quote followed by delim or end");
+          }
 
+          field = unescaped != nullptr
+                      ? StringPiece(*unescaped)
+                      : input.substr(field_start, current_idx - field_start);
           current_idx += 2;
         }
 
@@ -279,7 +296,7 @@ class DecodeCSVOp : public OpKernel {
         if (include) {
           result->push_back(field);
           selector_idx++;
-          if (selector_idx == select_cols_.size()) return;
+          if (selector_idx == select_cols_.size()) return Status::OK();
         }
       }
 
@@ -288,8 +305,9 @@ class DecodeCSVOp : public OpKernel {
                                    static_cast<size_t>(num_fields_parsed));
       // Check if the last field is missing
       if (include && input[input.size() - 1] == delim_)
-        result->push_back(string());
+        result->push_back(StringPiece());
     }
+    return Status::OK();
   }
 };
 
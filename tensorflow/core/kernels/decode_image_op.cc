@@ -15,7 +15,9 @@ limitations under the License.
 
 // See docs in ../ops/image_ops.cc
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "absl/strings/escaping.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -65,6 +67,31 @@ string FileFormatString(FileFormat magic, StringPiece data) {
   }
 }
 
+// Reads the JPEG decoding attrs shared by the JPEG decoding ops into `flags`.
+Status GetJpegDecodeAttrs(OpKernelConstruction* context,
+                          jpeg::UncompressFlags* flags) {
+  TF_RETURN_IF_ERROR(
+      context->GetAttr("fancy_upscaling", &flags->fancy_upscaling));
+  TF_RETURN_IF_ERROR(context->GetAttr("try_recover_truncated",
+                                      &flags->try_recover_truncated_jpeg));
+  TF_RETURN_IF_ERROR(context->GetAttr("acceptable_fraction",
+                                      &flags->min_acceptable_fraction));
+
+  string dct_method;
+  TF_RETURN_IF_ERROR(context->GetAttr("dct_method", &dct_method));
+  if (!dct_method.empty() && dct_method != "INTEGER_FAST" &&
+      dct_method != "INTEGER_ACCURATE") {
+    return errors::InvalidArgument(
+        "dct_method must be one of {'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}");
+  }
+  if (dct_method == "INTEGER_FAST") {
+    flags->dct_method = JDCT_IFAST;
+  } else if (dct_method == "INTEGER_ACCURATE") {
+    flags->dct_method = JDCT_ISLOW;
+  }
+  return Status::OK();
+}
+
 // Decode an image (either jpeg, png, or gif).  We use a single op so that
 // users don't have to care about which format they have.
 class DecodeImageOp : public OpKernel {
@@ -122,28 +149,7 @@ class DecodeImageOp : public OpKernel {
                       flags_.ratio == 8,
                   errors::InvalidArgument("ratio must be 1, 2, 4, or 8, got ",
                                           flags_.ratio));
-      OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
-                                               &flags_.fancy_upscaling));
-      OP_REQUIRES_OK(context,
-                     context->GetAttr("try_recover_truncated",
-                                      &flags_.try_recover_truncated_jpeg));
-      OP_REQUIRES_OK(context,
-                     context->GetAttr("acceptable_fraction",
-                                      &flags_.min_acceptable_fraction));
-
-      string dct_method;
-      OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
-      OP_REQUIRES(
-          context,
-          (dct_method.empty() || dct_method == "INTEGER_FAST" ||
-           dct_method == "INTEGER_ACCURATE"),
-          errors::InvalidArgument("dct_method must be one of "
-                                  "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
-      if (dct_method == "INTEGER_FAST") {
-        flags_.dct_method = JDCT_IFAST;
-      } else if (dct_method == "INTEGER_ACCURATE") {
-        flags_.dct_method = JDCT_ISLOW;
-      }
+      OP_REQUIRES_OK(context, GetJpegDecodeAttrs(context, &flags_));
     }
   }
 
@@ -336,11 +342,213 @@ class DecodeImageOp : public OpKernel {
   jpeg::UncompressFlags flags_;
 };
 
+// Decodes the crop window of a JPEG and resizes it with bilinear
+// interpolation, as ResizeBilinear with half_pixel_centers would resize the
+// output of DecodeAndCropJpeg. The crop window is decoded with the largest DCT
+// scaling that keeps it at least as large as the output, so large images are
+// never decoded at full resolution only to be downsampled.
+class DecodeAndCropAndResizeJpegOp : public OpKernel {
+ public:
+  explicit DecodeAndCropAndResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 0 || channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument(
+                    "channels must be 0, 1, or 3 for JPEG, got ", channels_));
+    flags_.components = channels_;
+    // The TensorFlow-chosen default for jpeg decoding is IFAST, sacrificing
+    // image quality for speed.
+    flags_.dct_method = JDCT_IFAST;
+    OP_REQUIRES_OK(context, GetJpegDecodeAttrs(context, &flags_));
+    flags_.crop = true;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("contents must be scalar, got shape ",
+                                        contents.shape().DebugString()));
+    const StringPiece input = contents.scalar<string>()();
+    OP_REQUIRES(context, ClassifyFileFormat(input) == kJpgFormat,
+                errors::InvalidArgument(
+                    "Expected JPEG, got ",
+                    FileFormatString(ClassifyFileFormat(input), input)));
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("JPEG contents are too large for int: ",
+                                        input.size()));
+
+    const Tensor& crop_window = context->input(1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(crop_window.shape()) &&
+                    crop_window.dim_size(0) == 4,
+                errors::InvalidArgument("crop_window must be 1-D with four "
+                                        "elements, got shape ",
+                                        crop_window.shape().DebugString()));
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(size.shape()) &&
+                    size.dim_size(0) == 2,
+                errors::InvalidArgument("size must be 1-D with two elements, "
+                                        "got shape ",
+                                        size.shape().DebugString()));
+    const auto crop_window_vec = crop_window.vec<int32>();
+    const int crop_y = crop_window_vec(0);
+    const int crop_x = crop_window_vec(1);
+    const int crop_height = crop_window_vec(2);
+    const int crop_width = crop_window_vec(3);
+    const int out_height = size.vec<int32>()(0);
+    const int out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive, got ",
+                                        out_height, "x", out_width));
+
+    int image_width;
+    int image_height;
+    OP_REQUIRES(context,
+                jpeg::GetImageInfo(input.data(), input.size(), &image_width,
+                                   &image_height, nullptr),
+                errors::InvalidArgument("Invalid JPEG data, data size ",
+                                        input.size()));
+    OP_REQUIRES(
+        context,
+        crop_y >= 0 && crop_x >= 0 && crop_height > 0 && crop_width > 0 &&
+            crop_y <= image_height - crop_height &&
+            crop_x <= image_width - crop_width,
+        errors::InvalidArgument("Invalid crop window ", crop_y, ",", crop_x,
+                                ",", crop_height, ",", crop_width,
+                                " for image of size ", image_height, "x",
+                                image_width));
+
+    // Pick the largest DCT scaling under which the crop window still has at
+    // least as many pixels as the output in each dimension.
+    jpeg::UncompressFlags flags = flags_;
+    for (const int scale_denom : {8, 4, 2}) {
+      if (crop_height / scale_denom >= out_height &&
+          crop_width / scale_denom >= out_width) {
+        flags.ratio = scale_denom;
+        break;
+      }
+    }
+    // The crop window in the scaled image, covering every scaled pixel that
+    // overlaps the requested window. libjpeg rounds scaled sizes up.
+    const int ratio = flags.ratio;
+    const int scaled_height = (image_height + ratio - 1) / ratio;
+    const int scaled_width = (image_width + ratio - 1) / ratio;
+    flags.crop_y = crop_y / ratio;
+    flags.crop_x = crop_x / ratio;
+    flags.crop_height =
+        std::min(scaled_height, (crop_y + crop_height + ratio - 1) / ratio) -
+        flags.crop_y;
+    flags.crop_width =
+        std::min(scaled_width, (crop_x + crop_width + ratio - 1) / ratio) -
+        flags.crop_x;
+
+    Tensor decoded;
+    OP_REQUIRES(
+        context,
+        jpeg::Uncompress(
+            input.data(), input.size(), flags, nullptr /* nwarn */,
+            [=, &decoded](int width, int height, int channels) -> uint8* {
+              Status status(context->allocate_temp(
+                  DT_UINT8, TensorShape({height, width, channels}), &decoded));
+              if (!status.ok()) {
+                VLOG(1) << status;
+                context->SetStatus(status);
+                return nullptr;
+              }
+              return decoded.flat<uint8>().data();
+            }),
+        errors::InvalidArgument("Invalid JPEG data or crop window, data size ",
+                                input.size()));
+
+    const int channels = decoded.dim_size(2);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({out_height, out_width, channels}),
+                       &output));
+    Resize(decoded, crop_y, crop_x, crop_height, crop_width, flags, output);
+  }
+
+ private:
+  struct Interpolation {
+    int64 lower;  // Index of the lower pixel.
+    int64 upper;  // Index of the upper pixel.
+    float lerp;   // Weight of the upper pixel.
+  };
+
+  // Interpolation of `out_size` output pixels spanning `crop_size` pixels of
+  // the original image from `crop_start`, in a decoded window of `in_size`
+  // pixels starting at scaled pixel `scaled_start`.
+  static std::vector<Interpolation> ComputeInterpolation(
+      int out_size, int crop_start, int crop_size, int ratio, int scaled_start,
+      int in_size, int stride) {
+    std::vector<Interpolation> interpolation(out_size);
+    const float scale = static_cast<float>(crop_size) / out_size;
+    for (int i = 0; i < out_size; ++i) {
+      // Pixel centers of the original image mapped to the scaled image.
+      const float in =
+          (crop_start + (i + 0.5f) * scale) / ratio - 0.5f - scaled_start;
+      const float in_clamped = std::max(0.0f, in);
+      const int lower = std::min(static_cast<int>(in_clamped), in_size - 1);
+      interpolation[i].lower = static_cast<int64>(lower) * stride;
+      interpolation[i].upper =
+          static_cast<int64>(std::min(lower + 1, in_size - 1)) * stride;
+      interpolation[i].lerp = in_clamped - lower;
+    }
+    return interpolation;
+  }
+
+  static void Resize(const Tensor& decoded, int crop_y, int crop_x,
+                     int crop_height, int crop_width,
+                     const jpeg::UncompressFlags& flags, Tensor* output) {
+    const int in_height = decoded.dim_size(0);
+    const int in_width = decoded.dim_size(1);
+    const int channels = decoded.dim_size(2);
+    const int out_height = output->dim_size(0);
+    const int out_width = output->dim_size(1);
+    const int64 in_row_size = static_cast<int64>(in_width) * channels;
+    const std::vector<Interpolation> ys =
+        ComputeInterpolation(out_height, crop_y, crop_height, flags.ratio,
+                             flags.crop_y, in_height, in_row_size);
+    const std::vector<Interpolation> xs =
+        ComputeInterpolation(out_width, crop_x, crop_width, flags.ratio,
+                             flags.crop_x, in_width, channels);
+
+    const uint8* in = decoded.flat<uint8>().data();
+    float* out = output->flat<float>().data();
+    for (int y = 0; y < out_height; ++y) {
+      const uint8* top = in + ys[y].lower;
+      const uint8* bottom = in + ys[y].upper;
+      const float y_lerp = ys[y].lerp;
+      for (int x = 0; x < out_width; ++x) {
+        const int64 left = xs[x].lower;
+        const int64 right = xs[x].upper;
+        const float x_lerp = xs[x].lerp;
+        for (int c = 0; c < channels; ++c) {
+          const float top_left = top[left + c];
+          const float bottom_left = bottom[left + c];
+          const float top_value =
+              top_left + (top[right + c] - top_left) * x_lerp;
+          const float bottom_value =
+              bottom_left + (bottom[right + c] - bottom_left) * x_lerp;
+          *out++ = top_value + (bottom_value - top_value) * y_lerp;
+        }
+      }
+    }
+  }
+
+  int channels_;
+  jpeg::UncompressFlags flags_;
+};
+
 REGISTER_KERNEL_BUILDER(Name("DecodeJpeg").Device(DEVICE_CPU), DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodePng").Device(DEVICE_CPU), DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodeGif").Device(DEVICE_CPU), DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodeAndCropJpeg").Device(DEVICE_CPU),
                         DecodeImageOp);
+REGISTER_KERNEL_BUILDER(Name("DecodeAndCropAndResizeJpeg").Device(DEVICE_CPU),
+                        DecodeAndCropAndResizeJpegOp);
 
 }  // namespace
 }  // namespace tensorflow
@@ -139,16 +139,86 @@ struct DepthwiseConv2DKernel {
   }
 };
 
+// Computes the output at ('out_r', 'out_c') of a depthwise conv2d with a depth
+// multiplier of one, reading 'input' and 'filter' in place. Output channel 'd'
+// then depends on input channel 'd' only, so unlike DepthwiseConv2DKernel this
+// needs neither a replicated input buffer nor a padded filter, and filter taps
+// that fall outside the input are skipped rather than multiplied by zeros.
+//
+// EX:
+//   in_depth = 6, filter [2, 2], register_width = 4
+//
+//   First output register [in_depth]
+//     [q0, q1, q2, q3] = ([a0, a1, a2, a3] x [u0, v0, w0, x0]) +
+//                        ([b0, b1, b2, b3] x [u1, v1, w1, x1]) +
+//                        ([e0, e1, e2, e3] x [u2, v2, w2, x2]) +
+//                        ([f0, f1, f2, f3] x [u3, v3, w3, x3])
+//   The remaining outputs [q4, q5] are computed one at a time.
+template <typename T>
+struct DepthwiseConv2DDirectKernel {
+  static void Run(const DepthwiseArgs& args, const int64 out_r,
+                  const int64 out_c, const T* filter, const T* input,
+                  T* output) {
+    typedef typename Eigen::internal::packet_traits<T>::type Packet;
+    static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+
+    const int64 depth = args.out_depth;
+    const int64 vectorized_size = (depth / kPacketSize) * kPacketSize;
+
+    // Restrict the filter to the taps that fall inside the input.
+    const int64 in_r_start = out_r * args.stride - args.pad_rows;
+    const int64 in_c_start = out_c * args.stride - args.pad_cols;
+    const int64 f_r_start = std::max<int64>(0, -in_r_start);
+    const int64 f_r_end =
+        std::min<int64>(args.filter_rows, args.in_rows - in_r_start);
+    const int64 f_c_start = std::max<int64>(0, -in_c_start);
+    const int64 f_c_end =
+        std::min<int64>(args.filter_cols, args.in_cols - in_c_start);
+
+    T* out = output + (out_r * args.out_cols + out_c) * depth;
+    for (int64 d = 0; d < vectorized_size; d += kPacketSize) {
+      auto vaccum = Eigen::internal::pset1<Packet>(static_cast<T>(0));
+      for (int64 f_r = f_r_start; f_r < f_r_end; ++f_r) {
+        const T* in_row =
+            input + ((in_r_start + f_r) * args.in_cols + in_c_start) * depth;
+        const T* filter_row = filter + f_r * args.filter_cols * depth;
+        for (int64 f_c = f_c_start; f_c < f_c_end; ++f_c) {
+          const auto filter_block =
+              Eigen::internal::ploadu<Packet>(filter_row + f_c * depth + d);
+          const auto data_block =
+              Eigen::internal::ploadu<Packet>(in_row + f_c * depth + d);
+          vaccum =
+              Eigen::internal::pmadd<Packet>(filter_block, data_block, vaccum);
+        }
+      }
+      Eigen::internal::pstoreu<T>(out + d, vaccum);
+    }
+
+    for (int64 d = vectorized_size; d < depth; ++d) {
+      T accum = static_cast<T>(0);
+      for (int64 f_r = f_r_start; f_r < f_r_end; ++f_r) {
+        const T* in_row =
+            input + ((in_r_start + f_r) * args.in_cols + in_c_start) * depth;
+        const T* filter_row = filter + f_r * args.filter_cols * depth;
+        for (int64 f_c = f_c_start; f_c < f_c_end; ++f_c) {
+          accum += filter_row[f_c * depth + d] * in_row[f_c * depth + d];
+        }
+      }
+      out[d] = accum;
+    }
+  }
+};
+
 // Computes the depthwise conv2d of 'input' by 'depthwise_filter' and stores
 // the result in 'output'. This implementation trades off copying small patches
 // of the input to achieve better data alignment, which enables vectorized
 // load/store and multiply-add operations (see comments at InputBufferCopyOp and
-// DepthwiseConv2DKernel for details).
+// DepthwiseConv2DKernel for details). With a depth multiplier of one, as in
+// most mobile architectures, the input is read in place instead (see
+// DepthwiseConv2DDirectKernel).
 //
 // TODO(andydavis) Evaluate the performance of processing multiple input
 // patches in the inner loop.
-// TODO(andydavis) Consider a zero-copy implementation for the case when
-// 'in_depth' is a multiple of register width, and 'depth_multipler' is one.
 // TODO(andydavis) Evaluate the performance of alternative implementations.
 template <typename T>
 struct LaunchDepthwiseConvOp<CPUDevice, T> {
@@ -164,7 +234,8 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
 
     // Pad 'depthwise_filter' to vector register width (if needed).
-    const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
+    const bool direct = args.depth_multiplier == 1;
+    const bool pad_filter = !direct && (args.out_depth % kPacketSize) != 0;
     Tensor padded_filter;
     if (pad_filter) {
       // Allocate space for padded filter.
@@ -184,13 +255,27 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
         pad_filter ? padded_filter.template flat<T>().data() : depthwise_filter;
 
     // Computes one shard of depthwise conv2d output.
-    auto shard = [&ctx, &args, &input, &filter_data, &output, data_format](
-                     int64 start, int64 limit) {
+    auto shard = [&ctx, &args, &input, &filter_data, &output, data_format,
+                  direct](int64 start, int64 limit) {
       static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
       const int64 input_image_size =
           args.in_rows * args.in_cols * args.in_depth;
       const int64 output_image_size =
           args.out_rows * args.out_cols * args.out_depth;
+
+      if (direct) {
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / args.out_rows;
+          const int64 out_r = i % args.out_rows;
+          for (int64 out_c = 0; out_c < args.out_cols; ++out_c) {
+            DepthwiseConv2DDirectKernel<T>::Run(
+                args, out_r, out_c, filter_data, input + b * input_image_size,
+                output + b * output_image_size);
+          }
+        }
+        return;
+      }
+
       const int64 filter_spatial_size = args.filter_rows * args.filter_cols;
       const int64 padded_filter_inner_dim_size =
           ((args.out_depth + kPacketSize - 1) / kPacketSize) * kPacketSize;
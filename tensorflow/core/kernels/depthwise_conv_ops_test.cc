@@ -93,6 +93,62 @@ class DepthwiseConvOpTest : public OpsTestBase {
 };
 
 TEST_F(DepthwiseConvOpTest, DepthwiseConvFloatCpu) { Run<float>(Device::CPU); }
+
+// Compares a depthwise conv with a depth multiplier of one against a direct
+// computation, for a depth that is not a multiple of the vector width.
+TEST_F(DepthwiseConvOpTest, DepthwiseConvDepthMultiplierOneCpu) {
+  TF_EXPECT_OK(NodeDefBuilder("depthwise_conv2d", "DepthwiseConv2dNative")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("strides", {1, 2, 2, 1})
+                   .Attr("padding", "SAME")
+                   .Finalize(node_def()));
+  TF_EXPECT_OK(InitOp());
+  const int depth = 19;
+  const int rows = 7;
+  const int cols = 6;
+  const int filter_size = 5;
+  Tensor image(DT_FLOAT, {1, rows, cols, depth});
+  auto image_flat = image.flat<float>();
+  for (int i = 0; i < image_flat.size(); ++i) {
+    image_flat(i) = (i % 7) - 3;
+  }
+  Tensor filter(DT_FLOAT, {filter_size, filter_size, depth, 1});
+  auto filter_flat = filter.flat<float>();
+  for (int i = 0; i < filter_flat.size(); ++i) {
+    filter_flat(i) = (i % 5) - 2;
+  }
+  AddInputFromArray<float>(image.shape(), image_flat);
+  AddInputFromArray<float>(filter.shape(), filter_flat);
+  TF_ASSERT_OK(RunOpKernel());
+
+  // With stride 2 and 'SAME' padding, the output is 4x3, and the input is
+  // padded by two rows at the top and one column at the left.
+  const int out_rows = 4;
+  const int out_cols = 3;
+  Tensor expected(DT_FLOAT, {1, out_rows, out_cols, depth});
+  auto image_t = image.tensor<float, 4>();
+  auto filter_t = filter.tensor<float, 4>();
+  auto expected_t = expected.tensor<float, 4>();
+  for (int r = 0; r < out_rows; ++r) {
+    for (int c = 0; c < out_cols; ++c) {
+      for (int d = 0; d < depth; ++d) {
+        float sum = 0;
+        for (int f_r = 0; f_r < filter_size; ++f_r) {
+          for (int f_c = 0; f_c < filter_size; ++f_c) {
+            const int in_r = r * 2 - 2 + f_r;
+            const int in_c = c * 2 - 1 + f_c;
+            if (in_r < 0 || in_r >= rows || in_c < 0 || in_c >= cols) continue;
+            sum += image_t(0, in_r, in_c, d) * filter_t(f_r, f_c, d, 0);
+          }
+        }
+        expected_t(0, r, c, d) = sum;
+      }
+    }
+  }
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
 TEST_F(DepthwiseConvOpTest, DepthwiseConvDoubleCpu) {
   Run<double>(Device::CPU);
 }
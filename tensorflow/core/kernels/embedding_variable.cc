@@ -0,0 +1,349 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/embedding_variable.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+EmbeddingVariable::EmbeddingVariable(const Tensor& default_value,
+                                     int64 hot_capacity,
+                                     const string& cold_storage_dir, Env* env)
+    : dim_(default_value.NumElements()),
+      hot_capacity_(hot_capacity),
+      cold_storage_dir_(cold_storage_dir),
+      env_(env) {
+  const auto values = default_value.flat<float>();
+  default_value_.assign(values.data(), values.data() + values.size());
+}
+
+EmbeddingVariable::~EmbeddingVariable() {
+  mutex_lock l(mu_);
+  CloseColdFile();
+}
+
+string EmbeddingVariable::DebugString() const {
+  return strings::StrCat("EmbeddingVariable(dim=", dim_,
+                         ", hot_rows=", num_hot_rows(),
+                         ", cold_rows=", num_cold_rows(), ")");
+}
+
+int64 EmbeddingVariable::MemoryUsed() const {
+  tf_shared_lock l(mu_);
+  int64 cold_bytes = 0;
+  for (const auto& id_and_row : cold_index_) {
+    cold_bytes += sizeof(ColdRow) + id_and_row.second.values.size() *
+                                        sizeof(float);
+  }
+  return sizeof(EmbeddingVariable) + hot_values_.size() * sizeof(float) +
+         hot_ids_.size() * 2 * sizeof(int64) + cold_bytes;
+}
+
+int64 EmbeddingVariable::num_hot_rows() const {
+  tf_shared_lock l(mu_);
+  return hot_index_.size();
+}
+
+int64 EmbeddingVariable::num_cold_rows() const {
+  tf_shared_lock l(mu_);
+  return cold_index_.size();
+}
+
+Status EmbeddingVariable::Gather(const std::vector<int64>& ids,
+                                 float* output) {
+  // Copy the hot rows under a shared lock, so that concurrent gathers of hot
+  // rows do not serialize. Only the rows that must be created or moved from
+  // the cold tier need the exclusive lock.
+  std::vector<size_t> missing;
+  {
+    tf_shared_lock l(mu_);
+    for (size_t i = 0; i < ids.size(); ++i) {
+      const auto it = hot_index_.find(ids[i]);
+      if (it == hot_index_.end()) {
+        missing.push_back(i);
+        continue;
+      }
+      hot_frequencies_[it->second].fetch_add(1, std::memory_order_relaxed);
+      std::memcpy(output + i * dim_, hot_row(it->second),
+                  dim_ * sizeof(float));
+    }
+  }
+  if (missing.empty()) {
+    return Status::OK();
+  }
+  mutex_lock l(mu_);
+  for (size_t i : missing) {
+    int64 slot;
+    TF_RETURN_IF_ERROR(GetHotSlot(ids[i], &slot));
+    std::memcpy(output + i * dim_, hot_row(slot), dim_ * sizeof(float));
+  }
+  return Status::OK();
+}
+
+Status EmbeddingVariable::Export(std::vector<int64>* ids,
+                                 std::vector<float>* values) {
+  // Exclusive, since reading cold rows may flush the cold file.
+  mutex_lock l(mu_);
+  const size_t num_rows = hot_index_.size() + cold_index_.size();
+  ids->clear();
+  ids->reserve(num_rows);
+  values->resize(num_rows * dim_);
+  float* output = values->data();
+  for (const auto& id_and_slot : hot_index_) {
+    ids->push_back(id_and_slot.first);
+    std::memcpy(output, hot_row(id_and_slot.second), dim_ * sizeof(float));
+    output += dim_;
+  }
+  for (const auto& id_and_row : cold_index_) {
+    ids->push_back(id_and_row.first);
+    TF_RETURN_IF_ERROR(ReadColdRow(id_and_row.second, output));
+    output += dim_;
+  }
+  return Status::OK();
+}
+
+Status EmbeddingVariable::Import(const std::vector<int64>& ids,
+                                 const float* values) {
+  mutex_lock l(mu_);
+  hot_values_.clear();
+  hot_ids_.clear();
+  hot_frequencies_.clear();
+  free_hot_slots_.clear();
+  hot_index_.clear();
+  cold_index_.clear();
+  CloseColdFile();
+  for (size_t i = 0; i < ids.size(); ++i) {
+    int64 slot;
+    TF_RETURN_IF_ERROR(GetHotSlot(ids[i], &slot));
+    std::memcpy(hot_row(slot), values + i * dim_, dim_ * sizeof(float));
+  }
+  return Status::OK();
+}
+
+Status EmbeddingVariable::Update(
+    const std::vector<int64>& ids,
+    const std::function<void(int64, float*)>& update) {
+  mutex_lock l(mu_);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    int64 slot;
+    TF_RETURN_IF_ERROR(GetHotSlot(ids[i], &slot));
+    update(i, hot_row(slot));
+  }
+  return Status::OK();
+}
+
+Status EmbeddingVariable::GetHotSlot(int64 id, int64* slot) {
+  auto hot_it = hot_index_.find(id);
+  if (hot_it != hot_index_.end()) {
+    *slot = hot_it->second;
+    hot_frequencies_[*slot].fetch_add(1, std::memory_order_relaxed);
+    return Status::OK();
+  }
+
+  // Allocate first: evictions add rows to the cold tier, which invalidates its
+  // iterators.
+  TF_RETURN_IF_ERROR(AllocateHotSlot(slot));
+  auto cold_it = cold_index_.find(id);
+  if (cold_it == cold_index_.end()) {
+    std::copy(default_value_.begin(), default_value_.end(), hot_row(*slot));
+    hot_frequencies_[*slot].store(1, std::memory_order_relaxed);
+  } else {
+    TF_RETURN_IF_ERROR(ReadColdRow(cold_it->second, hot_row(*slot)));
+    hot_frequencies_[*slot].store(cold_it->second.frequency + 1,
+                                  std::memory_order_relaxed);
+    cold_index_.erase(cold_it);
+  }
+  hot_ids_[*slot] = id;
+  hot_index_[id] = *slot;
+  return Status::OK();
+}
+
+Status EmbeddingVariable::AllocateHotSlot(int64* slot) {
+  if (free_hot_slots_.empty() &&
+      static_cast<int64>(hot_ids_.size()) >= hot_capacity_) {
+    TF_RETURN_IF_ERROR(EvictHotRows());
+  }
+  if (!free_hot_slots_.empty()) {
+    *slot = free_hot_slots_.back();
+    free_hot_slots_.pop_back();
+    return Status::OK();
+  }
+  *slot = hot_ids_.size();
+  hot_ids_.push_back(-1);
+  GrowHotFrequencies(hot_ids_.size());
+  hot_frequencies_[*slot].store(0, std::memory_order_relaxed);
+  hot_values_.resize(hot_values_.size() + dim_);
+  return Status::OK();
+}
+
+void EmbeddingVariable::GrowHotFrequencies(int64 size) {
+  const int64 old_size = hot_frequencies_.size();
+  if (size <= old_size) {
+    return;
+  }
+  // std::atomic is not movable, so the counts are copied into a new vector,
+  // which doubles to keep the copies amortized.
+  std::vector<std::atomic<int64>> frequencies(
+      std::max(size, std::min(hot_capacity_, 2 * old_size)));
+  for (int64 i = 0; i < old_size; ++i) {
+    frequencies[i].store(hot_frequencies_[i].load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+  }
+  hot_frequencies_.swap(frequencies);
+}
+
+Status EmbeddingVariable::EvictHotRows() {
+  std::vector<int64> slots;
+  slots.reserve(hot_index_.size());
+  for (const auto& id_and_slot : hot_index_) {
+    slots.push_back(id_and_slot.second);
+  }
+  const int64 num_evicted =
+      std::min<int64>(slots.size(), std::max<int64>(1, hot_capacity_ / 8));
+  std::nth_element(slots.begin(), slots.begin() + num_evicted, slots.end(),
+                   [this](int64 a, int64 b) {
+                     return hot_frequencies_[a].load(
+                                std::memory_order_relaxed) <
+                            hot_frequencies_[b].load(
+                                std::memory_order_relaxed);
+                   });
+  for (int64 i = 0; i < num_evicted; ++i) {
+    const int64 slot = slots[i];
+    const int64 id = hot_ids_[slot];
+    ColdRow& row = cold_index_[id];
+    row.frequency = hot_frequencies_[slot].load(std::memory_order_relaxed);
+    TF_RETURN_IF_ERROR(WriteColdRow(hot_row(slot), &row));
+    hot_index_.erase(id);
+    hot_ids_[slot] = -1;
+    free_hot_slots_.push_back(slot);
+  }
+  for (std::atomic<int64>& frequency : hot_frequencies_) {
+    frequency.store(frequency.load(std::memory_order_relaxed) / 2,
+                    std::memory_order_relaxed);
+  }
+  if (!cold_storage_dir_.empty() &&
+      num_cold_records_ > 2 * static_cast<int64>(cold_index_.size()) + 1024) {
+    TF_RETURN_IF_ERROR(CompactColdFile());
+  }
+  return Status::OK();
+}
+
+Status EmbeddingVariable::WriteColdRow(const float* values, ColdRow* row) {
+  if (cold_storage_dir_.empty()) {
+    row->values.assign(values, values + dim_);
+    return Status::OK();
+  }
+  if (cold_writer_ == nullptr) {
+    TF_RETURN_IF_ERROR(OpenColdFile());
+  }
+  const size_t length = dim_ * sizeof(float);
+  TF_RETURN_IF_ERROR(cold_writer_->Append(
+      StringPiece(reinterpret_cast<const char*>(values), length)));
+  row->offset = cold_file_size_;
+  cold_file_size_ += length;
+  ++num_cold_records_;
+  cold_needs_flush_ = true;
+  return Status::OK();
+}
+
+Status EmbeddingVariable::ReadColdRow(const ColdRow& row, float* values) {
+  if (cold_storage_dir_.empty()) {
+    std::copy(row.values.begin(), row.values.end(), values);
+    return Status::OK();
+  }
+  if (cold_needs_flush_) {
+    TF_RETURN_IF_ERROR(cold_writer_->Flush());
+    cold_needs_flush_ = false;
+  }
+  const size_t length = dim_ * sizeof(float);
+  StringPiece result;
+  TF_RETURN_IF_ERROR(cold_reader_->Read(row.offset, length, &result,
+                                        reinterpret_cast<char*>(values)));
+  if (result.size() != length) {
+    return errors::DataLoss("Short read from embedding variable cold file ",
+                            cold_filename_);
+  }
+  if (result.data() != reinterpret_cast<const char*>(values)) {
+    std::memcpy(values, result.data(), length);
+  }
+  return Status::OK();
+}
+
+Status EmbeddingVariable::OpenColdFile() {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(cold_storage_dir_));
+  cold_filename_ = io::JoinPath(
+      cold_storage_dir_,
+      strings::StrCat("embedding_variable_", random::New64(), ".cold"));
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(cold_filename_, &cold_writer_));
+  TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(cold_filename_, &cold_reader_));
+  cold_file_size_ = 0;
+  num_cold_records_ = 0;
+  cold_needs_flush_ = false;
+  return Status::OK();
+}
+
+Status EmbeddingVariable::CompactColdFile() {
+  VLOG(1) << "Compacting embedding variable cold file " << cold_filename_
+          << ": " << cold_index_.size() << " live rows out of "
+          << num_cold_records_;
+  if (cold_needs_flush_) {
+    TF_RETURN_IF_ERROR(cold_writer_->Flush());
+    cold_needs_flush_ = false;
+  }
+  std::unique_ptr<RandomAccessFile> old_reader = std::move(cold_reader_);
+  const string old_filename = cold_filename_;
+  TF_RETURN_IF_ERROR(cold_writer_->Close());
+  cold_writer_.reset();
+  TF_RETURN_IF_ERROR(OpenColdFile());
+
+  const size_t length = dim_ * sizeof(float);
+  std::vector<float> values(dim_);
+  for (auto& id_and_row : cold_index_) {
+    ColdRow& row = id_and_row.second;
+    StringPiece result;
+    char* scratch = reinterpret_cast<char*>(values.data());
+    TF_RETURN_IF_ERROR(old_reader->Read(row.offset, length, &result, scratch));
+    if (result.size() != length) {
+      return errors::DataLoss("Short read from embedding variable cold file ",
+                              old_filename);
+    }
+    TF_RETURN_IF_ERROR(cold_writer_->Append(result));
+    row.offset = cold_file_size_;
+    cold_file_size_ += length;
+    ++num_cold_records_;
+  }
+  cold_needs_flush_ = true;
+  old_reader.reset();
+  env_->DeleteFile(old_filename).IgnoreError();
+  return Status::OK();
+}
+
+void EmbeddingVariable::CloseColdFile() {
+  if (cold_writer_ == nullptr) {
+    return;
+  }
+  cold_reader_.reset();
+  cold_writer_->Close().IgnoreError();
+  cold_writer_.reset();
+  env_->DeleteFile(cold_filename_).IgnoreError();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,153 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
+#define TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// A float embedding table keyed by int64 ids, for tables with too many rows to
+// keep in memory as a dense variable.
+//
+// Rows are created on first access with the default value. They live in one
+// of two tiers:
+//  - The hot tier holds at most `hot_capacity` rows in a contiguous array.
+//    Every access goes through it: rows of the cold tier are moved back into
+//    it when they are read or updated.
+//  - The cold tier holds the rows evicted from the hot tier. They are stored
+//    in a file in `cold_storage_dir`, or in host memory if it is empty.
+//
+// Each hot row counts its accesses. When the hot tier is full, the eighth of
+// its rows with the fewest accesses is evicted, and the counts of the
+// remaining rows are halved so that the tier follows shifts in popularity.
+//
+// The cold file is append-only. It is rewritten with only the live rows once
+// it holds more than twice as many records as live rows.
+//
+// Thread-safe. Gathers of rows that are all in the hot tier only take a shared
+// lock; anything that creates or moves rows takes an exclusive one.
+class EmbeddingVariable : public ResourceBase {
+ public:
+  // `default_value` must be a float vector, whose size is the embedding
+  // dimension.
+  EmbeddingVariable(const Tensor& default_value, int64 hot_capacity,
+                    const string& cold_storage_dir, Env* env);
+
+  string DebugString() const override;
+  int64 MemoryUsed() const override;
+
+  int64 dim() const { return dim_; }
+
+  // Copies the rows of `ids` to `output`, which must hold ids.size() * dim()
+  // floats.
+  Status Gather(const std::vector<int64>& ids, float* output)
+      LOCKS_EXCLUDED(mu_);
+
+  // Returns the ids of all rows, hot and cold, and their values, with
+  // ids->size() * dim() floats.
+  Status Export(std::vector<int64>* ids, std::vector<float>* values)
+      LOCKS_EXCLUDED(mu_);
+
+  // Replaces all rows with the ids->size() rows in `values`, for example when
+  // restoring a checkpoint.
+  Status Import(const std::vector<int64>& ids, const float* values)
+      LOCKS_EXCLUDED(mu_);
+
+  // Calls `update(i, row)` with the row of ids[i], for each i in order.
+  Status Update(const std::vector<int64>& ids,
+                const std::function<void(int64, float*)>& update)
+      LOCKS_EXCLUDED(mu_);
+
+  int64 num_hot_rows() const LOCKS_EXCLUDED(mu_);
+  int64 num_cold_rows() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct ColdRow {
+    int64 frequency = 0;
+    // Location of the row in the cold file.
+    uint64 offset = 0;
+    // The row itself when there is no cold file.
+    std::vector<float> values;
+  };
+
+  ~EmbeddingVariable() override;
+
+  // Returns the slot of the hot tier holding the row of `id`, creating the
+  // row or moving it from the cold tier as needed.
+  Status GetHotSlot(int64 id, int64* slot) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns a free slot of the hot tier, evicting rows if it is full.
+  Status AllocateHotSlot(int64* slot) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status EvictHotRows() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Grows hot_frequencies_ to hold at least `size` slots.
+  void GrowHotFrequencies(int64 size) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Status WriteColdRow(const float* values, ColdRow* row)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status ReadColdRow(const ColdRow& row, float* values)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status OpenColdFile() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status CompactColdFile() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void CloseColdFile() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  float* hot_row(int64 slot) SHARED_LOCKS_REQUIRED(mu_) {
+    return hot_values_.data() + slot * dim_;
+  }
+
+  const int64 dim_;
+  const int64 hot_capacity_;
+  const string cold_storage_dir_;
+  Env* const env_;
+  std::vector<float> default_value_;
+
+  mutable mutex mu_;
+  // The hot tier. Slot i holds the row of hot_ids_[i], or is free if it is in
+  // free_hot_slots_. The access counts are atomic so that gathers can bump
+  // them under a shared lock; the vector itself only changes under an
+  // exclusive lock, and may be longer than hot_ids_.
+  std::vector<float> hot_values_ GUARDED_BY(mu_);
+  std::vector<int64> hot_ids_ GUARDED_BY(mu_);
+  std::vector<std::atomic<int64>> hot_frequencies_ GUARDED_BY(mu_);
+  std::vector<int64> free_hot_slots_ GUARDED_BY(mu_);
+  absl::flat_hash_map<int64, int64> hot_index_ GUARDED_BY(mu_);
+
+  // The cold tier.
+  absl::flat_hash_map<int64, ColdRow> cold_index_ GUARDED_BY(mu_);
+  string cold_filename_ GUARDED_BY(mu_);
+  std::unique_ptr<WritableFile> cold_writer_ GUARDED_BY(mu_);
+  std::unique_ptr<RandomAccessFile> cold_reader_ GUARDED_BY(mu_);
+  uint64 cold_file_size_ GUARDED_BY(mu_) = 0;
+  int64 num_cold_records_ GUARDED_BY(mu_) = 0;
+  // Whether appended rows may not have reached the file yet.
+  bool cold_needs_flush_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EmbeddingVariable);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
@@ -0,0 +1,274 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Kernels of the tiered EmbeddingVariable resource. See embedding_variable.h.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/bounds_check.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/embedding_variable.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace {
+
+template <typename Index>
+std::vector<int64> GetIds(const Tensor& indices) {
+  const auto indices_flat = indices.flat<Index>();
+  std::vector<int64> ids(indices_flat.size());
+  for (int64 i = 0; i < indices_flat.size(); ++i) {
+    ids[i] = internal::SubtleMustCopy(indices_flat(i));
+  }
+  return ids;
+}
+
+}  // namespace
+
+class EmbeddingVariableHandleOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableHandleOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("hot_capacity", &hot_capacity_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("cold_storage_dir", &cold_storage_dir_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& default_value = ctx->input(0);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(default_value.shape()),
+                errors::InvalidArgument("default_value must be a vector, got ",
+                                        default_value.shape().DebugString()));
+
+    ContainerInfo cinfo;
+    OP_REQUIRES_OK(ctx, cinfo.Init(ctx->resource_manager(), def(),
+                                   /*use_node_name_as_default=*/true));
+    EmbeddingVariable* variable;
+    OP_REQUIRES_OK(ctx,
+                   ctx->resource_manager()->LookupOrCreate<EmbeddingVariable>(
+                       cinfo.container(), cinfo.name(), &variable,
+                       [&](EmbeddingVariable** ret) {
+                         *ret = new EmbeddingVariable(
+                             default_value, hot_capacity_, cold_storage_dir_,
+                             ctx->env());
+                         return Status::OK();
+                       }));
+    core::ScopedUnref unref(variable);
+    OP_REQUIRES(ctx, variable->dim() == default_value.NumElements(),
+                errors::InvalidArgument(
+                    "Embedding variable ", cinfo.name(), " has dimension ",
+                    variable->dim(), ", but default_value has ",
+                    default_value.NumElements(), " elements"));
+
+    Tensor* handle;
+    AllocatorAttributes attr;
+    attr.set_on_host(true);
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(0, TensorShape({}), &handle, attr));
+    handle->scalar<ResourceHandle>()() = MakeResourceHandle<EmbeddingVariable>(
+        ctx, cinfo.container(), cinfo.name());
+  }
+
+ private:
+  int64 hot_capacity_;
+  string cold_storage_dir_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableHandleOp")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("dtype"),
+                        EmbeddingVariableHandleOp);
+
+template <typename Index>
+class ResourceEmbeddingGatherOp : public OpKernel {
+ public:
+  explicit ResourceEmbeddingGatherOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    EmbeddingVariable* variable;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0),
+                                       &variable));
+    core::ScopedUnref unref(variable);
+
+    const Tensor& indices = ctx->input(1);
+    TensorShape output_shape = indices.shape();
+    output_shape.AddDim(variable->dim());
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+    OP_REQUIRES_OK(ctx, variable->Gather(GetIds<Index>(indices),
+                                         output->flat<float>().data()));
+  }
+};
+
+#define REGISTER_GATHER_KERNEL(index_type)                             \
+  REGISTER_KERNEL_BUILDER(Name("ResourceEmbeddingGather")              \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<float>("dtype")          \
+                              .TypeConstraint<index_type>("Tindices"), \
+                          ResourceEmbeddingGatherOp<index_type>)
+REGISTER_GATHER_KERNEL(int32);
+REGISTER_GATHER_KERNEL(int64);
+#undef REGISTER_GATHER_KERNEL
+
+class EmbeddingVariableExportOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableExportOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    EmbeddingVariable* variable;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0),
+                                       &variable));
+    core::ScopedUnref unref(variable);
+
+    std::vector<int64> ids;
+    std::vector<float> values;
+    OP_REQUIRES_OK(ctx, variable->Export(&ids, &values));
+    const int64 num_rows = ids.size();
+    Tensor* ids_output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({num_rows}),
+                                             &ids_output));
+    std::copy(ids.begin(), ids.end(), ids_output->flat<int64>().data());
+    Tensor* values_output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                            1, TensorShape({num_rows, variable->dim()}),
+                            &values_output));
+    std::copy(values.begin(), values.end(),
+              values_output->flat<float>().data());
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableExport")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("dtype"),
+                        EmbeddingVariableExportOp);
+
+class EmbeddingVariableImportOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableImportOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    EmbeddingVariable* variable;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0),
+                                       &variable));
+    core::ScopedUnref unref(variable);
+
+    const Tensor& ids = ctx->input(1);
+    const Tensor& values = ctx->input(2);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(ids.shape()),
+                errors::InvalidArgument("ids must be a vector, got ",
+                                        ids.shape().DebugString()));
+    OP_REQUIRES(ctx,
+                values.NumElements() == ids.NumElements() * variable->dim(),
+                errors::InvalidArgument(
+                    "values must have ", ids.NumElements() * variable->dim(),
+                    " elements to import ", ids.NumElements(),
+                    " rows of dimension ", variable->dim(), ", got shape ",
+                    values.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, variable->Import(GetIds<int64>(ids),
+                                         values.flat<float>().data()));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableImport")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("dtype"),
+                        EmbeddingVariableImportOp);
+
+// Sparse Adagrad update of an embedding variable, with the accumulators in a
+// second embedding variable:
+//   accum += grad * grad
+//   var -= lr * grad / sqrt(accum)
+// Each variable is only locked while its own rows are updated, so the two
+// variables are never locked at the same time.
+template <typename Index>
+class ResourceEmbeddingSparseApplyAdagradOp : public OpKernel {
+ public:
+  explicit ResourceEmbeddingSparseApplyAdagradOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    EmbeddingVariable* var;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &var));
+    core::ScopedUnref unref_var(var);
+    EmbeddingVariable* accum;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 1), &accum));
+    core::ScopedUnref unref_accum(accum);
+    OP_REQUIRES(ctx, var->dim() == accum->dim(),
+                errors::InvalidArgument(
+                    "var and accum must have the same dimension, got ",
+                    var->dim(), " and ", accum->dim()));
+
+    const Tensor& lr = ctx->input(2);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& grad = ctx->input(3);
+    const Tensor& indices = ctx->input(4);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices must be one-dimensional"));
+    const int64 num_ids = indices.dim_size(0);
+    OP_REQUIRES(ctx, grad.NumElements() == num_ids * var->dim(),
+                errors::InvalidArgument(
+                    "grad must have ", num_ids * var->dim(),
+                    " elements to update ", num_ids, " rows of dimension ",
+                    var->dim(), ", got shape ", grad.shape().DebugString()));
+
+    const int64 dim = var->dim();
+    const float lr_scalar = lr.scalar<float>()();
+    const float* grad_values = grad.flat<float>().data();
+    const std::vector<int64> ids = GetIds<Index>(indices);
+
+    // Accumulate first, keeping the accumulator of each update for the
+    // variable update. Duplicate ids then see the same accumulators as if
+    // both variables were updated one id at a time.
+    std::vector<float> accum_values(num_ids * dim);
+    OP_REQUIRES_OK(ctx, accum->Update(ids, [&](int64 i, float* row) {
+      const float* g = grad_values + i * dim;
+      float* a = accum_values.data() + i * dim;
+      for (int64 j = 0; j < dim; ++j) {
+        row[j] += g[j] * g[j];
+        a[j] = row[j];
+      }
+    }));
+    OP_REQUIRES_OK(ctx, var->Update(ids, [&](int64 i, float* row) {
+      const float* g = grad_values + i * dim;
+      const float* a = accum_values.data() + i * dim;
+      for (int64 j = 0; j < dim; ++j) {
+        row[j] -= lr_scalar * g[j] / std::sqrt(a[j]);
+      }
+    }));
+  }
+};
+
+#define REGISTER_ADAGRAD_KERNEL(index_type)                            \
+  REGISTER_KERNEL_BUILDER(Name("ResourceEmbeddingSparseApplyAdagrad")  \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<float>("T")              \
+                              .TypeConstraint<index_type>("Tindices"), \
+                          ResourceEmbeddingSparseApplyAdagradOp<index_type>)
+REGISTER_ADAGRAD_KERNEL(int32);
+REGISTER_ADAGRAD_KERNEL(int64);
+#undef REGISTER_ADAGRAD_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,177 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/embedding_variable.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Writes id + j to column j of the rows of `ids`, then checks that they read
+// back after the hot tier has been cycled through.
+void TestEvictionAndReload(const string& cold_storage_dir) {
+  const int64 dim = 3;
+  const int64 hot_capacity = 16;
+  EmbeddingVariable* variable =
+      new EmbeddingVariable(test::AsTensor<float>({0.5f, 0.5f, 0.5f}),
+                            hot_capacity, cold_storage_dir, Env::Default());
+  core::ScopedUnref unref(variable);
+
+  std::vector<int64> ids;
+  for (int64 id = 0; id < 100; ++id) {
+    ids.push_back(id * 7919);
+  }
+  TF_ASSERT_OK(variable->Update(ids, [&](int64 i, float* row) {
+    for (int64 j = 0; j < dim; ++j) {
+      row[j] = ids[i] + j;
+    }
+  }));
+  EXPECT_LE(variable->num_hot_rows(), hot_capacity);
+  EXPECT_EQ(variable->num_hot_rows() + variable->num_cold_rows(), 100);
+
+  // Read twice, so that rows move back and forth between the tiers.
+  for (int pass = 0; pass < 2; ++pass) {
+    std::vector<float> output(ids.size() * dim);
+    TF_ASSERT_OK(variable->Gather(ids, output.data()));
+    for (size_t i = 0; i < ids.size(); ++i) {
+      for (int64 j = 0; j < dim; ++j) {
+        EXPECT_EQ(output[i * dim + j], ids[i] + j);
+      }
+    }
+  }
+
+  // New rows start from the default value.
+  std::vector<float> output(dim);
+  TF_ASSERT_OK(variable->Gather({-1}, output.data()));
+  EXPECT_EQ(output, std::vector<float>({0.5f, 0.5f, 0.5f}));
+}
+
+TEST(EmbeddingVariableTest, EvictsToMemory) { TestEvictionAndReload(""); }
+
+TEST(EmbeddingVariableTest, EvictsToFile) {
+  TestEvictionAndReload(
+      io::JoinPath(testing::TmpDir(), "embedding_variable_test"));
+}
+
+TEST(EmbeddingVariableTest, KeepsFrequentRowsHot) {
+  const int64 hot_capacity = 8;
+  EmbeddingVariable* variable = new EmbeddingVariable(
+      test::AsTensor<float>({0.0f}), hot_capacity, "", Env::Default());
+  core::ScopedUnref unref(variable);
+
+  // Row 42 is read between every new row, so it must never be evicted.
+  float value;
+  for (int64 id = 0; id < 10 * hot_capacity; ++id) {
+    TF_ASSERT_OK(variable->Gather({42}, &value));
+    TF_ASSERT_OK(variable->Gather({id + 100}, &value));
+    EXPECT_EQ(variable->num_hot_rows() + variable->num_cold_rows(), id + 2);
+  }
+  // Reading a cold row would move it out of the cold tier.
+  const int64 num_cold_rows = variable->num_cold_rows();
+  EXPECT_GT(num_cold_rows, 0);
+  TF_ASSERT_OK(variable->Gather({42}, &value));
+  EXPECT_EQ(variable->num_cold_rows(), num_cold_rows);
+}
+
+TEST(EmbeddingVariableTest, ExportAndImportIncludeColdRows) {
+  const string cold_storage_dir =
+      io::JoinPath(testing::TmpDir(), "embedding_variable_export_test");
+  const int64 hot_capacity = 4;
+  EmbeddingVariable* variable =
+      new EmbeddingVariable(test::AsTensor<float>({0.0f, 0.0f}), hot_capacity,
+                            cold_storage_dir, Env::Default());
+  core::ScopedUnref unref(variable);
+
+  std::vector<int64> ids;
+  for (int64 id = 0; id < 20; ++id) {
+    ids.push_back(id);
+  }
+  TF_ASSERT_OK(variable->Update(ids, [&](int64 i, float* row) {
+    row[0] = ids[i];
+    row[1] = -ids[i];
+  }));
+  ASSERT_GT(variable->num_cold_rows(), 0);
+
+  std::vector<int64> exported_ids;
+  std::vector<float> exported_values;
+  TF_ASSERT_OK(variable->Export(&exported_ids, &exported_values));
+  ASSERT_EQ(exported_ids.size(), ids.size());
+  ASSERT_EQ(exported_values.size(), 2 * ids.size());
+  for (size_t i = 0; i < exported_ids.size(); ++i) {
+    EXPECT_EQ(exported_values[2 * i], exported_ids[i]);
+    EXPECT_EQ(exported_values[2 * i + 1], -exported_ids[i]);
+  }
+
+  // Importing replaces every row, hot and cold.
+  EmbeddingVariable* restored =
+      new EmbeddingVariable(test::AsTensor<float>({0.0f, 0.0f}), hot_capacity,
+                            cold_storage_dir, Env::Default());
+  core::ScopedUnref unref_restored(restored);
+  std::vector<float> row(2);
+  TF_ASSERT_OK(restored->Gather({100}, row.data()));
+  TF_ASSERT_OK(restored->Import(exported_ids, exported_values.data()));
+  EXPECT_EQ(restored->num_hot_rows() + restored->num_cold_rows(), 20);
+  std::vector<float> output(2 * (ids.size() + 1));
+  ids.push_back(100);
+  TF_ASSERT_OK(restored->Gather(ids, output.data()));
+  for (size_t i = 0; i + 1 < ids.size(); ++i) {
+    EXPECT_EQ(output[2 * i], ids[i]);
+    EXPECT_EQ(output[2 * i + 1], -ids[i]);
+  }
+  EXPECT_EQ(output[2 * 20], 0.0f);
+}
+
+TEST(EmbeddingVariableTest, ConcurrentGathersOfHotRows) {
+  const int64 dim = 4;
+  EmbeddingVariable* variable = new EmbeddingVariable(
+      test::AsTensor<float>({0.0f, 0.0f, 0.0f, 0.0f}), /*hot_capacity=*/64,
+      "", Env::Default());
+  core::ScopedUnref unref(variable);
+  std::vector<int64> ids;
+  for (int64 id = 0; id < 32; ++id) {
+    ids.push_back(id);
+  }
+  TF_ASSERT_OK(variable->Update(ids, [&](int64 i, float* row) {
+    std::fill(row, row + dim, static_cast<float>(ids[i]));
+  }));
+
+  {
+    thread::ThreadPool pool(Env::Default(), "gather", 4);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&]() {
+        std::vector<float> output(ids.size() * dim);
+        for (int iter = 0; iter < 100; ++iter) {
+          TF_EXPECT_OK(variable->Gather(ids, output.data()));
+          for (size_t i = 0; i < output.size(); ++i) {
+            EXPECT_EQ(output[i], ids[i / dim]);
+          }
+        }
+      });
+    }
+  }
+  EXPECT_EQ(variable->num_hot_rows(), 32);
+  EXPECT_EQ(variable->num_cold_rows(), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <deque>
+#include <iterator>
 #include <vector>
 
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -50,6 +51,29 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  // Fast path: if no enqueue is waiting and there is room, add the element
+  // right away, without registering an attempt with the cancellation manager.
+  if (!cm->IsCancelled()) {
+    bool enqueued = false;
+    bool dequeues_waiting = false;
+    {
+      mutex_lock l(mu_);
+      if (!closed_ && enqueue_attempts_.empty() &&
+          queues_[0].size() < static_cast<size_t>(capacity_)) {
+        for (int i = 0; i < num_components(); ++i) {
+          queues_[i].push_back(PersistentTensor(tuple[i]));
+        }
+        enqueued = true;
+        dequeues_waiting = !dequeue_attempts_.empty();
+      }
+    }
+    if (enqueued) {
+      if (dequeues_waiting) FlushUnlocked();
+      callback();
+      return;
+    }
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -154,6 +178,25 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  // Fast path: if no dequeue is waiting and the queue is not empty, take the
+  // element right away.
+  if (!cm->IsCancelled()) {
+    Tuple tuple;
+    bool enqueues_waiting = false;
+    {
+      mutex_lock l(mu_);
+      if (dequeue_attempts_.empty() && !queues_[0].empty()) {
+        DequeueLocked(ctx, &tuple);
+        enqueues_waiting = !enqueue_attempts_.empty();
+      }
+    }
+    if (!tuple.empty()) {
+      if (enqueues_waiting) FlushUnlocked();
+      callback(tuple);
+      return;
+    }
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -245,6 +288,73 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 
   CancellationManager* cm = ctx->cancellation_manager();
+  // Fast path: if no dequeue is waiting and the queue holds a full batch,
+  // allocate the batch and take the elements while holding the lock, and copy
+  // them into the batch after releasing it. The batch is allocated before any
+  // element is removed, so that a failed allocation loses no elements.
+  if (!cm->IsCancelled()) {
+    Tuple tuple;
+    std::vector<PersistentTensor> elements;
+    bool enqueues_waiting = false;
+    Status status;
+    {
+      mutex_lock l(mu_);
+      if (dequeue_attempts_.empty() &&
+          queues_[0].size() >= static_cast<size_t>(num_elements)) {
+        tuple.reserve(num_components());
+        for (int i = 0; status.ok() && i < num_components(); ++i) {
+          tuple.emplace_back();
+          status = ctx->allocate_temp(component_dtypes_[i],
+                                      ManyOutShape(i, num_elements),
+                                      &tuple.back());
+        }
+        if (status.ok()) {
+          elements.reserve(num_elements * num_components());
+          for (int i = 0; i < num_components(); ++i) {
+            std::move(queues_[i].begin(), queues_[i].begin() + num_elements,
+                      std::back_inserter(elements));
+            queues_[i].erase(queues_[i].begin(),
+                             queues_[i].begin() + num_elements);
+          }
+          enqueues_waiting = !enqueue_attempts_.empty();
+        }
+      }
+    }
+    if (!status.ok()) {
+      ctx->SetStatus(status);
+      callback(Tuple());
+      return;
+    }
+    if (!elements.empty()) {
+      if (enqueues_waiting) FlushUnlocked();
+      for (int i = 0; status.ok() && i < num_components(); ++i) {
+        for (int64 j = 0; status.ok() && j < num_elements; ++j) {
+          status = batch_util::CopyElementToSlice(
+              *elements[i * num_elements + j].AccessTensor(ctx), &tuple[i], j);
+        }
+      }
+      if (!status.ok()) {
+        // Puts the elements back at the front of the queue, in order.
+        {
+          mutex_lock l(mu_);
+          for (int i = 0; i < num_components(); ++i) {
+            queues_[i].insert(
+                queues_[i].begin(),
+                std::make_move_iterator(elements.begin() + i * num_elements),
+                std::make_move_iterator(elements.begin() +
+                                        (i + 1) * num_elements));
+          }
+        }
+        FlushUnlocked();
+        ctx->SetStatus(status);
+        callback(Tuple());
+        return;
+      }
+      callback(tuple);
+      return;
+    }
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -40,27 +41,43 @@ inline void CopyToBuffer(const T& value, uint8* output) {
 #endif
 }
 
-void FarmhashFingerprint64(TTypes<uint8, 2>::ConstTensor input,
+// The rough cost, in cycles, of fingerprinting a short string.
+constexpr int64 kStringFingerprintCost = 100;
+
+void FarmhashFingerprint64(OpKernelContext* context,
+                           TTypes<uint8, 2>::ConstTensor input,
                            TTypes<uint8, 2>::Matrix output) {
   DCHECK_EQ(output.dimension(0), input.dimension(0));
   DCHECK_EQ(output.dimension(1), sizeof(uint64));
-  for (int64 i = 0; i < output.dimension(0); ++i) {
-    const uint64 fingerprint =
-        Fingerprint64({reinterpret_cast<const char*>(&input(i, 0)),
-                       static_cast<std::size_t>(input.dimension(1))});
-    CopyToBuffer(fingerprint, &output(i, 0));
-  }
+  auto fingerprint_rows = [&](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      const uint64 fingerprint =
+          Fingerprint64({reinterpret_cast<const char*>(&input(i, 0)),
+                         static_cast<std::size_t>(input.dimension(1))});
+      CopyToBuffer(fingerprint, &output(i, 0));
+    }
+  };
+  auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        output.dimension(0), kStringFingerprintCost + input.dimension(1),
+        fingerprint_rows);
 }
 
-void FarmhashFingerprint64(TTypes<string>::ConstFlat input,
+void FarmhashFingerprint64(OpKernelContext* context,
+                           TTypes<string>::ConstFlat input,
                            TTypes<uint8, 2>::Matrix output) {
   DCHECK_EQ(output.dimension(0), input.dimension(0));
   DCHECK_EQ(output.dimension(1), sizeof(uint64));
-  for (int64 i = 0; i < input.dimension(0); ++i) {
-    const uint64 fingerprint =
-        Fingerprint64({input(i).data(), input(i).size()});
-    CopyToBuffer(fingerprint, &output(i, 0));
-  }
+  auto fingerprint_strings = [&](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      const uint64 fingerprint =
+          Fingerprint64({input(i).data(), input(i).size()});
+      CopyToBuffer(fingerprint, &output(i, 0));
+    }
+  };
+  auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        input.dimension(0), kStringFingerprintCost, fingerprint_strings);
 }
 
 class FingerprintOp : public OpKernel {
@@ -110,19 +127,23 @@ class FingerprintOp : public OpKernel {
         // and each row contains the fingerprint value of corresponding string.
         // To compute fingerprints of multiple strings, this op fingerprints the
         // buffer containing the string fingerprints.
-        FarmhashFingerprint64(input.flat<string>(), temp.tensor<uint8, 2>());
-        FarmhashFingerprint64(static_cast<const Tensor&>(temp).shaped<uint8, 2>(
-                                  {dim0, dim1 * kFingerprintSize}),
-                              output->matrix<uint8>());
+        FarmhashFingerprint64(context, input.flat<string>(),
+                              temp.tensor<uint8, 2>());
+        FarmhashFingerprint64(
+            context,
+            static_cast<const Tensor&>(temp).shaped<uint8, 2>(
+                {dim0, dim1 * kFingerprintSize}),
+            output->matrix<uint8>());
       } else {
         // In case dim1 == 1, each string computes into its own fingerprint
         // value. There is no need to fingerprint twice.
-        FarmhashFingerprint64(input.flat<string>(), output->matrix<uint8>());
+        FarmhashFingerprint64(context, input.flat<string>(),
+                              output->matrix<uint8>());
       }
     } else {
       auto data = input.bit_casted_shaped<uint8, 2>(
           {dim0, dim1 * DataTypeSize(input.dtype())});
-      FarmhashFingerprint64(data, output->matrix<uint8>());
+      FarmhashFingerprint64(context, data, output->matrix<uint8>());
     }
   }
 
@@ -26,6 +26,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -105,6 +107,30 @@ TEST_F(FingerprintOpTest, StringGoldenValue) {
             "\x0d\x9b\x7f\x63\x23\x14\x1c\xb8");
 }
 
+// Large inputs are fingerprinted on several threads, which must not change the
+// result.
+TEST_F(FingerprintOpTest, ManyStrings) {
+  const int64 num_strings = 100000;
+  Tensor data(DT_STRING, {num_strings});
+  auto buffer = data.flat<string>();
+  for (int64 i = 0; i < num_strings; ++i) {
+    buffer(i) = strings::StrCat("feature_", i);
+  }
+
+  TF_ASSERT_OK(MakeFingerprintOp(&data));
+  TF_ASSERT_OK(RunOpKernel());
+  ASSERT_EQ(GetOutput(0)->shape(), (TensorShape{num_strings, 8}));
+  const auto output = GetOutput(0)->matrix<uint8>();
+  for (int64 i = 0; i < num_strings; i += 997) {
+    // The fingerprints are stored in little-endian order.
+    uint64 fingerprint = 0;
+    for (int k = 0; k < 8; ++k) {
+      fingerprint |= static_cast<uint64>(output(i, k)) << (8 * k);
+    }
+    EXPECT_EQ(Fingerprint64(buffer(i)), fingerprint) << "at " << i;
+  }
+}
+
 TEST_F(FingerprintOpTest, Collision) {
   const TensorShape shape = {1, 2, 4, 6};
   for (DataType dtype : kRealNumberTypes) {
@@ -0,0 +1,159 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_attention_op.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+template <typename Device, typename T>
+class FusedScaledDotProductAttentionOp : public OpKernel {
+ public:
+  explicit FusedScaledDotProductAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+
+    const int rank = query.dims();
+    OP_REQUIRES(context, rank >= 3,
+                errors::InvalidArgument(
+                    "query must be at least 3-D, got shape ",
+                    query.shape().DebugString()));
+    OP_REQUIRES(context, key.dims() == rank && value.dims() == rank,
+                errors::InvalidArgument(
+                    "query, key and value must have the same rank, got shapes ",
+                    query.shape().DebugString(), ", ",
+                    key.shape().DebugString(), " and ",
+                    value.shape().DebugString()));
+    int64 batch = 1;
+    for (int i = 0; i < rank - 2; ++i) {
+      OP_REQUIRES(context,
+                  key.dim_size(i) == query.dim_size(i) &&
+                      value.dim_size(i) == query.dim_size(i),
+                  errors::InvalidArgument(
+                      "query, key and value must have the same batch "
+                      "dimensions, got shapes ",
+                      query.shape().DebugString(), ", ",
+                      key.shape().DebugString(), " and ",
+                      value.shape().DebugString()));
+      batch *= query.dim_size(i);
+    }
+    const int64 num_queries = query.dim_size(rank - 2);
+    const int64 depth = query.dim_size(rank - 1);
+    const int64 num_keys = key.dim_size(rank - 2);
+    const int64 value_depth = value.dim_size(rank - 1);
+    OP_REQUIRES(context, key.dim_size(rank - 1) == depth,
+                errors::InvalidArgument(
+                    "query and key must have the same depth, got shapes ",
+                    query.shape().DebugString(), " and ",
+                    key.shape().DebugString()));
+    OP_REQUIRES(context, value.dim_size(rank - 2) == num_keys,
+                errors::InvalidArgument(
+                    "key and value must have the same length, got shapes ",
+                    key.shape().DebugString(), " and ",
+                    value.shape().DebugString()));
+
+    TensorShape output_shape = query.shape();
+    output_shape.set_dim(rank - 1, value_depth);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+    if (num_keys == 0) {
+      // Attention over an empty sequence has no weights to normalize.
+      functor::SetZeroFunctor<Device, T>()(context->eigen_device<Device>(),
+                                           output->flat<T>());
+      return;
+    }
+
+    Tensor scores;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({batch, num_queries, num_keys}),
+                                &scores));
+
+    functor::FusedScaledDotProductAttention<Device, T>()(
+        context->eigen_device<Device>(),
+        query.shaped<T, 3>({batch, num_queries, depth}),
+        key.shaped<T, 3>({batch, num_keys, depth}),
+        value.shaped<T, 3>({batch, num_keys, value_depth}), scale_,
+        scores.tensor<T, 3>(),
+        output->shaped<T, 3>({batch, num_queries, value_depth}));
+  }
+
+ private:
+  float scale_;
+};
+
+#define REGISTER_KERNELS(type)                                   \
+  REGISTER_KERNEL_BUILDER(Name("_FusedScaledDotProductAttention") \
+                              .Device(DEVICE_CPU)                 \
+                              .TypeConstraint<type>("T"),         \
+                          FusedScaledDotProductAttentionOp<CPUDevice, type>);
+
+TF_CALL_half(REGISTER_KERNELS);
+TF_CALL_float(REGISTER_KERNELS);
+#undef REGISTER_KERNELS
+
+#if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
+    (defined(TENSORFLOW_USE_ROCM) && TENSORFLOW_USE_ROCM)
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                   \
+  template <>                                                                 \
+  void FusedScaledDotProductAttention<GPUDevice, T>::operator()(              \
+      const GPUDevice& d, typename TTypes<T, 3>::ConstTensor query,           \
+      typename TTypes<T, 3>::ConstTensor key,                                 \
+      typename TTypes<T, 3>::ConstTensor value, float scale,                  \
+      typename TTypes<T, 3>::Tensor scores,                                   \
+      typename TTypes<T, 3>::Tensor output);                                  \
+  extern template struct FusedScaledDotProductAttention<GPUDevice, T>;
+
+TF_CALL_half(DECLARE_GPU_SPEC);
+TF_CALL_float(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+// Registration of the GPU implementations.
+#define REGISTER_GPU_KERNELS(type)                                \
+  REGISTER_KERNEL_BUILDER(Name("_FusedScaledDotProductAttention") \
+                              .Device(DEVICE_GPU)                 \
+                              .TypeConstraint<type>("T"),         \
+                          FusedScaledDotProductAttentionOp<GPUDevice, type>);
+
+TF_CALL_half(REGISTER_GPU_KERNELS);
+TF_CALL_float(REGISTER_GPU_KERNELS);
+#undef REGISTER_GPU_KERNELS
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
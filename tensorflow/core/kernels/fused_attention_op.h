@@ -0,0 +1,91 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+// Functor definition for FusedScaledDotProductAttentionOp, must be compilable
+// by nvcc.
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/softmax_op_functor.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Functor used by FusedScaledDotProductAttentionOp to do the computations.
+template <typename Device, typename T>
+struct FusedScaledDotProductAttention {
+  // Computes softmax(query * key^T * scale) * value for every batch.
+  //
+  // query: dims: batch, num_queries, depth.
+  // key: dims: batch, num_keys, depth.
+  // value: dims: batch, num_keys, value_depth.
+  // scores: dims: batch, num_queries, num_keys, scratch space for the
+  //   attention weights.
+  // output: dims: batch, num_queries, value_depth.
+  void operator()(const Device& d, typename TTypes<T, 3>::ConstTensor query,
+                  typename TTypes<T, 3>::ConstTensor key,
+                  typename TTypes<T, 3>::ConstTensor value, float scale,
+                  typename TTypes<T, 3>::Tensor scores,
+                  typename TTypes<T, 3>::Tensor output) {
+    const Eigen::Index batch = query.dimension(0);
+    const Eigen::Index num_queries = query.dimension(1);
+    const Eigen::Index depth = query.dimension(2);
+    const Eigen::Index num_keys = key.dimension(1);
+    const Eigen::Index value_depth = value.dimension(2);
+
+    // query * key^T contracts the depth of both operands, and
+    // weights * value contracts the keys.
+    const Eigen::array<Eigen::IndexPair<Eigen::Index>, 1> query_key_dims = {
+        Eigen::IndexPair<Eigen::Index>(1, 1)};
+    const Eigen::array<Eigen::IndexPair<Eigen::Index>, 1> weights_value_dims =
+        {Eigen::IndexPair<Eigen::Index>(1, 0)};
+
+    for (Eigen::Index b = 0; b < batch; ++b) {
+      typename TTypes<T>::ConstMatrix query_b(
+          query.data() + b * num_queries * depth, num_queries, depth);
+      typename TTypes<T>::ConstMatrix key_b(key.data() + b * num_keys * depth,
+                                            num_keys, depth);
+      typename TTypes<T>::Matrix scores_b(
+          scores.data() + b * num_queries * num_keys, num_queries, num_keys);
+      scores_b.device(d) =
+          query_b.contract(key_b, query_key_dims) * static_cast<T>(scale);
+    }
+
+    typename TTypes<T>::Matrix weights(scores.data(), batch * num_queries,
+                                       num_keys);
+    SoftmaxEigenImpl<Device, T>::Compute(
+        d, typename TTypes<T>::ConstMatrix(weights.data(), batch * num_queries,
+                                           num_keys),
+        weights, /*log=*/false);
+
+    for (Eigen::Index b = 0; b < batch; ++b) {
+      typename TTypes<T>::ConstMatrix weights_b(
+          scores.data() + b * num_queries * num_keys, num_queries, num_keys);
+      typename TTypes<T>::ConstMatrix value_b(
+          value.data() + b * num_keys * value_depth, num_keys, value_depth);
+      typename TTypes<T>::Matrix output_b(
+          output.data() + b * num_queries * value_depth, num_queries,
+          value_depth);
+      output_b.device(d) = weights_b.contract(value_b, weights_value_dims);
+    }
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
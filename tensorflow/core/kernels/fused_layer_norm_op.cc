@@ -0,0 +1,129 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_layer_norm_op.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+template <typename Device, typename T>
+class FusedLayerNormOp : public OpKernel {
+ public:
+  using U = typename functor::LayerNormAccumulatorType<T>::type;
+
+  explicit FusedLayerNormOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& scale = context->input(1);
+    const Tensor& offset = context->input(2);
+
+    OP_REQUIRES(context, x.dims() >= 1,
+                errors::InvalidArgument("x must be at least 1-D, got shape ",
+                                        x.shape().DebugString()));
+    const int64 depth = x.dim_size(x.dims() - 1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(scale.shape()) &&
+                    scale.NumElements() == depth,
+                errors::InvalidArgument("scale must be a vector of size ",
+                                        depth, ", got shape ",
+                                        scale.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(offset.shape()) &&
+                    offset.NumElements() == depth,
+                errors::InvalidArgument("offset must be a vector of size ",
+                                        depth, ", got shape ",
+                                        offset.shape().DebugString()));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (x.NumElements() == 0) return;
+
+    const int64 rows = x.NumElements() / depth;
+    Tensor mean;
+    Tensor inv_std;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<U>::value,
+                                                   TensorShape({rows}), &mean));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<U>::value,
+                                          TensorShape({rows}), &inv_std));
+
+    functor::FusedLayerNorm<Device, T>()(
+        context->eigen_device<Device>(), x.flat_inner_dims<T>(),
+        scale.vec<T>(), offset.vec<T>(), epsilon_, mean.vec<U>(),
+        inv_std.vec<U>(), y->flat_inner_dims<T>());
+  }
+
+ private:
+  float epsilon_;
+};
+
+#define REGISTER_KERNELS(type)                                              \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_FusedLayerNorm").Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      FusedLayerNormOp<CPUDevice, type>);
+
+TF_CALL_half(REGISTER_KERNELS);
+TF_CALL_float(REGISTER_KERNELS);
+#undef REGISTER_KERNELS
+
+#if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
+    (defined(TENSORFLOW_USE_ROCM) && TENSORFLOW_USE_ROCM)
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                \
+  template <>                                                              \
+  void FusedLayerNorm<GPUDevice, T>::operator()(                           \
+      const GPUDevice& d, typename TTypes<T>::ConstMatrix x,               \
+      typename TTypes<T>::ConstVec scale,                                  \
+      typename TTypes<T>::ConstVec offset, float epsilon,                  \
+      typename TTypes<LayerNormAccumulatorType<T>::type>::Vec mean,        \
+      typename TTypes<LayerNormAccumulatorType<T>::type>::Vec inv_std,     \
+      typename TTypes<T>::Matrix y);                                       \
+  extern template struct FusedLayerNorm<GPUDevice, T>;
+
+TF_CALL_half(DECLARE_GPU_SPEC);
+TF_CALL_float(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+// Registration of the GPU implementations.
+#define REGISTER_GPU_KERNELS(type)                                          \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_FusedLayerNorm").Device(DEVICE_GPU).TypeConstraint<type>("T"), \
+      FusedLayerNormOp<GPUDevice, type>);
+
+TF_CALL_half(REGISTER_GPU_KERNELS);
+TF_CALL_float(REGISTER_GPU_KERNELS);
+#undef REGISTER_GPU_KERNELS
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
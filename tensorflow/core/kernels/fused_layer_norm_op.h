@@ -0,0 +1,82 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_LAYER_NORM_OP_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_LAYER_NORM_OP_H_
+// Functor definition for FusedLayerNormOp, must be compilable by nvcc.
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Type used to accumulate the mean and variance of a row. Half precision does
+// not have enough mantissa bits to sum a few thousand elements accurately.
+template <typename T>
+struct LayerNormAccumulatorType {
+  using type = T;
+};
+
+template <>
+struct LayerNormAccumulatorType<Eigen::half> {
+  using type = float;
+};
+
+// Functor used by FusedLayerNormOp to do the computations.
+template <typename Device, typename T>
+struct FusedLayerNorm {
+  using U = typename LayerNormAccumulatorType<T>::type;
+
+  // Normalizes every row of `x` and applies per-column scale and offset.
+  //
+  // x: dims: rows, depth.
+  // scale, offset: dims: depth.
+  // mean, inv_std: dims: rows, scratch space for the row statistics.
+  // y: dims: rows, depth.
+  void operator()(const Device& d, typename TTypes<T>::ConstMatrix x,
+                  typename TTypes<T>::ConstVec scale,
+                  typename TTypes<T>::ConstVec offset, float epsilon,
+                  typename TTypes<U>::Vec mean, typename TTypes<U>::Vec inv_std,
+                  typename TTypes<T>::Matrix y) {
+    const Eigen::Index rows = x.dimension(0);
+    const Eigen::Index depth = x.dimension(1);
+
+    Eigen::DSizes<Eigen::Index, 1> along_depth(1);
+    Eigen::DSizes<Eigen::Index, 2> rows_by_one(rows, 1);
+    Eigen::DSizes<Eigen::Index, 2> one_by_depth(1, depth);
+
+    auto x_u = x.template cast<U>();
+    auto centered = x_u - mean.reshape(rows_by_one).broadcast(one_by_depth);
+
+    mean.device(d) = x_u.sum(along_depth) / static_cast<U>(depth);
+    inv_std.device(d) =
+        (centered.square().sum(along_depth) / static_cast<U>(depth) +
+         static_cast<U>(epsilon))
+            .rsqrt();
+    y.device(d) =
+        (centered * inv_std.reshape(rows_by_one).broadcast(one_by_depth) *
+             scale.template cast<U>().reshape(one_by_depth).broadcast(
+                 rows_by_one) +
+         offset.template cast<U>().reshape(one_by_depth).broadcast(
+             rows_by_one))
+            .template cast<T>();
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_LAYER_NORM_OP_H_
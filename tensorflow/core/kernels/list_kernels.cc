@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/kernels/concat_lib.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/util/util.h"
@@ -38,6 +39,108 @@ namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+constexpr size_t TensorListTensors::Storage::kFirstChunkSize;
+constexpr int TensorListTensors::Storage::kMaxChunks;
+
+Tensor& TensorListTensors::Storage::at(size_t i) {
+  const int k = Log2Floor64(i / kFirstChunkSize + 1);
+  return chunks_[k][i - kFirstChunkSize * ((size_t{1} << k) - 1)];
+}
+
+bool TensorListTensors::Storage::TryAppend(size_t expected_size, Tensor* t) {
+  mutex_lock l(mu_);
+  if (size_ != expected_size) {
+    return false;
+  }
+  const int k = Log2Floor64(size_ / kFirstChunkSize + 1);
+  CHECK_LT(k, kMaxChunks);
+  if (chunks_[k] == nullptr) {
+    chunks_[k].reset(new Tensor[kFirstChunkSize << k]);
+  }
+  at(size_) = std::move(*t);
+  ++size_;
+  return true;
+}
+
+void TensorListTensors::Storage::Truncate(size_t n) {
+  mutex_lock l(mu_);
+  for (; size_ > n; --size_) {
+    at(size_ - 1) = Tensor();
+  }
+}
+
+TensorListTensors::TensorListTensors(const TensorListTensors& other)
+    : storage_(other.storage_), size_(other.size_) {
+  if (storage_ != nullptr) storage_->Ref();
+}
+
+TensorListTensors::TensorListTensors(TensorListTensors&& other)
+    : storage_(other.storage_), size_(other.size_) {
+  other.storage_ = nullptr;
+  other.size_ = 0;
+}
+
+TensorListTensors& TensorListTensors::operator=(
+    const TensorListTensors& other) {
+  if (other.storage_ != nullptr) other.storage_->Ref();
+  if (storage_ != nullptr) storage_->Unref();
+  storage_ = other.storage_;
+  size_ = other.size_;
+  return *this;
+}
+
+TensorListTensors& TensorListTensors::operator=(TensorListTensors&& other) {
+  if (this != &other) {
+    if (storage_ != nullptr) storage_->Unref();
+    storage_ = other.storage_;
+    size_ = other.size_;
+    other.storage_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+TensorListTensors::~TensorListTensors() {
+  if (storage_ != nullptr) storage_->Unref();
+}
+
+void TensorListTensors::MakeUnique() {
+  if (storage_ == nullptr) {
+    storage_ = new Storage;
+  } else if (storage_->RefCountIsOne()) {
+    storage_->Truncate(size_);
+  } else {
+    Storage* storage = new Storage;
+    for (size_t i = 0; i < size_; ++i) {
+      Tensor t = storage_->at(i);
+      storage->TryAppend(i, &t);
+    }
+    storage_->Unref();
+    storage_ = storage;
+  }
+}
+
+void TensorListTensors::push_back(Tensor t) {
+  // Appending to shared storage only succeeds if no other copy has appended
+  // to it since this list was copied.
+  if (storage_ == nullptr || !storage_->TryAppend(size_, &t)) {
+    MakeUnique();
+    CHECK(storage_->TryAppend(size_, &t));
+  }
+  ++size_;
+}
+
+void TensorListTensors::resize(size_t n, const Tensor& t) {
+  if (n < size_) {
+    size_ = n;
+    // Release the dropped tensors unless another copy may still see them.
+    if (storage_->RefCountIsOne()) storage_->Truncate(n);
+  }
+  while (size_ < n) {
+    push_back(t);
+  }
+}
+
 // Variant compatible type for a list of tensors. This is mutable but instances
 // should never be mutated after stored in a variant tensor.
 TensorList::TensorList(const TensorList& other)
@@ -207,7 +310,7 @@ Status ForwardInputOrCreateNewList(OpKernelContext* c, int32 input_index,
     c->set_output(output_index, *output_tensor);
   } else {
     // If forwarding is not possible allocate a new output tensor and copy
-    // the `input_list` to it.
+    // the `input_list` to it. The copy shares the tensors of `input_list`.
     AllocatorAttributes attr;
     attr.set_on_host(true);
     TF_RETURN_IF_ERROR(
@@ -439,22 +542,11 @@ class TensorListResize : public OpKernel {
       AllocatorAttributes attr;
       attr.set_on_host(true);
       OP_REQUIRES_OK(c, c->allocate_output(0, TensorShape{}, &result, attr));
-      TensorList output_list;
-      output_list.element_shape = input_list->element_shape;
-      output_list.element_dtype = input_list->element_dtype;
-      output_list.max_num_elements = input_list->max_num_elements;
-      if (size > input_list->tensors.size()) {
-        output_list.tensors.insert(output_list.tensors.begin(),
-                                   input_list->tensors.begin(),
-                                   input_list->tensors.end());
-        // Add DT_INVALID tensors to the end of the list if the requested size
-        // is larger than the list length.
-        output_list.tensors.resize(size, Tensor(DT_INVALID));
-      } else {
-        output_list.tensors.insert(output_list.tensors.begin(),
-                                   input_list->tensors.begin(),
-                                   input_list->tensors.begin() + size);
-      }
+      // The copy shares the tensors of `input_list`.
+      TensorList output_list(*input_list);
+      // Add DT_INVALID tensors to the end of the list if the requested size
+      // is larger than the list length.
+      output_list.tensors.resize(size, Tensor(DT_INVALID));
       result->scalar<Variant>()() = std::move(output_list);
     }
   }
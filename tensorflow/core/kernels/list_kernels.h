@@ -20,6 +20,9 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <iterator>
+#include <memory>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -31,7 +34,10 @@ limitations under the License.
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/tensor_ops_util.h"
 #include "tensorflow/core/util/util.h"
 
@@ -39,6 +45,124 @@ namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+// The tensors of a TensorList, with the interface of a std::vector<Tensor>.
+//
+// Copies share their storage, so that copying a list, as the list kernels do
+// when they cannot forward their input list, takes constant time. The storage
+// only ever grows, in chunks that never move, and every copy sees a prefix of
+// it. Appending to a copy therefore takes amortized constant time as long as
+// no other copy has appended since, and shrinking a copy never copies the
+// tensors. Any other change to shared storage copies the tensors first.
+//
+// Like a std::vector, an instance must not be read while another thread
+// changes it, but different copies can be used from different threads.
+class TensorListTensors {
+ public:
+  typedef Tensor value_type;
+  typedef size_t size_type;
+
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Tensor value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Tensor* pointer;
+    typedef const Tensor& reference;
+
+    const_iterator(const TensorListTensors* tensors, size_t index)
+        : tensors_(tensors), index_(index) {}
+
+    const Tensor& operator*() const { return (*tensors_)[index_]; }
+    const Tensor* operator->() const { return &(*tensors_)[index_]; }
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      return const_iterator(tensors_, index_++);
+    }
+    bool operator==(const const_iterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return index_ != other.index_;
+    }
+
+   private:
+    const TensorListTensors* tensors_;
+    size_t index_;
+  };
+
+  TensorListTensors() {}
+  TensorListTensors(const TensorListTensors& other);
+  TensorListTensors(TensorListTensors&& other);
+  TensorListTensors& operator=(const TensorListTensors& other);
+  TensorListTensors& operator=(TensorListTensors&& other);
+  ~TensorListTensors();
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const Tensor& operator[](size_t i) const {
+    DCHECK_LT(i, size_);
+    return storage_->at(i);
+  }
+  const Tensor& at(size_t i) const {
+    CHECK_LT(i, size_);
+    return storage_->at(i);
+  }
+  const Tensor& back() const { return (*this)[size_ - 1]; }
+
+  // The mutable accessors copy shared tensors first.
+  Tensor& operator[](size_t i) {
+    DCHECK_LT(i, size_);
+    MakeUnique();
+    return storage_->at(i);
+  }
+  Tensor& back() { return (*this)[size_ - 1]; }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+  void push_back(Tensor t);
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    push_back(Tensor(std::forward<Args>(args)...));
+  }
+  void pop_back() { resize(size_ - 1); }
+  void resize(size_t n, const Tensor& t = Tensor());
+  // The storage grows geometrically, so this is a no-op.
+  void reserve(size_t n) {}
+
+ private:
+  // Tensor i lives in chunk k = log2(i / kFirstChunkSize + 1), which holds
+  // kFirstChunkSize << k tensors.
+  class Storage : public core::RefCounted {
+   public:
+    static constexpr size_t kFirstChunkSize = 16;
+    static constexpr int kMaxChunks = 48;
+
+    Tensor& at(size_t i);
+
+    // Appends 't' if the storage holds exactly 'expected_size' tensors.
+    bool TryAppend(size_t expected_size, Tensor* t);
+
+    // Releases the tensors from index 'n' on.
+    void Truncate(size_t n);
+
+   private:
+    mutex mu_;
+    size_t size_ GUARDED_BY(mu_) = 0;
+    std::unique_ptr<Tensor[]> chunks_[kMaxChunks];
+  };
+
+  // Gives this list storage of its own that holds exactly its tensors.
+  void MakeUnique();
+
+  Storage* storage_ = nullptr;
+  size_t size_ = 0;
+};
+
 // Variant compatible type for a list of tensors. This is mutable but instances
 // should never be mutated after stored in a variant tensor.
 struct TensorList {
@@ -56,7 +180,7 @@ struct TensorList {
   // TODO(apassos) fill this out
   string DebugString() const { return "TensorList"; }
 
-  std::vector<Tensor> tensors;
+  TensorListTensors tensors;
   PartialTensorShape element_shape;
   DataType element_dtype;
   // The maximum allowed size of `tensors`. Defaults to -1 meaning that the size
@@ -138,9 +138,12 @@ class InitializeTableFromTextFileOp : public OpKernel {
     if (ctx->track_allocations()) {
       memory_used_before = table->MemoryUsed();
     }
-    OP_REQUIRES_OK(ctx, lookup::InitializeTableFromTextFile(
-                            vocab_filename, vocab_size_, delimiter_, key_index_,
-                            value_index_, ctx->env(), table));
+    OP_REQUIRES_OK(
+        ctx, lookup::InitializeTableFromTextFile(
+                 vocab_filename, vocab_size_, delimiter_, key_index_,
+                 value_index_, ctx->env(),
+                 ctx->device()->tensorflow_cpu_worker_threads()->workers,
+                 table));
     if (ctx->track_allocations()) {
       ctx->record_persistent_memory_allocation(table->MemoryUsed() -
                                                memory_used_before);
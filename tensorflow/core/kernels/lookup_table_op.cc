@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -30,12 +31,31 @@ limitations under the License.
 namespace tensorflow {
 namespace lookup {
 
+namespace {
+
+// Hash used to pick the shard of a key. It must not be correlated with the
+// hash of std::unordered_map, which is the identity for integral keys.
+template <typename T>
+inline uint64 ShardHash(const T& key) {
+  return Hash64(reinterpret_cast<const char*>(&key), sizeof(key));
+}
+
+inline uint64 ShardHash(const string& key) { return Hash64(key); }
+
+}  // namespace
+
 // Lookup table that wraps an unordered_map, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
 //
+// The table can be split into `num_shards` unordered_maps, each guarded by its
+// own mutex. Keys are assigned to shards by hash, so that Find and Insert calls
+// running concurrently on different inter-op threads mostly take different
+// locks. Each call groups its keys by shard and locks every shard it touches
+// once.
+//
 // Sample use case:
 //
 // MutableHashTableOfScalars<int64, int64> table;  // int64 -> int64.
@@ -47,11 +67,26 @@ namespace lookup {
 template <class K, class V>
 class MutableHashTableOfScalars final : public LookupInterface {
  public:
-  MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
+  MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {
+    int64 num_shards = 1;
+    // Only MutableHashTableV2 has the attr.
+    if (HasNodeAttr(kernel->def(), "num_shards")) {
+      OP_REQUIRES_OK(ctx,
+                     GetNodeAttr(kernel->def(), "num_shards", &num_shards));
+    }
+    OP_REQUIRES(ctx, num_shards >= 1,
+                errors::InvalidArgument("num_shards must be at least 1, got: ",
+                                        num_shards));
+    shards_ = std::vector<Shard>(num_shards);
+  }
 
   size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      size += shard.table.size();
+    }
+    return size;
   }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
@@ -60,12 +95,30 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
+    if (num_shards() == 1) {
+      const Shard& shard = shards_[0];
+      tf_shared_lock l(shard.mu);
+      for (int64 i = 0; i < key_values.size(); ++i) {
+        value_values(i) = gtl::FindWithDefault(
+            shard.table, SubtleMustCopyIfIntegral(key_values(i)), default_val);
+      }
+      return Status::OK();
     }
 
+    std::vector<K> keys;
+    std::vector<int64> order;
+    std::vector<int64> shard_starts;
+    PartitionByShard(key_values, &keys, &order, &shard_starts);
+    for (int s = 0; s < num_shards(); ++s) {
+      if (shard_starts[s] == shard_starts[s + 1]) continue;
+      const Shard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64 j = shard_starts[s]; j < shard_starts[s + 1]; ++j) {
+        const int64 i = order[j];
+        value_values(i) =
+            gtl::FindWithDefault(shard.table, keys[i], default_val);
+      }
+    }
     return Status::OK();
   }
 
@@ -73,13 +126,48 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
     if (clear) {
-      table_.clear();
+      // Imports replace the whole table at once, so hold all the shards.
+      std::vector<mutex_lock> locks;
+      locks.reserve(num_shards());
+      for (Shard& shard : shards_) {
+        locks.emplace_back(shard.mu);
+        shard.table.clear();
+      }
+      for (int64 i = 0; i < key_values.size(); ++i) {
+        const K key = SubtleMustCopyIfIntegral(key_values(i));
+        gtl::InsertOrUpdate(&shards_[ShardIndex(key)].table, key,
+                            SubtleMustCopyIfIntegral(value_values(i)));
+      }
+      return Status::OK();
     }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          SubtleMustCopyIfIntegral(value_values(i)));
+
+    if (num_shards() == 1) {
+      Shard& shard = shards_[0];
+      mutex_lock l(shard.mu);
+      for (int64 i = 0; i < key_values.size(); ++i) {
+        gtl::InsertOrUpdate(&shard.table,
+                            SubtleMustCopyIfIntegral(key_values(i)),
+                            SubtleMustCopyIfIntegral(value_values(i)));
+      }
+      return Status::OK();
+    }
+
+    std::vector<K> key_copies;
+    std::vector<int64> order;
+    std::vector<int64> shard_starts;
+    PartitionByShard(key_values, &key_copies, &order, &shard_starts);
+    for (int s = 0; s < num_shards(); ++s) {
+      if (shard_starts[s] == shard_starts[s + 1]) continue;
+      Shard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      // `order` keeps the keys of a shard in input order, so the last value
+      // of a duplicated key wins like in the unsharded table.
+      for (int64 j = shard_starts[s]; j < shard_starts[s + 1]; ++j) {
+        const int64 i = order[j];
+        gtl::InsertOrUpdate(&shard.table, key_copies[i],
+                            SubtleMustCopyIfIntegral(value_values(i)));
+      }
     }
     return Status::OK();
   }
@@ -92,9 +180,26 @@ class MutableHashTableOfScalars final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
+    if (num_shards() == 1) {
+      Shard& shard = shards_[0];
+      mutex_lock l(shard.mu);
+      for (int64 i = 0; i < key_values.size(); ++i) {
+        shard.table.erase(SubtleMustCopyIfIntegral(key_values(i)));
+      }
+      return Status::OK();
+    }
+
+    std::vector<K> key_copies;
+    std::vector<int64> order;
+    std::vector<int64> shard_starts;
+    PartitionByShard(key_values, &key_copies, &order, &shard_starts);
+    for (int s = 0; s < num_shards(); ++s) {
+      if (shard_starts[s] == shard_starts[s + 1]) continue;
+      Shard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      for (int64 j = shard_starts[s]; j < shard_starts[s + 1]; ++j) {
+        shard.table.erase(key_copies[order[j]]);
+      }
     }
     return Status::OK();
   }
@@ -105,8 +210,14 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
+    // Hold all the shards so that the export is a consistent snapshot.
+    std::vector<tf_shared_lock> locks;
+    locks.reserve(num_shards());
+    int64 size = 0;
+    for (const Shard& shard : shards_) {
+      locks.emplace_back(shard.mu);
+      size += shard.table.size();
+    }
 
     Tensor* keys;
     Tensor* values;
@@ -118,9 +229,11 @@ class MutableHashTableOfScalars final : public LookupInterface {
     auto keys_data = keys->flat<K>();
     auto values_data = values->flat<V>();
     int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
+    for (const Shard& shard : shards_) {
+      for (auto it = shard.table.begin(); it != shard.table.end(); ++it, ++i) {
+        keys_data(i) = it->first;
+        values_data(i) = it->second;
+      }
     }
     return Status::OK();
   }
@@ -135,21 +248,58 @@ class MutableHashTableOfScalars final : public LookupInterface {
 
   int64 MemoryUsed() const override {
     int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      for (unsigned i = 0; i < shard.table.bucket_count(); ++i) {
+        size_t bucket_size = shard.table.bucket_size(i);
+        if (bucket_size == 0) {
+          ret++;
+        } else {
+          ret += bucket_size;
+        }
       }
     }
-    return sizeof(MutableHashTableOfScalars) + ret;
+    return sizeof(MutableHashTableOfScalars) + num_shards() * sizeof(Shard) +
+           ret;
   }
 
  private:
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ GUARDED_BY(mu_);
+  struct Shard {
+    mutable mutex mu;
+    std::unordered_map<K, V> table GUARDED_BY(mu);
+  };
+
+  int num_shards() const { return shards_.size(); }
+
+  int ShardIndex(const K& key) const { return ShardHash(key) % num_shards(); }
+
+  // Copies the keys into `keys` and sorts their indices by shard into
+  // `order`, keeping the input order within each shard. The indices of shard
+  // s are order[shard_starts[s]] to order[shard_starts[s + 1] - 1].
+  void PartitionByShard(typename TTypes<K>::ConstFlat key_values,
+                        std::vector<K>* keys, std::vector<int64>* order,
+                        std::vector<int64>* shard_starts) const {
+    const int64 num_keys = key_values.size();
+    std::vector<int> shard_of(num_keys);
+    shard_starts->assign(num_shards() + 1, 0);
+    keys->reserve(num_keys);
+    for (int64 i = 0; i < num_keys; ++i) {
+      keys->push_back(SubtleMustCopyIfIntegral(key_values(i)));
+      shard_of[i] = ShardIndex(keys->back());
+      ++(*shard_starts)[shard_of[i] + 1];
+    }
+    for (int s = 0; s < num_shards(); ++s) {
+      (*shard_starts)[s + 1] += (*shard_starts)[s];
+    }
+    std::vector<int64> next(shard_starts->begin(), shard_starts->end() - 1);
+    order->resize(num_keys);
+    for (int64 i = 0; i < num_keys; ++i) {
+      (*order)[next[shard_of[i]]++] = i;
+    }
+  }
+
+  // Sized once at construction; the shards are never added or removed.
+  std::vector<Shard> shards_;
 };
 
 // Lookup table that wraps an unordered_map. Behaves identical to
@@ -15,10 +15,17 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/lookup_util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_split.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/errors.h"
-#include "tensorflow/core/lib/io/inputbuffer.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -28,29 +35,42 @@ static const int kInputBufferSize = 1 * 1024 * 1024; /* bytes */
 static const int kLineNumber = -1;
 static const int kWholeLine = -2;
 
+// The number of lines parsed and inserted into the table at a time.
+static const int64 kLinesPerBatch = 64 * 1024;
+
 Status GetNumLinesInTextFile(Env* env, const string& vocab_file,
                              int64* num_lines) {
   std::unique_ptr<RandomAccessFile> file;
   TF_RETURN_IF_ERROR(env->NewRandomAccessFile(vocab_file, &file));
 
-  io::InputBuffer input_buffer(file.get(), kInputBufferSize);
-  string line;
-  Status s = input_buffer.ReadLine(&line);
+  // Counts the newlines, plus a last line without one unless it is only a
+  // '\r', without copying the lines out.
+  std::unique_ptr<char[]> scratch(new char[kInputBufferSize]);
+  uint64 offset = 0;
   int64 next_id = 0;
-  while (s.ok()) {
+  char last_chars[2] = {'\n', '\n'};
+  Status s;
+  do {
+    StringPiece data;
+    s = file->Read(offset, kInputBufferSize, &data, scratch.get());
+    if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+    if (data.empty()) break;
+    next_id += std::count(data.begin(), data.end(), '\n');
+    last_chars[0] = data.size() > 1 ? data[data.size() - 2] : last_chars[1];
+    last_chars[1] = data.back();
+    offset += data.size();
+  } while (s.ok());
+  if (last_chars[1] != '\n' &&
+      !(last_chars[1] == '\r' && last_chars[0] == '\n')) {
     next_id++;
-    s = input_buffer.ReadLine(&line);
-  }
-  if (!errors::IsOutOfRange(s)) {
-    return s;
   }
   *num_lines = next_id;
   return Status::OK();
 }
 
-// Iterator that reads a text file. Each iteration process one line, it parses
-// the line and populates the keys and values tensors used for initialization
-// with a single key and corresponding value.
+// Iterator that reads a text file. Each iteration processes a batch of up to
+// kLinesPerBatch lines: it parses them and populates the keys and values
+// tensors used for initialization with one key and value per line.
 //
 // What information of the line to populate the key or values is specified by
 // providing key_index and value_index.
@@ -72,25 +92,29 @@ class TextFileLineIterator
   // - Index -1 means the line number stored in int64.
   // - Index >= 0 represent index (starting at zero) of the split line based on
   //   delimiter.
+  //
+  // If 'thread_pool' is not null, the lines of each batch are parsed on it.
   Status Init(const string& filename, int64 vocab_size, char delimiter,
               DataType key_dtype, int64 key_index, DataType value_dtype,
-              int64 value_index, Env* env) {
+              int64 value_index, Env* env, thread::ThreadPool* thread_pool) {
     filename_ = filename;
     vocab_size_ = vocab_size;
     delimiter_ = delimiter;
-    key_ = Tensor(key_dtype, TensorShape({}));
-    value_ = Tensor(value_dtype, TensorShape({}));
+    key_dtype_ = key_dtype;
+    value_dtype_ = value_dtype;
     key_index_ = key_index;
     value_index_ = value_index;
     env_ = env;
+    thread_pool_ = thread_pool;
 
     status_ = env->NewRandomAccessFile(filename_, &file_);
     if (!status_.ok()) return status_;
 
-    input_buffer_.reset(new io::InputBuffer(file_.get(), kInputBufferSize));
     valid_ = true;
     next_id_ = 0;
-    ignore_split_ = std::max(key_index_, value_index_) < 0;
+    file_offset_ = 0;
+    buffer_pos_ = 0;
+    end_of_file_ = false;
     Next();
     return status_;
   }
@@ -98,14 +122,24 @@ class TextFileLineIterator
   void Next() override {
     if (!valid_) return;
 
-    string line;
-    status_ = input_buffer_->ReadLine(&line);
+    int64 max_lines = kLinesPerBatch;
+    if (vocab_size_ != -1) {
+      max_lines = std::min(max_lines, vocab_size_ - next_id_);
+    }
+    std::vector<StringPiece> lines;
+    status_ = ReadLines(std::max<int64>(max_lines, 1), &lines);
     if (!status_.ok()) {
-      if (errors::IsOutOfRange(status_) && vocab_size_ != -1 &&
-          next_id_ != vocab_size_) {
+      valid_ = false;
+      return;
+    }
+    if (lines.empty()) {
+      if (vocab_size_ != -1 && next_id_ != vocab_size_) {
         status_ = errors::InvalidArgument("Invalid vocab_size in ", filename_,
                                           ": expected ", vocab_size_,
                                           " but got ", next_id_);
+      } else {
+        status_ = errors::OutOfRange("Finished reading ", next_id_,
+                                     " lines from ", filename_);
       }
       valid_ = false;
       return;
@@ -119,38 +153,41 @@ class TextFileLineIterator
       valid_ = false;
       return;
     }
-    if (line.empty()) {
-      status_ = errors::InvalidArgument("Invalid content in ", filename_,
-                                        ": empty line found at position ",
-                                        input_buffer_->Tell(), ".");
-      valid_ = false;
-      return;
-    }
 
-    std::vector<string> tokens;
-    if (!ignore_split_) {
-      tokens = str_util::Split(line, delimiter_);
-      if (std::max(key_index_, value_index_) >= tokens.size()) {
-        status_ = errors::InvalidArgument(
-            "Invalid number of columns in ", filename_, " line ", next_id_,
-            " (", line, ") : expected ", std::max(key_index_, value_index_),
-            " got ", tokens.size());
-        valid_ = false;
-        return;
+    const int64 num_lines = lines.size();
+    key_ = Tensor(key_dtype_, TensorShape({num_lines}));
+    value_ = Tensor(value_dtype_, TensorShape({num_lines}));
+    // The error of the first line that failed to parse, if any.
+    mutex mu;
+    int64 first_error_line = num_lines;
+    Status first_error;
+    auto parse_lines = [&](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        Status s = ParseLine(lines[i], next_id_ + i, i);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < first_error_line) {
+            first_error_line = i;
+            first_error = s;
+          }
+          return;
+        }
       }
+    };
+    if (thread_pool_ != nullptr) {
+      // Assume each line costs about as much as a short string copy.
+      thread_pool_->ParallelFor(num_lines, /*cost_per_unit=*/1000,
+                                parse_lines);
+    } else {
+      parse_lines(0, num_lines);
     }
-    status_ = SetValue(line, tokens, key_index_, &key_);
-    if (!status_.ok()) {
-      valid_ = false;
-      return;
-    }
-    status_ = SetValue(line, tokens, value_index_, &value_);
-    if (!status_.ok()) {
+    if (!first_error.ok()) {
+      status_ = first_error;
       valid_ = false;
       return;
     }
 
-    next_id_++;
+    next_id_ += num_lines;
   }
 
   bool Valid() const override { return valid_; }
@@ -178,70 +215,146 @@ class TextFileLineIterator
   Tensor key_;
   Tensor value_;
   bool valid_;  // true if the iterator points to an existing range.
+  DataType key_dtype_;
+  DataType value_dtype_;
   int64 key_index_;
   int64 value_index_;
   Env* env_;
+  thread::ThreadPool* thread_pool_;
   int64 next_id_;
   int64 vocab_size_;
   string filename_;
   char delimiter_;
   Status status_;
-  bool ignore_split_;
-  std::unique_ptr<RandomAccessFile> file_;  // must outlive input_buffer_
-  std::unique_ptr<io::InputBuffer> input_buffer_;
-
-  // Set the corresponding value from line or tokens based on 'index' into the
-  // tensor 't'. The value is transformed to the given data type 'dtype'.
-  Status SetValue(const string& line, const std::vector<string>& tokens,
-                  int64 index, Tensor* tensor) {
+  std::unique_ptr<RandomAccessFile> file_;
+
+  // The part of the file read but not returned by ReadLines yet starts at
+  // buffer_pos_ in buffer_. file_offset_ is where the next read starts.
+  string buffer_;
+  size_t buffer_pos_;
+  uint64 file_offset_;
+  bool end_of_file_;
+
+  // Reads up to 'max_lines' lines, without their line endings. The lines
+  // point into buffer_, and stay valid until the next call.
+  Status ReadLines(int64 max_lines, std::vector<StringPiece>* lines) {
+    buffer_.erase(0, buffer_pos_);
+    buffer_pos_ = 0;
+    std::vector<std::pair<size_t, size_t>> line_ranges;
+    size_t line_begin = 0;
+    while (static_cast<int64>(line_ranges.size()) < max_lines) {
+      const size_t newline = buffer_.find('\n', line_begin);
+      if (newline != string::npos) {
+        line_ranges.emplace_back(line_begin, newline);
+        line_begin = newline + 1;
+        continue;
+      }
+      if (end_of_file_) {
+        // A last line without a newline, unless it is empty.
+        if (line_begin < buffer_.size() &&
+            !(buffer_.size() - line_begin == 1 && buffer_.back() == '\r')) {
+          line_ranges.emplace_back(line_begin, buffer_.size());
+        }
+        line_begin = buffer_.size();
+        break;
+      }
+      const size_t old_size = buffer_.size();
+      buffer_.resize(old_size + kInputBufferSize);
+      StringPiece data;
+      char* scratch = &buffer_[old_size];
+      Status s = file_->Read(file_offset_, kInputBufferSize, &data, scratch);
+      if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+      if (data.data() != scratch) {
+        memmove(scratch, data.data(), data.size());
+      }
+      buffer_.resize(old_size + data.size());
+      file_offset_ += data.size();
+      end_of_file_ = !s.ok() || data.empty();
+    }
+    buffer_pos_ = line_begin;
+
+    lines->reserve(line_ranges.size());
+    for (const auto& range : line_ranges) {
+      size_t end = range.second;
+      if (end > range.first && buffer_[end - 1] == '\r') --end;
+      lines->emplace_back(buffer_.data() + range.first, end - range.first);
+    }
+    return Status::OK();
+  }
+
+  // Parses line number 'line_number' of the file into row 'row' of key_ and
+  // value_.
+  Status ParseLine(StringPiece line, int64 line_number, int64 row) {
+    if (line.empty()) {
+      return errors::InvalidArgument("Invalid content in ", filename_,
+                                     ": empty line found at line ",
+                                     line_number, ".");
+    }
+    std::vector<StringPiece> tokens;
+    if (std::max(key_index_, value_index_) >= 0) {
+      tokens = absl::StrSplit(line, delimiter_);
+      if (std::max(key_index_, value_index_) >= tokens.size()) {
+        return errors::InvalidArgument(
+            "Invalid number of columns in ", filename_, " line ", line_number,
+            " (", line, ") : expected ", std::max(key_index_, value_index_),
+            " got ", tokens.size());
+      }
+    }
+    TF_RETURN_IF_ERROR(
+        SetValue(line, tokens, key_index_, line_number, row, &key_));
+    return SetValue(line, tokens, value_index_, line_number, row, &value_);
+  }
+
+  // Set the corresponding value from line or tokens based on 'index' into row
+  // 'row' of the tensor 't'. The value is transformed to the given data type
+  // 'dtype'.
+  static Status SetValue(StringPiece line,
+                         const std::vector<StringPiece>& tokens, int64 index,
+                         int64 line_number, int64 row, Tensor* tensor) {
     if (index == kLineNumber) {
-      tensor->flat<int64>()(0) = next_id_;
+      tensor->flat<int64>()(row) = line_number;
       return Status::OK();
     }
-    const string& token = (index == kWholeLine) ? line : tokens[index];
+    const StringPiece token = (index == kWholeLine) ? line : tokens[index];
     const DataType& dtype = tensor->dtype();
     switch (dtype) {
       case DT_INT32: {
         int32 value;
-        if (!strings::safe_strto32(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
-                                         " is not a valid int32.");
+        if (!strings::safe_strto32(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ",
+                                         line_number, " is not a valid int32.");
         }
-        tensor->flat<int32>()(0) = value;
+        tensor->flat<int32>()(row) = value;
       } break;
       case DT_INT64: {
         int64 value;
-        if (!strings::safe_strto64(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
-                                         " is not a valid int64.");
+        if (!strings::safe_strto64(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ",
+                                         line_number, " is not a valid int64.");
         }
-        tensor->flat<int64>()(0) = value;
+        tensor->flat<int64>()(row) = value;
       } break;
       case DT_FLOAT: {
         float value;
-        if (!strings::safe_strtof(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
-                                         " is not a valid float.");
+        if (!strings::safe_strtof(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ",
+                                         line_number, " is not a valid float.");
         }
-        tensor->flat<float>()(0) = value;
+        tensor->flat<float>()(row) = value;
       } break;
       case DT_DOUBLE: {
         double value;
-        if (!strings::safe_strtod(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+        if (!strings::safe_strtod(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ",
+                                         line_number,
                                          " is not a valid double.");
         }
-        tensor->flat<double>()(0) = value;
+        tensor->flat<double>()(row) = value;
       } break;
       case DT_STRING:
-        tensor->flat<string>()(0) = token;
+        tensor->flat<string>()(row) = string(token);
         break;
       default:
-        valid_ = false;
         return errors::InvalidArgument("Data type ", DataTypeString(dtype),
                                        " not supported.");
     }
@@ -340,6 +453,16 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
                                    char delimiter, int32 key_index,
                                    int32 value_index, Env* env,
                                    InitializableLookupTable* table) {
+  return InitializeTableFromTextFile(filename, vocab_size, delimiter, key_index,
+                                     value_index, env, /*thread_pool=*/nullptr,
+                                     table);
+}
+
+Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
+                                   char delimiter, int32 key_index,
+                                   int32 value_index, Env* env,
+                                   thread::ThreadPool* thread_pool,
+                                   InitializableLookupTable* table) {
   if (key_index == kLineNumber && table->key_dtype() != DT_INT64) {
     return errors::InvalidArgument(
         "Key index for line number requires table key dtype of int64, got ",
@@ -366,7 +489,8 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
 
   TextFileLineIterator iter;
   TF_RETURN_IF_ERROR(iter.Init(filename, vocab_size, delimiter, key_dtype,
-                               key_index, value_dtype, value_index, env));
+                               key_index, value_dtype, value_index, env,
+                               thread_pool));
   // For initialization from files, ignore if the table is already
   // initialized. The table shared name should contain the filename to
   // avoid trying to initialize the same table from the same file at the same
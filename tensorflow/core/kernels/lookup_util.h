@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -46,6 +47,13 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
                                    int32 value_index, Env* env,
                                    InitializableLookupTable* table);
 
+// Same as above, but parses the lines of the file on thread_pool.
+Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
+                                   char delimiter, int32 key_index,
+                                   int32 value_index, Env* env,
+                                   thread::ThreadPool* thread_pool,
+                                   InitializableLookupTable* table);
+
 }  // namespace lookup
 }  // namespace tensorflow
 
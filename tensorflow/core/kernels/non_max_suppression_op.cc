@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -288,70 +289,66 @@ void BatchedNonMaxSuppressionOp(
     int num_boxes, const int max_size_per_class, const int total_size_per_batch,
     const float score_threshold, const float iou_threshold,
     bool pad_per_class = false, bool clip_boxes = true) {
-  int q = inp_boxes.dim_size(2);
-  int num_classes = inp_scores.dim_size(2);
+  const int q = inp_boxes.dim_size(2);
+  const int num_classes = inp_scores.dim_size(2);
   const int num_batches = inp_boxes.dim_size(0);
 
-  // [num_batches, per_batch_size * 4]
-  std::vector<std::vector<float>> nmsed_boxes(num_batches);
-  // [num_batches, per_batch_size]
-  std::vector<std::vector<float>> nmsed_scores(num_batches);
-  // [num_batches, per_batch_size]
-  std::vector<std::vector<float>> nmsed_classes(num_batches);
-  // [num_batches]
-  std::vector<int> final_valid_detections;
-
-  int per_batch_size = total_size_per_batch;
-
-  // perform non_max_suppression operation for each batch independently
-  for (int batch = 0; batch < num_batches; ++batch) {
-    // dims of per_batch_boxes [num_boxes, q, 4]
-    Tensor per_batch_boxes = inp_boxes.Slice(batch, batch + 1);
-    // dims of per_batch_scores [num_boxes, num_classes]
-    Tensor per_batch_scores = inp_scores.Slice(batch, batch + 1);
-
-    struct ResultCandidate {
-      int box_index;
-      float score;
-      int class_idx;
-      float box_coord[4];
-    };
-
-    std::vector<ResultCandidate> result_candidate_vec;
-
-    float* scores_data = per_batch_scores.unaligned_flat<float>().data();
-    float* boxes_data = per_batch_boxes.unaligned_flat<float>().data();
-
-    // Iterate through all classes
-    for (int class_idx = 0; class_idx < num_classes; ++class_idx) {
-      std::vector<float> class_scores_data;
-      class_scores_data.reserve(num_boxes);
-      std::vector<float> class_boxes_data;
-      class_boxes_data.reserve(num_boxes * 4);
-
-      for (int box = 0; box < num_boxes; ++box) {
-        // Get the scores per class
-        // class_scores_data dim is [num_boxes].
-        class_scores_data.push_back(scores_data[box * num_classes + class_idx]);
-        for (int cid = 0; cid < 4; ++cid) {
-          if (q > 1) {
-            // Get the boxes per class. class_boxes_data dims is [num_boxes, 4]
-            class_boxes_data.push_back(
-                boxes_data[(box * q + class_idx) * 4 + cid]);
-          } else {
-            class_boxes_data.push_back(boxes_data[box * 4 + cid]);
-          }
-        }
-      }
+  // If pad_per_class is false, we always pad to max_total_size
+  const int per_batch_size =
+      pad_per_class
+          ? std::min(total_size_per_batch, max_size_per_class * num_classes)
+          : total_size_per_batch;
 
-      // Copy class_boxes_data to a tensor
-      TensorShape boxesShape({num_boxes, 4});
-      Tensor boxes(per_batch_boxes.dtype(), boxesShape);
-      std::copy_n(class_boxes_data.begin(), class_boxes_data.size(),
-                  boxes.unaligned_flat<float>().data());
+  Tensor* nmsed_boxes_t = nullptr;
+  TensorShape boxes_shape({num_batches, per_batch_size, 4});
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(0, boxes_shape, &nmsed_boxes_t));
+  auto nmsed_boxes_flat = nmsed_boxes_t->template flat<float>();
+
+  Tensor* nmsed_scores_t = nullptr;
+  TensorShape scores_shape({num_batches, per_batch_size});
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(1, scores_shape, &nmsed_scores_t));
+  auto nmsed_scores_flat = nmsed_scores_t->template flat<float>();
+
+  Tensor* nmsed_classes_t = nullptr;
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(2, scores_shape, &nmsed_classes_t));
+  auto nmsed_classes_flat = nmsed_classes_t->template flat<float>();
+
+  Tensor* valid_detections_t = nullptr;
+  TensorShape valid_detections_shape({num_batches});
+  OP_REQUIRES_OK(context, context->allocate_output(3, valid_detections_shape,
+                                                   &valid_detections_t));
+  auto valid_detections_flat = valid_detections_t->template flat<int>();
+
+  struct ResultCandidate {
+    int box_index;
+    float score;
+    int class_idx;
+    float box_coord[4];
+  };
+
+  // The boxes selected for each batch and class, in order of selection.
+  std::vector<std::vector<ResultCandidate>> class_results(num_batches *
+                                                          num_classes);
+  const float* all_scores_data = inp_scores.flat<float>().data();
+  const float* all_boxes_data = inp_boxes.flat<float>().data();
+  const int size_per_class = std::min(max_size_per_class, num_boxes);
+
+  // Performs non_max_suppression for each batch and class independently.
+  auto per_class_nms = [&](int64 begin, int64 end) {
+    std::vector<float> class_boxes_data;
+    for (int64 idx = begin; idx < end; ++idx) {
+      const int batch = idx / num_classes;
+      const int class_idx = idx % num_classes;
+      // dims of scores_data [num_boxes, num_classes]
+      const float* scores_data =
+          all_scores_data + batch * num_boxes * num_classes;
+      // dims of batch_boxes_data [num_boxes, q, 4]
+      const float* batch_boxes_data =
+          all_boxes_data + batch * num_boxes * q * 4;
 
-      const int size_per_class = std::min(max_size_per_class, num_boxes);
-      // Do NMS, get the candidate indices of form vector<int>
       // Data structure for selection candidate in NMS.
       struct Candidate {
         int box_index;
@@ -361,32 +358,43 @@ void BatchedNonMaxSuppressionOp(
         return bs_i.score > bs_j.score;
       };
       std::vector<Candidate> candidate_vector;
-      for (int i = 0; i < class_scores_data.size(); ++i) {
-        if (class_scores_data[i] > score_threshold) {
-          candidate_vector.emplace_back(Candidate({i, class_scores_data[i]}));
+      for (int i = 0; i < num_boxes; ++i) {
+        const float score = scores_data[i * num_classes + class_idx];
+        if (score > score_threshold) {
+          candidate_vector.emplace_back(Candidate({i, score}));
         }
       }
-
-      std::vector<int> selected;
-      std::vector<float> selected_boxes;
-      Candidate next_candidate;
+      if (candidate_vector.empty()) continue;
+
+      // Get the boxes of the class, of dims [num_boxes, 4]. Boxes shared by
+      // all classes are read in place.
+      const float* class_boxes = batch_boxes_data;
+      if (q > 1) {
+        class_boxes_data.resize(num_boxes * 4);
+        for (int box = 0; box < num_boxes; ++box) {
+          std::copy_n(batch_boxes_data + (box * q + class_idx) * 4, 4,
+                      class_boxes_data.data() + box * 4);
+        }
+        class_boxes = class_boxes_data.data();
+      }
+      typename TTypes<float, 2>::ConstTensor boxes_data(class_boxes, num_boxes,
+                                                        4);
 
       std::sort(candidate_vector.begin(), candidate_vector.end(), cmp);
-      const Tensor const_boxes = boxes;
-      typename TTypes<float, 2>::ConstTensor boxes_data =
-          const_boxes.tensor<float, 2>();
+      std::vector<int> selected;
+      std::vector<ResultCandidate>& result_candidate_vec = class_results[idx];
       int candidate_idx = 0;
-      float iou;
       while (selected.size() < size_per_class &&
              candidate_idx < candidate_vector.size()) {
-        next_candidate = candidate_vector[candidate_idx++];
+        const Candidate next_candidate = candidate_vector[candidate_idx++];
 
         // Overlapping boxes are likely to have similar scores,
         // therefore we iterate through the previously selected boxes backwards
         // in order to see if `next_candidate` should be suppressed.
         bool should_select = true;
         for (int j = selected.size() - 1; j >= 0; --j) {
-          iou = IOU<float>(boxes_data, next_candidate.box_index, selected[j]);
+          const float iou =
+              IOU<float>(boxes_data, next_candidate.box_index, selected[j]);
           if (iou > iou_threshold) {
             should_select = false;
             break;
@@ -406,94 +414,69 @@ void BatchedNonMaxSuppressionOp(
         }
       }
     }
+  };
 
-    auto rc_cmp = [](const ResultCandidate rc_i, const ResultCandidate rc_j) {
-      return rc_i.score > rc_j.score;
-    };
-    std::sort(result_candidate_vec.begin(), result_candidate_vec.end(), rc_cmp);
-
-    int max_detections = 0;
-    // If pad_per_class is false, we always pad to max_total_size
-    if (!pad_per_class) {
-      max_detections =
-          std::min((int)result_candidate_vec.size(), total_size_per_batch);
-      per_batch_size = total_size_per_batch;
-    } else {
-      per_batch_size =
-          std::min(total_size_per_batch, max_size_per_class * num_classes);
-      max_detections =
-          std::min(per_batch_size, (int)result_candidate_vec.size());
-    }
-
-    final_valid_detections.push_back(max_detections);
-
-    int curr_total_size = max_detections;
-    int result_idx = 0;
-    // Pick the top max_detections values
-    while (curr_total_size > 0 && result_idx < result_candidate_vec.size()) {
-      ResultCandidate next_candidate = result_candidate_vec[result_idx++];
-      // Add to final output vectors
-      if (clip_boxes) {
-        const float box_min = 0.0;
-        const float box_max = 1.0;
-        nmsed_boxes[batch].push_back(
-            std::max(std::min(next_candidate.box_coord[0], box_max), box_min));
-        nmsed_boxes[batch].push_back(
-            std::max(std::min(next_candidate.box_coord[1], box_max), box_min));
-        nmsed_boxes[batch].push_back(
-            std::max(std::min(next_candidate.box_coord[2], box_max), box_min));
-        nmsed_boxes[batch].push_back(
-            std::max(std::min(next_candidate.box_coord[3], box_max), box_min));
-      } else {
-        nmsed_boxes[batch].push_back(next_candidate.box_coord[0]);
-        nmsed_boxes[batch].push_back(next_candidate.box_coord[1]);
-        nmsed_boxes[batch].push_back(next_candidate.box_coord[2]);
-        nmsed_boxes[batch].push_back(next_candidate.box_coord[3]);
+  // Merges the results of the classes of each batch into the outputs.
+  auto merge_batch_results = [&](int64 begin, int64 end) {
+    for (int64 batch = begin; batch < end; ++batch) {
+      std::vector<ResultCandidate> result_candidate_vec;
+      for (int class_idx = 0; class_idx < num_classes; ++class_idx) {
+        const std::vector<ResultCandidate>& results =
+            class_results[batch * num_classes + class_idx];
+        result_candidate_vec.insert(result_candidate_vec.end(),
+                                    results.begin(), results.end());
       }
-      nmsed_scores[batch].push_back(next_candidate.score);
-      nmsed_classes[batch].push_back(next_candidate.class_idx);
-      curr_total_size--;
-    }
-
-    nmsed_boxes[batch].resize(per_batch_size * 4, 0);
-    nmsed_scores[batch].resize(per_batch_size, 0);
-    nmsed_classes[batch].resize(per_batch_size, 0);
-  }
-
-  Tensor* nmsed_boxes_t = nullptr;
-  TensorShape boxes_shape({num_batches, per_batch_size, 4});
-  OP_REQUIRES_OK(context,
-                 context->allocate_output(0, boxes_shape, &nmsed_boxes_t));
-  auto nmsed_boxes_flat = nmsed_boxes_t->template flat<float>();
-
-  Tensor* nmsed_scores_t = nullptr;
-  TensorShape scores_shape({num_batches, per_batch_size});
-  OP_REQUIRES_OK(context,
-                 context->allocate_output(1, scores_shape, &nmsed_scores_t));
-  auto nmsed_scores_flat = nmsed_scores_t->template flat<float>();
-
-  Tensor* nmsed_classes_t = nullptr;
-  OP_REQUIRES_OK(context,
-                 context->allocate_output(2, scores_shape, &nmsed_classes_t));
-  auto nmsed_classes_flat = nmsed_classes_t->template flat<float>();
 
-  Tensor* valid_detections_t = nullptr;
-  TensorShape valid_detections_shape({num_batches});
-  OP_REQUIRES_OK(context, context->allocate_output(3, valid_detections_shape,
-                                                   &valid_detections_t));
-  auto valid_detections_flat = valid_detections_t->template flat<int>();
+      auto rc_cmp = [](const ResultCandidate rc_i,
+                       const ResultCandidate rc_j) {
+        return rc_i.score > rc_j.score;
+      };
+      std::sort(result_candidate_vec.begin(), result_candidate_vec.end(),
+                rc_cmp);
 
-  for (int i = 0; i < num_batches; ++i) {
-    valid_detections_flat(i) = final_valid_detections[i];
-    for (int j = 0; j < per_batch_size; ++j) {
-      nmsed_scores_flat(i * per_batch_size + j) = nmsed_scores[i][j];
-      nmsed_classes_flat(i * per_batch_size + j) = nmsed_classes[i][j];
-      for (int k = 0; k < 4; ++k) {
-        nmsed_boxes_flat(i * per_batch_size * 4 + j * 4 + k) =
-            nmsed_boxes[i][j * 4 + k];
+      const int max_detections =
+          std::min(per_batch_size, (int)result_candidate_vec.size());
+      valid_detections_flat(batch) = max_detections;
+
+      // Pick the top max_detections values, and pad with zeros.
+      const int64 scores_offset = batch * per_batch_size;
+      for (int j = 0; j < per_batch_size; ++j) {
+        float* box = &nmsed_boxes_flat((scores_offset + j) * 4);
+        if (j >= max_detections) {
+          std::fill_n(box, 4, 0.0f);
+          nmsed_scores_flat(scores_offset + j) = 0;
+          nmsed_classes_flat(scores_offset + j) = 0;
+          continue;
+        }
+        const ResultCandidate& next_candidate = result_candidate_vec[j];
+        for (int k = 0; k < 4; ++k) {
+          // Add to final output vectors
+          if (clip_boxes) {
+            const float box_min = 0.0;
+            const float box_max = 1.0;
+            box[k] = std::max(std::min(next_candidate.box_coord[k], box_max),
+                              box_min);
+          } else {
+            box[k] = next_candidate.box_coord[k];
+          }
+        }
+        nmsed_scores_flat(scores_offset + j) = next_candidate.score;
+        nmsed_classes_flat(scores_offset + j) = next_candidate.class_idx;
       }
     }
-  }
+  };
+
+  // Both steps are parallelized, over the classes of all batches and then
+  // over the batches. The cost of a class is dominated by copying and sorting
+  // its candidates.
+  auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+  const int64 cost_per_class = 40 * static_cast<int64>(num_boxes);
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        num_batches * num_classes, cost_per_class, per_class_nms);
+  const int64 cost_per_batch = 20 * static_cast<int64>(per_batch_size) +
+                               10 * static_cast<int64>(num_classes);
+  Shard(worker_threads.num_threads, worker_threads.workers, num_batches,
+        cost_per_batch, merge_batch_results);
 }
 
 }  // namespace
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/reference_gemm.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -355,4 +356,56 @@ TEST_F(QuantizedMatMulTest, Medium_WithParams) {
   test::ExpectTensorNear<float>(expected_float, output_float, 15.0);
 }
 
+// Sizes that are not multiples of the blocks of the optimized GEMMs, with both
+// operands transposed, compared against the reference implementation.
+TEST_F(QuantizedMatMulTest, OddSizes_MatchesReference) {
+  const bool transpose_a = true;
+  const bool transpose_b = true;
+  const int m = 5;
+  const int n = 19;
+  const int k = 7;
+  TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMul")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("Toutput", DataTypeToEnum<qint32>::v())
+                   .Attr("transpose_a", transpose_a)
+                   .Attr("transpose_b", transpose_b)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  std::vector<quint8> a_values(k * m);
+  for (size_t i = 0; i < a_values.size(); ++i) {
+    a_values[i] = (i * 37) % 256;
+  }
+  std::vector<quint8> b_values(n * k);
+  for (size_t i = 0; i < b_values.size(); ++i) {
+    b_values[i] = (i * 101 + 7) % 256;
+  }
+  const float a_min = -1.0f;
+  const float a_max = 3.0f;
+  const float b_min = -2.0f;
+  const float b_max = 2.0f;
+  AddInputFromArray<quint8>(TensorShape({k, m}), a_values);
+  AddInputFromArray<quint8>(TensorShape({n, k}), b_values);
+  AddInputFromArray<float>(TensorShape({1}), {a_min});
+  AddInputFromArray<float>(TensorShape({1}), {a_max});
+  AddInputFromArray<float>(TensorShape({1}), {b_min});
+  AddInputFromArray<float>(TensorShape({1}), {b_max});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_QINT32, TensorShape({m, n}));
+  ReferenceGemm<quint8, quint8, qint32>(
+      transpose_a, transpose_b, /*transpose_c=*/false, m, n, k,
+      a_values.data(), FloatToQuantizedUnclamped<quint8>(0.0f, a_min, a_max),
+      /*lda=*/m, b_values.data(),
+      FloatToQuantizedUnclamped<quint8>(0.0f, b_min, b_max), /*ldb=*/k,
+      expected.flat<qint32>().data(), /*shift_c=*/0, /*offset_c=*/0,
+      /*mult_c=*/1, /*ldc=*/n);
+  test::ExpectTensorEqual<qint32>(expected, *GetOutput(0));
+}
+
 }  // namespace tensorflow
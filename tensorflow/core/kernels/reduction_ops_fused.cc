@@ -0,0 +1,293 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/kernels/reduction_ops_common.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+enum class FusedReduction {
+  kSum,
+  kMean,
+  kMax,
+  kMin,
+  kSumOfSquares,
+  kMeanOfSquares,
+};
+
+Status ParseFusedReduction(const string& name, FusedReduction* reduction) {
+  if (name == "Sum") {
+    *reduction = FusedReduction::kSum;
+  } else if (name == "Mean") {
+    *reduction = FusedReduction::kMean;
+  } else if (name == "Max") {
+    *reduction = FusedReduction::kMax;
+  } else if (name == "Min") {
+    *reduction = FusedReduction::kMin;
+  } else if (name == "SumOfSquares") {
+    *reduction = FusedReduction::kSumOfSquares;
+  } else if (name == "MeanOfSquares") {
+    *reduction = FusedReduction::kMeanOfSquares;
+  } else {
+    return errors::InvalidArgument("Unsupported reduction: ", name);
+  }
+  return Status::OK();
+}
+
+// Number of input elements on which all the reductions run before moving on,
+// so that every reduction after the first reads them from L1 cache.
+constexpr int64 kBlockSize = 1024;
+
+// The running values of the reductions of up to kBlockSize outputs. Only the
+// accumulators needed by the requested reductions are computed.
+template <typename T>
+struct FusedAccumulators {
+  using Array = Eigen::Array<T, Eigen::Dynamic, 1>;
+  using ConstMap = Eigen::Map<const Array>;
+
+  bool needs_sum = false;
+  bool needs_sum_of_squares = false;
+  bool needs_max = false;
+  bool needs_min = false;
+
+  Array sum;
+  Array sum_of_squares;
+  Array max;
+  Array min;
+
+  void Allocate(int64 size) {
+    if (needs_sum) sum.resize(size);
+    if (needs_sum_of_squares) sum_of_squares.resize(size);
+    if (needs_max) max.resize(size);
+    if (needs_min) min.resize(size);
+  }
+
+  void Reset(int64 size) {
+    if (needs_sum) sum.head(size).setZero();
+    if (needs_sum_of_squares) sum_of_squares.head(size).setZero();
+    if (needs_max) max.head(size).setConstant(std::numeric_limits<T>::lowest());
+    if (needs_min) min.head(size).setConstant(std::numeric_limits<T>::max());
+  }
+
+  // Accumulates `size` consecutive inputs into as many outputs.
+  void AccumulateColumns(const T* input, int64 size) {
+    const ConstMap values(input, size);
+    if (needs_sum) sum.head(size) += values;
+    if (needs_sum_of_squares) sum_of_squares.head(size) += values.square();
+    if (needs_max) max.head(size) = max.head(size).max(values);
+    if (needs_min) min.head(size) = min.head(size).min(values);
+  }
+
+  // Accumulates `size` consecutive inputs into the first output.
+  void AccumulateRow(const T* input, int64 size) {
+    const ConstMap values(input, size);
+    if (needs_sum) sum(0) += values.sum();
+    if (needs_sum_of_squares) sum_of_squares(0) += values.square().sum();
+    if (needs_max) max(0) = std::max(max(0), values.maxCoeff());
+    if (needs_min) min(0) = std::min(min(0), values.minCoeff());
+  }
+};
+
+}  // namespace
+
+// Computes several reductions of the same input over the same axes in a
+// single pass over the input, e.g. the mean and the mean of squares of a
+// normalization. Created by the remapper from separate reductions.
+template <typename T>
+class FusedReduceOp : public OpKernel {
+ public:
+  explicit FusedReduceOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("keep_dims", &keep_dims_));
+    std::vector<string> reductions;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("reductions", &reductions));
+    OP_REQUIRES(ctx, static_cast<int>(reductions.size()) == ctx->num_outputs(),
+                errors::InvalidArgument("Expected ", ctx->num_outputs(),
+                                        " reductions, got ",
+                                        reductions.size()));
+    for (const string& name : reductions) {
+      FusedReduction reduction;
+      OP_REQUIRES_OK(ctx, ParseFusedReduction(name, &reduction));
+      reductions_.push_back(reduction);
+    }
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& data = ctx->input(0);
+    const Tensor& axes = ctx->input(1);
+
+    ReductionHelper helper;
+    OP_REQUIRES_OK(ctx, helper.Simplify(data, axes, keep_dims_));
+
+    // View the input as [outer, reduced, inner] and reduce the middle
+    // dimension. Reductions that do not fit this view are transposed into it,
+    // like in ReductionOp.
+    const TensorShape data_reshape = helper.data_reshape();
+    const int ndims = helper.ndims();
+    const bool reduce_first_axis = helper.reduce_first_axis();
+    int64 outer = 1;
+    int64 reduced = 1;
+    int64 inner = 1;
+    const T* input = data.flat<T>().data();
+    Tensor shuffled;
+    if (ndims == 1) {
+      (reduce_first_axis ? reduced : outer) = data_reshape.dim_size(0);
+    } else if (ndims == 2 && reduce_first_axis) {
+      reduced = data_reshape.dim_size(0);
+      inner = data_reshape.dim_size(1);
+    } else if (ndims == 2) {
+      outer = data_reshape.dim_size(0);
+      reduced = data_reshape.dim_size(1);
+    } else if (ndims == 3 && !reduce_first_axis) {
+      outer = data_reshape.dim_size(0);
+      reduced = data_reshape.dim_size(1);
+      inner = data_reshape.dim_size(2);
+    } else if (ndims > 0) {
+      Tensor data_reshaped;
+      CHECK(data_reshaped.CopyFrom(data, data_reshape));
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                             helper.shuffled_shape(),
+                                             &shuffled));
+      OP_REQUIRES_OK(ctx, DoTranspose(ctx->eigen_device<CPUDevice>(),
+                                      data_reshaped, helper.permutation(),
+                                      &shuffled));
+      outer = helper.out_reshape().num_elements();
+      reduced = outer == 0 ? 0 : shuffled.NumElements() / outer;
+      input = shuffled.flat<T>().data();
+    }
+
+    std::vector<T*> outputs(reductions_.size());
+    for (size_t i = 0; i < reductions_.size(); ++i) {
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK(ctx,
+                     ctx->allocate_output(i, helper.out_shape(), &output));
+      outputs[i] = output->flat<T>().data();
+    }
+    if (outer * inner == 0) return;
+
+    FusedAccumulators<T> prototype;
+    for (const FusedReduction reduction : reductions_) {
+      switch (reduction) {
+        case FusedReduction::kSum:
+        case FusedReduction::kMean:
+          prototype.needs_sum = true;
+          break;
+        case FusedReduction::kSumOfSquares:
+        case FusedReduction::kMeanOfSquares:
+          prototype.needs_sum_of_squares = true;
+          break;
+        case FusedReduction::kMax:
+          prototype.needs_max = true;
+          break;
+        case FusedReduction::kMin:
+          prototype.needs_min = true;
+          break;
+      }
+    }
+    const int64 num_accumulators =
+        prototype.needs_sum + prototype.needs_sum_of_squares +
+        prototype.needs_max + prototype.needs_min;
+
+    // Each unit of work computes up to kBlockSize consecutive outputs.
+    const int64 num_col_blocks = (inner + kBlockSize - 1) / kBlockSize;
+    const int64 cols_per_block = std::min(inner, kBlockSize);
+    auto compute = [&](int64 start, int64 limit) {
+      FusedAccumulators<T> accumulators = prototype;
+      accumulators.Allocate(cols_per_block);
+      for (int64 unit = start; unit < limit; ++unit) {
+        const int64 o = unit / num_col_blocks;
+        const int64 col = (unit % num_col_blocks) * kBlockSize;
+        const int64 cols = std::min(kBlockSize, inner - col);
+        const T* block_input = input + o * reduced * inner + col;
+        accumulators.Reset(cols);
+        if (inner == 1) {
+          for (int64 r = 0; r < reduced; r += kBlockSize) {
+            accumulators.AccumulateRow(block_input + r,
+                                       std::min(kBlockSize, reduced - r));
+          }
+        } else {
+          for (int64 r = 0; r < reduced; ++r) {
+            accumulators.AccumulateColumns(block_input + r * inner, cols);
+          }
+        }
+        StoreOutputs(accumulators, reduced, o * inner + col, cols, outputs);
+      }
+    };
+    const auto& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          outer * num_col_blocks,
+          std::max<int64>(1, reduced * cols_per_block * num_accumulators),
+          compute);
+  }
+
+ private:
+  void StoreOutputs(const FusedAccumulators<T>& accumulators, int64 reduced,
+                    int64 offset, int64 size,
+                    const std::vector<T*>& outputs) const {
+    const T inv_reduced = T(1) / static_cast<T>(reduced);
+    for (size_t i = 0; i < reductions_.size(); ++i) {
+      Eigen::Map<typename FusedAccumulators<T>::Array> output(
+          outputs[i] + offset, size);
+      switch (reductions_[i]) {
+        case FusedReduction::kSum:
+          output = accumulators.sum.head(size);
+          break;
+        case FusedReduction::kMean:
+          output = accumulators.sum.head(size) * inv_reduced;
+          break;
+        case FusedReduction::kMax:
+          output = accumulators.max.head(size);
+          break;
+        case FusedReduction::kMin:
+          output = accumulators.min.head(size);
+          break;
+        case FusedReduction::kSumOfSquares:
+          output = accumulators.sum_of_squares.head(size);
+          break;
+        case FusedReduction::kMeanOfSquares:
+          output = accumulators.sum_of_squares.head(size) * inv_reduced;
+          break;
+      }
+    }
+  }
+
+  bool keep_dims_;
+  std::vector<FusedReduction> reductions_;
+};
+
+#define REGISTER_CPU_KERNELS(type)                                    \
+  REGISTER_KERNEL_BUILDER(Name("_FusedReduce")                        \
+                              .Device(DEVICE_CPU)                     \
+                              .TypeConstraint<type>("T")              \
+                              .TypeConstraint<int32>("Tidx"),         \
+                          FusedReduceOp<type>);                       \
+  REGISTER_KERNEL_BUILDER(Name("_FusedReduce")                        \
+                              .Device(DEVICE_CPU)                     \
+                              .TypeConstraint<type>("T")              \
+                              .TypeConstraint<int64>("Tidx"),         \
+                          FusedReduceOp<type>);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+#undef REGISTER_CPU_KERNELS
+
+}  // namespace tensorflow
@@ -540,9 +540,20 @@ class AssignUpdateVariableOp : public OpKernel {
                                            &variable));
 
     const Tensor& value = context->input(1);
-    // TODO(apassos): We could possibly avoid the copy done by
-    // PrepareToUpdateVariable() for commutative operations like Op ==
-    // ADD if value's refcount was 1.
+    // Addition is commutative, so if this op is the last user of `value` the
+    // sum can be computed in its buffer, which then becomes the variable's.
+    // The buffer must satisfy the same allocator attributes as the copy
+    // PrepareToUpdateVariable() would make, since reads of the variable may
+    // be sent over the network or to a GPU without another copy.
+    std::unique_ptr<Tensor> value_alias;
+    if (Op == ADD) {
+      AllocatorAttributes attr;
+      attr.set_gpu_compatible(true);
+      attr.set_nic_compatible(true);
+      value_alias = context->forward_input(
+          1, OpKernelContext::Params::kNoReservation /*output_index*/,
+          value.dtype(), value.shape(), DEVICE_MEMORY, attr);
+    }
     mutex_lock ml(*variable->mu());
     Tensor* var_tensor = variable->tensor();
     OP_REQUIRES(context, var_tensor->shape().IsSameSize(value.shape()),
@@ -551,6 +562,16 @@ class AssignUpdateVariableOp : public OpKernel {
                                         " using a Tensor with shape ",
                                         value.shape().DebugString(),
                                         ", shapes must be equal."));
+    if (value_alias != nullptr && !variable->copy_on_read_mode.load() &&
+        !var_tensor->RefCountIsOne()) {
+      // Reads still alias the variable's buffer, which would otherwise have
+      // to be copied by PrepareToUpdateVariable() before being updated.
+      functor::DenseUpdate<Device, T, ADD> update_functor;
+      update_functor(context->eigen_device<Device>(), value_alias->flat<T>(),
+                     const_cast<const Tensor*>(var_tensor)->flat<T>());
+      *var_tensor = *value_alias;
+      return;
+    }
     OP_REQUIRES_OK(
         context, PrepareToUpdateVariable<Device, T>(
                      context, var_tensor, variable->copy_on_read_mode.load()));
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <algorithm>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
@@ -29,7 +30,10 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -236,6 +240,9 @@ namespace {
 // Tensors larger than this threshold will be restored from a thread-pool.
 const int64 kLargeShapeThreshold = 16 << 20;  // 16M
 
+// Smaller tensors are restored in batches of at least this many elements.
+const int64 kMinBatchShapeSize = 1 << 20;  // 1M
+
 // A restore operation for a single tensor.  Small tensors may be restored
 // directly from the op thread to improve read locality.  Large tensors can be
 // restored from a thread pool: this requires creating a separate BundleReader
@@ -243,20 +250,22 @@ const int64 kLargeShapeThreshold = 16 << 20;  // 16M
 struct RestoreOp {
   RestoreOp& operator=(const RestoreOp&) = delete;
 
-  bool should_run_in_pool(BundleReader* reader) const {
+  void lookup_num_elements(BundleReader* reader) {
     TensorShape restored_full_shape;
 
     // Ignore status here; we'll catch the error later.
-    if (!reader->LookupTensorShape(tensor_name, &restored_full_shape).ok()) {
-      return false;
+    if (reader->LookupTensorShape(tensor_name, &restored_full_shape).ok()) {
+      num_elements = restored_full_shape.num_elements();
     }
+  }
 
-    return restored_full_shape.num_elements() > kLargeShapeThreshold;
+  bool should_run_in_pool() const {
+    return num_elements > kLargeShapeThreshold;
   }
 
   // Run this restore operation using a new BundleReader.
   void run_with_new_reader() {
-    BundleReader reader(Env::Default(), reader_prefix);
+    BundleReader reader(Env::Default(), reader_prefix, reader_options);
     if (!reader.status().ok()) {
       status = reader.status();
       return;
@@ -273,7 +282,12 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    if (shape_and_slice.empty() && reader_options.memory_map_data) {
+      // Let the reader allocate, or alias, the full tensor.
+      Tensor restored;
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &restored));
+      context->set_output(idx, restored);
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -308,6 +322,50 @@ struct RestoreOp {
   string tensor_name;
   string shape_and_slice;
   string reader_prefix;
+  BundleReader::Options reader_options;
+  int64 num_elements;
+
+  ::tensorflow::Status status;
+};
+
+// A batch of restore operations for small tensors with consecutive names.
+// Full tensors are looked up together, which lets the reader merge the reads
+// of tensors stored next to each other.
+struct RestoreBatch {
+  RestoreBatch& operator=(const RestoreBatch&) = delete;
+
+  void run_with_new_reader() {
+    BundleReader reader(Env::Default(), ops[0]->reader_prefix,
+                        ops[0]->reader_options);
+    if (!reader.status().ok()) {
+      status = reader.status();
+      return;
+    }
+
+    status = run(&reader);
+  }
+
+  Status run(BundleReader* reader) {
+    std::vector<string> keys;
+    std::vector<Tensor*> vals;
+    for (RestoreOp* op : ops) {
+      if (!op->shape_and_slice.empty() || op->reader_options.memory_map_data) {
+        TF_RETURN_IF_ERROR(op->run(reader));
+        continue;
+      }
+      TensorShape restored_full_shape;
+      TF_RETURN_IF_ERROR(
+          reader->LookupTensorShape(op->tensor_name, &restored_full_shape));
+      Tensor* restored_tensor;
+      TF_RETURN_IF_ERROR(op->context->allocate_output(
+          op->idx, restored_full_shape, &restored_tensor));
+      keys.push_back(op->tensor_name);
+      vals.push_back(restored_tensor);
+    }
+    return reader->LookupMany(keys, vals);
+  }
+
+  std::vector<RestoreOp*> ops;
 
   ::tensorflow::Status status;
 };
@@ -333,8 +391,20 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
 
   std::vector<std::unique_ptr<RestoreOp> > pool_restore_ops;
   std::vector<std::unique_ptr<RestoreOp> > direct_restore_ops;
+  int64 direct_num_elements = 0;
+
+  int64 num_threads;
+  TF_RETURN_IF_ERROR(
+      ReadInt64FromEnvVar("TF_RESTORE_NUM_THREADS", 8, &num_threads));
+  num_threads = std::max<int64>(num_threads, 1);
 
-  BundleReader default_reader(Env::Default(), prefix_string);
+  // Memory-mapping the data files lets restored tensors alias the page cache
+  // instead of being copied, e.g. to speed up loading models for serving.
+  BundleReader::Options reader_options;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_RESTORE_MEMORY_MAP_BUNDLES", false,
+                                        &reader_options.memory_map_data));
+
+  BundleReader default_reader(Env::Default(), prefix_string, reader_options);
   TF_RETURN_IF_ERROR(default_reader.status());
 
   std::vector<string> mismatched_errors;
@@ -360,30 +430,55 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
-    auto op =
-        new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
-    if (op->should_run_in_pool(&default_reader)) {
+    auto op = new RestoreOp{context,         i,
+                            tensor_name,     shape_and_slice,
+                            prefix_string,   reader_options};
+    op->lookup_num_elements(&default_reader);
+    if (op->should_run_in_pool()) {
       pool_restore_ops.emplace_back(op);
     } else {
       direct_restore_ops.emplace_back(op);
+      direct_num_elements += op->num_elements;
     }
   }
 
+  // Split the small tensors, in name order, into batches of similar size, so
+  // that reads from high-latency file systems can proceed in parallel.
+  const int64 num_batches = std::max<int64>(
+      1, std::min(num_threads, direct_num_elements / kMinBatchShapeSize));
+  const int64 batch_num_elements = direct_num_elements / num_batches;
+  std::vector<std::unique_ptr<RestoreBatch> > batches;
+  int64 current_num_elements = 0;
+  for (auto& op : direct_restore_ops) {
+    if (batches.empty() ||
+        (static_cast<int64>(batches.size()) < num_batches &&
+         current_num_elements >= batch_num_elements)) {
+      batches.emplace_back(new RestoreBatch);
+      current_num_elements = 0;
+    }
+    batches.back()->ops.push_back(op.get());
+    current_num_elements += op->num_elements;
+  }
+
   {
     // Schedule any threaded operations first, skipping thread pool creation if
     // we don't have any expensive operations.
     std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
-      reader_pool.reset(
-          new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
+    if (!pool_restore_ops.empty() || batches.size() > 1) {
+      reader_pool.reset(new thread::ThreadPool(Env::Default(),
+                                               "restore_tensors", num_threads));
       for (auto& op : pool_restore_ops) {
         reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
       }
+      for (size_t i = 1; i < batches.size(); ++i) {
+        RestoreBatch* batch = batches[i].get();
+        reader_pool->Schedule([batch]() { batch->run_with_new_reader(); });
+      }
     }
 
-    // Read small tensors from the op thread
-    for (auto& op : direct_restore_ops) {
-      TF_RETURN_IF_ERROR(op->run(&default_reader));
+    // Read the first batch of small tensors from the op thread.
+    if (!batches.empty()) {
+      batches[0]->status = batches[0]->run(&default_reader);
     }
   }
 
@@ -391,6 +486,9 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   for (auto& op : pool_restore_ops) {
     TF_RETURN_IF_ERROR(op->status);
   }
+  for (auto& batch : batches) {
+    TF_RETURN_IF_ERROR(batch->status);
+  }
 
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
@@ -405,4 +503,81 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   return Status::OK();
 }
 
+namespace {
+
+// Number of threads writing checkpoints scheduled by ScheduleSave().
+const int kNumSaveThreads = 4;
+
+// The checkpoints being written in the background, and the errors of those
+// that failed and were not yet waited for.
+class PendingSaves {
+ public:
+  static PendingSaves* Global() {
+    static PendingSaves* pending_saves = new PendingSaves;
+    return pending_saves;
+  }
+
+  Status Schedule(const string& prefix, std::function<Status()> write) {
+    {
+      mutex_lock l(mu_);
+      while (pending_.count(prefix) > 0) {
+        cv_.wait(l);
+      }
+      TF_RETURN_IF_ERROR(TakeErrorLocked(prefix));
+      ++pending_[prefix];
+    }
+    pool_.Schedule([this, prefix, write]() {
+      const Status s = write();
+      if (!s.ok()) {
+        LOG(ERROR) << "Writing checkpoint " << prefix << " failed: " << s;
+      }
+      mutex_lock l(mu_);
+      if (!s.ok()) {
+        errors_.emplace(prefix, s);
+      }
+      if (--pending_[prefix] == 0) {
+        pending_.erase(prefix);
+        cv_.notify_all();
+      }
+    });
+    return Status::OK();
+  }
+
+  Status Wait(const string& prefix) {
+    mutex_lock l(mu_);
+    while (pending_.count(prefix) > 0) {
+      cv_.wait(l);
+    }
+    return TakeErrorLocked(prefix);
+  }
+
+ private:
+  PendingSaves()
+      : pool_(Env::Default(), "checkpoint_save", kNumSaveThreads) {}
+
+  Status TakeErrorLocked(const string& prefix) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = errors_.find(prefix);
+    if (it == errors_.end()) return Status::OK();
+    const Status s = it->second;
+    errors_.erase(it);
+    return s;
+  }
+
+  mutex mu_;
+  condition_variable cv_;
+  std::unordered_map<string, int> pending_ GUARDED_BY(mu_);
+  std::unordered_map<string, Status> errors_ GUARDED_BY(mu_);
+  thread::ThreadPool pool_;
+};
+
+}  // namespace
+
+Status ScheduleSave(const string& prefix, std::function<Status()> write) {
+  return PendingSaves::Global()->Schedule(prefix, std::move(write));
+}
+
+Status WaitForPendingSave(const string& prefix) {
+  return PendingSaves::Global()->Wait(prefix);
+}
+
 }  // namespace tensorflow
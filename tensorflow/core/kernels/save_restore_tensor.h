@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 #define TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 
+#include <functional>
+
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_writer.h"
 
@@ -68,6 +70,17 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& shape_and_slices,
                         gtl::ArraySlice<DataType> dtypes);
 
+// Runs "write", which writes the V2 checkpoint "prefix", on a background
+// thread.  Blocks first until earlier writes of "prefix" have finished.
+// Returns the error of an earlier write of "prefix" that was not yet reported
+// by WaitForPendingSave(), if any, without scheduling "write".
+Status ScheduleSave(const string& prefix, std::function<Status()> write);
+
+// Waits until all writes of "prefix" scheduled by ScheduleSave() have
+// finished, and returns (and clears) the error of the first one that failed.
+// Returns OK immediately if no write of "prefix" was ever scheduled.
+Status WaitForPendingSave(const string& prefix);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
@@ -15,12 +15,16 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <cstring>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
@@ -29,9 +33,11 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -85,12 +91,79 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// A tensor to save, with its parsed shape and slice specification.
+struct SavedTensor {
+  string name;
+  bool is_slice = false;
+  TensorShape shape;
+  TensorSlice slice;
+  Tensor tensor;
+};
+
+Status WriteBundle(const string& prefix,
+                   const std::vector<SavedTensor>& saved_tensors) {
+  BundleWriter writer(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+  for (const SavedTensor& saved : saved_tensors) {
+    if (saved.is_slice) {
+      TF_RETURN_IF_ERROR(
+          writer.AddSlice(saved.name, saved.shape, saved.slice, saved.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(saved.name, saved.tensor));
+    }
+  }
+  return writer.Finish();
+}
+
+// Returns a copy of "tensor", using the CPU worker threads to copy large
+// buffers.
+Tensor Snapshot(OpKernelContext* context, const Tensor& tensor) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype())) {
+    return tensor::DeepCopy(tensor);
+  }
+  Tensor snapshot(tensor.dtype(), tensor.shape());
+  const char* src = tensor.tensor_data().data();
+  char* dst = const_cast<char*>(snapshot.tensor_data().data());
+  auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        tensor.TotalBytes(), /*cost_per_unit=*/1,
+        [src, dst](int64 begin, int64 end) {
+          memcpy(dst + begin, src + begin, end - begin);
+        });
+  return snapshot;
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
+//
+// If the environment variable TF_SAVE_V2_ASYNC is set to true, the op only
+// takes a snapshot of the tensors and writes the bundle from a background
+// thread, so that training can continue meanwhile.  The bundle is complete
+// only after RestoreV2, MergeV2Checkpoints, or another SaveV2 of the same
+// prefix in this process starts running; these ops wait for pending writes,
+// and report their errors.
+//
+// The snapshot is a deep copy, so an asynchronous save temporarily doubles
+// the memory held by the saved tensors. The copy is needed for reference
+// variables, which are updated in place. Resource variables copy their buffer
+// before updating it while a read still aliases it, so graphs that only save
+// resource variables can set TF_SAVE_V2_ASYNC_COPY to false to keep references
+// to the tensors instead.
+//
+// There is no incremental mode that only writes the rows updated since the
+// last save: it would need dirty-row tracking in the update kernels, a delta
+// bundle format, and a restore path that merges deltas into a base bundle.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context,
+                   ReadBoolFromEnvVar("TF_SAVE_V2_ASYNC", false, &async_));
+    OP_REQUIRES_OK(context, ReadBoolFromEnvVar("TF_SAVE_V2_ASYNC_COPY", true,
+                                               &async_copy_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -105,37 +178,50 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<string>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    auto saved_tensors = std::make_shared<std::vector<SavedTensor>>();
+    saved_tensors->reserve(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
       const Tensor& tensor = context->input(i + kFixedInputs);
+      SavedTensor saved;
+      saved.name = tensor_names_flat(i);
 
       if (!shape_and_slices_flat(i).empty()) {
         const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
+        saved.slice = TensorSlice(tensor.dims());
         TensorShape slice_shape;
 
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
+        OP_REQUIRES_OK(context,
+                       checkpoint::ParseShapeAndSlice(shape_spec, &saved.shape,
+                                                      &saved.slice,
+                                                      &slice_shape));
         OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
                     errors::InvalidArgument("Slice in shape_and_slice "
                                             "specification does not match the "
                                             "shape of the tensor to  save: ",
                                             shape_spec, ", tensor: ",
                                             tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
+        saved.is_slice = true;
       }
+      // Reference variables may be updated in place as soon as this op
+      // completes.
+      saved.tensor =
+          async_ && async_copy_ ? Snapshot(context, tensor) : tensor;
+      saved_tensors->push_back(std::move(saved));
+    }
+
+    if (async_) {
+      auto write = [prefix_string, saved_tensors]() {
+        return WriteBundle(prefix_string, *saved_tensors);
+      };
+      OP_REQUIRES_OK(context, ScheduleSave(prefix_string, std::move(write)));
+    } else {
+      OP_REQUIRES_OK(context, WriteBundle(prefix_string, *saved_tensors));
     }
-    OP_REQUIRES_OK(context, writer.Finish());
   }
+
+ private:
+  bool async_;
+  bool async_copy_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -158,6 +244,7 @@ class RestoreV2 : public OpKernel {
                    shape_and_slices);
 
     const string& prefix_string = prefix.scalar<string>()();
+    OP_REQUIRES_OK(context, WaitForPendingSave(prefix_string));
 
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
@@ -216,6 +303,9 @@ class MergeV2Checkpoints : public OpKernel {
         gtl::ArraySlice<string>(checkpoint_prefixes.flat<string>());
     Env* env = Env::Default();
     const string& merged_prefix = destination_prefix.scalar<string>()();
+    for (const string& input_prefix : input_prefixes) {
+      OP_REQUIRES_OK(context, WaitForPendingSave(input_prefix));
+    }
     OP_REQUIRES_OK(
         context, tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
 
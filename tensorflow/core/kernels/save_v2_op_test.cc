@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <stdlib.h>
+
 #include <complex>
 #include <string>
 
@@ -23,8 +25,10 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
@@ -338,5 +342,108 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+class AsyncSaveV2OpTest : public OpsTestBase {
+ protected:
+  void SetUp() override { CHECK_EQ(setenv("TF_SAVE_V2_ASYNC", "1", 1), 0); }
+  void TearDown() override { CHECK_EQ(unsetenv("TF_SAVE_V2_ASYNC"), 0); }
+
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Input(FakeInput({DT_FLOAT, DT_STRING}))  // tensors
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(AsyncSaveV2OpTest, SavesSnapshot) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_async");
+  MakeOp();
+  AddInput<string>(TensorShape({}),
+                   [&prefix](int x) -> string { return prefix; });
+  AddInput<string>(TensorShape({2}), [](int x) -> string {
+    return x == 0 ? "tensor_float" : "tensor_string";
+  });
+  AddInput<string>(TensorShape({2}),
+                   [](int x) -> string { return "" /* saves in full */; });
+  AddInput<float>(TensorShape({1000}),
+                  [](int x) -> float { return static_cast<float>(x); });
+  AddInput<string>(TensorShape({3}),
+                   [](int x) -> string { return strings::StrCat("str", x); });
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Updates after the op has run are not saved.
+  mutable_input(3).tensor->flat<float>().setZero();
+  mutable_input(4).tensor->flat<string>().setConstant("");
+
+  TF_ASSERT_OK(WaitForPendingSave(prefix));
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("tensor_float", &val));
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(static_cast<float>(i), val.flat<float>()(i));
+  }
+  TF_ASSERT_OK(reader.Lookup("tensor_string", &val));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(strings::StrCat("str", i), val.flat<string>()(i));
+  }
+}
+
+TEST_F(AsyncSaveV2OpTest, ReportsWriteErrors) {
+  const string prefix =
+      io::JoinPath(testing::TmpDir(), "not_a_dir", "file", "tensor_async");
+  // Makes a regular file where the bundle's directory should be.
+  TF_ASSERT_OK(WriteStringToFile(
+      Env::Default(), io::JoinPath(testing::TmpDir(), "not_a_dir"), ""));
+  MakeOp();
+  AddInput<string>(TensorShape({}),
+                   [&prefix](int x) -> string { return prefix; });
+  AddInput<string>(TensorShape({2}), [](int x) -> string {
+    return x == 0 ? "tensor_float" : "tensor_string";
+  });
+  AddInput<string>(TensorShape({2}), [](int x) -> string { return ""; });
+  AddInput<float>(TensorShape({1}), [](int x) -> float { return 0; });
+  AddInput<string>(TensorShape({1}), [](int x) -> string { return ""; });
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_FALSE(WaitForPendingSave(prefix).ok());
+  // The error is reported only once.
+  TF_EXPECT_OK(WaitForPendingSave(prefix));
+}
+
+TEST_F(AsyncSaveV2OpTest, SavesWithoutCopy) {
+  CHECK_EQ(setenv("TF_SAVE_V2_ASYNC_COPY", "0", 1), 0);
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_async_nocopy");
+  MakeOp();
+  CHECK_EQ(unsetenv("TF_SAVE_V2_ASYNC_COPY"), 0);
+  AddInput<string>(TensorShape({}),
+                   [&prefix](int x) -> string { return prefix; });
+  AddInput<string>(TensorShape({2}), [](int x) -> string {
+    return x == 0 ? "tensor_float" : "tensor_string";
+  });
+  AddInput<string>(TensorShape({2}), [](int x) -> string { return ""; });
+  AddInput<float>(TensorShape({1000}),
+                  [](int x) -> float { return static_cast<float>(x); });
+  AddInput<string>(TensorShape({3}),
+                   [](int x) -> string { return strings::StrCat("str", x); });
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The inputs are left alone, as resource variables would be.
+  TF_ASSERT_OK(WaitForPendingSave(prefix));
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("tensor_float", &val));
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(static_cast<float>(i), val.flat<float>()(i));
+  }
+  TF_ASSERT_OK(reader.Lookup("tensor_string", &val));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(strings::StrCat("str", i), val.flat<string>()(i));
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -22,6 +22,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -387,6 +389,37 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     const int64 N = segment_ids.dimension(0);
     const int64 num_segments = output.dimension(0);
     ReductionF reduction;
+    // Segment ids derived from row splits, as in the reductions of ragged
+    // tensors, are sorted. Every segment then covers a contiguous range of
+    // rows, so ranges of segments can be reduced in parallel.
+    const Index* ids_begin = segment_ids.data();
+    const Index* ids_end = ids_begin + N;
+    if (std::is_sorted(ids_begin, ids_end)) {
+      const Index last = internal::SubtleMustCopy(segment_ids(N - 1));
+      OP_REQUIRES(
+          ctx, last < num_segments,
+          errors::InvalidArgument(
+              "segment_ids", SliceDebugString(segment_ids_shape, N - 1), " = ",
+              last, " is out of range [0, ", num_segments, ")"));
+      auto reduce_segments = [&](int64 start, int64 limit) {
+        for (int64 i = std::lower_bound(ids_begin, ids_end, start) - ids_begin;
+             i < N; ++i) {
+          // The ids are read again, so do not trust them to still be sorted.
+          const Index j = internal::SubtleMustCopy(segment_ids(i));
+          if (j >= limit) break;
+          if (j < start) continue;
+          reduction(data.template chip<0>(i), output.template chip<0>(j));
+        }
+      };
+      const DeviceBase::CpuWorkerThreads& worker_threads =
+          *ctx->device()->tensorflow_cpu_worker_threads();
+      const int64 cost_per_segment =
+          (N / std::max<int64>(num_segments, 1) + 1) * data.dimension(1) *
+          Eigen::TensorOpCost::AddCost<T>();
+      Shard(worker_threads.num_threads, worker_threads.workers, num_segments,
+            cost_per_segment, reduce_segments);
+      return;
+    }
     for (int64 i = 0; i < N; ++i) {
       Index j = internal::SubtleMustCopy(segment_ids(i));
       if (j < 0) {
@@ -625,7 +658,7 @@ TF_CALL_complex128(REGISTER_SUM_GPU_UNSORTED_KERNELS_ALL);
 // Same as SegmentReductionOp but takes as input a "sparse" tensor, represented
 // by two dense tensors, one containing the data, and the other containing
 // indices into the data.
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionOpBase : public OpKernel {
  public:
   explicit SparseSegmentReductionOpBase(OpKernelConstruction* context,
@@ -767,8 +800,6 @@ class SparseSegmentReductionOpBase : public OpKernel {
   }
 
  private:
-  typedef int32 Index;
-
   int64 Reduce(const typename TTypes<T>::ConstMatrix& input_flat,
                const typename TTypes<Index>::ConstVec& indices_vec, int64 start,
                int64 num,
@@ -902,114 +933,126 @@ class SparseSegmentReductionOpBase : public OpKernel {
   const T default_value_;
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionMeanOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionMeanOp(OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(
+      : SparseSegmentReductionOpBase<Device, T, Index>(
             context, true /*is_mean*/, false /*is_sqrtn*/,
             false /* has_num_segments */, T(0) /* default_value */) {}
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionMeanWithNumSegmentsOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionMeanWithNumSegmentsOp(
       OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(
+      : SparseSegmentReductionOpBase<Device, T, Index>(
             context, true /*is_mean*/, false /*is_sqrtn*/,
             true /* has_num_segments */, T(0) /* default_value */) {}
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionSqrtNOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionSqrtNOp(OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(
+      : SparseSegmentReductionOpBase<Device, T, Index>(
             context, false /*is_mean*/, true /*is_sqrtn*/,
             false /* has_num_segments */, T(0) /* default_value */) {}
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionSqrtNWithNumSegmentsOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionSqrtNWithNumSegmentsOp(
       OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(
+      : SparseSegmentReductionOpBase<Device, T, Index>(
             context, false /*is_mean*/, true /*is_sqrtn*/,
             true /* has_num_segments */, T(0) /* default_value */) {}
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionSumOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionSumOp(OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(
+      : SparseSegmentReductionOpBase<Device, T, Index>(
             context, false /*is_mean*/, false /*is_sqrtn*/,
             false /* has_num_segments */, T(0) /* default_value */) {}
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionSumWithNumSegmentsOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionSumWithNumSegmentsOp(
       OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(
+      : SparseSegmentReductionOpBase<Device, T, Index>(
             context, false /*is_mean*/, false /*is_sqrtn*/,
             true /* has_num_segments */, T(0) /* default_value */) {}
 };
 
-#define REGISTER_CPU_SPARSE_KERNELS(type)                                \
-  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSum")                       \
-                              .Device(DEVICE_CPU)                        \
-                              .TypeConstraint<type>("T")                 \
-                              .TypeConstraint<int32>("Tidx"),            \
-                          SparseSegmentReductionSumOp<CPUDevice, type>); \
-  REGISTER_KERNEL_BUILDER(                                               \
-      Name("SparseSegmentSumWithNumSegments")                            \
-          .Device(DEVICE_CPU)                                            \
-          .TypeConstraint<type>("T")                                     \
-          .TypeConstraint<int32>("Tidx"),                                \
-      SparseSegmentReductionSumWithNumSegmentsOp<CPUDevice, type>);
-TF_CALL_REAL_NUMBER_TYPES(REGISTER_CPU_SPARSE_KERNELS);
+#define REGISTER_CPU_SPARSE_KERNELS(type, index_type)            \
+  REGISTER_KERNEL_BUILDER(                                       \
+      Name("SparseSegmentSum")                                   \
+          .Device(DEVICE_CPU)                                    \
+          .TypeConstraint<type>("T")                             \
+          .TypeConstraint<index_type>("Tidx"),                   \
+      SparseSegmentReductionSumOp<CPUDevice, type, index_type>); \
+  REGISTER_KERNEL_BUILDER(                                       \
+      Name("SparseSegmentSumWithNumSegments")                    \
+          .Device(DEVICE_CPU)                                    \
+          .TypeConstraint<type>("T")                             \
+          .TypeConstraint<index_type>("Tidx"),                   \
+      SparseSegmentReductionSumWithNumSegmentsOp<CPUDevice, type, index_type>);
+#define REGISTER_CPU_SPARSE_KERNELS_FOR_EACH_INDEX_TYPE(type) \
+  REGISTER_CPU_SPARSE_KERNELS(type, int32);                   \
+  REGISTER_CPU_SPARSE_KERNELS(type, int64);
+TF_CALL_REAL_NUMBER_TYPES(REGISTER_CPU_SPARSE_KERNELS_FOR_EACH_INDEX_TYPE);
+#undef REGISTER_CPU_SPARSE_KERNELS_FOR_EACH_INDEX_TYPE
 #undef REGISTER_CPU_SPARSE_KERNELS
 
-#define REGISTER_CPU_SPARSE_KERNELS(type)                                 \
-  REGISTER_KERNEL_BUILDER(Name("SparseSegmentMean")                       \
-                              .Device(DEVICE_CPU)                         \
-                              .TypeConstraint<type>("T")                  \
-                              .TypeConstraint<int32>("Tidx"),             \
-                          SparseSegmentReductionMeanOp<CPUDevice, type>); \
-  REGISTER_KERNEL_BUILDER(                                                \
-      Name("SparseSegmentMeanWithNumSegments")                            \
-          .Device(DEVICE_CPU)                                             \
-          .TypeConstraint<type>("T")                                      \
-          .TypeConstraint<int32>("Tidx"),                                 \
-      SparseSegmentReductionMeanWithNumSegmentsOp<CPUDevice, type>);
-REGISTER_CPU_SPARSE_KERNELS(float);
-REGISTER_CPU_SPARSE_KERNELS(double);
+#define REGISTER_CPU_SPARSE_KERNELS(type, index_type)             \
+  REGISTER_KERNEL_BUILDER(                                        \
+      Name("SparseSegmentMean")                                   \
+          .Device(DEVICE_CPU)                                     \
+          .TypeConstraint<type>("T")                              \
+          .TypeConstraint<index_type>("Tidx"),                    \
+      SparseSegmentReductionMeanOp<CPUDevice, type, index_type>); \
+  REGISTER_KERNEL_BUILDER(                                        \
+      Name("SparseSegmentMeanWithNumSegments")                    \
+          .Device(DEVICE_CPU)                                     \
+          .TypeConstraint<type>("T")                              \
+          .TypeConstraint<index_type>("Tidx"),                    \
+      SparseSegmentReductionMeanWithNumSegmentsOp<CPUDevice, type, index_type>);
+REGISTER_CPU_SPARSE_KERNELS(float, int32);
+REGISTER_CPU_SPARSE_KERNELS(float, int64);
+REGISTER_CPU_SPARSE_KERNELS(double, int32);
+REGISTER_CPU_SPARSE_KERNELS(double, int64);
 #undef REGISTER_CPU_SPARSE_KERNELS
 
-#define REGISTER_CPU_SPARSE_KERNELS(type)                                  \
-  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSqrtN")                       \
-                              .Device(DEVICE_CPU)                          \
-                              .TypeConstraint<type>("T")                   \
-                              .TypeConstraint<int32>("Tidx"),              \
-                          SparseSegmentReductionSqrtNOp<CPUDevice, type>); \
-  REGISTER_KERNEL_BUILDER(                                                 \
-      Name("SparseSegmentSqrtNWithNumSegments")                            \
-          .Device(DEVICE_CPU)                                              \
-          .TypeConstraint<type>("T")                                       \
-          .TypeConstraint<int32>("Tidx"),                                  \
-      SparseSegmentReductionSqrtNWithNumSegmentsOp<CPUDevice, type>);
-REGISTER_CPU_SPARSE_KERNELS(float);
-REGISTER_CPU_SPARSE_KERNELS(double);
+#define REGISTER_CPU_SPARSE_KERNELS(type, index_type)               \
+  REGISTER_KERNEL_BUILDER(                                          \
+      Name("SparseSegmentSqrtN")                                    \
+          .Device(DEVICE_CPU)                                       \
+          .TypeConstraint<type>("T")                                \
+          .TypeConstraint<index_type>("Tidx"),                      \
+      SparseSegmentReductionSqrtNOp<CPUDevice, type, index_type>);  \
+  REGISTER_KERNEL_BUILDER(                                          \
+      Name("SparseSegmentSqrtNWithNumSegments")                     \
+          .Device(DEVICE_CPU)                                       \
+          .TypeConstraint<type>("T")                                \
+          .TypeConstraint<index_type>("Tidx"),                      \
+      SparseSegmentReductionSqrtNWithNumSegmentsOp<CPUDevice, type, \
+                                                   index_type>);
+REGISTER_CPU_SPARSE_KERNELS(float, int32);
+REGISTER_CPU_SPARSE_KERNELS(float, int64);
+REGISTER_CPU_SPARSE_KERNELS(double, int32);
+REGISTER_CPU_SPARSE_KERNELS(double, int64);
 #undef REGISTER_CPU_SPARSE_KERNELS
 
 template <class T>
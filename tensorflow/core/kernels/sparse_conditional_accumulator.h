@@ -16,7 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SPARSE_CONDITIONAL_ACCUMULATOR_H_
 #define TENSORFLOW_CORE_KERNELS_SPARSE_CONDITIONAL_ACCUMULATOR_H_
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 #include "tensorflow/core/kernels/typed_conditional_accumulator_base.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
 
 namespace tensorflow {
 
@@ -39,6 +45,10 @@ namespace tensorflow {
  * (2) the count of accumulated gradients is reset to 0
  * (3) the internal global_step value (current_global_step_) is incremented by 1
  *
+ * Gradients are summed in place, by index, so that applying a gradient costs
+ * time in the size of that gradient only; the indices of a gradient need not
+ * be sorted or unique. The accumulated gradient is sorted once, when taken.
+ *
  * SparseConditionalAccumulator is the datatype-dependent templated sub-class of
  * ConditionalAccumulatorBase. It implements the virtual arithmetic methods that
  * are used by for aggregating, averaging, allocating, returning indexed slices.
@@ -161,29 +171,17 @@ class SparseConditionalAccumulator
     const Tensor* grad_idx = std::get<0>(*grad);
     const Tensor* grad_val = std::get<1>(*grad);
 
-    const int64 nnz = grad_idx->dim_size(0);
-
-    // Assign indices
+    // Start over with room for the rows of the first gradient.
     if (accum_idx_vec_ != nullptr) delete accum_idx_vec_;
     accum_idx_vec_ = new std::vector<int64>();
-    accum_idx_vec_->reserve(nnz);
-    for (int i = 0; i < nnz; i++) {
-      accum_idx_vec_->push_back(grad_idx->vec<int64>()(i));
-    }
+    if (count_element_ != nullptr) delete count_element_;
+    count_element_ = new std::vector<int>();
+    accum_idx_to_row_.clear();
 
-    // Assign values to accum_val_tensor
-    // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
-    ctx->allocate_persistent(dtype_, grad_val->shape(), accum_val_persistent_,
-                             &accum_val_)
-        .IgnoreError();
-    accum_val_->flat<T>().device(ctx->template eigen_device<Device>()) =
-        grad_val->flat<T>();
-
-    // Assign count_element_
-    if (count_element_ != nullptr) {
-      delete count_element_;
-    }
-    count_element_ = new std::vector<int>(nnz, 1);
+    OP_REQUIRES_OK(ctx, ctx->allocate_persistent(dtype_, grad_val->shape(),
+                                                 accum_val_persistent_,
+                                                 &accum_val_));
+    AddRows(ctx, grad_idx, grad_val);
 
     // Do not need shape; Assume that the op has checked that the shapes match,
     // so grad's shape == shape_
@@ -192,129 +190,7 @@ class SparseConditionalAccumulator
   void AddToAccumGradFunction(
       OpKernelContext* ctx,
       std::tuple<const Tensor*, const Tensor*, const Tensor*>* grad) override {
-    // Modeled after third_party/tensorflow/core/kernels/sparse_add_op
-
-    const Tensor* grad_idx = std::get<0>(*grad);
-    const Tensor* grad_val = std::get<1>(*grad);
-
-    const int64 accum_nnz = accum_idx_vec_->size();
-    const int64 grad_nnz = grad_idx->dim_size(0);
-
-    // Source enumerates the origin of a non-zero element: whether it is from
-    // the new gradient, the accumulated gradient, or the sum of both.
-    enum Source { from_accum, from_grad, from_accum_and_grad };
-
-    // (1) do a pass over inputs, and append values and indices to vectors
-    std::vector<std::tuple<Source, int64, int64>> entries_to_copy;
-    entries_to_copy.reserve(accum_nnz + grad_nnz);
-
-    // Pass over all non-zero elements of both the gradient and the accumulated
-    // value, to identify where each non-zero element of the sum comes from.
-    // The input and output indexed slices are assumed to be ordered along
-    // increasing dimension number.
-    int64 i = 0, j = 0;
-    int64 sum_nnz = 0;
-    while (i < accum_nnz && j < grad_nnz) {
-      sum_nnz++;
-      switch (cmp(accum_idx_vec_, grad_idx, i, j)) {
-        case -1:
-          entries_to_copy.emplace_back(from_accum, i, -1);
-          ++i;
-          break;
-        case 0:
-          entries_to_copy.emplace_back(from_accum_and_grad, i, j);
-          ++i;
-          ++j;
-          break;
-        case 1:
-          entries_to_copy.emplace_back(from_grad, -1, j);
-          ++j;
-          break;
-      }
-    }
-
-    // Handle leftovers
-    while (i < accum_nnz) {
-      sum_nnz++;
-      entries_to_copy.emplace_back(from_accum, i, -1);
-      ++i;
-    }
-    while (j < grad_nnz) {
-      sum_nnz++;
-      entries_to_copy.emplace_back(from_grad, -1, j);
-      ++j;
-    }
-
-    // (2) Copy or sum the non-zero elements into sum_indices and sum_tensor
-    std::vector<int64>* sum_indices_vec = new std::vector<int64>();
-    sum_indices_vec->reserve(sum_nnz);
-
-    std::vector<int>* sum_counts = new std::vector<int>();
-    sum_counts->reserve(sum_nnz);
-
-    Tensor* sum_tensor = nullptr;
-    PersistentTensor* tensor_sum_persistent = new PersistentTensor();
-
-    TensorShape sum_shape = grad_val->shape();
-    sum_shape.set_dim(0, sum_nnz);
-
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_persistent(dtype_, sum_shape, tensor_sum_persistent,
-                                      &sum_tensor));
-    auto sum_flat = sum_tensor->flat_outer_dims<T>();
-    auto accum_flat = accum_val_->flat_outer_dims<T>();
-    auto grad_flat = grad_val->flat_outer_dims<T>();
-
-    const int64 num_col = grad_flat.dimension(1);
-
-    Eigen::DSizes<Eigen::DenseIndex, 1> slice_shape(num_col);
-
-    for (i = 0; i < sum_nnz; ++i) {
-      const Source src = std::get<0>(entries_to_copy[i]);
-      const int64 idx_a = std::get<1>(entries_to_copy[i]);
-      const int64 idx_b = std::get<2>(entries_to_copy[i]);
-      T* sum_slice_ptr = &sum_flat(i, 0);
-      SliceT sum_slice(sum_slice_ptr, slice_shape);
-      if (src == from_accum) {
-        // Element comes from accumulator; directly copy data structures over
-        sum_indices_vec->push_back(accum_idx_vec_->at(idx_a));
-        T* accum_slice_ptr = &accum_flat(idx_a, 0);
-        SliceT accum_slice(accum_slice_ptr, slice_shape);
-        sum_slice = accum_slice;
-        sum_counts->push_back(count_element_->at(idx_a));
-      } else if (src == from_accum_and_grad) {
-        // Element is a sum of accumulated value and new gradient;
-        // compute sum here
-        sum_indices_vec->push_back(accum_idx_vec_->at(idx_a));
-        const T* grad_slice_ptr = &grad_flat(idx_b, 0);
-        SliceConstT grad_slice(grad_slice_ptr, slice_shape);
-        T* accum_slice_ptr = &accum_flat(idx_a, 0);
-        SliceT accum_slice(accum_slice_ptr, slice_shape);
-        sum_slice = grad_slice + accum_slice;
-        sum_counts->push_back(count_element_->at(idx_a) + 1);
-      } else if (src == from_grad) {
-        // Element comes from new gradient; make a copy of indices and values
-        sum_indices_vec->push_back(grad_idx->vec<int64>()(idx_b));
-        const T* grad_slice_ptr = &grad_flat(idx_b, 0);
-        SliceConstT grad_slice(grad_slice_ptr, slice_shape);
-        sum_slice = grad_slice;
-        sum_counts->push_back(1);
-      }
-    }
-
-    // (3) Keep output, i.e., switch pointers to point to new data structures
-    // representing the sum
-    // Indices
-    if (accum_idx_vec_ != nullptr) delete accum_idx_vec_;
-    accum_idx_vec_ = sum_indices_vec;
-    // Values
-    accum_val_ = sum_tensor;
-    delete accum_val_persistent_;
-    accum_val_persistent_ = tensor_sum_persistent;
-    // Counts
-    if (count_element_ != nullptr) delete count_element_;
-    count_element_ = sum_counts;
-
+    AddRows(ctx, std::get<0>(*grad), std::get<1>(*grad));
     // No need to copy shape, since shape remains the same after sum.
   }
 
@@ -346,9 +222,11 @@ class SparseConditionalAccumulator
   }
 
   bool SetOutput(OpKernelContext* ctx) override {
+    // The gradient is returned sorted by index.
+    const std::vector<int64> rows = SortedRows();
     bool is_successful = true;
-    if (is_successful) is_successful = ReturnIdxTensor(ctx);
-    if (is_successful) is_successful = ReturnValTensor(ctx);
+    if (is_successful) is_successful = ReturnIdxTensor(ctx, rows);
+    if (is_successful) is_successful = ReturnValTensor(ctx, rows);
     if (is_successful) is_successful = ReturnShapeTensor(ctx);
     return is_successful;
   }
@@ -407,33 +285,124 @@ class SparseConditionalAccumulator
   }
 
  private:
-  inline int cmp(std::vector<int64>* a_idx, const Tensor* b_idx,
-                 const int64 a_row, const int64 b_row) {
-    const int64 a = a_idx->at(a_row);
-    const int64 b = b_idx->vec<int64>()(b_row);
-    if (a < b) {
-      return -1;
-    } else if (a > b) {
-      return 1;
+  // Maps an index of the accumulated gradient to its row in accum_val_.
+  gtl::FlatMap<int64, int64> accum_idx_to_row_;
+
+  // Sums the slices of a gradient into the rows of their indices, in place.
+  // The rows of accum_val_ are kept in the order their indices were first
+  // seen, and accum_val_ may have more rows than there are indices, so that
+  // applying a gradient costs time in its own size rather than in the size of
+  // the accumulated gradient. Indices need not be sorted or unique.
+  void AddRows(OpKernelContext* ctx, const Tensor* grad_idx,
+               const Tensor* grad_val) EXCLUSIVE_LOCKS_REQUIRED(this->mu_) {
+    const auto grad_idx_vec = grad_idx->vec<int64>();
+    const int64 grad_nnz = grad_idx->dim_size(0);
+    const int64 old_nnz = accum_idx_vec_->size();
+
+    // (1) Find the row of every slice, assigning rows to new indices. A row
+    // counts each gradient once, however many of its slices it sums.
+    std::vector<int64> rows(grad_nnz);
+    gtl::FlatSet<int64> rows_seen;
+    for (int64 j = 0; j < grad_nnz; ++j) {
+      const int64 index = grad_idx_vec(j);
+      auto it = accum_idx_to_row_.insert({index, accum_idx_vec_->size()});
+      if (it.second) {
+        accum_idx_vec_->push_back(index);
+        count_element_->push_back(0);
+      }
+      rows[j] = it.first->second;
+      if (rows_seen.insert(rows[j]).second) {
+        (*count_element_)[rows[j]]++;
+      }
+    }
+    const int64 sum_nnz = accum_idx_vec_->size();
+
+    // (2) Make room for the new rows, at least doubling the capacity so that
+    // growing costs amortized constant time per row.
+    if (sum_nnz > accum_val_->dim_size(0)) {
+      TensorShape sum_shape = grad_val->shape();
+      sum_shape.set_dim(0, std::max(sum_nnz, 2 * accum_val_->dim_size(0)));
+      Tensor* sum_tensor = nullptr;
+      PersistentTensor* tensor_sum_persistent = new PersistentTensor();
+      Status s = ctx->allocate_persistent(dtype_, sum_shape,
+                                          tensor_sum_persistent, &sum_tensor);
+      if (!s.ok()) {
+        // Leave the accumulated gradient as it was.
+        delete tensor_sum_persistent;
+        for (int64 row : rows_seen) {
+          (*count_element_)[row]--;
+        }
+        for (int64 i = old_nnz; i < sum_nnz; ++i) {
+          accum_idx_to_row_.erase((*accum_idx_vec_)[i]);
+        }
+        accum_idx_vec_->resize(old_nnz);
+        count_element_->resize(old_nnz);
+        ctx->CtxFailureWithWarning(s);
+        return;
+      }
+      if (old_nnz > 0) {
+        sum_tensor->Slice(0, old_nnz).unaligned_flat<T>() =
+            accum_val_->Slice(0, old_nnz).unaligned_flat<T>();
+      }
+      accum_val_ = sum_tensor;
+      delete accum_val_persistent_;
+      accum_val_persistent_ = tensor_sum_persistent;
+    }
+    if (sum_nnz > old_nnz) {
+      accum_val_->Slice(old_nnz, sum_nnz).unaligned_flat<T>().setZero();
+    }
+
+    // (3) Sum the slices into their rows.
+    auto accum_flat = accum_val_->flat_outer_dims<T>();
+    auto grad_flat = grad_val->flat_outer_dims<T>();
+    Eigen::DSizes<Eigen::DenseIndex, 1> slice_shape(grad_flat.dimension(1));
+    for (int64 j = 0; j < grad_nnz; ++j) {
+      SliceT accum_slice(&accum_flat(rows[j], 0), slice_shape);
+      SliceConstT grad_slice(&grad_flat(j, 0), slice_shape);
+      accum_slice = accum_slice + grad_slice;
     }
-    return 0;
   }
 
-  inline bool ReturnIdxTensor(OpKernelContext* ctx) {
+  // Returns the positions of the accumulated indices in increasing order.
+  std::vector<int64> SortedRows() {
+    std::vector<int64> rows(accum_idx_vec_->size());
+    std::iota(rows.begin(), rows.end(), 0);
+    std::sort(rows.begin(), rows.end(), [this](int64 a, int64 b) {
+      return (*accum_idx_vec_)[a] < (*accum_idx_vec_)[b];
+    });
+    return rows;
+  }
+
+  inline bool ReturnIdxTensor(OpKernelContext* ctx,
+                              const std::vector<int64>& rows) {
     Tensor* idx_tensor;
-    const int64 nnz = accum_idx_vec_->size();
+    const int64 nnz = rows.size();
     OP_REQUIRES_OK_BOOLEAN(ctx, ctx->allocate_output(0, {nnz}, &idx_tensor));
     // If allocate_output fails, OP_REQUIRES_OK_BOOLEAN will short-circuit
     // the remaining code and just return false
     auto idx_tensor_vec = idx_tensor->vec<int64>();
-    for (int i = 0; i < nnz; ++i) {
-      idx_tensor_vec(i) = accum_idx_vec_->at(i);
+    for (int64 i = 0; i < nnz; ++i) {
+      idx_tensor_vec(i) = (*accum_idx_vec_)[rows[i]];
     }
     return true;
   }
 
-  inline bool ReturnValTensor(OpKernelContext* ctx) {
-    ctx->set_output(1, *accum_val_);
+  inline bool ReturnValTensor(OpKernelContext* ctx,
+                              const std::vector<int64>& rows) {
+    const int64 nnz = rows.size();
+    TensorShape val_shape = accum_val_->shape();
+    val_shape.set_dim(0, nnz);
+    Tensor* val_tensor;
+    OP_REQUIRES_OK_BOOLEAN(ctx,
+                           ctx->allocate_output(1, val_shape, &val_tensor));
+    auto val_flat = val_tensor->flat_outer_dims<T>();
+    auto accum_flat = accum_val_->flat_outer_dims<T>();
+    Eigen::DSizes<Eigen::DenseIndex, 1> slice_shape(accum_flat.dimension(1));
+    for (int64 i = 0; i < nnz; ++i) {
+      SliceT val_slice(&val_flat(i, 0), slice_shape);
+      SliceT accum_slice(&accum_flat(rows[i], 0), slice_shape);
+      val_slice = accum_slice;
+    }
     return true;
   }
 
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -246,6 +248,9 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
   // Vectorize certain operations above this size.
   static const std::size_t kNumVectorize = 32;
 
+  // The nonzeros of a are first sorted by output row into a CSR layout, so
+  // that output rows can be computed in parallel, each by accumulating the
+  // rows of b selected by its nonzeros.
   static Status Compute(const CPUDevice& d, typename TTypes<T>::Matrix out,
                         typename TTypes<Tindices>::ConstMatrix a_indices,
                         typename TTypes<T>::ConstVec a_values,
@@ -255,63 +260,78 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
     const int lhs_index_a = ADJ_A ? 1 : 0;
     const int rhs_index_a = ADJ_A ? 0 : 1;
+    const int64 out_rows = out.dimension(0);
 
     out.setZero();
 
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
-
-    if (rhs_right < kNumVectorize) {
-      // Disable vectorization if the RHS of output is too small
-      auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
-
+    // Convert a to CSR: the column indices and values of the nonzeros of row
+    // m are at [row_starts[m], row_starts[m + 1]) in csr_cols and csr_values,
+    // in their original order.
+    std::vector<int64> row_starts(out_rows + 1, 0);
+    std::vector<int64> rows(nnz);
+    std::vector<int64> cols(nnz);
+    for (std::size_t i = 0; i < nnz; ++i) {
+      const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+      const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+      if (!FastBoundsCheck(k, lhs_right)) {
+        return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+      }
+      if (!FastBoundsCheck(m, out_rows)) {
+        return MOutOfBoundsError(m, i, lhs_index_a, out_rows);
+      }
+      rows[i] = m;
+      cols[i] = k;
+      ++row_starts[m + 1];
+    }
+    for (int64 m = 0; m < out_rows; ++m) {
+      row_starts[m + 1] += row_starts[m];
+    }
+    std::vector<int64> csr_cols(nnz);
+    std::vector<T> csr_values(nnz);
+    {
+      std::vector<int64> next(row_starts.begin(), row_starts.end() - 1);
       for (std::size_t i = 0; i < nnz; ++i) {
-        const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
-        const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
-        if (!FastBoundsCheck(k, lhs_right)) {
-          return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
-        }
-        if (!FastBoundsCheck(m, out.dimension(0))) {
-          return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
-        }
-        const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
-        for (std::size_t n = 0; n < rhs_right; ++n) {
-          const T b_value = maybe_adjoint_b(k, n);
-          out(m, n) += a_value * b_value;
-        }
+        const int64 j = next[rows[i]]++;
+        csr_cols[j] = cols[i];
+        csr_values[j] = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
       }
-    } else {
-      // Vectorization via Eigen.
-      const int b_chip_index = ADJ_B ? 1 : 0;
-
-#define LOOP_NNZ(b_passed)                                                  \
-  for (std::size_t i = 0; i < nnz; ++i) {                                   \
-    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a)); \
-    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a)); \
-    const T a_value = (ADJ_A) ? MaybeConj(a_values(i)) : a_values(i);       \
-    if (!FastBoundsCheck(k, lhs_right)) {                                   \
-      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);               \
-    }                                                                       \
-    if (!FastBoundsCheck(m, out.dimension(0))) {                            \
-      return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));        \
-    }                                                                       \
-    out.template chip<0>(m) +=                                              \
-        b_passed.template chip<b_chip_index>(k) * a_value;                  \
-  }
+    }
 
-      if (ADJ_B) {
-        // Perform transpose and conjugation on B once, since we chip out B's
-        // columns in the nnz loop.
-        Eigen::array<int, 2> shuffle(1, 0);  // preserve dimension order
-        Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b =
-            b.swap_layout().shuffle(shuffle).conjugate();
-        LOOP_NNZ(col_major_conj_b);
-      } else {
-        LOOP_NNZ(b);
-      }
-#undef LOOP_NNZ
+    // Rows of the (adjoint of the) right hand side, made contiguous once since
+    // they are read for every nonzero.
+    Eigen::Tensor<T, 2, Eigen::RowMajor> b_adjoint;
+    if (ADJ_B) {
+      Eigen::array<int, 2> shuffle(1, 0);
+      b_adjoint = b.shuffle(shuffle).conjugate();
     }
+    typename TTypes<T>::ConstMatrix b_rows(
+        ADJ_B ? b_adjoint.data() : b.data(), lhs_right, rhs_right);
+
+    auto compute_rows = [&](int64 begin, int64 end) {
+      for (int64 m = begin; m < end; ++m) {
+        for (int64 j = row_starts[m]; j < row_starts[m + 1]; ++j) {
+          const int64 k = csr_cols[j];
+          const T a_value = csr_values[j];
+          if (rhs_right < kNumVectorize) {
+            for (std::size_t n = 0; n < rhs_right; ++n) {
+              out(m, n) += a_value * b_rows(k, n);
+            }
+          } else {
+            // Vectorization via Eigen.
+            out.template chip<0>(m) += b_rows.template chip<0>(k) * a_value;
+          }
+        }
+      }
+    };
+    const double nnz_per_row =
+        out_rows == 0 ? 0.0 : static_cast<double>(nnz) / out_rows;
+    const Eigen::TensorOpCost cost(
+        nnz_per_row * rhs_right * sizeof(T),
+        rhs_right * sizeof(T),
+        nnz_per_row * rhs_right *
+            (Eigen::TensorOpCost::AddCost<T>() +
+             Eigen::TensorOpCost::MulCost<T>()));
+    d.parallelFor(out_rows, cost, compute_rows);
     return Status::OK();
   }
 };
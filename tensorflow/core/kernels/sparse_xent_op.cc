@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -96,8 +97,11 @@ class SparseSoftmaxXentWithLogitsOp : public OpKernel {
   }
 };
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from XentEigenImpl.
+// Partial specialization for a CPUDevice. Rather than running the whole-batch
+// reductions of SparseXentEigenImpl, it computes the rows in parallel, each
+// with three passes while the row is in cache: the max logit, the
+// exponentials and their sum, and the normalization. The exponentials are
+// stored in `backprop`, which may be the buffer of `logits`.
 namespace functor {
 template <typename T, typename Index>
 struct SparseXentFunctor<CPUDevice, T, Index> {
@@ -105,8 +109,36 @@ struct SparseXentFunctor<CPUDevice, T, Index> {
                   typename TTypes<Index>::ConstVec labels,
                   typename TTypes<T>::Vec scratch, typename TTypes<T>::Vec loss,
                   typename TTypes<T>::Matrix backprop) {
-    SparseXentEigenImpl<CPUDevice, T, Index>::Compute(ctx, logits, labels,
-                                                      scratch, loss, backprop);
+    const int64 num_classes = logits.dimension(1);
+    auto compute_rows = [&logits, &labels, &loss, &backprop, num_classes](
+                            int64 start, int64 end) {
+      for (int64 b = start; b < end; ++b) {
+        typename TTypes<T>::UnalignedConstVec logits_row(&logits(b, 0),
+                                                         num_classes);
+        typename TTypes<T>::UnalignedVec backprop_row(&backprop(b, 0),
+                                                      num_classes);
+        const Index label = labels(b);
+        const Eigen::Tensor<T, 0, Eigen::RowMajor> max_logit =
+            logits_row.maximum();
+        // Read before the logits can be overwritten.
+        const T label_logit = logits_row(label) - max_logit();
+        backprop_row = (logits_row - logits_row.constant(max_logit())).exp();
+        const Eigen::Tensor<T, 0, Eigen::RowMajor> sum_exp =
+            backprop_row.sum();
+        loss(b) = Eigen::numext::log(sum_exp()) - label_logit;
+        backprop_row = backprop_row / backprop_row.constant(sum_exp());
+        backprop_row(label) -= T(1);
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    const int64 cost_per_row =
+        num_classes * (4 * Eigen::TensorOpCost::AddCost<T>() +
+                       Eigen::TensorOpCost::DivCost<T>() +
+                       Eigen::internal::functor_traits<
+                           Eigen::internal::scalar_exp_op<T>>::Cost);
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          logits.dimension(0), cost_per_row, compute_rows);
   }
 };
 }  // namespace functor
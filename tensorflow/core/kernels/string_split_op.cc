@@ -28,39 +28,36 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 // Split input string `str` based on a character delimiter.
-// Returns a vector of StringPieces which are valid as long as input `str`
+// Appends to `result` StringPieces which are valid as long as input `str`
 // is valid.
 // Note: The single character delimiter is a common case and is implemented as
 // a series of finds in the input string, making it much more effcient than
 // SplitOnCharSet.
 template <typename Predicate>
-std::vector<StringPiece> SplitOnChar(const string& str, const char delim,
-                                     Predicate p) {
-  std::vector<StringPiece> result;
+void SplitOnChar(const string& str, const char delim, Predicate p,
+                 std::vector<StringPiece>* result) {
   StringPiece text(str);
   auto f = text.find(delim);
   while (f != StringPiece::npos) {
     StringPiece token = text.substr(0, f);
     if (p(token)) {
-      result.emplace_back(token);
+      result->emplace_back(token);
     }
     text.remove_prefix(f + 1);
     f = text.find(delim);
   }
   if (p(text)) {
-    result.push_back(text);
+    result->push_back(text);
   }
-  return result;
 }
 
 // Split input string `str` based on a set of character delimiters.
-// Returns a vector of StringPieces which are valid as long as input `str`
+// Appends to `result` StringPieces which are valid as long as input `str`
 // is valid.
 // Based on str_util::Split.
 template <typename Predicate>
-std::vector<StringPiece> SplitOnCharSet(const string& str,
-                                        const string& delim_set, Predicate p) {
-  std::vector<StringPiece> result;
+void SplitOnCharSet(const string& str, const string& delim_set, Predicate p,
+                    std::vector<StringPiece>* result) {
   StringPiece text(str);
   StringPiece delims(delim_set);
   size_t token_start = 0;
@@ -68,39 +65,39 @@ std::vector<StringPiece> SplitOnCharSet(const string& str,
     if ((i == text.size()) || (delims.find(text[i]) != StringPiece::npos)) {
       StringPiece token(text.data() + token_start, i - token_start);
       if (p(token)) {
-        result.emplace_back(token);
+        result->emplace_back(token);
       }
       token_start = i + 1;
     }
   }
-  return result;
 }
 
 // Split input string `str` based on given delimiter.
-// Returns a vector of StringPieces which are valid as long as input `str`
-// is valid.
+// Appends to `result` StringPieces which are valid as long as input `str`
+// is valid. Appending, rather than returning a new vector for each string,
+// lets the kernels collect the tokens of a whole batch without allocating
+// per string.
 template <typename Predicate>
-std::vector<StringPiece> Split(const string& str, const string& delimiter,
-                               Predicate predicate) {
+void Split(const string& str, const string& delimiter, Predicate predicate,
+           std::vector<StringPiece>* result) {
   if (str.empty()) {
-    return std::vector<StringPiece>();
+    return;
   }
   if (delimiter.empty()) {
-    std::vector<StringPiece> result;
-    result.resize(str.size());
     for (size_t i = 0; i < str.size(); ++i) {
-      result[i] = StringPiece(str.data() + i, 1);
+      result->emplace_back(str.data() + i, 1);
     }
-    return result;
+    return;
   }
   if (delimiter.size() == 1) {
-    return SplitOnChar(str, delimiter[0], predicate);
+    SplitOnChar(str, delimiter[0], predicate, result);
+    return;
   }
-  return SplitOnCharSet(str, delimiter, predicate);
+  SplitOnCharSet(str, delimiter, predicate, result);
 }
 
-std::vector<StringPiece> SplitV2(const string& str, StringPiece sep,
-                                 int maxsplit) {
+void SplitV2(const string& str, StringPiece sep, int maxsplit,
+             std::vector<StringPiece>* result) {
   // This SplitV2 method matches the behavior of python's str.split:
   //   If sep is given, consecutive delimiters are not grouped together
   //   and are deemed to delimit empty strings (for example, '1,,2'.split(',')
@@ -115,12 +112,10 @@ std::vector<StringPiece> SplitV2(const string& str, StringPiece sep,
   //   splitting an empty string or a string consisting of just whitespace
   //   with a None separator returns [].
 
-  std::vector<StringPiece> result;
-
   StringPiece text(str);
   if (maxsplit == 0) {
-    result.emplace_back(text);
-    return result;
+    result->emplace_back(text);
+    return;
   }
 
   if (sep.empty()) {
@@ -129,32 +124,31 @@ std::vector<StringPiece> SplitV2(const string& str, StringPiece sep,
     str_util::RemoveLeadingWhitespace(&text);
     int split = 0;
     while (str_util::ConsumeNonWhitespace(&text, &token)) {
-      result.push_back(token);
+      result->push_back(token);
       str_util::RemoveLeadingWhitespace(&text);
       ++split;
       if (maxsplit > 0 && split == maxsplit) {
-        result.push_back(text);
-        return result;
+        result->push_back(text);
+        return;
       }
     }
-    return result;
+    return;
   }
   auto p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
   int split = 0;
   while (p != text.end()) {
     StringPiece token = text.substr(0, p - text.begin());
-    result.push_back(token);
+    result->push_back(token);
     text.remove_prefix(token.size());
     text.remove_prefix(sep.size());
     ++split;
     if (maxsplit > 0 && split == maxsplit) {
-      result.push_back(StringPiece(text));
-      return result;
+      result->push_back(StringPiece(text));
+      return;
     }
     p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
   }
-  result.push_back(text);
-  return result;
+  result->push_back(text);
 }
 
 }  // namespace
@@ -199,15 +193,16 @@ class StringSplitOp : public OpKernel {
     int64 max_num_entries = 0;
     std::vector<int64> num_indices(batch_size);
     for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<StringPiece> parts =
-          skip_empty_ ? Split(input_vec(i), delimiter, str_util::SkipEmpty())
-                      : Split(input_vec(i), delimiter, str_util::AllowEmpty());
-      int64 n_entries = parts.size();
+      const size_t num_tokens_before = tokens.size();
+      if (skip_empty_) {
+        Split(input_vec(i), delimiter, str_util::SkipEmpty(), &tokens);
+      } else {
+        Split(input_vec(i), delimiter, str_util::AllowEmpty(), &tokens);
+      }
+      int64 n_entries = tokens.size() - num_tokens_before;
       num_indices[i] = n_entries;
       output_size += n_entries;
       max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), std::make_move_iterator(parts.begin()),
-                    std::make_move_iterator(parts.end()));
     }
 
     Tensor* sp_indices_t;
@@ -272,12 +267,12 @@ class StringSplitV2Op : public OpKernel {
     int64 max_num_entries = 0;
     std::vector<int64> num_indices(batch_size);
     for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<StringPiece> parts = SplitV2(input_vec(i), sep, maxsplit_);
-      int64 n_entries = parts.size();
+      const size_t num_tokens_before = tokens.size();
+      SplitV2(input_vec(i), sep, maxsplit_, &tokens);
+      int64 n_entries = tokens.size() - num_tokens_before;
       num_indices[i] = n_entries;
       output_size += n_entries;
       max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), parts.begin(), parts.end());
     }
 
     Tensor* sp_indices_t;
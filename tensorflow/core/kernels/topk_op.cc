@@ -28,7 +28,6 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/lib/gtl/top_n.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -99,6 +98,81 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+namespace {
+
+// Returns whether input[a] comes before input[b] in the output of TopK: larger
+// values first, and equal values by increasing index.
+template <typename T>
+struct TopKOrder {
+  bool operator()(const int32 a, const int32 b) const {
+    if (input[b] < input[a]) {
+      return true;
+    } else if (input[b] > input[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  }
+  const T* input;
+};
+
+// Appends to `top` the indices of the top k elements of input[begin, end) in
+// no particular order, or of all of them if there are fewer than k.
+//
+// Only the elements larger than the k-th largest element seen so far can be
+// among the top k, since ties go to the lower index. Candidates are filtered
+// by that threshold into a buffer of at most 2k elements, which is cut back
+// to the top k whenever it fills up. Blocks of elements whose maximum, a
+// vectorizable reduction, is not above the threshold are skipped entirely.
+template <typename T>
+void FindTopK(const T* input, int32 begin, int32 end, int k,
+              std::vector<int32>* top) {
+  constexpr int32 kBlockSize = 64;
+  const TopKOrder<T> order{input};
+  std::vector<int32> candidates;
+  candidates.reserve(2 * k + kBlockSize);
+  int32 c = begin;
+  for (; c < end && candidates.size() < static_cast<size_t>(k); ++c) {
+    candidates.push_back(c);
+  }
+  T threshold{};
+  auto keep_top_k = [&]() {
+    std::nth_element(candidates.begin(), candidates.begin() + (k - 1),
+                     candidates.end(), order);
+    candidates.resize(k);
+    threshold = input[candidates[k - 1]];
+  };
+  if (c < end) {
+    keep_top_k();
+  }
+  for (; c < end; c += kBlockSize) {
+    const int32 block_end = std::min(end, c + kBlockSize);
+    T block_max = input[c];
+    for (int32 i = c + 1; i < block_end; ++i) {
+      block_max = std::max(block_max, input[i]);
+    }
+    if (!(threshold < block_max)) continue;
+    for (int32 i = c; i < block_end; ++i) {
+      if (threshold < input[i]) {
+        candidates.push_back(i);
+      }
+    }
+    if (candidates.size() >= 2 * static_cast<size_t>(k)) {
+      keep_top_k();
+    }
+  }
+  if (candidates.size() > static_cast<size_t>(k)) {
+    keep_top_k();
+  }
+  top->insert(top->end(), candidates.begin(), candidates.end());
+}
+
+// Rows with at least this many columns per thread are split across threads
+// when there are fewer rows than threads.
+constexpr int64 kMinColsPerSegment = 1 << 14;
+
+}  // namespace
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status
@@ -137,23 +211,9 @@ struct TopKFunctor<CPUDevice, T> {
     auto SortIndices = [&](int start_batch, int limit_batch) {
       for (int32 b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
-        const auto stable_comp = [input_data](const int32 a, const int32 b) {
-          if (input_data[b] < input_data[a]) {
-            return true;
-          } else if (input_data[b] > input_data[a]) {
-            return false;
-          } else {
-            return a < b;
-          }
-        };
         const auto comp = [input_data](const int32 a, const int32 b) {
           return input_data[b] < input_data[a];
         };
-        // TODO(ebrevdo): For large k < num_cols, instead of using
-        // TopN, it may be faster to create a temporary vector of
-        // values 0..num_cols - 1 and then use std::partial_sort_copy
-        // of this into indices. Choosing the appropriate minimum k or
-        // ratio of k/num_cols will require some experimentation.
         if (k == num_cols) {
           auto* begin = &indices(b, 0);
           auto* end = &indices(b, k);
@@ -177,26 +237,13 @@ struct TopKFunctor<CPUDevice, T> {
             run_begin = run_end;
           }
         } else {
-          // Use the TopN heap object to sort.
-          gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
-          filter.reserve(num_cols);
-          for (int32 c = 0; c < num_cols; ++c) {
-            filter.push(c);
-          }
-
-          int32 i = 0;
-          if (sorted) {
-            std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
-            for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
-                 ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          } else {
-            for (auto top_k_it = filter.unsorted_begin();
-                 top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          }
+          std::vector<int32> top_k;
+          top_k.reserve(k);
+          FindTopK(input_data, 0, num_cols, k, &top_k);
+          // Sorting k elements is cheap compared to finding them, so the
+          // output is sorted even if that is not required.
+          std::sort(top_k.begin(), top_k.end(), TopKOrder<T>{input_data});
+          std::copy(top_k.begin(), top_k.end(), &indices(b, 0));
         }
         // Now that the indices are sorted, copy the values over in
         // sorted order.
@@ -220,6 +267,51 @@ struct TopKFunctor<CPUDevice, T> {
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // Split large rows into segments when there are not enough rows to keep
+    // all threads busy. The top k of each segment are found in parallel, and
+    // then merged into the top k of the row.
+    const int64 num_segments =
+        k < num_cols && num_rows < worker_threads.num_threads
+            ? std::min<int64>(
+                  worker_threads.num_threads / num_rows,
+                  num_cols / std::max<int64>(kMinColsPerSegment, 4 * k))
+            : 1;
+    if (num_segments > 1) {
+      const int64 segment_size = (num_cols + num_segments - 1) / num_segments;
+      std::vector<std::vector<int32>> segment_top_k(num_rows * num_segments);
+      auto find_segment_top_k = [&](int64 start, int64 limit) {
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / num_segments;
+          const int64 begin = (i % num_segments) * segment_size;
+          const int64 end = std::min(num_cols, begin + segment_size);
+          FindTopK(&input(b, 0), begin, end, k, &segment_top_k[i]);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers,
+            num_rows * num_segments, final_cost / num_segments,
+            find_segment_top_k);
+
+      for (int64 b = 0; b < num_rows; ++b) {
+        const T* input_data = &input(b, 0);
+        std::vector<int32> candidates;
+        for (int64 i = b * num_segments; i < (b + 1) * num_segments; ++i) {
+          candidates.insert(candidates.end(), segment_top_k[i].begin(),
+                            segment_top_k[i].end());
+        }
+        const TopKOrder<T> order{input_data};
+        std::nth_element(candidates.begin(), candidates.begin() + (k - 1),
+                         candidates.end(), order);
+        candidates.resize(k);
+        std::sort(candidates.begin(), candidates.end(), order);
+        for (int i = 0; i < k; ++i) {
+          indices(b, i) = candidates[i];
+          values(b, i) = input_data[candidates[i]];
+        }
+      }
+      return Status::OK();
+    }
+
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
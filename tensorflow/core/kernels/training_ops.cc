@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/training_ops.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/lib/hash/hash.h"
 
 #ifdef TENSORFLOW_USE_SYCL
 #include "tensorflow/core/common_runtime/sycl/sycl_util.h"
@@ -43,6 +44,63 @@ inline T sgn(const T x) {
   T one(1);
   return (x == zero ? zero : (x < zero ? -one : one));
 }
+
+// Calls `update(i)` for every i in [0, N) on the intra-op threads of `d`,
+// where `cost` is the cost of one call. The indices are sharded by a hash of
+// the row, so all updates of a row run on one thread in the order of i:
+// distinct rows are updated in parallel without locks, and duplicate indices
+// are applied one after another as in a serial loop. Hashing spreads strided
+// rows, e.g. the rows of one embedding partition, over all the shards. The
+// indices must be in bounds.
+template <typename Tindex, typename Update>
+void ParallelSparseUpdate(const CPUDevice& d,
+                          typename TTypes<Tindex>::ConstVec indices,
+                          const Eigen::TensorOpCost& cost,
+                          const Update& update) {
+  const Tindex N = indices.size();
+  // Aim for shards of at least ~100k cycles, as Eigen's parallelFor does.
+  const double kMinCostPerShard = 100000;
+  const double total_cost =
+      Eigen::TensorCostModel<CPUDevice>::totalCost(N, cost);
+  const int64 num_shards =
+      std::min<int64>(d.numThreads() + 1,
+                      static_cast<int64>(total_cost / kMinCostPerShard) + 1);
+  if (num_shards <= 1) {
+    for (Tindex i = 0; i < N; ++i) {
+      update(i);
+    }
+    return;
+  }
+
+  // Bucket the positions of the indices by shard with a counting sort, which
+  // keeps the positions of each shard in increasing order.
+  std::vector<int64> shards(N);
+  std::vector<Tindex> shard_start(num_shards + 1, 0);
+  for (Tindex i = 0; i < N; ++i) {
+    const int64 row = internal::SubtleMustCopy(indices(i));
+    shards[i] =
+        Hash64(reinterpret_cast<const char*>(&row), sizeof(row)) % num_shards;
+    ++shard_start[shards[i] + 1];
+  }
+  for (int64 s = 0; s < num_shards; ++s) {
+    shard_start[s + 1] += shard_start[s];
+  }
+  std::vector<Tindex> positions(N);
+  std::vector<Tindex> next(shard_start.begin(), shard_start.end() - 1);
+  for (Tindex i = 0; i < N; ++i) {
+    positions[next[shards[i]]++] = i;
+  }
+
+  d.parallelFor(num_shards, cost * (static_cast<double>(N) / num_shards),
+                [&](Eigen::Index first, Eigen::Index last) {
+                  for (Eigen::Index s = first; s < last; ++s) {
+                    for (Tindex j = shard_start[s]; j < shard_start[s + 1];
+                         ++j) {
+                      update(positions[j]);
+                    }
+                  }
+                });
+}
 }  // namespace
 
 namespace functor {
@@ -1452,20 +1510,18 @@ class SparseApplyAdagradOp : public OpKernel {
                                           " in indices is out of range")));
         }
 
-        const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
-          for (Tindex i = start_idx; i < end_idx; ++i) {
-            const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-            auto a = accum_flat.template chip<0>(index);
-            auto g = grad_flat.template chip<0>(i);
-            auto v = var_flat.template chip<0>(index);
-            if (update_slots_) {
-              a += g.square();
-            }
-            v -= g.constant(lr_scalar) * g * a.rsqrt();
+        const auto update = [&](Tindex i) {
+          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
+          auto a = accum_flat.template chip<0>(index);
+          auto g = grad_flat.template chip<0>(i);
+          auto v = var_flat.template chip<0>(index);
+          if (update_slots_) {
+            a += g.square();
           }
+          v -= g.constant(lr_scalar) * g * a.rsqrt();
         };
 
-        d.parallelFor(N, cost, shard);
+        ParallelSparseUpdate<Tindex>(d, indices_vec, cost, update);
 
       } else {
         auto indices_vec = indices.vec<Tindex>();
@@ -1483,19 +1539,17 @@ class SparseApplyAdagradOp : public OpKernel {
                                           " in indices is out of range")));
         }
 
-        const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
-          for (Tindex i = start_idx; i < end_idx; ++i) {
-            const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-            T& a = accum_flat(index);
-            const T& g = grad_flat(i);
-            if (update_slots_) {
-              a += g * g;
-            }
-            var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
+        const auto update = [&](Tindex i) {
+          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
+          T& a = accum_flat(index);
+          const T& g = grad_flat(i);
+          if (update_slots_) {
+            a += g * g;
           }
+          var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
         };
 
-        d.parallelFor(N, cost, shard);
+        ParallelSparseUpdate<Tindex>(d, indices_vec, cost, update);
       }
     }
 
@@ -2267,6 +2321,15 @@ class SparseApplyFtrlOp : public OpKernel {
                                   l2_shrinkage->shape().DebugString()));
     }
 
+    // This op is implemented only for CPU device.
+    const auto& d = ctx->eigen_cpu_device();
+    const int in_bytes = inner_dim * sizeof(T) * 4;
+    const int out_bytes = inner_dim * sizeof(T) * 3;
+    const int cycles = inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 8 +
+                                    Eigen::TensorOpCost::MulCost<T>() * 6 +
+                                    Eigen::TensorOpCost::DivCost<T>() * 2);
+    const Eigen::TensorOpCost cost(in_bytes, out_bytes, cycles);
+
     if (N > 0) {
       if (inner_dim > 1) {
         const Tindex first_dim_size = var.dim_size(0);
@@ -2290,6 +2353,10 @@ class SparseApplyFtrlOp : public OpKernel {
                       errors::InvalidArgument(
                           strings::StrCat("Index ", index, " at offset ", i,
                                           " in indices is out of range")));
+        }
+
+        const auto update = [&](Tindex i) {
+          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
           auto accum = accum_flat.template chip<0>(index);
           auto linear = linear_flat.template chip<0>(index);
           auto grad = grad_flat.template chip<0>(i);
@@ -2327,8 +2394,10 @@ class SparseApplyFtrlOp : public OpKernel {
           } else {
             COMPUTE_FTRL(grad, grad);
           }
-        }
+        };
 #undef COMPUTE_FTRL
+
+        ParallelSparseUpdate<Tindex>(d, indices_vec, cost, update);
       } else {
         T lr_scalar = lr.scalar<T>()();
         T l1_scalar = l1.scalar<T>()();
@@ -2352,6 +2421,10 @@ class SparseApplyFtrlOp : public OpKernel {
                       errors::InvalidArgument(
                           strings::StrCat("Index ", index, " at offset ", i,
                                           " in indices is out of range")));
+        }
+
+        const auto update = [&](Tindex i) {
+          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
           T& a = accum_flat(index);
           T& l = linear_flat(index);
           T& v = var_flat(index);
@@ -2372,7 +2445,9 @@ class SparseApplyFtrlOp : public OpKernel {
                           lr_power_scalar);
           a = updated_a;
           l = updated_l;
-        }
+        };
+
+        ParallelSparseUpdate<Tindex>(d, indices_vec, cost, update);
       }
     }
 
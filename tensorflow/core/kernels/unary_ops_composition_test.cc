@@ -79,6 +79,14 @@ TEST_F(UnaryOpsCompositionTest, Compose_Tanh_Relu6_F) {
   RunComposedOp<float>({"Relu6"}, 11.0f, 6.0f);
 }
 
+TEST_F(UnaryOpsCompositionTest, Compose_Erf_Sign_F) {
+  RunComposedOp<float>({"Erf", "Sign"}, -0.5f, -1.0f);
+}
+
+TEST_F(UnaryOpsCompositionTest, Compose_Exp_Lgamma_D) {
+  RunComposedOp<double>({"Exp", "Lgamma"}, 1.0, std::lgamma(std::exp(1.0)));
+}
+
 // Performance benchmarks below.
 
 string Function(int i) {
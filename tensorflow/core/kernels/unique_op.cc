@@ -13,10 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -24,11 +27,36 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Inputs of at least this many elements are deduplicated in parallel.
+constexpr int64 kMinParallelUniqueSize = 1 << 16;
+
+// Scrambles the bits of hash<T>, which is the identity for integers, so that
+// both the partitions and the hash maps of the parallel implementation are
+// balanced.
+template <typename T>
+struct UniqueHash {
+  static uint64 Mix(const T& value) {
+    uint64 h = hash<T>{}(value);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+  }
+  size_t operator()(const T& value) const {
+    return static_cast<size_t>(Mix(value));
+  }
+};
+
+}  // namespace
+
 template <typename T, typename TIndex>
 class UniqueOp : public OpKernel {
  public:
@@ -99,7 +127,14 @@ class UniqueOp : public OpKernel {
     auto idx_vec = idx->template vec<TIndex>();
 
     int64 uniq_size;
-    if (new_sizes[0] == 1 && new_sizes[2] == 1) {
+    const auto* worker_threads =
+        context->device()->tensorflow_cpu_worker_threads();
+    if (new_sizes[0] == 1 && new_sizes[2] == 1 &&
+        input.NumElements() >= kMinParallelUniqueSize &&
+        worker_threads->num_threads > 1) {
+      OP_REQUIRES_OK(context, ComputeParallel(context, input, axis,
+                                              idx_vec, &uniq_size));
+    } else if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
       // elements. Here we put T directly into the map rather than ints pointing
       // to them as in the general case.
@@ -192,6 +227,113 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  // Parallel implementation of the single element case, with the same output.
+  //
+  // The input is split into one chunk per thread, and its elements are split
+  // into one partition per thread by hash, so that the unique elements of each
+  // partition can be found independently. The unique elements are then
+  // numbered in order of first occurrence, by a prefix sum over the chunks.
+  Status ComputeParallel(OpKernelContext* context, const Tensor& input,
+                         int64 axis, typename TTypes<TIndex>::Vec idx_vec,
+                         int64* uniq_size) {
+    const auto* worker_threads =
+        context->device()->tensorflow_cpu_worker_threads();
+    auto Tin = input.flat<T>();
+    const int64 N = static_cast<int64>(Tin.size());
+    const int num_parts = worker_threads->num_threads;
+    const int64 chunk_size = (N + num_parts - 1) / num_parts;
+    // Runs fn(part) for each part in [0, num_parts) on its own thread.
+    auto for_each_part = [&](const std::function<void(int64)>& fn) {
+      Shard(num_parts, worker_threads->workers, num_parts,
+            /*cost_per_unit=*/100 * chunk_size, [&fn](int64 start, int64 end) {
+              for (int64 part = start; part < end; ++part) {
+                fn(part);
+              }
+            });
+    };
+    auto chunk_start = [&](int64 chunk) {
+      return std::min(N, chunk * chunk_size);
+    };
+
+    // Elements of each partition in each chunk, in increasing order. Indices
+    // fit in int32 as the input size was checked in Compute.
+    std::vector<std::vector<std::vector<int32>>> elements(
+        num_parts, std::vector<std::vector<int32>>(num_parts));
+    for_each_part([&](int64 chunk) {
+      for (int64 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        // The high bits, as the hash maps use the low ones.
+        const int64 part = (UniqueHash<T>::Mix(Tin(i)) >> 32) % num_parts;
+        elements[chunk][part].push_back(i);
+      }
+    });
+
+    // Deduplicate each partition, setting idx to the index of the element
+    // among the unique elements of its partition.
+    std::vector<uint8> is_first(N, 0);
+    std::vector<std::vector<int32>> first_occurrences(num_parts);
+    for_each_part([&](int64 part) {
+      absl::flat_hash_map<T, TIndex, UniqueHash<T>> uniq;
+      std::vector<int32>& firsts = first_occurrences[part];
+      for (int64 chunk = 0; chunk < num_parts; ++chunk) {
+        for (int32 i : elements[chunk][part]) {
+          auto it = uniq.emplace(Tin(i), firsts.size());
+          if (it.second) {
+            firsts.push_back(i);
+            is_first[i] = 1;
+          }
+          idx_vec(i) = it.first->second;
+        }
+      }
+    });
+
+    // Number the unique elements in order of first occurrence, setting the
+    // final idx of the first occurrences.
+    std::vector<int64> chunk_offsets(num_parts + 1, 0);
+    for_each_part([&](int64 chunk) {
+      int64 count = 0;
+      for (int64 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        count += is_first[i];
+      }
+      chunk_offsets[chunk + 1] = count;
+    });
+    for (int chunk = 0; chunk < num_parts; ++chunk) {
+      chunk_offsets[chunk + 1] += chunk_offsets[chunk];
+    }
+    *uniq_size = chunk_offsets[num_parts];
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, *uniq_size);
+    Tensor* output = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, &output));
+    auto Tout = output->flat<T>();
+    for_each_part([&](int64 chunk) {
+      int64 next = chunk_offsets[chunk];
+      for (int64 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        if (is_first[i]) {
+          Tout(next) = Tin(i);
+          idx_vec(i) = next++;
+        }
+      }
+    });
+
+    // Map the remaining idx from partition to final numbering.
+    for_each_part([&](int64 part) {
+      const std::vector<int32>& firsts = first_occurrences[part];
+      std::vector<TIndex> final_idx(firsts.size());
+      for (size_t j = 0; j < firsts.size(); ++j) {
+        final_idx[j] = idx_vec(firsts[j]);
+      }
+      for (int64 chunk = 0; chunk < num_parts; ++chunk) {
+        for (int32 i : elements[chunk][part]) {
+          if (!is_first[i]) {
+            idx_vec(i) = final_idx[idx_vec(i)];
+          }
+        }
+      }
+    });
+    return Status::OK();
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                    \
@@ -0,0 +1,212 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/vnni_support.h"
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+#if defined(__AVX512F__) && defined(__AVX512VNNI__) && \
+    !defined(TENSORFLOW_DISABLE_VNNI)
+#define TENSORFLOW_USE_VNNI (1)
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#endif
+
+namespace tensorflow {
+namespace vnni {
+
+namespace {
+
+#ifdef TENSORFLOW_USE_VNNI
+
+// Columns of c computed by one vector of int32 accumulators.
+constexpr int kBlockCols = 16;
+// Depth consumed per column by one vpdpbusd.
+constexpr int kBlockDepth = 4;
+// Rows of c sharing each load of the right hand side.
+constexpr int kBlockRows = 4;
+
+// vpdpbusd multiplies unsigned by signed bytes, so b is stored minus 128 as
+// int8, and 128 * (sum of the row of a) is added back to each result. The
+// offsets are applied the same way, from the row sums of a and the column sums
+// of b:
+//   (a + offset_a) * (b + offset_b) = a * (b - 128)
+//                                     + (128 + offset_b) * row_sums(a)
+//                                     + offset_a * col_sums(b)
+//                                     + k * offset_a * offset_b
+struct PackedOperands {
+  int m;
+  int n;
+  int padded_k;
+  int num_col_blocks;
+  // a, row major with rows padded with zeros to padded_k.
+  std::vector<uint8> lhs;
+  // (128 + offset_b) * row_sums(a).
+  std::vector<int32> row_terms;
+  // b - 128, in blocks of kBlockCols columns. Each block is stored in groups
+  // of kBlockDepth rows, each group column after column, so that a group is
+  // the right hand side of one vpdpbusd. Padded with zeros.
+  std::vector<int8> rhs;
+  // offset_a * col_sums(b) + k * offset_a * offset_b, padded to whole blocks.
+  std::vector<int32> col_terms;
+};
+
+void Pack(bool transpose_a, bool transpose_b, const uint8* a, const uint8* b,
+          int m, int n, int k, int offset_a, int offset_b, int lda, int ldb,
+          PackedOperands* packed) {
+  packed->m = m;
+  packed->n = n;
+  packed->padded_k = (k + kBlockDepth - 1) / kBlockDepth * kBlockDepth;
+  packed->num_col_blocks = (n + kBlockCols - 1) / kBlockCols;
+  const int padded_k = packed->padded_k;
+
+  packed->lhs.assign(static_cast<size_t>(m) * padded_k, 0);
+  packed->row_terms.resize(m);
+  for (int i = 0; i < m; ++i) {
+    uint8* row = packed->lhs.data() + static_cast<size_t>(i) * padded_k;
+    int32 sum = 0;
+    for (int depth = 0; depth < k; ++depth) {
+      row[depth] = transpose_a ? a[depth * lda + i] : a[i * lda + depth];
+      sum += row[depth];
+    }
+    packed->row_terms[i] = (128 + offset_b) * sum;
+  }
+
+  const int num_groups = padded_k / kBlockDepth;
+  packed->rhs.assign(static_cast<size_t>(packed->num_col_blocks) *
+                         num_groups * kBlockCols * kBlockDepth,
+                     0);
+  packed->col_terms.assign(packed->num_col_blocks * kBlockCols, 0);
+  for (int j = 0; j < n; ++j) {
+    const int block = j / kBlockCols;
+    const int col_in_block = j % kBlockCols;
+    int32 sum = 0;
+    for (int depth = 0; depth < k; ++depth) {
+      const uint8 value = transpose_b ? b[j * ldb + depth] : b[depth * ldb + j];
+      sum += value;
+      const int group = depth / kBlockDepth;
+      packed->rhs[((static_cast<size_t>(block) * num_groups + group) *
+                       kBlockCols +
+                   col_in_block) *
+                      kBlockDepth +
+                  depth % kBlockDepth] = static_cast<int8>(value - 128);
+    }
+    packed->col_terms[j] = offset_a * sum + k * offset_a * offset_b;
+  }
+}
+
+// Computes kRows rows of c starting at `row`.
+template <int kRows>
+void MultiplyRows(const PackedOperands& packed, int row, int32* c, int ldc) {
+  const int padded_k = packed.padded_k;
+  const int num_groups = padded_k / kBlockDepth;
+  const uint8* lhs = packed.lhs.data() + static_cast<size_t>(row) * padded_k;
+  for (int block = 0; block < packed.num_col_blocks; ++block) {
+    const int8* rhs = packed.rhs.data() + static_cast<size_t>(block) *
+                                              num_groups * kBlockCols *
+                                              kBlockDepth;
+    __m512i acc[kRows];
+    for (int r = 0; r < kRows; ++r) {
+      acc[r] = _mm512_setzero_si512();
+    }
+    for (int group = 0; group < num_groups; ++group) {
+      const __m512i rhs_group =
+          _mm512_loadu_si512(rhs + group * kBlockCols * kBlockDepth);
+      for (int r = 0; r < kRows; ++r) {
+        int32 lhs_group;
+        std::memcpy(&lhs_group, lhs + r * padded_k + group * kBlockDepth,
+                    sizeof(lhs_group));
+        acc[r] = _mm512_dpbusd_epi32(acc[r], _mm512_set1_epi32(lhs_group),
+                                     rhs_group);
+      }
+    }
+
+    const int col = block * kBlockCols;
+    const int num_cols = std::min(kBlockCols, packed.n - col);
+    const __mmask16 mask = static_cast<__mmask16>((1u << num_cols) - 1);
+    const __m512i col_terms = _mm512_loadu_si512(packed.col_terms.data() + col);
+    for (int r = 0; r < kRows; ++r) {
+      const __m512i result = _mm512_add_epi32(
+          _mm512_add_epi32(acc[r], col_terms),
+          _mm512_set1_epi32(packed.row_terms[row + r]));
+      _mm512_mask_storeu_epi32(c + static_cast<size_t>(row + r) * ldc + col,
+                               mask, result);
+    }
+  }
+}
+
+#endif  // TENSORFLOW_USE_VNNI
+
+}  // namespace
+
+bool IsSupported() {
+#ifdef TENSORFLOW_USE_VNNI
+  static const bool supported =
+      port::TestCPUFeature(port::CPUFeature::AVX512_VNNI);
+  return supported;
+#else
+  return false;
+#endif
+}
+
+void QuantizedGemm(OpKernelContext* context, bool transpose_a, bool transpose_b,
+                   const quint8* a_data, const quint8* b_data, qint32* c_data,
+                   int m, int n, int k, int offset_a, int offset_b, int lda,
+                   int ldb, int ldc) {
+#ifdef TENSORFLOW_USE_VNNI
+  PackedOperands packed;
+  Pack(transpose_a, transpose_b, &(a_data->value), &(b_data->value), m, n, k,
+       offset_a, offset_b, lda, ldb, &packed);
+  int32* c = &(c_data->value);
+
+  const int num_row_blocks = (m + kBlockRows - 1) / kBlockRows;
+  auto compute_row_blocks = [&packed, c, ldc](int64 start, int64 limit) {
+    for (int64 row_block = start; row_block < limit; ++row_block) {
+      const int row = row_block * kBlockRows;
+      switch (std::min(kBlockRows, packed.m - row)) {
+        case 4:
+          MultiplyRows<4>(packed, row, c, ldc);
+          break;
+        case 3:
+          MultiplyRows<3>(packed, row, c, ldc);
+          break;
+        case 2:
+          MultiplyRows<2>(packed, row, c, ldc);
+          break;
+        default:
+          MultiplyRows<1>(packed, row, c, ldc);
+          break;
+      }
+    }
+  };
+  const auto& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, num_row_blocks,
+        /*cost_per_unit=*/static_cast<int64>(kBlockRows) * n * packed.padded_k /
+            kBlockDepth,
+        compute_row_blocks);
+#else
+  LOG(FATAL) << "QuantizedGemm: VNNI fastpath not supported.";
+#endif
+}
+
+}  // namespace vnni
+}  // namespace tensorflow
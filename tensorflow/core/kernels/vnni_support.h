@@ -0,0 +1,44 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_VNNI_SUPPORT_H_
+#define TENSORFLOW_CORE_KERNELS_VNNI_SUPPORT_H_
+
+#include "tensorflow/core/framework/numeric_types.h"
+
+namespace tensorflow {
+
+class OpKernelContext;
+
+namespace vnni {
+
+// Returns whether QuantizedGemm is available: this requires TensorFlow to be
+// built with AVX-512 VNNI enabled (e.g. -march=cascadelake), and the processor
+// to support it.
+bool IsSupported();
+
+// Eight-bit GEMM on x86 using the AVX-512 VNNI vpdpbusd instruction, with the
+// same contract as meta::QuantizedGemm: computes the row major m x n matrix
+// c = (a + offset_a) * (b + offset_b), where a is m x k and b is k x n, each
+// stored row major unless transposed. Must only be called if IsSupported().
+void QuantizedGemm(OpKernelContext* context, bool transpose_a, bool transpose_b,
+                   const quint8* a_data, const quint8* b_data, qint32* c_data,
+                   int m, int n, int k, int offset_a, int offset_b, int lda,
+                   int ldb, int ldc);
+
+}  // namespace vnni
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_VNNI_SUPPORT_H_
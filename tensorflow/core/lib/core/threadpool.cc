@@ -17,9 +17,14 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -30,6 +35,68 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+namespace {
+
+auto* thread_pool_tasks = monitoring::Counter<1>::New(
+    "/tensorflow/core/thread_pool/tasks",
+    "The number of tasks run by each thread pool. Only recorded when "
+    "TF_THREAD_POOL_METRICS=1.",
+    "pool");
+
+auto* thread_pool_busy_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/thread_pool/busy_usecs",
+    "The time the threads of each thread pool spent running tasks. Divided by "
+    "the elapsed time and the number of threads, this is the utilization of "
+    "the pool. Only recorded when TF_THREAD_POOL_METRICS=1.",
+    "pool");
+
+// Timing every task costs two clock reads, so the metrics above are only
+// recorded when TF_THREAD_POOL_METRICS=1 is set when the pool is created.
+bool ThreadPoolMetricsEnabled() {
+  const char* value = getenv("TF_THREAD_POOL_METRICS");
+  return value != nullptr && strcmp(value, "1") == 0;
+}
+
+// Per-thread totals that are published to the shared cells in batches, so
+// that the threads of a pool do not contend on the cells for every task.
+// Whatever is left is published when the thread exits.
+struct ThreadTaskStats {
+  static constexpr int64 kMaxPendingTasks = 64;
+  static constexpr int64 kMaxPendingUsecs = 100 * 1000;
+
+  monitoring::CounterCell* tasks = nullptr;
+  monitoring::CounterCell* busy_usecs = nullptr;
+  int64 pending_tasks = 0;
+  int64 pending_usecs = 0;
+
+  ~ThreadTaskStats() { Flush(); }
+
+  void Add(monitoring::CounterCell* tasks_cell,
+           monitoring::CounterCell* busy_usecs_cell, int64 usecs) {
+    if (tasks_cell != tasks) {
+      Flush();
+      tasks = tasks_cell;
+      busy_usecs = busy_usecs_cell;
+    }
+    ++pending_tasks;
+    pending_usecs += usecs;
+    if (pending_tasks >= kMaxPendingTasks ||
+        pending_usecs >= kMaxPendingUsecs) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    if (pending_tasks == 0) return;
+    tasks->IncrementBy(pending_tasks);
+    busy_usecs->IncrementBy(pending_usecs);
+    pending_tasks = 0;
+    pending_usecs = 0;
+  }
+};
+
+}  // namespace
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
@@ -44,10 +111,20 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  // Null unless TF_THREAD_POOL_METRICS=1.
+  monitoring::CounterCell* const tasks_;
+  monitoring::CounterCell* const busy_usecs_;
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
                    const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        tasks_(ThreadPoolMetricsEnabled() ? thread_pool_tasks->GetCell(name)
+                                          : nullptr),
+        busy_usecs_(ThreadPoolMetricsEnabled()
+                        ? thread_pool_busy_usecs->GetCell(name)
+                        : nullptr) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
     return env_->StartThread(thread_options_, name_, [=]() {
@@ -58,6 +135,11 @@ struct EigenEnvironment {
       if (thread_options_.numa_node != port::kNUMANoAffinity) {
         port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
       }
+      if (!thread_options_.cpu_affinity.empty() &&
+          !port::SetCurrentThreadCpuAffinity(thread_options_.cpu_affinity)) {
+        LOG(WARNING) << "Could not restrict the threads of " << name_
+                     << " to the requested CPUs.";
+      }
       f();
     });
   }
@@ -81,7 +163,14 @@ struct EigenEnvironment {
     WithContext wc(t.f->context);
     tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
                                  t.f->trace_id);
+    if (tasks_ == nullptr) {
+      t.f->f();
+      return;
+    }
+    static thread_local ThreadTaskStats stats;
+    const uint64 start_us = env_->NowMicros();
     t.f->f();
+    stats.Add(tasks_, busy_usecs_, env_->NowMicros() - start_us);
   }
 };
 
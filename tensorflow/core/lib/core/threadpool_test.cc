@@ -15,11 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 
+#include <stdlib.h>
+
 #include <atomic>
 
 #include "absl/synchronization/barrier.h"
 #include "absl/synchronization/blocking_counter.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -62,6 +66,61 @@ TEST(ThreadPool, DoWork) {
   }
 }
 
+int64 CollectedTaskCount(const string& pool) {
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  options.collect_metric_descriptors = false;
+  const auto metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(options);
+  const auto it = metrics->point_set_map.find(
+      "/tensorflow/core/thread_pool/tasks");
+  if (it == metrics->point_set_map.end()) return 0;
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == pool) {
+      return point->int64_value;
+    }
+  }
+  return 0;
+}
+
+TEST(ThreadPool, MetricsAreOptIn) {
+  const int kTasks = 100;
+  {
+    ThreadPool pool(Env::Default(), "metrics_off", 2);
+    for (int i = 0; i < kTasks; ++i) pool.Schedule([]() {});
+  }
+  EXPECT_EQ(0, CollectedTaskCount("tf_metrics_off"));
+
+  setenv("TF_THREAD_POOL_METRICS", "1", 1);
+  {
+    ThreadPool pool(Env::Default(), "metrics_on", 2);
+    for (int i = 0; i < kTasks; ++i) pool.Schedule([]() {});
+  }
+  unsetenv("TF_THREAD_POOL_METRICS");
+  // The counts left below the publishing batch size are flushed as the
+  // threads exit, which happens before the pool's destructor returns.
+  EXPECT_EQ(kTasks, CollectedTaskCount("tf_metrics_on"));
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST(ThreadPool, CpuAffinity) {
+  // The CPU this thread runs on is surely available to the process.
+  const int cpu = port::GetCurrentCPU();
+  ASSERT_NE(port::kUnknownCPU, cpu);
+  ThreadOptions thread_options;
+  thread_options.cpu_affinity = {cpu};
+  std::atomic<int> num_tasks_on_other_cpus(0);
+  {
+    ThreadPool pool(Env::Default(), thread_options, "test", 4);
+    for (int i = 0; i < 100; ++i) {
+      pool.Schedule([cpu, &num_tasks_on_other_cpus]() {
+        if (port::GetCurrentCPU() != cpu) ++num_tasks_on_other_cpus;
+      });
+    }
+  }
+  EXPECT_EQ(0, num_tasks_on_other_cpus);
+}
+#endif
+
 void RunSharding(int64 block_size, int64 total, ThreadPool* threads) {
   mutex mu;
   int64 num_shards = 0;
@@ -0,0 +1,203 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_gzip.h"
+
+#include <string.h>
+#include <zlib.h>
+
+#include <limits>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+
+namespace tensorflow {
+namespace io {
+namespace block_gzip {
+namespace {
+
+const unsigned char kGzipId1 = 0x1f;
+const unsigned char kGzipId2 = 0x8b;
+const unsigned char kMethodDeflate = 8;
+const unsigned char kFlagExtra = 4;
+const unsigned char kOsUnknown = 255;
+const uint16 kExtraLength = 8;
+const char kSubfieldId1 = 'T';
+const char kSubfieldId2 = 'F';
+const uint16 kSubfieldLength = 4;
+
+// Offset of the member size within the header.
+const size_t kMemberSizeOffset = 16;
+
+// Deflate never expands data by more than this factor, which bounds the
+// buffer allocated for a member whose trailer is corrupted.
+const uint64 kMaxDeflateRatio = 1032;
+
+}  // namespace
+
+Status CompressMember(StringPiece data, int compression_level,
+                      string* output) {
+  if (data.size() > std::numeric_limits<uInt>::max()) {
+    return errors::InvalidArgument("BLOCK_GZIP block too large: ",
+                                   data.size(), " bytes");
+  }
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, compression_level, Z_DEFLATED, -MAX_WBITS,
+                   /*memLevel=*/8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return errors::InvalidArgument(
+        "deflateInit2 failed with compression level ", compression_level);
+  }
+  const size_t bound = deflateBound(&stream, data.size());
+  const size_t start = output->size();
+  output->resize(start + kHeaderSize + bound + kTrailerSize);
+  char* member = &(*output)[start];
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(member + kHeaderSize);
+  stream.avail_out = bound;
+  const int ret = deflate(&stream, Z_FINISH);
+  const size_t compressed_size = stream.total_out;
+  deflateEnd(&stream);
+  if (ret != Z_STREAM_END) {
+    output->resize(start);
+    return errors::Internal("deflate failed with error ", ret);
+  }
+
+  const size_t member_size = kHeaderSize + compressed_size + kTrailerSize;
+  if (member_size > std::numeric_limits<uint32>::max()) {
+    output->resize(start);
+    return errors::InvalidArgument("BLOCK_GZIP member too large: ",
+                                   member_size, " bytes");
+  }
+  member[0] = kGzipId1;
+  member[1] = kGzipId2;
+  member[2] = kMethodDeflate;
+  member[3] = kFlagExtra;
+  core::EncodeFixed32(member + 4, 0);  // MTIME
+  member[8] = 0;                       // XFL
+  member[9] = kOsUnknown;
+  core::EncodeFixed16(member + 10, kExtraLength);
+  member[12] = kSubfieldId1;
+  member[13] = kSubfieldId2;
+  core::EncodeFixed16(member + 14, kSubfieldLength);
+  core::EncodeFixed32(member + kMemberSizeOffset, member_size);
+
+  char* trailer = member + kHeaderSize + compressed_size;
+  core::EncodeFixed32(
+      trailer, crc32(0L, reinterpret_cast<const Bytef*>(data.data()),
+                     data.size()));
+  core::EncodeFixed32(trailer + 4, data.size());
+  output->resize(start + member_size);
+  return Status::OK();
+}
+
+Status ParseMemberSize(StringPiece header, uint32* member_size) {
+  if (header.size() < kHeaderSize) {
+    return errors::DataLoss("truncated BLOCK_GZIP member header");
+  }
+  const char* p = header.data();
+  if (static_cast<unsigned char>(p[0]) != kGzipId1 ||
+      static_cast<unsigned char>(p[1]) != kGzipId2 ||
+      static_cast<unsigned char>(p[2]) != kMethodDeflate ||
+      static_cast<unsigned char>(p[3]) != kFlagExtra ||
+      core::DecodeFixed16(p + 10) != kExtraLength || p[12] != kSubfieldId1 ||
+      p[13] != kSubfieldId2 ||
+      core::DecodeFixed16(p + 14) != kSubfieldLength) {
+    return errors::DataLoss("not a BLOCK_GZIP member header");
+  }
+  *member_size = core::DecodeFixed32(p + kMemberSizeOffset);
+  if (*member_size < kHeaderSize + kTrailerSize) {
+    return errors::DataLoss("invalid BLOCK_GZIP member size ", *member_size);
+  }
+  return Status::OK();
+}
+
+Status DecompressMember(StringPiece member, string* output) {
+  uint32 member_size;
+  TF_RETURN_IF_ERROR(ParseMemberSize(member, &member_size));
+  if (member.size() != member_size) {
+    return errors::DataLoss("BLOCK_GZIP member is ", member.size(),
+                            " bytes but its header says ", member_size);
+  }
+  const char* trailer = member.data() + member.size() - kTrailerSize;
+  const uint32 expected_crc = core::DecodeFixed32(trailer);
+  const uint32 uncompressed_size = core::DecodeFixed32(trailer + 4);
+  const size_t compressed_size = member.size() - kHeaderSize - kTrailerSize;
+  if (uncompressed_size > kMaxDeflateRatio * compressed_size) {
+    return errors::DataLoss("BLOCK_GZIP member of ", compressed_size,
+                            " compressed bytes claims ", uncompressed_size,
+                            " uncompressed bytes");
+  }
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+    return errors::Internal("inflateInit2 failed");
+  }
+  output->resize(uncompressed_size);
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(member.data() + kHeaderSize));
+  stream.avail_in = compressed_size;
+  stream.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  stream.avail_out = uncompressed_size;
+  const int ret = inflate(&stream, Z_FINISH);
+  const size_t total_out = stream.total_out;
+  inflateEnd(&stream);
+  if (ret != Z_STREAM_END || total_out != uncompressed_size) {
+    return errors::DataLoss("corrupted BLOCK_GZIP member (inflate returned ",
+                            ret, ")");
+  }
+  if (crc32(0L, reinterpret_cast<const Bytef*>(output->data()),
+            output->size()) != expected_crc) {
+    return errors::DataLoss("BLOCK_GZIP member checksum mismatch");
+  }
+  return Status::OK();
+}
+
+}  // namespace block_gzip
+
+namespace {
+
+class BlockGzipFormat : public BlockInputStream::Format {
+ public:
+  const char* name() const override { return "BLOCK_GZIP"; }
+
+  size_t header_size() const override { return block_gzip::kHeaderSize; }
+
+  Status ParseBlockSize(StringPiece header, uint64* block_size) const override {
+    uint32 member_size;
+    TF_RETURN_IF_ERROR(block_gzip::ParseMemberSize(header, &member_size));
+    *block_size = member_size;
+    return Status::OK();
+  }
+
+  Status DecompressBlock(StringPiece block, string* output) const override {
+    return block_gzip::DecompressMember(block, output);
+  }
+};
+
+}  // namespace
+
+BlockGzipInputStream::BlockGzipInputStream(InputStreamInterface* input_stream,
+                                           int num_threads,
+                                           bool owns_input_stream)
+    : BlockInputStream(input_stream, std::make_shared<BlockGzipFormat>(),
+                       num_threads, owns_input_stream) {}
+
+}  // namespace io
+}  // namespace tensorflow
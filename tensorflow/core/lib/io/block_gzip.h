@@ -0,0 +1,79 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_H_
+#define TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_H_
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/block_inputstream.h"
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// A BLOCK_GZIP file is a sequence of independently compressed gzip members
+// (RFC 1952), so it is also a valid gzip file. Each member records its own
+// compressed size in an extra field of its header, which lets a reader find
+// every member without inflating the ones before it and decompress several
+// members in parallel.
+//
+// Layout of a member:
+//   10 bytes   gzip header with FLG.FEXTRA set
+//   uint16     XLEN = 8
+//   2 bytes    subfield id 'T' 'F'
+//   uint16     subfield length = 4
+//   uint32     total size of the member, header and trailer included
+//   byte       raw deflate data
+//   uint32     CRC-32 of the uncompressed data
+//   uint32     size of the uncompressed data
+// All integers are little-endian.
+namespace block_gzip {
+
+static const size_t kHeaderSize = 20;
+static const size_t kTrailerSize = 8;
+
+// Compresses `data` into a single member appended to `*output`.
+// `compression_level` is a zlib compression level.
+Status CompressMember(StringPiece data, int compression_level,
+                      string* output);
+
+// Parses the first kHeaderSize bytes of a member and sets `*member_size` to
+// the total size of the member.
+Status ParseMemberSize(StringPiece header, uint32* member_size);
+
+// Decompresses the whole member `member` into `*output` and verifies its
+// checksum.
+Status DecompressMember(StringPiece member, string* output);
+
+}  // namespace block_gzip
+
+// An InputStreamInterface that decompresses a BLOCK_GZIP stream, inflating up
+// to `num_threads` members ahead of the reader in parallel.
+//
+// Note: this class is not thread safe; external synchronization required.
+class BlockGzipInputStream : public BlockInputStream {
+ public:
+  // Create a BlockGzipInputStream for `input_stream`. If `owns_input_stream`
+  // is true, the stream is deleted when this stream is deleted.
+  BlockGzipInputStream(InputStreamInterface* input_stream, int num_threads,
+                       bool owns_input_stream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_H_
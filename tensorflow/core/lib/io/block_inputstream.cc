@@ -0,0 +1,155 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// Decompresses the blocks of all streams, so that opening many readers, e.g.
+// one per file of an interleaved dataset, does not start threads for each.
+thread::ThreadPool* DecompressionThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "block_inputstream", port::MaxParallelism());
+  return pool;
+}
+
+}  // namespace
+
+BlockInputStream::BlockInputStream(InputStreamInterface* input_stream,
+                                   std::shared_ptr<const Format> format,
+                                   int num_threads, bool owns_input_stream)
+    : input_stream_(input_stream),
+      owns_input_stream_(owns_input_stream),
+      format_(std::move(format)),
+      max_blocks_in_flight_(2 * std::max(num_threads, 1)) {}
+
+BlockInputStream::~BlockInputStream() {
+  CancelBlocks();
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+void BlockInputStream::ScheduleBlocks() {
+  const size_t header_size = format_->header_size();
+  while (!input_exhausted_ && blocks_.size() < max_blocks_in_flight_) {
+    std::shared_ptr<Block> block = std::make_shared<Block>();
+    Status s = input_stream_->ReadNBytes(header_size, &block->compressed);
+    if (errors::IsOutOfRange(s) && block->compressed.empty()) {
+      input_exhausted_ = true;
+      return;
+    }
+    uint64 block_size = 0;
+    if (s.ok()) {
+      s = format_->ParseBlockSize(block->compressed, &block_size);
+    } else if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated ", format_->name(), " block header");
+    }
+    string rest;
+    if (s.ok() && block_size < header_size) {
+      s = errors::DataLoss("invalid ", format_->name(), " block size ",
+                           block_size);
+    }
+    if (s.ok()) {
+      s = input_stream_->ReadNBytes(block_size - header_size, &rest);
+      if (errors::IsOutOfRange(s)) {
+        s = errors::DataLoss("truncated ", format_->name(), " block");
+      }
+    }
+    if (!s.ok()) {
+      // Blocks read before the failure are still returned; the error is
+      // reported once they have been consumed.
+      input_status_ = s;
+      input_exhausted_ = true;
+      return;
+    }
+    block->compressed.append(rest);
+    std::shared_ptr<const Format> format = format_;
+    DecompressionThreadPool()->Schedule([format, block]() {
+      block->status = format->DecompressBlock(block->compressed, &block->data);
+      string().swap(block->compressed);
+      block->done.Notify();
+    });
+    blocks_.push_back(std::move(block));
+  }
+}
+
+Status BlockInputStream::NextBlock() {
+  ScheduleBlocks();
+  if (blocks_.empty()) {
+    TF_RETURN_IF_ERROR(input_status_);
+    return errors::OutOfRange("reached end of ", format_->name(), " stream");
+  }
+  std::shared_ptr<Block> block = std::move(blocks_.front());
+  blocks_.pop_front();
+  block->done.WaitForNotification();
+  TF_RETURN_IF_ERROR(block->status);
+  current_.swap(block->data);
+  pos_ = 0;
+  return Status::OK();
+}
+
+void BlockInputStream::CancelBlocks() {
+  for (const auto& block : blocks_) {
+    block->done.WaitForNotification();
+  }
+  blocks_.clear();
+}
+
+Status BlockInputStream::ReadNBytes(int64 bytes_to_read, string* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  result->reserve(bytes_to_read);
+  while (result->size() < static_cast<size_t>(bytes_to_read)) {
+    if (pos_ == current_.size()) {
+      TF_RETURN_IF_ERROR(NextBlock());
+    }
+    const size_t n =
+        std::min(static_cast<size_t>(bytes_to_read) - result->size(),
+                 current_.size() - pos_);
+    result->append(current_, pos_, n);
+    pos_ += n;
+    bytes_read_ += n;
+  }
+  return Status::OK();
+}
+
+int64 BlockInputStream::Tell() const { return bytes_read_; }
+
+Status BlockInputStream::Reset() {
+  CancelBlocks();
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+  input_exhausted_ = false;
+  input_status_ = Status::OK();
+  current_.clear();
+  pos_ = 0;
+  bytes_read_ = 0;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,121 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_BLOCK_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_BLOCK_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// An InputStreamInterface over a stream made of independently compressed
+// blocks, each of which starts with a header giving its size. Up to
+// 2 * `num_threads` blocks ahead of the reader are decompressed in parallel,
+// on a thread pool shared by all BlockInputStreams of the process.
+//
+// Note: this class is not thread safe; external synchronization required.
+class BlockInputStream : public InputStreamInterface {
+ public:
+  // Describes how blocks are framed and compressed. Methods may be called
+  // concurrently from several threads.
+  class Format {
+   public:
+    virtual ~Format() {}
+
+    // Name of the format, for error messages.
+    virtual const char* name() const = 0;
+
+    // Number of bytes at the start of each block needed by ParseBlockSize.
+    virtual size_t header_size() const = 0;
+
+    // Sets `*block_size` to the total size of the block starting with
+    // `header`, header included.
+    virtual Status ParseBlockSize(StringPiece header,
+                                  uint64* block_size) const = 0;
+
+    // Decompresses the whole block `block` into `*output`.
+    virtual Status DecompressBlock(StringPiece block, string* output) const = 0;
+  };
+
+  // Create a BlockInputStream for `input_stream`. If `owns_input_stream` is
+  // true, the stream is deleted when this stream is deleted.
+  BlockInputStream(InputStreamInterface* input_stream,
+                   std::shared_ptr<const Format> format, int num_threads,
+                   bool owns_input_stream);
+
+  ~BlockInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, string* result) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  // A block read from the input, and its decompressed contents once `done`
+  // is notified.
+  struct Block {
+    string compressed;
+    string data;
+    Status status;
+    Notification done;
+  };
+
+  // Reads blocks from the input and schedules their decompression until
+  // enough are in flight or the input is exhausted. A read error ends the
+  // input and is kept in `input_status_`.
+  void ScheduleBlocks();
+
+  // Waits for the next block and makes it the current one. Returns
+  // OUT_OF_RANGE when no block is left.
+  Status NextBlock();
+
+  // Waits for all blocks in flight and drops them.
+  void CancelBlocks();
+
+  InputStreamInterface* input_stream_;
+  const bool owns_input_stream_;
+  const std::shared_ptr<const Format> format_;
+  const size_t max_blocks_in_flight_;
+
+  // Blocks being decompressed, in stream order.
+  std::deque<std::shared_ptr<Block>> blocks_;
+  bool input_exhausted_ = false;
+  Status input_status_;
+
+  // Decompressed contents of the current block and the read position in it.
+  string current_;
+  size_t pos_ = 0;
+
+  // Number of uncompressed bytes returned so far.
+  int64 bytes_read_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_BLOCK_INPUTSTREAM_H_
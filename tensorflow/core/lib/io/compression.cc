@@ -21,6 +21,8 @@ namespace compression {
 
 const char kNone[] = "";
 const char kGzip[] = "GZIP";
+const char kBlockGzip[] = "BLOCK_GZIP";
+const char kZstd[] = "ZSTD";
 
 }  // namespace compression
 }  // namespace io
@@ -22,6 +22,8 @@ namespace compression {
 
 extern const char kNone[];
 extern const char kGzip[];
+extern const char kBlockGzip[];
+extern const char kZstd[];
 
 }  // namespace compression
 }  // namespace io
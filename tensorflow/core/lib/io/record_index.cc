@@ -0,0 +1,99 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// "TFRINDEX" in little-endian order.
+const uint64 kRecordIndexMagic = 0x5845444e49524654ull;
+
+}  // namespace
+
+string RecordIndexFilename(const string& record_filename) {
+  return record_filename + ".index";
+}
+
+Status WriteRecordIndex(Env* env, const string& index_filename,
+                        const std::vector<uint64>& offsets) {
+  string contents;
+  contents.reserve((offsets.size() + 2) * sizeof(uint64) + sizeof(uint32));
+  core::PutFixed64(&contents, kRecordIndexMagic);
+  core::PutFixed64(&contents, offsets.size());
+  for (uint64 offset : offsets) {
+    core::PutFixed64(&contents, offset);
+  }
+  core::PutFixed32(&contents,
+                   crc32c::Mask(crc32c::Value(contents.data(),
+                                              contents.size())));
+  return WriteStringToFile(env, index_filename, contents);
+}
+
+Status ReadRecordIndex(Env* env, const string& index_filename,
+                       std::vector<uint64>* offsets) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, index_filename, &contents));
+  const size_t header_size = 2 * sizeof(uint64);
+  if (contents.size() < header_size + sizeof(uint32) ||
+      core::DecodeFixed64(contents.data()) != kRecordIndexMagic) {
+    return errors::DataLoss("not a record index: ", index_filename);
+  }
+  const uint64 num_records = core::DecodeFixed64(contents.data() + 8);
+  const size_t data_size = contents.size() - sizeof(uint32);
+  if ((data_size - header_size) / sizeof(uint64) != num_records ||
+      (data_size - header_size) % sizeof(uint64) != 0) {
+    return errors::DataLoss("truncated record index: ", index_filename);
+  }
+  const uint32 masked_crc = core::DecodeFixed32(contents.data() + data_size);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(contents.data(), data_size)) {
+    return errors::DataLoss("corrupted record index: ", index_filename);
+  }
+  offsets->resize(num_records);
+  for (uint64 i = 0; i < num_records; ++i) {
+    (*offsets)[i] =
+        core::DecodeFixed64(contents.data() + header_size + i * sizeof(uint64));
+  }
+  return Status::OK();
+}
+
+Status BuildRecordIndex(Env* env, const string& record_filename,
+                        const RecordReaderOptions& options,
+                        std::vector<uint64>* offsets) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(record_filename, &file));
+  RecordReader reader(file.get(), options);
+  offsets->clear();
+  uint64 offset = 0;
+  string record;
+  while (true) {
+    const uint64 record_offset = offset;
+    Status s = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(s)) break;
+    TF_RETURN_IF_ERROR(s);
+    offsets->push_back(record_offset);
+  }
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,62 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Env;
+
+namespace io {
+
+// A record index is a sidecar file listing the offset of every record of a
+// TFRecord file, as accepted by RecordReader::ReadRecord(). It lets readers
+// seek to any record without scanning the file. For compressed files the
+// offsets are positions in the uncompressed stream.
+//
+// Format of an index file:
+//  uint64    magic number
+//  uint64    number of records N
+//  uint64    offset[N]
+//  uint32    masked crc32c of all of the above
+
+// Returns the conventional name of the index of `record_filename`.
+string RecordIndexFilename(const string& record_filename);
+
+// Writes `offsets` as a record index to `index_filename`.
+Status WriteRecordIndex(Env* env, const string& index_filename,
+                        const std::vector<uint64>& offsets);
+
+// Reads the record index at `index_filename` into `*offsets`. Returns
+// NOT_FOUND if the index does not exist.
+Status ReadRecordIndex(Env* env, const string& index_filename,
+                       std::vector<uint64>* offsets);
+
+// Computes the record offsets of `record_filename` by scanning it.
+Status BuildRecordIndex(Env* env, const string& record_filename,
+                        const RecordReaderOptions& options,
+                        std::vector<uint64>* offsets);
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -34,7 +35,12 @@ namespace io {
 
 class RecordReaderOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    BLOCK_GZIP_COMPRESSION = 2,
+    ZSTD_COMPRESSION = 3
+  };
   CompressionType compression_type = NONE;
 
   // If buffer_size is non-zero, then all reads must be sequential, and no
@@ -48,7 +54,15 @@ class RecordReaderOptions {
 #if !defined(IS_SLIM_BUILD)
   // Options specific to zlib compression.
   ZlibCompressionOptions zlib_options;
+
+  // Number of blocks decompressed in parallel ahead of the reader when
+  // compression_type is BLOCK_GZIP_COMPRESSION, twice as many being
+  // buffered. The threads are shared by all readers of the process.
+  int block_gzip_num_threads = 4;
 #endif  // IS_SLIM_BUILD
+
+  // Options specific to zstd compression.
+  ZstdCompressionOptions zstd_options;
 };
 
 // Low-level interface to read TFRecord files.
@@ -20,12 +20,16 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/platform/env.h"
 
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/block_gzip.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/zstd.h"
 
 namespace tensorflow {
 
@@ -41,6 +45,10 @@ io::RecordReaderOptions GetMatchingReaderOptions(
   if (options.compression_type == io::RecordWriterOptions::ZLIB_COMPRESSION) {
     return io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB");
   }
+  if (options.compression_type ==
+      io::RecordWriterOptions::BLOCK_GZIP_COMPRESSION) {
+    return io::RecordReaderOptions::CreateRecordReaderOptions("BLOCK_GZIP");
+  }
   return io::RecordReaderOptions::CreateRecordReaderOptions("");
 }
 
@@ -117,6 +125,12 @@ TEST(RecordReaderWriterTest, TestZlibSyncFlush) {
   VerifyFlush(options);
 }
 
+TEST(RecordReaderWriterTest, TestBlockGzipFlush) {
+  io::RecordWriterOptions options =
+      io::RecordWriterOptions::CreateRecordWriterOptions("BLOCK_GZIP");
+  VerifyFlush(options);
+}
+
 TEST(RecordReaderWriterTest, TestBasics) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_test";
@@ -196,6 +210,191 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestBlockGzipCorruptedUncompressedSize) {
+  string member;
+  TF_ASSERT_OK(io::block_gzip::CompressMember("abcdefgh", Z_DEFAULT_COMPRESSION,
+                                              &member));
+  string data;
+  TF_ASSERT_OK(io::block_gzip::DecompressMember(member, &data));
+  EXPECT_EQ("abcdefgh", data);
+
+  // A size in the trailer that deflate cannot reach is rejected before any
+  // buffer of that size is allocated.
+  core::EncodeFixed32(&member[member.size() - 4], 0xfffffff0);
+  EXPECT_EQ(error::DATA_LOSS,
+            io::block_gzip::DecompressMember(member, &data).code());
+}
+
+TEST(RecordReaderWriterTest, TestBlockGzip) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_block_gzip_test";
+
+  std::vector<string> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(strings::StrCat("record ", i, string(i % 97, 'x')));
+  }
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+    io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions("BLOCK_GZIP");
+    // Small blocks, so that the file has many of them.
+    options.block_gzip_block_size = 1024;
+    io::RecordWriter writer(file.get(), options);
+    for (const string& record : records) {
+      TF_EXPECT_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+
+  for (int num_threads : {1, 4}) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions("BLOCK_GZIP");
+    options.block_gzip_num_threads = num_threads;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    uint64 offset_of_record_10 = 0;
+    string record;
+    for (size_t i = 0; i < records.size(); ++i) {
+      if (i == 10) offset_of_record_10 = offset;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(records[i], record);
+    }
+    EXPECT_EQ(reader.ReadRecord(&offset, &record).code(), error::OUT_OF_RANGE);
+
+    // Seeking backwards restarts decompression from the first block.
+    offset = offset_of_record_10;
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(records[10], record);
+
+    io::RecordReader::Metadata md;
+    TF_ASSERT_OK(reader.GetMetadata(&md));
+    EXPECT_EQ(static_cast<int64>(records.size()), md.stats.entries);
+  }
+
+  // The file is a valid multi-member gzip file.
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(
+      read_file.get(),
+      io::RecordReaderOptions::CreateRecordReaderOptions("GZIP"));
+  uint64 offset = 0;
+  string record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ(records[0], record);
+}
+
+TEST(RecordReaderWriterTest, TestZstd) {
+  string unused;
+  if (!port::Zstd_Compress("", 0, 1, "", &unused)) {
+    LOG(INFO) << "Skipping test: built without zstd support.";
+    return;
+  }
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_zstd_test";
+
+  std::vector<string> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(strings::StrCat("record ", i, string(i % 97, 'x')));
+  }
+  string dictionary;
+  ASSERT_TRUE(port::Zstd_TrainDictionary(records, 1024, &dictionary));
+
+  for (const string& dict : {string(), dictionary}) {
+    {
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+      io::RecordWriterOptions options =
+          io::RecordWriterOptions::CreateRecordWriterOptions("ZSTD");
+      options.zstd_options.block_size = 1024;
+      options.zstd_options.dictionary = dict;
+      io::RecordWriter writer(file.get(), options);
+      for (const string& record : records) {
+        TF_EXPECT_OK(writer.WriteRecord(record));
+      }
+      TF_CHECK_OK(writer.Close());
+      TF_CHECK_OK(file->Close());
+    }
+
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions("ZSTD");
+    options.zstd_options.dictionary = dict;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    string record;
+    for (const string& expected : records) {
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(expected, record);
+    }
+    EXPECT_EQ(reader.ReadRecord(&offset, &record).code(), error::OUT_OF_RANGE);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestRecordIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  std::vector<string> records = {"abc", "", "defg", string(1000, 'x')};
+
+  for (const string& compression : {"", "ZLIB"}) {
+    {
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+      io::RecordWriterOptions options =
+          io::RecordWriterOptions::CreateRecordWriterOptions(compression);
+      options.write_index = true;
+      io::RecordWriter writer(file.get(), options);
+      for (const string& record : records) {
+        TF_EXPECT_OK(writer.WriteRecord(record));
+      }
+      TF_CHECK_OK(writer.Close());
+      TF_CHECK_OK(file->Close());
+    }
+
+    std::vector<uint64> offsets;
+    TF_CHECK_OK(
+        io::ReadRecordIndex(env, io::RecordIndexFilename(fname), &offsets));
+    ASSERT_EQ(records.size(), offsets.size());
+
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions(compression);
+    std::vector<uint64> scanned_offsets;
+    TF_CHECK_OK(io::BuildRecordIndex(env, fname, options, &scanned_offsets));
+    EXPECT_EQ(offsets, scanned_offsets);
+
+    // Read the records back in reverse order through the index.
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReader reader(read_file.get(), options);
+    for (int i = records.size() - 1; i >= 0; --i) {
+      uint64 offset = offsets[i];
+      string record;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(records[i], record);
+    }
+  }
+
+  // A corrupted index is rejected.
+  string contents;
+  TF_CHECK_OK(
+      ReadFileToString(env, io::RecordIndexFilename(fname), &contents));
+  contents[contents.size() / 2] ^= 1;
+  TF_CHECK_OK(
+      WriteStringToFile(env, io::RecordIndexFilename(fname), contents));
+  std::vector<uint64> offsets;
+  EXPECT_EQ(
+      io::ReadRecordIndex(env, io::RecordIndexFilename(fname), &offsets)
+          .code(),
+      error::DATA_LOSS);
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
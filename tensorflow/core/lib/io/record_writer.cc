@@ -16,8 +16,14 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 
 #include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/block_gzip.h"
+#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/record_index.h"
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -26,6 +32,13 @@ namespace {
 bool IsZlibCompressed(RecordWriterOptions options) {
   return options.compression_type == RecordWriterOptions::ZLIB_COMPRESSION;
 }
+bool IsZstdCompressed(RecordWriterOptions options) {
+  return options.compression_type == RecordWriterOptions::ZSTD_COMPRESSION;
+}
+bool IsBlockGzipCompressed(RecordWriterOptions options) {
+  return options.compression_type ==
+         RecordWriterOptions::BLOCK_GZIP_COMPRESSION;
+}
 }  // namespace
 
 RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
@@ -47,6 +60,16 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
 #endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kBlockGzip) {
+    options.compression_type = io::RecordWriterOptions::BLOCK_GZIP_COMPRESSION;
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
+#else
+    options.zlib_options = io::ZlibCompressionOptions::GZIP();
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kZstd) {
+    options.compression_type = io::RecordWriterOptions::ZSTD_COMPRESSION;
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
                << ". No compression will be used.";
@@ -72,6 +95,12 @@ RecordWriter::RecordWriter(WritableFile* dest,
     }
     dest_ = zlib_output_buffer;
 #endif  // IS_SLIM_BUILD
+  } else if (IsBlockGzipCompressed(options)) {
+#if defined(IS_SLIM_BUILD)
+    LOG(FATAL) << "Zlib compression is unsupported on mobile platforms.";
+#endif  // IS_SLIM_BUILD
+  } else if (IsZstdCompressed(options)) {
+    dest_ = new ZstdOutputBuffer(dest, options.zstd_options);
   } else if (options.compression_type == RecordWriterOptions::NONE) {
     // Nothing to do
   } else {
@@ -98,10 +127,17 @@ Status RecordWriter::WriteRecord(StringPiece data) {
   //  uint32    masked crc of length
   //  byte      data[length]
   //  uint32    masked crc of data
+  AddRecordOffset(data.size());
   char header[kHeaderSize];
   char footer[kFooterSize];
   PopulateHeader(header, data.data(), data.size());
   PopulateFooter(footer, data.data(), data.size());
+  if (IsBlockGzipCompressed(options_)) {
+    block_.append(header, sizeof(header));
+    block_.append(data.data(), data.size());
+    block_.append(footer, sizeof(footer));
+    return WriteBlockIfFull();
+  }
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
   return dest_->Append(StringPiece(footer, sizeof(footer)));
@@ -118,10 +154,17 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
   //  uint32    masked crc of length
   //  byte      data[length]
   //  uint32    masked crc of data
+  AddRecordOffset(data.size());
   char header[kHeaderSize];
   char footer[kFooterSize];
   PopulateHeader(header, data);
   PopulateFooter(footer, data);
+  if (IsBlockGzipCompressed(options_)) {
+    block_.append(header, sizeof(header));
+    block_.append(std::string(data));
+    block_.append(footer, sizeof(footer));
+    return WriteBlockIfFull();
+  }
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
   return dest_->Append(StringPiece(footer, sizeof(footer)));
@@ -130,6 +173,13 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
 
 Status RecordWriter::Close() {
   if (dest_ == nullptr) return Status::OK();
+  TF_RETURN_IF_ERROR(WriteIndex());
+  if (IsZstdCompressed(options_)) {
+    Status s = dest_->Close();
+    delete dest_;
+    dest_ = nullptr;
+    return s;
+  }
 #if !defined(IS_SLIM_BUILD)
   if (IsZlibCompressed(options_)) {
     Status s = dest_->Close();
@@ -137,6 +187,11 @@ Status RecordWriter::Close() {
     dest_ = nullptr;
     return s;
   }
+  if (IsBlockGzipCompressed(options_)) {
+    Status s = WriteBlock();
+    dest_ = nullptr;
+    return s;
+  }
 #endif  // IS_SLIM_BUILD
   return Status::OK();
 }
@@ -146,8 +201,55 @@ Status RecordWriter::Flush() {
     return Status(::tensorflow::error::FAILED_PRECONDITION,
                   "Writer not initialized or previously closed");
   }
+  if (IsBlockGzipCompressed(options_)) {
+    TF_RETURN_IF_ERROR(WriteBlock());
+  }
   return dest_->Flush();
 }
 
+void RecordWriter::AddRecordOffset(size_t n) {
+  if (options_.write_index) {
+    record_offsets_.push_back(offset_);
+  }
+  offset_ += kHeaderSize + n + kFooterSize;
+}
+
+Status RecordWriter::WriteIndex() {
+  if (!options_.write_index || index_written_) return Status::OK();
+  StringPiece name;
+  Status s = dest_->Name(&name);
+  if (!s.ok()) {
+    return errors::FailedPrecondition(
+        "Cannot write a record index: the destination file has no name: ",
+        s.error_message());
+  }
+  TF_RETURN_IF_ERROR(WriteRecordIndex(
+      Env::Default(), RecordIndexFilename(string(name)), record_offsets_));
+  index_written_ = true;
+  return Status::OK();
+}
+
+Status RecordWriter::WriteBlockIfFull() {
+#if !defined(IS_SLIM_BUILD)
+  if (static_cast<int64>(block_.size()) >= options_.block_gzip_block_size) {
+    return WriteBlock();
+  }
+#endif  // IS_SLIM_BUILD
+  return Status::OK();
+}
+
+Status RecordWriter::WriteBlock() {
+  if (block_.empty()) return Status::OK();
+#if !defined(IS_SLIM_BUILD)
+  string member;
+  TF_RETURN_IF_ERROR(block_gzip::CompressMember(
+      block_, options_.zlib_options.compression_level, &member));
+  block_.clear();
+  return dest_->Append(member);
+#else
+  return errors::Unimplemented("BLOCK_GZIP is unsupported on mobile platforms");
+#endif  // IS_SLIM_BUILD
+}
+
 }  // namespace io
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 
+#include <vector>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -24,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #endif  // IS_SLIM_BUILD
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -36,7 +39,12 @@ namespace io {
 
 class RecordWriterOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    BLOCK_GZIP_COMPRESSION = 2,
+    ZSTD_COMPRESSION = 3
+  };
   CompressionType compression_type = NONE;
 
   static RecordWriterOptions CreateRecordWriterOptions(
@@ -45,7 +53,21 @@ class RecordWriterOptions {
 // Options specific to zlib compression.
 #if !defined(IS_SLIM_BUILD)
   tensorflow::io::ZlibCompressionOptions zlib_options;
+
+  // With BLOCK_GZIP_COMPRESSION, records are buffered and compressed as an
+  // independent block once at least this many uncompressed bytes are
+  // pending. Blocks always end on a record boundary. The compression level
+  // is taken from zlib_options.
+  int64 block_gzip_block_size = 1 << 20;
 #endif  // IS_SLIM_BUILD
+
+  // Options specific to zstd compression.
+  ZstdCompressionOptions zstd_options;
+
+  // If true, Close() also writes a record index (see record_index.h) of the
+  // file to RecordIndexFilename() of the destination's name. The destination
+  // WritableFile must implement Name().
+  bool write_index = false;
 };
 
 class RecordWriter {
@@ -101,9 +123,29 @@ class RecordWriter {
 #endif
 
  private:
+  // Compresses the pending BLOCK_GZIP records and appends them to dest_,
+  // either unconditionally or once they reach the configured block size.
+  Status WriteBlock();
+  Status WriteBlockIfFull();
+
+  // Records the offset of a record of `n` bytes about to be written.
+  void AddRecordOffset(size_t n);
+
+  // Writes the record index, if requested by the options.
+  Status WriteIndex();
+
   WritableFile* dest_;
   RecordWriterOptions options_;
 
+  // Records not yet compressed, with BLOCK_GZIP_COMPRESSION.
+  string block_;
+
+  // Offset of the next record in the uncompressed stream, and the offsets
+  // of the records written so far if an index is requested.
+  uint64 offset_ = 0;
+  std::vector<uint64> record_offsets_;
+  bool index_written_ = false;
+
   inline static uint32 MaskedCrc(const char* data, size_t n) {
     return crc32c::Mask(crc32c::Value(data, n));
   }
@@ -0,0 +1,47 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_COMPRESSION_OPTIONS_H_
+#define TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_COMPRESSION_OPTIONS_H_
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+class ZstdCompressionOptions {
+ public:
+  // zstd compression level. Levels range from 1 (fastest) to 19 (smallest);
+  // negative levels trade even more ratio for speed.
+  int compression_level = 3;
+
+  // Uncompressed size at which buffered data is compressed into a block.
+  // Larger blocks compress better; smaller blocks allow more parallelism
+  // when reading.
+  int64 block_size = 1 << 20;
+
+  // Optional dictionary, e.g. from port::Zstd_TrainDictionary(). Data
+  // compressed with a dictionary must be read with the same dictionary.
+  string dictionary;
+
+  // Number of blocks decompressed in parallel ahead of the reader. The
+  // threads are shared by all readers of the process.
+  int num_decompression_threads = 4;
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_COMPRESSION_OPTIONS_H_
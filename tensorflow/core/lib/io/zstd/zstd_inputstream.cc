@@ -0,0 +1,81 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/zstd/zstd_inputstream.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
+#include "tensorflow/core/platform/zstd.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+class ZstdFormat : public BlockInputStream::Format {
+ public:
+  explicit ZstdFormat(const string& dictionary) : dictionary_(dictionary) {}
+
+  const char* name() const override { return "ZSTD"; }
+
+  size_t header_size() const override {
+    return ZstdOutputBuffer::kBlockHeaderSize;
+  }
+
+  Status ParseBlockSize(StringPiece header, uint64* block_size) const override {
+    if (core::DecodeFixed32(header.data()) !=
+            ZstdOutputBuffer::kSkippableFrameMagic ||
+        core::DecodeFixed32(header.data() + 4) != sizeof(uint32)) {
+      return errors::DataLoss("not a ZSTD block header");
+    }
+    *block_size = ZstdOutputBuffer::kBlockHeaderSize +
+                  core::DecodeFixed32(header.data() + 8);
+    return Status::OK();
+  }
+
+  Status DecompressBlock(StringPiece block, string* output) const override {
+    const char* frame = block.data() + ZstdOutputBuffer::kBlockHeaderSize;
+    const size_t frame_size = block.size() - ZstdOutputBuffer::kBlockHeaderSize;
+    size_t uncompressed_size;
+    if (!port::Zstd_GetUncompressedLength(frame, frame_size,
+                                          &uncompressed_size)) {
+      return errors::DataLoss(
+          "corrupted ZSTD block, or TensorFlow is not built with "
+          "--define=with_zstd_support=true");
+    }
+    output->resize(uncompressed_size);
+    if (!port::Zstd_Uncompress(frame, frame_size, dictionary_, &(*output)[0],
+                               uncompressed_size)) {
+      return errors::DataLoss("corrupted ZSTD block");
+    }
+    return Status::OK();
+  }
+
+ private:
+  const string dictionary_;
+};
+
+}  // namespace
+
+ZstdInputStream::ZstdInputStream(InputStreamInterface* input_stream,
+                                 const ZstdCompressionOptions& options,
+                                 bool owns_input_stream)
+    : BlockInputStream(input_stream,
+                       std::make_shared<ZstdFormat>(options.dictionary),
+                       options.num_decompression_threads, owns_input_stream) {
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,43 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_INPUTSTREAM_H_
+
+#include "tensorflow/core/lib/io/block_inputstream.h"
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+
+namespace tensorflow {
+namespace io {
+
+// An InputStreamInterface that decompresses the output of ZstdOutputBuffer,
+// decompressing up to `options.num_decompression_threads` blocks ahead of the
+// reader in parallel.
+//
+// Note: this class is not thread safe; external synchronization required.
+class ZstdInputStream : public BlockInputStream {
+ public:
+  // Create a ZstdInputStream for `input_stream`. If `owns_input_stream` is
+  // true, the stream is deleted when this stream is deleted.
+  ZstdInputStream(InputStreamInterface* input_stream,
+                  const ZstdCompressionOptions& options,
+                  bool owns_input_stream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_INPUTSTREAM_H_
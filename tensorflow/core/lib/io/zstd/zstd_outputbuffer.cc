@@ -0,0 +1,99 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
+
+#include <limits>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/zstd.h"
+
+namespace tensorflow {
+namespace io {
+
+ZstdOutputBuffer::ZstdOutputBuffer(WritableFile* file,
+                                   const ZstdCompressionOptions& options)
+    : file_(file), options_(options) {}
+
+ZstdOutputBuffer::~ZstdOutputBuffer() {
+  if (!buffer_.empty()) {
+    LOG(WARNING) << "ZstdOutputBuffer::Close() not called. Possible data loss";
+  }
+}
+
+Status ZstdOutputBuffer::Append(StringPiece data) {
+  if (closed_) {
+    return errors::FailedPrecondition("ZstdOutputBuffer is closed");
+  }
+  buffer_.append(data.data(), data.size());
+  if (static_cast<int64>(buffer_.size()) >= options_.block_size) {
+    return WriteBlock();
+  }
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::Flush() {
+  if (closed_) {
+    return errors::FailedPrecondition("ZstdOutputBuffer is closed");
+  }
+  TF_RETURN_IF_ERROR(WriteBlock());
+  return file_->Flush();
+}
+
+Status ZstdOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status ZstdOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status ZstdOutputBuffer::Close() {
+  if (!closed_) {
+    TF_RETURN_IF_ERROR(WriteBlock());
+    closed_ = true;
+  }
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::WriteBlock() {
+  if (buffer_.empty()) return Status::OK();
+  string frame;
+  if (!port::Zstd_Compress(buffer_.data(), buffer_.size(),
+                           options_.compression_level, options_.dictionary,
+                           &frame)) {
+    return errors::Internal(
+        "zstd compression failed; is TensorFlow built with "
+        "--define=with_zstd_support=true?");
+  }
+  if (frame.size() > std::numeric_limits<uint32>::max()) {
+    return errors::InvalidArgument("zstd block too large: ", frame.size(),
+                                   " bytes");
+  }
+  char header[kBlockHeaderSize];
+  core::EncodeFixed32(header, kSkippableFrameMagic);
+  core::EncodeFixed32(header + 4, sizeof(uint32));
+  core::EncodeFixed32(header + 8, frame.size());
+  TF_RETURN_IF_ERROR(file_->Append(StringPiece(header, sizeof(header))));
+  TF_RETURN_IF_ERROR(file_->Append(frame));
+  buffer_.clear();
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,95 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Compresses data written to it with Zstandard (https://facebook.github.io/
+// zstd/) and writes it to `file`.
+//
+// Input is buffered and compressed into independent blocks of about
+// `options.block_size` bytes, so that ZstdInputStream can decompress several
+// blocks in parallel.
+//
+// Output file format:
+// A sequence of blocks, each made of
+//   uint32    0x184D2A50, the magic number of a zstd skippable frame
+//   uint32    4, the size of the skippable frame
+//   uint32    size of the zstd frame that follows
+//   byte      a zstd frame holding the block
+// All integers are little-endian. The output is a valid zstd stream and can
+// be decompressed by the `zstd` command line tool when no dictionary is used.
+//
+// A given instance of a ZstdOutputBuffer is NOT safe for concurrent use by
+// multiple threads.
+class ZstdOutputBuffer : public WritableFile {
+ public:
+  static const uint32 kSkippableFrameMagic = 0x184D2A50;
+  static const size_t kBlockHeaderSize = 3 * sizeof(uint32);
+
+  // Create a ZstdOutputBuffer for `file`. Does not take ownership of `file`.
+  ZstdOutputBuffer(WritableFile* file, const ZstdCompressionOptions& options);
+
+  ~ZstdOutputBuffer() override;
+
+  // Adds `data` to the current block, compressing and writing the block to
+  // file once it reaches `options.block_size` bytes.
+  Status Append(StringPiece data) override;
+
+  // Compresses any buffered input and writes it to file. The resulting block
+  // may be smaller than `options.block_size`.
+  Status Flush() override;
+
+  // Compresses any buffered input and writes it to file. This must be called
+  // before the destructor to avoid any data loss. Does not close `file`.
+  //
+  // After calling this, any further calls to `Append()` or `Flush()` will
+  // fail.
+  Status Close() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Compresses any buffered input, writes it to file and syncs it.
+  Status Sync() override;
+
+ private:
+  // Compresses `buffer_` into a block and appends it to `file_`.
+  Status WriteBlock();
+
+  WritableFile* file_;  // Not owned
+  const ZstdCompressionOptions options_;
+  string buffer_;
+  bool closed_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ZstdOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
@@ -190,6 +190,43 @@ class PhiloxRandom {
     return counter;
   }
 
+  // Fills 'results' with the next 'N' groups of random numbers, the same as
+  // calling operator() 'N' times. Each round is computed for all groups at
+  // once, so that the compiler can vectorize the rounds across groups.
+  template <int N>
+  PHILOX_DEVICE_INLINE void Generate(ResultType* results) {
+    uint32 c0[N], c1[N], c2[N], c3[N];
+    for (int i = 0; i < N; ++i) {
+      c0[i] = counter_[0];
+      c1[i] = counter_[1];
+      c2[i] = counter_[2];
+      c3[i] = counter_[3];
+      SkipOne();
+    }
+    Key key = key_;
+    for (int round = 0; round < 10; ++round) {
+      for (int i = 0; i < N; ++i) {
+        uint32 lo0;
+        uint32 hi0;
+        MultiplyHighLow(kPhiloxM4x32A, c0[i], &lo0, &hi0);
+        uint32 lo1;
+        uint32 hi1;
+        MultiplyHighLow(kPhiloxM4x32B, c2[i], &lo1, &hi1);
+        c0[i] = hi1 ^ c1[i] ^ key[0];
+        c1[i] = lo1;
+        c2[i] = hi0 ^ c3[i] ^ key[1];
+        c3[i] = lo0;
+      }
+      RaiseKey(&key);
+    }
+    for (int i = 0; i < N; ++i) {
+      results[i][0] = c0[i];
+      results[i][1] = c1[i];
+      results[i][2] = c2[i];
+      results[i][3] = c3[i];
+    }
+  }
+
  private:
   // We use the same constants as recommended by the original paper.
   static const uint32 kPhiloxW32A = 0x9E3779B9;
@@ -68,6 +68,28 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+TEST(PhiloxRandomTest, GenerateMatchTest) {
+  PhiloxRandom gen1(GetTestSeed());
+  // Start next to a carry into the upper words of the counter.
+  gen1.Skip(0xfffffffcull);
+  PhiloxRandom gen2 = gen1;
+
+  PhiloxRandom::ResultType results[8];
+  gen1.Generate<8>(results);
+  for (int i = 0; i < 8; ++i) {
+    PhiloxRandom::ResultType expected = gen2();
+    for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+      ASSERT_EQ(expected[j], results[i][j]);
+    }
+  }
+  // Both generators continue from the same counter.
+  PhiloxRandom::ResultType next1 = gen1();
+  PhiloxRandom::ResultType next2 = gen2();
+  for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+    EXPECT_EQ(next2[j], next1[j]);
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
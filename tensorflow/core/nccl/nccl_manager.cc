@@ -20,8 +20,10 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/cuda.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -82,12 +84,17 @@ struct NcclManager::CommunicatorMember {
 struct NcclManager::Communicator {
  public:
   explicit Communicator(std::vector<CommunicatorMember> members,
-                        const string& key)
-      : num_devices(members.size()), members(std::move(members)), key(key) {}
+                        const string& key, int slot)
+      : num_devices(members.size()),
+        members(std::move(members)),
+        key(key),
+        slot(slot) {}
 
   const int num_devices;
   const std::vector<CommunicatorMember> members;
   const string key;
+  // Distinguishes single-node communicators over the same devices.
+  const int slot;
 };
 
 namespace {
@@ -115,6 +122,17 @@ void StringToNcclUniqueId(const string& str_id, ncclUniqueId* nccl_id) {
   }
 }
 
+int NumStreamsPerDevice() {
+  int64 num_streams = 1;
+  Status s = ReadInt64FromEnvVar("TF_NCCL_NUM_STREAMS_PER_DEVICE", 1,
+                                 &num_streams);
+  if (!s.ok() || num_streams < 1) {
+    LOG(ERROR) << "Ignoring invalid TF_NCCL_NUM_STREAMS_PER_DEVICE: " << s;
+    return 1;
+  }
+  return static_cast<int>(num_streams);
+}
+
 }  // namespace
 
 // A `Collective` encapsulates state for a collective instance at one node.
@@ -178,7 +196,9 @@ struct NcclManager::Collective : public core::RefCounted {
   Status status;
 };
 
-NcclManager::NcclManager() { VLOG(2) << "New NcclManager " << this; }
+NcclManager::NcclManager() : num_streams_per_device_(NumStreamsPerDevice()) {
+  VLOG(2) << "New NcclManager " << this;
+}
 NcclManager::~NcclManager() {
   VLOG(2) << "~NcclManager " << this;
   for (auto& it : device_to_comm_streams_) {
@@ -203,6 +223,36 @@ string NcclManager::GenerateCommunicatorKey() {
   return string(nccl_id.internal, NCCL_UNIQUE_ID_BYTES);
 }
 
+Status NcclManager::WarmUpCommunicators(
+    const std::vector<se::StreamExecutor*>& executors,
+    const std::vector<int>& gpu_device_ids) {
+  if (executors.size() != gpu_device_ids.size()) {
+    return errors::InvalidArgument("Got ", executors.size(),
+                                   " executors but ", gpu_device_ids.size(),
+                                   " device ids");
+  }
+  // Same order as GetCommunicator.
+  std::vector<std::pair<se::StreamExecutor*, int>> devices;
+  for (int i = 0; i < executors.size(); ++i) {
+    devices.emplace_back(executors[i], gpu_device_ids[i]);
+  }
+  std::sort(devices.begin(), devices.end());
+  std::vector<se::StreamExecutor*> sorted_executors;
+  std::vector<int> sorted_device_ids;
+  for (const auto& d : devices) {
+    sorted_executors.push_back(d.first);
+    sorted_device_ids.push_back(d.second);
+  }
+
+  mutex_lock l(mu_);
+  for (int slot = 0; slot < num_streams_per_device_; ++slot) {
+    Communicator* communicator;
+    TF_RETURN_IF_ERROR(GetSingleNodeCommunicator(
+        sorted_executors, sorted_device_ids, slot, &communicator));
+  }
+  return Status::OK();
+}
+
 Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
                                     NcclManager::Communicator** communicator) {
   // Sort by executor to make ordering of executors deterministic.
@@ -211,128 +261,158 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
                const std::unique_ptr<Participant>& b) {
               return a->executor < b->executor;
             });
+  std::vector<se::StreamExecutor*> executors;
+  std::vector<int> gpu_device_ids;
+  std::vector<int> ranks;
+  for (int i = 0; i < collective->num_local_devices; ++i) {
+    const Participant& p = *collective->participants[i];
+    executors.push_back(p.executor);
+    gpu_device_ids.push_back(p.gpu_device_id);
+    // Set rank to `participant->global_rank` if provided, else `i`.
+    ranks.push_back(p.global_rank >= 0 ? p.global_rank : i);
+  }
 
   mutex_lock l(mu_);
 
   if (collective->communicator_key.empty()) {
-    // For single-node collectives, when the caller does not specify a
-    // `communicator_key`, we identify a communicator uniquely by the set of
-    // devices participating in the collective.  For example, if a collective is
-    // for GPUs 0, 1, and 2 then this will scan to find the communicator for
-    // GPUs 0, 1, and 2.
-    //
-    // Note that each executor identifies a context on one device, so this is
-    // the same as getting the communicator connecting the devices in the
-    // collective. A device can be in different communicators as well - for
-    // example, a communicator for GPUs 0 and 1 is separate from one for GPUs 0,
-    // 1, and 2.
-    //
-    // Since it's expected that a small number of distinct communicators will
-    // be needed, communicators_ is not garbage collected currently.
-    //
-    // Launching of kernels must be serialized so that, given collectives A and
-    // B, and an order of them (e.g., A before B), then for each comm_stream
-    // involved, the kernel for A is launched before the kernel for B. This is
-    // guaranteed currently be a global mutex controlling additions of the
-    // kernels to per-stream launch queues.  The launch queues are processed by
-    // LoopKernelLaunches.
-    for (auto& comm : communicators_) {
-      if (comm->num_devices == collective->num_global_devices) {
-        int i;
-        for (i = 0; i < collective->num_local_devices; ++i) {
-          if (comm->members[i].nccl_stream->executor !=
-              collective->participants[i]->executor) {
-            break;
-          }
-        }
-        if (i == collective->num_local_devices) {
-          *communicator = comm.get();
-          return Status::OK();
-        }
-      }
-    }
-  } else {
+    // Independent collectives over the same devices are spread over
+    // `num_streams_per_device_` communicators, each with its own streams, so
+    // that they can run concurrently.  Every participant at this node uses
+    // the same collective_key, hence the same communicator.
+    const int slot =
+        Hash64(collective->collective_key) % num_streams_per_device_;
+    return GetSingleNodeCommunicator(executors, gpu_device_ids, slot,
+                                     communicator);
+  }
+
 #if NCCL_MAJOR < 2
-    return errors::Internal(
-        "Cannot use multi-node NCCL collectives with NCCL 1.x");
+  return errors::Internal(
+      "Cannot use multi-node NCCL collectives with NCCL 1.x");
 #endif
-    if (collective->communicator_key.size() != NCCL_UNIQUE_ID_BYTES) {
-      return errors::Internal("Expected communicator_key of size ",
-                              NCCL_UNIQUE_ID_BYTES, " but found size ",
-                              collective->communicator_key.size());
+  if (collective->communicator_key.size() != NCCL_UNIQUE_ID_BYTES) {
+    return errors::Internal("Expected communicator_key of size ",
+                            NCCL_UNIQUE_ID_BYTES, " but found size ",
+                            collective->communicator_key.size());
+  }
+  // This is an instance of multi-node collective.  We have previously
+  // created a NCCL unique id and shared with all workers.  Now we find the
+  // `Communicator` corresponding to this id.
+  for (auto& comm : communicators_) {
+    if (comm->key == collective->communicator_key) {
+      *communicator = comm.get();
+      return Status::OK();
     }
-    // This is an instance of multi-node collective.  We have previously
-    // created a NCCL unique id and shared with all workers.  Now we find the
-    // `Communicator` corresponding to this id.
-    for (auto& comm : communicators_) {
-      if (comm->key == collective->communicator_key) {
+  }
+  return CreateCommunicator(executors, gpu_device_ids, ranks,
+                            collective->num_global_devices,
+                            collective->communicator_key, 0 /*slot*/,
+                            communicator);
+}
+
+Status NcclManager::GetSingleNodeCommunicator(
+    const std::vector<se::StreamExecutor*>& executors,
+    const std::vector<int>& gpu_device_ids, int slot,
+    Communicator** communicator) {
+  // For single-node collectives, when the caller does not specify a
+  // `communicator_key`, we identify a communicator uniquely by the set of
+  // devices participating in the collective and the stream slot.  For example,
+  // if a collective is for GPUs 0, 1, and 2 then this will scan to find the
+  // communicator for GPUs 0, 1, and 2.
+  //
+  // Note that each executor identifies a context on one device, so this is
+  // the same as getting the communicator connecting the devices in the
+  // collective. A device can be in different communicators as well - for
+  // example, a communicator for GPUs 0 and 1 is separate from one for GPUs 0,
+  // 1, and 2.
+  //
+  // Since it's expected that a small number of distinct communicators will
+  // be needed, communicators_ is not garbage collected currently.
+  //
+  // Launching of kernels must be serialized so that, given collectives A and
+  // B, and an order of them (e.g., A before B), then for each comm_stream
+  // involved, the kernel for A is launched before the kernel for B. This is
+  // guaranteed currently be a global mutex controlling additions of the
+  // kernels to per-stream launch queues.  The launch queues are processed by
+  // LoopKernelLaunches.
+  const int num_devices = executors.size();
+  for (auto& comm : communicators_) {
+    if (comm->key.empty() && comm->slot == slot &&
+        comm->num_devices == num_devices) {
+      int i;
+      for (i = 0; i < num_devices; ++i) {
+        if (comm->members[i].nccl_stream->executor != executors[i]) {
+          break;
+        }
+      }
+      if (i == num_devices) {
         *communicator = comm.get();
         return Status::OK();
       }
     }
   }
+  std::vector<int> ranks(num_devices);
+  for (int i = 0; i < num_devices; ++i) ranks[i] = i;
+  return CreateCommunicator(executors, gpu_device_ids, ranks, num_devices,
+                            "" /*communicator_key*/, slot, communicator);
+}
 
+Status NcclManager::CreateCommunicator(
+    const std::vector<se::StreamExecutor*>& executors,
+    const std::vector<int>& gpu_device_ids, const std::vector<int>& ranks,
+    int num_global_devices, const string& communicator_key, int slot,
+    Communicator** communicator) {
   auto* env = Env::Default();
   std::set<NcclStream*> used_streams;
+  const int num_local_devices = executors.size();
 
   // Create and initialize a new communicator.
   // Note that this is done under the lock; performance is not expected to
   // matter as this happens a very small number of times.
-  std::vector<CommunicatorMember> members(collective->num_local_devices);
-  std::vector<int> devices(collective->num_local_devices);
-  for (int i = 0; i < collective->num_local_devices; ++i) {
-    auto* executor = collective->participants[i]->executor;
+  std::vector<CommunicatorMember> members(num_local_devices);
+  for (int i = 0; i < num_local_devices; ++i) {
+    auto* executor = executors[i];
 
     // Find a communication stream to use for the device.
     auto& streams = device_to_comm_streams_[executor];
     NcclStream* nccl_stream = nullptr;
-    for (const auto& s : streams) {
-      if (used_streams.insert(s).second) {
-        nccl_stream = s;
-        break;
+    for (int j = slot; nccl_stream == nullptr; ++j) {
+      while (streams.size() <= j) {
+        NcclStream* new_stream = new NcclStream();
+        new_stream->executor = executor;
+        new_stream->stream.reset(new se::Stream(executor));
+        new_stream->stream->Init();
+        streams.emplace_back(new_stream);
+
+        new_stream->Ref();
+        env->SchedClosure([this, new_stream]() {
+          LoopKernelLaunches(new_stream);
+          new_stream->Unref();
+        });
+      }
+      if (used_streams.insert(streams[j]).second) {
+        nccl_stream = streams[j];
       }
     }
-    if (nccl_stream == nullptr) {
-      nccl_stream = new NcclStream();
-      nccl_stream->executor = executor;
-      nccl_stream->stream.reset(new se::Stream(executor));
-      nccl_stream->stream->Init();
-
-      streams.emplace_back(nccl_stream);
-      used_streams.insert(nccl_stream);
-
-      nccl_stream->Ref();
-      env->SchedClosure([this, nccl_stream]() {
-        LoopKernelLaunches(nccl_stream);
-        nccl_stream->Unref();
-      });
-    }
-
     members[i].nccl_stream = nccl_stream;
-    devices[i] = collective->participants[i]->gpu_device_id;
   }
 
-  std::vector<ncclComm_t> nccl_comms(collective->num_local_devices);
+  std::vector<ncclComm_t> nccl_comms(num_local_devices);
 #if NCCL_MAJOR >= 2
   // For NCCL 2, we always initialize using ncclCommInitRank guarded by NCCL
   // group primitives.
   ncclUniqueId nccl_id;
-  if (collective->single_node) {
+  if (communicator_key.empty()) {
     NCCL_RETURN_IF_ERROR(ncclGetUniqueId(&nccl_id));
   } else {
-    StringToNcclUniqueId(collective->communicator_key, &nccl_id);
+    StringToNcclUniqueId(communicator_key, &nccl_id);
   }
   int saved_device = 0;
   CUDA_RETURN_IF_ERROR(cudaGetDevice(&saved_device));
   NCCL_RETURN_IF_ERROR(ncclGroupStart());
-  for (int i = 0; i < collective->num_local_devices; ++i) {
-    // Set rank to `participant->global_rank` if provided, else `i`.
-    const int rank = collective->participants[i]->global_rank >= 0
-                         ? collective->participants[i]->global_rank
-                         : i;
-    CUDA_RETURN_IF_ERROR(cudaSetDevice(devices[i]));
+  for (int i = 0; i < num_local_devices; ++i) {
+    CUDA_RETURN_IF_ERROR(cudaSetDevice(gpu_device_ids[i]));
     NCCL_RETURN_IF_ERROR(ncclCommInitRank(
-        nccl_comms.data() + i, collective->num_global_devices, nccl_id, rank));
+        nccl_comms.data() + i, num_global_devices, nccl_id, ranks[i]));
   }
   NCCL_RETURN_IF_ERROR(ncclGroupEnd());
   CUDA_RETURN_IF_ERROR(cudaSetDevice(saved_device));
@@ -341,15 +421,15 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
   // used ncclCommInitRank with NCCL 1 as well, but then we would have to
   // issue each init call from a different thread
   // (https://docs.nvidia.com/deeplearning/sdk/nccl-developer-guide/docs/nccl1.html).
-  NCCL_RETURN_IF_ERROR(ncclCommInitAll(
-      nccl_comms.data(), collective->num_local_devices, devices.data()));
+  NCCL_RETURN_IF_ERROR(ncclCommInitAll(nccl_comms.data(), num_local_devices,
+                                       gpu_device_ids.data()));
 #endif
 
-  for (int i = 0; i < collective->num_local_devices; ++i) {
+  for (int i = 0; i < num_local_devices; ++i) {
     members[i].nccl_comm = nccl_comms[i];
   }
   communicators_.emplace_back(
-      new Communicator(std::move(members), collective->communicator_key));
+      new Communicator(std::move(members), communicator_key, slot));
   *communicator = communicators_.back().get();
   return Status::OK();
 }
@@ -569,8 +649,9 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
       comm_stream->implementation()->GpuStreamMemberHack());
 
   while (true) {
-    // Find collective to run.
-    std::pair<Collective*, int> next_launch;
+    // Find collectives to run.  All launches queued so far are taken at
+    // once, in the order in which they were added.
+    std::vector<std::pair<Collective*, int>> launches;
     {
       VLOG(3) << "Locking mutex nccl_stream " << nccl_stream;
       mutex_lock l(nccl_stream->mu);
@@ -581,83 +662,118 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
         }
         nccl_stream->cv.wait(l);
       }
-      next_launch = nccl_stream->pending_launches_.back();
-      nccl_stream->pending_launches_.pop_back();
+      while (!nccl_stream->pending_launches_.empty()) {
+        launches.push_back(nccl_stream->pending_launches_.back());
+        nccl_stream->pending_launches_.pop_back();
+      }
     }
 
-    // Launch the nccl kernel.
-    Collective* collective = next_launch.first;
-    ncclDataType_t data_type = ToNcclType(collective->data_type);
-    int p_idx = next_launch.second;
-    Participant* p = collective->participants[p_idx].get();
-    auto nccl_comm = collective->communicator->members[p_idx].nccl_comm;
-    ncclResult_t nccl_result = ncclSuccess;
-    switch (collective->type) {
-      case kAllReduce: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
-
-        VLOG(2) << "call NcclAllReduce collective_key "
-                << collective->collective_key << " participant " << p_idx
-                << " sendbuff " << sendbuff << " recvbuff " << recvbuff
-                << " nccl_comm " << nccl_comm << " comm_stream " << comm_stream
-                << " cuda_stream " << cu_stream;
-        nccl_result = ncclAllReduce(sendbuff, recvbuff, p->input->NumElements(),
-                                    data_type, collective->reduction_op,
-                                    nccl_comm, *cu_stream);
-        break;
-      }
-      case kBroadcast: {
-        const Tensor* buf_t = p->input ? p->input : p->output;
-        void* buf = const_cast<char*>(buf_t->tensor_data().data());
-        nccl_result = ncclBcast(buf, buf_t->NumElements(), data_type,
-                                collective->root_rank, nccl_comm, *cu_stream);
-        break;
+    // Launch the nccl kernels.  With NCCL 2, several launches are aggregated
+    // into one group so that they are issued with a single launch overhead.
+    std::vector<ncclResult_t> nccl_results(launches.size(), ncclSuccess);
+#if NCCL_MAJOR >= 2
+    const bool grouped = launches.size() > 1;
+    ncclResult_t group_result = ncclSuccess;
+    if (grouped) {
+      group_result = ncclGroupStart();
+    }
+#endif
+    for (int i = 0; i < launches.size(); ++i) {
+      nccl_results[i] =
+          LaunchKernel(launches[i].first, launches[i].second, cu_stream);
+    }
+#if NCCL_MAJOR >= 2
+    if (grouped) {
+      if (group_result == ncclSuccess) {
+        group_result = ncclGroupEnd();
       }
-      case kReduce: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff =
-            p->output ? const_cast<char*>(p->output->tensor_data().data())
-                      : nullptr;
-        nccl_result = ncclReduce(sendbuff, recvbuff, p->input->NumElements(),
-                                 data_type, collective->reduction_op,
-                                 collective->root_rank, nccl_comm, *cu_stream);
-        break;
+      if (group_result != ncclSuccess) {
+        // None of the kernels of the group have been launched.
+        for (auto& nccl_result : nccl_results) {
+          if (nccl_result == ncclSuccess) nccl_result = group_result;
+        }
       }
-      case kAllGather: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
+    }
+#endif
 
-        VLOG(2) << "call NcclAllGather collective_key "
+    for (int i = 0; i < launches.size(); ++i) {
+      Collective* collective = launches[i].first;
+      const int p_idx = launches[i].second;
+      const ncclResult_t nccl_result = nccl_results[i];
+      // Run the done_callback when the nccl kernel finishes running.
+      auto done_callback = [collective, p_idx, nccl_result]() {
+        VLOG(2) << "done Nccl kernel collective_key "
                 << collective->collective_key << " participant " << p_idx
-                << " sendbuff " << sendbuff << " sendcount "
-                << p->input->NumElements() << " recvbuff " << recvbuff
-                << " recvcount " << p->output->NumElements() << " nccl_comm "
-                << nccl_comm << " comm_stream " << comm_stream
-                << " cuda_stream " << cu_stream;
-        nccl_result = ncclAllGather(sendbuff, recvbuff, p->input->NumElements(),
-                                    data_type, nccl_comm, *cu_stream);
-        break;
-      }
+                << " ncclResult " << nccl_result;
+        if (nccl_result == ncclSuccess) {
+          collective->participants[p_idx]->done_callback(Status::OK());
+        } else {
+          // Propagate the error, but note that if other members of the
+          // collective did launch their kernels, then they are hanging.
+          collective->participants[p_idx]->done_callback(errors::Unknown(
+              "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
+        }
+        collective->Unref();
+      };
+      collective->participants[p_idx]->event_mgr->ThenExecute(comm_stream,
+                                                              done_callback);
     }
+  }
+}
 
-    // Run the done_callback when the nccl kernel finishes running.
-    auto done_callback = [collective, p_idx, nccl_result]() {
-      VLOG(2) << "done Nccl kernel collective_key "
+ncclResult_t NcclManager::LaunchKernel(Collective* collective, int p_idx,
+                                       const cudaStream_t* cu_stream) {
+  ncclDataType_t data_type = ToNcclType(collective->data_type);
+  Participant* p = collective->participants[p_idx].get();
+  auto nccl_comm = collective->communicator->members[p_idx].nccl_comm;
+  ncclResult_t nccl_result = ncclSuccess;
+  switch (collective->type) {
+    case kAllReduce: {
+      const void* sendbuff = p->input->tensor_data().data();
+      void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
+
+      VLOG(2) << "call NcclAllReduce collective_key "
               << collective->collective_key << " participant " << p_idx
-              << " ncclResult " << nccl_result;
-      if (nccl_result == ncclSuccess) {
-        collective->participants[p_idx]->done_callback(Status::OK());
-      } else {
-        // Propagate the error, but note that if other members of the collective
-        // did launch their kernels, then they are hanging.
-        collective->participants[p_idx]->done_callback(errors::Unknown(
-            "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
-      }
-      collective->Unref();
-    };
-    p->event_mgr->ThenExecute(comm_stream, done_callback);
+              << " sendbuff " << sendbuff << " recvbuff " << recvbuff
+              << " nccl_comm " << nccl_comm << " cuda_stream " << cu_stream;
+      nccl_result = ncclAllReduce(sendbuff, recvbuff, p->input->NumElements(),
+                                  data_type, collective->reduction_op,
+                                  nccl_comm, *cu_stream);
+      break;
+    }
+    case kBroadcast: {
+      const Tensor* buf_t = p->input ? p->input : p->output;
+      void* buf = const_cast<char*>(buf_t->tensor_data().data());
+      nccl_result = ncclBcast(buf, buf_t->NumElements(), data_type,
+                              collective->root_rank, nccl_comm, *cu_stream);
+      break;
+    }
+    case kReduce: {
+      const void* sendbuff = p->input->tensor_data().data();
+      void* recvbuff =
+          p->output ? const_cast<char*>(p->output->tensor_data().data())
+                    : nullptr;
+      nccl_result = ncclReduce(sendbuff, recvbuff, p->input->NumElements(),
+                               data_type, collective->reduction_op,
+                               collective->root_rank, nccl_comm, *cu_stream);
+      break;
+    }
+    case kAllGather: {
+      const void* sendbuff = p->input->tensor_data().data();
+      void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
+
+      VLOG(2) << "call NcclAllGather collective_key "
+              << collective->collective_key << " participant " << p_idx
+              << " sendbuff " << sendbuff << " sendcount "
+              << p->input->NumElements() << " recvbuff " << recvbuff
+              << " recvcount " << p->output->NumElements() << " nccl_comm "
+              << nccl_comm << " cuda_stream " << cu_stream;
+      nccl_result = ncclAllGather(sendbuff, recvbuff, p->input->NumElements(),
+                                  data_type, nccl_comm, *cu_stream);
+      break;
+    }
   }
+  return nccl_result;
 }
 
 }  // namespace tensorflow
@@ -53,6 +53,13 @@ class NcclManager {
   // multi-node collective invocations.
   string GenerateCommunicatorKey();
 
+  // Creates the communicators that single-node collectives over the devices
+  // of `executors` will use, so that NCCL initialization is not on the
+  // critical path of the first such collective.  `gpu_device_ids` are the
+  // corresponding CUDA device ids.
+  Status WarmUpCommunicators(const std::vector<se::StreamExecutor*>& executors,
+                             const std::vector<int>& gpu_device_ids);
+
   // A participant in a Collective.
   struct Participant {
     Participant(se::StreamExecutor* executor, se::Stream* tensor_stream,
@@ -189,6 +196,24 @@ class NcclManager {
   // the corresponding NCCL/CUDA error string.
   Status GetCommunicator(Collective* collective, Communicator** communicator);
 
+  // Returns the communicator over `executors` for single-node collectives
+  // that use stream slot `slot`, creating it if needed.
+  Status GetSingleNodeCommunicator(
+      const std::vector<se::StreamExecutor*>& executors,
+      const std::vector<int>& gpu_device_ids, int slot,
+      Communicator** communicator) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Creates a communicator whose i-th local member has rank `ranks[i]`.  Each
+  // member gets the communication stream of its device at index `slot` or
+  // above that is not used by another member.
+  Status CreateCommunicator(const std::vector<se::StreamExecutor*>& executors,
+                            const std::vector<int>& gpu_device_ids,
+                            const std::vector<int>& ranks,
+                            int num_global_devices,
+                            const string& communicator_key, int slot,
+                            Communicator** communicator)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Adds a participant device to the local `Collective` instance corresponding
   // to `collective_key`.  Launches the `Collective` if it is ready, which it
   // checks by calling `CheckReady()`.  Also performs consistency and sanity
@@ -210,6 +235,14 @@ class NcclManager {
   // Run <collective>.  This calls takes ownership of <collective>.
   void RunCollective(Collective* collective);
   void LoopKernelLaunches(NcclStream* stream);
+  // Enqueues the kernel of participant `p_idx` of `collective` on
+  // `cu_stream`.
+  ncclResult_t LaunchKernel(Collective* collective, int p_idx,
+                            const cudaStream_t* cu_stream);
+
+  // Number of communication streams, and of single-node communicators over
+  // the same devices, that independent collectives are spread over.
+  const int num_streams_per_device_;
 
   mutex mu_;
 
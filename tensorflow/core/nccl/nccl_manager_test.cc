@@ -340,6 +340,44 @@ TYPED_TEST(NcclManagerTest, BasicSumReduction) {
   }
 }
 
+// Same as the Basic test, but with the communicators created up front.
+TYPED_TEST(NcclManagerTest, WarmUpCommunicators) {
+  const int num_ranks = 4;
+
+  std::vector<se::StreamExecutor*> executors;
+  std::vector<int> gpu_device_ids;
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = this->GetDevice(rank);
+    executors.push_back(device->executor());
+    gpu_device_ids.push_back(device->gpu_id());
+  }
+  TF_ASSERT_OK(
+      NcclManager::instance()->WarmUpCommunicators(executors, gpu_device_ids));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      NcclManager::instance()->WarmUpCommunicators(executors, {})));
+
+  std::unique_ptr<typename TestFixture::TestCase> test_case(
+      this->MakeReductionTestCase(/*num_nodes=*/1, num_ranks, ncclSum,
+                                  TensorShape({2, 3}), 0.0f));
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = this->GetDevice(rank);
+    auto* event_mgr = device->tensorflow_gpu_device_info()->event_mgr;
+    auto* stream = device->tensorflow_gpu_device_info()->stream;
+    auto participant = absl::make_unique<NcclManager::Participant>(
+        device->executor(), stream, event_mgr, device->gpu_id(),
+        &test_case->ins[rank], &test_case->outs[rank], /*global_rank=*/-1,
+        this->CreateDoneCallback(test_case.get()));
+    NcclManager::instance()->AddToAllReduce(
+        std::move(participant),
+        {"warmup_allreduce", /*num_local_devices=*/num_ranks,
+         /*num_global_devices=*/num_ranks, /*communicator_key=*/""},
+        ncclSum);
+  }
+
+  LOG(INFO) << "Verifying results";
+  this->VerifyResults(test_case.get());
+}
+
 // Same as the Basic test, but with multiple threads launching parts of many
 // reductions.
 //
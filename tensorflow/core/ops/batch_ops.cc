@@ -32,6 +32,8 @@ REGISTER_OP("BatchFunction")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
     .Attr("batching_queue: string = ''")
+    .Attr("bucket_boundaries: list(int) = []")
+    .Attr("bucket_dim: int = 1")
     .Attr("Tin: list(type)")
     .Attr("Tcaptured: list(type) >= 0")
     .Attr("Tout: list(type)")
@@ -30,6 +30,7 @@ REGISTER_OP("CollectiveReduce")
     .Attr("final_op: {'Id', 'Div'}")
     .Attr("subdiv_offsets: list(int)")
     .Attr("wait_for: list(int) = []")
+    .Attr("wire_codec: {'none', 'bf16'} = 'none'")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnchangedShape);
 
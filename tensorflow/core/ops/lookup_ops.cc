@@ -370,6 +370,7 @@ REGISTER_OP("MutableHashTableV2")
     .Attr("use_node_name_sharing: bool = false")
     .Attr("key_dtype: type")
     .Attr("value_dtype: type")
+    .Attr("num_shards: int >= 1 = 1")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) {
       return MutableHashTableShape(c, /*key=*/c->Scalar(),
@@ -971,6 +971,31 @@ REGISTER_OP("Max")
     .Attr("Tidx: {int32, int64} = DT_INT32")
     .SetShapeFn(shape_inference::ReductionShape);
 
+REGISTER_OP("_FusedReduce")
+    .Input("input: T")
+    .Input("reduction_indices: Tidx")
+    .Output("output: num_reductions * T")
+    .Attr("keep_dims: bool = false")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("num_reductions: int >= 1")
+    .Attr("reductions: list(string)")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::ReductionShape(c));
+      for (int i = 1; i < c->num_outputs(); ++i) {
+        c->set_output(i, c->output(0));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes several reductions of `input` over the same axes in a single pass.
+`reductions` has one of "Sum", "Mean", "Max", "Min", "SumOfSquares" and
+"MeanOfSquares" for each output.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 namespace {
 
 Status ArgOpShape(shape_inference::InferenceContext* c) {
@@ -246,6 +246,68 @@ REGISTER_OP("_FusedBatchNormEx")
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedLayerNorm")
+    .Input("x: T")
+    .Input("scale: T")
+    .Input("offset: T")
+    .Output("y: T")
+    .Attr("T: {half, float}")
+    .Attr("epsilon: float = 0.001")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &x));
+      DimensionHandle depth = c->Dim(x, -1);
+      for (int i = 1; i < 3; ++i) {
+        ShapeHandle vec;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &vec));
+        TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(vec, 0), &depth));
+      }
+      ShapeHandle y;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(x, -1, depth, &y));
+      c->set_output(0, y);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Normalizes `x` over its innermost dimension, then scales and offsets it:
+`y = (x - mean(x)) * rsqrt(variance(x) + epsilon) * scale + offset`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedScaledDotProductAttention")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Output("output: T")
+    .Attr("T: {half, float}")
+    .Attr("scale: float = 1.0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query;
+      ShapeHandle key;
+      ShapeHandle value;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 3, &query));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(1), 3, &key));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(2), 3, &value));
+
+      // Query and key must agree on depth, key and value on sequence length.
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(query, -1), c->Dim(key, -1), &unused));
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(key, -2), c->Dim(value, -2), &unused));
+
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(query, -1, c->Dim(value, -1), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes `softmax(query * key^T * scale) * value` over the innermost two
+dimensions. All leading dimensions are batch dimensions and must match.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("FusedBatchNormGrad")
     .Input("y_backprop: T")
     .Input("x: T")
@@ -416,4 +416,83 @@ REGISTER_OP("ConsumeMutexLock")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) { return Status::OK(); });
 
+REGISTER_OP("EmbeddingVariableHandleOp")
+    .Input("default_value: dtype")
+    .Output("resource: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("dtype: {float}")
+    .Attr("hot_capacity: int >= 1 = 1048576")
+    .Attr("cold_storage_dir: string = ''")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableExport")
+    .Input("resource: resource")
+    .Output("ids: int64")
+    .Output("values: dtype")
+    .Attr("dtype: {float}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->Vector(InferenceContext::kUnknownDim));
+      c->set_output(1, c->Matrix(InferenceContext::kUnknownDim,
+                                 InferenceContext::kUnknownDim));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableImport")
+    .Input("resource: resource")
+    .Input("ids: int64")
+    .Input("values: dtype")
+    .Attr("dtype: {float}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle ids;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &ids));
+      ShapeHandle values;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &values));
+      shape_inference::DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(ids, 0), c->Dim(values, 0), &unused_dim));
+      return Status::OK();
+    });
+
+REGISTER_OP("ResourceEmbeddingGather")
+    .Input("resource: resource")
+    .Input("indices: Tindices")
+    .Output("output: dtype")
+    .Attr("dtype: {float}")
+    .Attr("Tindices: {int32,int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->input(1), c->Vector(InferenceContext::kUnknownDim), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    });
+
+REGISTER_OP("ResourceEmbeddingSparseApplyAdagrad")
+    .Input("var: resource")
+    .Input("accum: resource")
+    .Input("lr: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {float}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      ShapeHandle grad;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 2, &grad));
+      ShapeHandle indices;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 1, &indices));
+      shape_inference::DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(grad, 0), c->Dim(indices, 0), &unused_dim));
+      return Status::OK();
+    });
+
 }  // namespace tensorflow
@@ -17,17 +17,23 @@ limitations under the License.
 #include <stdio.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <fstream>
+#include <memory>
 #include <vector>
 #ifdef _WIN32
 #include <io.h>  // for _mktemp
 #endif
 #include "absl/base/macros.h"
 #include "include/json/json.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -129,6 +135,15 @@ constexpr char kAllowedBucketLocations[] = "GCS_ALLOWED_BUCKET_LOCATIONS";
 // is running in and restricts to buckets in that region.
 constexpr char kDetectZoneSentinalValue[] = "auto";
 
+// The number of threads shared by the vectored reads of all GCS files.
+constexpr int kReadVThreads = 16;
+
+thread::ThreadPool* ReadVThreadPool() {
+  static thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "gcs_read_v", kReadVThreads);
+  return pool;
+}
+
 // TODO: DO NOT use a hardcoded path
 Status GetTmpFilename(string* filename) {
 #ifndef _WIN32
@@ -304,6 +319,43 @@ class GcsRandomAccessFile : public RandomAccessFile {
     return read_fn_(filename_, offset, n, result, scratch);
   }
 
+  /// Issues ranged reads in parallel on a pool shared by all GCS files.
+  /// Thread safe.
+  Status ReadV(std::vector<ReadRange>* ranges) const override {
+    if (ranges->size() <= 1) {
+      return RandomAccessFile::ReadV(ranges);
+    }
+    // The calling thread and the pool threads claim ranges by index. The
+    // calling thread reads too, so the reads make progress even when the
+    // pool is busy with the reads of other files.
+    std::atomic<size_t> next_range(0);
+    auto read_ranges = [this, ranges, &next_range]() {
+      for (size_t i = next_range++; i < ranges->size(); i = next_range++) {
+        ReadRange& range = (*ranges)[i];
+        range.status =
+            Read(range.offset, range.n, &range.result, range.scratch);
+      }
+    };
+    thread::ThreadPool* pool = ReadVThreadPool();
+    const int num_helpers =
+        std::min<int>(ranges->size() - 1, pool->NumThreads());
+    BlockingCounter pending(num_helpers);
+    for (int i = 0; i < num_helpers; ++i) {
+      pool->Schedule([&read_ranges, &pending]() {
+        read_ranges();
+        pending.DecrementCount();
+      });
+    }
+    read_ranges();
+    pending.Wait();
+
+    Status status;
+    for (const ReadRange& range : *ranges) {
+      status.Update(range.status);
+    }
+    return status;
+  }
+
  private:
   /// The filename of this file.
   const string filename_;
@@ -312,6 +364,11 @@ class GcsRandomAccessFile : public RandomAccessFile {
 };
 
 /// A GCS-based implementation of a random access file with a read buffer.
+///
+/// Once the buffer is refilled from where the previous fill ended, the file
+/// is assumed to be read sequentially and up to `read_ahead_blocks` further
+/// buffers are requested in parallel, each with its own ranged request. Any
+/// read elsewhere stops the read-ahead until the pattern is seen again.
 class BufferedGcsRandomAccessFile : public RandomAccessFile {
  public:
   using ReadFn =
@@ -320,11 +377,24 @@ class BufferedGcsRandomAccessFile : public RandomAccessFile {
 
   // Initialize the reader. Provided read_fn should be thread safe.
   BufferedGcsRandomAccessFile(const string& filename, uint64 buffer_size,
-                              ReadFn read_fn)
+                              size_t read_ahead_blocks, ReadFn read_fn)
       : filename_(filename),
         read_fn_(std::move(read_fn)),
         buffer_size_(buffer_size),
-        buffer_start_(0) {}
+        read_ahead_blocks_(read_ahead_blocks),
+        buffer_start_(0),
+        next_sequential_start_(0) {}
+
+  ~BufferedGcsRandomAccessFile() override {
+    // The reads still in flight use the members of this file.
+    mutex_lock l(buffer_mutex_);
+    for (const auto& block : read_ahead_) {
+      block->done.WaitForNotification();
+    }
+    for (const auto& block : abandoned_) {
+      block->done.WaitForNotification();
+    }
+  }
 
   Status Name(StringPiece* result) const override {
     *result = filename_;
@@ -372,17 +442,86 @@ class BufferedGcsRandomAccessFile : public RandomAccessFile {
   }
 
  private:
+  // A buffer's worth of the file read ahead on another thread.
+  struct Block {
+    uint64 start;
+    string data;
+    Status status;
+    Notification done;
+  };
+
   Status FillBuffer(uint64 start) const
       EXCLUSIVE_LOCKS_REQUIRED(buffer_mutex_) {
+    const bool sequential = read_ahead_blocks_ > 0 && start > 0 &&
+                            start == next_sequential_start_;
+    if (!sequential ||
+        (!read_ahead_.empty() && read_ahead_.front()->start != start)) {
+      AbandonReadAhead();
+    }
+
     buffer_start_ = start;
-    buffer_.resize(buffer_size_);
-    StringPiece str_piece;
-    Status status = read_fn_(filename_, buffer_start_, buffer_size_, &str_piece,
-                             &(buffer_[0]));
-    buffer_.resize(str_piece.size());
+    Status status;
+    if (!read_ahead_.empty()) {
+      std::shared_ptr<Block> block = std::move(read_ahead_.front());
+      read_ahead_.pop_front();
+      block->done.WaitForNotification();
+      buffer_.swap(block->data);
+      status = block->status;
+    } else {
+      buffer_.resize(buffer_size_);
+      StringPiece str_piece;
+      status = read_fn_(filename_, buffer_start_, buffer_size_, &str_piece,
+                        &(buffer_[0]));
+      buffer_.resize(str_piece.size());
+    }
+    next_sequential_start_ = buffer_start_ + buffer_.size();
+
+    if (!status.ok() || buffer_.size() < buffer_size_) {
+      // Stop at errors and at the end of the file.
+      AbandonReadAhead();
+    } else if (sequential) {
+      while (read_ahead_.size() < read_ahead_blocks_) {
+        const uint64 next_start =
+            read_ahead_.empty() ? next_sequential_start_
+                                : read_ahead_.back()->start + buffer_size_;
+        read_ahead_.push_back(StartRead(next_start));
+      }
+    }
     return status;
   }
 
+  // Starts reading a buffer's worth of the file at `start` on another thread.
+  std::shared_ptr<Block> StartRead(uint64 start) const {
+    auto block = std::make_shared<Block>();
+    block->start = start;
+    Env::Default()->SchedClosure([this, block]() {
+      block->data.resize(buffer_size_);
+      StringPiece str_piece;
+      block->status = read_fn_(filename_, block->start, buffer_size_,
+                               &str_piece, &(block->data[0]));
+      block->data.resize(str_piece.size());
+      block->done.Notify();
+    });
+    return block;
+  }
+
+  // Drops the blocks read ahead. The reads still in flight are remembered so
+  // that the destructor can wait for them.
+  void AbandonReadAhead() const EXCLUSIVE_LOCKS_REQUIRED(buffer_mutex_) {
+    abandoned_.erase(
+        std::remove_if(abandoned_.begin(), abandoned_.end(),
+                       [](const std::shared_ptr<Block>& block) {
+                         return block->done.HasBeenNotified();
+                       }),
+        abandoned_.end());
+    for (auto& block : read_ahead_) {
+      if (!block->done.HasBeenNotified()) {
+        abandoned_.push_back(std::move(block));
+      }
+    }
+    read_ahead_.clear();
+  }
+
   // The filename of this file.
   const string filename_;
 
@@ -392,6 +531,9 @@ class BufferedGcsRandomAccessFile : public RandomAccessFile {
   // Size of buffer that we read from GCS each time we send a request.
   const uint64 buffer_size_;
 
+  // Maximum number of buffers read ahead of a sequential reader.
+  const size_t read_ahead_blocks_;
+
   // Mutex for buffering operations that can be accessed from multiple threads.
   // The following members are mutable in order to provide a const Read.
   mutable mutex buffer_mutex_;
@@ -400,6 +542,17 @@ class BufferedGcsRandomAccessFile : public RandomAccessFile {
   mutable uint64 buffer_start_ GUARDED_BY(buffer_mutex_);
 
   mutable string buffer_ GUARDED_BY(buffer_mutex_);
+
+  // Offset just past the data of the last fill of the buffer.
+  mutable uint64 next_sequential_start_ GUARDED_BY(buffer_mutex_);
+
+  // The buffers read ahead, in file order, starting at next_sequential_start_.
+  mutable std::deque<std::shared_ptr<Block>> read_ahead_
+      GUARDED_BY(buffer_mutex_);
+
+  // Read-ahead that was not needed after all but may still be in flight.
+  mutable std::vector<std::shared_ptr<Block>> abandoned_
+      GUARDED_BY(buffer_mutex_);
 };
 
 /// \brief GCS-based implementation of a writeable file.
@@ -745,12 +898,17 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+
+  if (GetEnvVar(kReadAheadBlocks, strings::safe_strtou64, &value)) {
+    read_ahead_blocks_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "read-ahead blocks = " << read_ahead_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -873,11 +1031,13 @@ GcsFileSystem::GcsFileSystem(
     size_t stat_cache_max_entries, uint64 matching_paths_cache_max_age,
     size_t matching_paths_cache_max_entries, RetryConfig retry_config,
     TimeoutConfig timeouts, const std::unordered_set<string>& allowed_locations,
-    std::pair<const string, const string>* additional_header)
+    std::pair<const string, const string>* additional_header,
+    size_t read_ahead_blocks)
     : auth_provider_(std::move(auth_provider)),
       http_request_factory_(std::move(http_request_factory)),
       zone_provider_(std::move(zone_provider)),
       block_size_(block_size),
+      read_ahead_blocks_(read_ahead_blocks),
       file_block_cache_(
           MakeFileBlockCache(block_size, max_bytes, max_staleness)),
       stat_cache_(new StatCache(stat_cache_max_age, stat_cache_max_entries)),
@@ -933,7 +1093,7 @@ Status GcsFileSystem::NewRandomAccessFile(
     }));
   } else {
     result->reset(new BufferedGcsRandomAccessFile(
-        fname, block_size_,
+        fname, block_size_, read_ahead_blocks_,
         [this, bucket, object](const string& fname, uint64 offset, size_t n,
                                StringPiece* result, char* scratch) {
           *result = StringPiece();
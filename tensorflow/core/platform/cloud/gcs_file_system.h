@@ -50,6 +50,11 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that sets how many blocks are read ahead, in
+// parallel, once a file without a block cache is read sequentially. 0 (the
+// default) disables read-ahead.
+constexpr char kReadAheadBlocks[] = "GCS_READ_AHEAD_BLOCKS";
+constexpr size_t kDefaultReadAheadBlocks = 0;
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -122,7 +127,8 @@ class GcsFileSystem : public FileSystem {
                 size_t matching_paths_cache_max_entries,
                 RetryConfig retry_config, TimeoutConfig timeouts,
                 const std::unordered_set<string>& allowed_locations,
-                std::pair<const string, const string>* additional_header);
+                std::pair<const string, const string>* additional_header,
+                size_t read_ahead_blocks = kDefaultReadAheadBlocks);
 
   Status NewRandomAccessFile(
       const string& fname, std::unique_ptr<RandomAccessFile>* result) override;
@@ -180,6 +186,7 @@ class GcsFileSystem : public FileSystem {
     tf_shared_lock l(block_cache_lock_);
     return file_block_cache_->max_staleness();
   }
+  size_t read_ahead_blocks() const { return read_ahead_blocks_; }
   TimeoutConfig timeouts() const { return timeouts_; }
   std::unordered_set<string> allowed_locations() const {
     return allowed_locations_;
@@ -338,6 +345,9 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // Number of blocks read ahead by files without a block cache.
+  size_t read_ahead_blocks_ = kDefaultReadAheadBlocks;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/platform/cloud/gcs_file_system.h"
+#include <algorithm>
 #include <fstream>
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -51,6 +52,74 @@ class FakeZoneProvider : public ZoneProvider {
   }
 };
 
+// Serves ranged reads of a fixed object in whatever order they are made, and
+// records where each of them starts.
+class FakeRangeReadHttpRequestFactory : public HttpRequest::Factory {
+ public:
+  explicit FakeRangeReadHttpRequestFactory(const string& content)
+      : content_(content) {}
+
+  HttpRequest* Create() override { return new Request(this); }
+
+  // Returns the starts of the ranges read so far, in increasing order.
+  std::vector<uint64> range_starts() {
+    mutex_lock l(mu_);
+    std::vector<uint64> starts = range_starts_;
+    std::sort(starts.begin(), starts.end());
+    return starts;
+  }
+
+ private:
+  class Request : public CurlHttpRequest {
+   public:
+    explicit Request(FakeRangeReadHttpRequestFactory* factory)
+        : factory_(factory) {}
+
+    void SetUri(const string& uri) override {}
+    void SetRange(uint64 start, uint64 end) override {
+      start_ = start;
+      end_ = end;
+    }
+    void AddAuthBearerHeader(const string& auth_token) override {}
+    void SetTimeouts(uint32 connection, uint32 inactivity,
+                     uint32 total) override {}
+    void SetResultBufferDirect(char* buffer, size_t size) override {
+      buffer_ = buffer;
+      size_ = size;
+    }
+    size_t GetResultBufferDirectBytesTransferred() override {
+      return bytes_transferred_;
+    }
+    string EscapeString(const string& str) override { return str; }
+
+    Status Send() override {
+      {
+        mutex_lock l(factory_->mu_);
+        factory_->range_starts_.push_back(start_);
+      }
+      const string& content = factory_->content_;
+      if (start_ < content.size()) {
+        bytes_transferred_ = std::min<size_t>(
+            {size_, end_ + 1 - start_, content.size() - start_});
+        memcpy(buffer_, content.data() + start_, bytes_transferred_);
+      }
+      return Status::OK();
+    }
+
+   private:
+    FakeRangeReadHttpRequestFactory* const factory_;
+    uint64 start_ = 0;
+    uint64 end_ = 0;
+    char* buffer_ = nullptr;
+    size_t size_ = 0;
+    size_t bytes_transferred_ = 0;
+  };
+
+  const string content_;
+  mutex mu_;
+  std::vector<uint64> range_starts_ GUARDED_BY(mu_);
+};
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_NoBlockCache) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
@@ -355,6 +424,96 @@ TEST(GcsFileSystemTest,
   TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/random_access.txt", &file));
 }
 
+// Returns a file system without a block cache that reads 10-byte buffers and
+// keeps 2 of them in flight ahead of sequential readers.
+std::unique_ptr<GcsFileSystem> CreateReadAheadFileSystem(
+    FakeRangeReadHttpRequestFactory* factory) {
+  return std::unique_ptr<GcsFileSystem>(new GcsFileSystem(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(factory),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 10 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, 2 /* read ahead blocks */));
+}
+
+string ReadAheadTestContent() {
+  string content;
+  for (int i = 0; i < 95; ++i) content += static_cast<char>('a' + i % 26);
+  return content;
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_ReadAhead) {
+  const string content = ReadAheadTestContent();
+  auto* factory = new FakeRangeReadHttpRequestFactory(content);
+  std::unique_ptr<GcsFileSystem> fs = CreateReadAheadFileSystem(factory);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(fs->NewRandomAccessFile("gs://bucket/read_ahead.txt", &file));
+  char scratch[10];
+  StringPiece result;
+  TF_ASSERT_OK(file->Read(0, sizeof(scratch), &result, scratch));
+  EXPECT_EQ(content.substr(0, 10), result);
+  // The first read is not known to be sequential.
+  EXPECT_EQ(std::vector<uint64>({0}), factory->range_starts());
+
+  // Reading on from the end of the buffer starts reading the next two
+  // buffers ahead.
+  TF_ASSERT_OK(file->Read(10, sizeof(scratch), &result, scratch));
+  EXPECT_EQ(content.substr(10, 10), result);
+
+  // The rest of the file is read through, with every range requested once.
+  string rest;
+  uint64 offset = 20;
+  Status status;
+  while (status.ok()) {
+    status = file->Read(offset, sizeof(scratch), &result, scratch);
+    rest.append(result.data(), result.size());
+    offset += result.size();
+  }
+  EXPECT_EQ(error::OUT_OF_RANGE, status.code());
+  EXPECT_EQ(content.substr(20), rest);
+
+  // Destroying the file waits for the reads still in flight.
+  file.reset();
+  // Read-ahead stops at the short read of the last buffer, but one read past
+  // the end of the file was already in flight.
+  EXPECT_EQ(std::vector<uint64>({0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100}),
+            factory->range_starts());
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_ReadAheadAfterSeek) {
+  const string content = ReadAheadTestContent();
+  auto* factory = new FakeRangeReadHttpRequestFactory(content);
+  std::unique_ptr<GcsFileSystem> fs = CreateReadAheadFileSystem(factory);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(fs->NewRandomAccessFile("gs://bucket/read_ahead.txt", &file));
+  char scratch[10];
+  StringPiece result;
+  TF_ASSERT_OK(file->Read(0, sizeof(scratch), &result, scratch));
+  TF_ASSERT_OK(file->Read(10, sizeof(scratch), &result, scratch));
+
+  // A seek drops the buffers read ahead, and reads from the new offset.
+  TF_ASSERT_OK(file->Read(55, sizeof(scratch), &result, scratch));
+  EXPECT_EQ(content.substr(55, 10), result);
+  // Reading on from there reads ahead again, from the new position.
+  TF_ASSERT_OK(file->Read(65, sizeof(scratch), &result, scratch));
+  EXPECT_EQ(content.substr(65, 10), result);
+  TF_ASSERT_OK(file->Read(75, sizeof(scratch), &result, scratch));
+  EXPECT_EQ(content.substr(75, 10), result);
+
+  // A seek back reads the data again instead of using stale buffers.
+  TF_ASSERT_OK(file->Read(20, sizeof(scratch), &result, scratch));
+  EXPECT_EQ(content.substr(20, 10), result);
+
+  file.reset();
+  EXPECT_EQ(std::vector<uint64>({0, 10, 20, 20, 30, 55, 65, 75, 85, 95}),
+            factory->range_starts());
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_WithLocationConstraintCaching) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
@@ -3398,6 +3557,7 @@ TEST(GcsFileSystemTest, OverrideCacheParameters) {
   EXPECT_EQ(16 * 1024 * 1024, fs1.block_size());
   EXPECT_EQ(128 * 1024 * 1024, fs1.max_bytes());
   EXPECT_EQ(0, fs1.max_staleness());
+  EXPECT_EQ(0, fs1.read_ahead_blocks());
   EXPECT_EQ(120, fs1.timeouts().connect);
   EXPECT_EQ(60, fs1.timeouts().idle);
   EXPECT_EQ(3600, fs1.timeouts().metadata);
@@ -3414,10 +3574,12 @@ TEST(GcsFileSystemTest, OverrideCacheParameters) {
   setenv("GCS_READ_CACHE_BLOCK_SIZE_MB", "1", 1);
   setenv("GCS_READ_CACHE_MAX_SIZE_MB", "16", 1);
   setenv("GCS_READ_CACHE_MAX_STALENESS", "60", 1);
+  setenv("GCS_READ_AHEAD_BLOCKS", "4", 1);
   GcsFileSystem fs3;
   EXPECT_EQ(1048576L, fs3.block_size());
   EXPECT_EQ(16 * 1024 * 1024, fs3.max_bytes());
   EXPECT_EQ(60, fs3.max_staleness());
+  EXPECT_EQ(4, fs3.read_ahead_blocks());
 
   // Verify StatCache and MatchingPathsCache overrides.
   setenv("GCS_STAT_CACHE_MAX_AGE", "60", 1);
@@ -163,6 +163,23 @@ class RetryingRandomAccessFile : public RandomAccessFile {
         retry_config_);
   }
 
+  Status ReadV(std::vector<ReadRange>* ranges) const override {
+    // Let the base file read all ranges at once, then retry the ranges that
+    // failed one at a time.
+    if (base_file_->ReadV(ranges).ok()) {
+      return Status::OK();
+    }
+    Status status;
+    for (ReadRange& range : *ranges) {
+      if (!range.status.ok() && range.status.code() != error::OUT_OF_RANGE) {
+        range.status =
+            Read(range.offset, range.n, &range.result, range.scratch);
+      }
+      status.Update(range.status);
+    }
+    return status;
+  }
+
  private:
   std::unique_ptr<RandomAccessFile> base_file_;
   const RetryConfig retry_config_;
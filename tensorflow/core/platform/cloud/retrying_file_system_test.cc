@@ -294,6 +294,43 @@ TEST(RetryingFileSystemTest, NewRandomAccessFile_NoRetriesForSomeErrors) {
             random_access_file->Read(0, 10, &result, scratch).error_message());
 }
 
+TEST(RetryingFileSystemTest, NewRandomAccessFile_ReadVRetriesFailedRanges) {
+  // Configure the mock base random access file. Its default ReadV() reads
+  // the ranges in turn, then only the failed second range is read again.
+  ExpectedCalls expected_file_calls(
+      {std::make_tuple("Read", Status::OK()),
+       std::make_tuple("Read", errors::Unavailable("Something is wrong")),
+       std::make_tuple("Read", Status::OK())});
+  std::unique_ptr<RandomAccessFile> base_file(
+      new MockRandomAccessFile(expected_file_calls));
+
+  // Configure the mock base file system.
+  ExpectedCalls expected_fs_calls(
+      {std::make_tuple("NewRandomAccessFile", Status::OK())});
+  std::unique_ptr<MockFileSystem> base_fs(
+      new MockFileSystem(expected_fs_calls));
+  base_fs->random_access_file_to_return = std::move(base_file);
+  RetryingFileSystem<MockFileSystem> fs(
+      std::move(base_fs), RetryConfig(0 /* init_delay_time_us */));
+
+  // Retrieve the wrapped random access file.
+  std::unique_ptr<RandomAccessFile> random_access_file;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("filename.txt", &random_access_file));
+
+  // Use it and check the results.
+  char scratch[20];
+  std::vector<RandomAccessFile::ReadRange> ranges(2);
+  ranges[0].offset = 0;
+  ranges[0].n = 10;
+  ranges[0].scratch = scratch;
+  ranges[1].offset = 10;
+  ranges[1].n = 10;
+  ranges[1].scratch = scratch + 10;
+  TF_EXPECT_OK(random_access_file->ReadV(&ranges));
+  TF_EXPECT_OK(ranges[0].status);
+  TF_EXPECT_OK(ranges[1].status);
+}
+
 TEST(RetryingFileSystemTest, NewWritableFile_ImmediateSuccess) {
   // Configure the mock base random access file.
   ExpectedCalls expected_file_calls({std::make_tuple("Name", Status::OK()),
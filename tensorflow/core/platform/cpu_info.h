@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_PLATFORM_CPU_INFO_H_
 
 #include <string>
+#include <vector>
 
 // TODO(ahentz): This is not strictly required here but, for historical
 // reasons, many people depend on cpu_info.h in order to use kLittleEndian.
@@ -63,6 +64,11 @@ int NumTotalCPUs();
 // identified.  If successful, the return value will be in [0, NumTotalCPUs()).
 int GetCurrentCPU();
 
+// Restricts the current thread to run on the CPUs with the given ids, which
+// are in [0, NumTotalCPUs()).  Returns false if this is not supported on the
+// platform or fails, e.g. because none of the CPUs is available to the process.
+bool SetCurrentThreadCpuAffinity(const std::vector<int>& cpus);
+
 // Returns an estimate of the number of hyperthreads per physical core
 // on the CPU
 int NumHyperthreadsPerCore();
@@ -121,6 +127,7 @@ enum CPUFeature {
   AVX512IFMA = 35,     // Integer multiply-add
   AVX512_4VNNIW = 36,  // Integer neural network
   AVX512_4FMAPS = 37,  // Floating point neural network
+  AVX512_VNNI = 38,    // Integer neural network (Cascade Lake)
 };
 
 // Checks whether the current processor supports one of the features above.
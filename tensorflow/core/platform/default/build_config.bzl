@@ -613,6 +613,7 @@ def tf_additional_device_tracer_test_flags():
 def tf_additional_profiler_lib_deps():
     return [
         "//tensorflow/core/profiler/internal/cpu:host_tracer",
+        "//tensorflow/core/profiler/internal/cpu:sampling_profiler",
     ] + if_cuda([
         "//tensorflow/core/profiler/internal/gpu:device_tracer",
     ])
@@ -752,6 +753,12 @@ def tf_additional_gdr_lib_defines():
         "//conditions:default": [],
     })
 
+def tf_additional_ucx_lib_defines():
+    return select({
+        "//tensorflow:with_ucx_support": ["TENSORFLOW_USE_UCX"],
+        "//conditions:default": [],
+    })
+
 def tf_additional_numa_lib_defines():
     return select({
         "//tensorflow:with_numa_support": ["TENSORFLOW_USE_NUMA"],
@@ -813,3 +820,17 @@ def tf_additional_numa_copts():
             "-DTENSORFLOW_USE_NUMA",
         ],
     })
+
+# zstd is linked from the system when building with
+# --define=with_zstd_support=true.
+def tf_additional_zstd_copts():
+    return select({
+        "//tensorflow:with_zstd_support": ["-DTF_USE_ZSTD"],
+        "//conditions:default": [],
+    })
+
+def tf_additional_zstd_linkopts():
+    return select({
+        "//tensorflow:with_zstd_support": ["-lzstd"],
+        "//conditions:default": [],
+    })
@@ -65,6 +65,14 @@ def tf_additional_gdr_deps():
         "//conditions:default": [],
     })
 
+def tf_additional_ucx_deps():
+    return select({
+        str(Label("//tensorflow:with_ucx_support")): [
+            str(Label("//tensorflow/contrib/gdr:ucx_server_lib")),
+        ],
+        "//conditions:default": [],
+    })
+
 # Include specific extra dependencies when building statically, or
 # another set of dependencies otherwise. If "macos" is provided, that
 # dependency list is used when using the framework_shared_object config
@@ -17,7 +17,11 @@ limitations under the License.
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <unordered_set>
+#include <vector>
 
 #include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
@@ -167,6 +171,18 @@ class CudaEventRecorder {
   std::vector<MemcpyRecord> memcpy_records_ GUARDED_BY(mutex_);
 };
 
+// Driver API calls that launch the kernels and copies being traced.
+constexpr CUpti_CallbackId kTracedDriverCallbacks[] = {
+    CUPTI_DRIVER_TRACE_CBID_cuLaunchKernel,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpy,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpyAsync,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoD_v2,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoDAsync_v2,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoH_v2,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoHAsync_v2,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoD_v2,
+    CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoDAsync_v2};
+
 // Instances register callbacks with CUPTI to notify the event recorder before
 // and after kernel launches and memory copies.
 class CuptiCallbackHook {
@@ -176,15 +192,7 @@ class CuptiCallbackHook {
   Status Enable(CudaEventRecorder* recorder) {
     TF_RETURN_IF_ERROR(
         ToStatus(cuptiSubscribe(&subscriber_, &CuptiCallback, recorder)));
-    for (auto cbid : {CUPTI_DRIVER_TRACE_CBID_cuLaunchKernel,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpy,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpyAsync,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoD_v2,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoDAsync_v2,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoH_v2,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoHAsync_v2,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoD_v2,
-                      CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoDAsync_v2}) {
+    for (auto cbid : kTracedDriverCallbacks) {
       TF_RETURN_IF_ERROR(ToStatus(cuptiEnableCallback(
           /*enable=*/1, subscriber_, CUPTI_CB_DOMAIN_DRIVER_API, cbid)));
     }
@@ -318,6 +326,210 @@ class CuptiCallbackHook {
   CUpti_SubscriberHandle subscriber_;
 };
 
+// Kernel and memcpy activity reported by CUPTI's activity API, timed on the
+// device. Unlike KernelRecord and MemcpyRecord, recording these does not
+// insert any events into the traced streams.
+struct KernelActivity {
+  std::string kernel_name;
+  uint32 device_id;
+  uint32 context_id;
+  uint32 stream_id;
+  uint64 start_ns;
+  uint64 end_ns;
+  const std::string* annotation;
+};
+
+struct MemcpyActivity {
+  uint8 copy_kind;
+  uint64 size_bytes;
+  uint32 device_id;
+  uint32 context_id;
+  uint32 stream_id;
+  uint64 start_ns;
+  uint64 end_ns;
+  const std::string* annotation;
+};
+
+// Stores the activity records delivered by CUPTI, and the annotation that was
+// active when each traced driver API call was made.
+class CuptiActivityRecorder {
+ public:
+  // Remembers the current annotation of the calling thread for the API call
+  // with `correlation_id`, which is also stamped on the activity it creates.
+  void AddCorrelation(uint32 correlation_id) {
+    if (!tls_current_annotation) {
+      return;
+    }
+    mutex_lock lock(mutex_);
+    correlations_[correlation_id] =
+        &*annotations_.emplace(tls_current_annotation).first;
+  }
+
+  void AddActivity(const CUpti_Activity& record) {
+    mutex_lock lock(mutex_);
+    switch (record.kind) {
+      case CUPTI_ACTIVITY_KIND_KERNEL:
+      case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL: {
+        auto kernel = reinterpret_cast<const CUpti_ActivityKernel4*>(&record);
+        kernel_activities_.push_back(
+            {kernel->name ? kernel->name : "<unknown>", kernel->deviceId,
+             kernel->contextId, kernel->streamId, kernel->start, kernel->end,
+             GetAnnotation(kernel->correlationId)});
+        break;
+      }
+      case CUPTI_ACTIVITY_KIND_MEMCPY: {
+        auto memcpy = reinterpret_cast<const CUpti_ActivityMemcpy*>(&record);
+        memcpy_activities_.push_back(
+            {memcpy->copyKind, memcpy->bytes, memcpy->deviceId,
+             memcpy->contextId, memcpy->streamId, memcpy->start, memcpy->end,
+             GetAnnotation(memcpy->correlationId)});
+        break;
+      }
+      default:
+        VLOG(2) << "Ignoring CUPTI activity of kind " << record.kind;
+    }
+  }
+
+  // Anchors CUPTI timestamps to the wall clock.
+  void SetTimeBase(uint64 timestamp_ns, uint64 walltime_us) {
+    mutex_lock lock(mutex_);
+    base_timestamp_ns_ = timestamp_ns;
+    base_walltime_us_ = walltime_us;
+  }
+  // Returns the wall time in microseconds of a CUPTI timestamp.
+  int64 ToWalltimeUs(uint64 timestamp_ns) {
+    mutex_lock lock(mutex_);
+    return base_walltime_us_ +
+           (static_cast<int64>(timestamp_ns) -
+            static_cast<int64>(base_timestamp_ns_)) /
+               1000;
+  }
+
+  std::vector<KernelActivity> ConsumeKernelActivities() {
+    mutex_lock lock(mutex_);
+    correlations_.clear();
+    return std::move(kernel_activities_);
+  }
+  std::vector<MemcpyActivity> ConsumeMemcpyActivities() {
+    mutex_lock lock(mutex_);
+    return std::move(memcpy_activities_);
+  }
+
+ private:
+  const std::string* GetAnnotation(uint32 correlation_id)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto it = correlations_.find(correlation_id);
+    return it == correlations_.end() ? nullptr : it->second;
+  }
+
+  mutex mutex_;
+  std::unordered_set<std::string> annotations_ GUARDED_BY(mutex_);
+  absl::flat_hash_map<uint32, const std::string*> correlations_
+      GUARDED_BY(mutex_);
+  std::vector<KernelActivity> kernel_activities_ GUARDED_BY(mutex_);
+  std::vector<MemcpyActivity> memcpy_activities_ GUARDED_BY(mutex_);
+  uint64 base_timestamp_ns_ GUARDED_BY(mutex_) = 0;
+  int64 base_walltime_us_ GUARDED_BY(mutex_) = 0;
+};
+
+// Instances enable CUPTI's activity API, which has the driver time kernels
+// and copies on the device and hand the records over in buffers, and
+// subscribe to the traced driver API calls only to map each call to its
+// annotation. This adds far less overhead to a step than CuptiCallbackHook,
+// which records two CUevents around every launch.
+class CuptiActivityHook {
+ public:
+  CuptiActivityHook() : subscriber_(nullptr), activity_enabled_(false) {}
+
+  Status Enable(CuptiActivityRecorder* recorder) {
+    TF_RETURN_IF_ERROR(
+        ToStatus(cuptiSubscribe(&subscriber_, &CuptiCallback, recorder)));
+    for (auto cbid : kTracedDriverCallbacks) {
+      TF_RETURN_IF_ERROR(ToStatus(cuptiEnableCallback(
+          /*enable=*/1, subscriber_, CUPTI_CB_DOMAIN_DRIVER_API, cbid)));
+    }
+
+    uint64_t timestamp_ns;
+    TF_RETURN_IF_ERROR(ToStatus(cuptiGetTimestamp(&timestamp_ns)));
+    recorder->SetTimeBase(timestamp_ns, Env::Default()->NowMicros());
+
+    active_recorder_ = recorder;
+    TF_RETURN_IF_ERROR(ToStatus(
+        cuptiActivityRegisterCallbacks(&BufferRequested, &BufferCompleted)));
+    for (auto kind : kActivityKinds) {
+      TF_RETURN_IF_ERROR(ToStatus(cuptiActivityEnable(kind)));
+    }
+    activity_enabled_ = true;
+    return Status::OK();
+  }
+
+  ~CuptiActivityHook() {
+    if (activity_enabled_) {
+      for (auto kind : kActivityKinds) {
+        LogIfError(ToStatus(cuptiActivityDisable(kind)));
+      }
+      // Deliver the records still sitting in partially filled buffers.
+      LogIfError(ToStatus(cuptiActivityFlushAll(/*flag=*/0)));
+      active_recorder_ = nullptr;
+    }
+    LogIfError(ToStatus(cuptiUnsubscribe(subscriber_)));
+  }
+
+ private:
+  static constexpr CUpti_ActivityKind kActivityKinds[] = {
+      CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL, CUPTI_ACTIVITY_KIND_MEMCPY};
+  static constexpr size_t kBufferSize = 8 << 20;
+  static constexpr size_t kBufferAlignment = 8;
+
+  static void CUPTIAPI CuptiCallback(void* userdata,
+                                     CUpti_CallbackDomain domain,
+                                     CUpti_CallbackId cbid,
+                                     const void* cbdata) {
+    auto recorder = static_cast<CuptiActivityRecorder*>(userdata);
+    auto data = static_cast<const CUpti_CallbackData*>(cbdata);
+    DCHECK_EQ(domain, CUPTI_CB_DOMAIN_DRIVER_API);
+    if (data->callbackSite == CUPTI_API_ENTER) {
+      recorder->AddCorrelation(data->correlationId);
+    }
+  }
+
+  static void CUPTIAPI BufferRequested(uint8_t** buffer, size_t* size,
+                                       size_t* max_num_records) {
+    *buffer = static_cast<uint8_t*>(
+        port::AlignedMalloc(kBufferSize, kBufferAlignment));
+    *size = *buffer ? kBufferSize : 0;
+    *max_num_records = 0;  // As many records as fit into the buffer.
+  }
+
+  static void CUPTIAPI BufferCompleted(CUcontext context, uint32_t stream_id,
+                                       uint8_t* buffer, size_t size,
+                                       size_t valid_size) {
+    CuptiActivityRecorder* recorder = active_recorder_;
+    CUpti_Activity* record = nullptr;
+    while (recorder && cuptiActivityGetNextRecord(buffer, valid_size,
+                                                  &record) == CUPTI_SUCCESS) {
+      recorder->AddActivity(*record);
+    }
+    size_t num_dropped = 0;
+    if (cuptiActivityGetNumDroppedRecords(context, stream_id, &num_dropped) ==
+            CUPTI_SUCCESS &&
+        num_dropped > 0) {
+      LOG(WARNING) << "CUPTI dropped " << num_dropped << " activity records.";
+    }
+    port::AlignedFree(buffer);
+  }
+
+  // The buffer callbacks take no user data. Only one hook can be enabled at a
+  // time, because CUPTI allows a single subscriber.
+  static std::atomic<CuptiActivityRecorder*> active_recorder_;
+
+  CUpti_SubscriberHandle subscriber_;
+  bool activity_enabled_;
+};
+
+constexpr CUpti_ActivityKind CuptiActivityHook::kActivityKinds[];
+std::atomic<CuptiActivityRecorder*> CuptiActivityHook::active_recorder_;
+
 class TraceCollectorImpl : public tracing::TraceCollector {
  public:
   TraceCollectorImpl() : active_trace_session_(false) {
@@ -370,9 +582,15 @@ TraceCollectorImpl* GlobalDefaultTraceCollector() {
 
 // 'DeviceTracer' is an interface for collecting low-level execution timings
 // of hardware accelerator (e.g. GPU) computation and DMA transfers.
+//
+// By default kernels and copies are timed with CUevents recorded around each
+// launch. With TF_GPU_TRACER_USE_ACTIVITY_API=true, CUPTI's activity API is
+// used instead, which is cheap enough to leave profiling on in production.
+// TF_GPU_TRACER_SAMPLE_PERIOD=N only traces one in N sessions (e.g. steps
+// traced through RunOptions); the others run untraced.
 class DeviceTracer : public profiler::ProfilerInterface {
  public:
-  DeviceTracer();
+  DeviceTracer(bool use_activity_api, int64 sample_period);
   ~DeviceTracer() override;
 
   // ProfilerInterface interface:
@@ -384,15 +602,27 @@ class DeviceTracer : public profiler::ProfilerInterface {
   Status CollectData(RunMetadata* run_metadata) override;
 
  private:
+  const bool use_activity_api_;
+  const int64 sample_period_;
+
   std::unique_ptr<CudaEventRecorder> recorder_;
   std::unique_ptr<CuptiCallbackHook> cupti_hook_;
+  std::unique_ptr<CuptiActivityRecorder> activity_recorder_;
+  std::unique_ptr<CuptiActivityHook> activity_hook_;
 
   mutex mu_;
   bool enabled_ GUARDED_BY(mu_);
+  // Whether the current or last session was sampled for tracing.
+  bool sampled_ GUARDED_BY(mu_);
 };
 
-DeviceTracer::DeviceTracer()
-    : recorder_(new CudaEventRecorder()), enabled_(false) {
+DeviceTracer::DeviceTracer(bool use_activity_api, int64 sample_period)
+    : use_activity_api_(use_activity_api),
+      sample_period_(sample_period),
+      recorder_(new CudaEventRecorder()),
+      activity_recorder_(new CuptiActivityRecorder()),
+      enabled_(false),
+      sampled_(false) {
   VLOG(1) << "DeviceTracer created.";
 }
 
@@ -408,8 +638,22 @@ Status DeviceTracer::Start() {
   if (enabled_) {
     return errors::FailedPrecondition("DeviceTracer is already enabled.");
   }
-  cupti_hook_.reset(new CuptiCallbackHook());
-  TF_RETURN_IF_ERROR(cupti_hook_->Enable(recorder_.get()));
+  // Shared by all tracers, because a new one is created for every session.
+  static std::atomic<int64> num_sessions(0);
+  sampled_ = num_sessions.fetch_add(1) % sample_period_ == 0;
+  if (!sampled_) {
+    VLOG(1) << "DeviceTracer skips an unsampled session.";
+    enabled_ = true;
+    return Status::OK();
+  }
+
+  if (use_activity_api_) {
+    activity_hook_.reset(new CuptiActivityHook());
+    TF_RETURN_IF_ERROR(activity_hook_->Enable(activity_recorder_.get()));
+  } else {
+    cupti_hook_.reset(new CuptiCallbackHook());
+    TF_RETURN_IF_ERROR(cupti_hook_->Enable(recorder_.get()));
+  }
 
   // Register as a TraceEngine to receive ScopedAnnotations.
   GlobalDefaultTraceCollector()->Start();
@@ -424,8 +668,11 @@ Status DeviceTracer::Stop() {
   if (!enabled_) {
     return Status::OK();
   }
-  cupti_hook_.reset();
-  GlobalDefaultTraceCollector()->Stop();
+  if (sampled_) {
+    cupti_hook_.reset();
+    activity_hook_.reset();
+    GlobalDefaultTraceCollector()->Stop();
+  }
 
   enabled_ = false;
   return Status::OK();
@@ -691,15 +938,126 @@ class CudaEventCollector {
   int64 end_walltime_us_;
 };
 
+// Saves the records of a CuptiActivityRecorder to a StepStatsCollector.
+class CuptiActivityCollector {
+ public:
+  // Consumes the records in recorder and saves them to the collector.
+  static Status Collect(CuptiActivityRecorder* recorder,
+                        StepStatsCollector* collector) {
+    auto kernel_activities = recorder->ConsumeKernelActivities();
+    auto memcpy_activities = recorder->ConsumeMemcpyActivities();
+    LOG(INFO) << "Collecting " << kernel_activities.size()
+              << " kernel activities, " << memcpy_activities.size()
+              << " memcpy activities.";
+
+    CuptiActivityCollector activity_collector(recorder, collector);
+    for (const auto& activity : kernel_activities) {
+      std::string node_name = activity.kernel_name;
+      // Sometimes CUPTI returns invalid characters. See b/129892466.
+      if (!IsAscii(node_name)) {
+        node_name = "<invalid_name>";
+      }
+      TF_RETURN_IF_ERROR(activity_collector.SaveActivity(
+          node_name, /*node_label=*/"", activity.device_id,
+          activity.context_id, activity.stream_id, activity.start_ns,
+          activity.end_ns, activity.annotation));
+    }
+    for (const auto& activity : memcpy_activities) {
+      TF_RETURN_IF_ERROR(activity_collector.SaveActivity(
+          GetMemcpyName(activity.copy_kind),
+          absl::StrFormat("%d bytes", activity.size_bytes), activity.device_id,
+          activity.context_id, activity.stream_id, activity.start_ns,
+          activity.end_ns, activity.annotation));
+    }
+    return Status::OK();
+  }
+
+ private:
+  CuptiActivityCollector(CuptiActivityRecorder* recorder,
+                         StepStatsCollector* collector)
+      : recorder_(recorder), collector_(collector) {}
+
+  // Returns a name in the format used by CudaEventCollector.
+  static std::string GetMemcpyName(uint8 copy_kind) {
+    switch (copy_kind) {
+      case CUPTI_ACTIVITY_MEMCPY_KIND_HTOD:
+        return "MemcpyHtoD";
+      case CUPTI_ACTIVITY_MEMCPY_KIND_DTOH:
+        return "MemcpyDtoH";
+      case CUPTI_ACTIVITY_MEMCPY_KIND_DTOD:
+        return "MemcpyDtoD";
+      case CUPTI_ACTIVITY_MEMCPY_KIND_PTOP:
+        return "MemcpyPtoP";
+      case CUPTI_ACTIVITY_MEMCPY_KIND_HTOH:
+        return "MemcpyHtoH";
+      default:
+        return absl::StrCat("Memcpy", static_cast<int>(copy_kind));
+    }
+  }
+
+  Status GetDeviceName(uint32 device_id, const std::string** name) {
+    auto it = device_names_.find(device_id);
+    if (it == device_names_.end()) {
+      CUdevice device;
+      TF_RETURN_IF_ERROR(ToStatus(cuDeviceGet(&device, device_id)));
+      char buffer[100];
+      TF_RETURN_IF_ERROR(
+          ToStatus(cuDeviceGetName(buffer, sizeof(buffer), device)));
+      it = device_names_.emplace(device_id, buffer).first;
+    }
+    *name = &it->second;
+    return Status::OK();
+  }
+
+  Status SaveActivity(const std::string& name, const std::string& node_label,
+                      uint32 device_id, uint32 context_id, uint32 stream_id,
+                      uint64 start_ns, uint64 end_ns,
+                      const std::string* annotation) {
+    auto stats = absl::make_unique<NodeExecStats>();
+    stats->set_node_name(annotation ? absl::StrCat(*annotation, "::", name)
+                                    : name);
+    stats->set_timeline_label(node_label);
+    uint64 elapsed_us = end_ns > start_ns ? (end_ns - start_ns) / 1000 : 0;
+    stats->set_all_start_micros(recorder_->ToWalltimeUs(start_ns));
+    stats->set_op_end_rel_micros(elapsed_us);
+    stats->set_all_end_rel_micros(elapsed_us);
+
+    const std::string* device_name;
+    TF_RETURN_IF_ERROR(GetDeviceName(device_id, &device_name));
+    // TODO(csigg): tfprof_node.cc, run_metadata_test.py, and timeline_test.py
+    // currently require this particular formatting.
+    collector_->Save(absl::StrFormat("/device:GPU:%d/stream:all", device_id),
+                     new NodeExecStats(*stats));
+    collector_->Save(
+        absl::StrFormat("/gpu:%d (%s)/context#%d/stream#%d", device_id,
+                        *device_name, context_id, stream_id),
+        stats.release());
+    return Status::OK();
+  }
+
+  CuptiActivityRecorder* recorder_;
+  StepStatsCollector* collector_;
+  absl::flat_hash_map<uint32, std::string> device_names_;
+};
+
 Status DeviceTracer::CollectData(RunMetadata* run_metadata) {
   mutex_lock l(mu_);
   if (enabled_) {
     return errors::FailedPrecondition("DeviceTracer is still enabled.");
   }
 
+  if (!sampled_) {
+    return Status::OK();
+  }
+
   StepStatsCollector step_stats_collector(run_metadata->mutable_step_stats());
-  TF_RETURN_IF_ERROR(
-      CudaEventCollector::Collect(recorder_.get(), &step_stats_collector));
+  if (use_activity_api_) {
+    TF_RETURN_IF_ERROR(CuptiActivityCollector::Collect(
+        activity_recorder_.get(), &step_stats_collector));
+  } else {
+    TF_RETURN_IF_ERROR(
+        CudaEventCollector::Collect(recorder_.get(), &step_stats_collector));
+  }
   step_stats_collector.Finalize();
   return Status::OK();
 }
@@ -713,7 +1071,14 @@ std::unique_ptr<profiler::ProfilerInterface> CreateDeviceTracer(
     LogIfError(ToStatus(status));
     return nullptr;
   }
-  return absl::make_unique<DeviceTracer>();
+  bool use_activity_api;
+  LogIfError(ReadBoolFromEnvVar("TF_GPU_TRACER_USE_ACTIVITY_API",
+                                /*default_val=*/false, &use_activity_api));
+  int64 sample_period;
+  LogIfError(ReadInt64FromEnvVar("TF_GPU_TRACER_SAMPLE_PERIOD",
+                                 /*default_val=*/1, &sample_period));
+  return absl::make_unique<DeviceTracer>(use_activity_api,
+                                         std::max<int64>(sample_period, 1));
 }
 
 auto register_device_tracer_factory = [] {
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <stdlib.h>
+
 #include <map>
 #include <memory>
 #include <string>
@@ -211,6 +213,70 @@ TEST_F(DeviceTracerTest, TraceToStepStatsCollector) {
       << "Saw stats: " << run_metadata.DebugString();
 }
 
+TEST_F(DeviceTracerTest, TraceWithActivityApi) {
+  setenv("TF_GPU_TRACER_USE_ACTIVITY_API", "true", /*overwrite=*/1);
+  auto tracer = CreateDeviceTracer(nullptr);
+  unsetenv("TF_GPU_TRACER_USE_ACTIVITY_API");
+  if (!tracer) return;
+
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+  std::vector<Tensor> outputs;
+
+  TF_ASSERT_OK(tracer->Start());
+  TF_ASSERT_OK(session->Run(inputs, output_names, target_nodes, &outputs));
+  TF_ASSERT_OK(tracer->Stop());
+  RunMetadata run_metadata;
+  TF_ASSERT_OK(tracer->CollectData(&run_metadata));
+
+  bool found_stream_all = false;
+  for (const auto& dev_stats : run_metadata.step_stats().dev_stats()) {
+    if (dev_stats.device().find("stream:all") == string::npos) continue;
+    found_stream_all = true;
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      EXPECT_GT(node_stats.all_start_micros(), 0) << node_stats.node_name();
+    }
+  }
+  EXPECT_TRUE(found_stream_all) << "Saw stats: " << run_metadata.DebugString();
+}
+
+TEST_F(DeviceTracerTest, SamplesSessions) {
+  setenv("TF_GPU_TRACER_SAMPLE_PERIOD", "2", /*overwrite=*/1);
+  std::vector<std::unique_ptr<profiler::ProfilerInterface>> tracers;
+  for (int i = 0; i < 2; ++i) {
+    tracers.push_back(CreateDeviceTracer(nullptr));
+    if (!tracers.back()) break;
+  }
+  unsetenv("TF_GPU_TRACER_SAMPLE_PERIOD");
+  if (tracers.size() < 2 || !tracers.back()) return;
+
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+
+  // Exactly one of two consecutive sessions is traced.
+  int num_traced = 0;
+  for (auto& tracer : tracers) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(tracer->Start());
+    TF_ASSERT_OK(session->Run(inputs, output_names, target_nodes, &outputs));
+    TF_ASSERT_OK(tracer->Stop());
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(tracer->CollectData(&run_metadata));
+    if (run_metadata.step_stats().dev_stats_size() > 0) ++num_traced;
+  }
+  EXPECT_EQ(num_traced, 1);
+}
+
 TEST_F(DeviceTracerTest, RunWithTraceOption) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
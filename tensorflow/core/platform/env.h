@@ -259,6 +259,10 @@ class Env {
   /// \brief Returns the number of seconds since the Unix epoch.
   virtual uint64 NowSeconds() const { return env_time_->NowSeconds(); }
 
+  /// \brief Returns the number of nano-seconds of CPU time consumed by the
+  /// calling thread, or 0 if the platform cannot measure it.
+  virtual uint64 ThreadCpuNanos() const { return env_time_->ThreadCpuNanos(); }
+
   /// Sleeps/delays the thread for the prescribed number of micro-seconds.
   virtual void SleepForMicroseconds(int64 micros) = 0;
 
@@ -423,6 +427,8 @@ struct ThreadOptions {
   /// Guard area size to use near thread stacks to use (in bytes)
   size_t guard_size = 0;  // 0: use system default value
   int numa_node = port::kNUMANoAffinity;
+  /// CPUs the thread may run on, on platforms that support it.
+  std::vector<int> cpu_affinity;  // empty: no restriction
 };
 
 /// A utility routine: copy contents of `src` in file system `src_fs`
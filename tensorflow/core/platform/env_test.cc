@@ -90,6 +90,30 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadV) {
+  const string filename = io::JoinPath(BaseDir(), "read_v");
+  const string input = CreateTestFile(env_, filename, 100);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  char scratch[3][10];
+  std::vector<RandomAccessFile::ReadRange> ranges(3);
+  const uint64 offsets[] = {50, 0, 95};
+  for (int i = 0; i < 3; ++i) {
+    ranges[i].offset = offsets[i];
+    ranges[i].n = 10;
+    ranges[i].scratch = scratch[i];
+  }
+  // The last range reads past EOF.
+  EXPECT_EQ(error::OUT_OF_RANGE, f->ReadV(&ranges).code());
+  TF_EXPECT_OK(ranges[0].status);
+  EXPECT_EQ(input.substr(50, 10), ranges[0].result);
+  TF_EXPECT_OK(ranges[1].status);
+  EXPECT_EQ(input.substr(0, 10), ranges[1].result);
+  EXPECT_EQ(error::OUT_OF_RANGE, ranges[2].status.code());
+  EXPECT_EQ(input.substr(95), ranges[2].result);
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
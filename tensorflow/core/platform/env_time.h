@@ -50,6 +50,10 @@ class EnvTime {
 
   /// \brief Returns the number of seconds since the Unix epoch.
   virtual uint64 NowSeconds() const { return NowNanos() / kSecondsToNanos; }
+
+  /// \brief Returns the number of nano-seconds of CPU time consumed by the
+  /// calling thread, or 0 if the platform cannot measure it.
+  virtual uint64 ThreadCpuNanos() const { return 0; }
 };
 
 }  // namespace tensorflow
@@ -51,6 +51,15 @@ void FileSystem::FlushCaches() {}
 
 RandomAccessFile::~RandomAccessFile() {}
 
+Status RandomAccessFile::ReadV(std::vector<ReadRange>* ranges) const {
+  Status status;
+  for (ReadRange& range : *ranges) {
+    range.status = Read(range.offset, range.n, &range.result, range.scratch);
+    status.Update(range.status);
+  }
+  return status;
+}
+
 WritableFile::~WritableFile() {}
 
 FileSystemRegistry::~FileSystemRegistry() {}
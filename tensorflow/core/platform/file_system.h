@@ -260,6 +260,41 @@ class RandomAccessFile {
   virtual Status Read(uint64 offset, size_t n, StringPiece* result,
                       char* scratch) const = 0;
 
+  /// \brief A byte range read by `ReadV()`.
+  struct ReadRange {
+    uint64 offset = 0;
+    size_t n = 0;
+    /// Must hold at least `n` bytes and stay live while `result` is used.
+    char* scratch = nullptr;
+    /// Set to the data read, as by `Read()`.
+    StringPiece result;
+    /// Set to the status of reading this range, as returned by `Read()`.
+    Status status;
+  };
+
+  /// \brief Reads each of `*ranges`, possibly in parallel.
+  ///
+  /// Sets the `result` and `status` of every range and returns the first
+  /// non-OK status among them, or OK if all ranges were read completely.
+  ///
+  /// The default implementation calls `Read()` for each range in turn.
+  /// Filesystems where a read is a round trip to a remote service should
+  /// override it to issue the reads concurrently.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual Status ReadV(std::vector<ReadRange>* ranges) const;
+
+  /// \brief Asynchronous version of `ReadV()`.
+  ///
+  /// Calls `done` with the status `ReadV()` would return once all of
+  /// `*ranges` have been read. `ranges` and their scratch buffers must stay
+  /// live until then. The default implementation calls `ReadV()` and then
+  /// `done` on the calling thread.
+  virtual void ReadVAsync(std::vector<ReadRange>* ranges,
+                          std::function<void(const Status&)> done) const {
+    done(ReadV(ranges));
+  }
+
   // TODO(ebrevdo): Remove this ifdef when absl is updated.
 #if defined(PLATFORM_GOOGLE)
   /// \brief Read up to `n` bytes from the file starting at `offset`.
@@ -32,6 +32,17 @@ class PosixEnvTime : public EnvTime {
     return (static_cast<uint64>(ts.tv_sec) * kSecondsToNanos +
             static_cast<uint64>(ts.tv_nsec));
   }
+
+  uint64 ThreadCpuNanos() const override {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+      return (static_cast<uint64>(ts.tv_sec) * kSecondsToNanos +
+              static_cast<uint64>(ts.tv_nsec));
+    }
+#endif
+    return 0;
+  }
 };
 
 }  // namespace
@@ -0,0 +1,229 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/posix/io_uring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TF_HAS_IO_URING 1
+#endif
+#endif
+
+#ifdef TF_HAS_IO_URING
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+#ifdef TF_HAS_IO_URING
+namespace {
+
+// The kernel reads the submission queue tail and writes the completion queue
+// tail concurrently with us.
+unsigned LoadAcquire(const unsigned* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+void StoreRelease(unsigned* p, unsigned value) {
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+void* MapRing(int ring_fd, size_t size, off_t offset) {
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+}  // namespace
+
+/*static*/ std::unique_ptr<IoUring> IoUring::Create(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (ring_fd < 0) {
+    return nullptr;
+  }
+  std::unique_ptr<IoUring> ring(new IoUring());
+  ring->ring_fd_ = ring_fd;
+  ring->num_entries_ = params.sq_entries;
+
+  ring->sq_ring_size_ =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->sq_ring_ = MapRing(ring_fd, ring->sq_ring_size_, IORING_OFF_SQ_RING);
+  ring->cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  ring->cq_ring_ = MapRing(ring_fd, ring->cq_ring_size_, IORING_OFF_CQ_RING);
+  ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  ring->sqes_ = MapRing(ring_fd, ring->sqes_size_, IORING_OFF_SQES);
+  if (!ring->sq_ring_ || !ring->cq_ring_ || !ring->sqes_) {
+    return nullptr;
+  }
+
+  char* sq = static_cast<char*>(ring->sq_ring_);
+  ring->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  char* cq = static_cast<char*>(ring->cq_ring_);
+  ring->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes_ = cq + params.cq_off.cqes;
+  return ring;
+}
+
+IoUring::~IoUring() {
+  if (sqes_) munmap(sqes_, sqes_size_);
+  if (cq_ring_) munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_) munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ >= 0) close(ring_fd_);
+}
+
+bool IoUring::Enter(unsigned to_submit, unsigned min_complete,
+                    unsigned* num_submitted) {
+  while (to_submit > 0 || min_complete > 0) {
+    int r = syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                    IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (r < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      return false;
+    }
+    const unsigned submitted = std::min<unsigned>(r, to_submit);
+    to_submit -= submitted;
+    *num_submitted += submitted;
+    // Completions are counted by the caller; one successful wait is enough.
+    min_complete = 0;
+  }
+  return true;
+}
+
+void IoUring::Abandon(unsigned num_pending) {
+  abandoned_ = true;
+  // The kernel posts the completions of submitted reads whether or not
+  // io_uring_enter() works, so poll for them if waiting fails.
+  while (num_pending > 0) {
+    unsigned head = *cq_head_;
+    const unsigned cq_tail = LoadAcquire(cq_tail_);
+    if (head == cq_tail) {
+      if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+                  nullptr, 0) < 0) {
+        usleep(100);
+      }
+      continue;
+    }
+    num_pending -= std::min(num_pending, cq_tail - head);
+    StoreRelease(cq_head_, cq_tail);
+  }
+}
+
+bool IoUring::Read(const std::vector<ReadOp>& ops,
+                   std::vector<int64>* results) {
+  if (abandoned_) return false;
+  results->assign(ops.size(), 0);
+  std::vector<iovec> iovecs(num_entries_);
+  auto* sqes = static_cast<io_uring_sqe*>(sqes_);
+  auto* cqes = static_cast<io_uring_cqe*>(cqes_);
+
+  // Submit at most one ring's worth of reads at a time, so that completions
+  // can never overflow the completion queue.
+  for (size_t begin = 0; begin < ops.size(); begin += num_entries_) {
+    const size_t end = std::min<size_t>(ops.size(), begin + num_entries_);
+    unsigned tail = *sq_tail_;
+    for (size_t i = begin; i < end; ++i) {
+      const unsigned index = tail & *sq_mask_;
+      iovec& iov = iovecs[i - begin];
+      iov.iov_base = ops[i].buffer;
+      iov.iov_len = ops[i].n;
+      io_uring_sqe* sqe = &sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = ops[i].fd;
+      sqe->addr = reinterpret_cast<uint64>(&iov);
+      sqe->len = 1;
+      sqe->off = ops[i].offset;
+      sqe->user_data = i;
+      sq_array_[index] = index;
+      ++tail;
+    }
+    StoreRelease(sq_tail_, tail);
+
+    const unsigned num_ops = end - begin;
+    unsigned num_submitted = 0;
+    unsigned num_completed = 0;
+    bool ok = Enter(num_ops, num_ops, &num_submitted);
+    while (ok && num_completed < num_ops) {
+      unsigned head = *cq_head_;
+      const unsigned cq_tail = LoadAcquire(cq_tail_);
+      if (head == cq_tail) {
+        ok = Enter(0, 1, &num_submitted);
+        continue;
+      }
+      for (; head != cq_tail; ++head, ++num_completed) {
+        const io_uring_cqe& cqe = cqes[head & *cq_mask_];
+        (*results)[cqe.user_data] = cqe.res;
+      }
+      StoreRelease(cq_head_, head);
+    }
+    if (!ok) {
+      // The submitted reads may still write to the callers' buffers, which
+      // they will reuse once this returns.
+      Abandon(num_submitted - num_completed);
+      return false;
+    }
+  }
+  return true;
+}
+
+#else  // TF_HAS_IO_URING
+
+/*static*/ std::unique_ptr<IoUring> IoUring::Create(unsigned entries) {
+  return nullptr;
+}
+
+IoUring::~IoUring() {}
+
+bool IoUring::Enter(unsigned to_submit, unsigned min_complete,
+                    unsigned* num_submitted) {
+  return false;
+}
+
+void IoUring::Abandon(unsigned num_pending) { abandoned_ = true; }
+
+bool IoUring::Read(const std::vector<ReadOp>& ops,
+                   std::vector<int64>* results) {
+  return false;
+}
+
+#endif  // TF_HAS_IO_URING
+
+/*static*/ IoUring* IoUring::ForCurrentThread() {
+  static constexpr unsigned kEntries = 64;
+  thread_local std::unique_ptr<IoUring> ring = Create(kEntries);
+  if (ring != nullptr && ring->abandoned()) {
+    LOG(WARNING) << "io_uring failed, replacing the ring of this thread.";
+    ring = Create(kEntries);
+  }
+  return ring.get();
+}
+
+}  // namespace tensorflow
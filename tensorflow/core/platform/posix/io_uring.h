@@ -0,0 +1,101 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_POSIX_IO_URING_H_
+#define TENSORFLOW_CORE_PLATFORM_POSIX_IO_URING_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A minimal io_uring instance used to submit batches of reads with a single
+// system call. Only available on Linux 5.1 and later, built against kernel
+// headers that define io_uring.
+//
+// An IoUring is not thread safe; use one per thread.
+class IoUring {
+ public:
+  struct ReadOp {
+    int fd;
+    char* buffer;
+    size_t n;
+    uint64 offset;
+  };
+
+  // Returns null if io_uring is not supported by the build or the kernel.
+  static std::unique_ptr<IoUring> Create(unsigned entries);
+
+  // Returns the ring of the calling thread, creating it on first use, or null
+  // if io_uring is not supported.
+  static IoUring* ForCurrentThread();
+
+  ~IoUring();
+
+  // Reads all `ops`, which may refer to different files, and waits for them.
+  // Sets `(*results)[i]` to the number of bytes read by `ops[i]`, which may
+  // be short, or to -errno. Returns false if the ring itself failed, in which
+  // case the results are unspecified. Even then, no read is still writing to
+  // the buffers of `ops` when this returns.
+  bool Read(const std::vector<ReadOp>& ops, std::vector<int64>* results);
+
+  // Whether a failure of the ring made it unusable. Read() then fails at once.
+  bool abandoned() const { return abandoned_; }
+
+ private:
+  IoUring() {}
+
+  // Submits `to_submit` queued entries and waits for `min_complete`
+  // completions. Adds the number of entries the kernel took to
+  // `*num_submitted`, also when it fails.
+  bool Enter(unsigned to_submit, unsigned min_complete,
+             unsigned* num_submitted);
+
+  // Waits for the completions of `num_pending` submitted reads after
+  // io_uring_enter() failed, and marks the ring as abandoned. Entries the
+  // kernel did not take stay in the submission queue and point to stale
+  // iovecs, so the ring must not be entered again.
+  void Abandon(unsigned num_pending);
+
+  int ring_fd_ = -1;
+  bool abandoned_ = false;
+  unsigned num_entries_ = 0;
+
+  // Mappings of the submission queue, completion queue, and submission
+  // queue entries shared with the kernel.
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  void* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  void* cqes_ = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_POSIX_IO_URING_H_
@@ -0,0 +1,130 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/posix/io_uring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// More reads than the entries of a ring, so that they take several batches.
+constexpr int kNumReads = 150;
+constexpr int kReadSize = 5;
+
+string CreateTestFile(const string& name, int length) {
+  const string filename = io::JoinPath(testing::TmpDir(), name);
+  string input(length, 0);
+  for (int i = 0; i < length; i++) input[i] = i;
+  TF_CHECK_OK(WriteStringToFile(Env::Default(), filename, input));
+  return filename;
+}
+
+TEST(IoUringTest, ReadsInBatches) {
+  std::unique_ptr<IoUring> ring = IoUring::Create(64);
+  if (ring == nullptr) {
+    LOG(INFO) << "io_uring is not supported, skipping the test.";
+    return;
+  }
+  const string filename = CreateTestFile("io_uring_batches", 1000);
+  const int fd = open(filename.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  char scratch[kNumReads][kReadSize];
+  std::vector<IoUring::ReadOp> ops;
+  for (int i = 0; i < kNumReads; ++i) {
+    ops.push_back({fd, scratch[i], kReadSize,
+                   static_cast<uint64>(i * 7 % (1000 - kReadSize))});
+  }
+  std::vector<int64> results;
+  ASSERT_TRUE(ring->Read(ops, &results));
+  ASSERT_EQ(kNumReads, results.size());
+  for (int i = 0; i < kNumReads; ++i) {
+    ASSERT_EQ(kReadSize, results[i]) << i;
+    for (int j = 0; j < kReadSize; ++j) {
+      EXPECT_EQ(static_cast<char>(ops[i].offset + j), scratch[i][j]);
+    }
+  }
+  close(fd);
+}
+
+TEST(IoUringTest, ShortReadsAndErrors) {
+  std::unique_ptr<IoUring> ring = IoUring::Create(64);
+  if (ring == nullptr) {
+    LOG(INFO) << "io_uring is not supported, skipping the test.";
+    return;
+  }
+  const string filename = CreateTestFile("io_uring_errors", 100);
+  const int fd = open(filename.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  char scratch[3][10];
+  std::vector<IoUring::ReadOp> ops = {{fd, scratch[0], 10, 95},
+                                      {-1, scratch[1], 10, 0},
+                                      {fd, scratch[2], 10, 200}};
+  std::vector<int64> results;
+  ASSERT_TRUE(ring->Read(ops, &results));
+  EXPECT_EQ(5, results[0]);
+  EXPECT_EQ(-EBADF, results[1]);
+  EXPECT_EQ(0, results[2]);
+  // Failed reads do not make the ring unusable.
+  EXPECT_FALSE(ring->abandoned());
+  close(fd);
+}
+
+class IoUringEnvTest : public ::testing::Test {
+ protected:
+  // The file system reads the setting on the first ReadV() of the process.
+  static void SetUpTestCase() { setenv("TF_POSIX_USE_IO_URING", "1", 1); }
+};
+
+TEST_F(IoUringEnvTest, ReadV) {
+  const string filename = CreateTestFile("io_uring_read_v", 1000);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(filename, &f));
+
+  char scratch[kNumReads + 1][kReadSize];
+  std::vector<RandomAccessFile::ReadRange> ranges(kNumReads + 1);
+  for (int i = 0; i < kNumReads; ++i) {
+    ranges[i].offset = i * 7 % (1000 - kReadSize);
+    ranges[i].n = kReadSize;
+    ranges[i].scratch = scratch[i];
+  }
+  // The last range reads past EOF.
+  ranges[kNumReads].offset = 998;
+  ranges[kNumReads].n = kReadSize;
+  ranges[kNumReads].scratch = scratch[kNumReads];
+
+  EXPECT_EQ(error::OUT_OF_RANGE, f->ReadV(&ranges).code());
+  string input;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &input));
+  for (int i = 0; i < kNumReads; ++i) {
+    TF_EXPECT_OK(ranges[i].status);
+    EXPECT_EQ(input.substr(ranges[i].offset, kReadSize), ranges[i].result);
+  }
+  EXPECT_EQ(error::OUT_OF_RANGE, ranges[kNumReads].status.code());
+  EXPECT_EQ(input.substr(998), ranges[kNumReads].result);
+}
+
+}  // namespace
+}  // namespace tensorflow
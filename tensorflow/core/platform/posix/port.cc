@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/platform/zstd.h"
 
 #if defined(__linux__) && !defined(__ANDROID__)
 #include <sched.h>
@@ -40,6 +41,10 @@ limitations under the License.
 #ifdef TF_USE_SNAPPY
 #include "snappy.h"
 #endif
+#ifdef TF_USE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
 #if (defined(__APPLE__) && defined(__MACH__)) || defined(__FreeBSD__) || \
     defined(__HAIKU__)
 #include <thread>
@@ -126,6 +131,20 @@ int GetCurrentCPU() {
   return kUnknownCPU;
 }
 
+bool SetCurrentThreadCpuAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    CPU_SET(cpu, &cpuset);
+  }
+  return sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) == 0;
+#else
+  return false;
+#endif
+}
+
 int NumHyperthreadsPerCore() {
   static const int ht_per_core = tensorflow::port::CPUIDNumSMT();
   return (ht_per_core > 0) ? ht_per_core : 1;
@@ -336,6 +355,84 @@ bool Snappy_Uncompress(const char* input, size_t length, char* output) {
 #endif
 }
 
+bool Zstd_Compress(const char* input, size_t length, int level,
+                   const string& dictionary, string* output) {
+#ifdef TF_USE_ZSTD
+  output->resize(ZSTD_compressBound(length));
+  size_t outlen;
+  if (dictionary.empty()) {
+    outlen = ZSTD_compress(&(*output)[0], output->size(), input, length, level);
+  } else {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    outlen = ZSTD_compress_usingDict(cctx, &(*output)[0], output->size(),
+                                     input, length, dictionary.data(),
+                                     dictionary.size(), level);
+    ZSTD_freeCCtx(cctx);
+  }
+  if (ZSTD_isError(outlen)) return false;
+  output->resize(outlen);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                size_t* result) {
+#ifdef TF_USE_ZSTD
+  const unsigned long long size = ZSTD_getFrameContentSize(input, length);
+  if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR) {
+    return false;
+  }
+  *result = size;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool Zstd_Uncompress(const char* input, size_t length,
+                     const string& dictionary, char* output,
+                     size_t output_length) {
+#ifdef TF_USE_ZSTD
+  size_t outlen;
+  if (dictionary.empty()) {
+    outlen = ZSTD_decompress(output, output_length, input, length);
+  } else {
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    outlen = ZSTD_decompress_usingDict(dctx, output, output_length, input,
+                                       length, dictionary.data(),
+                                       dictionary.size());
+    ZSTD_freeDCtx(dctx);
+  }
+  return !ZSTD_isError(outlen) && outlen == output_length;
+#else
+  return false;
+#endif
+}
+
+bool Zstd_TrainDictionary(const std::vector<string>& samples, size_t max_size,
+                          string* dictionary) {
+#ifdef TF_USE_ZSTD
+  string buffer;
+  std::vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (const string& sample : samples) {
+    buffer.append(sample);
+    sizes.push_back(sample.size());
+  }
+  dictionary->resize(max_size);
+  const size_t size =
+      ZDICT_trainFromBuffer(&(*dictionary)[0], max_size, buffer.data(),
+                            sizes.data(), sizes.size());
+  if (ZDICT_isError(size)) return false;
+  dictionary->resize(size);
+  return true;
+#else
+  return false;
+#endif
+}
+
 string Demangle(const char* mangled) { return mangled; }
 
 double NominalCPUFrequency() {
@@ -18,6 +18,8 @@ limitations under the License.
 #include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #if defined(__linux__)
 #include <sys/sendfile.h>
@@ -35,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/posix/error.h"
+#include "tensorflow/core/platform/posix/io_uring.h"
 #include "tensorflow/core/platform/posix/posix_file_system.h"
 
 namespace tensorflow {
@@ -88,6 +91,53 @@ class PosixRandomAccessFile : public RandomAccessFile {
     *result = StringPiece(scratch, dst - scratch);
     return s;
   }
+
+  Status ReadV(std::vector<ReadRange>* ranges) const override {
+    IoUring* ring = UseIoUring() ? IoUring::ForCurrentThread() : nullptr;
+    std::vector<IoUring::ReadOp> ops;
+    std::vector<int64> results;
+    if (ring != nullptr) {
+      ops.reserve(ranges->size());
+      for (const ReadRange& range : *ranges) {
+        ops.push_back({fd_, range.scratch, range.n, range.offset});
+      }
+    }
+    if (ring == nullptr || !ring->Read(ops, &results)) {
+      return RandomAccessFile::ReadV(ranges);
+    }
+
+    Status status;
+    for (size_t i = 0; i < ranges->size(); ++i) {
+      ReadRange& range = (*ranges)[i];
+      if (results[i] < 0) {
+        range.status = IOError(filename_, -results[i]);
+        range.result = StringPiece(range.scratch, 0);
+      } else if (static_cast<size_t>(results[i]) < range.n) {
+        // Finish short reads, and detect EOF, with pread().
+        StringPiece rest;
+        range.status = Read(range.offset + results[i], range.n - results[i],
+                            &rest, range.scratch + results[i]);
+        range.result = StringPiece(range.scratch, results[i] + rest.size());
+      } else {
+        range.status = Status::OK();
+        range.result = StringPiece(range.scratch, range.n);
+      }
+      status.Update(range.status);
+    }
+    return status;
+  }
+
+ private:
+  // Whether ReadV() submits its reads to io_uring in a single system call,
+  // enabled by setting TF_POSIX_USE_IO_URING=1.
+  static bool UseIoUring() {
+    static const bool use_io_uring = [] {
+      const char* value = getenv("TF_POSIX_USE_IO_URING");
+      return value != nullptr &&
+             (strcmp(value, "1") == 0 || strcmp(value, "true") == 0);
+    }();
+    return use_io_uring;
+  }
 };
 
 class PosixWritableFile : public WritableFile {
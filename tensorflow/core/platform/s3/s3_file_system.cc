@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/platform/s3/s3_file_system.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/file_system_helper.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/s3/aws_crypto.h"
 #include "tensorflow/core/platform/s3/aws_logging.h"
@@ -28,15 +30,23 @@ limitations under the License.
 #include <aws/core/utils/logging/LogSystemInterface.h>
 #include <aws/s3/S3Client.h>
 #include <aws/s3/S3Errors.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
 #include <aws/s3/model/CopyObjectRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/DeleteObjectRequest.h>
 #include <aws/s3/model/GetObjectRequest.h>
 #include <aws/s3/model/HeadBucketRequest.h>
 #include <aws/s3/model/HeadObjectRequest.h>
 #include <aws/s3/model/ListObjectsRequest.h>
 #include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <deque>
 
 namespace tensorflow {
 
@@ -44,6 +54,11 @@ namespace {
 static const char* kS3FileSystemAllocationTag = "S3FileSystemAllocation";
 static const size_t kS3ReadAppendableFileBufferSize = 1024 * 1024;
 static const int kS3GetChildrenMaxKeys = 100;
+// S3 requires all parts of a multipart upload but the last to be at least
+// 5 MB.
+static const size_t kS3MinMultipartUploadPartSize = 5 * 1024 * 1024;
+static const size_t kS3DefaultMultipartUploadPartSize = 64 * 1024 * 1024;
+static const size_t kS3DefaultMultipartUploadConcurrency = 4;
 
 Aws::Client::ClientConfiguration& GetDefaultClientConfig() {
   static mutex cfg_lock(LINKER_INITIALIZED);
@@ -130,6 +145,30 @@ Aws::Client::ClientConfiguration& GetDefaultClientConfig() {
   return cfg;
 };
 
+// Returns the size of the parts of multipart uploads, overridden in MB by
+// S3_MULTIPART_UPLOAD_PART_SIZE_MB.
+size_t GetMultipartUploadPartSize() {
+  const char* part_size_mb = getenv("S3_MULTIPART_UPLOAD_PART_SIZE_MB");
+  uint64 value;
+  if (part_size_mb && strings::safe_strtou64(part_size_mb, &value)) {
+    return std::max<size_t>(value * 1024 * 1024,
+                            kS3MinMultipartUploadPartSize);
+  }
+  return kS3DefaultMultipartUploadPartSize;
+}
+
+// Returns how many parts of a file may be uploaded concurrently, overridden
+// by S3_MULTIPART_UPLOAD_CONCURRENCY.
+size_t GetMultipartUploadConcurrency() {
+  const char* concurrency = getenv("S3_MULTIPART_UPLOAD_CONCURRENCY");
+  uint64 value;
+  if (concurrency && strings::safe_strtou64(concurrency, &value) &&
+      value > 0) {
+    return value;
+  }
+  return kS3DefaultMultipartUploadConcurrency;
+}
+
 void ShutdownClient(Aws::S3::S3Client* s3_client) {
   if (s3_client != nullptr) {
     delete s3_client;
@@ -176,6 +215,34 @@ class S3RandomAccessFile : public RandomAccessFile {
 
   Status Read(uint64 offset, size_t n, StringPiece* result,
               char* scratch) const override {
+    auto getObjectOutcome =
+        this->s3_client_->GetObject(MakeGetObjectRequest(offset, n));
+    return ReadOutcome(&getObjectOutcome, result, scratch);
+  }
+
+  Status ReadV(std::vector<ReadRange>* ranges) const override {
+    // Issue all ranged GETs before waiting for any of them, so that the
+    // client's executor runs them in parallel.
+    std::vector<Aws::S3::Model::GetObjectOutcomeCallable> outcomes;
+    outcomes.reserve(ranges->size());
+    for (const ReadRange& range : *ranges) {
+      outcomes.push_back(this->s3_client_->GetObjectCallable(
+          MakeGetObjectRequest(range.offset, range.n)));
+    }
+    Status status;
+    for (size_t i = 0; i < ranges->size(); ++i) {
+      ReadRange& range = (*ranges)[i];
+      auto getObjectOutcome = outcomes[i].get();
+      range.status = ReadOutcome(&getObjectOutcome, &range.result,
+                                 range.scratch);
+      status.Update(range.status);
+    }
+    return status;
+  }
+
+ private:
+  Aws::S3::Model::GetObjectRequest MakeGetObjectRequest(uint64 offset,
+                                                        size_t n) const {
     Aws::S3::Model::GetObjectRequest getObjectRequest;
     getObjectRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
     string bytes = strings::StrCat("bytes=", offset, "-", offset + n - 1);
@@ -183,58 +250,77 @@ class S3RandomAccessFile : public RandomAccessFile {
     getObjectRequest.SetResponseStreamFactory([]() {
       return Aws::New<Aws::StringStream>(kS3FileSystemAllocationTag);
     });
-    auto getObjectOutcome = this->s3_client_->GetObject(getObjectRequest);
-    if (!getObjectOutcome.IsSuccess()) {
-      n = 0;
-      *result = StringPiece(scratch, n);
+    return getObjectRequest;
+  }
+
+  static Status ReadOutcome(Aws::S3::Model::GetObjectOutcome* getObjectOutcome,
+                            StringPiece* result, char* scratch) {
+    if (!getObjectOutcome->IsSuccess()) {
+      *result = StringPiece(scratch, 0);
       return Status(error::OUT_OF_RANGE, "Read less bytes than requested");
     }
-    n = getObjectOutcome.GetResult().GetContentLength();
-    getObjectOutcome.GetResult().GetBody().read(scratch, n);
+    size_t n = getObjectOutcome->GetResult().GetContentLength();
+    getObjectOutcome->GetResult().GetBody().read(scratch, n);
 
     *result = StringPiece(scratch, n);
     return Status::OK();
   }
 
- private:
   string bucket_;
   string object_;
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
 };
 
+// Uploads the file as a single object on Sync() and Close() until it grows
+// past `part_size` bytes. From then on, it is sent as a multipart upload:
+// every full part is uploaded in the background while the file is still
+// being appended to, with at most `max_parts_in_flight` parts in flight, and
+// the object appears once Close() completes the upload.
 class S3WritableFile : public WritableFile {
  public:
   S3WritableFile(const string& bucket, const string& object,
-                 std::shared_ptr<Aws::S3::S3Client> s3_client)
+                 std::shared_ptr<Aws::S3::S3Client> s3_client,
+                 size_t part_size, size_t max_parts_in_flight)
       : bucket_(bucket),
         object_(object),
         s3_client_(s3_client),
+        part_size_(part_size),
+        max_parts_in_flight_(std::max<size_t>(max_parts_in_flight, 1)),
         sync_needed_(true),
-        outfile_(Aws::MakeShared<Aws::Utils::TempFile>(
-            kS3FileSystemAllocationTag, "/tmp/s3_filesystem_XXXXXX",
-            std::ios_base::binary | std::ios_base::trunc | std::ios_base::in |
-                std::ios_base::out)) {}
+        closed_(false) {}
+
+  ~S3WritableFile() override {
+    if (!closed_ && !upload_id_.empty()) {
+      // Do not leave the parts of an unfinished upload behind.
+      WaitForParts(0).IgnoreError();
+      AbortMultipartUpload();
+    }
+  }
 
   Status Append(StringPiece data) override {
-    if (!outfile_) {
-      return errors::FailedPrecondition(
-          "The internal temporary file is not writable.");
+    if (closed_) {
+      return errors::FailedPrecondition("The S3 file is already closed.");
     }
     sync_needed_ = true;
-    outfile_->write(data.data(), data.size());
-    if (!outfile_->good()) {
-      return errors::Internal(
-          "Could not append to the internal temporary file.");
+    buffer_.append(data.data(), data.size());
+    if (buffer_.size() >= part_size_) {
+      size_t begin = 0;
+      for (; buffer_.size() - begin >= part_size_; begin += part_size_) {
+        TF_RETURN_IF_ERROR(UploadPart(buffer_.substr(begin, part_size_)));
+      }
+      buffer_.erase(0, begin);
     }
     return Status::OK();
   }
 
   Status Close() override {
-    if (outfile_) {
-      TF_RETURN_IF_ERROR(Sync());
-      outfile_.reset();
+    if (closed_) {
+      return Status::OK();
     }
-    return Status::OK();
+    Status status = upload_id_.empty() ? Sync() : CompleteMultipartUpload();
+    closed_ = true;
+    buffer_.clear();
+    return status;
   }
 
   Status Flush() override { return Sync(); }
@@ -244,35 +330,140 @@ class S3WritableFile : public WritableFile {
   }
 
   Status Sync() override {
-    if (!outfile_) {
-      return errors::FailedPrecondition(
-          "The internal temporary file is not writable.");
+    if (closed_) {
+      return errors::FailedPrecondition("The S3 file is already closed.");
+    }
+    if (!upload_id_.empty()) {
+      // A multipart upload cannot be made visible before it is complete.
+      return status_;
     }
     if (!sync_needed_) {
       return Status::OK();
     }
     Aws::S3::Model::PutObjectRequest putObjectRequest;
     putObjectRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
-    long offset = outfile_->tellp();
-    outfile_->seekg(0);
-    putObjectRequest.SetBody(outfile_);
-    putObjectRequest.SetContentLength(offset);
+    putObjectRequest.SetBody(MakeBody(buffer_));
+    putObjectRequest.SetContentLength(buffer_.size());
     auto putObjectOutcome = this->s3_client_->PutObject(putObjectRequest);
-    outfile_->clear();
-    outfile_->seekp(offset);
     if (!putObjectOutcome.IsSuccess()) {
       return errors::Unknown(putObjectOutcome.GetError().GetExceptionName(),
                              ": ", putObjectOutcome.GetError().GetMessage());
     }
+    sync_needed_ = false;
     return Status::OK();
   }
 
  private:
+  static std::shared_ptr<Aws::IOStream> MakeBody(const string& data) {
+    auto body = Aws::MakeShared<Aws::StringStream>(kS3FileSystemAllocationTag);
+    body->write(data.data(), data.size());
+    return body;
+  }
+
+  // Starts uploading `data` as the next part, starting the multipart upload
+  // first if needed.
+  Status UploadPart(const string& data) {
+    if (upload_id_.empty()) {
+      Aws::S3::Model::CreateMultipartUploadRequest createRequest;
+      createRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
+      auto createOutcome =
+          this->s3_client_->CreateMultipartUpload(createRequest);
+      if (!createOutcome.IsSuccess()) {
+        return errors::Unknown(createOutcome.GetError().GetExceptionName(),
+                               ": ", createOutcome.GetError().GetMessage());
+      }
+      upload_id_ = createOutcome.GetResult().GetUploadId().c_str();
+    }
+    TF_RETURN_IF_ERROR(WaitForParts(max_parts_in_flight_ - 1));
+
+    const int part_number =
+        completed_parts_.size() + parts_in_flight_.size() + 1;
+    Aws::S3::Model::UploadPartRequest uploadPartRequest;
+    uploadPartRequest.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_.c_str())
+        .WithPartNumber(part_number);
+    uploadPartRequest.SetBody(MakeBody(data));
+    uploadPartRequest.SetContentLength(data.size());
+    parts_in_flight_.emplace_back(
+        part_number, this->s3_client_->UploadPartCallable(uploadPartRequest));
+    return Status::OK();
+  }
+
+  // Waits until at most `max_in_flight` parts are being uploaded. Returns the
+  // first error of any part uploaded so far.
+  Status WaitForParts(size_t max_in_flight) {
+    while (parts_in_flight_.size() > max_in_flight) {
+      const int part_number = parts_in_flight_.front().first;
+      auto uploadPartOutcome = parts_in_flight_.front().second.get();
+      parts_in_flight_.pop_front();
+      if (!uploadPartOutcome.IsSuccess()) {
+        status_.Update(errors::Unknown(
+            uploadPartOutcome.GetError().GetExceptionName(), ": ",
+            uploadPartOutcome.GetError().GetMessage()));
+        continue;
+      }
+      completed_parts_.push_back(
+          Aws::S3::Model::CompletedPart()
+              .WithETag(uploadPartOutcome.GetResult().GetETag())
+              .WithPartNumber(part_number));
+    }
+    return status_;
+  }
+
+  Status CompleteMultipartUpload() {
+    if (!buffer_.empty() && status_.ok()) {
+      status_.Update(UploadPart(buffer_));
+    }
+    if (!WaitForParts(0).ok()) {
+      AbortMultipartUpload();
+      return status_;
+    }
+    Aws::S3::Model::CompletedMultipartUpload completedUpload;
+    completedUpload.SetParts(completed_parts_);
+    Aws::S3::Model::CompleteMultipartUploadRequest completeRequest;
+    completeRequest.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_.c_str())
+        .WithMultipartUpload(completedUpload);
+    auto completeOutcome =
+        this->s3_client_->CompleteMultipartUpload(completeRequest);
+    if (!completeOutcome.IsSuccess()) {
+      AbortMultipartUpload();
+      return errors::Unknown(completeOutcome.GetError().GetExceptionName(),
+                             ": ", completeOutcome.GetError().GetMessage());
+    }
+    return Status::OK();
+  }
+
+  void AbortMultipartUpload() {
+    Aws::S3::Model::AbortMultipartUploadRequest abortRequest;
+    abortRequest.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_.c_str());
+    auto abortOutcome = this->s3_client_->AbortMultipartUpload(abortRequest);
+    if (!abortOutcome.IsSuccess()) {
+      LOG(WARNING) << "Failed to abort the multipart upload of s3://"
+                   << bucket_ << "/" << object_ << ": "
+                   << abortOutcome.GetError().GetMessage();
+    }
+  }
+
   string bucket_;
   string object_;
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
+  const size_t part_size_;
+  const size_t max_parts_in_flight_;
   bool sync_needed_;
-  std::shared_ptr<Aws::Utils::TempFile> outfile_;
+  bool closed_;
+  // Data appended but not yet uploaded as a part.
+  string buffer_;
+  // Empty until the file outgrows a single part.
+  string upload_id_;
+  std::deque<std::pair<int, Aws::S3::Model::UploadPartOutcomeCallable>>
+      parts_in_flight_;
+  Aws::Vector<Aws::S3::Model::CompletedPart> completed_parts_;
+  Status status_;
 };
 
 class S3ReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
@@ -336,7 +527,9 @@ Status S3FileSystem::NewWritableFile(const string& fname,
                                      std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
-  result->reset(new S3WritableFile(bucket, object, this->GetS3Client()));
+  result->reset(new S3WritableFile(bucket, object, this->GetS3Client(),
+                                   GetMultipartUploadPartSize(),
+                                   GetMultipartUploadConcurrency()));
   return Status::OK();
 }
 
@@ -351,7 +544,9 @@ Status S3FileSystem::NewAppendableFile(const string& fname,
 
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
-  result->reset(new S3WritableFile(bucket, object, this->GetS3Client()));
+  result->reset(new S3WritableFile(bucket, object, this->GetS3Client(),
+                                   GetMultipartUploadPartSize(),
+                                   GetMultipartUploadConcurrency()));
 
   while (true) {
     status = reader->Read(offset, kS3ReadAppendableFileBufferSize, &read_chunk,
@@ -70,6 +70,22 @@ class WindowsEnvTime : public EnvTime {
         .count();
   }
 
+  uint64 ThreadCpuNanos() const override {
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time,
+                        &kernel_time, &user_time)) {
+      return 0;
+    }
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernel_time.dwLowDateTime;
+    kernel.HighPart = kernel_time.dwHighDateTime;
+    user.LowPart = user_time.dwLowDateTime;
+    user.HighPart = user_time.dwHighDateTime;
+    // FILETIME durations are expressed in 100 nanosecond intervals.
+    constexpr uint64 kFtToNanoSec = 100;
+    return (kernel.QuadPart + user.QuadPart) * kFtToNanoSec;
+  }
+
   void SleepForMicroseconds(int64 micros) { Sleep(micros / 1000); }
 
  private:
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/platform/zstd.h"
 
 namespace tensorflow {
 namespace port {
@@ -91,6 +92,16 @@ int GetCurrentCPU() {
   return GetCurrentProcessorNumber();
 }
 
+bool SetCurrentThreadCpuAffinity(const std::vector<int>& cpus) {
+  // Like GetCurrentCPU, this only covers the current processor group.
+  DWORD_PTR mask = 0;
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= 8 * sizeof(DWORD_PTR)) return false;
+    mask |= static_cast<DWORD_PTR>(1) << cpu;
+  }
+  return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
 bool NUMAEnabled() {
   // Not yet implemented: coming soon.
   return false;
@@ -161,6 +172,28 @@ bool Snappy_Uncompress(const char* input, size_t length, char* output) {
 #endif
 }
 
+// Zstandard is not supported on Windows.
+bool Zstd_Compress(const char* input, size_t length, int level,
+                   const string& dictionary, string* output) {
+  return false;
+}
+
+bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                size_t* result) {
+  return false;
+}
+
+bool Zstd_Uncompress(const char* input, size_t length,
+                     const string& dictionary, char* output,
+                     size_t output_length) {
+  return false;
+}
+
+bool Zstd_TrainDictionary(const std::vector<string>& samples, size_t max_size,
+                          string* dictionary) {
+  return false;
+}
+
 string Demangle(const char* mangled) { return mangled; }
 
 double NominalCPUFrequency() {
@@ -0,0 +1,51 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_ZSTD_H_
+#define TENSORFLOW_CORE_PLATFORM_ZSTD_H_
+
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace port {
+
+// Zstandard compression/decompression support. Only available when built
+// with --define=with_zstd_support=true; otherwise all functions return false.
+//
+// `dictionary` may be empty; if not, the same dictionary must be used to
+// compress and uncompress.
+bool Zstd_Compress(const char* input, size_t length, int level,
+                   const string& dictionary, string* output);
+
+// Sets `*result` to the uncompressed size recorded in the zstd frame `input`.
+bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                size_t* result);
+
+// Uncompresses the zstd frame `input` into exactly `output_length` bytes.
+bool Zstd_Uncompress(const char* input, size_t length,
+                     const string& dictionary, char* output,
+                     size_t output_length);
+
+// Trains a dictionary of at most `max_size` bytes from `samples`, which
+// should be representative of the data to compress.
+bool Zstd_TrainDictionary(const std::vector<string>& samples, size_t max_size,
+                          string* dictionary);
+
+}  // namespace port
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_ZSTD_H_
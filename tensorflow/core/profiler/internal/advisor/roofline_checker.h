@@ -0,0 +1,261 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// This checker compares the FLOP/s and bytes/s achieved by each operation
+// with the roofline of its device.
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_ROOFLINE_CHECKER_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_ROOFLINE_CHECKER_H_
+
+#include <algorithm>
+
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/profiler/internal/advisor/checker.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+// The roofline of a device: its peak compute and memory bandwidth.
+struct Roofline {
+  double gflops = 0.0;
+  double gb_per_sec = 0.0;
+
+  bool valid() const { return gflops > 0 && gb_per_sec > 0; }
+
+  // The best GFLOP/s an op with the given FLOPs per byte can achieve.
+  double AttainableGflops(double intensity) const {
+    return std::min(gflops, intensity * gb_per_sec);
+  }
+};
+
+// The roofline analysis of one operation.
+struct RooflineOpStats {
+  string name;
+  string op;
+  string device;
+  // Per run of the op.
+  double flops = 0.0;
+  double bytes = 0.0;
+  double seconds = 0.0;
+  // True if the cost estimator had to guess, e.g. because of unknown shapes.
+  bool inaccurate = false;
+
+  // FLOPs per byte.
+  double intensity() const { return bytes > 0 ? flops / bytes : 0.0; }
+  double achieved_gflops() const { return flops / seconds * 1e-9; }
+  double achieved_gb_per_sec() const { return bytes / seconds * 1e-9; }
+
+  // The achieved fraction of what the roofline allows for this op. For ops
+  // without FLOPs, the fraction of the peak memory bandwidth.
+  double RooflineFraction(const Roofline& roofline) const {
+    if (flops <= 0) {
+      return achieved_gb_per_sec() / roofline.gb_per_sec;
+    }
+    return achieved_gflops() / roofline.AttainableGflops(intensity());
+  }
+
+  bool ComputeBound(const Roofline& roofline) const {
+    return flops > 0 && intensity() * roofline.gb_per_sec >= roofline.gflops;
+  }
+};
+
+// Options:
+//   cpu_peak_gflops, cpu_peak_gb_per_sec: The CPU roofline. Defaults to the
+//     peaks grappler estimates for the local CPU.
+//   gpu_peak_gflops, gpu_peak_gb_per_sec: The GPU roofline. Defaults to the
+//     peaks grappler estimates for the local GPU 0, if any.
+//   top_k: The number of operations to report. Defaults to 10.
+//
+// FLOP and byte counts per run come from the grappler OpLevelCostEstimator,
+// applied to the shapes recorded in the profile, and the time per run from
+// the step stats. Operations are ranked by the time they would save if they
+// ran at the roofline.
+class RooflineChecker : public Checker {
+ public:
+  string name() const override { return kCheckers[4]; }
+
+ private:
+  AdviceProto::Checker Check(const AdvisorOptionsProto::CheckerOption& options,
+                             const TFStats* stats) override {
+    if (!stats) {
+      fprintf(stderr, "Missing profiles (e.g. graph, run_meta). Skip %s\n",
+              name().c_str());
+      return reports_;
+    }
+    if (stats->steps().empty()) {
+      fprintf(stderr, "Missing RunMetadata info. Skip %s\n", name().c_str());
+      return reports_;
+    }
+    cpu_roofline_ = GetRoofline(options, "cpu", grappler::GetLocalCPUInfo());
+    gpu_roofline_ = GetRoofline(options, "gpu",
+                                grappler::GetLocalGPUInfo(PlatformGpuId(0)));
+    int64 top_k = 10;
+    auto it = options.options().find("top_k");
+    if (it != options.options().end()) {
+      strings::safe_strto64(it->second, &top_k);
+    }
+
+    std::vector<RooflineOpStats> ops;
+    for (const auto& n : stats->nodes()) {
+      RooflineOpStats op;
+      if (Analyze(n.second.get(), &op)) {
+        ops.push_back(std::move(op));
+      }
+    }
+    std::sort(ops.begin(), ops.end(),
+              [this](const RooflineOpStats& a, const RooflineOpStats& b) {
+                return LostSeconds(a) > LostSeconds(b);
+              });
+
+    std::vector<string> outputs;
+    for (int64 i = 0; i < top_k && i < static_cast<int64>(ops.size()); ++i) {
+      const RooflineOpStats& op = ops[i];
+      const Roofline& roofline = GetDeviceRoofline(op.device);
+      outputs.push_back(strings::Printf(
+          "top %lld operation: %s (%s), %s-bound, intensity: %.2f flops/byte, "
+          "achieved: %.2f GFLOP/s %.2f GB/s, %.1f%% of roofline, "
+          "time: %s, at roofline: %s%s",
+          static_cast<long long>(i + 1), op.name.c_str(), op.op.c_str(),
+          op.ComputeBound(roofline) ? "compute" : "memory", op.intensity(),
+          op.achieved_gflops(), op.achieved_gb_per_sec(),
+          100.0 * op.RooflineFraction(roofline),
+          FormatTime(static_cast<int64>(op.seconds * 1e6)).c_str(),
+          FormatTime(static_cast<int64>((op.seconds - LostSeconds(op)) * 1e6))
+              .c_str(),
+          op.inaccurate ? " (inaccurate estimate)" : ""));
+    }
+    if (!outputs.empty()) {
+      reports_.add_reports(str_util::Join(outputs, "\n"));
+    }
+    return reports_;
+  }
+
+  static Roofline GetRoofline(
+      const AdvisorOptionsProto::CheckerOption& options, const string& device,
+      const DeviceProperties& properties) {
+    Roofline roofline;
+    // Without CUDA, the local GPU has no cores nor architecture.
+    const bool known = properties.num_cores() > 0 &&
+                       properties.frequency() > 0 &&
+                       (properties.type() == "CPU" ||
+                        (properties.type() == "GPU" &&
+                         properties.environment().count("architecture") > 0));
+    if (known) {
+      const grappler::DeviceInfo info =
+          grappler::OpLevelCostEstimator().GetDeviceInfo(properties);
+      roofline.gflops = info.gigaops;
+      roofline.gb_per_sec = info.gb_per_sec;
+    }
+    auto it = options.options().find(strings::StrCat(device, "_peak_gflops"));
+    if (it != options.options().end()) {
+      strings::safe_strtod(it->second.c_str(), &roofline.gflops);
+    }
+    it = options.options().find(strings::StrCat(device, "_peak_gb_per_sec"));
+    if (it != options.options().end()) {
+      strings::safe_strtod(it->second.c_str(), &roofline.gb_per_sec);
+    }
+    return roofline;
+  }
+
+  const Roofline& GetDeviceRoofline(const string& device) const {
+    return IsPlacedOnAccelerator(device) ? gpu_roofline_ : cpu_roofline_;
+  }
+
+  // The time the op would save per run if it ran at the roofline.
+  double LostSeconds(const RooflineOpStats& op) const {
+    const double fraction = op.RooflineFraction(GetDeviceRoofline(op.device));
+    return fraction < 1.0 ? op.seconds * (1.0 - fraction) : 0.0;
+  }
+
+  bool Analyze(const TFGraphNode* node, RooflineOpStats* op) {
+    if (node->all_op_execs().empty() || node->canonical_device().empty()) {
+      return false;
+    }
+    const Roofline& roofline = GetDeviceRoofline(node->canonical_device());
+    if (!roofline.valid()) {
+      return false;
+    }
+    // For accelerator ops, the CPU time is the launch overhead.
+    const int64 exec_micros = IsPlacedOnAccelerator(node->canonical_device())
+                                  ? node->accelerator_exec_micros(-1)
+                                  : node->cpu_exec_micros(-1);
+    if (exec_micros <= 0) {
+      return false;
+    }
+    op->name = node->name();
+    op->op = node->op();
+    op->device = node->canonical_device();
+    op->seconds =
+        exec_micros * 1e-6 / std::max<int64>(node->run_count(-1), 1);
+
+    // Estimate the costs on a device with 1 GFLOP/s and 1 GB/s, so that the
+    // estimated compute and memory times in nanoseconds are the FLOP and byte
+    // counts.
+    grappler::OpContext op_context;
+    op_context.name = node->name();
+    OpInfo* op_info = &op_context.op_info;
+    op_info->set_op(node->op());
+    *op_info->mutable_attr() = node->node().attrs();
+    op_info->mutable_device()->set_type("CPU");
+    op_info->mutable_device()->set_num_cores(1);
+    op_info->mutable_device()->set_frequency(1000);
+    op_info->mutable_device()->set_bandwidth(1000000);
+    const DataType dtype = GetDataType(node);
+    for (const auto& shape : node->input_shapes()) {
+      AddTensor(dtype, shape.second, op_info->add_inputs());
+    }
+    for (const auto& shape : node->output_shapes()) {
+      AddTensor(dtype, shape.second, op_info->add_outputs());
+    }
+    const grappler::Costs costs = estimator_.PredictCosts(op_context);
+    op->flops = costs.compute_time.count();
+    op->bytes = costs.memory_time.count();
+    op->inaccurate = costs.inaccurate;
+    return op->flops > 0 || op->bytes > 0;
+  }
+
+  static DataType GetDataType(const TFGraphNode* node) {
+    for (const char* attr : {"T", "dtype"}) {
+      const AttrValue* value = node->op_attrs(attr);
+      if (value && value->type() != DT_INVALID) {
+        return value->type();
+      }
+    }
+    return DT_FLOAT;
+  }
+
+  static void AddTensor(DataType dtype, const std::vector<int64>& shape,
+                        OpInfo::TensorProperties* tensor) {
+    tensor->set_dtype(dtype);
+    if (shape.empty()) {
+      // tfprof does not distinguish unknown shapes from scalars.
+      tensor->mutable_shape()->set_unknown_rank(true);
+      return;
+    }
+    for (int64 d : shape) {
+      tensor->mutable_shape()->add_dim()->set_size(d);
+    }
+  }
+
+  grappler::OpLevelCostEstimator estimator_;
+  Roofline cpu_roofline_;
+  Roofline gpu_roofline_;
+  AdviceProto::Checker reports_;
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_ROOFLINE_CHECKER_H_
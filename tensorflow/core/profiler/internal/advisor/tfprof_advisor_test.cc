@@ -104,5 +104,59 @@ TEST_F(TFProfAdvisorTest, ExpensiveOperationChecker) {
                                 "top 1 operation type: Conv2D"));
 }
 
+TEST(TFProfRooflineCheckerTest, RanksOpsAgainstRoofline) {
+  TFStats stats(std::unique_ptr<GraphDef>(new GraphDef()), nullptr, nullptr,
+                nullptr);
+  std::vector<std::unique_ptr<NodeDef>> node_defs;
+  auto add_node = [&](const string& name, const string& type,
+                      int64 exec_micros) {
+    node_defs.push_back(std::unique_ptr<NodeDef>(new NodeDef()));
+    NodeDef* def = node_defs.back().get();
+    def->set_name(name);
+    def->set_op(type);
+    (*def->mutable_attr())["T"].set_type(DT_FLOAT);
+    TensorShapeProto* shape =
+        (*def->mutable_attr())["_output_shapes"].mutable_list()->add_shape();
+    shape->add_dim()->set_size(256);
+    shape->add_dim()->set_size(256);
+    std::unique_ptr<TFGraphNode> node(
+        new TFGraphNode(def, -1, &stats.nodes()));
+    if (exec_micros > 0) {
+      NodeExecStats node_stat;
+      node_stat.set_all_start_micros(1);
+      node_stat.set_op_end_rel_micros(exec_micros);
+      for (const char* device :
+           {"/job:localhost/replica:0/task:0/device:GPU:0",
+            "/job:localhost/replica:0/task:0/device:GPU:0:stream:all",
+            "/job:localhost/replica:0/task:0/device:GPU:0:stream:0"}) {
+        node->AddStepStat(0, device, node_stat);
+      }
+    }
+    TFGraphNode* node_ptr = node.get();
+    stats.AddNodeForTest(0, std::move(node));
+    return node_ptr;
+  };
+  add_node("a", "Placeholder", 0);
+  add_node("b", "Placeholder", 0);
+  TFGraphNode* matmul = add_node("m", "MatMul", 100);
+  matmul->AddInput("a", 0, 0);
+  matmul->AddInput("b", 0, 1);
+
+  AdvisorOptionsProto options;
+  auto* checker_options =
+      (*options.mutable_checkers())[kCheckers[4]].mutable_options();
+  (*checker_options)["gpu_peak_gflops"] = "1000";
+  (*checker_options)["gpu_peak_gb_per_sec"] = "100";
+  AdviceProto advice = Advisor(&stats).Advise(options);
+  ASSERT_EQ(advice.checkers().at(kCheckers[4]).reports_size(), 1);
+  // 2 * 256^3 FLOPs and 3 * 256^2 * 4 bytes in 100us: 335.5 GFLOP/s at an
+  // intensity of 42.7, above the ridge point of 10.
+  const string& report = advice.checkers().at(kCheckers[4]).reports(0);
+  EXPECT_TRUE(absl::StrContains(
+      report, "top 1 operation: m (MatMul), compute-bound, intensity: 42.67"))
+      << report;
+  EXPECT_TRUE(absl::StrContains(report, "33.6% of roofline")) << report;
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
@@ -0,0 +1,354 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/internal/cpu/sampling_profiler.h"
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#define TF_HAS_SAMPLING_PROFILER 1
+#endif
+
+#ifdef TF_HAS_SAMPLING_PROFILER
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#endif
+
+#include <ctype.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/internal/profiler_interface.h"
+#include "tensorflow/core/profiler/lib/op_context.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace cpu {
+namespace {
+
+// The running profiler, if any.
+std::atomic<SamplingProfiler*> active_profiler{nullptr};
+
+// The number of signal handlers running. Stop() waits for it to drop to zero
+// after clearing active_profiler, so that no handler writes a sample after
+// Stop() returns.
+std::atomic<int> num_running_handlers{0};
+
+// Frames of TakeSample(), HandleSignal() and the signal trampoline.
+const int kSkippedFrames = 3;
+
+#ifdef TF_HAS_SAMPLING_PROFILER
+// The SIGPROF action replaced by the running profiler.
+struct sigaction previous_action;
+#endif
+
+// Async-signal-safe.
+void CopyName(const char* name, char* buffer, int size) {
+  int i = 0;
+  if (name != nullptr) {
+    for (; i < size - 1 && name[i] != '\0'; ++i) buffer[i] = name[i];
+  }
+  buffer[i] = '\0';
+}
+
+}  // namespace
+
+SamplingProfiler::SamplingProfiler(int64 period_micros, int64 max_samples)
+    : period_micros_(std::max<int64>(period_micros, 1)),
+      max_samples_(std::max<int64>(max_samples, 0)) {}
+
+SamplingProfiler::~SamplingProfiler() {
+  if (running_) {
+    Profile profile;
+    Stop(&profile).IgnoreError();
+  }
+}
+
+#ifdef TF_HAS_SAMPLING_PROFILER
+
+/*static*/ void SamplingProfiler::HandleSignal(int signal) {
+  const int saved_errno = errno;
+  num_running_handlers.fetch_add(1);
+  SamplingProfiler* profiler = active_profiler.load();
+  if (profiler != nullptr) {
+    profiler->TakeSample();
+  }
+  num_running_handlers.fetch_sub(1);
+  errno = saved_errno;
+}
+
+void SamplingProfiler::TakeSample() {
+  const int64 index = num_samples_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= max_samples_) {
+    return;
+  }
+  Sample* sample = &samples_[index];
+  sample->num_frames = backtrace(sample->frames, kMaxFrames);
+  const OpContext* context = CurrentOpContext();
+  CopyName(context->op_name.load(std::memory_order_relaxed), sample->op_name,
+           kMaxNameLength);
+  CopyName(context->dataset_iterator.load(std::memory_order_relaxed),
+           sample->dataset_iterator, kMaxNameLength);
+}
+
+Status SamplingProfiler::Start() {
+  if (running_) {
+    return errors::FailedPrecondition("SamplingProfiler already started");
+  }
+  samples_.reset(new Sample[max_samples_]);
+  num_samples_ = 0;
+  // backtrace() loads libgcc on its first call, which must not happen in the
+  // signal handler.
+  void* frames[1];
+  backtrace(frames, 1);
+
+  SamplingProfiler* expected = nullptr;
+  if (!active_profiler.compare_exchange_strong(expected, this)) {
+    samples_.reset();
+    return errors::Unavailable("Another SamplingProfiler is running");
+  }
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = &SamplingProfiler::HandleSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, &previous_action) != 0) {
+    active_profiler = nullptr;
+    samples_.reset();
+    return errors::Internal("Failed to install the SIGPROF handler: ",
+                            strerror(errno));
+  }
+  struct itimerval timer;
+  timer.it_interval.tv_sec = period_micros_ / 1000000;
+  timer.it_interval.tv_usec = period_micros_ % 1000000;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+    const int saved_errno = errno;
+    sigaction(SIGPROF, &previous_action, nullptr);
+    active_profiler = nullptr;
+    samples_.reset();
+    return errors::Internal("Failed to start sampling: ",
+                            strerror(saved_errno));
+  }
+  start_micros_ = Env::Default()->NowMicros();
+  running_ = true;
+  return Status::OK();
+}
+
+Status SamplingProfiler::Stop(Profile* profile) {
+  if (!running_) {
+    return errors::FailedPrecondition("SamplingProfiler not started");
+  }
+  struct itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  active_profiler = nullptr;
+  // A handler takes at most one backtrace, so this rarely waits at all.
+  while (num_running_handlers.load() > 0) {
+    Env::Default()->SleepForMicroseconds(10);
+  }
+  if (previous_action.sa_handler == SIG_DFL &&
+      !(previous_action.sa_flags & SA_SIGINFO)) {
+    previous_action.sa_handler = SIG_IGN;
+  }
+  sigaction(SIGPROF, &previous_action, nullptr);
+  running_ = false;
+
+  const int64 num_samples = num_samples_.load();
+  *profile = Profile();
+  profile->period_micros = period_micros_;
+  profile->start_micros = start_micros_;
+  profile->num_samples = std::min(num_samples, max_samples_);
+  profile->num_dropped_samples = num_samples - profile->num_samples;
+
+  std::map<std::pair<string, string>, OpProfile> ops;
+  for (int64 i = 0; i < profile->num_samples; ++i) {
+    const Sample& sample = samples_[i];
+    OpProfile& op = ops[{sample.op_name, sample.dataset_iterator}];
+    ++op.num_samples;
+    std::vector<uint64> stack;
+    for (int f = kSkippedFrames; f < sample.num_frames; ++f) {
+      stack.push_back(reinterpret_cast<uintptr_t>(sample.frames[f]));
+    }
+    ++op.stacks[stack];
+  }
+  samples_.reset();
+  for (auto& op : ops) {
+    op.second.op_name = op.first.first;
+    op.second.dataset_iterator = op.first.second;
+    profile->ops.push_back(std::move(op.second));
+  }
+  std::stable_sort(profile->ops.begin(), profile->ops.end(),
+                   [](const OpProfile& a, const OpProfile& b) {
+                     return a.num_samples > b.num_samples;
+                   });
+
+  Status s = ReadFileToString(Env::Default(), "/proc/self/maps",
+                              &profile->memory_map);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to read the memory map: " << s;
+  }
+  return Status::OK();
+}
+
+#else  // TF_HAS_SAMPLING_PROFILER
+
+/*static*/ void SamplingProfiler::HandleSignal(int signal) {}
+
+void SamplingProfiler::TakeSample() {}
+
+Status SamplingProfiler::Start() {
+  return errors::Unimplemented(
+      "The sampling CPU profiler is not supported on this platform");
+}
+
+Status SamplingProfiler::Stop(Profile* profile) {
+  return errors::FailedPrecondition("SamplingProfiler not started");
+}
+
+#endif  // TF_HAS_SAMPLING_PROFILER
+
+/*static*/ string SamplingProfiler::ToPprof(const Profile& profile,
+                                            const OpProfile& op) {
+  // Header: header size, version, sampling period.
+  std::vector<uintptr_t> words = {0, 3, 0,
+                                  static_cast<uintptr_t>(profile.period_micros),
+                                  0};
+  for (const auto& stack : op.stacks) {
+    words.push_back(stack.second);
+    words.push_back(stack.first.size());
+    words.insert(words.end(), stack.first.begin(), stack.first.end());
+  }
+  // Trailer.
+  words.insert(words.end(), {0, 1, 0});
+  string result(reinterpret_cast<const char*>(words.data()),
+                words.size() * sizeof(uintptr_t));
+  result.append(profile.memory_map);
+  return result;
+}
+
+namespace {
+
+// Runs a SamplingProfiler for a profiler session. Reports the number of
+// samples per op in the step stats of the "/host:CPU:sampled" device, and
+// writes a pprof profile per op into TF_CPU_SAMPLING_PROFILE_DIR, if set.
+class SamplingCpuTracer : public ProfilerInterface {
+ public:
+  SamplingCpuTracer(int64 period_micros, int64 max_samples)
+      : profiler_(period_micros, max_samples) {}
+
+  Status Start() override { return profiler_.Start(); }
+
+  Status Stop() override { return profiler_.Stop(&profile_); }
+
+  Status CollectData(RunMetadata* run_metadata) override;
+
+ private:
+  SamplingProfiler profiler_;
+  SamplingProfiler::Profile profile_;
+};
+
+string OpLabel(const SamplingProfiler::OpProfile& op) {
+  string label = op.op_name.empty() ? "(no op)" : op.op_name;
+  if (!op.dataset_iterator.empty()) {
+    strings::StrAppend(&label, " in ", op.dataset_iterator);
+  }
+  return label;
+}
+
+string ProfileFileName(int index, const SamplingProfiler::OpProfile& op) {
+  string name = strings::StrCat("cpu_", index, "_", OpLabel(op), ".prof");
+  for (char& c : name) {
+    if (!isalnum(c) && c != '.' && c != '-') c = '_';
+  }
+  return name;
+}
+
+Status SamplingCpuTracer::CollectData(RunMetadata* run_metadata) {
+  StepStatsCollector step_stats_collector(run_metadata->mutable_step_stats());
+  const string device_name = "/host:CPU:sampled";
+  for (const auto& op : profile_.ops) {
+    NodeExecStats* ns = new NodeExecStats;
+    ns->set_node_name(OpLabel(op));
+    ns->set_timeline_label(strings::StrCat(op.num_samples, " samples of ",
+                                           profile_.num_samples));
+    ns->set_all_start_micros(profile_.start_micros);
+    ns->set_all_end_rel_micros(op.num_samples * profile_.period_micros);
+    step_stats_collector.Save(device_name, ns);
+  }
+  step_stats_collector.Finalize();
+  if (profile_.num_dropped_samples > 0) {
+    LOG(WARNING) << "Dropped " << profile_.num_dropped_samples
+                 << " CPU samples; raise "
+                 << "TF_CPU_SAMPLING_PROFILER_MAX_SAMPLES to keep them.";
+  }
+
+  string profile_dir;
+  TF_RETURN_IF_ERROR(
+      ReadStringFromEnvVar("TF_CPU_SAMPLING_PROFILE_DIR", "", &profile_dir));
+  if (!profile_dir.empty()) {
+    Env* env = Env::Default();
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(profile_dir));
+    for (int i = 0; i < profile_.ops.size(); ++i) {
+      const SamplingProfiler::OpProfile& op = profile_.ops[i];
+      TF_RETURN_IF_ERROR(WriteStringToFile(
+          env, io::JoinPath(profile_dir, ProfileFileName(i, op)),
+          SamplingProfiler::ToPprof(profile_, op)));
+    }
+  }
+  profile_ = SamplingProfiler::Profile();
+  return Status::OK();
+}
+
+std::unique_ptr<ProfilerInterface> CreateSamplingCpuTracer(
+    const ProfilerContext*) {
+  int64 period_micros;
+  int64 max_samples;
+  Status s = ReadInt64FromEnvVar("TF_CPU_SAMPLING_PROFILER_PERIOD_MICROS", 0,
+                                 &period_micros);
+  if (s.ok()) {
+    s = ReadInt64FromEnvVar("TF_CPU_SAMPLING_PROFILER_MAX_SAMPLES", 20000,
+                            &max_samples);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Not sampling the CPU: " << s;
+    return nullptr;
+  }
+  if (period_micros <= 0) {
+    return nullptr;
+  }
+  return absl::make_unique<SamplingCpuTracer>(period_micros, max_samples);
+}
+
+auto register_sampling_cpu_tracer_factory = [] {
+  RegisterProfilerFactory(&CreateSamplingCpuTracer);
+  return 0;
+}();
+
+}  // namespace
+}  // namespace cpu
+}  // namespace profiler
+}  // namespace tensorflow
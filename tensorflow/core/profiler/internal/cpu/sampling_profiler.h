@@ -0,0 +1,105 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_SAMPLING_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_SAMPLING_PROFILER_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace cpu {
+
+// Samples the stacks of the threads of the process every `period_micros` of
+// CPU time that the process uses, driven by SIGPROF, and tags each sample
+// with the TF op and tf.data iterator of the sampled thread's OpContext.
+//
+// Only one SamplingProfiler can run in a process at a time. Start() replaces
+// any other SIGPROF handler and Stop() restores it, except that a default
+// disposition is restored as "ignore": a SIGPROF still in flight would
+// otherwise terminate the process. Only supported on Linux.
+class SamplingProfiler {
+ public:
+  // The samples taken while one thread ran one op in one iterator.
+  struct OpProfile {
+    // Empty when the sampled thread ran no op or iterator.
+    string op_name;
+    string dataset_iterator;
+    int64 num_samples = 0;
+    // Number of samples by stack, innermost frame first.
+    std::map<std::vector<uint64>, int64> stacks;
+  };
+
+  struct Profile {
+    int64 period_micros = 0;
+    int64 start_micros = 0;
+    int64 num_samples = 0;
+    // Samples lost because `max_samples` were already taken.
+    int64 num_dropped_samples = 0;
+    // By decreasing number of samples.
+    std::vector<OpProfile> ops;
+    // The memory map of the process, needed to symbolize the stacks.
+    string memory_map;
+  };
+
+  // Keeps at most `max_samples` samples.
+  SamplingProfiler(int64 period_micros, int64 max_samples);
+  ~SamplingProfiler();
+
+  Status Start();
+
+  // Stops sampling and aggregates the samples into `*profile`.
+  Status Stop(Profile* profile);
+
+  // Returns the samples of `op` as a CPU profile in the legacy gperftools
+  // format, which pprof reads.
+  static string ToPprof(const Profile& profile, const OpProfile& op);
+
+ private:
+  static const int kMaxFrames = 64;
+  static const int kMaxNameLength = 128;
+
+  struct Sample {
+    void* frames[kMaxFrames];
+    int num_frames;
+    char op_name[kMaxNameLength];
+    char dataset_iterator[kMaxNameLength];
+  };
+
+  static void HandleSignal(int signal);
+  TF_ATTRIBUTE_NOINLINE void TakeSample();
+
+  const int64 period_micros_;
+  const int64 max_samples_;
+  bool running_ = false;
+  int64 start_micros_ = 0;
+  std::unique_ptr<Sample[]> samples_;
+  std::atomic<int64> num_samples_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SamplingProfiler);
+};
+
+}  // namespace cpu
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_SAMPLING_PROFILER_H_
@@ -0,0 +1,135 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/internal/cpu/sampling_profiler.h"
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <signal.h>
+#include <string.h>
+#endif
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/lib/op_context.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace cpu {
+namespace {
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+// Uses about `millis` of CPU time.
+uint64 Spin(int64 millis) {
+  const uint64 end = Env::Default()->NowMicros() + millis * 1000;
+  uint64 x = 0;
+  while (Env::Default()->NowMicros() < end) {
+    for (int i = 0; i < 1000; ++i) x = x * 31 + i;
+  }
+  return x;
+}
+
+TEST(SamplingProfilerTest, TagsSamplesWithOpContext) {
+  SamplingProfiler profiler(/*period_micros=*/1000, /*max_samples=*/10000);
+  TF_ASSERT_OK(profiler.Start());
+  {
+    ScopedDatasetIteratorContext iterator_context("Iterator::Map");
+    ScopedOpContext op_context("busy_op");
+    Spin(300);
+  }
+  SamplingProfiler::Profile profile;
+  TF_ASSERT_OK(profiler.Stop(&profile));
+
+  EXPECT_EQ(1000, profile.period_micros);
+  EXPECT_GT(profile.num_samples, 0);
+  EXPECT_EQ(0, profile.num_dropped_samples);
+  // Nearly all samples are taken while the op spins.
+  ASSERT_FALSE(profile.ops.empty());
+  const SamplingProfiler::OpProfile& busy = profile.ops[0];
+  EXPECT_EQ("busy_op", busy.op_name);
+  EXPECT_EQ("Iterator::Map", busy.dataset_iterator);
+  int64 num_stack_samples = 0;
+  for (const auto& stack : busy.stacks) {
+    num_stack_samples += stack.second;
+  }
+  EXPECT_EQ(busy.num_samples, num_stack_samples);
+
+  // The pprof profile starts with its header and the sampling period.
+  const string pprof = SamplingProfiler::ToPprof(profile, busy);
+  ASSERT_GT(pprof.size(), 5 * sizeof(uintptr_t));
+  const uintptr_t* words = reinterpret_cast<const uintptr_t*>(pprof.data());
+  EXPECT_EQ(0, words[0]);
+  EXPECT_EQ(3, words[1]);
+  EXPECT_EQ(1000, words[3]);
+}
+
+TEST(SamplingProfilerTest, OnlyOneProfilerRuns) {
+  SamplingProfiler first(1000, 100);
+  SamplingProfiler second(1000, 100);
+  TF_ASSERT_OK(first.Start());
+  EXPECT_TRUE(errors::IsUnavailable(second.Start()));
+  SamplingProfiler::Profile profile;
+  TF_ASSERT_OK(first.Stop(&profile));
+  TF_ASSERT_OK(second.Start());
+  TF_ASSERT_OK(second.Stop(&profile));
+}
+
+TEST(SamplingProfilerTest, DropsSamplesBeyondMax) {
+  SamplingProfiler profiler(/*period_micros=*/1000, /*max_samples=*/5);
+  TF_ASSERT_OK(profiler.Start());
+  Spin(100);
+  SamplingProfiler::Profile profile;
+  TF_ASSERT_OK(profiler.Stop(&profile));
+  EXPECT_EQ(5, profile.num_samples);
+  EXPECT_GT(profile.num_dropped_samples, 0);
+}
+
+void OtherSigprofHandler(int signal) {}
+
+TEST(SamplingProfilerTest, RestoresPreviousHandler) {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = &OtherSigprofHandler;
+  sigemptyset(&action.sa_mask);
+  struct sigaction original;
+  ASSERT_EQ(0, sigaction(SIGPROF, &action, &original));
+
+  SamplingProfiler profiler(1000, 100);
+  TF_ASSERT_OK(profiler.Start());
+  struct sigaction current;
+  ASSERT_EQ(0, sigaction(SIGPROF, nullptr, &current));
+  EXPECT_NE(&OtherSigprofHandler, current.sa_handler);
+  SamplingProfiler::Profile profile;
+  TF_ASSERT_OK(profiler.Stop(&profile));
+  ASSERT_EQ(0, sigaction(SIGPROF, nullptr, &current));
+  EXPECT_EQ(&OtherSigprofHandler, current.sa_handler);
+
+  ASSERT_EQ(0, sigaction(SIGPROF, &original, nullptr));
+}
+
+#else
+
+TEST(SamplingProfilerTest, Unimplemented) {
+  SamplingProfiler profiler(1000, 100);
+  EXPECT_TRUE(errors::IsUnimplemented(profiler.Start()));
+}
+
+#endif
+
+}  // namespace
+}  // namespace cpu
+}  // namespace profiler
+}  // namespace tensorflow
@@ -366,7 +366,7 @@ class TFGraphNode {
   const string& name() const { return node_.name(); }
   int64 id() const { return node_.id(); }
   const string& op() const { return node_.op(); }
-  const ProfileNode& node() { return node_; }
+  const ProfileNode& node() const { return node_; }
 
   bool trackable(int64 step) const {
     auto exec = execs_.find(step);
@@ -0,0 +1,43 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/op_context.h"
+
+namespace tensorflow {
+namespace profiler {
+
+namespace {
+
+// The context is read from the SIGPROF handler of the sampling profiler. With
+// the initial-exec model it lives in the static TLS block of each thread, so
+// the first access on a thread does not allocate, which would not be
+// async-signal-safe. OpContext is constant-initialized, so no initialization
+// guard runs either.
+#if defined(__GNUC__) && !defined(_WIN32)
+#define TF_OP_CONTEXT_TLS_MODEL __attribute__((tls_model("initial-exec")))
+#else
+#define TF_OP_CONTEXT_TLS_MODEL
+#endif
+
+thread_local OpContext current_op_context TF_OP_CONTEXT_TLS_MODEL;
+
+#undef TF_OP_CONTEXT_TLS_MODEL
+
+}  // namespace
+
+OpContext* CurrentOpContext() { return &current_op_context; }
+
+}  // namespace profiler
+}  // namespace tensorflow
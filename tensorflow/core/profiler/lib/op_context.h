@@ -0,0 +1,83 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_OP_CONTEXT_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_OP_CONTEXT_H_
+
+#include <atomic>
+
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// The TF op and the tf.data iterator that a thread is running. The sampling
+// CPU profiler tags the samples it takes from a signal handler with them, so
+// the fields are atomics, and the strings they point to must stay alive while
+// the thread is in the scope that set them.
+struct OpContext {
+  std::atomic<const char*> op_name{nullptr};
+  std::atomic<const char*> dataset_iterator{nullptr};
+};
+
+// Returns the context of the current thread.
+OpContext* CurrentOpContext();
+
+// Sets the op of the current thread's context while in scope. Scopes nest.
+class ScopedOpContext {
+ public:
+  explicit ScopedOpContext(const char* op_name)
+      : context_(CurrentOpContext()),
+        last_op_name_(context_->op_name.load(std::memory_order_relaxed)) {
+    context_->op_name.store(op_name, std::memory_order_relaxed);
+  }
+  ~ScopedOpContext() {
+    context_->op_name.store(last_op_name_, std::memory_order_relaxed);
+  }
+
+ private:
+  OpContext* const context_;
+  const char* const last_op_name_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedOpContext);
+};
+
+// Sets the tf.data iterator of the current thread's context while in scope.
+// Scopes nest.
+class ScopedDatasetIteratorContext {
+ public:
+  explicit ScopedDatasetIteratorContext(const char* iterator_prefix)
+      : context_(CurrentOpContext()),
+        last_iterator_(
+            context_->dataset_iterator.load(std::memory_order_relaxed)) {
+    context_->dataset_iterator.store(iterator_prefix,
+                                     std::memory_order_relaxed);
+  }
+  ~ScopedDatasetIteratorContext() {
+    context_->dataset_iterator.store(last_iterator_,
+                                     std::memory_order_relaxed);
+  }
+
+ private:
+  OpContext* const context_;
+  const char* const last_iterator_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedDatasetIteratorContext);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_OP_CONTEXT_H_
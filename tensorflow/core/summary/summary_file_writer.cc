@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/summary/summary_file_writer.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/summary/summary_converter.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -21,19 +23,40 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
 namespace {
 
+auto* write_latency = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/summary/file_writer/write_latency",
+     "Distribution of wall time (in microseconds) spent appending a batch of "
+     "summary events to the events file and flushing it."},
+    // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+    monitoring::Buckets::Exponential(10, 1.8, 33));
+auto* dropped_events = monitoring::Counter<0>::New(
+    "/tensorflow/core/summary/file_writer/dropped_events",
+    "The number of summary events dropped because too many events were "
+    "waiting to be written.");
+
+// Events are appended to the events file by a background thread, so that
+// summary ops never wait for the (possibly remote) file system. The thread
+// writes the queued events once more than max_queue are waiting, and at
+// least every flush_millis.
 class SummaryFileWriter : public SummaryWriterInterface {
  public:
-  SummaryFileWriter(int max_queue, int flush_millis, Env* env)
+  SummaryFileWriter(const SummaryFileWriterOptions& options, Env* env)
       : SummaryWriterInterface(),
         is_initialized_(false),
-        max_queue_(max_queue),
-        flush_millis_(flush_millis),
+        max_queue_(std::max(options.max_queue, 0)),
+        flush_millis_(options.flush_millis),
+        max_pending_events_(
+            std::max<size_t>(options.max_pending_events, max_queue_ + 1)),
+        drop_when_full_(options.drop_when_full),
         env_(env) {}
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
@@ -44,27 +67,45 @@ class SummaryFileWriter : public SummaryWriterInterface {
       }
       TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(logdir));
     }
-    mutex_lock ml(mu_);
-    events_writer_ =
-        tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(
-        events_writer_->InitWithSuffix(filename_suffix),
-        "Could not initialize events writer.");
-    last_flush_ = env_->NowMicros();
+    {
+      mutex_lock ml(write_mu_);
+      events_writer_ =
+          tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
+      TF_RETURN_WITH_CONTEXT_IF_ERROR(
+          events_writer_->InitWithSuffix(filename_suffix),
+          "Could not initialize events writer.");
+    }
     is_initialized_ = true;
+    writer_thread_.reset(env_->StartThread(ThreadOptions(),
+                                           "summary_file_writer",
+                                           [this]() { WriterLoop(); }));
     return Status::OK();
   }
 
+  // Writes all queued events on the calling thread, and returns the first
+  // error of any write since the last Flush().
   Status Flush() override {
-    mutex_lock ml(mu_);
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
-    return InternalFlush();
+    const Status s = WriteQueuedEvents();
+    mutex_lock ml(mu_);
+    Status status = status_;
+    status_ = Status::OK();
+    status.Update(s);
+    return status;
   }
 
   ~SummaryFileWriter() override {
-    (void)Flush();  // Ignore errors.
+    if (writer_thread_ != nullptr) {
+      {
+        mutex_lock ml(mu_);
+        stopping_ = true;
+        queue_cv_.notify_one();
+      }
+      // Joins the thread, which writes the remaining events first.
+      writer_thread_.reset();
+    }
   }
 
   Status WriteTensor(int64 global_step, Tensor t, const string& tag,
@@ -140,11 +181,19 @@ class SummaryFileWriter : public SummaryWriterInterface {
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
+    while (queue_.size() >= max_pending_events_) {
+      if (drop_when_full_) {
+        dropped_events->GetCell()->IncrementBy(1);
+        return Status::OK();
+      }
+      space_cv_.wait(ml);
+    }
     queue_.emplace_back(std::move(event));
-    if (queue_.size() > max_queue_ ||
-        env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
+    if (queue_.size() > max_queue_) {
+      queue_cv_.notify_one();
     }
+    // Errors of the writer thread are returned by the next Flush() only, so
+    // that each is reported once.
     return Status::OK();
   }
 
@@ -155,28 +204,72 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
+  void WriterLoop() {
+    while (true) {
+      bool stopping;
+      {
+        mutex_lock ml(mu_);
+        if (!stopping_ && queue_.size() <= max_queue_) {
+          WaitForMilliseconds(&ml, &queue_cv_, std::max(flush_millis_, 1));
+        }
+        stopping = stopping_;
+      }
+      const Status s = WriteQueuedEvents();
+      if (!s.ok()) {
+        LOG(WARNING) << "Could not write summary events: " << s;
+        mutex_lock ml(mu_);
+        status_.Update(s);
+      }
+      if (stopping) return;
+    }
+  }
+
+  // Takes the queued events and appends them to the events file. Batches are
+  // written in the order they were queued since `write_mu_` is held while
+  // taking them.
+  Status WriteQueuedEvents() LOCKS_EXCLUDED(mu_, write_mu_) {
+    mutex_lock wl(write_mu_);
+    std::vector<std::unique_ptr<Event>> events;
+    {
+      mutex_lock ml(mu_);
+      events.swap(queue_);
+      space_cv_.notify_all();
+    }
+    if (events.empty()) {
+      return Status::OK();
+    }
+    const uint64 start_micros = env_->NowMicros();
+    for (const std::unique_ptr<Event>& e : events) {
       events_writer_->WriteEvent(*e);
     }
-    queue_.clear();
     TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
                                     "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
+    write_latency->GetCell()->Add(env_->NowMicros() - start_micros);
     return Status::OK();
   }
 
   bool is_initialized_;
-  const int max_queue_;
+  const size_t max_queue_;
   const int flush_millis_;
-  uint64 last_flush_;
+  const size_t max_pending_events_;
+  const bool drop_when_full_;
   Env* env_;
   mutex mu_;
+  // Signalled when the writer thread should write the queue.
+  condition_variable queue_cv_;
+  // Signalled when the queue has room for more events.
+  condition_variable space_cv_;
   std::vector<std::unique_ptr<Event>> queue_ GUARDED_BY(mu_);
+  // The first error of the writer thread since the last Flush().
+  Status status_ GUARDED_BY(mu_);
+  bool stopping_ GUARDED_BY(mu_) = false;
+  // Serializes writes to the events file. Acquired before `mu_`.
+  mutex write_mu_ ACQUIRED_BEFORE(mu_);
   // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ GUARDED_BY(mu_);
+  std::unique_ptr<EventsWriter> events_writer_ GUARDED_BY(write_mu_);
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       GUARDED_BY(mu_);
+  std::unique_ptr<Thread> writer_thread_;
 };
 
 }  // namespace
@@ -185,7 +278,21 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result) {
-  SummaryFileWriter* w = new SummaryFileWriter(max_queue, flush_millis, env);
+  SummaryFileWriterOptions options;
+  options.max_queue = max_queue;
+  options.flush_millis = flush_millis;
+  return CreateSummaryFileWriter(options, logdir, filename_suffix, env, result);
+}
+
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryWriterInterface** result) {
+  if (options.max_pending_events < 0) {
+    return errors::InvalidArgument("max_pending_events must be >= 0, got ",
+                                   options.max_pending_events);
+  }
+  SummaryFileWriter* w = new SummaryFileWriter(options, env);
   const Status s = w->Initialize(logdir, filename_suffix);
   if (!s.ok()) {
     w->Unref();
@@ -22,22 +22,44 @@ limitations under the License.
 
 namespace tensorflow {
 
+/// \brief Options of a SummaryWriterInterface that writes to a file.
+struct SummaryFileWriterOptions {
+  /// Events are written once more than this many are queued.
+  int max_queue = 10;
+  /// Queued events are written at least this often.
+  int flush_millis = 10000;
+  /// At most this many events wait to be written, and at least
+  /// max_queue + 1. Must not be negative.
+  int max_pending_events = 1000;
+  /// When max_pending_events are waiting, drop new events instead of
+  /// blocking the writing op until the writer thread catches up.
+  bool drop_when_full = false;
+};
+
 /// \brief Creates SummaryWriterInterface which writes to a file.
 ///
 /// The file is an append-only records file of tf.Event protos. That
 /// makes this summary writer suitable for file systems like GCS.
 ///
 /// It will enqueue up to max_queue summaries, and flush at least every
-/// flush_millis milliseconds. The summaries will be written to the
-/// directory specified by logdir and with the filename suffixed by
-/// filename_suffix. The caller owns a reference to result if the
-/// returned status is ok. The Env object must not be destroyed until
+/// flush_millis milliseconds. Writes happen on a background thread, so
+/// writing a summary does not wait for the file system, and write errors are
+/// returned by the next Flush() rather than by the writes. The summaries will
+/// be written to the directory specified by logdir and with the filename
+/// suffixed by filename_suffix. The caller owns a reference to result if
+/// the returned status is ok. The Env object must not be destroyed until
 /// after the returned writer.
 Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result);
 
+/// \brief Like CreateSummaryFileWriter() above, with all options.
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryWriterInterface** result);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_SUMMARY_SUMMARY_FILE_WRITER_H_
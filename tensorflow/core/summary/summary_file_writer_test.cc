@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
@@ -39,8 +40,48 @@ class FakeClockEnv : public EnvWrapper {
   uint64 current_millis_;
 };
 
+// Holds back the threads it starts until Release() is called, so that the
+// writer thread cannot drain the queue.
+class HeldThreadEnv : public EnvWrapper {
+ public:
+  HeldThreadEnv() : EnvWrapper(Env::Default()) {}
+  Thread* StartThread(const ThreadOptions& thread_options, const string& name,
+                      std::function<void()> fn) override {
+    return EnvWrapper::StartThread(thread_options, name, [this, fn]() {
+      release_.WaitForNotification();
+      fn();
+    });
+  }
+  void Release() { release_.Notify(); }
+
+ private:
+  Notification release_;
+};
+
 class SummaryFileWriterTest : public ::testing::Test {
  protected:
+  // Returns the number of events written to the file of `test_name`, not
+  // counting the file version.
+  int CountEvents(const string& test_name) {
+    std::vector<string> files;
+    TF_CHECK_OK(env_.GetChildren(testing::TmpDir(), &files));
+    int num_events = 0;
+    for (const string& f : files) {
+      if (!absl::StrContains(f, test_name)) continue;
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env_.NewRandomAccessFile(
+          io::JoinPath(testing::TmpDir(), f), &read_file));
+      io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+      string record;
+      uint64 offset = 0;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      while (reader.ReadRecord(&offset, &record).ok()) {
+        ++num_events;
+      }
+    }
+    return num_events;
+  }
+
   Status SummaryTestHelper(
       const string& test_name,
       const std::function<Status(SummaryWriterInterface*)>& writer_fn,
@@ -217,6 +258,110 @@ TEST_F(SummaryFileWriterTest, WriteEvent) {
                         }));
 }
 
+TEST_F(SummaryFileWriterTest, WritesQueuedEventsWhenDestroyed) {
+  const string test_name = "destroyed_test";
+  SummaryFileWriterOptions options;
+  options.max_queue = 100;
+  options.flush_millis = 1000000;
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(options, testing::TmpDir(), test_name,
+                                      &env_, &writer));
+  for (int i = 0; i < 3; ++i) {
+    std::unique_ptr<Event> e{new Event};
+    e->set_step(i);
+    TF_CHECK_OK(writer->WriteEvent(std::move(e)));
+  }
+  writer->Unref();
+
+  std::vector<string> files;
+  TF_CHECK_OK(env_.GetChildren(testing::TmpDir(), &files));
+  int num_files = 0;
+  for (const string& f : files) {
+    if (!absl::StrContains(f, test_name)) continue;
+    ++num_files;
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env_.NewRandomAccessFile(io::JoinPath(testing::TmpDir(), f),
+                                         &read_file));
+    io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+    string record;
+    uint64 offset = 0;
+    // The first event is the file version.
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    for (int i = 0; i < 3; ++i) {
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      Event e;
+      e.ParseFromString(record);
+      EXPECT_EQ(e.step(), i);
+    }
+  }
+  EXPECT_EQ(num_files, 1);
+}
+
+TEST_F(SummaryFileWriterTest, DropsEventsWhenFull) {
+  const string test_name = "drop_test";
+  HeldThreadEnv env;
+  SummaryFileWriterOptions options;
+  options.max_queue = 1;
+  options.flush_millis = 1000000;
+  options.max_pending_events = 2;
+  options.drop_when_full = true;
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(options, testing::TmpDir(), test_name,
+                                      &env, &writer));
+  // The writer thread is held back, so only the first two events fit.
+  for (int i = 0; i < 5; ++i) {
+    std::unique_ptr<Event> e{new Event};
+    e->set_step(i);
+    TF_CHECK_OK(writer->WriteEvent(std::move(e)));
+  }
+  TF_CHECK_OK(writer->Flush());
+  env.Release();
+  writer->Unref();
+  EXPECT_EQ(2, CountEvents(test_name));
+}
+
+TEST_F(SummaryFileWriterTest, BlocksWhenFull) {
+  const string test_name = "blocking_test";
+  HeldThreadEnv env;
+  SummaryFileWriterOptions options;
+  options.max_queue = 1;
+  options.flush_millis = 1000000;
+  options.max_pending_events = 2;
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(options, testing::TmpDir(), test_name,
+                                      &env, &writer));
+  for (int i = 0; i < 2; ++i) {
+    std::unique_ptr<Event> e{new Event};
+    e->set_step(i);
+    TF_CHECK_OK(writer->WriteEvent(std::move(e)));
+  }
+  Notification written;
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "write_event", [writer, &written]() {
+        std::unique_ptr<Event> e{new Event};
+        e->set_step(2);
+        TF_CHECK_OK(writer->WriteEvent(std::move(e)));
+        written.Notify();
+      }));
+  Env::Default()->SleepForMicroseconds(100000);
+  EXPECT_FALSE(written.HasBeenNotified());
+  // Writing the queue makes room for the blocked event.
+  TF_CHECK_OK(writer->Flush());
+  written.WaitForNotification();
+  thread.reset();
+  env.Release();
+  writer->Unref();
+  EXPECT_EQ(3, CountEvents(test_name));
+}
+
+TEST_F(SummaryFileWriterTest, NegativeMaxPendingEvents) {
+  SummaryFileWriterOptions options;
+  options.max_pending_events = -1;
+  SummaryWriterInterface* writer;
+  EXPECT_TRUE(errors::IsInvalidArgument(CreateSummaryFileWriter(
+      options, testing::TmpDir(), "negative_test", &env_, &writer)));
+}
+
 TEST_F(SummaryFileWriterTest, WallTime) {
   env_.AdvanceByMillis(7023);
   TF_CHECK_OK(SummaryTestHelper(
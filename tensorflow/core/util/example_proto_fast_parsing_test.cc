@@ -422,6 +422,24 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+// Parses a batch of `num_examples` examples with a mix of dense, varlen and
+// sparse features.
+static void BM_FastParseExample(int iters, int num_examples) {
+  testing::StopTiming();
+  std::vector<string> serialized(num_examples, ExampleWithSomeFeatures());
+  FastParseExampleConfig config;
+  AddDenseFeature("bytes_list", DT_STRING, {2}, false, 2, &config);
+  AddDenseFeature("float_list", DT_FLOAT, {-1}, true, 1, &config);
+  AddSparseFeature("int64_list", DT_INT64, &config);
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_examples);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    Result result;
+    TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  }
+}
+BENCHMARK(BM_FastParseExample)->Arg(1)->Arg(128)->Arg(1024);
+
 }  // namespace
 }  // namespace example
 }  // namespace tensorflow
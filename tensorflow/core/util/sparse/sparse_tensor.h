@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_SPARSE_SPARSE_TENSOR_H_
 #define TENSORFLOW_CORE_UTIL_SPARSE_SPARSE_TENSOR_H_
 
+#include <algorithm>
 #include <limits>
 #include <numeric>
 #include <vector>
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/overflow.h"
 #include "tensorflow/core/util/sparse/dim_comparator.h"
 #include "tensorflow/core/util/sparse/group_iterator.h"
 
@@ -257,6 +259,14 @@ class SparseTensor {
   }
 
  private:
+  // Sorts `reorder`, the positions of the entries, by their indices in
+  // `order` with a radix sort of the indices linearized in the dense shape.
+  // Returns false, leaving `reorder` untouched, if the dense shape has more
+  // elements than fit in an int64 or some index is out of bounds; the
+  // comparator sort handles those.
+  bool RadixSortEntries(const VarDimArray& order,
+                        std::vector<int64>* reorder) const;
+
   static Status GetDimsFromIx(const Tensor& ix, int* result) {
     if (!TensorShapeUtils::IsMatrix(ix.shape())) {
       return Status(error::INVALID_ARGUMENT,
@@ -373,9 +383,62 @@ class SparseTensor {
   int dims_;
 };
 
+inline bool SparseTensor::RadixSortEntries(const VarDimArray& order,
+                                           std::vector<int64>* reorder) const {
+  // The stride of each dimension of `order` in the linearized index.
+  ShapeArray strides(dims_);
+  int64 num_elements = 1;
+  for (int d = dims_ - 1; d >= 0; --d) {
+    if (shape_[order[d]] < 0) return false;
+    strides[d] = num_elements;
+    num_elements = MultiplyWithoutOverflow(num_elements, shape_[order[d]]);
+    if (num_elements < 0) return false;
+  }
+
+  auto ix_t = ix_.matrix<int64>();
+  const int64 N = num_entries();
+  std::vector<uint64> keys(N);
+  uint64 max_key = 0;
+  for (int64 n = 0; n < N; ++n) {
+    int64 key = 0;
+    for (int d = 0; d < dims_; ++d) {
+      const int64 index = ix_t((*reorder)[n], order[d]);
+      if (index < 0 || index >= shape_[order[d]]) return false;
+      key += index * strides[d];
+    }
+    keys[n] = key;
+    max_key = std::max<uint64>(max_key, key);
+  }
+
+  // Stable counting sorts from the least significant digit, skipping the
+  // digits that are zero in all keys.
+  constexpr int kRadixBits = 8;
+  constexpr int kRadix = 1 << kRadixBits;
+  std::vector<uint64> sorted_keys(N);
+  std::vector<int64> sorted(N);
+  for (int shift = 0; shift < 64 && (max_key >> shift) != 0;
+       shift += kRadixBits) {
+    int64 offsets[kRadix + 1] = {};
+    for (int64 n = 0; n < N; ++n) {
+      ++offsets[((keys[n] >> shift) & (kRadix - 1)) + 1];
+    }
+    for (int i = 0; i < kRadix; ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+    for (int64 n = 0; n < N; ++n) {
+      const int64 to = offsets[(keys[n] >> shift) & (kRadix - 1)]++;
+      sorted_keys[to] = keys[n];
+      sorted[to] = (*reorder)[n];
+    }
+    keys.swap(sorted_keys);
+    reorder->swap(sorted);
+  }
+  return true;
+}
+
 // This operation updates the indices and values Tensor rows, so it is
-// an in-place algorithm.  It requires O(N log N) time and O(N)
-// temporary space.
+// an in-place algorithm.  It requires O(N) time when the dense shape fits
+// in an int64, O(N log N) time otherwise, and O(N) temporary space.
 template <typename T>
 void SparseTensor::Reorder(const VarDimArray& order) {
   DCHECK_EQ(DataTypeToEnum<T>::v(), dtype())
@@ -388,23 +451,25 @@ void SparseTensor::Reorder(const VarDimArray& order) {
   std::iota(reorder.begin(), reorder.end(), 0);
 
   // Sort to get order of indices
-  switch (order.size()) {
+  if (!RadixSortEntries(order, &reorder)) {
+    switch (order.size()) {
 #define CASE_SORT(ORDER_SIZE)                                    \
   case ORDER_SIZE: {                                             \
     FixedDimComparator<ORDER_SIZE> sorter(ix_t, order, shape()); \
     std::sort(reorder.begin(), reorder.end(), sorter);           \
     break;                                                       \
   }
-    CASE_SORT(0);
-    CASE_SORT(1);
-    CASE_SORT(2);
-    CASE_SORT(3);
-    CASE_SORT(4);
-    CASE_SORT(5);
+      CASE_SORT(0);
+      CASE_SORT(1);
+      CASE_SORT(2);
+      CASE_SORT(3);
+      CASE_SORT(4);
+      CASE_SORT(5);
 #undef CASE_SORT
-    default: {
-      DimComparator sorter(ix_t, order, shape());
-      std::sort(reorder.begin(), reorder.end(), sorter);
+      default: {
+        DimComparator sorter(ix_t, order, shape());
+        std::sort(reorder.begin(), reorder.end(), sorter);
+      }
     }
   }
 
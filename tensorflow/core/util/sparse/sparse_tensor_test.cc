@@ -266,6 +266,29 @@ TEST(SparseTensorTest, SortingWorksCorrectly) {
   }
 }
 
+TEST(SparseTensorTest, SortingWorksForShapesLargerThanInt64) {
+  // The dense shape has 2^90 elements, so the indices can't be linearized.
+  int N = 30;
+  const int NDIM = 3;
+
+  Tensor ix(DT_INT64, TensorShape({N, NDIM}));
+  Tensor vals(DT_STRING, TensorShape({N}));
+  const std::vector<int64> shape{1LL << 30, 1LL << 30, 1LL << 30};
+  SparseTensor st;
+  TF_ASSERT_OK(SparseTensor::Create(ix, vals, shape, &st));
+
+  auto ix_t = ix.matrix<int64>();
+
+  for (int n = 0; n < 10; ++n) {
+    ix_t = ix_t.random(Eigen::internal::UniformRandomGenerator<int64>(n + 1));
+    ix_t = ix_t.abs() % (1LL << 30);
+    st.Reorder<string>({0, 1, 2});
+    TF_EXPECT_OK(st.IndicesValid());
+    st.Reorder<string>({2, 0, 1});
+    TF_EXPECT_OK(st.IndicesValid());
+  }
+}
+
 TEST(SparseTensorTest, ValidateIndicesFindsInvalid) {
   int N = 2;
   const int NDIM = 3;
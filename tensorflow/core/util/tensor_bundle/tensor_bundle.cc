@@ -17,10 +17,13 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb_text.h"
@@ -35,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/lib/bfloat16/bfloat16.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
@@ -55,6 +59,15 @@ const int kTensorBundleVersion = 1;
 // Size of our input buffer for streaming reads
 static const int kBufferSize = 1024 * 1024;
 
+// Limits for merging the reads of neighboring tensors in LookupMany(): the
+// largest gap (e.g. alignment padding) read and discarded between two tensors,
+// and the largest single read.
+static const int64 kMaxCoalescedGap = 4096;
+static const int64 kMaxCoalescedRead = 16 * 1024 * 1024;
+// The most bytes LookupMany() reads with one ReadV(), unless a single tensor
+// is larger. Bounds the scratch memory held at a time.
+static const int64 kMaxReadVBytes = 64 * 1024 * 1024;
+
 // Key to the special BundleHeaderProto entry.  Do not change this, as clients
 // can make the assumption that the header is always the first entry in the
 // bundle.
@@ -714,9 +727,53 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 
 // Interface for reading a tensor bundle.
 
-BundleReader::BundleReader(Env* env, StringPiece prefix)
+// A memory-mapped data file, kept alive by the reader and by the tensors that
+// alias it.
+class BundleReader::MappedFile : public core::RefCounted {
+ public:
+  explicit MappedFile(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : region_(std::move(region)) {}
+
+  const char* data() const { return static_cast<const char*>(region_->data()); }
+  uint64 length() const { return region_->length(); }
+
+ private:
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+namespace {
+
+// A read-only TensorBuffer over a range of a memory-mapped data file.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(core::RefCounted* file, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), file_(file), size_(size) {
+    file_->Ref();
+  }
+  ~MappedTensorBuffer() override { file_->Unref(); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mmap");
+  }
+  // The mapping is read-only, so the buffer must never be forwarded to an
+  // output and written to.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  core::RefCounted* const file_;
+  const size_t size_;
+};
+
+}  // namespace
+
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(prefix),
+      options_(options),
       metadata_(nullptr),
       table_(nullptr),
       iter_(nullptr) {
@@ -770,6 +827,9 @@ BundleReader::~BundleReader() {
     }
   }
   gtl::STLDeleteValues(&data_);
+  for (auto pair : mapped_data_) {
+    if (pair.second != nullptr) pair.second->Unref();
+  }
   gtl::STLDeleteValues(&tensor_slices_);
 }
 
@@ -794,10 +854,81 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return Status::OK();
 }
 
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry,
+                                    Tensor* val, bool* mapped) {
+  *mapped = false;
+  auto it = mapped_data_.find(entry.shard_id());
+  if (it == mapped_data_.end()) {
+    const string filename =
+        DataFilename(prefix_, entry.shard_id(), num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    if (!s.ok()) {
+      // Not all file systems support memory mapping; read the file instead.
+      VLOG(1) << "Not memory-mapping " << filename << ": " << s;
+    }
+    it = mapped_data_
+             .emplace(entry.shard_id(),
+                      s.ok() ? new MappedFile(std::move(region)) : nullptr)
+             .first;
+  }
+  MappedFile* file = it->second;
+  if (file == nullptr) return Status::OK();
+
+  if (entry.offset() < 0 || entry.size() < 0 ||
+      static_cast<uint64>(entry.offset() + entry.size()) > file->length()) {
+    return errors::DataLoss("Entry for key ", key(), " at offset ",
+                            entry.offset(), " with size ", entry.size(),
+                            " is out of the bounds of its data file of size ",
+                            file->length());
+  }
+  const char* data = file->data() + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment !=
+      0) {
+    return Status::OK();
+  }
+
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  TensorBuffer* buf = new MappedTensorBuffer(file, data, entry.size());
+  *val = Tensor(entry.dtype(), TensorShape(entry.shape()), buf);
+  buf->Unref();
+  *mapped = true;
+  return Status::OK();
+}
+
+Status BundleReader::GetDataFile(int32 shard_id,
+                                 io::InputBuffer** buffered_file) {
+  // Open the data file if it has not been opened.
+  io::InputBuffer*& file_buffer = data_[shard_id];
+  if (file_buffer == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    // The InputBuffer and RandomAccessFile objects are both released in dtor.
+    file_buffer = new io::InputBuffer(file.release(), kBufferSize);
+  }
+  *buffered_file = file_buffer;
+  return Status::OK();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
+    if (options_.memory_map_data && DataTypeCanUseMemcpy(entry.dtype()) &&
+        entry.size() == stored_shape.num_elements() *
+                            DataTypeSize(entry.dtype()) &&
+        entry.size() > 0) {
+      bool mapped;
+      TF_RETURN_IF_ERROR(GetMappedValue(entry, val, &mapped));
+      if (mapped) return Status::OK();
+    }
     ret = new Tensor(entry.dtype(), stored_shape);
   }
 
@@ -823,18 +954,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
-
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
 
@@ -891,6 +1012,119 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMany(gtl::ArraySlice<string> keys,
+                                gtl::ArraySlice<Tensor*> vals) {
+  CHECK_EQ(keys.size(), vals.size());
+  struct Pending {
+    size_t index;
+    BundleEntryProto entry;
+  };
+  std::vector<Pending> pending;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    CHECK(vals[i] != nullptr);
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], &entry));
+    const bool can_coalesce =
+        entry.slices().empty() && DataTypeCanUseMemcpy(entry.dtype()) &&
+        entry.size() <= kBufferSize &&
+        !(options_.memory_map_data && vals[i]->NumElements() == 0);
+    if (!can_coalesce) {
+      TF_RETURN_IF_ERROR(Lookup(keys[i], vals[i]));
+      continue;
+    }
+    if (vals[i]->NumElements() == 0) {
+      *vals[i] = Tensor(entry.dtype(), TensorShape(entry.shape()));
+    }
+    if (entry.size() != vals[i]->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry.size(),
+                              "; expected size ", vals[i]->TotalBytes());
+    }
+    pending.push_back({i, std::move(entry)});
+  }
+
+  // Read the remaining tensors in file order, merging the reads of tensors
+  // that are (nearly) adjacent in the same data file. The merged reads of a
+  // data file are issued together, up to kMaxReadVBytes at a time, which
+  // remote filesystems can serve in parallel.
+  std::sort(pending.begin(), pending.end(),
+            [](const Pending& a, const Pending& b) {
+              return std::make_pair(a.entry.shard_id(), a.entry.offset()) <
+                     std::make_pair(b.entry.shard_id(), b.entry.offset());
+            });
+  for (size_t shard_begin = 0; shard_begin < pending.size();) {
+    const int32 shard_id = pending[shard_begin].entry.shard_id();
+    // [begin, end) ranges of `pending` read together.
+    std::vector<std::pair<size_t, size_t>> runs;
+    std::vector<RandomAccessFile::ReadRange> ranges;
+    int64 batch_bytes = 0;
+    size_t begin = shard_begin;
+    while (begin < pending.size() &&
+           pending[begin].entry.shard_id() == shard_id) {
+      const BundleEntryProto& first = pending[begin].entry;
+      int64 end_offset = first.offset() + first.size();
+      size_t end = begin + 1;
+      while (end < pending.size()) {
+        const BundleEntryProto& next = pending[end].entry;
+        if (next.shard_id() != first.shard_id() ||
+            next.offset() < end_offset ||
+            next.offset() - end_offset > kMaxCoalescedGap ||
+            next.offset() + next.size() - first.offset() > kMaxCoalescedRead) {
+          break;
+        }
+        end_offset = next.offset() + next.size();
+        ++end;
+      }
+      const int64 run_bytes = end_offset - first.offset();
+      if (!ranges.empty() && batch_bytes + run_bytes > kMaxReadVBytes) {
+        // Read the run with the next batch.
+        break;
+      }
+      batch_bytes += run_bytes;
+      runs.emplace_back(begin, end);
+      RandomAccessFile::ReadRange range;
+      range.offset = first.offset();
+      range.n = run_bytes;
+      ranges.push_back(range);
+      begin = end;
+    }
+
+    std::vector<string> scratch(ranges.size());
+    for (size_t j = 0; j < ranges.size(); ++j) {
+      scratch[j].resize(ranges[j].n);
+      ranges[j].scratch = &scratch[j][0];
+    }
+    io::InputBuffer* buffered_file;
+    TF_RETURN_IF_ERROR(GetDataFile(shard_id, &buffered_file));
+    TF_RETURN_IF_ERROR(buffered_file->file()->ReadV(&ranges));
+
+    for (size_t j = 0; j < runs.size(); ++j) {
+      const StringPiece sp = ranges[j].result;
+      if (sp.size() != ranges[j].n) {
+        return errors::DataLoss("Requested ", ranges[j].n, " bytes but read ",
+                                sp.size(), " bytes from the data file of key ",
+                                keys[pending[runs[j].first].index]);
+      }
+      for (size_t i = runs[j].first; i < runs[j].second; ++i) {
+        const BundleEntryProto& entry = pending[i].entry;
+        const char* data = sp.data() + (entry.offset() - ranges[j].offset);
+        const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+        if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+          return errors::DataLoss(
+              "Checksum does not match: stored ",
+              strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+              " vs. calculated on the restored bytes ", actual_crc32c);
+        }
+        Tensor* val = vals[pending[i].index];
+        memcpy(const_cast<char*>(val->tensor_data().data()), data,
+               entry.size());
+      }
+    }
+    shard_begin = begin;
+  }
+  return Status::OK();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -181,7 +181,22 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
-  BundleReader(Env* const env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If true, data files are memory-mapped (where the file system supports
+    // it), and looking up an unsliced tensor of a memcpy-able type into an
+    // empty Tensor makes it alias the mapped bytes instead of a copy, provided
+    // that the bytes are aligned to Allocator::kAllocatorAlignment. Writing
+    // the bundle with BundleWriter::Options::data_alignment set to a multiple
+    // of that alignment guarantees this for all such tensors.
+    //
+    // The aliasing tensors are read-only and keep the mapping alive after the
+    // reader is destroyed; the data files must not be modified in place
+    // while they exist.
+    bool memory_map_data{false};
+  };
+  BundleReader(Env* const env, StringPiece prefix,
+               const Options& options = Options());
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -210,6 +225,8 @@ class BundleReader {
   // Caller must make sure "val" has the same shape and dtype as the
   // corresponding contents, so that its buffer can be filled without needing
   // extra allocation.  These can be queried via "LookupDtypeAndShape()".
+  // Alternatively, "val" may have no elements, in which case a new tensor is
+  // allocated (or, see Options::memory_map_data, mapped) for the contents.
   //
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
@@ -218,6 +235,16 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensors keyed by "keys" into the corresponding "vals", as if
+  // by calling Lookup() for each of them. Tensors stored next to each other
+  // in a data file are read with a single read, which is much faster than
+  // many small reads on high-latency file systems.
+  //
+  // On error, any of "vals" may contain nonsense data.
+  // REQUIRES: status().ok() && keys.size() == vals.size()
+  Status LookupMany(gtl::ArraySlice<string> keys,
+                    gtl::ArraySlice<Tensor*> vals) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -274,6 +301,16 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Returns the buffered data file of shard "shard_id", opening it if needed.
+  Status GetDataFile(int32 shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
+  // If the data file of "entry" can be memory-mapped and its contents are
+  // suitably aligned, validates them and sets "val" to a tensor aliasing
+  // them. Sets "*mapped" to whether it did.
+  Status GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                        bool* mapped) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -284,6 +321,7 @@ class BundleReader {
 
   Env* env_;  // Not owned.
   const string prefix_;
+  const Options options_;
 
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
@@ -291,6 +329,11 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // Memory-mapped data files, if options_.memory_map_data. Each is ref-counted
+  // and shared with the tensors aliasing it. Holds nullptr for files that
+  // could not be mapped.
+  class MappedFile;
+  std::unordered_map<int32, MappedFile*> mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
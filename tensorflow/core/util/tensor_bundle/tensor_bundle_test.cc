@@ -18,6 +18,7 @@ limitations under the License.
 #include <random>
 #include <vector>
 
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant.h"
@@ -884,6 +885,69 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+TEST(TensorBundleTest, LookupMany) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 64;
+    BundleWriter writer(Env::Default(), Prefix("foo"), opts);
+    TF_EXPECT_OK(writer.Add("foo_000", Constant_2x3<float>(0)));
+    TF_EXPECT_OK(writer.Add("foo_001", Constant_2x3<int32>(1)));
+    TF_EXPECT_OK(writer.Add("foo_002", Constant_2x3<string>("two")));
+    TF_EXPECT_OK(writer.Add("foo_003", Constant(3.0, TensorShape({1 << 16}))));
+    TF_EXPECT_OK(writer.Add("foo_004", Constant(true, TensorShape({}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("foo"));
+  TF_ASSERT_OK(reader.status());
+  // Looks up out of order, into both allocated and empty tensors.
+  Tensor t0(DT_FLOAT, TensorShape({2, 3}));
+  Tensor t1, t2, t3, t4;
+  TF_ASSERT_OK(reader.LookupMany({"foo_004", "foo_000", "foo_002", "foo_001",
+                                  "foo_003"},
+                                 {&t4, &t0, &t2, &t1, &t3}));
+  test::ExpectTensorEqual<float>(t0, Constant_2x3<float>(0));
+  test::ExpectTensorEqual<int32>(t1, Constant_2x3<int32>(1));
+  test::ExpectTensorEqual<string>(t2, Constant_2x3<string>("two"));
+  test::ExpectTensorEqual<double>(t3, Constant(3.0, TensorShape({1 << 16})));
+  test::ExpectTensorEqual<bool>(t4, Constant(true, TensorShape({})));
+
+  Tensor wrong_shape(DT_FLOAT, TensorShape({3}));
+  EXPECT_TRUE(errors::IsDataLoss(
+      reader.LookupMany({"foo_000"}, {&wrong_shape})));
+  Tensor missing;
+  EXPECT_TRUE(errors::IsNotFound(reader.LookupMany({"bar"}, {&missing})));
+}
+
+TEST(TensorBundleTest, MemoryMappedData) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(Env::Default(), Prefix("foo"), opts);
+    TF_EXPECT_OK(writer.Add("small", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(writer.Add("big", Constant(2.5f, TensorShape({1024}))));
+    TF_EXPECT_OK(writer.Add("strs", Constant_2x3<string>("x")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor big;
+  {
+    BundleReader::Options opts;
+    opts.memory_map_data = true;
+    BundleReader reader(Env::Default(), Prefix("foo"), opts);
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.Lookup("big", &big));
+    TensorDescription desc;
+    big.FillDescription(&desc);
+    EXPECT_EQ("mmap", desc.allocation_description().allocator_name());
+
+    // Tensors that are not memcpy-able, or that the caller allocated, are
+    // read as usual.
+    Expect<bool>(&reader, "small", Constant(true, TensorShape({1})));
+    Expect<string>(&reader, "strs", Constant_2x3<string>("x"));
+  }
+  // The mapping outlives the reader as long as a tensor refers to it.
+  test::ExpectTensorEqual<float>(big, Constant(2.5f, TensorShape({1024})));
+}
+
 static void BM_BundleAlignmentByteOff(int iters, int alignment,
                                       int tensor_size) {
   testing::StopTiming();
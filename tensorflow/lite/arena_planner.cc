@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/arena_planner.h"
+#include <cstring>
 #include <utility>
 
 namespace tflite {
@@ -26,17 +27,76 @@ struct AllocationInfo {
   enum Type { ALLOC, DEALLOC } type;
 };
 
+namespace {
+
+// Version of the format written by SerializeOfflineArenaPlan. The plan is
+// stored as 32 bit words: the version, the number of nodes, the arena size,
+// the number of tensors, then the offset and the size of each tensor.
+constexpr int32_t kOfflineArenaPlanVersion = 1;
+constexpr int kOfflineArenaPlanHeaderWords = 4;
+
+}  // namespace
+
+std::vector<uint8_t> SerializeOfflineArenaPlan(const OfflineArenaPlan& plan) {
+  std::vector<int32_t> words = {
+      kOfflineArenaPlanVersion, plan.num_nodes,
+      static_cast<int32_t>(plan.arena_size),
+      static_cast<int32_t>(plan.offsets.size())};
+  for (size_t i = 0; i < plan.offsets.size(); ++i) {
+    words.push_back(static_cast<int32_t>(plan.offsets[i]));
+    words.push_back(static_cast<int32_t>(plan.sizes[i]));
+  }
+  std::vector<uint8_t> data(words.size() * sizeof(int32_t));
+  memcpy(data.data(), words.data(), data.size());
+  return data;
+}
+
+bool ParseOfflineArenaPlan(const uint8_t* data, size_t size,
+                           OfflineArenaPlan* plan) {
+  if (size % sizeof(int32_t) != 0 ||
+      size < kOfflineArenaPlanHeaderWords * sizeof(int32_t)) {
+    return false;
+  }
+  std::vector<int32_t> words(size / sizeof(int32_t));
+  memcpy(words.data(), data, size);
+  const int32_t num_tensors = words[3];
+  if (words[0] != kOfflineArenaPlanVersion || words[1] < 0 || words[2] < 0 ||
+      num_tensors < 0 ||
+      words.size() !=
+          kOfflineArenaPlanHeaderWords + 2 * static_cast<size_t>(num_tensors)) {
+    return false;
+  }
+  plan->num_nodes = words[1];
+  plan->arena_size = words[2];
+  plan->offsets.resize(num_tensors);
+  plan->sizes.resize(num_tensors);
+  for (int i = 0; i < num_tensors; ++i) {
+    const int32_t offset = words[kOfflineArenaPlanHeaderWords + 2 * i];
+    const int32_t size = words[kOfflineArenaPlanHeaderWords + 2 * i + 1];
+    // Placed tensors must fit in the part of the arena used by the plan.
+    if (size < 0 || (offset >= 0 && static_cast<int64_t>(offset) + size >
+                                        words[2])) {
+      return false;
+    }
+    plan->offsets[i] = offset;
+    plan->sizes[i] = size;
+  }
+  return true;
+}
+
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_inputs, bool preserve_intermediates,
-                           int tensor_alignment)
+                           int tensor_alignment,
+                           const OfflineArenaPlan* offline_plan)
     : context_(context),
       graph_info_(std::move(graph_info)),
       arena_(kDefaultArenaAlignment),
       persistent_arena_(kDefaultArenaAlignment),
       preserve_inputs_(preserve_inputs),
       preserve_intermediates_(preserve_intermediates),
-      tensor_alignment_(tensor_alignment) {}
+      tensor_alignment_(tensor_alignment),
+      offline_plan_(offline_plan) {}
 
 ArenaPlanner::~ArenaPlanner() {}
 
@@ -55,6 +115,15 @@ TfLiteStatus ArenaPlanner::ResetAllocations() {
   TF_LITE_ENSURE_STATUS(persistent_arena_.Clear());
   allocs_.clear();
   allocs_.resize(graph_info_->num_tensors());
+  // The plan assumes the tensor lifetimes of the graph it was computed for,
+  // which a delegate changes, and does not keep intermediates alive.
+  use_offline_plan_ = offline_plan_ != nullptr && !preserve_intermediates_ &&
+                      offline_plan_->num_nodes == graph_info_->num_nodes();
+  if (use_offline_plan_) {
+    TF_LITE_ENSURE_STATUS(arena_.Allocate(context_, tensor_alignment_,
+                                          offline_plan_->arena_size,
+                                          &offline_plan_alloc_));
+  }
   // Note that we only clear the alloc_queue_ when re-planning allocations, as
   // it should only change when the graph topology itself changes.
   return kTfLiteOk;
@@ -204,6 +273,12 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   return kTfLiteOk;
 }
 
+void ArenaPlanner::GetAllocInfo(size_t* arena_size,
+                                size_t* arena_persist_size) const {
+  *arena_size = arena_.GetBufferSize();
+  *arena_persist_size = persistent_arena_.GetBufferSize();
+}
+
 TfLiteStatus ArenaPlanner::Commit() {
   TF_LITE_ENSURE_STATUS(arena_.Commit(context_));
   TF_LITE_ENSURE_STATUS(persistent_arena_.Commit(context_));
@@ -261,9 +336,24 @@ TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   return kTfLiteOk;
 }
 
+bool ArenaPlanner::IsPlannedOffline(int tensor_index) {
+  if (!use_offline_plan_ ||
+      static_cast<size_t>(tensor_index) >= offline_plan_->offsets.size() ||
+      offline_plan_->offsets[tensor_index] < 0) {
+    return false;
+  }
+  const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+  return tensor.allocation_type == kTfLiteArenaRw &&
+         tensor.bytes <= offline_plan_->sizes[tensor_index];
+}
+
 TfLiteStatus ArenaPlanner::CalculateTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-  if (tensor.allocation_type == kTfLiteArenaRw) {
+  if (IsPlannedOffline(tensor_index)) {
+    // The reserved region starts at offset 0 of the arena.
+    allocs_[tensor_index].offset = offline_plan_->offsets[tensor_index];
+    allocs_[tensor_index].size = tensor.bytes;
+  } else if (tensor.allocation_type == kTfLiteArenaRw) {
     TF_LITE_ENSURE_STATUS(arena_.Allocate(
         context_, tensor_alignment_, tensor.bytes, &allocs_[tensor_index]));
   }
@@ -276,7 +366,8 @@ TfLiteStatus ArenaPlanner::CalculateTensorAllocation(int tensor_index) {
 
 TfLiteStatus ArenaPlanner::CalculateTensorDeallocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-  if (tensor.allocation_type == kTfLiteArenaRw) {
+  if (tensor.allocation_type == kTfLiteArenaRw &&
+      !IsPlannedOffline(tensor_index)) {
     TF_LITE_ENSURE_STATUS(arena_.Deallocate(context_, allocs_[tensor_index]));
   }
   return kTfLiteOk;
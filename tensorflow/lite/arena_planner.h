@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_ARENA_PLANNER_H_
 #define TENSORFLOW_LITE_ARENA_PLANNER_H_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -31,6 +32,35 @@ constexpr const int kDefaultTensorAlignment = 64;
 
 struct AllocationInfo;
 
+// An arena plan computed ahead of time for the tensors of a graph, e.g. by
+// tools/optimize/offline_arena_planner.h, so that the planner does not have to
+// look for a place for them in the arena.
+struct OfflineArenaPlan {
+  // The number of nodes of the graph the plan was computed for. The plan is
+  // only used for graphs with the same number of nodes.
+  int num_nodes = 0;
+  // The size of the part of the arena used by the plan.
+  size_t arena_size = 0;
+  // offsets[i] is the offset of tensor i in the arena, or -1 if the plan
+  // does not place it.
+  std::vector<int64_t> offsets;
+  // sizes[i] is the size of tensor i assumed by the plan. Tensors that have
+  // grown beyond it are allocated as if they were not placed by the plan.
+  std::vector<size_t> sizes;
+};
+
+// Name of the model metadata holding the OfflineArenaPlan of the first
+// subgraph of a model, as serialized by SerializeOfflineArenaPlan().
+constexpr char kOfflineArenaPlanMetadataName[] = "OfflineArenaPlan";
+
+// Serializes `plan` into a buffer that ParseOfflineArenaPlan() can read.
+std::vector<uint8_t> SerializeOfflineArenaPlan(const OfflineArenaPlan& plan);
+
+// Reads a plan serialized by SerializeOfflineArenaPlan(). Returns false if
+// `data` does not hold a valid plan.
+bool ParseOfflineArenaPlan(const uint8_t* data, size_t size,
+                           OfflineArenaPlan* plan);
+
 // A memory planner that makes all the allocations using arenas.
 //
 // Before a model is executed by the interpreter, this class determines when
@@ -54,10 +84,13 @@ class ArenaPlanner : public MemoryPlanner {
   // Ownership of 'context' is not taken and it must remain util the
   // ArenaPlanner is destroyed. If 'preserve_inputs' is true the inputs to the
   // graph will not share memory with any other tensor, effectively preserving
-  // them until the end of inference.
+  // them until the end of inference. If not null, 'offline_plan' places the
+  // tensors it covers, and must also remain until the ArenaPlanner is
+  // destroyed.
   ArenaPlanner(TfLiteContext* context, std::unique_ptr<GraphInfo> graph_info,
                bool preserve_inputs, bool preserve_intermediates,
-               int tensor_alignment = kDefaultTensorAlignment);
+               int tensor_alignment = kDefaultTensorAlignment,
+               const OfflineArenaPlan* offline_plan = nullptr);
   ~ArenaPlanner() override;
   ArenaPlanner(const ArenaPlanner&) = delete;
   ArenaPlanner& operator=(const ArenaPlanner&) = delete;
@@ -65,6 +98,8 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus ResetAllocations() override;
   TfLiteStatus PlanAllocations() override;
   TfLiteStatus ExecuteAllocations(int first_node, int last_node) override;
+  void GetAllocInfo(size_t* arena_size,
+                    size_t* arena_persist_size) const override;
 
   // Returns the base arena location for a given allocation type.
   int64_t BasePointer(TfLiteAllocationType type);
@@ -96,6 +131,9 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Returns whether the offline plan places the given tensor.
+  bool IsPlannedOffline(int tensor_index);
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -125,6 +163,13 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // The plan computed ahead of time, if any, and whether it matches the
+  // current graph. The start of the arena is reserved for the tensors it
+  // places, and other tensors are allocated after them.
+  const OfflineArenaPlan* offline_plan_;
+  bool use_offline_plan_ = false;
+  ArenaAlloc offline_plan_alloc_;
 };
 
 }  // namespace tflite
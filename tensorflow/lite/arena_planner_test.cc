@@ -162,12 +162,14 @@ void ReportError(TfLiteContext* context, const char* format, ...) {
 
 class ArenaPlannerTest : public ::testing::Test {
  protected:
-  void SetGraph(TestGraph* graph, bool preserve_inputs = false) {
+  void SetGraph(TestGraph* graph, bool preserve_inputs = false,
+                const OfflineArenaPlan* offline_plan = nullptr) {
     graph_ = graph;
     context_.ReportError = ReportError;
     planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
-        preserve_inputs, /*preserve intermediates*/ false, kTensorAlignment));
+        preserve_inputs, /*preserve intermediates*/ false, kTensorAlignment,
+        offline_plan));
     CHECK(planner_->ResetAllocations() == kTfLiteOk);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
@@ -260,6 +262,27 @@ TEST_F(ArenaPlannerTest, SimpleGraph) {
   EXPECT_EQ(GetOffset(3), 0);
 }
 
+TEST_F(ArenaPlannerTest, GetAllocInfo) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  size_t arena_size = 1;
+  size_t arena_persist_size = 1;
+  planner_->GetAllocInfo(&arena_size, &arena_persist_size);
+  EXPECT_EQ(arena_size, 0);
+  EXPECT_EQ(arena_persist_size, 0);
+
+  Execute(0, 10);
+  planner_->GetAllocInfo(&arena_size, &arena_persist_size);
+  EXPECT_GE(arena_size, GetOffsetAfter(5));
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphInputsPreserved) {
   TestGraph graph({0, 1},
                   {
@@ -535,6 +558,78 @@ TEST_F(ArenaPlannerTest, ModifiedGraph) {
   EXPECT_EQ(GetOffset(3), GetOffsetAfter(1));
 }
 
+TEST_F(ArenaPlannerTest, OfflinePlan) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  // Tensor 5 is left to the planner, and tensor 4 has grown since the plan
+  // was made.
+  OfflineArenaPlan plan;
+  plan.num_nodes = 3;
+  plan.arena_size = 64;
+  plan.offsets = {0, 8, 16, 0, 32, -1};
+  plan.sizes = {3, 6, 9, 12, 12, 18};
+  (*graph.tensors())[4].bytes = 13;
+  SetGraph(&graph, /*preserve_inputs=*/false, &plan);
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), 8);
+  EXPECT_EQ(GetOffset(2), 16);
+  EXPECT_EQ(GetOffset(3), 0);
+  EXPECT_EQ(GetOffset(4), 64);
+  EXPECT_EQ(GetOffset(5), GetOffsetAfter(4));
+}
+
+TEST_F(ArenaPlannerTest, OfflinePlanForAnotherGraph) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},  // First op
+                      {{2, 0}, {3}, {}},  // Second op
+                  },
+                  {3});
+  OfflineArenaPlan plan;
+  plan.num_nodes = 3;
+  plan.arena_size = 64;
+  plan.offsets = {32, 0, 8, 16};
+  plan.sizes = {3, 6, 9, 12};
+  SetGraph(&graph, /*preserve_inputs=*/false, &plan);
+  Execute(0, 10);
+
+  // The plan is ignored.
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(0));
+}
+
+TEST(OfflineArenaPlanTest, SerializeAndParse) {
+  OfflineArenaPlan plan;
+  plan.num_nodes = 2;
+  plan.arena_size = 128;
+  plan.offsets = {0, -1, 64};
+  plan.sizes = {64, 10, 64};
+  const std::vector<uint8_t> data = SerializeOfflineArenaPlan(plan);
+
+  OfflineArenaPlan parsed;
+  ASSERT_TRUE(ParseOfflineArenaPlan(data.data(), data.size(), &parsed));
+  EXPECT_EQ(parsed.num_nodes, 2);
+  EXPECT_EQ(parsed.arena_size, 128);
+  EXPECT_EQ(parsed.offsets, plan.offsets);
+  EXPECT_EQ(parsed.sizes, plan.sizes);
+
+  // Truncated, or with a tensor outside of the arena.
+  EXPECT_FALSE(ParseOfflineArenaPlan(data.data(), data.size() - 4, &parsed));
+  plan.offsets[2] = 100;
+  const std::vector<uint8_t> bad_data = SerializeOfflineArenaPlan(plan);
+  EXPECT_FALSE(
+      ParseOfflineArenaPlan(bad_data.data(), bad_data.size(), &parsed));
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -187,6 +187,7 @@ TfLiteDelegate TfLiteDelegateCreate() {
       .CopyToBufferHandle = NULL,
       .FreeBufferHandle = NULL,
       .flags = kTfLiteDelegateFlagsNone,
+      .ShouldDelegatePartition = NULL,
   };
   return d;
 }
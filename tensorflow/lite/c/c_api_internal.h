@@ -44,11 +44,12 @@ typedef enum { kTfLiteOk = 0, kTfLiteError = 1 } TfLiteStatus;
 // need. Access to the external contexts is controled by one of the
 // corresponding support files.
 typedef enum {
-  kTfLiteEigenContext = 0,       // include eigen_support.h to use.
-  kTfLiteGemmLowpContext = 1,    // include gemm_support.h to use.
-  kTfLiteEdgeTpuContext = 2,     // Placeholder for Edge TPU support.
-  kTfLiteCpuBackendContext = 3,  // include cpu_backend_support.h to use.
-  kTfLiteMaxExternalContexts = 4
+  kTfLiteEigenContext = 0,         // include eigen_support.h to use.
+  kTfLiteGemmLowpContext = 1,      // include gemm_support.h to use.
+  kTfLiteEdgeTpuContext = 2,       // Placeholder for Edge TPU support.
+  kTfLiteCpuBackendContext = 3,    // include cpu_backend_support.h to use.
+  kTfLiteWeightsCacheContext = 4,  // include weights_cache.h to use.
+  kTfLiteMaxExternalContexts = 5
 } TfLiteExternalContextType;
 
 struct TfLiteContext;
@@ -280,12 +281,15 @@ typedef union {
 // Memory allocation strategies. kTfLiteMmapRo is for read-only memory-mapped
 // data (or data externally allocated). kTfLiteArenaRw is arena allocated
 // data. kTfLiteDynamic is for tensors that are allocated during evaluation.
+// kTfLiteCustom is for writable data owned by the caller, which is left out
+// of the arena.
 typedef enum {
   kTfLiteMemNone = 0,
   kTfLiteMmapRo,
   kTfLiteArenaRw,
   kTfLiteArenaRwPersistent,
   kTfLiteDynamic,
+  kTfLiteCustom,
 } TfLiteAllocationType;
 
 // The delegates should use zero or positive integers to represent handles.
@@ -597,6 +601,18 @@ typedef struct _TfLiteDelegate {
 
   // Bitmask flags. See the comments in `TfLiteDelegateFlags`.
   int64_t flags;
+
+  // Invoked by ReplaceNodeSubsetsWithDelegateKernels() for each partition of
+  // the nodes to replace, i.e. each set of nodes that would run as a single
+  // delegate kernel, with the tensors copied in and out of the partition.
+  // Returning false leaves the nodes of the partition to their CPU kernels,
+  // e.g. when the partition does too little work to pay for the copies. This
+  // can be null, in which case all partitions are delegated.
+  bool (*ShouldDelegatePartition)(TfLiteContext* context,
+                                  TfLiteDelegate* delegate,
+                                  const TfLiteIntArray* nodes,
+                                  const TfLiteIntArray* input_tensors,
+                                  const TfLiteIntArray* output_tensors);
 } TfLiteDelegate;
 
 // Build a 'null' delegate, with all the fields properly set to their default
@@ -16,6 +16,10 @@ limitations under the License.
 #include "tensorflow/lite/core/subgraph.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
 
 #include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/c/c_api_internal.h"
@@ -336,6 +340,18 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
         TfLiteDelegateParams* params =
             CreateDelegateParams(delegate, node_subset);
+        // Let the delegate leave partitions that are not worth delegating to
+        // the CPU kernels of their nodes.
+        if (delegate && delegate->ShouldDelegatePartition &&
+            !delegate->ShouldDelegatePartition(
+                &context_, delegate, params->nodes_to_replace,
+                params->input_tensors, params->output_tensors)) {
+          free(params);
+          execution_plan_.insert(execution_plan_.end(),
+                                 node_subset.nodes.begin(),
+                                 node_subset.nodes.end());
+          break;
+        }
         TF_LITE_ENSURE_STATUS(AddNodeWithParameters(
             node_subset.input_tensors, node_subset.output_tensors, {}, nullptr,
             0, params, &registration, &node_index));
@@ -362,6 +378,9 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (record_external_context_use_) {
+    external_context_used_ = true;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -429,6 +448,10 @@ TfLiteStatus Subgraph::SetVariables(std::vector<int> variables) {
   return kTfLiteOk;
 }
 
+void Subgraph::SetOfflineArenaPlan(std::unique_ptr<OfflineArenaPlan> plan) {
+  offline_arena_plan_ = std::move(plan);
+}
+
 void Subgraph::SetCancellationFunction(void* data,
                                        bool (*check_cancelled_func)(void*)) {
   cancellation_data_ = data;
@@ -492,15 +515,26 @@ TfLiteStatus Subgraph::AllocateTensors() {
     return kTfLiteOk;
   }
 
+  // Unless only the shapes of graph inputs changed, all the nodes have to be
+  // prepared again.
+  if (!only_inputs_resized_since_prepare_) {
+    resized_tensors_.clear();
+  }
+  only_inputs_resized_since_prepare_ = false;
+
   next_execution_plan_index_to_prepare_ = 0;
   next_execution_plan_index_to_plan_allocation_ = 0;
   if (memory_planner_) {
     TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
   }
 
-  TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  TfLiteStatus status = PrepareOpsAndTensors();
+  resized_tensors_.clear();
+  TF_LITE_ENSURE_STATUS(status);
 
   state_ = kStateInvokable;
+  // Nodes after a dynamic tensor are prepared again on every invocation.
+  only_inputs_resized_since_prepare_ = !has_dynamic_tensors_;
 
   // Reset the variable tensors to zero after (re)allocating the tensors.
   // Developers shouldn't rely on the side effect of this function to reset
@@ -511,6 +545,42 @@ TfLiteStatus Subgraph::AllocateTensors() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Subgraph::SetCustomAllocationForTensor(int tensor_index,
+                                                    void* data, size_t bytes) {
+  TF_LITE_ENSURE(&context_,
+                 tensor_index < context_.tensors_size && tensor_index >= 0);
+  TfLiteTensor* tensor = &context_.tensors[tensor_index];
+  TF_LITE_ENSURE(&context_, data != nullptr);
+  TF_LITE_ENSURE(&context_, tensor->type != kTfLiteString);
+  if (reinterpret_cast<uintptr_t>(data) % kDefaultTensorAlignment != 0) {
+    ReportError("Custom allocation for tensor %d is not aligned to %d bytes.",
+                tensor_index, kDefaultTensorAlignment);
+    return kTfLiteError;
+  }
+  if (tensor->allocation_type == kTfLiteArenaRw) {
+    if (state_ == kStateInvokableAndImmutable) {
+      ReportError(
+          "Tensors must be bound to custom allocations before delegates that "
+          "make the graph immutable are applied.");
+      return kTfLiteError;
+    }
+    // The arena has to be planned again without the tensor.
+    tensor->allocation_type = kTfLiteCustom;
+    state_ = kStateUninvokable;
+  } else if (tensor->allocation_type != kTfLiteCustom) {
+    ReportError("Tensor %d is not allocated in the arena.", tensor_index);
+    return kTfLiteError;
+  } else if (tensor->bytes > bytes) {
+    ReportError(
+        "Tensor %d needs %zu bytes, but its custom allocation has %zu bytes.",
+        tensor_index, tensor->bytes, bytes);
+    return kTfLiteError;
+  }
+  tensor->data.raw = reinterpret_cast<char*>(data);
+  custom_allocation_bytes_[tensor_index] = bytes;
+  return kTfLiteOk;
+}
+
 // TODO(ycling): Support non-zero default values.
 TfLiteStatus Subgraph::ResetVariableTensors() {
   for (auto& tensor : tensors_) {
@@ -541,6 +611,7 @@ TfLiteStatus Subgraph::AddNodeWithParameters(
     return kTfLiteError;
   }
   state_ = kStateUninvokable;
+  only_inputs_resized_since_prepare_ = false;
 
   TF_LITE_ENSURE_OK(&context_, CheckTensorIndices("node inputs", inputs.data(),
                                                   inputs.size()));
@@ -625,6 +696,16 @@ TfLiteStatus Subgraph::ResizeInputTensor(int tensor_index,
     TF_LITE_ENSURE_STATUS(UndoAllDelegates());
   }
   state_ = kStateUninvokable;
+  // Only the consumers of the tensor, and the nodes downstream of them whose
+  // input shapes change in turn, have to be prepared again.
+  if (only_inputs_resized_since_prepare_ &&
+      std::find(inputs_.begin(), inputs_.end(), tensor_index) !=
+          inputs_.end()) {
+    resized_tensors_.resize(context_.tensors_size, false);
+    resized_tensors_[tensor_index] = true;
+  } else {
+    only_inputs_resized_since_prepare_ = false;
+  }
   return ResizeTensorImpl(tensor, ConvertVectorToTfLiteIntArray(dims));
 }
 
@@ -650,17 +731,47 @@ TfLiteStatus Subgraph::OpPrepare(const TfLiteRegistration& op_reg,
   return op_reg.prepare(&context_, node);
 }
 
+bool Subgraph::HasResizedTensor(const TfLiteIntArray* tensor_indices) const {
+  for (int i = 0; i < tensor_indices->size; ++i) {
+    const int tensor_index = tensor_indices->data[i];
+    if (tensor_index >= 0 && tensor_index < resized_tensors_.size() &&
+        resized_tensors_[tensor_index]) {
+      return true;
+    }
+  }
+  return false;
+}
+
 TfLiteStatus Subgraph::PrepareOpsStartingAt(
     int first_execution_plan_index, int* last_execution_plan_index_prepared) {
   if (first_execution_plan_index == 0) {
     has_dynamic_tensors_ = false;
   }
+  const bool prepare_resized_only = !resized_tensors_.empty();
+  std::vector<std::unique_ptr<TfLiteIntArray, TfLiteIntArrayDeleter>>
+      previous_output_dims;
   for (int execution_plan_index = first_execution_plan_index;
        execution_plan_index < execution_plan_.size(); execution_plan_index++) {
     int node_index = execution_plan_[execution_plan_index];
     TfLiteNode& node = nodes_and_registration_[node_index].first;
     const TfLiteRegistration& registration =
         nodes_and_registration_[node_index].second;
+    if (prepare_resized_only) {
+      // The node was already prepared with the current shapes of its inputs,
+      // and its outputs and temporaries keep their shapes.
+      if (!HasResizedTensor(node.inputs)) {
+        *last_execution_plan_index_prepared = execution_plan_index;
+        continue;
+      }
+      previous_output_dims.clear();
+      for (int i = 0; i < node.outputs->size; ++i) {
+        const int tensor_index = node.outputs->data[i];
+        previous_output_dims.emplace_back(
+            tensor_index == kOptionalTensor
+                ? nullptr
+                : TfLiteIntArrayCopy(tensors_[tensor_index].dims));
+      }
+    }
     EnsureTensorsVectorCapacity();
     if (OpPrepare(registration, &node) == kTfLiteError) {
       return ReportOpError(&context_, node, registration, node_index,
@@ -674,17 +785,36 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
     // sizes of other tensors in the graph.
     if (HasDynamicTensor(context_, node.outputs)) {
       has_dynamic_tensors_ = true;
+      // The nodes after this one are prepared once its outputs are known, and
+      // all of them have to be.
+      resized_tensors_.clear();
       return kTfLiteOk;
     }
+
+    if (prepare_resized_only) {
+      for (int i = 0; i < node.outputs->size; ++i) {
+        const int tensor_index = node.outputs->data[i];
+        if (tensor_index == kOptionalTensor) continue;
+        if (!TfLiteIntArrayEqual(previous_output_dims[i].get(),
+                                 tensors_[tensor_index].dims)) {
+          if (tensor_index >= resized_tensors_.size()) {
+            resized_tensors_.resize(tensor_index + 1, false);
+          }
+          resized_tensors_[tensor_index] = true;
+        }
+      }
+    }
   }
   return kTfLiteOk;
 }
 
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
+  parallel_plan_ready_ = false;
   if (!memory_planner_) {
     memory_planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
-        /*preserve_inputs=*/true, /*preserve_intermediates*/ false));
+        /*preserve_inputs=*/true, /*preserve_intermediates*/ false,
+        kDefaultTensorAlignment, offline_arena_plan_.get()));
     memory_planner_->PlanAllocations();
   }
 
@@ -700,6 +830,20 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   next_execution_plan_index_to_plan_allocation_ =
       last_exec_plan_index_prepared + 1;
 
+  return VerifyCustomAllocations();
+}
+
+TfLiteStatus Subgraph::VerifyCustomAllocations() {
+  for (const auto& index_and_bytes : custom_allocation_bytes_) {
+    const TfLiteTensor& tensor = tensors_[index_and_bytes.first];
+    if (tensor.allocation_type == kTfLiteCustom &&
+        tensor.bytes > index_and_bytes.second) {
+      ReportError(
+          "Tensor %d needs %zu bytes, but its custom allocation has %zu bytes.",
+          index_and_bytes.first, tensor.bytes, index_and_bytes.second);
+      return kTfLiteError;
+    }
+  }
   return kTfLiteOk;
 }
 
@@ -722,6 +866,16 @@ TfLiteStatus Subgraph::Invoke() {
     applied_nnapi_delegate_ = true;
   }
 
+  if (parallel_plan_ready_ && CanInvokeInParallel()) {
+    return InvokeInParallel();
+  }
+  // The first invocation after the nodes are prepared runs them in order, to
+  // find out which ones use external contexts.
+  const bool record_external_context_use = CanInvokeInParallel();
+  if (record_external_context_use) {
+    node_uses_external_context_.assign(execution_plan_.size(), false);
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -763,11 +917,22 @@ TfLiteStatus Subgraph::Invoke() {
 
     EnsureTensorsVectorCapacity();
     tensor_resized_since_op_invoke_ = false;
+    record_external_context_use_ = record_external_context_use;
+    external_context_used_ = false;
     if (OpInvoke(registration, &node) == kTfLiteError) {
+      record_external_context_use_ = false;
       return ReportOpError(&context_, node, registration, node_index,
                            "failed to invoke");
     }
 
+    // Remember which nodes use external contexts, such as the CPU backend
+    // context, which can't be used by several nodes concurrently.
+    record_external_context_use_ = false;
+    if (record_external_context_use) {
+      node_uses_external_context_[execution_plan_index] =
+          external_context_used_;
+    }
+
     // Force execution prep for downstream ops if the latest op triggered the
     // resize of a dynamic tensor.
     if (tensor_resized_since_op_invoke_ &&
@@ -792,9 +957,211 @@ TfLiteStatus Subgraph::Invoke() {
     }
   }
 
+  if (record_external_context_use && CanInvokeInParallel()) {
+    PlanParallelInvoke();
+  }
+
   return status;
 }
 
+bool Subgraph::CanInvokeInParallel() const {
+  // Control flow ops invoke other subgraphs, which share the external contexts
+  // of this one, so subgraphs are only run in parallel on their own.
+  if (inter_op_thread_pool_ == nullptr || profiler_ != nullptr ||
+      has_dynamic_tensors_ ||
+      next_execution_plan_index_to_prepare_ < execution_plan_.size() ||
+      (subgraphs_ != nullptr && subgraphs_->size() > 1)) {
+    return false;
+  }
+  for (int node_index : execution_plan_) {
+    if (nodes_and_registration_[node_index].first.delegate != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Subgraph::PlanParallelInvoke() {
+  const int num_nodes = execution_plan_.size();
+
+  // Returns all the tensors a node uses.
+  auto node_tensors = [this](int execution_plan_index) {
+    const TfLiteNode& node =
+        nodes_and_registration_[execution_plan_[execution_plan_index]].first;
+    std::vector<int> tensor_indices;
+    for (const TfLiteIntArray* indices :
+         {node.inputs, node.outputs, node.temporaries}) {
+      if (indices == nullptr) continue;
+      for (int i = 0; i < indices->size; ++i) {
+        if (indices->data[i] != kOptionalTensor) {
+          tensor_indices.push_back(indices->data[i]);
+        }
+      }
+    }
+    return tensor_indices;
+  };
+  // Returns whether two different tensors share memory of the arena.
+  auto share_memory = [this](int a, int b) {
+    const TfLiteTensor& tensor_a = tensors_[a];
+    const TfLiteTensor& tensor_b = tensors_[b];
+    if (a == b || tensor_a.allocation_type != kTfLiteArenaRw ||
+        tensor_b.allocation_type != kTfLiteArenaRw || tensor_a.bytes == 0 ||
+        tensor_b.bytes == 0) {
+      return false;
+    }
+    return tensor_a.data.raw < tensor_b.data.raw + tensor_b.bytes &&
+           tensor_b.data.raw < tensor_a.data.raw + tensor_a.bytes;
+  };
+
+  std::vector<std::vector<int>> tensors_of_node(num_nodes);
+  std::vector<int> producer(tensors_.size(), -1);
+  for (int i = 0; i < num_nodes; ++i) {
+    tensors_of_node[i] = node_tensors(i);
+    const TfLiteNode& node = nodes_and_registration_[execution_plan_[i]].first;
+    for (int j = 0; j < node.outputs->size; ++j) {
+      if (node.outputs->data[j] != kOptionalTensor) {
+        producer[node.outputs->data[j]] = i;
+      }
+    }
+  }
+
+  parallel_num_dependencies_.assign(num_nodes, 0);
+  parallel_dependents_.assign(num_nodes, {});
+  // The last node that used each variable tensor so far.
+  std::vector<int> last_variable_user(tensors_.size(), -1);
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteNode& node = nodes_and_registration_[execution_plan_[i]].first;
+    std::set<int> dependencies;
+    for (int j = 0; j < node.inputs->size; ++j) {
+      const int tensor_index = node.inputs->data[j];
+      if (tensor_index != kOptionalTensor && producer[tensor_index] >= 0 &&
+          producer[tensor_index] < i) {
+        dependencies.insert(producer[tensor_index]);
+      }
+    }
+    for (int tensor_index : tensors_of_node[i]) {
+      if (tensors_[tensor_index].is_variable) {
+        if (last_variable_user[tensor_index] >= 0) {
+          dependencies.insert(last_variable_user[tensor_index]);
+        }
+        last_variable_user[tensor_index] = i;
+      }
+    }
+    // Outputs and temporaries may reuse the memory of tensors which earlier
+    // nodes no longer need.
+    std::vector<int> written(node.outputs->data,
+                             node.outputs->data + node.outputs->size);
+    if (node.temporaries != nullptr) {
+      for (int j = 0; j < node.temporaries->size; ++j) {
+        written.push_back(node.temporaries->data[j]);
+      }
+    }
+    for (int earlier = 0; earlier < i; ++earlier) {
+      if (dependencies.count(earlier)) continue;
+      bool shares_memory = false;
+      for (int tensor_index : written) {
+        if (tensor_index == kOptionalTensor) continue;
+        for (int other_index : tensors_of_node[earlier]) {
+          shares_memory |= share_memory(tensor_index, other_index);
+        }
+      }
+      if (shares_memory) dependencies.insert(earlier);
+    }
+    parallel_num_dependencies_[i] = dependencies.size();
+    for (int dependency : dependencies) {
+      parallel_dependents_[dependency].push_back(i);
+    }
+  }
+  parallel_plan_ready_ = true;
+}
+
+struct Subgraph::ParallelInvokeState {
+  explicit ParallelInvokeState(const std::vector<int>& num_dependencies)
+      : num_pending_dependencies(num_dependencies),
+        num_remaining_nodes(num_dependencies.size()) {}
+
+  std::mutex mutex;
+  std::condition_variable all_nodes_done;
+  std::vector<int> num_pending_dependencies;
+  int num_remaining_nodes;
+  TfLiteStatus status = kTfLiteOk;
+  // Held while invoking nodes which use external contexts.
+  std::mutex external_context_mutex;
+};
+
+TfLiteStatus Subgraph::InvokeInParallel() {
+  if (execution_plan_.empty()) return kTfLiteOk;
+  EnsureTensorsVectorCapacity();
+  auto state =
+      std::make_shared<ParallelInvokeState>(parallel_num_dependencies_);
+  for (int i = 0; i < execution_plan_.size(); ++i) {
+    if (parallel_num_dependencies_[i] == 0) {
+      inter_op_thread_pool_->Schedule(
+          [this, state, i]() { InvokeNodesInParallelFrom(state, i); });
+    }
+  }
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->all_nodes_done.wait(
+      lock, [&state]() { return state->num_remaining_nodes == 0; });
+  return state->status;
+}
+
+void Subgraph::InvokeNodesInParallelFrom(
+    std::shared_ptr<ParallelInvokeState> state, int execution_plan_index) {
+  while (execution_plan_index >= 0) {
+    const int node_index = execution_plan_[execution_plan_index];
+    TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+
+    bool failed;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      failed = state->status != kTfLiteOk;
+    }
+    bool cancelled = false;
+    TfLiteStatus node_status = kTfLiteOk;
+    // Once a node failed, the remaining ones are skipped.
+    if (!failed) {
+      if (check_cancelled_func_ != nullptr &&
+          check_cancelled_func_(cancellation_data_)) {
+        cancelled = true;
+      } else if (node_uses_external_context_[execution_plan_index]) {
+        std::lock_guard<std::mutex> lock(state->external_context_mutex);
+        node_status = OpInvoke(registration, &node);
+      } else {
+        node_status = OpInvoke(registration, &node);
+      }
+    }
+
+    int next_execution_plan_index = -1;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->status == kTfLiteOk) {
+      if (cancelled) {
+        ReportError("Client requested cancel during Invoke()");
+        state->status = kTfLiteError;
+      } else if (node_status != kTfLiteOk) {
+        state->status = ReportOpError(&context_, node, registration,
+                                      node_index, "failed to invoke");
+      }
+    }
+    for (int dependent : parallel_dependents_[execution_plan_index]) {
+      if (--state->num_pending_dependencies[dependent] > 0) continue;
+      if (next_execution_plan_index < 0) {
+        next_execution_plan_index = dependent;
+      } else {
+        inter_op_thread_pool_->Schedule([this, state, dependent]() {
+          InvokeNodesInParallelFrom(state, dependent);
+        });
+      }
+    }
+    if (--state->num_remaining_nodes == 0) {
+      state->all_nodes_done.notify_all();
+    }
+    execution_plan_index = next_execution_plan_index;
+  }
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -912,6 +1279,7 @@ TfLiteStatus Subgraph::SetTensorParametersReadOnly(
     tensor.allocation = allocation;
   } else {
     state_ = kStateUninvokable;
+    only_inputs_resized_since_prepare_ = false;
     TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(rank, dims),
                       GetLegacyQuantization(quantization),
                       const_cast<char*>(buffer), bytes, kTfLiteMmapRo,
@@ -962,6 +1330,7 @@ TfLiteStatus Subgraph::SetTensorParametersReadWrite(
   }
 
   TfLiteTensor& tensor = context_.tensors[tensor_index];
+  only_inputs_resized_since_prepare_ = false;
   TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(rank, dims),
                     GetLegacyQuantization(quantization),
                     /*buffer=*/nullptr, required_bytes, allocation_type,
@@ -978,6 +1347,7 @@ TfLiteStatus Subgraph::SetExecutionPlan(const std::vector<int>& new_plan) {
                                   node_index < nodes_and_registration_.size());
   }
   execution_plan_ = new_plan;
+  only_inputs_resized_since_prepare_ = false;
   return kTfLiteOk;
 }
 
@@ -986,7 +1356,8 @@ TfLiteStatus Subgraph::ResizeTensorImpl(TfLiteTensor* tensor,
   // Note that in theory we could resize kTfLiteArenaRwPersistent tensors too.
   if (tensor->allocation_type == kTfLiteArenaRw ||
       tensor->allocation_type == kTfLiteDynamic ||
-      tensor->allocation_type == kTfLiteArenaRwPersistent) {
+      tensor->allocation_type == kTfLiteArenaRwPersistent ||
+      tensor->allocation_type == kTfLiteCustom) {
     tensor_resized_since_op_invoke_ |=
         TfLiteIntArrayEqual(tensor->dims, new_size) == 0;
     if (tensor->type != kTfLiteString) {
@@ -1005,7 +1376,10 @@ TfLiteStatus Subgraph::ResizeTensorImpl(TfLiteTensor* tensor,
     if (tensor->dims) TfLiteIntArrayFree(tensor->dims);
     tensor->dims = new_size;
 
-    if (tensor->allocation_type != kTfLiteDynamic) {
+    // Custom allocations keep their buffer, and are checked against the new
+    // size when the tensors are allocated again.
+    if (tensor->allocation_type != kTfLiteDynamic &&
+        tensor->allocation_type != kTfLiteCustom) {
       tensor->data.raw = nullptr;
     }
   } else {
@@ -1079,6 +1453,7 @@ TfLiteStatus Subgraph::UndoAllDelegates() {
   nodes_and_registration_.resize(max_retained_node_index + 1);
   // After undoing delegates, the graph is uninvokable, but mutable.
   state_ = kStateUninvokable;
+  only_inputs_resized_since_prepare_ = false;
 
   delegates_undone_ = true;
   return kTfLiteOk;
@@ -1140,6 +1515,7 @@ TfLiteStatus Subgraph::ModifyGraphWithDelegate(TfLiteDelegate* delegate) {
 
   // If the memory planner has already been created, we need to execute
   // planning again to account for the updated graph topology.
+  only_inputs_resized_since_prepare_ = false;
   if (memory_planner_) {
     state_ = kStateUninvokable;
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
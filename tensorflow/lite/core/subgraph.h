@@ -16,11 +16,15 @@ limitations under the License.
 #define TENSORFLOW_LITE_CORE_SUBGRAPH_H_
 
 #include <cstdlib>
+#include <map>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/c/c_api_internal.h"
 #include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/util.h"
@@ -60,6 +64,12 @@ class Subgraph {
   // interpreter.
   TfLiteStatus SetVariables(std::vector<int> variables);
 
+  // Provide arena offsets computed ahead of time for the tensors of this
+  // subgraph. The plan is only used if the graph still has the number of nodes
+  // it was computed for, i.e. no delegate has replaced any of them, and must be
+  // set before the first call to AllocateTensors().
+  void SetOfflineArenaPlan(std::unique_ptr<OfflineArenaPlan> plan);
+
   // Ensure the internal node storage memory allocates at least `count`
   // spots for node. NOTE, this doesn't actually add operators. This is an
   // efficiency optimization that is subject to change.
@@ -277,6 +287,20 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   TfLiteStatus ResetVariableTensors();
 
+  // Makes the tensor at `tensor_index` use the `bytes` bytes at `data`, which
+  // the caller owns, instead of memory of the arena. This avoids copying
+  // inputs in and outputs out around Invoke(). `data` must be aligned to
+  // kDefaultTensorAlignment and must outlive the subgraph or the next call
+  // for the same tensor.
+  // Only non-string tensors allocated in the arena can be bound, and only
+  // before a delegate makes the graph immutable. The first time a tensor is
+  // bound, AllocateTensors() has to be called again; later calls only swap
+  // the buffer. AllocateTensors() fails if the tensor grows larger than
+  // `bytes`.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetCustomAllocationForTensor(int tensor_index, void* data,
+                                            size_t bytes);
+
   void SetProfiler(Profiler* profiler) {
     profiler_ = profiler;
     context_.profiler = profiler;
@@ -284,6 +308,18 @@ class Subgraph {
 
   Profiler* GetProfiler() { return profiler_; }
 
+  // Sets the threads on which Invoke() runs independent nodes concurrently, or
+  // null to run them one after the other. Nodes run concurrently only when
+  // all of them have been prepared in advance, none is delegated and there is
+  // no profiler, and after a first Invoke() has run them one after the other.
+  // Nodes that use an external context, e.g. for GEMMs, never run at the same
+  // time as each other. Ownership of `thread_pool` is not taken.
+  // WARNING: This is an experimental API and subject to change.
+  void SetInterOpThreadPool(InterOpThreadPool* thread_pool) {
+    inter_op_thread_pool_ = thread_pool;
+    parallel_plan_ready_ = false;
+  }
+
   // Returns a pointer to vector of subgraphs.
   // WARNING: This is an experimental API and subject to change.
   std::vector<std::unique_ptr<Subgraph>>* GetSubgraphs() { return subgraphs_; }
@@ -293,6 +329,19 @@ class Subgraph {
   // Before `AllocateTensors` is called, this will always return true;
   bool HasDynamicTensors() { return has_dynamic_tensors_; }
 
+  // Returns the bytes reserved by the memory planner for the tensors of this
+  // subgraph, split between the arena reused across nodes and the persistent
+  // arena. Both are 0 before tensors are allocated.
+  // WARNING: This is an experimental API and subject to change.
+  void GetMemoryAllocInfo(size_t* arena_size,
+                          size_t* arena_persist_size) const {
+    *arena_size = 0;
+    *arena_persist_size = 0;
+    if (memory_planner_) {
+      memory_planner_->GetAllocInfo(arena_size, arena_persist_size);
+    }
+  }
+
  private:
   // Prevent 'context_' from accessing functions that are only available to
   // delegated kernels.
@@ -332,6 +381,10 @@ class Subgraph {
   // to wait until Invoke() to resolve the sizes of dynamic tensors.
   TfLiteStatus PrepareOpsAndTensors();
 
+  // Checks that the tensors bound with SetCustomAllocationForTensor() still
+  // fit in their buffers.
+  TfLiteStatus VerifyCustomAllocations();
+
   // Call OpPrepare() for all ops starting at 'first_node'. Stop when a
   // dynamic tensors is found or all ops have been prepared. Fill
   // 'last_node_prepared' with the id of the op containing dynamic tensors, or
@@ -339,6 +392,30 @@ class Subgraph {
   TfLiteStatus PrepareOpsStartingAt(int first_execution_plan_index,
                                     int* last_execution_plan_index_prepared);
 
+  // Returns whether any of the given tensors is in `resized_tensors_`.
+  bool HasResizedTensor(const TfLiteIntArray* tensor_indices) const;
+
+  // Returns whether Invoke() can run independent nodes concurrently.
+  bool CanInvokeInParallel() const;
+
+  // Computes the dependencies between the nodes of the execution plan for
+  // InvokeInParallel(). Besides the producers of its inputs, a node depends on
+  // the earlier nodes using tensors whose memory its outputs and temporaries
+  // reuse, and on the earlier nodes using the same variable tensors.
+  void PlanParallelInvoke();
+
+  // Runs the nodes of the execution plan on `inter_op_thread_pool_`, each as
+  // soon as the nodes it depends on have run.
+  TfLiteStatus InvokeInParallel();
+
+  // Synchronization of the nodes run by InvokeInParallel().
+  struct ParallelInvokeState;
+
+  // Invokes the node at `execution_plan_index`, then the nodes it was the last
+  // dependency of, scheduling all but one of them on the thread pool.
+  void InvokeNodesInParallelFrom(std::shared_ptr<ParallelInvokeState> state,
+                                 int execution_plan_index);
+
   // Tensors needed by the interpreter. Use `AddTensors` to add more blank
   // tensor entries. Note, `tensors_.data()` needs to be synchronized to the
   // `context_` whenever this std::vector is reallocated. Currently this
@@ -553,6 +630,9 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // Arena offsets computed ahead of time, used by memory_planner_ if set.
+  std::unique_ptr<OfflineArenaPlan> offline_arena_plan_;
+
   // Tracking bit for whether a tensor was resized in the course of an op
   // invocation. This is a useful hint to ensure that dynamic tensor outputs
   // trigger downstream reallocation after op invocation.
@@ -570,6 +650,38 @@ class Subgraph {
   // The value is invalid before `PrepareOpStartingAt` is called.
   bool has_dynamic_tensors_ = true;
 
+  // True if all the nodes have been prepared and, since then, only graph
+  // inputs have been resized by `ResizeInputTensor`. `AllocateTensors` then
+  // only prepares again the nodes whose input shapes changed.
+  bool only_inputs_resized_since_prepare_ = false;
+
+  // Indexed by tensor, whether the shape of the tensor changed since the nodes
+  // were last prepared. Empty if all the nodes have to be prepared.
+  std::vector<bool> resized_tensors_;
+
+  // The sizes of the buffers bound with SetCustomAllocationForTensor(), by
+  // tensor index.
+  std::map<int, size_t> custom_allocation_bytes_;
+
+  // Threads used to invoke independent nodes concurrently, if any.
+  InterOpThreadPool* inter_op_thread_pool_ = nullptr;
+
+  // Whether the dependencies below are up to date with the prepared graph.
+  bool parallel_plan_ready_ = false;
+
+  // Indexed by execution plan index: the number of nodes each node depends on,
+  // and the nodes which depend on it.
+  std::vector<int> parallel_num_dependencies_;
+  std::vector<std::vector<int>> parallel_dependents_;
+
+  // Indexed by execution plan index, whether the node called
+  // GetExternalContext() the last time it was invoked sequentially.
+  std::vector<bool> node_uses_external_context_;
+  // Whether GetExternalContext() was called since `external_context_used_` was
+  // last reset, when recording it.
+  bool record_external_context_use_ = false;
+  bool external_context_used_ = false;
+
   // Reference to cancellation function that can cancel a request in the middle
   // of a call to Invoke(). When this function returns True, a kTfLiteError is
   // thrown by Invoke().
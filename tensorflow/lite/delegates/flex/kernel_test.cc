@@ -95,7 +95,7 @@ class KernelTest : public testing::FlexModelTest {
 
  private:
   DelegateData delegate_data_;
-  TfLiteDelegate delegate_;
+  TfLiteDelegate delegate_ = TfLiteDelegateCreate();
 };
 
 TEST_F(KernelTest, FullGraph) {
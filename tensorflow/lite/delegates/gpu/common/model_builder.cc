@@ -91,6 +91,46 @@ void ConvertFloat16ToFloat32(size_t num_elements, const uint16_t* src,
   }
 }
 
+// Dequantizes a constant 8-bit tensor, quantized per tensor or per channel.
+template <typename T>
+Status DequantizeConstantTensor(const TfLiteTensor& tensor, float* dst) {
+  const T* src = reinterpret_cast<const T*>(tensor.data.raw_const);
+  const int num_elements = NumElements(&tensor);
+  const auto* affine =
+      tensor.quantization.type == kTfLiteAffineQuantization
+          ? static_cast<const TfLiteAffineQuantization*>(
+                tensor.quantization.params)
+          : nullptr;
+  if (!affine || !affine->scale || affine->scale->size <= 1) {
+    for (int i = 0; i < num_elements; ++i) {
+      dst[i] = tensor.params.scale * (src[i] - tensor.params.zero_point);
+    }
+    return OkStatus();
+  }
+
+  const int axis = affine->quantized_dimension;
+  const int num_channels = affine->scale->size;
+  if (axis < 0 || axis >= tensor.dims->size ||
+      tensor.dims->data[axis] != num_channels) {
+    return InvalidArgumentError(
+        StrCat("Invalid quantized dimension ", axis, " for ", num_channels,
+               " channels"));
+  }
+  const bool has_zero_points =
+      affine->zero_point && affine->zero_point->size == num_channels;
+  int inner_size = 1;
+  for (int i = axis + 1; i < tensor.dims->size; ++i) {
+    inner_size *= tensor.dims->data[i];
+  }
+  for (int i = 0; i < num_elements; ++i) {
+    const int channel = (i / inner_size) % num_channels;
+    const int zero_point = has_zero_points ? affine->zero_point->data[channel]
+                                           : 0;
+    dst[i] = affine->scale->data[channel] * (src[i] - zero_point);
+  }
+  return OkStatus();
+}
+
 template <>
 Status CreateVectorCopyData<float>(const TfLiteTensor& tensor,
                                    float* tensor_data) {
@@ -104,6 +144,10 @@ Status CreateVectorCopyData<float>(const TfLiteTensor& tensor,
           reinterpret_cast<uint16_t const*>(tensor.data.raw_const),
           tensor_data);
       break;
+    case kTfLiteUInt8:
+      return DequantizeConstantTensor<uint8_t>(tensor, tensor_data);
+    case kTfLiteInt8:
+      return DequantizeConstantTensor<int8_t>(tensor, tensor_data);
     default:
       return InvalidArgumentError("Unsupported data type for float32 tensor");
   }
@@ -2093,6 +2137,16 @@ bool IsAllFloatTensors(const TfLiteContext* context,
   return true;
 }
 
+// Returns whether a Dequantize node with the given input can be removed from
+// the graph by reading its input in place of its output. Constant 8-bit
+// tensors are dequantized when the graph is built, and become fp16 objects
+// on the GPU when precision loss is allowed, like float constants.
+bool IsFoldableDequantizeInput(const TfLiteTensor& tensor) {
+  return tensor.type == kTfLiteFloat16 ||
+         ((tensor.type == kTfLiteUInt8 || tensor.type == kTfLiteInt8) &&
+          IsConstantTensor(&tensor));
+}
+
 std::string GetOpNameByRegistration(const TfLiteRegistration* registration) {
   auto op = registration->builtin_code;
   std::string result =
@@ -2125,7 +2179,8 @@ TfLiteIntArray* GetOpsToReplace(TfLiteContext* context) {
   TfLiteIntArray* subgraph = TfLiteIntArrayCreate(execution_plan->size);
   std::vector<int> pruned_graph;
   subgraph->size = 0;
-  // pruned_graph will not include dequantize operations.
+  // pruned_graph will not include dequantize operations of fp16 and constant
+  // 8-bit tensors.
   std::set<std::string> errors;
 
   // Map the output tensor of a Dequantize nodes to its input tensor.
@@ -2140,8 +2195,7 @@ TfLiteIntArray* GetOpsToReplace(TfLiteContext* context) {
       return nullptr;
     }
     if (registration->builtin_code == kTfLiteBuiltinDequantize &&
-        context->tensors[node->inputs->data[0]].type ==
-            TfLiteType::kTfLiteFloat16) {
+        IsFoldableDequantizeInput(context->tensors[node->inputs->data[0]])) {
       // Record the output->input mapping for the op.
       node_map[node->outputs->data[0]] = node->inputs->data[0];
     } else {
@@ -347,6 +347,123 @@ TEST(ModelBuilderTest, GetOpsToReplaceDoesNotPruneUint8) {
   TfLiteIntArrayFree(ops_to_replace);
 }
 
+class InterpreterConstUint8 {
+ public:
+  InterpreterConstUint8() {
+    void* builtin_data = malloc(sizeof(int));
+    EXPECT_EQ(interpreter_.AddTensors(4), kTfLiteOk);
+    EXPECT_EQ(interpreter_.SetInputs({2}), kTfLiteOk);
+    EXPECT_EQ(interpreter_.SetOutputs({3}), kTfLiteOk);
+
+    // Add a Dequantize Node with constant uint8 input.
+    const TfLiteRegistration reg_dequant0 = {/*init=*/nullptr,
+                                             /*free=*/nullptr,
+                                             /*prepare=*/nullptr,
+                                             /*invoke=*/nullptr,
+                                             /*profiling_string=*/nullptr,
+                                             kTfLiteBuiltinDequantize};
+    EXPECT_EQ(interpreter_.AddNodeWithParameters(
+                  /*inputs=*/{0}, /*outputs=*/{1}, /*init_data=*/nullptr,
+                  /*init_data_size=*/0, /*builtin_data=*/nullptr,
+                  /*registration=*/&reg_dequant0),
+              kTfLiteOk);
+
+    // Add a node that GPU delegate can parse.
+    const TfLiteRegistration reg_add0 = {
+        [](TfLiteContext* context, const char* buffer, size_t length) {
+          return reinterpret_cast<void*>(new int(1));
+        },
+        [](TfLiteContext* context, void* buffer) {
+          delete reinterpret_cast<int*>(buffer);
+        },
+        nullptr,
+        nullptr,
+        nullptr,
+        kTfLiteBuiltinAdd};
+    EXPECT_EQ(interpreter_.AddNodeWithParameters(
+                  /*inputs=*/{1, 2}, /*outputs=*/{3}, /*init_data=*/nullptr,
+                  /*init_data_size=*/0,
+                  /*builtin_data=*/builtin_data,
+                  /*registration=*/&reg_add0),
+              kTfLiteOk);
+
+    const std::vector<int> dims = {1};
+    TfLiteQuantization no_quantization;
+    no_quantization.type = kTfLiteNoQuantization;
+    EXPECT_EQ(interpreter_.SetTensorParametersReadOnly(
+                  0, TfLiteType::kTfLiteUInt8, "t0", dims,
+                  TfLiteQuantizationParams{/*scale=*/0.5f, /*zero_point=*/128},
+                  reinterpret_cast<const char*>(&weight_), sizeof(weight_)),
+              kTfLiteOk);
+    EXPECT_EQ(interpreter_.SetTensorParametersReadWrite(
+                  1, TfLiteType::kTfLiteFloat32, "t1", dims, no_quantization,
+                  false),
+              kTfLiteOk);
+    EXPECT_EQ(interpreter_.SetTensorParametersReadWrite(
+                  2, TfLiteType::kTfLiteFloat32, "t2", dims, no_quantization,
+                  false),
+              kTfLiteOk);
+    exec_plan_ = TfLiteIntArrayCreate(2);
+    exec_plan_->data[0] = 0;
+    exec_plan_->data[1] = 1;
+  }
+
+  ~InterpreterConstUint8() { TfLiteIntArrayFree(exec_plan_); }
+
+  Subgraph* GetSubgraph() { return interpreter_.subgraph(0); }
+  TfLiteIntArray* exec_plan() const { return exec_plan_; }
+
+ private:
+  const uint8_t weight_ = 130;
+  Interpreter interpreter_;
+  TfLiteIntArray* exec_plan_;
+};
+
+InterpreterConstUint8* interpreter_const_uint8 = new InterpreterConstUint8();
+
+TEST(ModelBuilderTest, GetOpsToReplacePrunesConstUint8DequantizeNodes) {
+  // A Dequant node with a constant uint8 input is pruned, and its input is
+  // dequantized when the GPU graph is built:
+  //
+  //   t0 (const uint8) --> Dequant --> t1 (FP32) --> Add -> t3
+  //                                    t2 (FP32) --/
+  //
+  // becomes
+  //
+  //   t0 (const uint8) --> Add -> t3
+  //   t2 (FP32) ---------/
+  //
+  TfLiteContext* context = interpreter_const_uint8->GetSubgraph()->context();
+
+  // These functions are meant to be called inside delegates. Swap out
+  // for similar functions to permit direct calling of GetOpsToReplace.
+  context->GetExecutionPlan = [](struct TfLiteContext* context,
+                                 TfLiteIntArray** execution_plan) {
+    *execution_plan = interpreter_const_uint8->exec_plan();
+    return kTfLiteOk;
+  };
+  context->GetNodeAndRegistration = [](struct TfLiteContext*, int node_index,
+                                       TfLiteNode** node,
+                                       TfLiteRegistration** registration) {
+    auto& node_and_reg = interpreter_const_uint8->GetSubgraph()
+                             ->nodes_and_registration()[node_index];
+    *node = &node_and_reg.first;
+    *registration = &node_and_reg.second;
+    return kTfLiteOk;
+  };
+
+  TfLiteIntArray* ops_to_replace = GetOpsToReplace(context);
+
+  EXPECT_EQ(ops_to_replace->size, 1);
+  TfLiteNode* node = nullptr;
+  TfLiteRegistration* registration = nullptr;
+  context->GetNodeAndRegistration(context, ops_to_replace->data[0], &node,
+                                  &registration);
+  EXPECT_EQ(context->tensors[node->inputs->data[0]].type,
+            TfLiteType::kTfLiteUInt8);
+  TfLiteIntArrayFree(ops_to_replace);
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace tflite
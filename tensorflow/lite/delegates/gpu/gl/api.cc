@@ -31,6 +31,8 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/common/util.h"
 #include "tensorflow/lite/delegates/gpu/gl/compiler.h"
 #include "tensorflow/lite/delegates/gpu/gl/gl_call.h"
+#include "tensorflow/lite/delegates/gpu/gl/gl_program.h"
+#include "tensorflow/lite/delegates/gpu/gl/gl_shader.h"
 #include "tensorflow/lite/delegates/gpu/gl/gpu_info.h"
 #include "tensorflow/lite/delegates/gpu/gl/object.h"
 #include "tensorflow/lite/delegates/gpu/gl/portable_gl31.h"
@@ -210,8 +212,8 @@ class CompiledModelImpl
 
     // Store full shader and compile it if necessary.
     size_t shader_idx;
-    RETURN_IF_ERROR(
-        AddFullShader(code.source_code, workgroup_size, &shader_idx));
+    RETURN_IF_ERROR(AddFullShader(code.source_code, workgroup_size,
+                                  /*binary=*/nullptr, &shader_idx));
     programs_.push_back({
         std::move(code.parameters),
         std::move(code.objects),
@@ -222,16 +224,23 @@ class CompiledModelImpl
     return OkStatus();
   }
 
-  // Store full shader and compile it if necessary.
+  // Store full shader and compile it if necessary. If a binary of the linked
+  // program is given and the driver accepts it, compilation is skipped.
   // Returns full_shader_index
   Status AddFullShader(const std::string& partial_shader,
-                       const uint3& workgroup_size, size_t* size) {
+                       const uint3& workgroup_size, const BinaryShader* binary,
+                       size_t* size) {
     std::string shader_src = GetShaderHeader(workgroup_size) + partial_shader;
     auto it = shader_to_index_.find(shader_src);
     if (it == shader_to_index_.end()) {
       GlShader shader;
-      RETURN_IF_ERROR(
-          GlShader::CompileShader(GL_COMPUTE_SHADER, shader_src, &shader));
+      GlProgram program;
+      if (binary && GlProgram::CreateWithBinaryShader(*binary, &program).ok()) {
+        shader_binaries_.emplace(shaders_.size(), *binary);
+      } else {
+        RETURN_IF_ERROR(
+            GlShader::CompileShader(GL_COMPUTE_SHADER, shader_src, &shader));
+      }
       shaders_.push_back(std::move(shader));
       shader_to_index_.insert({shader_src, shader_to_index_.size()});
       *size = shader_to_index_.size() - 1;
@@ -261,8 +270,15 @@ class CompiledModelImpl
     auto runtime = absl::make_unique<Runtime>(options, gpu_info_, command_queue,
                                               refs ? refs.get() : objects);
     for (auto& c : programs_) {
-      RETURN_IF_ERROR(runtime->AddProgram(shaders_[c.shader_idx], c.parameters,
-                                          c.objects, c.num_workgroups));
+      auto binary = shader_binaries_.find(c.shader_idx);
+      if (binary != shader_binaries_.end()) {
+        RETURN_IF_ERROR(runtime->AddProgram(binary->second, c.parameters,
+                                            c.objects, c.num_workgroups));
+      } else {
+        RETURN_IF_ERROR(runtime->AddProgram(shaders_[c.shader_idx],
+                                            c.parameters, c.objects,
+                                            c.num_workgroups));
+      }
     }
     RETURN_IF_ERROR(runtime->PrepareForExecution());
     if (dynamic_batch_) {
@@ -280,7 +296,8 @@ class CompiledModelImpl
   Status OnProgram(const std::vector<UniformParameter>& parameters,
                    const std::vector<Object>& objects,
                    const uint3& workgroup_size, const uint3& num_workgroups,
-                   size_t partial_shader_index) final {
+                   size_t partial_shader_index,
+                   const BinaryShader* binary) final {
     for (auto& object : objects) {
       if (IsRef(object)) {
         object_sizes_[GetRef(object)] = ByteSizeOf(object);
@@ -289,7 +306,7 @@ class CompiledModelImpl
 
     size_t shader_idx;
     RETURN_IF_ERROR(AddFullShader(partial_shaders_[partial_shader_index],
-                                  workgroup_size, &shader_idx));
+                                  workgroup_size, binary, &shader_idx));
     programs_.push_back({
         parameters,
         objects,
@@ -312,6 +329,8 @@ class CompiledModelImpl
 
     std::unordered_map<std::string, size_t> partial_shader_to_index;
     std::vector<std::string> partial_shaders;
+    // Program binaries are stored once per full shader.
+    std::unordered_set<size_t> shaders_with_binary;
     for (const auto& program : programs_) {
       // Remove a header from a shader.
       std::string shader_without_header = full_shaders[program.shader_idx];
@@ -328,9 +347,13 @@ class CompiledModelImpl
       } else {
         shader_idx = it->second;
       }
+      std::unique_ptr<BinaryShader> binary;
+      if (shaders_with_binary.insert(program.shader_idx).second) {
+        binary = GetProgramBinary(program.shader_idx);
+      }
       builder.AddProgram(program.parameters, program.objects,
                          program.workgroup_size, program.num_workgroups,
-                         shader_idx);
+                         shader_idx, binary.get());
     }
     CompiledModelOptions options;
     options.dynamic_batch = dynamic_batch_;
@@ -349,6 +372,22 @@ class CompiledModelImpl
   void OnOptions(const CompiledModelOptions& options) final {
     dynamic_batch_ = options.dynamic_batch;
   }
+
+  // Returns a binary of the program linked from the given full shader, or
+  // nullptr if the driver does not provide one.
+  std::unique_ptr<BinaryShader> GetProgramBinary(size_t shader_idx) const {
+    auto it = shader_binaries_.find(shader_idx);
+    if (it != shader_binaries_.end()) {
+      return absl::make_unique<BinaryShader>(it->second);
+    }
+    GlProgram program;
+    BinaryShader binary(0, {});
+    if (!GlProgram::CreateWithShader(shaders_[shader_idx], &program).ok() ||
+        !program.GetBinary(&binary).ok()) {
+      return nullptr;
+    }
+    return absl::make_unique<BinaryShader>(std::move(binary));
+  }
 #endif  // TFLITE_GPU_BINARY_RELEASE
 
   CompilerStats stats() const final { return stats_; }
@@ -360,7 +399,10 @@ class CompiledModelImpl
   bool dynamic_batch_ = false;
 
   std::vector<std::string> partial_shaders_;
+  // Shaders restored from program binaries are left uncompiled.
   std::vector<GlShader> shaders_;
+  // Binaries of the linked programs, by full shader index.
+  std::unordered_map<size_t, BinaryShader> shader_binaries_;
 
   // Shaders are serialized in order of their indices.
   std::unordered_map<std::string, size_t> shader_to_index_;
@@ -57,7 +57,9 @@ class CompiledModel {
       std::unique_ptr<InferenceContext>* inference_context) const = 0;
 
 #ifndef TFLITE_GPU_BINARY_RELEASE
-  // Serializes compiled model to a string.
+  // Serializes compiled model to a string. Binaries of the linked programs
+  // are included when the driver provides them, so this needs to be called
+  // from the EGL context the model was created in.
   // @return true if serialization finished successfully.
   virtual Status Serialize(
       std::vector<uint8_t>* serialized_compiled_model) const = 0;
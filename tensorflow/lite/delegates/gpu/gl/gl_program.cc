@@ -111,6 +111,11 @@ Status GlProgram::CreateWithShader(const GlShader& shader,
 
   RETURN_IF_ERROR(
       TFLITE_GPU_CALL_GL(glAttachShader, program.id(), shader.id()));
+  // Some drivers only keep a binary of a program that asked for it before
+  // linking.
+  RETURN_IF_ERROR(TFLITE_GPU_CALL_GL(glProgramParameteri, program.id(),
+                                     GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                     GL_TRUE));
   RETURN_IF_ERROR(TFLITE_GPU_CALL_GL(glLinkProgram, program.id()));
   RETURN_IF_ERROR(CheckProgramLinked(program.id()));
 
@@ -143,9 +148,6 @@ Status GlProgram::GetBinary(BinaryShader* binary_shader) {
   if (!size) {
     return InternalError("Getting binary size failed.");
   }
-  // TODO(akulik): call
-  // glProgramParameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE)
-  // before linking a program to increase chances of retrieving a binary.
   std::vector<uint8_t> binary(size);
   GLsizei returned_size;
   GLenum format;
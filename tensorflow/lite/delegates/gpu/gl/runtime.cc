@@ -192,13 +192,29 @@ Status Runtime::AddProgram(const GlShader& shader,
                            const uint3& num_workgroups) {
   GlProgram program;
   RETURN_IF_ERROR(GlProgram::CreateWithShader(shader, &program));
+  return AddLinkedProgram(std::move(program), parameters, objects,
+                          num_workgroups);
+}
+
+Status Runtime::AddProgram(const BinaryShader& binary,
+                           const std::vector<UniformParameter>& parameters,
+                           const std::vector<Object>& objects,
+                           const uint3& num_workgroups) {
+  GlProgram program;
+  RETURN_IF_ERROR(GlProgram::CreateWithBinaryShader(binary, &program));
+  return AddLinkedProgram(std::move(program), parameters, objects,
+                          num_workgroups);
+}
 
+Status Runtime::AddLinkedProgram(
+    GlProgram gl_program, const std::vector<UniformParameter>& parameters,
+    const std::vector<Object>& objects, const uint3& num_workgroups) {
   for (auto& parameter : parameters) {
-    RETURN_IF_ERROR(program.SetParameter(parameter));
+    RETURN_IF_ERROR(gl_program.SetParameter(parameter));
   }
 
   programs_.emplace_back(
-      CompiledProgramDescriptor{std::move(program), num_workgroups, {}});
+      CompiledProgramDescriptor{std::move(gl_program), num_workgroups, {}});
 
   // Create const buffers, resolve external references and collect internal
   // buffer references.
@@ -49,6 +49,13 @@ class Runtime {
                     const std::vector<Object>& objects,
                     const uint3& num_workgroups);
 
+  // Same as above, but creates GL program from a binary previously returned by
+  // GlProgram::GetBinary, therefore the program is not linked again.
+  Status AddProgram(const BinaryShader& binary,
+                    const std::vector<UniformParameter>& parameters,
+                    const std::vector<Object>& objects,
+                    const uint3& num_workgroups);
+
   // Needs to be called once all programs and shaders has been added to runtime.
   Status PrepareForExecution();
 
@@ -70,6 +77,11 @@ class Runtime {
   }
 
  private:
+  Status AddLinkedProgram(GlProgram gl_program,
+                          const std::vector<UniformParameter>& parameters,
+                          const std::vector<Object>& objects,
+                          const uint3& num_workgroups);
+
   Status AllocateInternalObject(const Object& object);
 
   Status AllocateConstObject(const Object& object, uint32_t* id);
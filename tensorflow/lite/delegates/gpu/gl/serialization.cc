@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/lite/delegates/gpu/gl/serialization.h"
 
+#include <memory>
+
+#include "absl/memory/memory.h"
 #include "absl/types/variant.h"
 #include "tensorflow/lite/delegates/gpu/common/data_type.h"
 #include "tensorflow/lite/delegates/gpu/common/status.h"
@@ -278,7 +281,8 @@ void SerializedCompiledModelBuilder::AddShader(const std::string& shader_src) {
 void SerializedCompiledModelBuilder::AddProgram(
     const std::vector<UniformParameter>& parameters,
     const std::vector<Object>& objects, const uint3& workgroup_size,
-    const uint3& num_workgroups, size_t shader_index) {
+    const uint3& num_workgroups, size_t shader_index,
+    const BinaryShader* binary) {
   Offset<data::Uint3> fb_workgroups = Encode(num_workgroups, &builder_);
   Offset<data::Uint3> fb_workgroup_size = Encode(workgroup_size, &builder_);
 
@@ -319,12 +323,24 @@ void SerializedCompiledModelBuilder::AddProgram(
     fb_objects = builder_.CreateVector(offsets);
   }
 
+  Offset<data::ProgramBinary> fb_binary;
+  if (binary) {
+    auto fb_binary_data = builder_.CreateVector(binary->binary());
+    data::ProgramBinaryBuilder binary_builder(builder_);
+    binary_builder.add_format(binary->format());
+    binary_builder.add_binary(fb_binary_data);
+    fb_binary = binary_builder.Finish();
+  }
+
   data::ProgramBuilder program_builder(builder_);
   program_builder.add_number_workgroups(fb_workgroups);
   program_builder.add_workgroup_size(fb_workgroup_size);
   program_builder.add_parameters(fb_params);
   program_builder.add_objects(fb_objects);
   program_builder.add_shader_index(shader_index);
+  if (binary) {
+    program_builder.add_binary(fb_binary);
+  }
   programs_.push_back(program_builder.Finish());
 }
 
@@ -560,9 +576,16 @@ Status DeserializeCompiledModel(absl::Span<const uint8_t> serialized,
     uint3 num_workgroups(program->number_workgroups()->x(),
                          program->number_workgroups()->y(),
                          program->number_workgroups()->z());
+    std::unique_ptr<BinaryShader> binary;
+    if (program->binary() && program->binary()->binary()) {
+      auto fb_binary = program->binary()->binary();
+      binary = absl::make_unique<BinaryShader>(
+          program->binary()->format(),
+          std::vector<uint8_t>(fb_binary->begin(), fb_binary->end()));
+    }
     RETURN_IF_ERROR(handler->OnProgram(parameters, objects, workgroup_size,
-                                       num_workgroups,
-                                       program->shader_index()));
+                                       num_workgroups, program->shader_index(),
+                                       binary.get()));
   }
   handler->OnOptions(ParseParameters(*model->parameters()));
   return OkStatus();
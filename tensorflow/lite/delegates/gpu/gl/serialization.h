@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/common/status.h"
 #include "tensorflow/lite/delegates/gpu/common/types.h"
 #include "tensorflow/lite/delegates/gpu/gl/compiled_model_generated.h"
+#include "tensorflow/lite/delegates/gpu/gl/gl_shader.h"
 #include "tensorflow/lite/delegates/gpu/gl/object.h"
 #include "tensorflow/lite/delegates/gpu/gl/uniform_parameter.h"
 
@@ -46,10 +47,12 @@ class SerializedCompiledModelBuilder {
 
   void AddShader(const std::string& shader_src);
 
+  // `binary` is optional and holds the linked program, so that it can be
+  // restored without compiling the shader again.
   void AddProgram(const std::vector<UniformParameter>& parameters,
                   const std::vector<Object>& objects,
                   const uint3& workgroup_size, const uint3& num_workgroups,
-                  size_t shader_index);
+                  size_t shader_index, const BinaryShader* binary);
 
   // Returns serialized data that will stay valid until this object is
   // destroyed.
@@ -73,7 +76,8 @@ class DeserializationHandler {
                            const std::vector<Object>& objects,
                            const uint3& workgroup_size,
                            const uint3& num_workgroups,
-                           size_t shader_index) = 0;
+                           size_t shader_index,
+                           const BinaryShader* binary) = 0;
 
   virtual void OnOptions(const CompiledModelOptions& options) = 0;
 };
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/common/shape.h"
 #include "tensorflow/lite/delegates/gpu/common/status.h"
 #include "tensorflow/lite/delegates/gpu/common/types.h"
+#include "tensorflow/lite/delegates/gpu/gl/gl_shader.h"
 #include "tensorflow/lite/delegates/gpu/gl/object.h"
 #include "tensorflow/lite/delegates/gpu/gl/uniform_parameter.h"
 
@@ -41,6 +42,7 @@ struct ProgramDesc {
   uint3 workgroup_size;
   uint3 num_workgroups;
   size_t shader_index;
+  std::vector<uint8_t> binary;
 };
 
 struct Handler : public DeserializationHandler {
@@ -52,9 +54,10 @@ struct Handler : public DeserializationHandler {
   Status OnProgram(const std::vector<UniformParameter>& parameters,
                    const std::vector<Object>& objects,
                    const uint3& workgroup_size, const uint3& num_workgroups,
-                   size_t shader_index) final {
+                   size_t shader_index, const BinaryShader* binary) final {
     programs.push_back(
-        {parameters, objects, workgroup_size, num_workgroups, shader_index});
+        {parameters, objects, workgroup_size, num_workgroups, shader_index,
+         binary ? binary->binary() : std::vector<uint8_t>()});
     return OkStatus();
   }
 
@@ -159,7 +162,10 @@ TEST(Smoke, Read) {
                            std::vector<uint8_t>{7, 9}});
   uint3 num_workgroups(10, 20, 30);
   uint3 workgroup_size(1, 2, 3);
-  builder.AddProgram(parameters, objects, workgroup_size, num_workgroups, 1);
+  builder.AddProgram(parameters, objects, workgroup_size, num_workgroups, 1,
+                     nullptr);
+  BinaryShader binary(/*format=*/42, {1, 2, 3});
+  builder.AddProgram({}, {}, workgroup_size, num_workgroups, 0, &binary);
 
   Handler handler;
   CompiledModelOptions options;
@@ -177,6 +183,10 @@ TEST(Smoke, Read) {
   for (int i = 0; i < objects.size(); ++i) {
     EXPECT_TRUE(Eq(objects[i], handler.programs[0].objects[i])) << i;
   }
+  EXPECT_TRUE(handler.programs[0].binary.empty());
+  ASSERT_EQ(2, handler.programs.size());
+  EXPECT_EQ(0, handler.programs[1].shader_index);
+  EXPECT_THAT(handler.programs[1].binary, ::testing::ElementsAre(1, 2, 3));
   EXPECT_TRUE(handler.options.dynamic_batch);
 }
 
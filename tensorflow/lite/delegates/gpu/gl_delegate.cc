@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <string>
 #include <unordered_set>
@@ -24,6 +25,7 @@ limitations under the License.
 
 #include <EGL/egl.h>
 #include <GLES3/gl31.h>
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/c_api_internal.h"
@@ -72,6 +74,111 @@ inline bool IsPHWC4(const BHWC& shape) {
   return shape.c == 4 || (shape.h == 1 && shape.w == 1 && shape.c % 4 == 0);
 }
 
+#ifndef TFLITE_GPU_BINARY_RELEASE
+// Bump when the layout of cached models changes.
+constexpr uint64_t kCacheVersion = 1;
+
+// FNV-1a, which unlike std::hash gives the same value in every process.
+class Fingerprint {
+ public:
+  void Add(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      value_ = (value_ ^ bytes[i]) * 1099511628211ULL;
+    }
+  }
+  void Add(uint64_t value) { Add(&value, sizeof(value)); }
+  void Add(const std::string& value) {
+    Add(value.size());
+    Add(value.data(), value.size());
+  }
+
+  uint64_t value() const { return value_; }
+
+ private:
+  uint64_t value_ = 14695981039346656037ULL;
+};
+
+// Identifies a compiled model by everything that goes into compiling it: the
+// model, the delegated subgraph, the delegate options and the GPU and driver.
+uint64_t GetCacheKey(const TfLiteGpuDelegateOptions& options,
+                     const GpuInfo& gpu_info, const GraphFloat32& graph) {
+  Fingerprint fingerprint;
+  fingerprint.Add(kCacheVersion);
+  fingerprint.Add(std::string(options.model_token));
+  fingerprint.Add(options.metadata != nullptr);
+  fingerprint.Add(options.compile_options.precision_loss_allowed);
+  fingerprint.Add(options.compile_options.preferred_gl_object_type);
+  fingerprint.Add(options.compile_options.dynamic_batch_enabled);
+  fingerprint.Add(gpu_info.vendor_name);
+  fingerprint.Add(gpu_info.renderer_name);
+  fingerprint.Add(gpu_info.version);
+  for (auto node : graph.nodes()) {
+    fingerprint.Add(node->operation.type);
+  }
+  for (auto value : graph.values()) {
+    fingerprint.Add(value->id);
+    fingerprint.Add(value->tensor.ref);
+    const BHWC& shape = value->tensor.shape;
+    fingerprint.Add(shape.b);
+    fingerprint.Add(shape.h);
+    fingerprint.Add(shape.w);
+    fingerprint.Add(shape.c);
+  }
+  return fingerprint.value();
+}
+
+// Cache files start with the key they were written for and a fingerprint of
+// the serialized model that follows, so that stale or truncated files are
+// never loaded.
+Status ReadCacheFile(const std::string& path, uint64_t key,
+                     std::vector<uint8_t>* serialized_model) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return NotFoundError(absl::StrCat("Can't open ", path));
+  }
+  uint64_t header[2];
+  bool ok = fread(header, sizeof(header), 1, file) == 1 && header[0] == key;
+  serialized_model->clear();
+  uint8_t buffer[4096];
+  size_t size;
+  while (ok && (size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    serialized_model->insert(serialized_model->end(), buffer, buffer + size);
+  }
+  ok = ok && !ferror(file);
+  fclose(file);
+  Fingerprint fingerprint;
+  fingerprint.Add(serialized_model->data(), serialized_model->size());
+  if (!ok || fingerprint.value() != header[1]) {
+    return InvalidArgumentError(absl::StrCat(path, " is not a valid cache"));
+  }
+  return OkStatus();
+}
+
+Status WriteCacheFile(const std::string& path, uint64_t key,
+                      const std::vector<uint8_t>& serialized_model) {
+  Fingerprint fingerprint;
+  fingerprint.Add(serialized_model.data(), serialized_model.size());
+  const uint64_t header[2] = {key, fingerprint.value()};
+  // Write to a temporary file first, so that a concurrent reader never sees a
+  // partially written cache.
+  const std::string temp_path = path + ".tmp";
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (!file) {
+    return UnavailableError(absl::StrCat("Can't create ", temp_path));
+  }
+  bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+            fwrite(serialized_model.data(), 1, serialized_model.size(),
+                   file) == serialized_model.size();
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(temp_path.c_str(), path.c_str()) != 0) {
+    remove(temp_path.c_str());
+    return UnavailableError(absl::StrCat("Can't write ", path));
+  }
+  return OkStatus();
+}
+#endif  // TFLITE_GPU_BINARY_RELEASE
+
 class Delegate {
   struct ValueRef {
     BHWC shape;
@@ -89,6 +196,18 @@ class Delegate {
       options_.compile_options.preferred_gl_object_type =
           TFLITE_GL_OBJECT_TYPE_FASTEST;
       options_.compile_options.dynamic_batch_enabled = 0;
+      options_.serialization_dir = nullptr;
+      options_.model_token = nullptr;
+    }
+    // Keep own copies, the caller may free the strings once this returns.
+    if (options_.serialization_dir && options_.model_token) {
+      serialization_dir_ = options_.serialization_dir;
+      model_token_ = options_.model_token;
+      options_.serialization_dir = serialization_dir_.c_str();
+      options_.model_token = model_token_.c_str();
+    } else {
+      options_.serialization_dir = nullptr;
+      options_.model_token = nullptr;
     }
   }
 
@@ -264,8 +383,42 @@ class Delegate {
     auto workgroups_calculator =
         BestEffortWorkgroupsCalculator(options_.metadata, gpu_info);
     std::unique_ptr<CompiledModel> compiled_model;
-    RETURN_IF_ERROR(Compile(compile_options, graph, tflite_graph_io, *shaders,
-                            *workgroups_calculator, &compiled_model));
+#ifndef TFLITE_GPU_BINARY_RELEASE
+    // Try to load the model compiled by an earlier delegate.
+    std::string cache_path;
+    uint64_t cache_key = 0;
+    if (options_.serialization_dir && options_.model_token) {
+      cache_key = GetCacheKey(options_, gpu_info, graph);
+      cache_path = absl::StrCat(options_.serialization_dir, "/gl_delegate_",
+                                absl::Hex(cache_key, absl::kZeroPad16),
+                                ".bin");
+      std::vector<uint8_t> serialized_model;
+      if (!ReadCacheFile(cache_path, cache_key, &serialized_model).ok() ||
+          !ReadSerializedModel(serialized_model, &compiled_model).ok()) {
+        compiled_model.reset();
+      }
+    }
+#endif  // TFLITE_GPU_BINARY_RELEASE
+    if (!compiled_model) {
+      RETURN_IF_ERROR(Compile(compile_options, graph, tflite_graph_io,
+                              *shaders, *workgroups_calculator,
+                              &compiled_model));
+#ifndef TFLITE_GPU_BINARY_RELEASE
+      if (!cache_path.empty()) {
+        // Caching is best effort, the model is usable either way.
+        std::vector<uint8_t> serialized_model;
+        Status status = compiled_model->Serialize(&serialized_model);
+        if (status.ok()) {
+          status = WriteCacheFile(cache_path, cache_key, serialized_model);
+        }
+        if (!status.ok()) {
+          TFLITE_LOG_PROD(TFLITE_LOG_WARNING,
+                          "TfLiteGpuDelegate failed to cache model: %s",
+                          status.error_message().c_str());
+        }
+      }
+#endif  // TFLITE_GPU_BINARY_RELEASE
+    }
 
     // Create inference context.
     const RuntimeOptions runtime_options;
@@ -356,6 +509,8 @@ class Delegate {
   };
 
   TfLiteGpuDelegateOptions options_;
+  std::string serialization_dir_;
+  std::string model_token_;
 
   std::unique_ptr<EglEnvironment> env_;
   std::vector<ValueRef> tensors_;  // indexed by ValueId
@@ -74,6 +74,14 @@ struct TFL_CAPI_EXPORT TfLiteGlCompileOptions {
 struct TFL_CAPI_EXPORT TfLiteGpuDelegateOptions {
   const uint8_t* metadata;  // Internal.
   TfLiteGlCompileOptions compile_options;
+
+  // When both are set, compiled models and their GL program binaries are
+  // cached in `serialization_dir`, which must be writable and private to the
+  // app. Later delegates load them from there instead of compiling shaders.
+  // `model_token` identifies the model and must change whenever the model
+  // does. The cache is also keyed by GPU, driver and compile options.
+  const char* serialization_dir;
+  const char* model_token;
 };
 // LINT.ThenChange(//tensorflow/lite/delegates/gpu/java/src/main/java/org/tensorflow/lite/gpu/GpuDelegate.java)
 
@@ -86,6 +94,8 @@ struct TFL_CAPI_EXPORT TfLiteGpuDelegateOptions {
 //   .preferred_gl_object_type = TFLITE_GL_OBJECT_TYPE_FASTEST,
 //   .dynamic_batch_enabled = false,
 // },
+// .serialization_dir = nullptr,
+// .model_token = nullptr,
 TFL_CAPI_EXPORT TfLiteDelegate* TfLiteGpuDelegateCreate(
     const TfLiteGpuDelegateOptions* options);
 
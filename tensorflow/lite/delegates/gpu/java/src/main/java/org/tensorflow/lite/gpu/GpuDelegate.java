@@ -98,7 +98,23 @@ public class GpuDelegate implements Delegate, Closeable {
       return this;
     }
 
+    /**
+     * Enables caching of compiled models, which makes creating a delegate for the same model much
+     * faster after the first time.
+     *
+     * @param serializationDir a directory private to the app, e.g. {@code
+     *     Context.getCodeCacheDir()}, to store compiled models in.
+     * @param modelToken identifies the model, and must change whenever the model does.
+     */
+    public Options setSerializationParams(String serializationDir, String modelToken) {
+      this.serializationDir = serializationDir;
+      this.modelToken = modelToken;
+      return this;
+    }
+
     CompileOptions compileOptions = DEFAULT_COMPILE_OPTIONS;
+    String serializationDir = null;
+    String modelToken = null;
   }
 
   public GpuDelegate(Options options) {
@@ -106,7 +122,9 @@ public class GpuDelegate implements Delegate, Closeable {
         createDelegate(
             options.compileOptions.precisionLossAllowed,
             options.compileOptions.dynamicBatchEnabled,
-            options.compileOptions.preferredGlObjectType);
+            options.compileOptions.preferredGlObjectType,
+            options.serializationDir,
+            options.modelToken);
   }
 
   public GpuDelegate() {
@@ -156,7 +174,11 @@ public class GpuDelegate implements Delegate, Closeable {
   }
 
   private static native long createDelegate(
-      boolean precisionLossAllowed, boolean dynamicBatchEnabled, int preferredGlObjectType);
+      boolean precisionLossAllowed,
+      boolean dynamicBatchEnabled,
+      int preferredGlObjectType,
+      String serializationDir,
+      String modelToken);
 
   private static native void deleteDelegate(long delegateHandle);
 
@@ -23,7 +23,8 @@ extern "C" {
 
 JNIEXPORT jlong JNICALL Java_org_tensorflow_lite_gpu_GpuDelegate_createDelegate(
     JNIEnv* env, jclass clazz, jboolean precision_loss_allowed,
-    jboolean dynamic_batch_enabled, jint preferred_gl_object_type) {
+    jboolean dynamic_batch_enabled, jint preferred_gl_object_type,
+    jstring serialization_dir, jstring model_token) {
   TfLiteGpuDelegateOptions options;
   options.metadata = nullptr;
   options.compile_options.precision_loss_allowed =
@@ -32,7 +33,20 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_lite_gpu_GpuDelegate_createDelegate(
       static_cast<int32_t>(preferred_gl_object_type);
   options.compile_options.dynamic_batch_enabled =
       dynamic_batch_enabled == JNI_TRUE ? 1 : 0;
-  return reinterpret_cast<jlong>(TfLiteGpuDelegateCreate(&options));
+  options.serialization_dir =
+      serialization_dir ? env->GetStringUTFChars(serialization_dir, nullptr)
+                        : nullptr;
+  options.model_token =
+      model_token ? env->GetStringUTFChars(model_token, nullptr) : nullptr;
+  // The delegate keeps its own copies of the strings.
+  auto* delegate = TfLiteGpuDelegateCreate(&options);
+  if (options.serialization_dir) {
+    env->ReleaseStringUTFChars(serialization_dir, options.serialization_dir);
+  }
+  if (options.model_token) {
+    env->ReleaseStringUTFChars(model_token, options.model_token);
+  }
+  return reinterpret_cast<jlong>(delegate);
 }
 
 JNIEXPORT void JNICALL Java_org_tensorflow_lite_gpu_GpuDelegate_deleteDelegate(
@@ -286,6 +286,13 @@ struct NNFreeExecution {
   }
 };
 
+// RAII NN API Burst Destructor for use with std::unique_ptr
+struct NNFreeBurst {
+  void operator()(ANeuralNetworksBurst* burst) {
+    NnApiImplementation()->ANeuralNetworksBurst_free(burst);
+  }
+};
+
 // Manage NNAPI shared memory handle
 class NNMemory {
  public:
@@ -2025,6 +2032,7 @@ class NNAPIDelegateKernel {
       const char* cache_dir = delegate_options.cache_dir;
       const char* model_token = delegate_options.model_token;
       if (nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 &&
+          nnapi_->ANeuralNetworksCompilation_setCaching != nullptr &&
           cache_dir && model_token) {
         // Compilation caching could be enabled, try construct the uint8 token.
         // TODO(133342794): use a generic token generator class.
@@ -2062,6 +2070,19 @@ class NNAPIDelegateKernel {
       RETURN_TFLITE_ERROR_IF_NN_ERROR(context, finish_result);
       nn_compilation_.reset(compilation);
     }
+
+    if (!nn_burst_ && delegate_options.use_burst_computation &&
+        nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 &&
+        nnapi_->ANeuralNetworksBurst_create != nullptr &&
+        nnapi_->ANeuralNetworksExecution_burstCompute != nullptr) {
+      // The burst only speeds up invocations, so if the driver can't create
+      // one the model still runs with regular executions.
+      ANeuralNetworksBurst* burst = nullptr;
+      if (nnapi_->ANeuralNetworksBurst_create(nn_compilation_.get(), &burst) ==
+          ANEURALNETWORKS_NO_ERROR) {
+        nn_burst_.reset(burst);
+      }
+    }
     return kTfLiteOk;
   }
 
@@ -2199,6 +2220,11 @@ class NNAPIDelegateKernel {
       const int wait_result = nnapi_->ANeuralNetworksEvent_wait(event);
       nnapi_->ANeuralNetworksEvent_free(event);
       RETURN_TFLITE_ERROR_IF_NN_ERROR(context, wait_result);
+    } else if (nn_burst_) {
+      // Reuse the resources of the burst across invocations.
+      RETURN_TFLITE_ERROR_IF_NN_ERROR(
+          context, nnapi_->ANeuralNetworksExecution_burstCompute(
+                       execution, nn_burst_.get()));
     } else {
       // Use synchronous execution for NNAPI 1.2+.
       RETURN_TFLITE_ERROR_IF_NN_ERROR(
@@ -2241,6 +2267,8 @@ class NNAPIDelegateKernel {
   std::unique_ptr<ANeuralNetworksModel, NNFreeModel> nn_model_;
   std::unique_ptr<ANeuralNetworksCompilation, NNFreeCompilation>
       nn_compilation_;
+  // Set if the model runs with burst executions.
+  std::unique_ptr<ANeuralNetworksBurst, NNFreeBurst> nn_burst_;
   // Node indices that this delegate is responsible for. Indices here
   // indexes into the nodes array in the TfLiteContext.
   std::vector<int> nodes_;
@@ -2601,12 +2629,15 @@ StatefulNnApiDelegate::StatefulNnApiDelegate(Options options)
   if (options.model_token) {
     delegate_data_.model_token = options.model_token;
   }
+  delegate_data_.min_nodes_per_partition = options.min_nodes_per_partition;
+  delegate_data_.use_burst_computation = options.use_burst_computation;
   TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                        "Created TensorFlow Lite delegate for NNAPI.");
   Prepare = DoPrepare;
   CopyFromBufferHandle = DoCopyFromBufferHandle;
   CopyToBufferHandle = DoCopyToBufferHandle;
   FreeBufferHandle = DoFreeBufferHandle;
+  ShouldDelegatePartition = DoShouldDelegatePartition;
   data_ = &delegate_data_;
 }
 
@@ -2627,6 +2658,8 @@ const StatefulNnApiDelegate::Options StatefulNnApiDelegate::GetOptions(
   options.model_token = delegate_data->model_token.empty()
                             ? nullptr
                             : delegate_data->model_token.c_str();
+  options.min_nodes_per_partition = delegate_data->min_nodes_per_partition;
+  options.use_burst_computation = delegate_data->use_burst_computation;
   return options;
 }
 
@@ -2686,6 +2719,14 @@ void StatefulNnApiDelegate::DoFreeBufferHandle(TfLiteContext* context,
   }
 }
 
+bool StatefulNnApiDelegate::DoShouldDelegatePartition(
+    TfLiteContext* context, TfLiteDelegate* delegate,
+    const TfLiteIntArray* nodes, const TfLiteIntArray* input_tensors,
+    const TfLiteIntArray* output_tensors) {
+  auto delegate_data = reinterpret_cast<Data*>(delegate->data_);
+  return nodes->size >= delegate_data->min_nodes_per_partition;
+}
+
 TfLiteStatus StatefulNnApiDelegate::DoPrepare(TfLiteContext* context,
                                               TfLiteDelegate* delegate) {
   // Do not check nodes_ if NN API is unavailable.
@@ -63,6 +63,18 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     // NOTE: when using compilation caching, it is not recommended to use the
     // same delegate instance for multiple models.
     const char* model_token = nullptr;
+
+    // The minimum number of nodes of a partition of the graph for it to be
+    // delegated. Smaller partitions run on the CPU, which avoids copying their
+    // inputs and outputs to and from the accelerator for little work.
+    // Default to 0, which implies all partitions are delegated.
+    int min_nodes_per_partition = 0;
+
+    // Whether to run the compiled model with an ANeuralNetworksBurst, which
+    // lets the driver reuse resources across invocations and lowers the
+    // latency of repeated ones. Ignored before NNAPI 1.2 (Android Q), where
+    // invocations run without a burst.
+    bool use_burst_computation = false;
   };
 
   // Uses default options.
@@ -124,6 +136,10 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     std::string cache_dir;
     // The unique token string for NNAPI model.
     std::string model_token;
+    // The minimum number of nodes of a delegated partition.
+    int min_nodes_per_partition;
+    // Whether to run the model with an ANeuralNetworksBurst.
+    bool use_burst_computation;
     // Tensor to ANeuralNetworksMemory mapping.
     std::vector<MemoryRegistration> tensor_memory_map;
   };
@@ -149,6 +165,14 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
                                            TfLiteBufferHandle buffer_handle,
                                            TfLiteTensor* tensor);
 
+  // Implements TfLiteDelegate::ShouldDelegatePartition, based on
+  // Options::min_nodes_per_partition.
+  static bool DoShouldDelegatePartition(TfLiteContext* context,
+                                        TfLiteDelegate* delegate,
+                                        const TfLiteIntArray* nodes,
+                                        const TfLiteIntArray* input_tensors,
+                                        const TfLiteIntArray* output_tensors);
+
   // Free the Delegate Buffer Handle. Note: This only frees the handle, but
   // this doesn't release the underlying resource (e.g. textures). The
   // resources are either owned by application layer or the delegate.
@@ -0,0 +1,133 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/micro/greedy_memory_planner.h"
+
+namespace tflite {
+
+constexpr int GreedyMemoryPlanner::kPerBufferSize;
+
+GreedyMemoryPlanner::GreedyMemoryPlanner(unsigned char* scratch_buffer,
+                                         int scratch_buffer_size)
+    : buffer_count_(0), need_to_calculate_offsets_(true) {
+  max_buffer_count_ = scratch_buffer_size / kPerBufferSize;
+  int* next_free = reinterpret_cast<int*>(scratch_buffer);
+  buffer_sizes_ = next_free;
+  next_free += max_buffer_count_;
+  first_times_used_ = next_free;
+  next_free += max_buffer_count_;
+  last_times_used_ = next_free;
+  next_free += max_buffer_count_;
+  buffer_offsets_ = next_free;
+  next_free += max_buffer_count_;
+  buffers_by_size_ = next_free;
+  next_free += max_buffer_count_;
+  buffers_by_offset_ = next_free;
+}
+
+TfLiteStatus GreedyMemoryPlanner::AddBuffer(ErrorReporter* error_reporter,
+                                            int size, int first_time_used,
+                                            int last_time_used) {
+  if (buffer_count_ >= max_buffer_count_) {
+    error_reporter->Report("Too many buffers (max is %d)", max_buffer_count_);
+    return kTfLiteError;
+  }
+  buffer_sizes_[buffer_count_] = size;
+  first_times_used_[buffer_count_] = first_time_used;
+  last_times_used_[buffer_count_] = last_time_used;
+  ++buffer_count_;
+  need_to_calculate_offsets_ = true;
+  return kTfLiteOk;
+}
+
+bool GreedyMemoryPlanner::DoesLifetimeOverlap(int a, int b) const {
+  return first_times_used_[a] <= last_times_used_[b] &&
+         first_times_used_[b] <= last_times_used_[a];
+}
+
+void GreedyMemoryPlanner::CalculateOffsetsIfNeeded() {
+  if (!need_to_calculate_offsets_) {
+    return;
+  }
+  need_to_calculate_offsets_ = false;
+
+  // Insertion sort keeps the code small, and models have few enough tensors.
+  // Ties keep the order the buffers were added in.
+  for (int i = 0; i < buffer_count_; ++i) {
+    int j = i;
+    while (j > 0 && buffer_sizes_[buffers_by_size_[j - 1]] < buffer_sizes_[i]) {
+      buffers_by_size_[j] = buffers_by_size_[j - 1];
+      --j;
+    }
+    buffers_by_size_[j] = i;
+  }
+
+  int placed_count = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int buffer = buffers_by_size_[i];
+    const int size = buffer_sizes_[buffer];
+    // Walk the placed buffers from the lowest offset, and stop at the first
+    // gap between the ones alive at the same time that is large enough.
+    int offset = 0;
+    for (int k = 0; k < placed_count; ++k) {
+      const int placed = buffers_by_offset_[k];
+      if (!DoesLifetimeOverlap(buffer, placed)) {
+        continue;
+      }
+      if (offset + size <= buffer_offsets_[placed]) {
+        break;
+      }
+      const int placed_end = buffer_offsets_[placed] + buffer_sizes_[placed];
+      if (placed_end > offset) {
+        offset = placed_end;
+      }
+    }
+    buffer_offsets_[buffer] = offset;
+
+    int k = placed_count;
+    while (k > 0 && buffer_offsets_[buffers_by_offset_[k - 1]] > offset) {
+      buffers_by_offset_[k] = buffers_by_offset_[k - 1];
+      --k;
+    }
+    buffers_by_offset_[k] = buffer;
+    ++placed_count;
+  }
+}
+
+int GreedyMemoryPlanner::GetMaximumMemorySize() {
+  CalculateOffsetsIfNeeded();
+  int max_size = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int end = buffer_offsets_[i] + buffer_sizes_[i];
+    if (end > max_size) {
+      max_size = end;
+    }
+  }
+  return max_size;
+}
+
+TfLiteStatus GreedyMemoryPlanner::GetOffsetForBuffer(
+    ErrorReporter* error_reporter, int buffer_index, int* offset) {
+  CalculateOffsetsIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    error_reporter->Report("Buffer index %d is outside range 0 to %d",
+                           buffer_index, buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = buffer_offsets_[buffer_index];
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,79 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_MICRO_GREEDY_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_MICRO_GREEDY_MEMORY_PLANNER_H_
+
+#include "tensorflow/lite/c/c_api_internal.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+
+namespace tflite {
+
+// Plans where buffers with known sizes and lifetimes go within one arena, so
+// that buffers that are never in use at the same time can share memory.
+// Times are the indices of the operators that first and last use a buffer.
+//
+// Buffers are placed from the largest to the smallest, each one at the lowest
+// offset that doesn't overlap any buffer already placed whose lifetime
+// overlaps its own. This is the greedy-by-size approach of the TensorFlow Lite
+// arena planner, and works well for the mostly linear graphs of micro models.
+//
+// The planner uses no heap memory. The caller provides a scratch buffer of at
+// least kPerBufferSize bytes for each buffer that will be added.
+class GreedyMemoryPlanner {
+ public:
+  static constexpr int kPerBufferSize = 6 * sizeof(int);
+
+  GreedyMemoryPlanner(unsigned char* scratch_buffer, int scratch_buffer_size);
+
+  // Records a buffer of `size` bytes that is in use from `first_time_used`
+  // to `last_time_used`, inclusive. Its index is the number of buffers added
+  // before it.
+  TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
+                         int first_time_used, int last_time_used);
+
+  // The size of the arena the buffers need.
+  int GetMaximumMemorySize();
+
+  int GetBufferCount() const { return buffer_count_; }
+
+  // The offset of a buffer from the start of the arena.
+  TfLiteStatus GetOffsetForBuffer(ErrorReporter* error_reporter,
+                                  int buffer_index, int* offset);
+
+ private:
+  // Places all the buffers, if some were added since the last call.
+  void CalculateOffsetsIfNeeded();
+
+  bool DoesLifetimeOverlap(int a, int b) const;
+
+  int max_buffer_count_;
+  int buffer_count_;
+
+  // The records of the buffers, in the order they were added.
+  int* buffer_sizes_;
+  int* first_times_used_;
+  int* last_times_used_;
+  int* buffer_offsets_;
+  // The buffers by decreasing size, and the placed buffers by offset.
+  int* buffers_by_size_;
+  int* buffers_by_offset_;
+
+  bool need_to_calculate_offsets_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_MICRO_GREEDY_MEMORY_PLANNER_H_
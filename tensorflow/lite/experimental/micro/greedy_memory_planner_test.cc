@@ -0,0 +1,97 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/micro/greedy_memory_planner.h"
+#include "tensorflow/lite/experimental/micro/testing/micro_test.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kScratchBufferSize = 16 * GreedyMemoryPlanner::kPerBufferSize;
+// Aligned for the ints the planner keeps in it.
+int scratch_buffer[kScratchBufferSize / sizeof(int)];
+
+unsigned char* ScratchBuffer() {
+  return reinterpret_cast<unsigned char*>(scratch_buffer);
+}
+
+int GetOffset(GreedyMemoryPlanner* planner, int buffer_index) {
+  int offset = -1;
+  planner->GetOffsetForBuffer(micro_test::reporter, buffer_index, &offset);
+  return offset;
+}
+
+}  // namespace
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(TestReusesMemoryOfDeadBuffers) {
+  tflite::GreedyMemoryPlanner planner(tflite::ScratchBuffer(),
+                                      tflite::kScratchBufferSize);
+  // A chain of operators, where each buffer is only needed by the next one.
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 100, 0, 1));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 50, 1, 2));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 100, 2, 3));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 50, 3, 4));
+
+  TF_LITE_MICRO_EXPECT_EQ(150, planner.GetMaximumMemorySize());
+  TF_LITE_MICRO_EXPECT_EQ(0, tflite::GetOffset(&planner, 0));
+  TF_LITE_MICRO_EXPECT_EQ(100, tflite::GetOffset(&planner, 1));
+  TF_LITE_MICRO_EXPECT_EQ(0, tflite::GetOffset(&planner, 2));
+  TF_LITE_MICRO_EXPECT_EQ(100, tflite::GetOffset(&planner, 3));
+}
+
+TF_LITE_MICRO_TEST(TestFillsGapsBetweenLiveBuffers) {
+  tflite::GreedyMemoryPlanner planner(tflite::ScratchBuffer(),
+                                      tflite::kScratchBufferSize);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 40, 0, 1));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 60, 0, 4));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 50, 0, 4));
+  // Only fits where the first buffer was, once it is dead.
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 30, 2, 3));
+
+  TF_LITE_MICRO_EXPECT_EQ(150, planner.GetMaximumMemorySize());
+  TF_LITE_MICRO_EXPECT_EQ(110, tflite::GetOffset(&planner, 0));
+  TF_LITE_MICRO_EXPECT_EQ(0, tflite::GetOffset(&planner, 1));
+  TF_LITE_MICRO_EXPECT_EQ(60, tflite::GetOffset(&planner, 2));
+  TF_LITE_MICRO_EXPECT_EQ(110, tflite::GetOffset(&planner, 3));
+}
+
+TF_LITE_MICRO_TEST(TestTooManyBuffers) {
+  tflite::GreedyMemoryPlanner planner(
+      tflite::ScratchBuffer(), 2 * tflite::GreedyMemoryPlanner::kPerBufferSize);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 10, 0, 1));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 10, 0, 1));
+  TF_LITE_MICRO_EXPECT_NE(
+      kTfLiteOk, planner.AddBuffer(micro_test::reporter, 10, 0, 1));
+  TF_LITE_MICRO_EXPECT_EQ(20, planner.GetMaximumMemorySize());
+
+  int offset;
+  TF_LITE_MICRO_EXPECT_NE(
+      kTfLiteOk, planner.GetOffsetForBuffer(micro_test::reporter, 2, &offset));
+}
+
+TF_LITE_MICRO_TESTS_END
@@ -17,10 +17,13 @@ limitations under the License.
 #include "tensorflow/lite/c/c_api_internal.h"
 #include "tensorflow/lite/core/api/flatbuffer_conversions.h"
 #include "tensorflow/lite/experimental/micro/compatibility.h"
+#include "tensorflow/lite/experimental/micro/greedy_memory_planner.h"
 
 namespace tflite {
 namespace {
 const int kStackDataAllocatorSize = 128;
+// The alignment of tensors in the arena, enough for any type.
+const int kBufferAlignment = 16;
 class StackDataAllocator : public BuiltinDataAllocator {
  public:
   void* Allocate(size_t size) override {
@@ -101,65 +104,114 @@ MicroInterpreter::MicroInterpreter(const Model* model,
 TfLiteStatus MicroInterpreter::AllocateInputAndActTensors() {
   const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers =
       model_->buffers();
-  for (int i = 0; i < subgraph_->inputs()->size(); ++i) {
-    const int tensor_index = subgraph_->inputs()->Get(i);
-    const auto* tensor = tensors_->Get(tensor_index);
-    const TfLiteStatus status = tensor_allocator_->AllocateTensor(
-        *tensor, 0, operators_->size(), buffers, error_reporter_,
-        &context_.tensors[tensor_index]);
-    if (status != kTfLiteOk) {
-      return status;
-    }
-  }
+  const int tensor_count = tensors_->size();
+  const int operator_count = operators_->size();
 
+  // The first operator that creates each tensor and the last one that uses
+  // it, or -1.
   int* first_created = reinterpret_cast<int*>(tensor_allocator_->AllocateMemory(
-      sizeof(int) * tensors_->size(), sizeof(int)));
+      sizeof(int) * tensor_count, sizeof(int)));
   int* last_used = reinterpret_cast<int*>(tensor_allocator_->AllocateMemory(
-      sizeof(int) * tensors_->size(), sizeof(int)));
-  for (int i = 0; i < tensors_->size(); ++i) {
+      sizeof(int) * tensor_count, sizeof(int)));
+  if ((first_created == nullptr) || (last_used == nullptr)) {
+    error_reporter_->Report("Couldn't allocate memory for tensor lifetimes");
+    return kTfLiteError;
+  }
+  for (int i = 0; i < tensor_count; ++i) {
     first_created[i] = -1;
     last_used[i] = -1;
   }
-
-  for (int i = (operators_->size() - 1); i >= 0; --i) {
+  for (int i = 0; i < operator_count; ++i) {
     const auto* op = operators_->Get(i);
     for (int n = 0; n < op->inputs()->size(); ++n) {
       const int tensor_index = op->inputs()->Get(n);
-      if ((last_used[tensor_index] == -1) || (last_used[tensor_index] < i)) {
+      // Optional inputs that are missing have an index of -1.
+      if (tensor_index >= 0) {
         last_used[tensor_index] = i;
       }
     }
     for (int n = 0; n < op->outputs()->size(); ++n) {
       const int tensor_index = op->outputs()->Get(n);
-      const int create_before = i;
-      int destroy_after = last_used[tensor_index];
-      if (destroy_after == -1) {
-        destroy_after = operators_->size();
-      }
-      const auto* tensor = tensors_->Get(tensor_index);
-      if (!tensor->is_variable()) {
-        const TfLiteStatus status = tensor_allocator_->AllocateTensor(
-            *tensor, create_before, destroy_after, buffers, error_reporter_,
-            &context_.tensors[tensor_index]);
-        if (status != kTfLiteOk) {
-          return status;
-        }
+      if (first_created[tensor_index] == -1) {
         first_created[tensor_index] = i;
       }
     }
   }
+  // The inputs and outputs of the graph are read and written outside of
+  // Invoke(), and variables keep their values across calls, so they must
+  // have their memory for the whole run.
+  for (int i = 0; i < subgraph_->inputs()->size(); ++i) {
+    const int tensor_index = subgraph_->inputs()->Get(i);
+    first_created[tensor_index] = 0;
+    last_used[tensor_index] = operator_count;
+  }
+  for (int i = 0; i < subgraph_->outputs()->size(); ++i) {
+    const int tensor_index = subgraph_->outputs()->Get(i);
+    first_created[tensor_index] = 0;
+    last_used[tensor_index] = operator_count;
+  }
+  for (int i = 0; i < tensor_count; ++i) {
+    if (tensors_->Get(i)->is_variable()) {
+      first_created[i] = 0;
+      last_used[i] = operator_count;
+    }
+  }
 
-  for (int i = 0; i < tensors_->size(); ++i) {
-    const auto* tensor = tensors_->Get(i);
-    const bool is_read_only = (first_created[i] == -1) && (last_used[i] != -1);
-    if (tensor->is_variable() || is_read_only) {
-      const TfLiteStatus status = tensor_allocator_->AllocateTensor(
-          *tensor, 0, operators_->size(), buffers, error_reporter_,
-          &context_.tensors[i]);
-      if (status != kTfLiteOk) {
-        return status;
-      }
+  const int planner_scratch_size =
+      GreedyMemoryPlanner::kPerBufferSize * tensor_count;
+  unsigned char* planner_scratch =
+      tensor_allocator_->AllocateMemory(planner_scratch_size, sizeof(int));
+  if (planner_scratch == nullptr) {
+    error_reporter_->Report("Couldn't allocate memory for the memory planner");
+    return kTfLiteError;
+  }
+  GreedyMemoryPlanner planner(planner_scratch, planner_scratch_size);
+  // Tensors that no operator touches are left alone.
+  for (int i = 0; i < tensor_count; ++i) {
+    if ((first_created[i] == -1) && (last_used[i] == -1)) {
+      continue;
+    }
+    TfLiteTensor* tensor = &context_.tensors[i];
+    TF_LITE_ENSURE_STATUS(tensor_allocator_->InitializeTensor(
+        *tensors_->Get(i), buffers, error_reporter_, tensor));
+    if (tensor->allocation_type != kTfLiteArenaRw) {
+      continue;
+    }
+    // Tensors that are never created are in use from the start, and the ones
+    // that are never used until the end.
+    const int first_time_used = (first_created[i] == -1) ? 0 : first_created[i];
+    const int last_time_used =
+        (last_used[i] == -1) ? operator_count : last_used[i];
+    const int aligned_bytes =
+        (tensor->bytes + kBufferAlignment - 1) & ~(kBufferAlignment - 1);
+    TF_LITE_ENSURE_STATUS(planner.AddBuffer(error_reporter_, aligned_bytes,
+                                            first_time_used, last_time_used));
+  }
+
+  const int arena_size = planner.GetMaximumMemorySize();
+  uint8_t* arena =
+      tensor_allocator_->AllocateMemory(arena_size, kBufferAlignment);
+  if (arena == nullptr) {
+    error_reporter_->Report(
+        "Couldn't allocate memory for tensors, wanted %d bytes but only %d "
+        "were available",
+        arena_size, tensor_allocator_->GetAvailableSize());
+    return kTfLiteError;
+  }
+  int buffer_index = 0;
+  for (int i = 0; i < tensor_count; ++i) {
+    if ((first_created[i] == -1) && (last_used[i] == -1)) {
+      continue;
+    }
+    TfLiteTensor* tensor = &context_.tensors[i];
+    if (tensor->allocation_type != kTfLiteArenaRw) {
+      continue;
     }
+    int offset;
+    TF_LITE_ENSURE_STATUS(
+        planner.GetOffsetForBuffer(error_reporter_, buffer_index, &offset));
+    tensor->data.raw = reinterpret_cast<char*>(arena + offset);
+    ++buffer_index;
   }
 
   return kTfLiteOk;
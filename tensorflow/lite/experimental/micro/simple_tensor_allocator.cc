@@ -74,9 +74,8 @@ uint8_t* AlignPointerRoundUp(uint8_t* data, size_t alignment) {
 
 }  // namespace
 
-TfLiteStatus SimpleTensorAllocator::AllocateTensor(
-    const tflite::Tensor& flatbuffer_tensor, int create_before,
-    int destroy_after,
+TfLiteStatus SimpleTensorAllocator::InitializeTensor(
+    const tflite::Tensor& flatbuffer_tensor,
     const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
     ErrorReporter* error_reporter, TfLiteTensor* result) {
   TF_LITE_ENSURE_STATUS(ConvertTensorType(flatbuffer_tensor.type(),
@@ -108,23 +107,14 @@ TfLiteStatus SimpleTensorAllocator::AllocateTensor(
     TF_LITE_ENSURE_STATUS(BytesRequired(flatbuffer_tensor, data_size,
                                         &result->bytes, &type_size,
                                         error_reporter));
-    result->data.raw =
-        reinterpret_cast<char*>(AllocateMemory(result->bytes, type_size));
-    if (result->data.raw == nullptr) {
-      const char* tensor_name = flatbuffer_tensor.name()->c_str();
-      if (tensor_name == nullptr) {
-        tensor_name = "<None>";
-      }
-      error_reporter->Report(
-          "Couldn't allocate memory for tensor '%s', wanted %d bytes but only "
-          "%d were available",
-          tensor_name, result->bytes, (data_size_max_ - data_size_));
-      return kTfLiteError;
-    }
     result->allocation_type = kTfLiteArenaRw;
   }
   result->dims = reinterpret_cast<TfLiteIntArray*>(AllocateMemory(
       sizeof(int) * (flatbuffer_tensor.shape()->Length() + 1), sizeof(int)));
+  if (result->dims == nullptr) {
+    error_reporter->Report("Couldn't allocate memory for tensor dimensions");
+    return kTfLiteError;
+  }
   result->dims->size = flatbuffer_tensor.shape()->Length();
   for (int n = 0; n < flatbuffer_tensor.shape()->Length(); ++n) {
     result->dims->data[n] = flatbuffer_tensor.shape()->Get(n);
@@ -149,6 +139,31 @@ TfLiteStatus SimpleTensorAllocator::AllocateTensor(
   return kTfLiteOk;
 }
 
+TfLiteStatus SimpleTensorAllocator::AllocateTensor(
+    const tflite::Tensor& flatbuffer_tensor, int create_before,
+    int destroy_after,
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+    ErrorReporter* error_reporter, TfLiteTensor* result) {
+  TF_LITE_ENSURE_STATUS(InitializeTensor(flatbuffer_tensor, buffers,
+                                         error_reporter, result));
+  if (result->allocation_type != kTfLiteArenaRw) {
+    return kTfLiteOk;
+  }
+  size_t type_size;
+  TF_LITE_ENSURE_STATUS(
+      TfLiteTypeSizeOf(result->type, &type_size, error_reporter));
+  result->data.raw =
+      reinterpret_cast<char*>(AllocateMemory(result->bytes, type_size));
+  if (result->data.raw == nullptr) {
+    error_reporter->Report(
+        "Couldn't allocate memory for tensor '%s', wanted %d bytes but only "
+        "%d were available",
+        result->name, result->bytes, (data_size_max_ - data_size_));
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
 uint8_t* SimpleTensorAllocator::AllocateMemory(size_t size, size_t alignment) {
   uint8_t* current_data = data_ + data_size_;
   uint8_t* aligned_result = AlignPointerRoundUp(current_data, alignment);
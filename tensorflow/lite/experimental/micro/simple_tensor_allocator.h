@@ -22,14 +22,25 @@ limitations under the License.
 
 namespace tflite {
 
-// TODO(petewarden): This allocator never frees up or reuses  any memory, even
-// though we have enough information about lifetimes of the tensors to do so.
-// This makes it pretty wasteful, so we should use a more intelligent method.
+// Hands out memory linearly from the arena and never frees it. Tensors that
+// are only needed for part of a run should be initialized with
+// InitializeTensor() and given memory from a plan of their lifetimes, as
+// MicroInterpreter does with GreedyMemoryPlanner.
 class SimpleTensorAllocator {
  public:
   SimpleTensorAllocator(uint8_t* buffer, int buffer_size)
       : data_size_(0), data_size_max_(buffer_size), data_(buffer) {}
 
+  // Fills in `result` from the flatbuffer tensor. Tensors with data in the
+  // model point to it; other tensors get kTfLiteArenaRw with their size in
+  // `bytes` but no data yet.
+  TfLiteStatus InitializeTensor(
+      const tflite::Tensor& flatbuffer_tensor,
+      const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+      ErrorReporter* error_reporter, TfLiteTensor* result);
+
+  // Like InitializeTensor(), but also gives tensors without data in the model
+  // memory from the arena.
   TfLiteStatus AllocateTensor(
       const tflite::Tensor& flatbuffer_tensor, int create_before,
       int destroy_after,
@@ -39,6 +50,7 @@ class SimpleTensorAllocator {
   uint8_t* AllocateMemory(size_t size, size_t alignment);
 
   int GetDataSize() const { return data_size_; }
+  int GetAvailableSize() const { return data_size_max_ - data_size_; }
 
  private:
   int data_size_;
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/lite/experimental/ruy/check_macros.h"
 #include "tensorflow/lite/experimental/ruy/detect_dotprod.h"
+#include "tensorflow/lite/experimental/ruy/detect_x86.h"
 
 namespace ruy {
 
@@ -46,6 +47,20 @@ Path Context::GetRuntimeEnabledPaths() {
     }
   }
 
+  if ((runtime_enabled_paths_ & Path::kAvx2) != Path::kNone) {
+    if (!DetectAvx2()) {
+      runtime_enabled_paths_ = runtime_enabled_paths_ ^ Path::kAvx2;
+      RUY_DCHECK((runtime_enabled_paths_ & Path::kAvx2) == Path::kNone);
+    }
+  }
+
+  if ((runtime_enabled_paths_ & Path::kAvx512) != Path::kNone) {
+    if (!DetectAvx512()) {
+      runtime_enabled_paths_ = runtime_enabled_paths_ ^ Path::kAvx512;
+      RUY_DCHECK((runtime_enabled_paths_ & Path::kAvx512) == Path::kNone);
+    }
+  }
+
   // Sanity check. We can't possibly have disabled all paths, as some paths
   // are universally available (kReference, kStandardCpp).
   RUY_DCHECK(runtime_enabled_paths_ != Path::kNone);
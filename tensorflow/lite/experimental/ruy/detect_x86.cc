@@ -0,0 +1,42 @@
+/* Copyright 2019 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/ruy/detect_x86.h"
+
+#include "tensorflow/lite/experimental/ruy/path.h"
+
+namespace ruy {
+
+#ifdef RUY_X86_PATHS
+
+// __builtin_cpu_supports checks both CPUID and, through XGETBV, that the OS
+// saves the corresponding register state.
+bool DetectAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+bool DetectAvx512() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") &&
+         __builtin_cpu_supports("avx512bw");
+}
+
+#else
+bool DetectAvx2() { return false; }
+bool DetectAvx512() { return false; }
+#endif
+
+}  // namespace ruy
@@ -0,0 +1,31 @@
+/* Copyright 2019 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_RUY_DETECT_X86_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_RUY_DETECT_X86_H_
+
+namespace ruy {
+
+// On x86, returns true if the AVX2 and FMA extensions are present and enabled
+// by the OS. On other architectures, returns false unconditionally.
+bool DetectAvx2();
+
+// On x86, returns true if the AVX-512 F and BW extensions are present and
+// enabled by the OS. On other architectures, returns false unconditionally.
+bool DetectAvx512();
+
+}  // namespace ruy
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_RUY_DETECT_X86_H_
@@ -0,0 +1,368 @@
+/* Copyright 2019 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/ruy/kernel.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "profiling/instrumentation.h"
+
+#if (defined RUY_X86_PATHS) && RUY_OPT_ENABLED(RUY_OPT_INTRINSICS)
+#include <immintrin.h>
+#endif
+
+namespace ruy {
+
+#if (defined RUY_X86_PATHS) && RUY_OPT_ENABLED(RUY_OPT_INTRINSICS)
+
+#define RUY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define RUY_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+namespace {
+
+// Applies the output stage of the 8-bit kernels to a block of accumulators,
+// stored column-major with a stride of LhsCols, and stores the top-left
+// rows x cols values of the block at dst_ptr. The fixed-point multiplier is
+// applied in scalar code, exactly like Path::kStandardCpp does.
+template <int LhsCols, int RhsCols>
+void Store8bitBlock(const KernelParams8bit<LhsCols, RhsCols>& params, int row,
+                    const std::int32_t* accum, int rows, int cols,
+                    char* dst_ptr) {
+  for (int j = 0; j < cols; ++j) {
+    char* dst_col_ptr = dst_ptr + j * params.dst_stride;
+    for (int i = 0; i < rows; ++i) {
+      std::int32_t value = accum[j * LhsCols + i];
+      if (params.dst_type_id == RUY_ASM_TYPE_ID_INT32) {
+        reinterpret_cast<std::int32_t*>(dst_col_ptr)[i] = value;
+        continue;
+      }
+      const int channel =
+          (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) ? row + i : i;
+      value = MultiplyByQuantizedMultiplier(
+          value, params.multiplier_fixedpoint[channel],
+          params.multiplier_exponent[channel]);
+      value += params.dst_zero_point;
+      value = std::min(value, params.clamp_max);
+      value = std::max(value, params.clamp_min);
+      switch (params.dst_type_id) {
+        case RUY_ASM_TYPE_ID_UINT8:
+          reinterpret_cast<std::uint8_t*>(dst_col_ptr)[i] = value;
+          break;
+        case RUY_ASM_TYPE_ID_INT8:
+          reinterpret_cast<std::int8_t*>(dst_col_ptr)[i] = value;
+          break;
+        case RUY_ASM_TYPE_ID_INT16:
+          reinterpret_cast<std::int16_t*>(dst_col_ptr)[i] = value;
+          break;
+      }
+    }
+  }
+}
+
+// The size in bytes of the destination scalar type of the 8-bit kernels.
+int DstTypeSize(std::uint8_t dst_type_id) {
+  switch (dst_type_id) {
+    case RUY_ASM_TYPE_ID_UINT8:
+    case RUY_ASM_TYPE_ID_INT8:
+      return 1;
+    case RUY_ASM_TYPE_ID_INT16:
+      return 2;
+    default:
+      return 4;
+  }
+}
+
+// Returns the terms of the 8-bit accumulators that depend only on the row:
+// the bias, the zero point of the rhs times the sums of the lhs, and the
+// product of the zero points times the depth.
+template <int LhsCols, int RhsCols>
+void Get8bitRowTerms(const KernelParams8bit<LhsCols, RhsCols>& params, int row,
+                     int rows, std::int32_t* row_terms) {
+  for (int i = 0; i < LhsCols; ++i) {
+    row_terms[i] = params.prod_zp_depth;
+  }
+  if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
+    for (int i = 0; i < rows; ++i) {
+      row_terms[i] += params.bias[row + i];
+    }
+  }
+  if ((params.flags & RUY_ASM_FLAG_HAS_LHS_SUMS) && params.rhs_zero_point) {
+    for (int i = 0; i < LhsCols; ++i) {
+      row_terms[i] -= params.rhs_zero_point * params.lhs_sums[row + i];
+    }
+  }
+}
+
+// Returns the terms of the 8-bit accumulators that depend only on the column:
+// the zero point of the lhs times the sums of the rhs.
+template <int LhsCols, int RhsCols>
+void Get8bitColTerms(const KernelParams8bit<LhsCols, RhsCols>& params, int col,
+                     std::int32_t* col_terms) {
+  for (int j = 0; j < RhsCols; ++j) {
+    col_terms[j] = 0;
+  }
+  if ((params.flags & RUY_ASM_FLAG_HAS_RHS_SUMS) && params.lhs_zero_point) {
+    for (int j = 0; j < RhsCols; ++j) {
+      col_terms[j] = -params.lhs_zero_point * params.rhs_sums[col + j];
+    }
+  }
+}
+
+}  // namespace
+
+RUY_TARGET_AVX2
+void KernelFloatAvx2(const KernelParamsFloat<8, 8>& params) {
+  gemmlowp::ScopedProfilingLabel label("Kernel (AVX2)");
+  constexpr int kBlock = 8;
+  const int lhs_stride = params.lhs_stride / sizeof(float);
+  const int rhs_stride = params.rhs_stride / sizeof(float);
+  const __m256i row_indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256 clamp_min = _mm256_set1_ps(params.clamp_min);
+  const __m256 clamp_max = _mm256_set1_ps(params.clamp_max);
+  const bool has_bias = params.flags & RUY_ASM_FLAG_HAS_BIAS;
+
+  for (int col = params.start_col; col <= params.last_col; col += kBlock) {
+    const float* rhs_block_ptr =
+        params.rhs_base_ptr + (col - params.start_col) * rhs_stride;
+    const int cols = std::min(params.dst_cols - col, kBlock);
+    for (int row = params.start_row; row <= params.last_row; row += kBlock) {
+      const float* lhs_ptr =
+          params.lhs_base_ptr + (row - params.start_row) * lhs_stride;
+      const float* rhs_ptr = rhs_block_ptr;
+      __m256 accum[kBlock];
+      for (int j = 0; j < kBlock; ++j) {
+        accum[j] = _mm256_setzero_ps();
+      }
+      for (int d = 0; d < params.depth; ++d) {
+        const __m256 lhs_data = _mm256_loadu_ps(lhs_ptr);
+        for (int j = 0; j < kBlock; ++j) {
+          accum[j] = _mm256_fmadd_ps(lhs_data, _mm256_broadcast_ss(rhs_ptr + j),
+                                     accum[j]);
+        }
+        lhs_ptr += kBlock;
+        rhs_ptr += kBlock;
+      }
+
+      const int rows = std::min(params.dst_rows - row, kBlock);
+      const __m256i row_mask =
+          _mm256_cmpgt_epi32(_mm256_set1_epi32(rows), row_indices);
+      const __m256 bias = has_bias
+                              ? _mm256_maskload_ps(params.bias + row, row_mask)
+                              : _mm256_setzero_ps();
+      float* dst_ptr = reinterpret_cast<float*>(
+          reinterpret_cast<char*>(params.dst_base_ptr) +
+          (col - params.start_col) * params.dst_stride +
+          (row - params.start_row) * sizeof(float));
+      for (int j = 0; j < cols; ++j) {
+        __m256 result = _mm256_add_ps(accum[j], bias);
+        result = _mm256_min_ps(_mm256_max_ps(result, clamp_min), clamp_max);
+        float* dst_col_ptr = reinterpret_cast<float*>(
+            reinterpret_cast<char*>(dst_ptr) + j * params.dst_stride);
+        if (rows == kBlock) {
+          _mm256_storeu_ps(dst_col_ptr, result);
+        } else {
+          _mm256_maskstore_ps(dst_col_ptr, row_mask, result);
+        }
+      }
+    }
+  }
+}
+
+RUY_TARGET_AVX512
+void KernelFloatAvx512(const KernelParamsFloat<16, 16>& params) {
+  gemmlowp::ScopedProfilingLabel label("Kernel (AVX-512)");
+  constexpr int kBlock = 16;
+  const int lhs_stride = params.lhs_stride / sizeof(float);
+  const int rhs_stride = params.rhs_stride / sizeof(float);
+  const __m512 clamp_min = _mm512_set1_ps(params.clamp_min);
+  const __m512 clamp_max = _mm512_set1_ps(params.clamp_max);
+  const bool has_bias = params.flags & RUY_ASM_FLAG_HAS_BIAS;
+
+  for (int col = params.start_col; col <= params.last_col; col += kBlock) {
+    const float* rhs_block_ptr =
+        params.rhs_base_ptr + (col - params.start_col) * rhs_stride;
+    const int cols = std::min(params.dst_cols - col, kBlock);
+    for (int row = params.start_row; row <= params.last_row; row += kBlock) {
+      const float* lhs_ptr =
+          params.lhs_base_ptr + (row - params.start_row) * lhs_stride;
+      const float* rhs_ptr = rhs_block_ptr;
+      __m512 accum[kBlock];
+      for (int j = 0; j < kBlock; ++j) {
+        accum[j] = _mm512_setzero_ps();
+      }
+      for (int d = 0; d < params.depth; ++d) {
+        const __m512 lhs_data = _mm512_loadu_ps(lhs_ptr);
+        for (int j = 0; j < kBlock; ++j) {
+          accum[j] =
+              _mm512_fmadd_ps(lhs_data, _mm512_set1_ps(rhs_ptr[j]), accum[j]);
+        }
+        lhs_ptr += kBlock;
+        rhs_ptr += kBlock;
+      }
+
+      const int rows = std::min(params.dst_rows - row, kBlock);
+      const __mmask16 row_mask = static_cast<__mmask16>((1u << rows) - 1);
+      const __m512 bias = has_bias
+                              ? _mm512_maskz_loadu_ps(row_mask, params.bias + row)
+                              : _mm512_setzero_ps();
+      float* dst_ptr = reinterpret_cast<float*>(
+          reinterpret_cast<char*>(params.dst_base_ptr) +
+          (col - params.start_col) * params.dst_stride +
+          (row - params.start_row) * sizeof(float));
+      for (int j = 0; j < cols; ++j) {
+        __m512 result = _mm512_add_ps(accum[j], bias);
+        result = _mm512_min_ps(_mm512_max_ps(result, clamp_min), clamp_max);
+        float* dst_col_ptr = reinterpret_cast<float*>(
+            reinterpret_cast<char*>(dst_ptr) + j * params.dst_stride);
+        _mm512_mask_storeu_ps(dst_col_ptr, row_mask, result);
+      }
+    }
+  }
+}
+
+// Multiply-accumulates the 8 pairs of 16-bit lhs values with the pair of
+// 16-bit rhs values in 32-bit lane LANE of each 128-bit half of rhs.
+#define RUY_AVX2_MADD_LANE(ACCUM, LHS, RHS, LANE) \
+  ACCUM = _mm256_add_epi32(                       \
+      ACCUM, _mm256_madd_epi16(LHS, _mm256_shuffle_epi32(RHS, LANE * 0x55)))
+
+RUY_TARGET_AVX2
+void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params) {
+  gemmlowp::ScopedProfilingLabel label("Kernel (AVX2 8-bit)");
+  constexpr int kBlock = 8;
+  const int dst_type_size = DstTypeSize(params.dst_type_id);
+  std::int32_t row_terms[kBlock];
+  std::int32_t col_terms[kBlock];
+  std::int32_t accum_buf[kBlock * kBlock];
+
+  for (int col = params.start_col; col <= params.last_col; col += kBlock) {
+    const std::int8_t* rhs_block_ptr =
+        params.rhs_base_ptr + (col - params.start_col) * params.rhs_stride;
+    const int cols = std::min(params.dst_cols - col, kBlock);
+    Get8bitColTerms(params, col, col_terms);
+    for (int row = params.start_row; row <= params.last_row; row += kBlock) {
+      const std::int8_t* lhs_ptr =
+          params.lhs_base_ptr + (row - params.start_row) * params.lhs_stride;
+      const std::int8_t* rhs_ptr = rhs_block_ptr;
+      __m256i accum[kBlock];
+      for (int j = 0; j < kBlock; ++j) {
+        accum[j] = _mm256_setzero_si256();
+      }
+      // Each step consumes 2 levels of depth of 8 columns of each side,
+      // stored as 8 pairs of int8.
+      for (int d = 0; d < params.depth; d += 2) {
+        const __m256i lhs_data = _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs_ptr)));
+        const __m256i rhs_data = _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs_ptr)));
+        const __m256i rhs_lo = _mm256_permute2x128_si256(rhs_data, rhs_data, 0x00);
+        const __m256i rhs_hi = _mm256_permute2x128_si256(rhs_data, rhs_data, 0x11);
+        RUY_AVX2_MADD_LANE(accum[0], lhs_data, rhs_lo, 0);
+        RUY_AVX2_MADD_LANE(accum[1], lhs_data, rhs_lo, 1);
+        RUY_AVX2_MADD_LANE(accum[2], lhs_data, rhs_lo, 2);
+        RUY_AVX2_MADD_LANE(accum[3], lhs_data, rhs_lo, 3);
+        RUY_AVX2_MADD_LANE(accum[4], lhs_data, rhs_hi, 0);
+        RUY_AVX2_MADD_LANE(accum[5], lhs_data, rhs_hi, 1);
+        RUY_AVX2_MADD_LANE(accum[6], lhs_data, rhs_hi, 2);
+        RUY_AVX2_MADD_LANE(accum[7], lhs_data, rhs_hi, 3);
+        lhs_ptr += 2 * kBlock;
+        rhs_ptr += 2 * kBlock;
+      }
+
+      const int rows = std::min(params.dst_rows - row, kBlock);
+      Get8bitRowTerms(params, row, rows, row_terms);
+      const __m256i row_terms_vec =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_terms));
+      for (int j = 0; j < kBlock; ++j) {
+        const __m256i result = _mm256_add_epi32(
+            accum[j],
+            _mm256_add_epi32(row_terms_vec, _mm256_set1_epi32(col_terms[j])));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accum_buf + j * kBlock),
+                            result);
+      }
+      char* dst_ptr = static_cast<char*>(params.dst_base_ptr) +
+                      (col - params.start_col) * params.dst_stride +
+                      (row - params.start_row) * dst_type_size;
+      Store8bitBlock(params, row, accum_buf, rows, cols, dst_ptr);
+    }
+  }
+}
+
+#undef RUY_AVX2_MADD_LANE
+
+RUY_TARGET_AVX512
+void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
+  gemmlowp::ScopedProfilingLabel label("Kernel (AVX-512 8-bit)");
+  constexpr int kBlock = 16;
+  const int dst_type_size = DstTypeSize(params.dst_type_id);
+  std::int32_t row_terms[kBlock];
+  std::int32_t col_terms[kBlock];
+  std::int32_t accum_buf[kBlock * kBlock];
+
+  for (int col = params.start_col; col <= params.last_col; col += kBlock) {
+    const std::int8_t* rhs_block_ptr =
+        params.rhs_base_ptr + (col - params.start_col) * params.rhs_stride;
+    const int cols = std::min(params.dst_cols - col, kBlock);
+    Get8bitColTerms(params, col, col_terms);
+    for (int row = params.start_row; row <= params.last_row; row += kBlock) {
+      const std::int8_t* lhs_ptr =
+          params.lhs_base_ptr + (row - params.start_row) * params.lhs_stride;
+      const std::int8_t* rhs_ptr = rhs_block_ptr;
+      __m512i accum[kBlock];
+      for (int j = 0; j < kBlock; ++j) {
+        accum[j] = _mm512_setzero_si512();
+      }
+      // Each step consumes 2 levels of depth of 16 columns of each side,
+      // stored as 16 pairs of int8.
+      for (int d = 0; d < params.depth; d += 2) {
+        const __m512i lhs_data = _mm512_cvtepi8_epi16(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs_ptr)));
+        const __m512i rhs_data = _mm512_cvtepi8_epi16(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs_ptr)));
+        for (int j = 0; j < kBlock; ++j) {
+          accum[j] = _mm512_add_epi32(
+              accum[j],
+              _mm512_madd_epi16(
+                  lhs_data,
+                  _mm512_permutexvar_epi32(_mm512_set1_epi32(j), rhs_data)));
+        }
+        lhs_ptr += 2 * kBlock;
+        rhs_ptr += 2 * kBlock;
+      }
+
+      const int rows = std::min(params.dst_rows - row, kBlock);
+      Get8bitRowTerms(params, row, rows, row_terms);
+      const __m512i row_terms_vec = _mm512_loadu_si512(row_terms);
+      for (int j = 0; j < kBlock; ++j) {
+        const __m512i result = _mm512_add_epi32(
+            accum[j],
+            _mm512_add_epi32(row_terms_vec, _mm512_set1_epi32(col_terms[j])));
+        _mm512_storeu_si512(accum_buf + j * kBlock, result);
+      }
+      char* dst_ptr = static_cast<char*>(params.dst_base_ptr) +
+                      (col - params.start_col) * params.dst_stride +
+                      (row - params.start_row) * dst_type_size;
+      Store8bitBlock(params, row, accum_buf, rows, cols, dst_ptr);
+    }
+  }
+}
+
+#undef RUY_TARGET_AVX2
+#undef RUY_TARGET_AVX512
+
+#endif  // (defined RUY_X86_PATHS) && RUY_OPT_ENABLED(RUY_OPT_INTRINSICS)
+
+}  // namespace ruy
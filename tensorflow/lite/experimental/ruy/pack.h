@@ -106,6 +106,14 @@ template <>
 struct PackedTypeImpl<Path::kNeonDotprod, std::uint8_t> {
   using Type = std::int8_t;
 };
+template <>
+struct PackedTypeImpl<Path::kAvx2, std::uint8_t> {
+  using Type = std::int8_t;
+};
+template <>
+struct PackedTypeImpl<Path::kAvx512, std::uint8_t> {
+  using Type = std::int8_t;
+};
 
 template <Path ThePath, typename Scalar>
 using PackedType = typename PackedTypeImpl<ThePath, Scalar>::Type;
@@ -157,6 +165,8 @@ struct PackImpl<Path::kStandardCpp, FixedKernelLayout, Scalar, PackedScalar,
 
 RUY_INHERIT_PACK(Path::kStandardCpp, Path::kNeon)
 RUY_INHERIT_PACK(Path::kNeon, Path::kNeonDotprod)
+RUY_INHERIT_PACK(Path::kStandardCpp, Path::kAvx2)
+RUY_INHERIT_PACK(Path::kAvx2, Path::kAvx512)
 
 #if (defined __aarch64__) && RUY_OPT_ENABLED(RUY_OPT_ASM)
 
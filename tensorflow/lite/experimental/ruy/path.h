@@ -20,6 +20,12 @@ limitations under the License.
 
 #include "tensorflow/lite/experimental/ruy/size_util.h"
 
+// The x86 paths are compiled with function-level target attributes, so that
+// they can be selected at runtime regardless of the compiler flags.
+#if (defined __x86_64__) && (defined __GNUC__)
+#define RUY_X86_PATHS
+#endif
+
 namespace ruy {
 
 // A Path is a choice of implementation path, e.g. between reference code
@@ -70,6 +76,10 @@ enum class Path : std::uint8_t {
   // Optimized path making use of ARM NEON dot product instructions that are
   // available on newer ARM cores.
   kNeonDotprod = 0x8,
+  // Optimized path using x86 AVX2 and FMA instructions.
+  kAvx2 = 0x10,
+  // Optimized path using x86 AVX-512 (F and BW) instructions.
+  kAvx512 = 0x20,
 };
 
 inline constexpr Path operator|(Path p, Path q) {
@@ -105,6 +115,9 @@ constexpr Path kAllPaths =
 // We don't know how to do runtime dotprod detection outside of linux for now.
 constexpr Path kAllPaths = Path::kReference | Path::kStandardCpp | Path::kNeon;
 #endif
+#elif defined RUY_X86_PATHS
+constexpr Path kAllPaths =
+    Path::kReference | Path::kStandardCpp | Path::kAvx2 | Path::kAvx512;
 #else
 constexpr Path kAllPaths = Path::kReference | Path::kStandardCpp;
 #endif
@@ -67,6 +67,8 @@ const char* PathName(Path path) {
     RUY_PATHNAME_CASE(kStandardCpp)
     RUY_PATHNAME_CASE(kNeon)
     RUY_PATHNAME_CASE(kNeonDotprod)
+    RUY_PATHNAME_CASE(kAvx2)
+    RUY_PATHNAME_CASE(kAvx512)
     default:
       RUY_CHECK(false);
       return nullptr;
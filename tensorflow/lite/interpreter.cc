@@ -110,6 +110,7 @@ void Interpreter::AddSubgraphs(int subgraphs_to_add,
   for (int i = 0; i < subgraphs_to_add; ++i) {
     Subgraph* subgraph =
         new Subgraph(error_reporter_, external_contexts_, &subgraphs_);
+    subgraph->SetInterOpThreadPool(inter_op_thread_pool_.get());
     subgraphs_.emplace_back(subgraph);
   }
 }
@@ -193,8 +194,11 @@ TfLiteStatus Interpreter::SetExecutionPlan(const std::vector<int>& new_plan) {
 void Interpreter::UseNNAPI(bool enable) { primary_subgraph().UseNNAPI(enable); }
 
 void Interpreter::SetNumThreads(int num_threads) {
+  num_threads_ = num_threads;
+  // Kernels run single-threaded while nodes run concurrently.
+  const int kernel_num_threads = inter_op_thread_pool_ ? 1 : num_threads;
   for (auto& subgraph : subgraphs_) {
-    subgraph->context()->recommended_num_threads = num_threads;
+    subgraph->context()->recommended_num_threads = kernel_num_threads;
   }
 
   for (int i = 0; i < kTfLiteMaxExternalContexts; ++i) {
@@ -205,6 +209,15 @@ void Interpreter::SetNumThreads(int num_threads) {
   }
 }
 
+void Interpreter::SetNumInterOpThreads(int num_threads) {
+  inter_op_thread_pool_.reset(
+      num_threads > 1 ? new InterOpThreadPool(num_threads) : nullptr);
+  for (auto& subgraph : subgraphs_) {
+    subgraph->SetInterOpThreadPool(inter_op_thread_pool_.get());
+  }
+  SetNumThreads(num_threads_);
+}
+
 void Interpreter::SetAllowFp16PrecisionForFp32(bool allow) {
   for (auto& subgraph : subgraphs_) {
     subgraph->context()->allow_fp32_relax_to_fp16 = allow;
@@ -353,6 +353,15 @@ class Interpreter {
   /// Set the number of threads available to the interpreter.
   void SetNumThreads(int num_threads);
 
+  /// Set the number of threads used to invoke independent nodes of the graph
+  /// concurrently, e.g. the branches of multi-branch models. 1 or less runs
+  /// the nodes one after the other, which is the default. While more than one,
+  /// kernels run single-threaded, whatever SetNumThreads() says, to avoid
+  /// oversubscribing the cores. See Subgraph::SetInterOpThreadPool() for when
+  /// nodes actually run concurrently.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetNumInterOpThreads(int num_threads);
+
   /// Allow float16 precision for FP32 calculation when possible.
   /// default: not allow.
   /// WARNING: This is an experimental API and subject to change.
@@ -409,6 +418,20 @@ class Interpreter {
                                TfLiteBufferHandle buffer_handle,
                                TfLiteDelegate* delegate);
 
+  /// Makes the tensor use `bytes` bytes of caller-owned memory at `data`,
+  /// instead of memory of the arena, so that inputs can be written and outputs
+  /// read without copies. `data` must be aligned to kDefaultTensorAlignment
+  /// and stay valid while the tensor uses it. AllocateTensors() must be called
+  /// after a tensor is bound for the first time; binding it to another buffer
+  /// later needs no reallocation. Delegates read and write the buffer like any
+  /// other tensor memory, unless a buffer handle is set on the tensor.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetCustomAllocationForTensor(int tensor_index, void* data,
+                                            size_t bytes) {
+    return primary_subgraph().SetCustomAllocationForTensor(tensor_index, data,
+                                                           bytes);
+  }
+
   /// Get the delegate buffer handle, and the delegate which can process the
   /// buffer handle.
   /// WARNING: This is an experimental API and subject to change.
@@ -527,6 +550,13 @@ class Interpreter {
 
   // Subgraphs
   std::vector<std::unique_ptr<Subgraph>> subgraphs_;
+
+  // The number of threads set by SetNumThreads().
+  int num_threads_ = -1;
+
+  // Threads invoking independent nodes concurrently, if enabled by
+  // SetNumInterOpThreads().
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
 };
 
 }  // namespace tflite
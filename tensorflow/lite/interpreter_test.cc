@@ -17,6 +17,10 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "third_party/eigen3/Eigen/Core"
@@ -598,6 +602,78 @@ TEST(BasicInterpreter, OneOpInterpreter) {
   ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
 }
 
+TEST(BasicInterpreter, CustomAllocations) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({1}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(0, kTfLiteFloat32, "in",
+                                                     {3}, quantized),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(1, kTfLiteFloat32, "out",
+                                                     {3}, quantized),
+            kTfLiteOk);
+
+  // Writes twice the input to the output.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(input->dims));
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    for (int i = 0; i < input->dims->data[0]; ++i) {
+      output->data.f[i] = 2 * input->data.f[i];
+    }
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  alignas(kDefaultTensorAlignment) float input[4] = {1, 2, 3, 4};
+  alignas(kDefaultTensorAlignment) float output[4] = {0, 0, 0, 0};
+  // Misaligned buffers are rejected.
+  EXPECT_NE(interpreter.SetCustomAllocationForTensor(0, input + 1,
+                                                     3 * sizeof(float)),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.SetCustomAllocationForTensor(0, input,
+                                                     3 * sizeof(float)),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.SetCustomAllocationForTensor(1, output,
+                                                     3 * sizeof(float)),
+            kTfLiteOk);
+  // The arena is planned again without the bound tensors.
+  EXPECT_NE(interpreter.Invoke(), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(interpreter.tensor(0)->allocation_type, kTfLiteCustom);
+  EXPECT_EQ(interpreter.typed_tensor<float>(0), input);
+  EXPECT_EQ(interpreter.typed_tensor<float>(1), output);
+
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(output[0], 2);
+  EXPECT_EQ(output[1], 4);
+  EXPECT_EQ(output[2], 6);
+
+  // Binding another buffer needs no reallocation.
+  alignas(kDefaultTensorAlignment) float other_input[3] = {5, 6, 7};
+  ASSERT_EQ(interpreter.SetCustomAllocationForTensor(0, other_input,
+                                                     sizeof(other_input)),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(output[0], 10);
+  EXPECT_EQ(output[2], 14);
+
+  // The bound tensors can't grow larger than their buffers.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {4}), kTfLiteOk);
+  EXPECT_NE(interpreter.AllocateTensors(), kTfLiteOk);
+}
+
 // Forcefully divides tensor allocation in three steps: one before invocation
 // and two more at invocation time. This happens because we use string tensors
 // and their sizes can't be determined until invocation time.
@@ -727,6 +803,146 @@ TEST(BasicInterpreter, AllocateTwice) {
   ASSERT_EQ(old_tensor1_ptr, interpreter.tensor(1)->data.raw);
 }
 
+TEST(BasicInterpreter, ResizeInputPreparesOnlyAffectedNodes) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 1}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3, 4}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quantized),
+              kTfLiteOk);
+  }
+
+  // Copies the shape of the input to the output, and counts the calls to
+  // prepare in the builtin data of the node.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    ++*reinterpret_cast<int*>(node->builtin_data);
+    TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(input->dims));
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    return kTfLiteOk;
+  };
+  // 0 -> 2 -> 3 and 1 -> 4.
+  const std::vector<std::pair<int, int>> edges = {{0, 2}, {2, 3}, {1, 4}};
+  for (const auto& edge : edges) {
+    int* num_prepare_calls = static_cast<int*>(malloc(sizeof(int)));
+    *num_prepare_calls = 0;
+    ASSERT_EQ(interpreter.AddNodeWithParameters({edge.first}, {edge.second},
+                                                nullptr, 0, num_prepare_calls,
+                                                &reg),
+              kTfLiteOk);
+  }
+  auto num_prepare_calls = [&interpreter](int node_index) {
+    return *static_cast<int*>(
+        interpreter.node_and_registration(node_index)->first.builtin_data);
+  };
+
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(num_prepare_calls(0), 1);
+  EXPECT_EQ(num_prepare_calls(1), 1);
+  EXPECT_EQ(num_prepare_calls(2), 1);
+
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {5}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(num_prepare_calls(0), 2);
+  EXPECT_EQ(num_prepare_calls(1), 2);
+  EXPECT_EQ(num_prepare_calls(2), 1);
+  EXPECT_EQ(interpreter.tensor(3)->dims->data[0], 5);
+  EXPECT_EQ(interpreter.tensor(4)->dims->data[0], 3);
+
+  // Adding a node prepares all of them again.
+  int* num_prepare_calls_of_new_node = static_cast<int*>(malloc(sizeof(int)));
+  *num_prepare_calls_of_new_node = 0;
+  ASSERT_EQ(interpreter.AddTensors(1), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(5, kTfLiteFloat32, "",
+                                                     {3}, quantized),
+            kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({4}, {5}, nullptr, 0,
+                                        num_prepare_calls_of_new_node, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {7}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(num_prepare_calls(0), 3);
+  EXPECT_EQ(num_prepare_calls(1), 3);
+  EXPECT_EQ(num_prepare_calls(2), 2);
+  EXPECT_EQ(num_prepare_calls(3), 1);
+}
+
+TEST(BasicInterpreter, InvokeIndependentNodesConcurrently) {
+  Interpreter interpreter;
+  interpreter.SetNumInterOpThreads(2);
+  ASSERT_EQ(interpreter.AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {1}, quantized),
+              kTfLiteOk);
+  }
+
+  // Each branch waits a while for the other one to start, and adds one to its
+  // input if both are running. Run one after the other, only the second one
+  // does.
+  static std::atomic<int> num_started_branches;
+  TfLiteRegistration branch = {nullptr, nullptr, nullptr, nullptr};
+  branch.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    ++num_started_branches;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (num_started_branches < 2 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    context->tensors[node->outputs->data[0]].data.f[0] =
+        context->tensors[node->inputs->data[0]].data.f[0] +
+        (num_started_branches == 2 ? 1.0f : 0.0f);
+    return kTfLiteOk;
+  };
+  TfLiteRegistration add = {nullptr, nullptr, nullptr, nullptr};
+  add.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    context->tensors[node->outputs->data[0]].data.f[0] =
+        context->tensors[node->inputs->data[0]].data.f[0] +
+        context->tensors[node->inputs->data[1]].data.f[0];
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &branch),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr, &branch),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({1, 2}, {3}, nullptr, 0, nullptr, &add),
+      kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  interpreter.typed_tensor<float>(0)[0] = 1.0f;
+
+  // The first invocation runs the nodes one after the other.
+  num_started_branches = 0;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 3.0f);
+
+  num_started_branches = 0;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 4.0f);
+
+  // Back to one node at a time.
+  interpreter.SetNumInterOpThreads(1);
+  num_started_branches = 0;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 3.0f);
+}
+
 TEST(BasicInterpreter, TestNullErrorReporter) {
   TestErrorReporter reporter;
   Interpreter interpreter;
@@ -1256,7 +1472,7 @@ class TestDelegate : public ::testing::Test {
 
    private:
     std::vector<int> nodes_;
-    TfLiteDelegate delegate_;
+    TfLiteDelegate delegate_ = TfLiteDelegateCreate();
   };
   std::unique_ptr<Interpreter> interpreter_;
   std::unique_ptr<SimpleDelegate> delegate_, delegate2_;
@@ -1325,6 +1541,27 @@ TEST_F(TestDelegate, ComplexDelegate) {
             SimpleDelegate::FakeFusedRegistration().custom_name);
 }
 
+TEST_F(TestDelegate, DelegateRejectsPartition) {
+  delegate_ = std::unique_ptr<SimpleDelegate>(new SimpleDelegate({1, 2}));
+  TfLiteDelegate* delegate = delegate_->get_tf_lite_delegate();
+  // Only delegate partitions of at least 3 nodes.
+  delegate->ShouldDelegatePartition =
+      [](TfLiteContext* context, TfLiteDelegate* delegate,
+         const TfLiteIntArray* nodes, const TfLiteIntArray* input_tensors,
+         const TfLiteIntArray* output_tensors) {
+        return nodes->size >= 3;
+      };
+  ASSERT_EQ(interpreter_->ModifyGraphWithDelegate(delegate), kTfLiteOk);
+
+  // The partition of nodes 1 and 2 is rejected, so no delegate node is added
+  // and all nodes run on the CPU.
+  ASSERT_EQ(interpreter_->execution_plan().size(), 3);
+  EXPECT_EQ(interpreter_->execution_plan()[0], 0);
+  EXPECT_EQ(interpreter_->execution_plan()[1], 1);
+  EXPECT_EQ(interpreter_->execution_plan()[2], 2);
+  EXPECT_EQ(interpreter_->nodes_size(), 3);
+}
+
 TEST_F(TestDelegate, SetBufferHandleToInput) {
   delegate_ = std::unique_ptr<SimpleDelegate>(new SimpleDelegate({0, 1, 2}));
   TfLiteDelegate* delegate = delegate_->get_tf_lite_delegate();
@@ -1678,7 +1915,7 @@ class TestDelegateWithDynamicTensors : public ::testing::Test {
   }
 
   std::unique_ptr<Interpreter> interpreter_;
-  TfLiteDelegate delegate_;
+  TfLiteDelegate delegate_ = TfLiteDelegateCreate();
 };
 
 TEST_F(TestDelegateWithDynamicTensors, DisallowDynamicTensors) {
@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/kernels/weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -92,6 +93,10 @@ struct OpData {
   int32_t scaling_factors_index;
   bool need_hwcn_weights;
   bool have_weights_been_transposed;
+  // Whether the transposed weights come from the WeightsCache of the context,
+  // shared with other interpreters, instead of the hwcn_weights temporary.
+  bool use_shared_hwcn_weights = false;
+  const float* shared_hwcn_weights = nullptr;
   bool need_im2col;
 
   bool supports_multithreaded_kernel;
@@ -128,11 +133,8 @@ void Free(TfLiteContext* context, void* buffer) {
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
-  const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
+void TransposeFloatData(const float* input_data, int rows, int cols,
+                        float* output_data) {
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -141,6 +143,11 @@ void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
+void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
+  TransposeFloatData(GetTensorData<float>(input), output->dims->data[1],
+                     output->dims->data[0], GetTensorData<float>(output));
+}
+
 // Allocate temporary tensors (`im2col`, `hwcn_weights` if necessary).
 // Note: `context->AddTensors` might invalidate pointers to existing tensors.
 // Therefore the logic to add tensors are isolated into this function.
@@ -360,6 +367,14 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     hwcn_weights_size->data[0] = (filter_height * filter_width * input_depth);
     hwcn_weights_size->data[1] = channels_out;
 
+    // Constant weights are transposed once for all the interpreters sharing a
+    // weights cache, and the temporary is left empty.
+    data->use_shared_hwcn_weights = IsConstantTensor(filter) &&
+                                    WeightsCache::FromContext(context);
+    if (data->use_shared_hwcn_weights) {
+      hwcn_weights_size->data[0] = 0;
+    }
+
     TfLiteTensor* hwcn_weights =
         &context->tensors[node->temporaries->data[data->hwcn_weights_index]];
     hwcn_weights->type = input_type;
@@ -451,6 +466,7 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
   op_params.output_shift = -data->output_shift;
   op_params.quantized_activation_min = data->output_activation_min;
   op_params.quantized_activation_max = data->output_activation_max;
+  op_params.lhs_cacheable = IsConstantTensor(filter);
   switch (effective_kernel_type) {
     case kReference: {
       reference_ops::Conv(
@@ -493,6 +509,7 @@ void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
   op_params.dilation_width_factor = params->dilation_width_factor;
   op_params.padding_values.height = data->padding.height;
   op_params.padding_values.width = data->padding.width;
+  op_params.lhs_cacheable = IsConstantTensor(filter);
 
   switch (kernel_type) {
     case kReference: {
@@ -546,6 +563,7 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.dilation_height_factor = params->dilation_height_factor;
   op_params.float_activation_min = output_activation_min;
   op_params.float_activation_max = output_activation_max;
+  op_params.lhs_cacheable = IsConstantTensor(filter);
   switch (effective_kernel_type) {
     case kReference: {
       reference_ops::Conv(op_params, GetTensorShape(input),
@@ -575,7 +593,9 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
       TFLITE_DCHECK(false);
 #else
       const float* filter_data;
-      if (data->need_hwcn_weights) {
+      if (data->use_shared_hwcn_weights) {
+        filter_data = data->shared_hwcn_weights;
+      } else if (data->need_hwcn_weights) {
         filter_data = GetTensorData<float>(hwcn_weights);
       } else {
         filter_data = GetTensorData<float>(filter);
@@ -687,7 +707,20 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           : nullptr;
 
   if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
-    TransposeFloatTensor(filter, hwcn_weights);
+    if (data->use_shared_hwcn_weights) {
+      const int rows = SizeOfDimension(filter, 0);
+      const int cols = NumElements(filter) / rows;
+      const float* filter_data = GetTensorData<float>(filter);
+      auto transpose = [filter_data, rows, cols](void* buffer) {
+        TransposeFloatData(filter_data, rows, cols,
+                           static_cast<float*>(buffer));
+      };
+      data->shared_hwcn_weights = static_cast<const float*>(
+          WeightsCache::FromContext(context)->GetOrCreate(
+              filter->data.raw, "conv_hwcn_weights", filter->bytes, transpose));
+    } else {
+      TransposeFloatTensor(filter, hwcn_weights);
+    }
     data->have_weights_been_transposed = true;
   }
 
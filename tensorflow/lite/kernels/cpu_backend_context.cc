@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 
+#include <memory>
+
 #include "public/gemmlowp.h"
 #include "tensorflow/lite/experimental/ruy/context.h"
 
@@ -28,6 +30,23 @@ CpuBackendContext::CpuBackendContext()
 
 CpuBackendContext::~CpuBackendContext() {}
 
+ruy::PrepackedMatrix* CpuBackendContext::GetPrepackedMatrix(
+    const void* data, bool is_lhs, const ruy::Layout& layout,
+    std::int32_t zero_point) {
+  return &prepacked_matrices_[PrepackedMatrixKey(
+      data, is_lhs, layout.rows, layout.cols, layout.order, zero_point)];
+}
+
+void* CpuBackendContext::AllocatePrepacked(std::size_t size) {
+  // Packed data is read with vector loads, so align it like ruy's own
+  // allocator does.
+  constexpr std::size_t kAlignment = 64;
+  std::size_t space = size + kAlignment;
+  prepacked_buffers_.emplace_back(new char[space]);
+  void* buffer = prepacked_buffers_.back().get();
+  return std::align(kAlignment, size, buffer, space);
+}
+
 void CpuBackendContext::set_max_num_threads(int max_num_threads) {
   max_num_threads_ = max_num_threads;
   ruy_context_->max_num_threads = max_num_threads;
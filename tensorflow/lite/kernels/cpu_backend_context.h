@@ -16,10 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_CPU_BACKEND_CONTEXT_H_
 #define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_CONTEXT_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <tuple>
+#include <vector>
 
 #include "public/gemmlowp.h"
 #include "tensorflow/lite/experimental/ruy/context.h"
+#include "tensorflow/lite/experimental/ruy/matrix.h"
 
 namespace tflite {
 
@@ -49,6 +55,20 @@ class CpuBackendContext final {
   // See set_max_num_threads.
   int max_num_threads() const { return max_num_threads_; }
 
+  // Returns the cached ruy prepacked form of the constant matrix at `data`,
+  // used as the lhs (if `is_lhs`) or the rhs of a Gemm, see
+  // cpu_backend_gemm::MatrixParams::cacheable. The shape, storage order and
+  // zero_point are part of the key, as the same buffer may be read as several
+  // matrices. The first call for a matrix returns an entry with null data, to
+  // be filled by ruy::PrePackForMul with buffers from AllocatePrepacked.
+  ruy::PrepackedMatrix* GetPrepackedMatrix(const void* data, bool is_lhs,
+                                           const ruy::Layout& layout,
+                                           std::int32_t zero_point);
+
+  // Returns a buffer of `size` bytes owned by this context, for use by
+  // prepacked matrices.
+  void* AllocatePrepacked(std::size_t size);
+
  private:
   // To enable a smooth transition from the current direct usage
   // of the underlying gemmlowp context to going through abstractions
@@ -62,6 +82,14 @@ class CpuBackendContext final {
   // See set_max_num_threads.
   int max_num_threads_;
 
+  // See GetPrepackedMatrix. Keyed by data, is_lhs, rows, cols, order and
+  // zero_point.
+  using PrepackedMatrixKey =
+      std::tuple<const void*, bool, std::int32_t, std::int32_t, ruy::Order,
+                 std::int32_t>;
+  std::map<PrepackedMatrixKey, ruy::PrepackedMatrix> prepacked_matrices_;
+  std::vector<std::unique_ptr<char[]>> prepacked_buffers_;
+
   CpuBackendContext(const CpuBackendContext&) = delete;
 };
 
@@ -47,6 +47,10 @@ struct MatrixParams {
   // The zero_point, i.e. which Scalar value is to be interpreted as zero.
   // When Scalar is floating-point, this must be 0.
   Scalar zero_point = 0;
+  // Whether the data of the matrix is constant across calls with the same
+  // data pointer, e.g. weights, so that the back-end may cache a packed form
+  // of it keyed by that pointer. Back-ends that have no such cache ignore it.
+  bool cacheable = false;
 };
 
 // Enumeration of broad categories of Gemm.
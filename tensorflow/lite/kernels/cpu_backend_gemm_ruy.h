@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_RUY_H_
 
 #include "tensorflow/lite/experimental/ruy/ruy.h"
+#include "tensorflow/lite/experimental/ruy/ruy_advanced.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
 
@@ -79,8 +80,38 @@ struct GemmImplUsingRuy {
     ruy::BasicSpec<AccumScalar, DstScalar> ruy_spec;
     MakeRuySpec(params, &ruy_spec);
 
-    ruy::Mul<ruy::kAllPaths>(ruy_lhs, ruy_rhs, ruy_spec, context->ruy_context(),
-                             &ruy_dst);
+    if (!lhs_params.cacheable && !rhs_params.cacheable) {
+      ruy::Mul<ruy::kAllPaths>(ruy_lhs, ruy_rhs, ruy_spec,
+                               context->ruy_context(), &ruy_dst);
+      return;
+    }
+
+    // Pack the constant operands on the first call only, and reuse their
+    // packed form afterwards.
+    ruy::PrepackedMatrix* prepacked_lhs =
+        lhs_params.cacheable
+            ? context->GetPrepackedMatrix(lhs_data, /*is_lhs=*/true,
+                                          ruy_lhs.layout, ruy_lhs.zero_point)
+            : nullptr;
+    ruy::PrepackedMatrix* prepacked_rhs =
+        rhs_params.cacheable
+            ? context->GetPrepackedMatrix(rhs_data, /*is_lhs=*/false,
+                                          ruy_rhs.layout, ruy_rhs.zero_point)
+            : nullptr;
+    ruy::PrepackedMatrix* lhs_to_pack =
+        prepacked_lhs && !prepacked_lhs->data ? prepacked_lhs : nullptr;
+    ruy::PrepackedMatrix* rhs_to_pack =
+        prepacked_rhs && !prepacked_rhs->data ? prepacked_rhs : nullptr;
+    if (lhs_to_pack || rhs_to_pack) {
+      ruy::PrePackForMul<ruy::kAllPaths>(
+          ruy_lhs, ruy_rhs, ruy_spec, context->ruy_context(), &ruy_dst,
+          lhs_to_pack, rhs_to_pack, [context](std::size_t size) {
+            return context->AllocatePrepacked(size);
+          });
+    }
+    ruy::MulWithPrepacked<ruy::kAllPaths>(ruy_lhs, ruy_rhs, ruy_spec,
+                                          context->ruy_context(), &ruy_dst,
+                                          prepacked_lhs, prepacked_rhs);
   }
 };
 
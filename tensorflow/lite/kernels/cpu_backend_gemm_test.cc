@@ -456,6 +456,16 @@ void TestSomeGemm(int rows, int depth, int cols,
       lhs_params, lhs_data, rhs_params, rhs_data, dst_params, &dst_data, params,
       expected, &cpu_backend_context);
 
+  // Again with both operands marked as cacheable, so that the Gemm calls after
+  // the first one reuse their packed form.
+  MatrixParams<LhsScalar> cacheable_lhs_params = lhs_params;
+  cacheable_lhs_params.cacheable = true;
+  MatrixParams<RhsScalar> cacheable_rhs_params = rhs_params;
+  cacheable_rhs_params.cacheable = true;
+  PerformGemmThenCompareResultsThenAgainWithClamping(
+      cacheable_lhs_params, lhs_data, cacheable_rhs_params, rhs_data,
+      dst_params, &dst_data, params, expected, &cpu_backend_context);
+
   if (!use_golden && !std::is_floating_point<AccumScalar>::value) {
     // Try with per-channel quantized multipliers.
     std::vector<AccumScalar> multiplier_fixedpoint_perchannel(rows);
@@ -511,6 +521,61 @@ TEST(CpuBackendGemmSimpleTestAgainstGolden, Int8Int16) {
       3, 5, 4, {19, 48, 77, 48, 149, 250, 76, 249, 422, 105, 350, 595});
 }
 
+// The same constant buffer may be read as several matrices, e.g. a filter
+// shared by two ops with different shapes or quantization parameters. Check
+// that their packed forms are cached separately.
+TEST(CpuBackendGemmCacheableTest, SameDataWithDifferentParams) {
+  CpuBackendContext cpu_backend_context;
+  std::vector<std::int8_t> lhs_data;
+  std::vector<std::int8_t> rhs_data;
+  MakeVectorFilledWithConsecutiveInts(12, &lhs_data);
+  MakeVectorFilledWithConsecutiveInts(12, &rhs_data);
+  const std::vector<std::int32_t> bias_data(4, 0);
+
+  std::vector<MatrixParams<std::int8_t>> all_lhs_params;
+  MatrixParams<std::int8_t> variant;
+  variant.order = cpu_backend_gemm::Order::kRowMajor;
+  variant.rows = 3;
+  variant.cols = 4;
+  variant.zero_point = 1;
+  all_lhs_params.push_back(variant);
+  variant.rows = 4;
+  variant.cols = 3;
+  all_lhs_params.push_back(variant);
+  variant.zero_point = 5;
+  all_lhs_params.push_back(variant);
+
+  // The second pass reads the packed forms cached by the first one.
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const MatrixParams<std::int8_t>& lhs_params : all_lhs_params) {
+      MatrixParams<std::int8_t> rhs_params;
+      rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+      rhs_params.rows = lhs_params.cols;
+      rhs_params.cols = 12 / lhs_params.cols;
+      rhs_params.zero_point = 2;
+      MatrixParams<std::int16_t> dst_params;
+      dst_params.order = cpu_backend_gemm::Order::kColMajor;
+      dst_params.rows = lhs_params.rows;
+      dst_params.cols = rhs_params.cols;
+      GemmParams<std::int32_t, std::int16_t> params;
+      params.bias = bias_data.data();
+      params.multiplier_fixedpoint = 1 << 30;
+
+      std::vector<std::int16_t> expected(dst_params.rows * dst_params.cols);
+      ReferenceGemm(lhs_params, lhs_data.data(), rhs_params, rhs_data.data(),
+                    dst_params, expected.data(), params,
+                    &cpu_backend_context);
+      MatrixParams<std::int8_t> cacheable_lhs_params = lhs_params;
+      cacheable_lhs_params.cacheable = true;
+      std::vector<std::int16_t> dst_data(expected.size());
+      Gemm(cacheable_lhs_params, lhs_data.data(), rhs_params, rhs_data.data(),
+           dst_params, dst_data.data(), params, &cpu_backend_context);
+      CheckErrorForAccumulation<std::int32_t>(lhs_params.cols, dst_data,
+                                              expected);
+    }
+  }
+}
+
 template <typename tLhsScalar, typename tRhsScalar, typename tAccumScalar,
           typename tDstScalar>
 struct TypesTuple {
@@ -21,6 +21,7 @@ limitations under the License.
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/c_api_internal.h"
@@ -58,8 +59,21 @@ struct OpData {
   int32_t output_activation_max;
   // The index of the temporary tensor where the quantized inputs are cached.
   int scratch_tensor_index;
+  // Constant float weights in which most blocks are zero are also stored in
+  // the block compressed sparse row format of
+  // tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate, and multiplied
+  // by skipping the zero blocks.
+  bool sparse_weights_checked = false;
+  std::vector<float> sparse_weights;
+  std::vector<uint8_t> sparse_weights_ledger;
 };
 
+// The size of the blocks of the sparse weights.
+constexpr int kSparseBlockSize = 16;
+// The minimum fraction of zero blocks for which the sparse kernel beats the
+// dense one.
+constexpr float kMinSparseZeroBlockRatio = 0.7f;
+
 constexpr int kInputTensor = 0;
 constexpr int kWeightsTensor = 1;
 constexpr int kBiasTensor = 2;
@@ -127,6 +141,46 @@ void Free(TfLiteContext* context, void* buffer) {
   delete reinterpret_cast<OpData*>(buffer);
 }
 
+// Stores the weights in data->sparse_weights and data->sparse_weights_ledger
+// if they are constant and sparse enough for the sparse kernel.
+void MaybeSparsifyWeights(const TfLiteTensor* filter, OpData* data) {
+  if (data->sparse_weights_checked) return;
+  data->sparse_weights_checked = true;
+  if (filter->type != kTfLiteFloat32 || !IsConstantTensor(filter)) return;
+
+  const int rows = SizeOfDimension(filter, 0);
+  const int cols = SizeOfDimension(filter, 1);
+  // Block indices and per-row block counts are stored as uint8.
+  if (cols % kSparseBlockSize != 0 || cols >= 254 * kSparseBlockSize) return;
+  const int blocks_per_row = cols / kSparseBlockSize;
+
+  const float* weights = GetTensorData<float>(filter);
+  std::vector<float> sparse_weights;
+  std::vector<uint8_t> ledger;
+  ledger.reserve(rows);
+  int num_nonzero_blocks = 0;
+  for (int r = 0; r < rows; ++r) {
+    const int row_count_index = ledger.size();
+    ledger.push_back(0);
+    for (int b = 0; b < blocks_per_row; ++b) {
+      const float* block = weights + r * cols + b * kSparseBlockSize;
+      if (tensor_utils::IsZeroVector(block, kSparseBlockSize)) continue;
+      ++ledger[row_count_index];
+      ledger.push_back(b);
+      sparse_weights.insert(sparse_weights.end(), block,
+                            block + kSparseBlockSize);
+      ++num_nonzero_blocks;
+    }
+  }
+  const int num_blocks = rows * blocks_per_row;
+  if (num_blocks - num_nonzero_blocks <
+      kMinSparseZeroBlockRatio * num_blocks) {
+    return;
+  }
+  data->sparse_weights = std::move(sparse_weights);
+  data->sparse_weights_ledger = std::move(ledger);
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   auto* params =
       reinterpret_cast<TfLiteFullyConnectedParams*>(node->builtin_data);
@@ -178,6 +232,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
         &data->output_activation_max));
   }
 
+  MaybeSparsifyWeights(filter, data);
+
   // If we have to perform on-the-fly quantization (with quantized weights and
   // float inputs) first we need to quantize the inputs. Allocate a temporary
   // buffer to store the intermediate quantized values.
@@ -264,6 +320,35 @@ TfLiteStatus EvalPie(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+TfLiteStatus EvalSparse(TfLiteContext* context, TfLiteNode* node,
+                        TfLiteFullyConnectedParams* params, OpData* data,
+                        const TfLiteTensor* input, const TfLiteTensor* filter,
+                        const TfLiteTensor* bias, TfLiteTensor* output) {
+  const int input_size = filter->dims->data[1];
+  const int batch_size = NumElements(input) / input_size;
+  const int num_units = filter->dims->data[0];
+
+  // Output = bias if bias tensor exists.
+  if (bias) {
+    tensor_utils::VectorBatchVectorAssign(bias->data.f, num_units, batch_size,
+                                          output->data.f);
+  } else {
+    tensor_utils::ZeroVector(output->data.f, batch_size * num_units);
+  }
+
+  // Compute output += weight * input, skipping the zero blocks of weight.
+  tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate(
+      data->sparse_weights.data(), data->sparse_weights_ledger.data(),
+      num_units, input_size, input->data.f, batch_size, output->data.f,
+      /*result_stride=*/1);
+
+  // Apply activation function
+  tensor_utils::ApplyActivationToVector(output->data.f, batch_size * num_units,
+                                        params->activation, output->data.f);
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
                         TfLiteFullyConnectedParams* params, OpData* data,
                         const TfLiteTensor* input, const TfLiteTensor* filter,
@@ -343,6 +428,8 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
   op_params.output_shift = data->output_shift;
   op_params.quantized_activation_min = data->output_activation_min;
   op_params.quantized_activation_max = data->output_activation_max;
+  op_params.lhs_cacheable = IsConstantTensor(filter);
+  op_params.rhs_cacheable = IsConstantTensor(input);
   if (kernel_type == kReference) {
     reference_integer_ops::FullyConnected(
         op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
@@ -384,6 +471,8 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
     op_params.output_shift = data->output_shift;
     op_params.quantized_activation_min = data->output_activation_min;
     op_params.quantized_activation_max = data->output_activation_max;
+    op_params.lhs_cacheable = IsConstantTensor(filter);
+    op_params.rhs_cacheable = IsConstantTensor(input);
     switch (output->type) {
       case kTfLiteUInt8:
         if (kernel_type == kReference) {
@@ -503,10 +592,14 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
         GetTensorShape(output), GetTensorData<float>(output));
   } else if (kernel_type == kLegacyPie) {
     return EvalPie(context, node, params, data, input, filter, bias, output);
+  } else if (!data->sparse_weights_ledger.empty()) {
+    return EvalSparse(context, node, params, data, input, filter, bias, output);
   } else {
     FullyConnectedParams op_params;
     op_params.float_activation_min = output_activation_min;
     op_params.float_activation_max = output_activation_max;
+    op_params.lhs_cacheable = IsConstantTensor(filter);
+    op_params.rhs_cacheable = IsConstantTensor(input);
     optimized_ops::FullyConnected(
         op_params, GetTensorShape(input), GetTensorData<float>(input),
         GetTensorShape(filter), GetTensorData<float>(filter),
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 // Unit test for TFLite FULLY_CONNECTED op.
 
+#include <algorithm>
 #include <iomanip>
 #include <random>
 #include <vector>
@@ -330,6 +331,43 @@ class HybridFullyConnectedOpModel : public SingleOpModel {
   int input_size_;
 };
 
+// A float model with constant weights, which kernels may preprocess in Prepare.
+class ConstWeightsFullyConnectedOpModel : public SingleOpModel {
+ public:
+  ConstWeightsFullyConnectedOpModel(TfLiteRegistration* registration, int units,
+                                    int batches, const TensorData& input,
+                                    std::initializer_list<float> weights) {
+    int total_input_size = 1;
+    for (size_t i = 0; i < input.shape.size(); ++i) {
+      total_input_size *= input.shape[i];
+    }
+    const int input_size = total_input_size / batches;
+
+    input_ = AddInput(input);
+    AddConstInput(TensorType_FLOAT32, weights, {units, input_size});
+    bias_ = AddInput({TensorType_FLOAT32, {units}});
+    output_ = AddOutput(TensorType_FLOAT32);
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_RELU)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), {units, input_size}, GetShape(bias_)});
+  }
+
+  void SetBias(const std::vector<float>& f) { PopulateTensor(bias_, f); }
+  void SetInput(const std::vector<float>& f) { PopulateTensor(input_, f); }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ protected:
+  int input_;
+  int bias_;
+  int output_;
+};
+
 const auto kKernelMap = new std::map<string, TfLiteRegistration*>({
     {"Reference", ops::builtin::Register_FULLY_CONNECTED_REF()},
     {"GenericOptimized", ops::builtin::Register_FULLY_CONNECTED_GENERIC_OPT()},
@@ -412,6 +450,32 @@ TEST_P(FloatFullyConnectedOpTest, SimpleTest2) {
   EXPECT_THAT(m.GetOutput(), ElementsAre(11, 9));
 }
 
+TEST_P(FloatFullyConnectedOpTest, SparseConstWeights) {
+  // 5 of the 6 blocks of 16 weights are zero.
+  ConstWeightsFullyConnectedOpModel m(
+      GetRegistration(), /*units=*/3, /*batches=*/2,
+      /*input=*/{TensorType_FLOAT32, {2, 32}},
+      /*weights=*/{
+          0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   // u = 0
+          1, 2, 3, 4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16,  // u = 0
+          0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   // u = 1
+          0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   // u = 1
+          0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   // u = 2
+          0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   // u = 2
+      });
+  m.SetBias({1, 2, 3});
+
+  std::vector<float> input(64, 1.0f);
+  // The second half of the second batch is negative.
+  std::fill(input.begin() + 48, input.end(), -1.0f);
+  m.SetInput(input);
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 3));
+  EXPECT_THAT(m.GetOutput(), ElementsAre(137, 2, 3, 0, 2, 3));
+}
+
 TEST(FloatFullyConnectedOpTest, SimpleTestNoBias) {
   // The optimized kernel assumes that the bias is specified.
   FloatFullyConnectedOpModel m(ops::builtin::Register_FULLY_CONNECTED_PIE(),
@@ -62,11 +62,13 @@ inline void FullyConnected(
   lhs_params.cols = filter_cols;
   lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
   lhs_params.zero_point = -filter_offset;
+  lhs_params.cacheable = params.lhs_cacheable;
   cpu_backend_gemm::MatrixParams<int8> rhs_params;
   rhs_params.rows = filter_cols;
   rhs_params.cols = batches;
   rhs_params.order = cpu_backend_gemm::Order::kColMajor;
   rhs_params.zero_point = -input_offset;
+  rhs_params.cacheable = params.rhs_cacheable;
   cpu_backend_gemm::MatrixParams<int8> dst_params;
   dst_params.rows = filter_rows;
   dst_params.cols = batches;
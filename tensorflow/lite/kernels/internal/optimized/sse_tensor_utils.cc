@@ -61,8 +61,44 @@ static inline int32_t ReduceInt32x4(__m128i acc) {
   return _mm_extract_epi32(acc, 0);
 }
 
+// Horizontally add 4 float values stored in a single XMM register to float.
+static inline float ReduceFloat32x4(__m128 acc) {
+  acc = _mm_hadd_ps(acc, acc);  // SSE3
+  acc = _mm_hadd_ps(acc, acc);  // SSE3
+  return _mm_cvtss_f32(acc);    // SSE
+}
+
 }  // namespace
 
+void SseSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
+    int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
+    float* __restrict__ result, int result_stride) {
+  static const int kBlockSize = 16;
+  static const int kFloatsPerSseLane = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  for (int batch = 0; batch < n_batch; ++batch, vector += m_cols) {
+    const uint8_t* ledger_ptr = ledger;
+    const float* row_ptr = matrix;
+    for (int row = 0; row < m_rows; ++row, result += result_stride) {
+      __m128 dotprod_f32x4 = _mm_setzero_ps();
+      int num_nonzero_blocks = *ledger_ptr++;
+      for (int i = 0; i < num_nonzero_blocks; i++) {
+        const float* vector_block_ptr = vector + *ledger_ptr++ * kBlockSize;
+        for (int c = 0; c < kBlockSize; c += kFloatsPerSseLane) {
+          const __m128 vec_f32x4 = _mm_loadu_ps(vector_block_ptr + c);
+          const __m128 row_f32x4 = _mm_loadu_ps(row_ptr + c);
+          dotprod_f32x4 =
+              _mm_add_ps(dotprod_f32x4, _mm_mul_ps(vec_f32x4, row_f32x4));
+        }
+        row_ptr += kBlockSize;
+      }
+      *result += ReduceFloat32x4(dotprod_f32x4);
+    }  // for row
+  }    // for batch
+}
+
 void SseMatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
     const int8_t* __restrict__ vectors, const float* scaling_factors,
@@ -32,6 +32,12 @@ void SseMatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ vectors, const float* scaling_factors,
     int n_batch, float* __restrict__ result, int result_stride);
 
+// Matrix multiplication for float values. Sparse version.
+void SseSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
+    int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
+    float* __restrict__ result, int result_stride);
+
 // Matrix multiplication for quantized values using symmetric quantization.
 // Sparse version.
 void SseSparseMatrixBatchVectorMultiplyAccumulate(
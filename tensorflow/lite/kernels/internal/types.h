@@ -800,6 +800,9 @@ struct ConvParams {
   // float activation params.
   float float_activation_min;
   float float_activation_max;
+  // Whether the filter data is constant across calls, see
+  // cpu_backend_gemm::MatrixParams::cacheable.
+  bool lhs_cacheable = false;
 };
 
 struct DepthToSpaceParams {
@@ -854,6 +857,10 @@ struct FullyConnectedParams {
   float float_activation_min;
   float float_activation_max;
   FullyConnectedWeightsFormat weights_format;
+  // Whether the weights, resp. input, data is constant across calls, see
+  // cpu_backend_gemm::MatrixParams::cacheable.
+  bool lhs_cacheable = false;
+  bool rhs_cacheable = false;
 };
 
 struct GatherParams {
@@ -0,0 +1,48 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/weights_cache.h"
+
+namespace tflite {
+
+WeightsCache::WeightsCache() {
+  type = kTfLiteWeightsCacheContext;
+  // The cache does not depend on the number of threads.
+  Refresh = nullptr;
+}
+
+WeightsCache* WeightsCache::FromContext(TfLiteContext* context) {
+  return static_cast<WeightsCache*>(
+      context->GetExternalContext(context, kTfLiteWeightsCacheContext));
+}
+
+const void* WeightsCache::GetOrCreate(
+    const void* weights, const std::string& kind, size_t bytes,
+    const std::function<void(void* buffer)>& fill) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<char[]>& buffer = buffers_[{weights, kind}];
+  if (!buffer) {
+    buffer.reset(new char[bytes]);
+    fill(buffer.get());
+    size_bytes_ += bytes;
+  }
+  return buffer.get();
+}
+
+size_t WeightsCache::size_bytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_bytes_;
+}
+
+}  // namespace tflite
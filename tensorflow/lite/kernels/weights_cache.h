@@ -0,0 +1,66 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_WEIGHTS_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_WEIGHTS_CACHE_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "tensorflow/lite/c/c_api_internal.h"
+
+namespace tflite {
+
+// Immutable buffers that ops derive from constant weights, e.g. transposed
+// convolution filters, shared by all the interpreters built from the same
+// FlatBufferModel, so that only activations are duplicated per interpreter.
+// Set it on every interpreter before AllocateTensors():
+//
+//   interpreter->SetExternalContext(kTfLiteWeightsCacheContext, &cache);
+//
+// Buffers are identified by the address of the weights they are derived
+// from, so the cache must not outlive the model.
+class WeightsCache : public TfLiteExternalContext {
+ public:
+  WeightsCache();
+  WeightsCache(const WeightsCache&) = delete;
+  WeightsCache& operator=(const WeightsCache&) = delete;
+
+  // Returns the cache set on `context`, or null if there is none.
+  static WeightsCache* FromContext(TfLiteContext* context);
+
+  // Returns the `bytes` long buffer of the given kind derived from `weights`.
+  // The first call for a given buffer allocates it and fills it with `fill`.
+  // Thread-safe.
+  const void* GetOrCreate(const void* weights, const std::string& kind,
+                          size_t bytes,
+                          const std::function<void(void* buffer)>& fill);
+
+  // The total size of the buffers in the cache.
+  size_t size_bytes();
+
+ private:
+  std::mutex mutex_;
+  std::map<std::pair<const void*, std::string>, std::unique_ptr<char[]>>
+      buffers_;
+  size_t size_bytes_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_WEIGHTS_CACHE_H_
@@ -0,0 +1,95 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/weights_cache.h"
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+struct TestTfLiteContext : public TfLiteContext {
+  TestTfLiteContext() {
+    external_context = nullptr;
+    GetExternalContext = GetExternalContextImpl;
+  }
+
+  static TfLiteExternalContext* GetExternalContextImpl(
+      TfLiteContext* context, TfLiteExternalContextType type) {
+    auto* external_context =
+        static_cast<TestTfLiteContext*>(context)->external_context;
+    return external_context && external_context->type == type
+               ? external_context
+               : nullptr;
+  }
+
+  TfLiteExternalContext* external_context;
+};
+
+TEST(WeightsCacheTest, FromContext) {
+  TestTfLiteContext context;
+  EXPECT_EQ(WeightsCache::FromContext(&context), nullptr);
+
+  WeightsCache cache;
+  context.external_context = &cache;
+  EXPECT_EQ(WeightsCache::FromContext(&context), &cache);
+}
+
+TEST(WeightsCacheTest, FillsEachBufferOnce) {
+  WeightsCache cache;
+  const float weights[] = {1.0f, 2.0f};
+  const float other_weights[] = {3.0f, 4.0f};
+  int num_fills = 0;
+  auto reverse = [&num_fills](const float* weights) {
+    return [&num_fills, weights](void* buffer) {
+      ++num_fills;
+      float* reversed = static_cast<float*>(buffer);
+      reversed[0] = weights[1];
+      reversed[1] = weights[0];
+    };
+  };
+
+  const float* reversed = static_cast<const float*>(cache.GetOrCreate(
+      weights, "reversed", sizeof(weights), reverse(weights)));
+  EXPECT_EQ(reversed[0], 2.0f);
+  EXPECT_EQ(reversed[1], 1.0f);
+  EXPECT_EQ(cache.GetOrCreate(weights, "reversed", sizeof(weights),
+                              reverse(weights)),
+            reversed);
+  EXPECT_EQ(num_fills, 1);
+
+  // Other weights, or another kind of buffer, get their own buffer.
+  const float* other_reversed = static_cast<const float*>(cache.GetOrCreate(
+      other_weights, "reversed", sizeof(other_weights),
+      reverse(other_weights)));
+  EXPECT_EQ(other_reversed[0], 4.0f);
+  EXPECT_NE(cache.GetOrCreate(weights, "copied", sizeof(weights),
+                              [&weights](void* buffer) {
+                                std::memcpy(buffer, weights, sizeof(weights));
+                              }),
+            reversed);
+  EXPECT_EQ(num_fills, 2);
+  EXPECT_EQ(cache.size_bytes(), 3 * sizeof(weights));
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
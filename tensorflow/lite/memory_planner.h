@@ -43,6 +43,11 @@ class MemoryPlanner {
   // have changed. All planned allocations remain, but can't be used until
   // ExecuteAllocations() is called.
   virtual TfLiteStatus ResetAllocations() = 0;
+
+  // Returns the bytes currently reserved for tensors that are allocated and
+  // deallocated as the graph runs, and for persistent tensors.
+  virtual void GetAllocInfo(size_t* arena_size,
+                            size_t* arena_persist_size) const = 0;
 };
 
 }  // namespace tflite
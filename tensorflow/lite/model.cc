@@ -22,6 +22,7 @@ limitations under the License.
 #include <sys/types.h>
 
 #include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/c_api_internal.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
@@ -400,6 +401,33 @@ TfLiteStatus InterpreterBuilder::ParseQuantization(
   return kTfLiteOk;
 }
 
+void InterpreterBuilder::ParseOfflineArenaPlanMetadata(
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+    Subgraph* subgraph) {
+  auto* metadata = model_->metadata();
+  if (!metadata) return;
+  for (const tflite::Metadata* entry : *metadata) {
+    if (!entry->name() ||
+        entry->name()->str() != kOfflineArenaPlanMetadataName) {
+      continue;
+    }
+    const tflite::Buffer* buffer = nullptr;
+    if (entry->buffer() < buffers->size()) {
+      buffer = (*buffers)[entry->buffer()];
+    }
+    std::unique_ptr<OfflineArenaPlan> plan(new OfflineArenaPlan);
+    if (!buffer || !buffer->data() ||
+        !ParseOfflineArenaPlan(buffer->data()->data(), buffer->data()->size(),
+                               plan.get())) {
+      // The plan is only an optimization, so fall back to planning at runtime.
+      error_reporter_->Report("Ignoring invalid offline arena plan.\n");
+      return;
+    }
+    subgraph->SetOfflineArenaPlan(std::move(plan));
+    return;
+  }
+}
+
 TfLiteStatus InterpreterBuilder::ParseTensors(
     const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
     const flatbuffers::Vector<flatbuffers::Offset<Tensor>>* tensors,
@@ -594,6 +622,10 @@ TfLiteStatus InterpreterBuilder::operator()(
       }
     }
     modified_subgraph->SetVariables(std::move(variables));
+
+    if (subgraph_index == 0) {
+      ParseOfflineArenaPlanMetadata(buffers, modified_subgraph);
+    }
   }
 
   if (ApplyDelegates(interpreter->get()) != kTfLiteOk)
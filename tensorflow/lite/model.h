@@ -208,6 +208,11 @@ class InterpreterBuilder {
       const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
       const flatbuffers::Vector<flatbuffers::Offset<Tensor>>* tensors,
       Subgraph* subgraph);
+  // Hands the OfflineArenaPlan stored in the model metadata, if any, to
+  // `subgraph`.
+  void ParseOfflineArenaPlanMetadata(
+      const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+      Subgraph* subgraph);
   TfLiteStatus ApplyDelegates(Interpreter* interpreter);
   TfLiteStatus ParseQuantization(const QuantizationParameters* src_quantization,
                                  TfLiteQuantization* quantization,
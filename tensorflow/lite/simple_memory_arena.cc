@@ -104,6 +104,13 @@ TfLiteStatus SimpleMemoryArena::Deallocate(TfLiteContext* context,
 TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
   size_t required_size = RequiredBufferSize();
   if (required_size > underlying_buffer_size_) {
+    // Once the buffer exists, grow it by at least a quarter so that repeated
+    // modest growth, e.g. from resizing the inputs of a graph, does not move
+    // the tensors every time. The buffer never shrinks.
+    if (underlying_buffer_size_ > 0) {
+      required_size = std::max(
+          required_size, underlying_buffer_size_ + underlying_buffer_size_ / 4);
+    }
     char* new_alloc = new char[required_size];
     char* new_underlying_buffer_aligned_ptr = reinterpret_cast<char*>(
         AlignTo(arena_alignment_, reinterpret_cast<intptr_t>(new_alloc)));
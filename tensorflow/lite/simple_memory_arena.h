@@ -62,6 +62,9 @@ class SimpleMemoryArena {
     return arena_alignment_ + high_water_mark_ + padding;
   }
 
+  // Returns the size of the underlying buffer, as of the last Commit().
+  size_t GetBufferSize() const { return underlying_buffer_size_; }
+
   TfLiteStatus Commit(TfLiteContext* context);
 
   TfLiteStatus ResolveAlloc(TfLiteContext* context, const ArenaAlloc& alloc,
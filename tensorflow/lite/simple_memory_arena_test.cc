@@ -123,6 +123,34 @@ TEST(SimpleMemoryArenaTest, TestAfterClear) {
   EXPECT_EQ(allocs[8].offset, 8192);
 }
 
+TEST(SimpleMemoryArenaTest, KeepsBufferForSmallerOrSlightlyLargerAllocs) {
+  TfLiteContext context;
+  SimpleMemoryArena arena(64);
+  ArenaAlloc alloc;
+
+  arena.Allocate(&context, 32, 4096, &alloc);
+  arena.Commit(&context);
+  const int64_t initial_base = arena.BasePointer();
+
+  // Shrinking keeps the buffer.
+  arena.Clear();
+  arena.Allocate(&context, 32, 1024, &alloc);
+  arena.Commit(&context);
+  EXPECT_EQ(arena.BasePointer(), initial_base);
+
+  // Growing reallocates with some headroom...
+  arena.Clear();
+  arena.Allocate(&context, 32, 4352, &alloc);
+  arena.Commit(&context);
+  const int64_t grown_base = arena.BasePointer();
+
+  // ... which further modest growth fits in.
+  arena.Clear();
+  arena.Allocate(&context, 32, 5120, &alloc);
+  arena.Commit(&context);
+  EXPECT_EQ(arena.BasePointer(), grown_base);
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -52,6 +52,7 @@ BenchmarkParams CreateParams(int32_t num_runs, float min_secs, float max_secs) {
   params.AddParam("enable_op_profiling", BenchmarkParam::Create<bool>(false));
   params.AddParam("max_profiling_buffer_entries",
                   BenchmarkParam::Create<int32_t>(1024));
+  params.AddParam("chrome_trace_file", BenchmarkParam::Create<std::string>(""));
   return params;
 }
 
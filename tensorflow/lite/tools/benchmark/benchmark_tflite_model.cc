@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/lite/tools/benchmark/benchmark_tflite_model.h"
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -28,6 +32,7 @@ limitations under the License.
 #include "tensorflow/lite/op_resolver.h"
 #include "tensorflow/lite/profiling/buffered_profiler.h"
 #include "tensorflow/lite/profiling/profile_summarizer.h"
+#include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/logging.h"
 #include "tensorflow/lite/tools/evaluation/utils.h"
@@ -51,13 +56,19 @@ constexpr int kOpProfilingEnabledDefault = true;
 constexpr int kOpProfilingEnabledDefault = false;
 #endif
 
-// Dumps profiling events if profiling is enabled.
+// Dumps profiling events if profiling is enabled. Besides the summary of the
+// ProfileSummarizer, logs latency percentiles of each operator and the time
+// spent in delegated partitions, and optionally writes every event to
+// `chrome_trace_file` in the Chrome trace event format (chrome://tracing).
 class ProfilingListener : public BenchmarkListener {
  public:
-  explicit ProfilingListener(Interpreter* interpreter, uint32_t max_num_entries)
+  explicit ProfilingListener(Interpreter* interpreter, uint32_t max_num_entries,
+                             const std::string& chrome_trace_file)
       : interpreter_(interpreter),
         profiler_(max_num_entries),
-        has_profiles_(false) {
+        chrome_trace_file_(chrome_trace_file),
+        has_profiles_(false),
+        num_profiled_runs_(0) {
     TFLITE_BENCHMARK_CHECK(interpreter);
     interpreter_->SetProfiler(&profiler_);
   }
@@ -69,10 +80,41 @@ class ProfilingListener : public BenchmarkListener {
   void OnBenchmarkEnd(const BenchmarkResults& results) override;
 
  private:
+  struct TraceEvent {
+    std::string name;
+    std::string tag;
+    int node_index;
+    bool delegated;
+    uint64_t begin_us;
+    uint64_t duration_us;
+  };
+
+  // Returns the name of the operator of node `node_index`.
+  std::string GetOperatorName(int node_index) const;
+
+  // Returns whether node `node_index` is a kernel created by a delegate.
+  bool IsDelegatedNode(int node_index) const;
+
+  // Logs the 50th, 90th and 99th percentiles of the latency of each operator.
+  void LogOperatorPercentiles() const;
+
+  // Logs the average time spent in delegated partitions and in the operators
+  // left to the CPU, and the bytes each partition reads and writes. These are
+  // the bytes a delegate has to copy in and out when it keeps tensors in its
+  // own memory.
+  void LogDelegatePartitions() const;
+
+  void WriteChromeTrace() const;
+
   Interpreter* interpreter_;
   profiling::BufferedProfiler profiler_;
   profiling::ProfileSummarizer summarizer_;
+  const std::string chrome_trace_file_;
   bool has_profiles_;
+  int num_profiled_runs_;
+  // Latencies of the invocations of each node, by node index.
+  std::map<int, std::vector<uint64_t>> op_latencies_us_;
+  std::vector<TraceEvent> trace_events_;
 };
 
 // Dumps gemmlowp profiling events if gemmlowp profiling is enabled.
@@ -93,6 +135,11 @@ void ProfilingListener::OnSingleRunStart(RunType run_type) {
 void ProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
   if (has_profiles_) {
     TFLITE_LOG(INFO) << summarizer_.GetOutputString();
+    LogOperatorPercentiles();
+    LogDelegatePartitions();
+  }
+  if (!chrome_trace_file_.empty()) {
+    WriteChromeTrace();
   }
 }
 
@@ -101,6 +148,147 @@ void ProfilingListener::OnSingleRunEnd() {
   auto profile_events = profiler_.GetProfileEvents();
   has_profiles_ = !profile_events.empty();
   summarizer_.ProcessProfiles(profile_events, *interpreter_);
+  if (profile_events.empty()) {
+    return;
+  }
+
+  ++num_profiled_runs_;
+  for (const profiling::ProfileEvent* event : profile_events) {
+    if (event->end_timestamp_us < event->begin_timestamp_us) {
+      continue;
+    }
+    const uint64_t duration_us =
+        event->end_timestamp_us - event->begin_timestamp_us;
+    const bool is_op_event =
+        event->event_type ==
+        profiling::ProfileEvent::EventType::OPERATOR_INVOKE_EVENT;
+    const int node_index =
+        is_op_event ? static_cast<int>(event->event_metadata) : -1;
+    if (is_op_event && std::string(event->tag) == "OpInvoke") {
+      op_latencies_us_[node_index].push_back(duration_us);
+    }
+    if (!chrome_trace_file_.empty()) {
+      trace_events_.push_back(
+          {is_op_event ? GetOperatorName(node_index) : event->tag, event->tag,
+           node_index, is_op_event && IsDelegatedNode(node_index),
+           event->begin_timestamp_us, duration_us});
+    }
+  }
+}
+
+std::string ProfilingListener::GetOperatorName(int node_index) const {
+  const auto* node_and_reg = interpreter_->node_and_registration(node_index);
+  if (node_and_reg == nullptr) {
+    return "Unknown";
+  }
+  const TfLiteRegistration& reg = node_and_reg->second;
+  if (reg.builtin_code == tflite::BuiltinOperator_CUSTOM) {
+    return reg.custom_name ? reg.custom_name : "UnknownCustomOp";
+  }
+  return tflite::EnumNamesBuiltinOperator()[reg.builtin_code];
+}
+
+bool ProfilingListener::IsDelegatedNode(int node_index) const {
+  const auto* node_and_reg = interpreter_->node_and_registration(node_index);
+  return node_and_reg != nullptr && node_and_reg->first.delegate != nullptr;
+}
+
+void ProfilingListener::LogOperatorPercentiles() const {
+  auto percentile = [](const std::vector<uint64_t>& sorted, int p) {
+    return sorted[(sorted.size() - 1) * p / 100];
+  };
+  std::stringstream stream;
+  stream << "Operator latency percentiles (us) over " << num_profiled_runs_
+         << " runs:\n";
+  stream << "node\toperator\tcount\tp50\tp90\tp99\n";
+  for (const auto& node_latencies : op_latencies_us_) {
+    std::vector<uint64_t> sorted = node_latencies.second;
+    std::sort(sorted.begin(), sorted.end());
+    stream << node_latencies.first << "\t"
+           << GetOperatorName(node_latencies.first) << "\t" << sorted.size()
+           << "\t" << percentile(sorted, 50) << "\t" << percentile(sorted, 90)
+           << "\t" << percentile(sorted, 99) << "\n";
+  }
+  TFLITE_LOG(INFO) << stream.str();
+}
+
+void ProfilingListener::LogDelegatePartitions() const {
+  uint64_t delegated_us = 0;
+  uint64_t cpu_us = 0;
+  for (const auto& node_latencies : op_latencies_us_) {
+    uint64_t total_us = 0;
+    for (uint64_t latency_us : node_latencies.second) {
+      total_us += latency_us;
+    }
+    (IsDelegatedNode(node_latencies.first) ? delegated_us : cpu_us) +=
+        total_us;
+  }
+  if (delegated_us == 0) {
+    return;
+  }
+
+  auto non_constant_bytes = [this](const TfLiteIntArray* tensors) {
+    size_t bytes = 0;
+    for (int i = 0; i < tensors->size; ++i) {
+      const TfLiteTensor* tensor = interpreter_->tensor(tensors->data[i]);
+      if (tensor != nullptr && tensor->allocation_type != kTfLiteMmapRo) {
+        bytes += tensor->bytes;
+      }
+    }
+    return bytes;
+  };
+  std::stringstream stream;
+  const int num_runs = std::max(num_profiled_runs_, 1);
+  stream << "Average time per run in delegated partitions: "
+         << delegated_us / num_runs << " us, in CPU operators: "
+         << cpu_us / num_runs << " us\n";
+  stream << "Delegated partitions:\n";
+  stream << "node\toperator\tinput bytes\toutput bytes\n";
+  for (int node_index : interpreter_->execution_plan()) {
+    if (!IsDelegatedNode(node_index)) {
+      continue;
+    }
+    const TfLiteNode& node =
+        interpreter_->node_and_registration(node_index)->first;
+    stream << node_index << "\t" << GetOperatorName(node_index) << "\t"
+           << non_constant_bytes(node.inputs) << "\t"
+           << non_constant_bytes(node.outputs) << "\n";
+  }
+  TFLITE_LOG(INFO) << stream.str();
+}
+
+void ProfilingListener::WriteChromeTrace() const {
+  auto escape = [](const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        escaped += '\\';
+      }
+      escaped += c;
+    }
+    return escaped;
+  };
+  std::ofstream trace(chrome_trace_file_);
+  if (!trace) {
+    TFLITE_LOG(ERROR) << "Failed to open " << chrome_trace_file_;
+    return;
+  }
+  trace << "{\"traceEvents\":[";
+  bool first = true;
+  for (const TraceEvent& event : trace_events_) {
+    trace << (first ? "\n" : ",\n");
+    first = false;
+    // Delegated partitions and the operators left to the CPU are shown as two
+    // threads, to make the hand-offs between them stand out.
+    trace << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\""
+          << escape(event.tag) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+          << (event.delegated ? 1 : 0) << ",\"ts\":" << event.begin_us
+          << ",\"dur\":" << event.duration_us
+          << ",\"args\":{\"node_index\":" << event.node_index << "}}";
+  }
+  trace << "\n]}\n";
+  TFLITE_LOG(INFO) << "Wrote " << trace_events_.size()
+                   << " profiling events to " << chrome_trace_file_;
 }
 
 void GemmlowpProfilingListener::OnBenchmarkStart(
@@ -240,6 +428,8 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
       BenchmarkParam::Create<bool>(kOpProfilingEnabledDefault));
   default_params.AddParam("max_profiling_buffer_entries",
                           BenchmarkParam::Create<int32_t>(1024));
+  default_params.AddParam("chrome_trace_file",
+                          BenchmarkParam::Create<std::string>(""));
   return default_params;
 }
 
@@ -276,7 +466,10 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
       CreateFlag<bool>("allow_fp16", &params_, "allow fp16"),
       CreateFlag<bool>("enable_op_profiling", &params_, "enable op profiling"),
       CreateFlag<int32_t>("max_profiling_buffer_entries", &params_,
-                          "max profiling buffer entries")};
+                          "max profiling buffer entries"),
+      CreateFlag<std::string>(
+          "chrome_trace_file", &params_,
+          "file to write op profiling events to, in Chrome trace format")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
   return flags;
@@ -300,6 +493,8 @@ void BenchmarkTfLiteModel::LogParams() {
   TFLITE_LOG(INFO) << "Max profiling buffer entries: ["
                    << params_.Get<int32_t>("max_profiling_buffer_entries")
                    << "]";
+  TFLITE_LOG(INFO) << "Chrome trace file: ["
+                   << params_.Get<std::string>("chrome_trace_file") << "]";
 }
 
 bool BenchmarkTfLiteModel::ValidateParams() {
@@ -486,11 +681,24 @@ void BenchmarkTfLiteModel::Init() {
     TFLITE_LOG(FATAL) << "Failed to allocate tensors!";
   }
 
+  size_t arena_bytes = 0;
+  size_t arena_persist_bytes = 0;
+  for (int i = 0; i < interpreter->subgraphs_size(); ++i) {
+    size_t subgraph_arena_bytes;
+    size_t subgraph_arena_persist_bytes;
+    interpreter->subgraph(i)->GetMemoryAllocInfo(
+        &subgraph_arena_bytes, &subgraph_arena_persist_bytes);
+    arena_bytes += subgraph_arena_bytes;
+    arena_persist_bytes += subgraph_arena_persist_bytes;
+  }
+  TFLITE_LOG(INFO) << "Arena bytes: " << arena_bytes
+                   << ", persistent arena bytes: " << arena_persist_bytes;
+
   // Install profilers if necessary.
   if (params_.Get<bool>("enable_op_profiling")) {
     profiling_listener_.reset(new ProfilingListener(
-        interpreter.get(),
-        params_.Get<int32_t>("max_profiling_buffer_entries")));
+        interpreter.get(), params_.Get<int32_t>("max_profiling_buffer_entries"),
+        params_.Get<std::string>("chrome_trace_file")));
     AddListener(profiling_listener_.get());
   }
 #ifdef GEMMLOWP_PROFILING
@@ -103,6 +103,8 @@ Interpreter::TfLiteDelegatePtr CreateGPUDelegate(
   options.compile_options.preferred_gl_object_type =
       TFLITE_GL_OBJECT_TYPE_FASTEST;
   options.compile_options.dynamic_batch_enabled = 0;
+  options.serialization_dir = nullptr;
+  options.model_token = nullptr;
 
   return CreateGPUDelegate(model, &options);
 #else
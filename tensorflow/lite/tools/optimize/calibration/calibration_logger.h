@@ -32,24 +32,38 @@ class MinMax {
     if (tensor_size <= 0) return kTfLiteOk;
 
     // TODO(shashishekhar): Make it possible to use weighted/moving average.
+    // We are only logging absolute min/max here. The NaN check and the min/max
+    // are computed in a single pass, since activations can be large.
+    float min = min_;
+    float max = max_;
     for (size_t i = 0; i < tensor_size; ++i) {
-      if (std::isnan(values[i])) {
+      const float value = values[i];
+      if (std::isnan(value)) {
         // TODO(suharshs): Propagate ErrorReporter here.
         LOG(ERROR) << "Model resulted in Nan value during calibration. Please "
                       "make sure model results in all real-values during "
                       "inference with provided dataset.";
         return kTfLiteError;
       }
+      min = std::min(min, value);
+      max = std::max(max, value);
     }
-    // We are only logging absolute min/max here.
-    const auto minmax = std::minmax_element(values, values + tensor_size);
-    min_ = std::min<float>(min_, *minmax.first);
-    max_ = std::max<float>(max_, *minmax.second);
+    min_ = min;
+    max_ = max;
 
     if (!has_values_) has_values_ = true;
     return kTfLiteOk;
   }
 
+  // Widens the range to include the values seen by |other|, e.g. by another
+  // interpreter that ran on a different part of the calibration dataset.
+  void Merge(const MinMax& other) {
+    if (!other.has_values_) return;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    has_values_ = true;
+  }
+
   bool HasValues() const { return has_values_; }
 
   TfLiteStatus Get(float* min_val, float* max_val) const {
@@ -62,7 +76,7 @@ class MinMax {
  private:
   bool has_values_ = false;
   float min_ = std::numeric_limits<float>::max();
-  float max_ = std::numeric_limits<float>::min();
+  float max_ = std::numeric_limits<float>::lowest();
 };
 
 // Captures min max values for tensors.
@@ -75,6 +89,13 @@ class Logger {
                                                         tensor_size);
   }
 
+  // Adds the values logged by |other| to the ones logged by this logger.
+  void Merge(const Logger& other) {
+    for (const auto& tensorid_stat : other.tensor_id_to_stats_map_) {
+      tensor_id_to_stats_map_[tensorid_stat.first].Merge(tensorid_stat.second);
+    }
+  }
+
   // Returns a map from tensor_index -> observed min max values.
   const std::unordered_map<int, MinMax>& GetCalibrationValues() const {
     return tensor_id_to_stats_map_;
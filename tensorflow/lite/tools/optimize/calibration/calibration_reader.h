@@ -44,6 +44,13 @@ class CalibrationReader {
   // calibration.
   virtual TfLiteStatus AddCalibrationToModel(ModelT* model) const;
 
+  // Adds the values collected so far to |logger|. Calibrating with several
+  // interpreters at once, each on a part of the dataset, and merging their
+  // values gives the same statistics as a single interpreter would have.
+  void MergeCalibrationValuesInto(Logger* logger) const {
+    logger->Merge(*logger_);
+  }
+
   virtual ~CalibrationReader() {}
 
  private:
@@ -16,6 +16,7 @@ limitations under the License.
 
 #include <fstream>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -112,20 +113,27 @@ KernelEvalFuncPtr Calibrator::GetKernelInvoke(const TfLiteNode* node) const {
 //
 // This way the kernel invoke functions can get the access to the Calibrator
 // object associated with the |TfLiteContext|.
+//
+// The registry is guarded by a mutex so that several logging interpreters can
+// be built and invoked from different threads, e.g. to calibrate on parts of
+// a dataset in parallel.
 class GlobalCalibratorRegistry {
  public:
   // Get the |Calibrator| associated with given context, returns null if no
   // calibrator is associated with the given context.
   Calibrator* GetCalibrator(const TfLiteContext* context) const {
-    if (calibrator_registry_.find(context) == calibrator_registry_.cend()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = calibrator_registry_.find(context);
+    if (it == calibrator_registry_.cend()) {
       return nullptr;
     }
-    return calibrator_registry_.at(context).get();
+    return it->second.get();
   }
 
   // Removes the association between calibrator and context.
   // Note: This deletes the calibrator as well.
   void RemoveCalibrator(const TfLiteContext* context) {
+    std::lock_guard<std::mutex> lock(mutex_);
     calibrator_registry_.erase(context);
   }
 
@@ -137,6 +145,7 @@ class GlobalCalibratorRegistry {
       const std::unordered_map<const TfLiteNode*, OperatorInfo>& node_to_opinfo,
       std::unique_ptr<LoggingOpResolver> logging_op_resolver,
       Calibrator** calibrator_ptr, ErrorReporter* reporter) {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (calibrator_registry_.find(context) != calibrator_registry_.cend()) {
       reporter->Report(
           "Failed to create calibrator, context already registered.");
@@ -150,6 +159,7 @@ class GlobalCalibratorRegistry {
   }
 
  private:
+  mutable std::mutex mutex_;
   std::unordered_map<const TfLiteContext*, std::unique_ptr<Calibrator>>
       calibrator_registry_;
 };
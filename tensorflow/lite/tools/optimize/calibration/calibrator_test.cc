@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <cstring>
+#include <thread>  // NOLINT(build/c++11)
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -189,6 +190,57 @@ TEST(CalibratorTest, MultipleInvokes) {
   EXPECT_NEAR(stats.at(6).max, 9.0f, eps);
 }
 
+TEST(CalibratorTest, MergesStatsOfInterpretersRunInParallel) {
+  auto model = ReadModel();
+  ASSERT_TRUE(model);
+  const size_t tensor_size = 1 * 8 * 8 * 3;
+  std::unique_ptr<Interpreter> interpreters[2];
+  std::unique_ptr<CalibrationReader> readers[2];
+  for (int k = 0; k < 2; k++) {
+    auto status =
+        BuildLoggingInterpreter(*model, ops::builtin::BuiltinOpResolver{},
+                                &interpreters[k], &readers[k]);
+    ASSERT_EQ(kTfLiteOk, status);
+    ASSERT_EQ(kTfLiteOk, interpreters[k]->AllocateTensors());
+    // Interpreter k fills input tensor i with (k + 1) * (i + 1).
+    for (size_t i = 0; i < interpreters[k]->inputs().size(); i++) {
+      TfLiteTensor* tensor =
+          interpreters[k]->tensor(interpreters[k]->inputs()[i]);
+      ASSERT_EQ(tensor->bytes, tensor_size * sizeof(float));
+      for (size_t j = 0; j < tensor_size; j++) {
+        tensor->data.f[j] = (k + 1) * (i + 1);
+      }
+    }
+  }
+
+  TfLiteStatus statuses[2];
+  std::thread threads[2];
+  for (int k = 0; k < 2; k++) {
+    threads[k] = std::thread(
+        [&, k]() { statuses[k] = interpreters[k]->Invoke(); });
+  }
+  for (int k = 0; k < 2; k++) {
+    threads[k].join();
+    ASSERT_EQ(kTfLiteOk, statuses[k]);
+  }
+
+  Logger merged;
+  for (int k = 0; k < 2; k++) {
+    readers[k]->MergeCalibrationValuesInto(&merged);
+  }
+  std::unordered_map<int, CalibrationReader::CalibrationStats> stats;
+  EXPECT_EQ(kTfLiteOk, CalibrationReader(&merged).GetTensorStatsAsMap(&stats));
+  EXPECT_EQ(7, stats.size());
+  const float expected_values[7] = {1.0f, 2.0f, 3.0f, 4.0f,
+                                    5.0f, 6.0f, 9.0f};
+  const float eps = 1e-6f;
+  for (int tensor_idx = 0; tensor_idx < 7; tensor_idx++) {
+    EXPECT_NEAR(stats.at(tensor_idx).min, expected_values[tensor_idx], eps);
+    EXPECT_NEAR(stats.at(tensor_idx).max, 2 * expected_values[tensor_idx],
+                eps);
+  }
+}
+
 }  // namespace
 }  // namespace calibration
 }  // namespace optimize
@@ -0,0 +1,202 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/offline_arena_planner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace optimize {
+
+namespace {
+
+// Node index past the last node, for tensors that are never deallocated.
+constexpr int kEndOfGraph = std::numeric_limits<int>::max();
+
+struct TensorLifetime {
+  int tensor;
+  size_t bytes;
+  // The first and last node during which the tensor is allocated, inclusive.
+  int first_node;
+  int last_node;
+};
+
+void IgnoreError(TfLiteContext* context, const char* format, ...) {}
+
+// Returns the number of bytes of `tensor`, or 0 if it is not placed by the
+// plan.
+size_t PlannedBytes(const ModelT& model, const TensorT& tensor,
+                    ErrorReporter* error_reporter) {
+  if (tensor.is_variable || tensor.type == TensorType_STRING) return 0;
+  if (tensor.buffer < model.buffers.size() &&
+      model.buffers[tensor.buffer] &&
+      !model.buffers[tensor.buffer]->data.empty()) {
+    return 0;
+  }
+  TfLiteType type;
+  if (ConvertTensorType(tensor.type, &type, error_reporter) != kTfLiteOk) {
+    return 0;
+  }
+  TfLiteContext context = {};
+  context.ReportError = IgnoreError;
+  size_t type_size;
+  if (GetSizeOfType(&context, type, &type_size) != kTfLiteOk) return 0;
+  size_t bytes = type_size;
+  for (const int32_t dim : tensor.shape) {
+    if (dim < 0) return 0;
+    bytes *= dim;
+  }
+  return bytes;
+}
+
+size_t AlignTo(size_t alignment, size_t offset) {
+  return offset % alignment == 0 ? offset
+                                 : offset + (alignment - offset % alignment);
+}
+
+// Computes when each tensor of `subgraph` is allocated and deallocated, the
+// same way as ArenaPlanner with preserve_inputs set, as the interpreter does.
+std::vector<TensorLifetime> ComputeLifetimes(const ModelT& model,
+                                             const SubGraphT& subgraph,
+                                             ErrorReporter* error_reporter) {
+  const int num_tensors = subgraph.tensors.size();
+  std::vector<int> first_node(num_tensors, -1);
+  std::vector<int> last_node(num_tensors, kEndOfGraph);
+  std::vector<int> refcounts(num_tensors, 0);
+  for (const int32_t tensor : subgraph.outputs) {
+    if (tensor >= 0) refcounts[tensor]++;
+  }
+  for (const int32_t tensor : subgraph.inputs) {
+    if (tensor >= 0) {
+      refcounts[tensor]++;
+      first_node[tensor] = 0;
+    }
+  }
+  for (const auto& op : subgraph.operators) {
+    for (const int32_t tensor : op->inputs) {
+      if (tensor >= 0) refcounts[tensor]++;
+    }
+  }
+  const int num_nodes = subgraph.operators.size();
+  for (int i = 0; i < num_nodes; ++i) {
+    const OperatorT& op = *subgraph.operators[i];
+    for (const int32_t tensor : op.outputs) {
+      if (tensor >= 0 && first_node[tensor] < 0) first_node[tensor] = i;
+    }
+    for (const int32_t tensor : op.inputs) {
+      if (tensor >= 0 && --refcounts[tensor] == 0 && first_node[tensor] >= 0) {
+        last_node[tensor] = i;
+      }
+    }
+  }
+
+  std::vector<TensorLifetime> lifetimes;
+  for (int i = 0; i < num_tensors; ++i) {
+    if (first_node[i] < 0) continue;
+    const size_t bytes =
+        PlannedBytes(model, *subgraph.tensors[i], error_reporter);
+    if (bytes == 0) continue;
+    lifetimes.push_back({i, bytes, first_node[i], last_node[i]});
+  }
+  return lifetimes;
+}
+
+}  // namespace
+
+TfLiteStatus PlanArenaOffline(ModelT* model, ErrorReporter* error_reporter) {
+  if (model->subgraphs.empty()) {
+    error_reporter->Report("No subgraph in the model.");
+    return kTfLiteError;
+  }
+  const SubGraphT& subgraph = *model->subgraphs[0];
+
+  std::vector<TensorLifetime> lifetimes =
+      ComputeLifetimes(*model, subgraph, error_reporter);
+  std::stable_sort(lifetimes.begin(), lifetimes.end(),
+                   [](const TensorLifetime& a, const TensorLifetime& b) {
+                     return a.bytes > b.bytes;
+                   });
+
+  OfflineArenaPlan plan;
+  plan.num_nodes = subgraph.operators.size();
+  plan.offsets.assign(subgraph.tensors.size(), -1);
+  plan.sizes.assign(subgraph.tensors.size(), 0);
+  // Place each tensor in the first gap between the tensors already placed
+  // that are alive at the same time.
+  std::vector<const TensorLifetime*> placed;
+  for (const TensorLifetime& lifetime : lifetimes) {
+    std::vector<const TensorLifetime*> overlapping;
+    for (const TensorLifetime* other : placed) {
+      if (other->first_node <= lifetime.last_node &&
+          lifetime.first_node <= other->last_node) {
+        overlapping.push_back(other);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(),
+              [&plan](const TensorLifetime* a, const TensorLifetime* b) {
+                return plan.offsets[a->tensor] < plan.offsets[b->tensor];
+              });
+    size_t offset = 0;
+    for (const TensorLifetime* other : overlapping) {
+      const size_t other_offset = plan.offsets[other->tensor];
+      if (offset + lifetime.bytes <= other_offset) break;
+      offset = std::max(offset, AlignTo(kDefaultTensorAlignment,
+                                        other_offset + other->bytes));
+    }
+    plan.offsets[lifetime.tensor] = offset;
+    plan.sizes[lifetime.tensor] = lifetime.bytes;
+    plan.arena_size = std::max(plan.arena_size, offset + lifetime.bytes);
+    placed.push_back(&lifetime);
+  }
+
+  // Replace the plan of a previous run, if any.
+  std::unique_ptr<MetadataT>* metadata = nullptr;
+  for (auto& entry : model->metadata) {
+    if (entry->name == kOfflineArenaPlanMetadataName &&
+        entry->buffer < model->buffers.size()) {
+      metadata = &entry;
+    }
+  }
+  if (!metadata) {
+    model->metadata.push_back(absl::make_unique<MetadataT>());
+    metadata = &model->metadata.back();
+    (*metadata)->name = kOfflineArenaPlanMetadataName;
+    (*metadata)->buffer = model->buffers.size();
+    model->buffers.push_back(absl::make_unique<BufferT>());
+  }
+  model->buffers[(*metadata)->buffer]->data = SerializeOfflineArenaPlan(plan);
+  return kTfLiteOk;
+}
+
+TfLiteStatus PlanArenaOffline(flatbuffers::FlatBufferBuilder* builder,
+                              const Model* input_model,
+                              ErrorReporter* error_reporter) {
+  std::unique_ptr<ModelT> model(input_model->UnPack());
+  TF_LITE_ENSURE_STATUS(PlanArenaOffline(model.get(), error_reporter));
+  flatbuffers::Offset<Model> output_model_location =
+      Model::Pack(*builder, model.get());
+  FinishModelBuffer(*builder, output_model_location);
+  return kTfLiteOk;
+}
+
+}  // namespace optimize
+}  // namespace tflite
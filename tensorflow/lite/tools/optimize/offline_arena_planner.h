@@ -0,0 +1,42 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_ARENA_PLANNER_H_
+#define TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_ARENA_PLANNER_H_
+
+#include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/context.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace optimize {
+
+// Computes the arena offsets of the tensors of the first subgraph of `model`
+// from their lifetimes, placing the largest tensors first, and stores them in
+// the model metadata under kOfflineArenaPlanMetadataName, so that the
+// interpreter uses them instead of planning the arena when the model is
+// loaded. Constant, variable and string tensors are not placed.
+TfLiteStatus PlanArenaOffline(ModelT* model, ErrorReporter* error_reporter);
+
+// Same as above, but populates `builder` with a copy of `input_model` holding
+// the plan, like QuantizeWeights(), so that it can run after other passes.
+TfLiteStatus PlanArenaOffline(flatbuffers::FlatBufferBuilder* builder,
+                              const Model* input_model,
+                              ErrorReporter* error_reporter);
+
+}  // namespace optimize
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_ARENA_PLANNER_H_
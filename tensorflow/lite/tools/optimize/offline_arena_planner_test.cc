@@ -0,0 +1,171 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/offline_arena_planner.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "flatbuffers/flatbuffers.h"  // TF:flatbuffers
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/tools/optimize/test_util.h"
+
+namespace {
+tensorflow::string* g_test_model_dir = nullptr;
+}  // namespace
+
+namespace tflite {
+namespace optimize {
+namespace {
+
+std::unique_ptr<FlatBufferModel> ReadAddWithReshapeTestModel() {
+  auto model_path = tensorflow::io::JoinPath(
+      *g_test_model_dir, internal::kMultiInputAddWithReshape);
+  return FlatBufferModel::BuildFromFile(model_path.c_str());
+}
+
+// Returns the plan stored in `model`, failing the test if there is none.
+OfflineArenaPlan GetPlan(const ModelT& model) {
+  OfflineArenaPlan plan;
+  int num_plans = 0;
+  for (const auto& metadata : model.metadata) {
+    if (metadata->name != kOfflineArenaPlanMetadataName) continue;
+    ++num_plans;
+    const std::vector<uint8_t>& data = model.buffers[metadata->buffer]->data;
+    EXPECT_TRUE(ParseOfflineArenaPlan(data.data(), data.size(), &plan));
+  }
+  EXPECT_EQ(1, num_plans);
+  return plan;
+}
+
+// Builds an interpreter for `model`, runs it with the same inputs every time,
+// and returns its first output.
+std::vector<float> Run(const Model* model) {
+  ops::builtin::BuiltinOpResolver resolver;
+  std::unique_ptr<Interpreter> interpreter;
+  InterpreterBuilder(model, resolver)(&interpreter);
+  EXPECT_NE(nullptr, interpreter);
+  if (interpreter == nullptr) return {};
+  EXPECT_EQ(kTfLiteOk, interpreter->AllocateTensors());
+  for (const int input : interpreter->inputs()) {
+    TfLiteTensor* tensor = interpreter->tensor(input);
+    EXPECT_EQ(kTfLiteFloat32, tensor->type);
+    const int num_elements = tensor->bytes / sizeof(float);
+    for (int i = 0; i < num_elements; ++i) {
+      tensor->data.f[i] = 0.5f * i - input;
+    }
+  }
+  EXPECT_EQ(kTfLiteOk, interpreter->Invoke());
+  const TfLiteTensor* output = interpreter->tensor(interpreter->outputs()[0]);
+  return std::vector<float>(output->data.f,
+                            output->data.f + output->bytes / sizeof(float));
+}
+
+class OfflineArenaPlannerTest : public testing::Test {
+ protected:
+  OfflineArenaPlannerTest() {
+    input_model_ = ReadAddWithReshapeTestModel();
+    model_ = input_model_->GetModel();
+  }
+
+  std::unique_ptr<FlatBufferModel> input_model_;
+  const Model* model_;
+  internal::FailOnErrorReporter error_reporter_;
+};
+
+TEST_F(OfflineArenaPlannerTest, TensorsUsedTogetherDoNotOverlap) {
+  std::unique_ptr<ModelT> model(model_->UnPack());
+  ASSERT_EQ(kTfLiteOk, PlanArenaOffline(model.get(), &error_reporter_));
+  const OfflineArenaPlan plan = GetPlan(*model);
+  const SubGraphT& subgraph = *model->subgraphs[0];
+  EXPECT_EQ(static_cast<int>(subgraph.operators.size()), plan.num_nodes);
+  ASSERT_EQ(subgraph.tensors.size(), plan.offsets.size());
+
+  // The inputs and outputs of a node are all allocated while it runs.
+  for (const auto& op : subgraph.operators) {
+    std::vector<int32_t> tensors;
+    for (const int32_t tensor : op->inputs) {
+      if (tensor >= 0 && plan.offsets[tensor] >= 0) tensors.push_back(tensor);
+    }
+    for (const int32_t tensor : op->outputs) {
+      if (plan.offsets[tensor] >= 0) tensors.push_back(tensor);
+    }
+    // The outputs of every node are placed.
+    EXPECT_GE(tensors.size(), op->outputs.size());
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      const int64_t begin = plan.offsets[tensors[i]];
+      const int64_t end = begin + plan.sizes[tensors[i]];
+      EXPECT_LE(end, static_cast<int64_t>(plan.arena_size));
+      for (size_t j = i + 1; j < tensors.size(); ++j) {
+        if (tensors[i] == tensors[j]) continue;
+        const int64_t other_begin = plan.offsets[tensors[j]];
+        const int64_t other_end = other_begin + plan.sizes[tensors[j]];
+        EXPECT_TRUE(end <= other_begin || other_end <= begin)
+            << "tensors " << tensors[i] << " and " << tensors[j];
+      }
+    }
+  }
+}
+
+TEST_F(OfflineArenaPlannerTest, ReplanningReplacesThePlan) {
+  std::unique_ptr<ModelT> model(model_->UnPack());
+  ASSERT_EQ(kTfLiteOk, PlanArenaOffline(model.get(), &error_reporter_));
+  const size_t num_buffers = model->buffers.size();
+  ASSERT_EQ(kTfLiteOk, PlanArenaOffline(model.get(), &error_reporter_));
+  EXPECT_EQ(num_buffers, model->buffers.size());
+  EXPECT_EQ(static_cast<int>(model->subgraphs[0]->operators.size()),
+            GetPlan(*model).num_nodes);
+}
+
+TEST_F(OfflineArenaPlannerTest, InterpreterResultsAreUnchanged) {
+  flatbuffers::FlatBufferBuilder builder;
+  ASSERT_EQ(kTfLiteOk, PlanArenaOffline(&builder, model_, &error_reporter_));
+  const Model* planned_model = GetModel(builder.GetBufferPointer());
+  ASSERT_NE(nullptr, planned_model->metadata());
+
+  const std::vector<float> expected = Run(model_);
+  ASSERT_FALSE(expected.empty());
+  EXPECT_THAT(Run(planned_model), testing::ElementsAreArray(expected));
+}
+
+}  // namespace
+}  // namespace optimize
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  tensorflow::string model_file;
+  const std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("test_model_file", &model_file,
+                       "Path to test tflite model file."),
+  };
+
+  const bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result) {
+    std::cerr << "Required test_model_file\n";
+    std::abort();
+  }
+  g_test_model_dir =
+      new tensorflow::string(tensorflow::io::Dirname(model_file));
+  ::tensorflow::port::InitMain(argv[0], &argc, &argv);
+  return RUN_ALL_TESTS();
+}
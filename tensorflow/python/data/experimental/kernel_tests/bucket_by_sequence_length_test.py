@@ -21,6 +21,7 @@ import random
 
 from absl.testing import parameterized
 
+from tensorflow.python.data.experimental.ops import bucketing
 from tensorflow.python.data.experimental.ops import grouping
 from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
@@ -465,5 +466,77 @@ class BucketBySequenceLengthTest(test_base.DatasetTestBase,
     self.assertEqual(batches, expected_batches)
 
 
+
+def _lengths_to_sequences(lengths):
+  """Returns a dataset of vectors of the given lengths, filled with them."""
+  return dataset_ops.Dataset.from_tensor_slices(lengths).map(
+      lambda n: array_ops.fill([n], n))
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class NativeBucketBySequenceLengthTest(test_base.DatasetTestBase,
+                                       parameterized.TestCase):
+
+  @parameterized.named_parameters(
+      ("PadToLongest", False),
+      ("PadToBucketBoundary", True),
+  )
+  def testMatchesGroupByWindow(self, pad_to_bucket_boundary):
+    random.seed(0)
+    lengths = [random.randint(1, 39) for _ in range(200)]
+    boundaries = [10, 20, 40]
+    batch_sizes = [8, 5, 3, 2]
+
+    expected = _lengths_to_sequences(lengths).apply(
+        grouping.bucket_by_sequence_length(
+            _element_length_fn, boundaries, batch_sizes,
+            pad_to_bucket_boundary=pad_to_bucket_boundary))
+    dataset = _lengths_to_sequences(lengths).apply(
+        bucketing.bucket_by_sequence_length(
+            boundaries, batch_sizes,
+            pad_to_bucket_boundary=pad_to_bucket_boundary))
+    self.assertDatasetsEqual(expected, dataset)
+
+  def testDropRemainder(self):
+    dataset = _lengths_to_sequences([1, 5, 2, 6, 1]).apply(
+        bucketing.bucket_by_sequence_length([3], [2, 3], drop_remainder=True))
+    self.assertDatasetProduces(dataset, expected_output=[[[1, 0], [2, 2]]])
+
+  def testMaxBufferedBytesEmitsLargestBucket(self):
+    # The int32 elements hold 4, 4, 20 and 20 bytes, so the fourth one takes
+    # the buffered bytes over the bound and flushes the longer bucket.
+    dataset = _lengths_to_sequences([1, 1, 5, 5]).apply(
+        bucketing.bucket_by_sequence_length([3], [4, 4],
+                                            max_buffered_bytes=40))
+    self.assertDatasetProduces(
+        dataset, expected_output=[[[5] * 5, [5] * 5], [[1], [1]]])
+
+  def testLengthComponent(self):
+    dataset = dataset_ops.Dataset.from_tensor_slices(([2, 0, 1], [1, 4, 3]))
+    dataset = dataset.map(lambda a, b: (a, array_ops.fill([b], b)))
+    dataset = dataset.apply(
+        bucketing.bucket_by_sequence_length([2], [2, 2], length_component=1))
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[([0, 1], [[4, 4, 4, 4], [3, 3, 3, 0]]), ([2], [[1]])])
+
+  def testPadToBucketBoundaryRejectsLongElements(self):
+    dataset = _lengths_to_sequences([1, 5]).apply(
+        bucketing.bucket_by_sequence_length([3], [2, 2],
+                                            pad_to_bucket_boundary=True))
+    self.assertDatasetProduces(
+        dataset,
+        expected_error=(errors.InvalidArgumentError,
+                        "elements must have length < max"))
+
+  def testMaxBufferedBytesWithDropRemainder(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      dataset = _lengths_to_sequences([1]).apply(
+          bucketing.bucket_by_sequence_length([3], [2, 2],
+                                              drop_remainder=True,
+                                              max_buffered_bytes=8))
+      self.evaluate(self.getNext(dataset)())
+
+
 if __name__ == "__main__":
   test.main()
@@ -0,0 +1,154 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.ops.data_service_ops`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import socket
+import subprocess
+import sys
+import time
+
+import portpicker
+
+from tensorflow.python.data.experimental.ops import data_service_ops
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.eager import context
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+
+_SERVER_BIN = (
+    "core/distributed_runtime/rpc/data_service/grpc_data_service_server")
+
+
+def _wait_for_server(port, timeout_sec=60):
+  """Blocks until a server accepts connections on `port`."""
+  deadline = time.time() + timeout_sec
+  while True:
+    try:
+      socket.create_connection(("localhost", port)).close()
+      return
+    except socket.error:
+      if time.time() > deadline:
+        raise
+      time.sleep(0.1)
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class DataServiceOpsTest(test_base.DatasetTestBase):
+  """Runs datasets on a dispatcher and a worker started in subprocesses."""
+
+  @classmethod
+  def setUpClass(cls):
+    super(DataServiceOpsTest, cls).setUpClass()
+    server_bin = test.test_src_dir_path(_SERVER_BIN)
+    dispatcher_port = portpicker.pick_unused_port()
+    worker_port = portpicker.pick_unused_port()
+    cls._address = "localhost:%d" % dispatcher_port
+    cls._dispatcher = subprocess.Popen(
+        [server_bin, "--port=%d" % dispatcher_port],
+        stdout=sys.stdout,
+        stderr=sys.stderr)
+    # The worker exits if it cannot register with the dispatcher.
+    _wait_for_server(dispatcher_port)
+    cls._worker = subprocess.Popen([
+        server_bin,
+        "--port=%d" % worker_port,
+        "--dispatcher_address=%s" % cls._address,
+        "--worker_address=localhost:%d" % worker_port,
+    ],
+                                   stdout=sys.stdout,
+                                   stderr=sys.stderr)
+
+  @classmethod
+  def tearDownClass(cls):
+    for server in [cls._worker, cls._dispatcher]:
+      server.terminate()
+      server.wait()
+    super(DataServiceOpsTest, cls).tearDownClass()
+
+  def _jobName(self):
+    # Named jobs outlive the test, which runs once per execution mode.
+    return "%s_%s" % (self._testMethodName, context.executing_eagerly())
+
+  def testDistributeKeepsTheStructure(self):
+    dataset = dataset_ops.Dataset.range(10).batch(2).apply(
+        data_service_ops.distribute(self._address))
+    self.assertEqual(dtypes.int64, dataset_ops.get_legacy_output_types(dataset))
+    self.assertEqual([None],
+                     dataset_ops.get_legacy_output_shapes(dataset).as_list())
+
+  def testShardingPolicies(self):
+    for sharding_policy in ["OFF", "AUTO", "DATA"]:
+      dataset = dataset_ops.Dataset.range(10).apply(
+          data_service_ops.distribute(
+              self._address, sharding_policy=sharding_policy))
+      self.assertDatasetProduces(
+          dataset,
+          expected_output=list(range(10)),
+          requires_initialization=True,
+          assert_items_equal=True)
+
+  def testIteratorsOfANamedJobShareItsElements(self):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        data_service_ops.distribute(
+            self._address,
+            sharding_policy="OFF",
+            job_name=self._jobName(),
+            max_outstanding_requests=1))
+    get_next = [
+        self.getNext(dataset, requires_initialization=True) for _ in range(2)
+    ]
+    elements = []
+    for next_element in get_next:
+      while True:
+        try:
+          elements.append(self.evaluate(next_element()))
+        except errors.OutOfRangeError:
+          break
+    self.assertCountEqual(list(range(10)), elements)
+
+  def _assertRaisesWhenIterated(self, expected_exception, regex, **kwargs):
+    with self.assertRaisesRegexp(expected_exception, regex):
+      dataset = dataset_ops.Dataset.range(10).apply(
+          data_service_ops.distribute(**kwargs))
+      self.evaluate(self.getNext(dataset, requires_initialization=True)())
+
+  def testInvalidArguments(self):
+    self._assertRaisesWhenIterated(
+        errors.InvalidArgumentError, "`address` must not be empty", address="")
+    self._assertRaisesWhenIterated(
+        errors.InvalidArgumentError,
+        "Unsupported protocol",
+        address=self._address,
+        protocol="http")
+    self._assertRaisesWhenIterated(
+        errors.InvalidArgumentError,
+        "`max_outstanding_requests` must be > 0",
+        address=self._address,
+        max_outstanding_requests=0)
+    # Graph construction checks the attr before the kernel does.
+    self._assertRaisesWhenIterated((ValueError, errors.InvalidArgumentError),
+                                   "FILES",
+                                   address=self._address,
+                                   sharding_policy="FILES")
+
+
+if __name__ == "__main__":
+  test.main()
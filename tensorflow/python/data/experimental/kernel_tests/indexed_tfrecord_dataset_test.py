@@ -0,0 +1,106 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.ops.indexed_readers`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from tensorflow.python.data.experimental.ops import indexed_readers
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import test_util
+from tensorflow.python.lib.io import python_io
+from tensorflow.python.lib.io import tf_record
+from tensorflow.python.platform import test
+from tensorflow.python.util import compat
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class IndexedTFRecordDatasetTest(test_base.DatasetTestBase):
+
+  def setUp(self):
+    super(IndexedTFRecordDatasetTest, self).setUp()
+    self._num_files = 2
+    self._num_records = 7
+    self._filenames = self._createFiles()
+
+  def _record(self, f, r):
+    return compat.as_bytes("Record %d of file %d" % (r, f))
+
+  def _createFiles(self, options=None):
+    filenames = []
+    for i in range(self._num_files):
+      filename = os.path.join(self.get_temp_dir(), "tf_record.%d.txt" % i)
+      filenames.append(filename)
+      writer = python_io.TFRecordWriter(filename, options)
+      for j in range(self._num_records):
+        writer.write(self._record(i, j))
+      writer.close()
+    return filenames
+
+  def _allRecords(self):
+    return [
+        self._record(f, r)
+        for f in range(self._num_files)
+        for r in range(self._num_records)
+    ]
+
+  def testReadAllRecords(self):
+    dataset = indexed_readers.IndexedTFRecordDataset(self._filenames)
+    self.assertDatasetProduces(dataset, expected_output=self._allRecords())
+
+  def testShardAndSkip(self):
+    dataset = indexed_readers.IndexedTFRecordDataset(
+        self._filenames, num_shards=3, shard_index=1, skip=1)
+    self.assertDatasetProduces(
+        dataset, expected_output=self._allRecords()[4::3])
+
+  def testShuffledShardsPartitionTheRecords(self):
+    records = []
+    for shard_index in range(3):
+      dataset = indexed_readers.IndexedTFRecordDataset(
+          self._filenames,
+          num_shards=3,
+          shard_index=shard_index,
+          shuffle=True,
+          seed=42)
+      get_next = self.getNext(dataset)
+      while True:
+        try:
+          records.append(self.evaluate(get_next()))
+        except errors.OutOfRangeError:
+          break
+    # With the same seed, every shard sees the same permutation.
+    self.assertNotEqual(self._allRecords(), records)
+    self.assertItemsEqual(self._allRecords(), records)
+
+  def testShuffleOfCompressedFilesFails(self):
+    options = tf_record.TFRecordOptions(tf_record.TFRecordCompressionType.GZIP)
+    filenames = self._createFiles(options)
+    dataset = indexed_readers.IndexedTFRecordDataset(
+        filenames, compression_type="GZIP", num_shards=2)
+    self.assertDatasetProduces(dataset, expected_output=self._allRecords()[::2])
+    dataset = indexed_readers.IndexedTFRecordDataset(
+        filenames, compression_type="GZIP", shuffle=True, seed=42)
+    self.assertDatasetProduces(
+        dataset,
+        expected_error=(errors.InvalidArgumentError,
+                        "only supported for uncompressed files"))
+
+
+if __name__ == "__main__":
+  test.main()
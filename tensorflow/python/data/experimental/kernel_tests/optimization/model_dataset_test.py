@@ -44,6 +44,26 @@ class ModelDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     with self.assertRaises(errors.OutOfRangeError):
       self.evaluate(get_next())
 
+  @parameterized.named_parameters(
+      ("HillClimb", dataset_ops.AutotuneAlgorithm.HILL_CLIMB.value, 0),
+      ("GradientDescent", dataset_ops.AutotuneAlgorithm.GRADIENT_DESCENT.value,
+       0),
+      ("GradientDescentWithRamBudget",
+       dataset_ops.AutotuneAlgorithm.GRADIENT_DESCENT.value, 1 << 20),
+  )
+  def testAutotuneAlgorithm(self, algorithm, ram_budget):
+    dataset = dataset_ops.Dataset.range(100)
+    dataset = dataset.map(
+        lambda x: x * 2, num_parallel_calls=dataset_ops.AUTOTUNE).prefetch(
+            dataset_ops.AUTOTUNE)
+    options = dataset_ops.Options()
+    options.experimental_optimization.apply_default_optimizations = False
+    options.experimental_optimization.autotune = True
+    options.experimental_optimization.autotune_algorithm = algorithm
+    options.experimental_optimization.autotune_ram_budget = ram_budget
+    dataset = dataset.with_options(options)
+    self.assertDatasetProduces(dataset, [x * 2 for x in range(100)])
+
 
 if __name__ == "__main__":
   test.main()
@@ -19,6 +19,7 @@ from __future__ import division
 from __future__ import print_function
 
 import copy
+import os
 
 import numpy as np
 
@@ -27,12 +28,14 @@ from tensorflow.core.example import feature_pb2
 from tensorflow.python.data.experimental.ops import parsing_ops as contrib_parsing_ops
 from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import readers
 from tensorflow.python.eager import context
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors_impl
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import test_util
+from tensorflow.python.lib.io import python_io
 from tensorflow.python.ops import parsing_ops
 from tensorflow.python.platform import test
 
@@ -877,5 +880,77 @@ class ParseExampleDatasetTest(test_base.DatasetTestBase):
                       "allow_missing to be True."))
 
 
+  def testBatchAndParseMatchesBatchThenParse(self):
+    original = [
+        example(features=features({
+            "a": float_feature([i, -i]),
+            "b": bytes_feature([b"b%d" % j for j in range(i % 3)]),
+            "c": int64_feature(list(range(i % 2))),
+        })) for i in range(5)
+    ]
+    serialized = [m.SerializeToString() for m in original]
+    feature_val = {
+        "a": parsing_ops.FixedLenFeature((2,), dtype=dtypes.float32),
+        "b": parsing_ops.VarLenFeature(dtype=dtypes.string),
+        "c": parsing_ops.FixedLenSequenceFeature(
+            (), dtype=dtypes.int64, allow_missing=True),
+    }
+    dataset = dataset_ops.Dataset.from_tensor_slices(serialized)
+    for drop_remainder in [False, True]:
+      self.assertDatasetsEqual(
+          dataset.batch(2, drop_remainder).apply(
+              contrib_parsing_ops.parse_example_dataset(feature_val)),
+          dataset.apply(
+              contrib_parsing_ops.batch_and_parse_example_dataset(
+                  feature_val, 2, drop_remainder)))
+
+  def testBatchAndParseRecordsReadFromFiles(self):
+    # Records read from files do not share their buffers, so their strings are
+    # moved into the batch rather than copied.
+    filename = os.path.join(self.get_temp_dir(), "batch_and_parse.tfrecord")
+    writer = python_io.TFRecordWriter(filename)
+    for i in range(7):
+      writer.write(
+          example(features=features({
+              "a": int64_feature([i, 2 * i]),
+          })).SerializeToString())
+    writer.close()
+    dataset = readers.TFRecordDataset(filename).apply(
+        contrib_parsing_ops.batch_and_parse_example_dataset(
+            {"a": parsing_ops.FixedLenFeature((2,), dtype=dtypes.int64)},
+            batch_size=3)).prefetch(2)
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[{
+            "a": [[0, 0], [1, 2], [2, 4]]
+        }, {
+            "a": [[3, 6], [4, 8], [5, 10]]
+        }, {
+            "a": [[6, 12]]
+        }])
+
+  def testBatchAndParseStaticBatchDimension(self):
+    serialized = [
+        example(features=features({
+            "a": int64_feature([i]),
+        })).SerializeToString() for i in range(5)
+    ]
+    dataset = dataset_ops.Dataset.from_tensor_slices(serialized).apply(
+        contrib_parsing_ops.batch_and_parse_example_dataset(
+            {"a": parsing_ops.FixedLenFeature((), dtype=dtypes.int64)},
+            batch_size=2, drop_remainder=True))
+    self.assertEqual(
+        [2], dataset_ops.get_legacy_output_shapes(dataset)["a"].as_list())
+    self.assertDatasetProduces(
+        dataset, expected_output=[{"a": [0, 1]}, {"a": [2, 3]}])
+
+  def testBatchAndParseRequiresScalarInput(self):
+    with self.assertRaisesRegexp(TypeError, "scalar strings"):
+      dataset_ops.Dataset.from_tensors(["a", "b"]).apply(
+          contrib_parsing_ops.batch_and_parse_example_dataset(
+              {"a": parsing_ops.FixedLenFeature((), dtype=dtypes.int64)},
+              batch_size=2))
+
+
 if __name__ == "__main__":
   test.main()
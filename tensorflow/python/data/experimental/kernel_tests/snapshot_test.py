@@ -237,6 +237,37 @@ class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase,
 
     self.assertSnapshotDirectoryContains(tmpdir, 1, 1, 4)
 
+  @parameterized.parameters(
+      (1, False), (1, True), (4, False), (4, True))
+  def testReadSnapshotBackWithWriterThreads(self, num_writer_threads,
+                                            raw_buffers):
+    tmpdir = self.makeSnapshotDirectory()
+
+    dataset = dataset_ops.Dataset.range(1000)
+    dataset = dataset.map(lambda x: (x, string_ops.as_string(x)))
+    dataset = dataset.apply(
+        snapshot.snapshot(
+            tmpdir,
+            num_writer_threads=num_writer_threads,
+            raw_buffers=raw_buffers))
+    expected = [(x, b"%d" % x) for x in range(1000)]
+    self.assertDatasetProduces(dataset, expected)
+
+    # Reading back the snapshot restores the original order.
+    dataset2 = dataset_ops.Dataset.range(1000)
+    dataset2 = dataset2.map(lambda x: (x, string_ops.as_string(x)))
+    dataset2 = dataset2.apply(
+        snapshot.snapshot(
+            tmpdir,
+            num_writer_threads=num_writer_threads,
+            raw_buffers=raw_buffers))
+    self.assertDatasetProduces(dataset2, expected)
+
+    run_dir = os.path.join(tmpdir, os.listdir(tmpdir)[0])
+    run_dir = os.path.join(
+        run_dir, [d for d in os.listdir(run_dir) if d != "snapshot.metadata"][0])
+    self.assertLen(os.listdir(run_dir), num_writer_threads)
+
   def testAdditionalOperationsAfterReadBack(self):
     self.setUpTFRecord()
     filenames = self.test_filenames
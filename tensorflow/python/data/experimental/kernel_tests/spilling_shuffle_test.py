@@ -0,0 +1,71 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `shuffle_ops.spilling_shuffle()`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from tensorflow.python.data.experimental.ops import shuffle_ops
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import string_ops
+from tensorflow.python.platform import test
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class SpillingShuffleTest(test_base.DatasetTestBase):
+
+  def _spill_dir(self):
+    return os.path.join(self.get_temp_dir(), "spill")
+
+  def _outputs(self, dataset):
+    get_next = self.getNext(dataset)
+    outputs = []
+    while True:
+      try:
+        outputs.append(self.evaluate(get_next()))
+      except errors.OutOfRangeError:
+        return outputs
+
+  def testSameOrderAsInMemoryShuffle(self):
+    dataset = dataset_ops.Dataset.range(1000)
+    expected = self._outputs(dataset.shuffle(100, seed=42))
+    actual = self._outputs(
+        dataset.apply(
+            shuffle_ops.spilling_shuffle(100, self._spill_dir(), seed=42)))
+    self.assertEqual(expected, actual)
+
+  def testMultipleComponents(self):
+    dataset = dataset_ops.Dataset.range(100).map(
+        lambda x: (x, string_ops.as_string(x), math_ops.cast(x, "float32")))
+    dataset = dataset.apply(
+        shuffle_ops.spilling_shuffle(10, self._spill_dir(), seed=1)).repeat(2)
+    output = self._outputs(dataset)
+    self.assertEqual(200, len(output))
+    for x, s, f in output:
+      self.assertEqual(str(x).encode(), s)
+      self.assertEqual(float(x), f)
+    # Each epoch produces every element once.
+    self.assertEqual(list(range(100)), sorted(x for x, _, _ in output[:100]))
+    self.assertEqual(list(range(100)), sorted(x for x, _, _ in output[100:]))
+
+
+if __name__ == "__main__":
+  test.main()
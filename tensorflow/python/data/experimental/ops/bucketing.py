@@ -0,0 +1,159 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Native bucketing of dataset elements by sequence length."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import nest
+from tensorflow.python.data.util import sparse
+from tensorflow.python.data.util import structure
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_shape
+from tensorflow.python.framework import tensor_util
+from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
+
+
+def bucket_by_sequence_length(bucket_boundaries,
+                              bucket_batch_sizes,
+                              length_component=0,
+                              padded_shapes=None,
+                              padding_values=None,
+                              pad_to_bucket_boundary=False,
+                              drop_remainder=False,
+                              max_buffered_bytes=0):
+  """A transformation that buckets elements in a `Dataset` by length.
+
+  This is a native version of
+  `tf.data.experimental.bucket_by_sequence_length`. Instead of calling an
+  `element_length_func`, the length of an element is the size of the 0th
+  dimension of one of its components, and the elements are bucketed, padded
+  and batched in a single dataset op. For example:
+
+  ```python
+  dataset = dataset.apply(bucketing.bucket_by_sequence_length(
+      bucket_boundaries=[16, 32, 64],
+      bucket_batch_sizes=[64, 32, 16, 8],
+      max_buffered_bytes=64 << 20))
+  ```
+
+  Args:
+    bucket_boundaries: `list<int>`, upper length boundaries of the buckets.
+    bucket_batch_sizes: `list<int>`, batch size per bucket. Length should be
+      `len(bucket_boundaries) + 1`.
+    length_component: (Optional.) The index, in `nest.flatten` order, of the
+      component of an element whose 0th dimension is the element's length.
+    padded_shapes: (Optional.) Nested structure of `tf.TensorShape` as for
+      `tf.data.Dataset.padded_batch`. Defaults to the input's output shapes.
+    padding_values: (Optional.) Values to pad with, as for
+      `tf.data.Dataset.padded_batch`. Defaults to padding with 0.
+    pad_to_bucket_boundary: (Optional.) If `True`, pads dimensions with unknown
+      size to the bucket boundary minus 1 instead of to the maximum length in
+      the batch. Elements must then be shorter than `max(bucket_boundaries)`.
+    drop_remainder: (Optional.) Whether to drop the last batch of each bucket
+      if it has fewer than its batch size elements.
+    max_buffered_bytes: (Optional.) A bound on the bytes of the elements held
+      in all buckets. When it is exceeded, the bucket holding the most bytes is
+      emitted as a smaller batch. `0` means no bound. Cannot be combined with
+      `drop_remainder`.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+
+  Raises:
+    ValueError: if `len(bucket_batch_sizes) != len(bucket_boundaries) + 1`.
+  """
+  if len(bucket_batch_sizes) != (len(bucket_boundaries) + 1):
+    raise ValueError(
+        "len(bucket_batch_sizes) must equal len(bucket_boundaries) + 1")
+
+  def _apply_fn(dataset):
+    return _BucketBySequenceLengthDataset(
+        dataset, bucket_boundaries, bucket_batch_sizes, length_component,
+        padded_shapes, padding_values, pad_to_bucket_boundary, drop_remainder,
+        max_buffered_bytes)
+
+  return _apply_fn
+
+
+class _BucketBySequenceLengthDataset(dataset_ops.UnaryDataset):
+  """A `Dataset` that batches and pads elements of similar lengths together."""
+
+  def __init__(self, input_dataset, bucket_boundaries, bucket_batch_sizes,
+               length_component, padded_shapes, padding_values,
+               pad_to_bucket_boundary, drop_remainder, max_buffered_bytes):
+    """See `bucket_by_sequence_length()` for details."""
+    if sparse.any_sparse(dataset_ops.get_legacy_output_classes(input_dataset)):
+      raise TypeError(
+          "Bucketing of padded sparse tensors is not currently supported")
+    self._input_dataset = input_dataset
+    self._bucket_boundaries = ops.convert_to_tensor(
+        bucket_boundaries, dtype=dtypes.int64, name="bucket_boundaries")
+    self._bucket_batch_sizes = ops.convert_to_tensor(
+        bucket_batch_sizes, dtype=dtypes.int64, name="bucket_batch_sizes")
+    self._drop_remainder = ops.convert_to_tensor(
+        drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+    self._max_buffered_bytes = ops.convert_to_tensor(
+        max_buffered_bytes, dtype=dtypes.int64, name="max_buffered_bytes")
+
+    input_shapes = dataset_ops.get_legacy_output_shapes(input_dataset)
+    if padded_shapes is None:
+      padded_shapes = input_shapes
+    # pylint: disable=protected-access
+    if padding_values is None:
+      padding_values = dataset_ops._default_padding(input_dataset)
+    flat_padded_shapes = nest.flatten_up_to(input_shapes, padded_shapes)
+    self._padded_shapes = [
+        dataset_ops._padded_shape_to_tensor(padded_shape, input_shape)
+        for input_shape, padded_shape in zip(
+            nest.flatten(input_shapes), flat_padded_shapes)
+    ]
+    self._padding_values = nest.flatten(
+        nest.map_structure_up_to(
+            input_shapes, dataset_ops._padding_value_to_tensor, padding_values,
+            dataset_ops.get_legacy_output_types(input_dataset)))
+    # pylint: enable=protected-access
+
+    # Batch sizes differ between buckets, and dimensions padded to the bucket
+    # boundary differ between batches.
+    output_shapes = nest.pack_sequence_as(input_shapes, [
+        tensor_shape.vector(None).concatenate(
+            tensor_util.constant_value_as_shape(s))
+        for s in self._padded_shapes
+    ])
+    self._structure = structure.convert_legacy_structure(
+        dataset_ops.get_legacy_output_types(input_dataset), output_shapes,
+        dataset_ops.get_legacy_output_classes(input_dataset))
+
+    variant_tensor = ged_ops.bucket_by_sequence_length_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        bucket_boundaries=self._bucket_boundaries,
+        bucket_batch_sizes=self._bucket_batch_sizes,
+        padded_shapes=self._padded_shapes,
+        padding_values=self._padding_values,
+        drop_remainder=self._drop_remainder,
+        max_buffered_bytes=self._max_buffered_bytes,
+        length_component=length_component,
+        pad_to_bucket_boundary=pad_to_bucket_boundary,
+        output_shapes=structure.get_flat_tensor_shapes(self._structure))
+    super(_BucketBySequenceLengthDataset, self).__init__(input_dataset,
+                                                         variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._structure
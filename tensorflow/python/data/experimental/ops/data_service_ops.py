@@ -0,0 +1,102 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Reading the elements of a dataset from the tf.data service."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
+
+
+class _DataServiceDataset(dataset_ops.UnaryUnchangedStructureDataset):
+  """A `Dataset` whose elements are produced by the tf.data service."""
+
+  def __init__(self, input_dataset, address, protocol, sharding_policy,
+               job_name, max_outstanding_requests, num_splits):
+    self._input_dataset = input_dataset
+    self._address = ops.convert_to_tensor(
+        address, dtype=dtypes.string, name="address")
+    self._protocol = ops.convert_to_tensor(
+        protocol, dtype=dtypes.string, name="protocol")
+    self._job_name = ops.convert_to_tensor(
+        job_name if job_name is not None else "",
+        dtype=dtypes.string,
+        name="job_name")
+    self._max_outstanding_requests = ops.convert_to_tensor(
+        max_outstanding_requests,
+        dtype=dtypes.int64,
+        name="max_outstanding_requests")
+    variant_tensor = ged_ops.data_service_dataset(
+        self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+        address=self._address,
+        protocol=self._protocol,
+        job_name=self._job_name,
+        max_outstanding_requests=self._max_outstanding_requests,
+        sharding_policy=sharding_policy,
+        num_splits=num_splits,
+        **self._flat_structure)
+    super(_DataServiceDataset, self).__init__(input_dataset, variant_tensor)
+
+
+def distribute(address,
+               protocol="grpc",
+               sharding_policy="AUTO",
+               job_name=None,
+               max_outstanding_requests=16,
+               num_splits=None):
+  """Moves the input pipeline of a dataset to the tf.data service.
+
+  The dataset is sent to the dispatcher at `address`, which splits it into one
+  task per registered worker. The workers produce the elements, and iterators
+  of the resulting dataset fetch them concurrently from all the tasks, so the
+  order of the elements is not deterministic.
+
+  The input pipeline must not depend on resources of the client process, such
+  as lookup tables or Python functions that are not traced into the graph.
+
+  Args:
+    address: The "host:port" address of the dispatcher.
+    protocol: (Optional.) The protocol used to reach the service. Only "grpc"
+      is supported.
+    sharding_policy: (Optional.) "OFF" makes every worker produce the whole
+      dataset, "AUTO" shards the source files of the dataset among the
+      workers, and "DATA" shards its elements. "DYNAMIC" splits the source
+      files into `num_splits` shards that the workers lease one at a time, so
+      that the work rebalances when workers join, are slow or fail. The
+      splits of failed workers are read again, so their elements can be
+      produced more than once. Datasets without source files fall back to
+      sharding elements, which reads the whole input once per split; prefer
+      "DATA" for those. Defaults to "AUTO".
+    job_name: (Optional.) If set, iterators that use the same `job_name` and
+      dataset share one job, each element being read by one of them.
+    max_outstanding_requests: (Optional.) The maximum number of elements each
+      iterator fetches ahead of its consumer. Defaults to 16.
+    num_splits: (Optional.) The number of shards of a "DYNAMIC" job. Defaults
+      to a multiple of the number of workers.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):
+    return _DataServiceDataset(dataset, address, protocol, sharding_policy,
+                               job_name, max_outstanding_requests,
+                               num_splits or 0)
+
+  return _apply_fn
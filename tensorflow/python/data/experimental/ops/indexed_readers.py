@@ -0,0 +1,99 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""A `Dataset` that reads TFRecord files by record index."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import random_seed
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_spec
+from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
+
+
+class IndexedTFRecordDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of the records of TFRecord files, read by record index.
+
+  Each file's record offsets are read from `<filename>.index`, which a
+  `RecordWriter` writes when `write_index` is set in its options; files
+  without an index are scanned once when iteration starts. Records are then
+  read directly at their offsets, so sharding, skipping and shuffling do not
+  read any record that is not produced. For example, to read a globally
+  shuffled, disjoint shard on each of `num_workers` workers:
+
+  ```python
+  dataset = IndexedTFRecordDataset(
+      filenames, num_shards=num_workers, shard_index=worker_index,
+      shuffle=True, seed=42)
+  ```
+
+  All shards of a shuffled dataset must use the same non-zero `seed` to see
+  the same permutation of the records.
+  """
+
+  def __init__(self,
+               filenames,
+               compression_type=None,
+               num_shards=1,
+               shard_index=0,
+               skip=0,
+               shuffle=False,
+               seed=None):
+    """Creates an `IndexedTFRecordDataset`.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames.
+      compression_type: (Optional.) A `tf.string` scalar evaluating to one of
+        `""` (no compression), `"ZLIB"`, `"GZIP"`, `"BLOCK_GZIP"` or `"ZSTD"`.
+        Records of compressed files are located by decompressing up to them,
+        so compressed files cannot be shuffled.
+      num_shards: (Optional.) A `tf.int64` scalar, the number of shards.
+      shard_index: (Optional.) A `tf.int64` scalar, the shard to read. Record
+        `i` of the (shuffled) sequence of all records belongs to shard
+        `i % num_shards`.
+      skip: (Optional.) A `tf.int64` scalar, the number of leading records of
+        the shard to skip.
+      shuffle: (Optional.) Whether to produce the records of all files in a
+        random order. Only supported for uncompressed files.
+      seed: (Optional.) A `tf.int64` scalar seed for the shuffle.
+    """
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    if compression_type is None:
+      compression_type = ""
+    self._compression_type = ops.convert_to_tensor(
+        compression_type, dtype=dtypes.string, name="compression_type")
+    self._num_shards = ops.convert_to_tensor(
+        num_shards, dtype=dtypes.int64, name="num_shards")
+    self._shard_index = ops.convert_to_tensor(
+        shard_index, dtype=dtypes.int64, name="shard_index")
+    self._skip = ops.convert_to_tensor(skip, dtype=dtypes.int64, name="skip")
+    self._seed, self._seed2 = random_seed.get_seed(seed)
+    variant_tensor = ged_ops.indexed_tf_record_dataset(
+        self._filenames,
+        self._compression_type,
+        self._num_shards,
+        self._shard_index,
+        self._skip,
+        seed=self._seed,
+        seed2=self._seed2,
+        shuffle=shuffle)
+    super(IndexedTFRecordDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return tensor_spec.TensorSpec([], dtypes.string)
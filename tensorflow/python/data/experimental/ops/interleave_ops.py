@@ -96,6 +96,57 @@ def parallel_interleave(map_func,
   return _apply_fn
 
 
+def windowed_deterministic_interleave(map_func,
+                                      cycle_length,
+                                      block_length=1,
+                                      num_parallel_calls=dataset_ops.AUTOTUNE,
+                                      buffer_output_elements=None,
+                                      reopen_stragglers=True):
+  """A deterministic parallel interleave that tolerates slow input elements.
+
+  Produces the same elements in the same order as
+  `dataset.interleave(map_func, cycle_length, block_length,
+  num_parallel_calls)`, but:
+
+  * each of the `cycle_length` cycle elements may fetch up to
+    `buffer_output_elements` elements ahead of the consumer, so one slow
+    cycle element only stalls the pipeline once the consumer has drained its
+    buffer, and
+  * if `reopen_stragglers` is true, a cycle element that the consumer has been
+    waiting on for much longer than a typical fetch is re-created from its
+    input element in the background and fast-forwarded to the same position.
+    Whichever copy produces the awaited element first is kept.
+
+  At most `num_parallel_calls` cycle elements are fetched from concurrently.
+
+  Reopening is only correct if `map_func` returns datasets that produce the
+  same elements every time they are iterated, e.g. datasets reading files.
+
+  Args:
+    map_func: A function mapping a nested structure of tensors to a `Dataset`.
+    cycle_length: The number of input elements processed concurrently.
+    block_length: The number of consecutive elements to produce from each
+      input element before cycling to another input element.
+    num_parallel_calls: The number of cycle elements fetched from in parallel.
+      Must be at most `cycle_length`.
+    buffer_output_elements: (Optional.) The number of elements each cycle
+      element may buffer ahead of the consumer. Defaults to `block_length`.
+    reopen_stragglers: (Optional.) Whether to speculatively re-create
+      straggling cycle elements.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+  def _apply_fn(dataset):
+    return dataset_ops.ParallelInterleaveDataset(
+        dataset, map_func, cycle_length, block_length, num_parallel_calls,
+        buffer_output_elements=buffer_output_elements,
+        reopen_stragglers=reopen_stragglers)
+
+  return _apply_fn
+
+
 class _DirectedInterleaveDataset(dataset_ops.Dataset):
   """A substitute for `Dataset.interleave()` on a fixed list of datasets."""
 
@@ -99,6 +99,16 @@ class OptimizationOptions(options.OptionsBase):
       "are allowed but may result in CPU contention. If None, defaults to the "
       "number of schedulable CPU cores.")
 
+  autotune_ram_budget = options.create_option(
+      name="autotune_ram_budget",
+      ty=int,
+      docstring=
+      "When autotuning is enabled (through `autotune`), determines the RAM "
+      "budget in bytes for the buffers of the input pipeline, including "
+      "prefetch, shuffle and cache buffers. Tunable parameters are not "
+      "increased beyond the values whose projected buffer sizes fit the "
+      "budget. If None, the buffer sizes are not limited.")
+
   filter_fusion = options.create_option(
       name="filter_fusion",
       ty=bool,
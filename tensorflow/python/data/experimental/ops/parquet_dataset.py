@@ -0,0 +1,107 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""A `Dataset` that reads batches of columns from Parquet files."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_spec
+from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
+from tensorflow.python.ops.ragged import ragged_tensor
+
+_PREDICATE_OPS = ("==", "!=", "<", "<=", ">", ">=")
+
+
+class ParquetDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of batches of columns read from Parquet files.
+
+  Each element is a dictionary mapping column paths to a batch of their
+  values. Only the requested columns are read from the files. For example:
+
+  ```python
+  dataset = ParquetDataset(
+      ["/path/to/data.parquet"],
+      columns={"id": tf.int64,
+               "tags.list.element": tf.RaggedTensorSpec(dtype=tf.string,
+                                                       ragged_rank=1)},
+      batch_size=1024,
+      predicates=[("id", ">=", 1000)])
+  ```
+
+  Flat columns are read as dense vectors, and the rows of repeated columns as
+  a `tf.RaggedTensor` with one row per Parquet row. Null values are read as
+  zero or the empty string, and null lists as empty lists.
+
+  Predicates are only used to skip whole row groups whose column statistics
+  show that none of their rows match, so rows that do not match a predicate
+  may still be produced.
+  """
+
+  def __init__(self, filenames, columns, batch_size, predicates=None):
+    """Creates a `ParquetDataset`.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames.
+      columns: A dictionary mapping the dot-separated path of each leaf column
+        to read to either the `tf.DType` of a flat column, or a
+        `tf.RaggedTensorSpec` with the value type of a repeated column.
+        BOOLEAN, INT32, INT64, FLOAT and DOUBLE columns are read as `tf.bool`,
+        `tf.int32`, `tf.int64`, `tf.float32` and `tf.float64`, and BYTE_ARRAY
+        and FIXED_LEN_BYTE_ARRAY columns as `tf.string`.
+      batch_size: A `tf.int64` scalar, the number of rows in each batch. The
+        last batch may be smaller.
+      predicates: (Optional.) A list of `(column, op, value)` tuples, where
+        `op` is one of "==", "!=", "<", "<=", ">" and ">=", and `value` is a
+        number. Row groups that no row satisfying all predicates can belong
+        to are skipped.
+    """
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    # The outputs are ordered like the flattened element, i.e. by path.
+    self._columns = sorted(columns)
+    self._element_spec = {}
+    for path, spec in columns.items():
+      if isinstance(spec, ragged_tensor.RaggedTensorSpec):
+        # pylint: disable=protected-access
+        self._element_spec[path] = ragged_tensor.RaggedTensorSpec(
+            [None, None], spec._dtype, ragged_rank=1)
+      else:
+        self._element_spec[path] = tensor_spec.TensorSpec(
+            [None], dtypes.as_dtype(spec))
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    predicates = predicates or []
+    for _, op, _ in predicates:
+      if op not in _PREDICATE_OPS:
+        raise ValueError("Unsupported predicate operator: %r" % (op,))
+    variant_tensor = ged_ops.parquet_dataset(
+        self._filenames,
+        columns=self._columns,
+        batch_size=self._batch_size,
+        predicate_columns=ops.convert_to_tensor(
+            [p[0] for p in predicates], dtype=dtypes.string),
+        predicate_ops=ops.convert_to_tensor(
+            [p[1] for p in predicates], dtype=dtypes.string),
+        predicate_values=ops.convert_to_tensor(
+            [p[2] for p in predicates], dtype=dtypes.float64),
+        **self._flat_structure)
+    super(ParquetDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._element_spec
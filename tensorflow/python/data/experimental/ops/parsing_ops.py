@@ -23,6 +23,8 @@ from tensorflow.python.data.util import structure
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
+from tensorflow.python.framework import tensor_shape
+from tensorflow.python.framework import tensor_util
 from tensorflow.python.ops import gen_experimental_dataset_ops
 from tensorflow.python.ops import parsing_ops
 from tensorflow.python.util.tf_export import tf_export
@@ -31,12 +33,39 @@ from tensorflow.python.util.tf_export import tf_export
 class _ParseExampleDataset(dataset_ops.UnaryDataset):
   """A `Dataset` that parses `example` dataset into a `dict` dataset."""
 
-  def __init__(self, input_dataset, features, num_parallel_calls):
+  def __init__(self, input_dataset, features, num_parallel_calls,
+               batch_size=None, drop_remainder=False):
+    """See `parse_example_dataset()` and `batch_and_parse_example_dataset()`.
+
+    If `batch_size` is not None, `input_dataset` contains scalar strings, which
+    are batched by this dataset before they are parsed.
+    """
     self._input_dataset = input_dataset
-    if not structure.are_compatible(
-        input_dataset.element_spec,
-        structure.TensorStructure(dtypes.string, [None])):
-      raise TypeError("Input dataset should be a dataset of vectors of strings")
+    if batch_size is None:
+      if not structure.are_compatible(
+          input_dataset.element_spec,
+          structure.TensorStructure(dtypes.string, [None])):
+        raise TypeError(
+            "Input dataset should be a dataset of vectors of strings")
+      input_dataset_shape = dataset_ops.get_legacy_output_shapes(
+          self._input_dataset)
+    else:
+      if not structure.are_compatible(
+          input_dataset.element_spec,
+          structure.TensorStructure(dtypes.string, [])):
+        raise TypeError(
+            "Input dataset should be a dataset of scalar strings")
+      self._batch_size = ops.convert_to_tensor(
+          batch_size, dtype=dtypes.int64, name="batch_size")
+      self._drop_remainder = ops.convert_to_tensor(
+          drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+      constant_drop_remainder = tensor_util.constant_value(
+          self._drop_remainder)
+      if constant_drop_remainder:
+        input_dataset_shape = tensor_shape.TensorShape(
+            [tensor_util.constant_value(self._batch_size)])
+      else:
+        input_dataset_shape = tensor_shape.TensorShape([None])
     self._num_parallel_calls = num_parallel_calls
     # pylint: disable=protected-access
     self._features = parsing_ops._prepend_none_dimension(features)
@@ -59,8 +88,6 @@ class _ParseExampleDataset(dataset_ops.UnaryDataset):
     self._dense_defaults = dense_defaults_vec
     self._dense_shapes = dense_shapes
     self._dense_types = dense_types
-    input_dataset_shape = dataset_ops.get_legacy_output_shapes(
-        self._input_dataset)
     dense_output_shapes = [input_dataset_shape.concatenate(shape)
                            for shape in dense_shape_as_shape]
     sparse_output_shapes = [input_dataset_shape.concatenate([None])
@@ -80,7 +107,19 @@ class _ParseExampleDataset(dataset_ops.UnaryDataset):
     self._element_spec = structure.convert_legacy_structure(
         output_types, output_shapes, output_classes)
 
-    if compat.forward_compatible(2019, 8, 3):
+    if batch_size is not None:
+      variant_tensor = (
+          gen_experimental_dataset_ops.batch_and_parse_example_dataset(
+              self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+              self._batch_size,
+              self._drop_remainder,
+              self._dense_defaults,
+              self._sparse_keys,
+              self._dense_keys,
+              self._sparse_types,
+              self._dense_shapes,
+              **self._flat_structure))
+    elif compat.forward_compatible(2019, 8, 3):
       variant_tensor = (
           gen_experimental_dataset_ops.parse_example_dataset(
               self._input_dataset._variant_tensor,  # pylint: disable=protected-access
@@ -156,3 +195,55 @@ def parse_example_dataset(features, num_parallel_calls=1):
     return out_dataset
 
   return _apply_fn
+
+
+def batch_and_parse_example_dataset(features, batch_size,
+                                    drop_remainder=False):
+  """Batches serialized `Example` protos and parses each batch.
+
+  Equivalent to
+  `dataset.batch(batch_size, drop_remainder).apply(parse_example_dataset(...))`
+  for a dataset of scalar `tf.string` elements, but each batch of serialized
+  records is parsed directly into the batch-major output tensors, without
+  first building a batch of serialized strings.
+
+  Each batch is parsed in parallel on the intra-op threads, but consecutive
+  batches are parsed one after another. Apply `tf.data.Dataset.prefetch` to
+  the result to overlap parsing with the rest of the input pipeline.
+
+  Args:
+   features: A `dict` mapping feature keys to `FixedLenFeature`,
+     `VarLenFeature`, and `SparseFeature` values.
+   batch_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
+     consecutive records to parse together.
+   drop_remainder: (Optional.) A `tf.bool` scalar `tf.Tensor`, representing
+     whether the last batch should be dropped in the case it has fewer than
+     `batch_size` elements.
+
+  Returns:
+    A dataset transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+
+  Raises:
+    ValueError: if features argument is None.
+  """
+  if features is None:
+    raise ValueError("Missing: features was %s." % features)
+
+  def _apply_fn(dataset):
+    """Function from `Dataset` to `Dataset` that applies the transformation."""
+    out_dataset = _ParseExampleDataset(
+        dataset, features, num_parallel_calls=None, batch_size=batch_size,
+        drop_remainder=drop_remainder)
+    if any(
+        isinstance(feature, parsing_ops.SparseFeature)
+        for _, feature in features.items()
+    ):
+      # pylint: disable=protected-access
+      # pylint: disable=g-long-lambda
+      out_dataset = out_dataset.map(
+          lambda x: parsing_ops._construct_sparse_tensors_for_sparse_features(
+              features, x))
+    return out_dataset
+
+  return _apply_fn
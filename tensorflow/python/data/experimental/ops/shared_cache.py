@@ -0,0 +1,75 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Process-wide shared dataset cache."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
+
+
+class _SharedCacheDataset(dataset_ops.UnaryUnchangedStructureDataset):
+  """A `Dataset` that caches elements in a cache shared across iterators."""
+
+  def __init__(self, input_dataset, spill_dir, memory_budget_bytes):
+    self._input_dataset = input_dataset
+    self._spill_dir = ops.convert_to_tensor(
+        spill_dir if spill_dir is not None else "",
+        dtype=dtypes.string,
+        name="spill_dir")
+    self._memory_budget_bytes = (
+        memory_budget_bytes if memory_budget_bytes is not None else 0)
+    variant_tensor = ged_ops.shared_cache_dataset(
+        self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+        spill_dir=self._spill_dir,
+        memory_budget_bytes=self._memory_budget_bytes,
+        **self._flat_structure)
+    super(_SharedCacheDataset, self).__init__(input_dataset, variant_tensor)
+
+
+def shared_cache(spill_dir=None, memory_budget_bytes=None):
+  """Caches the elements of a dataset in a cache shared within the process.
+
+  Unlike `tf.data.Dataset.cache`, the cache is keyed by the definition of the
+  input pipeline: every dataset in the process built from the same pipeline,
+  including datasets created in other sessions, reads from the same cache.
+  Elements can be read while the cache is still being filled, and elements
+  that do not fit `memory_budget_bytes` are spilled to `spill_dir`.
+
+  The input pipeline must produce the same elements in the same order every
+  time it is iterated. It must also be stateless, and every tensor it captures
+  must be serializable, so that its definition identifies its elements.
+  Datasets with different `spill_dir` or `memory_budget_bytes` do not share
+  a cache.
+
+  Args:
+    spill_dir: (Optional.) A directory on local storage for elements that do
+      not fit the memory budget. Defaults to keeping all elements in memory.
+    memory_budget_bytes: (Optional.) The number of bytes of elements to keep
+      in memory before spilling the least recently used ones to `spill_dir`.
+      Defaults to unbounded.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):
+    return _SharedCacheDataset(dataset, spill_dir, memory_budget_bytes)
+
+  return _apply_fn
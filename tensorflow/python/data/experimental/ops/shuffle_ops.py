@@ -90,3 +90,43 @@ def shuffle_and_repeat(buffer_size, count=None, seed=None):
     return _ShuffleAndRepeatDataset(dataset, buffer_size, count, seed)
 
   return _apply_fn
+
+
+def spilling_shuffle(buffer_size,
+                     spill_dir,
+                     seed=None,
+                     reshuffle_each_iteration=None):
+  """Shuffles a dataset with a buffer that is kept in local files.
+
+  Produces the same order as `tf.data.Dataset.shuffle` with the same
+  arguments, but every buffered element is written to a file in `spill_dir`
+  when it enters the buffer and read back when it is produced, so only the
+  locations of the buffered elements are kept in memory. This makes large
+  buffers of large elements, such as decoded images, affordable at the cost
+  of local I/O.
+
+  Args:
+    buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
+      elements from which the new dataset will sample.
+    spill_dir: A directory on local storage for the buffered elements.
+    seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      random seed that will be used to create the distribution. See
+      `tf.compat.v1.set_random_seed` for behavior.
+    reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
+      that the dataset should be pseudorandomly reshuffled each time it is
+      iterated over. (Defaults to `True`.)
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):  # pylint: disable=missing-docstring
+    return dataset_ops.ShuffleDataset(
+        dataset,
+        buffer_size,
+        seed=seed,
+        reshuffle_each_iteration=reshuffle_each_iteration,
+        spill_dir=spill_dir)
+
+  return _apply_fn
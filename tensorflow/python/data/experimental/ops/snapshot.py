@@ -24,6 +24,7 @@ from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
 
 
 COMPRESSION_GZIP = "GZIP"
+COMPRESSION_ZSTD = "ZSTD"
 COMPRESSION_NONE = None
 
 
@@ -37,7 +38,9 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
                reader_path_prefix=None,
                writer_path_prefix=None,
                shard_size_bytes=None,
-               pending_snapshot_expiry_seconds=None):
+               pending_snapshot_expiry_seconds=None,
+               num_writer_threads=None,
+               raw_buffers=None):
 
     self._compression = compression if compression is not None else ""
     self._reader_path_prefix = (
@@ -49,6 +52,9 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
     self._pending_snapshot_expiry_seconds = (
         pending_snapshot_expiry_seconds
         if pending_snapshot_expiry_seconds is not None else -1)
+    self._num_writer_threads = (
+        num_writer_threads if num_writer_threads is not None else 1)
+    self._raw_buffers = raw_buffers if raw_buffers is not None else False
 
     self._input_dataset = input_dataset
     self._path = ops.convert_to_tensor(path, dtype=dtypes.string, name="path")
@@ -61,6 +67,8 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
         writer_path_prefix=self._writer_path_prefix,
         shard_size_bytes=self._shard_size_bytes,
         pending_snapshot_expiry_seconds=self._pending_snapshot_expiry_seconds,
+        num_writer_threads=self._num_writer_threads,
+        raw_buffers=self._raw_buffers,
         **self._flat_structure)
     super(_SnapshotDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -70,7 +78,9 @@ def snapshot(path,
              reader_path_prefix=None,
              writer_path_prefix=None,
              shard_size_bytes=None,
-             pending_snapshot_expiry_seconds=None):
+             pending_snapshot_expiry_seconds=None,
+             num_writer_threads=None,
+             raw_buffers=None):
   """Writes to/reads from a snapshot of a dataset.
 
   This function attempts to determine whether a valid snapshot exists at the
@@ -82,7 +92,9 @@ def snapshot(path,
     path: A directory where we want to save our snapshots and/or read from a
       previously saved snapshot.
     compression: The type of compression to apply to the Dataset. Currently
-      supports "GZIP" or None. Defaults to None (no compression).
+      supports "GZIP", "ZSTD" or None. Defaults to None (no compression).
+      "ZSTD" requires TensorFlow to be built with
+      `--define=with_zstd_support=true`.
     reader_path_prefix: A prefix to add to the path when reading from snapshots.
       Defaults to None.
     writer_path_prefix: A prefix to add to the path when writing to snapshots.
@@ -91,6 +103,11 @@ def snapshot(path,
       dataset op. Defaults to 10 GiB.
     pending_snapshot_expiry_seconds: How long to wait (in seconds) before
       the snapshot op considers a previously unfinished snapshot to be stale.
+    num_writer_threads: The number of threads that write the snapshot in
+      parallel, each to its own files. The snapshot is read back with one
+      thread per writer. Defaults to 1.
+    raw_buffers: If True, tensors are written as raw buffers instead of
+      `TensorProto`s, which is faster to write and read. Defaults to False.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
@@ -100,6 +117,7 @@ def snapshot(path,
   def _apply_fn(dataset):
     return _SnapshotDataset(dataset, path, compression, reader_path_prefix,
                             writer_path_prefix, shard_size_bytes,
-                            pending_snapshot_expiry_seconds)
+                            pending_snapshot_expiry_seconds, num_writer_threads,
+                            raw_buffers)
 
   return _apply_fn
@@ -17,18 +17,23 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import collections
 import multiprocessing
 import os
+import threading
 
 from absl.testing import parameterized
 import numpy as np
 
+from tensorflow.python.data.experimental.ops import interleave_ops
 from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import script_ops
 from tensorflow.python.ops import sparse_ops
 from tensorflow.python.platform import test
 
@@ -247,6 +252,71 @@ class InterleaveTest(test_base.DatasetTestBase, parameterized.TestCase):
       actual_output.append(self.evaluate(get_next()))
     self.assertAllEqual(expected_output.sort(), actual_output.sort())
 
+  @parameterized.named_parameters(
+      ("1", np.int64([4, 5, 6]), 2, 1, 2, None),
+      ("2", np.int64([4, 5, 6]), 2, 3, 1, 5),
+      ("3", np.int64([4, 5, 6]), 7, 2, 3, 4),
+      ("4", np.int64([4, 0, 6]), 2, 3, 2, 10),
+  )
+  def testWindowedDeterministicInterleave(self, input_values, cycle_length,
+                                          block_length, num_parallel_calls,
+                                          buffer_output_elements):
+    count = 2
+    dataset = dataset_ops.Dataset.from_tensor_slices(input_values).repeat(
+        count).apply(
+            interleave_ops.windowed_deterministic_interleave(
+                lambda x: dataset_ops.Dataset.from_tensors(x).repeat(x),
+                cycle_length, block_length, num_parallel_calls,
+                buffer_output_elements=buffer_output_elements))
+    expected_output = [
+        element for element in _interleave(
+            _repeat(input_values, count), cycle_length, block_length)
+    ]
+    self.assertDatasetProduces(dataset, expected_output)
+
+  def testWindowedDeterministicInterleaveWithStraggler(self):
+    # The first fetch from input element 1 blocks until the test releases it,
+    # so the interleave only makes progress if it reopens that element.
+    release = threading.Event()
+    lock = threading.Lock()
+    attempts = collections.Counter()
+    timed_out = []
+
+    def delay(x, i):
+      if x == 1 and i == 0:
+        with lock:
+          attempts[x] += 1
+          first_attempt = attempts[x] == 1
+        if first_attempt and not release.wait(timeout=60):
+          timed_out.append(x)
+      return i
+
+    def make_dataset(x):
+      return dataset_ops.Dataset.range(3).map(
+          lambda i: script_ops.py_func(delay, [x, i], dtypes.int64)).map(
+              lambda i: i + 10 * x)
+
+    dataset = dataset_ops.Dataset.range(4).apply(
+        interleave_ops.windowed_deterministic_interleave(
+            make_dataset, cycle_length=2, num_parallel_calls=2,
+            buffer_output_elements=3))
+    get_next = self.getNext(dataset)
+    try:
+      actual_output = []
+      while True:
+        try:
+          actual_output.append(self.evaluate(get_next()))
+        except errors.OutOfRangeError:
+          break
+      # The whole dataset was produced while the straggler was still blocked.
+      self.assertEqual([], timed_out)
+      self.assertEqual(2, attempts[1])
+      self.assertEqual([0, 10, 1, 11, 2, 12, 20, 30, 21, 31, 22, 32],
+                       actual_output)
+    finally:
+      # Lets the abandoned worker finish, so that the iterator can be deleted.
+      release.set()
+
   def testInterleaveMap(self):
     dataset = dataset_ops.Dataset.range(100)
 
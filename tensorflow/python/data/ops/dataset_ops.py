@@ -97,6 +97,7 @@ tf_export("data.experimental.AUTOTUNE").export_constant(__name__, "AUTOTUNE")
 
 class AutotuneAlgorithm(enum.Enum):
   HILL_CLIMB = 0
+  GRADIENT_DESCENT = 1
 
 
 @tf_export("data.Dataset", v1=[])
@@ -277,6 +278,7 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
     autotune = True
     algorithm = AutotuneAlgorithm.HILL_CLIMB
     cpu_budget = 0  # Indicates that all CPU cores should be used.
+    ram_budget = 0  # Indicates that buffer sizes should not be limited.
     if options.experimental_optimization is not None:
       if options.experimental_optimization.autotune is False:  # pylint: disable=g-bool-id-comparison
         autotune = False
@@ -284,9 +286,11 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
         algorithm = options.experimental_optimization.autotune_algorithm
       if options.experimental_optimization.autotune_cpu_budget is not None:
         cpu_budget = options.experimental_optimization.autotune_cpu_budget
+      if options.experimental_optimization.autotune_ram_budget is not None:
+        ram_budget = options.experimental_optimization.autotune_ram_budget
 
     if autotune:
-      dataset = _ModelDataset(dataset, algorithm, cpu_budget)
+      dataset = _ModelDataset(dataset, algorithm, cpu_budget, ram_budget)
 
     if options.experimental_stats and options.experimental_stats.aggregator:  # pylint: disable=line-too-long
       dataset = _SetStatsAggregatorDataset(  # pylint: disable=protected-access
@@ -2932,7 +2936,8 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
                input_dataset,
                buffer_size,
                seed=None,
-               reshuffle_each_iteration=None):
+               reshuffle_each_iteration=None,
+               spill_dir=None):
     """Randomly shuffles the elements of this dataset.
 
     Args:
@@ -2945,6 +2950,9 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
       reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
         that the dataset should be pseudorandomly reshuffled each time it is
         iterated over. (Defaults to `True`.)
+      spill_dir: (Optional.) A directory on local storage to which buffered
+        elements are written, keeping only their locations in memory.
+        (Defaults to keeping the buffer in memory.)
 
     Returns:
       A `Dataset`.
@@ -2967,6 +2975,7 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
         seed=self._seed,
         seed2=self._seed2,
         reshuffle_each_iteration=self._reshuffle_each_iteration,
+        spill_dir=spill_dir if spill_dir is not None else "",
         **self._flat_structure)
     super(ShuffleDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -3429,8 +3438,25 @@ class ParallelInterleaveDataset(UnaryDataset):
   """A `Dataset` that maps a function over its input and interleaves the result."""
 
   def __init__(self, input_dataset, map_func, cycle_length, block_length,
-               num_parallel_calls):
-    """See `Dataset.interleave()` for details."""
+               num_parallel_calls, buffer_output_elements=None,
+               reopen_stragglers=False):
+    """See `Dataset.interleave()` for details.
+
+    Args:
+      input_dataset: The input `Dataset`.
+      map_func: A function mapping an element of `input_dataset` to a
+        `Dataset`.
+      cycle_length: The number of input elements processed concurrently.
+      block_length: The number of consecutive elements to produce from each
+        input element.
+      num_parallel_calls: The number of cycle elements fetched from in
+        parallel.
+      buffer_output_elements: (Optional.) The number of elements each cycle
+        element may buffer ahead of the consumer. Defaults to `block_length`.
+      reopen_stragglers: (Optional.) Whether to speculatively re-create cycle
+        elements that the consumer has been waiting on for a long time. Only
+        used when elements are produced in deterministic order.
+    """
     self._input_dataset = input_dataset
     self._map_func = StructuredFunctionWrapper(
         map_func, self._transformation_name(), dataset=input_dataset)
@@ -3452,6 +3478,8 @@ class ParallelInterleaveDataset(UnaryDataset):
         self._block_length,
         self._num_parallel_calls,
         f=self._map_func.function,
+        buffer_output_elements=buffer_output_elements or 0,
+        reopen_stragglers=reopen_stragglers,
         **self._flat_structure)
     super(ParallelInterleaveDataset, self).__init__(input_dataset,
                                                     variant_tensor)
@@ -3584,22 +3612,21 @@ class _OptionsDataset(UnaryUnchangedStructureDataset):
 class _ModelDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that acts as an identity, and models performance."""
 
-  def __init__(self, input_dataset, algorithm, cpu_budget):
+  def __init__(self, input_dataset, algorithm, cpu_budget, ram_budget=0):
     self._input_dataset = input_dataset
     # TODO(jsimsa): This check is introduced for forward compatibility and can
     # be removed after 7/24/2019. At that point, all servers are expected to
     # recognize the `algorithm` attribute.
+    kwargs = dict(self._flat_structure)
     if algorithm != AutotuneAlgorithm.HILL_CLIMB:
-      variant_tensor = gen_dataset_ops.model_dataset(
-          input_dataset._variant_tensor,  # pylint: disable=protected-access
-          algorithm=algorithm,
-          cpu_budget=cpu_budget,
-          **self._flat_structure)
-    else:
-      variant_tensor = gen_dataset_ops.model_dataset(
-          input_dataset._variant_tensor,  # pylint: disable=protected-access
-          cpu_budget=cpu_budget,
-          **self._flat_structure)
+      kwargs["algorithm"] = algorithm
+    # Similarly, `ram_budget` is only set when a budget is used.
+    if ram_budget:
+      kwargs["ram_budget"] = ram_budget
+    variant_tensor = gen_dataset_ops.model_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        cpu_budget=cpu_budget,
+        **kwargs)
     super(_ModelDataset, self).__init__(input_dataset, variant_tensor)
 
 
@@ -2101,6 +2101,83 @@ class PredictionOpsTest(test_util.TensorFlowTestCase):
       logits = session.run(predict_op)
       self.assertAllClose(expected_logits, logits)
 
+  @test_util.run_deprecated_v1
+  def testPredictionAfterEnsembleChanges(self):
+    """Tests that predictions use the latest trees of the ensemble."""
+    with self.cached_session() as session:
+      tree_ensemble_config = boosted_trees_pb2.TreeEnsemble()
+      text_format.Merge(
+          """
+        trees {
+          nodes {
+            bucketized_split {
+              feature_id: 0
+              threshold: 34
+              left_id: 1
+              right_id: 2
+            }
+          }
+          nodes {
+            leaf {
+              scalar: -7.0
+            }
+          }
+          nodes {
+            leaf {
+              scalar: 5.0
+            }
+          }
+        }
+        tree_weights: 1.0
+      """, tree_ensemble_config)
+
+      tree_ensemble = boosted_trees_ops.TreeEnsemble(
+          'ensemble', serialized_proto=tree_ensemble_config.SerializeToString())
+      tree_ensemble_handle = tree_ensemble.resource_handle
+      resources.initialize_resources(resources.shared_resources()).run()
+
+      feature_0_values = [36, 32]
+      feature_1_values = [11, 27]
+      predict_op = boosted_trees_ops.predict(
+          tree_ensemble_handle,
+          bucketized_features=[feature_0_values, feature_1_values],
+          logits_dimension=1)
+      self.assertAllClose([[5.0], [-7.0]], session.run(predict_op))
+
+      # Add a tree with a categorical split.
+      text_format.Merge(
+          """
+        trees {
+          nodes {
+            categorical_split {
+              feature_id: 1
+              value: 27
+              left_id: 1
+              right_id: 2
+            }
+          }
+          nodes {
+            leaf {
+              scalar: 2.0
+            }
+          }
+          nodes {
+            leaf {
+              scalar: -1.0
+            }
+          }
+        }
+        tree_weights: 0.5
+      """, tree_ensemble_config)
+      session.run(
+          tree_ensemble.deserialize(
+              stamp_token=3,
+              serialized_proto=tree_ensemble_config.SerializeToString()))
+
+      # Example 1: tree 0: 5.0, tree 1: -1.0 => logit = 5.0 - 0.5 * 1.0
+      # Example 2: tree 0: -7.0, tree 1: 2.0 => logit = -7.0 + 0.5 * 2.0
+      self.assertAllClose([[4.5], [-6.0]], session.run(predict_op))
+
   @test_util.run_deprecated_v1
   def testPredictionMultipleTreeMultiClass(self):
     """Tests the predictions work when we have multiple trees."""
@@ -0,0 +1,105 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for tensorflow.python.ops.embedding_variable_ops."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import numpy as np
+
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import embedding_variable_ops
+from tensorflow.python.ops import gradients_impl
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+from tensorflow.python.training import saver as saver_lib
+from tensorflow.python.training.tracking import util as trackable_utils
+
+
+class EmbeddingVariableTest(test.TestCase):
+
+  @test_util.run_in_graph_and_eager_modes
+  def testLookupCreatesDefaultRows(self):
+    variable = embedding_variable_ops.EmbeddingVariable(
+        [0.5, 1.5], name="embeddings", checkpoint=False)
+    rows = variable.lookup(constant_op.constant([[3, 4]], dtypes.int64))
+    self.assertAllEqual([[[0.5, 1.5], [0.5, 1.5]]], self.evaluate(rows))
+
+  @test_util.run_deprecated_v1
+  def testGradientAppliedWithAdagrad(self):
+    with self.cached_session():
+      variable = embedding_variable_ops.EmbeddingVariable(
+          [1.0, 1.0], name="embeddings", checkpoint=False)
+      accumulator = embedding_variable_ops.EmbeddingVariable(
+          [0.1, 0.1], name="accumulators", checkpoint=False)
+      ids = constant_op.constant([3, 7], dtypes.int64)
+      weights = np.array([[1.0, 2.0], [3.0, 4.0]], dtype=np.float32)
+      loss = math_ops.reduce_sum(variable.lookup(ids) * weights)
+      grad, = gradients_impl.gradients(loss, [variable.resource_handle])
+      self.assertIsInstance(grad, ops.IndexedSlices)
+
+      self.evaluate(variable.sparse_apply_adagrad(accumulator, 0.5, grad))
+      expected = 1.0 - 0.5 * weights / np.sqrt(0.1 + weights * weights)
+      self.assertAllClose(expected, self.evaluate(variable.lookup(ids)))
+
+  @test_util.run_deprecated_v1
+  def testSaveRestoreIncludesColdRows(self):
+    save_path = os.path.join(self.get_temp_dir(), "embedding_variable")
+    ids = [1, 5, 9]
+    values = [[1.0, 1.0], [5.0, 5.0], [9.0, 9.0]]
+    with self.session(graph=ops.Graph()) as sess:
+      # With room for two hot rows, one of the three rows is cold.
+      variable = embedding_variable_ops.EmbeddingVariable(
+          [0.0, 0.0], hot_capacity=2, name="embeddings")
+      sess.run(variable.import_rows(ids, values))
+      saver_lib.Saver().save(sess, save_path)
+
+    with self.session(graph=ops.Graph()) as sess:
+      variable = embedding_variable_ops.EmbeddingVariable(
+          [0.0, 0.0], hot_capacity=2, name="embeddings")
+      sess.run(variable.lookup(constant_op.constant([2], dtypes.int64)))
+      saver_lib.Saver().restore(sess, save_path)
+      # Row 2 was not saved, so it starts again from the default value.
+      self.assertAllEqual(
+          values + [[0.0, 0.0]],
+          sess.run(
+              variable.lookup(constant_op.constant([1, 5, 9, 2],
+                                                   dtypes.int64))))
+
+  @test_util.run_in_graph_and_eager_modes
+  def testObjectBasedCheckpoint(self):
+    prefix = os.path.join(self.get_temp_dir(), "ckpt")
+    variable = embedding_variable_ops.EmbeddingVariable(
+        [0.0], name="embeddings")
+    self.evaluate(variable.import_rows([4], [[4.0]]))
+    checkpoint = trackable_utils.Checkpoint(embeddings=variable)
+    save_path = checkpoint.save(prefix)
+
+    self.evaluate(variable.import_rows([4], [[-1.0]]))
+    checkpoint.restore(save_path).run_restore_ops()
+    self.assertAllEqual([[4.0]],
+                        self.evaluate(
+                            variable.lookup(
+                                constant_op.constant([4], dtypes.int64))))
+
+
+if __name__ == "__main__":
+  test.main()
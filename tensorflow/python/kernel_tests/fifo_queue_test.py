@@ -1112,6 +1112,44 @@ class FIFOQueueTest(test.TestCase):
       self.assertEqual([50.0], self.evaluate(dequeued_t))
       thread.join()
 
+  def testDequeueManyFromFullQueueUnblocksEnqueue(self):
+    # We need each thread to keep its own device stack or the device scopes
+    # won't be properly nested.
+    ops.get_default_graph().switch_to_thread_local()
+    with self.cached_session() as sess:
+      q = data_flow_ops.FIFOQueue(
+          4, (dtypes_lib.float32, dtypes_lib.int32), shapes=((), (2,)))
+      float_elems = [10.0, 20.0, 30.0, 40.0]
+      int_elems = [[1, 2], [3, 4], [5, 6], [7, 8]]
+      enqueue_op = q.enqueue_many((float_elems, int_elems))
+      blocking_enqueue_op = q.enqueue_many(([50.0, 60.0], [[9, 10], [11, 12]]))
+      dequeued_t = q.dequeue_many(3)
+      dequeued_single_t = q.dequeue()
+
+      enqueue_op.run()
+
+      def blocking_enqueue():
+        self.evaluate(blocking_enqueue_op)
+
+      thread = self.checkedThread(target=blocking_enqueue)
+      thread.start()
+      # The dequeue ops should run after the blocking_enqueue_op has blocked.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      # The queue holds a full batch, so no element may be lost or reordered
+      # while the blocked enqueue is flushed into the space it frees.
+      float_val, int_val = self.evaluate(dequeued_t)
+      self.assertAllEqual(float_elems[0:3], float_val)
+      self.assertAllEqual(int_elems[0:3], int_val)
+      thread.join()
+      float_val, int_val = self.evaluate(dequeued_single_t)
+      self.assertEqual(40.0, float_val)
+      self.assertAllEqual([7, 8], int_val)
+      float_val, int_val = self.evaluate(dequeued_single_t)
+      self.assertEqual(50.0, float_val)
+      self.assertAllEqual([9, 10], int_val)
+      self.assertEqual(1, self.evaluate(q.size()))
+
   def testBlockingEnqueueManyToFullQueue(self):
     # We need each thread to keep its own device stack or the device scopes
     # won't be properly nested.
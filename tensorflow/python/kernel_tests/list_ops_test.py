@@ -67,6 +67,22 @@ class ListOpsTest(test_util.TensorFlowTestCase, parameterized.TestCase):
     with context.device("gpu:0"):
       self._testPushPop(max_num_elements)
 
+  def testPushBackToSharedList(self):
+    l = list_ops.empty_tensor_list(
+        element_dtype=dtypes.float32, element_shape=[])
+    l = list_ops.tensor_list_push_back(l, 1.0)
+    # Both pushes and the pop read the same list, so none can be done in place.
+    l1 = list_ops.tensor_list_push_back(l, 2.0)
+    l2 = list_ops.tensor_list_push_back(l, 3.0)
+    l3, _ = list_ops.tensor_list_pop_back(l1, element_dtype=dtypes.float32)
+    l3 = list_ops.tensor_list_push_back(l3, 4.0)
+    l1 = list_ops.tensor_list_set_item(l1, 0, 5.0)
+    self.assertAllEqual(
+        self.evaluate([
+            list_ops.tensor_list_stack(t, element_dtype=dtypes.float32)
+            for t in [l, l1, l2, l3]
+        ]), [[1.0], [5.0, 2.0], [1.0, 3.0], [1.0, 4.0]])
+
   @test_util.run_deprecated_v1
   def testPushInFullListFails(self):
     l = list_ops.empty_tensor_list(
@@ -2655,6 +2655,32 @@ class MutableHashTableOpTest(test.TestCase):
       self.assertAllEqual([b"brain", b"salad", b"surgery"], sorted_keys)
       self.assertAllEqual([0, 1, 2], sorted_values)
 
+  def testShardedMutableHashTable(self):
+    with self.cached_session():
+      default_val = -1
+      keys = constant_op.constant([11, 12, 13, 14, 12], dtypes.int64)
+      values = constant_op.constant([0, 1, 2, 3, 4], dtypes.int64)
+      table = lookup_ops.MutableHashTable(
+          dtypes.int64, dtypes.int64, default_val, num_shards=4)
+      self.assertAllEqual(0, self.evaluate(table.size()))
+
+      # The last value of a duplicated key wins.
+      self.evaluate(table.insert(keys, values))
+      self.assertAllEqual(4, self.evaluate(table.size()))
+
+      self.evaluate(table.remove(constant_op.constant([14, 15], dtypes.int64)))
+      self.assertAllEqual(3, self.evaluate(table.size()))
+
+      output = table.lookup(
+          constant_op.constant([13, 12, 11, 14], dtypes.int64))
+      self.assertAllEqual([2, 4, 0, -1], self.evaluate(output))
+
+      exported_keys, exported_values = table.export()
+      sorted_keys = np.sort(self.evaluate(exported_keys))
+      sorted_values = np.sort(self.evaluate(exported_values))
+      self.assertAllEqual([11, 12, 13], sorted_keys)
+      self.assertAllEqual([0, 2, 4], sorted_values)
+
   @test_util.run_v1_only("SaverV1")
   def testSaveRestore(self):
     save_dir = os.path.join(self.get_temp_dir(), "save_restore")
@@ -250,6 +250,27 @@ class ResourceVariableOpsTest(test_util.TensorFlowTestCase,
         resource_variable_ops.read_variable_op(handle, dtype=dtypes.int32))
     self.assertEqual(read, 2)
 
+  @test_util.run_in_graph_and_eager_modes
+  def testAssignAddKeepsEarlierReads(self):
+    handle = resource_variable_ops.var_handle_op(
+        dtype=dtypes.float32, shape=[3])
+    self.evaluate(resource_variable_ops.assign_variable_op(
+        handle, constant_op.constant([1., 2., 3.])))
+    first_read = resource_variable_ops.read_variable_op(
+        handle, dtype=dtypes.float32)
+    with ops.control_dependencies([first_read]):
+      # The update is the last user of its value, so the sum can reuse it.
+      update = resource_variable_ops.assign_add_variable_op(
+          handle,
+          math_ops.add(constant_op.constant([1., 1., 1.]),
+                       constant_op.constant([0., 1., 2.])))
+    with ops.control_dependencies([update]):
+      second_read = resource_variable_ops.read_variable_op(
+          handle, dtype=dtypes.float32)
+    f, s = self.evaluate([first_read, second_read])
+    self.assertAllEqual(f, [1., 2., 3.])
+    self.assertAllEqual(s, [2., 4., 6.])
+
   @test_util.run_in_graph_and_eager_modes
   def testScatterAdd(self):
     handle = resource_variable_ops.var_handle_op(
@@ -313,6 +313,23 @@ class UnsortedSegmentTest(SegmentReductionHelper):
               self.assertAllCloseAccordingToType(np_ans, tf_ans)
               self.assertShapeEqual(np_ans, s)
 
+  def testSortedValues(self):
+    # Sorted ids, with empty and dropped segments, as derived from row splits.
+    indices = np.array([-1, 0, 0, 3, 3, 3, 4, 7, 8, 8])
+    num_segments = 12
+    shape = indices.shape + (3,)
+    for dtype in [dtypes_lib.float32, dtypes_lib.int32]:
+      tf_x, np_x = self._input(shape, dtype=dtype)
+      with self.cached_session(use_gpu=False):
+        for np_op1, np_op2, tf_op, init_op in self.ops_list:
+          if (np_op2 == self._sqrt_n_reduce_op and dtype.is_integer):
+            continue
+          np_ans = self._segmentReduce(
+              indices[1:], np_x[1:], np_op1, np_op2,
+              num_segments=num_segments, initial_value=init_op(dtype))
+          s = tf_op(tf_x, segment_ids=indices, num_segments=num_segments)
+          self.assertAllCloseAccordingToType(np_ans, self.evaluate(s))
+
   def testNumSegmentsTypes(self):
     dtypes = [dtypes_lib.int32, dtypes_lib.int64]
     indices_flat = np.array([0, 4, 0, 8, 3, 8, 4, 7, 7, 3])
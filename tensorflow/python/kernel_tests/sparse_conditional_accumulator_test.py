@@ -222,6 +222,27 @@ class IndexedSlicesConditionalAccumulatorTest(test.TestCase):
       self.assertAllEqual([[1, 1], [0, 2], [3, 0]], val.values)
       self.assertAllEqual([-1, 2], val.dense_shape)
 
+  @test_util.run_deprecated_v1
+  def testAccumulatorTakeGradMeanUnsortedIndices(self):
+    with self.cached_session() as sess:
+      q = data_flow_ops.SparseConditionalAccumulator(
+          dtypes_lib.float32, name="Q", shape=())
+
+      accum_op = q.apply_grad([2, 0, 2],
+                              np.array([[1, 0], [0, 2], [3, 0]]).astype(
+                                  np.float32), [3, 2])
+      accum_op.run()
+      accum_op = q.apply_grad([1, 0],
+                              np.array([[0, 1], [4, 0]]).astype(np.float32),
+                              [3, 2])
+      accum_op.run()
+
+      takeg_t = q.take_indexed_slices_grad(1)
+      val = self.evaluate(takeg_t)
+      self.assertAllEqual([0, 1, 2], val.indices)
+      self.assertAllEqual([[2, 1], [0, 1], [4, 0]], val.values)
+      self.assertAllEqual([-1, 2], val.dense_shape)
+
   @test_util.run_deprecated_v1
   def testAccumulatorTakeGradInvalidReductionType(self):
     with self.assertRaises(ValueError):
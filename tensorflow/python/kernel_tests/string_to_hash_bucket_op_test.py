@@ -70,6 +70,20 @@ class StringToHashBucketOpTest(test.TestCase):
       # Hash64('c') -> 14899841994519054197 -> mod 10 -> 7
       self.assertAllEqual([8, 0, 7], result)
 
+  @test_util.run_deprecated_v1
+  def testLargeInputsMatchSingleElements(self):
+    # Large inputs are hashed on several threads.
+    strings = ['s%d' % i for i in range(50000)]
+    sampled = [0, 1, 12345, 49999]
+    with self.cached_session():
+      for hash_fn in (string_ops.string_to_hash_bucket,
+                      string_ops.string_to_hash_bucket_fast):
+        result = self.evaluate(hash_fn(constant_op.constant(strings), 1000))
+        for i in sampled:
+          expected = self.evaluate(
+              hash_fn(constant_op.constant([strings[i]]), 1000))
+          self.assertEqual(expected[0], result[i])
+
   def testStringToOneHashBucketStrongOneHashBucket(self):
     with self.cached_session():
       input_string = constant_op.constant(['a', 'b', 'c'])
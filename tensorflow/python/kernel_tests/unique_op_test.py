@@ -39,6 +39,17 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]])
 
+  def testLargeInt64(self):
+    # Large enough to be deduplicated in parallel.
+    x = np.random.randint(-50000, high=50000, size=300000).astype(np.int64)
+    with self.cached_session() as sess:
+      y, idx = array_ops.unique(x)
+      tf_y, tf_idx = self.evaluate([y, idx])
+
+    _, first_occurrences = np.unique(x, return_index=True)
+    self.assertAllEqual(tf_y, x[np.sort(first_occurrences)])
+    self.assertAllEqual(tf_y[tf_idx], x)
+
   def testInt32OutIdxInt64(self):
     x = np.random.randint(2, high=10, size=7000)
     with self.cached_session() as sess:
@@ -34,7 +34,9 @@ def batch_function(num_batch_threads,
                    batch_timeout_micros,
                    allowed_batch_sizes=None,
                    max_enqueued_batches=10,
-                   autograph=True):
+                   autograph=True,
+                   bucket_boundaries=None,
+                   bucket_dim=1):
   """Batches the computation done by the decorated function.
 
   So, for example, in the following code
@@ -71,6 +73,13 @@ def batch_function(num_batch_threads,
     max_enqueued_batches: The maximum depth of the batch queue. Defaults to 10.
     autograph: Whether to use autograph to compile python and eager style code
      for efficient graph-mode execution.
+    bucket_boundaries: Optional list of sequence length bucket boundaries. If
+     left empty, does nothing. Otherwise, only calls whose inputs fall in the
+     same bucket along `bucket_dim` are batched together, padded with zeros
+     along `bucket_dim` to the length of their bucket. Each bucket is batched
+     with its own timeout and size limits, and all buckets share
+     `num_batch_threads`. The outputs keep the padding.
+    bucket_dim: The dimension of the inputs that `bucket_boundaries` apply to.
 
   Returns:
     The decorated function will return the unbatched computation output Tensors.
@@ -100,6 +109,8 @@ def batch_function(num_batch_threads,
             batch_timeout_micros=batch_timeout_micros,
             allowed_batch_sizes=allowed_batch_sizes,
             max_enqueued_batches=max_enqueued_batches,
+            bucket_boundaries=bucket_boundaries,
+            bucket_dim=bucket_dim,
             shared_name=name,
             f=computation,
             in_tensors=list(args),
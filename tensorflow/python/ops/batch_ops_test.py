@@ -323,6 +323,38 @@ class BatchOpsTest(test.TestCase):
       self.assertEqual(thread_results[0], [2])
       self.assertEqual(main_results[0], [3])
 
+  def testBatchFunctionOpWithBuckets(self):
+    """Tests that batch_function op pads inputs to their bucket."""
+    if context.executing_eagerly():
+      return
+    with self.cached_session() as sess:
+
+      @function.Defun(dtypes.int32)
+      def computation(in_t):
+        return in_t * 2
+
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[1, None])
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=10,
+          batch_timeout_micros=100000,
+          bucket_boundaries=[4, 8],
+          Tout=[dtypes.int32],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      thread_results = []
+
+      def worker():
+        thread_results.extend(sess.run([result], feed_dict={inp: [[1, 2]]}))
+
+      worker_thread = threading.Thread(target=worker)
+      worker_thread.start()
+      main_results = sess.run([result], feed_dict={inp: [[3, 4, 5, 6, 7]]})
+      worker_thread.join()
+      self.assertAllEqual(thread_results[0], [[2, 4, 0, 0]])
+      self.assertAllEqual(main_results[0], [[6, 8, 10, 12, 14, 0, 0, 0]])
+
   def testBatchFunctionOpWithInputError(self):
     """Tests that batch_function op works with error in the inputs."""
     if context.executing_eagerly():
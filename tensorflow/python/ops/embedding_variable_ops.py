@@ -0,0 +1,226 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tiered embedding variables keyed by int64 ids."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import functools
+
+from tensorflow.python.eager import context
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_resource_variable_ops
+from tensorflow.python.training.saving import saveable_object
+from tensorflow.python.training.tracking import tracking
+
+
+class EmbeddingVariable(tracking.TrackableResource):
+  """A float embedding table keyed by int64 ids.
+
+  Rows are created with `default_value` on first lookup, so the set of ids
+  does not need to be known in advance. The most frequently accessed rows are
+  kept in an in-memory hot tier of at most `hot_capacity` rows; the others are
+  evicted to a cold tier, in a file in `cold_storage_dir` or in host memory if
+  it is empty. The variable is only placed on CPU.
+
+  Gradients of `lookup` with respect to `resource_handle` are `IndexedSlices`,
+  which `sparse_apply_adagrad` applies:
+
+  ```python
+  embeddings = EmbeddingVariable(tf.zeros([64]), name="embeddings")
+  accumulators = EmbeddingVariable(tf.fill([64], 0.1), name="accumulators")
+  rows = embeddings.lookup(ids)
+  loss = ...
+  grad, = tf.gradients(loss, [embeddings.resource_handle])
+  train_op = embeddings.sparse_apply_adagrad(accumulators, 0.01, grad)
+  ```
+  """
+
+  def __init__(self,
+               default_value,
+               hot_capacity=1048576,
+               cold_storage_dir="",
+               name="EmbeddingVariable",
+               checkpoint=True):
+    """Creates an embedding variable.
+
+    Args:
+      default_value: 1-D float `Tensor`, the initial value of every row. Its
+        size is the embedding dimension.
+      hot_capacity: The maximum number of rows kept in the hot tier.
+      cold_storage_dir: Directory of the file holding the rows evicted from the
+        hot tier. If empty, evicted rows are kept in host memory.
+      name: A name for the variable.
+      checkpoint: if True, all rows are saved to and restored from checkpoints.
+
+    Returns:
+      An `EmbeddingVariable` object.
+    """
+    self._default_value = ops.convert_to_tensor(
+        default_value, dtype=dtypes.float32)
+    self._default_value.get_shape().assert_has_rank(1)
+    self._hot_capacity = hot_capacity
+    self._cold_storage_dir = cold_storage_dir
+    self._name = name
+    self._checkpoint = checkpoint
+
+    self._shared_name = None
+    if context.executing_eagerly():
+      # Kernels are cached by their attributes when executing eagerly, so each
+      # variable needs its own shared_name to get its own resource.
+      self._shared_name = "embedding_variable_%d" % (ops.uid(),)
+    # The kernels are only registered for CPU.
+    super(EmbeddingVariable, self).__init__(device="CPU")
+
+    with ops.device(self._resource_device):
+      self._resource_handle = self._create_resource()
+    if checkpoint:
+      saveable = EmbeddingVariable._Saveable(self, name)
+      if not context.executing_eagerly():
+        ops.add_to_collection(ops.GraphKeys.SAVEABLE_OBJECTS, saveable)
+
+  def _create_resource(self):
+    handle = gen_resource_variable_ops.embedding_variable_handle_op(
+        default_value=self._default_value,
+        shared_name=self._shared_name,
+        hot_capacity=self._hot_capacity,
+        cold_storage_dir=self._cold_storage_dir,
+        name=self._name)
+    if context.executing_eagerly():
+      self._variable_name = None
+    else:
+      self._variable_name = handle.op.name.split("/")[-1]
+    return handle
+
+  @property
+  def name(self):
+    return self._variable_name
+
+  @property
+  def dtype(self):
+    return dtypes.float32
+
+  def lookup(self, ids, name=None):
+    """Returns the rows of `ids`, creating the missing ones.
+
+    Args:
+      ids: An int32 or int64 `Tensor` of ids.
+      name: A name for the operation (optional).
+
+    Returns:
+      A float `Tensor` of shape `ids.shape + [dim]`.
+    """
+    with ops.name_scope(name, "%s_lookup" % self._name,
+                        [self.resource_handle, ids]):
+      with ops.colocate_with(self.resource_handle):
+        return gen_resource_variable_ops.resource_embedding_gather(
+            self.resource_handle, ids, dtype=dtypes.float32)
+
+  def sparse_apply_adagrad(self, accumulator, learning_rate, grad, name=None):
+    """Applies a sparse Adagrad update to the rows of this variable.
+
+    Args:
+      accumulator: The `EmbeddingVariable` holding the Adagrad accumulators,
+        with the same dimension as this variable.
+      learning_rate: A scalar float `Tensor`.
+      grad: An `IndexedSlices` gradient of this variable, as returned for
+        `resource_handle` by `tf.gradients`.
+      name: A name for the operation (optional).
+
+    Returns:
+      The update operation.
+    """
+    with ops.name_scope(name, "%s_sparse_apply_adagrad" % self._name,
+                        [self.resource_handle, accumulator.resource_handle]):
+      with ops.colocate_with(self.resource_handle):
+        apply_adagrad = (
+            gen_resource_variable_ops.resource_embedding_sparse_apply_adagrad)
+        return apply_adagrad(
+            self.resource_handle, accumulator.resource_handle,
+            ops.convert_to_tensor(learning_rate, dtype=dtypes.float32),
+            grad.values, grad.indices)
+
+  def export(self, name=None):
+    """Returns tensors of the ids and values of all rows, hot and cold.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A pair of tensors: the int64 ids, and the values with one row per id.
+    """
+    with ops.name_scope(name, "%s_export" % self._name,
+                        [self.resource_handle]):
+      with ops.colocate_with(self.resource_handle):
+        return gen_resource_variable_ops.embedding_variable_export(
+            self.resource_handle, dtype=dtypes.float32)
+
+  def import_rows(self, ids, values, name=None):
+    """Replaces all rows of this variable with `values`.
+
+    Args:
+      ids: A 1-D int64 `Tensor` of ids.
+      values: A 2-D float `Tensor` with one row per id.
+      name: A name for the operation (optional).
+
+    Returns:
+      The import operation.
+    """
+    with ops.name_scope(name, "%s_import" % self._name,
+                        [self.resource_handle, ids, values]):
+      with ops.colocate_with(self.resource_handle):
+        return gen_resource_variable_ops.embedding_variable_import(
+            self.resource_handle,
+            ops.convert_to_tensor(ids, dtype=dtypes.int64),
+            ops.convert_to_tensor(values, dtype=dtypes.float32))
+
+  def _gather_saveables_for_checkpoint(self):
+    """For object-based checkpointing."""
+    return {
+        "embedding_variable":
+            functools.partial(
+                EmbeddingVariable._Saveable, variable=self, name=self._name)
+    }
+
+  class _Saveable(saveable_object.SaveableObject):
+    """SaveableObject implementation for EmbeddingVariable."""
+
+    def __init__(self, variable, name):
+      tensors = variable.export()
+      specs = [
+          saveable_object.SaveSpec(tensors[0], "", name + "-ids"),
+          saveable_object.SaveSpec(tensors[1], "", name + "-values")
+      ]
+      super(EmbeddingVariable._Saveable, self).__init__(variable, specs, name)
+
+    def restore(self, restored_tensors, restored_shapes, name=None):
+      del restored_shapes  # unused
+      return self.op.import_rows(restored_tensors[0], restored_tensors[1],
+                                 name=name)
+
+
+@ops.RegisterGradient("ResourceEmbeddingGather")
+def _EmbeddingGatherGrad(op, grad):
+  """Gradient for ResourceEmbeddingGather, as IndexedSlices of the rows."""
+  indices = op.inputs[1]
+  size = array_ops.expand_dims(array_ops.size(indices), 0)
+  dim = array_ops.shape(grad)[-1:]
+  values = array_ops.reshape(grad, array_ops.concat([size, dim], 0))
+  indices = array_ops.reshape(indices, size)
+  # The variable has no dense shape: any id is a valid row.
+  return (ops.IndexedSlices(values, indices), None)
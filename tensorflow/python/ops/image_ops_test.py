@@ -3858,6 +3858,32 @@ class JpegTest(test_util.TensorFlowTestCase):
             lambda e: "Invalid JPEG data or crop window" in str(e)):
           self.evaluate(result)
 
+  def testDecodeAndCropAndResizeJpeg(self):
+    with self.cached_session():
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+
+      # Without downscaling during decoding, the result is that of
+      # DecodeAndCropJpeg followed by ResizeBilinear.
+      crop_window = [6, 5, 200, 100]
+      size = [150, 80]
+      image1 = gen_image_ops.resize_bilinear(
+          array_ops.expand_dims(
+              image_ops.decode_and_crop_jpeg(jpeg0, crop_window), 0),
+          size,
+          half_pixel_centers=True)[0]
+      image2 = gen_image_ops.decode_and_crop_and_resize_jpeg(
+          jpeg0, crop_window, size)
+      self.assertAllEqual([150, 80, None], image2.get_shape().as_list())
+      self.assertAllClose(self.evaluate(image1), self.evaluate(image2))
+
+      # Resizing the whole 256x128 image to 32x16 decodes it at 1/8 scale.
+      image1 = math_ops.cast(image_ops.decode_jpeg(jpeg0, ratio=8),
+                             dtypes.float32)
+      image2 = gen_image_ops.decode_and_crop_and_resize_jpeg(
+          jpeg0, [0, 0, 256, 128], [32, 16])
+      self.assertAllEqual(self.evaluate(image1), self.evaluate(image2))
+
   def testSynthetic(self):
     with self.cached_session(use_gpu=True) as sess:
       # Encode it, then decode it, then encode it
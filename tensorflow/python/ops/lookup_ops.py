@@ -1601,7 +1601,8 @@ class MutableHashTable(LookupInterface):
                value_dtype,
                default_value,
                name="MutableHashTable",
-               checkpoint=True):
+               checkpoint=True,
+               num_shards=1):
     """Creates an empty `MutableHashTable` object.
 
     Creates a table, the type of its keys and values are specified by key_dtype
@@ -1615,6 +1616,9 @@ class MutableHashTable(LookupInterface):
       checkpoint: if True, the contents of the table are saved to and restored
         from checkpoints. If `shared_name` is empty for a checkpointed table, it
         is shared using the table node name.
+      num_shards: The number of independently locked shards of the table.
+        Sharding lets concurrent lookups and insertions from different threads
+        proceed in parallel. Only used for scalar values.
 
     Returns:
       A `MutableHashTable` object.
@@ -1629,6 +1633,7 @@ class MutableHashTable(LookupInterface):
     self._key_dtype = key_dtype
     self._value_dtype = value_dtype
     self._name = name
+    self._num_shards = num_shards
 
     self._shared_name = None
     if context.executing_eagerly():
@@ -1657,6 +1662,7 @@ class MutableHashTable(LookupInterface):
           use_node_name_sharing=use_node_name_sharing,
           key_dtype=self._key_dtype,
           value_dtype=self._value_dtype,
+          num_shards=self._num_shards,
           name=self._name)
     else:
       table_ref = gen_lookup_ops.mutable_hash_table_of_tensors_v2(
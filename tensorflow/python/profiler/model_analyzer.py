@@ -45,6 +45,7 @@ ALL_ADVICE = {
     'AcceleratorUtilizationChecker': {},
     'JobChecker': {},  # Only available internally.
     'OperationChecker': {},
+    'RooflineChecker': {},
 }
 
 
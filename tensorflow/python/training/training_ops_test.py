@@ -239,6 +239,34 @@ class TrainingOpsTest(TensorFlowTestCase):
       indices = np.array([0, 2]).astype(index_type)
       self._testTypesForSparseAdagrad(x, y, lr, grad, indices)
 
+  @test_util.run_v1_only("b/120545219")
+  def testSparseApplyAdagradDuplicateIndices(self):
+    # Enough work to be split across threads, with every row updated many
+    # times. Duplicates must be applied in order, as in a serial loop.
+    num_rows, num_cols, num_updates = 8, 4096, 256
+    rng = np.random.RandomState(0)
+    x = rng.rand(num_rows, num_cols)
+    y = rng.rand(num_rows, num_cols) + 0.1
+    lr = 0.5
+    grad = rng.rand(num_updates, num_cols)
+    indices = np.tile(np.arange(num_rows), num_updates // num_rows)
+    expected_var = x.copy()
+    expected_accum = y.copy()
+    for (i, index) in enumerate(indices):
+      expected_accum[index] += grad[i] * grad[i]
+      expected_var[index] -= lr * grad[i] / np.sqrt(expected_accum[index])
+
+    with self.session(use_gpu=False):
+      var = variables.VariableV1(x)
+      accum = variables.VariableV1(y)
+      self.evaluate(variables.global_variables_initializer())
+      self.evaluate(
+          training_ops.sparse_apply_adagrad(
+              var, accum, np.array(lr), grad,
+              constant_op.constant(indices, dtypes.int64)))
+      self.assertAllClose(expected_accum, self.evaluate(accum))
+      self.assertAllClose(expected_var, self.evaluate(var))
+
   @test_util.run_v1_only("b/120545219")
   def testSparseApplyFtrlDim1(self):
     for (dtype, index_type) in itertools.product(
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/stream_executor/cuda/ptxas_utils.h"
 
+#include <tuple>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/synchronization/mutex.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -41,6 +44,10 @@ port::StatusOr<std::vector<uint8>> CompilePtx(int device_ordinal,
   return port::InternalError("Invoking ptxas not supported on Windows");
 }
 
+port::StatusOr<std::string> GetPtxasVersion(PtxCompilationOptions options) {
+  return port::InternalError("Invoking ptxas not supported on Windows");
+}
+
 port::StatusOr<absl::Span<const uint8>> CompilePtxOrGetCached(
     int device_ordinal, const char* ptx,
     PtxCompilationOptions compilation_options) {
@@ -49,38 +56,40 @@ port::StatusOr<absl::Span<const uint8>> CompilePtxOrGetCached(
 
 #else
 
-// Prints a warning if the ptxas at ptxas_path has known bugs.
-//
-// Only prints a warning the first time it's called for a particular value of
-// ptxas_path.
-//
-// Locks on entry.
-static void WarnIfBadPtxasVersion(const string& ptxas_path) {
-  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
-  static std::unordered_set<string>* seen_ptxas_paths GUARDED_BY(mu) =
-      new std::unordered_set<string>();
-
-  tensorflow::mutex_lock lock(mu);
-  if (!seen_ptxas_paths->insert(ptxas_path).second) {
-    // Already checked this ptx binary, nothing to do.
-    return;
+// Returns the path of the ptxas found in the CUDA roots searched for
+// `options`.
+static port::StatusOr<string> FindPtxas(const PtxCompilationOptions& options) {
+  string ptxas_path;
+  auto env = tensorflow::Env::Default();
+  for (const string& cuda_root :
+       tensorflow::CandidateCudaRoots(options.preferred_cuda_dir)) {
+    ptxas_path = tensorflow::io::JoinPath(cuda_root, "bin", "ptxas");
+    VLOG(2) << "Looking for ptxas at " << ptxas_path;
+    if (env->FileExists(ptxas_path).ok()) {
+      break;
+    }
   }
+  TF_RETURN_IF_ERROR(env->FileExists(ptxas_path));
+  return ptxas_path;
+}
 
+// Runs `ptxas_path --version` and returns the {major, minor, dot} version.
+static port::StatusOr<std::tuple<int64, int64, int64>> RunPtxasVersion(
+    const string& ptxas_path) {
   tensorflow::SubProcess ptxas;
   ptxas.SetProgram(ptxas_path, {ptxas_path, "--version"});
   ptxas.SetChannelAction(tensorflow::CHAN_STDOUT, tensorflow::ACTION_PIPE);
   if (!ptxas.Start()) {
-    LOG(WARNING) << "Couldn't invoke " << ptxas_path << " --version";
-    return;
+    return port::InternalError(
+        absl::StrCat("Couldn't invoke ", ptxas_path, " --version"));
   }
 
   string out;
   int exit_code = ptxas.Communicate(/*stdin_input=*/nullptr, &out,
                                     /*stderr_output=*/nullptr);
   if (exit_code != 0) {
-    LOG(WARNING) << "Running " << ptxas_path << " --version returned "
-                 << exit_code;
-    return;
+    return port::InternalError(absl::StrCat(
+        "Running ", ptxas_path, " --version returned ", exit_code));
   }
 
   int64 vmaj, vmin, vdot;
@@ -90,12 +99,58 @@ static void WarnIfBadPtxasVersion(const string& ptxas_path) {
       !absl::SimpleAtoi(vmaj_str, &vmaj) ||
       !absl::SimpleAtoi(vmin_str, &vmin) ||
       !absl::SimpleAtoi(vdot_str, &vdot)) {
-    LOG(WARNING) << "Couldn't parse ptxas version in output of " << ptxas_path
-                 << " --version:\n"
-                 << out;
+    return port::InternalError(
+        absl::StrCat("Couldn't parse ptxas version in output of ", ptxas_path,
+                     " --version:\n", out));
+  }
+  return std::make_tuple(vmaj, vmin, vdot);
+}
+
+port::StatusOr<std::string> GetPtxasVersion(PtxCompilationOptions options) {
+  TF_ASSIGN_OR_RETURN(string ptxas_path, FindPtxas(options));
+
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static auto& versions GUARDED_BY(mu) =
+      *new absl::flat_hash_map<string, std::string>();
+  tensorflow::mutex_lock lock(mu);
+  auto it = versions.find(ptxas_path);
+  if (it == versions.end()) {
+    TF_ASSIGN_OR_RETURN(auto version, RunPtxasVersion(ptxas_path));
+    it = versions
+             .emplace(ptxas_path,
+                      absl::StrCat(std::get<0>(version), ".",
+                                   std::get<1>(version), ".",
+                                   std::get<2>(version)))
+             .first;
+  }
+  return it->second;
+}
+
+// Prints a warning if the ptxas at ptxas_path has known bugs.
+//
+// Only prints a warning the first time it's called for a particular value of
+// ptxas_path.
+//
+// Locks on entry.
+static void WarnIfBadPtxasVersion(const string& ptxas_path) {
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static std::unordered_set<string>* seen_ptxas_paths GUARDED_BY(mu) =
+      new std::unordered_set<string>();
+
+  tensorflow::mutex_lock lock(mu);
+  if (!seen_ptxas_paths->insert(ptxas_path).second) {
+    // Already checked this ptx binary, nothing to do.
     return;
   }
 
+  auto version_or = RunPtxasVersion(ptxas_path);
+  if (!version_or.ok()) {
+    LOG(WARNING) << version_or.status().error_message();
+    return;
+  }
+  int64 vmaj, vmin, vdot;
+  std::tie(vmaj, vmin, vdot) = version_or.ValueOrDie();
+
   // We need ptxas >= 9.0 as a hard requirement, because we compile targeting
   // PTX 6.0.  An older ptxas will just fail to compile any of our code.
   //
@@ -157,17 +212,8 @@ port::StatusOr<std::vector<uint8>> CompilePtx(int device_ordinal,
   TF_RETURN_IF_ERROR(
       CUDADriver::GetComputeCapability(&cc_major, &cc_minor, handle));
 
-  string ptxas_path;
+  TF_ASSIGN_OR_RETURN(string ptxas_path, FindPtxas(options));
   auto env = tensorflow::Env::Default();
-  for (const string& cuda_root :
-       tensorflow::CandidateCudaRoots(options.preferred_cuda_dir)) {
-    ptxas_path = tensorflow::io::JoinPath(cuda_root, "bin", "ptxas");
-    VLOG(2) << "Looking for ptxas at " << ptxas_path;
-    if (env->FileExists(ptxas_path).ok()) {
-      break;
-    }
-  }
-  TF_RETURN_IF_ERROR(env->FileExists(ptxas_path));
   VLOG(2) << "Using ptxas at " << ptxas_path;
 
   WarnIfBadPtxasVersion(ptxas_path);
@@ -53,6 +53,11 @@ port::StatusOr<std::vector<uint8>> CompilePtx(int device_ordinal,
                                               const char* ptx_contents,
                                               PtxCompilationOptions options);
 
+// Returns the version of the ptxas that CompilePtx would use with `options`,
+// e.g. "10.1.243". Anything that caches its output beyond the process must
+// include this version in its key.
+port::StatusOr<std::string> GetPtxasVersion(PtxCompilationOptions options);
+
 // Same as CompilePtx, but caches the result, and returns unowned view of
 // the compiled binary.
 //
@@ -27,22 +27,130 @@ limitations under the License.
 
 namespace tensorflow {
 namespace graph_transforms {
+namespace {
+
+NodeDef MakeScalarConstNode(const string& name, float value) {
+  NodeDef node;
+  node.set_op("Const");
+  node.set_name(name);
+  SetNodeAttr("dtype", DT_FLOAT, &node);
+  Tensor tensor(DT_FLOAT, {});
+  tensor.scalar<float>()() = value;
+  SetNodeTensorAttr<float>("value", tensor, &node);
+  return node;
+}
+
+// Replaces a float constant with signed eight-bit values that have a separate
+// scale for every output channel, so a channel with small weights keeps its
+// precision even when others in the same tensor are large. The channels are
+// the last `num_channel_dims` dimensions. The values are stored with a
+// symmetric range, so the SCALED Dequantize just converts them back to float,
+// and a Mul applies the channel scales.
+void QuantizePerChannel(const NodeDef& old_const_node, const Tensor& old_tensor,
+                        int num_channel_dims, std::vector<NodeDef>* new_nodes) {
+  TensorShape channels_shape;
+  for (int i = old_tensor.dims() - num_channel_dims; i < old_tensor.dims();
+       ++i) {
+    channels_shape.AddDim(old_tensor.dim_size(i));
+  }
+  const int64 num_channels = channels_shape.num_elements();
+  // Viewed as a matrix with one column for each channel.
+  const auto old_values = old_tensor.shaped<float, 2>(
+      {old_tensor.NumElements() / num_channels, num_channels});
+  const int64 num_rows = old_values.dimension(0);
+  const float kMaxQuantized = 127.0f;
+
+  Tensor scales_tensor(DT_FLOAT, channels_shape);
+  auto scales = scales_tensor.flat<float>();
+  for (int64 c = 0; c < num_channels; ++c) {
+    float max_abs = 0.0f;
+    for (int64 r = 0; r < num_rows; ++r) {
+      max_abs = std::max(max_abs, std::abs(old_values(r, c)));
+    }
+    // An all-zero channel quantizes to zeros with any scale.
+    scales(c) = (max_abs > 0.0f) ? (max_abs / kMaxQuantized) : 1.0f;
+  }
+
+  Tensor quantized_tensor(DT_QINT8, old_tensor.shape());
+  auto quantized_values =
+      quantized_tensor.shaped<qint8, 2>({num_rows, num_channels});
+  for (int64 r = 0; r < num_rows; ++r) {
+    for (int64 c = 0; c < num_channels; ++c) {
+      const float value = std::round(old_values(r, c) / scales(c));
+      quantized_values(r, c) = static_cast<int8>(
+          std::max(-kMaxQuantized, std::min(kMaxQuantized, value)));
+    }
+  }
+
+  NodeDef quantized_const_node;
+  quantized_const_node.set_op("Const");
+  quantized_const_node.set_name(old_const_node.name() + "_quantized_const");
+  SetNodeAttr("dtype", DT_QINT8, &quantized_const_node);
+  SetNodeTensorAttr<qint8>("value", quantized_tensor, &quantized_const_node);
+  new_nodes->push_back(quantized_const_node);
+
+  const NodeDef min_node = MakeScalarConstNode(
+      old_const_node.name() + "_quantized_min", -kMaxQuantized);
+  new_nodes->push_back(min_node);
+  const NodeDef max_node = MakeScalarConstNode(
+      old_const_node.name() + "_quantized_max", kMaxQuantized);
+  new_nodes->push_back(max_node);
+
+  NodeDef scales_node;
+  scales_node.set_op("Const");
+  scales_node.set_name(old_const_node.name() + "_quantized_scales");
+  SetNodeAttr("dtype", DT_FLOAT, &scales_node);
+  SetNodeTensorAttr<float>("value", scales_tensor, &scales_node);
+  new_nodes->push_back(scales_node);
+
+  NodeDef dequantize_node;
+  dequantize_node.set_op("Dequantize");
+  dequantize_node.set_name(old_const_node.name() + "_dequantize");
+  SetNodeAttr("T", DT_QINT8, &dequantize_node);
+  SetNodeAttr("mode", "SCALED", &dequantize_node);
+  AddNodeInput(quantized_const_node.name(), &dequantize_node);
+  AddNodeInput(min_node.name(), &dequantize_node);
+  AddNodeInput(max_node.name(), &dequantize_node);
+  new_nodes->push_back(dequantize_node);
+
+  NodeDef mul_node;
+  mul_node.set_op("Mul");
+  mul_node.set_name(old_const_node.name());
+  SetNodeAttr("T", DT_FLOAT, &mul_node);
+  AddNodeInput(dequantize_node.name(), &mul_node);
+  AddNodeInput(scales_node.name(), &mul_node);
+  new_nodes->push_back(mul_node);
+}
+
+}  // namespace
 
 // Converts any large float constants into eight-bit equivalents, with a
 // Dequantize op so that subsequent nodes can still access the results in a
-// float form.
+// float form. With per_channel set, the constants are stored as signed
+// eight-bit values with one scale for each slice along the last dimension, or
+// the last two for depthwise filters, which are the output channels.
 Status QuantizeWeights(const GraphDef& input_graph_def,
                        const TransformFuncContext& context,
                        GraphDef* output_graph_def) {
   int32 minimum_size;
   TF_RETURN_IF_ERROR(
       context.GetOneInt32Parameter("minimum_size", 1024, &minimum_size));
+  bool per_channel;
+  TF_RETURN_IF_ERROR(
+      context.GetOneBoolParameter("per_channel", false, &per_channel));
+  // The output channels of depthwise filters span their last two dimensions.
+  std::set<string> depthwise_filters;
+  for (const NodeDef& node : input_graph_def.node()) {
+    if (node.op() == "DepthwiseConv2dNative" && node.input_size() > 1) {
+      depthwise_filters.insert(NodeNameFromInput(node.input(1)));
+    }
+  }
   TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
       input_graph_def, {"Const"},
-      [minimum_size](const NodeMatch& match,
-                     const std::set<string>& input_nodes,
-                     const std::set<string>& output_nodes,
-                     std::vector<NodeDef>* new_nodes) {
+      [minimum_size, per_channel, &depthwise_filters](
+          const NodeMatch& match, const std::set<string>& input_nodes,
+          const std::set<string>& output_nodes,
+          std::vector<NodeDef>* new_nodes) {
         const NodeDef& old_const_node = match.node;
         if (!old_const_node.attr().count("dtype")) {
           return errors::InvalidArgument("No 'dtype' attribute for Const node ",
@@ -65,6 +173,16 @@ Status QuantizeWeights(const GraphDef& input_graph_def,
           new_nodes->push_back(old_const_node);
           return Status::OK();
         }
+        const int num_channel_dims =
+            depthwise_filters.count(old_const_node.name()) ? 2 : 1;
+        // A tensor with no dimensions besides its channels, such as a bias,
+        // would get one scale per value, so it is quantized per-tensor.
+        if (per_channel && (num_elements > 0) &&
+            (old_tensor.dims() > num_channel_dims)) {
+          QuantizePerChannel(old_const_node, old_tensor, num_channel_dims,
+                             new_nodes);
+          return Status::OK();
+        }
         const float* old_values = old_tensor.flat<float>().data();
         float min = std::numeric_limits<float>::max();
         float max = std::numeric_limits<float>::min();
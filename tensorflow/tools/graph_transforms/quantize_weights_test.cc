@@ -159,5 +159,92 @@ TEST_F(QuantizeWeightsTest, RangesAlwaysIncludeZero) {
       expected_tensor(4.0), existing_tensor("weights_op_quantized_max"), 1e-5);
 }
 
+TEST_F(QuantizeWeightsTest, PerChannel) {
+  GraphDef original_graph_def;
+  BuildGraphDef({1, 1, 6, 2},
+                {1.0f, 4.0f, 2.0f, 5.0f, 3.0f, 6.0f, -1.0f, -4.0f, -2.0f,
+                 -5.0f, -3.0f, -6.0f},
+                {1, 2, 2, 10},
+                {1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f, 1.0f, 2.0f,
+                 3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f, 1.0f, 2.0f, 3.0f, 4.0f,
+                 0.1f, 0.2f, 0.3f, 0.4f, 1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f,
+                 0.3f, 0.4f, 1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f},
+                &original_graph_def);
+  TransformFuncContext context;
+  context.output_names = {"output"};
+  context.params["minimum_size"] = {"16"};
+  context.params["per_channel"] = {"true"};
+  GraphDef quantized_graph_def;
+  TF_ASSERT_OK(
+      QuantizeWeights(original_graph_def, context, &quantized_graph_def));
+
+  std::map<string, const NodeDef*> node_lookup;
+  MapNamesToNodes(quantized_graph_def, &node_lookup);
+  ASSERT_EQ(1, node_lookup.count("weights_op"));
+  EXPECT_EQ("Mul", node_lookup.at("weights_op")->op());
+  ASSERT_EQ(1, node_lookup.count("weights_op_dequantize"));
+  EXPECT_EQ("Dequantize", node_lookup.at("weights_op_dequantize")->op());
+  ASSERT_EQ(1, node_lookup.count("weights_op_quantized_const"));
+  EXPECT_EQ(DT_QINT8, node_lookup.at("weights_op_quantized_const")
+                          ->attr()
+                          .at("dtype")
+                          .type());
+  ASSERT_EQ(1, node_lookup.count("weights_op_quantized_scales"));
+  const NodeDef* scales_node = node_lookup.at("weights_op_quantized_scales");
+  Tensor scales = GetNodeTensorAttr(*scales_node, "value");
+  ASSERT_EQ(10, scales.NumElements());
+  EXPECT_NEAR(3.0f / 127.0f, scales.flat<float>()(0), 1e-6);
+  EXPECT_NEAR(4.0f / 127.0f, scales.flat<float>()(1), 1e-6);
+
+  std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+  TF_ASSERT_OK(original_session->Create(original_graph_def));
+  std::vector<Tensor> original_outputs;
+  TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+  std::unique_ptr<Session> quantized_session(NewSession(SessionOptions()));
+  TF_ASSERT_OK(quantized_session->Create(quantized_graph_def));
+  std::vector<Tensor> quantized_outputs;
+  TF_ASSERT_OK(quantized_session->Run({}, {"output"}, {}, &quantized_outputs));
+
+  test::ExpectTensorNear<float>(original_outputs[0], quantized_outputs[0],
+                                0.5);
+}
+
+TEST_F(QuantizeWeightsTest, PerChannelFallsBackToPerTensorForVectors) {
+  auto root = tensorflow::Scope::DisabledShapeInferenceScope();
+  Tensor bias_data(DT_FLOAT, TensorShape({20}));
+  test::FillFn<float>(&bias_data, [](int i) { return 0.25f * i - 2.0f; });
+  Output bias_op =
+      ops::Const(root.WithOpName("bias_op"), Input::Initializer(bias_data));
+  Output output_op = ops::Identity(root.WithOpName("output"), bias_op);
+  GraphDef original_graph_def;
+  TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+  TransformFuncContext context;
+  context.output_names = {"output"};
+  context.params["minimum_size"] = {"16"};
+  context.params["per_channel"] = {"true"};
+  GraphDef quantized_graph_def;
+  TF_ASSERT_OK(
+      QuantizeWeights(original_graph_def, context, &quantized_graph_def));
+
+  std::map<string, const NodeDef*> node_lookup;
+  MapNamesToNodes(quantized_graph_def, &node_lookup);
+  ASSERT_EQ(1, node_lookup.count("bias_op"));
+  EXPECT_EQ("Dequantize", node_lookup.at("bias_op")->op());
+  EXPECT_EQ(0, node_lookup.count("bias_op_quantized_scales"));
+  ASSERT_EQ(1, node_lookup.count("bias_op_quantized_const"));
+  EXPECT_EQ(DT_QUINT8, node_lookup.at("bias_op_quantized_const")
+                           ->attr()
+                           .at("dtype")
+                           .type());
+
+  std::unique_ptr<Session> quantized_session(NewSession(SessionOptions()));
+  TF_ASSERT_OK(quantized_session->Create(quantized_graph_def));
+  std::vector<Tensor> quantized_outputs;
+  TF_ASSERT_OK(quantized_session->Run({}, {"output"}, {}, &quantized_outputs));
+  test::ExpectTensorNear<float>(bias_data, quantized_outputs[0], 0.05);
+}
+
 }  // namespace graph_transforms
 }  // namespace tensorflow
@@ -0,0 +1,82 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// This file creates a binary that builds a database of measured op costs from
+// the RunMetadata of real runs, for use as RewriterConfig::op_cost_database.
+// ./collect_op_costs --run_metadata=/tmp/step1.pb,/tmp/step2.pb
+// --output_file_path=/tmp/op_costs.pb [--input_file_path=/tmp/old_costs.pb]
+//
+// The runs must have been made with GraphOptions::build_cost_model and
+// RunOptions::output_partition_graphs set.
+
+#include "tensorflow/core/grappler/costs/op_cost_database.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+Status RealMain(int argc, char** argv) {
+  string run_metadata_paths;
+  string input_file_path;
+  string output_file_path;
+
+  const std::vector<Flag> flag_list = {
+      Flag("run_metadata", &run_metadata_paths,
+           "Comma separated list of RunMetadata files, in binary or text "
+           "format."),
+      Flag("input_file_path", &input_file_path,
+           "Optional existing database to merge the measurements into."),
+      Flag("output_file_path", &output_file_path,
+           "Location to write the resulting database."),
+  };
+  if (!Flags::Parse(&argc, argv, flag_list)) {
+    return errors::FailedPrecondition("Invalid flags passed");
+  }
+  port::InitMain(argv[0], &argc, &argv);
+
+  if (run_metadata_paths.empty()) {
+    return errors::FailedPrecondition("run_metadata is a required flag.");
+  }
+  if (output_file_path.empty()) {
+    return errors::FailedPrecondition("output_file_path is a required flag.");
+  }
+
+  grappler::OpCostDatabase database;
+  if (!input_file_path.empty()) {
+    TF_RETURN_IF_ERROR(database.Load(input_file_path));
+  }
+  for (const string& path : str_util::Split(run_metadata_paths, ',')) {
+    RunMetadata run_metadata;
+    if (!ReadBinaryProto(Env::Default(), path, &run_metadata).ok()) {
+      run_metadata.Clear();
+      TF_RETURN_IF_ERROR(ReadTextProto(Env::Default(), path, &run_metadata));
+    }
+    TF_RETURN_IF_ERROR(database.AddRunMetadata(run_metadata));
+  }
+  LOG(INFO) << "Writing " << database.size() << " op costs to "
+            << output_file_path;
+  return database.Save(output_file_path);
+}
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  TF_CHECK_OK(tensorflow::RealMain(argc, argv));
+  return 0;
+}
@@ -0,0 +1,151 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Compares benchmark results against a baseline.
+
+Both the baseline and the current results are directories (or single files)
+of JSON-serialized "TestResults" protos, as written by run_and_gather_logs
+with --test_log_output_dir. Benchmarks are matched by target and name, and
+their wall time per iteration is compared. The script exits with a non-zero
+status if any benchmark got slower than the baseline by more than
+--threshold, so it can be used as a regression gate.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import sys
+
+from google.protobuf import json_format
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import app
+from tensorflow.python.platform import gfile
+
+FLAGS = None
+
+
+def _result_files(path):
+  if not gfile.IsDirectory(path):
+    return [path]
+  return [
+      os.path.join(path, f)
+      for f in sorted(gfile.ListDirectory(path))
+      if f.endswith(".json")
+  ]
+
+
+def _wall_time_per_iter(test_results, entry):
+  # C++ microbenchmarks report the total wall time of all iterations, Python
+  # benchmarks report the wall time of a single iteration.
+  if (test_results.benchmark_type == test_log_pb2.TestResults.CPP_MICROBENCHMARK
+      and entry.iters > 0):
+    return entry.wall_time / entry.iters
+  return entry.wall_time
+
+
+def load_wall_times(path):
+  """Returns a map from (target, benchmark name) to wall time per iteration."""
+  wall_times = {}
+  for file_name in _result_files(path):
+    test_results = test_log_pb2.TestResults()
+    json_format.Parse(gfile.GFile(file_name).read(), test_results)
+    for entry in test_results.entries.entry:
+      key = (test_results.target, entry.name)
+      wall_times[key] = _wall_time_per_iter(test_results, entry)
+  return wall_times
+
+
+def compare(baseline, current, threshold):
+  """Compares two maps returned by load_wall_times.
+
+  Args:
+    baseline: Wall times of the baseline run.
+    current: Wall times of the run being checked.
+    threshold: Relative slowdown above which a benchmark is a regression,
+      e.g. 0.1 for 10%.
+
+  Returns:
+    A list of dicts, one per benchmark present in both runs, sorted by target
+    and name.
+  """
+  comparisons = []
+  for key in sorted(set(baseline) & set(current)):
+    before = baseline[key]
+    after = current[key]
+    change = (after - before) / before if before > 0 else 0.0
+    comparisons.append({
+        "target": key[0],
+        "name": key[1],
+        "baseline_wall_time": before,
+        "wall_time": after,
+        "change": change,
+        "regression": change > threshold,
+    })
+  return comparisons
+
+
+def main(unused_args):
+  baseline = load_wall_times(FLAGS.baseline)
+  current = load_wall_times(FLAGS.current)
+  comparisons = compare(baseline, current, FLAGS.threshold)
+
+  for c in comparisons:
+    print("%-60s %12.3e %12.3e %+7.1f%%%s" %
+          ("%s:%s" % (c["target"], c["name"]), c["baseline_wall_time"],
+           c["wall_time"], c["change"] * 100,
+           "  REGRESSION" if c["regression"] else ""))
+  for key in sorted(set(baseline) - set(current)):
+    print("%s:%s missing from the current results" % key)
+
+  if FLAGS.output_file:
+    gfile.GFile(FLAGS.output_file, "w").write(
+        json.dumps(comparisons, indent=2, sort_keys=True))
+
+  num_regressions = sum(1 for c in comparisons if c["regression"])
+  if num_regressions:
+    print("%d of %d benchmarks regressed by more than %.1f%%" %
+          (num_regressions, len(comparisons), FLAGS.threshold * 100))
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "--baseline",
+      type=str,
+      required=True,
+      help="Directory or file with the baseline TestResults.")
+  parser.add_argument(
+      "--current",
+      type=str,
+      required=True,
+      help="Directory or file with the TestResults to check.")
+  parser.add_argument(
+      "--threshold",
+      type=float,
+      default=0.1,
+      help="Relative slowdown in wall time per iteration above which a "
+      "benchmark counts as a regression.")
+  parser.add_argument(
+      "--output_file",
+      type=str,
+      default="",
+      help="If set, the comparison is also written to this file as JSON.")
+  FLAGS, unparsed = parser.parse_known_args()
+  app.run(main=main, argv=[sys.argv[0]] + unparsed)